@@ -273,6 +273,7 @@ enum elf_dynamic_tag {
 	DT_TEXTREL  = 22,
 	DT_JMPREL   = 23,
 	DT_BIND_NOW = 24,
+	DT_GNU_HASH = 0x6ffffef5,
 	DT_LOPROC   = 0x70000000,
 	DT_HIPROC   = 0x7fffffff,
 };
@@ -516,6 +517,7 @@ typedef struct elf32_dyn elf_dyn_t;
 typedef struct elf32_rel elf_rel_t;
 typedef struct elf32_rela elf_rela_t;
 #define ELF_R_TYPE(i)  ELF32_R_TYPE(i)
+#define ELF_R_SYM(i)   ELF32_R_SYM(i)
 #endif
 
 #ifdef __64_BITS__
@@ -528,6 +530,7 @@ typedef struct elf64_dyn elf_dyn_t;
 typedef struct elf64_rel elf_rel_t;
 typedef struct elf64_rela elf_rela_t;
 #define ELF_R_TYPE(i)  ELF64_R_TYPE(i)
+#define ELF_R_SYM(i)   ELF64_R_SYM(i)
 #endif
 
 #endif
@@ -57,6 +57,9 @@ enum {
 	 * IPC_M_DATA_READ requests.
 	 */
 	DATA_XFER_LIMIT = 64 * 1024,
+
+	/** Maximum number of calls submitted or reaped by one batch syscall */
+	IPC_BATCH_LIMIT = 64,
 };
 
 /* Flags for calls */
@@ -122,6 +125,16 @@ typedef struct {
 	cap_call_handle_t cap_handle;
 } ipc_data_t;
 
+/** One entry of a batched asynchronous call submission. */
+typedef struct {
+	/** Phone capability handle to make the call on. */
+	cap_phone_handle_t phone;
+	/** User-defined label associated with the answer. */
+	sysarg_t label;
+	/** Call data with the request. */
+	ipc_data_t data;
+} ipc_call_request_t;
+
 /* Functions for manipulating calling data */
 
 static inline void ipc_set_retval(ipc_data_t *data, errno_t retval)
@@ -45,8 +45,17 @@ enum {
 	AS_AREA_CACHEABLE    = 0x08,
 	AS_AREA_GUARD        = 0x10,
 	AS_AREA_LATE_RESERVE = 0x20,
+	AS_AREA_LARGE        = 0x40,
 };
 
+/** Page-in request flag ORed into the size argument.
+ *
+ * The page size is page-aligned, so its low bits are free to carry
+ * flags. The flag tells the pager that the faulting access is a write
+ * and that it should consider the page dirty from now on.
+ */
+#define AS_PAGE_IN_WRITE  0x01
+
 static void *const AS_AREA_ANY = (void *) -1;
 static void *const AS_MAP_FAILED = (void *) -1;
 static void *const AS_AREA_UNPAGED = NULL;
@@ -49,6 +49,7 @@ typedef enum {
 	SYS_THREAD_GET_ID,
 	SYS_THREAD_USLEEP,
 	SYS_THREAD_UDELAY,
+	SYS_THREAD_SET_DEADLINE,
 
 	SYS_TASK_GET_ID,
 	SYS_TASK_SET_NAME,
@@ -60,10 +61,13 @@ typedef enum {
 	SYS_WAITQ_SLEEP,
 	SYS_WAITQ_WAKEUP,
 	SYS_WAITQ_DESTROY,
+	SYS_FUTEX_SLEEP,
+	SYS_FUTEX_WAKEUP,
 	SYS_SMC_COHERENCE,
 
 	SYS_AS_AREA_CREATE,
 	SYS_AS_AREA_RESIZE,
+	SYS_AS_AREA_DECOMMIT,
 	SYS_AS_AREA_CHANGE_FLAGS,
 	SYS_AS_AREA_GET_INFO,
 	SYS_AS_AREA_DESTROY,
@@ -72,11 +76,13 @@ typedef enum {
 
 	SYS_IPC_CALL_ASYNC_FAST,
 	SYS_IPC_CALL_ASYNC_SLOW,
+	SYS_IPC_CALL_ASYNC_BATCH,
 	SYS_IPC_ANSWER_FAST,
 	SYS_IPC_ANSWER_SLOW,
 	SYS_IPC_FORWARD_FAST,
 	SYS_IPC_FORWARD_SLOW,
 	SYS_IPC_WAIT,
+	SYS_IPC_WAIT_BATCH,
 	SYS_IPC_POKE,
 	SYS_IPC_HANGUP,
 	SYS_IPC_CONNECT_KBOX,
@@ -48,8 +48,44 @@ enum {
 	/** Maximum name sizes */
 	TASK_NAME_BUFLEN = 64,
 	EXC_NAME_BUFLEN  = 20,
+
+	/** Maximum name size of a sysinfo value exported on the clock page */
+	SYSINFO_EXPORT_NAME_BUFLEN = 56,
 };
 
+/** Sysinfo scalar exported on the clock page
+ *
+ */
+typedef struct {
+	char name[SYSINFO_EXPORT_NAME_BUFLEN];  /**< Full sysinfo path */
+	uintptr_t value;                        /**< Current value */
+} sysinfo_export_t;
+
+/** Layout of the clock page
+ *
+ * One read-only page maintained by the kernel and mapped by tasks
+ * that want to read the system uptime and frequently read sysinfo
+ * scalars with a few loads instead of a syscall.
+ *
+ * The first three members hold the uptime and are updated by the
+ * clock interrupt handler. Since two of them cannot be read
+ * atomically, the seconds are stored twice; a reader reads seconds2
+ * first, then useconds, then seconds1, and zeroes the microseconds
+ * if the two readings of the seconds differ.
+ *
+ * The export table only ever grows, entries are never renamed and
+ * export_cnt is increased only after the new entry is completely
+ * filled in, so a reader needs no synchronization with the kernel
+ * beyond a read barrier after reading export_cnt.
+ */
+typedef struct {
+	uintptr_t seconds1;         /**< Uptime seconds (first copy) */
+	uintptr_t useconds;         /**< Uptime microsecond fraction */
+	uintptr_t seconds2;         /**< Uptime seconds (second copy) */
+	uintptr_t export_cnt;       /**< Number of valid export entries */
+	sysinfo_export_t exports[]; /**< Exported sysinfo scalars */
+} clock_page_t;
+
 /** Item value type
  *
  */
@@ -143,6 +179,83 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Kernel event counter indices
+ *
+ * Indices into the per-CPU event counter arrays of the statistics
+ * region. The counters are incremented with plain stores by the
+ * owning CPU and are never reset; consumers compute rates by
+ * sampling them periodically and taking differences.
+ *
+ */
+typedef enum {
+	STATS_EVENT_SYSCALL = 0,  /**< System calls */
+	STATS_EVENT_IPC_CALL,     /**< IPC calls sent */
+	STATS_EVENT_PAGE_FAULT,   /**< Page faults */
+	STATS_EVENT_CTX_SWITCH,   /**< Context switches */
+	STATS_EVENT_MAX
+} stats_event_t;
+
+/** Per-CPU slot of the statistics region
+ *
+ * Updated in place by the owning CPU from its clock interrupt
+ * handler. The sequence counter is even whenever the slot is stable;
+ * the CPU increments it before and after rewriting the statistics,
+ * so a reader retries if it observes an odd value or if the counter
+ * changed while it was reading.
+ *
+ */
+typedef struct {
+	uintptr_t seq;      /**< Change counter (even when stable) */
+	stats_cpu_t stats;  /**< Statistics proper */
+
+	/** Event counters (indexed by stats_event_t) */
+	uint64_t events[STATS_EVENT_MAX];
+} stats_region_cpu_t;
+
+/** Layout of the statistics region
+ *
+ * Read-only physical memory area maintained by the kernel. Monitoring
+ * tasks map it once and then read CPU and task statistics in place,
+ * without the double snapshot generation and copying of the sysinfo
+ * data interface on every sample.
+ *
+ * The per-CPU slots are updated on every clock tick and are guarded
+ * by their individual sequence counters. The task section is
+ * refreshed on demand by reading the "stats.refresh" sysinfo value
+ * and is guarded by task_seq (even when stable; writers are
+ * serialized by the sysinfo interface). If task_total exceeds
+ * task_max, the section was truncated at the last refresh.
+ *
+ */
+typedef struct {
+	uintptr_t cpu_cnt;          /**< Number of per-CPU slots */
+	uintptr_t task_off;         /**< Offset of the task section (bytes) */
+	uintptr_t task_max;         /**< Capacity of the task section (entries) */
+	uintptr_t task_seq;         /**< Task section change counter */
+	uintptr_t task_cnt;         /**< Number of valid task entries */
+	uintptr_t task_total;       /**< Number of tasks at the last refresh */
+	stats_region_cpu_t cpus[];  /**< Per-CPU slots */
+} stats_region_t;
+
+/** Single sample taken by the kernel sampling profiler
+ *
+ */
+typedef struct {
+	uint64_t cycle;         /**< Cycle counter value at sample time */
+	uint64_t pc;            /**< Interrupted program counter (zero if unused) */
+	thread_id_t thread_id;  /**< Interrupted thread ID (zero if none) */
+	uint64_t cpu;           /**< CPU that took the sample */
+} prof_sample_t;
+
+/** Longest latency-critical section recorded on one CPU by the
+ *  kernel latency tracer
+ *
+ */
+typedef struct {
+	uint64_t cycles;  /**< Duration of the section in cycles */
+	uint64_t pc;      /**< Address of the code that opened the section */
+} lattrace_rec_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
@@ -35,8 +35,22 @@
 #ifndef _ABI_UDEBUG_H_
 #define _ABI_UDEBUG_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define UDEBUG_EVMASK(event)  (1 << ((event) - 1))
 
+/** Maximum number of spans in one UDEBUG_M_MEM_READV message. */
+#define UDEBUG_MEM_READV_MAX_SPANS  64
+
+/** Single span of a vectored memory read. */
+typedef struct {
+	/** Address in the debugged task's address space. */
+	uintptr_t addr;
+	/** Number of bytes. */
+	size_t size;
+} udebug_mem_span_t;
+
 typedef enum { /* udebug_method_t */
 
 	/** Start debugging the recipient.
@@ -150,7 +164,30 @@ typedef enum { /* udebug_method_t */
 	 * - ARG4 - size of receiving buffer in bytes
 	 *
 	 */
-	UDEBUG_M_MEM_READ
+	UDEBUG_M_MEM_READ,
+
+	/** Write the debugged tasks's memory.
+	 *
+	 * - ARG2 - source address in the caller's address space
+	 * - ARG3 - destination address in the recipient's address space
+	 * - ARG4 - number of bytes to write
+	 *
+	 */
+	UDEBUG_M_MEM_WRITE,
+
+	/** Read several spans of the debugged tasks's memory at once.
+	 *
+	 * - ARG2 - destination address in the caller's address space
+	 * - ARG3 - address of an array of udebug_mem_span_t structures
+	 *          in the caller's address space
+	 * - ARG4 - number of spans in the array (at most
+	 *          UDEBUG_MEM_READV_MAX_SPANS)
+	 *
+	 * The data of the individual spans is stored into the destination
+	 * buffer back to back, in the order of the spans.
+	 *
+	 */
+	UDEBUG_M_MEM_READV
 } udebug_method_t;
 
 typedef enum {
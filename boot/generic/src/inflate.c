@@ -31,12 +31,15 @@
  * @brief Implementation of inflate decompression
  *
  * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. It is not optimized
- * for speed but for readability as it is used as part of the bootloader and
- * any miss-optimization might be hard to debug.
+ * described by RFC 1951) based on puff.c by Mark Adler. It is mostly
+ * optimized for readability as it is used as part of the bootloader and
+ * any miss-optimization might be hard to debug. The only concession to
+ * speed is a small one-level lookup table resolving short Huffman codes
+ * in a single step, since the bootloader decompresses the whole boot
+ * image through this code.
  *
  * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * stack usage should be typically bounded by 3 KB.
  *
  * Original copyright notice:
  *
@@ -88,6 +91,9 @@
 /** Number of all codes */
 #define MAX_CODE  (MAX_LITLEN + MAX_DIST)
 
+/** Number of bits resolved by the fast decode table */
+#define FAST_BITS  8
+
 /** Check for input buffer overrun condition */
 #define CHECK_OVERRUN(state) \
 	do { \
@@ -119,6 +125,14 @@ typedef struct {
 typedef struct {
 	uint16_t *count;   /**< Array of symbol counts */
 	uint16_t *symbol;  /**< Array of symbols */
+
+	/**
+	 * Fast decode table with 2^FAST_BITS entries, resolving codes of
+	 * at most FAST_BITS bits in a single lookup. Each entry holds
+	 * the code length in the upper four bits and the decoded symbol
+	 * in the rest; zero marks a code longer than FAST_BITS.
+	 */
+	uint16_t *fast;
 } huffman_t;
 
 /** Length codes
@@ -211,12 +225,28 @@ static uint16_t dist_symbol[MAX_DIST] = {
 	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
 };
 
+/** Static length fast decode table
+ *
+ */
+static uint16_t len_fast[1 << FAST_BITS];
+
+/** Static distance fast decode table
+ *
+ */
+static uint16_t dist_fast[1 << FAST_BITS];
+
+/** Whether the static fast decode tables have been filled
+ *
+ */
+static bool fixed_fast_ready = false;
+
 /** Huffman code for lengths
  *
  */
 static huffman_t len_code = {
 	.count = len_count,
-	.symbol = len_symbol
+	.symbol = len_symbol,
+	.fast = len_fast
 };
 
 /** Huffman code for distances
@@ -224,7 +254,8 @@ static huffman_t len_code = {
  */
 static huffman_t dist_code = {
 	.count = dist_count,
-	.symbol = dist_symbol
+	.symbol = dist_symbol,
+	.fast = dist_fast
 };
 
 /** Get bits from the bit buffer
@@ -259,6 +290,45 @@ static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
 	return ((uint16_t) (val & ((1 << cnt) - 1)));
 }
 
+/** Peek at bits in the bit buffer without consuming them
+ *
+ * @param state Inflate state.
+ * @param cnt   Number of bits to peek at (at most 9).
+ * @param bits  Place to store the bits.
+ *
+ * @return True if enough input was available.
+ *
+ */
+static inline bool peek_bits(inflate_state_t *state, size_t cnt,
+    uint16_t *bits)
+{
+	while (state->bitlen < cnt) {
+		if (state->srccnt == state->srclen)
+			return false;
+
+		/* Load 8 more bits */
+		state->bitbuf |=
+		    ((uint16_t) state->src[state->srccnt]) << state->bitlen;
+		state->srccnt++;
+		state->bitlen += 8;
+	}
+
+	*bits = state->bitbuf & ((1 << cnt) - 1);
+	return true;
+}
+
+/** Drop bits previously peeked at from the bit buffer
+ *
+ * @param state Inflate state.
+ * @param cnt   Number of bits to drop.
+ *
+ */
+static inline void drop_bits(inflate_state_t *state, size_t cnt)
+{
+	state->bitbuf >>= cnt;
+	state->bitlen -= cnt;
+}
+
 /** Decode `stored' block
  *
  * @param state Inflate state.
@@ -315,9 +385,80 @@ static int inflate_stored(inflate_state_t *state)
  * @param EINVAL on invalid Huffman code.
  *
  */
+/** Reverse the bit order of a code
+ *
+ * @param code Huffman code to reverse.
+ * @param len  Number of bits in the code.
+ *
+ * @return Code with reversed bit order.
+ *
+ */
+static inline uint16_t reverse_bits(uint16_t code, size_t len)
+{
+	uint16_t rev = 0;
+
+	while (len > 0) {
+		rev = (rev << 1) | (code & 1);
+		code >>= 1;
+		len--;
+	}
+
+	return rev;
+}
+
+/** Fill the fast decode table of a Huffman code
+ *
+ * For every code of at most FAST_BITS bits, all table entries whose
+ * low bits match the code (as it appears in the bit stream, i.e. with
+ * reversed bit order) are set to the code length and decoded symbol.
+ * Entries matching no short code are left zero and the decoder falls
+ * back to the bit-by-bit walk.
+ *
+ * @param huffman Huffman code with constructed count/symbol tables.
+ *
+ */
+static void huffman_fill_fast(huffman_t *huffman)
+{
+	size_t index = 0;
+	uint16_t first = 0;
+
+	for (size_t i = 0; i < (1 << FAST_BITS); i++)
+		huffman->fast[i] = 0;
+
+	for (size_t len = 1; len <= FAST_BITS; len++) {
+		uint16_t count = huffman->count[len];
+
+		for (uint16_t code = 0; code < count; code++) {
+			uint16_t entry = (len << 12) |
+			    huffman->symbol[index + code];
+			uint16_t rev = reverse_bits(first + code, len);
+
+			for (size_t fill = rev; fill < (1 << FAST_BITS);
+			    fill += (1 << len))
+				huffman->fast[fill] = entry;
+		}
+
+		index += count;
+		first = (first + count) << 1;
+	}
+}
+
 static int huffman_decode(inflate_state_t *state, huffman_t *huffman,
     uint16_t *symbol)
 {
+	/* Resolve short codes with a single table lookup */
+	uint16_t bits;
+	if ((huffman->fast != NULL) && (peek_bits(state, FAST_BITS, &bits))) {
+		uint16_t entry = huffman->fast[bits];
+		if (entry != 0) {
+			drop_bits(state, entry >> 12);
+			*symbol = entry & 0x0fff;
+			return EOK;
+		}
+
+		/* A longer code, take the slow path below */
+	}
+
 	/* Decode bits */
 	uint16_t code = 0;
 
@@ -514,16 +655,20 @@ static int inflate_dynamic(inflate_state_t *state)
 	uint16_t length[MAX_CODE];
 	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
 	uint16_t dyn_len_symbol[MAX_LITLEN];
+	uint16_t dyn_len_fast[1 << FAST_BITS];
 	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
 	uint16_t dyn_dist_symbol[MAX_DIST];
+	uint16_t dyn_dist_fast[1 << FAST_BITS];
 	huffman_t dyn_len_code;
 	huffman_t dyn_dist_code;
 
 	dyn_len_code.count = dyn_len_count;
 	dyn_len_code.symbol = dyn_len_symbol;
+	dyn_len_code.fast = dyn_len_fast;
 
 	dyn_dist_code.count = dyn_dist_count;
 	dyn_dist_code.symbol = dyn_dist_symbol;
+	dyn_dist_code.fast = dyn_dist_fast;
 
 	/* Get number of bits in each table */
 	uint16_t nlen = get_bits(state, 5) + 257;
@@ -555,6 +700,8 @@ static int inflate_dynamic(inflate_state_t *state)
 	if (rc != 0)
 		return EINVAL;
 
+	huffman_fill_fast(&dyn_len_code);
+
 	/* Read length/literal and distance code length tables */
 	index = 0;
 	while (index < nlen + ndist) {
@@ -604,11 +751,15 @@ static int inflate_dynamic(inflate_state_t *state)
 	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
 		return EINVAL;
 
+	huffman_fill_fast(&dyn_len_code);
+
 	/* Build Huffman tables for distance codes */
 	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
 	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
 		return EINVAL;
 
+	huffman_fill_fast(&dyn_dist_code);
+
 	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
 }
 
@@ -628,6 +779,13 @@ static int inflate_dynamic(inflate_state_t *state)
  */
 int inflate(const void *src, size_t srclen, void *dest, size_t destlen)
 {
+	/* Fill the fast decode tables of the fixed codes once */
+	if (!fixed_fast_ready) {
+		huffman_fill_fast(&len_code);
+		huffman_fill_fast(&dist_code);
+		fixed_fast_ready = true;
+	}
+
 	/* Initialize the state */
 	inflate_state_t state;
 
@@ -312,6 +312,39 @@ _NO_TRACE static inline void invlpg(uintptr_t addr)
 	);
 }
 
+/* INVPCID invalidation types. */
+#define INVPCID_ADDR           0
+#define INVPCID_SINGLE_CTX     1
+#define INVPCID_ALL_GLOBAL     2
+#define INVPCID_ALL_NONGLOBAL  3
+
+/** Invalidate TLB entries tagged with a PCID.
+ *
+ * May only be used when the CPU supports the INVPCID instruction.
+ *
+ * @param type One of the INVPCID_* invalidation types.
+ * @param pcid PCID to operate on (ignored by the all-context types).
+ * @param addr Address whose entry is to be invalidated (INVPCID_ADDR only).
+ *
+ */
+_NO_TRACE static inline void invpcid(uint64_t type, uint64_t pcid,
+    uintptr_t addr)
+{
+	struct {
+		uint64_t pcid;
+		uint64_t addr;
+	} __attribute__((packed)) desc = {
+		.pcid = pcid,
+		.addr = addr
+	};
+
+	asm volatile (
+	    "invpcid %[desc], %[type]\n"
+	    :: [desc] "m" (desc), [type] "r" (type)
+	    : "memory"
+	);
+}
+
 /** Load GDTR register from memory.
  *
  * @param gdtr_reg Address of memory from where to load GDTR.
@@ -57,7 +57,13 @@
 #define CR0_PG		(1 << 31)
 
 #define CR4_PAE		(1 << 5)
+#define CR4_PGE		(1 << 7)
 #define CR4_OSFXSR	(1 << 9)
+#define CR4_PCIDE	(1 << 17)
+#define CR4_OSXSAVE	(1 << 18)
+
+/* When CR4.PCIDE is set, bits 11:0 of CR3 hold the current PCID. */
+#define CR3_PCID_MASK	0xfff
 
 /* EFER bits */
 #define AMD_SCE		(1 << 0)
@@ -81,6 +87,7 @@
 #ifndef __ASSEMBLER__
 
 #include <arch/pm.h>
+#include <stdbool.h>
 
 typedef struct {
 	int vendor;
@@ -92,6 +99,9 @@ typedef struct {
 	unsigned int id; /** CPU's local, ie physical, APIC ID. */
 
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
+
+	bool pcid;     /** CR4.PCIDE was enabled on this CPU. */
+	bool invpcid;  /** The INVPCID instruction is available. */
 } cpu_arch_t;
 
 struct star_msr {
@@ -39,11 +39,25 @@
 #define AMD_EXT_NOEXECUTE   20
 #define AMD_EXT_LONG_MODE   29
 
-#define INTEL_CPUID_LEVEL     0x00000000
-#define INTEL_CPUID_STANDARD  0x00000001
-#define INTEL_CPUID_EXTENDED  0x80000000
+#define INTEL_CPUID_LEVEL       0x00000000
+#define INTEL_CPUID_STANDARD    0x00000001
+#define INTEL_CPUID_STRUCTURED  0x00000007
+#define INTEL_CPUID_TOPOLOGY    0x0000000b
+#define INTEL_CPUID_XSTATE      0x0000000d
+#define INTEL_CPUID_EXTENDED    0x80000000
 #define INTEL_SSE2            26
 #define INTEL_FXSAVE          24
+#define INTEL_HTT             28
+/** Leaf 0x1 ECX: XSAVE instruction family supported. */
+#define INTEL_XSAVE           26
+/** Leaf 0x1 ECX: AVX instructions supported. */
+#define INTEL_AVX             28
+/** Leaf 0xd sub-leaf 1 EAX: XSAVEOPT instruction supported. */
+#define INTEL_XSAVEOPT         0
+/** Leaf 0x1 ECX: process-context identifiers supported. */
+#define INTEL_PCID            17
+/** Leaf 0x7 EBX: INVPCID instruction supported. */
+#define INTEL_INVPCID         10
 
 #ifndef __ASSEMBLER__
 
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2005 Jakub Vana
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_amd64_FPU_CONTEXT_H_
+#define KERN_amd64_FPU_CONTEXT_H_
+
+#include <stdint.h>
+
+/* XSAVE demands a 64-byte aligned save area. */
+#define FPU_CONTEXT_ALIGN  64
+
+/*
+ * Large enough for the legacy FXSAVE area (512 bytes), the XSAVE
+ * header (64 bytes) and the AVX component (256 bytes). State
+ * components that would not fit here (e.g. AVX-512) are never
+ * enabled in XCR0.
+ */
+#define FPU_CONTEXT_SIZE  832
+
+typedef struct {
+	uint8_t fpu[FPU_CONTEXT_SIZE];  /* (FX/X)SAVE and (FX/X)RSTOR storage area */
+} fpu_context_t;
+
+extern void fpu_xsave_init(void);
+
+#endif
+
+/** @}
+ */
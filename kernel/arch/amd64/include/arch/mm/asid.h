@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2005 Jakub Jermar
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64_mm
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * amd64 implements ASIDs using 12-bit process-context identifiers
+ * (PCIDs), available when CR4.PCIDE can be enabled. The ASID is
+ * written to bits 11:0 of CR3 by as_install_arch(), which makes
+ * address space switches possible without flushing the TLB.
+ *
+ * On processors without PCID support the ASIDs are still allocated,
+ * but they never make it to the hardware and every address space
+ * switch flushes the TLB as before.
+ */
+
+#ifndef KERN_amd64_ASID_H_
+#define KERN_amd64_ASID_H_
+
+#include <stdint.h>
+
+typedef int32_t asid_t;
+
+#define ASID_MAX_ARCH  4095	/* 2^12 - 1 */
+
+#endif
+
+/** @}
+ */
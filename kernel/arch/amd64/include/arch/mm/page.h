@@ -105,9 +105,12 @@
 	    ((((uint64_t) ((pte_t *) (ptl3))[(i)].addr_12_31) << 12) | \
 	    (((uint64_t) ((pte_t *) (ptl3))[(i)].addr_32_51) << 32)))
 
-/* Set PTE address accessors for each level. */
-#define SET_PTL0_ADDRESS_ARCH(ptl0) \
-	(write_cr3((uintptr_t) (ptl0)))
+/*
+ * Set PTE address accessors for each level. PTL0 is loaded into CR3
+ * by as_install_arch() so that it can be tagged with the address
+ * space's PCID.
+ */
+#define SET_PTL0_ADDRESS_ARCH(ptl0)
 #define SET_PTL1_ADDRESS_ARCH(ptl0, i, a) \
 	set_pt_addr((pte_t *) (ptl0), (size_t) (i), a)
 #define SET_PTL2_ADDRESS_ARCH(ptl1, i, a) \
@@ -135,7 +135,7 @@ void amd64_post_mm_init(void)
 
 	if (config.cpu_active == 1) {
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(IRQ_COUNT);
 
 		/* hard clock */
 		i8254_init();
@@ -35,6 +35,7 @@
 #include <cpu.h>
 #include <arch/cpu.h>
 #include <arch/cpuid.h>
+#include <arch/mm/as.h>
 #include <arch/pm.h>
 
 #include <arch.h>
@@ -75,6 +76,7 @@ void cpu_setup_fpu(void)
 {
 	write_cr0((read_cr0() & ~CR0_EM) | CR0_MP);
 	write_cr4(read_cr4() | CR4_OSFXSR);
+	fpu_xsave_init();
 }
 
 /** Set the TS flag to 1.
@@ -99,6 +101,7 @@ void cpu_arch_init(void)
 	CPU->arch.tss->iomap_base = &CPU->arch.tss->iomap[0] -
 	    ((uint8_t *) CPU->arch.tss);
 	CPU->fpu_owner = NULL;
+	pcid_init();
 }
 
 void cpu_identify(void)
@@ -108,6 +111,7 @@ void cpu_identify(void)
 	CPU->arch.vendor = VendorUnknown;
 	if (has_cpuid()) {
 		cpuid(INTEL_CPUID_LEVEL, &info);
+		uint32_t level = info.cpuid_eax;
 
 		/*
 		 * Check for AMD processor.
@@ -131,14 +135,42 @@ void cpu_identify(void)
 		CPU->arch.family = (info.cpuid_eax >> 8) & 0xf;
 		CPU->arch.model = (info.cpuid_eax >> 4) & 0xf;
 		CPU->arch.stepping = (info.cpuid_eax >> 0) & 0xf;
+
+		/*
+		 * Discover the cache topology. The initial APIC ID of this
+		 * CPU encodes its position in the topology: the number of
+		 * logical CPUs per package determines how many of its low
+		 * bits select a CPU within the package and the SMT
+		 * enumeration level (when available) how many of them
+		 * select a sibling within one physical core.
+		 */
+		uint32_t apic_id = (info.cpuid_ebx >> 24) & 0xff;
+
+		unsigned int package_shift = 0;
+		if (info.cpuid_edx & (UINT32_C(1) << INTEL_HTT)) {
+			uint32_t logical = (info.cpuid_ebx >> 16) & 0xff;
+			while ((UINT32_C(1) << package_shift) < logical)
+				package_shift++;
+		}
+
+		unsigned int smt_shift = 0;
+		if ((CPU->arch.vendor == VendorIntel) &&
+		    (level >= INTEL_CPUID_TOPOLOGY)) {
+			cpuid(INTEL_CPUID_TOPOLOGY, &info);
+			smt_shift = info.cpuid_eax & 0x1f;
+		}
+
+		CPU->core_id = apic_id >> smt_shift;
+		CPU->package_id = apic_id >> package_shift;
 	}
 }
 
 void cpu_print_report(cpu_t *m)
 {
-	printf("cpu%d: (%s family=%d model=%d stepping=%d apicid=%u) %dMHz\n",
-	    m->id, vendor_str[m->arch.vendor], m->arch.family, m->arch.model,
-	    m->arch.stepping, m->arch.id, m->frequency_mhz);
+	printf("cpu%d: (%s family=%d model=%d stepping=%d apicid=%u "
+	    "package=%u core=%u) %dMHz\n", m->id, vendor_str[m->arch.vendor],
+	    m->arch.family, m->arch.model, m->arch.stepping, m->arch.id,
+	    m->package_id, m->core_id, m->frequency_mhz);
 }
 
 /** @}
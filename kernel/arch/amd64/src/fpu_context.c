@@ -34,9 +34,55 @@
  */
 
 #include <fpu_context.h>
+#include <arch/cpu.h>
+#include <arch/cpuid.h>
+#include <arch/asm.h>
+#include <assert.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-/** Save FPU (mmx, sse) context using fxsave instruction */
-void fpu_context_save(fpu_context_t *fctx)
+/** Byte offset of the XSAVE header within the save area. */
+#define XSAVE_HEADER_OFFSET  512
+/** Size of the XSAVE header. */
+#define XSAVE_HEADER_SIZE    64
+
+/** Byte offset of MXCSR within the legacy FXSAVE area. */
+#define FXSAVE_MXCSR_OFFSET  24
+/** Power-on value of MXCSR: all SSE exceptions masked. */
+#define MXCSR_DEFAULT        0x1f80
+
+/** XCR0 state component bits. */
+#define XCR0_X87  (UINT64_C(1) << 0)
+#define XCR0_SSE  (UINT64_C(1) << 1)
+#define XCR0_AVX  (UINT64_C(1) << 2)
+
+typedef void (*fpu_context_function)(fpu_context_t *fctx);
+
+/*
+ * The boot CPU selects the save/restore implementation in
+ * fpu_xsave_init() before the first thread is created; the legacy
+ * FXSAVE pair is only kept for machines without XSAVE.
+ */
+static void fpu_context_fx_save(fpu_context_t *);
+static void fpu_context_fx_restore(fpu_context_t *);
+
+static fpu_context_function fpu_save = fpu_context_fx_save;
+static fpu_context_function fpu_restore = fpu_context_fx_restore;
+
+static bool fpu_xsave_enabled = false;
+
+/**
+ * Template restored into the FPU by fpu_init() when XSAVE is in use.
+ * The zeroed XSAVE header (XSTATE_BV == 0) makes XRSTOR put every
+ * enabled state component into its initial configuration; only MXCSR
+ * is loaded from the legacy area and is therefore seeded with its
+ * power-on value in fpu_xsave_init().
+ */
+static fpu_context_t initial_xstate
+    __attribute__((aligned(FPU_CONTEXT_ALIGN)));
+
+static void fpu_context_fx_save(fpu_context_t *fctx)
 {
 	asm volatile (
 	    "fxsave %[fctx]\n"
@@ -44,8 +90,7 @@ void fpu_context_save(fpu_context_t *fctx)
 	);
 }
 
-/** Restore FPU (mmx,sse) context using fxrstor instruction */
-void fpu_context_restore(fpu_context_t *fctx)
+static void fpu_context_fx_restore(fpu_context_t *fctx)
 {
 	asm volatile (
 	    "fxrstor %[fctx]\n"
@@ -53,9 +98,138 @@ void fpu_context_restore(fpu_context_t *fctx)
 	);
 }
 
+/** Prepare the XSAVE header of a save area for a subsequent XRSTOR.
+ *
+ * XSAVE and XSAVEOPT only write the XSTATE_BV field; XCOMP_BV and the
+ * reserved part of the header must already contain zeros, which is not
+ * guaranteed for a freshly slab-allocated context.
+ */
+static void xsave_header_clear(fpu_context_t *fctx)
+{
+	memsetb(fctx->fpu + XSAVE_HEADER_OFFSET, XSAVE_HEADER_SIZE, 0);
+}
+
+static void fpu_context_x_save(fpu_context_t *fctx)
+{
+	xsave_header_clear(fctx);
+	asm volatile (
+	    "xsave64 %[fctx]\n"
+	    : [fctx] "=m" (fctx->fpu)
+	    : "a" (UINT32_MAX), "d" (UINT32_MAX)
+	);
+}
+
+static void fpu_context_xopt_save(fpu_context_t *fctx)
+{
+	xsave_header_clear(fctx);
+	asm volatile (
+	    "xsaveopt64 %[fctx]\n"
+	    : [fctx] "=m" (fctx->fpu)
+	    : "a" (UINT32_MAX), "d" (UINT32_MAX)
+	);
+}
+
+static void fpu_context_x_restore(fpu_context_t *fctx)
+{
+	asm volatile (
+	    "xrstor64 %[fctx]\n"
+	    :
+	    : [fctx] "m" (fctx->fpu), "a" (UINT32_MAX), "d" (UINT32_MAX)
+	);
+}
+
+static void write_xcr0(uint64_t value)
+{
+	asm volatile (
+	    "xsetbv\n"
+	    :
+	    : "c" (0), "a" ((uint32_t) value), "d" ((uint32_t) (value >> 32))
+	);
+}
+
+static void cpuid_subleaf(uint32_t leaf, uint32_t subleaf, cpu_info_t *info)
+{
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (info->cpuid_eax), "=b" (info->cpuid_ebx),
+	      "=c" (info->cpuid_ecx), "=d" (info->cpuid_edx)
+	    : "a" (leaf), "c" (subleaf)
+	);
+}
+
+/** Enable the XSAVE family of instructions if the CPU supports it.
+ *
+ * Called once per processor from cpu_setup_fpu(). Sets CR4.OSXSAVE,
+ * enables the x87, SSE and (when available) AVX state components in
+ * XCR0 and selects XSAVEOPT-based context switching, so that only the
+ * components a thread actually modified are spilled and components in
+ * their initial configuration are not copied at all.
+ */
+void fpu_xsave_init(void)
+{
+	cpu_info_t info;
+
+	if (!has_cpuid())
+		return;
+
+	cpuid(INTEL_CPUID_STANDARD, &info);
+	if (!(info.cpuid_ecx & (1 << INTEL_XSAVE)))
+		return;
+
+	uint64_t xcr0 = XCR0_X87 | XCR0_SSE;
+	if (info.cpuid_ecx & (1 << INTEL_AVX))
+		xcr0 |= XCR0_AVX;
+
+	write_cr4(read_cr4() | CR4_OSXSAVE);
+	write_xcr0(xcr0);
+
+	/*
+	 * The save area size required for the enabled components is
+	 * only known after XCR0 has been written.
+	 */
+	cpuid_subleaf(INTEL_CPUID_XSTATE, 0, &info);
+	assert(info.cpuid_ebx <= FPU_CONTEXT_SIZE);
+
+	cpuid_subleaf(INTEL_CPUID_XSTATE, 1, &info);
+	if (info.cpuid_eax & (1 << INTEL_XSAVEOPT))
+		fpu_save = fpu_context_xopt_save;
+	else
+		fpu_save = fpu_context_x_save;
+
+	fpu_restore = fpu_context_x_restore;
+
+	uint32_t mxcsr = MXCSR_DEFAULT;
+	memcpy(initial_xstate.fpu + FXSAVE_MXCSR_OFFSET, &mxcsr,
+	    sizeof(mxcsr));
+
+	fpu_xsave_enabled = true;
+}
+
+/** Save FPU (x87, SSE, AVX) context */
+void fpu_context_save(fpu_context_t *fctx)
+{
+	fpu_save(fctx);
+}
+
+/** Restore FPU (x87, SSE, AVX) context */
+void fpu_context_restore(fpu_context_t *fctx)
+{
+	fpu_restore(fctx);
+}
+
 void fpu_init(void)
 {
-	/* TODO: Zero all SSE, MMX etc. registers */
+	if (fpu_xsave_enabled) {
+		/*
+		 * Put every enabled state component into its initial
+		 * configuration. Unlike plain fninit this also clears
+		 * the SSE and AVX registers left over from the
+		 * previous owner of the FPU.
+		 */
+		fpu_context_x_restore(&initial_xstate);
+		return;
+	}
+
 	/*
 	 * Default value of SCR register is 0x1f80,
 	 * it masks all FPU exceptions
@@ -1 +0,0 @@
-../../../ia32/src/mm/as.c
\ No newline at end of file
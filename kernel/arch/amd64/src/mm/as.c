@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2006 Jakub Jermar
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64_mm
+ * @{
+ */
+/** @file
+ */
+
+#include <arch/asm.h>
+#include <arch/cpu.h>
+#include <arch/cpuid.h>
+#include <arch/mm/as.h>
+#include <cpu.h>
+#include <genarch/mm/as_pt.h>
+#include <genarch/mm/asid_fifo.h>
+#include <genarch/mm/page_pt.h>
+#include <mm/as.h>
+#include <mm/asid.h>
+
+/** Loading CR3 with this bit set does not flush the TLB entries of
+ * the installed PCID (requires CR4.PCIDE).
+ */
+#define CR3_NOFLUSH  (UINT64_C(1) << 63)
+
+/** Architecture dependent address space init. */
+void as_arch_init(void)
+{
+	as_operations = &as_pt_operations;
+	asid_fifo_init();
+}
+
+/** Detect and enable PCID support on the current CPU.
+ *
+ * Called once per processor, before it starts scheduling threads.
+ * When the CPU supports process-context identifiers, CR4.PCIDE is
+ * enabled so that TLB entries are tagged with the ASID of their
+ * address space and context switches do not flush the TLB.
+ */
+void pcid_init(void)
+{
+	cpu_info_t info;
+
+	CPU->arch.pcid = false;
+	CPU->arch.invpcid = false;
+
+	if (!has_cpuid())
+		return;
+
+	cpuid(INTEL_CPUID_STANDARD, &info);
+	if (!(info.cpuid_ecx & (1 << INTEL_PCID)))
+		return;
+
+	cpuid(INTEL_CPUID_LEVEL, &info);
+	if (info.cpuid_eax >= INTEL_CPUID_STRUCTURED) {
+		cpuid(INTEL_CPUID_STRUCTURED, &info);
+		if (info.cpuid_ebx & (1 << INTEL_INVPCID))
+			CPU->arch.invpcid = true;
+	}
+
+	/*
+	 * CR4.PCIDE may only be set while CR3 carries PCID 0, which
+	 * holds at this point as the CPU still runs on the plain
+	 * kernel page table.
+	 */
+	write_cr4(read_cr4() | CR4_PCIDE);
+	CPU->arch.pcid = true;
+}
+
+/** Install address space on the processor.
+ *
+ * Load PTL0 into CR3, tagged with the address space's ASID (PCID).
+ * The TLB was purged of entries tagged with this ASID when the ASID
+ * was allocated and TLB shootdowns keep it coherent afterwards, so
+ * the non-flushing CR3 load is safe.
+ *
+ * @param as Address space.
+ */
+void as_install_arch(as_t *as)
+{
+	uint64_t ptl0 = (uint64_t) (uintptr_t) as->genarch.page_table;
+
+	if (!CPU->arch.pcid) {
+		write_cr3(ptl0);
+		return;
+	}
+
+	write_cr3(ptl0 | ((uint64_t) as->asid & CR3_PCID_MASK) |
+	    CR3_NOFLUSH);
+}
+
+/** @}
+ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2005 Jakub Jermar
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64_mm
+ * @{
+ */
+/** @file
+ */
+
+#include <mm/tlb.h>
+#include <mm/asid.h>
+#include <arch/mm/asid.h>
+#include <arch/asm.h>
+#include <arch/cpu.h>
+#include <cpu.h>
+#include <typedefs.h>
+
+/** Invalidate all entries in TLB.
+ *
+ * With CR4.PCIDE enabled, a CR3 reload only affects entries tagged
+ * with the current PCID, so the flush has to be done by other means.
+ */
+void tlb_invalidate_all(void)
+{
+	if ((CPU != NULL) && (CPU->arch.pcid)) {
+		if (CPU->arch.invpcid) {
+			invpcid(INVPCID_ALL_GLOBAL, 0, 0);
+		} else {
+			/*
+			 * Toggling CR4.PGE flushes the TLB entries of
+			 * all PCIDs, including global entries.
+			 */
+			sysarg_t cr4 = read_cr4();
+			write_cr4(cr4 ^ CR4_PGE);
+			write_cr4(cr4);
+		}
+	} else
+		write_cr3(read_cr3());
+}
+
+/** Invalidate all entries in TLB that belong to specified address space.
+ *
+ * @param asid ASID (PCID) whose entries are to be invalidated.
+ */
+void tlb_invalidate_asid(asid_t asid)
+{
+	if ((CPU != NULL) && (CPU->arch.pcid) && (CPU->arch.invpcid)) {
+		if (asid == ASID_KERNEL) {
+			/*
+			 * Kernel mappings are replicated under every PCID,
+			 * so a single-context invalidation of PCID 0 would
+			 * leave stale kernel translations cached under the
+			 * other PCIDs.
+			 */
+			tlb_invalidate_all();
+			return;
+		}
+
+		invpcid(INVPCID_SINGLE_CTX, (uint64_t) asid, 0);
+	} else
+		tlb_invalidate_all();
+}
+
+/** Invalidate TLB entries for specified page range belonging to specified address space.
+ *
+ * @param asid ASID (PCID) of the address space the pages belong to.
+ * @param page Address of the first page whose entry is to be invalidated.
+ * @param cnt Number of entries to invalidate.
+ */
+void tlb_invalidate_pages(asid_t asid, uintptr_t page, size_t cnt)
+{
+	unsigned int i;
+
+	if ((CPU != NULL) && (CPU->arch.pcid)) {
+		if (asid == ASID_KERNEL) {
+			/*
+			 * Kernel mappings are replicated under every
+			 * PCID and there is no way to invalidate a page
+			 * in all of them at once.
+			 */
+			tlb_invalidate_all();
+			return;
+		}
+
+		if ((uint64_t) asid != (read_cr3() & CR3_PCID_MASK)) {
+			/*
+			 * INVLPG only affects the current PCID.
+			 */
+			if (CPU->arch.invpcid) {
+				for (i = 0; i < cnt; i++) {
+					invpcid(INVPCID_ADDR,
+					    (uint64_t) asid,
+					    page + i * PAGE_SIZE);
+				}
+			} else
+				tlb_invalidate_all();
+			return;
+		}
+	}
+
+	for (i = 0; i < cnt; i++)
+		invlpg(page + i * PAGE_SIZE);
+}
+
+void tlb_arch_init(void)
+{
+}
+
+void tlb_print(void)
+{
+}
+
+/** @}
+ */
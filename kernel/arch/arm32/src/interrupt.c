@@ -103,7 +103,7 @@ void interrupt_init(void)
 	size_t irq_count;
 
 	irq_count = machine_get_irq_count();
-	irq_init(irq_count, irq_count);
+	irq_init(irq_count);
 
 	machine_timer_irq_start();
 }
@@ -153,7 +153,7 @@ static void timer_irq_handler(irq_t *irq)
 void interrupt_init(void)
 {
 	size_t irq_count = machine_get_irq_count();
-	irq_init(irq_count, irq_count);
+	irq_init(irq_count);
 
 	/* Initialize virtual timer. */
 	timer_suspend();
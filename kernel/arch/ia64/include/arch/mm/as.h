@@ -46,7 +46,7 @@
 typedef struct {
 } as_arch_t;
 
-#include <genarch/mm/as_ht.h>
+#include <genarch/mm/as_rt.h>
 
 #define as_constructor_arch(as, flags)  ((void)as, (void)flags, EOK)
 #define as_destructor_arch(as)          ((void)as, 0)
@@ -138,7 +138,7 @@ void ia64_post_mm_init(void)
 		    KM_NATURAL_ALIGNMENT, PAGE_WRITE | PAGE_NOT_CACHEABLE);
 
 		iosapic_init();
-		irq_init(INR_COUNT, INR_COUNT);
+		irq_init(INR_COUNT);
 	}
 	it_init();
 }
@@ -36,8 +36,8 @@
 #include <arch/mm/asid.h>
 #include <arch/mm/page.h>
 #include <assert.h>
-#include <genarch/mm/as_ht.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/as_rt.h>
+#include <genarch/mm/page_rt.h>
 #include <genarch/mm/asid_fifo.h>
 #include <mm/asid.h>
 #include <barrier.h>
@@ -45,7 +45,7 @@
 /** Architecture dependent address space init. */
 void as_arch_init(void)
 {
-	as_operations = &as_ht_operations;
+	as_operations = &as_rt_operations;
 	asid_fifo_init();
 }
 
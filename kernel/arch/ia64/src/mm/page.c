@@ -35,7 +35,7 @@
 
 #include <arch/mm/page.h>
 #include <assert.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/asid.h>
 #include <arch/mm/asid.h>
 #include <arch/mm/vhpt.h>
@@ -53,7 +53,7 @@ static void set_environment(void);
 /** Initialize ia64 virtual address translation subsystem. */
 void page_arch_init(void)
 {
-	page_mapping_operations = &ht_mapping_operations;
+	page_mapping_operations = &rt_mapping_operations;
 	pk_disable();
 	set_environment();
 }
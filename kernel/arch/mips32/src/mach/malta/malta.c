@@ -97,7 +97,7 @@ static void malta_isa_irq_handler(unsigned int i)
 
 void malta_init(void)
 {
-	irq_init(ISA_IRQ_COUNT, ISA_IRQ_COUNT);
+	irq_init(ISA_IRQ_COUNT);
 
 	i8259_init((i8259_t *) PIC0_BASE, (i8259_t *) PIC1_BASE, 0);
 	sysinfo_set_item_val("i8259", NULL, true);
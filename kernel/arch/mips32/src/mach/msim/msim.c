@@ -76,7 +76,7 @@ static void msim_irq_handler(unsigned int i)
 
 void msim_init(void)
 {
-	irq_init(HW_INTERRUPTS, HW_INTERRUPTS);
+	irq_init(HW_INTERRUPTS);
 
 	int_handler[INT_HW0] = msim_irq_handler;
 	int_handler[INT_HW1] = msim_irq_handler;
@@ -213,7 +213,7 @@ void ppc32_post_mm_init(void)
 		ofw_sysinfo_map();
 
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(IRQ_COUNT);
 
 		/* Merge all zones to 1 big zone */
 		zone_merge_all();
@@ -83,7 +83,7 @@ typedef struct {
 
 #endif /* CONFIG_TSB */
 
-#include <genarch/mm/as_ht.h>
+#include <genarch/mm/as_rt.h>
 
 #ifdef CONFIG_TSB
 #include <arch/mm/tsb.h>
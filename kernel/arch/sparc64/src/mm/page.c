@@ -35,7 +35,7 @@
 #include <mm/page.h>
 #include <arch/mm/page.h>
 #include <arch/mm/tlb.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/frame.h>
 #include <arch/mm/frame.h>
 #include <bitops.h>
@@ -47,7 +47,7 @@
 void page_arch_init(void)
 {
 	if (config.cpu_active == 1)
-		page_mapping_operations = &ht_mapping_operations;
+		page_mapping_operations = &rt_mapping_operations;
 }
 
 /** @}
@@ -36,7 +36,7 @@
 #include <arch/mm/tlb.h>
 #include <assert.h>
 #include <config.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <genarch/mm/asid_fifo.h>
 
 #ifdef CONFIG_TSB
@@ -54,7 +54,7 @@
 void as_arch_init(void)
 {
 	if (config.cpu_active == 1) {
-		as_operations = &as_ht_operations;
+		as_operations = &as_rt_operations;
 		asid_fifo_init();
 	}
 }
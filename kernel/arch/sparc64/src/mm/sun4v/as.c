@@ -37,7 +37,7 @@
 #include <arch/mm/pagesize.h>
 #include <arch/mm/tlb.h>
 #include <assert.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <genarch/mm/asid_fifo.h>
 #include <config.h>
 #include <arch/sun4v/hypercall.h>
@@ -57,7 +57,7 @@
 void as_arch_init(void)
 {
 	if (config.cpu_active == 1) {
-		as_operations = &as_ht_operations;
+		as_operations = &as_rt_operations;
 		asid_fifo_init();
 	}
 }
@@ -55,7 +55,7 @@
 #include <arch/asm.h>
 #include <arch/cpu.h>
 #include <arch/mm/pagesize.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 
 #ifdef CONFIG_TSB
 #include <arch/mm/tsb.h>
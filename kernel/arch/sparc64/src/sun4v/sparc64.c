@@ -114,7 +114,7 @@ void sun4v_post_mm_init(void)
 		 * We have 2^11 different interrupt vectors.
 		 * But we only create 128 buckets.
 		 */
-		irq_init(1 << 11, 128);
+		irq_init(1 << 11);
 	}
 }
 
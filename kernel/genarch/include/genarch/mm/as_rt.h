@@ -32,20 +32,17 @@
 /** @file
  */
 
-#ifndef KERN_AS_HT_H_
-#define KERN_AS_HT_H_
+#ifndef KERN_AS_RT_H_
+#define KERN_AS_RT_H_
 
 #include <mm/mm.h>
-#include <adt/hash_table.h>
 #include <typedefs.h>
 
-typedef struct {
-} as_genarch_t;
+#define AS_PAGE_TABLE
 
 struct as;
 
 typedef struct pte {
-	ht_link_t link;		/**< Page hash table link. */
 	struct as *as;		/**< Address space. */
 	uintptr_t page;		/**< Virtual memory page. */
 	uintptr_t frame;	/**< Physical memory frame. */
@@ -59,6 +56,14 @@ typedef struct pte {
 	unsigned p : 1;		/**< Present. */
 } pte_t;
 
+typedef struct {
+	/**
+	 * Per-address-space page mapping radix tree,
+	 * cast to page_rt_t by the mapping operations.
+	 */
+	pte_t *page_table;
+} as_genarch_t;
+
 #endif
 
 /** @}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2006 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_genarch_mm
+ * @{
+ */
+/**
+ * @file
+ * @brief This is the generic page mapping radix tree interface.
+ */
+
+#ifdef CONFIG_PAGE_RT
+
+#ifndef KERN_PAGE_RT_H_
+#define KERN_PAGE_RT_H_
+
+#include <typedefs.h>
+#include <mm/as.h>
+#include <mm/page.h>
+#include <mm/slab.h>
+#include <synch/spinlock.h>
+
+/** Number of key bits resolved by one radix tree level. */
+#define PAGE_RT_BITS    9
+#define PAGE_RT_SLOTS   (1 << PAGE_RT_BITS)
+#define PAGE_RT_MASK    (PAGE_RT_SLOTS - 1)
+
+/** Number of radix tree levels needed to resolve a page number. */
+#define PAGE_RT_LEVELS \
+	(((sizeof(uintptr_t) * 8 - PAGE_WIDTH) + PAGE_RT_BITS - 1) / \
+	PAGE_RT_BITS)
+
+/** Radix tree node.
+ *
+ * Interior slots point to nodes of the next level,
+ * last-level slots point to pte_t.
+ */
+typedef struct page_rt_node {
+	void *slots[PAGE_RT_SLOTS];
+} page_rt_node_t;
+
+/** Per-address-space page mapping radix tree. */
+typedef struct {
+	/**
+	 * This lock protects the radix tree. It must be acquired
+	 * after address space lock and after any address space area
+	 * locks.
+	 */
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Root node of the tree or NULL if the tree is empty. */
+	page_rt_node_t *root;
+} page_rt_t;
+
+/* Macros for querying radix tree PTEs. */
+#define PTE_VALID(pte)       ((void *) (pte) != NULL)
+#define PTE_PRESENT(pte)     ((pte)->p != 0)
+#define PTE_GET_FRAME(pte)   ((pte)->frame)
+#define PTE_READABLE(pte)    1
+#define PTE_WRITABLE(pte)    ((pte)->w != 0)
+#define PTE_EXECUTABLE(pte)  ((pte)->x != 0)
+
+extern as_operations_t as_rt_operations;
+extern page_mapping_operations_t rt_mapping_operations;
+
+extern slab_cache_t *pte_cache;
+extern slab_cache_t *page_rt_node_cache;
+
+#endif
+
+#endif
+
+/** @}
+ */
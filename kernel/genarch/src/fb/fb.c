@@ -88,6 +88,7 @@ typedef struct {
 	parea_t parea;
 
 	uint8_t *addr;
+	uint8_t *shadow;
 	uint16_t *backbuf;
 	uint8_t *glyphs;
 	uint8_t *bgscan;
@@ -237,10 +238,6 @@ static void glyph_draw(fb_instance_t *instance, uint16_t glyph,
 	if (!overlay)
 		instance->backbuf[BB_POS(instance, col, row)] = glyph;
 
-	/* Do not output if the framebuffer is used by user space */
-	if ((instance->parea.mapped) && (!console_override))
-		return;
-
 	/* Check whether the glyph should be visible */
 	if (row < instance->offset_row)
 		return;
@@ -253,51 +250,49 @@ static void glyph_draw(fb_instance_t *instance, uint16_t glyph,
 	unsigned int y = ROW2Y(rel_row);
 
 	for (unsigned int yd = 0; yd < FONT_SCANLINES; yd++)
-		memcpy(&instance->addr[FB_POS(instance, x, y + yd)],
+		memcpy(&instance->shadow[FB_POS(instance, x, y + yd)],
 		    &instance->glyphs[GLYPH_POS(instance, glyph, yd)],
 		    instance->glyphscanline);
+
+	/* Do not output if the framebuffer is used by user space */
+	if ((instance->parea.mapped) && (!console_override))
+		return;
+
+	for (unsigned int yd = 0; yd < FONT_SCANLINES; yd++)
+		memcpy(&instance->addr[FB_POS(instance, x, y + yd)],
+		    &instance->shadow[FB_POS(instance, x, y + yd)],
+		    instance->glyphscanline);
 }
 
-/** Scroll screen down by one row
+/** Render one visible row from the backbuffer into the shadow buffer
  *
  */
-static void screen_scroll(fb_instance_t *instance)
+static void shadow_render_row(fb_instance_t *instance, unsigned int rel_row)
 {
-	if ((!instance->parea.mapped) || (console_override)) {
-		for (unsigned int rel_row = 0; rel_row < instance->rowtrim; rel_row++) {
-			unsigned int y = ROW2Y(rel_row);
-			unsigned int row = rel_row + instance->offset_row;
-
-			for (unsigned int yd = 0; yd < FONT_SCANLINES; yd++) {
-				unsigned int x;
-				unsigned int col;
-				size_t bb_pos = BB_POS(instance, 0, row);
-				size_t bb_pos1 = BB_POS(instance, 0, row + 1);
-
-				for (col = 0, x = 0; col < instance->cols;
-				    col++, x += FONT_WIDTH) {
-					uint16_t glyph;
-
-					if (row < instance->rows - 1) {
-						if (instance->backbuf[bb_pos] ==
-						    instance->backbuf[bb_pos1])
-							goto skip;
-
-						glyph = instance->backbuf[bb_pos1];
-					} else
-						glyph = 0;
-
-					memcpy(&instance->addr[FB_POS(instance, x, y + yd)],
-					    &instance->glyphs[GLYPH_POS(instance, glyph, yd)],
-					    instance->glyphscanline);
-				skip:
-					BB_NEXT_COL(bb_pos);
-					BB_NEXT_COL(bb_pos1);
-				}
-			}
+	unsigned int y = ROW2Y(rel_row);
+	unsigned int row = rel_row + instance->offset_row;
+
+	for (unsigned int yd = 0; yd < FONT_SCANLINES; yd++) {
+		unsigned int x;
+		unsigned int col;
+		size_t bb_pos = BB_POS(instance, 0, row);
+
+		for (col = 0, x = 0; col < instance->cols;
+		    col++, x += FONT_WIDTH) {
+			uint16_t glyph = instance->backbuf[bb_pos];
+			memcpy(&instance->shadow[FB_POS(instance, x, y + yd)],
+			    &instance->glyphs[GLYPH_POS(instance, glyph, yd)],
+			    instance->glyphscanline);
+			BB_NEXT_COL(bb_pos);
 		}
 	}
+}
 
+/** Scroll screen down by one row
+ *
+ */
+static void screen_scroll(fb_instance_t *instance)
+{
 	/*
 	 * Implement backbuffer scrolling by wrapping around
 	 * the cyclic buffer.
@@ -309,6 +304,24 @@ static void screen_scroll(fb_instance_t *instance)
 
 	memsetw(&instance->backbuf[BB_POS(instance, 0, instance->rows - 1)],
 	    instance->cols, 0);
+
+	/*
+	 * Scroll the shadow buffer by one large move, re-render only
+	 * the row that became visible at the bottom and send the
+	 * visible area to VRAM in a single linear blit. Glyph-by-glyph
+	 * redrawing over a slow mapped framebuffer is what used to
+	 * make scrolling expensive.
+	 */
+
+	size_t rowbytes = FONT_SCANLINES * instance->scanline;
+
+	memmove(instance->shadow, instance->shadow + rowbytes,
+	    rowbytes * (instance->rowtrim - 1));
+	shadow_render_row(instance, instance->rowtrim - 1);
+
+	if ((!instance->parea.mapped) || (console_override))
+		memcpy(instance->addr, instance->shadow,
+		    rowbytes * instance->rowtrim);
 }
 
 static void cursor_put(fb_instance_t *instance)
@@ -372,26 +385,8 @@ static void glyphs_render(fb_instance_t *instance)
 
 static void fb_redraw_internal(fb_instance_t *instance)
 {
-	for (unsigned int rel_row = 0; rel_row < instance->rowtrim; rel_row++) {
-		unsigned int y = ROW2Y(rel_row);
-		unsigned int row = rel_row + instance->offset_row;
-
-		for (unsigned int yd = 0; yd < FONT_SCANLINES; yd++) {
-			unsigned int x;
-			unsigned int col;
-			size_t bb_pos = BB_POS(instance, 0, row);
-
-			for (col = 0, x = 0; col < instance->cols;
-			    col++, x += FONT_WIDTH) {
-				uint16_t glyph =
-				    instance->backbuf[bb_pos];
-				void *dst = &instance->addr[FB_POS(instance, x, y + yd)];
-				void *src = &instance->glyphs[GLYPH_POS(instance, glyph, yd)];
-				memcpy(dst, src, instance->glyphscanline);
-				BB_NEXT_COL(bb_pos);
-			}
-		}
-	}
+	for (unsigned int rel_row = 0; rel_row < instance->rowtrim; rel_row++)
+		shadow_render_row(instance, rel_row);
 
 	if (COL2X(instance->cols) < instance->xres) {
 		unsigned int y;
@@ -399,7 +394,7 @@ static void fb_redraw_internal(fb_instance_t *instance)
 		    (instance->xres - COL2X(instance->cols)) * instance->pixelbytes;
 
 		for (y = 0; y < instance->yres; y++)
-			memcpy(&instance->addr[FB_POS(instance, COL2X(instance->cols), y)],
+			memcpy(&instance->shadow[FB_POS(instance, COL2X(instance->cols), y)],
 			    instance->bgscan, size);
 	}
 
@@ -407,9 +402,13 @@ static void fb_redraw_internal(fb_instance_t *instance)
 		unsigned int y;
 
 		for (y = ROW2Y(instance->rowtrim); y < instance->yres; y++)
-			memcpy(&instance->addr[FB_POS(instance, 0, y)],
+			memcpy(&instance->shadow[FB_POS(instance, 0, y)],
 			    instance->bgscan, instance->bgscanbytes);
 	}
+
+	/* The whole screen was composed in RAM; send it out in one blit. */
+	memcpy(instance->addr, instance->shadow,
+	    instance->scanline * instance->yres);
 }
 
 /** Print character to screen
@@ -640,9 +639,18 @@ outdev_t *fb_init(fb_properties_t *props)
 		return NULL;
 	}
 
+	instance->shadow = (uint8_t *) malloc(fbsize);
+	if (!instance->shadow) {
+		LOG("Unable to allocate shadow buffer.");
+		free(instance);
+		free(fbdev);
+		return NULL;
+	}
+
 	instance->backbuf = (uint16_t *) malloc(bbsize);
 	if (!instance->backbuf) {
 		LOG("Unable to allocate backbuffer.");
+		free(instance->shadow);
 		free(instance);
 		free(fbdev);
 		return NULL;
@@ -652,6 +660,7 @@ outdev_t *fb_init(fb_properties_t *props)
 	if (!instance->glyphs) {
 		LOG("Unable to allocate glyphs.");
 		free(instance->backbuf);
+		free(instance->shadow);
 		free(instance);
 		free(fbdev);
 		return NULL;
@@ -662,11 +671,14 @@ outdev_t *fb_init(fb_properties_t *props)
 		LOG("Unable to allocate background pixel.");
 		free(instance->glyphs);
 		free(instance->backbuf);
+		free(instance->shadow);
 		free(instance);
 		free(fbdev);
 		return NULL;
 	}
 
+	memsetb(instance->shadow, fbsize, 0);
+
 	memsetw(instance->backbuf, instance->cols * instance->rows, 0);
 	glyphs_render(instance);
 
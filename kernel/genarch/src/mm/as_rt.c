@@ -32,65 +32,110 @@
 
 /**
  * @file
- * @brief Address space functions for global page hash table.
+ * @brief Address space functions for per-address-space page mapping
+ *        radix trees.
  */
 
 #include <arch/mm/as.h>
-#include <genarch/mm/as_ht.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/as_rt.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/as.h>
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <typedefs.h>
-#include <adt/hash_table.h>
 #include <synch/mutex.h>
+#include <stdlib.h>
+#include <assert.h>
 
-static pte_t *ht_create(unsigned int);
-static void ht_destroy(pte_t *);
+static pte_t *rt_create(unsigned int);
+static void rt_destroy(pte_t *);
 
-static void ht_lock(as_t *, bool);
-static void ht_unlock(as_t *, bool);
-static bool ht_locked(as_t *);
+static void rt_lock(as_t *, bool);
+static void rt_unlock(as_t *, bool);
+static bool rt_locked(as_t *);
 
-as_operations_t as_ht_operations = {
-	.page_table_create = ht_create,
-	.page_table_destroy = ht_destroy,
-	.page_table_lock = ht_lock,
-	.page_table_unlock = ht_unlock,
-	.page_table_locked = ht_locked,
+as_operations_t as_rt_operations = {
+	.page_table_create = rt_create,
+	.page_table_destroy = rt_destroy,
+	.page_table_lock = rt_lock,
+	.page_table_unlock = rt_unlock,
+	.page_table_locked = rt_locked,
 };
 
-/** Page hash table create.
+/** Create a page mapping radix tree.
  *
- * The page hash table will be created only once
- * and will be shared by all address spaces.
+ * Every address space gets a radix tree of its own. When the kernel
+ * address space is created, the caches backing the PTEs and the tree
+ * nodes are created as well.
  *
- * @param flags Ignored.
+ * @param flags Flags saying whether the kernel address space is being
+ *              created.
  *
- * @return Returns NULL.
+ * @return Empty radix tree cast to pte_t *.
  *
  */
-pte_t *ht_create(unsigned int flags)
+pte_t *rt_create(unsigned int flags)
 {
 	if (flags & FLAG_AS_KERNEL) {
-		hash_table_create(&page_ht, 0, 0, &ht_ops);
 		pte_cache = slab_cache_create("pte_t", sizeof(pte_t), 0,
 		    NULL, NULL, SLAB_CACHE_MAGDEFERRED);
+		page_rt_node_cache = slab_cache_create("page_rt_node_t",
+		    sizeof(page_rt_node_t), 0, NULL, NULL,
+		    SLAB_CACHE_MAGDEFERRED);
 	}
 
-	return NULL;
+	page_rt_t *rt = malloc(sizeof(page_rt_t));
+	if (!rt)
+		return NULL;
+
+	irq_spinlock_initialize(&rt->lock, "as.page_rt_lock");
+	rt->root = NULL;
+
+	return (pte_t *) rt;
+}
+
+/** Free a radix tree node and everything below it.
+ *
+ * @param node  Node to be freed.
+ * @param level Level of the node, PAGE_RT_LEVELS - 1 for the root.
+ *
+ */
+static void rt_node_destroy(page_rt_node_t *node, unsigned int level)
+{
+	size_t index;
+	for (index = 0; index < PAGE_RT_SLOTS; index++) {
+		if (!node->slots[index])
+			continue;
+
+		if (level > 0)
+			rt_node_destroy((page_rt_node_t *) node->slots[index],
+			    level - 1);
+		else
+			slab_free(pte_cache, node->slots[index]);
+	}
+
+	slab_free(page_rt_node_cache, node);
 }
 
-/** Destroy page table.
+/** Destroy the page mapping radix tree of an address space.
  *
- * Actually do nothing as the global page hash table is used.
+ * All mappings are expected to have been removed along with the
+ * address space areas; only the tree skeleton (and possibly leaked
+ * PTEs) is reclaimed here.
  *
- * @param page_table This parameter is ignored.
+ * @param page_table Radix tree cast to pte_t *.
  *
  */
-void ht_destroy(pte_t *page_table)
+void rt_destroy(pte_t *page_table)
 {
-	/* No-op. */
+	page_rt_t *rt = (page_rt_t *) page_table;
+
+	assert(rt != NULL);
+
+	if (rt->root)
+		rt_node_destroy(rt->root, PAGE_RT_LEVELS - 1);
+
+	free(rt);
 }
 
 /** Lock page table.
@@ -102,7 +147,7 @@ void ht_destroy(pte_t *page_table)
  * @param lock If false, do not attempt to lock the address space.
  *
  */
-void ht_lock(as_t *as, bool lock)
+void rt_lock(as_t *as, bool lock)
 {
 	if (lock)
 		mutex_lock(&as->lock);
@@ -117,7 +162,7 @@ void ht_lock(as_t *as, bool lock)
  * @param unlock If false, do not attempt to lock the address space.
  *
  */
-void ht_unlock(as_t *as, bool unlock)
+void rt_unlock(as_t *as, bool unlock)
 {
 	if (unlock)
 		mutex_unlock(&as->lock);
@@ -130,7 +175,7 @@ void ht_unlock(as_t *as, bool unlock)
  * @return		True if the page tables belonging to the address soace
  *			are locked, otherwise false.
  */
-bool ht_locked(as_t *as)
+bool rt_locked(as_t *as)
 {
 	return mutex_locked(&as->lock);
 }
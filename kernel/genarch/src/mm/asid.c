@@ -125,7 +125,7 @@ asid_t asid_get(void)
 		/*
 		 * Get the system rid of the stolen ASID.
 		 */
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_ASID, asid, 0, 0);
+		ipl_t ipl = tlb_shootdown_start(as, TLB_INVL_ASID, asid, 0, 0);
 		tlb_invalidate_asid(asid);
 		tlb_shootdown_finalize(ipl);
 	} else {
@@ -141,7 +141,7 @@ asid_t asid_get(void)
 		/*
 		 * Purge the allocated ASID from TLBs.
 		 */
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_ASID, asid, 0, 0);
+		ipl_t ipl = tlb_shootdown_start(NULL, TLB_INVL_ASID, asid, 0, 0);
 		tlb_invalidate_asid(asid);
 		tlb_shootdown_finalize(ipl);
 	}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2006 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_genarch_mm
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Virtual Address Translation (VAT) for per-address-space page
+ *        mapping radix trees.
+ *
+ * Unlike the former global page hash table, every address space owns
+ * its own radix tree guarded by its own lock, so page faults taken in
+ * different address spaces do not serialize against each other.
+ */
+
+#include <genarch/mm/page_rt.h>
+#include <mm/page.h>
+#include <arch/mm/page.h>
+#include <mm/frame.h>
+#include <mm/slab.h>
+#include <mm/as.h>
+#include <arch/mm/asid.h>
+#include <typedefs.h>
+#include <arch/asm.h>
+#include <barrier.h>
+#include <synch/spinlock.h>
+#include <arch.h>
+#include <assert.h>
+#include <align.h>
+#include <mem.h>
+
+static void rt_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
+static void rt_mapping_remove(as_t *, uintptr_t);
+static bool rt_mapping_find(as_t *, uintptr_t, bool, pte_t *);
+static void rt_mapping_update(as_t *, uintptr_t, bool, pte_t *);
+static void rt_mapping_make_global(uintptr_t, size_t);
+
+slab_cache_t *pte_cache = NULL;
+slab_cache_t *page_rt_node_cache = NULL;
+
+/** Page mapping operations for radix tree architectures. */
+page_mapping_operations_t rt_mapping_operations = {
+	.mapping_insert = rt_mapping_insert,
+	.mapping_remove = rt_mapping_remove,
+	.mapping_find = rt_mapping_find,
+	.mapping_update = rt_mapping_update,
+	.mapping_make_global = rt_mapping_make_global
+};
+
+/** Get the radix tree of an address space. */
+static page_rt_t *rt_get(as_t *as)
+{
+	return (page_rt_t *) as->genarch.page_table;
+}
+
+/** Allocate and clear a radix tree node. */
+static page_rt_node_t *rt_node_alloc(void)
+{
+	page_rt_node_t *node = slab_alloc(page_rt_node_cache,
+	    FRAME_LOWMEM | FRAME_ATOMIC);
+	assert(node != NULL);
+
+	memsetb(node, sizeof(page_rt_node_t), 0);
+	return node;
+}
+
+/** Find the leaf slot for the given page.
+ *
+ * Walk the radix tree from the root towards the leaf level, resolving
+ * PAGE_RT_BITS of the virtual page number per level. Must be called
+ * with the tree lock held.
+ *
+ * @param rt     Radix tree to search.
+ * @param page   Virtual address of the page (page-aligned).
+ * @param create If true, missing interior nodes are allocated.
+ *
+ * @return Pointer to the leaf slot holding the PTE (which may be NULL)
+ *         or NULL if the path does not exist and create is false.
+ *
+ */
+static pte_t **rt_slot_find(page_rt_t *rt, uintptr_t page, bool create)
+{
+	if (!rt->root) {
+		if (!create)
+			return NULL;
+
+		rt->root = rt_node_alloc();
+	}
+
+	uintptr_t vpn = page >> PAGE_WIDTH;
+	page_rt_node_t *node = rt->root;
+
+	unsigned int level;
+	for (level = PAGE_RT_LEVELS - 1; level > 0; level--) {
+		size_t index = (vpn >> (level * PAGE_RT_BITS)) & PAGE_RT_MASK;
+
+		page_rt_node_t *child = (page_rt_node_t *) node->slots[index];
+		if (!child) {
+			if (!create)
+				return NULL;
+
+			child = rt_node_alloc();
+
+			/*
+			 * Make sure the cleared node is visible before
+			 * it is linked into the tree.
+			 */
+			write_barrier();
+			node->slots[index] = child;
+		}
+
+		node = child;
+	}
+
+	return (pte_t **) &node->slots[vpn & PAGE_RT_MASK];
+}
+
+/** Map page to frame using the radix tree.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void rt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	page_rt_t *rt = rt_get(as);
+
+	assert(page_table_locked(as));
+
+	irq_spinlock_lock(&rt->lock, true);
+
+	pte_t **slot = rt_slot_find(rt, ALIGN_DOWN(page, PAGE_SIZE), true);
+	if (*slot == NULL) {
+		pte_t *pte = slab_alloc(pte_cache, FRAME_LOWMEM | FRAME_ATOMIC);
+		assert(pte != NULL);
+
+		pte->g = (flags & PAGE_GLOBAL) != 0;
+		pte->x = (flags & PAGE_EXEC) != 0;
+		pte->w = (flags & PAGE_WRITE) != 0;
+		pte->k = !(flags & PAGE_USER);
+		pte->c = (flags & PAGE_CACHEABLE) != 0;
+		pte->p = !(flags & PAGE_NOT_PRESENT);
+		pte->a = false;
+		pte->d = false;
+
+		pte->as = as;
+		pte->page = ALIGN_DOWN(page, PAGE_SIZE);
+		pte->frame = ALIGN_DOWN(frame, FRAME_SIZE);
+
+		/*
+		 * Make sure that a concurrent rt_mapping_find() will see the
+		 * new entry only after it is fully initialized.
+		 */
+		write_barrier();
+
+		*slot = pte;
+	}
+
+	irq_spinlock_unlock(&rt->lock, true);
+}
+
+/** Remove mapping of page from the radix tree.
+ *
+ * Remove any mapping of page within address space as.
+ * TLB shootdown should follow in order to make effects of
+ * this call visible.
+ *
+ * Interior nodes emptied by the removal are intentionally left in
+ * place; they are reclaimed when the address space is destroyed.
+ *
+ * @param as   Address space to which page belongs.
+ * @param page Virtual address of the page to be demapped.
+ *
+ */
+void rt_mapping_remove(as_t *as, uintptr_t page)
+{
+	page_rt_t *rt = rt_get(as);
+
+	assert(page_table_locked(as));
+
+	irq_spinlock_lock(&rt->lock, true);
+
+	pte_t **slot = rt_slot_find(rt, ALIGN_DOWN(page, PAGE_SIZE), false);
+	if ((slot) && (*slot)) {
+		slab_free(pte_cache, *slot);
+		*slot = NULL;
+	}
+
+	irq_spinlock_unlock(&rt->lock, true);
+}
+
+static pte_t *rt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+{
+	assert(nolock || page_table_locked(as));
+
+	pte_t **slot = rt_slot_find(rt_get(as), ALIGN_DOWN(page, PAGE_SIZE),
+	    false);
+	if (slot)
+		return *slot;
+
+	return NULL;
+}
+
+/** Find mapping for virtual page in the radix tree.
+ *
+ * @param as       Address space to which page belongs.
+ * @param page     Virtual page.
+ * @param nolock   True if the page tables need not be locked.
+ * @param[out] pte Structure that will receive a copy of the found PTE.
+ *
+ * @return True if the mapping was found, false otherwise.
+ */
+bool rt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
+{
+	page_rt_t *rt = rt_get(as);
+
+	irq_spinlock_lock(&rt->lock, true);
+
+	pte_t *t = rt_mapping_find_internal(as, page, nolock);
+	if (t)
+		*pte = *t;
+
+	irq_spinlock_unlock(&rt->lock, true);
+
+	return t != NULL;
+}
+
+/** Update mapping for virtual page in the radix tree.
+ *
+ * @param as       Address space to which page belongs.
+ * @param page     Virtual page.
+ * @param nolock   True if the page tables need not be locked.
+ * @param pte      New PTE.
+ */
+void rt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
+{
+	page_rt_t *rt = rt_get(as);
+
+	irq_spinlock_lock(&rt->lock, true);
+
+	pte_t *t = rt_mapping_find_internal(as, page, nolock);
+	if (!t)
+		panic("Updating non-existent PTE");
+
+	assert(pte->as == t->as);
+	assert(pte->page == t->page);
+	assert(pte->frame == t->frame);
+	assert(pte->g == t->g);
+	assert(pte->x == t->x);
+	assert(pte->w == t->w);
+	assert(pte->k == t->k);
+	assert(pte->c == t->c);
+	assert(pte->p == t->p);
+
+	t->a = pte->a;
+	t->d = pte->d;
+
+	irq_spinlock_unlock(&rt->lock, true);
+}
+
+void rt_mapping_make_global(uintptr_t base, size_t size)
+{
+	/* nothing to do */
+}
+
+/** @}
+ */
@@ -75,6 +75,15 @@ typedef struct {
 	hash_table_ops_t *op;
 	list_t *bucket;
 	size_t bucket_cnt;
+	/**
+	 * Bucket array of the previous size while a resize is in
+	 * progress, NULL otherwise. Items are migrated to the current
+	 * bucket array incrementally by the mutating operations.
+	 */
+	list_t *old_bucket;
+	size_t old_bucket_cnt;
+	/** Index of the next old bucket to be migrated in order. */
+	size_t migrate_idx;
 	size_t full_item_cnt;
 	size_t item_cnt;
 	size_t max_load;
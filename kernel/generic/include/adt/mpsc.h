@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2018 CZ.NIC, z.s.p.o.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_MPSC_H_
+#define KERN_MPSC_H_
+
+#include <atomic.h>
+#include <member.h>
+#include <stddef.h>
+
+/** Lock-free multi-producer single-consumer queue link. */
+typedef struct mpsc_link {
+	/** Pointer to the next (younger) item in the queue. */
+	_Atomic(struct mpsc_link *) next;
+} mpsc_link_t;
+
+/** Lock-free multi-producer single-consumer intrusive queue.
+ *
+ * Any number of producers may push concurrently without taking a lock.
+ * Popping and iterating are reserved for a single consumer at a time;
+ * the user is responsible for serializing consumers externally.
+ */
+typedef struct mpsc_queue {
+	/** The youngest item in the queue. Modified by producers. */
+	_Atomic(mpsc_link_t *) tail;
+	/** The oldest (already consumed) item. Consumer-private. */
+	mpsc_link_t *head;
+	/** Dummy item making sure the queue is never completely empty. */
+	mpsc_link_t stub;
+} mpsc_queue_t;
+
+#define mpsc_queue_get_instance(link, type, member) \
+	member_to_inst(link, type, member)
+
+extern void mpsc_queue_initialize(mpsc_queue_t *);
+extern void mpsc_queue_push(mpsc_queue_t *, mpsc_link_t *);
+extern mpsc_link_t *mpsc_queue_pop(mpsc_queue_t *);
+extern mpsc_link_t *mpsc_queue_first(mpsc_queue_t *);
+extern mpsc_link_t *mpsc_queue_next(mpsc_queue_t *, mpsc_link_t *);
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_OBTREE_H_
+#define _LIBC_OBTREE_H_
+
+#include <errno.h>
+#include <member.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <types/adt/obtree.h>
+
+#define obtree_get_instance(olink, type, member) \
+	member_to_inst(olink, type, member)
+
+extern void obtree_init(void);
+extern void obtree_initialize(obtree_t *, obt_getkey_t, obt_cmp_t);
+extern void obtree_finalize(obtree_t *);
+extern void obt_link_initialize(obt_link_t *);
+extern errno_t obtree_insert(obt_link_t *, obtree_t *);
+extern void obtree_remove(obt_link_t *);
+extern errno_t obtree_key_update(obt_link_t *, obtree_t *);
+extern bool obt_link_used(obt_link_t *);
+extern bool obtree_empty(obtree_t *);
+extern unsigned long obtree_count(obtree_t *);
+extern obt_link_t *obtree_first(obtree_t *);
+extern obt_link_t *obtree_last(obtree_t *);
+extern obt_link_t *obtree_prev(obt_link_t *, obtree_t *);
+extern obt_link_t *obtree_next(obt_link_t *, obtree_t *);
+extern obt_link_t *obtree_find_eq(obtree_t *, void *);
+extern obt_link_t *obtree_find_eq_last(obtree_t *, void *);
+extern obt_link_t *obtree_find_geq(obtree_t *, void *);
+extern obt_link_t *obtree_find_gt(obtree_t *, void *);
+extern obt_link_t *obtree_find_leq(obtree_t *, void *);
+extern obt_link_t *obtree_find_lt(obtree_t *, void *);
+extern errno_t obtree_validate(obtree_t *);
+
+#endif
+
+/** @}
+ */
@@ -93,6 +93,12 @@ typedef struct kobject {
 		struct phone *phone;
 		struct waitq *waitq;
 	};
+
+	/**
+	 * Link to the deferred reclamation queue. Used only after the last
+	 * reference has been dropped, when the kobject is already dead.
+	 */
+	link_t reclaim_link;
 } kobject_t;
 
 /*
@@ -126,6 +132,7 @@ typedef struct cap_info {
 } cap_info_t;
 
 extern void caps_init(void);
+extern void caps_reclaim_init(void);
 extern errno_t caps_task_alloc(struct task *);
 extern void caps_task_free(struct task *);
 extern void caps_task_init(struct task *);
@@ -144,6 +151,7 @@ extern void kobject_initialize(kobject_t *, kobject_type_t, void *);
 extern kobject_t *kobject_get(struct task *, cap_handle_t, kobject_type_t);
 extern void kobject_add_ref(kobject_t *);
 extern void kobject_put(kobject_t *);
+extern void kobject_put_deferred(kobject_t *);
 
 #endif
 
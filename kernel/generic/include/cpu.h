@@ -35,12 +35,17 @@
 #ifndef KERN_CPU_H_
 #define KERN_CPU_H_
 
+#include <abi/sysinfo.h>
 #include <mm/tlb.h>
+#include <mm/as.h>
+#include <mm/frame.h>
 #include <synch/spinlock.h>
 #include <proc/scheduler.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
 #include <adt/list.h>
+#include <time/timeout.h>
+#include <lattrace.h>
 #include <arch.h>
 
 #define CPU                  CURRENT->cpu
@@ -61,8 +66,41 @@ typedef struct cpu {
 	runq_t rq[RQ_COUNT];
 	volatile size_t needs_relink;
 
+	/**
+	 * Run queue of SCHED_CLASS_DEADLINE threads, ordered by their
+	 * absolute deadlines. Always served before the priority queues.
+	 */
+	runq_t deadline_rq;
+
+	/**
+	 * Admitted utilization of deadline-class threads in per mille.
+	 * Protected by lock.
+	 */
+	size_t deadline_load;
+
+	/**
+	 * Number of passes through the scheduler on this CPU.
+	 * Used for RCU grace period detection.
+	 */
+	atomic_t rcu_passes;
+
+	/**
+	 * Cache of free single low-memory frames. This variable is
+	 * CPU-local and can be only accessed when interrupts are
+	 * disabled.
+	 */
+	uintptr_t frame_cache[FRAME_CACHE_SIZE];
+	size_t frame_cache_cnt;
+
+	/**
+	 * MRU cache of address space areas recently hit by page
+	 * faults on this CPU. This variable is CPU-local and can be
+	 * only accessed when interrupts are disabled.
+	 */
+	as_area_cache_t area_cache[AS_AREA_CACHE_SIZE];
+
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+	timeout_wheel_t timeout_wheel;
 
 	/**
 	 * When system clock loses a tick, it is
@@ -73,6 +111,14 @@ typedef struct cpu {
 	 */
 	size_t missed_clock_ticks;
 
+	/**
+	 * Interrupt state of the innermost exception being
+	 * serviced on this CPU. Set by exc_dispatch() and
+	 * sampled by the profiler. This variable is CPU-local
+	 * and can be only accessed when interrupts are disabled.
+	 */
+	struct istate *current_istate;
+
 	/**
 	 * Processor cycle accounting.
 	 */
@@ -81,11 +127,44 @@ typedef struct cpu {
 	uint64_t idle_cycles;
 	uint64_t busy_cycles;
 
+	/**
+	 * True if the periodic tick is stopped while this CPU idles
+	 * (see clock_idle_enter()). This variable is CPU-local and can
+	 * be only accessed when interrupts are disabled.
+	 */
+	bool tick_stopped;
+
+	/**
+	 * Latency tracer state: the longest interrupt-off and
+	 * preemption-off sections observed on this CPU. Only ever
+	 * touched by code executing on this CPU (see lattrace.c).
+	 */
+	lattrace_cpu_t lattrace;
+
+	/**
+	 * Event counters (indexed by stats_event_t). Incremented with
+	 * plain stores by code running on this CPU and exported to
+	 * uspace through the statistics region. Approximate by design:
+	 * an increment from preemptible context may be lost when the
+	 * thread migrates in the middle of it.
+	 */
+	uint64_t events[STATS_EVENT_MAX];
+
 	/**
 	 * Processor ID assigned by kernel.
 	 */
 	unsigned int id;
 
+	/**
+	 * Cache topology of the processor. CPUs with the same package_id
+	 * share the last-level cache and CPUs which additionally have the
+	 * same core_id are SMT siblings sharing one physical core. Set to
+	 * conservative defaults by cpu_init() and refined by architectures
+	 * which can discover the real topology.
+	 */
+	unsigned int package_id;
+	unsigned int core_id;
+
 	bool active;
 	volatile bool tlb_active;
 
@@ -104,6 +183,29 @@ typedef struct cpu {
 
 extern cpu_t *cpus;
 
+/** Count an event on the current CPU.
+ *
+ * May be called from any context; events occurring before the CPU
+ * structure is set up are not counted.
+ */
+static inline void cpu_count_event(stats_event_t event)
+{
+	if (CPU != NULL)
+		CPU->events[event]++;
+}
+
+/** Decide whether two CPUs are SMT siblings sharing one physical core. */
+static inline bool cpu_shares_core(cpu_t *a, cpu_t *b)
+{
+	return (a->package_id == b->package_id) && (a->core_id == b->core_id);
+}
+
+/** Decide whether two CPUs share the last-level cache. */
+static inline bool cpu_shares_cache(cpu_t *a, cpu_t *b)
+{
+	return a->package_id == b->package_id;
+}
+
 extern void cpu_init(void);
 extern void cpu_list(void);
 
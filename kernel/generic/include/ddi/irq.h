@@ -38,7 +38,6 @@
 #include <typedefs.h>
 #include <abi/ddi/irq.h>
 #include <adt/list.h>
-#include <adt/hash_table.h>
 #include <synch/spinlock.h>
 #include <proc/task.h>
 #include <ipc/ipc.h>
@@ -61,6 +60,26 @@ typedef void (*irq_handler_t)(struct irq *);
 /** Type for function used to clear the interrupt. */
 typedef void (*cir_t)(void *, inr_t);
 
+/** One pre-translated top-half IRQ instruction.
+ *
+ * Direct-threaded form of irq_cmd_t: the dispatch target is resolved
+ * and the operands are pre-decoded when the IRQ code is subscribed, so
+ * that executing the program in the interrupt context is a chain of
+ * computed gotos instead of an interpreter loop.
+ */
+typedef struct {
+	/** Dispatch target inside ipc_irq_top_half_claim(). */
+	const void *target;
+	/** Pre-bound kernel virtual PIO address. */
+	void *addr;
+	/** Immediate value or branch displacement. */
+	uint32_t value;
+	/** Source scratch register index. */
+	uintptr_t srcarg;
+	/** Destination scratch register index. */
+	uintptr_t dstarg;
+} irq_op_t;
+
 /** IPC notification config structure.
  *
  * Primarily, this structure is encapsulated in the irq_t structure.
@@ -70,7 +89,7 @@ typedef void (*cir_t)(void *, inr_t);
 typedef struct {
 	/** When false, notifications are not sent. */
 	bool notify;
-	/** True if the structure is in irq_uspace_hash_table_table */
+	/** True if the structure is in the uspace IRQ dispatch lists */
 	bool hashed_in;
 	/** Answerbox for notifications. */
 	answerbox_t *answerbox;
@@ -80,6 +99,8 @@ typedef struct {
 	uint32_t scratch[IPC_CALL_LEN];
 	/** Top-half IRQ code. */
 	irq_code_t *code;
+	/** Top-half IRQ code translated to direct-threaded form. */
+	irq_op_t *ops;
 	/** Counter. */
 	size_t counter;
 } ipc_notif_cfg_t;
@@ -90,12 +111,12 @@ typedef struct {
  * instantions.
  */
 typedef struct irq {
-	/** Hash table link. */
-	ht_link_t link;
+	/** Dispatch list link. */
+	link_t link;
 
 	/** Lock protecting everything in this structure
 	 *  except the link member. When both the IRQ
-	 *  hash table lock and this lock are to be acquired,
+	 *  dispatch list lock and this lock are to be acquired,
 	 *  this lock must not be taken first.
 	 */
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -126,16 +147,23 @@ typedef struct irq {
 
 	/** Notification configuration structure. */
 	ipc_notif_cfg_t notif_cfg;
+
+	/**
+	 * Backing kernel object for IRQs subscribed from userspace,
+	 * NULL for IRQs registered by the kernel. Referenced by deferred
+	 * notifications to pin the structure until they are delivered.
+	 */
+	kobject_t *kobject;
 } irq_t;
 
-IRQ_SPINLOCK_EXTERN(irq_uspace_hash_table_lock);
-extern hash_table_t irq_uspace_hash_table;
+IRQ_SPINLOCK_EXTERN(irq_uspace_lists_lock);
+extern list_t *irq_uspace_lists;
 
 extern slab_cache_t *irq_cache;
 
 extern inr_t last_inr;
 
-extern void irq_init(size_t, size_t);
+extern void irq_init(size_t);
 extern void irq_initialize(irq_t *);
 extern void irq_register(irq_t *);
 extern irq_t *irq_dispatch_and_lock(inr_t);
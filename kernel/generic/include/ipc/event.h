@@ -36,6 +36,7 @@
 #define KERN_EVENT_H_
 
 #include <abi/ipc/event.h>
+#include <adt/list.h>
 #include <typedefs.h>
 #include <synch/spinlock.h>
 #include <ipc/ipc.h>
@@ -44,9 +45,13 @@ struct task;
 
 typedef void (*event_callback_t)(void *);
 
-/** Event notification structure. */
+/** One subscriber of an event type.
+ *
+ * All members are protected by the lock of the owning event_t.
+ */
 typedef struct {
-	SPINLOCK_DECLARE(lock);
+	/** Link to event_t.subscribers. */
+	link_t link;
 
 	/** Answerbox for notifications. */
 	answerbox_t *answerbox;
@@ -57,6 +62,22 @@ typedef struct {
 
 	/** Masked flag. */
 	bool masked;
+
+	/**
+	 * Last notification queued for this subscriber or NULL. Holds an
+	 * extra kobject reference so that identical notifications can be
+	 * coalesced into it while it still sits in the answerbox.
+	 */
+	call_t *pending;
+} event_sub_t;
+
+/** Event notification structure. */
+typedef struct {
+	SPINLOCK_DECLARE(lock);
+
+	/** List of subscribers (event_sub_t). */
+	list_t subscribers;
+
 	/** Unmask callback. */
 	event_callback_t unmask_callback;
 } event_t;
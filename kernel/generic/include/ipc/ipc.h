@@ -36,6 +36,7 @@
 #define KERN_IPC_H_
 
 #include <synch/spinlock.h>
+#include <adt/mpsc.h>
 #include <synch/mutex.h>
 #include <synch/waitq.h>
 #include <abi/ipc/ipc.h>
@@ -93,12 +94,15 @@ typedef struct answerbox {
 
 	/** Phones connected to this answerbox. */
 	list_t connected_phones;
-	/** Received calls. */
-	list_t calls;
+	/**
+	 * Received calls. Senders push to the queue without taking the
+	 * answerbox lock; the consumer side is serialized by it.
+	 */
+	mpsc_queue_t calls;
 	list_t dispatched_calls;  /* Should be hash table in the future */
 
-	/** Answered calls. */
-	list_t answers;
+	/** Answered calls. Synchronized like the calls queue. */
+	mpsc_queue_t answers;
 
 	IRQ_SPINLOCK_DECLARE(irq_lock);
 
@@ -116,9 +120,12 @@ typedef struct call {
 	 */
 	link_t ta_link;
 
-	/** Answerbox link. */
+	/** Answerbox link for the dispatched calls and notification lists. */
 	link_t ab_link;
 
+	/** Answerbox link for the lock-free calls and answers queues. */
+	mpsc_link_t ab_qlink;
+
 	unsigned int flags;
 
 	/** Protects the forget member. */
@@ -165,6 +172,16 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/**
+	 * Frames lent by the sender for large IPC_M_DATA_WRITE transfers.
+	 * When non-NULL, the payload is read directly from these referenced
+	 * frames instead of an intermediate kernel buffer. lent_offset is
+	 * the offset of the payload within the first frame.
+	 */
+	uintptr_t *lent_frames;
+	size_t lent_count;
+	size_t lent_offset;
 } call_t;
 
 extern slab_cache_t *phone_cache;
@@ -182,7 +199,7 @@ extern errno_t ipc_call(phone_t *, call_t *);
 extern errno_t ipc_wait_for_call(answerbox_t *, uint32_t, unsigned int, call_t **);
 extern errno_t ipc_forward(call_t *, phone_t *, answerbox_t *, unsigned int);
 extern void ipc_answer(answerbox_t *, call_t *);
-extern void _ipc_answer_free_call(call_t *, bool);
+extern void _ipc_answer_free_call(call_t *);
 
 extern void ipc_phone_init(phone_t *, struct task *);
 extern bool ipc_phone_connect(phone_t *, answerbox_t *);
@@ -194,6 +211,7 @@ extern void ipc_cleanup(void);
 extern void ipc_backsend_err(phone_t *, call_t *, errno_t);
 extern void ipc_answerbox_slam_phones(answerbox_t *, bool);
 extern void ipc_cleanup_call_list(answerbox_t *, list_t *);
+extern void ipc_cleanup_call_queue(answerbox_t *, mpsc_queue_t *);
 
 extern void ipc_print_task(task_id_t);
 
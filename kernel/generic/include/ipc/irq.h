@@ -49,6 +49,11 @@
 
 extern kobject_ops_t irq_kobject_ops;
 
+extern void ipc_irq_defer_init(void);
+
+extern errno_t ipc_irq_code_check(irq_cmd_t *, size_t);
+extern irq_op_t *ipc_irq_code_compile(irq_code_t *);
+
 extern irq_ownership_t ipc_irq_top_half_claim(irq_t *);
 extern void ipc_irq_top_half_handler(irq_t *);
 
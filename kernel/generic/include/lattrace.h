@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_LATTRACE_H_
+#define KERN_LATTRACE_H_
+
+#include <abi/sysinfo.h>
+#include <errno.h>
+#include <stdint.h>
+
+/** Kinds of latency-critical sections distinguished by the tracer. */
+#define LATTRACE_IRQ      0  /**< Interrupts disabled */
+#define LATTRACE_PREEMPT  1  /**< Preemption disabled */
+#define LATTRACE_KINDS    2
+
+/** Latency tracer state of one CPU.
+ *
+ * Embedded in cpu_t. Only ever touched by code executing on the
+ * owning CPU, hence no locking: the interrupt-off kind is accessed
+ * with interrupts disabled and the preemption-off kind with
+ * preemption disabled.
+ */
+typedef struct {
+	/** Nesting depth of hooked sections of each kind. */
+	unsigned int depth[LATTRACE_KINDS];
+	/** Cycle counter value at the start of the open outermost section. */
+	uint64_t start[LATTRACE_KINDS];
+	/** Address of the code that opened the outermost section. */
+	uintptr_t pc[LATTRACE_KINDS];
+	/** Longest section of each kind seen since the tracer was started. */
+	lattrace_rec_t max[LATTRACE_KINDS];
+} lattrace_cpu_t;
+
+extern void lattrace_init(void);
+extern errno_t lattrace_start(void);
+extern void lattrace_stop(void);
+extern void lattrace_section_begin(unsigned int, void *);
+extern void lattrace_section_end(unsigned int);
+
+#endif
+
+/** @}
+ */
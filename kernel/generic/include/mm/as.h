@@ -76,6 +76,12 @@
 #define AS_AREA_ATTR_NONE     0
 #define AS_AREA_ATTR_PARTIAL  1  /**< Not fully initialized area. */
 
+/**
+ * Size of the naturally aligned cluster of pages that is populated at once
+ * when a page fault hits an area created with AS_AREA_LARGE.
+ */
+#define AS_AREA_LARGE_SIZE  (1 << 21)
+
 /** The page fault was resolved by as_page_fault(). */
 #define AS_PF_OK     0
 
@@ -115,6 +121,17 @@ typedef struct as {
 	 */
 	asid_t asid;
 
+	/** Set of CPUs on which this address space has ever been active.
+	 *
+	 * Used to target TLB shootdowns at the processors that may
+	 * actually cache translations of this address space. Bits are
+	 * only set (under asidlock, when the address space is being
+	 * installed) and the mask is read without synchronization by
+	 * the shootdown sender. NULL means the set is not tracked and
+	 * shootdowns fall back to broadcasting.
+	 */
+	struct cpu_mask *cpus;
+
 	/** Number of references (i.e. tasks that reference this as). */
 	atomic_refcount_t refcount;
 
@@ -304,6 +321,27 @@ typedef struct mem_backend {
 	void (*destroy_shared_data)(void *);
 } mem_backend_t;
 
+/** Number of entries in the per-CPU cache of fault-hit areas. */
+#define AS_AREA_CACHE_SIZE  4
+
+/** Per-CPU cache entry remembering an area recently hit by a page fault.
+ *
+ * Entries are validated against a global area generation counter
+ * maintained by mm/as.c; stale entries are never dereferenced.
+ */
+typedef struct {
+	/** Address space the cached area belongs to. */
+	as_t *as;
+	/** The cached area. */
+	as_area_t *area;
+	/** Value of the area generation counter when cached. */
+	size_t gen;
+	/** Base address of the area when cached. */
+	uintptr_t base;
+	/** Number of pages in the area when cached. */
+	size_t pages;
+} as_area_cache_t;
+
 extern as_t *AS_KERNEL;
 
 extern as_operations_t *as_operations;
@@ -321,6 +359,7 @@ extern as_area_t *as_area_create(as_t *, unsigned int, size_t, unsigned int,
     mem_backend_t *, mem_backend_data_t *, uintptr_t *, uintptr_t);
 extern errno_t as_area_destroy(as_t *, uintptr_t);
 extern errno_t as_area_resize(as_t *, uintptr_t, size_t, unsigned int);
+extern errno_t as_area_decommit(as_t *, uintptr_t, size_t);
 extern errno_t as_area_share(as_t *, uintptr_t, size_t, as_t *, unsigned int,
     uintptr_t *, uintptr_t);
 extern errno_t as_area_change_flags(as_t *, unsigned int, uintptr_t);
@@ -368,6 +407,8 @@ extern void as_deinstall_arch(as_t *);
 /* Backend declarations and functions. */
 extern mem_backend_t anon_backend;
 extern mem_backend_t elf_backend;
+
+extern void elf_cache_init(void);
 extern mem_backend_t phys_backend;
 extern mem_backend_t user_backend;
 
@@ -375,6 +416,7 @@ extern mem_backend_t user_backend;
 extern sysarg_t sys_as_area_create(uintptr_t, size_t, unsigned int, uintptr_t,
     uspace_ptr_as_area_pager_info_t);
 extern sys_errno_t sys_as_area_resize(uintptr_t, size_t, unsigned int);
+extern sys_errno_t sys_as_area_decommit(uintptr_t, size_t);
 extern sys_errno_t sys_as_area_change_flags(uintptr_t, unsigned int);
 extern sys_errno_t sys_as_area_get_info(uintptr_t, uspace_ptr_as_area_info_t);
 extern sys_errno_t sys_as_area_destroy(uintptr_t);
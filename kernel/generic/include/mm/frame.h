@@ -47,6 +47,9 @@
 /** Maximum number of zones in the system. */
 #define ZONES_MAX  32
 
+/** Number of frames in the per-CPU free frame cache. */
+#define FRAME_CACHE_SIZE  8
+
 typedef uint8_t frame_flags_t;
 
 #define FRAME_NONE        0x00
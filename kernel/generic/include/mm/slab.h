@@ -41,7 +41,7 @@
 #include <mm/frame.h>
 
 /** Initial Magazine size (TODO: dynamically growing magazines) */
-#define SLAB_MAG_SIZE  4
+#define SLAB_MAG_SIZE  8
 
 /** If object size is less, store control structure inside SLAB */
 #define SLAB_INSIDE_SIZE  (PAGE_SIZE >> 3)
@@ -74,6 +74,12 @@ typedef struct {
 typedef struct {
 	slab_magazine_t *current;
 	slab_magazine_t *last;
+	/** Spare full magazine kept aside for refills.
+	 *
+	 * Serves as a CPU-local depot of depth one so that the common
+	 * refill/flush cycle does not have to take the cache-wide maglock.
+	 */
+	slab_magazine_t *spare_full;
 	IRQ_SPINLOCK_DECLARE(lock);
 } slab_mag_cache_t;
 
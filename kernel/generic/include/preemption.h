@@ -38,22 +38,30 @@
 #include <arch.h>
 #include <assert.h>
 #include <barrier.h>
+#include <lattrace.h>
 
 #define PREEMPTION_INC         (1 << 0)
 #define PREEMPTION_DISABLED    (PREEMPTION_INC <= CURRENT->preemption)
 #define PREEMPTION_ENABLED     (!PREEMPTION_DISABLED)
 
-/** Increment preemption disabled counter. */
+/** Increment preemption disabled counter.
+ *
+ * The latency tracer hook runs after the counter is incremented,
+ * so the hook itself cannot be preempted away from the current CPU.
+ */
 #define preemption_disable() \
 	do { \
 		CURRENT->preemption += PREEMPTION_INC; \
 		compiler_barrier(); \
+		lattrace_section_begin(LATTRACE_PREEMPT, \
+		    __builtin_return_address(0)); \
 	} while (0)
 
 /** Restores preemption but never reschedules. */
 #define preemption_enable() \
 	do { \
 		assert(PREEMPTION_DISABLED); \
+		lattrace_section_end(LATTRACE_PREEMPT); \
 		compiler_barrier(); \
 		CURRENT->preemption -= PREEMPTION_INC; \
 	} while (0)
@@ -44,6 +44,13 @@
 #define RQ_COUNT          16
 #define NEEDS_RELINK_MAX  (HZ)
 
+/**
+ * Maximum admitted utilization of deadline-class threads on one CPU,
+ * in per mille. The remainder is left to the normal class so that
+ * deadline threads cannot starve the rest of the system completely.
+ */
+#define DEADLINE_LOAD_MAX  950
+
 /** Scheduler run queue structure. */
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -42,7 +42,7 @@
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
 #include <adt/list.h>
-#include <adt/odict.h>
+#include <adt/obtree.h>
 #include <security/perm.h>
 #include <arch/proc/task.h>
 #include <arch/proc/thread.h>
@@ -66,7 +66,7 @@ struct cap;
 /** Task structure. */
 typedef struct task {
 	/** Link to @c tasks ordered dictionary */
-	odlink_t ltasks;
+	obt_link_t ltasks;
 
 	/** Task lock.
 	 *
@@ -134,7 +134,7 @@ typedef struct task {
 /** Synchronize access to @c tasks */
 IRQ_SPINLOCK_EXTERN(tasks_lock);
 /** Ordered dictionary of all tasks by ID (of task_t structures) */
-extern odict_t tasks;
+extern obtree_t tasks;
 
 extern void task_init(void);
 extern void task_done(void);
@@ -67,6 +67,18 @@ typedef enum {
 	THREAD_FLAG_UNCOUNTED = (1 << 2)
 } thread_flags_t;
 
+/** Thread scheduling classes. */
+typedef enum {
+	/** Default class scheduled via the priority run queues. */
+	SCHED_CLASS_NORMAL = 0,
+	/**
+	 * Earliest-deadline-first class for latency-critical threads.
+	 * Threads of this class are always served before the normal
+	 * class and are subject to admission control.
+	 */
+	SCHED_CLASS_DEADLINE
+} sched_class_t;
+
 /** Thread structure. There is one per thread. */
 typedef struct thread {
 	link_t rq_link;  /**< Run queue link. */
@@ -159,6 +171,13 @@ typedef struct thread {
 	 */
 	bool fpu_context_engaged;
 
+	/**
+	 * Heuristic measure of recent FPU activity. Raised whenever the
+	 * thread takes a lazy FPU trap, decayed whenever its context is
+	 * restored eagerly on context switch.
+	 */
+	unsigned int fpu_counter;
+
 	/* The thread will not be migrated if nomigrate is non-zero. */
 	unsigned int nomigrate;
 
@@ -189,6 +208,16 @@ typedef struct thread {
 
 	/** Thread's priority. Implemented as index to CPU->rq */
 	int priority;
+
+	/** Scheduling class of the thread. */
+	sched_class_t sched_class;
+	/** Activation period and relative deadline in microseconds. */
+	uint32_t deadline_period;
+	/** Execution budget per period in microseconds. */
+	uint32_t deadline_budget;
+	/** Absolute deadline of the current activation in microseconds. */
+	uint64_t deadline;
+
 	/** Thread ID. */
 	thread_id_t tid;
 
@@ -270,6 +299,7 @@ extern sys_errno_t sys_thread_exit(int);
 extern sys_errno_t sys_thread_get_id(uspace_ptr_thread_id_t);
 extern sys_errno_t sys_thread_usleep(uint32_t);
 extern sys_errno_t sys_thread_udelay(uint32_t);
+extern sys_errno_t sys_thread_set_deadline(uint32_t, uint32_t);
 
 #endif
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2012 Adam Hraska
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_RCU_H_
+#define KERN_RCU_H_
+
+#include <adt/list.h>
+#include <barrier.h>
+#include <preemption.h>
+
+/** Begin an RCU read-side critical section.
+ *
+ * RCU read-side critical sections must not block or sleep. They may be
+ * nested and may be entered from interrupt handlers.
+ */
+#define rcu_read_lock()    preemption_disable()
+
+/** End an RCU read-side critical section. */
+#define rcu_read_unlock()  preemption_enable()
+
+/** Append an item to an RCU-protected list.
+ *
+ * May only be called by the list's writer, typically with the writer
+ * lock held. The item is linked in only after its list pointers are
+ * initialized, so a concurrent reader traversing the list either
+ * misses the item or sees it whole.
+ *
+ * @param link Item to be appended.
+ * @param list List to append the item to.
+ */
+static inline void rcu_list_append(link_t *link, list_t *list)
+{
+	link->next = &list->head;
+	link->prev = list->head.prev;
+
+	/* Publish only the fully initialized item. */
+	write_barrier();
+
+	list->head.prev->next = link;
+	list->head.prev = link;
+}
+
+/** Remove an item from an RCU-protected list.
+ *
+ * May only be called by the list's writer. Unlike list_remove(), the
+ * unlinked item keeps its forward pointer, so that a reader standing
+ * on it can still reach the rest of the list. The item must not be
+ * freed, reinitialized or reinserted before a grace period elapses.
+ *
+ * @param link Item to be removed.
+ */
+static inline void rcu_list_remove(link_t *link)
+{
+	link->next->prev = link->prev;
+	link->prev->next = link->next;
+}
+
+extern void rcu_quiescent_point(void);
+extern void synchronize_rcu(void);
+
+#endif
+
+/** @}
+ */
@@ -43,8 +43,18 @@
 
 #ifdef CONFIG_SMP
 
+/*
+ * Spinlocks are implemented as ticket locks. Every contender draws a
+ * ticket and spins until the owner counter reaches it, so the lock is
+ * granted in FIFO order and a lock hand-over invalidates the shared
+ * cache line only once, instead of all waiters racing to test-and-set
+ * a single flag.
+ */
 typedef struct spinlock {
-	atomic_flag flag;
+	/** Ticket drawn by the next contender. */
+	atomic_ushort next_ticket;
+	/** Ticket currently owning the lock. */
+	atomic_ushort owner_ticket;
 
 #ifdef CONFIG_DEBUG_SPINLOCK
 	const char *name;
@@ -68,13 +78,15 @@ typedef struct spinlock {
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
 		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
+		.next_ticket = 0, \
+		.owner_ticket = 0 \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
 		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
+		.next_ticket = 0, \
+		.owner_ticket = 0 \
 	}
 
 #define ASSERT_SPINLOCK(expr, lock) \
@@ -87,12 +99,14 @@ typedef struct spinlock {
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
+		.next_ticket = 0, \
+		.owner_ticket = 0 \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
+		.next_ticket = 0, \
+		.owner_ticket = 0 \
 	}
 
 #define ASSERT_SPINLOCK(expr, lock) \
@@ -105,8 +119,10 @@ typedef struct spinlock {
 _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
 {
 	preemption_disable();
-	while (atomic_flag_test_and_set_explicit(&lock->flag,
-	    memory_order_acquire))
+	unsigned short ticket = atomic_fetch_add_explicit(&lock->next_ticket,
+	    1, memory_order_relaxed);
+	while (atomic_load_explicit(&lock->owner_ticket,
+	    memory_order_acquire) != ticket)
 		;
 }
 
@@ -116,7 +132,10 @@ _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
  */
 _NO_TRACE static inline void spinlock_unlock(spinlock_t *lock)
 {
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+	/* Only the lock owner ever stores to owner_ticket. */
+	atomic_store_explicit(&lock->owner_ticket,
+	    atomic_load_explicit(&lock->owner_ticket,
+	    memory_order_relaxed) + 1, memory_order_release);
 	preemption_enable();
 }
 
@@ -214,7 +233,8 @@ typedef struct {
 	irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
+			.next_ticket = 0, \
+			.owner_ticket = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -224,7 +244,8 @@ typedef struct {
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
+			.next_ticket = 0, \
+			.owner_ticket = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -235,7 +256,8 @@ typedef struct {
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
 		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
+			.next_ticket = 0, \
+			.owner_ticket = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -244,7 +266,8 @@ typedef struct {
 #define IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
+			.next_ticket = 0, \
+			.owner_ticket = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
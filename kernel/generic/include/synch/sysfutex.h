@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2006 Jakub Jermar
+ * Copyright (c) 2018 Jakub Jermar
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -26,44 +26,23 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-/** @addtogroup kernel_genarch_mm
+/** @addtogroup kernel_sync
  * @{
  */
-/**
- * @file
- * @brief This is the generic page hash table interface.
+/** @file
  */
 
-#ifdef CONFIG_PAGE_HT
-
-#ifndef KERN_PAGE_HT_H_
-#define KERN_PAGE_HT_H_
+#ifndef KERN_SYS_FUTEX_H_
+#define KERN_SYS_FUTEX_H_
 
 #include <typedefs.h>
-#include <mm/as.h>
-#include <mm/page.h>
-#include <mm/slab.h>
-#include <adt/hash_table.h>
-
-#define KEY_AS        0
-#define KEY_PAGE      1
 
-/* Macros for querying page hash table PTEs. */
-#define PTE_VALID(pte)       ((void *) (pte) != NULL)
-#define PTE_PRESENT(pte)     ((pte)->p != 0)
-#define PTE_GET_FRAME(pte)   ((pte)->frame)
-#define PTE_READABLE(pte)    1
-#define PTE_WRITABLE(pte)    ((pte)->w != 0)
-#define PTE_EXECUTABLE(pte)  ((pte)->x != 0)
+extern void sys_futex_init(void);
 
-extern as_operations_t as_ht_operations;
-extern page_mapping_operations_t ht_mapping_operations;
+extern void sys_futex_task_cleanup(void);
 
-extern slab_cache_t *pte_cache;
-extern hash_table_t page_ht;
-extern hash_table_ops_t ht_ops;
-
-#endif
+extern sys_errno_t sys_futex_sleep(uspace_addr_t, uint32_t, unsigned int);
+extern sys_errno_t sys_futex_wakeup(uspace_addr_t);
 
 #endif
 
@@ -37,6 +37,7 @@
 
 extern void kload(void *arg);
 extern void stats_init(void);
+extern void stats_update_cpu(void);
 
 #endif
 
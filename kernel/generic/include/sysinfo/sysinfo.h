@@ -159,6 +159,7 @@ extern void sysinfo_set_subtree_fn(const char *, sysinfo_item_t **,
     sysinfo_fn_subtree_t, void *);
 
 extern void sysinfo_init(void);
+extern void sysinfo_export_init(void);
 extern void sysinfo_dump(sysinfo_item_t *);
 
 extern sys_errno_t sys_sysinfo_get_keys_size(uspace_addr_t, size_t, uspace_addr_t);
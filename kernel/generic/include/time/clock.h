@@ -35,21 +35,49 @@
 #ifndef KERN_CLOCK_H_
 #define KERN_CLOCK_H_
 
+#include <abi/sysinfo.h>
 #include <typedefs.h>
 
 #define HZ  100
 
-/** Uptime structure */
-typedef struct {
-	sysarg_t seconds1;
-	sysarg_t useconds;
-	sysarg_t seconds2;
-} uptime_t;
+/** Uptime structure
+ *
+ * The uptime lives at the start of the clock page, which also carries
+ * the sysinfo scalars exported to userspace (see sysinfo_export_val()).
+ */
+typedef clock_page_t uptime_t;
 
 extern uptime_t *uptime;
 
+/** Architecture hooks for stopping the periodic tick on idle CPUs.
+ *
+ * An architecture whose clock device supports one-shot operation
+ * registers these with clock_dynticks_enable(); the scheduler then
+ * stops the tick whenever a CPU goes idle. All hooks are invoked with
+ * interrupts disabled on the CPU they act upon.
+ */
+typedef struct {
+	/**
+	 * Stop the periodic tick and program a one-shot clock event
+	 * no later than the given number of ticks ahead.
+	 */
+	void (*stop_tick)(uint64_t ticks);
+	/** Restore the periodic tick. */
+	void (*restart_tick)(void);
+	/**
+	 * Return the number of whole ticks elapsed since the matching
+	 * stop_tick() call, measured on the architecture's reference
+	 * counter.
+	 */
+	uint64_t (*idle_ticks)(void);
+} clock_dynticks_ops_t;
+
 extern void clock(void);
 extern void clock_counter_init(void);
+extern uint64_t uptime_useconds(void);
+extern void clock_dynticks_enable(clock_dynticks_ops_t *);
+extern void clock_idle_enter(void);
+extern void clock_idle_exit(void);
 
 #endif
 
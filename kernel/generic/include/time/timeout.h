@@ -36,24 +36,59 @@
 #define KERN_TIMEOUT_H_
 
 #include <adt/list.h>
-#include <cpu.h>
+#include <synch/spinlock.h>
 #include <stdint.h>
 
 typedef void (*timeout_handler_t)(void *arg);
 
+/** Number of levels of the timeout wheel hierarchy. */
+#define TIMEOUT_WHEEL_LEVELS  4
+
+/** Number of expiration tick bits consumed by each wheel level. */
+#define TIMEOUT_WHEEL_BITS  6
+
+/** Number of slots in each wheel level. */
+#define TIMEOUT_WHEEL_SLOTS  (1 << TIMEOUT_WHEEL_BITS)
+#define TIMEOUT_WHEEL_MASK   (TIMEOUT_WHEEL_SLOTS - 1)
+
+/** Smallest tick delta which does not fit into the wheel. */
+#define TIMEOUT_WHEEL_HORIZON \
+	(UINT64_C(1) << (TIMEOUT_WHEEL_LEVELS * TIMEOUT_WHEEL_BITS))
+
+/** Hierarchical timer wheel keyed by clock() ticks.
+ *
+ * Timeouts due in less than TIMEOUT_WHEEL_SLOTS ticks hash into level
+ * zero by their expiration tick, timeouts further away into higher
+ * levels by progressively coarser portions of the expiration tick.
+ * Whenever a level wraps around, the matching slot of the next level
+ * is redistributed into the lower levels, so every slot of level zero
+ * holds only timeouts expiring at a single tick.
+ *
+ * The structure is encapsulated in cpu_t and is protected by
+ * cpu_t::timeoutlock.
+ */
+typedef struct {
+	/** Number of clock() ticks elapsed on this CPU. */
+	uint64_t current_tick;
+	/** Wheel slots with timeouts hashed by their expiration tick. */
+	list_t slots[TIMEOUT_WHEEL_LEVELS][TIMEOUT_WHEEL_SLOTS];
+	/** Timeouts expiring beyond the wheel horizon. */
+	list_t overflow;
+} timeout_wheel_t;
+
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
 
-	/** Link to the list of active timeouts on CURRENT->cpu */
+	/** Link to a slot of the timeout wheel on CURRENT->cpu */
 	link_t link;
-	/** Timeout will be activated in this amount of clock() ticks. */
-	uint64_t ticks;
+	/** Timeout will be activated when the CPU's wheel reaches this tick. */
+	uint64_t deadline;
 	/** Function that will be called on timeout activation. */
 	timeout_handler_t handler;
 	/** Argument to be passed to handler() function. */
 	void *arg;
 	/** On which processor is this timeout registered. */
-	cpu_t *cpu;
+	struct cpu *cpu;
 } timeout_t;
 
 #define us2ticks(us)  ((uint64_t) (((uint32_t) (us) / (1000000 / HZ))))
@@ -63,6 +98,8 @@ extern void timeout_initialize(timeout_t *);
 extern void timeout_reinitialize(timeout_t *);
 extern void timeout_register(timeout_t *, uint64_t, timeout_handler_t, void *);
 extern bool timeout_unregister(timeout_t *);
+extern void timeout_clock_tick(void);
+extern uint64_t timeout_next_tick_delta(void);
 
 #endif
 
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_TYPES_OBTREE_H_
+#define _LIBC_TYPES_OBTREE_H_
+
+#include <adt/list.h>
+#include <stddef.h>
+
+/** Maximum number of entries in a B-tree node */
+#define OBTREE_MAX_ENTRIES  7
+/** Minimum number of entries in a non-root B-tree node */
+#define OBTREE_MIN_ENTRIES  3
+
+typedef struct obtree_node obtree_node_t;
+typedef struct obt_link obt_link_t;
+typedef struct obtree obtree_t;
+
+typedef void *(*obt_getkey_t)(obt_link_t *);
+typedef int (*obt_cmp_t)(void *, void *);
+
+/** B-tree node.
+ *
+ * Unlike an odict node, which is embedded in the entry itself,
+ * a B-tree node indexes multiple entries from a contiguous array,
+ * so a lookup touches one cache-friendly node per tree level
+ * instead of one entry per comparison.
+ */
+struct obtree_node {
+	/** Parent node or @c NULL for the root */
+	obtree_node_t *parent;
+	/** Number of entries in the node */
+	size_t nentries;
+	/** The indexed entries in ascending key order */
+	obt_link_t *entry[OBTREE_MAX_ENTRIES];
+	/** Child nodes (all @c NULL in a leaf) */
+	obtree_node_t *child[OBTREE_MAX_ENTRIES + 1];
+};
+
+/** Ordered B-tree dictionary link */
+struct obt_link {
+	/** Containing dictionary */
+	obtree_t *obtree;
+	/** Node indexing this entry */
+	obtree_node_t *node;
+	/** Link to obtree->entries */
+	link_t lentries;
+};
+
+/** Ordered B-tree dictionary */
+struct obtree {
+	/** Root node of the tree (@c NULL if the tree is empty) */
+	obtree_node_t *root;
+	/** List of entries in ascending order */
+	list_t entries;
+	/** Get key operation */
+	obt_getkey_t getkey;
+	/** Compare operation */
+	obt_cmp_t cmp;
+};
+
+#endif
+
+/** @}
+ */
@@ -55,6 +55,9 @@ errno_t udebug_args_read(thread_t *t, void **buffer);
 errno_t udebug_regs_read(thread_t *t, void **buffer);
 
 errno_t udebug_mem_read(uspace_addr_t uspace_addr, size_t n, void **buffer);
+errno_t udebug_mem_readv(const udebug_mem_span_t *spans, size_t cnt,
+    void **buffer, size_t *size);
+errno_t udebug_mem_write(uspace_addr_t uspace_addr, const void *data, size_t n);
 
 #endif
 
@@ -37,6 +37,14 @@
 /*
  * This is an implementation of a generic resizable chained hash table.
  *
+ * Resizing is incremental: when the load factor calls for it, a new
+ * bucket array is allocated and items are migrated to it a few buckets
+ * at a time by subsequent mutating operations, so no single insert or
+ * remove ever rehashes the whole table. Lookups check the not yet
+ * migrated part of the old bucket array as well. Inserting or removing
+ * a key first migrates the old bucket that the key maps to, which
+ * keeps all items with equal keys in the same bucket list.
+ *
  * The table grows to 2*n+1 buckets each time, starting at n == 89,
  * per Thomas Wang's recommendation:
  * http://www.concentric.net/~Ttwang/tech/hashsize.htm
@@ -58,6 +66,8 @@
 #define HT_MIN_BUCKETS  89
 /* The table is resized when the average load per bucket exceeds this number. */
 #define HT_MAX_LOAD     2
+/* Number of old buckets migrated to the new table per mutating operation. */
+#define HT_MIGRATE_STEP 4
 
 static size_t round_up_size(size_t);
 static bool alloc_table(size_t, list_t **);
@@ -65,6 +75,10 @@ static void clear_items(hash_table_t *);
 static void resize(hash_table_t *, size_t);
 static void grow_if_needed(hash_table_t *);
 static void shrink_if_needed(hash_table_t *);
+static void migrate_bucket(hash_table_t *, size_t);
+static void migrate_step(hash_table_t *);
+static void migrate_key(hash_table_t *, size_t);
+static void migrate_all(hash_table_t *);
 
 /* Dummy do nothing callback to invoke in place of remove_callback == NULL. */
 static void nop_remove_callback(ht_link_t *item)
@@ -105,6 +119,9 @@ bool hash_table_create(hash_table_t *h, size_t init_size, size_t max_load,
 
 	h->max_load = (max_load == 0) ? HT_MAX_LOAD : max_load;
 	h->item_cnt = 0;
+	h->old_bucket = NULL;
+	h->old_bucket_cnt = 0;
+	h->migrate_idx = 0;
 	h->op = op;
 	h->full_item_cnt = h->max_load * h->bucket_cnt;
 	h->apply_ongoing = false;
@@ -128,6 +145,12 @@ void hash_table_destroy(hash_table_t *h)
 
 	clear_items(h);
 
+	if (h->old_bucket) {
+		free(h->old_bucket);
+		h->old_bucket = NULL;
+		h->old_bucket_cnt = 0;
+	}
+
 	free(h->bucket);
 
 	h->bucket = NULL;
@@ -181,6 +204,16 @@ static void clear_items(hash_table_t *h)
 		}
 	}
 
+	for (size_t idx = h->migrate_idx; idx < h->old_bucket_cnt; ++idx) {
+		list_foreach_safe(h->old_bucket[idx], cur, next) {
+			assert(cur);
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+			list_remove(cur);
+			h->op->remove_callback(cur_link);
+		}
+	}
+
 	h->item_cnt = 0;
 }
 
@@ -195,7 +228,11 @@ void hash_table_insert(hash_table_t *h, ht_link_t *item)
 	assert(h && h->bucket);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	size_t hash = h->op->hash(item);
+	migrate_key(h, hash);
+	migrate_step(h);
+
+	size_t idx = hash % h->bucket_cnt;
 
 	list_append(&item->link, &h->bucket[idx]);
 	++h->item_cnt;
@@ -217,7 +254,11 @@ bool hash_table_insert_unique(hash_table_t *h, ht_link_t *item)
 	assert(h->op && h->op->hash && h->op->equal);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	size_t hash = h->op->hash(item);
+	migrate_key(h, hash);
+	migrate_step(h);
+
+	size_t idx = hash % h->bucket_cnt;
 
 	/* Check for duplicates. */
 	list_foreach(h->bucket[idx], link, ht_link_t, cur_link) {
@@ -248,7 +289,8 @@ ht_link_t *hash_table_find(const hash_table_t *h, const void *key)
 {
 	assert(h && h->bucket);
 
-	size_t idx = h->op->key_hash(key) % h->bucket_cnt;
+	size_t hash = h->op->key_hash(key);
+	size_t idx = hash % h->bucket_cnt;
 
 	list_foreach(h->bucket[idx], link, ht_link_t, cur_link) {
 		/*
@@ -261,6 +303,18 @@ ht_link_t *hash_table_find(const hash_table_t *h, const void *key)
 		}
 	}
 
+	/* The item may not have been migrated from the old buckets yet. */
+	if (h->old_bucket) {
+		size_t old_idx = hash % h->old_bucket_cnt;
+
+		list_foreach(h->old_bucket[old_idx], link, ht_link_t,
+		    cur_link) {
+			if (h->op->key_equal(key, cur_link)) {
+				return cur_link;
+			}
+		}
+	}
+
 	return NULL;
 }
 
@@ -271,7 +325,8 @@ hash_table_find_next(const hash_table_t *h, ht_link_t *first, ht_link_t *item)
 	assert(item);
 	assert(h && h->bucket);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	size_t hash = h->op->hash(item);
+	size_t idx = hash % h->bucket_cnt;
 
 	/* Traverse the circular list until we reach the starting item again. */
 	for (link_t *cur = item->link.next; cur != &first->link;
@@ -281,6 +336,10 @@ hash_table_find_next(const hash_table_t *h, ht_link_t *first, ht_link_t *item)
 		if (cur == &h->bucket[idx].head)
 			continue;
 
+		if ((h->old_bucket) &&
+		    (cur == &h->old_bucket[hash % h->old_bucket_cnt].head))
+			continue;
+
 		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
 		/*
 		 * Is this is the item we are looking for? We could have first
@@ -310,7 +369,11 @@ size_t hash_table_remove(hash_table_t *h, const void *key)
 	assert(h && h->bucket);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->key_hash(key) % h->bucket_cnt;
+	size_t hash = h->op->key_hash(key);
+	migrate_key(h, hash);
+	migrate_step(h);
+
+	size_t idx = hash % h->bucket_cnt;
 
 	size_t removed = 0;
 
@@ -340,6 +403,7 @@ void hash_table_remove_item(hash_table_t *h, ht_link_t *item)
 	list_remove(&item->link);
 	--h->item_cnt;
 	h->op->remove_callback(item);
+	migrate_step(h);
 	shrink_if_needed(h);
 }
 
@@ -373,6 +437,15 @@ void hash_table_apply(hash_table_t *h, bool (*f)(ht_link_t *, void *), void *arg
 				goto out;
 		}
 	}
+
+	for (size_t idx = h->migrate_idx; idx < h->old_bucket_cnt; ++idx) {
+		list_foreach_safe(h->old_bucket[idx], cur, next) {
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+			if (!f(cur_link, arg))
+				goto out;
+		}
+	}
 out:
 	h->apply_ongoing = false;
 
@@ -411,6 +484,10 @@ static bool alloc_table(size_t bucket_cnt, list_t **pbuckets)
 /** Shrinks the table if the table is only sparely populated. */
 static inline void shrink_if_needed(hash_table_t *h)
 {
+	/* Do not start a new resize before the previous one completes. */
+	if (h->old_bucket)
+		return;
+
 	if (h->item_cnt <= h->full_item_cnt / 4 && HT_MIN_BUCKETS < h->bucket_cnt) {
 		/*
 		 * Keep the bucket_cnt odd (possibly also prime).
@@ -424,6 +501,10 @@ static inline void shrink_if_needed(hash_table_t *h)
 /** Grows the table if table load exceeds the maximum allowed. */
 static inline void grow_if_needed(hash_table_t *h)
 {
+	/* Do not start a new resize before the previous one completes. */
+	if (h->old_bucket)
+		return;
+
 	/* Grow the table if the average bucket load exceeds the maximum. */
 	if (h->full_item_cnt < h->item_cnt) {
 		/* Keep the bucket_cnt odd (possibly also prime). */
@@ -432,7 +513,76 @@ static inline void grow_if_needed(hash_table_t *h)
 	}
 }
 
-/** Allocates and rehashes items to a new table. Frees the old table. */
+/** Rehashes the items of one old bucket to the current table. */
+static void migrate_bucket(hash_table_t *h, size_t old_idx)
+{
+	assert(h->old_bucket && old_idx < h->old_bucket_cnt);
+
+	list_foreach_safe(h->old_bucket[old_idx], cur, next) {
+		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+		size_t new_idx = h->op->hash(cur_link) % h->bucket_cnt;
+		list_remove(cur);
+		list_append(cur, &h->bucket[new_idx]);
+	}
+}
+
+/** Migrates a bounded number of old buckets to the current table.
+ *
+ * Invoked by the mutating operations so that an ongoing resize is
+ * guaranteed to make progress and complete after a bounded number
+ * of operations.
+ */
+static void migrate_step(hash_table_t *h)
+{
+	if (!h->old_bucket || h->apply_ongoing)
+		return;
+
+	size_t steps = HT_MIGRATE_STEP;
+	while (0 < steps-- && h->migrate_idx < h->old_bucket_cnt)
+		migrate_bucket(h, h->migrate_idx++);
+
+	if (h->migrate_idx == h->old_bucket_cnt) {
+		free(h->old_bucket);
+		h->old_bucket = NULL;
+		h->old_bucket_cnt = 0;
+		h->migrate_idx = 0;
+	}
+}
+
+/** Migrates the old bucket the given hash maps to.
+ *
+ * Keeps the invariant that items with equal keys all reside in the same
+ * bucket list: before a key is inserted or removed, any not yet
+ * migrated items of that key are moved to the current table.
+ */
+static void migrate_key(hash_table_t *h, size_t hash)
+{
+	if (!h->old_bucket || h->apply_ongoing)
+		return;
+
+	size_t old_idx = hash % h->old_bucket_cnt;
+
+	if (h->migrate_idx <= old_idx)
+		migrate_bucket(h, old_idx);
+}
+
+/** Completes an ongoing incremental resize, if any. */
+static void migrate_all(hash_table_t *h)
+{
+	if (!h->old_bucket)
+		return;
+
+	while (h->migrate_idx < h->old_bucket_cnt)
+		migrate_bucket(h, h->migrate_idx++);
+
+	free(h->old_bucket);
+	h->old_bucket = NULL;
+	h->old_bucket_cnt = 0;
+	h->migrate_idx = 0;
+}
+
+/** Allocates a new table and starts migrating items to it incrementally. */
 static void resize(hash_table_t *h, size_t new_bucket_cnt)
 {
 	assert(h && h->bucket);
@@ -442,29 +592,24 @@ static void resize(hash_table_t *h, size_t new_bucket_cnt)
 	if (h->apply_ongoing)
 		return;
 
+	/* Finish the previous resize before starting another one. */
+	migrate_all(h);
+
 	list_t *new_buckets;
 
 	/* Leave the table as is if we cannot resize. */
 	if (!alloc_table(new_bucket_cnt, &new_buckets))
 		return;
 
-	if (0 < h->item_cnt) {
-		/* Rehash all the items to the new table. */
-		for (size_t old_idx = 0; old_idx < h->bucket_cnt; ++old_idx) {
-			list_foreach_safe(h->bucket[old_idx], cur, next) {
-				ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
-
-				size_t new_idx = h->op->hash(cur_link) % new_bucket_cnt;
-				list_remove(cur);
-				list_append(cur, &new_buckets[new_idx]);
-			}
-		}
-	}
+	h->old_bucket = h->bucket;
+	h->old_bucket_cnt = h->bucket_cnt;
+	h->migrate_idx = 0;
 
-	free(h->bucket);
 	h->bucket = new_buckets;
 	h->bucket_cnt = new_bucket_cnt;
 	h->full_item_cnt = h->max_load * h->bucket_cnt;
+
+	migrate_step(h);
 }
 
 /** @}
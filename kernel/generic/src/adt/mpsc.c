@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2018 CZ.NIC, z.s.p.o.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Lock-free multi-producer single-consumer intrusive queue.
+ *
+ * Kernel counterpart of the heap-allocating channel in
+ * uspace/lib/c/generic/thread/mpsc.c, reworked into an intrusive queue
+ * so that no allocation happens on the push path.
+ *
+ * A producer publishes an item in two steps: it first swings the tail
+ * pointer to the new item and only then links the item into the chain of
+ * its predecessor. To keep the window between the two steps bounded, the
+ * push is performed with interrupts disabled; the consumer can therefore
+ * spin on a torn chain without risking a deadlock on uniprocessor
+ * configurations.
+ */
+
+#include <adt/mpsc.h>
+#include <arch/asm.h>
+#include <stddef.h>
+
+/** Initialize a queue.
+ *
+ * @param queue Queue to be initialized.
+ *
+ */
+void mpsc_queue_initialize(mpsc_queue_t *queue)
+{
+	atomic_store_explicit(&queue->stub.next, NULL, memory_order_relaxed);
+	atomic_store_explicit(&queue->tail, &queue->stub,
+	    memory_order_relaxed);
+	queue->head = &queue->stub;
+}
+
+/** Append an item to the queue.
+ *
+ * May be called by any number of producers concurrently, without any
+ * external synchronization.
+ *
+ * @param queue Queue to append the item to.
+ * @param link  Queue link of the item.
+ *
+ */
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_link_t *link)
+{
+	atomic_store_explicit(&link->next, NULL, memory_order_relaxed);
+
+	ipl_t ipl = interrupts_disable();
+
+	mpsc_link_t *prev = atomic_exchange_explicit(&queue->tail, link,
+	    memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, link, memory_order_release);
+
+	interrupts_restore(ipl);
+}
+
+/** Wait until a partially published item becomes visible.
+ *
+ * @param link Item whose successor is being published.
+ *
+ * @return The successor of @a link.
+ *
+ */
+static mpsc_link_t *_mpsc_queue_chase(mpsc_link_t *link)
+{
+	mpsc_link_t *next;
+
+	do {
+		next = atomic_load_explicit(&link->next,
+		    memory_order_acquire);
+	} while (next == NULL);
+
+	return next;
+}
+
+/** Remove the oldest item from the queue.
+ *
+ * May only be called by a single consumer at a time.
+ *
+ * @param queue Queue to remove the item from.
+ *
+ * @return Queue link of the removed item or NULL if the queue is empty.
+ *
+ */
+mpsc_link_t *mpsc_queue_pop(mpsc_queue_t *queue)
+{
+	mpsc_link_t *head = queue->head;
+	mpsc_link_t *next = atomic_load_explicit(&head->next,
+	    memory_order_acquire);
+
+	if (head == &queue->stub) {
+		if (next == NULL) {
+			if (atomic_load_explicit(&queue->tail,
+			    memory_order_acquire) == &queue->stub)
+				return NULL;
+
+			/*
+			 * A producer has already swung the tail but has not
+			 * linked its item yet.
+			 */
+			next = _mpsc_queue_chase(head);
+		}
+
+		/* Skip the stub. */
+		queue->head = next;
+		head = next;
+		next = atomic_load_explicit(&head->next,
+		    memory_order_acquire);
+	}
+
+	if (next == NULL) {
+		if (atomic_load_explicit(&queue->tail,
+		    memory_order_acquire) == head) {
+			/*
+			 * The queue contains a single item. Reinsert the stub
+			 * so that the item's successor link gets populated and
+			 * the item can be unlinked.
+			 */
+			mpsc_queue_push(queue, &queue->stub);
+		}
+
+		next = _mpsc_queue_chase(head);
+	}
+
+	queue->head = next;
+	return head;
+}
+
+/** Return the oldest item in the queue without removing it.
+ *
+ * May only be called when the consumer side is quiescent. Items pushed
+ * concurrently with the iteration may or may not be observed.
+ *
+ * @param queue Queue to examine.
+ *
+ * @return Queue link of the oldest item or NULL if the queue is empty.
+ *
+ */
+mpsc_link_t *mpsc_queue_first(mpsc_queue_t *queue)
+{
+	return mpsc_queue_next(queue, queue->head);
+}
+
+/** Return the successor of an item in the queue.
+ *
+ * May only be called when the consumer side is quiescent.
+ *
+ * @param queue Queue to examine.
+ * @param link  Queue link of the item to get the successor of.
+ *
+ * @return Queue link of the successor or NULL at the end of the queue.
+ *
+ */
+mpsc_link_t *mpsc_queue_next(mpsc_queue_t *queue, mpsc_link_t *link)
+{
+	mpsc_link_t *next = atomic_load_explicit(&link->next,
+	    memory_order_acquire);
+
+	/* The stub is not an item. */
+	if (next == &queue->stub)
+		next = atomic_load_explicit(&next->next,
+		    memory_order_acquire);
+
+	return next;
+}
@@ -0,0 +1,911 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/**
+ * @file
+ * @brief Ordered B-tree dictionary.
+ *
+ * Ordered dictionary with the same interface style as odict, but backed
+ * by a B-tree with multi-entry nodes allocated from a slab cache. Where
+ * an odict lookup chases one pointer per comparison, a B-tree lookup
+ * touches a single contiguous node per tree level, which behaves much
+ * better in the cache for large dictionaries.
+ *
+ * The entries themselves stay embedded in client structures (obt_link_t);
+ * the B-tree nodes only index them. Since index nodes must be allocated,
+ * obtree_insert() can fail with ENOMEM, unlike odict_insert(). Nodes are
+ * allocated with FRAME_ATOMIC as insertions commonly happen under
+ * spinlocks.
+ *
+ * Like in odict, entries are additionally linked into an ordered list,
+ * giving O(1) iteration.
+ */
+
+#include <adt/list.h>
+#include <adt/obtree.h>
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <mm/frame.h>
+#include <mm/slab.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+static slab_cache_t *obtree_node_cache;
+
+/** Initialize B-tree dictionaries.
+ *
+ * Create the slab cache for B-tree nodes. Must be called before the
+ * first insertion into any dictionary.
+ */
+void obtree_init(void)
+{
+	obtree_node_cache = slab_cache_create("obtree_node_t",
+	    sizeof(obtree_node_t), 0, NULL, NULL, SLAB_CACHE_MAGDEFERRED);
+}
+
+/** Allocate a new, empty leaf node.
+ *
+ * @return New node or @c NULL if out of memory
+ */
+static obtree_node_t *obtree_node_alloc(void)
+{
+	obtree_node_t *node;
+
+	node = (obtree_node_t *) slab_alloc(obtree_node_cache, FRAME_ATOMIC);
+	if (node == NULL)
+		return NULL;
+
+	memsetb(node, sizeof(obtree_node_t), 0);
+
+	return node;
+}
+
+/** Free a node. */
+static void obtree_node_free(obtree_node_t *node)
+{
+	slab_free(obtree_node_cache, node);
+}
+
+/** Determine if node is a leaf. */
+static bool obtree_node_is_leaf(obtree_node_t *node)
+{
+	return node->child[0] == NULL;
+}
+
+/** Return position of entry in its node. */
+static size_t obtree_entry_idx(obtree_node_t *node, obt_link_t *olink)
+{
+	size_t i;
+
+	for (i = 0; i < node->nentries; i++) {
+		if (node->entry[i] == olink)
+			return i;
+	}
+
+	assert(false);
+	return 0;
+}
+
+/** Return position of child in its parent. */
+static size_t obtree_child_idx(obtree_node_t *parent, obtree_node_t *node)
+{
+	size_t i;
+
+	for (i = 0; i <= parent->nentries; i++) {
+		if (parent->child[i] == node)
+			return i;
+	}
+
+	assert(false);
+	return 0;
+}
+
+/** Get key of entry. */
+static void *obtree_key(obtree_t *obtree, obt_link_t *olink)
+{
+	return obtree->getkey(olink);
+}
+
+/** Split the full child @a ci of node @a parent.
+ *
+ * @a parent must not be full. The median entry of the child moves up
+ * into @a parent; the upper half of the child moves into a newly
+ * allocated right sibling.
+ *
+ * @param parent Parent node
+ * @param ci     Index of the full child
+ *
+ * @return EOK on success, ENOMEM if out of memory (the tree is left
+ *         unmodified)
+ */
+static errno_t obtree_split_child(obtree_node_t *parent, size_t ci)
+{
+	obtree_node_t *cnode = parent->child[ci];
+	obtree_node_t *rnode;
+	size_t median = OBTREE_MAX_ENTRIES / 2;
+	size_t i;
+
+	assert(cnode->nentries == OBTREE_MAX_ENTRIES);
+	assert(parent->nentries < OBTREE_MAX_ENTRIES);
+
+	rnode = obtree_node_alloc();
+	if (rnode == NULL)
+		return ENOMEM;
+
+	/* Move the upper half of the child to the new right sibling. */
+	for (i = median + 1; i < OBTREE_MAX_ENTRIES; i++) {
+		rnode->entry[i - median - 1] = cnode->entry[i];
+		rnode->entry[i - median - 1]->node = rnode;
+		cnode->entry[i] = NULL;
+	}
+
+	if (!obtree_node_is_leaf(cnode)) {
+		for (i = median + 1; i <= OBTREE_MAX_ENTRIES; i++) {
+			rnode->child[i - median - 1] = cnode->child[i];
+			rnode->child[i - median - 1]->parent = rnode;
+			cnode->child[i] = NULL;
+		}
+	}
+
+	rnode->nentries = OBTREE_MAX_ENTRIES - median - 1;
+
+	/* Move the median up into the parent. */
+	for (i = parent->nentries; i > ci; i--) {
+		parent->entry[i] = parent->entry[i - 1];
+		parent->child[i + 1] = parent->child[i];
+	}
+
+	parent->entry[ci] = cnode->entry[median];
+	parent->entry[ci]->node = parent;
+	cnode->entry[median] = NULL;
+	cnode->nentries = median;
+
+	parent->child[ci + 1] = rnode;
+	rnode->parent = parent;
+	parent->nentries++;
+
+	return EOK;
+}
+
+/** Initialize ordered B-tree dictionary.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param getkey Funcition to get key
+ * @param cmp    Function to compare two keys
+ */
+void obtree_initialize(obtree_t *obtree, obt_getkey_t getkey, obt_cmp_t cmp)
+{
+	obtree->root = NULL;
+	list_initialize(&obtree->entries);
+	obtree->getkey = getkey;
+	obtree->cmp = cmp;
+}
+
+/** Finalize ordered B-tree dictionary.
+ *
+ * The dictionary must be empty.
+ *
+ * @param obtree Ordered B-tree dictionary
+ */
+void obtree_finalize(obtree_t *obtree)
+{
+	assert(obtree->root == NULL);
+	assert(list_empty(&obtree->entries));
+}
+
+/** Initialize ordered B-tree dictionary link.
+ *
+ * @param olink Ordered B-tree dictionary link
+ */
+void obt_link_initialize(obt_link_t *olink)
+{
+	olink->obtree = NULL;
+	olink->node = NULL;
+	link_initialize(&olink->lentries);
+}
+
+/** Insert entry into ordered B-tree dictionary.
+ *
+ * Insert entry into dictionary. If the key is already present, the new
+ * entry is inserted after the existing equal entries.
+ *
+ * @param olink  New entry
+ * @param obtree Ordered B-tree dictionary
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t obtree_insert(obt_link_t *olink, obtree_t *obtree)
+{
+	obtree_node_t *node;
+	obt_link_t *pred;
+	void *key;
+	errno_t rc;
+	size_t i;
+	size_t j;
+
+	key = obtree_key(obtree, olink);
+	pred = obtree_find_leq(obtree, key);
+
+	if (obtree->root == NULL) {
+		node = obtree_node_alloc();
+		if (node == NULL)
+			return ENOMEM;
+
+		obtree->root = node;
+	}
+
+	/*
+	 * Split full nodes preemptively while descending so that no
+	 * node on the path from the insertion point to the root is
+	 * full and no bottom-up split cascade is needed.
+	 */
+	if (obtree->root->nentries == OBTREE_MAX_ENTRIES) {
+		node = obtree_node_alloc();
+		if (node == NULL)
+			return ENOMEM;
+
+		node->child[0] = obtree->root;
+		obtree->root->parent = node;
+
+		rc = obtree_split_child(node, 0);
+		if (rc != EOK) {
+			obtree->root->parent = NULL;
+			node->child[0] = NULL;
+			obtree_node_free(node);
+			return ENOMEM;
+		}
+
+		obtree->root = node;
+	}
+
+	node = obtree->root;
+	while (true) {
+		/* Position after all entries less than or equal to key */
+		i = 0;
+		while (i < node->nentries &&
+		    obtree->cmp(obtree_key(obtree, node->entry[i]), key) <= 0)
+			i++;
+
+		if (obtree_node_is_leaf(node))
+			break;
+
+		if (node->child[i]->nentries == OBTREE_MAX_ENTRIES) {
+			rc = obtree_split_child(node, i);
+			if (rc != EOK)
+				return ENOMEM;
+
+			/* The median entry moved up to position i. */
+			if (obtree->cmp(obtree_key(obtree, node->entry[i]),
+			    key) <= 0)
+				i++;
+		}
+
+		node = node->child[i];
+	}
+
+	/* Insert into the (non-full) leaf. */
+	assert(node->nentries < OBTREE_MAX_ENTRIES);
+
+	for (j = node->nentries; j > i; j--)
+		node->entry[j] = node->entry[j - 1];
+
+	node->entry[i] = olink;
+	node->nentries++;
+
+	olink->obtree = obtree;
+	olink->node = node;
+
+	if (pred != NULL)
+		list_insert_after(&olink->lentries, &pred->lentries);
+	else
+		list_prepend(&olink->lentries, &obtree->entries);
+
+	return EOK;
+}
+
+/** Rebalance the tree after removing an entry from @a node.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param node   Node an entry was removed from
+ */
+static void obtree_rebalance(obtree_t *obtree, obtree_node_t *node)
+{
+	obtree_node_t *parent;
+	obtree_node_t *lsib;
+	obtree_node_t *rsib;
+	size_t ci;
+	size_t i;
+
+	while (node != obtree->root &&
+	    node->nentries < OBTREE_MIN_ENTRIES) {
+		parent = node->parent;
+		ci = obtree_child_idx(parent, node);
+
+		lsib = (ci > 0) ? parent->child[ci - 1] : NULL;
+		rsib = (ci < parent->nentries) ? parent->child[ci + 1] : NULL;
+
+		if (lsib != NULL && lsib->nentries > OBTREE_MIN_ENTRIES) {
+			/* Borrow via the parent from the left sibling. */
+			for (i = node->nentries; i > 0; i--)
+				node->entry[i] = node->entry[i - 1];
+			if (!obtree_node_is_leaf(node)) {
+				for (i = node->nentries + 1; i > 0; i--)
+					node->child[i] = node->child[i - 1];
+			}
+
+			node->entry[0] = parent->entry[ci - 1];
+			node->entry[0]->node = node;
+
+			if (!obtree_node_is_leaf(node)) {
+				node->child[0] = lsib->child[lsib->nentries];
+				node->child[0]->parent = node;
+				lsib->child[lsib->nentries] = NULL;
+			}
+
+			parent->entry[ci - 1] = lsib->entry[lsib->nentries - 1];
+			parent->entry[ci - 1]->node = parent;
+			lsib->entry[lsib->nentries - 1] = NULL;
+
+			lsib->nentries--;
+			node->nentries++;
+			return;
+		}
+
+		if (rsib != NULL && rsib->nentries > OBTREE_MIN_ENTRIES) {
+			/* Borrow via the parent from the right sibling. */
+			node->entry[node->nentries] = parent->entry[ci];
+			node->entry[node->nentries]->node = node;
+
+			if (!obtree_node_is_leaf(node)) {
+				node->child[node->nentries + 1] = rsib->child[0];
+				node->child[node->nentries + 1]->parent = node;
+			}
+
+			parent->entry[ci] = rsib->entry[0];
+			parent->entry[ci]->node = parent;
+
+			for (i = 0; i < rsib->nentries - 1; i++)
+				rsib->entry[i] = rsib->entry[i + 1];
+			rsib->entry[rsib->nentries - 1] = NULL;
+			if (!obtree_node_is_leaf(rsib)) {
+				for (i = 0; i < rsib->nentries; i++)
+					rsib->child[i] = rsib->child[i + 1];
+				rsib->child[rsib->nentries] = NULL;
+			}
+
+			rsib->nentries--;
+			node->nentries++;
+			return;
+		}
+
+		/*
+		 * Both siblings are minimal. Merge with a sibling,
+		 * pulling the separating entry down from the parent,
+		 * and continue rebalancing the parent.
+		 */
+		if (lsib != NULL) {
+			/* Merge node into its left sibling. */
+			lsib->entry[lsib->nentries] = parent->entry[ci - 1];
+			lsib->entry[lsib->nentries]->node = lsib;
+
+			for (i = 0; i < node->nentries; i++) {
+				lsib->entry[lsib->nentries + 1 + i] =
+				    node->entry[i];
+				lsib->entry[lsib->nentries + 1 + i]->node =
+				    lsib;
+			}
+
+			if (!obtree_node_is_leaf(node)) {
+				for (i = 0; i <= node->nentries; i++) {
+					lsib->child[lsib->nentries + 1 + i] =
+					    node->child[i];
+					lsib->child[lsib->nentries + 1 + i]->
+					    parent = lsib;
+				}
+			}
+
+			lsib->nentries += 1 + node->nentries;
+
+			/* Remove the separator and the child from parent. */
+			for (i = ci - 1; i < parent->nentries - 1; i++)
+				parent->entry[i] = parent->entry[i + 1];
+			parent->entry[parent->nentries - 1] = NULL;
+			for (i = ci; i < parent->nentries; i++)
+				parent->child[i] = parent->child[i + 1];
+			parent->child[parent->nentries] = NULL;
+			parent->nentries--;
+
+			obtree_node_free(node);
+		} else {
+			assert(rsib != NULL);
+
+			/* Merge the right sibling into node. */
+			node->entry[node->nentries] = parent->entry[ci];
+			node->entry[node->nentries]->node = node;
+
+			for (i = 0; i < rsib->nentries; i++) {
+				node->entry[node->nentries + 1 + i] =
+				    rsib->entry[i];
+				node->entry[node->nentries + 1 + i]->node =
+				    node;
+			}
+
+			if (!obtree_node_is_leaf(rsib)) {
+				for (i = 0; i <= rsib->nentries; i++) {
+					node->child[node->nentries + 1 + i] =
+					    rsib->child[i];
+					node->child[node->nentries + 1 + i]->
+					    parent = node;
+				}
+			}
+
+			node->nentries += 1 + rsib->nentries;
+
+			for (i = ci; i < parent->nentries - 1; i++)
+				parent->entry[i] = parent->entry[i + 1];
+			parent->entry[parent->nentries - 1] = NULL;
+			for (i = ci + 1; i < parent->nentries; i++)
+				parent->child[i] = parent->child[i + 1];
+			parent->child[parent->nentries] = NULL;
+			parent->nentries--;
+
+			obtree_node_free(rsib);
+		}
+
+		node = parent;
+	}
+
+	/* The root may have become empty. */
+	node = obtree->root;
+	if (node->nentries == 0) {
+		if (!obtree_node_is_leaf(node)) {
+			/* The tree shrinks in height. */
+			obtree->root = node->child[0];
+			obtree->root->parent = NULL;
+		} else {
+			/* The tree is now empty. */
+			obtree->root = NULL;
+		}
+
+		obtree_node_free(node);
+	}
+}
+
+/** Remove entry from ordered B-tree dictionary.
+ *
+ * @param olink Entry
+ */
+void obtree_remove(obt_link_t *olink)
+{
+	obtree_t *obtree = olink->obtree;
+	obtree_node_t *node = olink->node;
+	obtree_node_t *lnode;
+	size_t idx;
+	size_t i;
+
+	assert(obtree != NULL);
+
+	idx = obtree_entry_idx(node, olink);
+
+	if (!obtree_node_is_leaf(node)) {
+		/*
+		 * Replace the entry with its in-order successor, which
+		 * resides in a leaf, and remove from that leaf instead.
+		 */
+		obt_link_t *succ = obtree_next(olink, obtree);
+
+		assert(succ != NULL);
+		lnode = succ->node;
+		i = obtree_entry_idx(lnode, succ);
+		assert(obtree_node_is_leaf(lnode));
+
+		node->entry[idx] = succ;
+		succ->node = node;
+	} else {
+		lnode = node;
+		i = idx;
+	}
+
+	for (; i < lnode->nentries - 1; i++)
+		lnode->entry[i] = lnode->entry[i + 1];
+	lnode->entry[lnode->nentries - 1] = NULL;
+	lnode->nentries--;
+
+	list_remove(&olink->lentries);
+	olink->obtree = NULL;
+	olink->node = NULL;
+
+	obtree_rebalance(obtree, lnode);
+}
+
+/** Update dictionary after entry key change.
+ *
+ * The entry is moved to the correct position for its new key.
+ *
+ * @param olink  Entry whose key changed
+ * @param obtree Ordered B-tree dictionary
+ *
+ * @return EOK on success, ENOMEM if out of memory (in which case the
+ *         entry is no longer in the dictionary)
+ */
+errno_t obtree_key_update(obt_link_t *olink, obtree_t *obtree)
+{
+	obtree_remove(olink);
+	return obtree_insert(olink, obtree);
+}
+
+/** Determine if entry is in a dictionary.
+ *
+ * @param olink Entry
+ * @return @c true if entry is in a dictionary, @c false otherwise
+ */
+bool obt_link_used(obt_link_t *olink)
+{
+	return olink->obtree != NULL;
+}
+
+/** Determine if dictionary is empty.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @return @c true if dictionary is empty
+ */
+bool obtree_empty(obtree_t *obtree)
+{
+	return obtree->root == NULL;
+}
+
+/** Return the number of entries in the dictionary.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @return Number of entries
+ */
+unsigned long obtree_count(obtree_t *obtree)
+{
+	return list_count(&obtree->entries);
+}
+
+/** Return first entry in dictionary (in ascending key order).
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @return First entry or @c NULL if the dictionary is empty
+ */
+obt_link_t *obtree_first(obtree_t *obtree)
+{
+	link_t *link = list_first(&obtree->entries);
+	if (link == NULL)
+		return NULL;
+
+	return list_get_instance(link, obt_link_t, lentries);
+}
+
+/** Return last entry in dictionary (in ascending key order).
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @return Last entry or @c NULL if the dictionary is empty
+ */
+obt_link_t *obtree_last(obtree_t *obtree)
+{
+	link_t *link = list_last(&obtree->entries);
+	if (link == NULL)
+		return NULL;
+
+	return list_get_instance(link, obt_link_t, lentries);
+}
+
+/** Return previous entry in dictionary.
+ *
+ * @param olink  Entry
+ * @param obtree Ordered B-tree dictionary
+ * @return Previous entry or @c NULL if @a olink is the first entry
+ */
+obt_link_t *obtree_prev(obt_link_t *olink, obtree_t *obtree)
+{
+	link_t *link = list_prev(&olink->lentries, &obtree->entries);
+	if (link == NULL)
+		return NULL;
+
+	return list_get_instance(link, obt_link_t, lentries);
+}
+
+/** Return next entry in dictionary.
+ *
+ * @param olink  Entry
+ * @param obtree Ordered B-tree dictionary
+ * @return Next entry or @c NULL if @a olink is the last entry
+ */
+obt_link_t *obtree_next(obt_link_t *olink, obtree_t *obtree)
+{
+	link_t *link = list_next(&olink->lentries, &obtree->entries);
+	if (link == NULL)
+		return NULL;
+
+	return list_get_instance(link, obt_link_t, lentries);
+}
+
+/** Find the first entry whose key is greater than or equal to @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_geq(obtree_t *obtree, void *key)
+{
+	obtree_node_t *node = obtree->root;
+	obt_link_t *cand = NULL;
+	size_t i;
+
+	while (node != NULL) {
+		i = 0;
+		while (i < node->nentries &&
+		    obtree->cmp(obtree_key(obtree, node->entry[i]), key) < 0)
+			i++;
+
+		if (i < node->nentries)
+			cand = node->entry[i];
+
+		node = node->child[i];
+	}
+
+	return cand;
+}
+
+/** Find the first entry whose key is greater than @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_gt(obtree_t *obtree, void *key)
+{
+	obtree_node_t *node = obtree->root;
+	obt_link_t *cand = NULL;
+	size_t i;
+
+	while (node != NULL) {
+		i = 0;
+		while (i < node->nentries &&
+		    obtree->cmp(obtree_key(obtree, node->entry[i]), key) <= 0)
+			i++;
+
+		if (i < node->nentries)
+			cand = node->entry[i];
+
+		node = node->child[i];
+	}
+
+	return cand;
+}
+
+/** Find the last entry whose key is less than or equal to @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_leq(obtree_t *obtree, void *key)
+{
+	obtree_node_t *node = obtree->root;
+	obt_link_t *cand = NULL;
+	size_t i;
+
+	while (node != NULL) {
+		i = 0;
+		while (i < node->nentries &&
+		    obtree->cmp(obtree_key(obtree, node->entry[i]), key) <= 0)
+			i++;
+
+		if (i > 0)
+			cand = node->entry[i - 1];
+
+		node = node->child[i];
+	}
+
+	return cand;
+}
+
+/** Find the last entry whose key is less than @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_lt(obtree_t *obtree, void *key)
+{
+	obtree_node_t *node = obtree->root;
+	obt_link_t *cand = NULL;
+	size_t i;
+
+	while (node != NULL) {
+		i = 0;
+		while (i < node->nentries &&
+		    obtree->cmp(obtree_key(obtree, node->entry[i]), key) < 0)
+			i++;
+
+		if (i > 0)
+			cand = node->entry[i - 1];
+
+		node = node->child[i];
+	}
+
+	return cand;
+}
+
+/** Find the first entry whose key is equal to @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_eq(obtree_t *obtree, void *key)
+{
+	obt_link_t *olink = obtree_find_geq(obtree, key);
+
+	if (olink == NULL)
+		return NULL;
+
+	if (obtree->cmp(obtree_key(obtree, olink), key) != 0)
+		return NULL;
+
+	return olink;
+}
+
+/** Find the last entry whose key is equal to @a key.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param key    Key
+ * @return Entry or @c NULL if not found
+ */
+obt_link_t *obtree_find_eq_last(obtree_t *obtree, void *key)
+{
+	obt_link_t *olink = obtree_find_leq(obtree, key);
+
+	if (olink == NULL)
+		return NULL;
+
+	if (obtree->cmp(obtree_key(obtree, olink), key) != 0)
+		return NULL;
+
+	return olink;
+}
+
+/** Validate one subtree.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @param node   Subtree root
+ * @param minkey Lower key bound for the subtree or @c NULL
+ * @param maxkey Upper key bound for the subtree or @c NULL
+ * @param depth  Depth of @a node
+ * @param ldepth Place to store/check the common leaf depth
+ *
+ * @return EOK if the subtree is valid, EINVAL otherwise
+ */
+static errno_t obtree_validate_node(obtree_t *obtree, obtree_node_t *node,
+    void *minkey, void *maxkey, size_t depth, size_t *ldepth)
+{
+	size_t i;
+	void *key;
+	errno_t rc;
+
+	if (node->nentries == 0 || node->nentries > OBTREE_MAX_ENTRIES)
+		return EINVAL;
+
+	if (node != obtree->root && node->nentries < OBTREE_MIN_ENTRIES)
+		return EINVAL;
+
+	for (i = 0; i < node->nentries; i++) {
+		if (node->entry[i]->node != node)
+			return EINVAL;
+		if (node->entry[i]->obtree != obtree)
+			return EINVAL;
+
+		key = obtree_key(obtree, node->entry[i]);
+
+		if (i > 0 && obtree->cmp(obtree_key(obtree,
+		    node->entry[i - 1]), key) > 0)
+			return EINVAL;
+
+		if (minkey != NULL && obtree->cmp(key, minkey) < 0)
+			return EINVAL;
+		if (maxkey != NULL && obtree->cmp(key, maxkey) > 0)
+			return EINVAL;
+	}
+
+	if (obtree_node_is_leaf(node)) {
+		if (*ldepth == (size_t) -1)
+			*ldepth = depth;
+		else if (*ldepth != depth)
+			return EINVAL;
+
+		return EOK;
+	}
+
+	for (i = 0; i <= node->nentries; i++) {
+		if (node->child[i] == NULL)
+			return EINVAL;
+		if (node->child[i]->parent != node)
+			return EINVAL;
+
+		rc = obtree_validate_node(obtree, node->child[i],
+		    (i > 0) ? obtree_key(obtree, node->entry[i - 1]) : minkey,
+		    (i < node->nentries) ?
+		    obtree_key(obtree, node->entry[i]) : maxkey,
+		    depth + 1, ldepth);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Validate dictionary structure invariants.
+ *
+ * @param obtree Ordered B-tree dictionary
+ * @return EOK if the dictionary is consistent, EINVAL otherwise
+ */
+errno_t obtree_validate(obtree_t *obtree)
+{
+	size_t ldepth = (size_t) -1;
+	obt_link_t *cur;
+	obt_link_t *prev;
+	errno_t rc;
+
+	if (obtree->root == NULL) {
+		if (!list_empty(&obtree->entries))
+			return EINVAL;
+		return EOK;
+	}
+
+	if (obtree->root->parent != NULL)
+		return EINVAL;
+
+	rc = obtree_validate_node(obtree, obtree->root, NULL, NULL, 0,
+	    &ldepth);
+	if (rc != EOK)
+		return rc;
+
+	/* The entry list must be in ascending key order. */
+	prev = NULL;
+	cur = obtree_first(obtree);
+	while (cur != NULL) {
+		if (prev != NULL && obtree->cmp(obtree_key(obtree, prev),
+		    obtree_key(obtree, cur)) > 0)
+			return EINVAL;
+
+		prev = cur;
+		cur = obtree_next(cur, obtree);
+	}
+
+	return EOK;
+}
+
+/** @}
+ */
@@ -78,7 +78,10 @@
 #include <cap/cap.h>
 #include <abi/cap.h>
 #include <proc/task.h>
+#include <proc/thread.h>
 #include <synch/mutex.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
 #include <abi/errno.h>
 #include <mm/slab.h>
 #include <adt/list.h>
@@ -86,6 +89,7 @@
 #include <ipc/ipcrsc.h>
 #include <ipc/ipc.h>
 #include <ipc/irq.h>
+#include <log.h>
 
 #include <limits.h>
 #include <stdint.h>
@@ -98,6 +102,11 @@
 static slab_cache_t *cap_cache;
 static slab_cache_t *kobject_cache;
 
+/** Queue of dead kobjects awaiting destruction by the kcapreclaim thread. */
+IRQ_SPINLOCK_STATIC_INITIALIZE(kobject_reclaim_lock);
+static LIST_INITIALIZE(kobject_reclaim_queue);
+static waitq_t kobject_reclaim_wq;
+
 kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_CALL] = &call_kobject_ops,
 	[KOBJECT_TYPE_IRQ] = &irq_kobject_ops,
@@ -136,6 +145,7 @@ void caps_init(void)
 	    NULL, 0);
 	kobject_cache = slab_cache_create("kobject_t", sizeof(kobject_t), 0,
 	    NULL, NULL, 0);
+	waitq_initialize(&kobject_reclaim_wq);
 }
 
 /** Allocate the capability info structure
@@ -486,5 +496,81 @@ void kobject_put(kobject_t *kobj)
 	}
 }
 
+/** Drop reference to kernel object, deferring the destruction
+ *
+ * Unlike kobject_put(), the destruction of the encapsulated object is not
+ * carried out by the caller, but handed over to the kcapreclaim thread.
+ * This is meant for bulk teardown paths (e.g. task cleanup) which would
+ * otherwise destroy thousands of objects while holding the task's
+ * capability lock.
+ *
+ * May only be called after caps_reclaim_init().
+ *
+ * @param kobj  Kernel object whose reference to drop.
+ */
+void kobject_put_deferred(kobject_t *kobj)
+{
+	if (atomic_postdec(&kobj->refcnt) == 1) {
+		irq_spinlock_lock(&kobject_reclaim_lock, true);
+		list_append(&kobj->reclaim_link, &kobject_reclaim_queue);
+		irq_spinlock_unlock(&kobject_reclaim_lock, true);
+
+		waitq_wakeup(&kobject_reclaim_wq, WAKEUP_FIRST);
+	}
+}
+
+/** Kernel thread destroying dead kobjects in batches
+ *
+ * Destruction happens outside of any task's capability lock, so a task
+ * dropping a large number of capabilities at once does not stall on the
+ * destructors of the underlying objects.
+ *
+ * @param arg Ignored.
+ *
+ */
+static void kcapreclaim(void *arg)
+{
+	/*
+	 * Detach kcapreclaim as nobody will call thread_join_timeout() on it.
+	 */
+	thread_detach(THREAD);
+
+	while (true) {
+		waitq_sleep(&kobject_reclaim_wq);
+
+		list_t batch;
+		list_initialize(&batch);
+
+		irq_spinlock_lock(&kobject_reclaim_lock, true);
+		list_concat(&batch, &kobject_reclaim_queue);
+		irq_spinlock_unlock(&kobject_reclaim_lock, true);
+
+		list_foreach_safe(batch, cur, next) {
+			kobject_t *kobj =
+			    list_get_instance(cur, kobject_t, reclaim_link);
+			list_remove(cur);
+			KOBJECT_OP(kobj)->destroy(kobj->raw);
+			kobject_free(kobj);
+		}
+	}
+}
+
+/** Start the deferred kobject reclamation thread.
+ *
+ * Called from kinit before any userspace task can exercise the
+ * capability interfaces.
+ *
+ */
+void caps_reclaim_init(void)
+{
+	thread_t *thread = thread_create(kcapreclaim, NULL, TASK,
+	    THREAD_FLAG_UNCOUNTED, "kcapreclaim");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR,
+		    "Unable to create kcapreclaim thread");
+}
+
 /** @}
  */
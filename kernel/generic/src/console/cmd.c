@@ -67,6 +67,8 @@
 #include <ipc/ipc.h>
 #include <ipc/irq.h>
 #include <ipc/event.h>
+#include <sysinfo/profiler.h>
+#include <lattrace.h>
 #include <sysinfo/sysinfo.h>
 #include <symtab.h>
 #include <errno.h>
@@ -429,6 +431,38 @@ cmd_info_t physmem_info = {
 	.argv = NULL
 };
 
+/* Data and methods for 'profile' command. */
+static int cmd_profile(cmd_arg_t *argv);
+static char profile_buf[MAX_CMDLINE + 1];
+static cmd_arg_t profile_argv = {
+	.type = ARG_TYPE_STRING,
+	.buffer = profile_buf,
+	.len = sizeof(profile_buf)
+};
+static cmd_info_t profile_info = {
+	.name = "profile",
+	.description = "<start|stop> Control the kernel sampling profiler.",
+	.func = cmd_profile,
+	.argc = 1,
+	.argv = &profile_argv
+};
+
+/* Data and methods for 'lattrace' command. */
+static int cmd_lattrace(cmd_arg_t *argv);
+static char lattrace_buf[MAX_CMDLINE + 1];
+static cmd_arg_t lattrace_argv = {
+	.type = ARG_TYPE_STRING,
+	.buffer = lattrace_buf,
+	.len = sizeof(lattrace_buf)
+};
+static cmd_info_t lattrace_info = {
+	.name = "lattrace",
+	.description = "<start|stop> Control the kernel latency tracer.",
+	.func = cmd_lattrace,
+	.argc = 1,
+	.argv = &lattrace_argv
+};
+
 /* Data and methods for 'tlb' command. */
 static int cmd_tlb(cmd_arg_t *argv);
 cmd_info_t tlb_info = {
@@ -596,7 +630,9 @@ static cmd_info_t *basic_commands[] = {
 	&help_info,
 	&ipc_info,
 	&kill_info,
+	&lattrace_info,
 	&physmem_info,
+	&profile_info,
 	&reboot_info,
 	&sched_info,
 	&set4_info,
@@ -1153,6 +1189,58 @@ int cmd_physmem(cmd_arg_t *argv)
 	return 1;
 }
 
+/** Control the kernel sampling profiler.
+ *
+ * @param argv Argument vector.
+ *
+ * @return 0 on failure, 1 on success.
+ */
+int cmd_profile(cmd_arg_t *argv)
+{
+	if (str_cmp((char *) argv->buffer, "start") == 0) {
+		if (profiler_start() != EOK) {
+			printf("Profiler is not available.\n");
+			return 0;
+		}
+
+		printf("Profiler started.\n");
+	} else if (str_cmp((char *) argv->buffer, "stop") == 0) {
+		profiler_stop();
+		printf("Profiler stopped.\n");
+	} else {
+		printf("Unknown argument '%s'.\n", (char *) argv->buffer);
+		return 0;
+	}
+
+	return 1;
+}
+
+/** Control the kernel latency tracer.
+ *
+ * @param argv Argument vector.
+ *
+ * @return 0 on failure, 1 on success.
+ */
+int cmd_lattrace(cmd_arg_t *argv)
+{
+	if (str_cmp((char *) argv->buffer, "start") == 0) {
+		if (lattrace_start() != EOK) {
+			printf("Latency tracer is not available.\n");
+			return 0;
+		}
+
+		printf("Latency tracer started.\n");
+	} else if (str_cmp((char *) argv->buffer, "stop") == 0) {
+		lattrace_stop();
+		printf("Latency tracer stopped.\n");
+	} else {
+		printf("Unknown argument '%s'.\n", (char *) argv->buffer);
+		return 0;
+	}
+
+	return 1;
+}
+
 /** Write 4 byte value to address */
 int cmd_set4(cmd_arg_t *argv)
 {
@@ -60,6 +60,14 @@
 #define KIO_PAGES    8
 #define KIO_LENGTH   (KIO_PAGES * PAGE_SIZE / sizeof(char32_t))
 
+/** Notify uspace when this many unread characters accumulate.
+ *
+ * Forces a notification even when no newline has been printed yet, so
+ * that a consumer under heavy kernel logging gets a chance to drain the
+ * buffer before unread characters start being overwritten.
+ */
+#define KIO_NOTIFY_THRESHOLD  (KIO_LENGTH / 2)
+
 /** Kernel log cyclic buffer */
 char32_t kio[KIO_LENGTH] __attribute__((aligned(PAGE_SIZE)));
 
@@ -78,6 +86,9 @@ static size_t kio_stored = 0;
 /** Number of stored kernel log characters for uspace */
 static size_t kio_uspace = 0;
 
+/** Number of kernel log characters overwritten before uspace read them */
+static size_t kio_lost = 0;
+
 /** Kernel log spinlock */
 SPINLOCK_INITIALIZE_NAME(kio_lock, "kio_lock");
 
@@ -301,9 +312,11 @@ void kio_update(void *event)
 	spinlock_lock(&kio_lock);
 
 	if (kio_uspace > 0) {
-		if (event_notify_3(EVENT_KIO, true, kio_start, kio_len,
-		    kio_uspace) == EOK)
+		if (event_notify_4(EVENT_KIO, true, kio_start, kio_len,
+		    kio_uspace, kio_lost) == EOK) {
 			kio_uspace = 0;
+			kio_lost = 0;
+		}
 	}
 
 	spinlock_unlock(&kio_lock);
@@ -357,6 +370,10 @@ void kio_push_char(const char32_t ch)
 	/* The character is stored for uspace */
 	if (kio_uspace < kio_len)
 		kio_uspace++;
+	else if (kio_len == KIO_LENGTH) {
+		/* The oldest character not yet read by uspace was lost. */
+		kio_lost++;
+	}
 }
 
 void putuchar(const char32_t ch)
@@ -365,6 +382,7 @@ void putuchar(const char32_t ch)
 
 	spinlock_lock(&kio_lock);
 	kio_push_char(ch);
+	size_t pending = kio_uspace;
 	spinlock_unlock(&kio_lock);
 
 	/* Output stored characters */
@@ -384,8 +402,11 @@ void putuchar(const char32_t ch)
 		early_putuchar(ch);
 	}
 
-	/* Force notification on newline */
-	if (ch == '\n')
+	/*
+	 * Force notification on newline and when enough unread
+	 * characters have accumulated for a bulk read to pay off.
+	 */
+	if ((ch == '\n') || (pending >= KIO_NOTIFY_THRESHOLD))
 		kio_update(NULL);
 }
 
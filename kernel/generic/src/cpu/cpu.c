@@ -83,12 +83,25 @@ void cpu_init(void)
 			cpus[i].stack = (uint8_t *) PA2KA(stack_phys);
 			cpus[i].id = i;
 
+			/*
+			 * Conservative topology defaults: all CPUs share
+			 * the last-level cache and no two CPUs share a
+			 * core. Architectures which can discover the real
+			 * topology override these in cpu_identify().
+			 */
+			cpus[i].package_id = 0;
+			cpus[i].core_id = i;
+
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
 				list_initialize(&cpus[i].rq[j].rq);
 			}
+
+			irq_spinlock_initialize(&cpus[i].deadline_rq.lock,
+			    "cpus[].deadline_rq.lock");
+			list_initialize(&cpus[i].deadline_rq.rq);
 		}
 
 #ifdef CONFIG_SMP
@@ -39,60 +39,50 @@
  */
 
 #include <ddi/irq.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <mm/slab.h>
 #include <typedefs.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
 #include <console/console.h>
 #include <interrupt.h>
+#include <panic.h>
 #include <mem.h>
+#include <stdlib.h>
 #include <arch.h>
 
 slab_cache_t *irq_cache = NULL;
 
-/** Spinlock protecting the kernel IRQ hash table
+/** Spinlock protecting the kernel IRQ dispatch lists
  *
  * This lock must be taken only when interrupts are disabled.
  *
  */
-IRQ_SPINLOCK_STATIC_INITIALIZE(irq_kernel_hash_table_lock);
+IRQ_SPINLOCK_STATIC_INITIALIZE(irq_kernel_lists_lock);
 
-/** The kernel IRQ hash table. */
-static hash_table_t irq_kernel_hash_table;
+/** The kernel IRQ dispatch lists, one per INR. */
+static list_t *irq_kernel_lists;
 
-/** Spinlock protecting the uspace IRQ hash table
+/** Spinlock protecting the uspace IRQ dispatch lists
  *
- * This lock must be taken only when interrupts are disabled.
+ * This lock must be taken only when interrupts are disabled. It
+ * serializes writers only; the dispatch path traverses the lists as
+ * an RCU reader without taking it.
  *
  */
-IRQ_SPINLOCK_INITIALIZE(irq_uspace_hash_table_lock);
-
-/** The uspace IRQ hash table */
-hash_table_t irq_uspace_hash_table;
-
-static size_t irq_ht_hash(const ht_link_t *);
-static size_t irq_ht_key_hash(const void *);
-static bool irq_ht_equal(const ht_link_t *, const ht_link_t *);
-static bool irq_ht_key_equal(const void *, const ht_link_t *);
+IRQ_SPINLOCK_INITIALIZE(irq_uspace_lists_lock);
 
-static hash_table_ops_t irq_ht_ops = {
-	.hash = irq_ht_hash,
-	.key_hash = irq_ht_key_hash,
-	.equal = irq_ht_equal,
-	.key_equal = irq_ht_key_equal
-};
+/** The uspace IRQ dispatch lists, one per INR. */
+list_t *irq_uspace_lists;
 
 /** Last valid INR */
 inr_t last_inr = 0;
 
 /** Initialize IRQ subsystem
  *
- * @param inrs    Numbers of unique IRQ numbers or INRs.
- * @param chains  Number of buckets in the hash table.
+ * @param inrs  Numbers of unique IRQ numbers or INRs.
  *
  */
-void irq_init(size_t inrs, size_t chains)
+void irq_init(size_t inrs)
 {
 	last_inr = inrs - 1;
 
@@ -100,8 +90,18 @@ void irq_init(size_t inrs, size_t chains)
 	    FRAME_ATOMIC);
 	assert(irq_cache);
 
-	hash_table_create(&irq_uspace_hash_table, chains, 0, &irq_ht_ops);
-	hash_table_create(&irq_kernel_hash_table, chains, 0, &irq_ht_ops);
+	if (inrs == 0)
+		return;
+
+	irq_kernel_lists = malloc(inrs * sizeof(list_t));
+	irq_uspace_lists = malloc(inrs * sizeof(list_t));
+	if ((!irq_kernel_lists) || (!irq_uspace_lists))
+		panic("Cannot allocate IRQ dispatch lists.");
+
+	for (size_t i = 0; i < inrs; i++) {
+		list_initialize(&irq_kernel_lists[i]);
+		list_initialize(&irq_uspace_lists[i]);
+	}
 }
 
 /** Initialize one IRQ structure
@@ -128,31 +128,35 @@ void irq_initialize(irq_t *irq)
  */
 void irq_register(irq_t *irq)
 {
-	irq_spinlock_lock(&irq_kernel_hash_table_lock, true);
+	assert((irq->inr >= 0) && (irq->inr <= last_inr));
+
+	irq_spinlock_lock(&irq_kernel_lists_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
-	hash_table_insert(&irq_kernel_hash_table, &irq->link);
+	rcu_list_append(&irq->link, &irq_kernel_lists[irq->inr]);
 	irq_spinlock_unlock(&irq->lock, false);
-	irq_spinlock_unlock(&irq_kernel_hash_table_lock, true);
+	irq_spinlock_unlock(&irq_kernel_lists_lock, true);
 }
 
-/** Search and lock an IRQ hash table */
-static irq_t *
-irq_dispatch_and_lock_table(hash_table_t *h, irq_spinlock_t *l, inr_t inr)
+/** Search and lock an IRQ dispatch list
+ *
+ * The list is traversed as an RCU reader, without taking the writer
+ * lock. Writers unlink the IRQ structure and wait for a grace period
+ * before freeing it, so every structure reached here stays valid for
+ * the duration of the traversal.
+ */
+static irq_t *irq_dispatch_and_lock_list(list_t *lists, inr_t inr)
 {
-	irq_spinlock_lock(l, false);
-	ht_link_t *first = hash_table_find(h, &inr);
-	for (ht_link_t *lnk = first; lnk;
-	    lnk = hash_table_find_next(h, first, lnk)) {
-		irq_t *irq = hash_table_get_inst(lnk, irq_t, link);
+	rcu_read_lock();
+	list_foreach(lists[inr], link, irq_t, irq) {
 		irq_spinlock_lock(&irq->lock, false);
 		if (irq->claim(irq) == IRQ_ACCEPT) {
 			/* leave irq locked */
-			irq_spinlock_unlock(l, false);
+			rcu_read_unlock();
 			return irq;
 		}
 		irq_spinlock_unlock(&irq->lock, false);
 	}
-	irq_spinlock_unlock(l, false);
+	rcu_read_unlock();
 
 	return NULL;
 }
@@ -173,6 +177,9 @@ irq_dispatch_and_lock_table(hash_table_t *h, irq_spinlock_t *l, inr_t inr)
  */
 irq_t *irq_dispatch_and_lock(inr_t inr)
 {
+	if ((inr < 0) || (inr > last_inr))
+		return NULL;
+
 	/*
 	 * If the kernel console override is on, then try first the kernel
 	 * handlers and eventually fall back to uspace handlers.
@@ -181,52 +188,18 @@ irq_t *irq_dispatch_and_lock(inr_t inr)
 	 */
 
 	if (console_override) {
-		irq_t *irq = irq_dispatch_and_lock_table(&irq_kernel_hash_table,
-		    &irq_kernel_hash_table_lock, inr);
+		irq_t *irq = irq_dispatch_and_lock_list(irq_kernel_lists, inr);
 		if (irq)
 			return irq;
 
-		return irq_dispatch_and_lock_table(&irq_uspace_hash_table,
-		    &irq_uspace_hash_table_lock, inr);
+		return irq_dispatch_and_lock_list(irq_uspace_lists, inr);
 	}
 
-	irq_t *irq = irq_dispatch_and_lock_table(&irq_uspace_hash_table,
-	    &irq_uspace_hash_table_lock, inr);
+	irq_t *irq = irq_dispatch_and_lock_list(irq_uspace_lists, inr);
 	if (irq)
 		return irq;
 
-	return irq_dispatch_and_lock_table(&irq_kernel_hash_table,
-	    &irq_kernel_hash_table_lock, inr);
-}
-
-/** Return the hash of the key stored in the item. */
-size_t irq_ht_hash(const ht_link_t *item)
-{
-	irq_t *irq = hash_table_get_inst(item, irq_t, link);
-	return hash_mix(irq->inr);
-}
-
-/** Return the hash of the key. */
-size_t irq_ht_key_hash(const void *key)
-{
-	const inr_t *inr = key;
-	return hash_mix(*inr);
-}
-
-/** Return true if the items have the same lookup key. */
-bool irq_ht_equal(const ht_link_t *item1, const ht_link_t *item2)
-{
-	irq_t *irq1 = hash_table_get_inst(item1, irq_t, link);
-	irq_t *irq2 = hash_table_get_inst(item2, irq_t, link);
-	return irq1->inr == irq2->inr;
-}
-
-/** Return true if the key is equal to the item's lookup key. */
-bool irq_ht_key_equal(const void *key, const ht_link_t *item)
-{
-	const inr_t *inr = key;
-	irq_t *irq = hash_table_get_inst(item, irq_t, link);
-	return irq->inr == *inr;
+	return irq_dispatch_and_lock_list(irq_kernel_lists, inr);
 }
 
 /** @}
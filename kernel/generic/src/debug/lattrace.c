@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2018 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Kernel latency tracer.
+ *
+ * Records the longest sections during which interrupts or preemption
+ * stayed disabled, together with the address of the code that opened
+ * each section. The interrupt-off hooks sit in the irq spinlock and
+ * TLB shootdown primitives, the preemption-off hooks directly in
+ * preemption_disable() and preemption_enable(). Nested sections are
+ * folded into the outermost one by a per-CPU depth counter, so only
+ * whole interrupt-off (preemption-off) episodes are measured. The
+ * records are exported to userspace as the system.lattrace sysinfo
+ * item, to be symbolized against the kernel map.
+ *
+ * The per-CPU state is touched without locking: the owning CPU has
+ * exclusive access to it while the traced section is open, and the
+ * hooks themselves must not take any lock, since taking a lock is
+ * exactly what invokes them.
+ *
+ * The tracer is off by default. When it is off, the only cost of a
+ * hook is a single relaxed atomic load.
+ */
+
+#include <lattrace.h>
+#include <sysinfo/sysinfo.h>
+#include <abi/sysinfo.h>
+#include <arch.h>
+#include <arch/cycle.h>
+#include <config.h>
+#include <cpu.h>
+#include <mem.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/** When false, the hooks return immediately. */
+static atomic_bool lattrace_active = false;
+
+/** Enter a latency-critical section on the current CPU.
+ *
+ * Called by the instrumented primitives right after they disable
+ * interrupts (preemption), so the current CPU cannot change under
+ * our hands. Only the outermost section of each kind is timed.
+ *
+ * @param kind Section kind (LATTRACE_IRQ or LATTRACE_PREEMPT).
+ * @param pc   Address of the code that opened the section.
+ *
+ */
+void lattrace_section_begin(unsigned int kind, void *pc)
+{
+	if (!atomic_load_explicit(&lattrace_active, memory_order_relaxed))
+		return;
+
+	if (!CPU)
+		return;
+
+	lattrace_cpu_t *lt = &CPU->lattrace;
+
+	if (lt->depth[kind]++ == 0) {
+		lt->start[kind] = get_cycle();
+		lt->pc[kind] = (uintptr_t) pc;
+	}
+}
+
+/** Leave a latency-critical section on the current CPU.
+ *
+ * Called by the instrumented primitives right before they restore
+ * interrupts (preemption). When the outermost section of the kind
+ * closes, its duration is compared against the longest section seen
+ * so far on this CPU.
+ *
+ * @param kind Section kind (LATTRACE_IRQ or LATTRACE_PREEMPT).
+ *
+ */
+void lattrace_section_end(unsigned int kind)
+{
+	if (!atomic_load_explicit(&lattrace_active, memory_order_relaxed))
+		return;
+
+	if (!CPU)
+		return;
+
+	lattrace_cpu_t *lt = &CPU->lattrace;
+
+	/* The section was opened before the tracer was started */
+	if (lt->depth[kind] == 0)
+		return;
+
+	if (--lt->depth[kind] > 0)
+		return;
+
+	uint64_t cycles = get_cycle() - lt->start[kind];
+	if (cycles > lt->max[kind].cycles) {
+		lt->max[kind].cycles = cycles;
+		lt->max[kind].pc = lt->pc[kind];
+	}
+}
+
+/** Start tracing latency-critical sections.
+ *
+ * The records of a previous run are discarded. Sections already open
+ * when the tracer starts are not measured.
+ *
+ * @return EOK on success, ENOMEM if the CPU structures do not
+ *         exist yet.
+ *
+ */
+errno_t lattrace_start(void)
+{
+	if (cpus == NULL)
+		return ENOMEM;
+
+	size_t cpu;
+	for (cpu = 0; cpu < config.cpu_count; cpu++)
+		memsetb(&cpus[cpu].lattrace, sizeof(lattrace_cpu_t), 0);
+
+	atomic_store_explicit(&lattrace_active, true, memory_order_relaxed);
+	return EOK;
+}
+
+/** Stop tracing latency-critical sections.
+ *
+ * The records collected so far remain readable via sysinfo.
+ *
+ */
+void lattrace_stop(void)
+{
+	atomic_store_explicit(&lattrace_active, false, memory_order_relaxed);
+}
+
+/** Get the longest recorded latency-critical sections
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing LATTRACE_KINDS lattrace_rec_t structures
+ *         for each CPU, ordered by CPU ID with the interrupt-off
+ *         record of each CPU first. If the return value is not NULL,
+ *         it should be freed in the context of the sysinfo request.
+ */
+static void *get_lattrace_data(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	if (cpus == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	*size = sizeof(lattrace_rec_t) * LATTRACE_KINDS * config.cpu_count;
+
+	if (dry_run)
+		return NULL;
+
+	lattrace_rec_t *recs = (lattrace_rec_t *) malloc(*size);
+	if (recs == NULL) {
+		/* No free space for allocation */
+		*size = 0;
+		return NULL;
+	}
+
+	/*
+	 * The records are copied without stopping the other CPUs; a
+	 * record being updated at this very moment may come out torn.
+	 * Diagnostic output does not warrant the disruption of
+	 * synchronizing with every CPU.
+	 */
+	size_t cpu;
+	for (cpu = 0; cpu < config.cpu_count; cpu++) {
+		unsigned int kind;
+		for (kind = 0; kind < LATTRACE_KINDS; kind++)
+			recs[cpu * LATTRACE_KINDS + kind] =
+			    cpus[cpu].lattrace.max[kind];
+	}
+
+	return ((void *) recs);
+}
+
+/** Initialize the latency tracer
+ *
+ * Register the sysinfo item. The tracer remains inactive until
+ * lattrace_start() is called.
+ *
+ */
+void lattrace_init(void)
+{
+	sysinfo_set_item_gen_data("system.lattrace", NULL, get_lattrace_data,
+	    NULL);
+}
+
+/** @}
+ */
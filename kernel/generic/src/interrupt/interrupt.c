@@ -40,6 +40,7 @@
  */
 
 #include <assert.h>
+#include <barrier.h>
 #include <interrupt.h>
 #include <console/kconsole.h>
 #include <console/console.h>
@@ -119,6 +120,16 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		CPU->last_cycle = now;
 		CPU->idle = false;
 		irq_spinlock_unlock(&CPU->lock, false);
+
+		/*
+		 * Make the cleared idle flag globally visible before the
+		 * handler runs. Pairs with the barrier in
+		 * synchronize_rcu(), which treats an idle CPU as
+		 * quiescent: either the updater sees that this CPU is no
+		 * longer idle, or an RCU reader invoked from the handler
+		 * sees the updater's removals.
+		 */
+		memory_barrier();
 	}
 
 	uint64_t begin_cycle = get_cycle();
@@ -128,8 +139,18 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		THREAD->udebug.uspace_state = istate;
 #endif
 
+	/* Publish the interrupt state for the sampling profiler */
+	istate_t *prev_istate = NULL;
+	if (CPU) {
+		prev_istate = CPU->current_istate;
+		CPU->current_istate = istate;
+	}
+
 	exc_table[n].handler(n + IVT_FIRST, istate);
 
+	if (CPU)
+		CPU->current_istate = prev_istate;
+
 #ifdef CONFIG_UDEBUG
 	if (THREAD)
 		THREAD->udebug.uspace_state = NULL;
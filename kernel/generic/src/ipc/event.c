@@ -35,6 +35,8 @@
  */
 
 #include <assert.h>
+#include <adt/list.h>
+#include <cap/cap.h>
 #include <ipc/event.h>
 #include <mm/slab.h>
 #include <typedefs.h>
@@ -42,6 +44,7 @@
 #include <console/console.h>
 #include <proc/task.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <arch.h>
 
 /** The events array. */
@@ -50,13 +53,40 @@ static event_t events[EVENT_END];
 static void event_initialize(event_t *event)
 {
 	spinlock_initialize(&event->lock, "event.lock");
-	event->answerbox = NULL;
-	event->counter = 0;
-	event->imethod = 0;
-	event->masked = false;
+	list_initialize(&event->subscribers);
 	event->unmask_callback = NULL;
 }
 
+/** Find the subscription of an answerbox to an event.
+ *
+ * The event lock must be held.
+ *
+ * @return Subscriber structure or NULL if the answerbox is not subscribed.
+ */
+static event_sub_t *event_find_sub(event_t *event, answerbox_t *answerbox)
+{
+	list_foreach(event->subscribers, link, event_sub_t, sub) {
+		if (sub->answerbox == answerbox)
+			return sub;
+	}
+
+	return NULL;
+}
+
+/** Remove a subscriber from an event and free it.
+ *
+ * The event lock must be held.
+ */
+static void event_sub_destroy(event_sub_t *sub)
+{
+	list_remove(&sub->link);
+
+	if (sub->pending != NULL)
+		kobject_put_deferred(sub->pending->kobject);
+
+	free(sub);
+}
+
 static event_t *evno2event(int evno, task_t *task)
 {
 	assert(evno < EVENT_TASK_END);
@@ -93,17 +123,19 @@ void event_task_init(task_t *task)
  */
 void event_cleanup_answerbox(answerbox_t *answerbox)
 {
-	for (unsigned int i = 0; i < EVENT_END; i++) {
-		spinlock_lock(&events[i].lock);
-
-		if (events[i].answerbox == answerbox) {
-			events[i].answerbox = NULL;
-			events[i].counter = 0;
-			events[i].imethod = 0;
-			events[i].masked = false;
-		}
+	unsigned int limit = (answerbox->task != NULL) ?
+	    (unsigned int) EVENT_TASK_END : (unsigned int) EVENT_END;
+
+	for (unsigned int i = 0; i < limit; i++) {
+		event_t *event = evno2event(i, answerbox->task);
+
+		spinlock_lock(&event->lock);
 
-		spinlock_unlock(&events[i].lock);
+		event_sub_t *sub = event_find_sub(event, answerbox);
+		if (sub != NULL)
+			event_sub_destroy(sub);
+
+		spinlock_unlock(&event->lock);
 	}
 }
 
@@ -137,53 +169,119 @@ void event_task_set_unmask_callback(task_t *task, event_task_type_t evno,
 	_event_set_unmask_callback(evno2event(evno, task), callback);
 }
 
+/** Try to coalesce a notification into the subscriber's pending call.
+ *
+ * If the last notification queued for the subscriber still sits
+ * undelivered in the answerbox and carries identical arguments, merely
+ * advance the sequence counter passed in the notification label instead
+ * of queueing a duplicate. The receiver can detect the multiplicity
+ * from the gap in the sequence numbers.
+ *
+ * The event lock must be held.
+ *
+ * @return True if the notification was absorbed by the pending call.
+ */
+static bool event_coalesce(event_sub_t *sub, sysarg_t a1, sysarg_t a2,
+    sysarg_t a3, sysarg_t a4, sysarg_t a5)
+{
+	bool coalesced = false;
+
+	if (sub->pending == NULL)
+		return false;
+
+	irq_spinlock_lock(&sub->answerbox->irq_lock, true);
+
+	/*
+	 * As long as the call is still linked in irq_notifs, it cannot
+	 * be dequeued and its payload may be safely updated under
+	 * irq_lock.
+	 */
+	if (link_in_use(&sub->pending->ab_link) &&
+	    (ipc_get_arg1(&sub->pending->data) == a1) &&
+	    (ipc_get_arg2(&sub->pending->data) == a2) &&
+	    (ipc_get_arg3(&sub->pending->data) == a3) &&
+	    (ipc_get_arg4(&sub->pending->data) == a4) &&
+	    (ipc_get_arg5(&sub->pending->data) == a5)) {
+		sub->pending->priv = ++sub->counter;
+		coalesced = true;
+	}
+
+	irq_spinlock_unlock(&sub->answerbox->irq_lock, true);
+
+	return coalesced;
+}
+
 static errno_t event_enqueue(event_t *event, bool mask, sysarg_t a1, sysarg_t a2,
     sysarg_t a3, sysarg_t a4, sysarg_t a5)
 {
-	errno_t res;
+	bool delivered = false;
+	bool nomem = false;
+	bool masked = false;
 
 	spinlock_lock(&event->lock);
 
-	if (event->answerbox != NULL) {
-		if (!event->masked) {
-			call_t *call = ipc_call_alloc();
-
-			if (call) {
-				call->flags |= IPC_CALL_NOTIF;
-				call->priv = ++event->counter;
-
-				ipc_set_imethod(&call->data, event->imethod);
-				ipc_set_arg1(&call->data, a1);
-				ipc_set_arg2(&call->data, a2);
-				ipc_set_arg3(&call->data, a3);
-				ipc_set_arg4(&call->data, a4);
-				ipc_set_arg5(&call->data, a5);
-
-				call->data.task_id = TASK ? TASK->taskid : 0;
-
-				irq_spinlock_lock(&event->answerbox->irq_lock,
-				    true);
-				list_append(&call->ab_link,
-				    &event->answerbox->irq_notifs);
-				irq_spinlock_unlock(&event->answerbox->irq_lock,
-				    true);
-
-				waitq_wakeup(&event->answerbox->wq,
-				    WAKEUP_FIRST);
-
-				if (mask)
-					event->masked = true;
-
-				res = EOK;
-			} else
-				res = ENOMEM;
-		} else
-			res = EBUSY;
-	} else
-		res = ENOENT;
+	list_foreach(event->subscribers, link, event_sub_t, sub) {
+		if (sub->masked) {
+			masked = true;
+			continue;
+		}
+
+		if (event_coalesce(sub, a1, a2, a3, a4, a5)) {
+			if (mask)
+				sub->masked = true;
+
+			delivered = true;
+			continue;
+		}
+
+		call_t *call = ipc_call_alloc();
+		if (!call) {
+			nomem = true;
+			continue;
+		}
+
+		call->flags |= IPC_CALL_NOTIF;
+		call->priv = ++sub->counter;
+
+		ipc_set_imethod(&call->data, sub->imethod);
+		ipc_set_arg1(&call->data, a1);
+		ipc_set_arg2(&call->data, a2);
+		ipc_set_arg3(&call->data, a3);
+		ipc_set_arg4(&call->data, a4);
+		ipc_set_arg5(&call->data, a5);
+
+		call->data.task_id = TASK ? TASK->taskid : 0;
+
+		/* Remember the call for coalescing of later duplicates. */
+		if (sub->pending != NULL)
+			kobject_put_deferred(sub->pending->kobject);
+		kobject_add_ref(call->kobject);
+		sub->pending = call;
+
+		irq_spinlock_lock(&sub->answerbox->irq_lock, true);
+		list_append(&call->ab_link, &sub->answerbox->irq_notifs);
+		irq_spinlock_unlock(&sub->answerbox->irq_lock, true);
+
+		waitq_wakeup(&sub->answerbox->wq, WAKEUP_FIRST);
+
+		if (mask)
+			sub->masked = true;
+
+		delivered = true;
+	}
 
 	spinlock_unlock(&event->lock);
-	return res;
+
+	if (delivered)
+		return EOK;
+
+	if (nomem)
+		return ENOMEM;
+
+	if (masked)
+		return EBUSY;
+
+	return ENOENT;
 }
 
 /** Send kernel notification event
@@ -197,10 +295,11 @@ static errno_t event_enqueue(event_t *event, bool mask, sysarg_t a1, sysarg_t a2
  * @param a4   Fourth argument.
  * @param a5   Fifth argument.
  *
- * @return EOK if notification was successfully sent.
+ * @return EOK if the notification was sent to (or coalesced for) at
+ *         least one subscriber.
  * @return ENOMEM if the notification IPC message failed to allocate.
- * @return EBUSY if the notifications of the given type are
- *         currently masked.
+ * @return EBUSY if all subscribers of the given event type have the
+ *         notifications currently masked.
  * @return ENOENT if the notifications of the given type are
  *         currently not subscribed.
  *
@@ -225,10 +324,11 @@ errno_t event_notify(event_type_t evno, bool mask, sysarg_t a1, sysarg_t a2,
  * @param a4   Fourth argument.
  * @param a5   Fifth argument.
  *
- * @return EOK if notification was successfully sent.
+ * @return EOK if the notification was sent to (or coalesced for) at
+ *         least one subscriber.
  * @return ENOMEM if the notification IPC message failed to allocate.
- * @return EBUSY if the notifications of the given type are
- *         currently masked.
+ * @return EBUSY if all subscribers of the given event type have the
+ *         notifications currently masked.
  * @return ENOENT if the notifications of the given type are
  *         currently not subscribed.
  *
@@ -250,28 +350,40 @@ errno_t event_task_notify(task_t *task, event_task_type_t evno, bool mask,
  * @param answerbox Answerbox to send the notifications to.
  *
  * @return EOK if the subscription was successful.
- * @return EEXIST if the notifications of the given type are
- *         already subscribed.
+ * @return ENOMEM if the subscriber structure failed to allocate.
+ * @return EEXIST if the answerbox is already subscribed to
+ *         notifications of the given type.
  *
  */
 static errno_t event_subscribe(event_t *event, sysarg_t imethod,
     answerbox_t *answerbox)
 {
+	event_sub_t *sub = (event_sub_t *) malloc(sizeof(event_sub_t));
+	if (sub == NULL)
+		return ENOMEM;
+
 	errno_t res;
 
 	spinlock_lock(&event->lock);
 
-	if (event->answerbox == NULL) {
-		event->answerbox = answerbox;
-		event->imethod = imethod;
-		event->counter = 0;
-		event->masked = false;
+	if (event_find_sub(event, answerbox) == NULL) {
+		link_initialize(&sub->link);
+		sub->answerbox = answerbox;
+		sub->imethod = imethod;
+		sub->counter = 0;
+		sub->masked = false;
+		sub->pending = NULL;
+
+		list_append(&sub->link, &event->subscribers);
 		res = EOK;
 	} else
 		res = EEXIST;
 
 	spinlock_unlock(&event->lock);
 
+	if (res != EOK)
+		free(sub);
+
 	return res;
 }
 
@@ -280,9 +392,9 @@ static errno_t event_subscribe(event_t *event, sysarg_t imethod,
  * @param evno      Event type.
  * @param answerbox Answerbox used to send the notifications to.
  *
- * @return EOK if the subscription was successful.
- * @return EEXIST if the notifications of the given type are
- *         already subscribed.
+ * @return EOK if the unsubscription was successful.
+ * @return ENOENT if the answerbox is not subscribed to
+ *         notifications of the given type.
  *
  */
 static errno_t event_unsubscribe(event_t *event, answerbox_t *answerbox)
@@ -291,11 +403,9 @@ static errno_t event_unsubscribe(event_t *event, answerbox_t *answerbox)
 
 	spinlock_lock(&event->lock);
 
-	if (event->answerbox == answerbox) {
-		event->answerbox = NULL;
-		event->counter = 0;
-		event->imethod = 0;
-		event->masked = false;
+	event_sub_t *sub = event_find_sub(event, answerbox);
+	if (sub != NULL) {
+		event_sub_destroy(sub);
 		res = EOK;
 	} else
 		res = ENOENT;
@@ -307,13 +417,18 @@ static errno_t event_unsubscribe(event_t *event, answerbox_t *answerbox)
 
 /** Unmask event notifications
  *
- * @param evno Event type to unmask.
+ * @param evno      Event type to unmask.
+ * @param answerbox Answerbox of the unmasking subscriber.
  *
  */
-static void event_unmask(event_t *event)
+static void event_unmask(event_t *event, answerbox_t *answerbox)
 {
 	spinlock_lock(&event->lock);
-	event->masked = false;
+
+	event_sub_t *sub = event_find_sub(event, answerbox);
+	if (sub != NULL)
+		sub->masked = false;
+
 	event_callback_t callback = event->unmask_callback;
 	spinlock_unlock(&event->lock);
 
@@ -333,6 +448,7 @@ static void event_unmask(event_t *event)
  *
  * @return EOK on success.
  * @return ELIMIT on unknown event type.
+ * @return ENOMEM if the subscriber structure failed to allocate.
  * @return EEXIST if the notifications of the given type are
  *         already subscribed.
  *
@@ -382,7 +498,7 @@ sys_errno_t sys_ipc_event_unmask(sysarg_t evno)
 	if (evno >= EVENT_TASK_END)
 		return ELIMIT;
 
-	event_unmask(evno2event(evno, TASK));
+	event_unmask(evno2event(evno, TASK), &TASK->answerbox);
 
 	return EOK;
 }
@@ -51,6 +51,7 @@
 #include <ipc/sysipc_priv.h>
 #include <errno.h>
 #include <mm/slab.h>
+#include <mm/frame.h>
 #include <arch.h>
 #include <proc/task.h>
 #include <mem.h>
@@ -94,6 +95,11 @@ static void call_destroy(void *arg)
 
 	if (call->buffer)
 		free(call->buffer);
+	if (call->lent_frames) {
+		for (size_t i = 0; i < call->lent_count; i++)
+			frame_free_noreserve(call->lent_frames[i], 1);
+		free(call->lent_frames);
+	}
 	if (call->caller_phone)
 		kobject_put(call->caller_phone->kobject);
 	slab_free(call_cache, call);
@@ -144,9 +150,9 @@ void ipc_answerbox_init(answerbox_t *box, task_t *task)
 	irq_spinlock_initialize(&box->irq_lock, "ipc.box.irqlock");
 	waitq_initialize(&box->wq);
 	list_initialize(&box->connected_phones);
-	list_initialize(&box->calls);
+	mpsc_queue_initialize(&box->calls);
 	list_initialize(&box->dispatched_calls);
-	list_initialize(&box->answers);
+	mpsc_queue_initialize(&box->answers);
 	list_initialize(&box->irq_notifs);
 	atomic_store(&box->active_calls, 0);
 	box->task = task;
@@ -278,11 +284,10 @@ errno_t ipc_call_sync(phone_t *phone, call_t *request)
 
 /** Answer a message which was not dispatched and is not listed in any queue.
  *
- * @param call       Call structure to be answered.
- * @param selflocked If true, then TASK->answebox is locked.
+ * @param call Call structure to be answered.
  *
  */
-void _ipc_answer_free_call(call_t *call, bool selflocked)
+void _ipc_answer_free_call(call_t *call)
 {
 	/* Count sent answer */
 	irq_spinlock_lock(&TASK->lock, true);
@@ -311,19 +316,12 @@ void _ipc_answer_free_call(call_t *call, bool selflocked)
 
 	answerbox_t *callerbox = call->callerbox ? call->callerbox :
 	    &call->sender->answerbox;
-	bool do_lock = ((!selflocked) || (callerbox != &TASK->answerbox));
 
 	call->flags |= IPC_CALL_ANSWERED;
 
 	call->data.task_id = TASK->taskid;
 
-	if (do_lock)
-		irq_spinlock_lock(&callerbox->lock, true);
-
-	list_append(&call->ab_link, &callerbox->answers);
-
-	if (do_lock)
-		irq_spinlock_unlock(&callerbox->lock, true);
+	mpsc_queue_push(&callerbox->answers, &call->ab_qlink);
 
 	waitq_wakeup(&callerbox->wq, WAKEUP_FIRST);
 }
@@ -342,7 +340,7 @@ void ipc_answer(answerbox_t *box, call_t *call)
 	irq_spinlock_unlock(&box->lock, true);
 
 	/* Send back answer */
-	_ipc_answer_free_call(call, false);
+	_ipc_answer_free_call(call);
 }
 
 static void _ipc_call_actions_internal(phone_t *phone, call_t *call,
@@ -387,7 +385,7 @@ void ipc_backsend_err(phone_t *phone, call_t *call, errno_t err)
 {
 	_ipc_call_actions_internal(phone, call, false);
 	ipc_set_retval(&call->data, err);
-	_ipc_answer_free_call(call, false);
+	_ipc_answer_free_call(call);
 }
 
 /** Unsafe unchecking version of ipc_call.
@@ -411,9 +409,7 @@ static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
 	if (!(call->flags & IPC_CALL_FORWARDED))
 		_ipc_call_actions_internal(phone, call, preforget);
 
-	irq_spinlock_lock(&box->lock, true);
-	list_append(&call->ab_link, &box->calls);
-	irq_spinlock_unlock(&box->lock, true);
+	mpsc_queue_push(&box->calls, &call->ab_qlink);
 
 	waitq_wakeup(&box->wq, WAKEUP_FIRST);
 }
@@ -549,6 +545,7 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
     call_t **call)
 {
 	call_t *request;
+	mpsc_link_t *link;
 	uint64_t irq_cnt = 0;
 	uint64_t answer_cnt = 0;
 	uint64_t call_cnt = 0;
@@ -570,25 +567,21 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 		list_remove(&request->ab_link);
 
 		irq_spinlock_unlock(&box->irq_lock, false);
-	} else if (!list_empty(&box->answers)) {
+	} else if ((link = mpsc_queue_pop(&box->answers)) != NULL) {
 		/* Count received answer */
 		answer_cnt++;
 
 		/* Handle asynchronous answers */
-		request = list_get_instance(list_first(&box->answers),
-		    call_t, ab_link);
-		list_remove(&request->ab_link);
+		request = mpsc_queue_get_instance(link, call_t, ab_qlink);
 		atomic_dec(&request->caller_phone->active_calls);
 		atomic_dec(&box->active_calls);
 		kobject_put(request->caller_phone->kobject);
-	} else if (!list_empty(&box->calls)) {
+	} else if ((link = mpsc_queue_pop(&box->calls)) != NULL) {
 		/* Count received call */
 		call_cnt++;
 
 		/* Handle requests */
-		request = list_get_instance(list_first(&box->calls),
-		    call_t, ab_link);
-		list_remove(&request->ab_link);
+		request = mpsc_queue_get_instance(link, call_t, ab_qlink);
 
 		/* Append request to dispatch queue */
 		list_append(&request->ab_link, &box->dispatched_calls);
@@ -629,13 +622,37 @@ void ipc_cleanup_call_list(answerbox_t *box, list_t *lst)
 
 		irq_spinlock_unlock(&box->lock, true);
 
-		if (lst == &box->calls)
-			SYSIPC_OP(request_process, call, box);
+		ipc_data_t old = call->data;
+		ipc_set_retval(&call->data, EHANGUP);
+		answer_preprocess(call, &old);
+		_ipc_answer_free_call(call);
+
+		irq_spinlock_lock(&box->lock, true);
+	}
+	irq_spinlock_unlock(&box->lock, true);
+}
+
+/** Answer all undispatched calls from a call queue with EHANGUP answer.
+ *
+ * @param box   Answerbox with the queue.
+ * @param queue Queue of received calls to be cleaned up.
+ */
+void ipc_cleanup_call_queue(answerbox_t *box, mpsc_queue_t *queue)
+{
+	mpsc_link_t *link;
+
+	irq_spinlock_lock(&box->lock, true);
+	while ((link = mpsc_queue_pop(queue)) != NULL) {
+		call_t *call = mpsc_queue_get_instance(link, call_t, ab_qlink);
+
+		irq_spinlock_unlock(&box->lock, true);
+
+		SYSIPC_OP(request_process, call, box);
 
 		ipc_data_t old = call->data;
 		ipc_set_retval(&call->data, EHANGUP);
 		answer_preprocess(call, &old);
-		_ipc_answer_free_call(call, true);
+		_ipc_answer_free_call(call);
 
 		irq_spinlock_lock(&box->lock, true);
 	}
@@ -779,7 +796,7 @@ static bool phone_cap_cleanup_cb(cap_t *cap, void *arg)
 	ipc_phone_hangup(cap->kobject->phone);
 	kobject_t *kobj = cap_unpublish(cap->task, cap->handle,
 	    KOBJECT_TYPE_PHONE);
-	kobject_put(kobj);
+	kobject_put_deferred(kobj);
 	cap_free(cap->task, cap->handle);
 	return true;
 }
@@ -823,7 +840,7 @@ static bool call_cap_cleanup_cb(cap_t *cap, void *arg)
 	 */
 	kobject_t *kobj = cap_unpublish(cap->task, cap->handle,
 	    KOBJECT_TYPE_CALL);
-	kobject_put(kobj);
+	kobject_put_deferred(kobj);
 	cap_free(cap->task, cap->handle);
 	return true;
 }
@@ -870,7 +887,7 @@ void ipc_cleanup(void)
 	    NULL);
 
 	/* Answer all messages in 'calls' and 'dispatched_calls' queues */
-	ipc_cleanup_call_list(&TASK->answerbox, &TASK->answerbox.calls);
+	ipc_cleanup_call_queue(&TASK->answerbox, &TASK->answerbox.calls);
 	ipc_cleanup_call_list(&TASK->answerbox,
 	    &TASK->answerbox.dispatched_calls);
 
@@ -893,34 +910,48 @@ void ipc_init(void)
 	    0, NULL, NULL, 0);
 }
 
-static void ipc_print_call_list(list_t *list)
+static void ipc_print_call(call_t *call)
 {
-	list_foreach(*list, ab_link, call_t, call) {
 #ifdef __32_BITS__
-		printf("%10p ", call);
+	printf("%10p ", call);
 #endif
 
 #ifdef __64_BITS__
-		printf("%18p ", call);
+	printf("%18p ", call);
 #endif
 
-		spinlock_lock(&call->forget_lock);
+	spinlock_lock(&call->forget_lock);
 
-		printf("%-8" PRIun " %-6" PRIun " %-6" PRIun " %-6" PRIun
-		    " %-6" PRIun " %-6" PRIun " %-7x",
-		    ipc_get_imethod(&call->data), ipc_get_arg1(&call->data),
-		    ipc_get_arg2(&call->data), ipc_get_arg3(&call->data),
-		    ipc_get_arg4(&call->data), ipc_get_arg5(&call->data),
-		    call->flags);
+	printf("%-8" PRIun " %-6" PRIun " %-6" PRIun " %-6" PRIun
+	    " %-6" PRIun " %-6" PRIun " %-7x",
+	    ipc_get_imethod(&call->data), ipc_get_arg1(&call->data),
+	    ipc_get_arg2(&call->data), ipc_get_arg3(&call->data),
+	    ipc_get_arg4(&call->data), ipc_get_arg5(&call->data),
+	    call->flags);
 
-		if (call->forget) {
-			printf(" ? (call forgotten)\n");
-		} else {
-			printf(" %" PRIu64 " (%s)\n",
-			    call->sender->taskid, call->sender->name);
-		}
+	if (call->forget) {
+		printf(" ? (call forgotten)\n");
+	} else {
+		printf(" %" PRIu64 " (%s)\n",
+		    call->sender->taskid, call->sender->name);
+	}
 
-		spinlock_unlock(&call->forget_lock);
+	spinlock_unlock(&call->forget_lock);
+}
+
+static void ipc_print_call_list(list_t *list)
+{
+	list_foreach(*list, ab_link, call_t, call) {
+		ipc_print_call(call);
+	}
+}
+
+static void ipc_print_call_queue(mpsc_queue_t *queue)
+{
+	for (mpsc_link_t *link = mpsc_queue_first(queue); link != NULL;
+	    link = mpsc_queue_next(queue, link)) {
+		ipc_print_call(mpsc_queue_get_instance(link, call_t,
+		    ab_qlink));
 	}
 }
 
@@ -997,11 +1028,11 @@ void ipc_print_task(task_id_t taskid)
 #endif
 
 	printf(" --- incomming calls ---\n");
-	ipc_print_call_list(&task->answerbox.calls);
+	ipc_print_call_queue(&task->answerbox.calls);
 	printf(" --- dispatched calls ---\n");
 	ipc_print_call_list(&task->answerbox.dispatched_calls);
 	printf(" --- incoming answers ---\n");
-	ipc_print_call_list(&task->answerbox.answers);
+	ipc_print_call_queue(&task->answerbox.answers);
 
 	irq_spinlock_unlock(&task->answerbox.lock, false);
 	irq_spinlock_unlock(&task->lock, true);
@@ -50,10 +50,19 @@
  * - ARG5: payload modified by a 'top-half' handler (scratch[5])
  * - request_label: interrupt counter (may be needed to assure correct order
  *                  in multithreaded drivers)
+ *
+ * The notification call itself is not allocated and posted in the hard
+ * interrupt context. The top half only executes the IRQ code to silence
+ * the device and records the notification in a CPU-local ring, which is
+ * drained by the CPU's kirqbh bottom-half thread. Sustained interrupt
+ * storms thus fill the ring and get dropped instead of starving the
+ * scheduler.
  */
 
 #include <arch.h>
 #include <assert.h>
+#include <config.h>
+#include <cpu.h>
 #include <mm/slab.h>
 #include <mm/page.h>
 #include <mm/km.h>
@@ -61,12 +70,54 @@
 #include <ddi/irq.h>
 #include <ipc/ipc.h>
 #include <ipc/irq.h>
+#include <log.h>
+#include <panic.h>
+#include <proc/thread.h>
+#include <synch/rcu.h>
 #include <syscall/copy.h>
 #include <console/console.h>
 #include <macros.h>
 #include <cap/cap.h>
 #include <stdlib.h>
 
+/** Number of notifications a CPU-local ring can hold before dropping. */
+#define IRQ_DEFER_RING_SIZE  64
+
+/** One notification recorded by the top half for deferred delivery. */
+typedef struct {
+	/** IRQ structure the notification belongs to. */
+	irq_t *irq;
+	/** Reference pinning the IRQ structure, NULL for kernel IRQs. */
+	kobject_t *kobj;
+	/** Value of the interrupt counter at the time of the interrupt. */
+	size_t counter;
+	/** Interface and method of the notification. */
+	sysarg_t imethod;
+	/** Payload arguments of the notification. */
+	sysarg_t args[IPC_CALL_LEN - 1];
+} irq_defer_t;
+
+/** Per-CPU state of the deferred notification machinery.
+ *
+ * The ring is CPU-local: it is filled from the interrupt context and
+ * drained by the CPU's wired bottom-half thread with interrupts
+ * disabled, so no lock is needed.
+ */
+typedef struct {
+	/** Wait queue the bottom-half thread sleeps on. */
+	waitq_t wq;
+	/** Index of the oldest undelivered notification. */
+	size_t head;
+	/** Index past the youngest recorded notification. */
+	size_t tail;
+	/** Number of notifications dropped due to a full ring. */
+	uint64_t dropped;
+	/** Recorded notifications. */
+	irq_defer_t ring[IRQ_DEFER_RING_SIZE];
+} irq_defer_cpu_t;
+
+static irq_defer_cpu_t *irq_defer_cpus = NULL;
+
 static void ranges_unmap(irq_pio_range_t *ranges, size_t rangecount)
 {
 	for (size_t i = 0; i < rangecount; i++) {
@@ -166,7 +217,7 @@ static errno_t ranges_map_and_apply(irq_pio_range_t *ranges, size_t rangecount,
  * Check the top-half IRQ code for invalid or unsafe constructs.
  *
  */
-static errno_t code_check(irq_cmd_t *cmds, size_t cmdcount)
+errno_t ipc_irq_code_check(irq_cmd_t *cmds, size_t cmdcount)
 {
 	for (size_t i = 0; i < cmdcount; i++) {
 		/*
@@ -200,6 +251,52 @@ static errno_t code_check(irq_cmd_t *cmds, size_t cmdcount)
 	return EOK;
 }
 
+/** Dispatch table of ipc_irq_top_half_claim(), filled on the first use. */
+static const void *const *irq_op_targets = NULL;
+
+/** Translate checked top-half IRQ code to direct-threaded form.
+ *
+ * Resolves each command to its dispatch target within
+ * ipc_irq_top_half_claim() and pre-decodes the operands. The program
+ * is terminated with two explicit decline ops, so that both running
+ * off the end and a predicate jumping just beyond the last command
+ * keep the semantics of the former interpreter loop. The second
+ * terminator is needed because the executor advances past the jump
+ * destination before dispatching: a predicate that jumps just beyond
+ * the last command lands one op past the first terminator.
+ *
+ * Must only be called on code that passed ipc_irq_code_check().
+ *
+ * @param code Top-half IRQ code to translate.
+ *
+ * @return Translated program or NULL on allocation failure.
+ *
+ */
+irq_op_t *ipc_irq_code_compile(irq_code_t *code)
+{
+	if (irq_op_targets == NULL) {
+		/* Make ipc_irq_top_half_claim() export its labels. */
+		(void) ipc_irq_top_half_claim(NULL);
+	}
+
+	irq_op_t *ops = malloc(sizeof(irq_op_t) * (code->cmdcount + 2));
+	if (!ops)
+		return NULL;
+
+	for (size_t i = 0; i < code->cmdcount; i++) {
+		ops[i].target = irq_op_targets[code->cmds[i].cmd];
+		ops[i].addr = code->cmds[i].addr;
+		ops[i].value = code->cmds[i].value;
+		ops[i].srcarg = code->cmds[i].srcarg;
+		ops[i].dstarg = code->cmds[i].dstarg;
+	}
+
+	ops[code->cmdcount].target = irq_op_targets[CMD_DECLINE];
+	ops[code->cmdcount + 1].target = irq_op_targets[CMD_DECLINE];
+
+	return ops;
+}
+
 /** Free the top-half IRQ code.
  *
  * @param code Pointer to the top-half IRQ code.
@@ -254,7 +351,7 @@ static irq_code_t *code_from_uspace(uspace_ptr_irq_code_t ucode)
 	if (rc != EOK)
 		goto error;
 
-	rc = code_check(cmds, code->cmdcount);
+	rc = ipc_irq_code_check(cmds, code->cmdcount);
 	if (rc != EOK)
 		goto error;
 
@@ -281,17 +378,35 @@ error:
 
 static void irq_hash_out(irq_t *irq)
 {
-	irq_spinlock_lock(&irq_uspace_hash_table_lock, true);
+	irq_spinlock_lock(&irq_uspace_lists_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
 
-	if (irq->notif_cfg.hashed_in) {
-		/* Remove the IRQ from the uspace IRQ hash table. */
-		hash_table_remove_item(&irq_uspace_hash_table, &irq->link);
+	bool hashed_in = irq->notif_cfg.hashed_in;
+	if (hashed_in) {
+		/* Remove the IRQ from its uspace dispatch list. */
+		rcu_list_remove(&irq->link);
 		irq->notif_cfg.hashed_in = false;
 	}
 
+	/*
+	 * Make any already recorded but not yet delivered notifications
+	 * drop dead instead of touching the answerbox, which may be gone
+	 * by the time they are processed.
+	 */
+	irq->notif_cfg.notify = false;
+
 	irq_spinlock_unlock(&irq->lock, false);
-	irq_spinlock_unlock(&irq_uspace_hash_table_lock, true);
+	irq_spinlock_unlock(&irq_uspace_lists_lock, true);
+
+	if (hashed_in) {
+		/*
+		 * The dispatch path traverses the lists as an RCU reader.
+		 * Wait until no CPU can be looking at the structure
+		 * anymore before it is handed back to the caller for
+		 * destruction.
+		 */
+		synchronize_rcu();
+	}
 }
 
 static void irq_destroy(void *arg)
@@ -302,6 +417,7 @@ static void irq_destroy(void *arg)
 
 	/* Free up the IRQ code and associated structures. */
 	code_free(irq->notif_cfg.code);
+	free(irq->notif_cfg.ops);
 	slab_free(irq_cache, irq);
 }
 
@@ -328,12 +444,21 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 		return ELIMIT;
 
 	irq_code_t *code;
+	irq_op_t *ops;
 	if (ucode) {
 		code = code_from_uspace(ucode);
 		if (!code)
 			return EBADMEM;
-	} else
+
+		ops = ipc_irq_code_compile(code);
+		if (!ops) {
+			code_free(code);
+			return ENOMEM;
+		}
+	} else {
 		code = NULL;
+		ops = NULL;
+	}
 
 	/*
 	 * Allocate and populate the IRQ kernel object.
@@ -370,21 +495,29 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 	irq->notif_cfg.answerbox = box;
 	irq->notif_cfg.imethod = imethod;
 	irq->notif_cfg.code = code;
+	irq->notif_cfg.ops = ops;
 	irq->notif_cfg.counter = 0;
 
 	/*
-	 * Insert the IRQ structure into the uspace IRQ hash table.
+	 * The kobject must be associated before the IRQ is hashed in, so
+	 * that deferred notifications can reference it as soon as the
+	 * first interrupt comes.
+	 */
+	kobject_initialize(kobject, KOBJECT_TYPE_IRQ, irq);
+	irq->kobject = kobject;
+
+	/*
+	 * Insert the IRQ structure into its uspace dispatch list.
 	 */
-	irq_spinlock_lock(&irq_uspace_hash_table_lock, true);
+	irq_spinlock_lock(&irq_uspace_lists_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
 
 	irq->notif_cfg.hashed_in = true;
-	hash_table_insert(&irq_uspace_hash_table, &irq->link);
+	rcu_list_append(&irq->link, &irq_uspace_lists[inr]);
 
 	irq_spinlock_unlock(&irq->lock, false);
-	irq_spinlock_unlock(&irq_uspace_hash_table_lock, true);
+	irq_spinlock_unlock(&irq_uspace_lists_lock, true);
 
-	kobject_initialize(kobject, KOBJECT_TYPE_IRQ, irq);
 	cap_publish(TASK, handle, kobject);
 
 	return EOK;
@@ -431,6 +564,157 @@ static void send_call(irq_t *irq, call_t *call)
 	waitq_wakeup(&irq->notif_cfg.answerbox->wq, WAKEUP_FIRST);
 }
 
+/** Record a notification for deferred delivery by the bottom half.
+ *
+ * Assume irq->lock is locked and interrupts disabled. If the CPU-local
+ * ring is full, the notification is dropped, which is no worse than the
+ * former behavior of dropping it when the call could not be allocated.
+ *
+ * @param irq     IRQ structure referencing the target answerbox.
+ * @param imethod Interface and method of the notification.
+ * @param args    IPC_CALL_LEN - 1 payload arguments.
+ *
+ */
+static void irq_defer_enqueue(irq_t *irq, sysarg_t imethod,
+    const sysarg_t *args)
+{
+	assert(irq_defer_cpus);
+	assert(interrupts_disabled());
+
+	irq_defer_cpu_t *dc = &irq_defer_cpus[CPU->id];
+
+	if (dc->tail - dc->head == IRQ_DEFER_RING_SIZE) {
+		dc->dropped++;
+		return;
+	}
+
+	irq_defer_t *defer = &dc->ring[dc->tail % IRQ_DEFER_RING_SIZE];
+	defer->irq = irq;
+	defer->kobj = irq->kobject;
+	if (defer->kobj)
+		kobject_add_ref(defer->kobj);
+
+	/* Put a counter to the message */
+	defer->counter = ++irq->notif_cfg.counter;
+
+	defer->imethod = imethod;
+	for (size_t i = 0; i < IPC_CALL_LEN - 1; i++)
+		defer->args[i] = args[i];
+
+	dc->tail++;
+
+	waitq_wakeup(&dc->wq, WAKEUP_FIRST);
+}
+
+/** Deliver one deferred notification.
+ *
+ * Runs in the context of the bottom-half thread. The subscription is
+ * re-checked under irq->lock, so that notifications recorded before an
+ * unsubscription do not touch a possibly defunct answerbox.
+ *
+ * @param defer Notification to be delivered.
+ *
+ */
+static void irq_defer_deliver(irq_defer_t *defer)
+{
+	irq_t *irq = defer->irq;
+
+	irq_spinlock_lock(&irq->lock, true);
+
+	if ((irq->notif_cfg.notify) && (irq->notif_cfg.answerbox)) {
+		call_t *call = ipc_call_alloc();
+		if (call) {
+			call->flags |= IPC_CALL_NOTIF;
+			call->priv = defer->counter;
+
+			/* Set up args */
+			ipc_set_imethod(&call->data, defer->imethod);
+			ipc_set_arg1(&call->data, defer->args[0]);
+			ipc_set_arg2(&call->data, defer->args[1]);
+			ipc_set_arg3(&call->data, defer->args[2]);
+			ipc_set_arg4(&call->data, defer->args[3]);
+			ipc_set_arg5(&call->data, defer->args[4]);
+
+			send_call(irq, call);
+		}
+	}
+
+	irq_spinlock_unlock(&irq->lock, true);
+
+	if (defer->kobj)
+		kobject_put(defer->kobj);
+}
+
+/** IRQ notification bottom-half thread.
+ *
+ * There is one instance wired to each CPU, draining the CPU-local ring
+ * of notifications recorded by the top halves.
+ *
+ * @param arg Per-CPU state of the deferred notification machinery.
+ *
+ */
+static void kirqbh(void *arg)
+{
+	irq_defer_cpu_t *dc = (irq_defer_cpu_t *) arg;
+
+	/*
+	 * Detach kirqbh as nobody will call thread_join_timeout() on it.
+	 */
+	thread_detach(THREAD);
+
+	while (true) {
+		waitq_sleep(&dc->wq);
+
+		while (true) {
+			ipl_t ipl = interrupts_disable();
+
+			if (dc->head == dc->tail) {
+				interrupts_restore(ipl);
+				break;
+			}
+
+			irq_defer_t defer =
+			    dc->ring[dc->head % IRQ_DEFER_RING_SIZE];
+			dc->head++;
+
+			interrupts_restore(ipl);
+
+			irq_defer_deliver(&defer);
+		}
+	}
+}
+
+/** Start the per-CPU IRQ notification bottom halves.
+ *
+ * Called from kinit once all processors are up, before any userspace
+ * task gets a chance to subscribe for notifications.
+ *
+ */
+void ipc_irq_defer_init(void)
+{
+	irq_defer_cpus = malloc(sizeof(irq_defer_cpu_t) * config.cpu_count);
+	if (!irq_defer_cpus)
+		panic("Unable to allocate IRQ bottom halves.");
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		irq_defer_cpu_t *dc = &irq_defer_cpus[i];
+
+		waitq_initialize(&dc->wq);
+		dc->head = 0;
+		dc->tail = 0;
+		dc->dropped = 0;
+
+		thread_t *thread = thread_create(kirqbh, dc, TASK,
+		    THREAD_FLAG_UNCOUNTED, "kirqbh");
+		if (thread != NULL) {
+			thread_wire(thread, &cpus[i]);
+			thread_ready(thread);
+		} else
+			log(LF_OTHER, LVL_ERROR,
+			    "Unable to create kirqbh thread for cpu%u", i);
+	}
+}
+
 /** Apply the top-half IRQ code to find out whether to accept the IRQ or not.
  *
  * @param irq IRQ structure.
@@ -441,76 +725,118 @@ static void send_call(irq_t *irq, call_t *call)
  */
 irq_ownership_t ipc_irq_top_half_claim(irq_t *irq)
 {
-	irq_code_t *code = irq->notif_cfg.code;
+	/*
+	 * Dispatch table of the direct-threaded executor below. Unknown
+	 * commands (ipc_irq_code_check() only rejects values at or above
+	 * CMD_LAST) decline the interrupt, just like the default case
+	 * of the former switch.
+	 */
+	static const void *const targets[CMD_LAST] = {
+		[0] = &&cmd_decline,
+		[CMD_PIO_READ_8] = &&cmd_pio_read_8,
+		[CMD_PIO_READ_16] = &&cmd_pio_read_16,
+		[CMD_PIO_READ_32] = &&cmd_pio_read_32,
+		[CMD_PIO_WRITE_8] = &&cmd_pio_write_8,
+		[CMD_PIO_WRITE_16] = &&cmd_pio_write_16,
+		[CMD_PIO_WRITE_32] = &&cmd_pio_write_32,
+		[CMD_PIO_WRITE_A_8] = &&cmd_pio_write_a_8,
+		[CMD_PIO_WRITE_A_16] = &&cmd_pio_write_a_16,
+		[CMD_PIO_WRITE_A_32] = &&cmd_pio_write_a_32,
+		[CMD_LOAD] = &&cmd_load,
+		[CMD_AND] = &&cmd_and,
+		[CMD_PREDICATE] = &&cmd_predicate,
+		[CMD_ACCEPT] = &&cmd_accept,
+		[CMD_DECLINE] = &&cmd_decline
+	};
+
+	/* Let ipc_irq_code_compile() learn the dispatch targets. */
+	if (irq == NULL) {
+		irq_op_targets = targets;
+		return IRQ_DECLINE;
+	}
+
 	uint32_t *scratch = irq->notif_cfg.scratch;
 
 	if (!irq->notif_cfg.notify)
 		return IRQ_DECLINE;
 
-	if (!code)
+	const irq_op_t *op = irq->notif_cfg.ops;
+	if (!op)
 		return IRQ_DECLINE;
 
-	for (size_t i = 0; i < code->cmdcount; i++) {
-		uintptr_t srcarg = code->cmds[i].srcarg;
-		uintptr_t dstarg = code->cmds[i].dstarg;
-
-		switch (code->cmds[i].cmd) {
-		case CMD_PIO_READ_8:
-			scratch[dstarg] =
-			    pio_read_8((ioport8_t *) code->cmds[i].addr);
-			break;
-		case CMD_PIO_READ_16:
-			scratch[dstarg] =
-			    pio_read_16((ioport16_t *) code->cmds[i].addr);
-			break;
-		case CMD_PIO_READ_32:
-			scratch[dstarg] =
-			    pio_read_32((ioport32_t *) code->cmds[i].addr);
-			break;
-		case CMD_PIO_WRITE_8:
-			pio_write_8((ioport8_t *) code->cmds[i].addr,
-			    (uint8_t) code->cmds[i].value);
-			break;
-		case CMD_PIO_WRITE_16:
-			pio_write_16((ioport16_t *) code->cmds[i].addr,
-			    (uint16_t) code->cmds[i].value);
-			break;
-		case CMD_PIO_WRITE_32:
-			pio_write_32((ioport32_t *) code->cmds[i].addr,
-			    (uint32_t) code->cmds[i].value);
-			break;
-		case CMD_PIO_WRITE_A_8:
-			pio_write_8((ioport8_t *) code->cmds[i].addr,
-			    (uint8_t) scratch[srcarg]);
-			break;
-		case CMD_PIO_WRITE_A_16:
-			pio_write_16((ioport16_t *) code->cmds[i].addr,
-			    (uint16_t) scratch[srcarg]);
-			break;
-		case CMD_PIO_WRITE_A_32:
-			pio_write_32((ioport32_t *) code->cmds[i].addr,
-			    (uint32_t) scratch[srcarg]);
-			break;
-		case CMD_LOAD:
-			scratch[dstarg] = code->cmds[i].value;
-			break;
-		case CMD_AND:
-			scratch[dstarg] = scratch[srcarg] &
-			    code->cmds[i].value;
-			break;
-		case CMD_PREDICATE:
-			if (scratch[srcarg] == 0)
-				i += code->cmds[i].value;
+	goto *op->target;
+
+cmd_pio_read_8:
+	scratch[op->dstarg] = pio_read_8((ioport8_t *) op->addr);
+	op++;
+	goto *op->target;
+
+cmd_pio_read_16:
+	scratch[op->dstarg] = pio_read_16((ioport16_t *) op->addr);
+	op++;
+	goto *op->target;
+
+cmd_pio_read_32:
+	scratch[op->dstarg] = pio_read_32((ioport32_t *) op->addr);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_8:
+	pio_write_8((ioport8_t *) op->addr, (uint8_t) op->value);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_16:
+	pio_write_16((ioport16_t *) op->addr, (uint16_t) op->value);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_32:
+	pio_write_32((ioport32_t *) op->addr, (uint32_t) op->value);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_a_8:
+	pio_write_8((ioport8_t *) op->addr, (uint8_t) scratch[op->srcarg]);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_a_16:
+	pio_write_16((ioport16_t *) op->addr, (uint16_t) scratch[op->srcarg]);
+	op++;
+	goto *op->target;
+
+cmd_pio_write_a_32:
+	pio_write_32((ioport32_t *) op->addr, (uint32_t) scratch[op->srcarg]);
+	op++;
+	goto *op->target;
+
+cmd_load:
+	scratch[op->dstarg] = op->value;
+	op++;
+	goto *op->target;
+
+cmd_and:
+	scratch[op->dstarg] = scratch[op->srcarg] & op->value;
+	op++;
+	goto *op->target;
+
+cmd_predicate:
+	/*
+	 * ipc_irq_code_check() guarantees the displacement lands at most on the
+	 * first terminating decline op appended by ipc_irq_code_compile(). Since
+	 * the increment below moves one op further, a jump just beyond
+	 * the last command dispatches through the second terminator.
+	 */
+	if (scratch[op->srcarg] == 0)
+		op += op->value;
+	op++;
+	goto *op->target;
 
-			break;
-		case CMD_ACCEPT:
-			return IRQ_ACCEPT;
-		case CMD_DECLINE:
-		default:
-			return IRQ_DECLINE;
-		}
-	}
+cmd_accept:
+	return IRQ_ACCEPT;
 
+cmd_decline:
 	return IRQ_DECLINE;
 }
 
@@ -529,23 +855,15 @@ void ipc_irq_top_half_handler(irq_t *irq)
 	assert(irq_spinlock_locked(&irq->lock));
 
 	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call)
-			return;
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		/* Set up args */
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, irq->notif_cfg.scratch[1]);
-		ipc_set_arg2(&call->data, irq->notif_cfg.scratch[2]);
-		ipc_set_arg3(&call->data, irq->notif_cfg.scratch[3]);
-		ipc_set_arg4(&call->data, irq->notif_cfg.scratch[4]);
-		ipc_set_arg5(&call->data, irq->notif_cfg.scratch[5]);
-
-		send_call(irq, call);
+		sysarg_t args[IPC_CALL_LEN - 1] = {
+			irq->notif_cfg.scratch[1],
+			irq->notif_cfg.scratch[2],
+			irq->notif_cfg.scratch[3],
+			irq->notif_cfg.scratch[4],
+			irq->notif_cfg.scratch[5]
+		};
+
+		irq_defer_enqueue(irq, irq->notif_cfg.imethod, args);
 	}
 }
 
@@ -565,24 +883,9 @@ void ipc_irq_send_msg(irq_t *irq, sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	irq_spinlock_lock(&irq->lock, true);
 
 	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call) {
-			irq_spinlock_unlock(&irq->lock, true);
-			return;
-		}
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, a1);
-		ipc_set_arg2(&call->data, a2);
-		ipc_set_arg3(&call->data, a3);
-		ipc_set_arg4(&call->data, a4);
-		ipc_set_arg5(&call->data, a5);
+		sysarg_t args[IPC_CALL_LEN - 1] = { a1, a2, a3, a4, a5 };
 
-		send_call(irq, call);
+		irq_defer_enqueue(irq, irq->notif_cfg.imethod, args);
 	}
 
 	irq_spinlock_unlock(&irq->lock, true);
@@ -39,6 +39,147 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <align.h>
+#include <macros.h>
+#include <mm/as.h>
+#include <mm/page.h>
+#include <mm/frame.h>
+#include <mm/km.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_rt.h>
+#include <arch.h>
+
+/** Payload size from which the sender's frames are lent instead of copied. */
+#define DATA_LEND_LIMIT  PAGE_SIZE
+
+/** Lend the frames backing the payload instead of copying it.
+ *
+ * References the frames backing [src, src + size) in the sender's address
+ * space and records them in the call, so that the payload can be copied
+ * directly into the recipient's buffer at answer time, avoiding the
+ * intermediate kernel buffer. The frames are released in ipc_call_free()
+ * at the latest.
+ *
+ * Note that this gives the transfer page-lending semantics: modifications
+ * the sender makes to the payload between the send and the answer may be
+ * visible to the recipient.
+ *
+ * @param call Call structure carrying the transfer.
+ * @param src  Source address of the payload in the sender's address space.
+ * @param size Size of the payload.
+ *
+ * @return True on success, false if the copy path needs to be taken.
+ */
+static bool request_lend(call_t *call, uspace_addr_t src, size_t size)
+{
+	uintptr_t base = ALIGN_DOWN(src, PAGE_SIZE);
+	size_t offset = src - base;
+	size_t count = SIZE2FRAMES(offset + size);
+
+	uintptr_t *frames = malloc(count * sizeof(uintptr_t));
+	if (!frames)
+		return false;
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		uintptr_t page = base + P2SZ(i);
+		pte_t pte;
+		bool found;
+
+		page_table_lock(AS, true);
+		found = page_mapping_find(AS, page, false, &pte);
+
+		if ((!found) || (!PTE_PRESENT(&pte))) {
+			/*
+			 * Fault the page in by touching it and retry the
+			 * lookup.
+			 */
+			page_table_unlock(AS, true);
+
+			uint8_t dummy;
+			if (copy_from_uspace(&dummy, page,
+			    sizeof(dummy)) != EOK)
+				goto error;
+
+			page_table_lock(AS, true);
+			found = page_mapping_find(AS, page, false, &pte);
+			if ((!found) || (!PTE_PRESENT(&pte))) {
+				page_table_unlock(AS, true);
+				goto error;
+			}
+		}
+
+		frames[i] = PTE_GET_FRAME(&pte);
+
+		/*
+		 * Only frames managed by the frame allocator can be
+		 * referenced and later freed. A buffer in a physically
+		 * mapped area (e.g. device memory) is backed by non-zone
+		 * frames; take the copy path for it instead.
+		 */
+		if (find_zone(ADDR2PFN(frames[i]), 1, 0) == (size_t) -1) {
+			page_table_unlock(AS, true);
+			goto error;
+		}
+
+		frame_reference_add(ADDR2PFN(frames[i]));
+		page_table_unlock(AS, true);
+	}
+
+	call->lent_frames = frames;
+	call->lent_count = count;
+	call->lent_offset = offset;
+
+	return true;
+
+error:
+	while (i > 0)
+		frame_free_noreserve(frames[--i], 1);
+	free(frames);
+
+	return false;
+}
+
+/** Copy a lent payload to the recipient's buffer.
+ *
+ * @param answer Answer call structure carrying the lent frames.
+ * @param dst    Destination address in the recipient's address space.
+ * @param size   Size of the payload.
+ *
+ * @return EOK on success or an error code from copy_to_uspace().
+ */
+static errno_t lent_copy_to_uspace(call_t *answer, uspace_addr_t dst,
+    size_t size)
+{
+	size_t offset = answer->lent_offset;
+	size_t pos = 0;
+
+	for (size_t i = 0; (i < answer->lent_count) && (pos < size); i++) {
+		size_t chunk = min(PAGE_SIZE - offset, size - pos);
+		uintptr_t frame = answer->lent_frames[i];
+
+		uintptr_t kpage;
+		if (frame >= config.identity_size)
+			kpage = km_map(frame, PAGE_SIZE, PAGE_SIZE,
+			    PAGE_READ | PAGE_CACHEABLE);
+		else
+			kpage = PA2KA(frame);
+
+		errno_t rc = copy_to_uspace(dst + pos,
+		    (void *) (kpage + offset), chunk);
+
+		if (frame >= config.identity_size)
+			km_unmap(kpage, PAGE_SIZE);
+
+		if (rc != EOK)
+			return rc;
+
+		offset = 0;
+		pos += chunk;
+	}
+
+	return EOK;
+}
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
@@ -55,6 +196,14 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 			return ELIMIT;
 	}
 
+	/*
+	 * Large payloads are lent rather than copied whenever possible;
+	 * small ones are cheaper to copy than to look up and reference
+	 * page by page.
+	 */
+	if ((size >= DATA_LEND_LIMIT) && (request_lend(call, src, size)))
+		return EOK;
+
 	call->buffer = (uint8_t *) malloc(size);
 	if (!call->buffer)
 		return ENOMEM;
@@ -72,7 +221,7 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
-	assert(answer->buffer);
+	assert((answer->buffer) || (answer->lent_frames));
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to receive data. */
@@ -81,8 +230,12 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		size_t max_size = ipc_get_arg2(olddata);
 
 		if (size <= max_size) {
-			errno_t rc = copy_to_uspace(dst,
-			    answer->buffer, size);
+			errno_t rc;
+
+			if (answer->lent_frames)
+				rc = lent_copy_to_uspace(answer, dst, size);
+			else
+				rc = copy_to_uspace(dst, answer->buffer, size);
 			if (rc)
 				ipc_set_retval(&answer->data, rc);
 		} else {
@@ -37,7 +37,7 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <genarch/mm/page_pt.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/frame.h>
 #include <proc/task.h>
 #include <abi/errno.h>
@@ -33,6 +33,7 @@
  */
 
 #include <arch.h>
+#include <cpu.h>
 #include <assert.h>
 #include <errno.h>
 #include <mem.h>
@@ -272,6 +273,8 @@ static int process_request(answerbox_t *box, call_t *call)
 errno_t
 ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv)
 {
+	cpu_count_event(STATS_EVENT_IPC_CALL);
+
 	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
 	if (!kobj->phone)
 		return ENOENT;
@@ -369,6 +372,8 @@ static int check_call_limit(phone_t *phone)
 sys_errno_t sys_ipc_call_async_fast(cap_phone_handle_t handle, sysarg_t imethod,
     sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, sysarg_t label)
 {
+	cpu_count_event(STATS_EVENT_IPC_CALL);
+
 	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
 	if (!kobj)
 		return ENOENT;
@@ -421,6 +426,8 @@ sys_errno_t sys_ipc_call_async_fast(cap_phone_handle_t handle, sysarg_t imethod,
 sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, uspace_ptr_ipc_data_t data,
     sysarg_t label)
 {
+	cpu_count_event(STATS_EVENT_IPC_CALL);
+
 	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
 	if (!kobj)
 		return ENOENT;
@@ -458,6 +465,86 @@ sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, uspace_ptr_ipc_da
 	return EOK;
 }
 
+/** Make an asynchronous call from already copied-in call data.
+ *
+ * @param handle Phone capability handle for the call.
+ * @param data   Call data with the request.
+ * @param label  User-defined label.
+ *
+ * @return See sys_ipc_call_async_fast().
+ *
+ */
+static errno_t ipc_call_async_internal(cap_phone_handle_t handle,
+    ipc_data_t *data, sysarg_t label)
+{
+	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
+	if (!kobj)
+		return ENOENT;
+
+	if (check_call_limit(kobj->phone)) {
+		kobject_put(kobj);
+		return ELIMIT;
+	}
+
+	call_t *call = ipc_call_alloc();
+	if (!call) {
+		kobject_put(kobj);
+		return ENOMEM;
+	}
+
+	memcpy(&call->data.args, &data->args, sizeof(call->data.args));
+
+	/* Set the user-defined label */
+	call->data.answer_label = label;
+
+	errno_t res = request_preprocess(call, kobj->phone);
+
+	if (!res)
+		ipc_call(kobj->phone, call);
+	else
+		ipc_backsend_err(kobj->phone, call, res);
+
+	kobject_put(kobj);
+	return EOK;
+}
+
+/** Make a batch of asynchronous calls in a single syscall.
+ *
+ * Submission stops at the first request that cannot be copied in or
+ * submitted; the caller can tell from the return value how far the batch
+ * got and retry or inspect the rest.
+ *
+ * @param requests Userspace address of an array of call requests.
+ * @param count    Number of requests in the array.
+ *
+ * @return Number of calls successfully submitted.
+ *
+ */
+sysarg_t sys_ipc_call_async_batch(uspace_addr_t requests, sysarg_t count)
+{
+	if (count > IPC_BATCH_LIMIT)
+		count = IPC_BATCH_LIMIT;
+
+	sysarg_t done = 0;
+
+	while (done < count) {
+		ipc_call_request_t request;
+
+		if (copy_from_uspace(&request,
+		    requests + done * sizeof(ipc_call_request_t),
+		    sizeof(request)) != EOK)
+			break;
+
+		if (ipc_call_async_internal(request.phone, &request.data,
+		    request.label) != EOK)
+			break;
+
+		done++;
+	}
+
+	return done;
+}
+
 /** Forward a received call to another destination
  *
  * Common code for both the fast and the slow version.
@@ -565,7 +652,7 @@ error:
 	ipc_set_retval(&call->data, EFORWARD);
 	(void) answer_preprocess(call, need_old ? &old : NULL);
 	if (after_forward)
-		_ipc_answer_free_call(call, false);
+		_ipc_answer_free_call(call);
 	else
 		ipc_answer(&TASK->answerbox, call);
 
@@ -765,8 +852,8 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
  *
  * @return An error code on error.
  */
-sys_errno_t sys_ipc_wait_for_call(uspace_ptr_ipc_data_t calldata, uint32_t usec,
-    unsigned int flags)
+static errno_t ipc_wait_for_call_uspace(uspace_ptr_ipc_data_t calldata,
+    uint32_t usec, unsigned int flags)
 {
 	call_t *call = NULL;
 	errno_t rc;
@@ -865,6 +952,63 @@ error:
 	return rc;
 }
 
+/** Wait for an incoming IPC call or an answer.
+ *
+ * @param calldata Pointer to buffer where the call/answer data is stored.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ *
+ * @return An error code on error.
+ */
+sys_errno_t sys_ipc_wait_for_call(uspace_ptr_ipc_data_t calldata, uint32_t usec,
+    unsigned int flags)
+{
+	return ipc_wait_for_call_uspace(calldata, usec, flags);
+}
+
+/** Wait for a batch of incoming IPC calls or answers.
+ *
+ * The first call/answer is waited for according to @a usec and @a flags;
+ * once it arrives, any further calls/answers already queued in the
+ * answerbox are reaped without blocking, up to @a count in total.
+ *
+ * @param calls Userspace address of an array of call/answer data buffers.
+ * @param count Number of entries in the array.
+ * @param usec  Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags Select mode of sleep operation. See waitq_sleep_timeout()
+ *              for explanation.
+ *
+ * @return Number of calls/answers stored in the array.
+ *
+ */
+sysarg_t sys_ipc_wait_batch(uspace_ptr_ipc_data_t calls, sysarg_t count,
+    uint32_t usec, unsigned int flags)
+{
+	if (count > IPC_BATCH_LIMIT)
+		count = IPC_BATCH_LIMIT;
+
+	sysarg_t done = 0;
+
+	while (done < count) {
+		errno_t rc;
+
+		if (done == 0)
+			rc = ipc_wait_for_call_uspace(calls, usec, flags);
+		else
+			rc = ipc_wait_for_call_uspace(
+			    calls + done * sizeof(ipc_data_t), 0,
+			    SYNCH_FLAGS_NON_BLOCKING);
+
+		if (rc != EOK)
+			break;
+
+		done++;
+	}
+
+	return done;
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
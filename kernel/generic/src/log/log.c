@@ -40,11 +40,14 @@
 #include <ipc/event.h>
 #include <ipc/irq.h>
 #include <arch.h>
+#include <config.h>
+#include <cpu.h>
 #include <panic.h>
 #include <putchar.h>
 #include <atomic.h>
 #include <syscall/copy.h>
 #include <errno.h>
+#include <mem.h>
 #include <str.h>
 #include <print.h>
 #include <printf/printf_core.h>
@@ -54,132 +57,273 @@
 #include <abi/log.h>
 #include <stdlib.h>
 
-#define LOG_PAGES    8
-#define LOG_LENGTH   (LOG_PAGES * PAGE_SIZE)
-#define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + sizeof(uint32_t))
+#define LOG_CPU_PAGES   2
+#define LOG_CPU_LENGTH  (LOG_CPU_PAGES * PAGE_SIZE)
 
-/** Cyclic buffer holding the data for kernel log */
-uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
+/** Maximum length of a single log entry, including its header */
+#define LOG_ENTRY_MAX   PAGE_SIZE
+
+/** Length of the log entry header: length, serial, facility, level */
+#define LOG_ENTRY_HEADER_LENGTH  (sizeof(size_t) + 3 * sizeof(uint32_t))
+
+/** One log ring
+ *
+ * Each CPU appends log entries to its own ring, so a logging storm on
+ * one CPU never makes the others wait. The entries carry a globally
+ * ordered serial number and the rings are merged by it when the log
+ * is handed to uspace.
+ *
+ * The ring lock is only ever contended by the (rare) reader; the
+ * producer path disables interrupts for the time of the entry
+ * composition, which also keeps it safe against logging from
+ * interrupt handlers.
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Cyclic buffer holding complete log entries */
+	uint8_t *buffer;
+
+	/** Position in the buffer where the first log entry starts */
+	size_t start;
+
+	/** Sum of length of all log entries currently stored in the buffer */
+	size_t used;
+
+	/** Start of the next entry to be handed to uspace, relative to start */
+	size_t next_for_uspace;
+
+	/** Buffer in which the current entry is composed */
+	uint8_t *staging;
+
+	/** Length of the entry composed so far */
+	size_t staging_len;
+
+	/** Interrupt level saved by log_begin() */
+	ipl_t ipl;
+} log_ring_t;
+
+/** Storage of the ring used before the per-CPU rings are allocated */
+static uint8_t log_boot_buffer[LOG_CPU_LENGTH];
+static uint8_t log_boot_staging[LOG_ENTRY_MAX];
+
+/** Ring used before the per-CPU rings exist (and as their fallback) */
+static log_ring_t log_boot_ring = {
+	.buffer = log_boot_buffer,
+	.staging = log_boot_staging
+};
+
+/** Per-CPU rings, allocated by log_init() */
+static log_ring_t *log_rings = NULL;
 
 /** Kernel log initialized */
 static atomic_bool log_inited = false;
 
-/** Position in the cyclic buffer where the first log entry starts */
-size_t log_start = 0;
+/** Overall count of logged messages, which may overflow as needed */
+static atomic_size_t log_counter = 0;
 
-/** Sum of length of all log entries currently stored in the cyclic buffer */
-size_t log_used = 0;
+static void log_update(void *);
 
-/** Log spinlock */
-SPINLOCK_STATIC_INITIALIZE_NAME(log_lock, "log_lock");
+/** Get the ring the caller should log to.
+ *
+ * Interrupts have to be disabled so that the answer stays valid.
+ */
+static log_ring_t *log_ring_local(void)
+{
+	if ((log_rings != NULL) && (CPU != NULL))
+		return &log_rings[CPU->id];
 
-/** Overall count of logged messages, which may overflow as needed */
-static uint32_t log_counter = 0;
+	return &log_boot_ring;
+}
 
-/** Starting position of the entry currently being written to the log */
-static size_t log_current_start = 0;
+/** Number of rings a reader has to merge */
+static size_t log_ring_count(void)
+{
+	if (log_rings != NULL)
+		return config.cpu_count + 1;
 
-/** Length (including header) of the entry currently being written to the log */
-static size_t log_current_len = 0;
+	return 1;
+}
 
-/** Start of the next entry to be handed to uspace starting from log_start */
-static size_t next_for_uspace = 0;
+/** Get ring by reader index (0 is the boot ring) */
+static log_ring_t *log_ring_get(size_t i)
+{
+	if (i == 0)
+		return &log_boot_ring;
 
-static void log_update(void *);
+	return &log_rings[i - 1];
+}
 
 /** Initialize kernel logging facility
  *
  */
 void log_init(void)
 {
+	log_ring_t *rings = malloc(sizeof(log_ring_t) * config.cpu_count);
+
+	if (rings != NULL) {
+		size_t i;
+
+		for (i = 0; i < config.cpu_count; i++) {
+			irq_spinlock_initialize(&rings[i].lock,
+			    "log_ring.lock");
+			rings[i].buffer = malloc(LOG_CPU_LENGTH);
+			rings[i].staging = malloc(LOG_ENTRY_MAX);
+			rings[i].start = 0;
+			rings[i].used = 0;
+			rings[i].next_for_uspace = 0;
+			rings[i].staging_len = 0;
+
+			if ((rings[i].buffer == NULL) ||
+			    (rings[i].staging == NULL))
+				break;
+		}
+
+		if (i == config.cpu_count) {
+			log_rings = rings;
+		} else {
+			/* Keep using the boot ring only. */
+			for (size_t j = 0; j <= i; j++) {
+				free(rings[j].buffer);
+				free(rings[j].staging);
+			}
+			free(rings);
+		}
+	}
+
 	event_set_unmask_callback(EVENT_KLOG, log_update);
 	atomic_store(&log_inited, true);
 }
 
-static size_t log_copy_from(uint8_t *data, size_t pos, size_t len)
+static size_t ring_copy_from(log_ring_t *ring, uint8_t *data, size_t pos,
+    size_t len)
 {
-	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_LENGTH) {
-		data[i] = log_buffer[pos];
+	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_CPU_LENGTH) {
+		data[i] = ring->buffer[pos];
 	}
 	return pos;
 }
 
-static size_t log_copy_to(const uint8_t *data, size_t pos, size_t len)
+static size_t ring_copy_to(log_ring_t *ring, const uint8_t *data, size_t pos,
+    size_t len)
 {
-	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_LENGTH) {
-		log_buffer[pos] = data[i];
+	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_CPU_LENGTH) {
+		ring->buffer[pos] = data[i];
 	}
 	return pos;
 }
 
-/** Append data to the currently open log entry.
+/** Append data to the entry being composed in the ring's staging buffer.
  *
- * This function requires that the log_lock is acquired by the caller.
+ * This function requires that the ring is owned by the caller
+ * (i.e. it is called between log_begin() and log_end()).
  */
-static void log_append(const uint8_t *data, size_t len)
+static void log_append(log_ring_t *ring, const uint8_t *data, size_t len)
 {
-	/* Cap the length so that the entry entirely fits into the buffer */
-	if (len > LOG_LENGTH - log_current_len) {
-		len = LOG_LENGTH - log_current_len;
-	}
+	/* Cap the length so that the entry fits into the staging buffer */
+	if (len > LOG_ENTRY_MAX - ring->staging_len)
+		len = LOG_ENTRY_MAX - ring->staging_len;
 
 	if (len == 0)
 		return;
 
-	size_t log_free = LOG_LENGTH - log_used - log_current_len;
+	memcpy(ring->staging + ring->staging_len, data, len);
+	ring->staging_len += len;
+}
+
+/** Store the composed entry into the ring buffer.
+ *
+ * Discards the oldest entries if the ring is full. The ring lock
+ * must be held.
+ */
+static void log_commit(log_ring_t *ring)
+{
+	size_t len = ring->staging_len;
+	size_t log_free = LOG_CPU_LENGTH - ring->used;
 
 	/* Discard older entries to make space, if necessary */
 	while (len > log_free) {
 		size_t entry_len;
-		log_copy_from((uint8_t *) &entry_len, log_start, sizeof(size_t));
-		log_start = (log_start + entry_len) % LOG_LENGTH;
-		log_used -= entry_len;
+		ring_copy_from(ring, (uint8_t *) &entry_len, ring->start,
+		    sizeof(size_t));
+		ring->start = (ring->start + entry_len) % LOG_CPU_LENGTH;
+		ring->used -= entry_len;
 		log_free += entry_len;
-		next_for_uspace -= entry_len;
+
+		if (ring->next_for_uspace >= entry_len)
+			ring->next_for_uspace -= entry_len;
+		else
+			ring->next_for_uspace = 0;
 	}
 
-	size_t pos = (log_current_start + log_current_len) % LOG_LENGTH;
-	log_copy_to(data, pos, len);
-	log_current_len += len;
+	size_t pos = (ring->start + ring->used) % LOG_CPU_LENGTH;
+	ring_copy_to(ring, ring->staging, pos, len);
+	ring->used += len;
 }
 
 /** Begin writing an entry to the log.
  *
- * This acquires the log and output buffer locks, so only calls to log_* functions should
- * be used until calling log_end.
+ * This pins the caller to the CPU-local log ring by disabling
+ * interrupts, so only calls to log_* functions should be used until
+ * calling log_end().
  */
 void log_begin(log_facility_t fac, log_level_t level)
 {
-	spinlock_lock(&log_lock);
-	spinlock_lock(&kio_lock);
+	ipl_t ipl = interrupts_disable();
+
+	log_ring_t *ring = log_ring_local();
+	irq_spinlock_lock(&ring->lock, false);
+	ring->ipl = ipl;
 
-	log_current_start = (log_start + log_used) % LOG_LENGTH;
-	log_current_len = 0;
+	ring->staging_len = 0;
 
-	/* Write header of the log entry, the length will be written in log_end() */
-	log_append((uint8_t *) &log_current_len, sizeof(size_t));
-	log_append((uint8_t *) &log_counter, sizeof(uint32_t));
+	/* Write header of the entry, the length is patched in log_end() */
+	size_t len = 0;
+	uint32_t serial = (uint32_t) atomic_fetch_add(&log_counter, 1);
 	uint32_t fac32 = fac;
 	uint32_t lvl32 = level;
-	log_append((uint8_t *) &fac32, sizeof(uint32_t));
-	log_append((uint8_t *) &lvl32, sizeof(uint32_t));
 
-	log_counter++;
+	log_append(ring, (uint8_t *) &len, sizeof(size_t));
+	log_append(ring, (uint8_t *) &serial, sizeof(uint32_t));
+	log_append(ring, (uint8_t *) &fac32, sizeof(uint32_t));
+	log_append(ring, (uint8_t *) &lvl32, sizeof(uint32_t));
 }
 
 /** Finish writing an entry to the log.
  *
- * This releases the log and output buffer locks.
+ * Stores the entry into the CPU-local ring, mirrors its text to the
+ * kernel console buffer and re-enables interrupts.
  */
 void log_end(void)
 {
-	/* Set the length in the header to correct value */
-	log_copy_to((uint8_t *) &log_current_len, log_current_start, sizeof(size_t));
-	log_used += log_current_len;
+	log_ring_t *ring = log_ring_local();
 
+	/* Set the length in the header to the correct value */
+	memcpy(ring->staging, &ring->staging_len, sizeof(size_t));
+
+	log_commit(ring);
+
+	/*
+	 * Mirror the entry text to the kio buffer in one go, so that
+	 * messages from different CPUs do not interleave on the
+	 * console. Unlike the composition above, this is the only
+	 * place where concurrent loggers meet, and it is a plain
+	 * buffer copy.
+	 */
+	spinlock_lock(&kio_lock);
+
+	size_t offset = LOG_ENTRY_HEADER_LENGTH;
+	while (offset < ring->staging_len) {
+		kio_push_char(str_decode((char *) ring->staging, &offset,
+		    ring->staging_len));
+	}
 	kio_push_char('\n');
+
 	spinlock_unlock(&kio_lock);
-	spinlock_unlock(&log_lock);
+
+	ipl_t ipl = ring->ipl;
+	irq_spinlock_unlock(&ring->lock, false);
+	interrupts_restore(ipl);
 
 	/* This has to be called after we released the locks above */
 	kio_flush();
@@ -192,24 +336,36 @@ static void log_update(void *event)
 	if (!atomic_load(&log_inited))
 		return;
 
-	spinlock_lock(&log_lock);
-	if (next_for_uspace < log_used)
+	bool pending = false;
+
+	for (size_t i = 0; i < log_ring_count(); i++) {
+		log_ring_t *ring = log_ring_get(i);
+
+		irq_spinlock_lock(&ring->lock, true);
+		if (ring->next_for_uspace < ring->used)
+			pending = true;
+		irq_spinlock_unlock(&ring->lock, true);
+
+		if (pending)
+			break;
+	}
+
+	if (pending)
 		event_notify_0(EVENT_KLOG, true);
-	spinlock_unlock(&log_lock);
 }
 
 static int log_printf_str_write(const char *str, size_t size, void *data)
 {
+	log_append(log_ring_local(), (const uint8_t *) str, size);
+
 	size_t offset = 0;
 	size_t chars = 0;
 
 	while (offset < size) {
-		kio_push_char(str_decode(str, &offset, size));
+		str_decode(str, &offset, size);
 		chars++;
 	}
 
-	log_append((const uint8_t *)str, size);
-
 	return chars;
 }
 
@@ -220,15 +376,14 @@ static int log_printf_wstr_write(const char32_t *wstr, size_t size, void *data)
 	size_t chars = 0;
 
 	for (offset = 0; offset < size; offset += sizeof(char32_t), chars++) {
-		kio_push_char(wstr[chars]);
-
 		size_t buffer_offset = 0;
 		errno_t rc = chr_encode(wstr[chars], buffer, &buffer_offset, 16);
 		if (rc != EOK) {
 			return EOF;
 		}
 
-		log_append((const uint8_t *)buffer, buffer_offset);
+		log_append(log_ring_local(), (const uint8_t *) buffer,
+		    buffer_offset);
 	}
 
 	return chars;
@@ -291,6 +446,112 @@ int log(log_facility_t fac, log_level_t level, const char *fmt, ...)
 	return ret;
 }
 
+/** Read the header of the next unread entry of a ring.
+ *
+ * The ring lock must be held and the ring must have an unread entry.
+ */
+static void log_peek_unread(log_ring_t *ring, size_t *pos, size_t *entry_len,
+    uint32_t *serial)
+{
+	*pos = (ring->start + ring->next_for_uspace) % LOG_CPU_LENGTH;
+	ring_copy_from(ring, (uint8_t *) entry_len, *pos, sizeof(size_t));
+	ring_copy_from(ring, (uint8_t *) serial,
+	    (*pos + sizeof(size_t)) % LOG_CPU_LENGTH, sizeof(uint32_t));
+}
+
+/** Copy unread log entries for uspace, merging the rings.
+ *
+ * Entries are taken in the order of their serial numbers, so the
+ * per-CPU rings are presented to uspace as one globally ordered log.
+ *
+ * @return Number of bytes copied to data.
+ */
+static size_t log_read_merged(uint8_t *data, size_t size, errno_t *rc)
+{
+	size_t copied = 0;
+
+	*rc = EOK;
+
+	while (true) {
+		/* Find the ring holding the oldest unread entry. */
+		size_t best = 0;
+		uint32_t best_serial = 0;
+		bool found = false;
+
+		for (size_t i = 0; i < log_ring_count(); i++) {
+			log_ring_t *ring = log_ring_get(i);
+
+			irq_spinlock_lock(&ring->lock, true);
+			if (ring->next_for_uspace < ring->used) {
+				size_t pos;
+				size_t entry_len;
+				uint32_t serial;
+				log_peek_unread(ring, &pos, &entry_len,
+				    &serial);
+
+				/* Serial numbers may wrap around. */
+				if ((!found) ||
+				    ((int32_t) (serial - best_serial) < 0)) {
+					best = i;
+					best_serial = serial;
+					found = true;
+				}
+			}
+			irq_spinlock_unlock(&ring->lock, true);
+		}
+
+		if (!found)
+			break;
+
+		/*
+		 * The entry may have been discarded by a producer in
+		 * the meantime, so re-check under the lock. If it was,
+		 * whatever is unread now is a valid entry too, just
+		 * possibly slightly out of the global order.
+		 */
+		log_ring_t *ring = log_ring_get(best);
+
+		irq_spinlock_lock(&ring->lock, true);
+
+		if (ring->next_for_uspace >= ring->used) {
+			irq_spinlock_unlock(&ring->lock, true);
+			continue;
+		}
+
+		size_t pos;
+		size_t entry_len;
+		uint32_t serial;
+		log_peek_unread(ring, &pos, &entry_len, &serial);
+
+		if (entry_len > PAGE_SIZE) {
+			/*
+			 * Since we limit data transfer to uspace to a
+			 * maximum of PAGE_SIZE bytes, skip any entries
+			 * larger than this limit to prevent uspace
+			 * being stuck trying to read them.
+			 */
+			ring->next_for_uspace += entry_len;
+			irq_spinlock_unlock(&ring->lock, true);
+			continue;
+		}
+
+		if (size < copied + entry_len) {
+			if (copied == 0)
+				*rc = EOVERFLOW;
+			irq_spinlock_unlock(&ring->lock, true);
+			break;
+		}
+
+		ring_copy_from(ring, data + copied, pos, entry_len);
+		copied += entry_len;
+		ring->next_for_uspace += entry_len;
+
+		irq_spinlock_unlock(&ring->lock, true);
+	}
+
+	return copied;
+}
+
 /** Control of the log from uspace
  *
  */
@@ -328,42 +589,7 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 		if (!data)
 			return (sys_errno_t) ENOMEM;
 
-		size_t entry_len = 0;
-		size_t copied = 0;
-
-		rc = EOK;
-
-		spinlock_lock(&log_lock);
-
-		while (next_for_uspace < log_used) {
-			size_t pos = (log_start + next_for_uspace) % LOG_LENGTH;
-			log_copy_from((uint8_t *) &entry_len, pos, sizeof(size_t));
-
-			if (entry_len > PAGE_SIZE) {
-				/*
-				 * Since we limit data transfer
-				 * to uspace to a maximum of PAGE_SIZE
-				 * bytes, skip any entries larger
-				 * than this limit to prevent
-				 * userspace being stuck trying to
-				 * read them.
-				 */
-				next_for_uspace += entry_len;
-				continue;
-			}
-
-			if (size < copied + entry_len) {
-				if (copied == 0)
-					rc = EOVERFLOW;
-				break;
-			}
-
-			log_copy_from((uint8_t *) (data + copied), pos, entry_len);
-			copied += entry_len;
-			next_for_uspace += entry_len;
-		}
-
-		spinlock_unlock(&log_lock);
+		size_t copied = log_read_merged((uint8_t *) data, size, &rc);
 
 		if (rc != EOK) {
 			free(data);
@@ -378,7 +604,6 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 			return (sys_errno_t) rc;
 
 		return copy_to_uspace(uspace_nread, &copied, sizeof(copied));
-		return EOK;
 	default:
 		return (sys_errno_t) ENOTSUP;
 	}
@@ -67,6 +67,8 @@
 #include <security/perm.h>
 #include <lib/rd.h>
 #include <ipc/ipc.h>
+#include <ipc/irq.h>
+#include <cap/cap.h>
 #include <str.h>
 #include <sysinfo/stats.h>
 #include <sysinfo/sysinfo.h>
@@ -109,70 +111,33 @@ void kinit(void *arg)
 	interrupts_disable();
 
 #ifdef CONFIG_SMP
+	thread_t *kmp_thread = NULL;
+
 	if (config.cpu_count > 1) {
 		waitq_initialize(&ap_completion_wq);
 
 		/*
-		 * Create the kmp thread and wait for its completion.
-		 * cpu1 through cpuN-1 will come up consecutively and
-		 * not mess together with kcpulb threads.
-		 * Just a beautification.
+		 * Create the kmp thread, but do not wait for it just
+		 * yet. cpu1 through cpuN-1 come up one at a time and
+		 * spend most of that time calibrating their delay
+		 * loops; the init task images can be loaded on the
+		 * bootstrap processor in the meantime.
 		 */
-		thread = thread_create(kmp, NULL, TASK,
+		kmp_thread = thread_create(kmp, NULL, TASK,
 		    THREAD_FLAG_UNCOUNTED, "kmp");
-		if (!thread)
+		if (!kmp_thread)
 			panic("Unable to create kmp thread.");
 
-		thread_wire(thread, &cpus[0]);
-		thread_ready(thread);
-		thread_join(thread);
-		thread_detach(thread);
-
-		/*
-		 * For each CPU, create its load balancing thread.
-		 */
-		unsigned int i;
-
-		for (i = 0; i < config.cpu_count; i++) {
-			thread = thread_create(kcpulb, NULL, TASK,
-			    THREAD_FLAG_UNCOUNTED, "kcpulb");
-			if (thread != NULL) {
-				thread_wire(thread, &cpus[i]);
-				thread_ready(thread);
-			} else
-				log(LF_OTHER, LVL_ERROR,
-				    "Unable to create kcpulb thread for cpu%u", i);
-		}
+		thread_wire(kmp_thread, &cpus[0]);
+		thread_ready(kmp_thread);
 	}
 #endif /* CONFIG_SMP */
 
-	/*
-	 * At this point SMP, if present, is configured.
-	 */
-	ARCH_OP(post_smp_init);
-
-	/* Start thread computing system load */
-	thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
-	    "kload");
-	if (thread != NULL)
-		thread_ready(thread);
-	else
-		log(LF_OTHER, LVL_ERROR, "Unable to create kload thread");
+	/* Start the IRQ notification bottom halves */
+	ipc_irq_defer_init();
 
-#ifdef CONFIG_KCONSOLE
-	if (stdin) {
-		/*
-		 * Create kernel console.
-		 */
-		thread = thread_create(kconsole_thread, NULL, TASK,
-		    THREAD_FLAG_NONE, "kconsole");
-		if (thread != NULL)
-			thread_ready(thread);
-		else
-			log(LF_OTHER, LVL_ERROR,
-			    "Unable to create kconsole thread");
-	}
-#endif /* CONFIG_KCONSOLE */
+	/* Start the deferred capability reclamation thread */
+	caps_reclaim_init();
 
 	/*
 	 * Store the default stack size in sysinfo so that uspace can create
@@ -295,6 +260,39 @@ void kinit(void *arg)
 		}
 	}
 
+#ifdef CONFIG_SMP
+	if (config.cpu_count > 1) {
+		/*
+		 * Wait for the kmp thread. All processors must be active
+		 * before the load balancing threads are created and
+		 * before the init tasks are allowed to run.
+		 */
+		thread_join(kmp_thread);
+		thread_detach(kmp_thread);
+
+		/*
+		 * For each CPU, create its load balancing thread.
+		 */
+		unsigned int cpu;
+
+		for (cpu = 0; cpu < config.cpu_count; cpu++) {
+			thread = thread_create(kcpulb, NULL, TASK,
+			    THREAD_FLAG_UNCOUNTED, "kcpulb");
+			if (thread != NULL) {
+				thread_wire(thread, &cpus[cpu]);
+				thread_ready(thread);
+			} else
+				log(LF_OTHER, LVL_ERROR,
+				    "Unable to create kcpulb thread for cpu%u", cpu);
+		}
+	}
+#endif /* CONFIG_SMP */
+
+	/*
+	 * At this point SMP, if present, is configured.
+	 */
+	ARCH_OP(post_smp_init);
+
 	/*
 	 * Run user tasks.
 	 */
@@ -303,6 +301,29 @@ void kinit(void *arg)
 			program_ready(&programs[i]);
 	}
 
+	/* Start thread computing system load */
+	thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
+	    "kload");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR, "Unable to create kload thread");
+
+#ifdef CONFIG_KCONSOLE
+	if (stdin) {
+		/*
+		 * Create kernel console.
+		 */
+		thread = thread_create(kconsole_thread, NULL, TASK,
+		    THREAD_FLAG_NONE, "kconsole");
+		if (thread != NULL)
+			thread_ready(thread);
+		else
+			log(LF_OTHER, LVL_ERROR,
+			    "Unable to create kconsole thread");
+	}
+#endif /* CONFIG_KCONSOLE */
+
 #ifdef CONFIG_KCONSOLE
 	if (!stdin) {
 		thread_sleep(10);
@@ -77,6 +77,7 @@
 #include <mm/reserve.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/sysfutex.h>
 #include <arch/arch.h>
 #include <arch.h>
 #include <arch/faddr.h>
@@ -86,8 +87,11 @@
 #include <ddi/ddi.h>
 #include <main/main.h>
 #include <ipc/event.h>
+#include <adt/obtree.h>
 #include <sysinfo/sysinfo.h>
 #include <sysinfo/stats.h>
+#include <sysinfo/profiler.h>
+#include <lattrace.h>
 #include <lib/ra.h>
 #include <cap/cap.h>
 
@@ -247,6 +251,7 @@ void main_bsp_separated_stack(void)
 	frame_init();
 	slab_cache_init();
 	malloc_init();
+	obtree_init();
 	ra_init();
 	sysinfo_init();
 	as_init();
@@ -256,6 +261,7 @@ void main_bsp_separated_stack(void)
 	ddi_init();
 	ARCH_OP(post_mm_init);
 	reserve_init();
+	elf_cache_init();
 	ARCH_OP(pre_smp_init);
 	smp_init();
 
@@ -279,6 +285,7 @@ void main_bsp_separated_stack(void)
 	task_init();
 	thread_init();
 	sys_waitq_init();
+	sys_futex_init();
 
 	sysinfo_set_item_data("boot_args", NULL, bargs, str_size(bargs) + 1);
 
@@ -295,6 +302,8 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+	profiler_init();
+	lattrace_init();
 
 	/*
 	 * Create kernel task.
@@ -55,9 +55,10 @@
 #include <mm/tlb.h>
 #include <arch/mm/page.h>
 #include <genarch/mm/page_pt.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/asid.h>
 #include <arch/mm/asid.h>
+#include <cpu/cpu_mask.h>
 #include <preemption.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
@@ -72,6 +73,8 @@
 #include <macros.h>
 #include <bitops.h>
 #include <arch.h>
+#include <atomic.h>
+#include <cpu.h>
 #include <errno.h>
 #include <config.h>
 #include <align.h>
@@ -115,6 +118,14 @@ LIST_INITIALIZE(inactive_as_with_asid_list);
 /** Kernel address space. */
 as_t *AS_KERNEL = NULL;
 
+/** Generation counter for the per-CPU fault-path area caches.
+ *
+ * Incremented whenever an address space area is removed or resized.
+ * Cached (as, area) pairs tagged with an older generation are ignored,
+ * so a stale cache entry is never dereferenced.
+ */
+static atomic_size_t area_cache_gen = 0;
+
 static void *as_areas_getkey(odlink_t *);
 static int as_areas_cmp(void *, void *);
 
@@ -184,6 +195,18 @@ as_t *as_create(unsigned int flags)
 	refcount_init(&as->refcount);
 	as->cpu_refcount = 0;
 
+	if (flags & FLAG_AS_KERNEL) {
+		/*
+		 * The kernel address space is active on every processor,
+		 * so there is no point in tracking the set.
+		 */
+		as->cpus = NULL;
+	} else {
+		as->cpus = malloc(cpu_mask_size());
+		if (as->cpus)
+			cpu_mask_none(as->cpus);
+	}
+
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
 #else
@@ -269,6 +292,9 @@ retry:
 	page_table_destroy(NULL);
 #endif
 
+	if (as->cpus)
+		free(as->cpus);
+
 	slab_free(as_cache, as);
 }
 
@@ -880,6 +906,127 @@ _NO_TRACE static as_area_t *find_area_and_lock(as_t *as, uintptr_t va)
 	return NULL;
 }
 
+/** Invalidate all per-CPU fault-path area caches. */
+_NO_TRACE static void area_cache_invalidate(void)
+{
+	atomic_fetch_add(&area_cache_gen, 1);
+}
+
+/** Look up the faulting area in this CPU's area cache and lock it.
+ *
+ * A hit skips the walk of the address space's ordered dictionary.
+ * The cache is CPU-local, so it is consulted with interrupts disabled
+ * to rule out migration; @a as must be locked, which guarantees that
+ * a current-generation entry of @a as still describes a live area and
+ * that its base and size cannot change before the area is locked.
+ *
+ * @param as Address space.
+ * @param va Virtual address.
+ *
+ * @return Locked address space area containing va on cache hit or
+ *         NULL on cache miss.
+ *
+ */
+_NO_TRACE static as_area_t *area_cache_find_and_lock(as_t *as, uintptr_t va)
+{
+	assert(mutex_locked(&as->lock));
+
+	as_area_t *area = NULL;
+	uintptr_t base = 0;
+	size_t pages = 0;
+
+	ipl_t ipl = interrupts_disable();
+
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return NULL;
+	}
+
+	size_t gen = atomic_load(&area_cache_gen);
+
+	for (unsigned int i = 0; i < AS_AREA_CACHE_SIZE; i++) {
+		as_area_cache_t *entry = &CPU->area_cache[i];
+
+		if ((entry->as != as) || (entry->gen != gen))
+			continue;
+
+		if ((va < entry->base) ||
+		    (va > entry->base + (P2SZ(entry->pages) - 1)))
+			continue;
+
+		area = entry->area;
+		base = entry->base;
+		pages = entry->pages;
+
+		/* Keep the cache MRU-ordered */
+		if (i != 0) {
+			as_area_cache_t tmp = CPU->area_cache[0];
+			CPU->area_cache[0] = *entry;
+			*entry = tmp;
+		}
+
+		break;
+	}
+
+	interrupts_restore(ipl);
+
+	if (!area)
+		return NULL;
+
+	/*
+	 * Locking the area may block, so it is done only after interrupts
+	 * have been reenabled. Holding the address space lock keeps the
+	 * area alive and its base and size stable in the meantime.
+	 */
+	mutex_lock(&area->lock);
+
+	assert(area->base == base);
+	assert(area->pages == pages);
+
+	return area;
+}
+
+/** Remember a fault-hit area in this CPU's area cache.
+ *
+ * Must be called with both @a as and @a area locked. The cache is
+ * CPU-local, so it is updated with interrupts disabled to rule out
+ * migration. The least recently used entry is evicted.
+ *
+ * @param as   Address space.
+ * @param area Area which resolved the fault.
+ *
+ */
+_NO_TRACE static void area_cache_insert(as_t *as, as_area_t *area)
+{
+	assert(mutex_locked(&as->lock));
+	assert(mutex_locked(&area->lock));
+
+	ipl_t ipl = interrupts_disable();
+
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return;
+	}
+
+	/*
+	 * Read the generation before the area parameters so that an
+	 * invalidation racing with us makes the entry stale, never
+	 * wrongly current.
+	 */
+	size_t gen = atomic_load(&area_cache_gen);
+
+	for (unsigned int i = AS_AREA_CACHE_SIZE - 1; i > 0; i--)
+		CPU->area_cache[i] = CPU->area_cache[i - 1];
+
+	CPU->area_cache[0].as = as;
+	CPU->area_cache[0].area = area;
+	CPU->area_cache[0].gen = gen;
+	CPU->area_cache[0].base = area->base;
+	CPU->area_cache[0].pages = area->pages;
+
+	interrupts_restore(ipl);
+}
+
 /** Find address space area and change it.
  *
  * @param as      Address space.
@@ -954,7 +1101,7 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 * Start TLB shootdown sequence.
 		 */
 
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
+		ipl_t ipl = tlb_shootdown_start(as, TLB_INVL_PAGES,
 		    as->asid, area->base + P2SZ(pages),
 		    area->pages - pages);
 
@@ -1072,6 +1219,163 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 	}
 
 	area->pages = pages;
+	area_cache_invalidate();
+
+	mutex_unlock(&area->lock);
+	mutex_unlock(&as->lock);
+
+	return 0;
+}
+
+/** Decommit a range of pages within an address space area.
+ *
+ * The frames backing the range are freed and their mappings removed,
+ * while the area keeps its size, flags and reservation. The pages
+ * behave like never-touched pages of the area afterwards: the next
+ * access faults in a fresh zeroed frame. This lets userspace
+ * allocators return interior free memory without splitting the area.
+ *
+ * @param as      Address space.
+ * @param address Virtual address of the first page to be decommitted.
+ *                Must be page-aligned and belong to an existing area.
+ * @param size    Size of the range to be decommitted.
+ *
+ * @return Zero on success or a value from @ref errno.h otherwise.
+ *
+ */
+errno_t as_area_decommit(as_t *as, uintptr_t address, size_t size)
+{
+	if (!IS_ALIGNED(address, PAGE_SIZE))
+		return EINVAL;
+
+	size_t pages = SIZE2FRAMES(size);
+	if (!pages)
+		return EOK;
+
+	mutex_lock(&as->lock);
+
+	as_area_t *area = find_area_and_lock(as, address);
+	if (!area) {
+		mutex_unlock(&as->lock);
+		return ENOENT;
+	}
+
+	if (pages > area->pages - ((address - area->base) >> PAGE_WIDTH)) {
+		/*
+		 * The range does not fit within the area.
+		 */
+		mutex_unlock(&area->lock);
+		mutex_unlock(&as->lock);
+		return EINVAL;
+	}
+
+	if (area->backend != &anon_backend) {
+		/*
+		 * Only anonymous memory can be thrown away and lazily
+		 * recreated as zeroed pages.
+		 */
+		mutex_unlock(&area->lock);
+		mutex_unlock(&as->lock);
+		return ENOTSUP;
+	}
+
+	mutex_lock(&area->sh_info->lock);
+	if (area->sh_info->shared) {
+		/*
+		 * Decommit of shared address space areas
+		 * is not supported.
+		 */
+		mutex_unlock(&area->sh_info->lock);
+		mutex_unlock(&area->lock);
+		mutex_unlock(&as->lock);
+		return ENOTSUP;
+	}
+	mutex_unlock(&area->sh_info->lock);
+
+	uintptr_t end = address + P2SZ(pages);
+
+	page_table_lock(as, false);
+
+	/*
+	 * Start TLB shootdown sequence.
+	 */
+	ipl_t ipl = tlb_shootdown_start(as, TLB_INVL_PAGES, as->asid,
+	    address, pages);
+
+	/*
+	 * Visit the used space intervals overlapping the range, free
+	 * the frames backing the overlap and punch matching holes
+	 * into the used space.
+	 */
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space,
+	    address);
+	while ((ival != NULL) && (ival->page < end)) {
+		uintptr_t lo = max(ival->page, address);
+		uintptr_t hi = min(ival->page + P2SZ(ival->count), end);
+
+		size_t i;
+		for (i = 0; i < (hi - lo) >> PAGE_WIDTH; i++) {
+			pte_t pte;
+			bool found = page_mapping_find(as, lo + P2SZ(i),
+			    false, &pte);
+
+			(void) found;
+			assert(found);
+			assert(PTE_VALID(&pte));
+			assert(PTE_PRESENT(&pte));
+
+			if ((area->backend) &&
+			    (area->backend->frame_free)) {
+				area->backend->frame_free(area,
+				    lo + P2SZ(i), PTE_GET_FRAME(&pte));
+			}
+
+			page_mapping_remove(as, lo + P2SZ(i));
+		}
+
+		used_space_ival_t *next = used_space_next(ival);
+
+		size_t head = (lo - ival->page) >> PAGE_WIDTH;
+		size_t tail = (ival->page + P2SZ(ival->count) - hi) >>
+		    PAGE_WIDTH;
+
+		if ((head == 0) && (tail == 0)) {
+			used_space_remove_ival(ival);
+		} else if (tail == 0) {
+			used_space_shorten_ival(ival, head);
+		} else {
+			/*
+			 * The interval extends beyond the decommitted
+			 * range. The interval base is the ordered
+			 * dictionary key, so the surviving tail has to
+			 * be reinserted rather than adjusted in place.
+			 */
+			if (head == 0)
+				used_space_remove_ival(ival);
+			else
+				used_space_shorten_ival(ival, head);
+
+			if (!used_space_insert(&area->used_space, hi, tail))
+				panic("Cannot insert used space.");
+		}
+
+		ival = next;
+	}
+
+	/*
+	 * Finish TLB shootdown sequence.
+	 */
+
+	tlb_invalidate_pages(as->asid, address, pages);
+
+	/*
+	 * Invalidate software translation caches
+	 * (e.g. TSB on sparc64, PHT on ppc32).
+	 */
+	as_invalidate_translation_cache(as, address, pages);
+	tlb_shootdown_finalize(ipl);
+
+	page_table_unlock(as, false);
 
 	mutex_unlock(&area->lock);
 	mutex_unlock(&as->lock);
@@ -1104,7 +1408,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
+	ipl_t ipl = tlb_shootdown_start(as, TLB_INVL_PAGES, as->asid, area->base,
 	    area->pages);
 
 	/*
@@ -1163,6 +1467,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	 * Remove the empty area from address space.
 	 */
 	odict_remove(&area->las_areas);
+	area_cache_invalidate();
 
 	free(area);
 
@@ -1404,7 +1709,7 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
+	ipl_t ipl = tlb_shootdown_start(as, TLB_INVL_PAGES, as->asid, area->base,
 	    area->pages);
 
 	/*
@@ -1514,6 +1819,8 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 	uintptr_t page = ALIGN_DOWN(address, PAGE_SIZE);
 	int rc = AS_PF_FAULT;
 
+	cpu_count_event(STATS_EVENT_PAGE_FAULT);
+
 	if (!THREAD)
 		goto page_fault;
 
@@ -1521,7 +1828,19 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		goto page_fault;
 
 	mutex_lock(&AS->lock);
-	as_area_t *area = find_area_and_lock(AS, page);
+
+	/*
+	 * Repeated faults overwhelmingly hit the same few areas, so try
+	 * this CPU's cache of recently hit areas before walking the
+	 * ordered dictionary.
+	 */
+	as_area_t *area = area_cache_find_and_lock(AS, page);
+	if (!area) {
+		area = find_area_and_lock(AS, page);
+		if (area)
+			area_cache_insert(AS, area);
+	}
+
 	if (!area) {
 		/*
 		 * No area contained mapping for 'page'.
@@ -1581,6 +1900,33 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		goto page_fault;
 	}
 
+	/*
+	 * In large areas, take the fault as a hint that the neighbouring
+	 * pages will be needed soon and populate the rest of the naturally
+	 * aligned cluster at once, saving the individual faults. Failures
+	 * merely stop the pre-faulting; the primary fault has already been
+	 * resolved.
+	 */
+	if (area->flags & AS_AREA_LARGE) {
+		uintptr_t cluster = ALIGN_DOWN(page, AS_AREA_LARGE_SIZE);
+		uintptr_t start = max(cluster, area->base);
+		uintptr_t end = min(cluster + AS_AREA_LARGE_SIZE,
+		    area->base + P2SZ(area->pages));
+
+		for (uintptr_t ptr = start; ptr < end; ptr += PAGE_SIZE) {
+			if (ptr == page)
+				continue;
+
+			if ((page_mapping_find(AS, ptr, false, &pte)) &&
+			    (PTE_PRESENT(&pte)))
+				continue;
+
+			if (area->backend->page_fault(area, ptr,
+			    PF_ACCESS_READ) != AS_PF_OK)
+				break;
+		}
+	}
+
 	page_table_unlock(AS, false);
 	mutex_unlock(&area->lock);
 	mutex_unlock(&AS->lock);
@@ -1675,6 +2021,23 @@ retry:
 			new_as->asid = asid_get();
 	}
 
+	/*
+	 * Remember that the address space has been active on this CPU,
+	 * so that future TLB shootdowns can be targeted at it.
+	 */
+	if ((new_as->cpus) && (!cpu_mask_is_set(new_as->cpus, CPU->id))) {
+		cpu_mask_set(new_as->cpus, CPU->id);
+
+		/*
+		 * A shootdown which read the CPU set before the new bit
+		 * became visible neither messages nor waits for this
+		 * CPU. Synchronize with it before installing the page
+		 * table, so that no translation it is invalidating can
+		 * be cached here while it still runs.
+		 */
+		tlb_shootdown_barrier();
+	}
+
 #ifdef AS_PAGE_TABLE
 	SET_PTL0_ADDRESS(new_as->genarch.page_table);
 #endif
@@ -2119,6 +2482,11 @@ sys_errno_t sys_as_area_resize(uintptr_t address, size_t size, unsigned int flag
 	return (sys_errno_t) as_area_resize(AS, address, size, 0);
 }
 
+sys_errno_t sys_as_area_decommit(uintptr_t address, size_t size)
+{
+	return (sys_errno_t) as_area_decommit(AS, address, size);
+}
+
 sys_errno_t sys_as_area_change_flags(uintptr_t address, unsigned int flags)
 {
 	return (sys_errno_t) as_area_change_flags(AS, flags, address);
@@ -37,11 +37,13 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <mm/as.h>
 #include <mm/page.h>
+#include <mm/tlb.h>
 #include <mm/reserve.h>
 #include <genarch/mm/page_pt.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <mm/km.h>
@@ -80,6 +82,60 @@ mem_backend_t anon_backend = {
 	.destroy_shared_data = NULL
 };
 
+/**
+ * Global frame filled with zeroes which backs anonymous pages that have only
+ * been read so far. It is allocated lazily on the first read fault and the
+ * reference obtained from the frame allocator is never dropped, so the frame
+ * stays allocated forever.
+ */
+static atomic_uintptr_t zero_frame = 0;
+
+/** Return the physical address of the global zero frame.
+ *
+ * Allocates the frame on the first call. May block.
+ *
+ * @return Physical address of the zero frame.
+ */
+static uintptr_t zero_frame_get(void)
+{
+	uintptr_t frame = atomic_load(&zero_frame);
+	if (frame != 0)
+		return frame;
+
+	/*
+	 * Allocate and clear a candidate frame and try to install it. If we
+	 * lose the race with another CPU, simply free the candidate again.
+	 */
+	uintptr_t candidate;
+	uintptr_t kpage = km_temporary_page_get(&candidate, 0);
+	memsetb((void *) kpage, PAGE_SIZE, 0);
+	km_temporary_page_put(kpage);
+
+	frame = 0;
+	if (atomic_compare_exchange_strong(&zero_frame, &frame, candidate))
+		return candidate;
+
+	frame_free(candidate, 1);
+	return frame;
+}
+
+/** Remove the mapping of a page and purge it from all TLBs.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Address space area the page belongs to.
+ * @param upage Virtual page to be unmapped.
+ */
+static void anon_mapping_remove(as_area_t *area, uintptr_t upage)
+{
+	ipl_t ipl = tlb_shootdown_start(area->as, TLB_INVL_PAGES,
+	    area->as->asid, upage, 1);
+	page_mapping_remove(area->as, upage);
+	tlb_invalidate_pages(area->as->asid, upage, 1);
+	as_invalidate_translation_cache(area->as, upage, 1);
+	tlb_shootdown_finalize(ipl);
+}
+
 bool anon_create(as_area_t *area)
 {
 	if (area->flags & AS_AREA_LATE_RESERVE)
@@ -139,12 +195,35 @@ void anon_share(as_area_t *area)
 			assert(PTE_VALID(&pte));
 			assert(PTE_PRESENT(&pte));
 
+			uintptr_t frame = PTE_GET_FRAME(&pte);
+
+			if (frame == atomic_load(&zero_frame)) {
+				/*
+				 * The page has only been read so far and is
+				 * backed by the global read-only zero frame.
+				 * The sharers would lose coherence on the
+				 * first write to such a page, so give it a
+				 * private zeroed frame before publishing it
+				 * in the pagemap.
+				 */
+				uintptr_t kpage = km_temporary_page_get(&frame,
+				    FRAME_NO_RESERVE);
+				memsetb((void *) kpage, PAGE_SIZE, 0);
+				km_temporary_page_put(kpage);
+
+				anon_mapping_remove(area, base + P2SZ(j));
+				frame_free_noreserve(atomic_load(&zero_frame),
+				    1);
+
+				page_mapping_insert(area->as, base + P2SZ(j),
+				    frame, as_area_get_flags(area));
+			}
+
 			as_pagemap_insert(&area->sh_info->pagemap,
-			    (base + P2SZ(j)) - area->base, PTE_GET_FRAME(&pte));
+			    (base + P2SZ(j)) - area->base, frame);
 			page_table_unlock(area->as, false);
 
-			pfn_t pfn = ADDR2PFN(PTE_GET_FRAME(&pte));
-			frame_reference_add(pfn);
+			frame_reference_add(ADDR2PFN(frame));
 		}
 
 		ival = used_space_next(ival);
@@ -229,13 +308,34 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   area (e.g. heap or stack) and so far has not been
 		 *   allocated a frame for the faulting page
 		 *
-		 * - non-present mapping: another possibility,
-		 *   currently not implemented, would be frame
-		 *   reuse; when this becomes a possibility,
-		 *   do not forget to distinguish between
-		 *   the different causes
+		 * - write to a page mapped read-only to the global
+		 *   zero frame: the page was so far only read and the
+		 *   copy-on-write needs to be broken now
 		 */
 
+		pte_t pte;
+		bool cow = (page_mapping_find(area->as, upage, false, &pte)) &&
+		    (PTE_PRESENT(&pte));
+
+		if ((!cow) && (access != PF_ACCESS_WRITE)) {
+			/*
+			 * The page has never been written to. Instead of
+			 * allocating memory for it, back it by the global
+			 * zero frame mapped read-only and defer the
+			 * allocation until the first write.
+			 */
+			frame = zero_frame_get();
+			frame_reference_add(ADDR2PFN(frame));
+			mutex_unlock(&area->sh_info->lock);
+
+			page_mapping_insert(AS, upage, frame,
+			    as_area_get_flags(area) & ~PAGE_WRITE);
+			if (!used_space_insert(&area->used_space, upage, 1))
+				panic("Cannot insert used space.");
+
+			return AS_PF_OK;
+		}
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
@@ -249,6 +349,26 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
 		memsetb((void *) kpage, PAGE_SIZE, 0);
 		km_temporary_page_put(kpage);
+
+		if (cow) {
+			/*
+			 * Break the copy-on-write: replace the read-only
+			 * mapping of the global zero frame with the fresh
+			 * private frame. The page is already accounted in
+			 * the used space of the area.
+			 */
+			assert(access == PF_ACCESS_WRITE);
+			assert(PTE_GET_FRAME(&pte) == atomic_load(&zero_frame));
+			mutex_unlock(&area->sh_info->lock);
+
+			anon_mapping_remove(area, upage);
+			frame_free_noreserve(atomic_load(&zero_frame), 1);
+
+			page_mapping_insert(AS, upage, frame,
+			    as_area_get_flags(area));
+
+			return AS_PF_OK;
+		}
 	}
 	mutex_unlock(&area->sh_info->lock);
 
@@ -45,12 +45,16 @@
 #include <mm/reserve.h>
 #include <mm/km.h>
 #include <genarch/mm/page_pt.h>
-#include <genarch/mm/page_ht.h>
+#include <genarch/mm/page_rt.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <synch/mutex.h>
 #include <align.h>
 #include <mem.h>
 #include <macros.h>
 #include <arch.h>
 #include <barrier.h>
+#include <stdlib.h>
 
 static bool elf_create(as_area_t *);
 static bool elf_resize(as_area_t *, size_t);
@@ -79,6 +83,160 @@ mem_backend_t elf_backend = {
 	.destroy_shared_data = NULL
 };
 
+/** Cache of constructed frames for pages of read-only ELF segments.
+ *
+ * Pages of read-only segments which are not backed verbatim by the
+ * image (the boundary pages that need zeroed padding) used to be
+ * constructed again for every task executing the image. The cache
+ * keys such frames by the identity of the image (the kernel address
+ * of its ELF header) and the original page, so that all tasks
+ * executing the same image share one physical frame per page.
+ *
+ * The cache holds one reference to every cached frame, so the frames
+ * survive the exit of the tasks that faulted them in.
+ */
+typedef struct {
+	ht_link_t link;
+	/** Identity of the ELF image. */
+	elf_header_t *elf;
+	/** Original virtual address of the page within the image. */
+	uintptr_t elfpage;
+	/** Cached physical frame. */
+	uintptr_t frame;
+} elf_cache_entry_t;
+
+#define KEY_ELF   0
+#define KEY_PAGE  1
+
+static size_t elf_cache_hash(const ht_link_t *);
+static size_t elf_cache_key_hash(const void *);
+static bool elf_cache_key_equal(const void *, const ht_link_t *);
+
+static hash_table_t elf_cache;
+static mutex_t elf_cache_lock;
+
+static hash_table_ops_t elf_cache_ops = {
+	.hash = elf_cache_hash,
+	.key_hash = elf_cache_key_hash,
+	.key_equal = elf_cache_key_equal,
+	.remove_callback = NULL
+};
+
+size_t elf_cache_hash(const ht_link_t *item)
+{
+	elf_cache_entry_t *entry =
+	    hash_table_get_inst(item, elf_cache_entry_t, link);
+	size_t hash = 0;
+	hash = hash_combine(hash, (uintptr_t) entry->elf);
+	hash = hash_combine(hash, entry->elfpage >> PAGE_WIDTH);
+	return hash;
+}
+
+size_t elf_cache_key_hash(const void *arg)
+{
+	const uintptr_t *key = arg;
+	size_t hash = 0;
+	hash = hash_combine(hash, key[KEY_ELF]);
+	hash = hash_combine(hash, key[KEY_PAGE] >> PAGE_WIDTH);
+	return hash;
+}
+
+bool elf_cache_key_equal(const void *arg, const ht_link_t *item)
+{
+	const uintptr_t *key = arg;
+	elf_cache_entry_t *entry =
+	    hash_table_get_inst(item, elf_cache_entry_t, link);
+	return (key[KEY_ELF] == (uintptr_t) entry->elf) &&
+	    (key[KEY_PAGE] == entry->elfpage);
+}
+
+/** Initialize the ELF frame cache. */
+void elf_cache_init(void)
+{
+	hash_table_create(&elf_cache, 0, 0, &elf_cache_ops);
+	mutex_initialize(&elf_cache_lock, MUTEX_PASSIVE);
+}
+
+/** Look up a cached frame for a page of a read-only segment.
+ *
+ * On success, a reference is added to the frame on behalf of the
+ * mapping being created by the caller.
+ *
+ * @param elf        Identity of the ELF image.
+ * @param elfpage    Original virtual address of the page.
+ * @param[out] frame Cached physical frame.
+ *
+ * @return True if the cache contains the page.
+ *
+ */
+static bool elf_cache_find(elf_header_t *elf, uintptr_t elfpage,
+    uintptr_t *frame)
+{
+	uintptr_t key[2] = {
+		[KEY_ELF] = (uintptr_t) elf,
+		[KEY_PAGE] = elfpage
+	};
+	bool found = false;
+
+	mutex_lock(&elf_cache_lock);
+
+	ht_link_t *link = hash_table_find(&elf_cache, key);
+	if (link) {
+		elf_cache_entry_t *entry =
+		    hash_table_get_inst(link, elf_cache_entry_t, link);
+
+		*frame = entry->frame;
+		frame_reference_add(ADDR2PFN(entry->frame));
+		found = true;
+	}
+
+	mutex_unlock(&elf_cache_lock);
+	return found;
+}
+
+/** Offer a constructed frame to the ELF frame cache.
+ *
+ * The cache takes a reference of its own to the frame. If the entry
+ * cannot be inserted (allocation failure or a race with another fault
+ * on the same page), the frame simply stays private to the caller's
+ * mapping.
+ *
+ * @param elf     Identity of the ELF image.
+ * @param elfpage Original virtual address of the page.
+ * @param frame   Constructed physical frame.
+ *
+ */
+static void elf_cache_insert(elf_header_t *elf, uintptr_t elfpage,
+    uintptr_t frame)
+{
+	elf_cache_entry_t *entry = malloc(sizeof(elf_cache_entry_t));
+	if (!entry)
+		return;
+
+	entry->elf = elf;
+	entry->elfpage = elfpage;
+	entry->frame = frame;
+
+	uintptr_t key[2] = {
+		[KEY_ELF] = (uintptr_t) elf,
+		[KEY_PAGE] = elfpage
+	};
+
+	mutex_lock(&elf_cache_lock);
+
+	if (hash_table_find(&elf_cache, key)) {
+		/* Lost a race with another fault on the same page. */
+		mutex_unlock(&elf_cache_lock);
+		free(entry);
+		return;
+	}
+
+	frame_reference_add(ADDR2PFN(frame));
+	hash_table_insert(&elf_cache, &entry->link);
+
+	mutex_unlock(&elf_cache_lock);
+}
+
 static size_t elf_nonanon_pages_get(as_area_t *area)
 {
 	elf_segment_header_t *entry = area->backend_data.segment;
@@ -374,17 +532,28 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		else
 			pad_hi = 0;
 
-		kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
-		memcpy((void *) (kpage + pad_lo),
-		    (void *) (base + i * PAGE_SIZE + pad_lo),
-		    PAGE_SIZE - pad_lo - pad_hi);
-		if (entry->p_flags & PF_X) {
-			smc_coherence((void *) (kpage + pad_lo),
+		if ((entry->p_flags & PF_W) ||
+		    !elf_cache_find(elf, elfpage, &frame)) {
+			kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+			memcpy((void *) (kpage + pad_lo),
+			    (void *) (base + i * PAGE_SIZE + pad_lo),
 			    PAGE_SIZE - pad_lo - pad_hi);
+			if (entry->p_flags & PF_X) {
+				smc_coherence((void *) (kpage + pad_lo),
+				    PAGE_SIZE - pad_lo - pad_hi);
+			}
+			memsetb((void *) kpage, pad_lo, 0);
+			memsetb((void *) (kpage + PAGE_SIZE - pad_hi), pad_hi, 0);
+			km_temporary_page_put(kpage);
+
+			/*
+			 * The contents of a read-only segment never change,
+			 * so other tasks executing the same image can share
+			 * the constructed frame.
+			 */
+			if (!(entry->p_flags & PF_W))
+				elf_cache_insert(elf, elfpage, frame);
 		}
-		memsetb((void *) kpage, pad_lo, 0);
-		memsetb((void *) (kpage + PAGE_SIZE - pad_hi), pad_hi, 0);
-		km_temporary_page_put(kpage);
 		dirty = true;
 	}
 
@@ -38,7 +38,10 @@
 
 #include <mm/as.h>
 #include <mm/page.h>
+#include <mm/tlb.h>
 #include <mm/frame.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_rt.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -95,10 +98,33 @@ bool user_is_shareable(as_area_t *area)
 	return false;
 }
 
+/** Remove the mapping of a page and purge it from all TLBs.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Address space area the page belongs to.
+ * @param upage Virtual page to be unmapped.
+ */
+static void user_mapping_remove(as_area_t *area, uintptr_t upage)
+{
+	ipl_t ipl = tlb_shootdown_start(area->as, TLB_INVL_PAGES,
+	    area->as->asid, upage, 1);
+	page_mapping_remove(area->as, upage);
+	tlb_invalidate_pages(area->as->asid, upage, 1);
+	as_invalidate_translation_cache(area->as, upage, 1);
+	tlb_shootdown_finalize(ipl);
+}
+
 /** Service a page fault in the user-paged address space area.
  *
  * The address space area and page tables must be already locked.
  *
+ * Pages of writable areas are first mapped read-only, so that the
+ * first store to a page faults again and the pager learns which of
+ * its pages are dirty. On such a write fault the page-in request
+ * carries the AS_PAGE_IN_WRITE flag and the mapping is upgraded to
+ * the full area flags using the frame from the pager's reply.
+ *
  * @param area Pointer to the address space area.
  * @param upage Faulting virtual page.
  * @param access Access mode that caused the fault (i.e. read/write/exec).
@@ -117,10 +143,22 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 
 	as_area_pager_info_t *pager_info = &area->backend_data.pager_info;
 
+	/*
+	 * If the page is already mapped, this must be a write fault on
+	 * a read-only mapping established by an earlier read fault.
+	 */
+	pte_t old_pte;
+	bool upgrade = (page_mapping_find(AS, upage, false, &old_pte)) &&
+	    (PTE_PRESENT(&old_pte));
+
+	sysarg_t size = PAGE_SIZE;
+	if (access == PF_ACCESS_WRITE)
+		size |= AS_PAGE_IN_WRITE;
+
 	ipc_data_t data = { };
 	ipc_set_imethod(&data, IPC_M_PAGE_IN);
 	ipc_set_arg1(&data, upage - area->base);
-	ipc_set_arg2(&data, PAGE_SIZE);
+	ipc_set_arg2(&data, size);
 	ipc_set_arg3(&data, pager_info->id1);
 	ipc_set_arg4(&data, pager_info->id2);
 	ipc_set_arg5(&data, pager_info->id3);
@@ -145,9 +183,33 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 */
 
 	uintptr_t frame = ipc_get_arg1(&data);
-	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
-	if (!used_space_insert(&area->used_space, upage, 1))
-		panic("Cannot insert used space.");
+
+	/*
+	 * Map the page read-only at first unless the faulting access is
+	 * a write, so that the pager is notified again when the page is
+	 * dirtied.
+	 */
+	unsigned int flags = as_area_get_flags(area);
+	if (access != PF_ACCESS_WRITE)
+		flags &= ~PAGE_WRITE;
+
+	if (upgrade) {
+		/*
+		 * Replace the read-only mapping. The old frame's
+		 * reference taken by the original page-in is dropped;
+		 * the reply holds a fresh reference to the new frame
+		 * (usually the very same one). The page is already
+		 * accounted in the used space of the area.
+		 */
+		user_mapping_remove(area, upage);
+		user_frame_free(area, upage, PTE_GET_FRAME(&old_pte));
+
+		page_mapping_insert(AS, upage, frame, flags);
+	} else {
+		page_mapping_insert(AS, upage, frame, flags);
+		if (!used_space_insert(&area->used_space, upage, 1))
+			panic("Cannot insert used space.");
+	}
 
 	return AS_PF_OK;
 }
@@ -38,6 +38,9 @@
  *
  * This file contains the physical frame allocator and memory zone management.
  * The frame allocator is built on top of the two-level bitmap structure.
+ * Single-frame allocations are served from small per-CPU caches of free
+ * frames, which are refilled from the zones in batches, so that the common
+ * case does not contend for the global zones lock.
  *
  */
 
@@ -64,6 +67,16 @@
 
 zones_t zones;
 
+/** High-priority memory watermark
+ *
+ * Number of free frames that unconstrained allocations leave behind in
+ * every zone containing only high-priority memory (i.e. memory below
+ * FRAME_LOWPRIO), so that allocations physically constrained to that
+ * memory do not find it exhausted by allocations that could have been
+ * satisfied anywhere.
+ */
+#define FRAME_HIGHPRIO_WATERMARK  64
+
 /*
  * Synchronization primitives used to sleep when there is no memory
  * available.
@@ -223,6 +236,19 @@ _NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
 	    FRAME_LOWPRIO, constraint, NULL));
 }
 
+/** Check if frame range  priority memory
+ *
+ * @param pfn   Starting frame.
+ * @param count Number of frames.
+ *
+ * @return True if the range contains only priority memory.
+ *
+ */
+_NO_TRACE static bool is_high_priority(pfn_t base, size_t count)
+{
+	return (base + count <= FRAME_LOWPRIO);
+}
+
 /** Find a zone that can allocate specified number of frames
  *
  * This function searches among all zones. Assume interrupts are
@@ -233,13 +259,16 @@ _NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param reserve    Number of free frames that a zone containing only
+ *                   high-priority memory must be left with after the
+ *                   allocation. Zero disables the watermark.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, size_t reserve)
 {
 	for (size_t pos = 0; pos < zones.count; pos++) {
 		size_t i = (pos + hint) % zones.count;
@@ -248,6 +277,15 @@ _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
 		if (!ZONE_FLAGS_MATCH(zones.info[i].flags, flags))
 			continue;
 
+		/*
+		 * Keep a watermark of free frames in zones containing
+		 * only high-priority memory.
+		 */
+		if ((reserve > 0) &&
+		    (is_high_priority(zones.info[i].base, zones.info[i].count)) &&
+		    (zones.info[i].free_count < count + reserve))
+			continue;
+
 		/* Check if the zone can satisfy the allocation request. */
 		if (zone_can_alloc(&zones.info[i], count, constraint))
 			return i;
@@ -256,19 +294,6 @@ _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
 	return (size_t) -1;
 }
 
-/** Check if frame range  priority memory
- *
- * @param pfn   Starting frame.
- * @param count Number of frames.
- *
- * @return True if the range contains only priority memory.
- *
- */
-_NO_TRACE static bool is_high_priority(pfn_t base, size_t count)
-{
-	return (base + count <= FRAME_LOWPRIO);
-}
-
 /** Find a zone that can allocate specified number of frames
  *
  * This function ignores zones that contain only high-priority
@@ -336,8 +361,23 @@ _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
 	if (znum != (size_t) -1)
 		return znum;
 
+	/*
+	 * An unconstrained request spilling over into high-priority
+	 * memory must leave a watermark of free frames behind for the
+	 * allocations that are physically constrained to it (ISA DMA
+	 * and the like). The watermark is soft: if no other zone can
+	 * satisfy the request, the final pass ignores it rather than
+	 * failing an allocation that would previously succeed.
+	 */
+	if (constraint == 0) {
+		znum = find_free_zone_all(count, flags, constraint, hint,
+		    FRAME_HIGHPRIO_WATERMARK);
+		if (znum != (size_t) -1)
+			return znum;
+	}
+
 	/* Take all zones into account */
-	return find_free_zone_all(count, flags, constraint, hint);
+	return find_free_zone_all(count, flags, constraint, hint, 0);
 }
 
 /*
@@ -815,6 +855,58 @@ void *frame_get_parent(pfn_t pfn, size_t hint)
 	return res;
 }
 
+/** Return frames cached on the current CPU back to their home zones.
+ *
+ * Assume interrupts are disabled and zones lock is locked.
+ *
+ */
+_NO_TRACE static void frame_cache_drain(void)
+{
+	if (!CPU)
+		return;
+
+	while (CPU->frame_cache_cnt > 0) {
+		pfn_t pfn = ADDR2PFN(CPU->frame_cache[--CPU->frame_cache_cnt]);
+		size_t znum = find_zone(pfn, 1, 0);
+
+		assert(znum != (size_t) -1);
+
+		(void) zone_frame_free(&zones.info[znum],
+		    pfn - zones.info[znum].base);
+	}
+}
+
+/** Refill the per-CPU frame cache from a zone.
+ *
+ * Grabs a batch of single frames from the zone so that subsequent
+ * single-frame allocations on this CPU do not need to take the zones
+ * lock at all. Only low-memory frames are cached as these satisfy
+ * both FRAME_LOWMEM and FRAME_HIGHMEM requests. The zone is left with
+ * some headroom so that the cache does not eat the last free frames.
+ *
+ * Assume interrupts are disabled and zones lock is locked.
+ *
+ * @param znum Zone to refill the cache from.
+ *
+ */
+_NO_TRACE static void frame_cache_refill(size_t znum)
+{
+	if (!CPU)
+		return;
+
+	if (!(zones.info[znum].flags & ZONE_LOWMEM))
+		return;
+
+	while ((CPU->frame_cache_cnt < FRAME_CACHE_SIZE) &&
+	    (zones.info[znum].free_count > 2 * FRAME_CACHE_SIZE) &&
+	    (zone_can_alloc(&zones.info[znum], 1, 0))) {
+		pfn_t pfn = zone_frame_alloc(&zones.info[znum], 1, 0) +
+		    zones.info[znum].base;
+
+		CPU->frame_cache[CPU->frame_cache_cnt++] = PFN2ADDR(pfn);
+	}
+}
+
 static size_t try_find_zone(size_t count, bool lowmem,
     pfn_t frame_constraint, size_t hint)
 {
@@ -854,6 +946,26 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
+	/*
+	 * Try the per-CPU cache first. It holds single low-memory frames,
+	 * which satisfy any unconstrained request regardless of the
+	 * FRAME_LOWMEM/FRAME_HIGHMEM preference, so the common
+	 * single-frame allocation typically avoids the zones lock
+	 * altogether.
+	 */
+	if ((count == 1) && (frame_constraint == 0) && (!pzone)) {
+		ipl_t ipl = interrupts_disable();
+
+		if ((CPU) && (CPU->frame_cache_cnt > 0)) {
+			uintptr_t frame =
+			    CPU->frame_cache[--CPU->frame_cache_cnt];
+			interrupts_restore(ipl);
+			return frame;
+		}
+
+		interrupts_restore(ipl);
+	}
+
 loop:
 	irq_spinlock_lock(&zones.lock, true);
 
@@ -889,6 +1001,17 @@ loop:
 		}
 	}
 
+	/*
+	 * As a last resort, return the frames cached on this CPU back to
+	 * their zones and retry. Frames cached on other CPUs remain out
+	 * of reach, but their number is bounded by FRAME_CACHE_SIZE per
+	 * CPU.
+	 */
+	if (znum == (size_t) -1) {
+		frame_cache_drain();
+		znum = try_find_zone(count, lowmem, frame_constraint, hint);
+	}
+
 	if (znum == (size_t) -1) {
 		if (flags & FRAME_ATOMIC) {
 			irq_spinlock_unlock(&zones.lock, true);
@@ -948,6 +1071,14 @@ loop:
 	pfn_t pfn = zone_frame_alloc(&zones.info[znum], count,
 	    frame_constraint) + zones.info[znum].base;
 
+	/*
+	 * We took the slow path for a request the cache could have
+	 * served, so the cache must have been empty. Refill it in one
+	 * batch while we still hold the zones lock.
+	 */
+	if ((count == 1) && (frame_constraint == 0) && (!pzone))
+		frame_cache_refill(znum);
+
 	irq_spinlock_unlock(&zones.lock, true);
 
 	if (pzone)
@@ -64,7 +64,9 @@
  * The CPU-bound magazine is actually a pair of magazines in order to avoid
  * thrashing when somebody is allocating/deallocating 1 item at the magazine
  * size boundary. LIFO order is enforced, which should avoid fragmentation
- * as much as possible.
+ * as much as possible. In addition, each CPU keeps one spare full magazine
+ * aside, so that an alloc/free cycle crossing the magazine boundary is
+ * satisfied locally and does not contend on the cache-wide magazine list.
  *
  * Every cache contains list of full slabs and list of partially full slabs.
  * Empty slabs are immediately freed (thrashing will be avoided because
@@ -378,11 +380,72 @@ _NO_TRACE static size_t magazine_destroy(slab_cache_t *cache,
 	size_t i;
 	size_t frames = 0;
 
+	/*
+	 * Call the destructors first. They may allocate memory, so they
+	 * must not be invoked with the slablock held.
+	 */
+	if (cache->destructor) {
+		for (i = 0; i < mag->busy; i++)
+			frames += cache->destructor(mag->objs[i]);
+	}
+
+	/*
+	 * Resolve the home slabs of the objects in advance; obj2slab()
+	 * takes the zones lock and must not be called with the slablock
+	 * held.
+	 */
+	slab_t *slabs[SLAB_MAG_SIZE];
+
+	assert(mag->busy <= SLAB_MAG_SIZE);
+
+	for (i = 0; i < mag->busy; i++)
+		slabs[i] = obj2slab(mag->objs[i]);
+
+	/*
+	 * Return all objects of the magazine under a single hold of the
+	 * slablock instead of taking it once per object. Completely freed
+	 * slabs are collected on a local list and their memory is released
+	 * only after the lock has been dropped.
+	 */
+	list_t empty_slabs;
+	list_initialize(&empty_slabs);
+
+	irq_spinlock_lock(&cache->slablock, true);
+
 	for (i = 0; i < mag->busy; i++) {
-		frames += slab_obj_destroy(cache, mag->objs[i], NULL);
+		void *obj = mag->objs[i];
+		slab_t *slab = slabs[i];
+
+		assert(slab->cache == cache);
+		assert(slab->available < cache->objects);
+
+		*((size_t *) obj) = slab->nextavail;
+		slab->nextavail = (obj - slab->start) / cache->size;
+		slab->available++;
+
+		/* Move it to correct list */
+		if (slab->available == cache->objects) {
+			list_remove(&slab->link);
+			list_prepend(&slab->link, &empty_slabs);
+		} else if (slab->available == 1) {
+			/* It was in full, move to partial */
+			list_remove(&slab->link);
+			list_prepend(&slab->link, &cache->partial_slabs);
+		}
+
 		atomic_dec(&cache->cached_objs);
 	}
 
+	irq_spinlock_unlock(&cache->slablock, true);
+
+	while (!list_empty(&empty_slabs)) {
+		slab_t *slab = list_get_instance(list_first(&empty_slabs),
+		    slab_t, link);
+
+		list_remove(&slab->link);
+		frames += slab_space_free(cache, slab);
+	}
+
 	slab_free(&mag_cache, mag);
 
 	return frames;
@@ -409,8 +472,16 @@ _NO_TRACE static slab_magazine_t *get_full_current_mag(slab_cache_t *cache)
 		}
 	}
 
-	/* Local magazines are empty, import one from magazine list */
-	slab_magazine_t *newmag = get_mag_from_cache(cache, 1);
+	/*
+	 * Local magazines are empty. Try the CPU-local spare first so that
+	 * the common refill does not contend on the cache-wide maglock.
+	 */
+	slab_magazine_t *newmag = cache->mag_cache[CPU->id].spare_full;
+	if (newmag)
+		cache->mag_cache[CPU->id].spare_full = NULL;
+	else
+		newmag = get_mag_from_cache(cache, 1);
+
 	if (!newmag)
 		return NULL;
 
@@ -492,9 +563,16 @@ _NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 	newmag->size = SLAB_MAG_SIZE;
 	newmag->busy = 0;
 
-	/* Flush last to magazine list */
-	if (lastmag)
-		put_mag_to_cache(cache, lastmag);
+	/*
+	 * Flush last to the CPU-local spare slot if it is vacant,
+	 * otherwise to the shared magazine list.
+	 */
+	if (lastmag) {
+		if (!cache->mag_cache[CPU->id].spare_full)
+			cache->mag_cache[CPU->id].spare_full = lastmag;
+		else
+			put_mag_to_cache(cache, lastmag);
+	}
 
 	/* Move current as last, save new as current */
 	cache->mag_cache[CPU->id].last = cmag;
@@ -696,6 +774,11 @@ _NO_TRACE static size_t _slab_reclaim(slab_cache_t *cache, unsigned int flags)
 				frames += magazine_destroy(cache, mag);
 			cache->mag_cache[i].last = NULL;
 
+			mag = cache->mag_cache[i].spare_full;
+			if (mag)
+				frames += magazine_destroy(cache, mag);
+			cache->mag_cache[i].spare_full = NULL;
+
 			irq_spinlock_unlock(&cache->mag_cache[i].lock, true);
 		}
 	}
@@ -35,12 +35,19 @@
  * @brief Generic TLB shootdown algorithm.
  *
  * The algorithm implemented here is based on the CMU TLB shootdown
- * algorithm and is further simplified (e.g. all CPUs receive all TLB
- * shootdown messages).
+ * algorithm. Shootdown messages are delivered only to processors on
+ * which the affected address space has been active; processors that
+ * cannot cache any of the invalidated translations merely synchronize
+ * with the sender. Adjacent page range invalidations are coalesced
+ * into a single message instead of degrading to a full TLB flush when
+ * the message queue overflows.
  */
 
 #include <mm/tlb.h>
+#include <mm/as.h>
 #include <mm/asid.h>
+#include <mm/page.h>
+#include <cpu/cpu_mask.h>
 #include <arch/mm/tlb.h>
 #include <assert.h>
 #include <smp/ipi.h>
@@ -51,6 +58,7 @@
 #include <arch.h>
 #include <panic.h>
 #include <cpu.h>
+#include <lattrace.h>
 
 void tlb_init(void)
 {
@@ -70,8 +78,9 @@ IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 /** Send TLB shootdown message.
  *
  * This function attempts to deliver TLB shootdown message
- * to all other processors.
+ * to all processors on which the address space may be active.
  *
+ * @param as    Affected address space or NULL if not known.
  * @param type  Type describing scope of shootdown.
  * @param asid  Address space, if required by type.
  * @param page  Virtual page address, if required by type.
@@ -80,22 +89,48 @@ IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
  * @return The interrupt priority level as it existed prior to this call.
  *
  */
-ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
+ipl_t tlb_shootdown_start(as_t *as, tlb_invalidate_type_t type, asid_t asid,
     uintptr_t page, size_t count)
 {
 	ipl_t ipl = interrupts_disable();
+	lattrace_section_begin(LATTRACE_IRQ, __builtin_return_address(0));
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 
+	/*
+	 * If the set of CPUs on which the address space has been active is
+	 * tracked, message only its members. The other CPUs cannot cache
+	 * any of the invalidated translations; they will find their queue
+	 * empty and only synchronize with us.
+	 */
+	bool targeted = (as != NULL) && (as->cpus != NULL);
+
 	size_t i;
 	for (i = 0; i < config.cpu_count; i++) {
 		if (i == CPU->id)
 			continue;
 
+		if ((targeted) && (!cpu_mask_is_set(as->cpus, i)))
+			continue;
+
 		cpu_t *cpu = &cpus[i];
 
 		irq_spinlock_lock(&cpu->lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
+
+		/*
+		 * Coalesce with the last queued message if both
+		 * invalidate adjacent page ranges in the same address
+		 * space.
+		 */
+		size_t cnt = cpu->tlb_messages_count;
+		tlb_shootdown_msg_t *prev =
+		    (cnt > 0) ? &cpu->tlb_messages[cnt - 1] : NULL;
+
+		if ((type == TLB_INVL_PAGES) && (prev) &&
+		    (prev->type == TLB_INVL_PAGES) && (prev->asid == asid) &&
+		    (prev->page + P2SZ(prev->count) == page)) {
+			prev->count += count;
+		} else if (cnt == TLB_MESSAGE_QUEUE_LEN) {
 			/*
 			 * The message queue is full.
 			 * Erase the queue and store one TLB_INVL_ALL message.
@@ -122,6 +157,10 @@ ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
 
 busy_wait:
 	for (i = 0; i < config.cpu_count; i++) {
+		if ((targeted) && (i != CPU->id) &&
+		    (!cpu_mask_is_set(as->cpus, i)))
+			continue;
+
 		if (cpus[i].tlb_active)
 			goto busy_wait;
 	}
@@ -138,9 +177,33 @@ void tlb_shootdown_finalize(ipl_t ipl)
 {
 	irq_spinlock_unlock(&tlblock, false);
 	CPU->tlb_active = true;
+	lattrace_section_end(LATTRACE_IRQ);
 	interrupts_restore(ipl);
 }
 
+/** Synchronize the current CPU with any in-flight TLB shootdown.
+ *
+ * Callers which make the current CPU a new member of an address
+ * space's CPU set use this to make sure that a shootdown sequence
+ * which read the set before the new bit became visible has finished
+ * before any of the affected translations can be cached here. Such a
+ * sequence neither messages nor waits for this CPU.
+ *
+ * Must be called with interrupts disabled. Interrupts are briefly
+ * enabled while the lock is contended, because the holder may be
+ * busy-waiting for this CPU to park in the shootdown IPI handler.
+ */
+void tlb_shootdown_barrier(void)
+{
+	assert(interrupts_disabled());
+
+	while (!irq_spinlock_trylock(&tlblock)) {
+		(void) interrupts_enable();
+		(void) interrupts_disable();
+	}
+	irq_spinlock_unlock(&tlblock, false);
+}
+
 void tlb_shootdown_ipi_send(void)
 {
 	ipi_broadcast(VECTOR_TLB_SHOOTDOWN_IPI);
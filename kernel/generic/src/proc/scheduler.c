@@ -47,12 +47,14 @@
 #include <mm/page.h>
 #include <mm/as.h>
 #include <time/timeout.h>
+#include <time/clock.h>
 #include <time/delay.h>
 #include <arch/asm.h>
 #include <arch/faddr.h>
 #include <arch/cycle.h>
 #include <atomic.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
 #include <config.h>
 #include <context.h>
 #include <fpu_context.h>
@@ -67,14 +69,83 @@
 
 static void scheduler_separated_stack(void);
 
+/**
+ * Extra number of ready threads a CPU outside of our last-level cache
+ * domain must have above the average before kcpulb migrates from it.
+ */
+#define KCPULB_CACHE_BIAS  2
+
 atomic_t nrdy;  /**< Number of ready threads in the system. */
 
+#ifdef CONFIG_FPU_LAZY
+/**
+ * Value of thread_t::fpu_counter at which the FPU context of a thread
+ * is restored eagerly on context switch instead of waiting for the
+ * lazy FPU trap.
+ */
+#define FPU_EAGER_THRESHOLD  4
+
+/** Cap of thread_t::fpu_counter. */
+#define FPU_COUNTER_MAX      8
+#endif
+
 /** Carry out actions before new task runs. */
 static void before_task_runs(void)
 {
 	before_task_runs_arch();
 }
 
+#ifdef CONFIG_FPU_LAZY
+/** Try to restore the FPU context ahead of the first FPU trap.
+ *
+ * A thread that took an FPU trap in each of its recent quanta is
+ * almost certain to take one again; restoring its context while
+ * switching to it saves the #NM exception round trip. Called with
+ * THREAD->lock held and interrupts disabled.
+ *
+ * @return True if the context was restored and the FPU enabled.
+ *
+ */
+static bool scheduler_fpu_eager_restore(void)
+{
+	if ((!THREAD->fpu_context_exists) ||
+	    (THREAD->fpu_counter < FPU_EAGER_THRESHOLD))
+		return false;
+
+	irq_spinlock_lock(&CPU->lock, false);
+
+	if (CPU->fpu_owner != NULL) {
+		/*
+		 * The old owner may be held by a third party locking in
+		 * the thread-first order (e.g. thread_destroy()); fall
+		 * back to the lazy trap rather than risk a deadlock.
+		 */
+		if (!irq_spinlock_trylock(&CPU->fpu_owner->lock)) {
+			irq_spinlock_unlock(&CPU->lock, false);
+			return false;
+		}
+
+		fpu_enable();
+		fpu_context_save(CPU->fpu_owner->saved_fpu_context);
+		CPU->fpu_owner->fpu_context_engaged = false;
+		irq_spinlock_unlock(&CPU->fpu_owner->lock, false);
+		CPU->fpu_owner = NULL;
+	} else
+		fpu_enable();
+
+	fpu_context_restore(THREAD->saved_fpu_context);
+	CPU->fpu_owner = THREAD;
+	THREAD->fpu_context_engaged = true;
+
+	/* Decay, so that threads which stop trapping go back to lazy. */
+	THREAD->fpu_counter--;
+
+	irq_spinlock_unlock(&CPU->lock, false);
+
+	return true;
+}
+#endif /* CONFIG_FPU_LAZY */
+
 /** Take actions before new thread runs.
  *
  * Perform actions that need to be
@@ -91,7 +162,7 @@ static void before_thread_runs(void)
 #ifdef CONFIG_FPU_LAZY
 	if (THREAD == CPU->fpu_owner)
 		fpu_enable();
-	else
+	else if (!scheduler_fpu_eager_restore())
 		fpu_disable();
 #elif defined CONFIG_FPU
 	fpu_enable();
@@ -155,6 +226,14 @@ void scheduler_fpu_lazy_request(void)
 		THREAD->fpu_context_exists = true;
 	}
 
+	/*
+	 * Taking the trap is the evidence of recent FPU use; raise the
+	 * counter towards the eager-restore threshold faster than the
+	 * eager path decays it.
+	 */
+	if (THREAD->fpu_counter < FPU_COUNTER_MAX)
+		THREAD->fpu_counter += 2;
+
 	CPU->fpu_owner = THREAD;
 	THREAD->fpu_context_engaged = true;
 	irq_spinlock_unlock(&THREAD->lock, false);
@@ -172,6 +251,134 @@ void scheduler_init(void)
 {
 }
 
+#ifdef CONFIG_SMP
+/** Steal a ready thread from another CPU
+ *
+ * Attempt to pull a runnable thread from the busiest remote run queue,
+ * so that an idle CPU does not have to sit idle until the kcpulb load
+ * balancer wakes up. Uses trylock on the victim's run queue locks in
+ * order not to add contention to the victim's hot path.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @return Stolen thread (in the Entering state, not enqueued anywhere)
+ *         or NULL if no suitable thread was found.
+ *
+ */
+static thread_t *steal_thread(void)
+{
+	/*
+	 * Pick the victim among the busiest remote CPUs, preferring
+	 * SMT siblings and CPUs sharing our last-level cache so that
+	 * the stolen thread finds its cache footprint still warm.
+	 * Victims with a single ready thread are not worth the
+	 * disruption.
+	 */
+	cpu_t *victim = NULL;
+	unsigned int victim_distance = 0;
+	size_t most = 1;
+
+	size_t i;
+	for (i = 0; i < config.cpu_active; i++) {
+		cpu_t *cpu = &cpus[i];
+		if (cpu == CPU)
+			continue;
+
+		size_t n = atomic_load(&cpu->nrdy);
+		if (n <= 1)
+			continue;
+
+		/* 0 for an SMT sibling, 1 for a shared cache, 2 for remote */
+		unsigned int distance;
+		if (cpu_shares_core(cpu, CPU))
+			distance = 0;
+		else if (cpu_shares_cache(cpu, CPU))
+			distance = 1;
+		else
+			distance = 2;
+
+		if (victim) {
+			if (distance > victim_distance)
+				continue;
+
+			if ((distance == victim_distance) && (n <= most))
+				continue;
+		}
+
+		victim = cpu;
+		victim_distance = distance;
+		most = n;
+	}
+
+	if (!victim)
+		return NULL;
+
+	/* Steal from the least priority queues first. */
+	int rq;
+	for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
+		if (!irq_spinlock_trylock(&(victim->rq[rq].lock)))
+			continue;
+
+		if (victim->rq[rq].n == 0) {
+			irq_spinlock_unlock(&(victim->rq[rq].lock), false);
+			continue;
+		}
+
+		thread_t *thread = NULL;
+
+		/* Search rq from the back */
+		link_t *link = list_last(&victim->rq[rq].rq);
+
+		while (link != NULL) {
+			thread = (thread_t *) list_get_instance(link,
+			    thread_t, rq_link);
+
+			/*
+			 * Do not steal CPU-wired threads, threads
+			 * already stolen, threads for which migration
+			 * was temporarily disabled or threads whose
+			 * FPU context is still in the victim CPU.
+			 */
+			irq_spinlock_lock(&thread->lock, false);
+
+			if ((!thread->wired) && (!thread->stolen) &&
+			    (!thread->nomigrate) &&
+			    (!thread->fpu_context_engaged)) {
+				irq_spinlock_unlock(&thread->lock, false);
+
+				atomic_dec(&victim->nrdy);
+				atomic_dec(&nrdy);
+
+				victim->rq[rq].n--;
+				list_remove(&thread->rq_link);
+
+				break;
+			}
+
+			irq_spinlock_unlock(&thread->lock, false);
+
+			link = list_prev(link, &victim->rq[rq].rq);
+			thread = NULL;
+		}
+
+		if (thread) {
+			irq_spinlock_pass(&(victim->rq[rq].lock),
+			    &thread->lock);
+
+			thread->stolen = true;
+			thread->state = Entering;
+
+			irq_spinlock_unlock(&thread->lock, false);
+			return thread;
+		}
+
+		irq_spinlock_unlock(&(victim->rq[rq].lock), false);
+	}
+
+	return NULL;
+}
+#endif /* CONFIG_SMP */
+
 /** Get thread to be scheduled
  *
  * Get the optimal thread to be scheduled
@@ -188,6 +395,18 @@ static thread_t *find_best_thread(void)
 loop:
 
 	if (atomic_load(&CPU->nrdy) == 0) {
+#ifdef CONFIG_SMP
+		/*
+		 * Try to steal a ready thread from a busier CPU before
+		 * going to sleep. This makes an idle CPU pick up work
+		 * immediately instead of waiting for kcpulb.
+		 */
+		thread_t *stolen = steal_thread();
+		if (stolen) {
+			thread_ready(stolen);
+			goto loop;
+		}
+#endif
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
@@ -196,6 +415,10 @@ loop:
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->idle = true;
 		irq_spinlock_unlock(&CPU->lock, false);
+
+		/* Stop the periodic tick while sleeping, if supported */
+		clock_idle_enter();
+
 		interrupts_enable();
 
 		/*
@@ -205,11 +428,38 @@ loop:
 		 */
 		cpu_sleep();
 		interrupts_disable();
+
+		clock_idle_exit();
 		goto loop;
 	}
 
 	assert(!CPU->idle);
 
+	/*
+	 * Deadline-class threads are always served before the normal
+	 * priority queues, earliest absolute deadline first.
+	 */
+	irq_spinlock_lock(&(CPU->deadline_rq.lock), false);
+	if (CPU->deadline_rq.n > 0) {
+		atomic_dec(&CPU->nrdy);
+		atomic_dec(&nrdy);
+		CPU->deadline_rq.n--;
+
+		thread_t *thread = list_get_instance(
+		    list_first(&CPU->deadline_rq.rq), thread_t, rq_link);
+		list_remove(&thread->rq_link);
+
+		irq_spinlock_pass(&(CPU->deadline_rq.lock), &thread->lock);
+
+		/* The execution budget doubles as the preemption quantum. */
+		thread->ticks = us2ticks(thread->deadline_budget) + 1;
+		thread->priority = 0;
+		irq_spinlock_unlock(&thread->lock, false);
+
+		return thread;
+	}
+	irq_spinlock_unlock(&(CPU->deadline_rq.lock), false);
+
 	unsigned int i;
 	for (i = 0; i < RQ_COUNT; i++) {
 		irq_spinlock_lock(&(CPU->rq[i].lock), false);
@@ -401,6 +651,12 @@ void scheduler_separated_stack(void)
 	if (old_as)
 		as_hold(old_as);
 
+	/*
+	 * A pass through the scheduler is a quiescent state with respect
+	 * to RCU: no read-side critical section may span it.
+	 */
+	rcu_quiescent_point();
+
 	if (THREAD) {
 		/* Must be run after the switch to scheduler stack */
 		after_thread_ran();
@@ -505,6 +761,8 @@ void scheduler_separated_stack(void)
 	if (old_as)
 		as_release(old_as);
 
+	cpu_count_event(STATS_EVENT_CTX_SWITCH);
+
 	irq_spinlock_lock(&THREAD->lock, false);
 	THREAD->state = Running;
 
@@ -600,6 +858,16 @@ not_satisfied:
 			if (atomic_load(&cpu->nrdy) <= average)
 				continue;
 
+			/*
+			 * Migrating a thread across the last-level cache
+			 * boundary loses its cache footprint, so require
+			 * a larger imbalance before doing so.
+			 */
+			if ((!cpu_shares_cache(cpu, CPU)) &&
+			    (atomic_load(&cpu->nrdy) <=
+			    average + KCPULB_CACHE_BIAS))
+				continue;
+
 			irq_spinlock_lock(&(cpu->rq[rq].lock), true);
 			if (cpu->rq[rq].n == 0) {
 				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
@@ -47,7 +47,7 @@
 #include <arch.h>
 #include <barrier.h>
 #include <adt/list.h>
-#include <adt/odict.h>
+#include <adt/obtree.h>
 #include <cap/cap.h>
 #include <ipc/ipc.h>
 #include <ipc/ipcrsc.h>
@@ -64,7 +64,8 @@ IRQ_SPINLOCK_INITIALIZE(tasks_lock);
 
 /** Ordered dictionary of active tasks by task ID.
  *
- * Members are task_t structures.
+ * Members are task_t structures. The dictionary is B-tree backed as
+ * it can grow large and is looked up on hot paths (e.g. IPC).
  *
  * The task is guaranteed to exist after it was found in the @c tasks
  * dictionary as long as:
@@ -75,7 +76,7 @@ IRQ_SPINLOCK_INITIALIZE(tasks_lock);
  * @li the task's refcount is greater than 0
  *
  */
-odict_t tasks;
+obtree_t tasks;
 
 static task_id_t task_counter = 0;
 
@@ -86,7 +87,7 @@ static void task_kill_internal(task_t *);
 static errno_t tsk_constructor(void *, unsigned int);
 static size_t tsk_destructor(void *);
 
-static void *tasks_getkey(odlink_t *);
+static void *tasks_getkey(obt_link_t *);
 static int tasks_cmp(void *, void *);
 
 /** Initialize kernel tasks support.
@@ -95,7 +96,7 @@ static int tasks_cmp(void *, void *);
 void task_init(void)
 {
 	TASK = NULL;
-	odict_initialize(&tasks, tasks_getkey, tasks_cmp);
+	obtree_initialize(&tasks, tasks_getkey, tasks_cmp);
 	task_cache = slab_cache_create("task_t", sizeof(task_t), 0,
 	    tsk_constructor, tsk_destructor, 0);
 }
@@ -252,8 +253,14 @@ task_t *task_create(as_t *as, const char *name)
 	irq_spinlock_lock(&tasks_lock, true);
 
 	task->taskid = ++task_counter;
-	odlink_initialize(&task->ltasks);
-	odict_insert(&task->ltasks, &tasks, NULL);
+	obt_link_initialize(&task->ltasks);
+	if (obtree_insert(&task->ltasks, &tasks) != EOK) {
+		irq_spinlock_unlock(&tasks_lock, true);
+		task->as = NULL;
+		task_destroy_arch(task);
+		slab_free(task_cache, task);
+		return NULL;
+	}
 
 	irq_spinlock_unlock(&tasks_lock, true);
 
@@ -268,10 +275,10 @@ task_t *task_create(as_t *as, const char *name)
 void task_destroy(task_t *task)
 {
 	/*
-	 * Remove the task from the task odict.
+	 * Remove the task from the task dictionary.
 	 */
 	irq_spinlock_lock(&tasks_lock, true);
-	odict_remove(&task->ltasks);
+	obtree_remove(&task->ltasks);
 	irq_spinlock_unlock(&tasks_lock, true);
 
 	/*
@@ -428,9 +435,9 @@ task_t *task_find_by_id(task_id_t id)
 	assert(interrupts_disabled());
 	assert(irq_spinlock_locked(&tasks_lock));
 
-	odlink_t *odlink = odict_find_eq(&tasks, &id, NULL);
-	if (odlink != NULL)
-		return odict_get_instance(odlink, task_t, ltasks);
+	obt_link_t *olink = obtree_find_eq(&tasks, &id);
+	if (olink != NULL)
+		return obtree_get_instance(olink, task_t, ltasks);
 
 	return NULL;
 }
@@ -444,7 +451,7 @@ size_t task_count(void)
 	assert(interrupts_disabled());
 	assert(irq_spinlock_locked(&tasks_lock));
 
-	return odict_count(&tasks);
+	return obtree_count(&tasks);
 }
 
 /** Get first task (task with lowest ID).
@@ -453,16 +460,16 @@ size_t task_count(void)
  */
 task_t *task_first(void)
 {
-	odlink_t *odlink;
+	obt_link_t *olink;
 
 	assert(interrupts_disabled());
 	assert(irq_spinlock_locked(&tasks_lock));
 
-	odlink = odict_first(&tasks);
-	if (odlink == NULL)
+	olink = obtree_first(&tasks);
+	if (olink == NULL)
 		return NULL;
 
-	return odict_get_instance(odlink, task_t, ltasks);
+	return obtree_get_instance(olink, task_t, ltasks);
 }
 
 /** Get next task (with higher task ID).
@@ -472,16 +479,16 @@ task_t *task_first(void)
  */
 task_t *task_next(task_t *cur)
 {
-	odlink_t *odlink;
+	obt_link_t *olink;
 
 	assert(interrupts_disabled());
 	assert(irq_spinlock_locked(&tasks_lock));
 
-	odlink = odict_next(&cur->ltasks, &tasks);
-	if (odlink == NULL)
+	olink = obtree_next(&cur->ltasks, &tasks);
+	if (olink == NULL)
 		return NULL;
 
-	return odict_get_instance(odlink, task_t, ltasks);
+	return obtree_get_instance(olink, task_t, ltasks);
 }
 
 /** Get accounting data of given task.
@@ -701,12 +708,12 @@ void task_print_list(bool additional)
 
 /** Get key function for the @c tasks ordered dictionary.
  *
- * @param odlink Link
+ * @param olink Link
  * @return Pointer to task ID cast as 'void *'
  */
-static void *tasks_getkey(odlink_t *odlink)
+static void *tasks_getkey(obt_link_t *olink)
 {
-	task_t *task = odict_get_instance(odlink, task_t, ltasks);
+	task_t *task = obtree_get_instance(olink, task_t, ltasks);
 	return (void *) &task->taskid;
 }
 
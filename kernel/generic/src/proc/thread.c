@@ -48,6 +48,7 @@
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/sysfutex.h>
 #include <cpu.h>
 #include <str.h>
 #include <context.h>
@@ -242,6 +243,14 @@ void thread_init(void)
 	THREAD = NULL;
 
 	atomic_store(&nrdy, 0);
+
+	/*
+	 * The constructor and destructor own the kernel stack, so retired
+	 * thread structures cached in the per-CPU slab magazines keep
+	 * their stacks mapped and creating a thread is a magazine
+	 * operation in the common case. The magazines are bounded and are
+	 * drained by slab_reclaim() when the frame allocator runs short.
+	 */
 	thread_cache = slab_cache_create("thread_t", sizeof(thread_t), 0,
 	    thr_constructor, thr_destructor, 0);
 
@@ -272,6 +281,13 @@ static void before_thread_is_ready(thread_t *thread)
 	assert(irq_spinlock_locked(&thread->lock));
 }
 
+/** Compute the utilization of a deadline-class thread in per mille. */
+static size_t deadline_util(uint32_t period, uint32_t budget)
+{
+	size_t util = ((size_t) budget) * 1000 / period;
+	return (util > 0) ? util : 1;
+}
+
 /** Make thread ready
  *
  * Switch thread to the ready state.
@@ -287,6 +303,43 @@ void thread_ready(thread_t *thread)
 
 	before_thread_is_ready(thread);
 
+	if (thread->sched_class == SCHED_CLASS_DEADLINE) {
+		/*
+		 * A new activation of a deadline-class thread: stamp it
+		 * with its absolute deadline and insert it into the
+		 * deadline queue of its CPU, keeping the queue ordered
+		 * by deadlines. Deadline threads are pinned to the CPU
+		 * on which they were admitted.
+		 */
+		assert(thread->cpu != NULL);
+		cpu_t *dcpu = thread->cpu;
+
+		thread->deadline = uptime_useconds() + thread->deadline_period;
+		thread->state = Ready;
+
+		irq_spinlock_pass(&thread->lock, &(dcpu->deadline_rq.lock));
+
+		link_t *pos = NULL;
+		list_foreach(dcpu->deadline_rq.rq, rq_link, thread_t, cur) {
+			if (cur->deadline > thread->deadline) {
+				pos = &cur->rq_link;
+				break;
+			}
+		}
+
+		if (pos != NULL)
+			list_insert_before(&thread->rq_link, pos);
+		else
+			list_append(&thread->rq_link, &dcpu->deadline_rq.rq);
+
+		dcpu->deadline_rq.n++;
+		irq_spinlock_unlock(&(dcpu->deadline_rq.lock), true);
+
+		atomic_inc(&nrdy);
+		atomic_inc(&dcpu->nrdy);
+		return;
+	}
+
 	int i = (thread->priority < RQ_COUNT - 1) ?
 	    ++thread->priority : thread->priority;
 
@@ -302,6 +355,24 @@ void thread_ready(thread_t *thread)
 		/* Prefer the CPU on which the thread ran last */
 		assert(thread->cpu != NULL);
 		cpu = thread->cpu;
+
+		/*
+		 * If the last CPU is busy while an idle SMT sibling of it
+		 * is available, wake up on the sibling instead: it shares
+		 * the thread's cache footprint and can run it immediately.
+		 */
+		if (atomic_load(&cpu->nrdy) > 0) {
+			for (size_t k = 0; k < config.cpu_active; k++) {
+				cpu_t *sibling = &cpus[k];
+
+				if ((sibling != cpu) &&
+				    (cpu_shares_core(sibling, cpu)) &&
+				    (atomic_load(&sibling->nrdy) == 0)) {
+					cpu = sibling;
+					break;
+				}
+			}
+		}
 	} else {
 		cpu = CPU;
 	}
@@ -350,8 +421,18 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 		return NULL;
 	}
 
-	/* Not needed, but good for debugging */
+#ifdef CONFIG_DEBUG
+	/*
+	 * Not needed, but good for debugging. The kernel stack is never
+	 * exposed to user space and everything that is read from it is
+	 * written first (the CURRENT structure below, saved contexts and
+	 * istates as the thread runs), so production builds skip the
+	 * zeroing. Thread structures are recycled through the slab
+	 * magazine layer with their kernel stacks kept mapped and zeroing
+	 * the whole stack would dominate the create fast path.
+	 */
 	memsetb(thread->kstack, STACK_SIZE, 0);
+#endif
 
 	irq_spinlock_lock(&tidlock, true);
 	thread->tid = ++last_tid;
@@ -377,6 +458,10 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->uncounted =
 	    ((flags & THREAD_FLAG_UNCOUNTED) == THREAD_FLAG_UNCOUNTED);
 	thread->priority = -1;          /* Start in rq[0] */
+	thread->sched_class = SCHED_CLASS_NORMAL;
+	thread->deadline_period = 0;
+	thread->deadline_budget = 0;
+	thread->deadline = 0;
 	thread->cpu = NULL;
 	thread->wired = false;
 	thread->stolen = false;
@@ -403,6 +488,7 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 
 	thread->fpu_context_exists = false;
 	thread->fpu_context_engaged = false;
+	thread->fpu_counter = 0;
 
 	odlink_initialize(&thread->lthreads);
 
@@ -437,6 +523,12 @@ void thread_destroy(thread_t *thread, bool irq_res)
 	irq_spinlock_lock(&thread->cpu->lock, false);
 	if (thread->cpu->fpu_owner == thread)
 		thread->cpu->fpu_owner = NULL;
+
+	/* Release the admitted utilization of a deadline-class thread. */
+	if (thread->sched_class == SCHED_CLASS_DEADLINE)
+		thread->cpu->deadline_load -= deadline_util(
+		    thread->deadline_period, thread->deadline_budget);
+
 	irq_spinlock_unlock(&thread->cpu->lock, false);
 
 	irq_spinlock_pass(&thread->lock, &threads_lock);
@@ -522,6 +614,7 @@ void thread_exit(void)
 			 */
 			ipc_cleanup();
 			sys_waitq_task_cleanup();
+			sys_futex_task_cleanup();
 			LOG("Cleanup of task %" PRIu64 " completed.", TASK->taskid);
 		}
 	}
@@ -1113,5 +1206,89 @@ sys_errno_t sys_thread_udelay(uint32_t usec)
 	return 0;
 }
 
+/** Syscall to set the scheduling class of the calling thread.
+ *
+ * With a non-zero period, the calling thread joins the
+ * earliest-deadline-first class: each time it becomes ready it is
+ * stamped with the deadline of now + period and served before all
+ * normal-class threads, earliest deadline first. The budget declares
+ * the worst-case execution time per period and is used both for
+ * admission control and as the thread's preemption quantum. Deadline
+ * threads are pinned to the CPU on which they were admitted.
+ *
+ * With both arguments zero, the thread returns to the normal class.
+ *
+ * @param period Activation period and relative deadline (us).
+ * @param budget Execution budget per period (us).
+ *
+ * @return EOK on success.
+ * @return EINVAL if the budget is zero or exceeds the period.
+ * @return ELIMIT if the admission would overload the CPU.
+ *
+ */
+sys_errno_t sys_thread_set_deadline(uint32_t period, uint32_t budget)
+{
+	if ((period == 0) && (budget == 0)) {
+		/* Return to the normal class. */
+		irq_spinlock_lock(&THREAD->lock, true);
+		if (THREAD->sched_class != SCHED_CLASS_DEADLINE) {
+			irq_spinlock_unlock(&THREAD->lock, true);
+			return EOK;
+		}
+
+		irq_spinlock_lock(&THREAD->cpu->lock, false);
+		THREAD->cpu->deadline_load -= deadline_util(
+		    THREAD->deadline_period, THREAD->deadline_budget);
+		irq_spinlock_unlock(&THREAD->cpu->lock, false);
+
+		THREAD->sched_class = SCHED_CLASS_NORMAL;
+		THREAD->deadline_period = 0;
+		THREAD->deadline_budget = 0;
+		THREAD->nomigrate--;
+		irq_spinlock_unlock(&THREAD->lock, true);
+
+		return EOK;
+	}
+
+	if ((budget == 0) || (budget > period))
+		return (sys_errno_t) EINVAL;
+
+	size_t util = deadline_util(period, budget);
+
+	/*
+	 * Admission control: the total declared utilization of the
+	 * deadline threads on one CPU must not exceed DEADLINE_LOAD_MAX.
+	 * The thread is admitted on the CPU it is currently running on
+	 * (or was previously admitted on when changing parameters).
+	 */
+	irq_spinlock_lock(&THREAD->lock, true);
+
+	size_t old_util = (THREAD->sched_class == SCHED_CLASS_DEADLINE) ?
+	    deadline_util(THREAD->deadline_period, THREAD->deadline_budget) :
+	    0;
+	cpu_t *cpu = THREAD->cpu;
+
+	irq_spinlock_lock(&cpu->lock, false);
+	if (cpu->deadline_load - old_util + util > DEADLINE_LOAD_MAX) {
+		irq_spinlock_unlock(&cpu->lock, false);
+		irq_spinlock_unlock(&THREAD->lock, true);
+		return (sys_errno_t) ELIMIT;
+	}
+
+	cpu->deadline_load += util - old_util;
+	irq_spinlock_unlock(&cpu->lock, false);
+
+	if (THREAD->sched_class != SCHED_CLASS_DEADLINE) {
+		THREAD->sched_class = SCHED_CLASS_DEADLINE;
+		/* Pin the thread to the CPU its admission was done on. */
+		THREAD->nomigrate++;
+	}
+	THREAD->deadline_period = period;
+	THREAD->deadline_budget = budget;
+	irq_spinlock_unlock(&THREAD->lock, true);
+
+	return EOK;
+}
+
 /** @}
  */
@@ -36,6 +36,7 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <errno.h>
 #include <synch/mutex.h>
 #include <synch/semaphore.h>
@@ -70,6 +71,42 @@ bool mutex_locked(mutex_t *mtx)
 
 #define MUTEX_DEADLOCK_THRESHOLD	100000000
 
+/** Upper bound on optimistic spinning before going to sleep. */
+#define MUTEX_SPIN_THRESHOLD		250
+
+/** Try to acquire a contended mutex by spinning for a short while.
+ *
+ * Most kernel critical sections are only tens of cycles long, so when
+ * the owner is running on another processor, a short spin is much
+ * cheaper than the sleep/wakeup round trip through the wait queue.
+ *
+ * Thread structures are not type-stable, so the owner cannot be safely
+ * examined to see whether it is still running; the spin is instead
+ * bounded by a fixed budget, after which the caller blocks. The spin is
+ * abandoned early when the owner goes away, as the next attempt to take
+ * the semaphore down would only race with the woken-up waiters.
+ *
+ * @param mtx Mutex to be acquired.
+ *
+ * @return True if the mutex was acquired, false if it is time to block.
+ *
+ */
+static bool mutex_trydown_spin(mutex_t *mtx)
+{
+	if (config.cpu_active == 1)
+		return false;
+
+	for (unsigned int cnt = 0; cnt < MUTEX_SPIN_THRESHOLD; cnt++) {
+		if (semaphore_trydown(&mtx->sem) == EOK)
+			return true;
+
+		if (mtx->owner == NULL)
+			return false;
+	}
+
+	return false;
+}
+
 /** Acquire mutex.
  *
  * Timeout mode and non-blocking mode can be requested.
@@ -89,7 +126,13 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 	errno_t rc;
 
 	if (mtx->type == MUTEX_PASSIVE && THREAD) {
-		rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+		if (!(flags & SYNCH_FLAGS_NON_BLOCKING) &&
+		    mutex_trydown_spin(mtx))
+			rc = EOK;
+		else
+			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+		if (rc == EOK)
+			mtx->owner = THREAD;
 	} else if (mtx->type == MUTEX_RECURSIVE) {
 		assert(THREAD);
 
@@ -97,7 +140,12 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 			mtx->nesting++;
 			return EOK;
 		} else {
-			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+			if (!(flags & SYNCH_FLAGS_NON_BLOCKING) &&
+			    mutex_trydown_spin(mtx))
+				rc = EOK;
+			else
+				rc = _semaphore_down_timeout(&mtx->sem, usec,
+				    flags);
 			if (rc == EOK) {
 				mtx->owner = THREAD;
 				mtx->nesting = 1;
@@ -138,6 +186,8 @@ void mutex_unlock(mutex_t *mtx)
 		if (--mtx->nesting > 0)
 			return;
 		mtx->owner = NULL;
+	} else if (mtx->type == MUTEX_PASSIVE) {
+		mtx->owner = NULL;
 	}
 	semaphore_up(&mtx->sem);
 }
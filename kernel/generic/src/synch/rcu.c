@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2012 Adam Hraska
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Read-copy-update synchronization.
+ *
+ * This is a classic, scheduler-based RCU implementation. A read-side
+ * critical section merely disables preemption, which makes readers
+ * practically free. Writers first unlink the item being removed so that
+ * no new reader can find it and then call synchronize_rcu(), which
+ * blocks until every CPU has passed through a quiescent state - a pass
+ * through the scheduler or idle sleep. Since readers cannot block or be
+ * preempted, after a grace period elapses no reader can hold a
+ * reference to the unlinked item and it can be freed.
+ *
+ * The grace period detection is driven by a per-CPU counter that the
+ * scheduler increments on every pass via rcu_quiescent_point(). An idle
+ * CPU cannot execute a reader, so it counts as quiescent without being
+ * disturbed. Readers running in interrupt handlers are honored by
+ * pairing a memory barrier in synchronize_rcu() with the one executed
+ * by exc_dispatch() after it clears CPU->idle: either the updater
+ * observes that the CPU is no longer idle, or the handler is
+ * guaranteed to observe the updater's removals.
+ */
+
+#include <assert.h>
+#include <synch/rcu.h>
+#include <atomic.h>
+#include <barrier.h>
+#include <cpu.h>
+#include <config.h>
+#include <proc/thread.h>
+#include <arch.h>
+
+/** Interval between grace period polls in microseconds. */
+#define RCU_POLL_INTERVAL  500
+
+/** Record a quiescent state of the current CPU.
+ *
+ * Called by the scheduler on every pass with interrupts disabled.
+ */
+void rcu_quiescent_point(void)
+{
+	atomic_inc(&CPU->rcu_passes);
+}
+
+/** Wait for a grace period to elapse.
+ *
+ * Blocks until every reader that was running when this function was
+ * called has finished its read-side critical section. May only be
+ * called from preemptible thread context.
+ */
+void synchronize_rcu(void)
+{
+	assert(THREAD);
+	assert(!PREEMPTION_DISABLED);
+	assert(!interrupts_disabled());
+
+	/*
+	 * Order the caller's removal of the old version before the idle
+	 * checks below. Together with the barrier which exc_dispatch()
+	 * executes after clearing CPU->idle, this guarantees that when a
+	 * CPU is still seen as idle here, any reader which an interrupt
+	 * taken from that idle loop may be running has already observed
+	 * the removal.
+	 */
+	memory_barrier();
+
+	size_t i;
+	for (i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if (!cpu->active)
+			continue;
+
+		/*
+		 * Wait until the CPU passes through the scheduler or goes
+		 * idle. Either way, any reader that was running on it when
+		 * we took the snapshot is gone. The waiting order does not
+		 * matter; once a CPU is quiescent with respect to us, it
+		 * cannot resurrect an old reader.
+		 */
+		size_t passes = atomic_load(&cpu->rcu_passes);
+
+		while ((!cpu->idle) &&
+		    (atomic_load(&cpu->rcu_passes) == passes)) {
+			thread_usleep(RCU_POLL_INTERVAL);
+			memory_barrier();
+		}
+	}
+}
+
+/** @}
+ */
@@ -45,6 +45,7 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <lattrace.h>
 
 #ifdef CONFIG_SMP
 
@@ -55,7 +56,8 @@
  */
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
-	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
+	atomic_store_explicit(&lock->next_ticket, 0, memory_order_relaxed);
+	atomic_store_explicit(&lock->owner_ticket, 0, memory_order_relaxed);
 #ifdef CONFIG_DEBUG_SPINLOCK
 	lock->name = name;
 #endif
@@ -78,7 +80,10 @@ void spinlock_lock_debug(spinlock_t *lock)
 	bool deadlock_reported = false;
 
 	preemption_disable();
-	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+	unsigned short ticket = atomic_fetch_add_explicit(&lock->next_ticket, 1,
+	    memory_order_relaxed);
+	while (atomic_load_explicit(&lock->owner_ticket,
+	    memory_order_acquire) != ticket) {
 		/*
 		 * We need to be careful about particular locks
 		 * which are directly used to report deadlocks
@@ -126,7 +131,10 @@ void spinlock_unlock_debug(spinlock_t *lock)
 {
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+	/* Only the lock owner ever stores to owner_ticket. */
+	atomic_store_explicit(&lock->owner_ticket,
+	    atomic_load_explicit(&lock->owner_ticket,
+	    memory_order_relaxed) + 1, memory_order_release);
 	preemption_enable();
 }
 
@@ -145,7 +153,18 @@ void spinlock_unlock_debug(spinlock_t *lock)
 bool spinlock_trylock(spinlock_t *lock)
 {
 	preemption_disable();
-	bool ret = !atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire);
+
+	/*
+	 * Draw a ticket only if it would be served immediately, i.e. if
+	 * no other ticket is drawn or being served. Unlike spinlock_lock(),
+	 * this cannot use an unconditional fetch-and-add as a drawn ticket
+	 * cannot be returned without waiting for the turn.
+	 */
+	unsigned short owner = atomic_load_explicit(&lock->owner_ticket,
+	    memory_order_relaxed);
+	bool ret = atomic_compare_exchange_strong_explicit(&lock->next_ticket,
+	    &owner, (unsigned short) (owner + 1), memory_order_acquire,
+	    memory_order_relaxed);
 
 	if (!ret)
 		preemption_enable();
@@ -160,15 +179,13 @@ bool spinlock_trylock(spinlock_t *lock)
  */
 bool spinlock_locked(spinlock_t *lock)
 {
-	// NOTE: Atomic flag doesn't support simple atomic read (by design),
-	//       so instead we test_and_set and then clear if necessary.
+	// NOTE: The lock is held (or about to be held by a waiter that
+	//       already drew its ticket) whenever the two tickets differ.
 	//       This function is only used inside assert, so we don't need
 	//       any preemption_disable/enable here.
 
-	bool ret = atomic_flag_test_and_set_explicit(&lock->flag, memory_order_relaxed);
-	if (!ret)
-		atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-	return ret;
+	return atomic_load_explicit(&lock->next_ticket, memory_order_relaxed) !=
+	    atomic_load_explicit(&lock->owner_ticket, memory_order_relaxed);
 }
 
 #endif
@@ -199,6 +216,8 @@ void irq_spinlock_lock(irq_spinlock_t *lock, bool irq_dis)
 {
 	if (irq_dis) {
 		ipl_t ipl = interrupts_disable();
+		lattrace_section_begin(LATTRACE_IRQ,
+		    __builtin_return_address(0));
 		spinlock_lock(&(lock->lock));
 
 		lock->guard = true;
@@ -231,6 +250,7 @@ void irq_spinlock_unlock(irq_spinlock_t *lock, bool irq_res)
 		ipl_t ipl = lock->ipl;
 
 		spinlock_unlock(&(lock->lock));
+		lattrace_section_end(LATTRACE_IRQ);
 		interrupts_restore(ipl);
 	} else {
 		ASSERT_IRQ_SPINLOCK(!lock->guard, lock);
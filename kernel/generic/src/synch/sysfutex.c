@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2018 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Futexes addressable by userspace virtual address.
+ *
+ * A futex is a wait queue that the kernel creates on demand, keyed by
+ * the owning task and the userspace virtual address of the futex word.
+ * Userspace thus does not have to allocate a wait queue capability for
+ * every lock it creates; only locks that actually experience contention
+ * ever get a kernel object.
+ *
+ * The wait queue of a futex keeps track of missed wakeups, so a wakeup
+ * that races with the sleeper still entering the kernel is not lost.
+ * Because of this, a futex must stay allocated for as long as its task
+ * can sleep on it. Futexes are therefore only deallocated when their
+ * task exits.
+ */
+
+#include <synch/sysfutex.h>
+#include <errno.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <mm/slab.h>
+#include <proc/task.h>
+#include <udebug/udebug.h>
+
+#include <stdint.h>
+
+/** Kernel representation of a userspace futex. */
+typedef struct {
+	ht_link_t link;
+	/** Task which owns the futex. */
+	task_t *task;
+	/** Userspace virtual address of the futex word. */
+	uspace_addr_t uaddr;
+	/** Wait queue for threads sleeping on the futex. */
+	waitq_t wq;
+} futex_t;
+
+/** Lookup key of a futex. */
+typedef struct {
+	task_t *task;
+	uspace_addr_t uaddr;
+} futex_key_t;
+
+static slab_cache_t *futex_cache;
+
+/** Table of all futexes in the system, keyed by (task, uaddr). */
+static hash_table_t futex_ht;
+IRQ_SPINLOCK_STATIC_INITIALIZE(futex_ht_lock);
+
+static size_t futex_ht_hash(const ht_link_t *item)
+{
+	futex_t *futex = hash_table_get_inst(item, futex_t, link);
+	return hash_combine((uintptr_t) futex->task, futex->uaddr);
+}
+
+static size_t futex_ht_key_hash(const void *arg)
+{
+	const futex_key_t *key = arg;
+	return hash_combine((uintptr_t) key->task, key->uaddr);
+}
+
+static bool futex_ht_key_equal(const void *arg, const ht_link_t *item)
+{
+	const futex_key_t *key = arg;
+	futex_t *futex = hash_table_get_inst(item, futex_t, link);
+	return (key->task == futex->task) && (key->uaddr == futex->uaddr);
+}
+
+static hash_table_ops_t futex_ht_ops = {
+	.hash = futex_ht_hash,
+	.key_hash = futex_ht_key_hash,
+	.key_equal = futex_ht_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the futex subsystem */
+void sys_futex_init(void)
+{
+	futex_cache = slab_cache_create("futex_t", sizeof(futex_t), 0, NULL,
+	    NULL, 0);
+	hash_table_create(&futex_ht, 0, 0, &futex_ht_ops);
+}
+
+/** Find the futex for the given address, creating it if necessary.
+ *
+ * Once inserted, a futex stays in the table until its task exits, so
+ * the returned pointer remains valid after the table lock is dropped.
+ *
+ * @param uaddr Userspace virtual address of the futex word.
+ *
+ * @return Futex of the current task for uaddr or NULL on allocation
+ *         failure.
+ */
+static futex_t *futex_find(uspace_addr_t uaddr)
+{
+	futex_key_t key = {
+		.task = TASK,
+		.uaddr = uaddr
+	};
+
+	irq_spinlock_lock(&futex_ht_lock, true);
+
+	futex_t *futex;
+	ht_link_t *link = hash_table_find(&futex_ht, &key);
+	if (link) {
+		futex = hash_table_get_inst(link, futex_t, link);
+	} else {
+		futex = slab_alloc(futex_cache, FRAME_ATOMIC);
+		if (futex) {
+			futex->task = TASK;
+			futex->uaddr = uaddr;
+			waitq_initialize(&futex->wq);
+			hash_table_insert(&futex_ht, &futex->link);
+		}
+	}
+
+	irq_spinlock_unlock(&futex_ht_lock, true);
+
+	return futex;
+}
+
+static bool futex_task_cleanup_cb(ht_link_t *link, void *arg)
+{
+	futex_t *futex = hash_table_get_inst(link, futex_t, link);
+
+	if (futex->task == TASK) {
+		hash_table_remove_item(&futex_ht, &futex->link);
+		slab_free(futex_cache, futex);
+	}
+
+	return true;
+}
+
+/** Destroy all futexes of the exiting task */
+void sys_futex_task_cleanup(void)
+{
+	irq_spinlock_lock(&futex_ht_lock, true);
+	hash_table_apply(&futex_ht, futex_task_cleanup_cb, NULL);
+	irq_spinlock_unlock(&futex_ht_lock, true);
+}
+
+/** Sleep in the futex of the current task for the given address
+ *
+ * @param uaddr    Userspace virtual address of the futex word.
+ * @param timeout  Timeout in microseconds.
+ * @param flags    Flags from SYNCH_FLAGS_* family. SYNCH_FLAGS_INTERRUPTIBLE
+ *                 is always implied.
+ *
+ * @return         Error code.
+ */
+sys_errno_t sys_futex_sleep(uspace_addr_t uaddr, uint32_t timeout,
+    unsigned int flags)
+{
+	futex_t *futex = futex_find(uaddr);
+	if (!futex)
+		return (sys_errno_t) ENOMEM;
+
+#ifdef CONFIG_UDEBUG
+	udebug_stoppable_begin();
+#endif
+
+	errno_t rc = waitq_sleep_timeout(&futex->wq, timeout,
+	    SYNCH_FLAGS_INTERRUPTIBLE | flags, NULL);
+
+#ifdef CONFIG_UDEBUG
+	udebug_stoppable_end();
+#endif
+
+	return (sys_errno_t) rc;
+}
+
+/** Wakeup one thread sleeping in the futex for the given address
+ *
+ * If no thread sleeps in the futex yet, the wakeup is remembered by the
+ * futex wait queue so that it is not lost when the sleeper arrives.
+ *
+ * @param uaddr  Userspace virtual address of the futex word.
+ *
+ * @return       Error code.
+ */
+sys_errno_t sys_futex_wakeup(uspace_addr_t uaddr)
+{
+	futex_t *futex = futex_find(uaddr);
+	if (!futex)
+		return (sys_errno_t) ENOMEM;
+
+	waitq_wakeup(&futex->wq, WAKEUP_FIRST);
+
+	return (sys_errno_t) EOK;
+}
+
+/** @}
+ */
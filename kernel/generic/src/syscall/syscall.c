@@ -42,11 +42,13 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <arch.h>
+#include <cpu.h>
 #include <debug.h>
 #include <interrupt.h>
 #include <ipc/sysipc.h>
 #include <synch/smc.h>
 #include <synch/syswaitq.h>
+#include <synch/sysfutex.h>
 #include <ddi/ddi.h>
 #include <ipc/event.h>
 #include <security/perm.h>
@@ -65,6 +67,7 @@ static syshandler_t syscall_table[] = {
 	[SYS_THREAD_GET_ID] = (syshandler_t) sys_thread_get_id,
 	[SYS_THREAD_USLEEP] = (syshandler_t) sys_thread_usleep,
 	[SYS_THREAD_UDELAY] = (syshandler_t) sys_thread_udelay,
+	[SYS_THREAD_SET_DEADLINE] = (syshandler_t) sys_thread_set_deadline,
 
 	[SYS_TASK_GET_ID] = (syshandler_t) sys_task_get_id,
 	[SYS_TASK_SET_NAME] = (syshandler_t) sys_task_set_name,
@@ -77,11 +80,14 @@ static syshandler_t syscall_table[] = {
 	[SYS_WAITQ_SLEEP] = (syshandler_t) sys_waitq_sleep,
 	[SYS_WAITQ_WAKEUP] = (syshandler_t) sys_waitq_wakeup,
 	[SYS_WAITQ_DESTROY] = (syshandler_t) sys_waitq_destroy,
+	[SYS_FUTEX_SLEEP] = (syshandler_t) sys_futex_sleep,
+	[SYS_FUTEX_WAKEUP] = (syshandler_t) sys_futex_wakeup,
 	[SYS_SMC_COHERENCE] = (syshandler_t) sys_smc_coherence,
 
 	/* Address space related syscalls. */
 	[SYS_AS_AREA_CREATE] = (syshandler_t) sys_as_area_create,
 	[SYS_AS_AREA_RESIZE] = (syshandler_t) sys_as_area_resize,
+	[SYS_AS_AREA_DECOMMIT] = (syshandler_t) sys_as_area_decommit,
 	[SYS_AS_AREA_CHANGE_FLAGS] = (syshandler_t) sys_as_area_change_flags,
 	[SYS_AS_AREA_GET_INFO] = (syshandler_t) sys_as_area_get_info,
 	[SYS_AS_AREA_DESTROY] = (syshandler_t) sys_as_area_destroy,
@@ -92,11 +98,13 @@ static syshandler_t syscall_table[] = {
 	/* IPC related syscalls. */
 	[SYS_IPC_CALL_ASYNC_FAST] = (syshandler_t) sys_ipc_call_async_fast,
 	[SYS_IPC_CALL_ASYNC_SLOW] = (syshandler_t) sys_ipc_call_async_slow,
+	[SYS_IPC_CALL_ASYNC_BATCH] = (syshandler_t) sys_ipc_call_async_batch,
 	[SYS_IPC_ANSWER_FAST] = (syshandler_t) sys_ipc_answer_fast,
 	[SYS_IPC_ANSWER_SLOW] = (syshandler_t) sys_ipc_answer_slow,
 	[SYS_IPC_FORWARD_FAST] = (syshandler_t) sys_ipc_forward_fast,
 	[SYS_IPC_FORWARD_SLOW] = (syshandler_t) sys_ipc_forward_slow,
 	[SYS_IPC_WAIT] = (syshandler_t) sys_ipc_wait_for_call,
+	[SYS_IPC_WAIT_BATCH] = (syshandler_t) sys_ipc_wait_batch,
 	[SYS_IPC_POKE] = (syshandler_t) sys_ipc_poke,
 	[SYS_IPC_HANGUP] = (syshandler_t) sys_ipc_hangup,
 	[SYS_IPC_CONNECT_KBOX] = (syshandler_t) sys_ipc_connect_kbox,
@@ -139,6 +147,8 @@ static syshandler_t syscall_table[] = {
 sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
     sysarg_t a4, sysarg_t a5, sysarg_t a6, sysarg_t id)
 {
+	cpu_count_event(STATS_EVENT_SYSCALL);
+
 	/* Do userpace accounting */
 	irq_spinlock_lock(&THREAD->lock, true);
 	thread_update_accounting(true);
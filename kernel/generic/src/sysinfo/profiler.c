@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2018 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Kernel sampling profiler.
+ *
+ * Whenever the profiler is active, the clock interrupt handler records
+ * the interrupted program counter, the current thread and the cycle
+ * counter into a per-CPU ring buffer. The rings are exported to
+ * userspace as the system.profile sysinfo item, to be symbolized
+ * against the kernel map by a userspace tool.
+ *
+ * The profiler is off by default. When it is off, the only cost is a
+ * single relaxed atomic load in the clock interrupt handler.
+ */
+
+#include <sysinfo/profiler.h>
+#include <sysinfo/sysinfo.h>
+#include <abi/sysinfo.h>
+#include <arch.h>
+#include <arch/cycle.h>
+#include <config.h>
+#include <cpu.h>
+#include <interrupt.h>
+#include <log.h>
+#include <mem.h>
+#include <proc/thread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <synch/spinlock.h>
+
+/** Ring buffer of samples taken on one CPU. */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Index of the slot to receive the next sample. */
+	size_t head;
+
+	/** Sample storage, slots with a zero PC are unused. */
+	prof_sample_t samples[PROFILER_RING_SIZE];
+} profiler_ring_t;
+
+/** Per-CPU sample rings, indexed by CPU ID. */
+static profiler_ring_t *profiler_rings = NULL;
+
+/** When false, no samples are taken. */
+static atomic_bool profiler_active = false;
+
+/** Record one sample on the current CPU.
+ *
+ * Called from clock() with interrupts disabled. The interrupted
+ * program counter is taken from the interrupt state saved by
+ * exc_dispatch().
+ *
+ */
+void profiler_sample(void)
+{
+	if (!atomic_load_explicit(&profiler_active, memory_order_relaxed))
+		return;
+
+	istate_t *istate = CPU->current_istate;
+	if (istate == NULL)
+		return;
+
+	profiler_ring_t *ring = &profiler_rings[CPU->id];
+
+	irq_spinlock_lock(&ring->lock, false);
+
+	prof_sample_t *sample = &ring->samples[ring->head];
+	sample->cycle = get_cycle();
+	sample->pc = (uint64_t) istate_get_pc(istate);
+	sample->thread_id = (THREAD != NULL) ? THREAD->tid : 0;
+	sample->cpu = CPU->id;
+
+	ring->head = (ring->head + 1) % PROFILER_RING_SIZE;
+
+	irq_spinlock_unlock(&ring->lock, false);
+}
+
+/** Start taking samples.
+ *
+ * @return EOK on success, ENOMEM if the sample rings could not
+ *         be allocated during initialization.
+ *
+ */
+errno_t profiler_start(void)
+{
+	if (profiler_rings == NULL)
+		return ENOMEM;
+
+	atomic_store_explicit(&profiler_active, true, memory_order_relaxed);
+	return EOK;
+}
+
+/** Stop taking samples.
+ *
+ * The samples collected so far remain readable via sysinfo.
+ *
+ */
+void profiler_stop(void)
+{
+	atomic_store_explicit(&profiler_active, false, memory_order_relaxed);
+}
+
+/** Get collected profiling samples
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing PROFILER_RING_SIZE prof_sample_t structures
+ *         for each CPU. If the return value is not NULL, it should be
+ *         freed in the context of the sysinfo request.
+ */
+static void *get_profile_samples(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	if (profiler_rings == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	*size = sizeof(prof_sample_t) * PROFILER_RING_SIZE * config.cpu_count;
+
+	if (dry_run)
+		return NULL;
+
+	prof_sample_t *samples = (prof_sample_t *) malloc(*size);
+	if (samples == NULL) {
+		/* No free space for allocation */
+		*size = 0;
+		return NULL;
+	}
+
+	size_t cpu;
+	for (cpu = 0; cpu < config.cpu_count; cpu++) {
+		profiler_ring_t *ring = &profiler_rings[cpu];
+
+		irq_spinlock_lock(&ring->lock, true);
+		memcpy(&samples[cpu * PROFILER_RING_SIZE], ring->samples,
+		    sizeof(prof_sample_t) * PROFILER_RING_SIZE);
+		irq_spinlock_unlock(&ring->lock, true);
+	}
+
+	return ((void *) samples);
+}
+
+/** Initialize the sampling profiler
+ *
+ * Allocate the per-CPU sample rings and register the sysinfo item.
+ * The profiler remains inactive until profiler_start() is called.
+ *
+ */
+void profiler_init(void)
+{
+	profiler_rings = (profiler_ring_t *) malloc(sizeof(profiler_ring_t) *
+	    config.cpu_count);
+	if (profiler_rings == NULL) {
+		log(LF_OTHER, LVL_ERROR,
+		    "Unable to allocate profiler sample rings");
+		return;
+	}
+
+	memsetb(profiler_rings, sizeof(profiler_ring_t) * config.cpu_count, 0);
+
+	size_t cpu;
+	for (cpu = 0; cpu < config.cpu_count; cpu++)
+		irq_spinlock_initialize(&profiler_rings[cpu].lock,
+		    "profiler_ring_t_lock");
+
+	sysinfo_set_item_gen_data("system.profile", NULL, get_profile_samples,
+	    NULL);
+}
+
+/** @}
+ */
@@ -43,10 +43,16 @@
 #include <synch/mutex.h>
 #include <time/clock.h>
 #include <mm/frame.h>
+#include <ddi/ddi.h>
 #include <proc/task.h>
 #include <proc/thread.h>
 #include <interrupt.h>
+#include <barrier.h>
+#include <align.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <str.h>
 #include <errno.h>
 #include <cpu.h>
@@ -68,6 +74,9 @@
 /** Compute load in 5 second intervals */
 #define LOAD_INTERVAL  5
 
+/** Capacity of the task section of the statistics region */
+#define STATS_REGION_TASK_MAX  256
+
 /** IPC connections statistics state */
 typedef struct {
 	bool counting;
@@ -91,6 +100,15 @@ static load_t avenrdy[LOAD_STEPS] = { 0, 0, 0 };
 /** Load calculation lock */
 static mutex_t load_lock;
 
+/** Statistics region shared with monitoring tasks */
+static stats_region_t *stats_region = NULL;
+
+/** Task section of the statistics region */
+static stats_task_t *stats_region_tasks = NULL;
+
+/** Physical memory area of the statistics region */
+static parea_t stats_parea;
+
 /** Get statistics of all CPUs
  *
  * @param item    Sysinfo item (unused).
@@ -132,6 +150,37 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_cpus);
 }
 
+/** Update the current CPU slot of the statistics region
+ *
+ * Called from the clock interrupt handler on every CPU. Each CPU
+ * writes only its own slot and the accounting fields are updated
+ * only locally, so the slot sequence counter is the only
+ * synchronization with the readers.
+ *
+ */
+void stats_update_cpu(void)
+{
+	if (stats_region == NULL)
+		return;
+
+	stats_region_cpu_t *slot = &stats_region->cpus[CPU->id];
+
+	slot->seq++;
+	write_barrier();
+
+	slot->stats.id = CPU->id;
+	slot->stats.active = CPU->active;
+	slot->stats.frequency_mhz = CPU->frequency_mhz;
+	slot->stats.busy_cycles = CPU->busy_cycles;
+	slot->stats.idle_cycles = CPU->idle_cycles;
+
+	for (unsigned int i = 0; i < STATS_EVENT_MAX; i++)
+		slot->events[i] = CPU->events[i];
+
+	write_barrier();
+	slot->seq++;
+}
+
 /** Get the size of a virtual address space
  *
  * @param as Address space.
@@ -290,6 +339,57 @@ static void *get_stats_tasks(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_tasks);
 }
 
+/** Refresh the task section of the statistics region
+ *
+ * Gather the statistics of all tasks directly into the shared
+ * statistics region. The section sequence counter is odd while the
+ * update is in progress; writers are serialized by the sysinfo
+ * interface, so there is never more than one of them. If there are
+ * more tasks than the section can hold, the section is truncated
+ * and task_total records the actual number of tasks.
+ *
+ * @param item Sysinfo item (unused).
+ * @param data Unused.
+ *
+ * @return Number of task entries written.
+ *
+ */
+static sysarg_t refresh_stats_tasks(struct sysinfo_item *item, void *data)
+{
+	/* Messing with task structures, avoid deadlock */
+	irq_spinlock_lock(&tasks_lock, true);
+
+	size_t total = task_count();
+
+	stats_region->task_seq++;
+	write_barrier();
+
+	/* Gather the statistics for each task */
+	size_t i = 0;
+	task_t *task = task_first();
+	while ((task != NULL) && (i < STATS_REGION_TASK_MAX)) {
+		/* Interrupts are already disabled */
+		irq_spinlock_lock(&(task->lock), false);
+
+		/* Record the statistics and increment the index */
+		produce_stats_task(task, &stats_region_tasks[i]);
+		i++;
+
+		irq_spinlock_unlock(&(task->lock), false);
+		task = task_next(task);
+	}
+
+	stats_region->task_cnt = i;
+	stats_region->task_total = total;
+
+	write_barrier();
+	stats_region->task_seq++;
+
+	irq_spinlock_unlock(&tasks_lock, true);
+
+	return i;
+}
+
 /** Produce thread statistics
  *
  * Summarize thread information into thread statistics.
@@ -864,6 +964,55 @@ void kload(void *arg)
 	}
 }
 
+/** Initialize the statistics region
+ *
+ * Allocate the physical memory area through which monitoring tasks
+ * read CPU and task statistics and publish its location via sysinfo.
+ * If the allocation fails, the region simply stays unavailable and
+ * user space falls back to the sysinfo data interface.
+ *
+ */
+static void stats_region_init(void)
+{
+	/* Assumption: config.cpu_count is constant */
+	size_t task_off = ALIGN_UP(offsetof(stats_region_t, cpus) +
+	    config.cpu_count * sizeof(stats_region_cpu_t), sizeof(uint64_t));
+	size_t size = task_off + STATS_REGION_TASK_MAX * sizeof(stats_task_t);
+	size_t frames = SIZE2FRAMES(size);
+
+	uintptr_t faddr = frame_alloc(frames, FRAME_LOWMEM | FRAME_ATOMIC, 0);
+	if (faddr == 0)
+		return;
+
+	stats_region = (stats_region_t *) PA2KA(faddr);
+	memsetb(stats_region, FRAMES2SIZE(frames), 0);
+
+	stats_region->cpu_cnt = config.cpu_count;
+	stats_region->task_off = task_off;
+	stats_region->task_max = STATS_REGION_TASK_MAX;
+
+	stats_region_tasks = (stats_task_t *)
+	    ((uint8_t *) stats_region + task_off);
+
+	ddi_parea_init(&stats_parea);
+	stats_parea.pbase = faddr;
+	stats_parea.frames = frames;
+	stats_parea.unpriv = true;
+	stats_parea.mapped = false;
+	ddi_parea_register(&stats_parea);
+
+	/*
+	 * Prepare information for the userspace so that it can successfully
+	 * physmem_map() the stats_parea.
+	 *
+	 */
+	sysinfo_set_item_val("stats.faddr", NULL, (sysarg_t) faddr);
+	sysinfo_set_item_val("stats.frames", NULL, (sysarg_t) frames);
+
+	sysinfo_set_item_gen_val("stats.refresh", NULL, refresh_stats_tasks,
+	    NULL);
+}
+
 /** Register sysinfo statistical items
  *
  */
@@ -871,6 +1020,8 @@ void stats_init(void)
 {
 	mutex_initialize(&load_lock, MUTEX_PASSIVE);
 
+	stats_region_init();
+
 	sysinfo_set_item_gen_data("system.cpus", NULL, get_stats_cpus, NULL);
 	sysinfo_set_item_gen_data("system.physmem", NULL, get_stats_physmem, NULL);
 	sysinfo_set_item_gen_data("system.load", NULL, get_stats_load, NULL);
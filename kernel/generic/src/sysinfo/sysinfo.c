@@ -35,14 +35,17 @@
 
 #include <assert.h>
 #include <sysinfo/sysinfo.h>
+#include <mm/page.h>
 #include <mm/slab.h>
 #include <stdio.h>
 #include <syscall/copy.h>
 #include <synch/mutex.h>
 #include <arch/asm.h>
+#include <barrier.h>
 #include <errno.h>
 #include <macros.h>
 #include <stdlib.h>
+#include <time/clock.h>
 
 /** Maximal sysinfo path length */
 #define SYSINFO_MAX_PATH  2048
@@ -105,6 +108,112 @@ void sysinfo_init(void)
 	mutex_initialize(&sysinfo_lock, MUTEX_ACTIVE);
 }
 
+/** Number of export entries that fit on the clock page
+ *
+ */
+_NO_TRACE static size_t sysinfo_export_cap(void)
+{
+	return (PAGE_SIZE - offsetof(clock_page_t, exports)) /
+	    sizeof(sysinfo_export_t);
+}
+
+/** Mirror a scalar value to the clock page
+ *
+ * Scalars set via sysinfo_set_item_val() in the global tree are also
+ * published on the read-only clock page shared with all tasks, so
+ * that userspace sysinfo_get_value() can read them without entering
+ * the kernel.
+ *
+ * Should be called with sysinfo_lock held. Silently does nothing if
+ * the clock page does not exist yet (such values are replayed later
+ * by sysinfo_export_init()), if the name does not fit an export
+ * entry or if the page is full; the syscall interface then remains
+ * the only way to read the value.
+ *
+ * @param name Full sysinfo path.
+ * @param val  Value to publish.
+ *
+ */
+_NO_TRACE static void sysinfo_export_val(const char *name, sysarg_t val)
+{
+	size_t i;
+
+	if (uptime == NULL)
+		return;
+
+	if (str_size(name) >= SYSINFO_EXPORT_NAME_BUFLEN)
+		return;
+
+	for (i = 0; i < uptime->export_cnt; i++) {
+		if (str_cmp(uptime->exports[i].name, name) == 0) {
+			uptime->exports[i].value = val;
+			return;
+		}
+	}
+
+	if (i >= sysinfo_export_cap())
+		return;
+
+	str_cpy(uptime->exports[i].name, SYSINFO_EXPORT_NAME_BUFLEN, name);
+	uptime->exports[i].value = val;
+
+	/* Make sure the entry is visible before it is announced. */
+	write_barrier();
+	uptime->export_cnt = i + 1;
+}
+
+/** Recursively export scalar items of a sysinfo subtree
+ *
+ * Should be called with sysinfo_lock held.
+ *
+ * @param item   First item of the subtree.
+ * @param path   Path buffer of SYSINFO_EXPORT_NAME_BUFLEN bytes
+ *               holding the path prefix of the subtree.
+ * @param prefix Size of the path prefix (without the terminator).
+ *
+ */
+_NO_TRACE static void sysinfo_export_subtree(sysinfo_item_t *item, char *path,
+    size_t prefix)
+{
+	while (item != NULL) {
+		size_t len = prefix + str_size(item->name);
+
+		if (len < SYSINFO_EXPORT_NAME_BUFLEN) {
+			str_cpy(path + prefix,
+			    SYSINFO_EXPORT_NAME_BUFLEN - prefix, item->name);
+
+			if (item->val_type == SYSINFO_VAL_VAL)
+				sysinfo_export_val(path, item->val.val);
+
+			if ((item->subtree_type == SYSINFO_SUBTREE_TABLE) &&
+			    (len + 1 < SYSINFO_EXPORT_NAME_BUFLEN)) {
+				path[len] = '.';
+				path[len + 1] = 0;
+				sysinfo_export_subtree(item->subtree.table,
+				    path, len + 1);
+			}
+		}
+
+		item = item->next;
+	}
+}
+
+/** Publish scalar items that predate the clock page
+ *
+ * Called by clock_counter_init() once the clock page has been
+ * allocated. Scalars set afterwards are mirrored to the page as
+ * they are set.
+ *
+ */
+void sysinfo_export_init(void)
+{
+	char path[SYSINFO_EXPORT_NAME_BUFLEN];
+
+	mutex_lock(&sysinfo_lock);
+	sysinfo_export_subtree(global_root, path, 0);
+	mutex_unlock(&sysinfo_lock);
+}
+
 /** Recursively find an item in sysinfo tree
  *
  * Should be called with sysinfo_lock held.
@@ -330,6 +439,7 @@ void sysinfo_set_item_val(const char *name, sysinfo_item_t **root,
 	/* Protect sysinfo tree consistency */
 	mutex_lock(&sysinfo_lock);
 
+	bool global = (root == NULL);
 	if (root == NULL)
 		root = &global_root;
 
@@ -337,6 +447,10 @@ void sysinfo_set_item_val(const char *name, sysinfo_item_t **root,
 	if (item != NULL) {
 		item->val_type = SYSINFO_VAL_VAL;
 		item->val.val = val;
+
+		/* Items in the global tree are also exported to tasks */
+		if (global)
+			sysinfo_export_val(name, val);
 	} else {
 		printf("Could not set sysinfo item %s.\n", name);
 	}
@@ -53,6 +53,8 @@
 #include <atomic.h>
 #include <proc/thread.h>
 #include <sysinfo/sysinfo.h>
+#include <sysinfo/profiler.h>
+#include <sysinfo/stats.h>
 #include <barrier.h>
 #include <mm/frame.h>
 #include <ddi/ddi.h>
@@ -71,6 +73,69 @@ static parea_t clock_parea;
  */
 static sysarg_t secfrag = 0;
 
+/** Architecture dynticks hooks, NULL while the tick is periodic only. */
+static clock_dynticks_ops_t *dynticks_ops = NULL;
+
+/** Enable stopping of the periodic tick on idle CPUs.
+ *
+ * Called once by architecture code whose clock device supports
+ * one-shot operation.
+ *
+ * @param ops Architecture dynticks hooks.
+ *
+ */
+void clock_dynticks_enable(clock_dynticks_ops_t *ops)
+{
+	assert(ops->stop_tick);
+	assert(ops->restart_tick);
+	assert(ops->idle_ticks);
+
+	dynticks_ops = ops;
+}
+
+/** Stop the periodic tick before going idle
+ *
+ * Called by the scheduler with interrupts disabled when the CPU is
+ * about to sleep. If the architecture supports it, the periodic tick
+ * is replaced with a single clock event at the earliest deadline of
+ * the timeout wheel, so an idle CPU is not woken just to find out
+ * that it has nothing to do.
+ *
+ */
+void clock_idle_enter(void)
+{
+	if (!dynticks_ops)
+		return;
+
+	uint64_t delta = timeout_next_tick_delta();
+	if (delta <= 1)
+		return;
+
+	dynticks_ops->stop_tick(delta);
+	CPU->tick_stopped = true;
+}
+
+/** Restore the periodic tick after idle
+ *
+ * Called by the scheduler with interrupts disabled after the CPU
+ * wakes up. The ticks skipped while sleeping are fed into the missed
+ * tick accounting, so the next clock() catches up the uptime counters
+ * and the timeout wheel exactly as it does after lost ticks.
+ *
+ */
+void clock_idle_exit(void)
+{
+	if (!CPU->tick_stopped)
+		return;
+
+	uint64_t elapsed = dynticks_ops->idle_ticks();
+	if (elapsed > 1)
+		CPU->missed_clock_ticks += elapsed - 1;
+
+	dynticks_ops->restart_tick();
+	CPU->tick_stopped = false;
+}
+
 /** Initialize realtime clock counter
  *
  * The applications (and sometimes kernel) need to access accurate
@@ -89,6 +154,7 @@ void clock_counter_init(void)
 	uptime->seconds1 = 0;
 	uptime->seconds2 = 0;
 	uptime->useconds = 0;
+	uptime->export_cnt = 0;
 
 	ddi_parea_init(&clock_parea);
 	clock_parea.pbase = faddr;
@@ -103,6 +169,40 @@ void clock_counter_init(void)
 	 *
 	 */
 	sysinfo_set_item_val("clock.faddr", NULL, (sysarg_t) faddr);
+
+	/*
+	 * Publish the sysinfo scalars that were set before the clock
+	 * page existed; later ones are mirrored as they are set.
+	 */
+	sysinfo_export_init();
+}
+
+/** Get current uptime in microseconds
+ *
+ * The uptime is only advanced by the clock interrupt, so the result
+ * has clock tick granularity. Usable e.g. for ordering the absolute
+ * deadlines of deadline-class threads.
+ *
+ * @return Uptime in microseconds, zero before the clock counter
+ *         is initialized.
+ *
+ */
+uint64_t uptime_useconds(void)
+{
+	if (!uptime)
+		return 0;
+
+	sysarg_t seconds;
+	sysarg_t useconds;
+
+	do {
+		seconds = uptime->seconds2;
+		read_barrier();
+		useconds = uptime->useconds;
+		read_barrier();
+	} while (seconds != uptime->seconds1);
+
+	return ((uint64_t) seconds) * 1000000 + useconds;
 }
 
 /** Update public counters
@@ -150,47 +250,23 @@ void clock(void)
 	/* Account CPU usage */
 	cpu_update_accounting();
 
-	/*
-	 * To avoid lock ordering problems,
-	 * run all expired timeouts as you visit them.
-	 *
-	 */
+	/* Record a profiling sample if the profiler is active */
+	profiler_sample();
+
 	size_t i;
 	for (i = 0; i <= missed_clock_ticks; i++) {
 		/* Update counters and accounting */
 		clock_update_counters();
 		cpu_update_accounting();
 
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-
-		link_t *cur;
-		while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-			timeout_t *timeout = list_get_instance(cur, timeout_t,
-			    link);
-
-			irq_spinlock_lock(&timeout->lock, false);
-			if (timeout->ticks-- != 0) {
-				irq_spinlock_unlock(&timeout->lock, false);
-				break;
-			}
-
-			list_remove(cur);
-			timeout_handler_t handler = timeout->handler;
-			void *arg = timeout->arg;
-			timeout_reinitialize(timeout);
-
-			irq_spinlock_unlock(&timeout->lock, false);
-			irq_spinlock_unlock(&CPU->timeoutlock, false);
-
-			handler(arg);
-
-			irq_spinlock_lock(&CPU->timeoutlock, false);
-		}
-
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
+		/* Advance the timeout wheel and run expired timeouts */
+		timeout_clock_tick();
 	}
 	CPU->missed_clock_ticks = 0;
 
+	/* Publish the updated accounting in the statistics region */
+	stats_update_cpu();
+
 	/*
 	 * Do CPU usage accounting and find out whether to preempt THREAD.
 	 *
@@ -53,7 +53,67 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+
+	CPU->timeout_wheel.current_tick = 0;
+
+	unsigned int level;
+	for (level = 0; level < TIMEOUT_WHEEL_LEVELS; level++) {
+		unsigned int slot;
+		for (slot = 0; slot < TIMEOUT_WHEEL_SLOTS; slot++)
+			list_initialize(&CPU->timeout_wheel.slots[level][slot]);
+	}
+
+	list_initialize(&CPU->timeout_wheel.overflow);
+}
+
+/** Insert timeout into the wheel slot matching its deadline.
+ *
+ * The deadline must not lie in the past with respect to
+ * wheel->current_tick. The timeout wheel lock is assumed
+ * to be held.
+ *
+ * @param wheel   Timeout wheel.
+ * @param timeout Timeout with a valid deadline.
+ *
+ */
+static void timeout_wheel_insert(timeout_wheel_t *wheel, timeout_t *timeout)
+{
+	uint64_t delta = timeout->deadline - wheel->current_tick;
+
+	if (delta >= TIMEOUT_WHEEL_HORIZON) {
+		list_append(&timeout->link, &wheel->overflow);
+		return;
+	}
+
+	unsigned int level = 0;
+	while (delta >= (UINT64_C(1) << ((level + 1) * TIMEOUT_WHEEL_BITS)))
+		level++;
+
+	size_t slot = (timeout->deadline >> (level * TIMEOUT_WHEEL_BITS)) &
+	    TIMEOUT_WHEEL_MASK;
+	list_append(&timeout->link, &wheel->slots[level][slot]);
+}
+
+/** Redistribute timeouts from a wheel slot closer to their expiration.
+ *
+ * The timeout wheel lock is assumed to be held.
+ *
+ * @param wheel Timeout wheel.
+ * @param slot  Slot (or the overflow list) to be redistributed.
+ *
+ */
+static void timeout_wheel_cascade(timeout_wheel_t *wheel, list_t *slot)
+{
+	list_t moved;
+	list_initialize(&moved);
+	list_concat(&moved, slot);
+
+	link_t *cur;
+	while ((cur = list_first(&moved)) != NULL) {
+		list_remove(cur);
+		timeout_wheel_insert(wheel,
+		    list_get_instance(cur, timeout_t, link));
+	}
 }
 
 /** Reinitialize timeout
@@ -66,7 +126,7 @@ void timeout_init(void)
 void timeout_reinitialize(timeout_t *timeout)
 {
 	timeout->cpu = NULL;
-	timeout->ticks = 0;
+	timeout->deadline = 0;
 	timeout->handler = NULL;
 	timeout->arg = NULL;
 	link_initialize(&timeout->link);
@@ -88,7 +148,7 @@ void timeout_initialize(timeout_t *timeout)
 /** Register timeout
  *
  * Insert timeout handler f (with argument arg)
- * to timeout list and make it execute in
+ * to the timeout wheel and make it execute in
  * time microseconds (or slightly more).
  *
  * @param timeout Timeout structure.
@@ -107,52 +167,19 @@ void timeout_register(timeout_t *timeout, uint64_t time,
 		panic("Unexpected: timeout->cpu != 0.");
 
 	timeout->cpu = CPU;
-	timeout->ticks = us2ticks(time);
-
-	timeout->handler = handler;
-	timeout->arg = arg;
 
 	/*
-	 * Insert timeout into the active timeouts list according to timeout->ticks.
+	 * The extra tick both compensates for the truncation in
+	 * us2ticks() and makes sure that the deadline lies in
+	 * the future even for a zero timeout.
 	 */
-	uint64_t sum = 0;
-	timeout_t *target = NULL;
-	link_t *cur, *prev;
-	prev = NULL;
-	for (cur = list_first(&CPU->timeout_active_list);
-	    cur != NULL; cur = list_next(cur, &CPU->timeout_active_list)) {
-		target = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&target->lock, false);
-
-		if (timeout->ticks < sum + target->ticks) {
-			irq_spinlock_unlock(&target->lock, false);
-			break;
-		}
-
-		sum += target->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-		prev = cur;
-	}
+	timeout->deadline = CPU->timeout_wheel.current_tick +
+	    us2ticks(time) + 1;
 
-	if (prev == NULL)
-		list_prepend(&timeout->link, &CPU->timeout_active_list);
-	else
-		list_insert_after(&timeout->link, prev);
-
-	/*
-	 * Adjust timeout->ticks according to ticks
-	 * accumulated in target's predecessors.
-	 */
-	timeout->ticks -= sum;
+	timeout->handler = handler;
+	timeout->arg = arg;
 
-	/*
-	 * Decrease ticks of timeout's immediate succesor by timeout->ticks.
-	 */
-	if (cur != NULL) {
-		irq_spinlock_lock(&target->lock, false);
-		target->ticks -= timeout->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
+	timeout_wheel_insert(&CPU->timeout_wheel, timeout);
 
 	irq_spinlock_unlock(&timeout->lock, false);
 	irq_spinlock_unlock(&CPU->timeoutlock, true);
@@ -186,18 +213,9 @@ grab_locks:
 
 	/*
 	 * Now we know for sure that timeout hasn't been activated yet
-	 * and is lurking in timeout->cpu->timeout_active_list.
+	 * and is lurking in a slot of timeout->cpu's timeout wheel.
 	 */
 
-	link_t *cur = list_next(&timeout->link,
-	    &timeout->cpu->timeout_active_list);
-	if (cur != NULL) {
-		timeout_t *tmp = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&tmp->lock, false);
-		tmp->ticks += timeout->ticks;
-		irq_spinlock_unlock(&tmp->lock, false);
-	}
-
 	list_remove(&timeout->link);
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, false);
 
@@ -207,5 +225,107 @@ grab_locks:
 	return true;
 }
 
+/** Advance the timeout wheel by one tick and run expired timeouts.
+ *
+ * Called from clock() with interrupts disabled. To avoid lock
+ * ordering problems, each expired timeout handler is run with the
+ * timeout wheel lock released, so that it is free to register and
+ * unregister timeouts itself.
+ *
+ */
+void timeout_clock_tick(void)
+{
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	uint64_t tick = ++wheel->current_tick;
+
+	/*
+	 * Whenever a level wraps around, redistribute the current slot
+	 * of the next level (and ultimately the overflow list) into the
+	 * lower levels.
+	 */
+	unsigned int level = 1;
+	while ((level < TIMEOUT_WHEEL_LEVELS) &&
+	    (((tick >> ((level - 1) * TIMEOUT_WHEEL_BITS)) &
+	    TIMEOUT_WHEEL_MASK) == 0)) {
+		size_t slot = (tick >> (level * TIMEOUT_WHEEL_BITS)) &
+		    TIMEOUT_WHEEL_MASK;
+		timeout_wheel_cascade(wheel, &wheel->slots[level][slot]);
+		level++;
+	}
+
+	if ((level == TIMEOUT_WHEEL_LEVELS) &&
+	    (((tick >> ((level - 1) * TIMEOUT_WHEEL_BITS)) &
+	    TIMEOUT_WHEEL_MASK) == 0))
+		timeout_wheel_cascade(wheel, &wheel->overflow);
+
+	/*
+	 * All timeouts in the current slot of level zero expire at this
+	 * very tick. Run them as you visit them.
+	 */
+	list_t *expired = &wheel->slots[0][tick & TIMEOUT_WHEEL_MASK];
+
+	link_t *cur;
+	while ((cur = list_first(expired)) != NULL) {
+		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+
+		irq_spinlock_lock(&timeout->lock, false);
+
+		list_remove(cur);
+		timeout_handler_t handler = timeout->handler;
+		void *arg = timeout->arg;
+		timeout_reinitialize(timeout);
+
+		irq_spinlock_unlock(&timeout->lock, false);
+		irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+		handler(arg);
+
+		irq_spinlock_lock(&CPU->timeoutlock, false);
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+}
+
+/** Return the number of ticks until the earliest pending timeout.
+ *
+ * Only level zero of the wheel is inspected and the result is capped
+ * at the next cascade, before which no timeout parked in the higher
+ * levels can expire. The result is therefore a safe lower bound on
+ * how long the periodic tick may be stopped; the caller simply
+ * re-evaluates once the bound is reached.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @return Ticks until the earliest timeout registered on this CPU
+ *         may expire. Always positive, at most TIMEOUT_WHEEL_SLOTS.
+ *
+ */
+uint64_t timeout_next_tick_delta(void)
+{
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	/* Ticks remaining until level zero wraps and a cascade runs */
+	uint64_t wrap = TIMEOUT_WHEEL_SLOTS -
+	    (wheel->current_tick & TIMEOUT_WHEEL_MASK);
+	uint64_t delta = wrap;
+
+	for (uint64_t d = 1; d < wrap; d++) {
+		uint64_t tick = wheel->current_tick + d;
+		if (!list_empty(&wheel->slots[0][tick & TIMEOUT_WHEEL_MASK])) {
+			delta = d;
+			break;
+		}
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+	return delta;
+}
+
 /** @}
  */
@@ -49,11 +49,61 @@
 #include <udebug/udebug.h>
 #include <udebug/udebug_ops.h>
 #include <udebug/udebug_ipc.h>
+#include <stdlib.h>
 
 errno_t udebug_request_preprocess(call_t *call, phone_t *phone)
 {
+	errno_t rc;
+
 	switch (ipc_get_arg1(&call->data)) {
-		/* future UDEBUG_M_REGS_WRITE, UDEBUG_M_MEM_WRITE: */
+	case UDEBUG_M_MEM_WRITE: {
+		/*
+		 * Copy the data to be written from the debugger now,
+		 * while we are still executing in its address space.
+		 */
+		uspace_addr_t uspace_src = ipc_get_arg2(&call->data);
+		size_t size = ipc_get_arg4(&call->data);
+
+		void *buffer = malloc(size);
+		if (!buffer)
+			return ENOMEM;
+
+		rc = copy_from_uspace(buffer, uspace_src, size);
+		if (rc != EOK) {
+			free(buffer);
+			return rc;
+		}
+
+		call->buffer = buffer;
+		break;
+	}
+	case UDEBUG_M_MEM_READV: {
+		/*
+		 * Copy the span array from the debugger now, while we
+		 * are still executing in its address space.
+		 */
+		uspace_addr_t uspace_spans = ipc_get_arg3(&call->data);
+		size_t cnt = ipc_get_arg4(&call->data);
+
+		if ((cnt == 0) || (cnt > UDEBUG_MEM_READV_MAX_SPANS))
+			return ELIMIT;
+
+		udebug_mem_span_t *spans =
+		    malloc(cnt * sizeof(udebug_mem_span_t));
+		if (!spans)
+			return ENOMEM;
+
+		rc = copy_from_uspace(spans, uspace_spans,
+		    cnt * sizeof(udebug_mem_span_t));
+		if (rc != EOK) {
+			free(spans);
+			return rc;
+		}
+
+		call->buffer = (uint8_t *) spans;
+		break;
+	}
+		/* future UDEBUG_M_REGS_WRITE: */
 	default:
 		break;
 	}
@@ -435,6 +485,83 @@ static void udebug_receive_mem_read(call_t *call)
 	ipc_answer(&TASK->kb.box, call);
 }
 
+/** Process a MEM_WRITE call.
+ *
+ * Writes memory of the current (debugged) task. The data to be written
+ * was copied from the debugger to call->buffer by the request
+ * preprocessing.
+ *
+ * @param call	The call structure.
+ */
+static void udebug_receive_mem_write(call_t *call)
+{
+	uspace_addr_t uspace_dst;
+	size_t size;
+	errno_t rc;
+
+	uspace_dst = ipc_get_arg3(&call->data);
+	size = ipc_get_arg4(&call->data);
+
+	rc = udebug_mem_write(uspace_dst, call->buffer, size);
+
+	/*
+	 * The buffer must not make it to the answer processing, which
+	 * would interpret it as data to be copied to the debugger.
+	 */
+	free(call->buffer);
+	call->buffer = NULL;
+
+	ipc_set_retval(&call->data, rc);
+	ipc_answer(&TASK->kb.box, call);
+}
+
+/** Process a MEM_READV call.
+ *
+ * Reads several spans of memory of the current (debugged) task. The span
+ * array was copied from the debugger to call->buffer by the request
+ * preprocessing.
+ *
+ * @param call	The call structure.
+ */
+static void udebug_receive_mem_readv(call_t *call)
+{
+	uspace_addr_t uspace_dst;
+	udebug_mem_span_t *spans;
+	size_t cnt;
+	size_t size;
+	void *buffer = NULL;
+	errno_t rc;
+
+	uspace_dst = ipc_get_arg2(&call->data);
+	cnt = ipc_get_arg4(&call->data);
+
+	spans = (udebug_mem_span_t *) call->buffer;
+	call->buffer = NULL;
+
+	rc = udebug_mem_readv(spans, cnt, &buffer, &size);
+	free(spans);
+
+	if (rc != EOK) {
+		ipc_set_retval(&call->data, rc);
+		ipc_answer(&TASK->kb.box, call);
+		return;
+	}
+
+	assert(buffer != NULL);
+
+	ipc_set_retval(&call->data, EOK);
+	/*
+	 * ARG1=dest, ARG2=size as in IPC_M_DATA_READ so that
+	 * same code in process_answer() can be used
+	 * (no way to distinguish method in answer)
+	 */
+	ipc_set_arg1(&call->data, uspace_dst);
+	ipc_set_arg2(&call->data, size);
+	call->buffer = buffer;
+
+	ipc_answer(&TASK->kb.box, call);
+}
+
 /** Handle a debug call received on the kernel answerbox.
  *
  * This is called by the kbox servicing thread. Verifies that the sender
@@ -495,6 +622,12 @@ void udebug_call_receive(call_t *call)
 	case UDEBUG_M_MEM_READ:
 		udebug_receive_mem_read(call);
 		break;
+	case UDEBUG_M_MEM_WRITE:
+		udebug_receive_mem_write(call);
+		break;
+	case UDEBUG_M_MEM_READV:
+		udebug_receive_mem_readv(call);
+		break;
 	}
 }
 
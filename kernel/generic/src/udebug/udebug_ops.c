@@ -578,5 +578,93 @@ errno_t udebug_mem_read(uspace_addr_t uspace_addr, size_t n, void **buffer)
 	return EOK;
 }
 
+/** Read several spans of the debugged task's memory at once.
+ *
+ * Reads the spans described by @a spans from the address space of the
+ * debugged task. The data of the spans is copied back to back into a
+ * single allocated buffer and a pointer to it is written into @a buffer.
+ * The total number of bytes read is written into @a size.
+ *
+ * @param spans  Array of spans to read.
+ * @param cnt    Number of spans.
+ * @param buffer For storing a pointer to the allocated buffer.
+ * @param size   For storing the total size of the data.
+ *
+ */
+errno_t udebug_mem_readv(const udebug_mem_span_t *spans, size_t cnt,
+    void **buffer, size_t *size)
+{
+	size_t i;
+
+	/* Verify task state */
+	mutex_lock(&TASK->udebug.lock);
+
+	if (TASK->udebug.dt_state != UDEBUG_TS_ACTIVE) {
+		mutex_unlock(&TASK->udebug.lock);
+		return EBUSY;
+	}
+
+	/* Compute the total size, watching for overflow. */
+	size_t total = 0;
+	for (i = 0; i < cnt; i++) {
+		if (spans[i].size > SIZE_MAX - total) {
+			mutex_unlock(&TASK->udebug.lock);
+			return EINVAL;
+		}
+		total += spans[i].size;
+	}
+
+	void *data_buffer = malloc(total);
+	if (!data_buffer) {
+		mutex_unlock(&TASK->udebug.lock);
+		return ENOMEM;
+	}
+
+	size_t pos = 0;
+	for (i = 0; i < cnt; i++) {
+		errno_t rc = copy_from_uspace((uint8_t *) data_buffer + pos,
+		    spans[i].addr, spans[i].size);
+		if (rc != EOK) {
+			mutex_unlock(&TASK->udebug.lock);
+			free(data_buffer);
+			return rc;
+		}
+
+		pos += spans[i].size;
+	}
+
+	mutex_unlock(&TASK->udebug.lock);
+
+	*buffer = data_buffer;
+	*size = total;
+	return EOK;
+}
+
+/** Write the memory of the debugged task.
+ *
+ * Writes @a n bytes from @a data to the address space of the debugged
+ * task, starting at @a uspace_addr.
+ *
+ * @param uspace_addr Address where to start writing.
+ * @param data        Data to write.
+ * @param n           Number of bytes to write.
+ *
+ */
+errno_t udebug_mem_write(uspace_addr_t uspace_addr, const void *data, size_t n)
+{
+	/* Verify task state */
+	mutex_lock(&TASK->udebug.lock);
+
+	if (TASK->udebug.dt_state != UDEBUG_TS_ACTIVE) {
+		mutex_unlock(&TASK->udebug.lock);
+		return EBUSY;
+	}
+
+	errno_t rc = copy_to_uspace(uspace_addr, data, n);
+	mutex_unlock(&TASK->udebug.lock);
+
+	return rc;
+}
+
 /** @}
  */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2006 Ondrej Palkovsky
+ * Copyright (c) 2006 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <abi/ddi/irq.h>
+#include <ddi/irq.h>
+#include <errno.h>
+#include <ipc/irq.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/** Check, compile and execute a top-half IRQ program.
+ *
+ * The program must not contain any PIO commands as no ranges are
+ * mapped; the arithmetic and control flow subset is sufficient to
+ * exercise the executor.
+ */
+static const char *run_code(irq_cmd_t *cmds, size_t cmdcount,
+    irq_ownership_t expected)
+{
+	if (ipc_irq_code_check(cmds, cmdcount) != EOK)
+		return "Valid program rejected by ipc_irq_code_check()";
+
+	irq_code_t code = {
+		.rangecount = 0,
+		.ranges = NULL,
+		.cmdcount = cmdcount,
+		.cmds = cmds
+	};
+
+	irq_op_t *ops = ipc_irq_code_compile(&code);
+	if (!ops)
+		return "Cannot compile the program";
+
+	irq_t irq;
+	irq_initialize(&irq);
+	irq.notif_cfg.notify = true;
+	irq.notif_cfg.ops = ops;
+
+	irq_ownership_t claim = ipc_irq_top_half_claim(&irq);
+	free(ops);
+
+	if (claim != expected)
+		return "Unexpected claim result";
+
+	return NULL;
+}
+
+const char *test_irq1(void)
+{
+	const char *err;
+
+	TPRINTF("Executing a straight-line program...\n");
+	irq_cmd_t accept[] = {
+		{
+			.cmd = CMD_LOAD,
+			.value = 1,
+			.dstarg = 1
+		},
+		{
+			.cmd = CMD_ACCEPT
+		}
+	};
+	err = run_code(accept, 2, IRQ_ACCEPT);
+	if (err)
+		return err;
+
+	TPRINTF("Executing a program with an untaken predicate...\n");
+	irq_cmd_t untaken[] = {
+		{
+			.cmd = CMD_LOAD,
+			.value = 1,
+			.dstarg = 1
+		},
+		{
+			.cmd = CMD_PREDICATE,
+			.value = 1,
+			.srcarg = 1
+		},
+		{
+			.cmd = CMD_ACCEPT
+		}
+	};
+	err = run_code(untaken, 3, IRQ_ACCEPT);
+	if (err)
+		return err;
+
+	TPRINTF("Executing a program with a taken predicate...\n");
+	irq_cmd_t taken[] = {
+		{
+			.cmd = CMD_LOAD,
+			.value = 0,
+			.dstarg = 1
+		},
+		{
+			.cmd = CMD_PREDICATE,
+			.value = 1,
+			.srcarg = 1
+		},
+		{
+			.cmd = CMD_ACCEPT
+		},
+		{
+			.cmd = CMD_DECLINE
+		}
+	};
+	err = run_code(taken, 4, IRQ_DECLINE);
+	if (err)
+		return err;
+
+	TPRINTF("Executing a program running off the end...\n");
+	irq_cmd_t off_end[] = {
+		{
+			.cmd = CMD_LOAD,
+			.value = 1,
+			.dstarg = 1
+		}
+	};
+	err = run_code(off_end, 1, IRQ_DECLINE);
+	if (err)
+		return err;
+
+	TPRINTF("Executing a predicate jumping just beyond the last "
+	    "command...\n");
+	irq_cmd_t boundary[] = {
+		{
+			.cmd = CMD_LOAD,
+			.value = 0,
+			.dstarg = 1
+		},
+		{
+			.cmd = CMD_PREDICATE,
+			.value = 2,
+			.srcarg = 1
+		},
+		{
+			.cmd = CMD_ACCEPT
+		}
+	};
+	err = run_code(boundary, 3, IRQ_DECLINE);
+	if (err)
+		return err;
+
+	TPRINTF("Checking that an overflowing predicate is rejected...\n");
+	if (ipc_irq_code_check(boundary, 2) != EINVAL)
+		return "Overflowing predicate accepted by "
+		    "ipc_irq_code_check()";
+
+	return NULL;
+}
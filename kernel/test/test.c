@@ -42,6 +42,7 @@ test_t tests[] = {
 #include <atomic/atomic1.def>
 #include <debug/mips1.def>
 #include <fault/fault1.def>
+#include <ipc/irq1.def>
 #include <mm/falloc1.def>
 #include <mm/falloc2.def>
 #include <mm/mapping1.def>
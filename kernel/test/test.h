@@ -59,6 +59,7 @@ typedef struct {
 extern const char *test_atomic1(void);
 extern const char *test_mips1(void);
 extern const char *test_fault1(void);
+extern const char *test_irq1(void);
 extern const char *test_falloc1(void);
 extern const char *test_falloc2(void);
 extern const char *test_mapping1(void);
@@ -30,10 +30,10 @@
  * The VERY basics of execute in place support. These are buggy, leaky
  * and not nearly done. Only here for beta testing!! You were warned!!
  * TODO:
- * Hash command lookups to save time
  * Create a running pointer to **path and advance/rewind it as we go
  */
 
+#include <adt/odict.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -46,11 +46,111 @@
 #include "exec.h"
 #include "errors.h"
 
+/** Cached result of a command search.
+ *
+ * Maps a command name to the path of the binary it resolved to, so
+ * that repeated invocations do not search the directories again. The
+ * identity of the binary is remembered so that the entry can be
+ * invalidated when the binary is replaced or removed.
+ */
+typedef struct {
+	odlink_t odict;
+	char *name;		/**< Command name */
+	char *path;		/**< Resolved binary path */
+	fs_handle_t fs_handle;	/**< File system handling the binary */
+	service_id_t service_id;	/**< File system instance */
+	fs_index_t index;	/**< File index of the binary */
+} cmd_cache_t;
+
+static odict_t cmd_cache;
+static bool cmd_cache_init = false;
+
 static errno_t find_command(char *, char **);
 static int try_access(const char *);
 
 const char *search_dir[] = { "/app", NULL };
 
+static void *cmd_cache_key(odlink_t *odlink)
+{
+	return (void *) odict_get_instance(odlink, cmd_cache_t, odict)->name;
+}
+
+static int cmd_cache_cmp(void *a, void *b)
+{
+	return str_cmp((char *) a, (char *) b);
+}
+
+/** Remove and free one cache entry. */
+static void cmd_cache_remove(cmd_cache_t *ent)
+{
+	odict_remove(&ent->odict);
+	free(ent->name);
+	free(ent->path);
+	free(ent);
+}
+
+/** Look up a command in the cache.
+ *
+ * A hit is revalidated with a single stat: the binary must still exist
+ * and be the very same file (same file system and file index) as when
+ * the entry was created. A stale entry is dropped and the caller falls
+ * back to a full search.
+ *
+ * @return Path to the binary (caller must free) or NULL on cache miss.
+ */
+static char *cmd_cache_lookup(const char *cmd)
+{
+	odlink_t *odlink;
+	cmd_cache_t *ent;
+	vfs_stat_t st;
+
+	odlink = odict_find_eq(&cmd_cache, (void *) cmd, NULL);
+	if (odlink == NULL)
+		return NULL;
+
+	ent = odict_get_instance(odlink, cmd_cache_t, odict);
+
+	if (vfs_stat_path(ent->path, &st) != EOK ||
+	    st.fs_handle != ent->fs_handle ||
+	    st.service_id != ent->service_id ||
+	    st.index != ent->index) {
+		/* The binary was replaced or removed */
+		cmd_cache_remove(ent);
+		return NULL;
+	}
+
+	return str_dup(ent->path);
+}
+
+/** Insert a resolved command into the cache (best effort). */
+static void cmd_cache_insert(const char *cmd, const char *path)
+{
+	cmd_cache_t *ent;
+	vfs_stat_t st;
+
+	if (vfs_stat_path(path, &st) != EOK)
+		return;
+
+	ent = calloc(1, sizeof(cmd_cache_t));
+	if (ent == NULL)
+		return;
+
+	ent->name = str_dup(cmd);
+	ent->path = str_dup(path);
+	if (ent->name == NULL || ent->path == NULL) {
+		free(ent->name);
+		free(ent->path);
+		free(ent);
+		return;
+	}
+
+	ent->fs_handle = st.fs_handle;
+	ent->service_id = st.service_id;
+	ent->index = st.index;
+
+	odict_insert(&ent->odict, &cmd_cache, NULL);
+}
+
 /* work-around for access() */
 static int try_access(const char *f)
 {
@@ -83,6 +183,16 @@ static errno_t find_command(char *cmd, char **found)
 		return EOK;
 	}
 
+	if (!cmd_cache_init) {
+		odict_initialize(&cmd_cache, cmd_cache_key, cmd_cache_cmp);
+		cmd_cache_init = true;
+	}
+
+	/* Check whether we already know where the command lives */
+	*found = cmd_cache_lookup(cmd);
+	if (*found != NULL)
+		return EOK;
+
 	*found = (char *)malloc(PATH_MAX);
 	if (*found == NULL) {
 		return ENOMEM;
@@ -100,6 +210,7 @@ static errno_t find_command(char *cmd, char **found)
 		memset(*found, 0, PATH_MAX);
 		snprintf(*found, PATH_MAX, "%s/%s", search_dir[i], cmd);
 		if (-1 != try_access(*found)) {
+			cmd_cache_insert(cmd, *found);
 			return EOK;
 		}
 	}
@@ -57,6 +57,14 @@
 
 extern volatile unsigned int cli_quit;
 
+/** Buffer size for file redirection streams.
+ *
+ * Considerably larger than the default stdio buffer so that built-in
+ * commands stream their data in a few large file system requests
+ * instead of one round trip per small chunk.
+ */
+#define REDIR_BUF_SIZE (64 * 1024)
+
 /** Text input field. */
 static tinput_t *tinput;
 
@@ -260,6 +268,7 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 			rc = errno;
 			goto finit_with_files;
 		}
+		setvbuf(from, NULL, _IOFBF, REDIR_BUF_SIZE);
 		new_iostate.stdin = from;
 	}
 
@@ -270,6 +279,7 @@ static errno_t process_input_nohup(cliuser_t *usr, list_t *alias_hups, size_t co
 			rc = errno;
 			goto finit_with_files;
 		}
+		setvbuf(to, NULL, _IOFBF, REDIR_BUF_SIZE);
 		new_iostate.stdout = to;
 	}
 
@@ -114,6 +114,7 @@ int main()
     ts.add<std::test::unordered_map_test>();
     ts.add<std::test::unordered_set_test>();
     ts.add<std::test::numeric_test>();
+    ts.add<std::test::charconv_test>();
     ts.add<std::test::adaptors_test>();
     ts.add<std::test::memory_test>();
     ts.add<std::test::list_test>();
@@ -33,15 +33,25 @@
 /** @file
  * Download a file from a HTTP server
  *
+ * When writing to a file, the download is split into several byte ranges
+ * fetched over concurrent connections and assembled in place in a
+ * preallocated output file. Progress of each segment is recorded in a
+ * small state file next to the output, so an interrupted download can be
+ * resumed by simply running the same command again. Servers that do not
+ * advertise range support are handled with a single connection, as is
+ * output to stdout.
  */
 
 #include <errno.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
 #include <task.h>
 #include <macros.h>
+#include <vfs/vfs.h>
 
 #include <http/http.h>
 #include <uri.h>
@@ -54,13 +64,508 @@
 #endif
 #define USER_AGENT "HelenOS-" NAME "/" VERSION
 
+/** Default and maximum number of concurrent connections */
+#define DEFAULT_CONNS 4
+#define MAX_CONNS 16
+
+/** Per-segment receive buffer size */
+#define SEG_BUF_SIZE 65536
+
+/** How often segment progress is persisted to the state file */
+#define STATE_SYNC_BYTES (1024 * 1024)
+
+/** Suffix of the state file recording per-segment progress */
+#define STATE_SUFFIX ".dlstate"
+
+static const uint8_t state_magic[4] = { 'H', 'D', 'L', '1' };
+
+/** Header of the segment state file */
+typedef struct {
+	uint8_t magic[4];	/**< Magic value (state_magic) */
+	uint32_t nsegs;		/**< Number of segments */
+	uint64_t total;		/**< Total file size in bytes */
+} dl_state_hdr_t;
+
+struct dl_job;
+
+/** One segment of a parallel download */
+typedef struct {
+	struct dl_job *job;	/**< Parent job */
+	int index;		/**< Segment index */
+	aoff64_t start;		/**< File offset of the first byte */
+	aoff64_t length;	/**< Segment length in bytes */
+	aoff64_t done;		/**< Bytes already fetched and written */
+	errno_t rc;		/**< Fetch result */
+} dl_seg_t;
+
+/** A parallel download job */
+typedef struct dl_job {
+	const char *host;	/**< Server host name */
+	uint16_t port;		/**< Server port */
+	const char *path;	/**< Server-side path (incl. query) */
+	int fd;			/**< Output file */
+	int sfd;		/**< Segment state file */
+	aoff64_t total;		/**< Total file size in bytes */
+	int nsegs;		/**< Number of segments */
+	dl_seg_t *segs;		/**< Segment array */
+	fibril_mutex_t lock;	/**< Protects @c ndone */
+	fibril_condvar_t done_cv;	/**< Signalled when a segment finishes */
+	int ndone;		/**< Number of finished segments */
+} dl_job_t;
+
 static void syntax_print(void)
 {
-	fprintf(stderr, "Usage: download [-o <outfile>] <url>\n");
+	fprintf(stderr, "Usage: download [-o <outfile>] [-n <conns>] <url>\n");
 	fprintf(stderr, "  Without -o, data will be written to stdout, so you may want\n");
 	fprintf(stderr, "  to redirect the output, e.g.\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "    download http://helenos.org/ | to helenos.html\n\n");
+	fprintf(stderr, "  With -o, up to <conns> concurrent connections (default %d)\n",
+	    DEFAULT_CONNS);
+	fprintf(stderr, "  fetch separate byte ranges of the file. An interrupted\n");
+	fprintf(stderr, "  download is resumed by running the same command again.\n");
+}
+
+/** Build a GET request with the common headers filled in. */
+static http_request_t *dl_request_create(const char *method, const char *host,
+    const char *path)
+{
+	http_request_t *req = http_request_create(method, path);
+	if (req == NULL)
+		return NULL;
+
+	if (http_headers_append(&req->headers, "Host", host) != EOK ||
+	    http_headers_append(&req->headers, "User-Agent", USER_AGENT) !=
+	    EOK) {
+		http_request_destroy(req);
+		return NULL;
+	}
+
+	return req;
+}
+
+/** Query the size of the remote file and whether byte ranges are supported.
+ *
+ * Sends a HEAD request and inspects the Content-Length and Accept-Ranges
+ * headers of the response.
+ */
+static errno_t dl_probe(const char *host, uint16_t port, const char *path,
+    aoff64_t *size, bool *ranges)
+{
+	http_t *http = NULL;
+	http_request_t *req = NULL;
+	http_response_t *response = NULL;
+	char *val;
+	uint64_t v;
+	errno_t rc;
+
+	*size = 0;
+	*ranges = false;
+
+	req = dl_request_create("HEAD", host, path);
+	if (req == NULL)
+		return ENOMEM;
+
+	http = http_create(host, port);
+	if (http == NULL) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	rc = http_connect(http);
+	if (rc != EOK)
+		goto out;
+
+	rc = http_send_request(http, req);
+	if (rc != EOK)
+		goto out;
+
+	rc = http_receive_response(&http->recv_buffer, &response, 16 * 1024,
+	    100);
+	if (rc != EOK)
+		goto out;
+
+	if (response->status != 200) {
+		rc = EIO;
+		goto out;
+	}
+
+	if (http_headers_get(&response->headers, "Content-Length", &val) ==
+	    EOK && str_uint64_t(val, NULL, 10, true, &v) == EOK)
+		*size = v;
+
+	if (http_headers_get(&response->headers, "Accept-Ranges", &val) ==
+	    EOK && str_cmp(val, "bytes") == 0)
+		*ranges = true;
+
+	rc = EOK;
+out:
+	if (response != NULL)
+		http_response_destroy(response);
+	if (http != NULL)
+		http_destroy(http);
+	http_request_destroy(req);
+	return rc;
+}
+
+/** Persist the progress of one segment (best effort). */
+static void dl_state_update(dl_job_t *job, dl_seg_t *seg)
+{
+	aoff64_t pos = sizeof(dl_state_hdr_t) +
+	    seg->index * sizeof(uint64_t);
+	uint64_t done = seg->done;
+	size_t nwritten;
+
+	(void) vfs_write(job->sfd, &pos, &done, sizeof(done), &nwritten);
+}
+
+/** Write a fresh state file header and zeroed progress counters. */
+static errno_t dl_state_create(dl_job_t *job)
+{
+	dl_state_hdr_t hdr;
+	aoff64_t pos;
+	size_t nwritten;
+	int i;
+	errno_t rc;
+
+	memcpy(hdr.magic, state_magic, sizeof(state_magic));
+	hdr.nsegs = job->nsegs;
+	hdr.total = job->total;
+
+	rc = vfs_resize(job->sfd, sizeof(hdr) +
+	    job->nsegs * sizeof(uint64_t));
+	if (rc != EOK)
+		return rc;
+
+	pos = 0;
+	rc = vfs_write(job->sfd, &pos, &hdr, sizeof(hdr), &nwritten);
+	if (rc != EOK)
+		return rc;
+
+	for (i = 0; i < job->nsegs; i++)
+		dl_state_update(job, &job->segs[i]);
+
+	return EOK;
+}
+
+/** Load per-segment progress from an existing state file. */
+static void dl_state_load(dl_job_t *job)
+{
+	aoff64_t pos;
+	uint64_t done;
+	size_t nread;
+	int i;
+
+	for (i = 0; i < job->nsegs; i++) {
+		pos = sizeof(dl_state_hdr_t) + i * sizeof(uint64_t);
+		if (vfs_read(job->sfd, &pos, &done, sizeof(done),
+		    &nread) != EOK || nread != sizeof(done))
+			done = 0;
+		if (done > job->segs[i].length)
+			done = 0;
+		job->segs[i].done = done;
+	}
+}
+
+/** Fetch one segment over its own connection (fibril entry point).
+ *
+ * Issues a range request for the part of the segment that is still
+ * missing and writes the received data directly at the proper offset
+ * of the output file.
+ */
+static errno_t dl_fetch_segment(void *arg)
+{
+	dl_seg_t *seg = arg;
+	dl_job_t *job = seg->job;
+	http_t *http = NULL;
+	http_request_t *req = NULL;
+	http_response_t *response = NULL;
+	void *buf = NULL;
+	char *range = NULL;
+	aoff64_t synced;
+	errno_t rc;
+	int ret;
+
+	if (seg->done >= seg->length) {
+		rc = EOK;
+		goto done;
+	}
+
+	req = dl_request_create("GET", job->host, job->path);
+	if (req == NULL) {
+		rc = ENOMEM;
+		goto done;
+	}
+
+	ret = asprintf(&range, "bytes=%" PRIu64 "-%" PRIu64,
+	    seg->start + seg->done, seg->start + seg->length - 1);
+	if (ret < 0) {
+		rc = ENOMEM;
+		goto done;
+	}
+
+	rc = http_headers_append(&req->headers, "Range", range);
+	if (rc != EOK)
+		goto done;
+
+	http = http_create(job->host, job->port);
+	if (http == NULL) {
+		rc = ENOMEM;
+		goto done;
+	}
+
+	rc = http_connect(http);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed connecting: %s\n", str_error(rc));
+		rc = EIO;
+		goto done;
+	}
+
+	rc = http_send_request(http, req);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed sending request: %s\n",
+		    str_error(rc));
+		rc = EIO;
+		goto done;
+	}
+
+	rc = http_receive_response(&http->recv_buffer, &response, 16 * 1024,
+	    100);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed receiving response: %s\n",
+		    str_error(rc));
+		rc = EIO;
+		goto done;
+	}
+
+	if (response->status != 206) {
+		fprintf(stderr, "Server returned status %d %s to a range "
+		    "request\n", response->status, response->message);
+		rc = EIO;
+		goto done;
+	}
+
+	buf = malloc(SEG_BUF_SIZE);
+	if (buf == NULL) {
+		rc = ENOMEM;
+		goto done;
+	}
+
+	synced = seg->done;
+	while (seg->done < seg->length) {
+		size_t want = min((aoff64_t) SEG_BUF_SIZE,
+		    seg->length - seg->done);
+		size_t nrecv;
+		size_t nwritten;
+		aoff64_t pos;
+
+		rc = recv_buffer(&http->recv_buffer, buf, want, &nrecv);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed receiving body: %s\n",
+			    str_error(rc));
+			goto done;
+		}
+
+		if (nrecv == 0) {
+			/* Server closed the connection prematurely */
+			rc = EIO;
+			goto done;
+		}
+
+		pos = seg->start + seg->done;
+		rc = vfs_write(job->fd, &pos, buf, nrecv, &nwritten);
+		if (rc != EOK || nwritten != nrecv) {
+			fprintf(stderr, "Error writing output file.\n");
+			rc = EIO;
+			goto done;
+		}
+
+		seg->done += nrecv;
+		if (seg->done - synced >= STATE_SYNC_BYTES) {
+			dl_state_update(job, seg);
+			synced = seg->done;
+		}
+	}
+
+	rc = EOK;
+done:
+	dl_state_update(job, seg);
+	free(buf);
+	free(range);
+	if (response != NULL)
+		http_response_destroy(response);
+	if (http != NULL)
+		http_destroy(http);
+	if (req != NULL)
+		http_request_destroy(req);
+
+	seg->rc = rc;
+
+	fibril_mutex_lock(&job->lock);
+	job->ndone++;
+	fibril_condvar_signal(&job->done_cv);
+	fibril_mutex_unlock(&job->lock);
+	return EOK;
+}
+
+/** Download a file over several concurrent range-requesting connections.
+ *
+ * @return EOK on success, ENOTSUP if the server does not support byte
+ *         ranges (the caller should fall back to a single connection),
+ *         other error code on failure.
+ */
+static errno_t download_parallel(const char *host, uint16_t port,
+    const char *path, const char *ofname, int nconns)
+{
+	dl_job_t job;
+	dl_state_hdr_t hdr;
+	char *sfname = NULL;
+	bool ranges;
+	bool resume = false;
+	aoff64_t pos;
+	size_t nread;
+	fid_t fid;
+	int i;
+	errno_t rc;
+	int ret;
+
+	job.host = host;
+	job.port = port;
+	job.path = path;
+	job.fd = -1;
+	job.sfd = -1;
+	job.segs = NULL;
+	job.ndone = 0;
+	fibril_mutex_initialize(&job.lock);
+	fibril_condvar_initialize(&job.done_cv);
+
+	rc = dl_probe(host, port, path, &job.total, &ranges);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed querying file size, using a single "
+		    "connection.\n");
+		return ENOTSUP;
+	}
+
+	if (!ranges || job.total == 0) {
+		fprintf(stderr, "Server does not support ranges, using a "
+		    "single connection.\n");
+		return ENOTSUP;
+	}
+
+	ret = asprintf(&sfname, "%s" STATE_SUFFIX, ofname);
+	if (ret < 0)
+		return ENOMEM;
+
+	rc = vfs_lookup_open(sfname, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_READ | MODE_WRITE, &job.sfd);
+	if (rc != EOK) {
+		fprintf(stderr, "Error creating '%s'.\n", sfname);
+		rc = EIO;
+		goto error;
+	}
+
+	/* A valid state file from an interrupted download fixes the layout */
+	pos = 0;
+	if (vfs_read(job.sfd, &pos, &hdr, sizeof(hdr), &nread) == EOK &&
+	    nread == sizeof(hdr) &&
+	    memcmp(hdr.magic, state_magic, sizeof(state_magic)) == 0 &&
+	    hdr.total == job.total && hdr.nsegs >= 1 &&
+	    hdr.nsegs <= MAX_CONNS) {
+		resume = true;
+		job.nsegs = hdr.nsegs;
+	} else {
+		job.nsegs = nconns;
+	}
+
+	job.segs = calloc(job.nsegs, sizeof(dl_seg_t));
+	if (job.segs == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	for (i = 0; i < job.nsegs; i++) {
+		job.segs[i].job = &job;
+		job.segs[i].index = i;
+		job.segs[i].start = job.total * i / job.nsegs;
+		job.segs[i].length = job.total * (i + 1) / job.nsegs -
+		    job.segs[i].start;
+		job.segs[i].done = 0;
+		job.segs[i].rc = EOK;
+	}
+
+	if (resume)
+		dl_state_load(&job);
+
+	rc = vfs_lookup_open(ofname, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &job.fd);
+	if (rc != EOK) {
+		fprintf(stderr, "Error creating '%s'.\n", ofname);
+		rc = EIO;
+		goto error;
+	}
+
+	rc = vfs_resize(job.fd, job.total);
+	if (rc != EOK) {
+		fprintf(stderr, "Error resizing '%s'.\n", ofname);
+		rc = EIO;
+		goto error;
+	}
+
+	if (!resume) {
+		rc = dl_state_create(&job);
+		if (rc != EOK) {
+			fprintf(stderr, "Error writing '%s'.\n", sfname);
+			rc = EIO;
+			goto error;
+		}
+	}
+
+	printf("%s '%s' (%" PRIu64 " bytes, %d connections)\n",
+	    resume ? "Resuming" : "Downloading", ofname, job.total,
+	    job.nsegs);
+
+	for (i = 0; i < job.nsegs; i++) {
+		fid = fibril_create(dl_fetch_segment, &job.segs[i]);
+		if (fid == 0) {
+			/* Run the segment on this fibril instead */
+			(void) dl_fetch_segment(&job.segs[i]);
+		} else {
+			fibril_add_ready(fid);
+		}
+	}
+
+	fibril_mutex_lock(&job.lock);
+	while (job.ndone < job.nsegs)
+		fibril_condvar_wait(&job.done_cv, &job.lock);
+	fibril_mutex_unlock(&job.lock);
+
+	rc = EOK;
+	for (i = 0; i < job.nsegs; i++) {
+		if (job.segs[i].rc != EOK)
+			rc = job.segs[i].rc;
+	}
+
+	vfs_put(job.fd);
+	vfs_put(job.sfd);
+
+	if (rc == EOK) {
+		(void) vfs_unlink_path(sfname);
+	} else {
+		fprintf(stderr, "Download incomplete, run the same command "
+		    "again to resume.\n");
+	}
+
+	free(job.segs);
+	free(sfname);
+	return rc;
+error:
+	if (job.fd >= 0)
+		vfs_put(job.fd);
+	if (job.sfd >= 0)
+		vfs_put(job.sfd);
+	free(job.segs);
+	free(sfname);
+	return rc;
 }
 
 int main(int argc, char *argv[])
@@ -68,10 +573,11 @@ int main(int argc, char *argv[])
 	int i;
 	char *ofname = NULL;
 	FILE *ofile = NULL;
-	size_t buf_size = 4096;
+	size_t buf_size = SEG_BUF_SIZE;
 	void *buf = NULL;
 	uri_t *uri = NULL;
 	http_t *http = NULL;
+	int nconns = DEFAULT_CONNS;
 	errno_t rc;
 	int ret;
 
@@ -83,21 +589,39 @@ int main(int argc, char *argv[])
 
 	i = 1;
 
-	if (str_cmp(argv[i], "-o") == 0) {
-		++i;
-		if (argc < i + 1) {
+	while (i < argc && argv[i][0] == '-') {
+		if (str_cmp(argv[i], "-o") == 0) {
+			++i;
+			if (argc < i + 1) {
+				syntax_print();
+				rc = EINVAL;
+				goto error;
+			}
+
+			ofname = argv[i++];
+		} else if (str_cmp(argv[i], "-n") == 0) {
+			++i;
+			if (argc < i + 1) {
+				syntax_print();
+				rc = EINVAL;
+				goto error;
+			}
+
+			uint16_t n;
+			rc = str_uint16_t(argv[i++], NULL, 10, true, &n);
+			if (rc != EOK || n < 1 || n > MAX_CONNS) {
+				fprintf(stderr, "Connection count must be "
+				    "1 to %d\n", MAX_CONNS);
+				rc = EINVAL;
+				goto error;
+			}
+
+			nconns = n;
+		} else {
 			syntax_print();
 			rc = EINVAL;
 			goto error;
 		}
-
-		ofname = argv[i++];
-		ofile = fopen(ofname, "wb");
-		if (ofile == NULL) {
-			fprintf(stderr, "Error creating '%s'.\n", ofname);
-			rc = EINVAL;
-			goto error;
-		}
 	}
 
 	if (argc != i + 1) {
@@ -163,6 +687,18 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (ofname != NULL && nconns > 1) {
+		rc = download_parallel(uri->host, port, server_path, ofname,
+		    nconns);
+		if (rc != ENOTSUP) {
+			free(server_path);
+			uri_destroy(uri);
+			return rc;
+		}
+
+		/* Byte ranges not supported, use a single connection */
+	}
+
 	http_request_t *req = http_request_create("GET", server_path);
 	free(server_path);
 	if (req == NULL) {
@@ -217,6 +753,16 @@ int main(int argc, char *argv[])
 		fprintf(stderr, "Server returned status %d %s\n", response->status,
 		    response->message);
 	} else {
+		if (ofname != NULL) {
+			ofile = fopen(ofname, "wb");
+			if (ofile == NULL) {
+				fprintf(stderr, "Error creating '%s'.\n",
+				    ofname);
+				rc = EINVAL;
+				goto error;
+			}
+		}
+
 		buf = malloc(buf_size);
 		if (buf == NULL) {
 			fprintf(stderr, "Failed allocating buffer\n)");
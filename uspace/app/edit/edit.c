@@ -35,6 +35,7 @@
  * @file
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -74,6 +75,12 @@ typedef struct {
 	/** Bitmask of components that need redrawing */
 	enum redraw_flags rflags;
 
+	/**
+	 * Range of document rows (1-based, inclusive) that REDRAW_TEXT
+	 * should repaint. Only valid while REDRAW_TEXT is set.
+	 */
+	int dirty_row0, dirty_row1;
+
 	/** Current position of the caret */
 	tag_t caret_pos;
 
@@ -113,6 +120,7 @@ static sysarg_t scr_columns;
 
 #define ROW_BUF_SIZE 4096
 #define BUF_SIZE 64
+#define LOAD_BUF_SIZE 16384
 #define TAB_WIDTH 8
 
 /** Maximum filename length that can be entered. */
@@ -140,6 +148,7 @@ static char *range_get_str(spt_t const *spos, spt_t const *epos);
 
 static char *prompt(char const *prompt, char const *init_value);
 
+static void pane_dirty_rows(int r0, int r1);
 static void pane_text_display(void);
 static void pane_row_display(void);
 static void pane_row_range_display(int r0, int r1);
@@ -414,15 +423,14 @@ static void key_handle_ctrl(kbd_event_t const *ev)
 		selection_copy();
 		break;
 	case KC_V:
+		/* Deletion and insertion mark the dirty rows themselves. */
 		selection_delete();
 		insert_clipboard_data();
-		pane.rflags |= REDRAW_TEXT;
 		caret_update();
 		break;
 	case KC_X:
 		selection_copy();
 		selection_delete();
-		pane.rflags |= REDRAW_TEXT;
 		caret_update();
 		break;
 	case KC_A:
@@ -525,14 +533,21 @@ static void caret_move(spt_t new_caret_pt, bool select, bool update_ideal_column
 	if (select) {
 		spt_get_coord(&old_caret_pt, &c_old);
 
-		if (c_old.row == c_new.row)
+		if (c_old.row == c_new.row) {
 			pane.rflags |= REDRAW_ROW;
-		else
-			pane.rflags |= REDRAW_TEXT;
-
+		} else {
+			/* Only rows whose selection changed need redrawing. */
+			pane_dirty_rows(min(c_old.row, c_new.row),
+			    max(c_old.row, c_new.row));
+		}
 	} else if (had_sel == true) {
-		/* Redraw because text was unselected. */
-		pane.rflags |= REDRAW_TEXT;
+		/* Redraw the previously selected rows to unselect them. */
+		coord_t c_sel;
+
+		spt_get_coord(&old_caret_pt, &c_old);
+		spt_get_coord(&old_sel_pt, &c_sel);
+		pane_dirty_rows(min(c_old.row, c_sel.row),
+		    max(c_old.row, c_sel.row));
 	}
 
 	if (update_ideal_column)
@@ -702,34 +717,62 @@ static errno_t file_insert(char *fname)
 {
 	FILE *f;
 	char32_t c;
-	char buf[BUF_SIZE];
-	int bcnt;
-	int n_read;
-	size_t off;
+	char *buf;
+	char b;
+	size_t bcnt;
+	size_t n_read;
+	size_t off, prev;
+	spt_t pt;
 
 	f = fopen(fname, "rt");
 	if (f == NULL)
 		return EINVAL;
 
+	buf = malloc(LOAD_BUF_SIZE + 1);
+	if (buf == NULL) {
+		fclose(f);
+		return ENOMEM;
+	}
+
+	/*
+	 * Read the file in large chunks and insert each chunk into the
+	 * sheet whole, cropped to the last complete character. This is
+	 * much cheaper than one sheet insertion per character.
+	 */
 	bcnt = 0;
 
 	while (true) {
-		if (bcnt < STR_BOUNDS(1)) {
-			n_read = fread(buf + bcnt, 1, BUF_SIZE - bcnt, f);
-			bcnt += n_read;
-		}
+		n_read = fread(buf + bcnt, 1, LOAD_BUF_SIZE - bcnt, f);
+		bcnt += n_read;
+		if (bcnt == 0)
+			break;
 
-		off = 0;
-		c = str_decode(buf, &off, bcnt);
-		if (c == '\0')
+		/* Find the end of the last complete character. */
+		prev = off = 0;
+		do {
+			prev = off;
+			c = str_decode(buf, &off, bcnt);
+		} while (c != '\0');
+
+		if (prev == 0) {
+			/* Incomplete character at the end of the file. */
 			break;
+		}
 
-		bcnt -= off;
-		memcpy(buf, buf + off, bcnt);
+		/* Insert the complete part of the buffer. */
+		b = buf[prev];
+		buf[prev] = '\0';
 
-		insert_char(c);
+		tag_get_pt(&pane.caret_pos, &pt);
+		(void) sheet_insert(doc.sh, &pt, dir_before, buf);
+
+		/* Keep the trailing incomplete character for the next round. */
+		buf[prev] = b;
+		bcnt -= prev;
+		memcpy(buf, buf + prev, bcnt);
 	}
 
+	free(buf);
 	fclose(f);
 
 	return EOK;
@@ -807,27 +850,67 @@ static char *range_get_str(spt_t const *spos, spt_t const *epos)
 	return buf;
 }
 
+/** Mark a range of document rows as needing redraw.
+ *
+ * Extends the range of rows that the next REDRAW_TEXT pass will repaint.
+ * Pass @c INT_MAX as @a r1 when all rows from @a r0 to the bottom of the
+ * pane have changed (e.g. when later lines have shifted).
+ */
+static void pane_dirty_rows(int r0, int r1)
+{
+	if (r0 < 1)
+		r0 = 1;
+
+	if ((pane.rflags & REDRAW_TEXT) == 0) {
+		pane.dirty_row0 = r0;
+		pane.dirty_row1 = r1;
+	} else {
+		pane.dirty_row0 = min(pane.dirty_row0, r0);
+		pane.dirty_row1 = max(pane.dirty_row1, r1);
+	}
+
+	pane.rflags |= REDRAW_TEXT;
+}
+
 static void pane_text_display(void)
 {
 	int sh_rows, rows;
+	int r0, r1;
+
+	/* When called directly (not via REDRAW_TEXT), repaint everything. */
+	if ((pane.rflags & REDRAW_TEXT) == 0) {
+		pane.dirty_row0 = 1;
+		pane.dirty_row1 = INT_MAX;
+	}
 
 	sheet_get_num_rows(doc.sh, &sh_rows);
 	rows = min(sh_rows - pane.sh_row + 1, pane.rows);
 
-	/* Draw rows from the sheet. */
+	/* Determine which pane rows lie in the dirty range. */
 
-	console_set_pos(con, 0, 0);
-	pane_row_range_display(0, rows);
+	r0 = max(0, pane.dirty_row0 - pane.sh_row);
+	r1 = (pane.dirty_row1 - pane.sh_row >= rows) ? rows :
+	    pane.dirty_row1 - pane.sh_row + 1;
 
-	/* Clear the remaining rows if file is short. */
+	/* Draw dirty rows from the sheet. */
 
-	int i;
-	sysarg_t j;
-	for (i = rows; i < pane.rows; ++i) {
-		console_set_pos(con, 0, i);
-		for (j = 0; j < scr_columns; ++j)
-			putchar(' ');
-		console_flush(con);
+	if (r0 < r1)
+		pane_row_range_display(r0, r1);
+
+	/*
+	 * Clear the remaining rows if file is short, unless the dirty
+	 * range ends above them.
+	 */
+
+	if (pane.dirty_row1 - pane.sh_row >= rows) {
+		int i;
+		sysarg_t j;
+		for (i = rows; i < pane.rows; ++i) {
+			console_set_pos(con, 0, i);
+			for (j = 0; j < scr_columns; ++j)
+				putchar(' ');
+			console_flush(con);
+		}
 	}
 
 	pane.rflags |= (REDRAW_STATUS | REDRAW_CARET);
@@ -1063,10 +1146,12 @@ static void pane_caret_display(void)
 static void insert_char(char32_t c)
 {
 	spt_t pt;
+	coord_t coord;
 	char cbuf[STR_BOUNDS(1) + 1];
 	size_t offs;
 
 	tag_get_pt(&pane.caret_pos, &pt);
+	spt_get_coord(&pt, &coord);
 
 	offs = 0;
 	chr_encode(c, cbuf, &offs, STR_BOUNDS(1) + 1);
@@ -1075,8 +1160,10 @@ static void insert_char(char32_t c)
 	(void) sheet_insert(doc.sh, &pt, dir_before, cbuf);
 
 	pane.rflags |= REDRAW_ROW;
-	if (c == '\n')
-		pane.rflags |= REDRAW_TEXT;
+	if (c == '\n') {
+		/* Following rows have shifted down. */
+		pane_dirty_rows(coord.row, INT_MAX);
+	}
 }
 
 /** Delete the character before the caret. */
@@ -1094,8 +1181,10 @@ static void delete_char_before(void)
 	(void) sheet_delete(doc.sh, &sp, &ep);
 
 	pane.rflags |= REDRAW_ROW;
-	if (coord.column < 1)
-		pane.rflags |= REDRAW_TEXT;
+	if (coord.column < 1) {
+		/* Deleted a newline; the previous row and all below change. */
+		pane_dirty_rows(coord.row - 1, INT_MAX);
+	}
 }
 
 /** Delete the character after the caret. */
@@ -1113,8 +1202,10 @@ static void delete_char_after(void)
 	(void) sheet_delete(doc.sh, &sp, &ep);
 
 	pane.rflags |= REDRAW_ROW;
-	if (ec.row != sc.row)
-		pane.rflags |= REDRAW_TEXT;
+	if (ec.row != sc.row) {
+		/* Deleted a newline; rows below shift up. */
+		pane_dirty_rows(sc.row, INT_MAX);
+	}
 }
 
 /** Scroll pane after caret has moved.
@@ -1134,24 +1225,24 @@ static void caret_update(void)
 
 	if (coord.row < pane.sh_row) {
 		pane.sh_row = coord.row;
-		pane.rflags |= REDRAW_TEXT;
+		pane_dirty_rows(1, INT_MAX);
 	}
 
 	if (coord.row > pane.sh_row + pane.rows - 1) {
 		pane.sh_row = coord.row - pane.rows + 1;
-		pane.rflags |= REDRAW_TEXT;
+		pane_dirty_rows(1, INT_MAX);
 	}
 
 	/* Scroll pane horizontally. */
 
 	if (coord.column < pane.sh_column) {
 		pane.sh_column = coord.column;
-		pane.rflags |= REDRAW_TEXT;
+		pane_dirty_rows(1, INT_MAX);
 	}
 
 	if (coord.column > pane.sh_column + pane.columns - 1) {
 		pane.sh_column = coord.column - pane.columns + 1;
-		pane.rflags |= REDRAW_TEXT;
+		pane_dirty_rows(1, INT_MAX);
 	}
 
 	pane.rflags |= (REDRAW_CARET | REDRAW_STATUS);
@@ -1472,10 +1563,12 @@ static void selection_delete(void)
 	else
 		sheet_delete(doc.sh, &pb, &pa);
 
-	if (ca.row == cb.row)
+	if (ca.row == cb.row) {
 		pane.rflags |= REDRAW_ROW;
-	else
-		pane.rflags |= REDRAW_TEXT;
+	} else {
+		/* Rows below the deleted range shift up. */
+		pane_dirty_rows(min(ca.row, cb.row), INT_MAX);
+	}
 }
 
 /** Select all text in the editor */
@@ -1497,7 +1590,7 @@ static void selection_sel_range(spt_t pa, spt_t pb)
 	sheet_remove_tag(doc.sh, &pane.caret_pos);
 	sheet_place_tag(doc.sh, &pb, &pane.caret_pos);
 
-	pane.rflags |= REDRAW_TEXT;
+	pane_dirty_rows(1, INT_MAX);
 	caret_update();
 }
 
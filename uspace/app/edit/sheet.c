@@ -43,9 +43,15 @@
  * versa. The text that is inserted or deleted can contain tabs and newlines
  * which are interpreted and properly acted upon.
  *
- * This is a trivial implementation with poor efficiency with O(N+n)
- * insertion and deletion and O(N) mapping (in both directions), where
- * N is the size of the file and n is the size of the inserted/deleted text.
+ * This implementation stores the text in a single contiguous buffer, so
+ * insertion and deletion are still O(N+n) in the worst case (dominated by
+ * a memmove of the buffer tail), where N is the size of the file and n is
+ * the size of the inserted/deleted text. A line index (sorted array of
+ * line-start byte offsets) is maintained alongside the buffer, making
+ * both directions of coordinate mapping O(log N + l), where l is the
+ * length of the line in question, instead of O(N). This is what matters
+ * in practice since the editor maps coordinates for every displayed row
+ * on every redraw.
  */
 
 #include <stdlib.h>
@@ -62,9 +68,63 @@ enum {
 	TAB_WIDTH	= 8,
 
 	/** Initial  of dat buffer in bytes */
-	INITIAL_SIZE	= 32
+	INITIAL_SIZE	= 32,
+
+	/** Initial capacity of the line index in entries */
+	LIDX_INITIAL_CAP = 16
 };
 
+/** Find the line containing a byte offset.
+ *
+ * @param sh	Sheet.
+ * @param b_off	Byte offset.
+ * @return	Index of the greatest line start that is <= @a b_off.
+ */
+static size_t sheet_line_at(sheet_t *sh, size_t b_off)
+{
+	size_t lo, hi, mid;
+
+	/* Binary search for the last entry <= b_off. */
+	lo = 0;
+	hi = sh->lidx_cnt;
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (sh->lidx[mid] <= b_off)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/** Make room for more line index entries.
+ *
+ * @param sh	Sheet.
+ * @param extra	Number of new entries that will be inserted.
+ * @return	EOK on success, ELIMIT if out of memory.
+ */
+static errno_t sheet_lidx_reserve(sheet_t *sh, size_t extra)
+{
+	size_t ncap;
+	size_t *nlidx;
+
+	if (sh->lidx_cnt + extra <= sh->lidx_cap)
+		return EOK;
+
+	ncap = sh->lidx_cap;
+	while (sh->lidx_cnt + extra > ncap)
+		ncap = ncap * 2;
+
+	nlidx = realloc(sh->lidx, ncap * sizeof(size_t));
+	if (nlidx == NULL)
+		return ELIMIT;
+
+	sh->lidx = nlidx;
+	sh->lidx_cap = ncap;
+	return EOK;
+}
+
 /** Initialize an empty sheet. */
 errno_t sheet_create(sheet_t **rsh)
 {
@@ -83,6 +143,18 @@ errno_t sheet_create(sheet_t **rsh)
 		return ENOMEM;
 	}
 
+	sh->lidx_cap = LIDX_INITIAL_CAP;
+	sh->lidx = malloc(sh->lidx_cap * sizeof(size_t));
+	if (sh->lidx == NULL) {
+		free(sh->data);
+		free(sh);
+		return ENOMEM;
+	}
+
+	/* The first line starts at the beginning of the text. */
+	sh->lidx[0] = 0;
+	sh->lidx_cnt = 1;
+
 	list_initialize(&sh->tags);
 
 	*rsh = sh;
@@ -107,8 +179,27 @@ errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
 	char *ipp;
 	size_t sz;
 	char *newp;
-
+	size_t nl;
+	size_t row;
+	size_t i, j;
+	errno_t rc;
+
+	/*
+	 * Count newlines in the inserted text and reserve line index
+	 * entries for them up front so that we cannot fail with the
+	 * buffer already modified.
+	 */
 	sz = str_size(str);
+	nl = 0;
+	for (i = 0; i < sz; i++) {
+		if (str[i] == '\n')
+			++nl;
+	}
+
+	rc = sheet_lidx_reserve(sh, nl);
+	if (rc != EOK)
+		return rc;
+
 	if (sh->text_size + sz > sh->dbuf_size) {
 		/* Enlarge data buffer. */
 		newp = realloc(sh->data, sh->dbuf_size * 2);
@@ -126,6 +217,27 @@ errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
 	memcpy(ipp, str, sz);
 	sh->text_size += sz;
 
+	/* Update line index. */
+
+	row = sheet_line_at(sh, pos->b_off);
+
+	/*
+	 * Lines following the insertion point shift by @c sz and make
+	 * room for the lines started by newlines in the inserted text.
+	 * A line starting exactly at the insertion point keeps its offset
+	 * (the inserted text is prepended to it).
+	 */
+	for (j = sh->lidx_cnt; j > row + 1; j--)
+		sh->lidx[j - 1 + nl] = sh->lidx[j - 1] + sz;
+
+	j = row + 1;
+	for (i = 0; i < sz; i++) {
+		if (str[i] == '\n')
+			sh->lidx[j++] = pos->b_off + i + 1;
+	}
+
+	sh->lidx_cnt += nl;
+
 	/* Adjust tags. */
 
 	list_foreach(sh->tags, link, tag_t, tag) {
@@ -154,6 +266,8 @@ errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 	size_t sz;
 	char *newp;
 	size_t shrink_size;
+	size_t row;
+	size_t i, j;
 
 	spp = sh->data + spos->b_off;
 	sz = epos->b_off - spos->b_off;
@@ -161,6 +275,26 @@ errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 	memmove(spp, spp + sz, sh->text_size - (spos->b_off + sz));
 	sh->text_size -= sz;
 
+	/* Update line index. */
+
+	row = sheet_line_at(sh, spos->b_off);
+
+	/*
+	 * Lines starting within (spos, epos] lose their preceding newline
+	 * and are removed (they merge with the line containing spos).
+	 * Lines starting after epos shift back by @c sz.
+	 */
+	i = row + 1;
+	j = i;
+	while (j < sh->lidx_cnt && sh->lidx[j] <= epos->b_off)
+		++j;
+
+	while (j < sh->lidx_cnt) {
+		sh->lidx[i++] = sh->lidx[j++] - sz;
+	}
+
+	sh->lidx_cnt = i;
+
 	/* Adjust tags. */
 	list_foreach(sh->tags, link, tag_t, tag) {
 		if (tag->b_off >= epos->b_off)
@@ -223,9 +357,16 @@ void sheet_get_cell_pt(sheet_t *sh, coord_t const *coord, enum dir_spec dir,
 	size_t cur_pos, prev_pos;
 	char32_t c;
 	coord_t cc;
+	size_t row;
+
+	/* Start the scan at the beginning of the requested row. */
+	row = (coord->row > 0) ? (size_t) coord->row - 1 : 0;
+	if (row >= sh->lidx_cnt)
+		row = sh->lidx_cnt - 1;
 
-	cc.row = cc.column = 1;
-	cur_pos = prev_pos = 0;
+	cc.row = row + 1;
+	cc.column = 1;
+	cur_pos = prev_pos = sh->lidx[row];
 	while (true) {
 		if (prev_pos >= sh->text_size) {
 			/* Cannot advance any further. */
@@ -273,16 +414,7 @@ void sheet_get_row_width(sheet_t *sh, int row, int *length)
 /** Get the number of rows in a sheet. */
 void sheet_get_num_rows(sheet_t *sh, int *rows)
 {
-	int cnt;
-	size_t bo;
-
-	cnt = 1;
-	for (bo = 0; bo < sh->dbuf_size; ++bo) {
-		if (sh->data[bo] == '\n')
-			cnt += 1;
-	}
-
-	*rows = cnt;
+	*rows = (int) sh->lidx_cnt;
 }
 
 /** Get the coordinates of an s-point. */
@@ -292,21 +424,26 @@ void spt_get_coord(spt_t const *pos, coord_t *coord)
 	coord_t cc;
 	char32_t c;
 	sheet_t *sh;
+	size_t row;
 
 	sh = pos->sh;
-	cc.row = cc.column = 1;
 
-	off = 0;
+	/*
+	 * Look up the row containing the s-point and only scan that row
+	 * to compute the column (tabs make the column depend on the
+	 * preceding characters in the row).
+	 */
+	row = sheet_line_at(sh, pos->b_off);
+	cc.row = row + 1;
+	cc.column = 1;
+
+	off = sh->lidx[row];
 	while (off < pos->b_off && off < sh->text_size) {
 		c = str_decode(sh->data, &off, sh->text_size);
-		if (c == '\n') {
-			++cc.row;
-			cc.column = 1;
-		} else if (c == '\t') {
+		if (c == '\t')
 			cc.column = 1 + ALIGN_UP(cc.column, TAB_WIDTH);
-		} else {
+		else
 			++cc.column;
-		}
 	}
 
 	*coord = cc;
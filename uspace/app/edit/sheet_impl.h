@@ -46,6 +46,13 @@ struct sheet {
 	size_t dbuf_size;
 	char *data;
 
+	/** Byte offsets of line starts, in ascending order */
+	size_t *lidx;
+	/** Number of lines (valid entries in @c lidx) */
+	size_t lidx_cnt;
+	/** Number of entries allocated for @c lidx */
+	size_t lidx_cap;
+
 	list_t tags;
 };
 
@@ -38,13 +38,21 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_block_read,
 	&benchmark_dir_read,
+	&benchmark_double1,
 	&benchmark_fibril_mutex,
+	&benchmark_fibril_spawn,
+	&benchmark_fibril_wakeup,
 	&benchmark_file_read,
+	&benchmark_gfx_blit,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_memcpy1,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ping_pong,
+	&benchmark_tcp_rtt,
+	&benchmark_udp_rtt
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
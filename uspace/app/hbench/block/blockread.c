@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <block.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <loc.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Measures block device read performance through libblock. A number of
+ * worker fibrils (the queue depth) issue single-block direct reads
+ * until the requested number of blocks has been read, either
+ * sequentially or at pseudo-random offsets.
+ *
+ * Parameters:
+ *  - device: block device service name (default bd/initrd)
+ *  - access: "seq" or "rand" (default seq)
+ *  - queue_depth: number of concurrently reading fibrils (default 1)
+ */
+
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	service_id_t service_id;
+	size_t block_size;
+	aoff64_t nblocks;
+	/** Blocks not yet claimed by a worker */
+	uint64_t remaining;
+	/** Next sequential block index */
+	aoff64_t next_block;
+	bool random_access;
+	/** Workers still running */
+	size_t active_workers;
+	/** First error encountered by a worker */
+	errno_t error;
+} shared_t;
+
+static errno_t read_worker(void *arg)
+{
+	shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	/* Simple xorshift PRNG, seeded per worker from the fibril ID */
+	uint64_t rngstate = (uint64_t) fibril_get_id() | 1;
+
+	char *buf = malloc(shared->block_size);
+
+	fibril_mutex_lock(&shared->mutex);
+	while (buf != NULL && shared->remaining > 0 && shared->error == EOK) {
+		shared->remaining--;
+
+		aoff64_t ba;
+		if (shared->random_access) {
+			rngstate ^= rngstate << 13;
+			rngstate ^= rngstate >> 7;
+			rngstate ^= rngstate << 17;
+			ba = rngstate % shared->nblocks;
+		} else {
+			ba = shared->next_block;
+			shared->next_block = (shared->next_block + 1) %
+			    shared->nblocks;
+		}
+
+		fibril_mutex_unlock(&shared->mutex);
+		errno_t rc = block_read_direct(shared->service_id, ba, 1, buf);
+		fibril_mutex_lock(&shared->mutex);
+
+		if (rc != EOK && shared->error == EOK)
+			shared->error = rc;
+	}
+
+	if (buf == NULL && shared->error == EOK)
+		shared->error = ENOMEM;
+
+	shared->active_workers--;
+	if (shared->active_workers == 0)
+		fibril_condvar_signal(&shared->cv);
+	fibril_mutex_unlock(&shared->mutex);
+
+	free(buf);
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	shared_t shared;
+	uint64_t queue_depth;
+	errno_t rc;
+	bool ret = true;
+	bool initialized = false;
+
+	const char *device = bench_env_param_get(env, "device", "bd/initrd");
+	const char *access = bench_env_param_get(env, "access", "seq");
+	const char *qd_str = bench_env_param_get(env, "queue_depth", "1");
+
+	rc = str_uint64_t(qd_str, NULL, 10, true, &queue_depth);
+	if (rc != EOK || queue_depth == 0 || queue_depth > 64)
+		return bench_run_fail(run, "invalid queue_depth '%s'", qd_str);
+
+	if (str_cmp(access, "seq") == 0) {
+		shared.random_access = false;
+	} else if (str_cmp(access, "rand") == 0) {
+		shared.random_access = true;
+	} else {
+		return bench_run_fail(run, "invalid access mode '%s'", access);
+	}
+
+	rc = loc_service_get_id(device, &shared.service_id, 0);
+	if (rc != EOK)
+		return bench_run_fail(run, "cannot find device '%s'", device);
+
+	rc = block_init(shared.service_id, 2048);
+	if (rc != EOK)
+		return bench_run_fail(run, "cannot open device '%s'", device);
+	initialized = true;
+
+	rc = block_get_bsize(shared.service_id, &shared.block_size);
+	if (rc == EOK)
+		rc = block_get_nblocks(shared.service_id, &shared.nblocks);
+	if (rc != EOK || shared.nblocks == 0) {
+		ret = bench_run_fail(run, "cannot get device geometry");
+		goto out;
+	}
+
+	fibril_mutex_initialize(&shared.mutex);
+	fibril_condvar_initialize(&shared.cv);
+	shared.remaining = size;
+	shared.next_block = 0;
+	shared.active_workers = 0;
+	shared.error = EOK;
+
+	uint64_t created = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < queue_depth; i++) {
+		fid_t fid = fibril_create(read_worker, &shared);
+		if (fid == 0)
+			break;
+		fibril_mutex_lock(&shared.mutex);
+		shared.active_workers++;
+		fibril_mutex_unlock(&shared.mutex);
+		fibril_start(fid);
+		created++;
+	}
+
+	if (created == 0) {
+		bench_run_stop(run);
+		ret = bench_run_fail(run, "failed to create worker fibrils");
+		goto out;
+	}
+
+	fibril_mutex_lock(&shared.mutex);
+	while (shared.active_workers > 0)
+		fibril_condvar_wait(&shared.cv, &shared.mutex);
+	fibril_mutex_unlock(&shared.mutex);
+	bench_run_stop(run);
+
+	if (shared.error != EOK)
+		ret = bench_run_fail(run, "block read failed (%d)",
+		    (int) shared.error);
+
+out:
+	if (initialized)
+		block_fini(shared.service_id);
+	return ret;
+}
+
+benchmark_t benchmark_block_read = {
+	.name = "block_read",
+	.desc = "Block device read throughput (libblock)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -51,7 +51,8 @@ errno_t csv_report_open(const char *filename)
 		return errno;
 	}
 
-	fprintf(csv_output, "benchmark,run,size,duration_nanos\n");
+	fprintf(csv_output, "benchmark,run,workers,size,duration_nanos,"
+	    "latency_p50_nanos,latency_p95_nanos,latency_p99_nanos\n");
 
 	return EOK;
 }
@@ -61,21 +62,34 @@ errno_t csv_report_open(const char *filename)
  * When csv_report_open() was not called or failed, the function does
  * nothing.
  *
+ * The latency percentile columns are filled-in only when the run has
+ * recorded individual operation latencies (left empty otherwise).
+ *
  * @param run Performance data of the entry.
  * @param run_index Run index, use negative values for warm-up.
+ * @param workers Number of parallel workers of this run.
  * @param bench Benchmark information.
- * @param workload_size Workload size.
+ * @param workload_size Workload size (per worker).
  */
-void csv_report_add_entry(bench_run_t *run, int run_index,
+void csv_report_add_entry(bench_run_t *run, int run_index, size_t workers,
     benchmark_t *bench, uint64_t workload_size)
 {
 	if (csv_output == NULL) {
 		return;
 	}
 
-	fprintf(csv_output, "%s,%d,%" PRIu64 ",%lld\n",
-	    bench->name, run_index, workload_size,
+	fprintf(csv_output, "%s,%d,%zu,%" PRIu64 ",%lld",
+	    bench->name, run_index, workers, workload_size,
 	    (long long) stopwatch_get_nanos(&run->stopwatch));
+
+	if (run->latency_count > 0) {
+		fprintf(csv_output, ",%lld,%lld,%lld\n",
+		    (long long) bench_run_latency_percentile(run, 50),
+		    (long long) bench_run_latency_percentile(run, 95),
+		    (long long) bench_run_latency_percentile(run, 99));
+	} else {
+		fprintf(csv_output, ",,,\n");
+	}
 }
 
 /** Close CSV report.
@@ -97,6 +97,7 @@ errno_t bench_env_init(bench_env_t *env)
 
 	env->run_count = DEFAULT_RUN_COUNT;
 	env->minimal_run_duration_nanos = MSEC2NSEC(DEFAULT_MIN_RUN_DURATION_SEC);
+	env->max_workers = DEFAULT_MAX_WORKERS;
 
 	return EOK;
 }
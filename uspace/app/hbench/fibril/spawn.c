@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include "../hbench.h"
+
+/*
+ * Measures the cost of creating, scheduling and tearing down a fibril.
+ * Every iteration spawns one fibril which immediately terminates; the
+ * main fibril waits for the last one before stopping the clock.
+ */
+
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	uint64_t remaining;
+} shared_t;
+
+static errno_t short_lived(void *arg)
+{
+	shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	fibril_mutex_lock(&shared->mutex);
+	shared->remaining--;
+	if (shared->remaining == 0)
+		fibril_condvar_signal(&shared->cv);
+	fibril_mutex_unlock(&shared->mutex);
+
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	shared_t shared;
+
+	fibril_mutex_initialize(&shared.mutex);
+	fibril_condvar_initialize(&shared.cv);
+	shared.remaining = size;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		fid_t fid = fibril_create(short_lived, &shared);
+		if (fid == 0) {
+			return bench_run_fail(run,
+			    "failed to create fibril (iteration %" PRIu64 ")",
+			    i);
+		}
+		fibril_start(fid);
+	}
+
+	fibril_mutex_lock(&shared.mutex);
+	while (shared.remaining > 0)
+		fibril_condvar_wait(&shared.cv, &shared.mutex);
+	fibril_mutex_unlock(&shared.mutex);
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_fibril_spawn = {
+	.name = "fibril_spawn",
+	.desc = "Fibril creation and teardown throughput",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
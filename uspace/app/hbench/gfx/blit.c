@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <gfx/bitmap.h>
+#include <gfx/context.h>
+#include <gfx/coord.h>
+#include <gfx/render.h>
+#include <memgfx/memgc.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Measures memgfx bitmap blitting: renders a bitmap into a memory GC
+ * repeatedly. This exercises the software blit path that console and
+ * display server compositing is built on, without needing a running
+ * display service.
+ */
+
+enum {
+	surface_width = 256,
+	surface_height = 256
+};
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	mem_gc_t *mgc = NULL;
+	gfx_context_t *gc;
+	gfx_bitmap_t *bitmap = NULL;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t alloc;
+	gfx_rect_t rect;
+	errno_t rc;
+	bool ret = true;
+
+	rect.p0.x = 0;
+	rect.p0.y = 0;
+	rect.p1.x = surface_width;
+	rect.p1.y = surface_height;
+
+	alloc.pitch = surface_width * sizeof(uint32_t);
+	alloc.off0 = 0;
+	alloc.pixels = calloc(1, alloc.pitch * surface_height);
+	if (alloc.pixels == NULL)
+		return bench_run_fail(run, "failed to allocate surface");
+
+	rc = mem_gc_create(&rect, &alloc, NULL, NULL, NULL, &mgc);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed to create memory GC");
+		goto out;
+	}
+
+	gc = mem_gc_get_ctx(mgc);
+
+	gfx_bitmap_params_init(&params);
+	params.rect = rect;
+
+	rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed to create bitmap");
+		goto out;
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = gfx_bitmap_render(bitmap, NULL, NULL);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			ret = bench_run_fail(run, "bitmap render failed");
+			goto out;
+		}
+	}
+	bench_run_stop(run);
+
+out:
+	if (bitmap != NULL)
+		gfx_bitmap_destroy(bitmap);
+	if (mgc != NULL)
+		mem_gc_delete(mgc);
+	free(alloc.pixels);
+	return ret;
+}
+
+benchmark_t benchmark_gfx_blit = {
+	.name = "gfx_blit",
+	.desc = "memgfx bitmap blit rate (256x256 surface)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
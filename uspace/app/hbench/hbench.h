@@ -43,11 +43,13 @@
 
 #define DEFAULT_RUN_COUNT 10
 #define DEFAULT_MIN_RUN_DURATION_SEC 10
+#define DEFAULT_MAX_WORKERS 1
 
 /** Single run information.
  *
- * Used to store both performance information (now, only wall-clock
- * time) as well as information about error.
+ * Used to store both performance information (wall-clock time and,
+ * optionally, individual operation latencies) as well as information
+ * about error.
  *
  * Use proper access functions when modifying data inside this structure.
  *
@@ -58,6 +60,14 @@ typedef struct {
 	stopwatch_t stopwatch;
 	char *error_message;
 	size_t error_message_buffer_size;
+	/**
+	 * Individual operation latencies recorded by the benchmark
+	 * via bench_run_record_latency() (may be empty when the
+	 * benchmark measures the workload as a whole only).
+	 */
+	nsec_t *latencies;
+	size_t latency_count;
+	size_t latency_capacity;
 } bench_run_t;
 
 /** Benchmark environment configuration.
@@ -71,6 +81,8 @@ typedef struct {
 	hash_table_t parameters;
 	size_t run_count;
 	nsec_t minimal_run_duration_nanos;
+	/** Highest parallel worker count to measure with */
+	size_t max_workers;
 } bench_env_t;
 
 /** Actual benchmark runner.
@@ -98,7 +110,10 @@ typedef struct {
 } benchmark_t;
 
 extern void bench_run_init(bench_run_t *, char *, size_t);
+extern void bench_run_fini(bench_run_t *);
 extern bool bench_run_fail(bench_run_t *, const char *, ...);
+extern void bench_run_record_latency(bench_run_t *, nsec_t);
+extern nsec_t bench_run_latency_percentile(bench_run_t *, unsigned);
 
 /*
  * We keep the following two functions inline to ensure that we start
@@ -119,7 +134,8 @@ static inline void bench_run_stop(bench_run_t *run)
 }
 
 extern errno_t csv_report_open(const char *);
-extern void csv_report_add_entry(bench_run_t *, int, benchmark_t *, uint64_t);
+extern void csv_report_add_entry(bench_run_t *, int, size_t, benchmark_t *,
+    uint64_t);
 extern void csv_report_close(void);
 
 extern errno_t bench_env_init(bench_env_t *);
@@ -131,13 +147,21 @@ extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_block_read;
 extern benchmark_t benchmark_dir_read;
+extern benchmark_t benchmark_double1;
 extern benchmark_t benchmark_fibril_mutex;
+extern benchmark_t benchmark_fibril_spawn;
+extern benchmark_t benchmark_fibril_wakeup;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_gfx_blit;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_memcpy1;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_tcp_rtt;
+extern benchmark_t benchmark_udp_rtt;
 
 #endif
 
@@ -35,6 +35,8 @@
  */
 
 #include <assert.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <getopt.h>
 #include <math.h>
 #include <stdio.h>
@@ -50,18 +52,22 @@
 
 #define MAX_ERROR_STR_LENGTH 1024
 
-static void short_report(bench_run_t *info, int run_index,
+/** Upper bound on extra warm-up runs before measurement starts. */
+#define MAX_WARMUP_RUNS 5
+
+static void short_report(bench_run_t *info, int run_index, size_t workers,
     benchmark_t *bench, uint64_t workload_size)
 {
-	csv_report_add_entry(info, run_index, bench, workload_size);
+	csv_report_add_entry(info, run_index, workers, bench, workload_size);
 
 	usec_t duration_usec = NSEC2USEC(stopwatch_get_nanos(&info->stopwatch));
 
 	printf("Completed %" PRIu64 " operations in %llu us",
-	    workload_size, duration_usec);
+	    workers * workload_size, duration_usec);
 	if (duration_usec > 0) {
 		double nanos = stopwatch_get_nanos(&info->stopwatch);
-		double thruput = (double) workload_size / (nanos / 1000000000.0l);
+		double thruput = (double) (workers * workload_size) /
+		    (nanos / 1000000000.0l);
 		printf(", %.0f ops/s.\n", thruput);
 	} else {
 		printf(".\n");
@@ -137,16 +143,206 @@ static void compute_stats(bench_run_t *runs, size_t run_count,
 }
 
 static void summary_stats(bench_run_t *runs, size_t run_count,
-    benchmark_t *bench, uint64_t workload_size)
+    benchmark_t *bench, size_t workers, uint64_t workload_size)
 {
 	double duration_avg, duration_sigma, thruput_avg;
-	compute_stats(runs, run_count, workload_size, 0.001,
+	compute_stats(runs, run_count, workers * workload_size, 0.001,
 	    &duration_avg, &duration_sigma, &thruput_avg);
 
 	printf("Average: %" PRIu64 " ops in %.0f us (sd %.0f us); "
-	    "%.0f ops/s; Samples: %zu\n",
-	    workload_size, duration_avg / 1000.0, duration_sigma / 1000.0,
-	    thruput_avg * 1000000000.0, run_count);
+	    "%.0f ops/s; Workers: %zu; Samples: %zu\n",
+	    workers * workload_size, duration_avg / 1000.0,
+	    duration_sigma / 1000.0, thruput_avg * 1000000000.0,
+	    workers, run_count);
+
+	/*
+	 * Pool latency samples from all measured runs to get the overall
+	 * latency distribution (runs without recorded latencies, i.e.
+	 * single-worker runs of benchmarks that only measure the whole
+	 * workload, contribute nothing).
+	 */
+	bench_run_t pooled;
+	bench_run_init(&pooled, NULL, 0);
+	for (size_t i = 0; i < run_count; i++) {
+		for (size_t j = 0; j < runs[i].latency_count; j++)
+			bench_run_record_latency(&pooled, runs[i].latencies[j]);
+	}
+	if (pooled.latency_count > 0) {
+		printf("Latency: p50 %lld ns, p95 %lld ns, p99 %lld ns "
+		    "(%zu samples)\n",
+		    (long long) bench_run_latency_percentile(&pooled, 50),
+		    (long long) bench_run_latency_percentile(&pooled, 95),
+		    (long long) bench_run_latency_percentile(&pooled, 99),
+		    pooled.latency_count);
+	}
+	bench_run_fini(&pooled);
+}
+
+/** State shared by all worker fibrils of one parallel run. */
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	/** All workers were created, start hammering */
+	bool go;
+	/** Workers that have not finished yet */
+	size_t active;
+} worker_group_t;
+
+typedef struct {
+	worker_group_t *group;
+	bench_env_t *env;
+	benchmark_t *bench;
+	bench_run_t run;
+	uint64_t workload_size;
+	bool ok;
+} worker_t;
+
+static errno_t worker_fibril(void *arg)
+{
+	worker_t *worker = arg;
+	worker_group_t *group = worker->group;
+	fibril_detach(fibril_get_id());
+
+	/*
+	 * Wait until all workers are created so that they execute the
+	 * workload concurrently rather than in creation order.
+	 */
+	fibril_mutex_lock(&group->mutex);
+	while (!group->go)
+		fibril_condvar_wait(&group->cv, &group->mutex);
+	fibril_mutex_unlock(&group->mutex);
+
+	worker->ok = worker->bench->entry(worker->env, &worker->run,
+	    worker->workload_size);
+
+	fibril_mutex_lock(&group->mutex);
+	group->active--;
+	if (group->active == 0)
+		fibril_condvar_signal(&group->cv);
+	fibril_mutex_unlock(&group->mutex);
+
+	return EOK;
+}
+
+/** Execute one run of the benchmark with the given number of workers.
+ *
+ * With a single worker the benchmark entry point is called directly.
+ * Otherwise worker fibrils each execute the full workload in parallel
+ * and @a run receives the wall-clock time of the whole parallel phase.
+ * Latency samples recorded by the workers are merged into @a run; when
+ * the benchmark does not record any, each worker contributes its
+ * average operation duration so that at least the spread between
+ * workers is visible.
+ */
+static bool parallel_run(bench_env_t *env, benchmark_t *bench,
+    bench_run_t *run, size_t workers, uint64_t workload_size)
+{
+	if (workers == 1)
+		return bench->entry(env, run, workload_size);
+
+	worker_group_t group;
+	fibril_mutex_initialize(&group.mutex);
+	fibril_condvar_initialize(&group.cv);
+	group.go = false;
+	group.active = 0;
+
+	worker_t *worker = calloc(workers, sizeof(worker_t));
+	char *error_bufs = malloc(workers * (MAX_ERROR_STR_LENGTH + 1));
+	if (worker == NULL || error_bufs == NULL) {
+		free(worker);
+		free(error_bufs);
+		return bench_run_fail(run, "failed allocating worker structures");
+	}
+
+	bool ret = true;
+	size_t started = 0;
+
+	for (size_t i = 0; i < workers; i++) {
+		worker[i].group = &group;
+		worker[i].env = env;
+		worker[i].bench = bench;
+		worker[i].workload_size = workload_size;
+		worker[i].ok = true;
+		bench_run_init(&worker[i].run,
+		    error_bufs + i * (MAX_ERROR_STR_LENGTH + 1),
+		    MAX_ERROR_STR_LENGTH);
+
+		fid_t fid = fibril_create(worker_fibril, &worker[i]);
+		if (fid == 0) {
+			ret = bench_run_fail(run, "failed to create worker fibril");
+			break;
+		}
+		group.active++;
+		started++;
+		fibril_start(fid);
+	}
+
+	/*
+	 * Even on fibril creation failure we must release the workers
+	 * already started (they reference our stack) and let them drain.
+	 */
+	bench_run_start(run);
+	fibril_mutex_lock(&group.mutex);
+	group.go = true;
+	fibril_condvar_broadcast(&group.cv);
+	while (group.active > 0)
+		fibril_condvar_wait(&group.cv, &group.mutex);
+	fibril_mutex_unlock(&group.mutex);
+	bench_run_stop(run);
+
+	bool have_latencies = false;
+	for (size_t i = 0; i < started; i++) {
+		if (!worker[i].ok && ret) {
+			ret = bench_run_fail(run, "worker %zu: %s", i,
+			    worker[i].run.error_message);
+		}
+		if (worker[i].run.latency_count > 0)
+			have_latencies = true;
+	}
+
+	if (ret) {
+		for (size_t i = 0; i < started; i++) {
+			if (have_latencies) {
+				for (size_t j = 0; j < worker[i].run.latency_count; j++) {
+					bench_run_record_latency(run,
+					    worker[i].run.latencies[j]);
+				}
+			} else {
+				bench_run_record_latency(run,
+				    stopwatch_get_nanos(&worker[i].run.stopwatch) /
+				    (nsec_t) workload_size);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < started; i++)
+		bench_run_fini(&worker[i].run);
+	free(error_bufs);
+	free(worker);
+
+	return ret;
+}
+
+/** Decide whether the warm-up phase is over.
+ *
+ * The benchmark is considered warmed-up when the last three run
+ * durations are within 5 % of each other.
+ */
+static bool warmed_up(nsec_t *durations, size_t count)
+{
+	if (count < 3)
+		return false;
+
+	nsec_t min = durations[count - 3];
+	nsec_t max = durations[count - 3];
+	for (size_t i = count - 2; i < count; i++) {
+		if (durations[i] < min)
+			min = durations[i];
+		if (durations[i] > max)
+			max = durations[i];
+	}
+
+	return (max - min) * 20 <= min;
 }
 
 static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
@@ -193,11 +389,13 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 
 		bool ok = bench->entry(env, &run, workload_size);
 		if (!ok) {
+			bench_run_fini(&run);
 			goto leave_error;
 		}
-		short_report(&run, -1, bench, workload_size);
+		short_report(&run, -1, 1, bench, workload_size);
 
 		nsec_t duration = stopwatch_get_nanos(&run.stopwatch);
+		bench_run_fini(&run);
 		if (duration > env->minimal_run_duration_nanos) {
 			break;
 		}
@@ -206,27 +404,75 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 	printf("Workload size set to %" PRIu64 ", measuring %zu samples.\n",
 	    workload_size, env->run_count);
 
-	bench_run_t *runs = calloc(env->run_count, sizeof(bench_run_t));
-	if (runs == NULL) {
-		snprintf(error_msg, MAX_ERROR_STR_LENGTH, "failed allocating memory");
-		goto leave_error;
-	}
-	for (size_t i = 0; i < env->run_count; i++) {
-		bench_run_init(&runs[i], error_msg, MAX_ERROR_STR_LENGTH);
+	/*
+	 * Measure with increasing worker counts (powers of two up to the
+	 * configured maximum) so that scalability trends show up in the
+	 * report.
+	 */
+	size_t workers = 1;
+	while (true) {
+		if (env->max_workers > 1)
+			printf("Measuring with %zu worker(s)...\n", workers);
+
+		/*
+		 * Extra warm-up runs: measure only once durations
+		 * stabilize (the workload sizing above already did part
+		 * of the job for the single-worker case).
+		 */
+		nsec_t warmup_durations[MAX_WARMUP_RUNS];
+		size_t warmups = 0;
+		while (warmups < MAX_WARMUP_RUNS &&
+		    !warmed_up(warmup_durations, warmups)) {
+			bench_run_t run;
+			bench_run_init(&run, error_msg, MAX_ERROR_STR_LENGTH);
+
+			bool ok = parallel_run(env, bench, &run, workers,
+			    workload_size);
+			if (!ok) {
+				bench_run_fini(&run);
+				goto leave_error;
+			}
+			short_report(&run, -1 - (int) warmups, workers, bench,
+			    workload_size);
+			warmup_durations[warmups++] =
+			    stopwatch_get_nanos(&run.stopwatch);
+			bench_run_fini(&run);
+		}
 
-		bool ok = bench->entry(env, &runs[i], workload_size);
-		if (!ok) {
-			free(runs);
+		bench_run_t *runs = calloc(env->run_count, sizeof(bench_run_t));
+		if (runs == NULL) {
+			snprintf(error_msg, MAX_ERROR_STR_LENGTH, "failed allocating memory");
 			goto leave_error;
 		}
-		short_report(&runs[i], i, bench, workload_size);
+		for (size_t i = 0; i < env->run_count; i++) {
+			bench_run_init(&runs[i], error_msg, MAX_ERROR_STR_LENGTH);
+
+			bool ok = parallel_run(env, bench, &runs[i], workers,
+			    workload_size);
+			if (!ok) {
+				for (size_t j = 0; j <= i; j++)
+					bench_run_fini(&runs[j]);
+				free(runs);
+				goto leave_error;
+			}
+			short_report(&runs[i], i, workers, bench, workload_size);
+		}
+
+		summary_stats(runs, env->run_count, bench, workers, workload_size);
+
+		for (size_t i = 0; i < env->run_count; i++)
+			bench_run_fini(&runs[i]);
+		free(runs);
+
+		if (workers >= env->max_workers)
+			break;
+		workers *= 2;
+		if (workers > env->max_workers)
+			workers = env->max_workers;
 	}
 
-	summary_stats(runs, env->run_count, bench, workload_size);
 	printf("\nBenchmark completed\n");
 
-	free(runs);
-
 	goto leave;
 
 leave_error:
@@ -316,6 +562,8 @@ static void print_usage(const char *progname)
 	    "Store machine-readable data in filename.csv\n");
 	printf("-p, --param KEY=VALUE      "
 	    "Additional parameters for the benchmark\n");
+	printf("-w, --workers N            "
+	    "Measure with 1, 2, 4, ... up to N parallel workers\n");
 	printf("<benchmark> is one of the following:\n");
 	list_benchmarks();
 }
@@ -337,13 +585,14 @@ int main(int argc, char *argv[])
 		return -5;
 	}
 
-	const char *short_options = "ho:p:n:d:";
+	const char *short_options = "ho:p:n:d:w:";
 	struct option long_options[] = {
 		{ "duration", required_argument, NULL, 'd' },
 		{ "help", optional_argument, NULL, 'h' },
 		{ "count", required_argument, NULL, 'n' },
 		{ "output", required_argument, NULL, 'o' },
 		{ "param", required_argument, NULL, 'p' },
+		{ "workers", required_argument, NULL, 'w' },
 		{ 0, 0, NULL, 0 }
 	};
 
@@ -377,6 +626,14 @@ int main(int argc, char *argv[])
 		case 'p':
 			handle_param_arg(&bench_env, optarg);
 			break;
+		case 'w':
+			errno = EOK;
+			bench_env.max_workers = (size_t) atoll(optarg);
+			if ((errno != EOK) || (bench_env.max_workers <= 0)) {
+				fprintf(stderr, "Invalid -w argument.\n");
+				return -3;
+			}
+			break;
 		case -1:
 		default:
 			break;
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <mem.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Use a buffer that exceeds the vectorized copy threshold but
+ * still fits comfortably in the L1 cache, so the benchmark
+ * measures the copy routine rather than the memory bus.
+ */
+#define BUFFER_SIZE  8192
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	char *src = malloc(BUFFER_SIZE);
+	char *dst = malloc(BUFFER_SIZE);
+
+	if ((src == NULL) || (dst == NULL)) {
+		free(src);
+		free(dst);
+		return bench_run_fail(run, "failed to allocate %d B buffers",
+		    2 * BUFFER_SIZE);
+	}
+
+	memset(src, 0x5a, BUFFER_SIZE);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++)
+		memcpy(dst, src, BUFFER_SIZE);
+	bench_run_stop(run);
+
+	free(src);
+	free(dst);
+
+	return true;
+}
+
+benchmark_t benchmark_memcpy1 = {
+	.name = "memcpy1",
+	.desc = "memcpy() benchmark, repeatedly copy an 8 KiB buffer",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
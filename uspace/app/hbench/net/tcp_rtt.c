@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Measures TCP round-trip time through the networking stack. A listener
+ * and a client connection are created in-process on the loopback address
+ * and a message is echoed back and forth; each iteration is one full
+ * round trip (two passes through the TCP server).
+ *
+ * Parameters:
+ *  - port: TCP port to listen on (default 8770)
+ *  - msg_size: message size in bytes (default 64); larger sizes turn
+ *    this into a throughput benchmark
+ */
+
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	/** Server side of the connection (set by the listener callback) */
+	tcp_conn_t *srv_conn;
+	/** Benchmark is shutting down, no connection will arrive */
+	bool stop;
+	/** Echo fibril has terminated */
+	bool echo_done;
+	size_t msg_size;
+} shared_t;
+
+static void conn_new(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	shared_t *shared = tcp_listener_userptr(lst);
+
+	fibril_mutex_lock(&shared->mutex);
+	shared->srv_conn = conn;
+	fibril_condvar_signal(&shared->cv);
+	fibril_mutex_unlock(&shared->mutex);
+}
+
+static tcp_listen_cb_t listen_cb = {
+	.new_conn = conn_new
+};
+
+static tcp_cb_t conn_cb = {
+};
+
+/** Echo everything received on the server connection back to the sender. */
+static errno_t echo_fibril(void *arg)
+{
+	shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	fibril_mutex_lock(&shared->mutex);
+	while (shared->srv_conn == NULL && !shared->stop)
+		fibril_condvar_wait(&shared->cv, &shared->mutex);
+	tcp_conn_t *conn = shared->srv_conn;
+	fibril_mutex_unlock(&shared->mutex);
+
+	char *buf = conn != NULL ? malloc(shared->msg_size) : NULL;
+	if (buf != NULL) {
+		while (true) {
+			size_t nread;
+			errno_t rc = tcp_conn_recv_wait(conn, buf,
+			    shared->msg_size, &nread);
+			if (rc != EOK || nread == 0)
+				break;
+			if (tcp_conn_send(conn, buf, nread) != EOK)
+				break;
+		}
+		free(buf);
+	}
+
+	fibril_mutex_lock(&shared->mutex);
+	shared->echo_done = true;
+	fibril_condvar_signal(&shared->cv);
+	fibril_mutex_unlock(&shared->mutex);
+
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	tcp_t *tcp = NULL;
+	tcp_listener_t *lst = NULL;
+	tcp_conn_t *conn = NULL;
+	char *buf = NULL;
+	shared_t shared;
+	inet_ep_t ep;
+	inet_ep2_t epp;
+	uint64_t port;
+	uint64_t msg_size;
+	errno_t rc;
+	bool ret = true;
+	bool echo_started = false;
+
+	const char *port_str = bench_env_param_get(env, "port", "8770");
+	const char *size_str = bench_env_param_get(env, "msg_size", "64");
+
+	rc = str_uint64_t(port_str, NULL, 10, true, &port);
+	if (rc != EOK || port == 0 || port > 65535)
+		return bench_run_fail(run, "invalid port '%s'", port_str);
+
+	rc = str_uint64_t(size_str, NULL, 10, true, &msg_size);
+	if (rc != EOK || msg_size == 0)
+		return bench_run_fail(run, "invalid msg_size '%s'", size_str);
+
+	fibril_mutex_initialize(&shared.mutex);
+	fibril_condvar_initialize(&shared.cv);
+	shared.srv_conn = NULL;
+	shared.stop = false;
+	shared.echo_done = false;
+	shared.msg_size = msg_size;
+
+	buf = malloc(msg_size);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate buffer");
+	memset(buf, 'x', msg_size);
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed contacting TCP service");
+		goto out;
+	}
+
+	inet_ep_init(&ep);
+	ep.port = (uint16_t) port;
+
+	rc = tcp_listener_create(tcp, &ep, &listen_cb, &shared, &conn_cb,
+	    NULL, &lst);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed creating listener");
+		goto out;
+	}
+
+	fid_t fid = fibril_create(echo_fibril, &shared);
+	if (fid == 0) {
+		ret = bench_run_fail(run, "failed to create echo fibril");
+		goto out;
+	}
+	fibril_add_ready(fid);
+	echo_started = true;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.remote.addr, 127, 0, 0, 1);
+	epp.remote.port = (uint16_t) port;
+
+	rc = tcp_conn_create(tcp, &epp, &conn_cb, NULL, &conn);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed creating connection");
+		goto out;
+	}
+
+	rc = tcp_conn_wait_connected(conn);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed connecting to loopback");
+		goto out;
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = tcp_conn_send(conn, buf, msg_size);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			ret = bench_run_fail(run, "send failed");
+			goto out;
+		}
+
+		size_t total = 0;
+		while (total < msg_size) {
+			size_t nread;
+			rc = tcp_conn_recv_wait(conn, buf + total,
+			    msg_size - total, &nread);
+			if (rc != EOK) {
+				bench_run_stop(run);
+				ret = bench_run_fail(run, "receive failed");
+				goto out;
+			}
+			total += nread;
+		}
+	}
+	bench_run_stop(run);
+
+out:
+	if (conn != NULL)
+		tcp_conn_send_fin(conn);
+
+	if (echo_started) {
+		/*
+		 * Wake the echo fibril up and wait until it terminates
+		 * (it must not outlive our stack-allocated state).
+		 */
+		fibril_mutex_lock(&shared.mutex);
+		shared.stop = true;
+		fibril_condvar_broadcast(&shared.cv);
+		while (!shared.echo_done)
+			fibril_condvar_wait(&shared.cv, &shared.mutex);
+		fibril_mutex_unlock(&shared.mutex);
+	}
+
+	if (conn != NULL)
+		tcp_conn_destroy(conn);
+	if (shared.srv_conn != NULL)
+		tcp_conn_destroy(shared.srv_conn);
+	if (lst != NULL)
+		tcp_listener_destroy(lst);
+	if (tcp != NULL)
+		tcp_destroy(tcp);
+	free(buf);
+	return ret;
+}
+
+benchmark_t benchmark_tcp_rtt = {
+	.name = "tcp_rtt",
+	.desc = "TCP loopback round-trip time / throughput",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/udp.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Measures UDP round-trip time through the networking stack. Two
+ * associations are created in-process: an echo server bound to the
+ * given port on loopback and a client that sends a datagram and waits
+ * for the reflected reply. Each iteration is one round trip.
+ *
+ * Parameters:
+ *  - port: UDP port for the echo association (default 8770)
+ *  - msg_size: datagram size in bytes (default 64)
+ */
+
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	/** A reply to the last datagram has arrived */
+	bool reply_received;
+	size_t msg_size;
+	/** Scratch buffer for the echo callback */
+	char *echo_buf;
+} shared_t;
+
+/** Reflect each received datagram back to its sender. */
+static void echo_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	shared_t *shared = udp_assoc_userptr(assoc);
+	inet_ep_t remote;
+	size_t size = udp_rmsg_size(rmsg);
+
+	if (size > shared->msg_size)
+		size = shared->msg_size;
+
+	if (udp_rmsg_read(rmsg, 0, shared->echo_buf, size) != EOK)
+		return;
+
+	udp_rmsg_remote_ep(rmsg, &remote);
+	(void) udp_assoc_send_msg(assoc, &remote, shared->echo_buf, size);
+}
+
+static void client_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	shared_t *shared = udp_assoc_userptr(assoc);
+
+	fibril_mutex_lock(&shared->mutex);
+	shared->reply_received = true;
+	fibril_condvar_signal(&shared->cv);
+	fibril_mutex_unlock(&shared->mutex);
+}
+
+static udp_cb_t echo_cb = {
+	.recv_msg = echo_recv_msg
+};
+
+static udp_cb_t client_cb = {
+	.recv_msg = client_recv_msg
+};
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	udp_t *udp = NULL;
+	udp_assoc_t *echo_assoc = NULL;
+	udp_assoc_t *client_assoc = NULL;
+	char *buf = NULL;
+	shared_t shared;
+	inet_ep2_t epp;
+	inet_ep_t server_ep;
+	uint64_t port;
+	uint64_t msg_size;
+	errno_t rc;
+	bool ret = true;
+
+	const char *port_str = bench_env_param_get(env, "port", "8770");
+	const char *size_str = bench_env_param_get(env, "msg_size", "64");
+
+	rc = str_uint64_t(port_str, NULL, 10, true, &port);
+	if (rc != EOK || port == 0 || port > 65535)
+		return bench_run_fail(run, "invalid port '%s'", port_str);
+
+	rc = str_uint64_t(size_str, NULL, 10, true, &msg_size);
+	if (rc != EOK || msg_size == 0)
+		return bench_run_fail(run, "invalid msg_size '%s'", size_str);
+
+	fibril_mutex_initialize(&shared.mutex);
+	fibril_condvar_initialize(&shared.cv);
+	shared.reply_received = false;
+	shared.msg_size = msg_size;
+
+	buf = malloc(msg_size);
+	shared.echo_buf = malloc(msg_size);
+	if (buf == NULL || shared.echo_buf == NULL) {
+		ret = bench_run_fail(run, "failed to allocate buffers");
+		goto out;
+	}
+	memset(buf, 'x', msg_size);
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed contacting UDP service");
+		goto out;
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 127, 0, 0, 1);
+	epp.local.port = (uint16_t) port;
+
+	rc = udp_assoc_create(udp, &epp, &echo_cb, &shared, &echo_assoc);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed creating echo association");
+		goto out;
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 127, 0, 0, 1);
+	epp.local.port = (uint16_t) port + 1;
+
+	rc = udp_assoc_create(udp, &epp, &client_cb, &shared, &client_assoc);
+	if (rc != EOK) {
+		ret = bench_run_fail(run, "failed creating client association");
+		goto out;
+	}
+
+	inet_ep_init(&server_ep);
+	inet_addr(&server_ep.addr, 127, 0, 0, 1);
+	server_ep.port = (uint16_t) port;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		fibril_mutex_lock(&shared.mutex);
+		shared.reply_received = false;
+		fibril_mutex_unlock(&shared.mutex);
+
+		rc = udp_assoc_send_msg(client_assoc, &server_ep, buf,
+		    msg_size);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			ret = bench_run_fail(run, "send failed");
+			goto out;
+		}
+
+		fibril_mutex_lock(&shared.mutex);
+		while (!shared.reply_received)
+			fibril_condvar_wait(&shared.cv, &shared.mutex);
+		fibril_mutex_unlock(&shared.mutex);
+	}
+	bench_run_stop(run);
+
+out:
+	if (client_assoc != NULL)
+		udp_assoc_destroy(client_assoc);
+	if (echo_assoc != NULL)
+		udp_assoc_destroy(echo_assoc);
+	if (udp != NULL)
+		udp_destroy(udp);
+	free(shared.echo_buf);
+	free(buf);
+	return ret;
+}
+
+benchmark_t benchmark_udp_rtt = {
+	.name = "udp_rtt",
+	.desc = "UDP loopback round-trip time",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * A mix of integral values (the common telemetry case) and values
+ * exercising the full shortest-representation machinery.
+ */
+static const double samples[] = {
+	0.0, 1.0, 42.0, 1000000.0, 4294967296.0, 1.5, 0.1,
+	3.14159265358979, 2.718281828e-10, 6.02214076e23, 123456.789
+};
+
+#define SAMPLES  (sizeof(samples) / sizeof(samples[0]))
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	char buf[64];
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		snprintf(buf, sizeof(buf), "%g", samples[i % SAMPLES]);
+		snprintf(buf, sizeof(buf), "%.3f", samples[i % SAMPLES]);
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_double1 = {
+	.name = "double1",
+	.desc = "Double formatting benchmark, snprintf() with %g and %.3f",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril_synch.h>
+#include "../hbench.h"
+
+/*
+ * Measures fibril wakeup latency: two fibrils hand a token back and
+ * forth through a condition variable, so every iteration is one
+ * signal, one wakeup and one context switch in each direction.
+ */
+
+typedef struct {
+	fibril_mutex_t mutex;
+	fibril_condvar_t cv;
+	/** Whose turn it is: false for the main fibril, true for the echo */
+	bool echo_turn;
+	uint64_t count;
+} shared_t;
+
+static errno_t echo_fibril(void *arg)
+{
+	shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	fibril_mutex_lock(&shared->mutex);
+	while (shared->count > 0) {
+		while (!shared->echo_turn)
+			fibril_condvar_wait(&shared->cv, &shared->mutex);
+		shared->count--;
+		shared->echo_turn = false;
+		fibril_condvar_signal(&shared->cv);
+	}
+	fibril_mutex_unlock(&shared->mutex);
+
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	shared_t shared;
+
+	fibril_mutex_initialize(&shared.mutex);
+	fibril_condvar_initialize(&shared.cv);
+	shared.echo_turn = false;
+	shared.count = size;
+
+	fid_t other = fibril_create(echo_fibril, &shared);
+	if (other == 0)
+		return bench_run_fail(run, "failed to create echo fibril");
+	fibril_add_ready(other);
+
+	bench_run_start(run);
+	fibril_mutex_lock(&shared.mutex);
+	while (shared.count > 0) {
+		shared.echo_turn = true;
+		fibril_condvar_signal(&shared.cv);
+		while (shared.echo_turn && shared.count > 0)
+			fibril_condvar_wait(&shared.cv, &shared.mutex);
+	}
+	fibril_mutex_unlock(&shared.mutex);
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_fibril_wakeup = {
+	.name = "fibril_wakeup",
+	.desc = "Fibril wakeup latency (condition variable ping-pong)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
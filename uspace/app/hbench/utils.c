@@ -33,8 +33,10 @@
  * @file
  */
 
+#include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "hbench.h"
 
 /** Initialize bench run structure.
@@ -48,6 +50,86 @@ void bench_run_init(bench_run_t *run, char *error_buffer, size_t error_buffer_si
 	stopwatch_init(&run->stopwatch);
 	run->error_message = error_buffer;
 	run->error_message_buffer_size = error_buffer_size;
+	run->latencies = NULL;
+	run->latency_count = 0;
+	run->latency_capacity = 0;
+}
+
+/** Release resources owned by a bench run structure.
+ *
+ * Does not touch the error buffer, which is owned by the caller
+ * of bench_run_init().
+ *
+ * @param run Structure to finalize.
+ */
+void bench_run_fini(bench_run_t *run)
+{
+	free(run->latencies);
+	run->latencies = NULL;
+	run->latency_count = 0;
+	run->latency_capacity = 0;
+}
+
+/** Record latency of a single operation.
+ *
+ * Benchmarks may call this for each operation (or a sample of them)
+ * to allow the harness to report latency percentiles. The sample is
+ * silently dropped when memory cannot be allocated: losing a data
+ * point is preferable to failing the whole run.
+ *
+ * @param run Current benchmark run.
+ * @param nanos Duration of the operation in nanoseconds.
+ */
+void bench_run_record_latency(bench_run_t *run, nsec_t nanos)
+{
+	if (run->latency_count >= run->latency_capacity) {
+		size_t new_capacity = run->latency_capacity > 0 ?
+		    run->latency_capacity * 2 : 64;
+		nsec_t *tmp = realloc(run->latencies,
+		    new_capacity * sizeof(nsec_t));
+		if (tmp == NULL)
+			return;
+		run->latencies = tmp;
+		run->latency_capacity = new_capacity;
+	}
+
+	run->latencies[run->latency_count++] = nanos;
+}
+
+static int latency_cmp(const void *a, const void *b)
+{
+	nsec_t la = *(const nsec_t *) a;
+	nsec_t lb = *(const nsec_t *) b;
+
+	if (la < lb)
+		return -1;
+	if (la > lb)
+		return 1;
+	return 0;
+}
+
+/** Compute latency percentile from recorded samples.
+ *
+ * Uses the nearest-rank method. Sorts the recorded samples in place.
+ *
+ * @param run Run with at least one recorded latency sample.
+ * @param percentile Percentile to compute (1 to 100).
+ * @return Latency percentile in nanoseconds.
+ */
+nsec_t bench_run_latency_percentile(bench_run_t *run, unsigned percentile)
+{
+	assert(run->latency_count > 0);
+
+	qsort(run->latencies, run->latency_count, sizeof(nsec_t),
+	    latency_cmp);
+
+	size_t rank = (percentile * run->latency_count + 99) / 100;
+	if (rank > 0)
+		rank--;
+	if (rank >= run->latency_count)
+		rank = run->latency_count - 1;
+
+	return run->latencies[rank];
 }
 
 /** Format error message on benchmark failure.
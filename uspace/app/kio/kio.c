@@ -166,6 +166,11 @@ static void kio_notification_handler(ipc_call_t *call, void *arg)
 	size_t kio_start = (size_t) ipc_get_arg1(call);
 	size_t kio_len = (size_t) ipc_get_arg2(call);
 	size_t kio_stored = (size_t) ipc_get_arg3(call);
+	size_t kio_lost = (size_t) ipc_get_arg4(call);
+
+	if (kio_lost > 0)
+		printf("%s: %zu characters of kernel log lost\n", NAME,
+		    kio_lost);
 
 	size_t offset = (kio_start + kio_len - kio_stored) % kio_length;
 
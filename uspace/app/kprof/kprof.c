@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2018 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kprof
+ * @{
+ */
+/**
+ * @file
+ * @brief Print kernel sampling profiler data.
+ *
+ * Reads the samples collected by the kernel sampling profiler from
+ * the system.profile sysinfo item and prints the hottest program
+ * counters, optionally symbolized against a kernel map file (in the
+ * format produced by nm on the kernel binary).
+ */
+
+#include <stddef.h>
+#include <abi/sysinfo.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <sysinfo.h>
+
+#define NAME  "kprof"
+
+/** Maximum number of program counters printed. */
+#define MAX_LINES  32
+
+/** One symbol loaded from the kernel map file. */
+typedef struct {
+	uint64_t addr;
+	char *name;
+} map_symbol_t;
+
+static map_symbol_t *symbols = NULL;
+static size_t symbol_count = 0;
+
+static int map_symbol_cmp(const void *a, const void *b)
+{
+	const map_symbol_t *sym_a = (const map_symbol_t *) a;
+	const map_symbol_t *sym_b = (const map_symbol_t *) b;
+
+	if (sym_a->addr < sym_b->addr)
+		return -1;
+
+	if (sym_a->addr > sym_b->addr)
+		return 1;
+
+	return 0;
+}
+
+/** Load symbols from a kernel map file.
+ *
+ * Each line is expected to start with a hexadecimal address and end
+ * with a symbol name (nm output format). Lines that do not parse are
+ * silently skipped.
+ *
+ * @param path Map file path.
+ *
+ * @return True on success, false if the file could not be opened.
+ *
+ */
+static bool load_map(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return false;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		const char *end;
+		uint64_t addr;
+		if (str_uint64_t(line, &end, 16, false, &addr) != EOK)
+			continue;
+
+		/* The symbol name is the last whitespace-separated token */
+		const char *name = NULL;
+		const char *cur;
+		for (cur = end; *cur != 0; cur++) {
+			if ((*cur == ' ') || (*cur == '\t') || (*cur == '\n'))
+				name = NULL;
+			else if (name == NULL)
+				name = cur;
+		}
+
+		if (name == NULL)
+			continue;
+
+		map_symbol_t *tmp = (map_symbol_t *) realloc(symbols,
+		    (symbol_count + 1) * sizeof(map_symbol_t));
+		if (tmp == NULL)
+			break;
+
+		symbols = tmp;
+		symbols[symbol_count].addr = addr;
+		symbols[symbol_count].name = str_dup(name);
+		if (symbols[symbol_count].name == NULL)
+			break;
+
+		/* Strip the trailing newline */
+		char *newline = str_chr(symbols[symbol_count].name, '\n');
+		if (newline != NULL)
+			*newline = 0;
+
+		symbol_count++;
+	}
+
+	fclose(file);
+
+	qsort(symbols, symbol_count, sizeof(map_symbol_t), map_symbol_cmp);
+	return true;
+}
+
+/** Find the symbol covering the given address.
+ *
+ * @param addr   Address to symbolize.
+ * @param offset Offset of the address within the symbol.
+ *
+ * @return Symbol name or NULL if there is no covering symbol.
+ *
+ */
+static const char *symbolize(uint64_t addr, uint64_t *offset)
+{
+	if ((symbol_count == 0) || (addr < symbols[0].addr))
+		return NULL;
+
+	size_t low = 0;
+	size_t high = symbol_count;
+	while (high - low > 1) {
+		size_t middle = (low + high) / 2;
+		if (symbols[middle].addr <= addr)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	*offset = addr - symbols[low].addr;
+	return symbols[low].name;
+}
+
+static int sample_pc_cmp(const void *a, const void *b)
+{
+	const prof_sample_t *sample_a = (const prof_sample_t *) a;
+	const prof_sample_t *sample_b = (const prof_sample_t *) b;
+
+	if (sample_a->pc < sample_b->pc)
+		return -1;
+
+	if (sample_a->pc > sample_b->pc)
+		return 1;
+
+	return 0;
+}
+
+typedef struct {
+	uint64_t pc;
+	size_t count;
+} pc_count_t;
+
+static int pc_count_cmp(const void *a, const void *b)
+{
+	const pc_count_t *count_a = (const pc_count_t *) a;
+	const pc_count_t *count_b = (const pc_count_t *) b;
+
+	if (count_a->count > count_b->count)
+		return -1;
+
+	if (count_a->count < count_b->count)
+		return 1;
+
+	return 0;
+}
+
+/** Fetch, aggregate and print the profiling samples.
+ *
+ * @return True on success.
+ *
+ */
+static bool print_profile(void)
+{
+	size_t size;
+	prof_sample_t *samples =
+	    (prof_sample_t *) sysinfo_get_data("system.profile", &size);
+	if (samples == NULL) {
+		fprintf(stderr, "%s: Unable to get profiling samples\n", NAME);
+		return false;
+	}
+
+	/* Compact the valid samples to the beginning of the buffer */
+	size_t count = 0;
+	size_t i;
+	for (i = 0; i < size / sizeof(prof_sample_t); i++) {
+		if (samples[i].pc != 0)
+			samples[count++] = samples[i];
+	}
+
+	if (count == 0) {
+		printf("%s: No samples collected (is the profiler started?)\n",
+		    NAME);
+		free(samples);
+		return true;
+	}
+
+	qsort(samples, count, sizeof(prof_sample_t), sample_pc_cmp);
+
+	/* Aggregate hit counts of identical program counters */
+	pc_count_t *counts = (pc_count_t *) calloc(count, sizeof(pc_count_t));
+	if (counts == NULL) {
+		fprintf(stderr, "%s: Out of memory\n", NAME);
+		free(samples);
+		return false;
+	}
+
+	size_t distinct = 0;
+	for (i = 0; i < count; i++) {
+		if ((distinct > 0) &&
+		    (counts[distinct - 1].pc == samples[i].pc)) {
+			counts[distinct - 1].count++;
+			continue;
+		}
+
+		counts[distinct].pc = samples[i].pc;
+		counts[distinct].count = 1;
+		distinct++;
+	}
+
+	qsort(counts, distinct, sizeof(pc_count_t), pc_count_cmp);
+
+	printf("%zu samples, %zu distinct program counters\n", count, distinct);
+	printf("[samples] [pct] [pc              ] [symbol]\n");
+
+	size_t lines = (distinct < MAX_LINES) ? distinct : MAX_LINES;
+	for (i = 0; i < lines; i++) {
+		printf("%9zu %4zu%% %18" PRIx64 " ", counts[i].count,
+		    counts[i].count * 100 / count, counts[i].pc);
+
+		uint64_t offset;
+		const char *name = symbolize(counts[i].pc, &offset);
+		if (name != NULL)
+			printf("%s+%" PRIu64 "\n", name, offset);
+		else
+			printf("<unknown>\n");
+	}
+
+	free(counts);
+	free(samples);
+	return true;
+}
+
+static void usage(const char *name)
+{
+	printf(
+	    "Usage: %s [-m map_file]\n"
+	    "\n"
+	    "Options:\n"
+	    "\t-m map_file\n"
+	    "\t\tSymbolize samples against a kernel map file (nm format)\n"
+	    "\n"
+	    "\t-h | --help\n"
+	    "\t\tPrint this usage information\n"
+	    "\n"
+	    "Use the kernel console 'profile start' and 'profile stop'\n"
+	    "commands to control the collection of samples\n",
+	    name);
+}
+
+int main(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++) {
+		if ((str_cmp(argv[i], "-h") == 0) ||
+		    (str_cmp(argv[i], "--help") == 0)) {
+			usage(argv[0]);
+			return 0;
+		}
+
+		if (str_cmp(argv[i], "-m") == 0) {
+			i++;
+			if (i >= argc) {
+				usage(argv[0]);
+				return 1;
+			}
+
+			if (!load_map(argv[i])) {
+				fprintf(stderr, "%s: Unable to read map "
+				    "file '%s'\n", NAME, argv[i]);
+				return 1;
+			}
+
+			continue;
+		}
+
+		usage(argv[0]);
+		return 1;
+	}
+
+	return print_profile() ? 0 : 1;
+}
+
+/** @}
+ */
@@ -59,6 +59,9 @@
 /** Divide and round up. */
 #define div_round_up(a, b) (((a) + (b) - 1) / (b))
 
+/** Batch size for writing runs of sectors */
+#define WRITE_BATCH_BYTES (1024 * 1024)
+
 /** Default file-system parameters */
 enum {
 	default_sector_size		= 512,
@@ -365,13 +368,59 @@ static errno_t fat_params_compute(struct fat_cfg *cfg)
 	return EOK;
 }
 
+/** Write a run of zero sectors in large batches.
+ *
+ * Each batch is read back first and only written if it contains any
+ * non-zero data, so re-formatting already blank (e.g. freshly erased)
+ * media is read-bound and spares the flash unnecessary program cycles.
+ * The caller-provided batch buffer is clobbered.
+ */
+static errno_t fat_zero_write(service_id_t service_id, aoff64_t addr,
+    uint32_t cnt, uint8_t *buffer, uint32_t batch_sectors, size_t sector_size)
+{
+	uint32_t now;
+	size_t pos;
+	size_t nbytes;
+	bool blank;
+	errno_t rc;
+
+	while (cnt > 0) {
+		now = cnt < batch_sectors ? cnt : batch_sectors;
+		nbytes = (size_t) now * sector_size;
+
+		blank = false;
+		rc = block_read_direct(service_id, addr, now, buffer);
+		if (rc == EOK) {
+			blank = true;
+			for (pos = 0; pos < nbytes; ++pos) {
+				if (buffer[pos] != 0) {
+					blank = false;
+					break;
+				}
+			}
+		}
+
+		if (!blank) {
+			memset(buffer, 0, nbytes);
+			rc = block_write_direct(service_id, addr, now, buffer);
+			if (rc != EOK)
+				return EIO;
+		}
+
+		addr += now;
+		cnt -= now;
+	}
+
+	return EOK;
+}
+
 /** Create file system with the given parameters. */
 static errno_t fat_blocks_write(struct fat_cfg const *cfg, service_id_t service_id)
 {
 	aoff64_t addr;
 	uint8_t *buffer;
+	uint32_t batch_sectors;
 	int i;
-	uint32_t j;
 	errno_t rc;
 	struct fat_bs bs;
 	fat_dentry_t *de;
@@ -386,76 +435,88 @@ static errno_t fat_blocks_write(struct fat_cfg const *cfg, service_id_t service_
 
 	addr = BS_BLOCK + 1;
 
-	buffer = calloc(cfg->sector_size, 1);
+	batch_sectors = WRITE_BATCH_BYTES / cfg->sector_size;
+	if (batch_sectors == 0)
+		batch_sectors = 1;
+
+	buffer = calloc(batch_sectors, cfg->sector_size);
 	if (buffer == NULL)
 		return ENOMEM;
-	memset(buffer, 0, cfg->sector_size);
 
 	/* Reserved sectors */
-	for (i = 0; i < cfg->reserved_sectors - 1; ++i) {
-		rc = block_write_direct(service_id, addr, 1, buffer);
-		if (rc != EOK)
-			return EIO;
-
-		++addr;
+	rc = fat_zero_write(service_id, addr, cfg->reserved_sectors - 1,
+	    buffer, batch_sectors, cfg->sector_size);
+	if (rc != EOK) {
+		free(buffer);
+		return EIO;
 	}
 
+	addr += cfg->reserved_sectors - 1;
+
 	/* File allocation tables */
 	for (i = 0; i < cfg->fat_count; ++i) {
 		printf("Writing allocation table %d.\n", i + 1);
 
-		for (j = 0; j < cfg->fat_sectors; ++j) {
-			memset(buffer, 0, cfg->sector_size);
-			if (j == 0) {
-				buffer[0] = default_media_descriptor;
-				buffer[1] = 0xFF;
-				buffer[2] = 0xFF;
-				if (cfg->fat_type == FAT16) {
-					buffer[3] = 0xFF;
-				} else if (cfg->fat_type == FAT32) {
-					buffer[3] = 0x0F;
-					buffer[4] = 0xFF;
-					buffer[5] = 0xFF;
-					buffer[6] = 0xFF;
-					buffer[7] = 0x0F;
-					buffer[8] = 0xF8;
-					buffer[9] = 0xFF;
-					buffer[10] = 0xFF;
-					buffer[11] = 0x0F;
-				}
-			}
+		/* Only the first sector has non-zero content */
+		memset(buffer, 0, cfg->sector_size);
+		buffer[0] = default_media_descriptor;
+		buffer[1] = 0xFF;
+		buffer[2] = 0xFF;
+		if (cfg->fat_type == FAT16) {
+			buffer[3] = 0xFF;
+		} else if (cfg->fat_type == FAT32) {
+			buffer[3] = 0x0F;
+			buffer[4] = 0xFF;
+			buffer[5] = 0xFF;
+			buffer[6] = 0xFF;
+			buffer[7] = 0x0F;
+			buffer[8] = 0xF8;
+			buffer[9] = 0xFF;
+			buffer[10] = 0xFF;
+			buffer[11] = 0x0F;
+		}
 
-			rc = block_write_direct(service_id, addr, 1, buffer);
-			if (rc != EOK)
-				return EIO;
+		rc = block_write_direct(service_id, addr, 1, buffer);
+		if (rc != EOK) {
+			free(buffer);
+			return EIO;
+		}
 
-			++addr;
+		rc = fat_zero_write(service_id, addr + 1,
+		    cfg->fat_sectors - 1, buffer, batch_sectors,
+		    cfg->sector_size);
+		if (rc != EOK) {
+			free(buffer);
+			return EIO;
 		}
+
+		addr += cfg->fat_sectors;
 	}
 
 	/* Root directory */
 	printf("Writing root directory.\n");
 	memset(buffer, 0, cfg->sector_size);
-	de = (fat_dentry_t *)buffer;
-	size_t idx;
-	for (idx = 0; idx < cfg->rootdir_sectors; ++idx) {
-
-		if (idx == 0 && cfg->label != NULL) {
-			/* Set up volume label entry */
-			(void) fat_label_encode(&de->name, cfg->label);
-			de->attr = FAT_ATTR_VOLLABEL;
-			de->mtime = 0x1234; // XXX Proper time
-			de->mdate = 0x1234; // XXX Proper date
-		} else if (idx == 1) {
-			/* Clear volume label entry */
-			memset(buffer, 0, cfg->sector_size);
-		}
 
-		rc = block_write_direct(service_id, addr, 1, buffer);
-		if (rc != EOK)
-			return EIO;
+	if (cfg->label != NULL) {
+		/* Set up volume label entry */
+		de = (fat_dentry_t *)buffer;
+		(void) fat_label_encode(&de->name, cfg->label);
+		de->attr = FAT_ATTR_VOLLABEL;
+		de->mtime = 0x1234; // XXX Proper time
+		de->mdate = 0x1234; // XXX Proper date
+	}
 
-		++addr;
+	rc = block_write_direct(service_id, addr, 1, buffer);
+	if (rc != EOK) {
+		free(buffer);
+		return EIO;
+	}
+
+	rc = fat_zero_write(service_id, addr + 1, cfg->rootdir_sectors - 1,
+	    buffer, batch_sectors, cfg->sector_size);
+	if (rc != EOK) {
+		free(buffer);
+		return EIO;
 	}
 
 	free(buffer);
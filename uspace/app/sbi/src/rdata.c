@@ -211,6 +211,7 @@ rdata_value_t *rdata_value_new(void)
 		exit(1);
 	}
 
+	value->refs = 1;
 	return value;
 }
 
@@ -655,16 +656,20 @@ void rdata_symbol_delete(rdata_symbol_t *symbol_v)
 }
 
 /** Copy value.
+ *
+ * Values are immutable once constructed, so instead of cloning the var
+ * node tree we share the value node and increment its reference count.
  *
  * @param src		Input value
- * @param dest		Place to store pointer to new value
+ * @param dest		Place to store pointer to the shared value
  */
 void rdata_value_copy(rdata_value_t *src, rdata_value_t **dest)
 {
 	assert(src != NULL);
+	assert(src->refs > 0);
 
-	*dest = rdata_value_new();
-	rdata_var_copy(src->var, &(*dest)->var);
+	src->refs++;
+	*dest = src;
 }
 
 /** Make copy of a variable.
@@ -1057,13 +1062,20 @@ void rdata_aprop_indexed_destroy(rdata_aprop_indexed_t *aprop_indexed)
 
 /** Destroy value.
  *
- * Destroy a value node.
+ * Remove one reference to the value node. The value is actually
+ * destroyed when the last reference is removed.
  *
  * @param value		Value
  */
 void rdata_value_destroy(rdata_value_t *value)
 {
-	/* Assumption: Var nodes in values are not shared. */
+	assert(value->refs > 0);
+
+	/* The value might still be shared with someone else. */
+	if (--value->refs > 0)
+		return;
+
+	/* Var nodes in values are only shared via the value node. */
 	rdata_var_destroy(value->var);
 
 	/* Deallocate value node */
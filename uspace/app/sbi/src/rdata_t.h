@@ -270,11 +270,15 @@ typedef struct rdata_address {
 /** Value item. */
 typedef struct rdata_value {
 	/**
-	 * Read-only Variable holding a copy of the data. Currently we don't
-	 * allow sharing the same @c var node between different value nodes
-	 * so that when destroying the value we can destroy the var.
-	 *
-	 * We could share this, but would need to reference-count it.
+	 * Reference count. Since values are immutable once constructed,
+	 * copying a value amounts to sharing it and incrementing this
+	 * count. The value is destroyed when the count drops to zero.
+	 */
+	int refs;
+
+	/**
+	 * Read-only Variable holding a copy of the data. The var node
+	 * is owned by the value and destroyed together with it.
 	 */
 	rdata_var_t *var;
 } rdata_value_t;
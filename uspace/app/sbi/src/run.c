@@ -1446,9 +1446,8 @@ void run_cvt_value_item(run_t *run, rdata_item_t *item, rdata_item_t **ritem)
 		return;
 	}
 
-	/* Make a copy of the var node within. */
-	value = rdata_value_new();
-	rdata_var_copy(item->u.value->var, &value->var);
+	/* Share the value within (values are immutable). */
+	rdata_value_copy(item->u.value, &value);
 	*ritem = rdata_item_new(ic_value);
 	(*ritem)->u.value = value;
 }
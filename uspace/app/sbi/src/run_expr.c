@@ -263,7 +263,22 @@ static void run_nameref(run_t *run, stree_nameref_t *nameref,
 		csi = NULL;
 	}
 
-	sym = symbol_lookup_in_csi(run->program, csi, nameref->name);
+	/*
+	 * Check the inline cache first. The same name reference typically
+	 * resolves in the same CSI over and over (only with inherited code
+	 * can the CSI differ between activations), so this saves us from
+	 * walking the CSI hierarchy on every evaluation.
+	 */
+	if (csi != NULL && nameref->csi_cache == csi) {
+		sym = nameref->sym_cache;
+	} else {
+		sym = symbol_lookup_in_csi(run->program, csi, nameref->name);
+
+		if (csi != NULL) {
+			nameref->csi_cache = csi;
+			nameref->sym_cache = sym;
+		}
+	}
 
 	/* Existence should have been verified in type checking phase. */
 	assert(sym != NULL);
@@ -593,19 +608,29 @@ static void run_lit_string(run_t *run, stree_lit_string_t *lit_string,
 	rdata_string_t *string_v;
 
 #ifdef DEBUG_RUN_TRACE
-	printf("Run integer literal.\n");
+	printf("Run string literal.\n");
 #endif
 	(void) run;
 
-	item = rdata_item_new(ic_value);
-	value = rdata_value_new();
-	var = rdata_var_new(vc_string);
-	string_v = rdata_string_new();
+	/*
+	 * Construct the value only on the first evaluation and intern it
+	 * in the literal node. Subsequent evaluations just share it (the
+	 * literal keeps one reference for the lifetime of the program).
+	 */
+	if (lit_string->value_cache == NULL) {
+		value = rdata_value_new();
+		var = rdata_var_new(vc_string);
+		string_v = rdata_string_new();
 
-	item->u.value = value;
-	value->var = var;
-	var->u.string_v = string_v;
-	string_v->value = lit_string->value;
+		value->var = var;
+		var->u.string_v = string_v;
+		string_v->value = lit_string->value;
+
+		lit_string->value_cache = value;
+	}
+
+	item = rdata_item_new(ic_value);
+	rdata_value_copy(lit_string->value_cache, &item->u.value);
 
 	*res = item;
 }
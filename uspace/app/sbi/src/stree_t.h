@@ -38,6 +38,7 @@
  */
 
 struct stree_expr;
+struct rdata_value;
 
 /** Identifier */
 typedef struct {
@@ -51,6 +52,11 @@ typedef struct {
 	struct stree_expr *expr;
 
 	stree_ident_t *name;
+
+	/** CSI in which this name was last resolved (inline cache) */
+	struct stree_csi *csi_cache;
+	/** Symbol the name resolved to within @c csi_cache */
+	struct stree_symbol *sym_cache;
 } stree_nameref_t;
 
 /** Boolean literal */
@@ -75,6 +81,9 @@ typedef struct {
 /** String literal */
 typedef struct {
 	char *value;
+
+	/** Interned value node (filled in on first evaluation) */
+	struct rdata_value *value_cache;
 } stree_lit_string_t;
 
 typedef enum {
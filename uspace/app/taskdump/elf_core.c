@@ -44,11 +44,20 @@
  * process info etc. We only write one record NT_PRSTATUS which contains
  * process/register state (anything which is not register state we fill
  * with zeroes).
+ *
+ * The core file is produced as a single forward stream, which allows it
+ * to be piped through the streaming gzip compressor; the compressed form
+ * is a plain gzip image of the ELF core file. The amount of task memory
+ * read over udebug can be bounded; segment data beyond the limit is
+ * zero-filled (and thus nearly free in the compressed form), keeping the
+ * file layout intact.
  */
 
 #include <align.h>
+#include <deflate.h>
 #include <elf/elf.h>
 #include <elf/elf_linux.h>
+#include <gzip.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -65,18 +74,114 @@
 
 #include "elf_core.h"
 
+/** Output stream of the core file writer.
+ *
+ * Tracks the position in the (uncompressed) core stream separately
+ * from the position in the output file; the two differ when the
+ * stream is piped through the gzip compressor.
+ */
+typedef struct {
+	int fd;             /**< Output file */
+	aoff64_t fpos;      /**< Write position in the output file */
+	aoff64_t spos;      /**< Position in the core stream */
+	gzip_comp_t *gzip;  /**< Compression stream or NULL */
+} core_sink_t;
+
 static off64_t align_foff_up(off64_t, uintptr_t, size_t);
-static errno_t write_mem_area(int, aoff64_t *, as_area_info_t *, async_sess_t *);
+static errno_t core_sink_write(core_sink_t *, const void *, size_t);
+static errno_t core_sink_seek(core_sink_t *, aoff64_t);
+static errno_t write_mem_area(core_sink_t *, as_area_info_t *, async_sess_t *,
+    size_t *);
 
 #define BUFFER_SIZE 0x1000
 static uint8_t buffer[BUFFER_SIZE];
 
+/** Deliver compressed data to the output file.
+ *
+ * @param arg  Core file output stream (core_sink_t).
+ * @param data Data to write.
+ * @param size Number of bytes to write.
+ *
+ * @return EOK on success, EIO on failure.
+ *
+ */
+static errno_t core_sink_write_cb(void *arg, void *data, size_t size)
+{
+	core_sink_t *sink = (core_sink_t *) arg;
+	size_t nwr;
+
+	if (vfs_write(sink->fd, &sink->fpos, data, size, &nwr) != EOK)
+		return EIO;
+
+	return EOK;
+}
+
+/** Write data to the core stream.
+ *
+ * @param sink Core file output stream.
+ * @param data Data to write.
+ * @param size Number of bytes to write.
+ *
+ * @return EOK on success, EIO on failure.
+ *
+ */
+static errno_t core_sink_write(core_sink_t *sink, const void *data, size_t size)
+{
+	size_t nwr;
+	errno_t rc;
+
+	if (sink->gzip != NULL)
+		rc = gzip_comp_write(sink->gzip, (void *) data, size);
+	else
+		rc = vfs_write(sink->fd, &sink->spos, data, size, &nwr);
+
+	if (rc != EOK)
+		return EIO;
+
+	if (sink->gzip != NULL)
+		sink->spos += size;
+
+	return EOK;
+}
+
+/** Advance the core stream to the given position.
+ *
+ * The stream is forward-only; the gap is zero-filled so that the
+ * output remains a single sequential stream even when compressed.
+ *
+ * @param sink Core file output stream.
+ * @param pos  Target position in the core stream.
+ *
+ * @return EOK on success, EIO on failure.
+ *
+ */
+static errno_t core_sink_seek(core_sink_t *sink, aoff64_t pos)
+{
+	assert(pos >= sink->spos);
+
+	memset(buffer, 0, BUFFER_SIZE);
+
+	while (sink->spos < pos) {
+		size_t to_pad = min(pos - sink->spos, BUFFER_SIZE);
+
+		if (core_sink_write(sink, buffer, to_pad) != EOK)
+			return EIO;
+	}
+
+	return EOK;
+}
+
 /** Save ELF core file.
  *
  * @param file_name Name of file to save to.
  * @param ainfo     Array of @a n memory area info structures.
  * @param n         Number of memory areas.
  * @param sess      Debugging session.
+ * @param istate    Register state to store in the NT_PRSTATUS note.
+ * @param mem_limit Maximum number of bytes of task memory to store
+ *                  (zero means no limit). Segment data beyond the
+ *                  limit is zero-filled.
+ * @param compress  Produce a gzip-compressed core file.
  *
  * @return EOK on sucess.
  * @return ENOENT if file cannot be created.
@@ -85,7 +190,7 @@ static uint8_t buffer[BUFFER_SIZE];
  *
  */
 errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int n,
-    async_sess_t *sess, istate_t *istate)
+    async_sess_t *sess, istate_t *istate, size_t mem_limit, bool compress)
 {
 	elf_header_t elf_hdr;
 	off64_t foff;
@@ -95,11 +200,10 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 	elf_prstatus_t pr_status;
 	elf_note_t note;
 	size_t word_size;
-	aoff64_t pos = 0;
+	size_t mem_avail;
+	core_sink_t sink;
 
-	int fd;
 	errno_t rc;
-	size_t nwr;
 	unsigned int i;
 
 #ifdef __32_BITS__
@@ -116,6 +220,8 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 	memset(&pr_status, 0, sizeof(pr_status));
 	istate_to_elf_regs(istate, &pr_status.regs);
 
+	mem_avail = (mem_limit > 0) ? mem_limit : SIZE_MAX;
+
 	n_ph = n + 1;
 
 	p_hdr = malloc(sizeof(elf_segment_header_t) * n_ph);
@@ -124,14 +230,33 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 		return ENOMEM;
 	}
 
+	sink.fpos = 0;
+	sink.spos = 0;
+	sink.gzip = NULL;
+
 	rc = vfs_lookup_open(file_name, WALK_REGULAR | WALK_MAY_CREATE,
-	    MODE_WRITE, &fd);
+	    MODE_WRITE, &sink.fd);
 	if (rc != EOK) {
 		printf("Failed opening file '%s': %s.\n", file_name, str_error(rc));
 		free(p_hdr);
 		return ENOENT;
 	}
 
+	if (compress) {
+		/*
+		 * Minimize the time the task is held stopped: use the
+		 * fastest compression level rather than the best ratio.
+		 */
+		rc = gzip_comp_create(deflate_level_min, 1, core_sink_write_cb,
+		    &sink, &sink.gzip);
+		if (rc != EOK) {
+			printf("Failed creating compression stream.\n");
+			vfs_put(sink.fd);
+			free(p_hdr);
+			return ENOMEM;
+		}
+	}
+
 	/*
 	 * File layout:
 	 *
@@ -208,23 +333,25 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 		foff += ainfo[i].size;
 	}
 
-	rc = vfs_write(fd, &pos, &elf_hdr, sizeof(elf_hdr), &nwr);
+	rc = core_sink_write(&sink, &elf_hdr, sizeof(elf_hdr));
 	if (rc != EOK) {
 		printf("Failed writing ELF header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
 	for (i = 0; i < n_ph; ++i) {
-		rc = vfs_write(fd, &pos, &p_hdr[i], sizeof(p_hdr[i]), &nwr);
+		rc = core_sink_write(&sink, &p_hdr[i], sizeof(p_hdr[i]));
 		if (rc != EOK) {
 			printf("Failed writing program header.\n");
-			free(p_hdr);
-			return EIO;
+			goto error;
 		}
 	}
 
-	pos = p_hdr[0].p_offset;
+	rc = core_sink_seek(&sink, p_hdr[0].p_offset);
+	if (rc != EOK) {
+		printf("Failed writing note segment.\n");
+		goto error;
+	}
 
 	/*
 	 * Write note header
@@ -233,41 +360,66 @@ errno_t elf_core_save(const char *file_name, as_area_info_t *ainfo, unsigned int
 	note.descsz = sizeof(elf_prstatus_t);
 	note.type = NT_PRSTATUS;
 
-	rc = vfs_write(fd, &pos, &note, sizeof(elf_note_t), &nwr);
+	rc = core_sink_write(&sink, &note, sizeof(elf_note_t));
 	if (rc != EOK) {
 		printf("Failed writing note header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
-	rc = vfs_write(fd, &pos, "CORE", note.namesz, &nwr);
+	rc = core_sink_write(&sink, "CORE", note.namesz);
 	if (rc != EOK) {
 		printf("Failed writing note header.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
-	pos = ALIGN_UP(pos, word_size);
+	rc = core_sink_seek(&sink, ALIGN_UP(sink.spos, word_size));
+	if (rc != EOK) {
+		printf("Failed writing note header.\n");
+		goto error;
+	}
 
-	rc = vfs_write(fd, &pos, &pr_status, sizeof(elf_prstatus_t), &nwr);
+	rc = core_sink_write(&sink, &pr_status, sizeof(elf_prstatus_t));
 	if (rc != EOK) {
 		printf("Failed writing register data.\n");
-		free(p_hdr);
-		return EIO;
+		goto error;
 	}
 
 	for (i = 1; i < n_ph; ++i) {
-		pos = p_hdr[i].p_offset;
-		if (write_mem_area(fd, &pos, &ainfo[i - 1], sess) != EOK) {
+		rc = core_sink_seek(&sink, p_hdr[i].p_offset);
+		if (rc != EOK) {
 			printf("Failed writing memory data.\n");
-			free(p_hdr);
-			return EIO;
+			goto error;
+		}
+
+		if (write_mem_area(&sink, &ainfo[i - 1], sess,
+		    &mem_avail) != EOK) {
+			printf("Failed writing memory data.\n");
+			rc = EIO;
+			goto error;
 		}
 	}
 
+	if (sink.gzip != NULL) {
+		rc = gzip_comp_finish(sink.gzip);
+		gzip_comp_destroy(sink.gzip);
+		sink.gzip = NULL;
+		if (rc != EOK) {
+			printf("Failed finishing compression stream.\n");
+			goto error;
+		}
+	}
+
+	vfs_put(sink.fd);
 	free(p_hdr);
 
 	return EOK;
+error:
+	if (sink.gzip != NULL)
+		gzip_comp_destroy(sink.gzip);
+	vfs_put(sink.fd);
+	free(p_hdr);
+
+	return EIO;
 }
 
 /** Align file offset up to be congruent with vaddr modulo page size. */
@@ -284,35 +436,49 @@ static off64_t align_foff_up(off64_t foff, uintptr_t vaddr, size_t page_size)
 
 /** Write memory area from application to core file.
  *
- * @param fd   File to write to.
- * @param pos  Pointer to the position to write to.
- * @param area Memory area info structure.
- * @param sess Debugging session.
+ * Data beyond the remaining memory budget is zero-filled instead of
+ * being read over udebug, so the file layout does not depend on the
+ * budget.
+ *
+ * @param sink      Core file output stream.
+ * @param area      Memory area info structure.
+ * @param sess      Debugging session.
+ * @param mem_avail Remaining memory budget (bytes), updated.
  *
  * @return EOK on success, EIO on failure.
  *
  */
-static errno_t write_mem_area(int fd, aoff64_t *pos, as_area_info_t *area,
-    async_sess_t *sess)
+static errno_t write_mem_area(core_sink_t *sink, as_area_info_t *area,
+    async_sess_t *sess, size_t *mem_avail)
 {
 	size_t to_copy;
 	size_t total;
 	uintptr_t addr;
 	errno_t rc;
-	size_t nwr;
 
 	addr = area->start_addr;
 	total = 0;
 
 	while (total < area->size) {
 		to_copy = min(area->size - total, BUFFER_SIZE);
-		rc = udebug_mem_read(sess, buffer, addr, to_copy);
-		if (rc != EOK) {
-			printf("Failed reading task memory.\n");
-			return EIO;
+
+		if (*mem_avail > 0) {
+			if (to_copy > *mem_avail)
+				to_copy = *mem_avail;
+
+			rc = udebug_mem_read(sess, buffer, addr, to_copy);
+			if (rc != EOK) {
+				printf("Failed reading task memory.\n");
+				return EIO;
+			}
+
+			*mem_avail -= to_copy;
+		} else {
+			/* Budget exhausted, zero-fill the rest. */
+			memset(buffer, 0, to_copy);
 		}
 
-		rc = vfs_write(fd, pos, buffer, to_copy, &nwr);
+		rc = core_sink_write(sink, buffer, to_copy);
 		if (rc != EOK) {
 			printf("Failed writing memory contents.\n");
 			return EIO;
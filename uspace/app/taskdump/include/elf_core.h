@@ -38,9 +38,11 @@
 #include <async.h>
 #include <elf/elf_linux.h>
 #include <libarch/istate.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 extern errno_t elf_core_save(const char *, as_area_info_t *, unsigned int,
-    async_sess_t *, istate_t *);
+    async_sess_t *, istate_t *, size_t, bool);
 
 #endif
 
@@ -60,6 +60,8 @@
 static async_sess_t *sess;
 static task_id_t task_id;
 static bool write_core_file;
+static bool compress_core_file;
+static size_t core_mem_limit;
 static char *core_file_name;
 static char *app_name;
 static symtab_t *app_symtab;
@@ -181,6 +183,19 @@ static int parse_args(int argc, char *argv[])
 				--argc;
 				++argv;
 				core_file_name = *argv;
+			} else if (arg[1] == 'z' && arg[2] == '\0') {
+				compress_core_file = true;
+			} else if (arg[1] == 'l' && arg[2] == '\0') {
+				/* Memory limit in KiB */
+				--argc;
+				++argv;
+				core_mem_limit = strtol(*argv, &err_p, 10) *
+				    1024;
+				if (*err_p) {
+					printf("Memory limit syntax error\n");
+					print_syntax();
+					return -1;
+				}
 			} else {
 				printf("Uknown option '%c'\n", arg[0]);
 				print_syntax();
@@ -211,8 +226,10 @@ static int parse_args(int argc, char *argv[])
 
 static void print_syntax(void)
 {
-	printf("Syntax: taskdump [-c <core_file>] -t <task_id>\n");
+	printf("Syntax: taskdump [-c <core_file>] [-z] [-l <limit_kb>] -t <task_id>\n");
 	printf("\t-c <core_file_id>\tName of core file to write.\n");
+	printf("\t-z\tCompress the core file (gzip format).\n");
+	printf("\t-l <limit_kb>\tLimit on dumped task memory in KiB.\n");
 	printf("\t-t <task_id>\tWhich task to dump.\n");
 }
 
@@ -313,7 +330,7 @@ static errno_t areas_dump(void)
 		printf("Writing core file '%s'\n", core_file_name);
 
 		rc = elf_core_save(core_file_name, ainfo_buf, n_areas, sess,
-		    &reg_state);
+		    &reg_state, core_mem_limit, compress_core_file);
 
 		if (rc != EOK) {
 			printf("Failed writing core file.\n");
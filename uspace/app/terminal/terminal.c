@@ -47,6 +47,7 @@
 #include <io/concaps.h>
 #include <io/console.h>
 #include <io/pixelmap.h>
+#include <fibril.h>
 #include <task.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -69,6 +70,12 @@
 #define TERM_CAPS \
 	(CONSOLE_CAP_STYLE | CONSOLE_CAP_INDEXED | CONSOLE_CAP_RGB)
 
+/** Number of rows of scrollback history kept per terminal */
+#define SCROLLBACK_ROWS  1000
+
+/** Minimum delay between two compositions (microseconds, ~60 fps) */
+#define RENDER_PERIOD  16667
+
 static LIST_INITIALIZE(terms);
 
 static errno_t term_open(con_srvs_t *, con_srv_t *);
@@ -209,6 +216,68 @@ static void term_update_region(terminal_t *term, sysarg_t x, sysarg_t y,
 	term->update = nupdate;
 }
 
+/** Stash the top visible row before an operation that may scroll.
+ *
+ * Scrolling the chargrid rotates its circular buffer and clears the
+ * departing row in place, so the row has to be captured beforehand.
+ * Must be called with term->mtx held.
+ */
+static void term_sb_stash_top(terminal_t *term)
+{
+	sysarg_t col;
+
+	if (term->sb_buf == NULL)
+		return;
+
+	for (col = 0; col < term->cols; col++) {
+		term->sb_stash[col] =
+		    *chargrid_charfield_at(term->frontbuf, col, 0);
+	}
+}
+
+/** Append the stashed row to the scrollback ring buffer.
+ *
+ * Appending is O(1) with respect to the amount of history kept: only
+ * the single departing row is copied. Must be called with term->mtx
+ * held.
+ */
+static void term_sb_append_stash(terminal_t *term)
+{
+	charfield_t *dst;
+	sysarg_t col;
+
+	if (term->sb_buf == NULL)
+		return;
+
+	dst = term->sb_buf + term->sb_head * term->cols;
+	for (col = 0; col < term->cols; col++)
+		dst[col] = term->sb_stash[col];
+
+	term->sb_head = (term->sb_head + 1) % term->sb_rows;
+	if (term->sb_count < term->sb_rows)
+		term->sb_count++;
+}
+
+/** Return the character field displayed at the given position.
+ *
+ * When the view is scrolled back, the top @c sb_view rows come from
+ * the scrollback buffer and the rest shows the live grid shifted down.
+ */
+static charfield_t *term_display_field(terminal_t *term, sysarg_t col,
+    sysarg_t row)
+{
+	size_t idx;
+
+	if (row < term->sb_view) {
+		idx = (term->sb_head + term->sb_rows - term->sb_view + row) %
+		    term->sb_rows;
+		return term->sb_buf + idx * term->cols + col;
+	}
+
+	return chargrid_charfield_at(term->frontbuf, col,
+	    row - term->sb_view);
+}
+
 static void term_update_char(terminal_t *term, pixelmap_t *pixelmap,
     sysarg_t sx, sysarg_t sy, sysarg_t col, sysarg_t row)
 {
@@ -246,44 +315,45 @@ static void term_update_char(terminal_t *term, pixelmap_t *pixelmap,
 	term_update_region(term, bx, by, FONT_WIDTH, FONT_SCANLINES);
 }
 
-static bool term_update_scroll(terminal_t *term, pixelmap_t *pixelmap,
+/** Diff the entire display area against the back buffer.
+ *
+ * Compares every displayed cell (taking the scrollback view into
+ * account) with the back buffer and only repaints cells that differ,
+ * so unchanged rows never reach the bitmap.
+ */
+static bool term_update_diff_full(terminal_t *term, pixelmap_t *pixelmap,
     sysarg_t sx, sysarg_t sy)
 {
-	sysarg_t top_row = chargrid_get_top_row(term->frontbuf);
-
-	if (term->top_row == top_row) {
-		return false;
-	}
-
-	term->top_row = top_row;
+	bool update = false;
 
 	for (sysarg_t row = 0; row < term->rows; row++) {
 		for (sysarg_t col = 0; col < term->cols; col++) {
 			charfield_t *front_field =
-			    chargrid_charfield_at(term->frontbuf, col, row);
+			    term_display_field(term, col, row);
 			charfield_t *back_field =
 			    chargrid_charfield_at(term->backbuf, col, row);
-			bool update = false;
+			bool cupdate = false;
 
 			if (front_field->ch != back_field->ch) {
 				back_field->ch = front_field->ch;
-				update = true;
+				cupdate = true;
 			}
 
 			if (!attrs_same(front_field->attrs, back_field->attrs)) {
 				back_field->attrs = front_field->attrs;
-				update = true;
+				cupdate = true;
 			}
 
 			front_field->flags &= ~CHAR_FLAG_DIRTY;
 
-			if (update) {
+			if (cupdate) {
 				term_update_char(term, pixelmap, sx, sy, col, row);
+				update = true;
 			}
 		}
 	}
 
-	return true;
+	return update;
 }
 
 static bool term_update_cursor(terminal_t *term, pixelmap_t *pixelmap,
@@ -301,7 +371,7 @@ static bool term_update_cursor(terminal_t *term, pixelmap_t *pixelmap,
 
 	bool front_visibility =
 	    chargrid_get_cursor_visibility(term->frontbuf) &&
-	    term->is_focused;
+	    term->is_focused && term->sb_view == 0;
 	bool back_visibility =
 	    chargrid_get_cursor_visibility(term->backbuf);
 
@@ -343,8 +413,23 @@ static void term_update(terminal_t *term)
 	sysarg_t sx = 0;
 	sysarg_t sy = 0;
 
-	if (term_update_scroll(term, &pixelmap, sx, sy)) {
-		update = true;
+	/*
+	 * The grid having scrolled, a scrollback view change or an
+	 * explicit request all invalidate the per-cell dirty flags,
+	 * so diff the whole display area in those cases.
+	 */
+	bool full = term->full_update || term->sb_view > 0;
+	term->full_update = false;
+
+	sysarg_t top_row = chargrid_get_top_row(term->frontbuf);
+	if (term->top_row != top_row) {
+		term->top_row = top_row;
+		full = true;
+	}
+
+	if (full) {
+		if (term_update_diff_full(term, &pixelmap, sx, sy))
+			update = true;
 	} else {
 		for (sysarg_t y = 0; y < term->rows; y++) {
 			for (sysarg_t x = 0; x < term->cols; x++) {
@@ -416,20 +501,20 @@ static void term_repaint(terminal_t *term)
 	sysarg_t sx = 0;
 	sysarg_t sy = 0;
 
-	if (!term_update_scroll(term, &pixelmap, sx, sy)) {
-		for (sysarg_t y = 0; y < term->rows; y++) {
-			for (sysarg_t x = 0; x < term->cols; x++) {
-				charfield_t *front_field =
-				    chargrid_charfield_at(term->frontbuf, x, y);
-				charfield_t *back_field =
-				    chargrid_charfield_at(term->backbuf, x, y);
+	term->top_row = chargrid_get_top_row(term->frontbuf);
 
-				back_field->ch = front_field->ch;
-				back_field->attrs = front_field->attrs;
-				front_field->flags &= ~CHAR_FLAG_DIRTY;
+	for (sysarg_t y = 0; y < term->rows; y++) {
+		for (sysarg_t x = 0; x < term->cols; x++) {
+			charfield_t *front_field =
+			    term_display_field(term, x, y);
+			charfield_t *back_field =
+			    chargrid_charfield_at(term->backbuf, x, y);
 
-				term_update_char(term, &pixelmap, sx, sy, x, y);
-			}
+			back_field->ch = front_field->ch;
+			back_field->attrs = front_field->attrs;
+			front_field->flags &= ~CHAR_FLAG_DIRTY;
+
+			term_update_char(term, &pixelmap, sx, sy, x, y);
 		}
 	}
 
@@ -438,6 +523,83 @@ static void term_repaint(terminal_t *term)
 	fibril_mutex_unlock(&term->mtx);
 }
 
+/** Request that the terminal be composited.
+ *
+ * Wakes up the render fibril. Requests arriving while a composition
+ * is in progress or within the same frame period are coalesced into
+ * a single composition.
+ */
+static void term_render_req(terminal_t *term)
+{
+	fibril_mutex_lock(&term->render_mtx);
+	term->render_pending = true;
+	fibril_condvar_signal(&term->render_cv);
+	fibril_mutex_unlock(&term->render_mtx);
+}
+
+/** Render fibril.
+ *
+ * Composites the terminal at most once per RENDER_PERIOD no matter how
+ * fast output arrives. Writers merely mark the terminal dirty, so fast
+ * producers (e.g. cat of a large file) are never throttled by rendering
+ * and the screen is repainted a bounded number of times per second.
+ */
+static errno_t term_render_fibril(void *arg)
+{
+	terminal_t *term = (terminal_t *) arg;
+
+	while (true) {
+		fibril_mutex_lock(&term->render_mtx);
+		while (!term->render_pending) {
+			fibril_condvar_wait(&term->render_cv,
+			    &term->render_mtx);
+		}
+		term->render_pending = false;
+		fibril_mutex_unlock(&term->render_mtx);
+
+		term_update(term);
+		gfx_update(term->gc);
+
+		/* Coalesce further updates into the next frame. */
+		fibril_usleep(RENDER_PERIOD);
+	}
+
+	return EOK;
+}
+
+/** Scroll the view within the scrollback history.
+ *
+ * @param term Terminal
+ * @param delta Number of rows to scroll (positive scrolls back in history)
+ */
+static void term_sb_scroll_view(terminal_t *term, int delta)
+{
+	size_t view;
+
+	fibril_mutex_lock(&term->mtx);
+
+	view = term->sb_view;
+	if (delta > 0) {
+		view += delta;
+		if (view > term->sb_count)
+			view = term->sb_count;
+	} else {
+		if ((size_t)(-delta) >= view)
+			view = 0;
+		else
+			view -= (size_t)(-delta);
+	}
+
+	if (view != term->sb_view) {
+		term->sb_view = view;
+		term->full_update = true;
+	}
+
+	fibril_mutex_unlock(&term->mtx);
+
+	term_render_req(term);
+}
+
 static errno_t term_open(con_srvs_t *srvs, con_srv_t *srv)
 {
 	return EOK;
@@ -500,9 +662,21 @@ static errno_t term_read(con_srv_t *srv, void *buf, size_t size, size_t *nread)
 static void term_write_char(terminal_t *term, wchar_t ch)
 {
 	sysarg_t updated = 0;
+	sysarg_t col, row;
+	bool may_scroll;
 
 	fibril_mutex_lock(&term->mtx);
 
+	/*
+	 * If this character can scroll the grid, capture the departing
+	 * top row for the scrollback buffer first.
+	 */
+	chargrid_get_cursor(term->frontbuf, &col, &row);
+	may_scroll = (row == term->rows - 1) &&
+	    (ch == '\n' || ch == '\t' || col == term->cols - 1);
+	if (may_scroll)
+		term_sb_stash_top(term);
+
 	switch (ch) {
 	case '\n':
 		updated = chargrid_newline(term->frontbuf);
@@ -519,10 +693,10 @@ static void term_write_char(terminal_t *term, wchar_t ch)
 		updated = chargrid_putuchar(term->frontbuf, ch, true);
 	}
 
-	fibril_mutex_unlock(&term->mtx);
+	if (may_scroll && updated >= term->rows)
+		term_sb_append_stash(term);
 
-	if (updated > 1)
-		term_update(term);
+	fibril_mutex_unlock(&term->mtx);
 }
 
 static errno_t term_write(con_srv_t *srv, void *data, size_t size, size_t *nwritten)
@@ -533,7 +707,7 @@ static errno_t term_write(con_srv_t *srv, void *data, size_t size, size_t *nwrit
 	while (off < size)
 		term_write_char(term, str_decode(data, &off, size));
 
-	gfx_update(term->gc);
+	term_render_req(term);
 	*nwritten = size;
 	return EOK;
 }
@@ -554,8 +728,7 @@ static void term_clear(con_srv_t *srv)
 	chargrid_clear(term->frontbuf);
 	fibril_mutex_unlock(&term->mtx);
 
-	term_update(term);
-	gfx_update(term->gc);
+	term_render_req(term);
 }
 
 static void term_set_pos(con_srv_t *srv, sysarg_t col, sysarg_t row)
@@ -566,8 +739,7 @@ static void term_set_pos(con_srv_t *srv, sysarg_t col, sysarg_t row)
 	chargrid_set_cursor(term->frontbuf, col, row);
 	fibril_mutex_unlock(&term->mtx);
 
-	term_update(term);
-	gfx_update(term->gc);
+	term_render_req(term);
 }
 
 static errno_t term_get_pos(con_srv_t *srv, sysarg_t *col, sysarg_t *row)
@@ -638,8 +810,7 @@ static void term_set_cursor_visibility(con_srv_t *srv, bool visible)
 	chargrid_set_cursor_visibility(term->frontbuf, visible);
 	fibril_mutex_unlock(&term->mtx);
 
-	term_update(term);
-	gfx_update(term->gc);
+	term_render_req(term);
 }
 
 static errno_t term_get_event(con_srv_t *srv, cons_event_t *event)
@@ -764,8 +935,7 @@ static void term_buf_update(con_srv_t *srv, sysarg_t c0, sysarg_t r0,
 	fibril_mutex_unlock(&term->mtx);
 
 	/* Update terminal */
-	term_update(term);
-	gfx_update(term->gc);
+	term_render_req(term);
 }
 
 static void deinit_terminal(terminal_t *term)
@@ -777,6 +947,9 @@ static void deinit_terminal(terminal_t *term)
 
 	if (term->backbuf)
 		chargrid_destroy(term->backbuf);
+
+	free(term->sb_buf);
+	free(term->sb_stash);
 }
 
 void terminal_destroy(terminal_t *term)
@@ -827,6 +1000,27 @@ static void terminal_kbd_event(ui_window_t *window, void *arg,
 	terminal_t *term = (terminal_t *) arg;
 	cons_event_t event;
 
+	if (kbd_event->type == KEY_PRESS) {
+		/* Shift + Page Up/Down navigate the scrollback history. */
+		if ((kbd_event->mods & KM_SHIFT) != 0) {
+			if (kbd_event->key == KC_PAGE_UP) {
+				term_sb_scroll_view(term,
+				    (int) term->rows - 1);
+				return;
+			}
+			if (kbd_event->key == KC_PAGE_DOWN) {
+				term_sb_scroll_view(term,
+				    -((int) term->rows - 1));
+				return;
+			}
+		}
+
+		/* Any other key returns the view to the live screen. */
+		if (term->sb_view > 0 && kbd_event->key != KC_LSHIFT &&
+		    kbd_event->key != KC_RSHIFT)
+			term_sb_scroll_view(term, -(int) term->sb_rows);
+	}
+
 	event.type = CEV_KEY;
 	event.ev.key = *kbd_event;
 
@@ -905,6 +1099,8 @@ errno_t terminal_create(const char *display_spec, sysarg_t width,
 
 	link_initialize(&term->link);
 	fibril_mutex_initialize(&term->mtx);
+	fibril_mutex_initialize(&term->render_mtx);
+	fibril_condvar_initialize(&term->render_cv);
 	atomic_flag_clear(&term->refcnt);
 
 	prodcons_initialize(&term->input_pc);
@@ -935,6 +1131,18 @@ errno_t terminal_create(const char *display_spec, sysarg_t width,
 		goto error;
 	}
 
+	/* Allocate scrollback history; run without it if this fails. */
+	term->sb_rows = SCROLLBACK_ROWS;
+	term->sb_buf = calloc(term->sb_rows * term->cols,
+	    sizeof(charfield_t));
+	term->sb_stash = calloc(term->cols, sizeof(charfield_t));
+	if (term->sb_buf == NULL || term->sb_stash == NULL) {
+		free(term->sb_buf);
+		free(term->sb_stash);
+		term->sb_buf = NULL;
+		term->sb_stash = NULL;
+	}
+
 	rect.p0.x = 0;
 	rect.p0.y = 0;
 	rect.p1.x = width;
@@ -1023,6 +1231,15 @@ errno_t terminal_create(const char *display_spec, sysarg_t width,
 
 	term_repaint(term);
 
+	fid_t fid = fibril_create(term_render_fibril, term);
+	if (fid == 0) {
+		printf("Error creating render fibril.\n");
+		rc = ENOMEM;
+		goto error;
+	}
+
+	fibril_add_ready(fid);
+
 	*rterm = term;
 	return EOK;
 error:
@@ -84,6 +84,29 @@ typedef struct {
 	chargrid_t *backbuf;
 	sysarg_t top_row;
 
+	/** Scrollback ring buffer (@c sb_rows rows of @c cols cells) */
+	charfield_t *sb_buf;
+	/** Capacity of the scrollback buffer in rows */
+	size_t sb_rows;
+	/** Index of the slot that the next stored row will occupy */
+	size_t sb_head;
+	/** Number of valid rows in the scrollback buffer */
+	size_t sb_count;
+	/** Number of rows the view is scrolled back (0 = live view) */
+	size_t sb_view;
+	/** Row pending insertion into the scrollback buffer */
+	charfield_t *sb_stash;
+
+	/** Force a full front-to-back diff on the next update */
+	bool full_update;
+
+	/** Serializes render requests to the render fibril */
+	fibril_mutex_t render_mtx;
+	/** Signaled when render_pending becomes true */
+	fibril_condvar_t render_cv;
+	/** A render request is outstanding */
+	bool render_pending;
+
 	sysarg_t ucols;
 	sysarg_t urows;
 	charfield_t *ubuf;
@@ -94,6 +94,51 @@ static bool task_wait_for;
 /** Combination of events/data to print. */
 display_mask_t display_mask;
 
+/** Raw trace event record.
+ *
+ * Captured while the traced thread is stopped (syscall arguments and
+ * the IPC call payload are transient) and decoded later, so that the
+ * target is not slowed down by the decoding and printing.
+ */
+typedef struct {
+	/** Internal thread number */
+	unsigned thread_id;
+	/** Event type (UDEBUG_EVENT_SYSCALL_B or _E) */
+	unsigned ev_type;
+	/** Syscall number */
+	unsigned sc_id;
+	/** Syscall return value (_E only) */
+	sysarg_t sc_rc;
+	/** Syscall arguments */
+	sysarg_t sc_args[6];
+	/** @c true if @c call holds a captured IPC call payload */
+	bool have_call;
+	/** IPC call payload (for IPC syscalls) */
+	ipc_call_t call;
+} trace_ev_t;
+
+enum {
+	/** Number of entries in the event ring buffer */
+	evbuf_len = 1024
+};
+
+/** Streaming mode (decode deferred to a consumer fibril) */
+static bool stream_mode;
+/** No more events will be produced */
+static bool stream_done;
+/** Consumer fibril has terminated */
+static bool stream_exited;
+
+/** Event ring buffer (valid entries start at @c evbuf_tail) */
+static trace_ev_t evbuf[evbuf_len];
+static size_t evbuf_head;
+static size_t evbuf_tail;
+static size_t evbuf_cnt;
+/** Number of events dropped due to a full ring buffer */
+static uint64_t evbuf_drops;
+static fibril_mutex_t evbuf_lock;
+static fibril_condvar_t evbuf_cv;
+
 static errno_t cev_fibril(void *arg);
 
 static void cev_fibril_start(void)
@@ -133,6 +178,7 @@ static errno_t program_run(void)
 
 static errno_t connect_task(task_id_t task_id)
 {
+	udebug_evmask_t evmask;
 	errno_t rc;
 	bool debug_started = false;
 	bool wait_set_up = false;
@@ -162,9 +208,19 @@ static errno_t connect_task(task_id_t task_id)
 		wait_set_up = true;
 	}
 
-	rc = udebug_set_evmask(sess, UDEBUG_EM_ALL);
+	/*
+	 * Only ask the kernel for the events we are going to use. Events
+	 * not in the mask do not stop the traced thread at all. Note that
+	 * IPC and protocol decoding is derived from the IPC syscalls.
+	 */
+	evmask = UDEBUG_EM_FINISHED | UDEBUG_EM_STOP | UDEBUG_EM_THREAD_B |
+	    UDEBUG_EM_THREAD_E;
+	if ((display_mask & (DM_SYSCALL | DM_IPC | DM_SYSTEM | DM_USER)) != 0)
+		evmask |= UDEBUG_EM_SYSCALL_B | UDEBUG_EM_SYSCALL_E;
+
+	rc = udebug_set_evmask(sess, evmask);
 	if (rc != EOK) {
-		printf("udebug_set_evmask(0x%x) -> %s\n ", UDEBUG_EM_ALL, str_error_name(rc));
+		printf("udebug_set_evmask(0x%x) -> %s\n ", evmask, str_error_name(rc));
 		return rc;
 	}
 
@@ -282,7 +338,7 @@ static void print_sc_retval(sysarg_t retval, val_type_t val_type)
 	putchar('\n');
 }
 
-static void print_sc_args(sysarg_t *sc_args, int n)
+static void print_sc_args(const sysarg_t *sc_args, int n)
 {
 	int i;
 
@@ -295,122 +351,249 @@ static void print_sc_args(sysarg_t *sc_args, int n)
 	putchar(')');
 }
 
-static void sc_ipc_call_async_fast(sysarg_t *sc_args, errno_t sc_rc)
+static void sc_ipc_call_async_fast(const trace_ev_t *ev)
 {
 	ipc_call_t call;
 	cap_phone_handle_t phandle;
 
-	if (sc_rc != EOK)
+	if ((errno_t) ev->sc_rc != EOK)
 		return;
 
-	phandle = (cap_phone_handle_t) sc_args[0];
+	phandle = (cap_phone_handle_t) ev->sc_args[0];
 
-	ipc_set_imethod(&call, sc_args[1]);
-	ipc_set_arg1(&call, sc_args[2]);
-	ipc_set_arg2(&call, sc_args[3]);
-	ipc_set_arg3(&call, sc_args[4]);
-	ipc_set_arg4(&call, sc_args[5]);
+	ipc_set_imethod(&call, ev->sc_args[1]);
+	ipc_set_arg1(&call, ev->sc_args[2]);
+	ipc_set_arg2(&call, ev->sc_args[3]);
+	ipc_set_arg3(&call, ev->sc_args[4]);
+	ipc_set_arg4(&call, ev->sc_args[5]);
 	ipc_set_arg5(&call, 0);
 
 	ipcp_call_out(phandle, &call, 0);
 }
 
-static void sc_ipc_call_async_slow(sysarg_t *sc_args, errno_t sc_rc)
+static void sc_ipc_call_async_slow(const trace_ev_t *ev)
 {
 	ipc_call_t call;
-	errno_t rc;
 
-	if (sc_rc != EOK)
+	if (!ev->have_call)
 		return;
 
-	memset(&call, 0, sizeof(call));
-	rc = udebug_mem_read(sess, &call.args, sc_args[1], sizeof(call.args));
-
-	if (rc == EOK) {
-		ipcp_call_out((cap_phone_handle_t) sc_args[0], &call, 0);
-	}
+	call = ev->call;
+	ipcp_call_out((cap_phone_handle_t) ev->sc_args[0], &call, 0);
 }
 
-static void sc_ipc_wait(sysarg_t *sc_args, cap_call_handle_t sc_rc)
+static void sc_ipc_wait(const trace_ev_t *ev)
 {
 	ipc_call_t call;
-	errno_t rc;
 
-	if (sc_rc == 0)
+	if (!ev->have_call)
 		return;
 
-	memset(&call, 0, sizeof(call));
-	rc = udebug_mem_read(sess, &call, sc_args[0], sizeof(call));
-
-	if (rc == EOK)
-		ipcp_call_in(&call, sc_rc);
+	call = ev->call;
+	ipcp_call_in(&call, (cap_call_handle_t) ev->sc_rc);
 }
 
-static void event_syscall_b(unsigned thread_id, uintptr_t thread_hash,
-    unsigned sc_id, sysarg_t sc_rc)
+static void event_syscall_b(const trace_ev_t *ev)
 {
-	sysarg_t sc_args[6];
-	errno_t rc;
-
-	/* Read syscall arguments */
-	rc = udebug_args_read(sess, thread_hash, sc_args);
-
-	if (rc != EOK) {
-		printf("error\n");
-		return;
-	}
-
 	if ((display_mask & DM_SYSCALL) != 0) {
 		/* Print syscall name and arguments */
-		if (syscall_desc_defined(sc_id)) {
-			printf("%s", syscall_desc[sc_id].name);
-			print_sc_args(sc_args, syscall_desc[sc_id].n_args);
+		if (syscall_desc_defined(ev->sc_id)) {
+			printf("%s", syscall_desc[ev->sc_id].name);
+			print_sc_args(ev->sc_args,
+			    syscall_desc[ev->sc_id].n_args);
 		} else {
-			printf("unknown_syscall<%d>", sc_id);
-			print_sc_args(sc_args, 6);
+			printf("unknown_syscall<%d>", ev->sc_id);
+			print_sc_args(ev->sc_args, 6);
 		}
 	}
 }
 
-static void event_syscall_e(unsigned thread_id, uintptr_t thread_hash,
-    unsigned sc_id, sysarg_t sc_rc)
+static void event_syscall_e(const trace_ev_t *ev)
 {
-	sysarg_t sc_args[6];
 	int rv_type;
-	errno_t rc;
-
-	/* Read syscall arguments */
-	rc = udebug_args_read(sess, thread_hash, sc_args);
-
-	if (rc != EOK) {
-		printf("error\n");
-		return;
-	}
 
 	if ((display_mask & DM_SYSCALL) != 0) {
 		/* Print syscall return value */
-		if (syscall_desc_defined(sc_id))
-			rv_type = syscall_desc[sc_id].rv_type;
+		if (syscall_desc_defined(ev->sc_id))
+			rv_type = syscall_desc[ev->sc_id].rv_type;
 		else
 			rv_type = V_PTR;
-		print_sc_retval(sc_rc, rv_type);
+		print_sc_retval(ev->sc_rc, rv_type);
 	}
 
-	switch (sc_id) {
+	switch (ev->sc_id) {
 	case SYS_IPC_CALL_ASYNC_FAST:
-		sc_ipc_call_async_fast(sc_args, (errno_t) sc_rc);
+		sc_ipc_call_async_fast(ev);
 		break;
 	case SYS_IPC_CALL_ASYNC_SLOW:
-		sc_ipc_call_async_slow(sc_args, (errno_t) sc_rc);
+		sc_ipc_call_async_slow(ev);
 		break;
 	case SYS_IPC_WAIT:
-		sc_ipc_wait(sc_args, (cap_call_handle_t) sc_rc);
+		sc_ipc_wait(ev);
+		break;
+	default:
+		break;
+	}
+}
+
+/** Decode and print a captured event record. */
+static void trace_ev_print(const trace_ev_t *ev)
+{
+	switch (ev->ev_type) {
+	case UDEBUG_EVENT_SYSCALL_B:
+		event_syscall_b(ev);
+		break;
+	case UDEBUG_EVENT_SYSCALL_E:
+		event_syscall_e(ev);
 		break;
 	default:
 		break;
 	}
 }
 
+/** Capture a syscall event record.
+ *
+ * Must be called while the traced thread is stopped in the event --
+ * the syscall arguments and any referenced IPC call structure are only
+ * available until the thread is resumed.
+ *
+ * @param thread_id Internal thread number
+ * @param thread_hash Thread hash
+ * @param ev_type Event type
+ * @param sc_id Syscall number
+ * @param sc_rc Syscall return value
+ * @param ev Place to store the record
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t trace_ev_capture(unsigned thread_id, uintptr_t thread_hash,
+    unsigned ev_type, unsigned sc_id, sysarg_t sc_rc, trace_ev_t *ev)
+{
+	errno_t rc;
+
+	ev->thread_id = thread_id;
+	ev->ev_type = ev_type;
+	ev->sc_id = sc_id;
+	ev->sc_rc = sc_rc;
+	ev->have_call = false;
+
+	/* Read syscall arguments */
+	rc = udebug_args_read(sess, thread_hash, ev->sc_args);
+	if (rc != EOK)
+		return rc;
+
+	if (ev_type != UDEBUG_EVENT_SYSCALL_E)
+		return EOK;
+
+	/* Read out the IPC call payload referenced by the syscall */
+	switch (sc_id) {
+	case SYS_IPC_CALL_ASYNC_SLOW:
+		if ((errno_t) sc_rc == EOK) {
+			memset(&ev->call, 0, sizeof(ev->call));
+			rc = udebug_mem_read(sess, &ev->call.args,
+			    ev->sc_args[1], sizeof(ev->call.args));
+			ev->have_call = (rc == EOK);
+		}
+		break;
+	case SYS_IPC_WAIT:
+		if ((cap_call_handle_t) sc_rc != NULL) {
+			memset(&ev->call, 0, sizeof(ev->call));
+			rc = udebug_mem_read(sess, &ev->call,
+			    ev->sc_args[0], sizeof(ev->call));
+			ev->have_call = (rc == EOK);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return EOK;
+}
+
+/** Append an event record to the ring buffer.
+ *
+ * If the buffer is full the event is dropped -- the tracer must never
+ * block the traced task waiting for the consumer.
+ */
+static void evbuf_produce(const trace_ev_t *ev)
+{
+	fibril_mutex_lock(&evbuf_lock);
+
+	if (evbuf_cnt >= evbuf_len) {
+		++evbuf_drops;
+		fibril_mutex_unlock(&evbuf_lock);
+		return;
+	}
+
+	evbuf[evbuf_head] = *ev;
+	evbuf_head = (evbuf_head + 1) % evbuf_len;
+	++evbuf_cnt;
+
+	fibril_condvar_signal(&evbuf_cv);
+	fibril_mutex_unlock(&evbuf_lock);
+}
+
+/** Consumer fibril draining the event ring buffer. */
+static errno_t evbuf_fibril(void *arg)
+{
+	trace_ev_t ev;
+
+	(void) arg;
+
+	while (true) {
+		fibril_mutex_lock(&evbuf_lock);
+		while (evbuf_cnt == 0 && !stream_done)
+			fibril_condvar_wait(&evbuf_cv, &evbuf_lock);
+
+		if (evbuf_cnt == 0) {
+			/* Buffer drained and no more events are coming */
+			stream_exited = true;
+			fibril_condvar_broadcast(&evbuf_cv);
+			fibril_mutex_unlock(&evbuf_lock);
+			break;
+		}
+
+		ev = evbuf[evbuf_tail];
+		evbuf_tail = (evbuf_tail + 1) % evbuf_len;
+		--evbuf_cnt;
+		fibril_mutex_unlock(&evbuf_lock);
+
+		trace_ev_print(&ev);
+	}
+
+	return EOK;
+}
+
+static void evbuf_fibril_start(void)
+{
+	fid_t fid;
+
+	fid = fibril_create(evbuf_fibril, NULL);
+	if (fid == 0) {
+		printf("Error creating fibril\n");
+		exit(1);
+	}
+
+	fibril_add_ready(fid);
+}
+
+/** Stop the consumer fibril and wait until it drains the buffer. */
+static void evbuf_fibril_stop(void)
+{
+	fibril_mutex_lock(&evbuf_lock);
+	stream_done = true;
+	fibril_condvar_broadcast(&evbuf_cv);
+
+	while (!stream_exited)
+		fibril_condvar_wait(&evbuf_cv, &evbuf_lock);
+	fibril_mutex_unlock(&evbuf_lock);
+
+	if (evbuf_drops > 0) {
+		printf("Dropped %" PRIu64 " events (buffer full).\n",
+		    evbuf_drops);
+	}
+}
+
 static void event_thread_b(uintptr_t hash)
 {
 	printf("New thread, hash %p\n", (void *) hash);
@@ -424,6 +607,7 @@ static errno_t trace_loop(void *thread_hash_arg)
 	uintptr_t thread_hash;
 	unsigned thread_id;
 	sysarg_t val0, val1;
+	trace_ev_t ev;
 
 	thread_hash = (uintptr_t)thread_hash_arg;
 	thread_id = next_thread_id++;
@@ -461,10 +645,18 @@ static errno_t trace_loop(void *thread_hash_arg)
 		if (rc == EOK) {
 			switch (ev_type) {
 			case UDEBUG_EVENT_SYSCALL_B:
-				event_syscall_b(thread_id, thread_hash, val0, (int)val1);
-				break;
 			case UDEBUG_EVENT_SYSCALL_E:
-				event_syscall_e(thread_id, thread_hash, val0, (int)val1);
+				rc = trace_ev_capture(thread_id, thread_hash,
+				    ev_type, val0, (int)val1, &ev);
+				if (rc != EOK) {
+					printf("error\n");
+					break;
+				}
+
+				if (stream_mode)
+					evbuf_produce(&ev);
+				else
+					trace_ev_print(&ev);
 				break;
 			case UDEBUG_EVENT_STOP:
 				printf("Stop event\n");
@@ -553,6 +745,9 @@ static void trace_task(task_id_t task_id)
 
 	abort_trace = false;
 
+	if (stream_mode)
+		evbuf_fibril_start();
+
 	for (i = 0; i < n_threads; i++) {
 		thread_trace_start(thread_hash_buf[i]);
 	}
@@ -605,6 +800,9 @@ static void trace_task(task_id_t task_id)
 	udebug_end(sess);
 	async_hangup(sess);
 
+	if (stream_mode)
+		evbuf_fibril_stop();
+
 	ipcp_cleanup();
 
 	printf("Done\n");
@@ -639,6 +837,9 @@ static void main_init(void)
 	fibril_mutex_initialize(&state_lock);
 	fibril_condvar_initialize(&state_cv);
 
+	fibril_mutex_initialize(&evbuf_lock);
+	fibril_condvar_initialize(&evbuf_cv);
+
 	proto_init();
 
 	p = proto_new("vfs");
@@ -677,8 +878,12 @@ static void main_init(void)
 static void print_syntax(void)
 {
 	printf("Syntax:\n");
-	printf("\ttrace [+<events>] <executable> [<arg1> [...]]\n");
-	printf("or\ttrace [+<events>] -t <task_id>\n");
+	printf("\ttrace [-s] [+<events>] <executable> [<arg1> [...]]\n");
+	printf("or\ttrace [-s] [+<events>] -t <task_id>\n");
+	printf("Options:\n");
+	printf("\t-s ... Streaming mode. Events are buffered and decoded\n");
+	printf("\t       by a separate fibril; when the buffer fills up,\n");
+	printf("\t       events are dropped rather than slowing the task.\n");
 	printf("Events: (default is +tp)\n");
 	printf("\n");
 	printf("\tt ... Thread creation and termination\n");
@@ -746,6 +951,8 @@ static int parse_args(int argc, char *argv[])
 					print_syntax();
 					return -1;
 				}
+			} else if (arg[1] == 's') {
+				stream_mode = true;
 			} else {
 				printf("Uknown option '%c'\n", arg[0]);
 				print_syntax();
@@ -59,9 +59,14 @@ static ui_window_t *window;
 static gfx_bitmap_t *bitmap = NULL;
 static ui_image_t *image = NULL;
 static gfx_context_t *window_gc;
+static bool fullscreen = false;
 
 static gfx_rect_t img_rect;
 
+/** File buffer reused across images in a slideshow */
+static void *img_buf = NULL;
+static size_t img_buf_size = 0;
+
 static bool img_load(gfx_context_t *gc, const char *, gfx_bitmap_t **,
     gfx_rect_t *);
 static bool img_setup(gfx_context_t *, gfx_bitmap_t *, gfx_rect_t *);
@@ -142,29 +147,47 @@ static bool img_load(gfx_context_t *gc, const char *fname,
 		return false;
 	}
 
-	void *tga = malloc(stat.size);
-	if (tga == NULL) {
-		vfs_put(fd);
-		return false;
+	/* Grow the reused file buffer only when needed */
+	if (img_buf_size < stat.size) {
+		void *nbuf = realloc(img_buf, stat.size);
+		if (nbuf == NULL) {
+			vfs_put(fd);
+			return false;
+		}
+
+		img_buf = nbuf;
+		img_buf_size = stat.size;
 	}
 
 	size_t nread;
-	rc = vfs_read(fd, (aoff64_t []) { 0 }, tga, stat.size, &nread);
+	rc = vfs_read(fd, (aoff64_t []) { 0 }, img_buf, stat.size, &nread);
 	if (rc != EOK || nread != stat.size) {
-		free(tga);
 		vfs_put(fd);
 		return false;
 	}
 
 	vfs_put(fd);
 
-	rc = decode_tga(gc, tga, stat.size, rbitmap, rect);
-	if (rc != EOK) {
-		free(tga);
-		return false;
+	/*
+	 * In full-screen mode decode directly to the application area
+	 * size, so large photos never materialize at full resolution.
+	 */
+	gfx_coord2_t dims;
+	gfx_coord2_t *max_dims = NULL;
+	if (fullscreen) {
+		gfx_rect_t arect;
+
+		ui_window_get_app_rect(window, &arect);
+		dims.x = arect.p1.x - arect.p0.x;
+		dims.y = arect.p1.y - arect.p0.y;
+		if (dims.x > 0 && dims.y > 0)
+			max_dims = &dims;
 	}
 
-	free(tga);
+	rc = decode_tga_scaled(gc, img_buf, stat.size, max_dims, rbitmap,
+	    rect);
+	if (rc != EOK)
+		return false;
 
 	img_rect = *rect;
 	return true;
@@ -218,7 +241,6 @@ int main(int argc, char *argv[])
 	const char *display_spec = DISPLAY_DEFAULT;
 	gfx_bitmap_t *lbitmap;
 	gfx_rect_t lrect;
-	bool fullscreen = false;
 	gfx_rect_t rect;
 	gfx_rect_t wrect;
 	gfx_coord2_t off;
@@ -35,6 +35,8 @@
 
 #include <errno.h>
 #include <assert.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -62,6 +64,12 @@
 /** Buffer for receiving the request. */
 #define BUFFER_SIZE  1024
 
+/** Buffer for streaming file contents. */
+#define FILE_BUFFER_SIZE  16384
+
+/** Maximum number of simultaneously served connections. */
+#define MAX_CONNS  32
+
 static void websrv_new_conn(tcp_listener_t *, tcp_conn_t *);
 
 static tcp_listen_cb_t listen_cb = {
@@ -74,6 +82,14 @@ static tcp_cb_t conn_cb = {
 
 static uint16_t port = DEFAULT_PORT;
 
+/**
+ * Admission control of incoming connections. The TCP library dedicates
+ * a fibril to every incoming connection; the semaphore bounds how many
+ * of them are served at a time and its wait list forms the accept
+ * queue for the rest.
+ */
+static FIBRIL_SEMAPHORE_INITIALIZE(conn_semaphore, MAX_CONNS);
+
 typedef struct {
 	tcp_conn_t *conn;
 
@@ -89,10 +105,6 @@ static bool verbose = false;
 
 /** Responses to send to client. */
 
-static const char *msg_ok =
-    "HTTP/1.0 200 OK\r\n"
-    "\r\n";
-
 static const char *msg_bad_request =
     "HTTP/1.0 400 Bad Request\r\n"
     "\r\n"
@@ -166,10 +178,16 @@ static errno_t recv_char(recv_t *recv, char *c)
 
 		rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
 		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
+			if (verbose) {
+				fprintf(stderr, "tcp_conn_recv() failed: %s\n",
+				    str_error(rc));
+			}
 			return rc;
 		}
 
+		if (nrecv == 0)
+			return ENOTCONN;
+
 		recv->rbuf_in = nrecv;
 	}
 
@@ -240,15 +258,16 @@ static errno_t send_response(tcp_conn_t *conn, const char *msg)
 	return EOK;
 }
 
-static errno_t uri_get(const char *uri, tcp_conn_t *conn)
+static errno_t uri_get(const char *uri, tcp_conn_t *conn, bool keep_alive)
 {
 	char *fbuf = NULL;
 	char *fname = NULL;
+	char *hdr = NULL;
 	errno_t rc;
 	size_t nr;
 	int fd = -1;
 
-	fbuf = calloc(BUFFER_SIZE, 1);
+	fbuf = malloc(FILE_BUFFER_SIZE);
 	if (fbuf == NULL) {
 		rc = ENOMEM;
 		goto out;
@@ -271,13 +290,31 @@ static errno_t uri_get(const char *uri, tcp_conn_t *conn)
 	free(fname);
 	fname = NULL;
 
-	rc = send_response(conn, msg_ok);
+	/*
+	 * The content length lets the client find the response boundary,
+	 * which is what makes keep-alive connections possible at all.
+	 */
+	vfs_stat_t stat;
+	rc = vfs_stat(fd, &stat);
+	if (rc != EOK)
+		goto out;
+
+	if (asprintf(&hdr, "HTTP/1.1 200 OK\r\n"
+	    "Content-Length: %" PRIu64 "\r\n"
+	    "Connection: %s\r\n"
+	    "\r\n", (uint64_t) stat.size,
+	    keep_alive ? "keep-alive" : "close") < 0) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	rc = send_response(conn, hdr);
 	if (rc != EOK)
 		goto out;
 
 	aoff64_t pos = 0;
 	while (true) {
-		rc = vfs_read(fd, &pos, fbuf, BUFFER_SIZE, &nr);
+		rc = vfs_read(fd, &pos, fbuf, FILE_BUFFER_SIZE, &nr);
 		if (rc != EOK)
 			goto out;
 
@@ -295,46 +332,90 @@ static errno_t uri_get(const char *uri, tcp_conn_t *conn)
 out:
 	if (fd >= 0)
 		vfs_put(fd);
+	free(hdr);
 	free(fname);
 	free(fbuf);
 	return rc;
 }
 
-static errno_t req_process(tcp_conn_t *conn, recv_t *recv)
+/** Process one request on the connection.
+ *
+ * @param conn       Connection.
+ * @param recv       Receive buffer of the connection.
+ * @param close_conn Set to @c true if the connection must be closed
+ *                   after the response.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t req_process(tcp_conn_t *conn, recv_t *recv, bool *close_conn)
 {
 	char *reqline = NULL;
 
 	errno_t rc = recv_line(recv, &reqline);
-	if (rc != EOK) {
-		fprintf(stderr, "recv_line() failed\n");
+	if (rc != EOK)
 		return rc;
-	}
 
 	if (verbose)
 		fprintf(stderr, "Request: %s", reqline);
 
 	if (str_lcmp(reqline, "GET ", 4) != 0) {
+		*close_conn = true;
 		rc = send_response(conn, msg_not_implemented);
 		return rc;
 	}
 
 	char *uri = reqline + 4;
+	bool http_1_1 = false;
 	char *end_uri = str_chr(uri, ' ');
 	if (end_uri == NULL) {
 		end_uri = reqline + str_size(reqline) - 2;
 		assert(*end_uri == '\r');
+	} else if (str_lcmp(end_uri + 1, "HTTP/1.1", 8) == 0) {
+		http_1_1 = true;
 	}
 
 	*end_uri = '\0';
 	if (verbose)
 		fprintf(stderr, "Requested URI: %s\n", uri);
 
+	/*
+	 * Consume the header lines; requests of a keep-alive connection
+	 * would otherwise run together. HTTP/1.1 connections persist
+	 * unless the client asks for closing, HTTP/1.0 connections
+	 * close unless it asks for keeping alive.
+	 */
+	bool keep_alive = http_1_1;
+
+	while (true) {
+		char *hline;
+		rc = recv_line(recv, &hline);
+		if (rc != EOK)
+			return rc;
+
+		if (str_cmp(hline, "\r\n") == 0)
+			break;
+
+		if (str_lcasecmp(hline, "connection:", 11) == 0) {
+			char *value = hline + 11;
+			while (*value == ' ')
+				value++;
+
+			if (str_lcasecmp(value, "close", 5) == 0)
+				keep_alive = false;
+			else if (str_lcasecmp(value, "keep-alive", 10) == 0)
+				keep_alive = true;
+		}
+	}
+
+	*close_conn = !keep_alive;
+
 	if (!uri_is_valid(uri)) {
+		*close_conn = true;
 		rc = send_response(conn, msg_bad_request);
 		return rc;
 	}
 
-	return uri_get(uri, conn);
+	return uri_get(uri, conn, keep_alive);
 }
 
 static void usage(void)
@@ -404,6 +485,8 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 	errno_t rc;
 	recv_t *recv = NULL;
 
+	fibril_semaphore_down(&conn_semaphore);
+
 	if (verbose)
 		fprintf(stderr, "New connection, waiting for request\n");
 
@@ -413,20 +496,28 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 		goto error;
 	}
 
-	rc = req_process(conn, recv);
-	if (rc != EOK) {
-		fprintf(stderr, "Error processing request (%s)\n",
-		    str_error(rc));
-		goto error;
+	/*
+	 * Serve requests until the client closes the connection or asks
+	 * for closing it. Pipelined requests are simply picked up from
+	 * the receive buffer by the next iteration.
+	 */
+	bool close_conn = false;
+	while (!close_conn) {
+		rc = req_process(conn, recv, &close_conn);
+		if (rc != EOK)
+			break;
 	}
 
+	/*
+	 * A receive failure at a request boundary is the client closing
+	 * a keep-alive connection, not an error worth resetting.
+	 */
 	rc = tcp_conn_send_fin(conn);
-	if (rc != EOK) {
+	if (rc != EOK)
 		fprintf(stderr, "Error sending FIN.\n");
-		goto error;
-	}
 
 	recv_destroy(recv);
+	fibril_semaphore_up(&conn_semaphore);
 	return;
 error:
 	rc = tcp_conn_reset(conn);
@@ -434,6 +525,7 @@ error:
 		fprintf(stderr, "Error resetting connection.\n");
 
 	recv_destroy(recv);
+	fibril_semaphore_up(&conn_semaphore);
 }
 
 int main(int argc, char *argv[])
@@ -45,6 +45,9 @@
 
 #define NAME  "ahci"
 
+/** Size of one command table (command FIS + PRDT), 128-byte aligned. */
+#define AHCI_CMD_TABLE_SIZE  256
+
 #define LO(ptr) \
 	((uint32_t) (((uint64_t) ((uintptr_t) (ptr))) & 0xffffffff))
 
@@ -116,8 +119,7 @@ static errno_t write_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 
 static errno_t ahci_identify_device(sata_dev_t *);
 static errno_t ahci_set_highest_ultra_dma_mode(sata_dev_t *);
-static errno_t ahci_rb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
-static errno_t ahci_wb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
+static errno_t ahci_ncq_fpdma(sata_dev_t *, bool, uintptr_t, uint64_t);
 
 static void ahci_sata_devices_create(ahci_dev_t *, ddf_dev_t *);
 static ahci_dev_t *ahci_ahci_create(ddf_dev_t *);
@@ -240,10 +242,12 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
 
 	memset(buf, 0, sata->block_size);
 
-	fibril_mutex_lock(&sata->lock);
-
+	/*
+	 * No serialization on the device; concurrent calls overlap at the
+	 * device in separate NCQ command slots.
+	 */
 	for (size_t cur = 0; cur < count; cur++) {
-		rc = ahci_rb_fpdma(sata, phys, blocknum + cur);
+		rc = ahci_ncq_fpdma(sata, false, phys, blocknum + cur);
 		if (rc != EOK)
 			break;
 
@@ -251,7 +255,6 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
 		    ibuf, sata->block_size);
 	}
 
-	fibril_mutex_unlock(&sata->lock);
 	dmamem_unmap_anonymous(ibuf);
 
 	return rc;
@@ -281,17 +284,14 @@ static errno_t write_blocks(ddf_fun_t *fun, uint64_t blocknum,
 		return rc;
 	}
 
-	fibril_mutex_lock(&sata->lock);
-
 	for (size_t cur = 0; cur < count; cur++) {
 		memcpy(ibuf, (void *) (((uint8_t *) buf) + (sata->block_size * cur)),
 		    sata->block_size);
-		rc = ahci_wb_fpdma(sata, phys, blocknum + cur);
+		rc = ahci_ncq_fpdma(sata, true, phys, blocknum + cur);
 		if (rc != EOK)
 			break;
 	}
 
-	fibril_mutex_unlock(&sata->lock);
 	dmamem_unmap_anonymous(ibuf);
 
 	return rc;
@@ -478,6 +478,9 @@ static errno_t ahci_identify_device(sata_dev_t *sata)
 		goto error;
 	}
 
+	/* Word 75 bits 4:0 encode the device queue depth minus one */
+	sata->ncq_depth = (idata->queue_depth & 0x1f) + 1;
+
 	uint16_t logsec = idata->physical_logic_sector_size;
 	if ((logsec & 0xc000) == 0x4000) {
 		/* Length of sector may be larger than 512 B */
@@ -668,23 +671,38 @@ error:
 	return EINTR;
 }
 
-/** Set AHCI registers for reading one sector from the SATA device using FPDMA.
+/** Get the command table of a command slot. */
+static volatile uint32_t *ahci_cmd_table_get(sata_dev_t *sata,
+    unsigned int slot)
+{
+	return sata->cmd_table +
+	    (slot * AHCI_CMD_TABLE_SIZE) / sizeof(uint32_t);
+}
+
+/** Set AHCI registers for one sector FPDMA transfer in a command slot.
+ *
+ * The caller must hold the event lock and own the command slot.
  *
  * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param write    True for FPDMA write, false for FPDMA read.
+ * @param slot     Command slot (equals the NCQ tag) to use.
+ * @param phys     Physical address of buffer with sector data.
+ * @param blocknum Block number to transfer.
  *
  */
-static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static void ahci_ncq_fpdma_cmd(sata_dev_t *sata, bool write, unsigned int slot,
+    uintptr_t phys, uint64_t blocknum)
 {
+	volatile uint32_t *cmd_table = ahci_cmd_table_get(sata, slot);
 	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	    (sata_ncq_command_frame_t *) cmd_table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x60;
-	cmd->tag = 0;
+	cmd->command = write ? 0x61 : 0x60;
+
+	/* NCQ tag in bits 7:3 */
+	cmd->tag = slot << 3;
 	cmd->control = 0;
 
 	cmd->reserved1 = 0;
@@ -705,7 +723,7 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->lba5 = (blocknum >> 40) & 0xff;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&cmd_table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
@@ -714,127 +732,85 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	prdt->reserved2 = 0;
 	prdt->ioc = 0;
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
+	volatile ahci_cmdhdr_t *header = &sata->cmd_header[slot];
+
+	header->prdtl = 1;
+	header->flags =
 	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
+	    (write ? AHCI_CMDHDR_FLAGS_WRITE : 0) |
 	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	header->bytesprocessed = 0;
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	sata->port->pxsact |= (1 << slot);
+	sata->port->pxci |= (1 << slot);
 }
 
-/** Read one sector from the SATA device using FPDMA.
+/** Transfer one sector to or from the SATA device using FPDMA.
+ *
+ * Acquires a free NCQ command slot (waiting for one to complete if the
+ * whole queue is in use), issues the command and sleeps until the port
+ * interrupt handler marks the slot as complete. Multiple fibrils can
+ * thus keep up to the device queue depth of commands in flight.
  *
  * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param write    True for FPDMA write, false for FPDMA read.
+ * @param phys     Physical address of buffer with sector data.
+ * @param blocknum Block number to transfer.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t ahci_rb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static errno_t ahci_ncq_fpdma(sata_dev_t *sata, bool write, uintptr_t phys,
+    uint64_t blocknum)
 {
 	if (sata->is_invalid_device) {
 		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA read from invalid device", sata->model);
+		    "%s: FPDMA transfer on invalid device", sata->model);
 		return EINTR;
 	}
 
-	ahci_rb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
-
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA read", sata->model);
-		return EINTR;
-	}
-
-	return EOK;
-}
-
-/** Set AHCI registers for writing one sector to the SATA device, use FPDMA.
- *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
- *
- * @return EOK if succeed, error code otherwise
- *
- */
-static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
-{
-	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
-
-	cmd->fis_type = SATA_CMD_FIS_TYPE;
-	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x61;
-	cmd->tag = 0;
-	cmd->control = 0;
+	fibril_mutex_lock(&sata->event_lock);
 
-	cmd->reserved1 = 0;
-	cmd->reserved2 = 0;
-	cmd->reserved3 = 0;
-	cmd->reserved4 = 0;
-	cmd->reserved5 = 0;
-	cmd->reserved6 = 0;
+	/* Acquire a free command slot */
+	unsigned int slot;
+	while (true) {
+		if (sata->is_invalid_device) {
+			fibril_mutex_unlock(&sata->event_lock);
+			return EINTR;
+		}
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+		for (slot = 0; slot < sata->ncq_depth; slot++) {
+			if ((sata->slots_used & (1 << slot)) == 0)
+				break;
+		}
 
-	cmd->lba0 = blocknum & 0xff;
-	cmd->lba1 = (blocknum >> 8) & 0xff;
-	cmd->lba2 = (blocknum >> 16) & 0xff;
-	cmd->lba3 = (blocknum >> 24) & 0xff;
-	cmd->lba4 = (blocknum >> 32) & 0xff;
-	cmd->lba5 = (blocknum >> 40) & 0xff;
+		if (slot < sata->ncq_depth)
+			break;
 
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+		fibril_condvar_wait(&sata->slot_condvar, &sata->event_lock);
+	}
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
+	sata->slots_used |= (1 << slot);
+	sata->slot_done[slot] = false;
+	sata->slot_pxis[slot] = 0;
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
-	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_WRITE |
-	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	ahci_ncq_fpdma_cmd(sata, write, slot, phys, blocknum);
+	sata->slots_issued |= (1 << slot);
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
-}
+	/* Wait for the interrupt handler to complete the slot */
+	while (!sata->slot_done[slot])
+		fibril_condvar_wait(&sata->slot_condvar, &sata->event_lock);
 
-/** Write one sector into the SATA device, use FPDMA.
- *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
- *
- * @return EOK if succeed, error code otherwise
- *
- */
-static errno_t ahci_wb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
-{
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA write to invalid device", sata->model);
-		return EINTR;
-	}
+	ahci_port_is_t pxis = sata->slot_pxis[slot];
+	sata->slots_used &= ~(1 << slot);
+	fibril_condvar_broadcast(&sata->slot_condvar);
 
-	ahci_wb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	fibril_mutex_unlock(&sata->event_lock);
 
 	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
 		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA write", sata->model);
+		    "%s: Unrecoverable error during FPDMA %s", sata->model,
+		    write ? "write" : "read");
 		return EINTR;
 	}
 
@@ -911,9 +887,46 @@ static void ahci_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 	    (ahci_port_is_error(pxis))) {
 		fibril_mutex_lock(&sata->event_lock);
 
+		/* Non-queued commands (identify device, set mode) */
 		sata->event_pxis = pxis;
 		fibril_condvar_signal(&sata->event_condvar);
 
+		/* Per-slot completion tracking of NCQ commands */
+		if (sata->slots_issued != 0) {
+			uint32_t done;
+
+			if (ahci_port_is_error(pxis)) {
+				/*
+				 * The device aborts all outstanding
+				 * queued commands on error.
+				 */
+				done = sata->slots_issued;
+
+				if (ahci_port_is_permanent_error(pxis))
+					sata->is_invalid_device = true;
+			} else {
+				/*
+				 * Slots no longer active on the device
+				 * have completed.
+				 */
+				done = sata->slots_issued &
+				    ~sata->port->pxsact;
+			}
+
+			for (unsigned int slot = 0; slot < AHCI_NCQ_SLOTS;
+			    slot++) {
+				if (done & (1 << slot)) {
+					sata->slot_done[slot] = true;
+					sata->slot_pxis[slot] = pxis;
+				}
+			}
+
+			sata->slots_issued &= ~done;
+
+			if (done != 0)
+				fibril_condvar_broadcast(&sata->slot_condvar);
+		}
+
 		fibril_mutex_unlock(&sata->event_lock);
 	}
 }
@@ -968,15 +981,22 @@ static sata_dev_t *ahci_sata_allocate(ahci_dev_t *ahci, volatile ahci_port_t *po
 	sata->port->pxclb = LO(phys);
 	sata->cmd_header = (ahci_cmdhdr_t *) virt_cmd;
 
-	/* Allocate and init command table structure. */
-	rc = dmamem_map_anonymous(size, DMAMEM_4GiB,
+	/* Allocate and init command table structures, one per command slot. */
+	size_t table_size = AHCI_NCQ_SLOTS * AHCI_CMD_TABLE_SIZE;
+	rc = dmamem_map_anonymous(table_size, DMAMEM_4GiB,
 	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
 	if (rc != EOK)
 		goto error_table;
 
-	memset(virt_table, 0, size);
-	sata->cmd_header->cmdtableu = HI(phys);
-	sata->cmd_header->cmdtable = LO(phys);
+	memset(virt_table, 0, table_size);
+
+	for (unsigned int slot = 0; slot < AHCI_NCQ_SLOTS; slot++) {
+		sata->cmd_header[slot].cmdtableu =
+		    HI(phys + slot * AHCI_CMD_TABLE_SIZE);
+		sata->cmd_header[slot].cmdtable =
+		    LO(phys + slot * AHCI_CMD_TABLE_SIZE);
+	}
+
 	sata->cmd_table = (uint32_t *) virt_table;
 
 	return sata;
@@ -1056,6 +1076,11 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	fibril_mutex_initialize(&sata->lock);
 	fibril_mutex_initialize(&sata->event_lock);
 	fibril_condvar_initialize(&sata->event_condvar);
+	fibril_condvar_initialize(&sata->slot_condvar);
+
+	sata->slots_used = 0;
+	sata->slots_issued = 0;
+	sata->ncq_depth = 1;
 
 	ahci_sata_hw_start(sata);
 
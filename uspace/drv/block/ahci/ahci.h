@@ -40,6 +40,9 @@
 #include <stdint.h>
 #include "ahci_hw.h"
 
+/** Number of NCQ command slots per port. */
+#define AHCI_NCQ_SLOTS  32
+
 /** AHCI Device. */
 typedef struct {
 	/** Pointer to ddf device. */
@@ -90,6 +93,24 @@ typedef struct {
 	/** Event interrupt state. */
 	ahci_port_is_t event_pxis;
 
+	/** Mask of command slots owned by in-flight NCQ commands. */
+	uint32_t slots_used;
+
+	/** Mask of command slots issued to the device. */
+	uint32_t slots_issued;
+
+	/** Per-slot completion flags set by the interrupt handler. */
+	bool slot_done[AHCI_NCQ_SLOTS];
+
+	/** Per-slot completion interrupt state. */
+	ahci_port_is_t slot_pxis[AHCI_NCQ_SLOTS];
+
+	/** Signalled when a command slot completes or becomes free. */
+	fibril_condvar_t slot_condvar;
+
+	/** NCQ queue depth supported by the device. */
+	uint8_t ncq_depth;
+
 	/** Number of device data blocks. */
 	uint64_t blocks;
 
@@ -35,8 +35,11 @@
  * @brief ATA disk driver
  *
  * This driver supports CHS, 28-bit and 48-bit LBA addressing, as well as
- * PACKET devices. It only uses PIO transfers. There is no support DMA
- * or any other fancy features such as S.M.A.R.T, removable devices, etc.
+ * PACKET devices. It only uses PIO transfers, but reads and writes
+ * whole multi-sector ranges with a single command and, when the bus
+ * provides an IRQ, sleeps on interrupt-driven completion instead of
+ * polling the status register. There is no support for DMA or any other
+ * fancy features such as S.M.A.R.T, removable devices, etc.
  *
  * This driver is based on the ATA-1, ATA-2, ATA-3 and ATA/ATAPI-4 through 7
  * standards, as published by the ANSI, NCITS and INCITS standards bodies,
@@ -48,7 +51,9 @@
  */
 
 #include <ddi.h>
+#include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <device/hw_res.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
@@ -75,6 +80,16 @@
 /** Number of defined legacy controller base addresses. */
 #define LEGACY_CTLS 4
 
+/** Maximum number of sectors in one transfer.
+ *
+ * A sector count of zero in the (extended) sector count register means
+ * 256 (65536) sectors; by staying one below we avoid the special case.
+ */
+enum {
+	max_scnt	= 255,
+	max_scnt_ext	= 65535
+};
+
 /**
  * Size of data returned from Identify Device or Identify Packet Device
  * command.
@@ -119,6 +134,9 @@ static void coord_sc_program(ata_ctrl_t *ctrl, const block_coord_t *bc,
     uint16_t scnt);
 static errno_t wait_status(ata_ctrl_t *ctrl, unsigned set, unsigned n_reset,
     uint8_t *pstatus, unsigned timeout);
+static errno_t wait_irq(ata_ctrl_t *ctrl, uint8_t *pstatus, unsigned timeout);
+static void ata_irq_pending_clear(ata_ctrl_t *ctrl);
+static void ata_irq_handler(ipc_call_t *call, ddf_dev_t *dev);
 
 bd_ops_t ata_bd_ops = {
 	.open = ata_bd_open,
@@ -151,8 +169,14 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 	ddf_msg(LVL_DEBUG, "ata_ctrl_init()");
 
 	fibril_mutex_initialize(&ctrl->lock);
+	fibril_mutex_initialize(&ctrl->irq_lock);
+	fibril_condvar_initialize(&ctrl->irq_cv);
 	ctrl->cmd_physical = res->cmd;
 	ctrl->ctl_physical = res->ctl;
+	ctrl->irq = res->irq;
+	ctrl->ihandle = CAP_NIL;
+	ctrl->irq_enabled = false;
+	ctrl->irq_fired = false;
 
 	ddf_msg(LVL_NOTE, "I/O address %p/%p", (void *) ctrl->cmd_physical,
 	    (void *) ctrl->ctl_physical);
@@ -161,6 +185,9 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 	if (rc != EOK)
 		return rc;
 
+	/* Probe with device interrupts masked. */
+	pio_write_8(&ctrl->ctl->device_control, DCR_nIEN);
+
 	for (i = 0; i < MAX_DISKS; i++) {
 		ddf_msg(LVL_DEBUG, "Identify drive %d...", i);
 
@@ -195,6 +222,28 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 		goto error;
 	}
 
+	/*
+	 * Switch to interrupt-driven operation. If anything fails, the
+	 * driver simply keeps polling the status register.
+	 */
+	if (ctrl->irq >= 0) {
+		ctrl->parent_sess = ddf_dev_parent_sess_get(ctrl->dev);
+
+		rc = register_interrupt_handler(ctrl->dev, ctrl->irq,
+		    ata_irq_handler, NULL, &ctrl->ihandle);
+		if (rc == EOK && ctrl->parent_sess != NULL)
+			rc = hw_res_enable_interrupt(ctrl->parent_sess,
+			    ctrl->irq);
+
+		if (rc == EOK) {
+			pio_write_8(&ctrl->ctl->device_control, 0);
+			ctrl->irq_enabled = true;
+		} else {
+			ddf_msg(LVL_WARN, "Failed enabling IRQ %d, will "
+			    "poll instead.", ctrl->irq);
+		}
+	}
+
 	return EOK;
 error:
 	for (i = 0; i < MAX_DISKS; i++) {
@@ -334,8 +383,79 @@ static errno_t ata_bd_init_io(ata_ctrl_t *ctrl)
 /** Clean up device I/O. */
 static void ata_bd_fini_io(ata_ctrl_t *ctrl)
 {
-	(void) ctrl;
-	/* XXX TODO */
+	if (ctrl->ihandle != CAP_NIL) {
+		(void) unregister_interrupt_handler(ctrl->dev, ctrl->ihandle);
+		ctrl->ihandle = CAP_NIL;
+		ctrl->irq_enabled = false;
+	}
+}
+
+/** Interrupt handler.
+ *
+ * Reading the status register acknowledges the interrupt in the device.
+ * The status is passed on to the fibril sleeping in wait_irq().
+ */
+static void ata_irq_handler(ipc_call_t *call, ddf_dev_t *dev)
+{
+	ata_ctrl_t *ctrl = (ata_ctrl_t *)ddf_dev_data_get(dev);
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_status = pio_read_8(&ctrl->cmd->status);
+	ctrl->irq_fired = true;
+	fibril_condvar_signal(&ctrl->irq_cv);
+	fibril_mutex_unlock(&ctrl->irq_lock);
+
+	if (ctrl->parent_sess != NULL)
+		hw_res_clear_interrupt(ctrl->parent_sess, ctrl->irq);
+}
+
+/** Discard a pending interrupt.
+ *
+ * Called before issuing a command so that a stale interrupt from a
+ * previous command cannot be mistaken for the completion of a new one.
+ */
+static void ata_irq_pending_clear(ata_ctrl_t *ctrl)
+{
+	if (!ctrl->irq_enabled)
+		return;
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_fired = false;
+	fibril_mutex_unlock(&ctrl->irq_lock);
+}
+
+/** Wait for an interrupt from the device.
+ *
+ * When interrupts are not available, fall back to polling the status
+ * register. The same is done if the interrupt does not arrive in time,
+ * so that a lost interrupt does not fail the command.
+ *
+ * @param ctrl		Controller
+ * @param pstatus	Pointer where to store last read status or NULL.
+ * @param timeout	Timeout in 10ms units.
+ *
+ * @return		EOK on success, EIO on timeout.
+ */
+static errno_t wait_irq(ata_ctrl_t *ctrl, uint8_t *pstatus, unsigned timeout)
+{
+	if (!ctrl->irq_enabled)
+		return wait_status(ctrl, 0, ~SR_BSY, pstatus, timeout);
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	while (!ctrl->irq_fired) {
+		if (fibril_condvar_wait_timeout(&ctrl->irq_cv, &ctrl->irq_lock,
+		    (usec_t) timeout * 10000) == ETIMEOUT) {
+			fibril_mutex_unlock(&ctrl->irq_lock);
+			return wait_status(ctrl, 0, ~SR_BSY, pstatus, timeout);
+		}
+	}
+
+	ctrl->irq_fired = false;
+	if (pstatus != NULL)
+		*pstatus = ctrl->irq_status;
+	fibril_mutex_unlock(&ctrl->irq_lock);
+
+	return EOK;
 }
 
 /** Initialize a disk.
@@ -519,9 +639,15 @@ static errno_t ata_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		return EINVAL;
 
 	while (cnt > 0) {
+		size_t nb;
+
 		if (disk->dev_type == ata_reg_dev) {
-			rc = ata_rcmd_read(disk, ba, 1, buf);
+			/* Transfer as many blocks per command as possible. */
+			nb = min(cnt, (disk->amode == am_lba48) ?
+			    (size_t) max_scnt_ext : (size_t) max_scnt);
+			rc = ata_rcmd_read(disk, ba, nb, buf);
 		} else {
+			nb = 1;
 			rc = ata_pcmd_read_12(disk, ba, 1, buf,
 			    disk->block_size);
 		}
@@ -529,9 +655,9 @@ static errno_t ata_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += nb;
+		cnt -= nb;
+		buf += nb * disk->block_size;
 	}
 
 	return EOK;
@@ -559,13 +685,17 @@ static errno_t ata_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		return EINVAL;
 
 	while (cnt > 0) {
-		rc = ata_rcmd_write(disk, ba, 1, buf);
+		/* Transfer as many blocks per command as possible. */
+		size_t nb = min(cnt, (disk->amode == am_lba48) ?
+		    (size_t) max_scnt_ext : (size_t) max_scnt);
+
+		rc = ata_rcmd_write(disk, ba, nb, buf);
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += nb;
+		cnt -= nb;
+		buf += nb * disk->block_size;
 	}
 
 	return EOK;
@@ -601,60 +731,105 @@ static errno_t ata_bd_sync_cache(bd_srv_t *bd, uint64_t ba, size_t cnt)
 	return ata_rcmd_flush_cache(disk);
 }
 
-/** PIO data-in command protocol. */
+/** PIO data-in command protocol.
+ *
+ * The device raises an interrupt (or clears BSY when polling) once for
+ * every data block, i.e. once per sector for the Read Sectors commands.
+ */
 static errno_t ata_pio_data_in(disk_t *disk, void *obuf, size_t obuf_size,
     size_t blk_size, size_t nblocks)
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint16_t data;
+	size_t blk;
 	size_t i;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(obuf_size >= nblocks * blk_size);
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
-		return EIO;
+	for (blk = 0; blk < nblocks; blk++) {
+		if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
+			return EIO;
+
+		if ((status & SR_ERR) != 0)
+			return EIO;
 
-	if ((status & SR_DRQ) != 0) {
-		/* Read data from the device buffer. */
+		if ((status & SR_DRQ) == 0) {
+			/* The device may not have asserted DRQ yet. */
+			if (wait_status(ctrl, SR_DRQ, ~SR_BSY, &status,
+			    TIMEOUT_BSY) != EOK)
+				return EIO;
+
+			if ((status & SR_ERR) != 0)
+				return EIO;
+		}
 
+		/* Read data block from the device buffer. */
 		for (i = 0; i < blk_size / 2; i++) {
 			data = pio_read_16(&ctrl->cmd->data_port);
 			((uint16_t *) obuf)[i] = data;
 		}
-	}
 
-	if ((status & SR_ERR) != 0)
-		return EIO;
+		obuf += blk_size;
+	}
 
 	return EOK;
 }
 
-/** PIO data-out command protocol. */
+/** PIO data-out command protocol.
+ *
+ * The first data block must be transferred as soon as the device asserts
+ * DRQ; only the second and subsequent blocks are announced by an
+ * interrupt, as is the final command completion.
+ */
 static errno_t ata_pio_data_out(disk_t *disk, const void *buf, size_t buf_size,
     size_t blk_size, size_t nblocks)
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
+	size_t blk;
 	size_t i;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(buf_size >= nblocks * blk_size);
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
-		return EIO;
+	for (blk = 0; blk < nblocks; blk++) {
+		if (blk == 0) {
+			if (wait_status(ctrl, 0, ~SR_BSY, &status,
+			    TIMEOUT_BSY) != EOK)
+				return EIO;
+		} else {
+			if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
+				return EIO;
+		}
 
-	if ((status & SR_DRQ) != 0) {
-		/* Write data to the device buffer. */
+		if ((status & SR_ERR) != 0)
+			return EIO;
 
+		if ((status & SR_DRQ) == 0) {
+			/* The device may not have asserted DRQ yet. */
+			if (wait_status(ctrl, SR_DRQ, ~SR_BSY, &status,
+			    TIMEOUT_BSY) != EOK)
+				return EIO;
+
+			if ((status & SR_ERR) != 0)
+				return EIO;
+		}
+
+		/* Write data block to the device buffer. */
 		for (i = 0; i < blk_size / 2; i++) {
-			pio_write_16(&ctrl->cmd->data_port, ((uint16_t *) buf)[i]);
+			pio_write_16(&ctrl->cmd->data_port,
+			    ((uint16_t *) buf)[i]);
 		}
+
+		buf += blk_size;
 	}
 
+	/* Wait for the command to complete. */
+	if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
+		return EIO;
+
 	if (status & SR_ERR)
 		return EIO;
 
@@ -667,7 +842,7 @@ static errno_t ata_pio_nondata(disk_t *disk)
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint8_t status;
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
+	if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
 		return EIO;
 
 	if (status & SR_ERR)
@@ -1012,6 +1187,10 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	/* Silence warning. */
 	memset(&bc, 0, sizeof(bc));
 
+	/* Check device bounds. */
+	if (ba + blk_cnt > disk->blocks)
+		return EINVAL;
+
 	/* Compute block coordinates. */
 	if (coord_calc(disk, ba, &bc) != EOK)
 		return EINVAL;
@@ -1038,8 +1217,10 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 		return EIO;
 	}
 
-	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	/* Program block coordinates and sector count into the device. */
+	coord_sc_program(ctrl, &bc, (uint16_t) blk_cnt);
+
+	ata_irq_pending_clear(ctrl);
 
 	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
 	    CMD_READ_SECTORS_EXT : CMD_READ_SECTORS);
@@ -1072,6 +1253,10 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	/* Silence warning. */
 	memset(&bc, 0, sizeof(bc));
 
+	/* Check device bounds. */
+	if (ba + cnt > disk->blocks)
+		return EINVAL;
+
 	/* Compute block coordinates. */
 	if (coord_calc(disk, ba, &bc) != EOK)
 		return EINVAL;
@@ -1098,8 +1283,10 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 		return EIO;
 	}
 
-	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	/* Program block coordinates and sector count into the device. */
+	coord_sc_program(ctrl, &bc, (uint16_t) cnt);
+
+	ata_irq_pending_clear(ctrl);
 
 	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
 	    CMD_WRITE_SECTORS_EXT : CMD_WRITE_SECTORS);
@@ -1143,6 +1330,8 @@ static errno_t ata_rcmd_flush_cache(disk_t *disk)
 		return EIO;
 	}
 
+	ata_irq_pending_clear(ctrl);
+
 	pio_write_8(&ctrl->cmd->command, CMD_FLUSH_CACHE);
 
 	rc = ata_pio_nondata(disk);
@@ -50,6 +50,7 @@
 typedef struct {
 	uintptr_t cmd;	/**< Command block base address. */
 	uintptr_t ctl;	/**< Control block base address. */
+	int irq;	/**< IRQ number or -1 if none was assigned. */
 } ata_base_t;
 
 /** Timeout definitions. Unit is 10 ms. */
@@ -140,6 +141,24 @@ typedef struct ata_ctrl {
 	/** Control registers */
 	ata_ctl_t *ctl;
 
+	/** IRQ number or -1 if interrupts are not used */
+	int irq;
+	/** Interrupt handler handle */
+	cap_irq_handle_t ihandle;
+	/** Session with the parent driver (for interrupt control) */
+	async_sess_t *parent_sess;
+	/** True once probing is done and device interrupts are enabled */
+	bool irq_enabled;
+
+	/** Protects irq_fired and irq_status */
+	fibril_mutex_t irq_lock;
+	/** Signalled by the interrupt handler */
+	fibril_condvar_t irq_cv;
+	/** An interrupt arrived and was not consumed yet */
+	bool irq_fired;
+	/** Status register value read by the interrupt handler */
+	uint8_t irq_status;
+
 	/** Per-disk state. */
 	disk_t disk[MAX_DISKS];
 
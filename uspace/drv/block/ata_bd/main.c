@@ -90,6 +90,12 @@ static errno_t ata_get_res(ddf_dev_t *dev, ata_base_t *ata_res)
 	ata_res->cmd = RNGABS(*cmd_rng);
 	ata_res->ctl = RNGABS(*ctl_rng);
 
+	/* An IRQ is optional; without one the driver polls. */
+	if (hw_res.irqs.count > 0)
+		ata_res->irq = hw_res.irqs.irqs[0];
+	else
+		ata_res->irq = -1;
+
 	if (RNGSZ(*ctl_rng) < sizeof(ata_ctl_t)) {
 		rc = EINVAL;
 		goto error;
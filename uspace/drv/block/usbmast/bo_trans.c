@@ -34,6 +34,7 @@
  * USB mass storage bulk-only transport.
  */
 
+#include <assert.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <str_error.h>
@@ -47,7 +48,66 @@
 #define MASTLOG(format, ...) \
 	usb_log_debug2("USB cl08: " format, ##__VA_ARGS__)
 
-/** Send command via bulk-only transport.
+/** Size of each preallocated data-stage buffer in bytes. */
+#define DATA_BUF_SIZE	(128 * 1024)
+
+/** Allocate the preallocated transfer buffers of a mass storage device.
+ *
+ * The command block and status wrappers as well as the data stages of
+ * chunked reads and writes go through buffers satisfying the DMA policy
+ * of the respective bulk pipe, so that no bounce buffer needs to be
+ * allocated per transfer.
+ *
+ * @param mdev		Mass storage device with bulk pipes already set up
+ * @return		Error code
+ */
+errno_t usb_massstor_buffers_init(usbmast_dev_t *mdev)
+{
+	fibril_mutex_initialize(&mdev->lock);
+	fibril_mutex_initialize(&mdev->buf_lock);
+
+	mdev->cbw_buf = usb_pipe_alloc_buffer(mdev->bulk_out_pipe,
+	    sizeof(usb_massstor_cbw_t));
+	mdev->csw_buf = usb_pipe_alloc_buffer(mdev->bulk_in_pipe,
+	    sizeof(usb_massstor_csw_t));
+	mdev->data_in_buf = usb_pipe_alloc_buffer(mdev->bulk_in_pipe,
+	    DATA_BUF_SIZE);
+	mdev->data_out_buf = usb_pipe_alloc_buffer(mdev->bulk_out_pipe,
+	    DATA_BUF_SIZE);
+
+	if (mdev->cbw_buf == NULL || mdev->csw_buf == NULL ||
+	    mdev->data_in_buf == NULL || mdev->data_out_buf == NULL) {
+		usb_massstor_buffers_fini(mdev);
+		return ENOMEM;
+	}
+
+	mdev->data_buf_size = DATA_BUF_SIZE;
+	return EOK;
+}
+
+/** Free the preallocated transfer buffers of a mass storage device.
+ *
+ * @param mdev		Mass storage device
+ */
+void usb_massstor_buffers_fini(usbmast_dev_t *mdev)
+{
+	if (mdev->cbw_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_out_pipe, mdev->cbw_buf);
+	if (mdev->csw_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->csw_buf);
+	if (mdev->data_in_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->data_in_buf);
+	if (mdev->data_out_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_out_pipe, mdev->data_out_buf);
+
+	mdev->cbw_buf = NULL;
+	mdev->csw_buf = NULL;
+	mdev->data_in_buf = NULL;
+	mdev->data_out_buf = NULL;
+	mdev->data_buf_size = 0;
+}
+
+/** Send command via bulk-only transport (transport lock held).
  *
  * @param mfun		Mass storage function
  * @param tag		Command block wrapper tag (automatically compared
@@ -56,10 +116,13 @@
  *
  * @return		Error code
  */
-errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+static errno_t usb_massstor_cmd_locked(usbmast_fun_t *mfun, uint32_t tag,
+    scsi_cmd_t *cmd)
 {
 	errno_t rc;
 
+	assert(fibril_mutex_is_locked(&mfun->mdev->lock));
+
 	if (cmd->data_in && cmd->data_out)
 		return EINVAL;
 
@@ -77,15 +140,15 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	}
 
 	/* Prepare CBW - command block wrapper */
-	usb_massstor_cbw_t cbw;
-	usb_massstor_cbw_prepare(&cbw, tag, dbuf_size, ddir, mfun->lun,
+	usb_massstor_cbw_t *cbw = mfun->mdev->cbw_buf;
+	usb_massstor_cbw_prepare(cbw, tag, dbuf_size, ddir, mfun->lun,
 	    cmd->cdb_size, cmd->cdb);
 
 	/* Send the CBW. */
 	MASTLOG("Sending CBW.\n");
-	rc = usb_pipe_write(bulk_out_pipe, &cbw, sizeof(cbw));
+	rc = usb_pipe_write_dma(bulk_out_pipe, cbw, cbw, sizeof(*cbw));
 	MASTLOG("CBW '%s' sent: %s.\n",
-	    usb_debug_str_buffer((uint8_t *) &cbw, sizeof(cbw), 0),
+	    usb_debug_str_buffer((uint8_t *) cbw, sizeof(*cbw), 0),
 	    str_error(rc));
 	if (rc != EOK) {
 		usb_log_error("Bulk out write failed: %s", str_error(rc));
@@ -96,15 +159,26 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	if (cmd->data_in) {
 		size_t act_size;
 		/* Recieve data from the device. */
-		rc = usb_pipe_read(dpipe, cmd->data_in, cmd->data_in_size,
-		    &act_size);
+		if (cmd->dma) {
+			rc = usb_pipe_read_dma(dpipe, mfun->mdev->data_in_buf,
+			    cmd->data_in, cmd->data_in_size, &act_size);
+		} else {
+			rc = usb_pipe_read(dpipe, cmd->data_in,
+			    cmd->data_in_size, &act_size);
+		}
 		MASTLOG("Received %zu bytes (%s): %s.\n", act_size,
 		    usb_debug_str_buffer(cmd->data_in, act_size, 0),
 		    str_error(rc));
 	}
 	if (cmd->data_out) {
 		/* Send data to the device. */
-		rc = usb_pipe_write(dpipe, cmd->data_out, cmd->data_out_size);
+		if (cmd->dma) {
+			rc = usb_pipe_write_dma(dpipe, mfun->mdev->data_out_buf,
+			    (void *) cmd->data_out, cmd->data_out_size);
+		} else {
+			rc = usb_pipe_write(dpipe, cmd->data_out,
+			    cmd->data_out_size);
+		}
 		MASTLOG("Sent %zu bytes (%s): %s.\n", cmd->data_out_size,
 		    usb_debug_str_buffer(cmd->data_out, cmd->data_out_size, 0),
 		    str_error(rc));
@@ -120,33 +194,33 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	}
 
 	/* Read CSW. */
-	usb_massstor_csw_t csw;
+	usb_massstor_csw_t *csw = mfun->mdev->csw_buf;
 	size_t csw_size;
 	MASTLOG("Reading CSW.\n");
-	rc = usb_pipe_read(bulk_in_pipe, &csw, sizeof(csw), &csw_size);
+	rc = usb_pipe_read_dma(bulk_in_pipe, csw, csw, sizeof(*csw), &csw_size);
 	MASTLOG("CSW '%s' received (%zu bytes): %s.\n",
-	    usb_debug_str_buffer((uint8_t *) &csw, csw_size, 0), csw_size,
+	    usb_debug_str_buffer((uint8_t *) csw, csw_size, 0), csw_size,
 	    str_error(rc));
 	if (rc != EOK) {
 		usb_log_error("Failed to read CSW: %s", str_error(rc));
 		return EIO;
 	}
 
-	if (csw_size != sizeof(csw)) {
+	if (csw_size != sizeof(*csw)) {
 		usb_log_error("Received CSW of incorrect size.");
 		return EIO;
 	}
 
-	if (csw.dCSWTag != tag) {
+	if (csw->dCSWTag != tag) {
 		usb_log_error("Received CSW with incorrect tag. (expected: %"
-		    PRIX32 " received: %" PRIx32, tag, csw.dCSWTag);
+		    PRIX32 " received: %" PRIx32, tag, csw->dCSWTag);
 		return EIO;
 	}
 
 	/*
 	 * Determine the actual return value from the CSW.
 	 */
-	switch (csw.dCSWStatus) {
+	switch (csw->dCSWStatus) {
 	case cbs_passed:
 		cmd->status = CMDS_GOOD;
 		break;
@@ -164,7 +238,7 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 		break;
 	}
 
-	const size_t residue = uint32_usb2host(csw.dCSWDataResidue);
+	const size_t residue = uint32_usb2host(csw->dCSWDataResidue);
 	if (residue > dbuf_size) {
 		usb_log_error("Residue > buffer size (%zu > %zu).",
 		    residue, dbuf_size);
@@ -185,6 +259,29 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	return rc;
 }
 
+/** Send command via bulk-only transport.
+ *
+ * The bulk-only transport allows only a single command at a time;
+ * the CBW/data/CSW sequence is serialized on the device.
+ *
+ * @param mfun		Mass storage function
+ * @param tag		Command block wrapper tag (automatically compared
+ *			with answer)
+ * @param cmd		SCSI command
+ *
+ * @return		Error code
+ */
+errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+{
+	errno_t rc;
+
+	fibril_mutex_lock(&mfun->mdev->lock);
+	rc = usb_massstor_cmd_locked(mfun, tag, cmd);
+	fibril_mutex_unlock(&mfun->mdev->lock);
+
+	return rc;
+}
+
 /** Perform bulk-only mass storage reset.
  *
  * @param mfun		Mass storage function
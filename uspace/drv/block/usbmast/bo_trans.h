@@ -37,6 +37,7 @@
 #define BO_TRANS_H_
 
 #include <scsi/spc.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <usb/usb.h>
@@ -78,6 +79,9 @@ typedef struct {
 	/** Size of input buffer in bytes */
 	size_t data_in_size;
 
+	/** Data buffers point into the device's preallocated DMA buffers */
+	bool dma;
+
 	/** Number of bytes actually received */
 	size_t rcvd_size;
 
@@ -85,6 +89,8 @@ typedef struct {
 	cmd_status_t status;
 } scsi_cmd_t;
 
+extern errno_t usb_massstor_buffers_init(usbmast_dev_t *);
+extern void usb_massstor_buffers_fini(usbmast_dev_t *);
 extern errno_t usb_massstor_cmd(usbmast_fun_t *, uint32_t, scsi_cmd_t *);
 extern errno_t usb_massstor_reset(usbmast_dev_t *);
 extern void usb_massstor_reset_recovery(usbmast_dev_t *);
@@ -123,6 +123,7 @@ static errno_t usbmast_device_gone(usb_device_t *dev)
 		ddf_fun_destroy(mdev->luns[i]);
 		mdev->luns[i] = NULL;
 	}
+	usb_massstor_buffers_fini(mdev);
 	free(mdev->luns);
 	return EOK;
 }
@@ -185,6 +186,13 @@ static errno_t usbmast_device_add(usb_device_t *dev)
 
 	mdev->bulk_in_pipe = &epm_in->pipe;
 	mdev->bulk_out_pipe = &epm_out->pipe;
+
+	rc = usb_massstor_buffers_init(mdev);
+	if (rc != EOK) {
+		usb_log_error("Failed allocating transfer buffers.");
+		goto error;
+	}
+
 	for (i = 0; i < mdev->lun_count; i++) {
 		rc = usbmast_fun_create(mdev, i);
 		if (rc != EOK)
@@ -204,6 +212,7 @@ error:
 		}
 		ddf_fun_destroy(mdev->luns[i]);
 	}
+	usb_massstor_buffers_fini(mdev);
 	free(mdev->luns);
 	return rc;
 }
@@ -72,40 +72,12 @@ static void usbmast_dump_sense(scsi_sense_data_t *sense_buf)
 	    sense_buf->additional_cqual);
 }
 
-static errno_t usb_massstor_unit_ready(usbmast_fun_t *mfun)
-{
-	scsi_cmd_t cmd;
-	scsi_cdb_test_unit_ready_t cdb;
-	errno_t rc;
-
-	memset(&cdb, 0, sizeof(cdb));
-	cdb.op_code = SCSI_CMD_TEST_UNIT_READY;
-
-	memset(&cmd, 0, sizeof(cmd));
-	cmd.cdb = &cdb;
-	cmd.cdb_size = sizeof(cdb);
-
-	rc = usb_massstor_cmd(mfun, 0xDEADBEEF, &cmd);
-
-	if (rc != EOK) {
-		usb_log_error("Test Unit Ready failed on device %s: %s.",
-		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
-		return rc;
-	}
-	/*
-	 * Ignore command error here. If there's something wrong
-	 * with the device the following commands will fail too.
-	 */
-	if (cmd.status != CMDS_GOOD)
-		usb_log_warning("Test Unit Ready command failed on device %s.",
-		    usb_device_get_name(mfun->mdev->usb_dev));
-
-	return EOK;
-}
-
 /** Run SCSI command.
  *
- * Run command and repeat in case of unit attention.
+ * Run command and repeat in case of unit attention. Rather than probing
+ * the unit with TEST UNIT READY before every command, failures are
+ * diagnosed via REQUEST SENSE after the fact, saving a transport round
+ * trip on the common path.
  * XXX This is too simplified.
  */
 static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
@@ -115,16 +87,9 @@ static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
 	errno_t rc;
 
 	do {
-		rc = usb_massstor_unit_ready(mfun);
-		if (rc != EOK) {
-			usb_log_error("Inquiry transport failed, device %s: %s.",
-			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
-			return rc;
-		}
-
 		rc = usb_massstor_cmd(mfun, 0xDEADBEEF, cmd);
 		if (rc != EOK) {
-			usb_log_error("Inquiry transport failed, device %s: %s.",
+			usb_log_error("Command transport failed, device %s: %s.",
 			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
 			return rc;
 		}
@@ -316,15 +281,20 @@ errno_t usbmast_read_capacity(usbmast_fun_t *mfun, uint32_t *nblocks,
 	return EOK;
 }
 
-/** Perform SCSI Read command on USB mass storage device.
+/** Read a chunk of blocks into the preallocated data-stage buffer.
+ *
+ * The caller must hold the device buffer lock and @a nblocks must fit
+ * into the data-stage buffer.
  *
  * @param mfun		Mass storage function
  * @param ba		Address of first block
  * @param nblocks	Number of blocks to read
+ * @param buf		Destination buffer
  *
  * @return		Error code
  */
-errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf)
+static errno_t usbmast_read_chunk(usbmast_fun_t *mfun, uint64_t ba,
+    size_t nblocks, void *buf)
 {
 	scsi_cmd_t cmd;
 	scsi_cdb_read_10_t cdb;
@@ -333,9 +303,6 @@ errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf
 	if (ba > UINT32_MAX)
 		return ELIMIT;
 
-	if (nblocks > UINT16_MAX)
-		return ELIMIT;
-
 	memset(&cdb, 0, sizeof(cdb));
 	cdb.op_code = SCSI_CMD_READ_10;
 	cdb.lba = host2uint32_t_be(ba);
@@ -344,8 +311,9 @@ errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cdb = &cdb;
 	cmd.cdb_size = sizeof(cdb);
-	cmd.data_in = buf;
+	cmd.data_in = mfun->mdev->data_in_buf;
 	cmd.data_in_size = nblocks * mfun->block_size;
+	cmd.dma = true;
 
 	rc = usbmast_run_cmd(mfun, &cmd);
 
@@ -367,20 +335,66 @@ errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf
 		return EIO;
 	}
 
+	memcpy(buf, mfun->mdev->data_in_buf, nblocks * mfun->block_size);
+
 	return EOK;
 }
 
-/** Perform SCSI Write command on USB mass storage device.
+/** Perform SCSI Read command on USB mass storage device.
+ *
+ * Requests larger than the preallocated data-stage buffer are streamed
+ * through it in maximum-sized chunks.
  *
  * @param mfun		Mass storage function
  * @param ba		Address of first block
  * @param nblocks	Number of blocks to read
+ *
+ * @return		Error code
+ */
+errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf)
+{
+	usbmast_dev_t *mdev = mfun->mdev;
+	uint8_t *bp = buf;
+	errno_t rc = EOK;
+
+	const size_t max_nblocks =
+	    min(mdev->data_buf_size / mfun->block_size, UINT16_MAX);
+	if (max_nblocks == 0)
+		return ELIMIT;
+
+	fibril_mutex_lock(&mdev->buf_lock);
+
+	while (nblocks > 0) {
+		const size_t cur_nblocks = min(nblocks, max_nblocks);
+
+		rc = usbmast_read_chunk(mfun, ba, cur_nblocks, bp);
+		if (rc != EOK)
+			break;
+
+		bp += cur_nblocks * mfun->block_size;
+		ba += cur_nblocks;
+		nblocks -= cur_nblocks;
+	}
+
+	fibril_mutex_unlock(&mdev->buf_lock);
+
+	return rc;
+}
+
+/** Write a chunk of blocks through the preallocated data-stage buffer.
+ *
+ * The caller must hold the device buffer lock and @a nblocks must fit
+ * into the data-stage buffer.
+ *
+ * @param mfun		Mass storage function
+ * @param ba		Address of first block
+ * @param nblocks	Number of blocks to write
  * @param data		Data to write
  *
  * @return		Error code
  */
-errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
-    const void *data)
+static errno_t usbmast_write_chunk(usbmast_fun_t *mfun, uint64_t ba,
+    size_t nblocks, const void *data)
 {
 	scsi_cmd_t cmd;
 	scsi_cdb_write_10_t cdb;
@@ -389,19 +403,19 @@ errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
 	if (ba > UINT32_MAX)
 		return ELIMIT;
 
-	if (nblocks > UINT16_MAX)
-		return ELIMIT;
-
 	memset(&cdb, 0, sizeof(cdb));
 	cdb.op_code = SCSI_CMD_WRITE_10;
 	cdb.lba = host2uint32_t_be(ba);
 	cdb.xfer_len = host2uint16_t_be(nblocks);
 
+	memcpy(mfun->mdev->data_out_buf, data, nblocks * mfun->block_size);
+
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cdb = &cdb;
 	cmd.cdb_size = sizeof(cdb);
-	cmd.data_out = data;
+	cmd.data_out = mfun->mdev->data_out_buf;
 	cmd.data_out_size = nblocks * mfun->block_size;
+	cmd.dma = true;
 
 	rc = usbmast_run_cmd(mfun, &cmd);
 
@@ -420,6 +434,49 @@ errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
 	return EOK;
 }
 
+/** Perform SCSI Write command on USB mass storage device.
+ *
+ * Requests larger than the preallocated data-stage buffer are streamed
+ * through it in maximum-sized chunks.
+ *
+ * @param mfun		Mass storage function
+ * @param ba		Address of first block
+ * @param nblocks	Number of blocks to write
+ * @param data		Data to write
+ *
+ * @return		Error code
+ */
+errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
+    const void *data)
+{
+	usbmast_dev_t *mdev = mfun->mdev;
+	const uint8_t *bp = data;
+	errno_t rc = EOK;
+
+	const size_t max_nblocks =
+	    min(mdev->data_buf_size / mfun->block_size, UINT16_MAX);
+	if (max_nblocks == 0)
+		return ELIMIT;
+
+	fibril_mutex_lock(&mdev->buf_lock);
+
+	while (nblocks > 0) {
+		const size_t cur_nblocks = min(nblocks, max_nblocks);
+
+		rc = usbmast_write_chunk(mfun, ba, cur_nblocks, bp);
+		if (rc != EOK)
+			break;
+
+		bp += cur_nblocks * mfun->block_size;
+		ba += cur_nblocks;
+		nblocks -= cur_nblocks;
+	}
+
+	fibril_mutex_unlock(&mdev->buf_lock);
+
+	return rc;
+}
+
 /** Perform SCSI Synchronize Cache command on USB mass storage device.
  *
  * @param mfun		Mass storage function
@@ -37,6 +37,7 @@
 #define USBMAST_H_
 
 #include <bd_srv.h>
+#include <fibril_synch.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <usb/usb.h>
@@ -53,6 +54,20 @@ typedef struct usbmast_dev {
 	usb_pipe_t *bulk_in_pipe;
 	/** Data write pipe */
 	usb_pipe_t *bulk_out_pipe;
+	/** Serializes the bulk-only transport (one CBW/data/CSW at a time) */
+	fibril_mutex_t lock;
+	/** Serializes use of the preallocated data-stage buffers */
+	fibril_mutex_t buf_lock;
+	/** Preallocated command block wrapper buffer */
+	void *cbw_buf;
+	/** Preallocated command status wrapper buffer */
+	void *csw_buf;
+	/** Preallocated data-stage buffer for chunked reads */
+	void *data_in_buf;
+	/** Preallocated data-stage buffer for chunked writes */
+	void *data_out_buf;
+	/** Size of each data-stage buffer in bytes */
+	size_t data_buf_size;
 } usbmast_dev_t;
 
 /** Mass storage function.
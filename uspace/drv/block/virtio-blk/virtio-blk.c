@@ -35,6 +35,7 @@
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <macros.h>
 #include <pci_dev_iface.h>
 #include <fibril_synch.h>
 
@@ -83,6 +84,7 @@ static void virtio_blk_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	while (virtio_virtq_consume_used(vdev, RQ_QUEUE, &descno, &len)) {
 		assert(descno < RQ_BUFFERS);
 		fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
+		virtio_blk->rq_done[descno] = true;
 		fibril_condvar_signal(&virtio_blk->completion_cv[descno]);
 		fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
 	}
@@ -157,8 +159,23 @@ static errno_t virtio_blk_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
-    aoff64_t ba, void *buf)
+/** Queue a request into the virtqueue without waiting for its completion.
+ *
+ * @param virtio_blk	Virtio block device.
+ * @param read		True if reading, false if writing.
+ * @param ba		Address of the first block of the request.
+ * @param cnt		Number of blocks (at most RQ_MAX_BLOCKS unless the
+ *			data is transferred directly, see @a buf_phys).
+ * @param buf		Data source / destination.
+ * @param buf_phys	Physical address of @a buf if the device can access
+ *			it directly (zero-copy), zero to bounce the data
+ *			through the request's DMA buffer.
+ *
+ * @return		Number of the descriptor backing the request. The
+ *			caller must eventually pass it to virtio_blk_rq_wait().
+ */
+static uint16_t virtio_blk_rq_submit(virtio_blk_t *virtio_blk, bool read,
+    aoff64_t ba, size_t cnt, void *buf, uintptr_t buf_phys)
 {
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 
@@ -181,6 +198,7 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	fibril_mutex_unlock(&virtio_blk->free_lock);
 
 	assert(descno < RQ_BUFFERS);
+	assert(cnt > 0 && (cnt <= RQ_MAX_BLOCKS || buf_phys != 0));
 
 	/* Setup the request header */
 	virtio_blk_req_header_t *req_header =
@@ -190,11 +208,15 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	    read ? VIRTIO_BLK_T_IN : VIRTIO_BLK_T_OUT);
 	pio_write_le64(&req_header->sector, ba);
 
-	/* Copy write data to the request. */
-	if (!read)
-		memcpy(virtio_blk->rq_buf[descno], buf, VIRTIO_BLK_BLOCK_SIZE);
+	/* Copy write data to the request unless transferring directly. */
+	if (!read && buf_phys == 0) {
+		memcpy(virtio_blk->rq_buf[descno], buf,
+		    cnt * VIRTIO_BLK_BLOCK_SIZE);
+	}
 
 	fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
+	virtio_blk->rq_done[descno] = false;
+	fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
 
 	/*
 	 * Set the descriptors, chain them in the virtqueue and notify the
@@ -204,7 +226,8 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	    virtio_blk->rq_header_p[descno], sizeof(virtio_blk_req_header_t),
 	    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(descno));
 	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_BUFFER_DESC(descno),
-	    virtio_blk->rq_buf_p[descno], VIRTIO_BLK_BLOCK_SIZE,
+	    buf_phys != 0 ? buf_phys : virtio_blk->rq_buf_p[descno],
+	    cnt * VIRTIO_BLK_BLOCK_SIZE,
 	    VIRTQ_DESC_F_NEXT | (read ? VIRTQ_DESC_F_WRITE : 0),
 	    REQ_FOOTER_DESC(descno));
 	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_FOOTER_DESC(descno),
@@ -212,11 +235,34 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	    VIRTQ_DESC_F_WRITE, 0);
 	virtio_virtq_produce_available(vdev, RQ_QUEUE, descno);
 
+	return descno;
+}
+
+/** Wait for a previously submitted request and collect its result.
+ *
+ * @param virtio_blk	Virtio block device.
+ * @param descno	Descriptor returned by virtio_blk_rq_submit().
+ * @param read		True if reading, false if writing.
+ * @param cnt		Number of blocks of the request.
+ * @param buf		Destination for read data bounced through the
+ *			request's DMA buffer, @c NULL for direct transfers.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t virtio_blk_rq_wait(virtio_blk_t *virtio_blk, uint16_t descno,
+    bool read, size_t cnt, void *buf)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+
 	/*
-	 * Wait for the completion of the request.
+	 * Wait for the completion of the request. Requests retire out of
+	 * order, hence the done flag: ours may have completed already.
 	 */
-	fibril_condvar_wait(&virtio_blk->completion_cv[descno],
-	    &virtio_blk->completion_lock[descno]);
+	fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
+	while (!virtio_blk->rq_done[descno]) {
+		fibril_condvar_wait(&virtio_blk->completion_cv[descno],
+		    &virtio_blk->completion_lock[descno]);
+	}
 	fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
 
 	errno_t rc;
@@ -240,8 +286,9 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	}
 
 	/* Copy read data from the request */
-	if (rc == EOK && read)
-		memcpy(buf, virtio_blk->rq_buf[descno], VIRTIO_BLK_BLOCK_SIZE);
+	if (rc == EOK && read && buf != NULL)
+		memcpy(buf, virtio_blk->rq_buf[descno],
+		    cnt * VIRTIO_BLK_BLOCK_SIZE);
 
 	/* Free the descriptor and buffer */
 	fibril_mutex_lock(&virtio_blk->free_lock);
@@ -256,20 +303,59 @@ static errno_t virtio_blk_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     void *buf, size_t size, bool read)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
-	aoff64_t i;
-	errno_t rc;
+	struct {
+		uint16_t descno;
+		size_t cnt;
+		void *buf;
+	} rq[RQ_BUFFERS];
+	size_t nrq = 0;
+	size_t pos = 0;
+	uintptr_t phys = 0;
+	errno_t rc = EOK;
 
 	if (size != cnt * VIRTIO_BLK_BLOCK_SIZE)
 		return EINVAL;
 
-	for (i = 0; i < cnt; i++) {
-		rc = virtio_blk_rw_block(virtio_blk, read, ba + i,
-		    buf + i * VIRTIO_BLK_BLOCK_SIZE);
-		if (rc != EOK)
-			return rc;
+	/*
+	 * Buffers handed out by virtio_blk_bd_alloc_buf() are device
+	 * visible, so the device can transfer the data directly, without
+	 * bouncing it through the per-request DMA buffers.
+	 */
+	if (virtio_blk->dma_pool != NULL &&
+	    dma_pool_phys(virtio_blk->dma_pool, buf, &phys) != EOK)
+		phys = 0;
+
+	/*
+	 * Split the transfer into RQ_MAX_BLOCKS-sized requests and keep as
+	 * many of them in the virtqueue as there are descriptors available,
+	 * collecting completions as the window fills up. Direct (zero-copy)
+	 * transfers fit in a single request. On error, stop submitting, but
+	 * drain all requests still in flight.
+	 */
+	while (pos < cnt || nrq > 0) {
+		if (rc == EOK && pos < cnt && nrq < RQ_BUFFERS) {
+			size_t c = (phys != 0) ? cnt - pos :
+			    min(cnt - pos, RQ_MAX_BLOCKS);
+			rq[nrq].cnt = c;
+			rq[nrq].buf = (phys != 0) ? NULL :
+			    buf + pos * VIRTIO_BLK_BLOCK_SIZE;
+			rq[nrq].descno = virtio_blk_rq_submit(virtio_blk,
+			    read, ba + pos, c,
+			    buf + pos * VIRTIO_BLK_BLOCK_SIZE,
+			    (phys != 0) ? phys + pos * VIRTIO_BLK_BLOCK_SIZE :
+			    0);
+			nrq++;
+			pos += c;
+		} else {
+			nrq--;
+			errno_t rrc = virtio_blk_rq_wait(virtio_blk,
+			    rq[nrq].descno, read, rq[nrq].cnt, rq[nrq].buf);
+			if (rc == EOK)
+				rc = rrc;
+		}
 	}
 
-	return EOK;
+	return rc;
 }
 
 static errno_t virtio_blk_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
@@ -298,6 +384,29 @@ static errno_t virtio_blk_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *nb)
 	return EOK;
 }
 
+static errno_t virtio_blk_bd_get_queue_depth(bd_srv_t *bd, size_t *qdepth)
+{
+	*qdepth = RQ_BUFFERS;
+	return EOK;
+}
+
+static void *virtio_blk_bd_alloc_buf(bd_srv_t *bd, size_t size)
+{
+	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
+
+	if (virtio_blk->dma_pool == NULL || size > RQ_POOL_BUFSIZE)
+		return NULL;
+
+	return dma_pool_alloc(virtio_blk->dma_pool, NULL);
+}
+
+static void virtio_blk_bd_free_buf(bd_srv_t *bd, void *buf, size_t size)
+{
+	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
+
+	dma_pool_free(virtio_blk->dma_pool, buf);
+}
+
 bd_ops_t virtio_blk_bd_ops = {
 	.open = virtio_blk_bd_open,
 	.close = virtio_blk_bd_close,
@@ -305,6 +414,9 @@ bd_ops_t virtio_blk_bd_ops = {
 	.write_blocks = virtio_blk_bd_write_blocks,
 	.get_block_size = virtio_blk_bd_get_block_size,
 	.get_num_blocks = virtio_blk_bd_get_num_blocks,
+	.get_queue_depth = virtio_blk_bd_get_queue_depth,
+	.alloc_buf = virtio_blk_bd_alloc_buf,
+	.free_buf = virtio_blk_bd_free_buf,
 };
 
 static errno_t virtio_blk_initialize(ddf_dev_t *dev)
@@ -341,7 +453,7 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev, 0);
+	rc = virtio_device_setup_start(vdev, 0, 0, NULL);
 	if (rc != EOK)
 		goto fail;
 
@@ -376,8 +488,9 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	    true, virtio_blk->rq_header, virtio_blk->rq_header_p);
 	if (rc != EOK)
 		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, VIRTIO_BLK_BLOCK_SIZE,
-	    true, virtio_blk->rq_buf, virtio_blk->rq_buf_p);
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS,
+	    RQ_MAX_BLOCKS * VIRTIO_BLK_BLOCK_SIZE, true, virtio_blk->rq_buf,
+	    virtio_blk->rq_buf_p);
 	if (rc != EOK)
 		goto fail;
 	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
@@ -394,6 +507,17 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	virtio_create_desc_free_list(vdev, RQ_QUEUE, RQ_BUFFERS,
 	    &virtio_blk->rq_free_head);
 
+	/*
+	 * Create a pool of device-visible transfer buffers for zero-copy
+	 * transfers (best effort; without it all transfers bounce).
+	 */
+	rc = dma_pool_create(RQ_POOL_BUFSIZE, RQ_POOL_BUFS, 0,
+	    &virtio_blk->dma_pool);
+	if (rc != EOK) {
+		ddf_msg(LVL_WARN, "Failed to create DMA pool");
+		virtio_blk->dma_pool = NULL;
+	}
+
 	/*
 	 * Enable IRQ
 	 */
@@ -412,6 +536,9 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	return EOK;
 
 fail:
+	if (virtio_blk->dma_pool != NULL)
+		dma_pool_destroy(virtio_blk->dma_pool);
+
 	virtio_teardown_dma_bufs(virtio_blk->rq_header);
 	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
 	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
@@ -425,6 +552,9 @@ static void virtio_blk_uninitialize(ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) ddf_dev_data_get(dev);
 
+	if (virtio_blk->dma_pool != NULL)
+		dma_pool_destroy(virtio_blk->dma_pool);
+
 	virtio_teardown_dma_bufs(virtio_blk->rq_header);
 	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
 	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
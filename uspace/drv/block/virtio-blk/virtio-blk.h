@@ -31,6 +31,7 @@
 
 #include <virtio-pci.h>
 #include <bd_srv.h>
+#include <dma_pool.h>
 #include <abi/cap.h>
 
 #include <fibril_synch.h>
@@ -48,6 +49,13 @@
 
 #define RQ_BUFFERS	32
 
+/** Maximum number of blocks transferred by a single virtio request. */
+#define RQ_MAX_BLOCKS	8
+
+/** Number and size of buffers in the zero-copy DMA pool. */
+#define RQ_POOL_BUFS	16
+#define RQ_POOL_BUFSIZE	(32 * 1024)
+
 /** Device is read-only. */
 #define VIRTIO_BLK_F_RO		(1U << 5)
 
@@ -89,6 +97,21 @@ typedef struct {
 
 	fibril_mutex_t completion_lock[RQ_BUFFERS];
 	fibril_condvar_t completion_cv[RQ_BUFFERS];
+
+	/**
+	 * In-flight request table. An entry is cleared when the request
+	 * is produced into the virtqueue and set by the interrupt handler
+	 * when the device retires the request, so completions are never
+	 * lost even if they arrive before the submitter starts waiting.
+	 */
+	bool rq_done[RQ_BUFFERS];
+
+	/**
+	 * Pool of device-visible transfer buffers handed to bd_srv
+	 * clients, making aligned transfers zero-copy. May be NULL,
+	 * in which case all transfers bounce through rq_buf.
+	 */
+	dma_pool_t *dma_pool;
 } virtio_blk_t;
 
 #endif
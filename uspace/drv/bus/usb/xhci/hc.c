@@ -649,23 +649,33 @@ static int event_worker(void *arg)
 	return 0;
 }
 
+/** Number of events dequeued from the event ring in one burst */
+#define EVENT_RING_BURST 16
+
 /**
  * Dequeue from event ring and handle dequeued events.
  *
  * As there can be events, that blocks on waiting for subsequent events,
  * we solve this problem by deferring some types of events to separate fibrils.
+ *
+ * The events are dequeued in bursts, taking the event ring lock and
+ * updating the ERDP only once per burst.
  */
 static void hc_run_event_ring(xhci_hc_t *hc, xhci_event_ring_t *event_ring,
     xhci_interrupter_regs_t *intr)
 {
 	errno_t err;
 
-	xhci_trb_t trb;
+	xhci_trb_t trbs[EVENT_RING_BURST];
+	size_t count;
 	hc->event_handler = fibril_get_id();
 
-	while ((err = xhci_event_ring_dequeue(event_ring, &trb)) != ENOENT) {
-		if ((err = hc_handle_event(hc, &trb)) != EOK) {
-			usb_log_error("Failed to handle event in interrupt: %s", str_error(err));
+	while ((count = xhci_event_ring_dequeue_batch(event_ring, trbs,
+	    EVENT_RING_BURST)) > 0) {
+		for (size_t i = 0; i < count; ++i) {
+			if ((err = hc_handle_event(hc, &trbs[i])) != EOK) {
+				usb_log_error("Failed to handle event in interrupt: %s", str_error(err));
+			}
 		}
 
 		XHCI_REG_WR(intr, XHCI_INTR_ERDP, hc->event_ring.dequeue_ptr);
@@ -61,8 +61,13 @@ void isoch_init(xhci_endpoint_t *ep, const usb_endpoint_descriptors_t *desc)
 	 */
 	isoch->buffer_count = (2 * hc->ist) / ep->interval;
 
-	/* 2 buffers are the very minimum. */
-	isoch->buffer_count = max(2, isoch->buffer_count);
+	/*
+	 * Keep at least 4 buffers in rotation. Two are the very minimum to
+	 * avoid over/underruns, the extra ones give the batched feeding a
+	 * chance to push several TDs per doorbell and keep the endpoint fed
+	 * while events are still in flight.
+	 */
+	isoch->buffer_count = max(4, isoch->buffer_count);
 
 	usb_log_debug("[isoch] isoch setup with %zu buffers", isoch->buffer_count);
 }
@@ -173,16 +178,16 @@ err:
 	return ENOMEM;
 }
 
-static errno_t schedule_isochronous_trb(xhci_endpoint_t *ep, xhci_isoch_transfer_t *it)
+static void fill_isochronous_trb(xhci_endpoint_t *ep, xhci_isoch_transfer_t *it,
+    xhci_trb_t *trb)
 {
-	xhci_trb_t trb;
-	xhci_trb_clean(&trb);
+	xhci_trb_clean(trb);
 
-	trb.parameter = host2xhci(64, dma_buffer_phys_base(&it->data));
-	TRB_CTRL_SET_XFER_LEN(trb, it->size);
-	TRB_CTRL_SET_TD_SIZE(trb, 0);
-	TRB_CTRL_SET_IOC(trb, 1);
-	TRB_CTRL_SET_TRB_TYPE(trb, XHCI_TRB_TYPE_ISOCH);
+	trb->parameter = host2xhci(64, dma_buffer_phys_base(&it->data));
+	TRB_CTRL_SET_XFER_LEN(*trb, it->size);
+	TRB_CTRL_SET_TD_SIZE(*trb, 0);
+	TRB_CTRL_SET_IOC(*trb, 1);
+	TRB_CTRL_SET_TRB_TYPE(*trb, XHCI_TRB_TYPE_ISOCH);
 
 	// see 4.14.1 and 4.11.2.3 for the explanation, how to calculate those
 	size_t tdpc = it->size / 1024 + ((it->size % 1024) ? 1 : 0);
@@ -192,12 +197,51 @@ static errno_t schedule_isochronous_trb(xhci_endpoint_t *ep, xhci_isoch_transfer
 	size_t bsp = tdpc % ep->max_burst;
 	size_t tlbpc = (bsp ? bsp : ep->max_burst) - 1;
 
-	TRB_ISOCH_SET_TBC(trb, tbc);
-	TRB_ISOCH_SET_TLBPC(trb, tlbpc);
-	TRB_ISOCH_SET_FRAMEID(trb, (it->mfindex / 8) % 2048);
+	TRB_ISOCH_SET_TBC(*trb, tbc);
+	TRB_ISOCH_SET_TLBPC(*trb, tlbpc);
+	TRB_ISOCH_SET_FRAMEID(*trb, (it->mfindex / 8) % 2048);
+}
 
-	const errno_t err = xhci_trb_ring_enqueue(&ep->ring, &trb, &it->interrupt_trb_phys);
-	return err;
+/**
+ * Enqueue prepared TDs to the transfer ring in one batch and ring the
+ * doorbell once for all of them. Updates the state of scheduled
+ * transfers.
+ *
+ * @return True if the doorbell was rung.
+ */
+static bool isoch_feed_batch(xhci_endpoint_t *ep, xhci_trb_t *trbs,
+    xhci_isoch_transfer_t **scheduled, size_t count)
+{
+	if (count == 0)
+		return false;
+
+	uintptr_t phys[count];
+	const errno_t err =
+	    xhci_trb_ring_enqueue_batch(&ep->ring, trbs, count, phys);
+
+	bool fed = false;
+	for (size_t i = 0; i < count; ++i) {
+		xhci_isoch_transfer_t *const it = scheduled[i];
+		it->error = err;
+		if (err) {
+			it->state = ISOCH_COMPLETE;
+		} else {
+			it->interrupt_trb_phys = phys[i];
+			it->state = ISOCH_FED;
+			fed = true;
+		}
+	}
+
+	if (fed) {
+		hc_ring_ep_doorbell(ep, 0);
+		/*
+		 * The ring may be dead. If no event happens until the delay,
+		 * reset the endpoint.
+		 */
+		timer_schedule_reset(ep);
+	}
+
+	return fed;
 }
 
 /** The number of bits the MFINDEX is stored in at HW */
@@ -309,9 +353,17 @@ static void isoch_feed_out(xhci_endpoint_t *ep)
 	xhci_bus_t *bus = bus_to_xhci_bus(ep->base.device->bus);
 	xhci_hc_t *hc = bus->hc;
 
-	bool fed = false;
+	xhci_trb_t trbs[isoch->buffer_count];
+	xhci_isoch_transfer_t *scheduled[isoch->buffer_count];
+	size_t count = 0;
 
-	while (isoch->transfers[isoch->hw_enqueue].state == ISOCH_FILLED) {
+	/*
+	 * Transfers put aside for the batch keep their ISOCH_FILLED state
+	 * until the batch is flushed, hence the loop is bounded by the
+	 * batch size too.
+	 */
+	while (count < isoch->buffer_count &&
+	    isoch->transfers[isoch->hw_enqueue].state == ISOCH_FILLED) {
 		xhci_isoch_transfer_t *const it = &isoch->transfers[isoch->hw_enqueue];
 		usec_t delay;
 
@@ -332,13 +384,8 @@ static void isoch_feed_out(xhci_endpoint_t *ep)
 		case WINDOW_INSIDE:
 			usb_log_debug("[isoch] feeding buffer %zu at 0x%" PRIx64,
 			    it - isoch->transfers, it->mfindex);
-			it->error = schedule_isochronous_trb(ep, it);
-			if (it->error) {
-				it->state = ISOCH_COMPLETE;
-			} else {
-				it->state = ISOCH_FED;
-				fed = true;
-			}
+			fill_isochronous_trb(ep, it, &trbs[count]);
+			scheduled[count++] = it;
 
 			isoch->hw_enqueue = (isoch->hw_enqueue + 1) % isoch->buffer_count;
 			break;
@@ -360,15 +407,7 @@ static void isoch_feed_out(xhci_endpoint_t *ep)
 	}
 
 out:
-	if (fed) {
-		hc_ring_ep_doorbell(ep, 0);
-		/*
-		 * The ring may be dead. If no event happens until the delay, reset the
-		 * endpoint.
-		 */
-		timer_schedule_reset(ep);
-	}
-
+	isoch_feed_batch(ep, trbs, scheduled, count);
 }
 
 static void isoch_feed_out_timer(void *ep)
@@ -395,9 +434,17 @@ static void isoch_feed_in(xhci_endpoint_t *ep)
 	xhci_bus_t *bus = bus_to_xhci_bus(ep->base.device->bus);
 	xhci_hc_t *hc = bus->hc;
 
-	bool fed = false;
+	xhci_trb_t trbs[isoch->buffer_count];
+	xhci_isoch_transfer_t *scheduled[isoch->buffer_count];
+	size_t count = 0;
 
-	while (isoch->transfers[isoch->enqueue].state <= ISOCH_FILLED) {
+	/*
+	 * Transfers put aside for the batch keep their ISOCH_FILLED state
+	 * until the batch is flushed, hence the loop is bounded by the
+	 * batch size too.
+	 */
+	while (count < isoch->buffer_count &&
+	    isoch->transfers[isoch->enqueue].state <= ISOCH_FILLED) {
 		xhci_isoch_transfer_t *const it = &isoch->transfers[isoch->enqueue];
 		usec_t delay;
 
@@ -437,26 +484,13 @@ static void isoch_feed_in(xhci_endpoint_t *ep)
 			usb_log_debug("[isoch] feeding buffer %zu at 0x%" PRIx64,
 			    it - isoch->transfers, it->mfindex);
 
-			it->error = schedule_isochronous_trb(ep, it);
-			if (it->error) {
-				it->state = ISOCH_COMPLETE;
-			} else {
-				it->state = ISOCH_FED;
-				fed = true;
-			}
+			fill_isochronous_trb(ep, it, &trbs[count]);
+			scheduled[count++] = it;
 			break;
 		}
 	}
 out:
-
-	if (fed) {
-		hc_ring_ep_doorbell(ep, 0);
-		/*
-		 * The ring may be dead. If no event happens until the delay, reset the
-		 * endpoint.
-		 */
-		timer_schedule_reset(ep);
-	}
+	isoch_feed_batch(ep, trbs, scheduled, count);
 }
 
 static void isoch_feed_in_timer(void *ep)
@@ -302,6 +302,93 @@ errno_t xhci_trb_ring_enqueue(xhci_trb_ring_t *ring, xhci_trb_t *td, uintptr_t *
 	return xhci_trb_ring_enqueue_multiple(ring, td, 1, phys);
 }
 
+/**
+ * Enqueue several independent TDs composed of a single TRB each.
+ *
+ * Unlike `xhci_trb_ring_enqueue_multiple`, the TRBs are not chained into
+ * one TD - every one of them completes on its own, and a physical
+ * address is returned for each of them that generates an interrupt.
+ * This way a whole batch of isochronous TDs costs a single ring
+ * traversal (and subsequently a single doorbell).
+ *
+ * @param first_trb array of TRBs to enqueue
+ * @param trbs number of TRBs to enqueue
+ * @param phys array of at least @p trbs entries, receives the address
+ *             of every TRB enqueued that generates an interrupt
+ * @return EOK on success,
+ *         EAGAIN when the ring is too full to fit all TRBs (temporary)
+ */
+errno_t xhci_trb_ring_enqueue_batch(xhci_trb_ring_t *ring, xhci_trb_t *first_trb,
+    size_t trbs, uintptr_t *phys)
+{
+	errno_t err;
+	assert(trbs > 0);
+
+	if (trbs > xhci_trb_ring_size(ring))
+		return ELIMIT;
+
+	fibril_mutex_lock(&ring->guard);
+
+	xhci_trb_t *const saved_enqueue_trb = ring->enqueue_trb;
+	trb_segment_t *const saved_enqueue_segment = ring->enqueue_segment;
+
+	/*
+	 * First, dry run and advance the enqueue pointer to see if the ring would
+	 * be full anytime during the transaction.
+	 */
+	xhci_trb_t *trb = first_trb;
+	for (size_t i = 0; i < trbs; ++i, ++trb) {
+		if (phys)
+			phys[i] = trb_generates_interrupt(trb) ?
+			    trb_ring_enqueue_phys(ring) : (uintptr_t)NULL;
+
+		ring->enqueue_trb++;
+
+		if (TRB_TYPE(*ring->enqueue_trb) == XHCI_TRB_TYPE_LINK)
+			trb_ring_resolve_link(ring);
+
+		if (trb_ring_enqueue_phys(ring) == ring->dequeue) {
+			err = EAGAIN;
+			goto err;
+		}
+	}
+
+	ring->enqueue_segment = saved_enqueue_segment;
+	ring->enqueue_trb = saved_enqueue_trb;
+
+	/*
+	 * Now, copy the TRBs without further checking.
+	 */
+	trb = first_trb;
+	for (size_t i = 0; i < trbs; ++i, ++trb) {
+		TRB_SET_CYCLE(*trb, ring->pcs);
+		xhci_trb_copy_to_pio(ring->enqueue_trb, trb);
+
+		usb_log_debug2("TRB ring(%p): Enqueued TRB %p", ring, trb);
+		ring->enqueue_trb++;
+
+		if (TRB_TYPE(*ring->enqueue_trb) == XHCI_TRB_TYPE_LINK) {
+			TRB_SET_CYCLE(*ring->enqueue_trb, ring->pcs);
+
+			if (TRB_LINK_TC(*ring->enqueue_trb)) {
+				ring->pcs = !ring->pcs;
+				usb_log_debug("TRB ring(%p): PCS toggled", ring);
+			}
+
+			trb_ring_resolve_link(ring);
+		}
+	}
+
+	fibril_mutex_unlock(&ring->guard);
+	return EOK;
+
+err:
+	ring->enqueue_segment = saved_enqueue_segment;
+	ring->enqueue_trb = saved_enqueue_trb;
+	fibril_mutex_unlock(&ring->guard);
+	return err;
+}
+
 void xhci_trb_ring_reset_dequeue_state(xhci_trb_ring_t *ring, uintptr_t *addr)
 {
 	assert(ring);
@@ -392,15 +479,17 @@ static uintptr_t event_ring_dequeue_phys(xhci_event_ring_t *ring)
 }
 
 /**
- * Fill the event with next valid event from the ring.
+ * Fill the event with next valid event from the ring. The ring guard
+ * must be held.
  *
  * @param event pointer to event to be overwritten
  * @return EOK on success,
  *         ENOENT when the ring is empty
  */
-errno_t xhci_event_ring_dequeue(xhci_event_ring_t *ring, xhci_trb_t *event)
+static errno_t event_ring_dequeue_locked(xhci_event_ring_t *ring,
+    xhci_trb_t *event)
 {
-	fibril_mutex_lock(&ring->guard);
+	assert(fibril_mutex_is_locked(&ring->guard));
 
 	/**
 	 * The ERDP reported to the HC is a half-phase off the one we need to
@@ -408,10 +497,8 @@ errno_t xhci_event_ring_dequeue(xhci_event_ring_t *ring, xhci_trb_t *event)
 	 */
 	ring->dequeue_ptr = event_ring_dequeue_phys(ring);
 
-	if (TRB_CYCLE(*ring->dequeue_trb) != ring->ccs) {
-		fibril_mutex_unlock(&ring->guard);
+	if (TRB_CYCLE(*ring->dequeue_trb) != ring->ccs)
 		return ENOENT; /* The ring is empty. */
-	}
 
 	/* Do not reorder the Cycle bit reading with memcpy */
 	read_barrier();
@@ -437,10 +524,46 @@ errno_t xhci_event_ring_dequeue(xhci_event_ring_t *ring, xhci_trb_t *event)
 		ring->dequeue_trb = segment_begin(ring->dequeue_segment);
 	}
 
-	fibril_mutex_unlock(&ring->guard);
 	return EOK;
 }
 
+/**
+ * Fill the event with next valid event from the ring.
+ *
+ * @param event pointer to event to be overwritten
+ * @return EOK on success,
+ *         ENOENT when the ring is empty
+ */
+errno_t xhci_event_ring_dequeue(xhci_event_ring_t *ring, xhci_trb_t *event)
+{
+	fibril_mutex_lock(&ring->guard);
+	const errno_t err = event_ring_dequeue_locked(ring, event);
+	fibril_mutex_unlock(&ring->guard);
+	return err;
+}
+
+/**
+ * Fill the array with valid events from the ring, up to the given count.
+ * Takes the ring guard only once for the whole burst.
+ *
+ * @param events array of events to be overwritten
+ * @param count size of the @p events array
+ * @return Number of events dequeued, 0 when the ring is empty.
+ */
+size_t xhci_event_ring_dequeue_batch(xhci_event_ring_t *ring,
+    xhci_trb_t *events, size_t count)
+{
+	size_t dequeued = 0;
+
+	fibril_mutex_lock(&ring->guard);
+	while (dequeued < count &&
+	    event_ring_dequeue_locked(ring, &events[dequeued]) == EOK)
+		++dequeued;
+	fibril_mutex_unlock(&ring->guard);
+
+	return dequeued;
+}
+
 void xhci_sw_ring_init(xhci_sw_ring_t *ring, size_t size)
 {
 	ring->begin = calloc(size, sizeof(xhci_trb_t));
@@ -79,6 +79,8 @@ extern errno_t xhci_trb_ring_enqueue(xhci_trb_ring_t *, xhci_trb_t *,
     uintptr_t *);
 extern errno_t xhci_trb_ring_enqueue_multiple(xhci_trb_ring_t *, xhci_trb_t *,
     size_t, uintptr_t *);
+extern errno_t xhci_trb_ring_enqueue_batch(xhci_trb_ring_t *, xhci_trb_t *,
+    size_t, uintptr_t *);
 extern size_t xhci_trb_ring_size(xhci_trb_ring_t *);
 
 extern void xhci_trb_ring_reset_dequeue_state(xhci_trb_ring_t *, uintptr_t *);
@@ -115,6 +117,8 @@ extern errno_t xhci_event_ring_init(xhci_event_ring_t *, size_t);
 extern void xhci_event_ring_fini(xhci_event_ring_t *);
 extern void xhci_event_ring_reset(xhci_event_ring_t *);
 extern errno_t xhci_event_ring_dequeue(xhci_event_ring_t *, xhci_trb_t *);
+extern size_t xhci_event_ring_dequeue_batch(xhci_event_ring_t *, xhci_trb_t *,
+    size_t);
 
 /**
  * A TRB ring of which the software is both consumer and provider.
@@ -74,6 +74,7 @@ typedef struct {
 	visual_t visual;
 
 	pixel2visual_t pixel2visual;
+	pixel2visual_row_t pixel2visual_row;
 	visual2pixel_t visual2pixel;
 	visual_mask_t visual_mask;
 	size_t pixel_bytes;
@@ -189,14 +190,28 @@ static errno_t kfb_gc_fill_rect(void *arg, gfx_rect_t *rect)
 	kfb_t *kfb = (kfb_t *) arg;
 	gfx_rect_t crect;
 	gfx_coord_t x, y;
+	uint32_t val;
+	uint32_t *dp;
 
 	/* Make sure we have a sorted, clipped rectangle */
 	gfx_rect_clip(rect, &kfb->rect, &crect);
 
-	for (y = crect.p0.y; y < crect.p1.y; y++) {
-		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			kfb->pixel2visual(kfb->addr + FB_POS(kfb, x, y),
-			    kfb->color);
+	if (kfb->pixel_bytes == sizeof(uint32_t)) {
+		/* Convert the color once and fill whole words */
+		kfb->pixel2visual(&val, kfb->color);
+
+		for (y = crect.p0.y; y < crect.p1.y; y++) {
+			dp = (uint32_t *) (kfb->addr +
+			    FB_POS(kfb, crect.p0.x, y));
+			for (x = crect.p0.x; x < crect.p1.x; x++)
+				*dp++ = val;
+		}
+	} else {
+		for (y = crect.p0.y; y < crect.p1.y; y++) {
+			for (x = crect.p0.x; x < crect.p1.x; x++) {
+				kfb->pixel2visual(kfb->addr + FB_POS(kfb, x, y),
+				    kfb->color);
+			}
 		}
 	}
 
@@ -269,6 +284,54 @@ static errno_t kfb_gc_bitmap_destroy(void *bm)
 	return EOK;
 }
 
+/** Copy a clipped bitmap rectangle to the framebuffer.
+ *
+ * @param kfb KFB
+ * @param kfbbm Bitmap
+ * @param pbm Bitmap pixel map
+ * @param crect Clipped source rectangle
+ * @param offs Destination offset
+ */
+static void kfb_gc_bitmap_copy(kfb_t *kfb, kfb_bitmap_t *kfbbm,
+    pixelmap_t *pbm, gfx_rect_t *crect, gfx_coord2_t *offs)
+{
+	gfx_coord2_t sp;
+	gfx_coord2_t dp;
+	gfx_coord2_t pos;
+	gfx_coord_t width;
+	pixel_t color;
+
+	width = crect->p1.x - crect->p0.x;
+	if (width <= 0)
+		return;
+
+	if (kfb->pixel2visual_row != NULL) {
+		/* Convert entire rows at once */
+		for (pos.y = crect->p0.y; pos.y < crect->p1.y; pos.y++) {
+			sp.x = crect->p0.x - kfbbm->rect.p0.x;
+			sp.y = pos.y - kfbbm->rect.p0.y;
+			dp.x = crect->p0.x + offs->x;
+			dp.y = pos.y + offs->y;
+
+			kfb->pixel2visual_row(kfb->addr +
+			    FB_POS(kfb, dp.x, dp.y),
+			    pixelmap_pixel_at(pbm, sp.x, sp.y), width);
+		}
+	} else {
+		for (pos.y = crect->p0.y; pos.y < crect->p1.y; pos.y++) {
+			for (pos.x = crect->p0.x; pos.x < crect->p1.x;
+			    pos.x++) {
+				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
+				gfx_coord2_add(&pos, offs, &dp);
+
+				color = pixelmap_get_pixel(pbm, sp.x, sp.y);
+				kfb->pixel2visual(kfb->addr +
+				    FB_POS(kfb, dp.x, dp.y), color);
+			}
+		}
+	}
+}
+
 /** Render bitmap in KFB GC.
  *
  * @param bm Bitmap
@@ -342,28 +405,10 @@ static errno_t kfb_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 		}
 	} else if ((kfbbm->flags & bmpf_colorize) != 0) {
 		/* Color key */
-		for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
-			for (pos.x = crect.p0.x; pos.x < crect.p1.x; pos.x++) {
-				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
-				gfx_coord2_add(&pos, &offs, &dp);
-
-				color = pixelmap_get_pixel(&pbm, sp.x, sp.y);
-				kfb->pixel2visual(kfb->addr +
-				    FB_POS(kfb, dp.x, dp.y), color);
-			}
-		}
+		kfb_gc_bitmap_copy(kfb, kfbbm, &pbm, &crect, &offs);
 	} else {
 		/* Color key & colorize */
-		for (pos.y = crect.p0.y; pos.y < crect.p1.y; pos.y++) {
-			for (pos.x = crect.p0.x; pos.x < crect.p1.x; pos.x++) {
-				gfx_coord2_subtract(&pos, &kfbbm->rect.p0, &sp);
-				gfx_coord2_add(&pos, &offs, &dp);
-
-				color = pixelmap_get_pixel(&pbm, sp.x, sp.y);
-				kfb->pixel2visual(kfb->addr +
-				    FB_POS(kfb, dp.x, dp.y), color);
-			}
-		}
+		kfb_gc_bitmap_copy(kfb, kfbbm, &pbm, &crect, &offs);
 	}
 
 	return EOK;
@@ -523,6 +568,9 @@ errno_t port_init(ddf_dev_t *dev)
 	kfb->scanline = scanline;
 	kfb->visual = visual;
 
+	/* Row conversion is only available for the 32-bit visuals */
+	kfb->pixel2visual_row = NULL;
+
 	switch (visual) {
 	case VISUAL_INDIRECT_8:
 		kfb->pixel2visual = pixel2bgr_323;
@@ -568,24 +616,28 @@ errno_t port_init(ddf_dev_t *dev)
 		break;
 	case VISUAL_RGB_8_8_8_0:
 		kfb->pixel2visual = pixel2rgb_8880;
+		kfb->pixel2visual_row = pixel2rgb_8880_row;
 		kfb->visual2pixel = rgb_8880_2pixel;
 		kfb->visual_mask = visual_mask_8880;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_RGB_0_8_8_8:
 		kfb->pixel2visual = pixel2rgb_0888;
+		kfb->pixel2visual_row = pixel2rgb_0888_row;
 		kfb->visual2pixel = rgb_0888_2pixel;
 		kfb->visual_mask = visual_mask_0888;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_0_8_8_8:
 		kfb->pixel2visual = pixel2bgr_0888;
+		kfb->pixel2visual_row = pixel2bgr_0888_row;
 		kfb->visual2pixel = bgr_0888_2pixel;
 		kfb->visual_mask = visual_mask_0888;
 		kfb->pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_8_8_8_0:
 		kfb->pixel2visual = pixel2bgr_8880;
+		kfb->pixel2visual_row = pixel2bgr_8880_row;
 		kfb->visual2pixel = bgr_8880_2pixel;
 		kfb->visual_mask = visual_mask_8880;
 		kfb->pixel_bytes = 4;
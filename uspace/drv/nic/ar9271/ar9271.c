@@ -384,14 +384,31 @@ static errno_t ar9271_ieee80211_bssid_change(ieee80211_dev_t *ieee80211_dev,
 		wmi_send_command(ar9271->htc_device, WMI_NODE_CREATE,
 		    (uint8_t *) &sta_msg, sizeof(sta_msg), NULL);
 
+		uint8_t ap_rates[IEEE80211_MAX_RATES_LENGTH];
+		size_t ap_rates_count =
+		    ieee80211_query_ap_rates(ieee80211_dev, ap_rates);
+
 		htc_rate_msg_t rate_msg;
 		memset(&rate_msg, 0, sizeof(htc_rate_msg_t));
 		rate_msg.sta_index = 1;
 		rate_msg.is_new = 1;
-		rate_msg.legacy_rates_count = ARRAY_SIZE(ieee80211bg_data_rates);
-		memcpy(&rate_msg.legacy_rates,
-		    ieee80211bg_data_rates,
-		    ARRAY_SIZE(ieee80211bg_data_rates));
+
+		if (ap_rates_count > 0) {
+			/*
+			 * Let firmware rate control adapt within the rate
+			 * set the AP advertises instead of the full b/g
+			 * table.
+			 */
+			rate_msg.legacy_rates_count = ap_rates_count;
+			memcpy(&rate_msg.legacy_rates, ap_rates,
+			    ap_rates_count);
+		} else {
+			rate_msg.legacy_rates_count =
+			    ARRAY_SIZE(ieee80211bg_data_rates);
+			memcpy(&rate_msg.legacy_rates,
+			    ieee80211bg_data_rates,
+			    ARRAY_SIZE(ieee80211bg_data_rates));
+		}
 
 		wmi_send_command(ar9271->htc_device, WMI_RC_RATE_UPDATE,
 		    (uint8_t *) &rate_msg, sizeof(rate_msg), NULL);
@@ -54,6 +54,14 @@
 
 #define E1000_DEFAULT_INTERRUPT_INTERVAL_USEC  250
 
+/** Maximum number of frames processed in one RX poll pass
+ *
+ * While the budget keeps being exhausted, RX interrupts stay masked and
+ * the receive fibril keeps polling the descriptor ring, so a frame flood
+ * cannot livelock the system in interrupt handling.
+ */
+#define E1000_RX_BUDGET  64
+
 /* Must be power of 8 */
 #define E1000_RX_FRAME_COUNT  128
 #define E1000_TX_FRAME_COUNT  128
@@ -168,6 +176,24 @@ typedef struct {
 	/** Lock for receiver */
 	fibril_mutex_t rx_lock;
 
+	/** RX poll fibril */
+	fid_t rx_fibril;
+
+	/** Lock for RX poll state */
+	fibril_mutex_t rx_poll_lock;
+
+	/** Signalled when RX poll state changes */
+	fibril_condvar_t rx_poll_cv;
+
+	/** RX polling requested by the interrupt handler */
+	bool rx_poll_run;
+
+	/** RX poll fibril asked to exit */
+	bool rx_poll_exit;
+
+	/** RX poll fibril has exited */
+	bool rx_poll_exited;
+
 	/** Lock for transmitter */
 	fibril_mutex_t tx_lock;
 
@@ -1167,12 +1193,19 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 
 /** Receive frames
  *
- * @param nic NIC data
+ * @param nic    NIC data
+ * @param budget Maximum number of frames to process
+ *
+ * @return Number of frames processed
  *
  */
-static void e1000_receive_frames(nic_t *nic)
+static size_t e1000_receive_frames(nic_t *nic, size_t budget)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+	size_t received = 0;
+
+	/* Hand the whole pass to the stack in one batch if possible */
+	nic_frame_list_t *frame_list = nic_alloc_frame_list();
 
 	fibril_mutex_lock(&e1000->rx_lock);
 
@@ -1182,13 +1215,16 @@ static void e1000_receive_frames(nic_t *nic)
 	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
 	    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
 
-	while (rx_descriptor->status & 0x01) {
+	while (received < budget && (rx_descriptor->status & 0x01)) {
 		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
 
 		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
 			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
-			nic_received_frame(nic, frame);
+			if (frame_list != NULL)
+				nic_frame_list_append(frame_list, frame);
+			else
+				nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
@@ -1200,9 +1236,16 @@ static void e1000_receive_frames(nic_t *nic)
 
 		rx_descriptor = (e1000_rx_descriptor_t *)
 		    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
+
+		received++;
 	}
 
 	fibril_mutex_unlock(&e1000->rx_lock);
+
+	if (frame_list != NULL)
+		nic_received_frame_list(nic, frame_list);
+
+	return received;
 }
 
 /** Enable E1000 interupts
@@ -1222,7 +1265,7 @@ static void e1000_enable_interrupts(e1000_t *e1000)
  */
 static void e1000_disable_interrupts(e1000_t *e1000)
 {
-	E1000_REG_WRITE(e1000, E1000_IMS, 0);
+	E1000_REG_WRITE(e1000, E1000_IMC, 0xffffffff);
 }
 
 /** Interrupt handler implementation
@@ -1236,11 +1279,84 @@ static void e1000_disable_interrupts(e1000_t *e1000)
  */
 static void e1000_interrupt_handler_impl(nic_t *nic, uint32_t icr)
 {
-	if (icr & ICR_RXT0)
-		e1000_receive_frames(nic);
+	if (icr & ICR_RXT0) {
+		while (e1000_receive_frames(nic, E1000_RX_BUDGET) ==
+		    E1000_RX_BUDGET)
+			;
+	}
+}
+
+/** RX poll fibril
+ *
+ * Processes the receive descriptor ring in passes of at most
+ * E1000_RX_BUDGET frames. Interrupts remain masked (the kernel IRQ
+ * code masks them before the interrupt is dispatched) for as long as
+ * the ring keeps yielding full passes, so under load the driver works
+ * in pure polling mode and interrupts are only re-enabled when the
+ * card goes idle.
+ *
+ * @param arg NIC data
+ *
+ * @return EOK (never returns unless asked to exit)
+ *
+ */
+static errno_t e1000_rx_fibril(void *arg)
+{
+	nic_t *nic = (nic_t *) arg;
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	fibril_mutex_lock(&e1000->rx_poll_lock);
+	while (true) {
+		while (!e1000->rx_poll_run && !e1000->rx_poll_exit)
+			fibril_condvar_wait(&e1000->rx_poll_cv,
+			    &e1000->rx_poll_lock);
+
+		if (e1000->rx_poll_exit)
+			break;
+
+		e1000->rx_poll_run = false;
+		fibril_mutex_unlock(&e1000->rx_poll_lock);
+
+		while (true) {
+			if (e1000_receive_frames(nic, E1000_RX_BUDGET) ==
+			    E1000_RX_BUDGET) {
+				/* Still under load, let others run */
+				fibril_yield();
+				continue;
+			}
+
+			/*
+			 * The ring is drained. Acknowledge stale causes
+			 * and unmask the interrupts again.
+			 */
+			(void) E1000_REG_READ(e1000, E1000_ICR);
+			e1000_enable_interrupts(e1000);
+
+			/*
+			 * Catch frames which arrived after the last pass
+			 * but before unmasking; their interrupt may have
+			 * been acknowledged above.
+			 */
+			if (e1000_receive_frames(nic, E1000_RX_BUDGET) == 0)
+				break;
+
+			e1000_disable_interrupts(e1000);
+		}
+
+		fibril_mutex_lock(&e1000->rx_poll_lock);
+	}
+
+	e1000->rx_poll_exited = true;
+	fibril_condvar_broadcast(&e1000->rx_poll_cv);
+	fibril_mutex_unlock(&e1000->rx_poll_lock);
+
+	return EOK;
 }
 
 /** Handle device interrupt
+ *
+ * Hands the actual RX ring processing off to the RX poll fibril.
+ * Interrupts stay masked until the fibril drains the ring.
  *
  * @param icall IPC call structure
  * @param dev   E1000 device
@@ -1253,8 +1369,13 @@ static void e1000_interrupt_handler(ipc_call_t *icall,
 	nic_t *nic = NIC_DATA_DEV(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	e1000_interrupt_handler_impl(nic, icr);
-	e1000_enable_interrupts(e1000);
+	if (icr & ICR_RXT0) {
+		fibril_mutex_lock(&e1000->rx_poll_lock);
+		e1000->rx_poll_run = true;
+		fibril_condvar_signal(&e1000->rx_poll_cv);
+		fibril_mutex_unlock(&e1000->rx_poll_lock);
+	} else
+		e1000_enable_interrupts(e1000);
 }
 
 /** Register interrupt handler for the card in the system
@@ -1909,6 +2030,16 @@ static e1000_t *e1000_create_dev_data(ddf_dev_t *dev)
 	fibril_mutex_initialize(&e1000->rx_lock);
 	fibril_mutex_initialize(&e1000->tx_lock);
 	fibril_mutex_initialize(&e1000->eeprom_lock);
+	fibril_mutex_initialize(&e1000->rx_poll_lock);
+	fibril_condvar_initialize(&e1000->rx_poll_cv);
+
+	e1000->rx_fibril = fibril_create(e1000_rx_fibril, nic);
+	if (e1000->rx_fibril == 0) {
+		nic_unbind_and_destroy(dev);
+		return NULL;
+	}
+
+	fibril_add_ready(e1000->rx_fibril);
 
 	return e1000;
 }
@@ -1922,8 +2053,23 @@ inline static void e1000_delete_dev_data(ddf_dev_t *dev)
 {
 	assert(dev);
 
-	if (ddf_dev_data_get(dev) != NULL)
-		nic_unbind_and_destroy(dev);
+	if (ddf_dev_data_get(dev) == NULL)
+		return;
+
+	e1000_t *e1000 = DRIVER_DATA_DEV(dev);
+
+	/* Wait for the RX poll fibril to exit */
+	if (e1000 != NULL && e1000->rx_fibril != 0) {
+		fibril_mutex_lock(&e1000->rx_poll_lock);
+		e1000->rx_poll_exit = true;
+		fibril_condvar_broadcast(&e1000->rx_poll_cv);
+		while (!e1000->rx_poll_exited)
+			fibril_condvar_wait(&e1000->rx_poll_cv,
+			    &e1000->rx_poll_lock);
+		fibril_mutex_unlock(&e1000->rx_poll_lock);
+	}
+
+	nic_unbind_and_destroy(dev);
 }
 
 /** Clean up the E1000 device structure.
@@ -747,7 +747,14 @@ static errno_t rtl8169_on_activated(nic_t *nic_data)
 	pio_write_32(rtl8169->regs + RCR, rcr);
 	pio_write_16(rtl8169->regs + RMS, BUFFER_SIZE);
 
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	/*
+	 * Transmit completions are harvested lazily on the next transmit,
+	 * so the per-frame TX OK interrupt stays masked. INT_TDU and
+	 * INT_TER remain enabled as a fallback so a drained or failed
+	 * queue is still reclaimed when nobody is transmitting.
+	 */
+	rtl8169->int_mask = INT_KNOWN & ~INT_TOK;
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 	/* XXX Check return value */
 	hw_res_enable_interrupt(rtl8169->parent_sess, rtl8169->irq);
 
@@ -941,35 +948,50 @@ static errno_t rtl8169_broadcast_set(nic_t *nic_data, nic_broadcast_mode_t mode)
 	return EOK;
 }
 
-static void rtl8169_transmit_done(ddf_dev_t *dev)
+/** Reclaim TX descriptors released by the hardware.
+ *
+ * Walks the TX ring from the tail and harvests descriptors whose OWN bit
+ * the NIC has cleared, stopping at the first one still being transmitted.
+ * Must be called with tx_lock held.
+ *
+ * @param rtl8169 RTL8169 private structure
+ * @return Number of descriptors reclaimed
+ */
+static int rtl8169_tx_reclaim(rtl8169_t *rtl8169)
 {
-	unsigned int tail, head;
-	nic_t *nic_data = nic_get_from_ddf_dev(dev);
-	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
 	rtl8169_descr_t *descr;
+	unsigned int tail = rtl8169->tx_tail;
 	int sent = 0;
 
-	ddf_msg(LVL_DEBUG, "rtl8169_transmit_done()");
-
-	fibril_mutex_lock(&rtl8169->tx_lock);
-
-	head = rtl8169->tx_head;
-	tail = rtl8169->tx_tail;
+	read_barrier();
 
-	while (tail != head) {
+	while (tail != rtl8169->tx_head) {
 		descr = &rtl8169->tx_ring[tail];
-		descr->control &= (~CONTROL_OWN);
-		write_barrier();
-		ddf_msg(LVL_DEBUG, "TX status for descr %d: 0x%08x", tail, descr->control);
+		if (descr->control & CONTROL_OWN)
+			break;
+
+		ddf_msg(LVL_DEBUG, "TX status for descr %d: 0x%08x", tail,
+		    descr->control);
 
 		tail = (tail + 1) % TX_BUFFERS_COUNT;
 		sent++;
 	}
 
-	if (sent != 0)
-		nic_set_tx_busy(nic_data, 0);
-
 	rtl8169->tx_tail = tail;
+	return sent;
+}
+
+static void rtl8169_transmit_done(ddf_dev_t *dev)
+{
+	nic_t *nic_data = nic_get_from_ddf_dev(dev);
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	ddf_msg(LVL_DEBUG, "rtl8169_transmit_done()");
+
+	fibril_mutex_lock(&rtl8169->tx_lock);
+
+	if (rtl8169_tx_reclaim(rtl8169) != 0)
+		nic_set_tx_busy(nic_data, 0);
 
 	fibril_mutex_unlock(&rtl8169->tx_lock);
 }
@@ -1042,7 +1064,7 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
 
 	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 
 	while (isr != 0) {
 		ddf_msg(LVL_DEBUG, "irq handler: remaining isr=0x%04x", isr);
@@ -1093,6 +1115,7 @@ static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
 		ddf_msg(LVL_ERROR, "Send frame: frame too long, %zu bytes",
 		    size);
 		nic_report_send_error(nic_data, NIC_SEC_OTHER, 1);
+		return;
 	}
 
 	fibril_mutex_lock(&rtl8169->tx_lock);
@@ -1100,13 +1123,25 @@ static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
 	ddf_msg(LVL_DEBUG, "send_frame: size: %zu, tx_head=%d tx_tail=%d",
 	    size, rtl8169->tx_head, rtl8169->tx_tail);
 
+	/* Lazily harvest descriptors the NIC has finished with */
+	if (rtl8169_tx_reclaim(rtl8169) != 0)
+		nic_set_tx_busy(nic_data, 0);
+
 	head = rtl8169->tx_head;
 	tail = rtl8169->tx_tail;
 
 	if ((head + 1) % TX_BUFFERS_COUNT == tail) {
-		/* Queue is full */
+		/*
+		 * Ring is full even after reclaim - drop the frame rather
+		 * than overwrite a descriptor still owned by the NIC.
+		 * INT_TDU will fire once the queue drains and clear the
+		 * busy flag.
+		 */
 		ddf_msg(LVL_WARN, "TX queue full!");
 		nic_set_tx_busy(nic_data, 1);
+		nic_report_send_error(nic_data, NIC_SEC_BUFFER_FULL, 1);
+		fibril_mutex_unlock(&rtl8169->tx_lock);
+		return;
 	}
 
 	/* Calculate address of next free buffer and descriptor */
@@ -197,7 +197,10 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	/* Reset the device and negotiate the feature bits */
 	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ,
+	    VIRTIO_NET_F_CSUM | VIRTIO_NET_F_GUEST_CSUM |
+	    VIRTIO_F_RING_EVENT_IDX,
+	    &virtio_net->features);
 	if (rc != EOK)
 		goto fail;
 
@@ -471,10 +474,61 @@ static errno_t virtio_net_get_operation_mode(ddf_fun_t *fun, int *speed,
 	return EOK;
 }
 
+static uint32_t virtio_net_offload_flags(virtio_net_t *virtio_net)
+{
+	uint32_t flags = 0;
+
+	if (virtio_net->features & VIRTIO_NET_F_CSUM)
+		flags |= NIC_OFFLOAD_TX_CHECKSUM;
+	if (virtio_net->features & VIRTIO_NET_F_GUEST_CSUM)
+		flags |= NIC_OFFLOAD_RX_CHECKSUM;
+
+	return flags;
+}
+
+static errno_t virtio_net_offload_probe(ddf_fun_t *fun, uint32_t *supported,
+    uint32_t *active)
+{
+	nic_t *nic = nic_get_from_ddf_fun(fun);
+	if (!nic)
+		return ENOENT;
+
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+
+	/*
+	 * The checksum offloads are negotiated with the device during
+	 * setup and cannot be toggled afterwards, so the supported
+	 * offloads are always active.
+	 */
+	*supported = virtio_net_offload_flags(virtio_net);
+	*active = *supported;
+
+	return EOK;
+}
+
+static errno_t virtio_net_offload_set(ddf_fun_t *fun, uint32_t mask,
+    uint32_t active)
+{
+	nic_t *nic = nic_get_from_ddf_fun(fun);
+	if (!nic)
+		return ENOENT;
+
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	uint32_t flags = virtio_net_offload_flags(virtio_net);
+
+	/* The negotiated offloads are fixed, only accept no-op requests */
+	if ((mask & ~flags) != 0 || (active & mask) != (flags & mask))
+		return ENOTSUP;
+
+	return EOK;
+}
+
 static nic_iface_t virtio_net_nic_iface = {
 	.get_device_info = virtio_net_get_device_info,
 	.get_cable_state = virtio_net_get_cable_state,
 	.get_operation_mode = virtio_net_get_operation_mode,
+	.offload_probe = virtio_net_offload_probe,
+	.offload_set = virtio_net_offload_set,
 };
 
 int main(void)
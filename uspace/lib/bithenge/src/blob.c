@@ -132,7 +132,7 @@ static errno_t sequential_read(bithenge_blob_t *base, aoff64_t offset,
 	}
 	if (offset > blob->data_size)
 		return EINVAL;
-	*size = min(*size, blob->data_size - end);
+	*size = min(*size, blob->data_size - offset);
 	memcpy(buffer, blob->buffer + offset, *size);
 	return EOK;
 }
@@ -45,11 +45,24 @@
 #include <bithenge/blob.h>
 #include <bithenge/file.h>
 
+/** Size of the cached read window. Must be a power of two. */
+#define FILE_BLOB_WINDOW_SIZE 32768
+
 typedef struct {
 	bithenge_blob_t base;
 	int fd;
 	aoff64_t size; // needed by file_read()
 	bool needs_close;
+
+	/*
+	 * Transforms typically read a few bytes at a time, which would
+	 * devolve into one VFS request per field. Instead, reads are
+	 * served from an aligned window that is filled with one large
+	 * request.
+	 */
+	char *window;
+	aoff64_t window_offset;
+	size_t window_size;
 } file_blob_t;
 
 static inline file_blob_t *blob_as_file(bithenge_blob_t *base)
@@ -69,6 +82,28 @@ static errno_t file_size(bithenge_blob_t *base, aoff64_t *size)
 	return EOK;
 }
 
+static errno_t file_fill_window(file_blob_t *blob, aoff64_t offset)
+{
+	if (!blob->window) {
+		blob->window = malloc(FILE_BLOB_WINDOW_SIZE);
+		if (!blob->window)
+			return ENOMEM;
+	}
+
+	aoff64_t window_offset = offset - offset % FILE_BLOB_WINDOW_SIZE;
+	aoff64_t pos = window_offset;
+	size_t amount_read;
+	errno_t rc = vfs_read(blob->fd, &pos, blob->window,
+	    FILE_BLOB_WINDOW_SIZE, &amount_read);
+	if (rc != EOK) {
+		blob->window_size = 0;
+		return rc;
+	}
+	blob->window_offset = window_offset;
+	blob->window_size = amount_read;
+	return EOK;
+}
+
 static errno_t file_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
     aoff64_t *size)
 {
@@ -76,17 +111,43 @@ static errno_t file_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	if (offset > blob->size)
 		return ELIMIT;
 
-	size_t amount_read;
-	errno_t rc = vfs_read(blob->fd, &offset, buffer, *size, &amount_read);
-	if (rc != EOK)
-		return errno;
-	*size += amount_read;
+	/* Large reads do not benefit from the window; issue them directly. */
+	if (*size >= FILE_BLOB_WINDOW_SIZE) {
+		size_t amount_read;
+		errno_t rc = vfs_read(blob->fd, &offset, buffer, *size,
+		    &amount_read);
+		if (rc != EOK)
+			return rc;
+		*size = amount_read;
+		return EOK;
+	}
+
+	aoff64_t total = 0;
+	while (total < *size) {
+		if (!blob->window || offset < blob->window_offset ||
+		    offset >= blob->window_offset + blob->window_size) {
+			errno_t rc = file_fill_window(blob, offset);
+			if (rc != EOK)
+				return total ? EOK : rc;
+			if (blob->window_size == 0 ||
+			    offset >= blob->window_offset + blob->window_size)
+				break; // end of file
+		}
+		size_t window_pos = offset - blob->window_offset;
+		size_t amount = min(*size - total,
+		    blob->window_size - window_pos);
+		memcpy(buffer + total, blob->window + window_pos, amount);
+		offset += amount;
+		total += amount;
+	}
+	*size = total;
 	return EOK;
 }
 
 static void file_destroy(bithenge_blob_t *base)
 {
 	file_blob_t *blob = blob_as_file(base);
+	free(blob->window);
 	vfs_put(blob->fd);
 	free(blob);
 }
@@ -130,6 +191,9 @@ static errno_t new_file_blob(bithenge_node_t **out, int fd, bool needs_close)
 	blob->size = stat.st_size;
 #endif
 	blob->needs_close = needs_close;
+	blob->window = NULL; // allocated on first small read
+	blob->window_offset = 0;
+	blob->window_size = 0;
 	*out = bithenge_blob_as_node(file_as_blob(blob));
 
 	return EOK;
@@ -54,6 +54,15 @@ typedef struct {
 	size_t num_ends;
 	bool end_on_empty;
 	bithenge_int_t num_xforms;
+
+	/*
+	 * Results of already-applied subtransforms, so repeated queries of
+	 * the same field don't reparse the blob. Only leaf nodes are kept;
+	 * internal nodes reference their scope, which references this node,
+	 * and caching them would create a reference cycle. Entries are only
+	 * valid below num_ends and may be NULL.
+	 */
+	bithenge_node_t **subnodes;
 } seq_node_t;
 
 typedef struct seq_node_ops {
@@ -126,6 +135,13 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 			if (!new_ends)
 				return ENOMEM;
 			self->ends = new_ends;
+			bithenge_node_t **new_subnodes =
+			    realloc(self->subnodes,
+			    (self->num_ends + 1) * sizeof(*new_subnodes));
+			if (!new_subnodes)
+				return ENOMEM;
+			new_subnodes[self->num_ends] = NULL;
+			self->subnodes = new_subnodes;
 		}
 
 		prev_offset = self->ends[self->num_ends] =
@@ -135,9 +151,27 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 	return EOK;
 }
 
+static void seq_node_cache_subnode(seq_node_t *self, bithenge_node_t *node,
+    size_t index)
+{
+	if (!self->subnodes || self->subnodes[index])
+		return;
+	if (bithenge_node_type(node) == BITHENGE_NODE_INTERNAL)
+		return; // would form a reference cycle through the scope
+	bithenge_node_inc_ref(node);
+	self->subnodes[index] = node;
+}
+
 static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
     size_t index)
 {
+	if (index < self->num_ends && self->subnodes &&
+	    self->subnodes[index]) {
+		bithenge_node_inc_ref(self->subnodes[index]);
+		*out = self->subnodes[index];
+		return EOK;
+	}
+
 	aoff64_t start_pos;
 	errno_t rc = seq_node_field_offset(self, &start_pos, index);
 	if (rc != EOK)
@@ -191,8 +225,16 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 			if (!new_ends)
 				return ENOMEM;
 			self->ends = new_ends;
+			bithenge_node_t **new_subnodes =
+			    realloc(self->subnodes,
+			    (self->num_ends + 1) * sizeof(*new_subnodes));
+			if (!new_subnodes)
+				return ENOMEM;
+			new_subnodes[self->num_ends] = NULL;
+			self->subnodes = new_subnodes;
 		}
 		self->ends[self->num_ends++] = start_pos + size;
+		seq_node_cache_subnode(self, *out, self->num_ends - 1);
 	} else {
 		aoff64_t end_pos;
 		errno_t rc = seq_node_field_offset(self, &end_pos, index + 1);
@@ -216,6 +258,7 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 		bithenge_transform_dec_ref(subxform);
 		if (rc != EOK)
 			return rc;
+		seq_node_cache_subnode(self, *out, index);
 	}
 
 	return EOK;
@@ -238,6 +281,13 @@ static void seq_node_destroy(seq_node_t *self)
 {
 	bithenge_scope_dec_ref(self->scope);
 	bithenge_blob_dec_ref(self->blob);
+	if (self->subnodes) {
+		for (size_t i = 0; i < self->num_ends; i++) {
+			if (self->subnodes[i])
+				bithenge_node_dec_ref(self->subnodes[i]);
+		}
+		free(self->subnodes);
+	}
 	free(self->ends);
 }
 
@@ -261,8 +311,15 @@ static errno_t seq_node_init(seq_node_t *self, const seq_node_ops_t *ops,
 		self->ends = malloc(sizeof(*self->ends) * num_xforms);
 		if (!self->ends)
 			return ENOMEM;
-	} else
+		self->subnodes = calloc(num_xforms, sizeof(*self->subnodes));
+		if (!self->subnodes) {
+			free(self->ends);
+			return ENOMEM;
+		}
+	} else {
 		self->ends = NULL;
+		self->subnodes = NULL;
+	}
 	bithenge_blob_inc_ref(blob);
 	self->blob = blob;
 	self->num_xforms = num_xforms;
@@ -43,8 +43,10 @@
 #include <as.h>
 #include <assert.h>
 #include <bd.h>
+#include <bd_sched.h>
 #include <fibril_synch.h>
 #include <adt/list.h>
+#include <adt/hash.h>
 #include <adt/hash_table.h>
 #include <macros.h>
 #include <mem.h>
@@ -58,20 +60,70 @@
 
 #define MAX_WRITE_RETRIES 10
 
+/** Default number of blocks read ahead after a sequential run is detected. */
+#define RA_BLOCKS_DEFAULT	8
+
+/** Number of consecutive sequential requests that trigger readahead. */
+#define RA_SEQ_THRESHOLD	2
+
+/** Period of the write-back flusher in microseconds. */
+#define FLUSH_PERIOD		1000000
+
+/** Number of independently locked cache segments; must be a power of two. */
+#define CACHE_SEGMENTS		4
+
+/** Maximum number of requests in flight per block device. */
+#define SCHED_QUEUE_DEPTH	4
+
 /** Lock protecting the device connection list */
 static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
 static LIST_INITIALIZE(dcl);
 
+/** Independently locked segment of the block cache.
+ *
+ * Blocks are distributed among the segments by their logical block address
+ * so that concurrent clients working on different blocks do not contend on
+ * a single lock.
+ */
 typedef struct {
 	fibril_mutex_t lock;
+	unsigned blocks_cached;   /**< Number of blocks cached in the segment. */
+	hash_table_t block_hash;
+	/** Clock of idle blocks, scanned for second-chance replacement. */
+	list_t free_list;
+	/** List of idle dirty blocks awaiting write-back. */
+	list_t dirty_list;
+} cache_seg_t;
+
+typedef struct {
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
 	unsigned block_count;     /**< Total number of blocks. */
-	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
-	list_t free_list;
 	enum cache_mode mode;
+	cache_seg_t seg[CACHE_SEGMENTS];
+
+	/** Lock protecting the worker and sequential detector state below. */
+	fibril_mutex_t worker_lock;
+	/** Signals pending work or shutdown to the worker fibril. */
+	fibril_condvar_t worker_cv;
+	/** Signals termination of the worker fibril. */
+	fibril_condvar_t worker_done_cv;
+	/** Set to terminate the worker fibril. */
+	bool shutdown;
+	/** True while the worker fibril is running. */
+	bool worker_active;
+
+	/** Number of blocks to read ahead; 0 disables readahead. */
+	unsigned ra_blocks;
+	/** Address of the most recently requested block. */
+	aoff64_t last_ba;
+	/** Length of the current sequential run of requests. */
+	unsigned seq_run;
+	/** First block of the pending readahead request. */
+	aoff64_t ra_pos;
+	/** Number of blocks in the pending readahead request. */
+	unsigned ra_cnt;
 } cache_t;
 
 typedef struct {
@@ -79,6 +131,7 @@ typedef struct {
 	service_id_t service_id;
 	async_sess_t *sess;
 	bd_t *bd;
+	bd_sched_t *sched;   /**< I/O scheduler on top of bd */
 	void *bb_buf;
 	aoff64_t bb_addr;
 	aoff64_t pblocks;    /**< Number of physical blocks */
@@ -89,6 +142,9 @@ typedef struct {
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static errno_t write_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static aoff64_t ba_ltop(devcon_t *, aoff64_t);
+static errno_t _block_get(block_t **, devcon_t *, aoff64_t, int, bool);
+static void cache_flush_seg(devcon_t *, cache_t *, cache_seg_t *);
+static errno_t cache_worker(void *);
 
 static devcon_t *devcon_search(service_id_t service_id)
 {
@@ -106,7 +162,7 @@ static devcon_t *devcon_search(service_id_t service_id)
 }
 
 static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
-    size_t bsize, aoff64_t dev_size, bd_t *bd)
+    size_t bsize, aoff64_t dev_size, bd_t *bd, bd_sched_t *sched)
 {
 	devcon_t *devcon;
 
@@ -118,6 +174,7 @@ static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
 	devcon->service_id = service_id;
 	devcon->sess = sess;
 	devcon->bd = bd;
+	devcon->sched = sched;
 	devcon->bb_buf = NULL;
 	devcon->bb_addr = 0;
 	devcon->pblock_size = bsize;
@@ -176,8 +233,18 @@ errno_t block_init(service_id_t service_id, size_t comm_size)
 		return rc;
 	}
 
-	rc = devcon_add(service_id, sess, bsize, dev_size, bd);
+	bd_sched_t *sched;
+	rc = bd_sched_create(bd, bd_sched_merge, SCHED_QUEUE_DEPTH, bsize,
+	    &sched);
+	if (rc != EOK) {
+		bd_close(bd);
+		async_hangup(sess);
+		return rc;
+	}
+
+	rc = devcon_add(service_id, sess, bsize, dev_size, bd, sched);
 	if (rc != EOK) {
+		bd_sched_destroy(sched);
 		bd_close(bd);
 		async_hangup(sess);
 		return rc;
@@ -194,13 +261,14 @@ void block_fini(service_id_t service_id)
 	if (devcon->cache)
 		(void) block_cache_fini(service_id);
 
-	(void)bd_sync_cache(devcon->bd, 0, 0);
+	(void)bd_sched_sync_cache(devcon->sched, 0, 0);
 
 	devcon_remove(devcon);
 
 	if (devcon->bb_buf)
 		free(devcon->bb_buf);
 
+	bd_sched_destroy(devcon->sched);
 	bd_close(devcon->bd);
 	async_hangup(devcon->sess);
 
@@ -267,6 +335,12 @@ static hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Map a logical block address to its cache segment. */
+static cache_seg_t *cache_seg_get(cache_t *cache, aoff64_t ba)
+{
+	return &cache->seg[hash_mix(ba) & (CACHE_SEGMENTS - 1)];
+}
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
@@ -280,13 +354,20 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	if (!cache)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&cache->lock);
-	list_initialize(&cache->free_list);
 	cache->lblock_size = size;
 	cache->block_count = blocks;
-	cache->blocks_cached = 0;
 	cache->mode = mode;
 
+	fibril_mutex_initialize(&cache->worker_lock);
+	fibril_condvar_initialize(&cache->worker_cv);
+	fibril_condvar_initialize(&cache->worker_done_cv);
+	cache->shutdown = false;
+	cache->worker_active = false;
+	cache->ra_blocks = RA_BLOCKS_DEFAULT;
+	cache->last_ba = (aoff64_t) -2;
+	cache->seq_run = 0;
+	cache->ra_cnt = 0;
+
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
 		free(cache);
@@ -295,12 +376,40 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
 
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
+	for (unsigned i = 0; i < CACHE_SEGMENTS; i++) {
+		cache_seg_t *seg = &cache->seg[i];
+
+		fibril_mutex_initialize(&seg->lock);
+		list_initialize(&seg->free_list);
+		list_initialize(&seg->dirty_list);
+		seg->blocks_cached = 0;
+
+		if (!hash_table_create(&seg->block_hash, 0, 0, &cache_ops)) {
+			while (i > 0)
+				hash_table_destroy(&cache->seg[--i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
+	}
+
+	devcon->cache = cache;
+
+	/*
+	 * Start the worker fibril performing asynchronous readahead and
+	 * write-back of dirty blocks.
+	 */
+	fid_t fid = fibril_create(cache_worker, devcon);
+	if (fid == 0) {
+		devcon->cache = NULL;
+		for (unsigned i = 0; i < CACHE_SEGMENTS; i++)
+			hash_table_destroy(&cache->seg[i].block_hash);
 		free(cache);
 		return ENOMEM;
 	}
 
-	devcon->cache = cache;
+	cache->worker_active = true;
+	fibril_add_ready(fid);
+
 	return EOK;
 }
 
@@ -316,43 +425,60 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	/*
+	 * Terminate the worker fibril before tearing the cache down.
+	 */
+	fibril_mutex_lock(&cache->worker_lock);
+	cache->shutdown = true;
+	fibril_condvar_broadcast(&cache->worker_cv);
+	while (cache->worker_active)
+		fibril_condvar_wait(&cache->worker_done_cv, &cache->worker_lock);
+	fibril_mutex_unlock(&cache->worker_lock);
+
 	/*
 	 * We are expecting to find all blocks for this device handle on the
-	 * free list, i.e. the block reference count should be zero. Do not
+	 * free lists, i.e. the block reference count should be zero. Do not
 	 * bother with the cache and block locks because we are single-threaded.
 	 */
-	while (!list_empty(&cache->free_list)) {
-		block_t *b = list_get_instance(list_first(&cache->free_list),
-		    block_t, free_link);
-
-		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
+	for (unsigned i = 0; i < CACHE_SEGMENTS; i++) {
+		cache_seg_t *seg = &cache->seg[i];
+
+		while (!list_empty(&seg->free_list)) {
+			block_t *b = list_get_instance(list_first(&seg->free_list),
+			    block_t, free_link);
+
+			list_remove(&b->free_link);
+			if (b->dirty) {
+				list_remove(&b->dirty_link);
+				rc = write_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data, b->size);
+				if (rc != EOK)
+					return rc;
+			}
 
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			hash_table_remove_item(&seg->block_hash, &b->hash_link);
 
-		free(b->data);
-		free(b);
+			free(b->data);
+			free(b);
+		}
+
+		hash_table_destroy(&seg->block_hash);
 	}
 
-	hash_table_destroy(&cache->block_hash);
 	devcon->cache = NULL;
 	free(cache);
 
 	return EOK;
 }
 
+/* The watermarks apply to each cache segment separately. */
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
-static bool cache_can_grow(cache_t *cache)
+static bool cache_can_grow(cache_seg_t *seg)
 {
-	if (cache->blocks_cached < CACHE_LO_WATERMARK)
+	if (seg->blocks_cached < CACHE_LO_WATERMARK)
 		return true;
-	if (!list_empty(&cache->free_list))
+	if (!list_empty(&seg->free_list))
 		return false;
 	return true;
 }
@@ -364,8 +490,31 @@ static void block_initialize(block_t *b)
 	b->write_failures = 0;
 	b->dirty = false;
 	b->toxic = false;
+	b->accessed = false;
 	fibril_rwlock_initialize(&b->contents_lock);
 	link_initialize(&b->free_link);
+	link_initialize(&b->dirty_link);
+}
+
+/** Update the sequential access detector and schedule readahead.
+ *
+ * Must be called with the worker lock held.
+ *
+ * @param cache	Block cache.
+ * @param ba	Block address (logical) of the current request.
+ */
+static void cache_seq_update(cache_t *cache, aoff64_t ba)
+{
+	if ((cache->ra_blocks > 0) && (ba == cache->last_ba + 1)) {
+		if (++cache->seq_run >= RA_SEQ_THRESHOLD) {
+			cache->ra_pos = ba + 1;
+			cache->ra_cnt = cache->ra_blocks;
+			fibril_condvar_signal(&cache->worker_cv);
+		}
+	} else
+		cache->seq_run = 0;
+
+	cache->last_ba = ba;
 }
 
 /** Instantiate a block in memory and get a reference to it.
@@ -382,19 +531,37 @@ static void block_initialize(block_t *b)
  */
 errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int flags)
 {
-	devcon_t *devcon;
+	devcon_t *devcon = devcon_search(service_id);
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	return _block_get(block, devcon, ba, flags, false);
+}
+
+/** Implementation of block_get().
+ *
+ * @param readahead	True when called from the cache worker fibril; such
+ *			requests do not feed the sequential access detector.
+ */
+static errno_t _block_get(block_t **block, devcon_t *devcon, aoff64_t ba,
+    int flags, bool readahead)
+{
 	cache_t *cache;
+	cache_seg_t *seg;
 	block_t *b;
 	link_t *link;
 	aoff64_t p_ba;
 	errno_t rc;
 
-	devcon = devcon_search(service_id);
-
-	assert(devcon);
-	assert(devcon->cache);
-
 	cache = devcon->cache;
+	seg = cache_seg_get(cache, ba);
+
+	if (!readahead) {
+		fibril_mutex_lock(&cache->worker_lock);
+		cache_seq_update(cache, ba);
+		fibril_mutex_unlock(&cache->worker_lock);
+	}
 
 	/*
 	 * Check whether the logical block (or part of it) is beyond
@@ -411,8 +578,8 @@ retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&seg->lock);
+	ht_link_t *hlink = hash_table_find(&seg->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -420,17 +587,20 @@ retry:
 		 */
 		b = hash_table_get_inst(hlink, block_t, hash_link);
 		fibril_mutex_lock(&b->lock);
-		if (b->refcnt++ == 0)
+		if (b->refcnt++ == 0) {
 			list_remove(&b->free_link);
+			/* In-use blocks are written back when put. */
+			list_remove(&b->dirty_link);
+		}
 		if (b->toxic)
 			rc = EIO;
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&seg->lock);
 	} else {
 		/*
 		 * The block was not found in the cache.
 		 */
-		if (cache_can_grow(cache)) {
+		if (cache_can_grow(seg)) {
 			/*
 			 * We can grow the cache by allocating new blocks.
 			 * Should the allocation fail, we fail over and try to
@@ -445,19 +615,35 @@ retry:
 				b = NULL;
 				goto recycle;
 			}
-			cache->blocks_cached++;
+			seg->blocks_cached++;
 		} else {
 			/*
 			 * Try to recycle a block from the free list.
 			 */
 		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
+			if (list_empty(&seg->free_list)) {
+				fibril_mutex_unlock(&seg->lock);
 				rc = ENOMEM;
 				goto out;
 			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
+
+			/*
+			 * Pick the replacement victim in a CLOCK-like
+			 * fashion: idle blocks that were referenced since
+			 * they were freed get a second chance and go to the
+			 * back of the list with their reference bit cleared.
+			 * The scan is bounded because nobody can set the bits
+			 * while we hold the segment lock.
+			 */
+			while (true) {
+				link = list_first(&seg->free_list);
+				b = list_get_instance(link, block_t, free_link);
+				if (!b->accessed)
+					break;
+				b->accessed = false;
+				list_remove(&b->free_link);
+				list_append(&b->free_link, &seg->free_list);
+			}
 
 			fibril_mutex_lock(&b->lock);
 			if (b->dirty) {
@@ -471,8 +657,9 @@ retry:
 				 * block_get() draining the free list.
 				 */
 				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
+				list_append(&b->free_link, &seg->free_list);
+				list_remove(&b->dirty_link);
+				fibril_mutex_unlock(&seg->lock);
 				rc = write_blocks(devcon, b->pba,
 				    cache->blocks_cluster, b->data, b->size);
 				if (rc != EOK) {
@@ -496,7 +683,7 @@ retry:
 					b->write_failures = 0;
 
 				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
+				if (!fibril_mutex_trylock(&seg->lock)) {
 					/*
 					 * Somebody is probably racing with us.
 					 * Unlock the block and retry.
@@ -504,7 +691,7 @@ retry:
 					fibril_mutex_unlock(&b->lock);
 					goto retry;
 				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
+				hlink = hash_table_find(&seg->block_hash, &ba);
 				if (hlink) {
 					/*
 					 * Someone else must have already
@@ -527,23 +714,23 @@ retry:
 			 * table.
 			 */
 			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			hash_table_remove_item(&seg->block_hash, &b->hash_link);
 		}
 
 		block_initialize(b);
-		b->service_id = service_id;
+		b->service_id = devcon->service_id;
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		hash_table_insert(&seg->block_hash, &b->hash_link);
 
 		/*
-		 * Lock the block before releasing the cache lock. Thus we don't
-		 * kill concurrent operations on the cache while doing I/O on
-		 * the block.
+		 * Lock the block before releasing the segment lock. Thus we
+		 * don't kill concurrent operations on the cache while doing
+		 * I/O on the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&seg->lock);
 
 		if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
@@ -581,6 +768,7 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
+	cache_seg_t *seg;
 	unsigned blocks_cached;
 	enum cache_mode mode;
 	errno_t rc = EOK;
@@ -590,12 +778,13 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	seg = cache_seg_get(cache, block->lba);
 
 retry:
-	fibril_mutex_lock(&cache->lock);
-	blocks_cached = cache->blocks_cached;
+	fibril_mutex_lock(&seg->lock);
+	blocks_cached = seg->blocks_cached;
 	mode = cache->mode;
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&seg->lock);
 
 	/*
 	 * Determine whether to sync the block. Syncing the block is best done
@@ -617,7 +806,7 @@ retry:
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&seg->lock);
 	fibril_mutex_lock(&block->lock);
 	if (!--block->refcnt) {
 		/*
@@ -625,7 +814,7 @@ retry:
 		 * block or put it on the free list. In case of an I/O error,
 		 * free the block.
 		 */
-		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
+		if ((seg->blocks_cached > CACHE_HI_WATERMARK) ||
 		    (rc != EOK)) {
 			/*
 			 * Currently there are too many cached blocks or there
@@ -642,7 +831,7 @@ retry:
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
 					fibril_mutex_unlock(&block->lock);
-					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&seg->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -654,12 +843,12 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			hash_table_remove_item(&seg->block_hash, &block->hash_link);
 			fibril_mutex_unlock(&block->lock);
 			free(block->data);
 			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
+			seg->blocks_cached--;
+			fibril_mutex_unlock(&seg->lock);
 			return rc;
 		}
 		/*
@@ -667,22 +856,170 @@ retry:
 		 */
 		if (cache->mode != CACHE_MODE_WB && block->dirty) {
 			/*
-			 * We cannot sync the block while holding the cache
+			 * We cannot sync the block while holding the segment
 			 * lock. Release everything and retry.
 			 */
 			block->refcnt++;
 			fibril_mutex_unlock(&block->lock);
-			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&seg->lock);
 			goto retry;
 		}
-		list_append(&block->free_link, &cache->free_list);
+		block->accessed = true;
+		list_append(&block->free_link, &seg->free_list);
+		if (block->dirty) {
+			/*
+			 * Hand the idle dirty block over to the worker fibril
+			 * for asynchronous write-back.
+			 */
+			list_append(&block->dirty_link, &seg->dirty_list);
+			fibril_condvar_signal(&cache->worker_cv);
+		}
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&seg->lock);
 
 	return rc;
 }
 
+/** Write back all idle dirty blocks of a cache segment.
+ *
+ * Must be called with the segment lock held. The lock is dropped while the
+ * blocks are being written to the device.
+ *
+ * @param devcon	Device connection.
+ * @param cache		Block cache.
+ * @param seg		Cache segment to flush.
+ */
+static void cache_flush_seg(devcon_t *devcon, cache_t *cache, cache_seg_t *seg)
+{
+	while (!list_empty(&seg->dirty_list)) {
+		block_t *b = list_get_instance(list_first(&seg->dirty_list),
+		    block_t, dirty_link);
+		errno_t rc;
+
+		fibril_mutex_lock(&b->lock);
+		list_remove(&b->dirty_link);
+		if (!b->dirty || b->refcnt > 0) {
+			/*
+			 * The block was grabbed or synced by somebody else
+			 * after it was put on the dirty list.
+			 */
+			fibril_mutex_unlock(&b->lock);
+			continue;
+		}
+		fibril_mutex_unlock(&seg->lock);
+
+		rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
+		    b->data, b->size);
+		if (rc == EOK) {
+			b->write_failures = 0;
+			b->dirty = false;
+		} else if (b->write_failures < MAX_WRITE_RETRIES) {
+			/*
+			 * Leave the block dirty. It will be retried when it
+			 * gets recycled or when the cache is torn down.
+			 */
+			b->write_failures++;
+		} else {
+			printf("Too many errors writing block %"
+			    PRIuOFF64 "from device handle %" PRIun "\n"
+			    "SEVERE DATA LOSS POSSIBLE\n",
+			    b->lba, devcon->service_id);
+			b->dirty = false;
+		}
+
+		fibril_mutex_unlock(&b->lock);
+		fibril_mutex_lock(&seg->lock);
+	}
+}
+
+/** Cache worker fibril.
+ *
+ * Performs asynchronous readahead scheduled by the sequential access detector
+ * and periodic write-back of idle dirty blocks.
+ *
+ * @param arg	Device connection.
+ *
+ * @return	EOK.
+ */
+static errno_t cache_worker(void *arg)
+{
+	devcon_t *devcon = (devcon_t *) arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->worker_lock);
+	while (!cache->shutdown) {
+		if (cache->ra_cnt > 0) {
+			aoff64_t pos = cache->ra_pos;
+			unsigned cnt = cache->ra_cnt;
+			unsigned i;
+
+			cache->ra_cnt = 0;
+			fibril_mutex_unlock(&cache->worker_lock);
+
+			/*
+			 * Populate the cache with the blocks the client is
+			 * likely to ask for next. The extra references are
+			 * dropped right away; the blocks stay on the free
+			 * list until they are either requested or recycled.
+			 */
+			for (i = 0; i < cnt; i++) {
+				block_t *b;
+
+				if (_block_get(&b, devcon, pos + i,
+				    BLOCK_FLAGS_NONE, true) != EOK)
+					break;
+				block_put(b);
+			}
+
+			fibril_mutex_lock(&cache->worker_lock);
+			continue;
+		}
+
+		fibril_mutex_unlock(&cache->worker_lock);
+		for (unsigned i = 0; i < CACHE_SEGMENTS; i++) {
+			cache_seg_t *seg = &cache->seg[i];
+
+			fibril_mutex_lock(&seg->lock);
+			cache_flush_seg(devcon, cache, seg);
+			fibril_mutex_unlock(&seg->lock);
+		}
+		fibril_mutex_lock(&cache->worker_lock);
+
+		if (cache->shutdown)
+			break;
+		fibril_condvar_wait_timeout(&cache->worker_cv,
+		    &cache->worker_lock, FLUSH_PERIOD);
+	}
+
+	cache->worker_active = false;
+	fibril_condvar_broadcast(&cache->worker_done_cv);
+	fibril_mutex_unlock(&cache->worker_lock);
+
+	return EOK;
+}
+
+/** Set the readahead length for a cached block device.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param nblocks	Number of blocks to read ahead; 0 disables readahead.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_cache_set_readahead(service_id_t service_id, unsigned nblocks)
+{
+	devcon_t *devcon = devcon_search(service_id);
+
+	if (!devcon || !devcon->cache)
+		return ENOENT;
+
+	fibril_mutex_lock(&devcon->cache->worker_lock);
+	devcon->cache->ra_blocks = nblocks;
+	fibril_mutex_unlock(&devcon->cache->worker_lock);
+
+	return EOK;
+}
+
 /** Read sequential data from a block device.
  *
  * @param service_id	Service ID of the block device.
@@ -802,7 +1139,21 @@ errno_t block_sync_cache(service_id_t service_id, aoff64_t ba, size_t cnt)
 	devcon = devcon_search(service_id);
 	assert(devcon);
 
-	return bd_sync_cache(devcon->bd, ba, cnt);
+	if (devcon->cache) {
+		/*
+		 * Write back the idle dirty blocks before issuing the barrier
+		 * so that it covers them too.
+		 */
+		for (unsigned i = 0; i < CACHE_SEGMENTS; i++) {
+			cache_seg_t *seg = &devcon->cache->seg[i];
+
+			fibril_mutex_lock(&seg->lock);
+			cache_flush_seg(devcon, devcon->cache, seg);
+			fibril_mutex_unlock(&seg->lock);
+		}
+	}
+
+	return bd_sched_sync_cache(devcon->sched, ba, cnt);
 }
 
 /** Get device block size.
@@ -921,7 +1272,7 @@ static errno_t read_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *buf,
 {
 	assert(devcon);
 
-	errno_t rc = bd_read_blocks(devcon->bd, ba, cnt, buf, size);
+	errno_t rc = bd_sched_read_blocks(devcon->sched, ba, cnt, buf, size);
 	if (rc != EOK) {
 		printf("Error %s reading %zu blocks starting at block %" PRIuOFF64
 		    " from device handle %" PRIun "\n", str_error_name(rc), cnt, ba,
@@ -948,7 +1299,7 @@ static errno_t write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *dat
 {
 	assert(devcon);
 
-	errno_t rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
+	errno_t rc = bd_sched_write_blocks(devcon->sched, ba, cnt, data, size);
 	if (rc != EOK) {
 		printf("Error %s writing %zu blocks starting at block %" PRIuOFF64
 		    " to device handle %" PRIun "\n", str_error_name(rc), cnt, ba, devcon->service_id);
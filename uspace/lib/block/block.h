@@ -70,6 +70,8 @@ typedef struct block {
 	bool dirty;
 	/** If true, the blcok does not contain valid data. */
 	bool toxic;
+	/** Reference bit of the second-chance replacement policy. */
+	bool accessed;
 	/** Readers / Writer lock protecting the contents of the block. */
 	fibril_rwlock_t contents_lock;
 	/** Service ID of service providing the block device. */
@@ -84,6 +86,8 @@ typedef struct block {
 	int write_failures;
 	/** Link for placing the block into the free block list. */
 	link_t free_link;
+	/** Link for placing the block into the dirty block list. */
+	link_t dirty_link;
 	/** Link for placing the block into the block hash table. */
 	ht_link_t hash_link;
 	/** Buffer with the block data. */
@@ -106,6 +110,7 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_set_readahead(service_id_t, unsigned);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
@@ -44,9 +44,46 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/rtld_arch.h>
 
+/** Binding trampoline entry point (bind.S) */
+extern void __rtld_bind_start(void);
+
+/** Set up the module's PLT for lazy binding.
+ *
+ * GOT[1] and GOT[2] are reserved for the dynamic linker: GOT[1] is
+ * set to the module and GOT[2] to the binding trampoline, which the
+ * first PLT entry jumps to with the relocation index on the stack.
+ * The remaining GOT entries initially hold the link-time addresses
+ * of the push stubs in their PLT entries, so they only need to be
+ * adjusted by the load bias.
+ */
 void module_process_pre_arch(module_t *m)
 {
-	/* Unused */
+	elf_rela_t *rt;
+	size_t rt_entries;
+	uintptr_t *got;
+	uintptr_t *r_ptr;
+	size_t i;
+
+	if (m->dyn.plt_got == NULL || m->dyn.jmp_rel == NULL ||
+	    m->dyn.plt_rel != DT_RELA || m->dyn.bind_now)
+		return;
+
+	got = (uintptr_t *) m->dyn.plt_got;
+	got[1] = (uintptr_t) m;
+	got[2] = (uintptr_t) __rtld_bind_start;
+
+	rt = m->dyn.jmp_rel;
+	rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF64_R_TYPE(rt[i].r_info) != R_X86_64_JUMP_SLOT)
+			continue;
+
+		r_ptr = (uintptr_t *) (rt[i].r_offset + m->bias);
+		*r_ptr += m->bias;
+	}
+
+	m->lazy_plt = true;
 }
 
 /**
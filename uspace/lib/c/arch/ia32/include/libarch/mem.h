@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Martin Decky
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcia32
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_ia32_MEM_H_
+#define _LIBC_ia32_MEM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The architecture can use the SSE2 block memory routines. */
+#define MEM_ARCH_SSE2
+
+/*
+ * The ia32 code generation does not assume SSE2, the routines
+ * using the XMM registers need to enable it explicitly.
+ */
+#define MEM_ARCH_SSE2_ATTR  __attribute__((target("sse2")))
+
+/** Check whether the SSE2 block memory routines may be used.
+ *
+ * SSE2 is optional on ia32, probe for it using CPUID. The CPUID
+ * instruction itself is detected first by toggling the ID bit
+ * in EFLAGS.
+ *
+ */
+static inline bool mem_arch_sse2_supported(void)
+{
+	uint32_t orig;
+	uint32_t changed;
+
+	asm volatile (
+	    "pushfl\n"
+	    "popl %[orig]\n"
+	    "movl %[orig], %%eax\n"
+	    "xorl %[mask], %%eax\n"
+	    "pushl %%eax\n"
+	    "popfl\n"
+	    "pushfl\n"
+	    "popl %[changed]\n"
+	    "pushl %[orig]\n"
+	    "popfl\n"
+	    : [orig] "=&r" (orig), [changed] "=&r" (changed)
+	    : [mask] "i" (1 << 21)
+	    : "eax"
+	);
+
+	if (((orig ^ changed) & (1 << 21)) == 0)
+		return false;
+
+	uint32_t edx;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "=d" (edx)
+	    : "a" (1)
+	    : "ebx", "ecx"
+	);
+
+	return ((edx & (1 << 26)) != 0);
+}
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,719 @@
+/*
+ * Copyright (c) 2008 Jakub Jermar
+ * Copyright (c) 2012 Adam Hraska
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * This is a concurrent variant of the generic resizable chained hash
+ * table, intended for multithreaded servers that would otherwise wrap
+ * hash_table_t in a single big mutex.
+ *
+ * The table is divided into CHASH_TABLE_STRIPES stripes, each with
+ * its own fibril mutex. The bucket count is always a power-of-two
+ * multiple of the stripe count, so an item with hash h belongs to
+ * stripe h % CHASH_TABLE_STRIPES no matter how many buckets the table
+ * currently has. A single-key operation therefore takes exactly one
+ * stripe lock and runs in parallel with operations on other stripes.
+ *
+ * Resizing is incremental. When a stripe notices it has become
+ * overfull (or mostly empty), a new bucket array is published next to
+ * the old one. Each stripe's items are moved to the new array lazily,
+ * by whichever fibril next locks the stripe; since old and new bucket
+ * indices of an item agree modulo the stripe count, a stripe can be
+ * migrated while holding only its own lock. The old array is freed
+ * once the last stripe has been migrated. An operation thus never
+ * pays more than the cost of rehashing its own stripe.
+ *
+ * Whole-table operations (clear, apply, size) lock all stripes and
+ * complete any pending migration first; they are no more scalable
+ * than with hash_table_t, but are expected to be rare.
+ */
+
+#include <adt/chash_table.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <member.h>
+#include <stdlib.h>
+
+/* Minimum bucket count; a power-of-two multiple of the stripe count. */
+#define CHT_MIN_BUCKETS  128
+/* The table is resized when the average load per bucket exceeds this number. */
+#define CHT_MAX_LOAD     2
+
+static size_t round_up_size(size_t);
+static bool alloc_buckets(size_t, list_t **);
+static void clear_items(chash_table_t *);
+static void migrate_stripe(chash_table_t *, size_t);
+static bool catch_up_stripe(chash_table_t *, size_t);
+static void note_migrated(chash_table_t *, size_t);
+static void finish_resize(chash_table_t *);
+static void start_resize(chash_table_t *, bool);
+static void lock_all(chash_table_t *);
+static void unlock_all(chash_table_t *);
+
+/* Dummy do nothing callback to invoke in place of remove_callback == NULL. */
+static void nop_remove_callback(ht_link_t *item)
+{
+	/* no-op */
+}
+
+/** Stripe an item with the given hash belongs to.
+ *
+ * Stable across resizes because the bucket count is kept a multiple
+ * of the stripe count.
+ */
+static inline size_t stripe_idx(size_t hash)
+{
+	return hash & (CHASH_TABLE_STRIPES - 1);
+}
+
+/** Bucket count items of a caught-up stripe are hashed into. */
+static inline size_t effective_bucket_cnt(chash_table_t *h)
+{
+	return (h->new_bucket != NULL) ? h->new_bucket_cnt : h->bucket_cnt;
+}
+
+/** Bucket the given hash falls into.
+ *
+ * Only valid while holding the hash's stripe lock and after the
+ * stripe has caught up with any pending migration.
+ */
+static inline list_t *hash_bucket(chash_table_t *h, size_t hash)
+{
+	if (h->new_bucket != NULL)
+		return &h->new_bucket[hash & (h->new_bucket_cnt - 1)];
+
+	return &h->bucket[hash & (h->bucket_cnt - 1)];
+}
+
+/** True if the stripe exceeds the maximum allowed load. */
+static inline bool stripe_overfull(chash_table_t *h, size_t stripe)
+{
+	size_t full_stripe_cnt = h->max_load *
+	    (effective_bucket_cnt(h) / CHASH_TABLE_STRIPES);
+
+	return full_stripe_cnt < h->stripe_items[stripe];
+}
+
+/** True if the stripe is only sparsely populated. */
+static inline bool stripe_underfull(chash_table_t *h, size_t stripe)
+{
+	size_t full_stripe_cnt = h->max_load *
+	    (effective_bucket_cnt(h) / CHASH_TABLE_STRIPES);
+
+	return (h->stripe_items[stripe] <= full_stripe_cnt / 4) &&
+	    (CHT_MIN_BUCKETS < effective_bucket_cnt(h));
+}
+
+/** Create concurrent chained hash table.
+ *
+ * @param h        Hash table structure. Will be initialized by this call.
+ * @param init_size Initial desired number of hash table buckets. Pass zero
+ *                 if you want the default initial size.
+ * @param max_load The table is resized when the average load per bucket
+ *                 exceeds this number. Pass zero if you want the default.
+ * @param op       Hash table operations structure. remove_callback()
+ *                 is optional and can be NULL if no action is to be taken
+ *                 upon removal. equal() is optional if and only if
+ *                 chash_table_insert_unique() will never be invoked.
+ *                 All other operations are mandatory.
+ *
+ * @return True on success
+ *
+ */
+bool chash_table_create(chash_table_t *h, size_t init_size, size_t max_load,
+    hash_table_ops_t *op)
+{
+	assert(h);
+	assert(op && op->hash && op->key_hash && op->key_equal);
+
+	/* Check for compulsory ops. */
+	if (!op || !op->hash || !op->key_hash || !op->key_equal)
+		return false;
+
+	h->bucket_cnt = round_up_size(init_size);
+
+	if (!alloc_buckets(h->bucket_cnt, &h->bucket))
+		return false;
+
+	h->max_load = (max_load == 0) ? CHT_MAX_LOAD : max_load;
+	h->op = op;
+	h->new_bucket = NULL;
+	h->new_bucket_cnt = 0;
+	h->resize_gen = 0;
+	h->migrated_cnt = 0;
+
+	fibril_mutex_initialize(&h->resize_lock);
+
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s) {
+		fibril_mutex_initialize(&h->stripe_lock[s]);
+		h->stripe_items[s] = 0;
+		h->stripe_migrated[s] = false;
+	}
+
+	if (h->op->remove_callback == NULL) {
+		h->op->remove_callback = nop_remove_callback;
+	}
+
+	return true;
+}
+
+/** Destroy a hash table instance.
+ *
+ * There must be no concurrent users of the table.
+ *
+ * @param h Hash table to be destroyed.
+ *
+ */
+void chash_table_destroy(chash_table_t *h)
+{
+	assert(h && h->bucket);
+
+	lock_all(h);
+
+	clear_items(h);
+
+	free(h->bucket);
+	h->bucket = NULL;
+	h->bucket_cnt = 0;
+
+	unlock_all(h);
+}
+
+/** Returns true if there are no items in the table. */
+bool chash_table_empty(chash_table_t *h)
+{
+	assert(h && h->bucket);
+
+	return chash_table_size(h) == 0;
+}
+
+/** Returns the number of items in the table. */
+size_t chash_table_size(chash_table_t *h)
+{
+	assert(h && h->bucket);
+
+	size_t cnt = 0;
+
+	lock_all(h);
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		cnt += h->stripe_items[s];
+	unlock_all(h);
+
+	return cnt;
+}
+
+/** Remove all elements from the hash table
+ *
+ * @param h Hash table to be cleared
+ */
+void chash_table_clear(chash_table_t *h)
+{
+	assert(h && h->bucket);
+
+	lock_all(h);
+
+	clear_items(h);
+
+	/* Shrink the table to its minimum size if possible. */
+	if (CHT_MIN_BUCKETS < h->bucket_cnt) {
+		list_t *new_buckets;
+		if (alloc_buckets(CHT_MIN_BUCKETS, &new_buckets)) {
+			free(h->bucket);
+			h->bucket = new_buckets;
+			h->bucket_cnt = CHT_MIN_BUCKETS;
+		}
+	}
+
+	unlock_all(h);
+}
+
+/** Unlinks and removes all items but does not resize.
+ *
+ * Expects all stripe locks to be held and no resize in progress.
+ */
+static void clear_items(chash_table_t *h)
+{
+	assert(h->new_bucket == NULL);
+
+	for (size_t idx = 0; idx < h->bucket_cnt; ++idx) {
+		list_foreach_safe(h->bucket[idx], cur, next) {
+			assert(cur);
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+			list_remove(cur);
+			h->op->remove_callback(cur_link);
+		}
+	}
+
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		h->stripe_items[s] = 0;
+}
+
+/** Insert item into a hash table.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ */
+void chash_table_insert(chash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->bucket);
+
+	size_t hash = h->op->hash(item);
+	size_t stripe = stripe_idx(hash);
+
+	fibril_mutex_lock(&h->stripe_lock[stripe]);
+
+	bool migrated = catch_up_stripe(h, stripe);
+	size_t gen = h->resize_gen;
+
+	list_append(&item->link, hash_bucket(h, hash));
+	++h->stripe_items[stripe];
+	bool grow = stripe_overfull(h, stripe);
+
+	fibril_mutex_unlock(&h->stripe_lock[stripe]);
+
+	if (migrated)
+		note_migrated(h, gen);
+	if (grow)
+		start_resize(h, true);
+}
+
+/** Insert item into a hash table if not already present.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ *
+ * @return False if such an item had already been inserted.
+ * @return True if the inserted item was the only item with such a lookup key.
+ */
+bool chash_table_insert_unique(chash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->bucket && h->bucket_cnt);
+	assert(h->op && h->op->hash && h->op->equal);
+
+	size_t hash = h->op->hash(item);
+	size_t stripe = stripe_idx(hash);
+	bool unique = true;
+	bool grow = false;
+
+	fibril_mutex_lock(&h->stripe_lock[stripe]);
+
+	bool migrated = catch_up_stripe(h, stripe);
+	size_t gen = h->resize_gen;
+
+	/* Check for duplicates. */
+	list_foreach(*hash_bucket(h, hash), link, ht_link_t, cur_link) {
+		/*
+		 * We could filter out items using their hashes first, but
+		 * calling equal() might very well be just as fast.
+		 */
+		if (h->op->equal(cur_link, item)) {
+			unique = false;
+			break;
+		}
+	}
+
+	if (unique) {
+		list_append(&item->link, hash_bucket(h, hash));
+		++h->stripe_items[stripe];
+		grow = stripe_overfull(h, stripe);
+	}
+
+	fibril_mutex_unlock(&h->stripe_lock[stripe]);
+
+	if (migrated)
+		note_migrated(h, gen);
+	if (grow)
+		start_resize(h, true);
+
+	return unique;
+}
+
+/** Search hash table for an item matching keys.
+ *
+ * Note that the table does not protect the returned item against
+ * concurrent removal by another fibril; the caller must ensure the
+ * item stays valid (typically via reference counting performed by
+ * the item's own synchronization).
+ *
+ * @param h   Hash table.
+ * @param key Array of all keys needed to compute hash index.
+ *
+ * @return Matching item on success, NULL if there is no such item.
+ *
+ */
+ht_link_t *chash_table_find(chash_table_t *h, const void *key)
+{
+	assert(h && h->bucket);
+
+	size_t hash = h->op->key_hash(key);
+	size_t stripe = stripe_idx(hash);
+	ht_link_t *found = NULL;
+
+	fibril_mutex_lock(&h->stripe_lock[stripe]);
+
+	bool migrated = catch_up_stripe(h, stripe);
+	size_t gen = h->resize_gen;
+
+	list_foreach(*hash_bucket(h, hash), link, ht_link_t, cur_link) {
+		/*
+		 * Is this is the item we are looking for? We could have first
+		 * checked if the hashes match but op->key_equal() may very well be
+		 * just as fast as op->hash().
+		 */
+		if (h->op->key_equal(key, cur_link)) {
+			found = cur_link;
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&h->stripe_lock[stripe]);
+
+	if (migrated)
+		note_migrated(h, gen);
+
+	return found;
+}
+
+/** Remove all matching items from hash table.
+ *
+ * For each removed item, h->remove_callback() is called.
+ *
+ * @param h    Hash table.
+ * @param key  Array of keys that will be compared against items of
+ *             the hash table.
+ *
+ * @return Returns the number of removed items.
+ */
+size_t chash_table_remove(chash_table_t *h, const void *key)
+{
+	assert(h && h->bucket);
+
+	size_t hash = h->op->key_hash(key);
+	size_t stripe = stripe_idx(hash);
+	size_t removed = 0;
+
+	fibril_mutex_lock(&h->stripe_lock[stripe]);
+
+	bool migrated = catch_up_stripe(h, stripe);
+	size_t gen = h->resize_gen;
+
+	list_foreach_safe(*hash_bucket(h, hash), cur, next) {
+		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+		if (h->op->key_equal(key, cur_link)) {
+			++removed;
+			list_remove(cur);
+			h->op->remove_callback(cur_link);
+		}
+	}
+
+	h->stripe_items[stripe] -= removed;
+	bool shrink = stripe_underfull(h, stripe);
+
+	fibril_mutex_unlock(&h->stripe_lock[stripe]);
+
+	if (migrated)
+		note_migrated(h, gen);
+	if (shrink)
+		start_resize(h, false);
+
+	return removed;
+}
+
+/** Removes an item already present in the table. The item must be in the table. */
+void chash_table_remove_item(chash_table_t *h, ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->bucket);
+	assert(link_in_use(&item->link));
+
+	size_t hash = h->op->hash(item);
+	size_t stripe = stripe_idx(hash);
+
+	fibril_mutex_lock(&h->stripe_lock[stripe]);
+
+	bool migrated = catch_up_stripe(h, stripe);
+	size_t gen = h->resize_gen;
+
+	list_remove(&item->link);
+	--h->stripe_items[stripe];
+	h->op->remove_callback(item);
+	bool shrink = stripe_underfull(h, stripe);
+
+	fibril_mutex_unlock(&h->stripe_lock[stripe]);
+
+	if (migrated)
+		note_migrated(h, gen);
+	if (shrink)
+		start_resize(h, false);
+}
+
+/** Apply function to all items in hash table.
+ *
+ * All stripes are locked for the whole duration, so f() must not
+ * invoke any function of this hash table.
+ *
+ * @param h   Hash table.
+ * @param f   Function to be applied. Return false if no more items
+ *            should be visited.
+ * @param arg Argument to be passed to the function.
+ */
+void chash_table_apply(chash_table_t *h, bool (*f)(ht_link_t *, void *),
+    void *arg)
+{
+	assert(f);
+	assert(h && h->bucket);
+
+	lock_all(h);
+
+	for (size_t idx = 0; idx < h->bucket_cnt; ++idx) {
+		list_foreach_safe(h->bucket[idx], cur, next) {
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+			if (!f(cur_link, arg))
+				goto out;
+		}
+	}
+out:
+	unlock_all(h);
+}
+
+/** Rounds up size to the nearest suitable table size.
+ *
+ * Unlike hash_table_t, bucket counts are powers of two so that items
+ * keep their stripe across resizes.
+ */
+static size_t round_up_size(size_t size)
+{
+	size_t rounded_size = CHT_MIN_BUCKETS;
+
+	while (rounded_size < size) {
+		rounded_size = 2 * rounded_size;
+	}
+
+	return rounded_size;
+}
+
+/** Allocates and initializes the desired number of buckets. True if successful. */
+static bool alloc_buckets(size_t bucket_cnt, list_t **pbuckets)
+{
+	assert(pbuckets && CHT_MIN_BUCKETS <= bucket_cnt);
+
+	list_t *buckets = malloc(bucket_cnt * sizeof(list_t));
+	if (!buckets)
+		return false;
+
+	for (size_t i = 0; i < bucket_cnt; i++)
+		list_initialize(&buckets[i]);
+
+	*pbuckets = buckets;
+	return true;
+}
+
+/** Move all items of the stripe to the new bucket array.
+ *
+ * Expects the stripe lock to be held and a resize to be in progress.
+ * Old and new bucket indices of an item agree modulo the stripe
+ * count, so only buckets of this stripe are touched.
+ */
+static void migrate_stripe(chash_table_t *h, size_t stripe)
+{
+	assert(h->new_bucket != NULL);
+	assert(!h->stripe_migrated[stripe]);
+
+	for (size_t idx = stripe; idx < h->bucket_cnt;
+	    idx += CHASH_TABLE_STRIPES) {
+		list_foreach_safe(h->bucket[idx], cur, next) {
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+			size_t new_idx = h->op->hash(cur_link) &
+			    (h->new_bucket_cnt - 1);
+			list_remove(cur);
+			list_append(cur, &h->new_bucket[new_idx]);
+		}
+	}
+
+	h->stripe_migrated[stripe] = true;
+}
+
+/** Migrate the stripe if a resize is pending for it.
+ *
+ * Expects the stripe lock to be held. If true is returned, the
+ * caller must invoke note_migrated() with the resize generation read
+ * under the stripe lock, after releasing the stripe lock.
+ */
+static bool catch_up_stripe(chash_table_t *h, size_t stripe)
+{
+	if (h->new_bucket == NULL || h->stripe_migrated[stripe])
+		return false;
+
+	migrate_stripe(h, stripe);
+	return true;
+}
+
+/** Account a migrated stripe, finishing the resize after the last one.
+ *
+ * Must not be called with any stripe lock held.
+ *
+ * @param h   Hash table.
+ * @param gen Resize generation during which the stripe was migrated.
+ */
+static void note_migrated(chash_table_t *h, size_t gen)
+{
+	fibril_mutex_lock(&h->resize_lock);
+
+	/*
+	 * Skip stale updates if the resize was meanwhile completed by a
+	 * whole-table operation (and possibly a new one started).
+	 */
+	if (h->new_bucket != NULL && h->resize_gen == gen) {
+		++h->migrated_cnt;
+		if (h->migrated_cnt == CHASH_TABLE_STRIPES)
+			finish_resize(h);
+	}
+
+	fibril_mutex_unlock(&h->resize_lock);
+}
+
+/** Retire the old bucket array once all stripes have been migrated.
+ *
+ * Expects the resize lock to be held. Briefly takes all stripe locks
+ * to make sure no operation still reads the old array.
+ */
+static void finish_resize(chash_table_t *h)
+{
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		fibril_mutex_lock(&h->stripe_lock[s]);
+
+	free(h->bucket);
+	h->bucket = h->new_bucket;
+	h->bucket_cnt = h->new_bucket_cnt;
+	h->new_bucket = NULL;
+
+	for (size_t s = CHASH_TABLE_STRIPES; s > 0; --s)
+		fibril_mutex_unlock(&h->stripe_lock[s - 1]);
+}
+
+/** Start an incremental resize of the table.
+ *
+ * Must not be called with any stripe lock held. Does nothing if a
+ * resize is already in progress or the table cannot be resized.
+ *
+ * @param h    Hash table.
+ * @param grow True to double the bucket count, false to halve it.
+ */
+static void start_resize(chash_table_t *h, bool grow)
+{
+	fibril_mutex_lock(&h->resize_lock);
+
+	if (h->new_bucket != NULL)
+		goto leave;
+
+	size_t new_bucket_cnt;
+	if (grow) {
+		new_bucket_cnt = 2 * h->bucket_cnt;
+	} else {
+		new_bucket_cnt = h->bucket_cnt / 2;
+		if (new_bucket_cnt < CHT_MIN_BUCKETS)
+			goto leave;
+	}
+
+	list_t *new_buckets;
+
+	/* Leave the table as is if we cannot resize. */
+	if (!alloc_buckets(new_bucket_cnt, &new_buckets))
+		goto leave;
+
+	/*
+	 * Publish the new array under all stripe locks so that
+	 * operations always see a consistent resize state.
+	 */
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		fibril_mutex_lock(&h->stripe_lock[s]);
+
+	h->new_bucket = new_buckets;
+	h->new_bucket_cnt = new_bucket_cnt;
+	h->migrated_cnt = 0;
+	++h->resize_gen;
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		h->stripe_migrated[s] = false;
+
+	for (size_t s = CHASH_TABLE_STRIPES; s > 0; --s)
+		fibril_mutex_unlock(&h->stripe_lock[s - 1]);
+
+leave:
+	fibril_mutex_unlock(&h->resize_lock);
+}
+
+/** Lock the whole table, completing any pending resize.
+ *
+ * After return, all items reside in h->bucket and no other operation
+ * can run until unlock_all() is called.
+ */
+static void lock_all(chash_table_t *h)
+{
+	fibril_mutex_lock(&h->resize_lock);
+
+	for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s)
+		fibril_mutex_lock(&h->stripe_lock[s]);
+
+	if (h->new_bucket != NULL) {
+		for (size_t s = 0; s < CHASH_TABLE_STRIPES; ++s) {
+			if (!h->stripe_migrated[s])
+				migrate_stripe(h, s);
+		}
+
+		free(h->bucket);
+		h->bucket = h->new_bucket;
+		h->bucket_cnt = h->new_bucket_cnt;
+		h->new_bucket = NULL;
+	}
+}
+
+/** Unlock the whole table. */
+static void unlock_all(chash_table_t *h)
+{
+	for (size_t s = CHASH_TABLE_STRIPES; s > 0; --s)
+		fibril_mutex_unlock(&h->stripe_lock[s - 1]);
+
+	fibril_mutex_unlock(&h->resize_lock);
+}
+
+/** @}
+ */
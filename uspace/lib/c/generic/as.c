@@ -79,6 +79,25 @@ errno_t as_area_resize(void *address, size_t size, unsigned int flags)
 	    (sysarg_t) size, (sysarg_t) flags);
 }
 
+/** Decommit a range of pages within an address space area.
+ *
+ * Return the physical memory backing the range to the kernel while
+ * keeping the address range reserved. The pages read back as zeros
+ * and are committed again lazily on the first access.
+ *
+ * @param address Page-aligned virtual address pointing into already
+ *                existing address space area.
+ * @param size    Size of the range to decommit.
+ *
+ * @return zero on success or a code from @ref errno.h on failure.
+ *
+ */
+errno_t as_area_decommit(void *address, size_t size)
+{
+	return (errno_t) __SYSCALL2(SYS_AS_AREA_DECOMMIT, (sysarg_t) address,
+	    (sysarg_t) size);
+}
+
 /** Destroy address space area.
  *
  * @param address Virtual address pointing into the address space area being
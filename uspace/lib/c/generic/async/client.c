@@ -167,6 +167,53 @@ static LIST_INITIALIZE(inactive_exch_list);
  */
 static FIBRIL_CONDVAR_INITIALIZE(avail_phone_cv);
 
+/** Maximum number of inactive exchanges pooled per session.
+ *
+ * Pooled exchanges (and, for parallel sessions, their cloned phones)
+ * are handed out by async_exchange_begin() with a simple CAS, without
+ * going through async_sess_mutex. Exchanges beyond this limit go to
+ * the ordinary inactive lists so that the phones of idle parallel
+ * sessions remain reclaimable.
+ */
+#define EXCH_POOL_MAX  4
+
+/** Try to pop an exchange from the session's lock-free pool.
+ *
+ * @return Pooled exchange or NULL if the pool is empty.
+ */
+static async_exch_t *exch_pool_pop(async_sess_t *sess)
+{
+	async_exch_t *exch = atomic_load(&sess->exch_pool);
+
+	do {
+		if (exch == NULL)
+			return NULL;
+	} while (!atomic_compare_exchange_weak(&sess->exch_pool, &exch,
+	    exch->pool_next));
+
+	atomic_fetch_sub(&sess->exch_pool_cnt, 1);
+	return exch;
+}
+
+/** Try to push an inactive exchange onto the session's pool.
+ *
+ * @return True if the exchange was pooled, false if the pool is full.
+ */
+static bool exch_pool_push(async_sess_t *sess, async_exch_t *exch)
+{
+	if (atomic_load(&sess->exch_pool_cnt) >= EXCH_POOL_MAX)
+		return false;
+
+	atomic_fetch_add(&sess->exch_pool_cnt, 1);
+
+	exch->pool_next = atomic_load(&sess->exch_pool);
+	while (!atomic_compare_exchange_weak(&sess->exch_pool,
+	    &exch->pool_next, exch)) {
+	}
+
+	return true;
+}
+
 /** Initialize the async framework.
  *
  */
@@ -187,7 +234,9 @@ void __async_client_init(void)
 
 	list_initialize(&session_ns.exch_list);
 	fibril_mutex_initialize(&session_ns.mutex);
-	session_ns.exchanges = 0;
+	atomic_init(&session_ns.exch_pool, NULL);
+	atomic_init(&session_ns.exch_pool_cnt, 0);
+	atomic_init(&session_ns.exchanges, 0);
 }
 
 void __async_client_fini(void)
@@ -930,6 +979,8 @@ async_sess_t *async_connect_me_to(async_exch_t *exch, iface_t iface,
 
 	fibril_mutex_initialize(&sess->remote_state_mtx);
 	list_initialize(&sess->exch_list);
+	atomic_init(&sess->exch_pool, NULL);
+	atomic_init(&sess->exch_pool_cnt, 0);
 	fibril_mutex_initialize(&sess->mutex);
 
 	return sess;
@@ -1005,6 +1056,8 @@ async_sess_t *async_connect_me_to_blocking(async_exch_t *exch, iface_t iface,
 
 	fibril_mutex_initialize(&sess->remote_state_mtx);
 	list_initialize(&sess->exch_list);
+	atomic_init(&sess->exch_pool, NULL);
+	atomic_init(&sess->exch_pool_cnt, 0);
 	fibril_mutex_initialize(&sess->mutex);
 
 	return sess;
@@ -1044,6 +1097,8 @@ async_sess_t *async_connect_kbox(task_id_t id, errno_t *rc)
 
 	fibril_mutex_initialize(&sess->remote_state_mtx);
 	list_initialize(&sess->exch_list);
+	atomic_init(&sess->exch_pool, NULL);
+	atomic_init(&sess->exch_pool_cnt, 0);
 	fibril_mutex_initialize(&sess->mutex);
 
 	return sess;
@@ -1068,11 +1123,22 @@ void async_hangup(async_sess_t *sess)
 
 	assert(sess);
 
+	exch_mgmt_t mgmt = sess->mgmt;
+	if (sess->iface != 0)
+		mgmt = sess->iface & IFACE_EXCHANGE_MASK;
+
 	fibril_mutex_lock(&async_sess_mutex);
 	assert(sess->exchanges == 0);
 
 	async_hangup_internal(sess->phone);
 
+	while ((exch = exch_pool_pop(sess)) != NULL) {
+		if (mgmt != EXCHANGE_ATOMIC &&
+		    mgmt != EXCHANGE_SERIALIZE)
+			async_hangup_internal(exch->phone);
+		free(exch);
+	}
+
 	while (!list_empty(&sess->exch_list)) {
 		exch = (async_exch_t *)
 		    list_get_instance(list_first(&sess->exch_list),
@@ -1080,8 +1146,8 @@ void async_hangup(async_sess_t *sess)
 
 		list_remove(&exch->sess_link);
 		list_remove(&exch->global_link);
-		if (sess->mgmt != EXCHANGE_ATOMIC &&
-		    sess->mgmt != EXCHANGE_SERIALIZE)
+		if (mgmt != EXCHANGE_ATOMIC &&
+		    mgmt != EXCHANGE_SERIALIZE)
 			async_hangup_internal(exch->phone);
 		free(exch);
 	}
@@ -1107,7 +1173,19 @@ async_exch_t *async_exchange_begin(async_sess_t *sess)
 	if (sess->iface != 0)
 		mgmt = sess->iface & IFACE_EXCHANGE_MASK;
 
-	async_exch_t *exch = NULL;
+	/*
+	 * Fast path: grab a pooled exchange with a CAS, avoiding both
+	 * async_sess_mutex and (for parallel sessions) a phone clone.
+	 */
+	async_exch_t *exch = exch_pool_pop(sess);
+	if (exch != NULL) {
+		atomic_fetch_add(&sess->exchanges, 1);
+
+		if (mgmt == EXCHANGE_SERIALIZE)
+			fibril_mutex_lock(&sess->mutex);
+
+		return exch;
+	}
 
 	fibril_mutex_lock(&async_sess_mutex);
 
@@ -1180,7 +1258,7 @@ async_exch_t *async_exchange_begin(async_sess_t *sess)
 	}
 
 	if (exch != NULL)
-		sess->exchanges++;
+		atomic_fetch_add(&sess->exchanges, 1);
 
 	fibril_mutex_unlock(&async_sess_mutex);
 
@@ -1210,13 +1288,26 @@ void async_exchange_end(async_exch_t *exch)
 	if (mgmt == EXCHANGE_SERIALIZE)
 		fibril_mutex_unlock(&sess->mutex);
 
-	fibril_mutex_lock(&async_sess_mutex);
+	atomic_fetch_sub(&sess->exchanges, 1);
 
-	sess->exchanges--;
+	/* Fast path: return the exchange to the session's pool. */
+	if (exch_pool_push(sess, exch))
+		return;
+
+	fibril_mutex_lock(&async_sess_mutex);
 
 	list_append(&exch->sess_link, &sess->exch_list);
-	list_append(&exch->global_link, &inactive_exch_list);
-	fibril_condvar_signal(&avail_phone_cv);
+
+	/*
+	 * Only parallel exchanges own a cloned phone that can be
+	 * reclaimed by closing it; exchanges of atomic and serializing
+	 * sessions share the session phone and must not end up on the
+	 * global reclaim list.
+	 */
+	if (mgmt == EXCHANGE_PARALLEL) {
+		list_append(&exch->global_link, &inactive_exch_list);
+		fibril_condvar_signal(&avail_phone_cv);
+	}
 
 	fibril_mutex_unlock(&async_sess_mutex);
 }
@@ -1328,6 +1419,23 @@ errno_t async_data_read_start(async_exch_t *exch, void *dst, size_t size)
 	    (sysarg_t) size);
 }
 
+/** Start IPC_M_DATA_WRITE using the async framework.
+ *
+ * @param exch    Exchange for sending the message.
+ * @param src     Address of the beginning of the source buffer.
+ * @param size    Size of the source buffer (in bytes).
+ * @param dataptr Storage of call data (arg 2 holds actual data size).
+ *
+ * @return Hash of the sent message or 0 on error.
+ *
+ */
+aid_t async_data_write(async_exch_t *exch, const void *src, size_t size,
+    ipc_call_t *dataptr)
+{
+	return async_send_2(exch, IPC_M_DATA_WRITE, (sysarg_t) src,
+	    (sysarg_t) size, dataptr);
+}
+
 /** Wrapper for IPC_M_DATA_WRITE calls using the async framework.
  *
  * @param exch Exchange for sending the message.
@@ -1346,6 +1454,107 @@ errno_t async_data_write_start(async_exch_t *exch, const void *src, size_t size)
 	    (sysarg_t) size);
 }
 
+/** Compute the total byte count of an I/O vector.
+ *
+ * @param iov Array of buffer fragments.
+ * @param cnt Number of fragments.
+ *
+ * @return Sum of the fragment sizes.
+ *
+ */
+static size_t async_iovec_size(const async_iovec_t *iov, size_t cnt)
+{
+	size_t size = 0;
+
+	for (size_t i = 0; i < cnt; i++)
+		size += iov[i].iov_len;
+
+	return size;
+}
+
+/** Wrapper for scatter reads using the async framework.
+ *
+ * Transfer the data through a single IPC_M_DATA_READ round-trip and
+ * scatter it into the fragments of the I/O vector afterwards. The server
+ * sees one ordinary data read for the total size of the vector, so a
+ * multi-fragment read costs one exchange instead of one per fragment.
+ *
+ * @param exch Exchange for sending the message.
+ * @param iov  Array of destination buffer fragments.
+ * @param cnt  Number of fragments.
+ *
+ * @return Zero on success or an error code from errno.h.
+ *
+ */
+errno_t async_data_readv_start(async_exch_t *exch, const async_iovec_t *iov,
+    size_t cnt)
+{
+	if (exch == NULL)
+		return ENOENT;
+
+	if (cnt == 1)
+		return async_data_read_start(exch, iov[0].iov_base,
+		    iov[0].iov_len);
+
+	size_t size = async_iovec_size(iov, cnt);
+	void *buf = malloc(size);
+	if (!buf)
+		return ENOMEM;
+
+	errno_t rc = async_data_read_start(exch, buf, size);
+	if (rc == EOK) {
+		size_t pos = 0;
+		for (size_t i = 0; i < cnt; i++) {
+			memcpy(iov[i].iov_base, buf + pos, iov[i].iov_len);
+			pos += iov[i].iov_len;
+		}
+	}
+
+	free(buf);
+	return rc;
+}
+
+/** Wrapper for gather writes using the async framework.
+ *
+ * Gather the fragments of the I/O vector into one buffer and transfer it
+ * through a single IPC_M_DATA_WRITE round-trip. The server sees one
+ * ordinary data write for the total size of the vector, so a
+ * multi-fragment write costs one exchange instead of one per fragment.
+ *
+ * @param exch Exchange for sending the message.
+ * @param iov  Array of source buffer fragments.
+ * @param cnt  Number of fragments.
+ *
+ * @return Zero on success or an error code from errno.h.
+ *
+ */
+errno_t async_data_writev_start(async_exch_t *exch, const async_iovec_t *iov,
+    size_t cnt)
+{
+	if (exch == NULL)
+		return ENOENT;
+
+	if (cnt == 1)
+		return async_data_write_start(exch, iov[0].iov_base,
+		    iov[0].iov_len);
+
+	size_t size = async_iovec_size(iov, cnt);
+	void *buf = malloc(size);
+	if (!buf)
+		return ENOMEM;
+
+	size_t pos = 0;
+	for (size_t i = 0; i < cnt; i++) {
+		memcpy(buf + pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+
+	errno_t rc = async_data_write_start(exch, buf, size);
+
+	free(buf);
+	return rc;
+}
+
 errno_t async_state_change_start(async_exch_t *exch, sysarg_t arg1, sysarg_t arg2,
     sysarg_t arg3, async_exch_t *other_exch)
 {
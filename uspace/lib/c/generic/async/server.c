@@ -156,6 +156,12 @@ typedef struct {
 
 	/** Client data */
 	void *data;
+
+	/** Event queue the connection is registered with (or NULL). */
+	async_evq_t *evq;
+
+	/** User tag identifying the connection in event queue events. */
+	void *tag;
 } connection_t;
 
 /* Member of notification_t::msg_list. */
@@ -378,6 +384,221 @@ sysarg_t async_get_label(void)
 	return (sysarg_t) fibril_connection;
 }
 
+/*
+ * Event queues. A connection registered with an event queue has no
+ * fibril of its own; its calls are delivered as events into the queue
+ * and a single consumer fibril processes any number of connections.
+ */
+
+/** Event queue */
+struct async_evq {
+	/** Channel carrying async_evq_event_t items */
+	mpsc_t *channel;
+};
+
+/** Port data of an event queue port */
+typedef struct {
+	/** Queue receiving the opening calls of the port */
+	async_evq_t *evq;
+
+	/** User tag delivered with the connection events of the port */
+	void *tag;
+} evq_port_t;
+
+/** Placeholder connection handler of event queue ports.
+ *
+ * Never runs: handle_call() diverts connections to event queue ports
+ * into the queue before any connection fibril is created. The function
+ * itself only serves as the identification of such ports.
+ */
+static void evq_port_handler(ipc_call_t *icall, void *arg)
+{
+	abort();
+}
+
+/** Deliver the opening call of a connection to an event queue. */
+static void async_evq_new_connection(evq_port_t *port, ipc_call_t *call)
+{
+	async_evq_event_t event = {
+		.etype = ASYNC_EVQ_CONNECTION,
+		.tag = port->tag,
+		.call = *call
+	};
+
+	if (mpsc_send(port->evq->channel, &event) != EOK)
+		ipc_answer_0(call->cap_handle, EHANGUP);
+}
+
+/** Deliver a routed call to an event queue.
+ *
+ * @param conn Connection accepted into an event queue.
+ * @param call Data of the incoming call.
+ *
+ * @return EOK if the call was delivered.
+ * @return Error code if the queue is closed or out of memory.
+ */
+static errno_t async_evq_route(connection_t *conn, ipc_call_t *call)
+{
+	async_evq_event_t event = {
+		.etype = ASYNC_EVQ_CALL,
+		.tag = conn->tag,
+		.call = *call
+	};
+
+	if (ipc_get_imethod(call) == IPC_M_PHONE_HUNGUP)
+		event.etype = ASYNC_EVQ_HANGUP;
+
+	errno_t rc = mpsc_send(conn->evq->channel, &event);
+
+	if (event.etype == ASYNC_EVQ_HANGUP) {
+		/*
+		 * No further calls can arrive on this connection. Drop
+		 * the client task reference and the connection record;
+		 * the consumer keeps the tag from the event.
+		 */
+		async_client_put(conn->client);
+		free(conn);
+	}
+
+	return rc;
+}
+
+/** Create an event queue. */
+async_evq_t *async_evq_create(void)
+{
+	async_evq_t *evq = calloc(1, sizeof(async_evq_t));
+	if (evq == NULL)
+		return NULL;
+
+	evq->channel = mpsc_create(sizeof(async_evq_event_t));
+	if (evq->channel == NULL) {
+		free(evq);
+		return NULL;
+	}
+
+	return evq;
+}
+
+/** Destroy an event queue.
+ *
+ * All ports registered with the queue must have been destroyed and all
+ * accepted connections hung up beforehand. Calls still sitting in the
+ * queue are answered with EHANGUP.
+ */
+void async_evq_destroy(async_evq_t *evq)
+{
+	mpsc_close(evq->channel);
+
+	async_evq_event_t event;
+	while (mpsc_receive(evq->channel, &event, NULL) == EOK) {
+		if (event.call.cap_handle != CAP_NIL)
+			ipc_answer_0(event.call.cap_handle, EHANGUP);
+	}
+
+	mpsc_destroy(evq->channel);
+	free(evq);
+}
+
+/** Create a port delivering its connections to an event queue.
+ *
+ * @param evq     Event queue receiving the connection events.
+ * @param iface   Interface to listen on.
+ * @param tag     User tag delivered with the connection events.
+ * @param port_id ID of the newly created port.
+ *
+ * @return Zero on success or an error code.
+ */
+errno_t async_evq_create_port(async_evq_t *evq, iface_t iface, void *tag,
+    port_id_t *port_id)
+{
+	evq_port_t *port = malloc(sizeof(evq_port_t));
+	if (port == NULL)
+		return ENOMEM;
+
+	port->evq = evq;
+	port->tag = tag;
+
+	errno_t rc = async_create_port_internal(iface, evq_port_handler, port,
+	    port_id);
+	if (rc != EOK)
+		free(port);
+
+	return rc;
+}
+
+/** Accept a connection into an event queue.
+ *
+ * Answers the opening call of a connection delivered by an
+ * ASYNC_EVQ_CONNECTION event. Subsequent calls of the connection are
+ * delivered to the queue as ASYNC_EVQ_CALL events carrying @a tag.
+ * To refuse the connection, answer the opening call with an error
+ * instead of calling this function.
+ *
+ * @param evq  Event queue the connection calls are delivered to.
+ * @param call Opening call of the connection.
+ * @param tag  User tag identifying the connection.
+ *
+ * @return Zero on success or an error code.
+ */
+errno_t async_evq_accept(async_evq_t *evq, ipc_call_t *call, void *tag)
+{
+	connection_t *conn = calloc(1, sizeof(connection_t));
+	if (conn == NULL)
+		return ENOMEM;
+
+	client_t *client = async_client_get(call->task_id, true);
+	if (client == NULL) {
+		free(conn);
+		return ENOMEM;
+	}
+
+	conn->in_task_id = call->task_id;
+	conn->client = client;
+	conn->evq = evq;
+	conn->tag = tag;
+
+	cap_call_handle_t chandle = call->cap_handle;
+	assert(chandle != CAP_NIL);
+	call->cap_handle = CAP_NIL;
+
+	errno_t rc = ipc_answer_5(chandle, EOK, 0, 0, 0, 0, (sysarg_t) conn);
+	if (rc != EOK) {
+		async_client_put(client);
+		free(conn);
+	}
+
+	return rc;
+}
+
+/** Wait for a batch of events from an event queue.
+ *
+ * Blocks until at least one event arrives (or the deadline passes) and
+ * then drains up to @a max events without further blocking.
+ *
+ * @param evq     Event queue to wait on.
+ * @param events  Destination array for the events.
+ * @param max     Capacity of the destination array.
+ * @param expires Absolute deadline or NULL to wait indefinitely.
+ *
+ * @return Number of events received (zero on timeout).
+ */
+size_t async_evq_wait(async_evq_t *evq, async_evq_event_t *events, size_t max,
+    const struct timespec *expires)
+{
+	if (max == 0)
+		return 0;
+
+	if (mpsc_receive(evq->channel, &events[0], expires) != EOK)
+		return 0;
+
+	size_t cnt = 1;
+	while ((cnt < max) &&
+	    (mpsc_try_receive(evq->channel, &events[cnt]) == EOK))
+		cnt++;
+
+	return cnt;
+}
+
 /** Create a new fibril for a new connection.
  *
  * Create new fibril for connection, fill in connection structures and insert it
@@ -540,6 +761,9 @@ static errno_t route_call(ipc_call_t *call)
 	if (!conn)
 		return ENOENT;
 
+	if (conn->evq != NULL)
+		return async_evq_route(conn, call);
+
 	assert(conn->msg_channel);
 
 	errno_t rc = mpsc_send(conn->msg_channel, call);
@@ -943,12 +1167,6 @@ static void handle_call(ipc_call_t *call)
 
 	/* New connection */
 	if (ipc_get_imethod(call) == IPC_M_CONNECT_ME_TO) {
-		connection_t *conn = calloc(1, sizeof(*conn));
-		if (!conn) {
-			ipc_answer_0(call->cap_handle, ENOMEM);
-			return;
-		}
-
 		iface_t iface = (iface_t) ipc_get_arg1(call);
 
 		// TODO: Currently ignores all ports but the first one.
@@ -956,6 +1174,18 @@ static void handle_call(ipc_call_t *call)
 		async_port_handler_t handler =
 		    async_get_port_handler(iface, 0, &data);
 
+		/* Ports of event queues get no connection fibril. */
+		if (handler == evq_port_handler) {
+			async_evq_new_connection((evq_port_t *) data, call);
+			return;
+		}
+
+		connection_t *conn = calloc(1, sizeof(*conn));
+		if (!conn) {
+			ipc_answer_0(call->cap_handle, ENOMEM);
+			return;
+		}
+
 		async_new_connection(conn, call->task_id, call, handler, data);
 		return;
 	}
@@ -1361,6 +1591,51 @@ errno_t async_data_read_finalize(ipc_call_t *call, const void *src, size_t size)
 	return ipc_answer_2(chandle, EOK, (sysarg_t) src, (sysarg_t) size);
 }
 
+/** Wrapper for answering the IPC_M_DATA_READ calls with scattered data.
+ *
+ * Gather the fragments of the I/O vector into one buffer and answer the
+ * call with it, so the client receives the whole vector in the single
+ * data read it initiated.
+ *
+ * @param call IPC_M_DATA_READ call to answer.
+ * @param iov  Array of source buffer fragments.
+ * @param cnt  Number of fragments.
+ *
+ * @return  Zero on success or a value from @ref errno.h on failure.
+ *
+ */
+errno_t async_data_readv_finalize(ipc_call_t *call, const async_iovec_t *iov,
+    size_t cnt)
+{
+	assert(call);
+
+	if (cnt == 1)
+		return async_data_read_finalize(call, iov[0].iov_base,
+		    iov[0].iov_len);
+
+	size_t size = 0;
+	for (size_t i = 0; i < cnt; i++)
+		size += iov[i].iov_len;
+
+	void *buf = malloc(size);
+	if (!buf) {
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	size_t pos = 0;
+	for (size_t i = 0; i < cnt; i++) {
+		memcpy(buf + pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+
+	/* The data is copied out during the answer, freeing is safe. */
+	errno_t rc = async_data_read_finalize(call, buf, size);
+
+	free(buf);
+	return rc;
+}
+
 /** Wrapper for forwarding any read request
  *
  */
@@ -1515,6 +1790,52 @@ errno_t async_data_write_finalize(ipc_call_t *call, void *dst, size_t size)
 	return async_answer_2(call, EOK, (sysarg_t) dst, (sysarg_t) size);
 }
 
+/** Wrapper for answering the IPC_M_DATA_WRITE calls with scattered buffers.
+ *
+ * Receive the data of the call into one buffer and scatter it into the
+ * fragments of the I/O vector, so the server can accept a vectored write
+ * issued by the client as a single data write.
+ *
+ * @param call IPC_M_DATA_WRITE call to answer.
+ * @param iov  Array of destination buffer fragments.
+ * @param cnt  Number of fragments.
+ *
+ * @return  Zero on success or a value from @ref errno.h on failure.
+ *
+ */
+errno_t async_data_writev_finalize(ipc_call_t *call, const async_iovec_t *iov,
+    size_t cnt)
+{
+	assert(call);
+
+	if (cnt == 1)
+		return async_data_write_finalize(call, iov[0].iov_base,
+		    iov[0].iov_len);
+
+	size_t size = 0;
+	for (size_t i = 0; i < cnt; i++)
+		size += iov[i].iov_len;
+
+	void *buf = malloc(size);
+	if (!buf) {
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	/* The data is copied in during the answer. */
+	errno_t rc = async_data_write_finalize(call, buf, size);
+	if (rc == EOK) {
+		size_t pos = 0;
+		for (size_t i = 0; i < cnt; i++) {
+			memcpy(iov[i].iov_base, buf + pos, iov[i].iov_len);
+			pos += iov[i].iov_len;
+		}
+	}
+
+	free(buf);
+	return rc;
+}
+
 /** Wrapper for receiving binary data or strings
  *
  * This wrapper only makes it more comfortable to use async_data_write_*
@@ -37,6 +37,8 @@
  *
  */
 
+#include <align.h>
+#include <as.h>
 #include <async.h>
 #include <clipboard.h>
 #include <errno.h>
@@ -44,9 +46,18 @@
 #include <ipc/clipboard.h>
 #include <ipc/services.h>
 #include <loc.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str.h>
 
+enum {
+	/**
+	 * Payloads of at least this size are handed over via memory
+	 * sharing rather than copied over IPC.
+	 */
+	clip_area_threshold = 4 * PAGE_SIZE
+};
+
 static FIBRIL_MUTEX_INITIALIZE(clip_mutex);
 static async_sess_t *clip_sess = NULL;
 
@@ -87,6 +98,49 @@ static void clip_exchange_end(async_exch_t *exch)
 	async_exchange_end(exch);
 }
 
+/** Put string to clipboard via a shared memory area.
+ *
+ * A dedicated area is created, filled with the string and handed over
+ * to the clipboard service. Getters can then map it directly instead
+ * of copying the data over IPC.
+ *
+ * @param str String to put to clipboard.
+ * @param size Size of the string in bytes (nonzero).
+ *
+ * @return Zero on success or an error code.
+ *
+ */
+static errno_t clipboard_put_str_area(const char *str, size_t size)
+{
+	size_t asize = ALIGN_UP(size, PAGE_SIZE);
+	errno_t retval;
+	void *area;
+
+	area = as_area_create(AS_AREA_ANY, asize,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	memcpy(area, str, size);
+
+	async_exch_t *exch = clip_exchange_begin();
+	aid_t req = async_send_2(exch, CLIPBOARD_PUT_AREA, CLIPBOARD_TAG_DATA,
+	    size, NULL);
+	errno_t rc = async_share_out_start(exch, area,
+	    AS_AREA_READ | AS_AREA_CACHEABLE);
+	clip_exchange_end(exch);
+
+	async_wait_for(req, &retval);
+
+	/* The service has its own mapping now (if it accepted the area) */
+	as_area_destroy(area);
+
+	if (rc != EOK)
+		return rc;
+
+	return retval;
+}
+
 /** Copy string to clipboard.
  *
  * Sets the clipboard contents to @a str. Passing an empty string or NULL
@@ -101,6 +155,15 @@ errno_t clipboard_put_str(const char *str)
 {
 	size_t size = str_size(str);
 
+	if (size >= clip_area_threshold) {
+		/*
+		 * On any failure (e.g. the service does not support
+		 * memory sharing) fall back to the copy method.
+		 */
+		if (clipboard_put_str_area(str, size) == EOK)
+			return EOK;
+	}
+
 	if (size == 0) {
 		async_exch_t *exch = clip_exchange_begin();
 		errno_t rc = async_req_1_0(exch, CLIPBOARD_PUT_DATA,
@@ -130,6 +193,55 @@ errno_t clipboard_put_str(const char *str)
 	}
 }
 
+/** Get clipboard contents by mapping the shared area.
+ *
+ * Maps the area holding the clipboard contents, copies out the string
+ * and unmaps the area again.
+ *
+ * @param size Size of the contents as reported by CLIPBOARD_CONTENT.
+ * @param str Here pointer to the newly allocated string is stored.
+ *
+ * @return Zero on success, EOVERFLOW if the clipboard contents have
+ *         changed in the meantime, ENOTSUP if the contents cannot be
+ *         shared or another error code.
+ *
+ */
+static errno_t clipboard_get_str_area(size_t size, char **str)
+{
+	size_t asize = ALIGN_UP(size, PAGE_SIZE);
+	errno_t retval;
+	void *area;
+	char *sbuf;
+
+	async_exch_t *exch = clip_exchange_begin();
+	aid_t req = async_send_1(exch, CLIPBOARD_GET_AREA, CLIPBOARD_TAG_DATA,
+	    NULL);
+	errno_t rc = async_share_in_start_0_0(exch, asize, &area);
+	clip_exchange_end(exch);
+
+	async_wait_for(req, &retval);
+
+	if (rc != EOK)
+		return rc;
+
+	if (retval != EOK)
+		return retval;
+
+	sbuf = malloc(size + 1);
+	if (sbuf == NULL) {
+		as_area_destroy(area);
+		return ENOMEM;
+	}
+
+	memcpy(sbuf, area, size);
+	sbuf[size] = 0;
+
+	as_area_destroy(area);
+
+	*str = sbuf;
+	return EOK;
+}
+
 /** Get a copy of clipboard contents.
  *
  * Returns a new string that can be deallocated with free().
@@ -166,6 +278,23 @@ errno_t clipboard_get_str(char **str)
 			*str = sbuf;
 			return EOK;
 		case CLIPBOARD_TAG_DATA:
+			if (size >= clip_area_threshold) {
+				rc = clipboard_get_str_area(size, str);
+				if (rc == EOK)
+					return EOK;
+
+				if (rc == EOVERFLOW) {
+					/*
+					 * The data in the clipboard has
+					 * changed since the last call of
+					 * CLIPBOARD_CONTENT
+					 */
+					break;
+				}
+
+				/* Fall back to the copy method */
+			}
+
 			sbuf = malloc(size + 1);
 			if (sbuf == NULL)
 				return ENOMEM;
@@ -40,10 +40,21 @@
 #include <assert.h>
 #include <string.h>
 
+/** Size of the buffer of directory entries read ahead from the server. */
+#define DIRENTS_BUF_SIZE  4096
+
 struct __dirstream {
 	int fd;
 	struct dirent res;
 	aoff64_t pos;
+	/*
+	 * Servers may return several null-terminated entry names per read.
+	 * They are buffered here and handed out one per readdir() call.
+	 * The unused tail of the buffer is zeroed, so an empty name marks
+	 * the end of the buffered entries.
+	 */
+	char buf[DIRENTS_BUF_SIZE];
+	size_t buf_off;
 };
 
 /** Open directory.
@@ -78,6 +89,8 @@ DIR *opendir(const char *dirname)
 
 	dirp->fd = fd;
 	dirp->pos = 0;
+	dirp->buf[0] = '\0';
+	dirp->buf_off = 0;
 	return dirp;
 }
 
@@ -91,17 +104,33 @@ struct dirent *readdir(DIR *dirp)
 {
 	errno_t rc;
 	ssize_t len = 0;
-
-	rc = vfs_read_short(dirp->fd, dirp->pos, dirp->res.d_name,
-	    sizeof(dirp->res.d_name), &len);
-	if (rc != EOK) {
-		errno = rc;
-		return NULL;
+	size_t name_len;
+
+	if ((dirp->buf_off >= sizeof(dirp->buf)) ||
+	    (dirp->buf[dirp->buf_off] == '\0')) {
+		/*
+		 * The buffer is exhausted. Zero it so that the unused tail
+		 * can be recognized and read the next batch of entries.
+		 */
+		memset(dirp->buf, 0, sizeof(dirp->buf));
+		rc = vfs_read_short(dirp->fd, dirp->pos, dirp->buf,
+		    sizeof(dirp->buf), &len);
+		if (rc != EOK) {
+			errno = rc;
+			return NULL;
+		}
+
+		dirp->pos += len;
+		dirp->buf_off = 0;
 	}
 
-	assert(strnlen(dirp->res.d_name, sizeof(dirp->res.d_name)) < sizeof(dirp->res.d_name));
+	name_len = strnlen(dirp->buf + dirp->buf_off,
+	    sizeof(dirp->buf) - dirp->buf_off);
+	assert(name_len < sizeof(dirp->res.d_name));
 
-	dirp->pos += len;
+	memcpy(dirp->res.d_name, dirp->buf + dirp->buf_off, name_len);
+	dirp->res.d_name[name_len] = '\0';
+	dirp->buf_off += name_len + 1;
 
 	return &dirp->res;
 }
@@ -113,6 +142,8 @@ struct dirent *readdir(DIR *dirp)
 void rewinddir(DIR *dirp)
 {
 	dirp->pos = 0;
+	dirp->buf[0] = '\0';
+	dirp->buf_off = 0;
 }
 
 /** Close directory.
@@ -458,6 +458,71 @@ static int gen_dec_digits(fp_num_t scaled_upper, fp_num_t delta,
 	return len;
 }
 
+/** Returns true if val is an integral value not exceeding 2^53.
+ *
+ * Such values are represented exactly in a double and their unit
+ * in the last place is at most 1, so the decimal digits of the
+ * integer (with trailing zeros moved to the decimal exponent) are
+ * also the shortest accurate string representation.
+ */
+static bool is_small_int(ieee_double_t val, uint64_t *value)
+{
+	int neg_exp = -val.pos_val.exponent;
+
+	if ((neg_exp < 0) || (64 <= neg_exp))
+		return false;
+
+	if ((val.pos_val.significand & ((1ULL << neg_exp) - 1)) != 0)
+		return false;
+
+	*value = val.pos_val.significand >> neg_exp;
+
+	return true;
+}
+
+/** Produce the digits of an integral value by plain division.
+ *
+ * A fast path that skips the scaled bounds machinery. If requested,
+ * trailing zeros are moved into the decimal exponent.
+ *
+ * @return Number of digits; negative on failure (buffer too small).
+ */
+static int small_int_to_str(uint64_t value, bool strip_zeros, char *buf,
+    size_t buf_size, int *dec_exponent)
+{
+	assert(value != 0);
+
+	int exp = 0;
+
+	if (strip_zeros) {
+		while (value % 10 == 0) {
+			value /= 10;
+			++exp;
+		}
+	}
+
+	/* Produce the digits in reverse order. */
+	char digits[20];
+	int len = 0;
+
+	while (value != 0) {
+		digits[len] = '0' + (value % 10);
+		value /= 10;
+		++len;
+	}
+
+	if (buf_size < (size_t) len + 1)
+		return -1;
+
+	for (int i = 0; i < len; ++i)
+		buf[i] = digits[len - 1 - i];
+
+	buf[len] = '\0';
+	*dec_exponent = exp;
+
+	return len;
+}
+
 /** Produce a string for 0.0 */
 static int zero_to_str(char *buf, size_t buf_size, int *dec_exponent)
 {
@@ -513,6 +578,16 @@ int double_to_short_str(ieee_double_t ieee_val, char *buf, size_t buf_size,
 		return zero_to_str(buf, buf_size, dec_exponent);
 	}
 
+	/*
+	 * Fast path: counters and other integral values are common and
+	 * their digits can be produced by plain division.
+	 */
+	uint64_t int_val;
+	if (is_small_int(ieee_val, &int_val)) {
+		return small_int_to_str(int_val, true, buf, buf_size,
+		    dec_exponent);
+	}
+
 	fp_num_t scaled_upper_bound;
 	fp_num_t delta;
 	fp_num_t val_dist;
@@ -764,6 +839,27 @@ int double_to_fixed_str(ieee_double_t ieee_val, int signif_d_cnt,
 		return zero_to_str(buf, buf_size, dec_exponent);
 	}
 
+	/*
+	 * Fast path: integral values are exact, so produce their digits
+	 * by plain division and apply the significant digit limit
+	 * directly. The limit on fractional digits never truncates an
+	 * integral value (its decimal exponent is non-negative).
+	 */
+	uint64_t int_val;
+	if ((signif_d_cnt != 0) && is_small_int(ieee_val, &int_val)) {
+		int len = small_int_to_str(int_val, false, buf, buf_size,
+		    dec_exponent);
+
+		if ((len > 0) && (0 <= signif_d_cnt) && (signif_d_cnt < len)) {
+			/* Keep the most significant digits, do not round. */
+			*dec_exponent += len - signif_d_cnt;
+			len = signif_d_cnt;
+			buf[len] = '\0';
+		}
+
+		return len;
+	}
+
 	/* Normalize and scale. */
 	fp_num_t w = normalize(ieee_val.pos_val);
 
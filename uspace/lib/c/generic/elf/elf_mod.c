@@ -37,10 +37,12 @@
  * @brief	Userspace ELF module loader.
  *
  * This module allows loading ELF binaries (both executables and
- * shared objects) from VFS. The current implementation allocates
- * anonymous memory, fills it with segment data and then adjusts
- * the memory areas' flags to the final value. In the future,
- * the segments will be mapped directly from the file.
+ * shared objects) from VFS. Writable segments are populated from
+ * anonymous memory, which is filled with segment data and then has
+ * its flags adjusted to the final value. Read-only segments are,
+ * when possible, mapped directly from the file through the VFS
+ * pager, so that all tasks running images of the same file share
+ * one frame per page and repeat launches need no further I/O.
  */
 
 #include <errno.h>
@@ -51,7 +53,11 @@
 #include <align.h>
 #include <assert.h>
 #include <as.h>
+#include <async.h>
 #include <elf/elf.h>
+#include <fibril_synch.h>
+#include <ipc/services.h>
+#include <ns.h>
 #include <smc.h>
 #include <loader/pcb.h>
 #include <entry_point.h>
@@ -67,6 +73,33 @@ static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
 
+static FIBRIL_MUTEX_INITIALIZE(pager_mutex);
+static async_sess_t *pager_sess = NULL;
+static bool pager_tried = false;
+
+/** Get a session with the VFS pager.
+ *
+ * The session is created on the first use and never closed again. The
+ * kernel uses the pager phone to service page faults for as long as any
+ * area created by load_segment_paged() exists, which may be the entire
+ * lifetime of the task -- even past the loader handing over control to
+ * the newly loaded program.
+ *
+ * @return Pager session or NULL if the pager cannot be contacted.
+ */
+static async_sess_t *elf_pager_session(void)
+{
+	fibril_mutex_lock(&pager_mutex);
+	if (pager_sess == NULL && !pager_tried) {
+		pager_tried = true;
+		pager_sess = service_connect(SERVICE_VFS, INTERFACE_PAGER,
+		    0, NULL);
+	}
+	fibril_mutex_unlock(&pager_mutex);
+
+	return pager_sess;
+}
+
 /** Load ELF binary from a file.
  *
  * Load an ELF binary from the specified file. If the file is
@@ -98,10 +131,17 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 	elf.fd = ofile;
 	elf.info = info;
 	elf.flags = flags;
+	elf.paged = false;
 
 	rc = elf_load_module(&elf);
 
-	vfs_put(ofile);
+	/*
+	 * If some segment is mapped directly from the file, the file
+	 * descriptor must stay open so that the pager can service page
+	 * faults from it.
+	 */
+	if (!elf.paged)
+		vfs_put(ofile);
 	return rc;
 }
 
@@ -371,6 +411,88 @@ static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry)
 	return EOK;
 }
 
+/** Map read-only segment directly from the file.
+ *
+ * Instead of populating an anonymous area with a private copy of the
+ * segment data, create an area backed by the VFS pager. The pages are
+ * then served from the pager's page cache, so all tasks running images
+ * of the same file share one frame per page and repeat launches of a
+ * program (and of its libraries) do not read the data again.
+ *
+ * The pages are faulted in immediately while the loader still runs, so
+ * that execution of the loaded program never blocks on the pager. This
+ * also rules out deadlock should the program end up on the page-in
+ * path itself (e.g. as a file system server).
+ *
+ * @param elf	Loader state.
+ * @param entry Program header entry describing segment to be mapped.
+ *
+ * @return EOK on success, ENOTSUP if the segment cannot be mapped from
+ *	   the file, error code otherwise.
+ */
+static errno_t load_segment_paged(elf_ld_t *elf, elf_segment_header_t *entry)
+{
+	async_sess_t *pager;
+	uintptr_t base;
+	uintptr_t bias;
+	aoff64_t file_base;
+	size_t mem_sz;
+	size_t offs;
+	int flags = 0;
+	volatile uint8_t *seg;
+
+	/*
+	 * Only read-only segments whose file image covers the whole
+	 * memory image can be backed by the file. The caller must not
+	 * intend to modify the segment and the segment must start at
+	 * the same offset within a page in the file and in memory.
+	 */
+	if ((elf->flags & ELDF_RW) != 0)
+		return ENOTSUP;
+	if ((entry->p_flags & PF_W) != 0)
+		return ENOTSUP;
+	if (entry->p_filesz != entry->p_memsz)
+		return ENOTSUP;
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return ENOTSUP;
+
+	pager = elf_pager_session();
+	if (pager == NULL)
+		return ENOTSUP;
+
+	if (entry->p_flags & PF_X)
+		flags |= AS_AREA_EXEC;
+	if (entry->p_flags & PF_R)
+		flags |= AS_AREA_READ;
+	flags |= AS_AREA_CACHEABLE;
+
+	bias = elf->bias;
+	base = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
+	mem_sz = entry->p_memsz + (entry->p_vaddr - base);
+	file_base = entry->p_offset - (entry->p_vaddr - base);
+
+	seg = (volatile uint8_t *) async_as_area_create(
+	    (uint8_t *) base + bias, mem_sz, flags, pager,
+	    (sysarg_t) elf->fd, (sysarg_t) file_base, 0);
+	if (seg == AS_MAP_FAILED) {
+		DPRINTF("memory mapping failed (%p, %zu)\n",
+		    (void *) (base + bias), mem_sz);
+		return ENOTSUP;
+	}
+
+	DPRINTF("Mapped segment from file offset %zu at %p.\n",
+	    (size_t) file_base, (void *) seg);
+
+	/* The file descriptor must stay open to back the mapping. */
+	elf->paged = true;
+
+	/* Pre-fault the pages. */
+	for (offs = 0; offs < mem_sz; offs += PAGE_SIZE)
+		(void) seg[offs];
+
+	return EOK;
+}
+
 /** Load segment described by program header entry.
  *
  * @param elf	Loader state.
@@ -415,6 +537,10 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 		}
 	}
 
+	/* Try to map the segment directly from the file first. */
+	if (load_segment_paged(elf, entry) == EOK)
+		return EOK;
+
 	/* Final flags that will be set for the memory area */
 
 	if (entry->p_flags & PF_X)
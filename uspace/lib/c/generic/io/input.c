@@ -120,17 +120,55 @@ static void input_ev_key(input_t *input, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
-static void input_ev_move(input_t *input, ipc_call_t *call)
+/** Handle relative move event.
+ *
+ * Any relative move events that are already queued behind @a call are
+ * coalesced into a single consumer callback with the summed motion.
+ * A high-rate mouse can produce events faster than a consumer is able
+ * to process them and relative motion is trivially additive, so there
+ * is no point in delivering every event separately. Events of other
+ * types are never reordered with respect to the motion.
+ *
+ * @param input Input service
+ * @param call Move event call. If another event type interrupts the
+ *             coalescing, it is stored here on return.
+ *
+ * @return @c true if @a call contains a new event to be processed by
+ *         the caller, @c false otherwise
+ */
+static bool input_ev_move(input_t *input, ipc_call_t *call)
 {
-	int dx;
-	int dy;
+	ipc_call_t next;
+	bool have_next = false;
+	int dx = 0;
+	int dy = 0;
 	errno_t rc;
 
-	dx = ipc_get_arg1(call);
-	dy = ipc_get_arg2(call);
+	while (true) {
+		dx += (int) ipc_get_arg1(call);
+		dy += (int) ipc_get_arg2(call);
+
+		/* Only coalesce with events that are already queued */
+		if (!async_get_call_timeout(&next, 1))
+			break;
+
+		if (ipc_get_imethod(&next) != INPUT_EVENT_MOVE) {
+			have_next = true;
+			break;
+		}
+
+		/* Merge the new event into the accumulated motion */
+		async_answer_0(call, EOK);
+		*call = next;
+	}
 
 	rc = input->ev_ops->move(input, dx, dy);
 	async_answer_0(call, rc);
+
+	if (have_next)
+		*call = next;
+
+	return have_next;
 }
 
 static void input_ev_abs_move(input_t *input, ipc_call_t *call)
@@ -166,10 +204,14 @@ static void input_ev_button(input_t *input, ipc_call_t *call)
 static void input_cb_conn(ipc_call_t *icall, void *arg)
 {
 	input_t *input = (input_t *) arg;
+	ipc_call_t call;
+	bool have_call = false;
 
 	while (true) {
-		ipc_call_t call;
-		async_get_call(&call);
+		if (!have_call)
+			async_get_call(&call);
+
+		have_call = false;
 
 		if (!ipc_get_imethod(&call)) {
 			async_answer_0(&call, EOK);
@@ -187,7 +229,7 @@ static void input_cb_conn(ipc_call_t *icall, void *arg)
 			input_ev_key(input, &call);
 			break;
 		case INPUT_EVENT_MOVE:
-			input_ev_move(input, &call);
+			have_call = input_ev_move(input, &call);
 			break;
 		case INPUT_EVENT_ABS_MOVE:
 			input_ev_abs_move(input, &call);
@@ -51,6 +51,9 @@
 #include "../private/io.h"
 #include "../private/stdio.h"
 
+/** Upper bound on automatically grown stream buffers */
+#define STDIO_BUF_SIZE_MAX  65536
+
 static void _ffillbuf(FILE *stream);
 static void _fflushbuf(FILE *stream);
 
@@ -273,6 +276,7 @@ int setvbuf(FILE *stream, void *buf, int mode, size_t size)
 	stream->btype = mode;
 	stream->buf = buf;
 	stream->buf_size = size;
+	stream->buf_allocated = false;
 	stream->buf_head = stream->buf;
 	stream->buf_tail = stream->buf;
 	stream->buf_state = _bs_empty;
@@ -322,11 +326,42 @@ static int _fallocbuf(FILE *stream)
 		return EOF;
 	}
 
+	stream->buf_allocated = true;
 	stream->buf_head = stream->buf;
 	stream->buf_tail = stream->buf;
 	return 0;
 }
 
+/** Grow the buffer of a stream used for bulk output.
+ *
+ * Called when the stream buffer was filled completely. Fully buffered
+ * streams with a library-allocated buffer get their buffer doubled, up
+ * to STDIO_BUF_SIZE_MAX, so that the cost of a vfs_write() round trip
+ * is amortized over more data. Failing to grow is not an error; the
+ * stream simply keeps its current buffer.
+ */
+static void _fgrowbuf(FILE *stream)
+{
+	if ((stream->btype != _IOFBF) || (!stream->buf_allocated))
+		return;
+
+	if (stream->buf_size >= STDIO_BUF_SIZE_MAX)
+		return;
+
+	size_t nsize = stream->buf_size * 2;
+	if (nsize > STDIO_BUF_SIZE_MAX)
+		nsize = STDIO_BUF_SIZE_MAX;
+
+	uint8_t *nbuf = realloc(stream->buf, nsize);
+	if (nbuf == NULL)
+		return;
+
+	stream->buf_head = nbuf + (stream->buf_head - stream->buf);
+	stream->buf_tail = nbuf + (stream->buf_tail - stream->buf);
+	stream->buf = nbuf;
+	stream->buf_size = nsize;
+}
+
 /** Open a stream.
  *
  * @param path Path of the file to open.
@@ -434,6 +469,12 @@ static int _fclose_nofree(FILE *stream)
 	if (stream->fd >= 0)
 		rc = vfs_put(stream->fd);
 
+	if (stream->buf_allocated) {
+		free(stream->buf);
+		stream->buf = NULL;
+		stream->buf_allocated = false;
+	}
+
 	list_remove(&stream->link);
 
 	if (rc != EOK) {
@@ -565,10 +606,21 @@ static void _fflushbuf(FILE *stream)
 
 	/* If buffer has unwritten data, we need to write them out. */
 	if (bytes_used > 0 && stream->buf_state == _bs_write) {
-		(void) _fwrite(stream->buf_tail, 1, bytes_used, stream);
+		size_t nwritten = _fwrite(stream->buf_tail, 1, bytes_used,
+		    stream);
 		/* On error stream error indicator and errno are set by _fwrite */
 		if (stream->error)
 			return;
+
+		/*
+		 * A short write without an error: keep the unwritten tail
+		 * in the buffer for the next flush instead of silently
+		 * dropping it.
+		 */
+		if (nwritten < bytes_used) {
+			stream->buf_tail += nwritten;
+			return;
+		}
 	}
 
 	stream->buf_head = stream->buf;
@@ -696,6 +748,32 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	total_written = 0;
 	need_flush = false;
 
+	/*
+	 * When the caller's buffer is at least as large as the stream
+	 * buffer, copying it in would only chop the write into
+	 * buffer-sized pieces. Write out any pending data and send the
+	 * caller's buffer directly. The VFS has no vectored write, so
+	 * the pending data and the new data go out in two calls.
+	 */
+	if (bytes_left >= stream->buf_size) {
+		_fflushbuf(stream);
+
+		/*
+		 * The buffer may be non-empty after a short write;
+		 * fall back to the copying path in that case to keep
+		 * the data ordered.
+		 */
+		if ((!stream->error) && (stream->buf_state == _bs_empty)) {
+			total_written = _fwrite(data, 1, bytes_left, stream);
+
+			if ((stream->btype == _IOLBF) &&
+			    (memchr(data, '\n', total_written) != NULL))
+				fflush(stream);
+
+			return (total_written / size);
+		}
+	}
+
 	while ((!stream->error) && (bytes_left > 0)) {
 		buf_free = stream->buf_size - (stream->buf_head - stream->buf);
 		if (bytes_left > buf_free)
@@ -721,8 +799,16 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 		if (buf_free == 0) {
 			/* Only need to drain buffer. */
 			_fflushbuf(stream);
-			if (!stream->error)
+			if (!stream->error) {
 				need_flush = false;
+
+				/*
+				 * A completely filled buffer indicates
+				 * bulk output; amortize the flushes
+				 * over a larger buffer.
+				 */
+				_fgrowbuf(stream);
+			}
 		}
 	}
 
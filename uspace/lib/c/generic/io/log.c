@@ -31,10 +31,14 @@
  * @{
  */
 
+#include <align.h>
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
 #include <fibril_synch.h>
+#include <mem.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <async.h>
@@ -63,6 +67,12 @@ static const char *log_level_names[] = {
 /** IPC session with the logger service. */
 static async_sess_t *logger_session;
 
+/** Ring buffer shared with the logger service (NULL when not set up). */
+static logger_ring_t *log_ring = NULL;
+
+/** Serializes writers appending to the shared ring buffer. */
+static FIBRIL_MUTEX_INITIALIZE(log_ring_mutex);
+
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
@@ -108,6 +118,112 @@ static errno_t logger_message(async_sess_t *session, log_t log, log_level_t leve
 	return reg_msg_rc;
 }
 
+/** Try to establish the shared ring buffer transport.
+ *
+ * Failure is not fatal, messages simply keep using the synchronous
+ * IPC path.
+ */
+static void log_ring_setup(void)
+{
+	size_t size = ALIGN_UP(sizeof(logger_ring_t), PAGE_SIZE);
+
+	logger_ring_t *ring = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring == AS_MAP_FAILED)
+		return;
+
+	memset(ring, 0, sizeof(logger_ring_t));
+
+	async_exch_t *exchange = async_exchange_begin(logger_session);
+	if (exchange == NULL) {
+		as_area_destroy(ring);
+		return;
+	}
+
+	aid_t reg_msg = async_send_0(exchange, LOGGER_WRITER_RING, NULL);
+	errno_t rc = async_share_out_start(exchange, ring,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	errno_t reg_msg_rc;
+	async_wait_for(reg_msg, &reg_msg_rc);
+
+	async_exchange_end(exchange);
+
+	if ((rc != EOK) || (reg_msg_rc != EOK)) {
+		as_area_destroy(ring);
+		return;
+	}
+
+	log_ring = ring;
+}
+
+/** Append a message to the shared ring buffer.
+ *
+ * On overflow the oldest record in the ring is dropped. The logger
+ * is poked with an asynchronous flush request only when none is
+ * outstanding, so bursts of messages cost a single round-trip.
+ *
+ * @param log   Log to use.
+ * @param level Severity level of the message.
+ * @param kind  Kind of the record payload.
+ * @param data  The record payload.
+ * @param size  Size of the record payload in bytes.
+ *
+ * @return True if the record was handed over to the ring.
+ *
+ */
+static bool log_ring_append(log_t log, log_level_t level,
+    logger_rec_kind_t kind, const void *data, size_t size)
+{
+	if ((log_ring == NULL) || (size > LOGGER_RING_MSG_SIZE))
+		return false;
+
+	/* Text records need room for the terminating zero in the slot. */
+	if ((kind == LOGGER_REC_TEXT) && (size >= LOGGER_RING_MSG_SIZE))
+		return false;
+
+	fibril_mutex_lock(&log_ring_mutex);
+
+	size_t head = atomic_load(&log_ring->head);
+	size_t tail = atomic_load(&log_ring->tail);
+
+	if (head - tail == LOGGER_RING_SLOTS) {
+		/*
+		 * Ring full: drop the oldest record. If the logger consumes
+		 * it concurrently, the CAS fails and the slot is free anyway.
+		 */
+		if (atomic_compare_exchange_strong(&log_ring->tail, &tail,
+		    tail + 1))
+			atomic_fetch_add(&log_ring->dropped, 1);
+	}
+
+	logger_ring_slot_t *slot =
+	    &log_ring->slot[head & (LOGGER_RING_SLOTS - 1)];
+
+	atomic_store(&slot->seq, head);
+	slot->log_id = (log == LOG_DEFAULT) ? default_log_id : log;
+	slot->level = level;
+	slot->kind = kind;
+	slot->size = (uint32_t) size;
+	memcpy(slot->text, data, size);
+
+	atomic_store(&log_ring->head, head + 1);
+
+	/* Poke the logger unless a flush request is already outstanding. */
+	if (atomic_load(&log_ring->flush_pending) == 0) {
+		atomic_store(&log_ring->flush_pending, 1);
+
+		async_exch_t *exchange = async_exchange_begin(logger_session);
+		if (exchange != NULL) {
+			async_msg_0(exchange, LOGGER_WRITER_FLUSH);
+			async_exchange_end(exchange);
+		}
+	}
+
+	fibril_mutex_unlock(&log_ring_mutex);
+
+	return true;
+}
+
 /** Get name of the log level.
  *
  * @param level The log level.
@@ -174,6 +290,8 @@ errno_t log_init(const char *prog_name)
 
 	default_log_id = log_create(prog_name, LOG_NO_PARENT);
 
+	log_ring_setup();
+
 	return EOK;
 }
 
@@ -239,12 +357,41 @@ void log_msgv(log_t ctx, log_level_t level, const char *fmt, va_list args)
 {
 	assert(level < LVL_LIMIT);
 
+	/*
+	 * Try to ship the message as a binary record first: the format
+	 * string and the raw arguments are packed with a few copies and
+	 * the rendering is deferred to the logger, which only performs
+	 * it for messages that pass the level filter.
+	 */
+	if (log_ring != NULL) {
+		uint8_t record[LOGGER_RING_MSG_SIZE];
+		size_t record_size;
+
+		va_list cargs;
+		va_copy(cargs, args);
+		errno_t rc = log_fmt_encode(record, sizeof(record),
+		    &record_size, fmt, cargs);
+		va_end(cargs);
+
+		if ((rc == EOK) && (log_ring_append(ctx, level,
+		    LOGGER_REC_BINARY, record, record_size)))
+			return;
+	}
+
 	char *message_buffer = malloc(MESSAGE_BUFFER_SIZE);
 	if (message_buffer == NULL)
 		return;
 
 	vsnprintf(message_buffer, MESSAGE_BUFFER_SIZE, fmt, args);
-	logger_message(logger_session, ctx, level, message_buffer);
+
+	// FIXME: remove when all USB drivers use libc logging explicitly
+	str_rtrim(message_buffer, '\n');
+
+	/* Messages too long for a ring slot use the synchronous path. */
+	if (!log_ring_append(ctx, level, LOGGER_REC_TEXT, message_buffer,
+	    str_size(message_buffer)))
+		logger_message(logger_session, ctx, level, message_buffer);
+
 	free(message_buffer);
 }
 
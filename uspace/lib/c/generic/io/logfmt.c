@@ -0,0 +1,504 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+
+/** @file
+ * Binary log record encoding and deferred rendering.
+ *
+ * A binary log record consists of the printf-style format string
+ * (including the terminating zero) followed by the packed arguments
+ * in the order in which the conversions reference them. Integer,
+ * character and pointer arguments are widened to eight bytes, string
+ * arguments are stored inline including the terminating zero. The
+ * argument types are not stored; the decoder re-parses the format
+ * string to recover them.
+ *
+ * Producers encode a record with a few copies instead of rendering
+ * the message; the consumer renders it only if the message passes
+ * the level filter. Format strings using conversions that cannot be
+ * re-parsed safely (dynamic field widths, wide strings and other
+ * exotic conversions) are rejected by the encoder and the caller
+ * falls back to eager formatting.
+ */
+
+#include <errno.h>
+#include <io/log.h>
+#include <mem.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <str.h>
+
+/** Maximum size of a single re-assembled conversion specification. */
+#define SPEC_BUFFER_SIZE  32
+
+/** Length modifiers of a conversion specification. */
+typedef enum {
+	LEN_NONE,
+	LEN_HH,
+	LEN_H,
+	LEN_L,
+	LEN_LL,
+	LEN_Z,
+	LEN_J,
+	LEN_T
+} fmt_len_mod_t;
+
+/** Parse one conversion specification.
+ *
+ * Advance @a *fmtp past one conversion specification (the leading
+ * '%' already consumed) and classify its length modifier and
+ * conversion character. Only specifications that the decoder can
+ * re-assemble are accepted.
+ *
+ * @param fmtp    Pointer to the format string position, updated.
+ * @param len_mod Place to store the length modifier.
+ * @param conv    Place to store the conversion character.
+ *
+ * @return EOK on success.
+ * @return ENOTSUP if the specification cannot be encoded.
+ *
+ */
+static errno_t fmt_parse_spec(const char **fmtp, fmt_len_mod_t *len_mod,
+    char *conv)
+{
+	const char *fmt = *fmtp;
+
+	/* Flags */
+	while ((*fmt == '-') || (*fmt == '+') || (*fmt == ' ') ||
+	    (*fmt == '#') || (*fmt == '0'))
+		fmt++;
+
+	/* Field width (dynamic widths cannot be re-parsed) */
+	if (*fmt == '*')
+		return ENOTSUP;
+	while ((*fmt >= '0') && (*fmt <= '9'))
+		fmt++;
+
+	/* Precision */
+	if (*fmt == '.') {
+		fmt++;
+		if (*fmt == '*')
+			return ENOTSUP;
+		while ((*fmt >= '0') && (*fmt <= '9'))
+			fmt++;
+	}
+
+	/* Length modifier */
+	*len_mod = LEN_NONE;
+	switch (*fmt) {
+	case 'h':
+		fmt++;
+		if (*fmt == 'h') {
+			fmt++;
+			*len_mod = LEN_HH;
+		} else
+			*len_mod = LEN_H;
+		break;
+	case 'l':
+		fmt++;
+		if (*fmt == 'l') {
+			fmt++;
+			*len_mod = LEN_LL;
+		} else
+			*len_mod = LEN_L;
+		break;
+	case 'z':
+		fmt++;
+		*len_mod = LEN_Z;
+		break;
+	case 'j':
+		fmt++;
+		*len_mod = LEN_J;
+		break;
+	case 't':
+		fmt++;
+		*len_mod = LEN_T;
+		break;
+	default:
+		break;
+	}
+
+	*conv = *fmt;
+	if (*conv == 0)
+		return ENOTSUP;
+
+	*fmtp = fmt + 1;
+
+	switch (*conv) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'p':
+	case '%':
+		return EOK;
+	case 'c':
+	case 's':
+		/* Wide characters and strings cannot be copied byte for byte */
+		if (*len_mod != LEN_NONE)
+			return ENOTSUP;
+		return EOK;
+	default:
+		return ENOTSUP;
+	}
+}
+
+/** Append bytes to a binary log record.
+ *
+ * @param dest      Destination buffer.
+ * @param dest_size Size of the destination buffer.
+ * @param pos       Current position, updated on success.
+ * @param data      Bytes to append.
+ * @param size      Number of bytes to append.
+ *
+ * @return EOK on success, EOVERFLOW if the record does not fit.
+ *
+ */
+static errno_t fmt_append(void *dest, size_t dest_size, size_t *pos,
+    const void *data, size_t size)
+{
+	if ((size > dest_size) || (*pos > dest_size - size))
+		return EOVERFLOW;
+
+	memcpy((uint8_t *) dest + *pos, data, size);
+	*pos += size;
+
+	return EOK;
+}
+
+/** Encode a log message into a binary record.
+ *
+ * Pack the format string and the raw arguments into @a dest without
+ * rendering the message. The caller is expected to fall back to
+ * eager formatting if the encoding fails.
+ *
+ * @param dest      Destination buffer.
+ * @param dest_size Size of the destination buffer.
+ * @param nused     Place to store the size of the encoded record.
+ * @param fmt       Format string in printf-like format.
+ * @param args      Arguments.
+ *
+ * @return EOK on success.
+ * @return ENOTSUP if the format string cannot be encoded.
+ * @return EOVERFLOW if the record does not fit into the buffer.
+ *
+ */
+errno_t log_fmt_encode(void *dest, size_t dest_size, size_t *nused,
+    const char *fmt, va_list args)
+{
+	size_t pos = 0;
+	errno_t rc = fmt_append(dest, dest_size, &pos, fmt,
+	    str_size(fmt) + 1);
+	if (rc != EOK)
+		return rc;
+
+	while (*fmt != 0) {
+		if (*fmt++ != '%')
+			continue;
+
+		fmt_len_mod_t len_mod;
+		char conv;
+		rc = fmt_parse_spec(&fmt, &len_mod, &conv);
+		if (rc != EOK)
+			return rc;
+
+		int64_t sval;
+		uint64_t uval;
+		const char *str;
+
+		switch (conv) {
+		case '%':
+			break;
+		case 'd':
+		case 'i':
+			switch (len_mod) {
+			case LEN_L:
+				sval = va_arg(args, long);
+				break;
+			case LEN_LL:
+				sval = va_arg(args, long long);
+				break;
+			case LEN_Z:
+				sval = (int64_t) va_arg(args, size_t);
+				break;
+			case LEN_J:
+				sval = va_arg(args, intmax_t);
+				break;
+			case LEN_T:
+				sval = va_arg(args, ptrdiff_t);
+				break;
+			case LEN_HH:
+				sval = (signed char) va_arg(args, int);
+				break;
+			case LEN_H:
+				sval = (short) va_arg(args, int);
+				break;
+			default:
+				sval = va_arg(args, int);
+				break;
+			}
+			rc = fmt_append(dest, dest_size, &pos, &sval,
+			    sizeof(sval));
+			if (rc != EOK)
+				return rc;
+			break;
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			switch (len_mod) {
+			case LEN_L:
+				uval = va_arg(args, unsigned long);
+				break;
+			case LEN_LL:
+				uval = va_arg(args, unsigned long long);
+				break;
+			case LEN_Z:
+				uval = va_arg(args, size_t);
+				break;
+			case LEN_J:
+				uval = va_arg(args, uintmax_t);
+				break;
+			case LEN_T:
+				uval = (uint64_t) va_arg(args, ptrdiff_t);
+				break;
+			case LEN_HH:
+				uval = (unsigned char) va_arg(args, unsigned int);
+				break;
+			case LEN_H:
+				uval = (unsigned short) va_arg(args, unsigned int);
+				break;
+			default:
+				uval = va_arg(args, unsigned int);
+				break;
+			}
+			rc = fmt_append(dest, dest_size, &pos, &uval,
+			    sizeof(uval));
+			if (rc != EOK)
+				return rc;
+			break;
+		case 'c':
+			sval = va_arg(args, int);
+			rc = fmt_append(dest, dest_size, &pos, &sval,
+			    sizeof(sval));
+			if (rc != EOK)
+				return rc;
+			break;
+		case 'p':
+			uval = (uint64_t) (uintptr_t) va_arg(args, void *);
+			rc = fmt_append(dest, dest_size, &pos, &uval,
+			    sizeof(uval));
+			if (rc != EOK)
+				return rc;
+			break;
+		case 's':
+			str = va_arg(args, const char *);
+			if (str == NULL)
+				str = "(NULL)";
+			rc = fmt_append(dest, dest_size, &pos, str,
+			    str_size(str) + 1);
+			if (rc != EOK)
+				return rc;
+			break;
+		default:
+			return ENOTSUP;
+		}
+	}
+
+	*nused = pos;
+	return EOK;
+}
+
+/** Append a character to the rendered message.
+ *
+ * The output is silently truncated, matching snprintf() semantics.
+ *
+ * @param dest      Destination buffer.
+ * @param dest_size Size of the destination buffer.
+ * @param pos       Current position, updated.
+ * @param c         Character to append.
+ *
+ */
+static void render_putc(char *dest, size_t dest_size, size_t *pos, char c)
+{
+	if (*pos + 1 < dest_size)
+		dest[*pos] = c;
+
+	(*pos)++;
+}
+
+/** Render a binary log record into a message string.
+ *
+ * Re-parse the format string stored in the record and format each
+ * conversion with the packed argument that follows it. This is the
+ * deferred counterpart of the rendering the producer skipped in
+ * log_fmt_encode().
+ *
+ * @param rec       Binary record as produced by log_fmt_encode().
+ * @param rec_size  Size of the record.
+ * @param dest      Destination buffer for the rendered message.
+ * @param dest_size Size of the destination buffer.
+ *
+ * @return EOK on success (the message may be truncated).
+ * @return EINVAL if the record is malformed.
+ *
+ */
+errno_t log_fmt_render(const void *rec, size_t rec_size, char *dest,
+    size_t dest_size)
+{
+	const char *fmt = (const char *) rec;
+	size_t fmt_size = str_nsize(fmt, rec_size);
+	if (fmt_size >= rec_size)
+		return EINVAL;
+
+	size_t apos = fmt_size + 1;
+	size_t pos = 0;
+
+	if (dest_size == 0)
+		return EINVAL;
+
+	while (*fmt != 0) {
+		if (*fmt != '%') {
+			render_putc(dest, dest_size, &pos, *fmt++);
+			continue;
+		}
+
+		const char *spec_start = fmt;
+		fmt++;
+
+		fmt_len_mod_t len_mod;
+		char conv;
+		if (fmt_parse_spec(&fmt, &len_mod, &conv) != EOK)
+			return EINVAL;
+
+		if (conv == '%') {
+			render_putc(dest, dest_size, &pos, '%');
+			continue;
+		}
+
+		/*
+		 * Re-assemble the specification with the length modifier
+		 * normalized to 'll' so that the widened argument can be
+		 * passed to snprintf() directly.
+		 */
+		char spec[SPEC_BUFFER_SIZE];
+		size_t spec_len = (size_t) (fmt - spec_start - 1) -
+		    ((len_mod != LEN_NONE) ? ((len_mod == LEN_HH) ||
+		    (len_mod == LEN_LL) ? 2 : 1) : 0);
+		if (spec_len + 4 > SPEC_BUFFER_SIZE)
+			return EINVAL;
+
+		memcpy(spec, spec_start, spec_len);
+
+		size_t si = spec_len;
+		if ((conv != 'c') && (conv != 's') && (conv != 'p')) {
+			spec[si++] = 'l';
+			spec[si++] = 'l';
+		}
+		spec[si++] = conv;
+		spec[si] = 0;
+
+		/* Measure truncated conversions against a dummy buffer */
+		char dummy[1];
+		size_t avail = (pos < dest_size) ? dest_size - pos : 1;
+		char *out = (pos < dest_size) ? dest + pos : dummy;
+		int printed;
+
+		uint64_t uval;
+		const char *str;
+		size_t str_sz;
+
+		switch (conv) {
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c':
+			if (apos + sizeof(uval) > rec_size)
+				return EINVAL;
+			memcpy(&uval, (const uint8_t *) rec + apos,
+			    sizeof(uval));
+			apos += sizeof(uval);
+
+			if (conv == 'c')
+				printed = snprintf(out, avail, spec,
+				    (int) uval);
+			else if ((conv == 'd') || (conv == 'i'))
+				printed = snprintf(out, avail, spec,
+				    (long long) uval);
+			else
+				printed = snprintf(out, avail, spec,
+				    (unsigned long long) uval);
+			break;
+		case 'p':
+			if (apos + sizeof(uval) > rec_size)
+				return EINVAL;
+			memcpy(&uval, (const uint8_t *) rec + apos,
+			    sizeof(uval));
+			apos += sizeof(uval);
+
+			printed = snprintf(out, avail, "%p",
+			    (void *) (uintptr_t) uval);
+			break;
+		case 's':
+			str = (const char *) rec + apos;
+			str_sz = str_nsize(str, rec_size - apos);
+			if (apos + str_sz >= rec_size)
+				return EINVAL;
+			apos += str_sz + 1;
+
+			printed = snprintf(out, avail, spec, str);
+			break;
+		default:
+			return EINVAL;
+		}
+
+		if (printed < 0)
+			return EINVAL;
+
+		pos += (size_t) printed;
+	}
+
+	if (pos >= dest_size)
+		pos = dest_size - 1;
+	dest[pos] = 0;
+
+	return EOK;
+}
+
+/** @}
+ */
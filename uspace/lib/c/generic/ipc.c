@@ -109,6 +109,19 @@ errno_t ipc_call_async_slow(cap_phone_handle_t phandle, sysarg_t imethod,
 	    (sysarg_t) label);
 }
 
+/** Make a batch of asynchronous calls in a single syscall.
+ *
+ * @param requests  Array of call requests.
+ * @param count     Number of requests in the array.
+ *
+ * @return Number of calls successfully submitted.
+ */
+size_t ipc_call_async_batch(ipc_call_request_t *requests, size_t count)
+{
+	return __SYSCALL2(SYS_IPC_CALL_ASYNC_BATCH, (sysarg_t) requests,
+	    count);
+}
+
 /** Answer received call (fast version).
  *
  * The fast answer makes use of passing retval and first four arguments in
@@ -176,6 +189,26 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for a batch of incoming calls or answers.
+ *
+ * The first call/answer is waited for according to @a usec and @a flags;
+ * further calls/answers already queued are reaped without blocking, up to
+ * @a count in total.
+ *
+ * @param calls  Array of call data buffers to fill in.
+ * @param count  Number of entries in the array.
+ * @param usec   Timeout for the first call/answer.
+ * @param flags  Flags passed to the wait for the first call/answer.
+ *
+ * @return Number of calls/answers stored in the array.
+ */
+size_t ipc_wait_batch(ipc_call_t *calls, size_t count, sysarg_t usec,
+    unsigned int flags)
+{
+	return __SYSCALL4(SYS_IPC_WAIT_BATCH, (sysarg_t) calls, count, usec,
+	    flags);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
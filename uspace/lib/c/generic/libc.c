@@ -48,6 +48,7 @@
 #include "private/libc.h"
 #include "private/async.h"
 #include "private/malloc.h"
+#include "private/mem.h"
 #include "private/io.h"
 #include "private/fibril.h"
 
@@ -64,6 +65,8 @@ void __libc_main(void *pcb_ptr)
 {
 	__kio_init();
 
+	__mem_init();
+
 	assert(!__tcb_is_set());
 
 	__pcb = (pcb_t *) pcb_ptr;
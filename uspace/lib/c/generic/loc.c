@@ -847,6 +847,100 @@ errno_t loc_category_get_svcs(category_id_t cat_id, service_id_t **data,
 	    data, count);
 }
 
+static errno_t loc_category_get_svcs_since_once(category_id_t cat_id,
+    sysarg_t since_gen, service_id_t *id_buf, size_t buf_size,
+    size_t *act_size, sysarg_t *rgen, bool *full)
+{
+	async_exch_t *exch = loc_exchange_begin_blocking(INTERFACE_LOC_CONSUMER);
+
+	ipc_call_t answer;
+	aid_t req = async_send_2(exch, LOC_CATEGORY_GET_SVCS_SINCE, cat_id,
+	    since_gen, &answer);
+	errno_t rc = async_data_read_start(exch, id_buf, buf_size);
+
+	loc_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	if (retval != EOK) {
+		return retval;
+	}
+
+	*act_size = ipc_get_arg1(&answer);
+	*rgen = ipc_get_arg2(&answer);
+	*full = ipc_get_arg3(&answer) != 0;
+	return EOK;
+}
+
+/** Get list of services added to category since a known generation.
+ *
+ * Returns an allocated array of service IDs. On the first call pass
+ * zero as @a since_gen to get the complete list. Afterwards pass the
+ * generation stored in @a *rgen by the previous call: if @a *full is
+ * false the array contains just the services added since then,
+ * otherwise it is again the complete membership (this happens when
+ * a service has been removed from the category in the meantime).
+ *
+ * @param cat_id	Category ID
+ * @param since_gen	Generation known to the caller (zero for full list)
+ * @param rgen		Place to store the current generation
+ * @param full		Place to store whether a full list was returned
+ * @param data		Place to store pointer to array of IDs
+ * @param count		Place to store number of IDs
+ * @return 		EOK on success or an error code
+ */
+errno_t loc_category_get_svcs_since(category_id_t cat_id, sysarg_t since_gen,
+    sysarg_t *rgen, bool *full, service_id_t **data, size_t *count)
+{
+	*data = NULL;
+	*count = 0;
+
+	size_t act_size = 0;
+	sysarg_t gen = 0;
+	bool f = false;
+	errno_t rc = loc_category_get_svcs_since_once(cat_id, since_gen,
+	    NULL, 0, &act_size, &gen, &f);
+	if (rc != EOK)
+		return rc;
+
+	size_t alloc_size = act_size;
+	service_id_t *ids = malloc(alloc_size);
+	if (ids == NULL)
+		return ENOMEM;
+
+	while (true) {
+		rc = loc_category_get_svcs_since_once(cat_id, since_gen, ids,
+		    alloc_size, &act_size, &gen, &f);
+		if (rc != EOK) {
+			free(ids);
+			return rc;
+		}
+
+		if (act_size <= alloc_size)
+			break;
+
+		alloc_size = act_size;
+		service_id_t *tmp = realloc(ids, alloc_size);
+		if (tmp == NULL) {
+			free(ids);
+			return ENOMEM;
+		}
+		ids = tmp;
+	}
+
+	*rgen = gen;
+	*full = f;
+	*count = act_size / sizeof(service_id_t);
+	*data = ids;
+	return EOK;
+}
+
 /** Get list of categories.
  *
  * Returns an allocated array of category IDs.
@@ -45,6 +45,7 @@
 #include <bitops.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <adt/list.h>
 #include <adt/gcdlcm.h>
 
 #include "private/malloc.h"
@@ -77,6 +78,16 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Heap decommit granularity
+ *
+ * The interior of a free block is returned to the kernel
+ * only if it spans at least this many whole pages, so small
+ * free blocks are not bounced between the allocator and the
+ * kernel on every free and reuse.
+ *
+ */
+#define DECOMMIT_GRANULARITY  (8 * PAGE_SIZE)
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -197,6 +208,36 @@ static heap_block_head_t *next_fit = NULL;
 /** Futex for thread-safe heap manipulation */
 static fibril_rmutex_t malloc_mutex;
 
+/** Maximum net block size served from the quick lists. */
+#define QUICK_NET_MAX  (32 * BASE_ALIGN)
+
+/** Number of quick lists, one per size class of BASE_ALIGN granularity. */
+#define QUICK_LISTS  (QUICK_NET_MAX / BASE_ALIGN + 1)
+
+/** Maximum number of blocks kept on one quick list. */
+#define QUICK_LIST_MAX  32
+
+/** Number of blocks returned to the heap when a quick list is full. */
+#define QUICK_FLUSH  (QUICK_LIST_MAX / 2)
+
+/** Number of blocks carved from the heap when a quick list is empty. */
+#define QUICK_REFILL  8
+
+/** Quick lists of free blocks of small size classes.
+ *
+ * Small freed blocks of an exactly fitting size class are kept on these
+ * lists instead of being coalesced, and malloc() of a small size pops a
+ * recycled block without searching the heap. The cached blocks stay
+ * marked as allocated, so the regular heap machinery never merges or
+ * shrinks them away. When a list runs empty, it is refilled with a batch
+ * of blocks; when it overflows, a batch is returned to the heap, which
+ * bounds the memory held by the lists.
+ */
+static list_t quick_list[QUICK_LISTS];
+
+/** Number of blocks on each quick list. */
+static size_t quick_count[QUICK_LISTS];
+
 #define malloc_assert(expr) safe_assert(expr)
 
 /*
@@ -495,6 +536,9 @@ void __malloc_init(void)
 	if (fibril_rmutex_initialize(&malloc_mutex) != EOK)
 		abort();
 
+	for (size_t idx = 0; idx < QUICK_LISTS; idx++)
+		list_initialize(&quick_list[idx]);
+
 	if (!area_create(PAGE_SIZE))
 		abort();
 }
@@ -772,6 +816,176 @@ static void *malloc_internal(const size_t size, const size_t align)
 	return heap_grow_and_alloc(gross_size, falign);
 }
 
+/** Return the interior of a large free block to the kernel
+ *
+ * Should be called only inside the critical section.
+ * The block header and footer are preserved, only the whole pages
+ * strictly between them are decommitted. The pages stay part of the
+ * heap area, read back as zeros and are committed again lazily when
+ * the block is reused. Small blocks are left alone, see
+ * DECOMMIT_GRANULARITY.
+ *
+ * @param head Header of a free block.
+ *
+ */
+static void heap_decommit(heap_block_head_t *head)
+{
+	malloc_assert(head->free);
+
+	uintptr_t inner_start = ALIGN_UP((uintptr_t) head +
+	    sizeof(heap_block_head_t), PAGE_SIZE);
+	uintptr_t inner_end = ALIGN_DOWN((uintptr_t) BLOCK_FOOT(head),
+	    PAGE_SIZE);
+
+	if ((inner_start >= inner_end) ||
+	    (inner_end - inner_start < DECOMMIT_GRANULARITY))
+		return;
+
+	/* Best effort only, the block stays usable either way. */
+	(void) as_area_decommit((void *) inner_start,
+	    inner_end - inner_start);
+}
+
+/** Free a heap block back to its heap area
+ *
+ * Should be called only inside the critical section.
+ * The block is coalesced with its free neighbours and
+ * the heap area is shrunk if possible.
+ *
+ * @param head Header of the block to free.
+ *
+ */
+static void free_internal(heap_block_head_t *head)
+{
+	heap_area_t *area = head->area;
+
+	/* Mark the block itself as free. */
+	head->free = true;
+
+	/* Look at the next block. If it is free, merge the two. */
+	heap_block_head_t *next_head =
+	    (heap_block_head_t *) (((void *) head) + head->size);
+
+	if ((void *) next_head < area->end) {
+		block_check(next_head);
+		if (next_head->free)
+			block_init(head, head->size + next_head->size, true, area);
+	}
+
+	/* Look at the previous block. If it is free, merge the two. */
+	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
+		heap_block_foot_t *prev_foot =
+		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
+
+		heap_block_head_t *prev_head =
+		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+
+		block_check(prev_head);
+
+		if (prev_head->free) {
+			block_init(prev_head, prev_head->size + head->size, true,
+			    area);
+			head = prev_head;
+		}
+	}
+
+	heap_decommit(head);
+	heap_shrink(area);
+}
+
+/** Try to place a freed block on its quick list
+ *
+ * Should be called only inside the critical section.
+ * Blocks that do not exactly match a size class are not
+ * cached. If the target list is already full, a batch of
+ * cached blocks is returned to the heap to make room.
+ *
+ * @param head Header of the block being freed.
+ *
+ * @return True if the block was cached on a quick list.
+ *
+ */
+static bool quick_push(heap_block_head_t *head)
+{
+	size_t net_size = NET_SIZE(head->size);
+
+	if ((net_size > QUICK_NET_MAX) || (net_size % BASE_ALIGN != 0) ||
+	    (net_size < sizeof(link_t)))
+		return false;
+
+	size_t idx = net_size / BASE_ALIGN;
+
+	if (quick_count[idx] >= QUICK_LIST_MAX) {
+		/* List full -> flush a batch of blocks back to the heap. */
+		for (size_t i = 0; i < QUICK_FLUSH; i++) {
+			link_t *link = list_first(&quick_list[idx]);
+			list_remove(link);
+			quick_count[idx]--;
+
+			free_internal((heap_block_head_t *)
+			    (((void *) link) - sizeof(heap_block_head_t)));
+		}
+	}
+
+	/* The cached block stays marked as allocated. */
+	link_t *link = (link_t *) (((void *) head) + sizeof(heap_block_head_t));
+	link_initialize(link);
+	list_append(link, &quick_list[idx]);
+	quick_count[idx]++;
+
+	return true;
+}
+
+/** Allocate a small memory block from the quick lists
+ *
+ * Should be called only inside the critical section.
+ * If the matching quick list is empty, a batch of blocks
+ * is carved from the heap to refill it.
+ *
+ * @param size The net size of the block to allocate.
+ *
+ * @return Address of the allocated block or NULL if the size
+ *         is not served by the quick lists or on not enough
+ *         memory.
+ *
+ */
+static void *quick_malloc(const size_t size)
+{
+	size_t net_size = ALIGN_UP(size, BASE_ALIGN);
+
+	if ((net_size > QUICK_NET_MAX) || (net_size < sizeof(link_t)))
+		return NULL;
+
+	size_t idx = net_size / BASE_ALIGN;
+
+	if (list_empty(&quick_list[idx])) {
+		/* List empty -> refill it with a batch of fresh blocks. */
+		for (size_t i = 1; i < QUICK_REFILL; i++) {
+			void *addr = malloc_internal(net_size, BASE_ALIGN);
+			if (addr == NULL)
+				break;
+
+			heap_block_head_t *head = (heap_block_head_t *)
+			    (addr - sizeof(heap_block_head_t));
+
+			/*
+			 * A block enlarged by split_mark() might not match
+			 * the size class, put it back in that case.
+			 */
+			if (!quick_push(head))
+				free_internal(head);
+		}
+
+		return malloc_internal(net_size, BASE_ALIGN);
+	}
+
+	link_t *link = list_first(&quick_list[idx]);
+	list_remove(link);
+	quick_count[idx]--;
+
+	return (void *) link;
+}
+
 /** Allocate memory by number of elements
  *
  * @param nmemb Number of members to allocate.
@@ -802,7 +1016,12 @@ void *calloc(const size_t nmemb, const size_t size)
 void *malloc(const size_t size)
 {
 	heap_lock();
-	void *block = malloc_internal(size, BASE_ALIGN);
+
+	/* Serve small sizes from the quick lists. */
+	void *block = quick_malloc(size);
+	if (block == NULL)
+		block = malloc_internal(size, BASE_ALIGN);
+
 	heap_unlock();
 
 	return block;
@@ -973,35 +1192,9 @@ void free(void *const addr)
 	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
 	malloc_assert((void *) head < area->end);
 
-	/* Mark the block itself as free. */
-	head->free = true;
-
-	/* Look at the next block. If it is free, merge the two. */
-	heap_block_head_t *next_head =
-	    (heap_block_head_t *) (((void *) head) + head->size);
-
-	if ((void *) next_head < area->end) {
-		block_check(next_head);
-		if (next_head->free)
-			block_init(head, head->size + next_head->size, true, area);
-	}
-
-	/* Look at the previous block. If it is free, merge the two. */
-	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-		heap_block_foot_t *prev_foot =
-		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
-
-		heap_block_head_t *prev_head =
-		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
-
-		block_check(prev_head);
-
-		if (prev_head->free)
-			block_init(prev_head, prev_head->size + head->size, true,
-			    area);
-	}
-
-	heap_shrink(area);
+	/* Keep small blocks on the quick lists for reuse. */
+	if (!quick_push(head))
+		free_internal(head);
 
 	heap_unlock();
 }
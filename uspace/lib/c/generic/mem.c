@@ -34,10 +34,171 @@
  */
 
 #include <mem.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdalign.h>
+#include <libarch/mem.h>
 #include "private/cc.h"
+#include "private/mem.h"
+
+#ifdef MEM_ARCH_SSE2
+
+/** Minimum block length for taking the SSE2 path. */
+#define SSE2_THRESHOLD  128
+
+/** Whether the SSE2 block routines were detected at initialization. */
+static bool mem_sse2 = false;
+
+/** Fill memory block using unaligned 16-byte SSE2 stores.
+ *
+ * The destination is first aligned to a 16-byte boundary with
+ * plain byte stores, the bulk is filled 64 bytes per iteration
+ * and the tail is finished with byte stores again.
+ */
+MEM_ARCH_SSE2_ATTR
+    static void *memset_sse2(void *dest, int b, size_t n)
+{
+	uint8_t *dstb = dest;
+
+	alignas(16) struct {
+		uint8_t b[16];
+	} pattern;
+
+	for (size_t i = 0; i < sizeof(pattern.b); i++)
+		pattern.b[i] = (uint8_t) b;
+
+	/* Align the destination to 16 bytes. */
+	size_t fill = (-(uintptr_t) dstb) & 15;
+	n -= fill;
+	while (fill-- != 0)
+		*dstb++ = (uint8_t) b;
+
+	/* Fill the aligned bulk. */
+	size_t cnt = n / 64;
+	if (cnt > 0) {
+		asm volatile (
+		    "movdqa %[pat], %%xmm0\n"
+		    "0:\n"
+		    "movdqa %%xmm0, 0(%[dst])\n"
+		    "movdqa %%xmm0, 16(%[dst])\n"
+		    "movdqa %%xmm0, 32(%[dst])\n"
+		    "movdqa %%xmm0, 48(%[dst])\n"
+		    "add $64, %[dst]\n"
+		    "dec %[cnt]\n"
+		    "jnz 0b\n"
+		    : [dst] "+r" (dstb), [cnt] "+r" (cnt)
+		    : [pat] "m" (pattern)
+		    : "xmm0", "cc", "memory"
+		);
+		n %= 64;
+	}
+
+	cnt = n / 16;
+	if (cnt > 0) {
+		asm volatile (
+		    "movdqa %[pat], %%xmm0\n"
+		    "0:\n"
+		    "movdqa %%xmm0, 0(%[dst])\n"
+		    "add $16, %[dst]\n"
+		    "dec %[cnt]\n"
+		    "jnz 0b\n"
+		    : [dst] "+r" (dstb), [cnt] "+r" (cnt)
+		    : [pat] "m" (pattern)
+		    : "xmm0", "cc", "memory"
+		);
+		n %= 16;
+	}
+
+	/* Fill the final segment. */
+	while (n-- != 0)
+		*dstb++ = (uint8_t) b;
+
+	return dest;
+}
+
+/** Copy memory block using 16-byte SSE2 moves.
+ *
+ * The destination is first aligned to a 16-byte boundary with
+ * plain byte copies, so the bulk uses aligned stores (the loads
+ * remain unaligned and do not require any mutual alignment of
+ * the two buffers). The tail is finished with byte copies again.
+ */
+MEM_ARCH_SSE2_ATTR
+    static void *memcpy_sse2(void *dst, const void *src, size_t n)
+{
+	uint8_t *dstb = dst;
+	const uint8_t *srcb = src;
+
+	/* Align the destination to 16 bytes. */
+	size_t fill = (-(uintptr_t) dstb) & 15;
+	n -= fill;
+	while (fill-- != 0)
+		*dstb++ = *srcb++;
+
+	/* Copy the aligned bulk. */
+	size_t cnt = n / 64;
+	if (cnt > 0) {
+		asm volatile (
+		    "0:\n"
+		    "movdqu 0(%[src]), %%xmm0\n"
+		    "movdqu 16(%[src]), %%xmm1\n"
+		    "movdqu 32(%[src]), %%xmm2\n"
+		    "movdqu 48(%[src]), %%xmm3\n"
+		    "movdqa %%xmm0, 0(%[dst])\n"
+		    "movdqa %%xmm1, 16(%[dst])\n"
+		    "movdqa %%xmm2, 32(%[dst])\n"
+		    "movdqa %%xmm3, 48(%[dst])\n"
+		    "add $64, %[src]\n"
+		    "add $64, %[dst]\n"
+		    "dec %[cnt]\n"
+		    "jnz 0b\n"
+		    : [src] "+r" (srcb), [dst] "+r" (dstb), [cnt] "+r" (cnt)
+		    :
+		    : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory"
+		);
+		n %= 64;
+	}
+
+	cnt = n / 16;
+	if (cnt > 0) {
+		asm volatile (
+		    "0:\n"
+		    "movdqu 0(%[src]), %%xmm0\n"
+		    "movdqa %%xmm0, 0(%[dst])\n"
+		    "add $16, %[src]\n"
+		    "add $16, %[dst]\n"
+		    "dec %[cnt]\n"
+		    "jnz 0b\n"
+		    : [src] "+r" (srcb), [dst] "+r" (dstb), [cnt] "+r" (cnt)
+		    :
+		    : "xmm0", "cc", "memory"
+		);
+		n %= 16;
+	}
+
+	/* Copy the final segment. */
+	while (n-- != 0)
+		*dstb++ = *srcb++;
+
+	return dst;
+}
+
+#endif /* MEM_ARCH_SSE2 */
+
+/** Initialize memory routine dispatch
+ *
+ * Probe the processor and enable the architecture-specific block
+ * memory routines when available. Called once during libc
+ * initialization; until then the portable routines are used.
+ */
+void __mem_init(void)
+{
+#ifdef MEM_ARCH_SSE2
+	mem_sse2 = mem_arch_sse2_supported();
+#endif
+}
 
 /** Fill memory block with a constant value. */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
@@ -52,6 +213,11 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	size_t i;
 	size_t fill;
 
+#ifdef MEM_ARCH_SSE2
+	if ((mem_sse2) && (n >= SSE2_THRESHOLD))
+		return memset_sse2(dest, b, n);
+#endif
+
 	/* Fill initial segment. */
 	word_size = sizeof(unsigned long);
 	fill = word_size - ((uintptr_t) dest & (word_size - 1));
@@ -130,6 +296,11 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 
 	word_size = sizeof(unsigned long);
 
+#ifdef MEM_ARCH_SSE2
+	if ((mem_sse2) && (n >= SSE2_THRESHOLD))
+		return memcpy_sse2(dst, src, n);
+#endif
+
 	/*
 	 * Are source and destination addresses congruent modulo word_size?
 	 * If not, use unaligned_memcpy().
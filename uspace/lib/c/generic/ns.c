@@ -34,9 +34,12 @@
 
 #include <ns.h>
 #include <ipc/ns.h>
+#include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <macros.h>
 #include <errno.h>
+#include <stdlib.h>
 #include "private/ns.h"
 
 /*
@@ -45,6 +48,114 @@
  */
 static async_sess_t *sess_ns = NULL;
 
+/** Cached direct connection to a service.
+ *
+ * After the first successful connection to a service the task keeps
+ * a session of its own to the target. Further connections with the
+ * same parameters are cloned from it directly, without routing the
+ * setup through the naming service.
+ */
+typedef struct {
+	link_t link;
+	service_t service;
+	iface_t iface;
+	sysarg_t arg3;
+	/** Session new connections are cloned from */
+	async_sess_t *sess;
+} conn_cache_t;
+
+static FIBRIL_MUTEX_INITIALIZE(conn_cache_mutex);
+static LIST_INITIALIZE(conn_cache_list);
+
+/** Look up a cached direct connection.
+ *
+ * Sessions are never destroyed once cached, so the returned pointer
+ * stays valid after the cache mutex is dropped.
+ */
+static async_sess_t *conn_cache_find(service_t service, iface_t iface,
+    sysarg_t arg3)
+{
+	async_sess_t *sess = NULL;
+
+	fibril_mutex_lock(&conn_cache_mutex);
+
+	list_foreach(conn_cache_list, link, conn_cache_t, entry) {
+		if (entry->service == service && entry->iface == iface &&
+		    entry->arg3 == arg3) {
+			sess = entry->sess;
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&conn_cache_mutex);
+	return sess;
+}
+
+/** Cache a direct connection, replacing any stale entry.
+ *
+ * The cache is only an optimization, so allocation failure is ignored
+ * (the extra session is just hung up).
+ */
+static void conn_cache_insert(service_t service, iface_t iface, sysarg_t arg3,
+    async_sess_t *sess)
+{
+	fibril_mutex_lock(&conn_cache_mutex);
+
+	list_foreach(conn_cache_list, link, conn_cache_t, entry) {
+		if (entry->service == service && entry->iface == iface &&
+		    entry->arg3 == arg3) {
+			/*
+			 * Replace a stale entry (e.g. the service was
+			 * restarted). The old session is intentionally
+			 * leaked: another fibril may still be cloning
+			 * from it.
+			 */
+			entry->sess = sess;
+			fibril_mutex_unlock(&conn_cache_mutex);
+			return;
+		}
+	}
+
+	conn_cache_t *entry = malloc(sizeof(conn_cache_t));
+	if (entry == NULL) {
+		fibril_mutex_unlock(&conn_cache_mutex);
+		async_hangup(sess);
+		return;
+	}
+
+	entry->service = service;
+	entry->iface = iface;
+	entry->arg3 = arg3;
+	entry->sess = sess;
+	link_initialize(&entry->link);
+	list_append(&entry->link, &conn_cache_list);
+
+	fibril_mutex_unlock(&conn_cache_mutex);
+}
+
+/** Clone a new session from an existing connection to the target.
+ *
+ * Sends IPC_M_CONNECT_ME_TO directly to the target the same way
+ * additional connections for parallel exchanges are created, so the
+ * naming service is not involved.
+ */
+static async_sess_t *service_connect_direct(async_sess_t *dsess, iface_t iface,
+    sysarg_t arg3, errno_t *rc)
+{
+	async_exch_t *exch = async_exchange_begin(dsess);
+	if (exch == NULL)
+		return NULL;
+
+	async_sess_t *csess = async_connect_me_to(exch, iface, arg3, 0, rc);
+	async_exchange_end(exch);
+
+	if (csess == NULL)
+		return NULL;
+
+	async_sess_args_set(csess, iface, arg3, 0);
+	return csess;
+}
+
 errno_t service_register(service_t service, iface_t iface,
     async_port_handler_t handler, void *data)
 {
@@ -117,6 +228,17 @@ errno_t service_register_broker(service_t service, async_port_handler_t handler,
 async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3,
     errno_t *rc)
 {
+	/* Fast path: clone from a cached direct connection, bypassing ns */
+	async_sess_t *dsess = conn_cache_find(service, iface, arg3);
+	if (dsess != NULL) {
+		async_sess_t *csess = service_connect_direct(dsess, iface,
+		    arg3, rc);
+		if (csess != NULL)
+			return csess;
+
+		/* The target may be gone - fall back to the naming service */
+	}
+
 	async_sess_t *sess = ns_session_get(rc);
 	if (sess == NULL)
 		return NULL;
@@ -139,6 +261,11 @@ async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3,
 	 */
 	async_sess_args_set(csess, iface, arg3, 0);
 
+	/* Keep a session of our own for future direct connections */
+	dsess = service_connect_direct(csess, iface, arg3, NULL);
+	if (dsess != NULL)
+		conn_cache_insert(service, iface, arg3, dsess);
+
 	return csess;
 }
 
@@ -155,6 +282,17 @@ async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3,
 async_sess_t *service_connect_blocking(service_t service, iface_t iface,
     sysarg_t arg3, errno_t *rc)
 {
+	/* Fast path: clone from a cached direct connection, bypassing ns */
+	async_sess_t *dsess = conn_cache_find(service, iface, arg3);
+	if (dsess != NULL) {
+		async_sess_t *csess = service_connect_direct(dsess, iface,
+		    arg3, rc);
+		if (csess != NULL)
+			return csess;
+
+		/* The target may be gone - fall back to the naming service */
+	}
+
 	async_sess_t *sess = ns_session_get(rc);
 	if (sess == NULL)
 		return NULL;
@@ -174,6 +312,11 @@ async_sess_t *service_connect_blocking(service_t service, iface_t iface,
 	 */
 	async_sess_args_set(csess, iface, arg3, 0);
 
+	/* Keep a session of our own for future direct connections */
+	dsess = service_connect_direct(csess, iface, arg3, NULL);
+	if (dsess != NULL)
+		conn_cache_insert(service, iface, arg3, dsess);
+
 	return csess;
 }
 
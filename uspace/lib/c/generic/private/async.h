@@ -39,6 +39,7 @@
 #include <adt/list.h>
 #include <fibril.h>
 #include <fibril_synch.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <stdbool.h>
 
@@ -68,8 +69,14 @@ struct async_sess {
 	/** Exchange mutex */
 	fibril_mutex_t mutex;
 
+	/** Lock-free stack of pooled inactive exchanges */
+	_Atomic(struct async_exch *) exch_pool;
+
+	/** Number of exchanges in exch_pool (approximate) */
+	atomic_int exch_pool_cnt;
+
 	/** Number of opened exchanges */
-	int exchanges;
+	atomic_int exchanges;
 
 	/** Mutex for stateful connections */
 	fibril_mutex_t remote_state_mtx;
@@ -86,6 +93,9 @@ struct async_exch {
 	/** Link into global list of inactive exchanges */
 	link_t global_link;
 
+	/** Link in the session's lock-free exchange pool */
+	struct async_exch *pool_next;
+
 	/** Session pointer */
 	async_sess_t *sess;
 
@@ -62,6 +62,9 @@ struct fibril {
 
 	fibril_t *thread_ctx;
 
+	/** Home ready queue of the thread this helper fibril belongs to. */
+	size_t rq_idx;
+
 	bool is_running : 1;
 	bool is_writer : 1;
 	/* In some places, we use fibril structs that can't be freed. */
@@ -77,6 +80,7 @@ extern fibril_t *fibril_alloc(void);
 extern void fibril_setup(fibril_t *);
 extern void fibril_teardown(fibril_t *f);
 extern fibril_t *fibril_self(void);
+extern bool fibril_is_multithreaded(void);
 
 extern void __fibrils_init(void);
 extern void __fibrils_fini(void);
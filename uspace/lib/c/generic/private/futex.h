@@ -41,12 +41,10 @@
 #include <libc.h>
 #include <time.h>
 #include <fibril.h>
-#include <abi/cap.h>
 #include <abi/synch.h>
 
 typedef struct futex {
 	volatile atomic_int val;
-	volatile cap_waitq_handle_t whandle;
 
 #ifdef CONFIG_DEBUG_FUTEX
 	_Atomic(fibril_t *) owner;
@@ -57,12 +55,10 @@ extern errno_t futex_initialize(futex_t *futex, int value);
 
 static inline errno_t futex_destroy(futex_t *futex)
 {
-	if (futex->whandle) {
-		errno_t rc;
-		rc = __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) futex->whandle);
-		futex->whandle = CAP_NIL;
-		return rc;
-	}
+	/*
+	 * The kernel-side futex object, if any, is keyed by the futex
+	 * address and reclaimed when the task exits.
+	 */
 	return EOK;
 }
 
@@ -95,11 +91,6 @@ void __futex_give_to(futex_t *, void *, const char *);
 
 #endif
 
-static inline errno_t futex_allocate_waitq(futex_t *futex)
-{
-	return __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &futex->whandle);
-}
-
 /** Down the futex with timeout, composably.
  *
  * This means that when the operation fails due to a timeout or being
@@ -121,8 +112,6 @@ static inline errno_t futex_down_composable(futex_t *futex,
 {
 	// TODO: Add tests for this.
 
-	assert(futex->whandle != CAP_NIL);
-
 	if (atomic_fetch_sub_explicit(&futex->val, 1, memory_order_acquire) > 0)
 		return EOK;
 
@@ -147,7 +136,7 @@ static inline errno_t futex_down_composable(futex_t *futex,
 		assert(timeout > 0);
 	}
 
-	return __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) futex->whandle,
+	return __SYSCALL3(SYS_FUTEX_SLEEP, (sysarg_t) &futex->val,
 	    (sysarg_t) timeout, (sysarg_t) SYNCH_FLAGS_FUTEX);
 }
 
@@ -163,7 +152,7 @@ static inline errno_t futex_down_composable(futex_t *futex,
 static inline errno_t futex_up(futex_t *futex)
 {
 	if (atomic_fetch_add_explicit(&futex->val, 1, memory_order_release) < 0)
-		return __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) futex->whandle);
+		return __SYSCALL1(SYS_FUTEX_WAKEUP, (sysarg_t) &futex->val);
 
 	return EOK;
 }
@@ -106,6 +106,9 @@ struct _IO_FILE {
 	/** Buffer size */
 	size_t buf_size;
 
+	/** Non-zero if the buffer was allocated by the library */
+	int buf_allocated;
+
 	/** Buffer state */
 	enum __buffer_state buf_state;
 
@@ -32,13 +32,23 @@
 
 /**
  * @file
- * @brief Quicksort.
+ * @brief Introspective sort.
+ *
+ * Quicksort with a heapsort fallback once the recursion depth exceeds
+ * a logarithmic bound and with insertion sort for small ranges. This
+ * bounds the worst case at O(n log n) while keeping the quicksort
+ * common case fast.
  */
 
 #include <qsort.h>
 #include <stdbool.h>
 #include <stddef.h>
 
+/** Ranges up to this size are sorted by insertion sort */
+enum {
+	small_range_len = 8
+};
+
 /** Quicksort spec */
 typedef struct {
 	void *base;
@@ -107,6 +117,71 @@ static void elem_swap(qs_spec_t *qs, size_t i, size_t j)
 	}
 }
 
+/** Sort a range of indices by insertion sort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (inclusive)
+ */
+static void insertion_sort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t i, j;
+
+	for (i = lo + 1; i <= hi; i++) {
+		for (j = i; j > lo && elem_lt(qs, j, j - 1); j--)
+			elem_swap(qs, j, j - 1);
+	}
+}
+
+/** Sift an element down a heap rooted in a range of indices.
+ *
+ * The heap is stored with the root at @a lo and the children of the
+ * element at @a lo + k at @a lo + 2k + 1 and @a lo + 2k + 2.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound of the heap (inclusive)
+ * @param hi Upper bound of the heap (inclusive)
+ * @param root Index of the element to sift down
+ */
+static void heap_sift_down(qs_spec_t *qs, size_t lo, size_t hi, size_t root)
+{
+	size_t child;
+
+	while (true) {
+		child = lo + 2 * (root - lo) + 1;
+		if (child > hi)
+			break;
+
+		if (child < hi && elem_lt(qs, child, child + 1))
+			++child;
+
+		if (!elem_lt(qs, root, child))
+			break;
+
+		elem_swap(qs, root, child);
+		root = child;
+	}
+}
+
+/** Sort a range of indices by heapsort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (inclusive)
+ */
+static void heapsort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t i;
+
+	for (i = lo + (hi - lo) / 2 + 1; i > lo; i--)
+		heap_sift_down(qs, lo, hi, i - 1);
+
+	for (i = hi; i > lo; i--) {
+		elem_swap(qs, lo, i);
+		heap_sift_down(qs, lo, i - 1, lo);
+	}
+}
+
 /** Partition a range of indices.
  *
  * @param qs Quicksort spec
@@ -119,7 +194,14 @@ static size_t partition(qs_spec_t *qs, size_t lo, size_t hi)
 	size_t pivot;
 	size_t i, j;
 
+	/* Move the median of the first, middle and last element to mid */
 	pivot = lo + (hi - lo) / 2;
+	if (elem_lt(qs, pivot, lo))
+		elem_swap(qs, pivot, lo);
+	if (elem_lt(qs, hi, pivot))
+		elem_swap(qs, hi, pivot);
+	if (elem_lt(qs, pivot, lo))
+		elem_swap(qs, pivot, lo);
 	i = lo;
 	j = hi;
 	while (true) {
@@ -149,16 +231,53 @@ static size_t partition(qs_spec_t *qs, size_t lo, size_t hi)
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
  * @param hi Upper bound (inclusive)
+ * @param depth Remaining recursion depth before heapsort takes over
  */
-static void quicksort(qs_spec_t *qs, size_t lo, size_t hi)
+static void introsort(qs_spec_t *qs, size_t lo, size_t hi, unsigned depth)
 {
 	size_t p;
 
-	if (lo < hi) {
+	while (hi - lo + 1 > small_range_len) {
+		if (depth == 0) {
+			heapsort(qs, lo, hi);
+			return;
+		}
+
+		--depth;
 		p = partition(qs, lo, hi);
-		quicksort(qs, lo, p);
-		quicksort(qs, p + 1, hi);
+
+		/*
+		 * Recurse into the smaller partition and iterate on the
+		 * larger one to keep the stack depth logarithmic.
+		 */
+		if (p - lo < hi - p) {
+			introsort(qs, lo, p, depth);
+			lo = p + 1;
+		} else {
+			introsort(qs, p + 1, hi, depth);
+			hi = p;
+		}
+	}
+
+	insertion_sort(qs, lo, hi);
+}
+
+/** Compute recursion depth limit for sorting @a nmemb elements.
+ *
+ * @param nmemb Number of elements
+ * @return Maximum quicksort recursion depth (roughly 2 log2(nmemb))
+ */
+static unsigned depth_limit(size_t nmemb)
+{
+	unsigned d;
+
+	d = 0;
+	while (nmemb > 1) {
+		nmemb /= 2;
+		d += 2;
 	}
+
+	return d;
 }
 
 /** Quicksort.
@@ -182,7 +301,7 @@ void qsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar_wrap;
 	qs.arg = compar;
 
-	quicksort(&qs, 0, nmemb - 1);
+	introsort(&qs, 0, nmemb - 1, depth_limit(nmemb));
 }
 
 /** Quicksort with extra argument to comparison function.
@@ -207,7 +326,7 @@ void qsort_r(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar;
 	qs.arg = arg;
 
-	quicksort(&qs, 0, nmemb - 1);
+	introsort(&qs, 0, nmemb - 1, depth_limit(nmemb));
 }
 
 /** @}
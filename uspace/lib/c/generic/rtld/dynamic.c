@@ -77,6 +77,9 @@ void dynamic_parse(elf_dyn_t *dyn_ptr, size_t bias, dyn_info_t *info)
 		case DT_HASH:
 			info->hash = d_ptr;
 			break;
+		case DT_GNU_HASH:
+			info->gnu_hash = d_ptr;
+			break;
 		case DT_STRTAB:
 			info->str_tab = d_ptr;
 			break;
@@ -100,9 +100,12 @@ errno_t module_create_static_exec(rtld_t *rtld, module_t **rmodule)
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Process all relocation tables in a module.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * If the architecture set up lazy binding in module_process_pre_arch(),
+ * the jump slot relocations are left to be resolved on first call;
+ * otherwise they are processed eagerly (as if LD_BIND_NOW was
+ * specified).
  */
 void module_process_relocs(module_t *m)
 {
@@ -114,8 +117,8 @@ void module_process_relocs(module_t *m)
 
 	module_process_pre_arch(m);
 
-	/* jmp_rel table */
-	if (m->dyn.jmp_rel != NULL) {
+	/* jmp_rel table (skipped when the PLT is bound lazily) */
+	if (m->dyn.jmp_rel != NULL && !m->lazy_plt) {
 		DPRINTF("jmp_rel table\n");
 		if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
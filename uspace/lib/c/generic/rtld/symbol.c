@@ -62,7 +62,20 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/*
+ * GNU hash function (as used by the .gnu.hash section).
+ */
+static elf_word gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = h * 33 + *name++;
+
+	return h;
+}
+
+static elf_symbol_t *def_find_in_module_sysv(const char *name, module_t *m)
 {
 	elf_symbol_t *sym_table;
 	elf_symbol_t *s, *sym;
@@ -72,8 +85,6 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
-
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/* nchain = m->dyn.hash[1]; XXX Use to check HT range */
@@ -94,6 +105,81 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return sym;
+}
+
+/** Look up a symbol in a module's GNU hash table.
+ *
+ * The Bloom filter in front of the table rejects most symbols that
+ * are not defined in the module without ever touching the buckets,
+ * which is what makes searching many modules in a row cheap.
+ */
+static elf_symbol_t *def_find_in_module_gnu(const char *name, module_t *m)
+{
+	elf_symbol_t *sym_table;
+	elf_symbol_t *s;
+	char *s_name;
+
+	const elf_word *gh = m->dyn.gnu_hash;
+	elf_word nbucket = gh[0];
+	elf_word sym_offset = gh[1];
+	elf_word bloom_size = gh[2];
+	elf_word bloom_shift = gh[3];
+
+	/* Bloom filter words have the natural word size of the ELF class */
+	const uintptr_t *bloom = (const uintptr_t *) &gh[4];
+	const elf_word *buckets =
+	    (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbucket];
+
+	unsigned nbits = sizeof(uintptr_t) * 8;
+	elf_word h = gnu_hash((const unsigned char *) name);
+
+	uintptr_t word = bloom[(h / nbits) % bloom_size];
+	uintptr_t mask = ((uintptr_t) 1 << (h % nbits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % nbits));
+
+	if ((word & mask) != mask)
+		return NULL;
+
+	elf_word i = buckets[h % nbucket];
+	if (i < sym_offset)
+		return NULL;
+
+	sym_table = m->dyn.sym_tab;
+
+	while (true) {
+		elf_word ch = chain[i - sym_offset];
+
+		if ((ch | 1) == (h | 1)) {
+			s = &sym_table[i];
+			s_name = m->dyn.str_tab + s->st_name;
+
+			if (str_cmp(name, s_name) == 0)
+				return s;
+		}
+
+		/* The lowest bit marks the end of a chain */
+		if ((ch & 1) != 0)
+			break;
+
+		i++;
+	}
+
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = def_find_in_module_gnu(name, m);
+	else
+		sym = def_find_in_module_sysv(name, m);
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -273,5 +359,60 @@ void *symbol_get_addr(elf_symbol_t *sym, module_t *m, tcb_t *tcb)
 	}
 }
 
+/** Resolve a lazily bound PLT entry.
+ *
+ * Called from the architecture-specific binding trampoline the first
+ * time a lazily bound function is called. Resolves the jump slot
+ * relocation @a ridx in module @a m, patches the GOT entry and returns
+ * the target address, which the trampoline then jumps to.
+ *
+ * Concurrent calls for the same slot are harmless: both resolve to
+ * the same address and the GOT entry is written atomically.
+ *
+ * @param m    Module whose PLT entry is being bound.
+ * @param ridx Index into the module's jmp_rel relocation table.
+ *
+ * @return Address of the function the jump slot refers to.
+ */
+uintptr_t rtld_bind(module_t *m, size_t ridx)
+{
+	elf_word sym_idx;
+	uintptr_t r_offset;
+	uintptr_t *r_ptr;
+	elf_symbol_t *sym;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	const char *name;
+	uintptr_t sym_addr;
+
+	if (m->dyn.plt_rel == DT_RELA) {
+		elf_rela_t *rt = m->dyn.jmp_rel;
+		r_offset = rt[ridx].r_offset;
+		sym_idx = ELF_R_SYM(rt[ridx].r_info);
+	} else {
+		elf_rel_t *rt = m->dyn.jmp_rel;
+		r_offset = rt[ridx].r_offset;
+		sym_idx = ELF_R_SYM(rt[ridx].r_info);
+	}
+
+	sym = &((elf_symbol_t *) m->dyn.sym_tab)[sym_idx];
+	name = m->dyn.str_tab + sym->st_name;
+
+	DPRINTF("rtld_bind('%s', %zu) -> '%s'\n", m->dyn.soname, ridx, name);
+
+	sym_def = symbol_def_find(name, m, ssf_none, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n", name);
+		exit(1);
+	}
+
+	sym_addr = (uintptr_t) symbol_get_addr(sym_def, dest, NULL);
+
+	r_ptr = (uintptr_t *) (r_offset + m->bias);
+	*r_ptr = sym_addr;
+
+	return sym_addr;
+}
+
 /** @}
  */
@@ -39,9 +39,21 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <mem.h>
+#include <as.h>
+#include <barrier.h>
+#include <ddi.h>
 
 #define SYSINFO_STATS_MAX_PATH  64
 
+/** Pointer to the mapped kernel statistics region */
+static stats_region_t *stats_region = NULL;
+
+/** True if mapping the statistics region was already attempted */
+static bool stats_region_tried = false;
+
 /** Thread states
  *
  */
@@ -55,7 +67,49 @@ static const char *thread_states[] = {
 	"Lingering"
 };
 
+/** Get the kernel statistics region
+ *
+ * Map the read-only statistics region which the kernel shares with
+ * monitoring tasks. The region is mapped on the first use and stays
+ * mapped for the lifetime of the task. If the kernel does not
+ * provide the region, NULL is returned and the callers fall back
+ * to the sysinfo data interface.
+ *
+ * @return Pointer to the statistics region or NULL if it cannot
+ *         be mapped.
+ *
+ */
+static stats_region_t *stats_region_get(void)
+{
+	if ((stats_region == NULL) && (!stats_region_tried)) {
+		stats_region_tried = true;
+
+		sysarg_t faddr;
+		if (sysinfo_get_value("stats.faddr", &faddr) != EOK)
+			return NULL;
+
+		sysarg_t frames;
+		if (sysinfo_get_value("stats.frames", &frames) != EOK)
+			return NULL;
+
+		void *addr = AS_AREA_ANY;
+		errno_t rc = physmem_map(faddr, frames,
+		    AS_AREA_READ | AS_AREA_CACHEABLE, &addr);
+		if (rc != EOK)
+			return NULL;
+
+		stats_region = addr;
+	}
+
+	return stats_region;
+}
+
 /** Get CPUs statistics
+ *
+ * Read the per-CPU slots of the statistics region if the kernel
+ * provides it (the kernel updates them in place on every clock
+ * tick, so no syscall is needed), otherwise fall back to the
+ * sysinfo data interface.
  *
  * @param count Number of records returned.
  *
@@ -66,6 +120,33 @@ static const char *thread_states[] = {
  */
 stats_cpu_t *stats_get_cpus(size_t *count)
 {
+	stats_region_t *region = stats_region_get();
+	if (region != NULL) {
+		size_t cnt = region->cpu_cnt;
+		stats_cpu_t *stats_cpus =
+		    (stats_cpu_t *) malloc(cnt * sizeof(stats_cpu_t));
+		if (stats_cpus == NULL) {
+			*count = 0;
+			return NULL;
+		}
+
+		for (size_t i = 0; i < cnt; i++) {
+			stats_region_cpu_t *slot = &region->cpus[i];
+
+			/* Retry while the owning CPU is rewriting the slot */
+			uintptr_t seq;
+			do {
+				seq = slot->seq;
+				read_barrier();
+				stats_cpus[i] = slot->stats;
+				read_barrier();
+			} while (((seq & 1) != 0) || (slot->seq != seq));
+		}
+
+		*count = cnt;
+		return stats_cpus;
+	}
+
 	size_t size = 0;
 	stats_cpu_t *stats_cpus =
 	    (stats_cpu_t *) sysinfo_get_data("system.cpus", &size);
@@ -81,6 +162,58 @@ stats_cpu_t *stats_get_cpus(size_t *count)
 	return stats_cpus;
 }
 
+/** Get per-CPU kernel event counters
+ *
+ * Read the event counters of all CPUs from the statistics region.
+ * The returned array holds STATS_EVENT_MAX entries per CPU, indexed
+ * by stats_event_t. The counters are free-running; rates are obtained
+ * by sampling them twice and taking differences.
+ *
+ * The counters are only available through the statistics region;
+ * there is no sysinfo fallback.
+ *
+ * @param count Number of CPUs returned.
+ *
+ * @return Array of cpu_count * STATS_EVENT_MAX counters.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+uint64_t *stats_get_cpu_events(size_t *count)
+{
+	stats_region_t *region = stats_region_get();
+	if (region == NULL) {
+		*count = 0;
+		return NULL;
+	}
+
+	size_t cnt = region->cpu_cnt;
+	uint64_t *events =
+	    (uint64_t *) malloc(cnt * STATS_EVENT_MAX * sizeof(uint64_t));
+	if (events == NULL) {
+		*count = 0;
+		return NULL;
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		stats_region_cpu_t *slot = &region->cpus[i];
+
+		/* Retry while the owning CPU is rewriting the slot */
+		uintptr_t seq;
+		do {
+			seq = slot->seq;
+			read_barrier();
+			for (size_t ev = 0; ev < STATS_EVENT_MAX; ev++)
+				events[i * STATS_EVENT_MAX + ev] =
+				    slot->events[ev];
+			read_barrier();
+		} while (((seq & 1) != 0) || (slot->seq != seq));
+	}
+
+	*count = cnt;
+	return events;
+}
+
 /** Get physical memory statistics
  *
  *
@@ -105,6 +238,13 @@ stats_physmem_t *stats_get_physmem(void)
 }
 
 /** Get task statistics
+ *
+ * Ask the kernel to refresh the task section of the statistics
+ * region and read it in place if the kernel provides the region
+ * (a single syscall instead of the double snapshot generation and
+ * copying of the sysinfo data interface), otherwise fall back to
+ * the sysinfo data interface. The fallback is also used when there
+ * are more tasks than the section can hold.
  *
  * @param count Number of records returned.
  *
@@ -115,6 +255,40 @@ stats_physmem_t *stats_get_physmem(void)
  */
 stats_task_t *stats_get_tasks(size_t *count)
 {
+	stats_region_t *region = stats_region_get();
+	if (region != NULL) {
+		sysarg_t refreshed;
+		if ((sysinfo_get_value("stats.refresh", &refreshed) == EOK) &&
+		    (region->task_total <= region->task_max)) {
+			stats_task_t *entries = (stats_task_t *)
+			    ((uint8_t *) region + region->task_off);
+			stats_task_t *stats_tasks = (stats_task_t *)
+			    malloc(region->task_max * sizeof(stats_task_t));
+			if (stats_tasks == NULL) {
+				*count = 0;
+				return NULL;
+			}
+
+			/*
+			 * Retry while another monitoring task is having
+			 * the section refreshed under our hands.
+			 */
+			uintptr_t seq;
+			size_t cnt;
+			do {
+				seq = region->task_seq;
+				read_barrier();
+				cnt = region->task_cnt;
+				memcpy(stats_tasks, entries,
+				    cnt * sizeof(stats_task_t));
+				read_barrier();
+			} while (((seq & 1) != 0) || (region->task_seq != seq));
+
+			*count = cnt;
+			return stats_tasks;
+		}
+	}
+
 	size_t size = 0;
 	stats_task_t *stats_tasks =
 	    (stats_task_t *) sysinfo_get_data("system.tasks", &size);
@@ -130,6 +130,16 @@
 /** Number of data bits in a UTF-8 continuation byte */
 #define CONT_BITS  6
 
+/** Word with the lowest bit of each byte set */
+#define WORD_ONES  (((unsigned long) -1) / 0xff)
+
+/** Word with the highest bit of each byte set */
+#define WORD_HIGHS  (WORD_ONES * 0x80)
+
+/** Test whether a word contains a zero byte (the "haszero" trick) */
+#define word_has_zero(w) \
+	((((w) - WORD_ONES) & ~(w) & WORD_HIGHS) != 0)
+
 /** Decode a single character from a string.
  *
  * Decode a single character from a string of size @a size. Decoding starts
@@ -326,12 +336,31 @@ errno_t chr_encode(const char32_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
+	const char *pb = str;
 
-	while (*str++ != 0)
-		size++;
+	/* Scan bytewise until the pointer is word-aligned. */
+	while (((uintptr_t) pb & (sizeof(unsigned long) - 1)) != 0) {
+		if (*pb == 0)
+			return (size_t) (pb - str);
 
-	return size;
+		pb++;
+	}
+
+	/*
+	 * Scan word by word until a word containing a zero byte is
+	 * found. Reading the whole aligned word is safe even when the
+	 * terminator lies inside it.
+	 */
+	const unsigned long *pw = (const unsigned long *) pb;
+	while (!word_has_zero(*pw))
+		pw++;
+
+	/* Find the exact position of the zero byte. */
+	pb = (const char *) pw;
+	while (*pb != 0)
+		pb++;
+
+	return (size_t) (pb - str);
 }
 
 /** Get size of wide string.
@@ -581,6 +610,23 @@ bool chr_check(char32_t ch)
  */
 int str_cmp(const char *s1, const char *s2)
 {
+	/*
+	 * ASCII fast path: skip the UTF-8 decoder while both strings
+	 * are plain ASCII. Bytewise and character ordering coincide
+	 * there and the generic decoder below picks up correctly at
+	 * the first non-ASCII byte.
+	 */
+	while ((((uint8_t) *s1) < 0x80) && (((uint8_t) *s2) < 0x80)) {
+		if (*s1 != *s2)
+			return (((uint8_t) *s1) < ((uint8_t) *s2)) ? -1 : 1;
+
+		if (*s1 == 0)
+			return 0;
+
+		s1++;
+		s2++;
+	}
+
 	char32_t c1 = 0;
 	char32_t c2 = 0;
 
@@ -628,14 +674,28 @@ int str_cmp(const char *s1, const char *s2)
  */
 int str_lcmp(const char *s1, const char *s2, size_t max_len)
 {
+	size_t len = 0;
+
+	/* ASCII fast path, see str_cmp(). */
+	while ((len < max_len) && (((uint8_t) *s1) < 0x80) &&
+	    (((uint8_t) *s2) < 0x80)) {
+		if (*s1 != *s2)
+			return (((uint8_t) *s1) < ((uint8_t) *s2)) ? -1 : 1;
+
+		if (*s1 == 0)
+			return 0;
+
+		s1++;
+		s2++;
+		len++;
+	}
+
 	char32_t c1 = 0;
 	char32_t c2 = 0;
 
 	size_t off1 = 0;
 	size_t off2 = 0;
 
-	size_t len = 0;
-
 	while (true) {
 		if (len >= max_len)
 			break;
@@ -680,6 +740,21 @@ int str_lcmp(const char *s1, const char *s2, size_t max_len)
  */
 int str_casecmp(const char *s1, const char *s2)
 {
+	/* ASCII fast path, see str_cmp(). */
+	while ((((uint8_t) *s1) < 0x80) && (((uint8_t) *s2) < 0x80)) {
+		int b1 = tolower(*s1);
+		int b2 = tolower(*s2);
+
+		if (b1 != b2)
+			return (b1 < b2) ? -1 : 1;
+
+		if (*s1 == 0)
+			return 0;
+
+		s1++;
+		s2++;
+	}
+
 	char32_t c1 = 0;
 	char32_t c2 = 0;
 
@@ -728,14 +803,31 @@ int str_casecmp(const char *s1, const char *s2)
  */
 int str_lcasecmp(const char *s1, const char *s2, size_t max_len)
 {
+	size_t len = 0;
+
+	/* ASCII fast path, see str_cmp(). */
+	while ((len < max_len) && (((uint8_t) *s1) < 0x80) &&
+	    (((uint8_t) *s2) < 0x80)) {
+		int b1 = tolower(*s1);
+		int b2 = tolower(*s2);
+
+		if (b1 != b2)
+			return (b1 < b2) ? -1 : 1;
+
+		if (*s1 == 0)
+			return 0;
+
+		s1++;
+		s2++;
+		len++;
+	}
+
 	char32_t c1 = 0;
 	char32_t c2 = 0;
 
 	size_t off1 = 0;
 	size_t off2 = 0;
 
-	size_t len = 0;
-
 	while (true) {
 		if (len >= max_len)
 			break;
@@ -39,6 +39,47 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <as.h>
+#include <barrier.h>
+#include <ddi.h>
+#include "private/sysinfo.h"
+
+/** Pointer to the mapped kernel clock page */
+static clock_page_t *clock_page = NULL;
+
+/** Get the kernel clock page.
+ *
+ * Map the read-only page which the kernel shares with all tasks and
+ * which holds the system uptime and exported sysinfo scalars. The
+ * page is mapped on the first use and stays mapped for the lifetime
+ * of the task.
+ *
+ * @return Pointer to the clock page or NULL if it cannot be mapped.
+ *
+ */
+clock_page_t *__clock_page_get(void)
+{
+	if (clock_page == NULL) {
+		sysarg_t faddr;
+		errno_t rc = (errno_t) __SYSCALL3(SYS_SYSINFO_GET_VALUE,
+		    (sysarg_t) "clock.faddr",
+		    (sysarg_t) str_size("clock.faddr"), (sysarg_t) &faddr);
+		if (rc != EOK)
+			return NULL;
+
+		void *addr = AS_AREA_ANY;
+		rc = physmem_map(faddr, 1, AS_AREA_READ | AS_AREA_CACHEABLE,
+		    &addr);
+		if (rc != EOK) {
+			as_area_destroy(addr);
+			return NULL;
+		}
+
+		clock_page = addr;
+	}
+
+	return clock_page;
+}
 
 /** Get sysinfo keys size
  *
@@ -117,6 +158,34 @@ sysinfo_item_val_type_t sysinfo_get_val_type(const char *path)
 	    (sysarg_t) path, (sysarg_t) str_size(path));
 }
 
+/** Find a scalar in the export table on the clock page
+ *
+ * @param path  Sysinfo path.
+ * @param index Pointer to store the index of the matching entry to.
+ *
+ * @return EOK if the scalar is exported on the clock page.
+ * @return ENOENT if it is not.
+ *
+ */
+static errno_t sysinfo_export_find(const char *path, size_t *index)
+{
+	clock_page_t *page = __clock_page_get();
+	if (page == NULL)
+		return ENOENT;
+
+	size_t cnt = page->export_cnt;
+	read_barrier();
+
+	for (size_t i = 0; i < cnt; i++) {
+		if (str_cmp(page->exports[i].name, path) == 0) {
+			*index = i;
+			return EOK;
+		}
+	}
+
+	return ENOENT;
+}
+
 /** Get sysinfo numerical value
  *
  * @param path  Sysinfo path.
@@ -128,10 +197,76 @@ sysinfo_item_val_type_t sysinfo_get_val_type(const char *path)
  */
 errno_t sysinfo_get_value(const char *path, sysarg_t *value)
 {
+	/*
+	 * Try the table of scalars exported on the kernel clock page
+	 * first; frequently read values are answered by a few loads
+	 * without entering the kernel. Fall back to the syscall for
+	 * everything that is not exported.
+	 */
+	size_t index;
+	if (sysinfo_export_find(path, &index) == EOK) {
+		*value = __clock_page_get()->exports[index].value;
+		return EOK;
+	}
+
 	return (errno_t) __SYSCALL3(SYS_SYSINFO_GET_VALUE, (sysarg_t) path,
 	    (sysarg_t) str_size(path), (sysarg_t) value);
 }
 
+/** Resolve a sysinfo path to a stable handle
+ *
+ * Resolve the dotted path of a frequently polled scalar once, so
+ * that subsequent reads via sysinfo_get_value_by_handle() are a
+ * bounds check and a load, with no path parsing, no table scan and
+ * no syscall. The handle stays valid for the lifetime of the system
+ * because entries of the export table are never removed or renamed.
+ *
+ * Only scalars mirrored on the kernel clock page can be resolved;
+ * for anything else the caller has to keep querying by path.
+ *
+ * @param path   Sysinfo path.
+ * @param handle Pointer to store the handle to.
+ *
+ * @return EOK if the handle was resolved.
+ * @return ENOENT if the path is not an exported scalar.
+ *
+ */
+errno_t sysinfo_get_handle(const char *path, sysinfo_handle_t *handle)
+{
+	size_t index;
+	errno_t rc = sysinfo_export_find(path, &index);
+	if (rc != EOK)
+		return rc;
+
+	*handle = (sysinfo_handle_t) index;
+	return EOK;
+}
+
+/** Get sysinfo numerical value by a resolved handle
+ *
+ * @param handle Handle obtained from sysinfo_get_handle().
+ * @param value  Pointer to store the numerical value to.
+ *
+ * @return EOK if the value was successfully read.
+ * @return ENOENT on an invalid handle.
+ *
+ */
+errno_t sysinfo_get_value_by_handle(sysinfo_handle_t handle, sysarg_t *value)
+{
+	clock_page_t *page = __clock_page_get();
+	if (page == NULL)
+		return ENOENT;
+
+	size_t cnt = page->export_cnt;
+	read_barrier();
+
+	if (handle >= cnt)
+		return ENOENT;
+
+	*value = page->exports[handle].value;
+	return EOK;
+}
+
 /** Get sysinfo binary data size
  *
  * @param path Sysinfo path.
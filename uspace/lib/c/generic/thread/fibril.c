@@ -38,6 +38,7 @@
 #include <fibril.h>
 #include <stack.h>
 #include <tls.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <as.h>
 #include <context.h>
@@ -56,13 +57,32 @@
 #define DPRINTF(...) ((void)0)
 #undef READY_DEBUG
 
-/** Member of timeout_list. */
+/** Member of a timer wheel slot. */
 typedef struct {
 	link_t link;
 	struct timespec expires;
 	fibril_event_t *event;
 } _timeout_t;
 
+/*
+ * Pending timeouts are kept in a hierarchical timer wheel so that arming
+ * and cancelling is O(1) regardless of how many timeouts are pending.
+ * Level 0 has a slot per tick; each higher level covers WHEEL_SLOTS times
+ * the span of the previous one and its entries are redistributed to lower
+ * levels as the wheel turns. Timeouts beyond the span of the last level
+ * go to an overflow list.
+ */
+#define WHEEL_LEVEL_BITS  6
+#define WHEEL_SLOTS       (1 << WHEEL_LEVEL_BITS)
+#define WHEEL_LEVELS      4
+
+/** Number of ticks covered by levels 0 through lvl - 1. */
+#define WHEEL_SPAN(lvl)   (UINT64_C(1) << ((lvl) * WHEEL_LEVEL_BITS))
+
+/** Tick length. One millisecond keeps the wheel spans practical. */
+#define WHEEL_TICK_NSEC   1000000
+#define WHEEL_TICKS_PER_SEC  (1000000000 / WHEEL_TICK_NSEC)
+
 typedef struct {
 	errno_t rc;
 	link_t link;
@@ -90,9 +110,32 @@ static futex_t fibril_futex;
 static futex_t ready_semaphore;
 static long ready_st_count;
 
-static LIST_INITIALIZE(ready_list);
+/** Number of ready queues of the fibril executor.
+ *
+ * Ready fibrils are distributed over several queues, each with its own
+ * lock, so that runner threads pushing and popping ready fibrils do not
+ * all serialize on a single list. A runner prefers the home queue of its
+ * thread and steals from the other queues when it finds it empty.
+ */
+#define FIBRIL_RQ_COUNT  8
+
+typedef struct {
+	futex_t lock;
+	list_t list;
+} _ready_queue_t;
+
+static _ready_queue_t ready_queues[FIBRIL_RQ_COUNT];
+static atomic_size_t runner_counter;
+
 static LIST_INITIALIZE(fibril_list);
-static LIST_INITIALIZE(timeout_list);
+
+/* Timer wheel state, all protected by fibril_futex. */
+static list_t wheel_slots[WHEEL_LEVELS][WHEEL_SLOTS];
+static LIST_INITIALIZE(wheel_overflow);
+/** Last fully processed tick. Only meaningful while wheel_count > 0. */
+static uint64_t wheel_last;
+/** Number of pending timeouts (wheel slots plus overflow). */
+static size_t wheel_count;
 
 static futex_t ipc_lists_futex;
 static LIST_INITIALIZE(ipc_waiter_list);
@@ -110,12 +153,31 @@ static inline void _ready_debug_check(void)
 {
 #ifdef READY_DEBUG
 	assert(!multithreaded);
-	long count = (long) list_count(&ready_list) +
-	    (long) list_count(&ipc_buffer_free_list);
+	long count = (long) list_count(&ipc_buffer_free_list);
+	for (size_t i = 0; i < FIBRIL_RQ_COUNT; i++)
+		count += (long) list_count(&ready_queues[i].list);
 	assert(ready_st_count == count);
 #endif
 }
 
+/** Give a helper fibril a home ready queue.
+ *
+ * Helper fibrils are per-thread, so this effectively assigns the queue
+ * to the thread the helper belongs to.
+ */
+static void _ready_queue_assign(fibril_t *helper)
+{
+	helper->rq_idx = atomic_fetch_add(&runner_counter, 1) %
+	    FIBRIL_RQ_COUNT;
+}
+
+/** Return the home ready queue index of the current thread. */
+static size_t _current_rq_idx(void)
+{
+	fibril_t *helper = fibril_self()->thread_ctx;
+	return helper ? helper->rq_idx : 0;
+}
+
 static inline void _ready_up(void)
 {
 	if (multithreaded) {
@@ -138,6 +200,32 @@ static inline errno_t _ready_down(const struct timespec *expires)
 
 static atomic_int threads_in_ipc_wait;
 
+/** Take a ready fibril, stealing from other queues if need be.
+ *
+ * The home queue of the current thread is tried first, then the other
+ * queues in order. The caller must hold a token from ready_semaphore
+ * (or its single-threaded counterpart), which guarantees that an empty
+ * scan means it is the caller's turn to wait for IPC.
+ */
+static fibril_t *_ready_queue_take(void)
+{
+	size_t home = _current_rq_idx();
+
+	for (size_t i = 0; i < FIBRIL_RQ_COUNT; i++) {
+		_ready_queue_t *rq =
+		    &ready_queues[(home + i) % FIBRIL_RQ_COUNT];
+
+		futex_lock(&rq->lock);
+		fibril_t *f = list_pop(&rq->list, fibril_t, link);
+		futex_unlock(&rq->lock);
+
+		if (f)
+			return f;
+	}
+
+	return NULL;
+}
+
 /** Function that spans the whole life-cycle of a fibril.
  *
  * Each fibril begins execution in this function. Then the function implementing
@@ -277,22 +365,23 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 
 	/*
 	 * Once we acquire a token from ready_semaphore, there are two options.
-	 * Either there is a ready fibril in the list, or it's our turn to
-	 * call `ipc_wait_cycle()`. There is one extra token on the semaphore
-	 * for each entry of the call buffer.
+	 * Either there is a ready fibril in one of the queues, or it's our
+	 * turn to call `ipc_wait_cycle()`. There is one extra token on the
+	 * semaphore for each entry of the call buffer.
+	 *
+	 * We announce ourselves as a potential IPC waiter before scanning
+	 * the queues, so that a pusher that appends a fibril after our scan
+	 * is guaranteed to see the announcement and poke us out of the
+	 * IPC wait.
 	 */
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-	fibril_t *f = list_pop(&ready_list, fibril_t, link);
-	if (!f)
-		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
-		    memory_order_relaxed);
-	if (!locked)
-		futex_unlock(&fibril_futex);
+	atomic_fetch_add(&threads_in_ipc_wait, 1);
 
-	if (f)
+	fibril_t *f = _ready_queue_take();
+	if (f) {
+		atomic_fetch_sub(&threads_in_ipc_wait, 1);
 		return f;
+	}
 
 	if (!multithreaded)
 		assert(list_empty(&ipc_buffer_list));
@@ -301,8 +390,7 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	ipc_call_t call = { 0 };
 	rc = _ipc_wait(&call, expires);
 
-	atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
-	    memory_order_relaxed);
+	atomic_fetch_sub(&threads_in_ipc_wait, 1);
 
 	if (rc != EOK && rc != ENOENT) {
 		/* Return token. */
@@ -366,11 +454,16 @@ static void _ready_list_push(fibril_t *f)
 
 	futex_assert_is_locked(&fibril_futex);
 
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
+	/* Enqueue in the home ready queue of the current thread. */
+	_ready_queue_t *rq = &ready_queues[_current_rq_idx()];
+
+	futex_lock(&rq->lock);
+	list_append(&f->link, &rq->list);
+	futex_unlock(&rq->lock);
+
 	_ready_up();
 
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
+	if (atomic_load(&threads_in_ipc_wait)) {
 		DPRINTF("Poking.\n");
 		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
 		ipc_poke();
@@ -414,32 +507,188 @@ static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 	return rc;
 }
 
+/** Convert an uptime timestamp to a wheel tick, rounding down. */
+static uint64_t _wheel_tick(const struct timespec *ts)
+{
+	return (uint64_t) ts->tv_sec * WHEEL_TICKS_PER_SEC +
+	    (uint64_t) ts->tv_nsec / WHEEL_TICK_NSEC;
+}
+
+/** Convert an uptime timestamp to a wheel tick, rounding up. */
+static uint64_t _wheel_tick_up(const struct timespec *ts)
+{
+	return (uint64_t) ts->tv_sec * WHEEL_TICKS_PER_SEC +
+	    ((uint64_t) ts->tv_nsec + WHEEL_TICK_NSEC - 1) / WHEEL_TICK_NSEC;
+}
+
+/** Convert a wheel tick to an uptime timestamp. */
+static void _wheel_tick_ts(uint64_t tick, struct timespec *ts)
+{
+	ts->tv_sec = tick / WHEEL_TICKS_PER_SEC;
+	ts->tv_nsec = (tick % WHEEL_TICKS_PER_SEC) * WHEEL_TICK_NSEC;
+}
+
+/** Queue a timeout into the wheel slot matching its deadline.
+ *
+ * The deadline tick is rounded up, so a timeout can never fire before
+ * it expires (it may fire up to one tick after).
+ *
+ * @param timeout	Timeout to queue.
+ * @param min_tick	Earliest tick the timeout may be queued for.
+ */
+static void _wheel_place(_timeout_t *timeout, uint64_t min_tick)
+{
+	uint64_t tick = _wheel_tick_up(&timeout->expires);
+	uint64_t delta;
+	list_t *slot;
+
+	futex_assert_is_locked(&fibril_futex);
+
+	if (tick < min_tick)
+		tick = min_tick;
+
+	delta = tick - wheel_last;
+
+	if (delta < WHEEL_SPAN(1)) {
+		slot = &wheel_slots[0][tick & (WHEEL_SLOTS - 1)];
+	} else if (delta < WHEEL_SPAN(2)) {
+		slot = &wheel_slots[1][(tick >> WHEEL_LEVEL_BITS) &
+		    (WHEEL_SLOTS - 1)];
+	} else if (delta < WHEEL_SPAN(3)) {
+		slot = &wheel_slots[2][(tick >> (2 * WHEEL_LEVEL_BITS)) &
+		    (WHEEL_SLOTS - 1)];
+	} else if (delta < WHEEL_SPAN(4)) {
+		slot = &wheel_slots[3][(tick >> (3 * WHEEL_LEVEL_BITS)) &
+		    (WHEEL_SLOTS - 1)];
+	} else {
+		slot = &wheel_overflow;
+	}
+
+	list_append(&timeout->link, slot);
+	wheel_count++;
+}
+
+/** Redistribute higher-level slots feeding the given tick.
+ *
+ * Called when the wheel advances to @a tick. Whenever a level wraps
+ * around, the corresponding slot of the next level is emptied and its
+ * timeouts are re-queued, now landing in a lower level (or in the slot
+ * of @a tick itself if they are due).
+ */
+static void _wheel_cascade(uint64_t tick)
+{
+	unsigned lvl;
+	_timeout_t *to;
+
+	for (lvl = 1; lvl < WHEEL_LEVELS; lvl++) {
+		if ((tick & (WHEEL_SPAN(lvl) - 1)) != 0)
+			return;
+
+		list_t *slot = &wheel_slots[lvl]
+		    [(tick >> (lvl * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS - 1)];
+
+		while ((to = list_pop(slot, _timeout_t, link)) != NULL) {
+			wheel_count--;
+			_wheel_place(to, tick);
+		}
+	}
+
+	if ((tick & (WHEEL_SPAN(WHEEL_LEVELS) - 1)) == 0) {
+		while ((to = list_pop(&wheel_overflow, _timeout_t, link)) !=
+		    NULL) {
+			wheel_count--;
+			_wheel_place(to, tick);
+		}
+	}
+}
+
+/** Find the next tick the wheel needs to be advanced to.
+ *
+ * For level 0 this is the exact tick of the nearest timeout. For higher
+ * levels and the overflow list it is the tick at which their nearest
+ * nonempty slot cascades, which is never later than any timeout in it.
+ *
+ * Must only be called while wheel_count > 0.
+ */
+static uint64_t _wheel_next_tick(void)
+{
+	uint64_t next = 0;
+	bool have_next = false;
+	unsigned lvl;
+	unsigned i;
+
+	for (lvl = 0; lvl < WHEEL_LEVELS; lvl++) {
+		uint64_t cur = wheel_last >> (lvl * WHEEL_LEVEL_BITS);
+
+		for (i = 1; i <= WHEEL_SLOTS; i++) {
+			uint64_t s = cur + i;
+
+			if (list_empty(&wheel_slots[lvl]
+			    [s & (WHEEL_SLOTS - 1)]))
+				continue;
+
+			uint64_t tick = s << (lvl * WHEEL_LEVEL_BITS);
+			if (!have_next || tick < next) {
+				next = tick;
+				have_next = true;
+			}
+			break;
+		}
+	}
+
+	if (!list_empty(&wheel_overflow)) {
+		uint64_t tick = (wheel_last | (WHEEL_SPAN(WHEEL_LEVELS) - 1)) +
+		    1;
+		if (!have_next || tick < next) {
+			next = tick;
+			have_next = true;
+		}
+	}
+
+	assert(have_next);
+	return next;
+}
+
 /** Fire all timeouts that expired. */
 static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 {
 	struct timespec ts;
+	_timeout_t *to;
+
 	getuptime(&ts);
 
 	futex_lock(&fibril_futex);
 
-	while (!list_empty(&timeout_list)) {
-		link_t *cur = list_first(&timeout_list);
-		_timeout_t *to = list_get_instance(cur, _timeout_t, link);
+	if (wheel_count == 0) {
+		/* Nothing is pending; just keep the wheel position fresh. */
+		wheel_last = _wheel_tick(&ts);
+		futex_unlock(&fibril_futex);
+		return NULL;
+	}
+
+	uint64_t now_tick = _wheel_tick(&ts);
 
-		if (ts_gt(&to->expires, &ts)) {
-			*next_timeout = to->expires;
-			futex_unlock(&fibril_futex);
-			return next_timeout;
-		}
+	while (wheel_last < now_tick) {
+		wheel_last++;
+		_wheel_cascade(wheel_last);
 
-		list_remove(&to->link);
+		list_t *slot = &wheel_slots[0][wheel_last & (WHEEL_SLOTS - 1)];
+		while ((to = list_pop(slot, _timeout_t, link)) != NULL) {
+			wheel_count--;
+			_ready_list_push(_fibril_trigger_internal(
+			    to->event, _EVENT_TIMED_OUT));
+		}
 
-		_ready_list_push(_fibril_trigger_internal(
-		    to->event, _EVENT_TIMED_OUT));
+		if (wheel_count == 0) {
+			wheel_last = now_tick;
+			futex_unlock(&fibril_futex);
+			return NULL;
+		}
 	}
 
+	_wheel_tick_ts(_wheel_next_tick(), next_timeout);
 	futex_unlock(&fibril_futex);
-	return NULL;
+	return next_timeout;
 }
 
 /**
@@ -515,8 +764,17 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
  */
 static errno_t _helper_fibril_fn(void *arg)
 {
-	/* Set itself as the thread's own context. */
-	fibril_self()->thread_ctx = fibril_self();
+	fibril_t *self = fibril_self();
+
+	/*
+	 * Set itself as the thread's own context. A fresh runner thread
+	 * enters with no context assigned yet and also gets a home ready
+	 * queue here.
+	 */
+	if (!self->thread_ctx) {
+		self->thread_ctx = self;
+		_ready_queue_assign(self);
+	}
 
 	(void) arg;
 
@@ -600,17 +858,28 @@ static void _insert_timeout(_timeout_t *timeout)
 	futex_assert_is_locked(&fibril_futex);
 	assert(timeout);
 
-	link_t *tmp = timeout_list.head.next;
-	while (tmp != &timeout_list.head) {
-		_timeout_t *cur = list_get_instance(tmp, _timeout_t, link);
+	if (wheel_count == 0) {
+		/*
+		 * The wheel position may be stale; resynchronize it before
+		 * computing the slot.
+		 */
+		struct timespec now;
+		getuptime(&now);
+		wheel_last = _wheel_tick(&now);
+	}
 
-		if (ts_gteq(&cur->expires, &timeout->expires))
-			break;
+	_wheel_place(timeout, wheel_last + 1);
+}
 
-		tmp = tmp->next;
-	}
+/** Cancel a timeout if it is still pending. */
+static void _remove_timeout(_timeout_t *timeout)
+{
+	futex_assert_is_locked(&fibril_futex);
 
-	list_insert_before(&timeout->link, tmp);
+	if (link_in_use(&timeout->link)) {
+		list_remove(&timeout->link);
+		wheel_count--;
+	}
 }
 
 /**
@@ -635,6 +904,8 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 		    fibril_create_generic(_helper_fibril_fn, NULL, PAGE_SIZE);
 		if (!fibril_self()->thread_ctx)
 			return ENOMEM;
+
+		_ready_queue_assign(fibril_self()->thread_ctx);
 	}
 
 	futex_lock(&fibril_futex);
@@ -697,7 +968,7 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 	assert(event->fibril != _EVENT_INITIAL);
 	assert(event->fibril == _EVENT_TIMED_OUT || event->fibril == _EVENT_TRIGGERED);
 
-	list_remove(&timeout.link);
+	_remove_timeout(&timeout);
 	errno_t rc = (event->fibril == _EVENT_TIMED_OUT) ? ETIMEOUT : EOK;
 	event->fibril = _EVENT_INITIAL;
 
@@ -747,6 +1018,12 @@ void fibril_add_ready(fibril_t *fibril)
 	fibril_start(fibril);
 }
 
+/** @return Whether the executor runs (or ever ran) more than one thread. */
+bool fibril_is_multithreaded(void)
+{
+	return multithreaded;
+}
+
 /** @return the currently running fibril. */
 fibril_t *fibril_self(void)
 {
@@ -870,6 +1147,17 @@ void __fibrils_init(void)
 	if (futex_initialize(&ipc_lists_futex, 1) != EOK)
 		abort();
 
+	for (size_t i = 0; i < FIBRIL_RQ_COUNT; i++) {
+		if (futex_initialize(&ready_queues[i].lock, 1) != EOK)
+			abort();
+		list_initialize(&ready_queues[i].list);
+	}
+
+	for (size_t lvl = 0; lvl < WHEEL_LEVELS; lvl++) {
+		for (size_t i = 0; i < WHEEL_SLOTS; i++)
+			list_initialize(&wheel_slots[lvl][i]);
+	}
+
 	/*
 	 * We allow a fixed, small amount of parallelism for IPC reads, but
 	 * since IPC is currently serialized in kernel, there's not much
@@ -889,6 +1177,9 @@ void __fibrils_fini(void)
 {
 	futex_destroy(&fibril_futex);
 	futex_destroy(&ipc_lists_futex);
+
+	for (size_t i = 0; i < FIBRIL_RQ_COUNT; i++)
+		futex_destroy(&ready_queues[i].lock);
 }
 
 void fibril_usleep(usec_t timeout)
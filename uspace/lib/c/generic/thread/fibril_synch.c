@@ -42,6 +42,8 @@
 #include <stacktrace.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <io/kio.h>
 #include <mem.h>
 #include <context.h>
@@ -50,6 +52,253 @@
 #include "../private/fibril.h"
 #include "../private/futex.h"
 
+/*
+ * Opt-in lock contention profiler.
+ *
+ * When enabled, mutex and restricted mutex operations record per-lock
+ * acquisition counts, wait-time histograms and, at a low sampling
+ * rate, the backtrace of the fibril that held the lock when somebody
+ * had to wait for it. The profiler keeps its records in a bounded
+ * static table because it must not allocate memory: the allocator
+ * itself is protected by a restricted mutex that is being profiled.
+ */
+
+/** Number of distinct locks the profiler can track */
+#define PROF_SLOTS  64
+
+/** Number of binary logarithmic wait-time histogram buckets */
+#define PROF_WAIT_BUCKETS  16
+
+/** Sample the holder backtrace on every such contended acquisition */
+#define PROF_SAMPLE_PERIOD  64
+
+/** Number of holder backtrace frames kept */
+#define PROF_FRAMES  4
+
+typedef struct {
+	void *lock;               /**< Lock address (NULL means free slot) */
+	const char *kind;         /**< Lock flavor for the dump */
+	uint64_t acquisitions;    /**< Number of acquisitions */
+	uint64_t contended;       /**< Acquisitions that had to wait */
+	uint64_t wait_nanos;      /**< Total time spent waiting */
+	uint64_t wait_max_nanos;  /**< Longest single wait */
+
+	/** Wait-time histogram (bucket i counts waits below 2^i us) */
+	uint64_t wait_hist[PROF_WAIT_BUCKETS];
+
+	/** Last sampled holder backtrace (zero-terminated) */
+	uintptr_t holder_pc[PROF_FRAMES];
+} prof_slot_t;
+
+static bool prof_enabled = false;
+static futex_t prof_futex;
+static prof_slot_t prof_slots[PROF_SLOTS];
+
+/** Acquisitions not recorded because the slot table was full */
+static uint64_t prof_dropped;
+
+static errno_t prof_read_uintptr(void *arg, uintptr_t addr, uintptr_t *data)
+{
+	(void) arg;
+	*data = *((uintptr_t *) addr);
+	return EOK;
+}
+
+static stacktrace_ops_t prof_st_ops = {
+	.read_uintptr = prof_read_uintptr
+};
+
+/** Find or claim the profiler slot of a lock.
+ *
+ * The profiler futex must be held.
+ *
+ * @return Profiler slot or NULL if the table is full.
+ */
+static prof_slot_t *prof_slot_get(void *lock, const char *kind)
+{
+	size_t hint = ((uintptr_t) lock >> 4) % PROF_SLOTS;
+	prof_slot_t *free_slot = NULL;
+
+	for (size_t pos = 0; pos < PROF_SLOTS; pos++) {
+		prof_slot_t *slot = &prof_slots[(hint + pos) % PROF_SLOTS];
+
+		if (slot->lock == lock)
+			return slot;
+
+		if ((slot->lock == NULL) && (free_slot == NULL))
+			free_slot = slot;
+	}
+
+	if (free_slot == NULL) {
+		prof_dropped++;
+		return NULL;
+	}
+
+	free_slot->lock = lock;
+	free_slot->kind = kind;
+	return free_slot;
+}
+
+/** Record one lock acquisition.
+ *
+ * @param lock      Lock address.
+ * @param kind      Lock flavor for the dump.
+ * @param contended True if the caller had to wait for the lock.
+ * @param wait      Time spent waiting in nanoseconds.
+ */
+static void prof_record(void *lock, const char *kind, bool contended,
+    nsec_t wait)
+{
+	futex_lock(&prof_futex);
+
+	if (!prof_enabled) {
+		futex_unlock(&prof_futex);
+		return;
+	}
+
+	prof_slot_t *slot = prof_slot_get(lock, kind);
+	if (slot != NULL) {
+		slot->acquisitions++;
+
+		if (contended) {
+			slot->contended++;
+			slot->wait_nanos += wait;
+			if ((uint64_t) wait > slot->wait_max_nanos)
+				slot->wait_max_nanos = wait;
+
+			size_t bucket = 0;
+			uint64_t usec = wait / 1000;
+			while ((usec >>= 1) != 0)
+				bucket++;
+			if (bucket >= PROF_WAIT_BUCKETS)
+				bucket = PROF_WAIT_BUCKETS - 1;
+			slot->wait_hist[bucket]++;
+		}
+	}
+
+	futex_unlock(&prof_futex);
+}
+
+/** Possibly sample the backtrace of the holder of a contended lock.
+ *
+ * Must be called before the caller starts waiting, while the identity
+ * of the holder is still known. The holder may be running on another
+ * executor thread, in which case its saved context is stale and the
+ * backtrace only approximate; this is the same limitation that
+ * print_deadlock() has.
+ */
+static void prof_sample_holder(void *lock, const char *kind, fibril_t *holder)
+{
+	if (holder == NULL)
+		return;
+
+	futex_lock(&prof_futex);
+
+	if (!prof_enabled) {
+		futex_unlock(&prof_futex);
+		return;
+	}
+
+	prof_slot_t *slot = prof_slot_get(lock, kind);
+	if ((slot != NULL) && (slot->contended % PROF_SAMPLE_PERIOD == 0)) {
+		stacktrace_t st = {
+			.op_arg = NULL,
+			.ops = &prof_st_ops
+		};
+
+		uintptr_t fp = context_get_fp(&holder->ctx);
+		uintptr_t pc = context_get_pc(&holder->ctx);
+		size_t i = 0;
+
+		while ((i < PROF_FRAMES) && (stacktrace_fp_valid(&st, fp))) {
+			slot->holder_pc[i++] = pc;
+
+			if (stacktrace_ra_get(&st, fp, &pc) != EOK)
+				break;
+
+			uintptr_t nfp;
+			if (stacktrace_fp_prev(&st, fp, &nfp) != EOK)
+				break;
+
+			fp = nfp;
+		}
+
+		for (; i < PROF_FRAMES; i++)
+			slot->holder_pc[i] = 0;
+	}
+
+	futex_unlock(&prof_futex);
+}
+
+/** Start profiling lock contention.
+ *
+ * Discards any records from a previous profiling run.
+ */
+void fibril_synch_profile_start(void)
+{
+	futex_lock(&prof_futex);
+	memset(prof_slots, 0, sizeof(prof_slots));
+	prof_dropped = 0;
+	prof_enabled = true;
+	futex_unlock(&prof_futex);
+}
+
+/** Stop profiling lock contention.
+ *
+ * The records are kept until the next fibril_synch_profile_start().
+ */
+void fibril_synch_profile_stop(void)
+{
+	futex_lock(&prof_futex);
+	prof_enabled = false;
+	futex_unlock(&prof_futex);
+}
+
+/** Print the collected lock contention profile to standard output. */
+void fibril_synch_profile_dump(void)
+{
+	futex_lock(&prof_futex);
+
+	printf("[lock]             [kind]   [acquired] [contended] "
+	    "[wait us] [max wait us]\n");
+
+	for (size_t i = 0; i < PROF_SLOTS; i++) {
+		prof_slot_t *slot = &prof_slots[i];
+
+		if (slot->lock == NULL)
+			continue;
+
+		printf("%-18p %-8s %10" PRIu64 " %11" PRIu64 " %9" PRIu64
+		    " %13" PRIu64 "\n", slot->lock, slot->kind,
+		    slot->acquisitions, slot->contended,
+		    slot->wait_nanos / 1000, slot->wait_max_nanos / 1000);
+
+		for (size_t bucket = 0; bucket < PROF_WAIT_BUCKETS; bucket++) {
+			if (slot->wait_hist[bucket] == 0)
+				continue;
+
+			printf("  wait < %u us: %" PRIu64 "\n",
+			    2U << bucket, slot->wait_hist[bucket]);
+		}
+
+		if (slot->holder_pc[0] != 0) {
+			printf("  sampled holder:");
+			for (size_t frame = 0; frame < PROF_FRAMES; frame++) {
+				if (slot->holder_pc[frame] == 0)
+					break;
+				printf(" %p", (void *) slot->holder_pc[frame]);
+			}
+			printf("\n");
+		}
+	}
+
+	if (prof_dropped > 0)
+		printf("%" PRIu64 " acquisitions dropped (more than %u "
+		    "distinct locks)\n", prof_dropped, PROF_SLOTS);
+
+	futex_unlock(&prof_futex);
+}
+
 errno_t fibril_rmutex_initialize(fibril_rmutex_t *m)
 {
 	return futex_initialize(&m->futex, 1);
@@ -67,13 +316,36 @@ void fibril_rmutex_destroy(fibril_rmutex_t *m)
  */
 void fibril_rmutex_lock(fibril_rmutex_t *m)
 {
-	futex_lock(&m->futex);
+	if (prof_enabled) {
+		/*
+		 * The holder of a restricted mutex is not tracked, so
+		 * only the wait time can be recorded, not the holder
+		 * backtrace.
+		 */
+		if (futex_trylock(&m->futex)) {
+			prof_record(m, "rmutex", false, 0);
+		} else {
+			struct timespec wait_start;
+			getuptime(&wait_start);
+			futex_lock(&m->futex);
+
+			struct timespec now;
+			getuptime(&now);
+			prof_record(m, "rmutex", true,
+			    ts_sub_diff(&now, &wait_start));
+		}
+	} else {
+		futex_lock(&m->futex);
+	}
+
 	fibril_self()->rmutex_locks++;
 }
 
 bool fibril_rmutex_trylock(fibril_rmutex_t *m)
 {
 	if (futex_trylock(&m->futex)) {
+		if (prof_enabled)
+			prof_record(m, "rmutex", false, 0);
 		fibril_self()->rmutex_locks++;
 		return true;
 	} else {
@@ -95,10 +367,14 @@ void __fibril_synch_init(void)
 {
 	if (futex_initialize(&fibril_synch_futex, 1) != EOK)
 		abort();
+
+	if (futex_initialize(&prof_futex, 1) != EOK)
+		abort();
 }
 
 void __fibril_synch_fini(void)
 {
+	futex_destroy(&prof_futex);
 	futex_destroy(&fibril_synch_futex);
 }
 
@@ -107,10 +383,22 @@ typedef struct {
 	fibril_event_t event;
 	fibril_mutex_t *mutex;
 	fid_t fid;
+	/** True if the awaiter was moved from a condvar to the mutex queue. */
+	bool morphed;
 } awaiter_t;
 
 #define AWAITER_INIT { .fid = fibril_get_id() }
 
+/** Upper bound on spinning on a contended mutex.
+ *
+ * With more than one executor thread, the holder of a mutex may be
+ * running on another thread and about to release it, in which case a
+ * short spin is much cheaper than blocking and switching fibrils. The
+ * budget is a fixed constant because there is no way to tell whether
+ * the holder is actually running.
+ */
+#define FIBRIL_MUTEX_SPIN_COUNT  100
+
 static void print_deadlock(fibril_owner_info_t *oi)
 {
 	// FIXME: Print to stderr.
@@ -174,12 +462,38 @@ void fibril_mutex_lock(fibril_mutex_t *fm)
 
 	futex_lock(&fibril_synch_futex);
 
+	if (fm->counter <= 0 && fibril_is_multithreaded()) {
+		/*
+		 * Spin for a short while before enqueueing. The racy read
+		 * outside the futex is only a heuristic; the state of the
+		 * mutex is re-checked under the futex below.
+		 */
+		futex_unlock(&fibril_synch_futex);
+
+		for (int i = 0; i < FIBRIL_MUTEX_SPIN_COUNT; i++) {
+			if (*((volatile long *) &fm->counter) > 0)
+				break;
+		}
+
+		futex_lock(&fibril_synch_futex);
+	}
+
 	if (fm->counter-- > 0) {
 		fm->oi.owned_by = f;
 		futex_unlock(&fibril_synch_futex);
+		if (prof_enabled)
+			prof_record(fm, "mutex", false, 0);
 		return;
 	}
 
+	bool prof = prof_enabled;
+	struct timespec wait_start = { 0 };
+
+	if (prof) {
+		prof_sample_holder(fm, "mutex", fm->oi.owned_by);
+		getuptime(&wait_start);
+	}
+
 	awaiter_t wdata = AWAITER_INIT;
 	list_append(&wdata.link, &fm->waiters);
 	check_for_deadlock(&fm->oi);
@@ -188,6 +502,12 @@ void fibril_mutex_lock(fibril_mutex_t *fm)
 	futex_unlock(&fibril_synch_futex);
 
 	fibril_wait_for(&wdata.event);
+
+	if (prof) {
+		struct timespec now;
+		getuptime(&now);
+		prof_record(fm, "mutex", true, ts_sub_diff(&now, &wait_start));
+	}
 }
 
 bool fibril_mutex_trylock(fibril_mutex_t *fm)
@@ -202,6 +522,9 @@ bool fibril_mutex_trylock(fibril_mutex_t *fm)
 	}
 	futex_unlock(&fibril_synch_futex);
 
+	if (locked && prof_enabled)
+		prof_record(fm, "mutex", false, 0);
+
 	return locked;
 }
 
@@ -431,10 +754,22 @@ fibril_condvar_wait_timeout(fibril_condvar_t *fcv, fibril_mutex_t *fm,
 
 	futex_lock(&fibril_synch_futex);
 	bool timed_out = link_in_use(&wdata.link);
+	/*
+	 * If the awaiter was morphed onto the mutex queue by a broadcast
+	 * and the wait did not time out, the unlocking fibril has already
+	 * handed the mutex over to us.
+	 */
+	bool owner = wdata.morphed && !timed_out;
 	list_remove(&wdata.link);
+	if (timed_out && wdata.morphed) {
+		/* Give back the waiter slot taken when morphing. */
+		fm->counter++;
+		fibril_self()->waits_for = NULL;
+	}
 	futex_unlock(&fibril_synch_futex);
 
-	fibril_mutex_lock(fm);
+	if (!owner)
+		fibril_mutex_lock(fm);
 
 	return timed_out ? ETIMEOUT : EOK;
 }
@@ -460,8 +795,25 @@ void fibril_condvar_broadcast(fibril_condvar_t *fcv)
 	futex_lock(&fibril_synch_futex);
 
 	awaiter_t *w;
-	while ((w = list_pop(&fcv->waiters, awaiter_t, link)))
-		fibril_notify(&w->event);
+	while ((w = list_pop(&fcv->waiters, awaiter_t, link))) {
+		fibril_mutex_t *fm = w->mutex;
+
+		/*
+		 * Wait-morphing: when the mutex associated with the wait is
+		 * currently held, a woken waiter would only run to block on
+		 * the mutex right away. Move it to the mutex queue instead;
+		 * the unlock path will wake it up with the mutex ownership
+		 * already handed over.
+		 */
+		if ((fm != NULL) && (fm->oi.owned_by != NULL)) {
+			w->morphed = true;
+			fm->counter--;
+			list_append(&w->link, &fm->waiters);
+			((fibril_t *) w->fid)->waits_for = &fm->oi;
+		} else {
+			fibril_notify(&w->event);
+		}
+	}
 
 	futex_unlock(&fibril_synch_futex);
 }
@@ -44,6 +44,10 @@
 #define DPRINTF(...) dummy_printf(__VA_ARGS__)
 
 /** Initialize futex counter.
+ *
+ * A futex is addressed by its userspace virtual address; the kernel
+ * creates the corresponding wait queue lazily on first contention,
+ * so no syscall is needed here.
  *
  * @param futex Futex.
  * @param val   Initialization value.
@@ -53,8 +57,7 @@
 errno_t futex_initialize(futex_t *futex, int val)
 {
 	atomic_store_explicit(&futex->val, val, memory_order_relaxed);
-	futex->whandle = CAP_NIL;
-	return futex_allocate_waitq(futex);
+	return EOK;
 }
 
 #ifdef CONFIG_DEBUG_FUTEX
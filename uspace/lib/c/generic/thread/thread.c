@@ -180,6 +180,28 @@ void thread_usleep(usec_t usec)
 	(void) __SYSCALL1(SYS_THREAD_USLEEP, usec);
 }
 
+/** Set the scheduling class of the calling thread
+ *
+ * With a non-zero period, the calling thread joins the kernel's
+ * earliest-deadline-first scheduling class with the given activation
+ * period and per-period execution budget (subject to admission
+ * control). With both arguments zero, the thread returns to the
+ * normal class.
+ *
+ * @param period Activation period and relative deadline in microseconds.
+ * @param budget Execution budget per period in microseconds.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the budget is zero or exceeds the period.
+ * @return ELIMIT if the admission would overload the CPU.
+ *
+ */
+errno_t thread_set_deadline(usec_t period, usec_t budget)
+{
+	return (errno_t) __SYSCALL2(SYS_THREAD_SET_DEADLINE,
+	    (sysarg_t) period, (sysarg_t) budget);
+}
+
 /** Wait unconditionally for specified number of seconds
  *
  */
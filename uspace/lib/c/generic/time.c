@@ -40,8 +40,6 @@
 #include <macros.h>
 #include <errno.h>
 #include <sysinfo.h>
-#include <as.h>
-#include <ddi.h>
 #include <libc.h>
 #include <limits.h>
 #include <stdint.h>
@@ -52,6 +50,7 @@
 #include <loc.h>
 #include <device/clock_dev.h>
 #include <stats.h>
+#include "private/sysinfo.h"
 
 #define ASCTIME_BUF_LEN  27
 
@@ -63,15 +62,18 @@
 #define SECS_PER_HOUR  (SECS_PER_MIN * MINS_PER_HOUR)
 #define SECS_PER_DAY   (SECS_PER_HOUR * HOURS_PER_DAY)
 
-/** Pointer to kernel shared variables with time */
-struct {
-	volatile sysarg_t seconds1;
-	volatile sysarg_t useconds;
-	volatile sysarg_t seconds2;
-} *ktime = NULL;
+/** How often to resynchronize real time with the RTC service */
+#define RT_SYNC_INTERVAL_SEC  60
 
 static async_sess_t *clock_conn = NULL;
 
+/** Offset of real time from system uptime */
+static struct timespec rt_offset;
+/** Uptime seconds at which the offset was last synchronized */
+static time_t rt_sync_sec;
+/** True iff rt_offset holds a valid offset */
+static bool rt_offset_valid = false;
+
 /**
  * Get CPU time used since the process invocation.
  *
@@ -600,6 +602,24 @@ bool ts_gteq(const struct timespec *ts1, const struct timespec *ts2)
  */
 void getrealtime(struct timespec *ts)
 {
+	struct timespec uptime_ts;
+
+	getuptime(&uptime_ts);
+
+	/*
+	 * The RTC is read over IPC and has whole-second resolution, so
+	 * cache the offset of real time from the system uptime and
+	 * serve repeated calls by adding it to the uptime read from the
+	 * clock page. Resynchronize with the RTC service only once in
+	 * a while to bound the drift of the tick-based uptime.
+	 */
+	if (rt_offset_valid &&
+	    uptime_ts.tv_sec - rt_sync_sec < RT_SYNC_INTERVAL_SEC) {
+		*ts = uptime_ts;
+		ts_add(ts, &rt_offset);
+		return;
+	}
+
 	if (clock_conn == NULL) {
 		category_id_t cat_id;
 		errno_t rc = loc_category_get_id("clock", &cat_id, IPC_FLAG_BLOCKING);
@@ -641,10 +661,15 @@ void getrealtime(struct timespec *ts)
 	ts->tv_nsec = time.tm_nsec;
 	ts->tv_sec = mktime(&time);
 
+	rt_offset = *ts;
+	ts_sub(&rt_offset, &uptime_ts);
+	rt_sync_sec = uptime_ts.tv_sec;
+	rt_offset_valid = true;
+
 	return;
 
 fallback:
-	getuptime(ts);
+	*ts = uptime_ts;
 }
 
 /** Get system uptime.
@@ -665,33 +690,17 @@ fallback:
  */
 void getuptime(struct timespec *ts)
 {
-	if (ktime == NULL) {
-		uintptr_t faddr;
-		errno_t rc = sysinfo_get_value("clock.faddr", &faddr);
-		if (rc != EOK) {
-			errno = rc;
-			goto fallback;
-		}
-
-		void *addr = AS_AREA_ANY;
-		rc = physmem_map(faddr, 1, AS_AREA_READ | AS_AREA_CACHEABLE,
-		    &addr);
-		if (rc != EOK) {
-			as_area_destroy(addr);
-			errno = rc;
-			goto fallback;
-		}
-
-		ktime = addr;
-	}
+	clock_page_t *page = __clock_page_get();
+	if (page == NULL)
+		goto fallback;
 
-	sysarg_t s2 = ktime->seconds2;
+	sysarg_t s2 = page->seconds2;
 
 	read_barrier();
-	ts->tv_nsec = USEC2NSEC(ktime->useconds);
+	ts->tv_nsec = USEC2NSEC(page->useconds);
 
 	read_barrier();
-	sysarg_t s1 = ktime->seconds1;
+	sysarg_t s1 = page->seconds1;
 
 	if (s1 != s2) {
 		ts->tv_sec = max(s1, s2);
@@ -123,6 +123,28 @@ errno_t udebug_mem_read(async_sess_t *sess, void *buffer, uintptr_t addr, size_t
 	return rc;
 }
 
+errno_t udebug_mem_readv(async_sess_t *sess, void *buffer,
+    const udebug_mem_span_t *spans, size_t cnt)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_4_0(exch, IPC_M_DEBUG, UDEBUG_M_MEM_READV,
+	    (sysarg_t) buffer, (sysarg_t) spans, cnt);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+errno_t udebug_mem_write(async_sess_t *sess, const void *data, uintptr_t addr,
+    size_t n)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_4_0(exch, IPC_M_DEBUG, UDEBUG_M_MEM_WRITE,
+	    (sysarg_t) data, addr, n);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 errno_t udebug_args_read(async_sess_t *sess, thash_t tid, sysarg_t *buffer)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
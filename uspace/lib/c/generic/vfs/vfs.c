@@ -48,6 +48,7 @@
 #include <assert.h>
 #include <str.h>
 #include <loc.h>
+#include <time.h>
 #include <ipc/vfs.h>
 #include <ipc/loc.h>
 
@@ -127,6 +128,165 @@ static size_t cwd_size = 0;
 static FIBRIL_MUTEX_INITIALIZE(root_mutex);
 static int root_fd = -1;
 
+/*
+ * Client-side cache of recent vfs_stat_path() results and negative
+ * lookups. Programs tend to probe the same paths over and over during
+ * startup (PATH searches, locale files); serving the repeated probes
+ * locally saves a round trip to the VFS server and the FS server for
+ * each of them. Entries are keyed by the absolutized path, expire after
+ * a short TTL and are purged whenever this task modifies the namespace
+ * or file contents, so only changes made by other tasks can be served
+ * stale, and only within the TTL.
+ */
+
+/** Maximum number of cached paths. */
+#define PATHCACHE_ENTRIES	16
+
+/** Time to live of a cached path. */
+#define PATHCACHE_TTL_NSEC	SEC2NSEC(1)
+
+typedef struct {
+	link_t link;		/**< Path cache list link. */
+	char *path;		/**< Absolutized path. */
+	bool negative;		/**< Path is known not to exist. */
+	vfs_stat_t stat;	/**< File information unless negative. */
+	struct timespec expires;	/**< Expiration time of the entry. */
+} pathcache_entry_t;
+
+static FIBRIL_MUTEX_INITIALIZE(pathcache_mutex);
+static LIST_INITIALIZE(pathcache_list);
+static size_t pathcache_cnt = 0;
+
+/** Find a cached path. Expired entries are dropped on the way.
+ *
+ * The path cache mutex must be held.
+ */
+static pathcache_entry_t *pathcache_find(const char *path)
+{
+	struct timespec now;
+
+	getuptime(&now);
+
+	list_foreach_safe(pathcache_list, cur, next) {
+		pathcache_entry_t *entry = list_get_instance(cur,
+		    pathcache_entry_t, link);
+
+		if (ts_gteq(&now, &entry->expires)) {
+			list_remove(&entry->link);
+			pathcache_cnt--;
+			free(entry->path);
+			free(entry);
+			continue;
+		}
+
+		if (str_cmp(entry->path, path) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/** Remember the result of probing a path.
+ *
+ * @param path		Absolutized path.
+ * @param negative	True if the path does not exist.
+ * @param stat		File information; only valid if not negative.
+ */
+static void pathcache_insert(const char *path, bool negative,
+    const vfs_stat_t *stat)
+{
+	fibril_mutex_lock(&pathcache_mutex);
+
+	pathcache_entry_t *entry = pathcache_find(path);
+	if (entry == NULL) {
+		entry = malloc(sizeof(pathcache_entry_t));
+		if (entry == NULL) {
+			fibril_mutex_unlock(&pathcache_mutex);
+			return;
+		}
+		entry->path = str_dup(path);
+		if (entry->path == NULL) {
+			fibril_mutex_unlock(&pathcache_mutex);
+			free(entry);
+			return;
+		}
+		link_initialize(&entry->link);
+
+		if (pathcache_cnt == PATHCACHE_ENTRIES) {
+			/* Evict the oldest entry. */
+			pathcache_entry_t *victim = list_get_instance(
+			    list_first(&pathcache_list), pathcache_entry_t,
+			    link);
+			list_remove(&victim->link);
+			pathcache_cnt--;
+			free(victim->path);
+			free(victim);
+		}
+
+		list_append(&entry->link, &pathcache_list);
+		pathcache_cnt++;
+	}
+
+	entry->negative = negative;
+	if (!negative)
+		entry->stat = *stat;
+	getuptime(&entry->expires);
+	ts_add_diff(&entry->expires, PATHCACHE_TTL_NSEC);
+
+	fibril_mutex_unlock(&pathcache_mutex);
+}
+
+/** Look a path up in the cache.
+ *
+ * @param path		Absolutized path.
+ * @param[out] negative	True if the path is known not to exist.
+ * @param[out] stat	If not NULL, filled in with the cached file
+ *			information of a positive entry.
+ *
+ * @return		True if fresh information was found.
+ */
+static bool pathcache_lookup(const char *path, bool *negative,
+    vfs_stat_t *stat)
+{
+	fibril_mutex_lock(&pathcache_mutex);
+
+	pathcache_entry_t *entry = pathcache_find(path);
+	if (entry == NULL) {
+		fibril_mutex_unlock(&pathcache_mutex);
+		return false;
+	}
+
+	*negative = entry->negative;
+	if (!entry->negative && stat != NULL)
+		*stat = entry->stat;
+
+	fibril_mutex_unlock(&pathcache_mutex);
+	return true;
+}
+
+/** Drop all cached paths.
+ *
+ * Called whenever this task modifies the file system namespace or file
+ * contents in a way that may invalidate cached information.
+ */
+static void pathcache_purge(void)
+{
+	/* Unsynchronized peek; the cache is usually empty. */
+	if (pathcache_cnt == 0)
+		return;
+
+	fibril_mutex_lock(&pathcache_mutex);
+	while (!list_empty(&pathcache_list)) {
+		pathcache_entry_t *entry = list_get_instance(
+		    list_first(&pathcache_list), pathcache_entry_t, link);
+		list_remove(&entry->link);
+		free(entry->path);
+		free(entry);
+	}
+	pathcache_cnt = 0;
+	fibril_mutex_unlock(&pathcache_mutex);
+}
+
 static errno_t get_parent_and_child(const char *path, int *parent, char **child)
 {
 	size_t size;
@@ -224,6 +384,67 @@ char *vfs_absolutize(const char *path, size_t *retlen)
 	return ncwd_path;
 }
 
+/** Check whether an asynchronous file operation has completed
+ *
+ * Never blocks. Even when this function returns true, the operation must
+ * still be completed by vfs_async_wait() in order to collect its result.
+ *
+ * @param aio           Operation submitted by vfs_read_async(),
+ *                      vfs_write_async() or vfs_sync_async()
+ *
+ * @return              True if the operation has completed
+ */
+bool vfs_async_poll(vfs_aio_t *aio)
+{
+	if ((aio->data_req != 0) && (!aio->data_done)) {
+		if (async_wait_timeout(aio->data_req, &aio->data_rc, 0) != EOK)
+			return false;
+		aio->data_done = true;
+	}
+
+	if (!aio->done) {
+		if (async_wait_timeout(aio->req, &aio->rc, 0) != EOK)
+			return false;
+		aio->done = true;
+	}
+
+	return true;
+}
+
+/** Wait for an asynchronous file operation and collect its result
+ *
+ * Blocks until the operation has completed. Every submitted operation
+ * must eventually be completed by this function, even if its completion
+ * was already observed via vfs_async_poll().
+ *
+ * @param aio           Operation submitted by vfs_read_async(),
+ *                      vfs_write_async() or vfs_sync_async()
+ * @param[out] nbytes   If not NULL, actual number of bytes transferred
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_async_wait(vfs_aio_t *aio, ssize_t *nbytes)
+{
+	if ((aio->data_req != 0) && (!aio->data_done)) {
+		async_wait_for(aio->data_req, &aio->data_rc);
+		aio->data_done = true;
+	}
+
+	if (!aio->done) {
+		async_wait_for(aio->req, &aio->rc);
+		aio->done = true;
+	}
+
+	if (aio->data_rc != EOK)
+		return aio->data_rc;
+	if (aio->rc != EOK)
+		return aio->rc;
+
+	if (nbytes)
+		*nbytes = (ssize_t) ipc_get_arg1(&aio->answer);
+	return EOK;
+}
+
 /** Clone a file handle
  *
  * The caller can choose whether to clone an existing file handle into another
@@ -507,6 +728,8 @@ errno_t vfs_link(int parent, const char *child, vfs_file_kind_t kind, int *linke
 	if (rc != EOK)
 		return rc;
 
+	pathcache_purge();
+
 	if (linkedfd)
 		*linkedfd = file;
 	else
@@ -559,6 +782,19 @@ errno_t vfs_lookup(const char *path, int flags, int *handle)
 	if (!p)
 		return ENOMEM;
 
+	/*
+	 * Serve repeated probes for a nonexistent path from the cache,
+	 * unless the lookup is allowed to create the path.
+	 */
+	bool creating = (flags & (WALK_MAY_CREATE | WALK_MUST_CREATE)) != 0;
+	if (!creating) {
+		bool negative;
+		if (pathcache_lookup(p, &negative, NULL) && negative) {
+			free(p);
+			return ENOENT;
+		}
+	}
+
 	int root = vfs_root();
 	if (root < 0) {
 		free(p);
@@ -569,6 +805,9 @@ errno_t vfs_lookup(const char *path, int flags, int *handle)
 	*handle = -1;
 
 	errno_t rc = vfs_walk(root, p, flags, handle);
+	if (rc == ENOENT && !creating)
+		pathcache_insert(p, true, NULL);
+
 	vfs_put(root);
 	free(p);
 	return rc;
@@ -602,6 +841,30 @@ errno_t vfs_lookup_open(const char *path, int flags, int mode, int *handle)
 	return EOK;
 }
 
+/** Synchronize memory-mapped modifications of a file
+ *
+ * Write modifications made through memory mappings of the file back to
+ * the file system. When the call returns successfully, all stores to
+ * the mapping made before the call are visible to subsequent reads of
+ * the file and have been synchronized to stable storage.
+ *
+ * @param file          File handle of the mapped file
+ * @param offset        First byte of the range to synchronize
+ * @param size          Length of the range; zero means up to the end of
+ *                      the file
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_map_sync(int file, aoff64_t offset, size_t size)
+{
+	async_exch_t *exch = vfs_exchange_begin();
+	errno_t rc = async_req_4_0(exch, VFS_IN_MSYNC, file, LOWER32(offset),
+	    UPPER32(offset), size);
+	vfs_exchange_end(exch);
+
+	return rc;
+}
+
 /** Mount a file system
  *
  * @param[in] mp                File handle representing the mount-point
@@ -644,6 +907,9 @@ errno_t vfs_mount(int mp, const char *fs_name, service_id_t serv, const char *op
 
 	if (rc != EOK)
 		return rc;
+
+	if (rc1 == EOK)
+		pathcache_purge();
 	return rc1;
 }
 
@@ -861,6 +1127,49 @@ errno_t vfs_read(int file, aoff64_t *pos, void *buf, size_t nbyte, size_t *nread
 	return EOK;
 }
 
+/** Start an asynchronous read from a file
+ *
+ * Submit a read of up to @a nbyte bytes from the file without waiting
+ * for it to complete. The operation must later be completed by
+ * vfs_async_wait(), which also reports the actual number of bytes read.
+ * The buffer must stay valid until then. Any number of operations can be
+ * kept in flight by one fibril at the same time.
+ *
+ * @param file          File handle to read from
+ * @param[in] pos       Position to read from
+ * @param buf           Buffer to read to
+ * @param nbyte         Maximum number of bytes to read
+ * @param[out] aio      Operation handle to be filled in
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_read_async(int file, aoff64_t pos, void *buf, size_t nbyte,
+    vfs_aio_t *aio)
+{
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	aio->req = async_send_4(exch, VFS_IN_READ, file, LOWER32(pos),
+	    UPPER32(pos), nbyte, &aio->answer);
+	aio->data_req = async_data_read(exch, buf, nbyte, NULL);
+
+	vfs_exchange_end(exch);
+
+	aio->done = false;
+	aio->data_done = false;
+	aio->rc = EOK;
+	aio->data_rc = EOK;
+
+	if (aio->data_req == 0) {
+		async_forget(aio->req);
+		return ENOMEM;
+	}
+
+	return EOK;
+}
+
 /** Read bytes from a file
  *
  * Read up to @a nbyte bytes from file. The actual number of bytes read
@@ -888,8 +1197,8 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 
 	async_exch_t *exch = vfs_exchange_begin();
 
-	req = async_send_3(exch, VFS_IN_READ, file, LOWER32(pos),
-	    UPPER32(pos), &answer);
+	req = async_send_4(exch, VFS_IN_READ, file, LOWER32(pos),
+	    UPPER32(pos), nbyte, &answer);
 	rc = async_data_read_start(exch, (void *) buf, nbyte);
 
 	vfs_exchange_end(exch);
@@ -973,6 +1282,9 @@ errno_t vfs_rename_path(const char *old, const char *new)
 	vfs_put(root);
 	async_wait_for(req, &rc);
 
+	if (rc == EOK)
+		pathcache_purge();
+
 	return rc;
 }
 
@@ -992,6 +1304,9 @@ errno_t vfs_resize(int file, aoff64_t length)
 	    UPPER32(length));
 	vfs_exchange_end(exch);
 
+	if (rc == EOK)
+		pathcache_purge();
+
 	return rc;
 }
 
@@ -1085,14 +1400,32 @@ errno_t vfs_stat(int file, vfs_stat_t *stat)
  */
 errno_t vfs_stat_path(const char *path, vfs_stat_t *stat)
 {
+	size_t size;
+	char *p = vfs_absolutize(path, &size);
+	if (!p)
+		return ENOMEM;
+
+	bool negative;
+	if (pathcache_lookup(p, &negative, stat)) {
+		free(p);
+		return negative ? ENOENT : EOK;
+	}
+
 	int file;
-	errno_t rc = vfs_lookup(path, 0, &file);
-	if (rc != EOK)
+	errno_t rc = vfs_lookup(p, 0, &file);
+	if (rc != EOK) {
+		if (rc == ENOENT)
+			pathcache_insert(p, true, NULL);
+		free(p);
 		return rc;
+	}
 
 	rc = vfs_stat(file, stat);
+	if (rc == EOK)
+		pathcache_insert(p, false, stat);
 
 	vfs_put(file);
+	free(p);
 
 	return rc;
 }
@@ -1158,6 +1491,31 @@ errno_t vfs_sync(int file)
 	return rc;
 }
 
+/** Start an asynchronous file synchronization
+ *
+ * Submit a synchronization of the file without waiting for it to
+ * complete. The operation must later be completed by vfs_async_wait().
+ *
+ * @param file          File handle to synchronize
+ * @param[out] aio      Operation handle to be filled in
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_sync_async(int file, vfs_aio_t *aio)
+{
+	async_exch_t *exch = vfs_exchange_begin();
+	aio->req = async_send_1(exch, VFS_IN_SYNC, file, &aio->answer);
+	vfs_exchange_end(exch);
+
+	aio->data_req = 0;
+	aio->done = false;
+	aio->data_done = false;
+	aio->rc = EOK;
+	aio->data_rc = EOK;
+
+	return EOK;
+}
+
 /** Unlink a file or directory
  *
  * Unlink a name from a parent directory. The caller can supply the file handle
@@ -1188,6 +1546,9 @@ errno_t vfs_unlink(int parent, const char *child, int expect)
 
 	if (rc_orig != EOK)
 		return (errno_t) rc_orig;
+
+	if (rc == EOK)
+		pathcache_purge();
 	return rc;
 }
 
@@ -1234,6 +1595,9 @@ errno_t vfs_unmount(int mp)
 	async_exch_t *exch = vfs_exchange_begin();
 	errno_t rc = async_req_1_0(exch, VFS_IN_UNMOUNT, mp);
 	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		pathcache_purge();
 	return rc;
 }
 
@@ -1327,6 +1691,51 @@ errno_t vfs_write(int file, aoff64_t *pos, const void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Start an asynchronous write to a file
+ *
+ * Submit a write of up to @a nbyte bytes to the file without waiting
+ * for it to complete. The operation must later be completed by
+ * vfs_async_wait(), which also reports the actual number of bytes
+ * written. The buffer must stay valid until then. Any number of
+ * operations can be kept in flight by one fibril at the same time.
+ *
+ * @param file          File handle to write to
+ * @param[in] pos       Position to write to
+ * @param buf           Buffer to write from
+ * @param nbyte         Maximum number of bytes to write
+ * @param[out] aio      Operation handle to be filled in
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_write_async(int file, aoff64_t pos, const void *buf, size_t nbyte,
+    vfs_aio_t *aio)
+{
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	aio->req = async_send_4(exch, VFS_IN_WRITE, file, LOWER32(pos),
+	    UPPER32(pos), nbyte, &aio->answer);
+	aio->data_req = async_data_write(exch, buf, nbyte, NULL);
+
+	vfs_exchange_end(exch);
+
+	aio->done = false;
+	aio->data_done = false;
+	aio->rc = EOK;
+	aio->data_rc = EOK;
+
+	if (aio->data_req == 0) {
+		async_forget(aio->req);
+		return ENOMEM;
+	}
+
+	pathcache_purge();
+
+	return EOK;
+}
+
 /** Write bytes to a file
  *
  * Write up to @a nbyte bytes from file. The actual number of bytes written
@@ -1352,8 +1761,8 @@ errno_t vfs_write_short(int file, aoff64_t pos, const void *buf, size_t nbyte,
 
 	async_exch_t *exch = vfs_exchange_begin();
 
-	req = async_send_3(exch, VFS_IN_WRITE, file, LOWER32(pos),
-	    UPPER32(pos), &answer);
+	req = async_send_4(exch, VFS_IN_WRITE, file, LOWER32(pos),
+	    UPPER32(pos), nbyte, &answer);
 	rc = async_data_write_start(exch, (void *) buf, nbyte);
 
 	vfs_exchange_end(exch);
@@ -1366,6 +1775,8 @@ errno_t vfs_write_short(int file, aoff64_t pos, const void *buf, size_t nbyte,
 	if (rc != EOK)
 		return rc;
 
+	pathcache_purge();
+
 	*nwritten = (ssize_t) ipc_get_arg1(&answer);
 	return EOK;
 }
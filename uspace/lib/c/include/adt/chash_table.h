@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2006 Jakub Jermar
+ * Copyright (c) 2012 Adam Hraska
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_CHASH_TABLE_H_
+#define _LIBC_CHASH_TABLE_H_
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Number of independently locked stripes of a concurrent hash table.
+ *
+ * Must be a power of two. Operations on keys hashing to different
+ * stripes proceed in parallel.
+ */
+#define CHASH_TABLE_STRIPES  64
+
+/** Concurrent hash table structure.
+ *
+ * A chained hash table with internal fine-grained locking. The table
+ * is divided into CHASH_TABLE_STRIPES stripes, each protected by its
+ * own fibril mutex; single-key operations take exactly one stripe
+ * lock. Resizing is incremental: a new bucket array is published and
+ * each stripe is moved over lazily by whichever fibril next touches
+ * it, so no operation ever rehashes the whole table at once.
+ *
+ * Uses the same item link and operations types as hash_table_t.
+ * Note that items returned by chash_table_find() are not protected
+ * against concurrent removal; the caller is responsible for item
+ * lifetime (e.g. via reference counting).
+ */
+typedef struct {
+	hash_table_ops_t *op;
+	/** Current bucket array. */
+	list_t *bucket;
+	size_t bucket_cnt;
+	/** Bucket array being migrated to during a resize (or NULL). */
+	list_t *new_bucket;
+	size_t new_bucket_cnt;
+	size_t max_load;
+	/** Serializes starting and finishing a resize. */
+	fibril_mutex_t resize_lock;
+	/** Number of the current resize (protects against stale updates). */
+	size_t resize_gen;
+	/** Number of stripes already migrated to new_bucket. */
+	size_t migrated_cnt;
+	/** Stripe locks. */
+	fibril_mutex_t stripe_lock[CHASH_TABLE_STRIPES];
+	/** Number of items in each stripe. */
+	size_t stripe_items[CHASH_TABLE_STRIPES];
+	/** Whether the stripe was already migrated to new_bucket. */
+	bool stripe_migrated[CHASH_TABLE_STRIPES];
+} chash_table_t;
+
+extern bool chash_table_create(chash_table_t *, size_t, size_t,
+    hash_table_ops_t *);
+extern void chash_table_destroy(chash_table_t *);
+
+extern bool chash_table_empty(chash_table_t *);
+extern size_t chash_table_size(chash_table_t *);
+
+extern void chash_table_clear(chash_table_t *);
+extern void chash_table_insert(chash_table_t *, ht_link_t *);
+extern bool chash_table_insert_unique(chash_table_t *, ht_link_t *);
+extern ht_link_t *chash_table_find(chash_table_t *, const void *);
+extern size_t chash_table_remove(chash_table_t *, const void *);
+extern void chash_table_remove_item(chash_table_t *, ht_link_t *);
+extern void chash_table_apply(chash_table_t *, bool (*)(ht_link_t *, void *),
+    void *);
+
+#endif
+
+/** @}
+ */
@@ -57,6 +57,7 @@ static inline size_t PAGES2SIZE(size_t pages)
 extern void *as_area_create(void *, size_t, unsigned int,
     as_area_pager_info_t *);
 extern errno_t as_area_resize(void *, size_t, unsigned int);
+extern errno_t as_area_decommit(void *, size_t);
 extern errno_t as_area_change_flags(void *, unsigned int);
 extern errno_t as_area_get_info(void *, as_area_info_t *);
 extern errno_t as_area_destroy(void *);
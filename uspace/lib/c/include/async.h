@@ -105,6 +105,14 @@ struct async_sess;
 typedef struct async_sess async_sess_t;
 typedef struct async_exch async_exch_t;
 
+/** Buffer fragment of a vectored data transfer. */
+typedef struct {
+	/** Base address of the fragment. */
+	void *iov_base;
+	/** Number of bytes in the fragment. */
+	size_t iov_len;
+} async_iovec_t;
+
 extern __noreturn void async_manager(void);
 
 extern bool async_get_call(ipc_call_t *);
@@ -137,6 +145,45 @@ extern void async_set_fallback_port_handler(async_port_handler_t, void *);
 extern errno_t async_create_callback_port(async_exch_t *, iface_t, sysarg_t,
     sysarg_t, async_port_handler_t, void *, port_id_t *);
 
+/*
+ * Event queues multiplex many connections into one consumer fibril.
+ * Instead of dedicating a fibril (and its stack) to every incoming
+ * connection, ports registered with an event queue deliver their
+ * opening calls and all subsequent calls as events that the consumer
+ * receives in batches with async_evq_wait().
+ */
+
+/** Event queue */
+typedef struct async_evq async_evq_t;
+
+/** Type of an event queue event */
+typedef enum {
+	/** Opening call of a new connection */
+	ASYNC_EVQ_CONNECTION,
+	/** Call on an accepted connection */
+	ASYNC_EVQ_CALL,
+	/** Final (hangup) call of a connection */
+	ASYNC_EVQ_HANGUP
+} async_evq_etype_t;
+
+/** Event received from an event queue */
+typedef struct {
+	/** Event type */
+	async_evq_etype_t etype;
+	/** Tag of the port (connection events) or of the connection */
+	void *tag;
+	/** Call data; answer with async_answer_*() */
+	ipc_call_t call;
+} async_evq_event_t;
+
+extern async_evq_t *async_evq_create(void);
+extern void async_evq_destroy(async_evq_t *);
+extern errno_t async_evq_create_port(async_evq_t *, iface_t, void *,
+    port_id_t *);
+extern errno_t async_evq_accept(async_evq_t *, ipc_call_t *, void *);
+extern size_t async_evq_wait(async_evq_t *, async_evq_event_t *, size_t,
+    const struct timespec *);
+
 extern errno_t async_irq_subscribe(int, async_notification_handler_t, void *,
     const irq_code_t *, cap_irq_handle_t *);
 extern errno_t async_irq_unsubscribe(cap_irq_handle_t);
@@ -333,8 +380,12 @@ extern errno_t async_data_read_forward_4_1(async_exch_t *, sysarg_t, sysarg_t,
 
 extern aid_t async_data_read(async_exch_t *, void *, size_t, ipc_call_t *);
 extern errno_t async_data_read_start(async_exch_t *, void *, size_t);
+extern errno_t async_data_readv_start(async_exch_t *, const async_iovec_t *,
+    size_t);
 extern bool async_data_read_receive(ipc_call_t *, size_t *);
 extern errno_t async_data_read_finalize(ipc_call_t *, const void *, size_t);
+extern errno_t async_data_readv_finalize(ipc_call_t *, const async_iovec_t *,
+    size_t);
 
 extern errno_t async_data_write_forward_0_0(async_exch_t *, sysarg_t);
 extern errno_t async_data_write_forward_1_0(async_exch_t *, sysarg_t, sysarg_t);
@@ -356,9 +407,15 @@ extern errno_t async_data_write_forward_3_1(async_exch_t *, sysarg_t, sysarg_t,
 extern errno_t async_data_write_forward_4_1(async_exch_t *, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
 
+extern aid_t async_data_write(async_exch_t *, const void *, size_t,
+    ipc_call_t *);
 extern errno_t async_data_write_start(async_exch_t *, const void *, size_t);
+extern errno_t async_data_writev_start(async_exch_t *, const async_iovec_t *,
+    size_t);
 extern bool async_data_write_receive(ipc_call_t *, size_t *);
 extern errno_t async_data_write_finalize(ipc_call_t *, void *, size_t);
+extern errno_t async_data_writev_finalize(ipc_call_t *, const async_iovec_t *,
+    size_t);
 
 extern errno_t async_data_write_accept(void **, const bool, const size_t,
     const size_t, const size_t, size_t *);
@@ -189,11 +189,16 @@ extern void fibril_semaphore_down(fibril_semaphore_t *);
 extern errno_t fibril_semaphore_down_timeout(fibril_semaphore_t *, usec_t);
 extern void fibril_semaphore_close(fibril_semaphore_t *);
 
+extern void fibril_synch_profile_start(void);
+extern void fibril_synch_profile_stop(void);
+extern void fibril_synch_profile_dump(void);
+
 typedef struct mpsc mpsc_t;
 extern mpsc_t *mpsc_create(size_t);
 extern void mpsc_destroy(mpsc_t *);
 extern errno_t mpsc_send(mpsc_t *, const void *);
 extern errno_t mpsc_receive(mpsc_t *, void *, const struct timespec *);
+extern errno_t mpsc_try_receive(mpsc_t *, void *);
 extern void mpsc_close(mpsc_t *);
 
 __HELENOS_DECLS_END;
@@ -62,6 +62,10 @@ extern void log_msg(log_t, log_level_t, const char *, ...)
     _HELENOS_PRINTF_ATTRIBUTE(3, 4);
 extern void log_msgv(log_t, log_level_t, const char *, va_list);
 
+extern errno_t log_fmt_encode(void *, size_t, size_t *, const char *,
+    va_list);
+extern errno_t log_fmt_render(const void *, size_t, char *, size_t);
+
 #endif
 
 /** @}
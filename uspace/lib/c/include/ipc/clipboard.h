@@ -40,7 +40,9 @@
 typedef enum {
 	CLIPBOARD_PUT_DATA = IPC_FIRST_USER_METHOD,
 	CLIPBOARD_GET_DATA,
-	CLIPBOARD_CONTENT
+	CLIPBOARD_CONTENT,
+	CLIPBOARD_PUT_AREA,
+	CLIPBOARD_GET_AREA
 } clipboard_request_t;
 
 typedef enum {
@@ -68,7 +68,8 @@ typedef enum {
 	LOC_GET_SERVICE_COUNT,
 	LOC_GET_CATEGORIES,
 	LOC_GET_NAMESPACES,
-	LOC_GET_SERVICES
+	LOC_GET_SERVICES,
+	LOC_CATEGORY_GET_SVCS_SINCE
 } loc_request_t;
 
 typedef enum {
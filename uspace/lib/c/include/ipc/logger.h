@@ -34,6 +34,9 @@
 #define _LIBC_IPC_LOGGER_H_
 
 #include <ipc/common.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
 	/** Set (global) default displayed logging level.
@@ -71,9 +74,71 @@ typedef enum {
 	 * Returns: error code
 	 * Followed by: string with the message.
 	 */
-	LOGGER_WRITER_MESSAGE
+	LOGGER_WRITER_MESSAGE,
+	/** Share a message ring buffer with the logger.
+	 *
+	 * Returns: error code
+	 * Followed by: IPC_M_SHARE_OUT of a logger_ring_t area.
+	 */
+	LOGGER_WRITER_RING,
+	/** Ask the logger to drain the shared ring buffer.
+	 *
+	 * Returns: error code
+	 */
+	LOGGER_WRITER_FLUSH
 } logger_writer_request_t;
 
+/** Number of slots in the shared message ring (must be a power of two). */
+#define LOGGER_RING_SLOTS  256
+
+/** Size of one ring message including the terminating zero. */
+#define LOGGER_RING_MSG_SIZE  224
+
+/** Kind of a ring record payload. */
+typedef enum {
+	/** Zero-terminated message text. */
+	LOGGER_REC_TEXT = 0,
+	/** Binary record as produced by log_fmt_encode(). */
+	LOGGER_REC_BINARY = 1
+} logger_rec_kind_t;
+
+/** One record of the shared message ring. */
+typedef struct {
+	/** Absolute index of the record, for overwrite detection. */
+	atomic_size_t seq;
+	/** Log id as returned by LOGGER_WRITER_CREATE_LOG. */
+	sysarg_t log_id;
+	/** Severity level of the message (log_level_t). */
+	uint32_t level;
+	/** Kind of the payload (logger_rec_kind_t). */
+	uint32_t kind;
+	/** Size of the payload (text size excludes the terminating zero). */
+	uint32_t size;
+	/** The payload. */
+	char text[LOGGER_RING_MSG_SIZE];
+} logger_ring_slot_t;
+
+/** Message ring buffer shared between a client and the logger.
+ *
+ * The client appends records at @c head and the logger consumes
+ * them at @c tail; both are free-running indices into the slot
+ * array modulo #LOGGER_RING_SLOTS. On overflow, the client drops
+ * the oldest record by advancing @c tail itself, competing with
+ * the logger using compare-and-swap.
+ */
+typedef struct {
+	/** Index of the next record to be written. */
+	atomic_size_t head;
+	/** Index of the oldest unconsumed record. */
+	atomic_size_t tail;
+	/** Number of records dropped on overflow. */
+	atomic_size_t dropped;
+	/** Set while a LOGGER_WRITER_FLUSH request is outstanding. */
+	atomic_size_t flush_pending;
+	/** The records themselves. */
+	logger_ring_slot_t slot[LOGGER_RING_SLOTS];
+} logger_ring_t;
+
 #endif
 
 /** @}
@@ -74,6 +74,7 @@ typedef enum {
 	VFS_IN_FSPROBE,
 	VFS_IN_FSTYPES,
 	VFS_IN_MOUNT,
+	VFS_IN_MSYNC,
 	VFS_IN_OPEN,
 	VFS_IN_PUT,
 	VFS_IN_READ,
@@ -187,6 +188,8 @@ enum {
 	MODE_READ = 1,
 	MODE_WRITE = 2,
 	MODE_APPEND = 4,
+	/** Let the VFS server coalesce small adjacent writes. */
+	MODE_WRITE_COMBINE = 8,
 };
 
 #endif
@@ -60,6 +60,8 @@ extern errno_t loc_category_get_id(const char *, category_id_t *,
     unsigned int);
 extern errno_t loc_category_get_name(category_id_t, char **);
 extern errno_t loc_category_get_svcs(category_id_t, category_id_t **, size_t *);
+extern errno_t loc_category_get_svcs_since(category_id_t, sysarg_t, sysarg_t *,
+    bool *, service_id_t **, size_t *);
 extern loc_object_type_t loc_id_probe(service_id_t);
 
 extern async_sess_t *loc_service_connect(service_id_t, iface_t,
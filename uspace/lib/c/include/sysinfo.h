@@ -40,9 +40,19 @@
 #include <stdbool.h>
 #include <abi/sysinfo.h>
 
+/** Handle of a resolved sysinfo scalar
+ *
+ * Stable index into the table of scalars exported on the kernel
+ * clock page. Obtained once via sysinfo_get_handle() and then used
+ * to read the current value with a single load.
+ */
+typedef size_t sysinfo_handle_t;
+
 extern char *sysinfo_get_keys(const char *, size_t *);
 extern sysinfo_item_val_type_t sysinfo_get_val_type(const char *);
 extern errno_t sysinfo_get_value(const char *, sysarg_t *);
+extern errno_t sysinfo_get_handle(const char *, sysinfo_handle_t *);
+extern errno_t sysinfo_get_value_by_handle(sysinfo_handle_t, sysarg_t *);
 extern void *sysinfo_get_data(const char *, size_t *);
 extern void *sysinfo_get_property(const char *, const char *, size_t *);
 
@@ -74,6 +74,13 @@ typedef struct module {
 	/** True iff relocations have already been processed in this module. */
 	bool relocated;
 
+	/**
+	 * True iff the PLT has been set up for lazy binding
+	 * (by module_process_pre_arch()), so the jump slot relocations
+	 * must not be processed eagerly.
+	 */
+	bool lazy_plt;
+
 	/** Link to list of all modules in runtime environment */
 	link_t modules_link;
 	/** Link to list of initial modules */
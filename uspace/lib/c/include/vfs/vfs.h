@@ -78,8 +78,32 @@ typedef struct {
 	size_t size;
 } vfs_fstypes_t;
 
+/** Asynchronous file operation in flight.
+ *
+ * Filled in by vfs_read_async(), vfs_write_async() or vfs_sync_async()
+ * and completed by vfs_async_wait(). A single fibril can keep any number
+ * of these in flight at the same time. The buffer passed to the submit
+ * function must stay valid until the operation is completed.
+ */
+typedef struct {
+	aid_t req;		/**< The VFS request proper. */
+	aid_t data_req;		/**< Data transfer phase, 0 if none. */
+	bool done;		/**< The VFS request was collected. */
+	bool data_done;		/**< The data transfer phase was collected. */
+	errno_t rc;		/**< Result of the VFS request. */
+	errno_t data_rc;	/**< Result of the data transfer phase. */
+	ipc_call_t answer;	/**< Answer to the VFS request. */
+} vfs_aio_t;
+
 extern errno_t vfs_fhandle(FILE *, int *);
 
+extern errno_t vfs_read_async(int, aoff64_t, void *, size_t, vfs_aio_t *);
+extern errno_t vfs_write_async(int, aoff64_t, const void *, size_t,
+    vfs_aio_t *);
+extern errno_t vfs_sync_async(int, vfs_aio_t *);
+extern bool vfs_async_poll(vfs_aio_t *);
+extern errno_t vfs_async_wait(vfs_aio_t *, ssize_t *);
+
 extern char *vfs_absolutize(const char *, size_t *);
 extern errno_t vfs_clone(int, int, bool, int *);
 extern errno_t vfs_cwd_get(char *path, size_t);
@@ -93,6 +117,7 @@ extern errno_t vfs_link(int, const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_link_path(const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_lookup(const char *, int, int *);
 extern errno_t vfs_lookup_open(const char *, int, int, int *);
+extern errno_t vfs_map_sync(int, aoff64_t, size_t);
 extern errno_t vfs_mount_path(const char *, const char *, const char *,
     const char *, unsigned int, unsigned int);
 extern errno_t vfs_mount(int, const char *, service_id_t, const char *, unsigned,
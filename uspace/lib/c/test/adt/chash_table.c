@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2012 Adam Hraska
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/chash_table.h>
+#include <adt/hash.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(chash_table);
+
+enum {
+	/* Enough items to force several incremental resizes. */
+	many_items = 3000
+};
+
+typedef struct {
+	ht_link_t link;
+	int key;
+} test_entry_t;
+
+static size_t test_hash(const ht_link_t *item)
+{
+	test_entry_t *entry = hash_table_get_inst(item, test_entry_t, link);
+	return hash_mix(entry->key);
+}
+
+static size_t test_key_hash(const void *key)
+{
+	return hash_mix(*(const int *) key);
+}
+
+static bool test_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	test_entry_t *e1 = hash_table_get_inst(item1, test_entry_t, link);
+	test_entry_t *e2 = hash_table_get_inst(item2, test_entry_t, link);
+	return e1->key == e2->key;
+}
+
+static bool test_key_equal(const void *key, const ht_link_t *item)
+{
+	test_entry_t *entry = hash_table_get_inst(item, test_entry_t, link);
+	return *(const int *) key == entry->key;
+}
+
+static size_t removed_cnt;
+
+static void test_remove_callback(ht_link_t *item)
+{
+	++removed_cnt;
+}
+
+static hash_table_ops_t test_ops = {
+	.hash = test_hash,
+	.key_hash = test_key_hash,
+	.equal = test_equal,
+	.key_equal = test_key_equal,
+	.remove_callback = test_remove_callback
+};
+
+/** Basic insertion, lookup and removal. */
+PCUT_TEST(insert_find_remove)
+{
+	chash_table_t ht;
+	test_entry_t a;
+	test_entry_t b;
+	int key;
+
+	PCUT_ASSERT_TRUE(chash_table_create(&ht, 0, 0, &test_ops));
+	PCUT_ASSERT_TRUE(chash_table_empty(&ht));
+
+	a.key = 1;
+	b.key = 2;
+	chash_table_insert(&ht, &a.link);
+	chash_table_insert(&ht, &b.link);
+
+	PCUT_ASSERT_INT_EQUALS(2, chash_table_size(&ht));
+
+	key = 1;
+	PCUT_ASSERT_EQUALS(&a.link, chash_table_find(&ht, &key));
+	key = 2;
+	PCUT_ASSERT_EQUALS(&b.link, chash_table_find(&ht, &key));
+	key = 3;
+	PCUT_ASSERT_NULL(chash_table_find(&ht, &key));
+
+	removed_cnt = 0;
+	key = 1;
+	PCUT_ASSERT_INT_EQUALS(1, chash_table_remove(&ht, &key));
+	PCUT_ASSERT_INT_EQUALS(1, removed_cnt);
+	PCUT_ASSERT_NULL(chash_table_find(&ht, &key));
+
+	chash_table_remove_item(&ht, &b.link);
+	PCUT_ASSERT_TRUE(chash_table_empty(&ht));
+
+	chash_table_destroy(&ht);
+}
+
+/** Duplicate detection of insert_unique. */
+PCUT_TEST(insert_unique)
+{
+	chash_table_t ht;
+	test_entry_t a;
+	test_entry_t b;
+
+	PCUT_ASSERT_TRUE(chash_table_create(&ht, 0, 0, &test_ops));
+
+	a.key = 42;
+	b.key = 42;
+	PCUT_ASSERT_TRUE(chash_table_insert_unique(&ht, &a.link));
+	PCUT_ASSERT_FALSE(chash_table_insert_unique(&ht, &b.link));
+	PCUT_ASSERT_INT_EQUALS(1, chash_table_size(&ht));
+
+	chash_table_destroy(&ht);
+}
+
+/** Growing and shrinking across incremental resizes keeps all items.
+ *
+ * Inserting this many items triggers several grows; since migration
+ * of each stripe is lazy, the subsequent lookups also exercise the
+ * paths that catch up with a resize in progress.
+ */
+PCUT_TEST(resize)
+{
+	chash_table_t ht;
+	test_entry_t *entries;
+	int i;
+	int key;
+
+	entries = calloc(many_items, sizeof(test_entry_t));
+	PCUT_ASSERT_NOT_NULL(entries);
+
+	PCUT_ASSERT_TRUE(chash_table_create(&ht, 0, 0, &test_ops));
+
+	for (i = 0; i < many_items; i++) {
+		entries[i].key = i;
+		PCUT_ASSERT_TRUE(chash_table_insert_unique(&ht, &entries[i].link));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(many_items, chash_table_size(&ht));
+
+	for (i = 0; i < many_items; i++) {
+		key = i;
+		PCUT_ASSERT_EQUALS(&entries[i].link, chash_table_find(&ht, &key));
+	}
+
+	removed_cnt = 0;
+	for (i = 0; i < many_items; i++) {
+		key = i;
+		PCUT_ASSERT_INT_EQUALS(1, chash_table_remove(&ht, &key));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(many_items, removed_cnt);
+	PCUT_ASSERT_TRUE(chash_table_empty(&ht));
+
+	chash_table_destroy(&ht);
+	free(entries);
+}
+
+/** Clearing removes all items and invokes the removal callback. */
+PCUT_TEST(clear)
+{
+	chash_table_t ht;
+	test_entry_t entries[10];
+	int i;
+
+	PCUT_ASSERT_TRUE(chash_table_create(&ht, 0, 0, &test_ops));
+
+	for (i = 0; i < 10; i++) {
+		entries[i].key = i;
+		chash_table_insert(&ht, &entries[i].link);
+	}
+
+	removed_cnt = 0;
+	chash_table_clear(&ht);
+	PCUT_ASSERT_INT_EQUALS(10, removed_cnt);
+	PCUT_ASSERT_TRUE(chash_table_empty(&ht));
+
+	chash_table_destroy(&ht);
+}
+
+static bool count_item(ht_link_t *item, void *arg)
+{
+	size_t *cnt = arg;
+	++*cnt;
+	return true;
+}
+
+/** Apply visits every item. */
+PCUT_TEST(apply)
+{
+	chash_table_t ht;
+	test_entry_t entries[10];
+	size_t cnt;
+	int i;
+
+	PCUT_ASSERT_TRUE(chash_table_create(&ht, 0, 0, &test_ops));
+
+	for (i = 0; i < 10; i++) {
+		entries[i].key = i;
+		chash_table_insert(&ht, &entries[i].link);
+	}
+
+	cnt = 0;
+	chash_table_apply(&ht, count_item, &cnt);
+	PCUT_ASSERT_INT_EQUALS(10, cnt);
+
+	chash_table_clear(&ht);
+	chash_table_destroy(&ht);
+}
+
+PCUT_EXPORT(chash_table);
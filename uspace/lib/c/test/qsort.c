@@ -33,7 +33,9 @@
 
 enum {
 	/** Length of test number sequences */
-	test_seq_len = 5
+	test_seq_len = 5,
+	/** Length of long test number sequences */
+	test_long_seq_len = 1000
 };
 
 /** Test compare function.
@@ -171,4 +173,39 @@ PCUT_TEST(pseudorandom_seq)
 	free(seq2);
 }
 
+/** Test sorting long pseudorandom sequence.
+ *
+ * Long enough to leave the insertion sort range and exercise the
+ * quicksort/heapsort paths.
+ */
+PCUT_TEST(long_pseudorandom_seq)
+{
+	int *seq, *seq2;
+	int i;
+	int v;
+
+	seq = calloc(test_long_seq_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	seq2 = calloc(test_long_seq_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq2);
+
+	v = 1;
+	for (i = 0; i < test_long_seq_len; i++) {
+		seq[i] = v;
+		seq2[i] = v;
+		v = seq_next(v);
+	}
+
+	qsort(seq, test_long_seq_len, sizeof(int), test_cmp);
+	bubble_sort(seq2, test_long_seq_len);
+
+	for (i = 0; i < test_long_seq_len; i++) {
+		PCUT_ASSERT_INT_EQUALS(seq2[i], seq[i]);
+	}
+
+	free(seq);
+	free(seq2);
+}
+
 PCUT_EXPORT(qsort);
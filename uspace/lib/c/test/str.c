@@ -114,4 +114,36 @@ PCUT_TEST(str_str_empty_n)
 	PCUT_ASSERT_TRUE((const char *)p == hs);
 }
 
+PCUT_TEST(str_size_alignment)
+{
+	/* Exercise all alignments of the word-at-a-time scan. */
+	for (size_t off = 0; off < sizeof(unsigned long); off++) {
+		for (size_t len = 0; len < 3 * sizeof(unsigned long); len++) {
+			memset(buffer, 'x', BUFFER_SIZE);
+			buffer[off + len] = 0;
+			PCUT_ASSERT_INT_EQUALS(len, str_size(buffer + off));
+		}
+	}
+}
+
+PCUT_TEST(str_cmp_ascii)
+{
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("abcd", "abcd"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abcc", "abcd"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("abcd", "abcc"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abc", "abcd"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("abcd", "abc"));
+}
+
+PCUT_TEST(str_cmp_non_ascii)
+{
+	/* Comparison must leave the ASCII fast path correctly. */
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("abcš", "abcš"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abcd", "abcš"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("abcš", "abcd"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("š", "ž"));
+	PCUT_ASSERT_INT_EQUALS(0, str_lcmp("abcš", "abcž", 3));
+	PCUT_ASSERT_INT_EQUALS(-1, str_lcmp("abcš", "abcž", 4));
+}
+
 PCUT_EXPORT(str);
@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Implementation of deflate compression
+ *
+ * A simple deflate implementation (compression into a `deflate' stream as
+ * described by RFC 1951), the counterpart of inflate.c. Matches are found
+ * with a hash chain over the previous 32 KiB of input and encoded using
+ * the fixed Huffman tables, so the output can be decoded by any inflate
+ * implementation. The compression level controls how many chain entries
+ * are searched for each position; level 0 emits stored (uncompressed)
+ * blocks only.
+ *
+ * When the compressed form of the data would be larger than its stored
+ * form (e.g. for already compressed input), the routine falls back to
+ * stored blocks, so the output size never exceeds deflate_bound().
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "deflate.h"
+
+/** Sliding window size */
+#define DEFLATE_WINDOW  32768
+/** Number of hash buckets */
+#define HASH_SIZE       (1 << 15)
+/** Minimum match length */
+#define MIN_MATCH       3
+/** Maximum match length */
+#define MAX_MATCH       258
+/** Maximum stored block size */
+#define STORED_MAX      65535
+
+/** Number of length codes */
+#define MAX_LEN   29
+/** Number of distance codes */
+#define MAX_DIST  30
+
+/** Chain position meaning no position */
+#define NOPOS  UINT32_MAX
+
+/** Deflate algorithm state
+ *
+ */
+typedef struct {
+	uint8_t *dest;    /**< Output buffer */
+	size_t destlen;   /**< Output buffer size */
+	size_t destcnt;   /**< Position in the output buffer */
+
+	uint32_t bitbuf;  /**< Bit buffer */
+	size_t bitlen;    /**< Number of bits in the bit buffer */
+
+	bool overrun;     /**< Output overrun condition */
+} deflate_state_t;
+
+/** Length code base values
+ *
+ */
+static const uint16_t lens[MAX_LEN] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Length code extra bits
+ *
+ */
+static const uint16_t lens_ext[MAX_LEN] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/** Distance code base values
+ *
+ */
+static const uint16_t dists[MAX_DIST] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+/** Distance code extra bits
+ *
+ */
+static const uint16_t dists_ext[MAX_DIST] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 13, 13
+};
+
+/** Write bits to the output buffer (least significant bit first)
+ *
+ * @param state Deflate state.
+ * @param val   Bits to write.
+ * @param len   Number of bits to write.
+ *
+ */
+static void deflate_put_bits(deflate_state_t *state, uint32_t val, size_t len)
+{
+	state->bitbuf |= val << state->bitlen;
+	state->bitlen += len;
+
+	while (state->bitlen >= 8) {
+		if (state->destcnt < state->destlen)
+			state->dest[state->destcnt] = (uint8_t) state->bitbuf;
+		else
+			state->overrun = true;
+
+		state->destcnt++;
+		state->bitbuf >>= 8;
+		state->bitlen -= 8;
+	}
+}
+
+/** Pad the output with zero bits to the next byte boundary
+ *
+ * @param state Deflate state.
+ *
+ */
+static void deflate_align(deflate_state_t *state)
+{
+	if (state->bitlen > 0)
+		deflate_put_bits(state, 0, 8 - state->bitlen);
+}
+
+/** Write a Huffman code to the output buffer
+ *
+ * Huffman codes are packed starting with the most significant bit,
+ * the reverse of everything else in a deflate stream.
+ *
+ * @param state Deflate state.
+ * @param code  Huffman code.
+ * @param len   Code length in bits.
+ *
+ */
+static void deflate_put_code(deflate_state_t *state, uint32_t code, size_t len)
+{
+	uint32_t rev = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		rev = (rev << 1) | (code & 1);
+		code >>= 1;
+	}
+
+	deflate_put_bits(state, rev, len);
+}
+
+/** Write a fixed Huffman literal/length symbol
+ *
+ * @param state Deflate state.
+ * @param sym   Literal/length symbol (0 - 287).
+ *
+ */
+static void deflate_put_litlen(deflate_state_t *state, unsigned sym)
+{
+	if (sym < 144)
+		deflate_put_code(state, 0x30 + sym, 8);
+	else if (sym < 256)
+		deflate_put_code(state, 0x190 + sym - 144, 9);
+	else if (sym < 280)
+		deflate_put_code(state, sym - 256, 7);
+	else
+		deflate_put_code(state, 0xc0 + sym - 280, 8);
+}
+
+/** Write a match length
+ *
+ * @param state Deflate state.
+ * @param len   Match length (MIN_MATCH - MAX_MATCH).
+ *
+ */
+static void deflate_put_len(deflate_state_t *state, size_t len)
+{
+	unsigned idx = MAX_LEN - 1;
+
+	while (lens[idx] > len)
+		idx--;
+
+	deflate_put_litlen(state, 257 + idx);
+	if (lens_ext[idx] > 0)
+		deflate_put_bits(state, len - lens[idx], lens_ext[idx]);
+}
+
+/** Write a match distance
+ *
+ * @param state Deflate state.
+ * @param dist  Match distance (1 - DEFLATE_WINDOW).
+ *
+ */
+static void deflate_put_dist(deflate_state_t *state, size_t dist)
+{
+	unsigned idx = MAX_DIST - 1;
+
+	while (dists[idx] > dist)
+		idx--;
+
+	deflate_put_code(state, idx, 5);
+	if (dists_ext[idx] > 0)
+		deflate_put_bits(state, dist - dists[idx], dists_ext[idx]);
+}
+
+/** Hash the three bytes starting at @a src
+ *
+ */
+static unsigned deflate_hash(uint8_t *src)
+{
+	return (((unsigned) src[0] << 10) ^ ((unsigned) src[1] << 5) ^
+	    (unsigned) src[2]) & (HASH_SIZE - 1);
+}
+
+/** Insert position @a pos into the hash chains
+ *
+ */
+static void deflate_insert(uint8_t *src, size_t pos, uint32_t *head,
+    uint32_t *prev)
+{
+	unsigned h = deflate_hash(src + pos);
+
+	prev[pos & (DEFLATE_WINDOW - 1)] = head[h];
+	head[h] = pos;
+}
+
+/** Compute the length of the match of @a pos against @a cand
+ *
+ */
+static size_t deflate_match_len(uint8_t *src, size_t srclen, size_t cand,
+    size_t pos)
+{
+	size_t max = srclen - pos;
+	size_t len = 0;
+
+	if (max > MAX_MATCH)
+		max = MAX_MATCH;
+
+	while ((len < max) && (src[cand + len] == src[pos + len]))
+		len++;
+
+	return len;
+}
+
+/** Emit the data as stored (uncompressed) blocks
+ *
+ * @param state  Deflate state.
+ * @param src    Input buffer.
+ * @param srclen Input buffer size (bytes).
+ * @param last   Mark the last block as final.
+ *
+ */
+static void deflate_stored(deflate_state_t *state, uint8_t *src, size_t srclen,
+    bool last)
+{
+	size_t pos = 0;
+
+	do {
+		size_t len = srclen - pos;
+		if (len > STORED_MAX)
+			len = STORED_MAX;
+
+		bool final = last && (pos + len == srclen);
+
+		deflate_put_bits(state, final ? 1 : 0, 1);
+		deflate_put_bits(state, 0, 2);
+		deflate_align(state);
+
+		deflate_put_bits(state, len & 0xff, 8);
+		deflate_put_bits(state, (len >> 8) & 0xff, 8);
+		deflate_put_bits(state, ~len & 0xff, 8);
+		deflate_put_bits(state, (~len >> 8) & 0xff, 8);
+
+		if (state->destcnt + len <= state->destlen)
+			memcpy(state->dest + state->destcnt, src + pos, len);
+		else
+			state->overrun = true;
+
+		state->destcnt += len;
+		pos += len;
+	} while (pos < srclen);
+}
+
+/** Emit the data as a single fixed Huffman block
+ *
+ * Greedy LZ77 parse: for each position the hash chain is searched
+ * for the longest match within the window, the number of candidates
+ * examined being bounded by 2^level.
+ *
+ * @param state  Deflate state.
+ * @param src    Input buffer.
+ * @param srclen Input buffer size (bytes).
+ * @param level  Compression level (1 - 9).
+ * @param head   Hash bucket array (HASH_SIZE entries).
+ * @param prev   Chain link array (DEFLATE_WINDOW entries).
+ * @param last   Mark the block as final.
+ *
+ */
+static void deflate_fixed(deflate_state_t *state, uint8_t *src, size_t srclen,
+    unsigned level, uint32_t *head, uint32_t *prev, bool last)
+{
+	size_t max_chain = 1 << level;
+	size_t pos = 0;
+
+	memset(head, 0xff, HASH_SIZE * sizeof(uint32_t));
+
+	deflate_put_bits(state, last ? 1 : 0, 1);
+	deflate_put_bits(state, 1, 2);
+
+	while (pos < srclen) {
+		size_t best_len = 0;
+		size_t best_dist = 0;
+
+		if (pos + MIN_MATCH <= srclen) {
+			uint32_t cand = head[deflate_hash(src + pos)];
+			size_t chain = max_chain;
+
+			while ((cand != NOPOS) && (pos - cand <= DEFLATE_WINDOW) &&
+			    (chain > 0)) {
+				size_t len = deflate_match_len(src, srclen,
+				    cand, pos);
+				if (len > best_len) {
+					best_len = len;
+					best_dist = pos - cand;
+					if (len >= MAX_MATCH)
+						break;
+				}
+
+				/*
+				 * Entries in prev are overwritten as the
+				 * window slides; a stale link would point
+				 * forward instead of backward.
+				 */
+				uint32_t next = prev[cand & (DEFLATE_WINDOW - 1)];
+				if ((next == NOPOS) || (next >= cand))
+					break;
+
+				cand = next;
+				chain--;
+			}
+		}
+
+		if (best_len >= MIN_MATCH) {
+			deflate_put_len(state, best_len);
+			deflate_put_dist(state, best_dist);
+
+			while (best_len > 0) {
+				if (pos + MIN_MATCH <= srclen)
+					deflate_insert(src, pos, head, prev);
+				pos++;
+				best_len--;
+			}
+		} else {
+			deflate_put_litlen(state, src[pos]);
+			deflate_insert(src, pos, head, prev);
+			pos++;
+		}
+	}
+
+	/* End of block */
+	deflate_put_litlen(state, 256);
+}
+
+/** Compute the maximum size of the compressed form of data
+ *
+ * @param srclen Input data size (bytes).
+ *
+ * @return Maximum number of bytes deflate_part() can produce
+ *         for @a srclen bytes of input.
+ *
+ */
+size_t deflate_bound(size_t srclen)
+{
+	/* Stored block headers plus one empty sync block */
+	return srclen + (srclen / STORED_MAX + 1) * 5 + 5;
+}
+
+/** Compress data into a part of a deflate stream
+ *
+ * Produce deflate blocks encoding @a src. If @a last is true, the
+ * final block is marked as ending the stream; otherwise the output
+ * is flushed to a byte boundary with an empty stored block so that
+ * parts compressed independently can be concatenated into a single
+ * valid stream (the last part having @a last set).
+ *
+ * Note that each part is compressed with an empty window, so splitting
+ * a stream into many small parts reduces the compression ratio.
+ *
+ * @param src     Source data buffer.
+ * @param srclen  Source buffer size (bytes).
+ * @param dest    Destination data buffer.
+ * @param destlen Destination buffer size (bytes).
+ * @param ndest   Place to store number of bytes written.
+ * @param level   Compression level (0 - 9).
+ * @param last    This is the last part of the stream.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM on failure to allocate the match finder state.
+ * @return ELIMIT on output buffer overrun.
+ *
+ */
+errno_t deflate_part(void *src, size_t srclen, void *dest, size_t destlen,
+    size_t *ndest, unsigned level, bool last)
+{
+	deflate_state_t state;
+
+	if (level > deflate_level_max)
+		return EINVAL;
+
+	state.dest = (uint8_t *) dest;
+	state.destlen = destlen;
+	state.destcnt = 0;
+	state.bitbuf = 0;
+	state.bitlen = 0;
+	state.overrun = false;
+
+	if (level == deflate_level_store) {
+		deflate_stored(&state, (uint8_t *) src, srclen, last);
+	} else {
+		uint32_t *head = malloc(HASH_SIZE * sizeof(uint32_t));
+		uint32_t *prev = malloc(DEFLATE_WINDOW * sizeof(uint32_t));
+
+		if ((head == NULL) || (prev == NULL)) {
+			free(head);
+			free(prev);
+			return ENOMEM;
+		}
+
+		deflate_fixed(&state, (uint8_t *) src, srclen, level, head,
+		    prev, last);
+		free(head);
+		free(prev);
+
+		if (!last) {
+			/* Sync flush: empty stored block */
+			deflate_put_bits(&state, 0, 3);
+			deflate_align(&state);
+			deflate_put_bits(&state, 0x0000, 16);
+			deflate_put_bits(&state, 0xffff, 16);
+		}
+
+		if (state.overrun) {
+			/* Data does not compress, store it instead */
+			state.destcnt = 0;
+			state.bitbuf = 0;
+			state.bitlen = 0;
+			state.overrun = false;
+
+			deflate_stored(&state, (uint8_t *) src, srclen, last);
+		}
+	}
+
+	deflate_align(&state);
+
+	if (state.overrun)
+		return ELIMIT;
+
+	*ndest = state.destcnt;
+	return EOK;
+}
+
+/** Compress data into a complete deflate stream
+ *
+ * @param src     Source data buffer.
+ * @param srclen  Source buffer size (bytes).
+ * @param dest    Destination data buffer.
+ * @param destlen Destination buffer size (bytes).
+ * @param ndest   Place to store number of bytes written.
+ * @param level   Compression level (0 - 9).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM on failure to allocate the match finder state.
+ * @return ELIMIT on output buffer overrun.
+ *
+ */
+errno_t deflate(void *src, size_t srclen, void *dest, size_t destlen,
+    size_t *ndest, unsigned level)
+{
+	return deflate_part(src, srclen, dest, destlen, ndest, level, true);
+}
@@ -28,11 +28,16 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <errno.h>
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/list.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include "gzip.h"
+#include "deflate.h"
 #include "inflate.h"
 
 #define GZIP_ID1  UINT8_C(0x1f)
@@ -61,6 +66,112 @@ typedef struct {
 	uint32_t size;
 } __attribute__((packed)) gzip_footer_t;
 
+/** Input block size of the streaming compressor */
+#define GZIP_COMP_BLOCK  (128 * 1024)
+
+/** Block of a streaming compression stream */
+typedef struct {
+	/** Link to gzip_comp_t.blocks */
+	link_t lblocks;
+	/** Containing compression stream */
+	struct gzip_comp *comp;
+	/** Uncompressed data */
+	uint8_t *data;
+	/** Uncompressed data size */
+	size_t size;
+	/** Compressed data */
+	uint8_t *cdata;
+	/** Compressed data size */
+	size_t csize;
+	/** This is the last block of the stream */
+	bool last;
+	/** Compression has finished */
+	bool done;
+	/** Compression result */
+	errno_t rc;
+} gzip_comp_blk_t;
+
+/** Streaming gzip compressor */
+struct gzip_comp {
+	/** Protects blocks, nblocks, done flags and rc */
+	fibril_mutex_t lock;
+	/** Signalled when a block finishes compressing */
+	fibril_condvar_t done_cv;
+	/** Compression level */
+	unsigned level;
+	/** Maximum number of blocks compressed concurrently */
+	unsigned nfibrils;
+	/** Output sink */
+	gzip_write_cb_t write_cb;
+	/** Argument to write_cb */
+	void *write_arg;
+	/** In-flight blocks (of gzip_comp_blk_t), oldest first */
+	list_t blocks;
+	/** Number of in-flight blocks */
+	size_t nblocks;
+	/** Input block being filled */
+	uint8_t *buf;
+	/** Number of bytes in @c buf */
+	size_t nbuf;
+	/** CRC-32 of all input so far */
+	uint32_t crc;
+	/** Total input size */
+	uint64_t size;
+	/** First error encountered */
+	errno_t rc;
+};
+
+/** CRC-32 (IEEE 802.3) lookup table */
+static uint32_t crc32_table[256];
+static bool crc32_ready = false;
+
+/** Fill in the CRC-32 lookup table
+ *
+ * Filling the table is idempotent so a race between two fibrils
+ * initializing it at the same time is harmless.
+ *
+ */
+static void gzip_crc32_init(void)
+{
+	unsigned n;
+	unsigned k;
+
+	for (n = 0; n < 256; n++) {
+		uint32_t c = n;
+
+		for (k = 0; k < 8; k++) {
+			if ((c & 1) != 0)
+				c = UINT32_C(0xedb88320) ^ (c >> 1);
+			else
+				c = c >> 1;
+		}
+
+		crc32_table[n] = c;
+	}
+
+	crc32_ready = true;
+}
+
+/** Update a CRC-32 checksum with a run of data
+ *
+ * @param crc  Checksum so far (0 initially).
+ * @param data Data buffer.
+ * @param size Data size (bytes).
+ *
+ * @return Updated checksum.
+ *
+ */
+static uint32_t gzip_crc32(uint32_t crc, uint8_t *data, size_t size)
+{
+	size_t i;
+
+	crc ^= UINT32_C(0xffffffff);
+	for (i = 0; i < size; i++)
+		crc = crc32_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return crc ^ UINT32_C(0xffffffff);
+}
+
 /** Expand GZIP compressed data
  *
  * The routine allocates the output buffer based
@@ -175,9 +286,378 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 
 	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
 	if (ret != EOK) {
-		free(dest);
+		free(*dest);
 		return ret;
 	}
 
 	return EOK;
 }
+
+/** Compress data into GZIP format
+ *
+ * The routine allocates the output buffer. The worst-case output
+ * size is slightly larger than the input size (already compressed
+ * input is stored rather than expanded).
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ * @param[in]  level   Compression level (0 - 9).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM on failure to allocate memory.
+ *
+ */
+errno_t gzip_compress(void *src, size_t srclen, void **dest, size_t *destlen,
+    unsigned level)
+{
+	gzip_header_t header;
+	gzip_footer_t footer;
+	size_t nbytes;
+	errno_t rc;
+
+	if (!crc32_ready)
+		gzip_crc32_init();
+
+	size_t bound = sizeof(header) + deflate_bound(srclen) + sizeof(footer);
+
+	uint8_t *buf = malloc(bound);
+	if (buf == NULL)
+		return ENOMEM;
+
+	memset(&header, 0, sizeof(header));
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+	memcpy(buf, &header, sizeof(header));
+
+	rc = deflate(src, srclen, buf + sizeof(header),
+	    bound - sizeof(header) - sizeof(footer), &nbytes, level);
+	if (rc != EOK) {
+		free(buf);
+		return rc;
+	}
+
+	footer.crc32 = host2uint32_t_le(gzip_crc32(0, src, srclen));
+	footer.size = host2uint32_t_le((uint32_t) srclen);
+	memcpy(buf + sizeof(header) + nbytes, &footer, sizeof(footer));
+
+	*destlen = sizeof(header) + nbytes + sizeof(footer);
+
+	/* Trim the buffer down to the actual output size */
+	void *shrunk = realloc(buf, *destlen);
+	*dest = (shrunk != NULL) ? shrunk : buf;
+
+	return EOK;
+}
+
+/** Block compression fibril
+ *
+ * Compresses a single block of a streaming compression stream
+ * and marks it as done.
+ *
+ * @param arg Block (gzip_comp_blk_t *).
+ * @return EOK (fibril exits when the block is compressed).
+ *
+ */
+static errno_t gzip_comp_fibril(void *arg)
+{
+	gzip_comp_blk_t *blk = (gzip_comp_blk_t *) arg;
+	gzip_comp_t *comp = blk->comp;
+
+	blk->rc = deflate_part(blk->data, blk->size, blk->cdata,
+	    deflate_bound(blk->size), &blk->csize, comp->level, blk->last);
+
+	fibril_mutex_lock(&comp->lock);
+	blk->done = true;
+	fibril_condvar_broadcast(&comp->done_cv);
+	fibril_mutex_unlock(&comp->lock);
+
+	return EOK;
+}
+
+/** Write out finished blocks in input order
+ *
+ * Must be called with comp->lock held. If @a all is true, waits
+ * until every in-flight block has been compressed and written out.
+ * Otherwise waits only as long as the number of in-flight blocks
+ * is at the limit (backpressure).
+ *
+ * @param comp Compression stream.
+ * @param all  Drain all in-flight blocks.
+ *
+ */
+static void gzip_comp_drain(gzip_comp_t *comp, bool all)
+{
+	link_t *link;
+	gzip_comp_blk_t *blk;
+	errno_t rc;
+
+	while ((link = list_first(&comp->blocks)) != NULL) {
+		blk = list_get_instance(link, gzip_comp_blk_t, lblocks);
+
+		if (!blk->done) {
+			if (!all && comp->nblocks < comp->nfibrils)
+				break;
+
+			fibril_condvar_wait(&comp->done_cv, &comp->lock);
+			continue;
+		}
+
+		list_remove(&blk->lblocks);
+		comp->nblocks--;
+
+		fibril_mutex_unlock(&comp->lock);
+		rc = blk->rc;
+		if (rc == EOK)
+			rc = comp->write_cb(comp->write_arg, blk->cdata,
+			    blk->csize);
+		free(blk->data);
+		free(blk->cdata);
+		free(blk);
+		fibril_mutex_lock(&comp->lock);
+
+		if ((rc != EOK) && (comp->rc == EOK))
+			comp->rc = rc;
+	}
+}
+
+/** Post the current input block for compression
+ *
+ * Hands the input block being filled over to a compression fibril
+ * and starts a new one (unless @a last). If the number of in-flight
+ * blocks is at the limit, first waits for the oldest one to finish.
+ *
+ * @param comp Compression stream.
+ * @param last This is the last block of the stream.
+ *
+ * @return EOK on success.
+ * @return ENOMEM on failure to allocate memory.
+ *
+ */
+static errno_t gzip_comp_post(gzip_comp_t *comp, bool last)
+{
+	gzip_comp_blk_t *blk;
+	uint8_t *nbuf = NULL;
+	fid_t fid;
+
+	blk = calloc(1, sizeof(gzip_comp_blk_t));
+	if (blk == NULL)
+		return ENOMEM;
+
+	blk->cdata = malloc(deflate_bound(comp->nbuf));
+	if (blk->cdata == NULL) {
+		free(blk);
+		return ENOMEM;
+	}
+
+	if (!last) {
+		nbuf = malloc(GZIP_COMP_BLOCK);
+		if (nbuf == NULL) {
+			free(blk->cdata);
+			free(blk);
+			return ENOMEM;
+		}
+	}
+
+	blk->comp = comp;
+	blk->data = comp->buf;
+	blk->size = comp->nbuf;
+	blk->last = last;
+
+	comp->buf = nbuf;
+	comp->nbuf = 0;
+
+	fibril_mutex_lock(&comp->lock);
+	gzip_comp_drain(comp, false);
+	list_append(&blk->lblocks, &comp->blocks);
+	comp->nblocks++;
+	fibril_mutex_unlock(&comp->lock);
+
+	fid = fibril_create(gzip_comp_fibril, blk);
+	if (fid != 0)
+		fibril_add_ready(fid);
+	else
+		(void) gzip_comp_fibril(blk);
+
+	return EOK;
+}
+
+/** Create a streaming gzip compressor
+ *
+ * Input passed to gzip_comp_write() is split into 128 KiB blocks which
+ * are compressed by separate fibrils, up to @a nfibrils of them at a
+ * time, and written to @a write_cb in input order (the blocks form a
+ * single deflate stream, so the output is an ordinary GZIP file).
+ * For the block compression to actually proceed in parallel the
+ * application must enable multithreaded execution of fibrils.
+ *
+ * @param[in]  level     Compression level (0 - 9).
+ * @param[in]  nfibrils  Maximum number of blocks compressed
+ *                       concurrently (0 means 1).
+ * @param[in]  write_cb  Output sink.
+ * @param[in]  write_arg Argument to @a write_cb.
+ * @param[out] rcomp     Place to store pointer to new compression stream.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM on failure to allocate memory.
+ * @return Other error code from @a write_cb.
+ *
+ */
+errno_t gzip_comp_create(unsigned level, unsigned nfibrils,
+    gzip_write_cb_t write_cb, void *write_arg, gzip_comp_t **rcomp)
+{
+	gzip_comp_t *comp;
+	gzip_header_t header;
+	errno_t rc;
+
+	if (level > deflate_level_max)
+		return EINVAL;
+
+	if (!crc32_ready)
+		gzip_crc32_init();
+
+	comp = calloc(1, sizeof(gzip_comp_t));
+	if (comp == NULL)
+		return ENOMEM;
+
+	fibril_mutex_initialize(&comp->lock);
+	fibril_condvar_initialize(&comp->done_cv);
+	list_initialize(&comp->blocks);
+	comp->level = level;
+	comp->nfibrils = (nfibrils > 0) ? nfibrils : 1;
+	comp->write_cb = write_cb;
+	comp->write_arg = write_arg;
+	comp->rc = EOK;
+
+	comp->buf = malloc(GZIP_COMP_BLOCK);
+	if (comp->buf == NULL) {
+		free(comp);
+		return ENOMEM;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+
+	rc = write_cb(write_arg, &header, sizeof(header));
+	if (rc != EOK) {
+		free(comp->buf);
+		free(comp);
+		return rc;
+	}
+
+	*rcomp = comp;
+	return EOK;
+}
+
+/** Write data to a compression stream
+ *
+ * @param comp Compression stream.
+ * @param data Data buffer.
+ * @param size Data size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOMEM on failure to allocate memory.
+ *
+ */
+errno_t gzip_comp_write(gzip_comp_t *comp, void *data, size_t size)
+{
+	uint8_t *dp = (uint8_t *) data;
+	errno_t rc;
+
+	while (size > 0) {
+		size_t n = GZIP_COMP_BLOCK - comp->nbuf;
+		if (n > size)
+			n = size;
+
+		memcpy(comp->buf + comp->nbuf, dp, n);
+		comp->crc = gzip_crc32(comp->crc, dp, n);
+		comp->nbuf += n;
+		comp->size += n;
+		dp += n;
+		size -= n;
+
+		if (comp->nbuf == GZIP_COMP_BLOCK) {
+			rc = gzip_comp_post(comp, false);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	return EOK;
+}
+
+/** Finish a compression stream
+ *
+ * Compresses any buffered input as the final block, waits for all
+ * in-flight blocks to be written out and writes the GZIP footer.
+ * The stream must still be freed with gzip_comp_destroy().
+ *
+ * @param comp Compression stream.
+ *
+ * @return EOK on success.
+ * @return ENOMEM on failure to allocate memory.
+ * @return Other error code from the output sink.
+ *
+ */
+errno_t gzip_comp_finish(gzip_comp_t *comp)
+{
+	gzip_footer_t footer;
+	errno_t rc;
+
+	rc = gzip_comp_post(comp, true);
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&comp->lock);
+	gzip_comp_drain(comp, true);
+	rc = comp->rc;
+	fibril_mutex_unlock(&comp->lock);
+
+	if (rc != EOK)
+		return rc;
+
+	footer.crc32 = host2uint32_t_le(comp->crc);
+	footer.size = host2uint32_t_le((uint32_t) comp->size);
+
+	return comp->write_cb(comp->write_arg, &footer, sizeof(footer));
+}
+
+/** Destroy a compression stream
+ *
+ * Waits for any in-flight blocks and discards them. If the stream
+ * was not finished with gzip_comp_finish(), the output is truncated.
+ *
+ * @param comp Compression stream.
+ *
+ */
+void gzip_comp_destroy(gzip_comp_t *comp)
+{
+	link_t *link;
+	gzip_comp_blk_t *blk;
+
+	fibril_mutex_lock(&comp->lock);
+	while ((link = list_first(&comp->blocks)) != NULL) {
+		blk = list_get_instance(link, gzip_comp_blk_t, lblocks);
+
+		if (!blk->done) {
+			fibril_condvar_wait(&comp->done_cv, &comp->lock);
+			continue;
+		}
+
+		list_remove(&blk->lblocks);
+		comp->nblocks--;
+		free(blk->data);
+		free(blk->cdata);
+		free(blk);
+	}
+	fibril_mutex_unlock(&comp->lock);
+
+	free(comp->buf);
+	free(comp);
+}
@@ -31,6 +31,19 @@
 
 #include <stddef.h>
 
+/** Output sink for streaming compression */
+typedef errno_t (*gzip_write_cb_t)(void *, void *, size_t);
+
+struct gzip_comp;
+typedef struct gzip_comp gzip_comp_t;
+
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
+extern errno_t gzip_compress(void *, size_t, void **, size_t *, unsigned);
+
+extern errno_t gzip_comp_create(unsigned, unsigned, gzip_write_cb_t, void *,
+    gzip_comp_t **);
+extern errno_t gzip_comp_write(gzip_comp_t *, void *, size_t);
+extern errno_t gzip_comp_finish(gzip_comp_t *);
+extern void gzip_comp_destroy(gzip_comp_t *);
 
 #endif
@@ -47,6 +47,8 @@
 #include "../private/console.h"
 #include "../private/color.h"
 
+static void console_gc_putfield(console_gc_t *, gfx_coord_t, gfx_coord_t,
+    charfield_t *, gfx_rect_t *);
 static errno_t console_gc_set_clip_rect(void *, gfx_rect_t *);
 static errno_t console_gc_set_color(void *, gfx_color_t *);
 static errno_t console_gc_fill_rect(void *, gfx_rect_t *);
@@ -68,6 +70,43 @@ gfx_context_ops_t console_gc_ops = {
 	.bitmap_get_alloc = console_gc_bitmap_get_alloc
 };
 
+/** Store character field if it differs from current buffer contents.
+ *
+ * Write @a ch to the buffer cell at @a x, @a y only if the cell does
+ * not already have the same contents. If the cell is written, the
+ * update rectangle @a upd is extended to cover it. This way unchanged
+ * cells produce no console update traffic.
+ *
+ * @param cgc Console GC
+ * @param x Column
+ * @param y Row
+ * @param ch Character field
+ * @param upd Update rectangle to extend
+ */
+static void console_gc_putfield(console_gc_t *cgc, gfx_coord_t x,
+    gfx_coord_t y, charfield_t *ch, gfx_rect_t *upd)
+{
+	gfx_coord_t cols;
+	charfield_t *cur;
+
+	cols = cgc->rect.p1.x - cgc->rect.p0.x;
+	cur = &cgc->buf[y * cols + x];
+
+	if (cur->ch == ch->ch && attrs_same(cur->attrs, ch->attrs))
+		return;
+
+	*cur = *ch;
+
+	if (x < upd->p0.x)
+		upd->p0.x = x;
+	if (y < upd->p0.y)
+		upd->p0.y = y;
+	if (x + 1 > upd->p1.x)
+		upd->p1.x = x + 1;
+	if (y + 1 > upd->p1.y)
+		upd->p1.y = y + 1;
+}
+
 /** Set clipping rectangle on console GC.
  *
  * @param arg Console GC
@@ -115,14 +154,16 @@ static errno_t console_gc_fill_rect(void *arg, gfx_rect_t *rect)
 {
 	console_gc_t *cgc = (console_gc_t *) arg;
 	gfx_coord_t x, y;
-	gfx_coord_t cols;
 	gfx_rect_t crect;
+	gfx_rect_t upd;
 	charfield_t ch;
 
 	/* Make sure rectangle is clipped and sorted */
 	gfx_rect_clip(rect, &cgc->clip_rect, &crect);
 
-	cols = cgc->rect.p1.x - cgc->rect.p0.x;
+	/* Update rectangle starts out empty and is extended cell by cell */
+	upd.p0 = crect.p1;
+	upd.p1 = crect.p0;
 
 	ch.ch = cgc->clr >> 24;
 	ch.flags = CHAR_FLAG_DIRTY;
@@ -132,12 +173,14 @@ static errno_t console_gc_fill_rect(void *arg, gfx_rect_t *rect)
 
 	for (y = crect.p0.y; y < crect.p1.y; y++) {
 		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			cgc->buf[y * cols + x] = ch;
+			console_gc_putfield(cgc, x, y, &ch, &upd);
 		}
 	}
 
-	console_update(cgc->con, crect.p0.x, crect.p0.y,
-	    crect.p1.x, crect.p1.y);
+	if (!gfx_rect_is_empty(&upd)) {
+		console_update(cgc->con, upd.p0.x, upd.p0.y,
+		    upd.p1.x, upd.p1.y);
+	}
 
 	return EOK;
 }
@@ -335,8 +378,8 @@ static errno_t console_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_rect_t srect;
 	gfx_rect_t drect;
 	gfx_rect_t crect;
+	gfx_rect_t upd;
 	gfx_coord2_t offs;
-	gfx_coord_t cols;
 
 	if (srect0 != NULL)
 		srect = *srect0;
@@ -354,10 +397,12 @@ static errno_t console_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_rect_clip(&drect, &cbm->cgc->clip_rect, &crect);
 
 	pixelmap.width = cbm->rect.p1.x - cbm->rect.p0.x;
-	pixelmap.height = cbm->rect.p1.y = cbm->rect.p1.y;
+	pixelmap.height = cbm->rect.p1.y - cbm->rect.p0.y;
 	pixelmap.data = cbm->alloc.pixels;
 
-	cols = cbm->cgc->rect.p1.x - cbm->cgc->rect.p0.x;
+	/* Update rectangle starts out empty and is extended cell by cell */
+	upd.p0 = crect.p1;
+	upd.p1 = crect.p0;
 
 	if ((cbm->flags & bmpf_color_key) == 0) {
 		/* Simple copy */
@@ -373,7 +418,8 @@ static errno_t console_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 				ch.attrs.val.rgb.fgcolor = clr ^ 0xffffff;
 				ch.attrs.val.rgb.bgcolor = clr;
 
-				cbm->cgc->buf[y * cols + x] = ch;
+				console_gc_putfield(cbm->cgc, x, y, &ch,
+				    &upd);
 			}
 		}
 	} else if ((cbm->flags & bmpf_colorize) == 0) {
@@ -391,8 +437,10 @@ static errno_t console_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 				ch.attrs.val.rgb.fgcolor = clr ^ 0xffffff;
 				ch.attrs.val.rgb.bgcolor = clr;
 
-				if (clr != cbm->key_color)
-					cbm->cgc->buf[y * cols + x] = ch;
+				if (clr != cbm->key_color) {
+					console_gc_putfield(cbm->cgc, x, y,
+					    &ch, &upd);
+				}
 			}
 		}
 	} else {
@@ -409,14 +457,18 @@ static errno_t console_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 				    x - offs.x - cbm->rect.p0.x,
 				    y - offs.y - cbm->rect.p0.y);
 
-				if (clr != cbm->key_color)
-					cbm->cgc->buf[y * cols + x] = ch;
+				if (clr != cbm->key_color) {
+					console_gc_putfield(cbm->cgc, x, y,
+					    &ch, &upd);
+				}
 			}
 		}
 	}
 
-	console_update(cbm->cgc->con, crect.p0.x, crect.p0.y, crect.p1.x,
-	    crect.p1.y);
+	if (!gfx_rect_is_empty(&upd)) {
+		console_update(cbm->cgc->con, upd.p0.x, upd.p0.y, upd.p1.x,
+		    upd.p1.y);
+	}
 
 	return EOK;
 }
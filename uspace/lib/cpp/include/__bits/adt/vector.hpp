@@ -561,7 +561,7 @@ namespace std
             {
                 if (size_ + count < capacity_)
                 {
-                    copy_backward(position, end(), end() + count);
+                    move_backward(position, end(), end() + count);
                     size_ += count;
 
                     return position;
@@ -577,11 +577,11 @@ namespace std
                     tmp.resize_without_copy_(max(new_size, capacity_));
                     tmp.size_ = new_size;
 
-                    // Copy before insertion index.
-                    copy(begin(), begin() + start_idx, tmp.begin());
+                    // Move before insertion index.
+                    move(begin(), begin() + start_idx, tmp.begin());
 
-                    // Copy after insertion index.
-                    copy(begin() + start_idx, end(), tmp.begin() + end_idx);
+                    // Move after insertion index.
+                    move(begin() + start_idx, end(), tmp.begin() + end_idx);
 
                     swap(tmp);
 
@@ -408,9 +408,11 @@ namespace std
     BidirectionalIterator2 move_backward(BidirectionalIterator1 first, BidirectionalIterator1 last,
                                          BidirectionalIterator2 result)
     {
-        // Note: We're copying [first, last) so we need to skip the initial value of last.
-        while (last-- != first)
-            *result-- = move(*last);
+        // Note: The last element moved is *first and it is moved to *(result - (last - first)).
+        while (last != first)
+            *--result = move(*--last);
+
+        return result;
     }
 
     /**
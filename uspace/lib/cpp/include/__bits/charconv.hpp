@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_CHARCONV
+#define LIBCPP_BITS_CHARCONV
+
+#include <system_error>
+#include <type_traits>
+
+namespace std
+{
+    /**
+     * 20.19, primitive numeric conversions:
+     *
+     * Unlike the string conversion functions, these write into
+     * caller-provided buffers and never allocate, which makes them
+     * suitable for logging and serialization hot paths.
+     */
+
+    struct to_chars_result
+    {
+        char* ptr;
+        errc ec;
+    };
+
+    struct from_chars_result
+    {
+        const char* ptr;
+        errc ec;
+    };
+
+    enum class chars_format
+    {
+        scientific = 1,
+        fixed = 2,
+        hex = 4,
+        general = fixed | scientific
+    };
+
+    namespace aux
+    {
+        constexpr char charconv_digits[] =
+            "0123456789abcdefghijklmnopqrstuvwxyz";
+
+        constexpr int charconv_digit_value(char c) noexcept
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'z')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'Z')
+                return c - 'A' + 10;
+
+            return -1;
+        }
+    }
+
+    /**
+     * 20.19.2, to_chars for integer types:
+     */
+
+    template<class T>
+    enable_if_t<is_integral<T>::value && !is_same<T, bool>::value, to_chars_result>
+    to_chars(char* first, char* last, T value, int base = 10)
+    {
+        using unsigned_type = typename make_unsigned<T>::type;
+
+        if (base < 2 || base > 36)
+            return to_chars_result{last, errc::invalid_argument};
+
+        unsigned_type uvalue{};
+        bool negative{false};
+
+        if constexpr (is_signed<T>::value)
+        {
+            if (value < 0)
+            {
+                negative = true;
+                uvalue = static_cast<unsigned_type>(0)
+                    - static_cast<unsigned_type>(value);
+            }
+            else
+                uvalue = static_cast<unsigned_type>(value);
+        }
+        else
+            uvalue = value;
+
+        /* Digits get produced in reverse order. */
+        char buffer[sizeof(T) * 8];
+        size_t len{};
+
+        do
+        {
+            buffer[len++] = aux::charconv_digits[uvalue % static_cast<unsigned_type>(base)];
+            uvalue /= static_cast<unsigned_type>(base);
+        } while (uvalue != 0);
+
+        auto needed = len + (negative ? 1 : 0);
+        if (static_cast<size_t>(last - first) < needed)
+            return to_chars_result{last, errc::value_too_large};
+
+        if (negative)
+            *first++ = '-';
+        while (len > 0)
+            *first++ = buffer[--len];
+
+        return to_chars_result{first, errc{}};
+    }
+
+    /**
+     * 20.19.3, from_chars for integer types:
+     */
+
+    template<class T>
+    enable_if_t<is_integral<T>::value && !is_same<T, bool>::value, from_chars_result>
+    from_chars(const char* first, const char* last, T& value, int base = 10)
+    {
+        using unsigned_type = typename make_unsigned<T>::type;
+
+        if (base < 2 || base > 36)
+            return from_chars_result{first, errc::invalid_argument};
+
+        auto it = first;
+        bool negative{false};
+
+        if constexpr (is_signed<T>::value)
+        {
+            if (it != last && *it == '-')
+            {
+                negative = true;
+                ++it;
+            }
+        }
+
+        constexpr auto type_max = static_cast<unsigned_type>(~unsigned_type{});
+        unsigned_type result{};
+        bool overflow{false};
+        bool any{false};
+
+        while (it != last)
+        {
+            auto digit = aux::charconv_digit_value(*it);
+            if (digit < 0 || digit >= base)
+                break;
+
+            any = true;
+            if (!overflow)
+            {
+                auto udigit = static_cast<unsigned_type>(digit);
+                if (result > (type_max - udigit) / static_cast<unsigned_type>(base))
+                    overflow = true;
+                else
+                    result = result * static_cast<unsigned_type>(base) + udigit;
+            }
+
+            ++it;
+        }
+
+        if (!any)
+            return from_chars_result{first, errc::invalid_argument};
+
+        /* The largest magnitude representable in T with the given sign. */
+        unsigned_type limit = type_max;
+        if constexpr (is_signed<T>::value)
+        {
+            limit = type_max / 2;
+            if (negative)
+                ++limit;
+        }
+
+        if (overflow || result > limit)
+            return from_chars_result{it, errc::result_out_of_range};
+
+        if (negative)
+            value = static_cast<T>(static_cast<unsigned_type>(0) - result);
+        else
+            value = static_cast<T>(result);
+
+        return from_chars_result{it, errc{}};
+    }
+
+    /**
+     * 20.19.2-3, to_chars/from_chars for floating-point types:
+     */
+
+    to_chars_result to_chars(char* first, char* last, float value);
+    to_chars_result to_chars(char* first, char* last, double value);
+    to_chars_result to_chars(char* first, char* last, long double value);
+
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt);
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt);
+    to_chars_result to_chars(char* first, char* last, long double value,
+                             chars_format fmt);
+
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt, int precision);
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt, int precision);
+    to_chars_result to_chars(char* first, char* last, long double value,
+                             chars_format fmt, int precision);
+
+    from_chars_result from_chars(const char* first, const char* last,
+                                 float& value,
+                                 chars_format fmt = chars_format::general);
+    from_chars_result from_chars(const char* first, const char* last,
+                                 double& value,
+                                 chars_format fmt = chars_format::general);
+    from_chars_result from_chars(const char* first, const char* last,
+                                 long double& value,
+                                 chars_format fmt = chars_format::general);
+}
+
+#endif
@@ -478,8 +478,8 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                init_short_();
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
@@ -490,12 +490,10 @@ namespace std
             }
 
             basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
+                : data_{}, size_{other.size_},
                   capacity_{other.capacity_}, allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
@@ -520,9 +518,9 @@ namespace std
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{}, size_{n}, capacity_{n + 1}, allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
+                data_ = allocate_(capacity_);
                 for (size_type i = 0; i < size_; ++i)
                     traits_type::assign(data_[i], c);
                 ensure_null_terminator_();
@@ -536,8 +534,8 @@ namespace std
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
                     size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
+                    capacity_ = size_ + 1;
+                    data_ = allocate_(capacity_);
 
                     for (size_type i = 0; i < size_; ++i)
                         traits_type::assign(data_[i], static_cast<value_type>(last));
@@ -561,16 +559,14 @@ namespace std
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                deallocate_();
             }
 
             basic_string& operator=(const basic_string& other)
@@ -841,7 +837,19 @@ namespace std
             basic_string& append(const value_type* str, size_type n)
             {
                 // TODO: if (size_ + n > max_size()) throw length_error
-                ensure_free_space_(n);
+                if (str >= data_ && str < data_ + size_)
+                {
+                    /**
+                     * Appending from within this string - the buffer
+                     * may move when growing, so recompute the source.
+                     */
+                    auto offset = static_cast<size_type>(str - data_);
+                    ensure_free_space_(n);
+                    str = data_ + offset;
+                }
+                else
+                    ensure_free_space_(n);
+
                 traits_type::copy(data_ + size(), str, n);
                 size_ += n;
                 ensure_null_terminator_();
@@ -1160,7 +1168,40 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
+                if (!is_short_() && !other.is_short_())
+                {
+                    std::swap(data_, other.data_);
+                }
+                else if (is_short_() && other.is_short_())
+                {
+                    /**
+                     * Pointers into the inline buffers cannot be handed
+                     * over, the characters have to be exchanged by copying.
+                     */
+                    value_type tmp[sso_capacity_ + 1];
+
+                    traits_type::copy(tmp, local_, size_ + 1);
+                    traits_type::copy(local_, other.local_, other.size_ + 1);
+                    traits_type::copy(other.local_, tmp, size_ + 1);
+                }
+                else
+                {
+                    /**
+                     * Exactly one of the strings is stored inline. Copy
+                     * its characters into the other's inline buffer and
+                     * hand the heap buffer over in the other direction.
+                     */
+                    basic_string* short_str = is_short_() ? this : &other;
+                    basic_string* long_str = is_short_() ? &other : this;
+
+                    auto heap_data = long_str->data_;
+                    traits_type::copy(long_str->local_, short_str->local_,
+                                      short_str->size_ + 1);
+
+                    long_str->data_ = long_str->local_;
+                    short_str->data_ = heap_data;
+                }
+
                 std::swap(size_, other.size_);
                 std::swap(capacity_, other.capacity_);
             }
@@ -1481,26 +1522,80 @@ namespace std
             size_type capacity_;
             allocator_type allocator_;
 
+            /**
+             * Short string optimization: strings of up to
+             * sso_capacity_ characters are stored in this inline
+             * buffer and data_ points at it, avoiding any
+             * allocation. Longer strings live on the heap.
+             */
+            static constexpr size_type sso_capacity_{15};
+            value_type local_[sso_capacity_ + 1];
+
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_short_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            void init_short_() noexcept
+            {
+                data_ = local_;
+                capacity_ = sso_capacity_ + 1;
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Get a buffer with the requested capacity - either the
+             * inline buffer (bumping the capacity to its size) or a
+             * newly allocated one. Does not touch data_.
              */
-            static constexpr size_type default_capacity_{4};
+            value_type* allocate_(size_type& capacity)
+            {
+                if (capacity <= sso_capacity_ + 1)
+                {
+                    capacity = sso_capacity_ + 1;
+                    return local_;
+                }
 
-            void init_(const value_type* str, size_type size)
+                return allocator_.allocate(capacity);
+            }
+
+            void deallocate_()
             {
-                if (data_)
+                if (data_ && !is_short_())
                     allocator_.deallocate(data_, capacity_);
+            }
+
+            /**
+             * Take over the contents of another string (for move
+             * construction). A short string is copied into our own
+             * inline buffer, a long one hands over its heap buffer.
+             * The other string is left empty (and short).
+             */
+            void steal_(basic_string& other)
+            {
+                if (other.is_short_())
+                {
+                    init_short_();
+                    traits_type::copy(data_, other.data_, size_ + 1);
+                }
+                else
+                    data_ = other.data_;
+
+                other.init_short_();
+                other.size_ = 0;
+                other.ensure_null_terminator_();
+            }
+
+            void init_(const value_type* str, size_type size)
+            {
+                deallocate_();
 
                 size_ = size;
                 capacity_ = size + 1;
 
-                data_ = allocator_.allocate(capacity_);
+                data_ = allocate_(capacity_);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
@@ -1526,10 +1621,9 @@ namespace std
 
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                deallocate_();
 
-                data_ = allocator_.allocate(capacity);
+                data_ = allocate_(capacity);
                 size_ = 0;
                 capacity_ = capacity;
                 ensure_null_terminator_();
@@ -1539,14 +1633,16 @@ namespace std
             {
                 if(capacity_ == 0 || capacity_ < capacity)
                 {
-                    auto new_data = allocator_.allocate(capacity);
-
-                    auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
+                    auto new_data = allocate_(capacity);
 
-                    std::swap(data_, new_data);
+                    if (new_data != data_)
+                    {
+                        auto to_copy = min(size, size_);
+                        traits_type::move(new_data, data_, to_copy);
 
-                    allocator_.deallocate(new_data, capacity_);
+                        deallocate_();
+                        data_ = new_data;
+                    }
                 }
 
                 capacity_ = capacity;
@@ -230,6 +230,18 @@ namespace std::test
             void test_complex();
     };
 
+    class charconv_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_to_chars_integral();
+            void test_from_chars_integral();
+            void test_floating();
+    };
+
     class adaptors_test: public test_suite
     {
         public:
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+namespace std::test
+{
+    bool charconv_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_to_chars_integral();
+        test_from_chars_integral();
+        test_floating();
+
+        return end();
+    }
+
+    const char* charconv_test::name()
+    {
+        return "charconv";
+    }
+
+    void charconv_test::test_to_chars_integral()
+    {
+        char buf[64];
+
+        auto res1 = std::to_chars(buf, buf + sizeof(buf), 1234);
+        test_eq("to_chars int", std::string(buf, res1.ptr), "1234"s);
+        test_eq("to_chars int ec", res1.ec == errc{}, true);
+
+        auto res2 = std::to_chars(buf, buf + sizeof(buf), -42);
+        test_eq("to_chars negative int", std::string(buf, res2.ptr), "-42"s);
+
+        auto res3 = std::to_chars(buf, buf + sizeof(buf), 255u, 16);
+        test_eq("to_chars hex", std::string(buf, res3.ptr), "ff"s);
+
+        auto res4 = std::to_chars(buf, buf + sizeof(buf), 5, 2);
+        test_eq("to_chars binary", std::string(buf, res4.ptr), "101"s);
+
+        auto res5 = std::to_chars(buf, buf + sizeof(buf), 0);
+        test_eq("to_chars zero", std::string(buf, res5.ptr), "0"s);
+
+        long long big{-1234567890123456789ll};
+        auto res6 = std::to_chars(buf, buf + sizeof(buf), big);
+        test_eq("to_chars long long", std::string(buf, res6.ptr),
+                "-1234567890123456789"s);
+
+        /* Buffer too small. */
+        auto res7 = std::to_chars(buf, buf + 2, 1234);
+        test_eq("to_chars overflow", res7.ec == errc::value_too_large, true);
+    }
+
+    void charconv_test::test_from_chars_integral()
+    {
+        const char* str1 = "1234";
+        int val1{};
+        auto res1 = std::from_chars(str1, str1 + 4, val1);
+        test_eq("from_chars int", val1, 1234);
+        test_eq("from_chars end pointer", res1.ptr == str1 + 4, true);
+
+        const char* str2 = "-42abc";
+        int val2{};
+        auto res2 = std::from_chars(str2, str2 + 6, val2);
+        test_eq("from_chars stops at non-digit", val2, -42);
+        test_eq("from_chars partial end", res2.ptr == str2 + 3, true);
+
+        const char* str3 = "ff";
+        unsigned val3{};
+        std::from_chars(str3, str3 + 2, val3, 16);
+        test_eq("from_chars hex", val3, 255u);
+
+        const char* str4 = "xyz";
+        int val4{99};
+        auto res4 = std::from_chars(str4, str4 + 3, val4);
+        test_eq("from_chars invalid", res4.ec == errc::invalid_argument, true);
+        test_eq("from_chars invalid keeps value", val4, 99);
+
+        const char* str5 = "99999999999999999999";
+        int val5{};
+        auto res5 = std::from_chars(str5, str5 + 20, val5);
+        test_eq("from_chars out of range",
+                res5.ec == errc::result_out_of_range, true);
+
+        /* Round trip through both directions. */
+        char buf[64];
+        auto res6 = std::to_chars(buf, buf + sizeof(buf), -987654321);
+        int val6{};
+        std::from_chars(buf, res6.ptr, val6);
+        test_eq("integer round trip", val6, -987654321);
+    }
+
+    void charconv_test::test_floating()
+    {
+        char buf[64];
+
+        auto res1 = std::to_chars(buf, buf + sizeof(buf), 2.5,
+                                  chars_format::fixed, 2);
+        test_eq("to_chars fixed", std::string(buf, res1.ptr), "2.50"s);
+
+        const char* str1 = "3.125";
+        double val1{};
+        auto res2 = std::from_chars(str1, str1 + 5, val1);
+        test_eq("from_chars double", val1, 3.125);
+        test_eq("from_chars double end", res2.ptr == str1 + 5, true);
+
+        const char* str2 = "-1.5e2";
+        double val2{};
+        std::from_chars(str2, str2 + 6, val2);
+        test_eq("from_chars exponent", val2, -150.0);
+
+        const char* str3 = "2.5e3";
+        double val3{};
+        auto res3 = std::from_chars(str3, str3 + 5, val3,
+                                    chars_format::fixed);
+        test_eq("from_chars fixed ignores exponent", val3, 2.5);
+        test_eq("from_chars fixed end", res3.ptr == str3 + 3, true);
+
+        /* Round trip. */
+        auto res4 = std::to_chars(buf, buf + sizeof(buf), 0.0625);
+        double val4{};
+        std::from_chars(buf, res4.ptr, val4);
+        test_eq("double round trip", val4, 0.0625);
+    }
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace std
+{
+    namespace aux
+    {
+        /**
+         * Format a floating-point value into the caller's buffer using
+         * the libc formatter. Only stack storage is used; a conversion
+         * that does not fit reports value_too_large.
+         *
+         * Note: The libc formatter only handles double, so long double
+         *       arguments are converted with double precision.
+         */
+        static to_chars_result fp_to_chars(char* first, char* last,
+                                           double value, char conv,
+                                           int precision)
+        {
+            char spec[16];
+            char buffer[512];
+
+            std::snprintf(spec, sizeof(spec), "%%.%d%c", precision, conv);
+
+            auto len = std::snprintf(buffer, sizeof(buffer), spec, value);
+            if (len < 0 || static_cast<size_t>(len) >= sizeof(buffer))
+                return to_chars_result{last, errc::value_too_large};
+
+            if (last - first < len)
+                return to_chars_result{last, errc::value_too_large};
+
+            std::memcpy(first, buffer, static_cast<size_t>(len));
+
+            return to_chars_result{first + len, errc{}};
+        }
+
+        static char fp_conversion(chars_format fmt)
+        {
+            switch (fmt)
+            {
+                case chars_format::scientific:
+                    return 'e';
+                case chars_format::fixed:
+                    return 'f';
+                default:
+                    return 'g';
+            }
+        }
+
+        /**
+         * Parse a decimal floating-point number. Hexadecimal input
+         * (chars_format::hex) is not supported at the moment.
+         */
+        static from_chars_result fp_from_chars(const char* first,
+                                               const char* last,
+                                               double& value,
+                                               chars_format fmt)
+        {
+            if (fmt == chars_format::hex)
+                return from_chars_result{first, errc::invalid_argument};
+
+            auto it = first;
+            bool negative{false};
+
+            if (it != last && *it == '-')
+            {
+                negative = true;
+                ++it;
+            }
+
+            /**
+             * Accumulate the significand. Digits beyond what fits
+             * in the accumulator only adjust the decimal exponent.
+             */
+            unsigned long long significand{};
+            int exponent{};
+            bool any_digits{false};
+            bool seen_point{false};
+
+            constexpr unsigned long long significand_max =
+                (~0ull - 9) / 10;
+
+            while (it != last)
+            {
+                if (*it == '.' && !seen_point)
+                {
+                    seen_point = true;
+                    ++it;
+                    continue;
+                }
+
+                if (*it < '0' || *it > '9')
+                    break;
+
+                if (significand <= significand_max)
+                {
+                    significand = significand * 10
+                        + static_cast<unsigned long long>(*it - '0');
+                    if (seen_point)
+                        --exponent;
+                }
+                else if (!seen_point)
+                    ++exponent;
+
+                any_digits = true;
+                ++it;
+            }
+
+            if (!any_digits)
+                return from_chars_result{first, errc::invalid_argument};
+
+            /* Optional exponent part (not allowed for fixed). */
+            if (fmt != chars_format::fixed && it != last &&
+                (*it == 'e' || *it == 'E'))
+            {
+                auto exp_start = it;
+                ++it;
+
+                bool exp_negative{false};
+                if (it != last && (*it == '+' || *it == '-'))
+                {
+                    exp_negative = (*it == '-');
+                    ++it;
+                }
+
+                int exp_value{};
+                bool exp_digits{false};
+                while (it != last && *it >= '0' && *it <= '9')
+                {
+                    if (exp_value < 100000)
+                        exp_value = exp_value * 10 + (*it - '0');
+                    exp_digits = true;
+                    ++it;
+                }
+
+                if (!exp_digits)
+                    it = exp_start;
+                else
+                    exponent += exp_negative ? -exp_value : exp_value;
+            }
+
+            /* Scale the significand by the decimal exponent. */
+            double result = static_cast<double>(significand);
+            auto scale = exponent;
+
+            while (scale > 0)
+            {
+                result *= 10.0;
+                --scale;
+            }
+            while (scale < 0)
+            {
+                result /= 10.0;
+                ++scale;
+            }
+
+            value = negative ? -result : result;
+
+            return from_chars_result{it, errc{}};
+        }
+    }
+
+    to_chars_result to_chars(char* first, char* last, float value)
+    {
+        return aux::fp_to_chars(first, last, value, 'g', 9);
+    }
+
+    to_chars_result to_chars(char* first, char* last, double value)
+    {
+        return aux::fp_to_chars(first, last, value, 'g', 17);
+    }
+
+    to_chars_result to_chars(char* first, char* last, long double value)
+    {
+        return aux::fp_to_chars(first, last,
+                                static_cast<double>(value), 'g', 17);
+    }
+
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt)
+    {
+        return aux::fp_to_chars(first, last, value,
+                                aux::fp_conversion(fmt), 9);
+    }
+
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt)
+    {
+        return aux::fp_to_chars(first, last, value,
+                                aux::fp_conversion(fmt), 17);
+    }
+
+    to_chars_result to_chars(char* first, char* last, long double value,
+                             chars_format fmt)
+    {
+        return aux::fp_to_chars(first, last, static_cast<double>(value),
+                                aux::fp_conversion(fmt), 17);
+    }
+
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt, int precision)
+    {
+        return aux::fp_to_chars(first, last, value,
+                                aux::fp_conversion(fmt), precision);
+    }
+
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt, int precision)
+    {
+        return aux::fp_to_chars(first, last, value,
+                                aux::fp_conversion(fmt), precision);
+    }
+
+    to_chars_result to_chars(char* first, char* last, long double value,
+                             chars_format fmt, int precision)
+    {
+        return aux::fp_to_chars(first, last, static_cast<double>(value),
+                                aux::fp_conversion(fmt), precision);
+    }
+
+    from_chars_result from_chars(const char* first, const char* last,
+                                 float& value, chars_format fmt)
+    {
+        double tmp{};
+        auto res = aux::fp_from_chars(first, last, tmp, fmt);
+
+        if (res.ec == errc{})
+            value = static_cast<float>(tmp);
+
+        return res;
+    }
+
+    from_chars_result from_chars(const char* first, const char* last,
+                                 double& value, chars_format fmt)
+    {
+        return aux::fp_from_chars(first, last, value, fmt);
+    }
+
+    from_chars_result from_chars(const char* first, const char* last,
+                                 long double& value, chars_format fmt)
+    {
+        double tmp{};
+        auto res = aux::fp_from_chars(first, last, tmp, fmt);
+
+        if (res.ec == errc{})
+            value = static_cast<long double>(tmp);
+
+        return res;
+    }
+}
@@ -269,101 +269,75 @@ static void inv_shift_rows(uint8_t state[ELEMS][ELEMS])
 	}
 }
 
-/** Multiplication in GF(2^8).
+/** Multiplication by x (i.e. 0x02) in GF(2^8).
  *
- * @param x First factor.
- * @param y Second factor.
+ * @param value Value to be multiplied.
  *
- * @return Multiplication of given factors in GF(2^8).
+ * @return Product of the value and x reduced by the irreducible
+ *         polynomial.
  *
  */
-static uint8_t galois_mult(uint8_t x, uint8_t y)
+static uint8_t xtime(uint8_t value)
 {
-	uint8_t result = 0;
-	uint8_t f_bith;
+	uint8_t result = value << 1;
 
-	for (size_t i = 0; i < 8; i++) {
-		if (y & 1)
-			result ^= x;
-
-		f_bith = (x & 0x80);
-		x <<= 1;
-
-		if (f_bith)
-			x ^= AES_IP;
-
-		y >>= 1;
-	}
+	if (value & 0x80)
+		result ^= AES_IP;
 
 	return result;
 }
 
 /** Perform mix columns transformation on state table.
+ *
+ * Multiplications by the {02, 03, 01, 01} matrix coefficients are
+ * decomposed into xtime() calls and XORs instead of generic GF(2^8)
+ * multiplication loops.
  *
  * @param state State table to be modified.
  *
  */
 static void mix_columns(uint8_t state[ELEMS][ELEMS])
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
+	uint8_t a0, a1, a2, a3, all;
 
 	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x2, orig_state[0][j]) ^
-		    galois_mult(0x3, orig_state[1][j]) ^
-		    orig_state[2][j] ^
-		    orig_state[3][j];
-		state[1][j] =
-		    orig_state[0][j] ^
-		    galois_mult(0x2, orig_state[1][j]) ^
-		    galois_mult(0x3, orig_state[2][j]) ^
-		    orig_state[3][j];
-		state[2][j] =
-		    orig_state[0][j] ^
-		    orig_state[1][j] ^
-		    galois_mult(0x2, orig_state[2][j]) ^
-		    galois_mult(0x3, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x3, orig_state[0][j]) ^
-		    orig_state[1][j] ^
-		    orig_state[2][j] ^
-		    galois_mult(0x2, orig_state[3][j]);
+		a0 = state[0][j];
+		a1 = state[1][j];
+		a2 = state[2][j];
+		a3 = state[3][j];
+		all = a0 ^ a1 ^ a2 ^ a3;
+
+		state[0][j] = a0 ^ all ^ xtime(a0 ^ a1);
+		state[1][j] = a1 ^ all ^ xtime(a1 ^ a2);
+		state[2][j] = a2 ^ all ^ xtime(a2 ^ a3);
+		state[3][j] = a3 ^ all ^ xtime(a3 ^ a0);
 	}
 }
 
 /** Perform inverted mix columns transformation on state table.
+ *
+ * The {0e, 0b, 0d, 09} inverse matrix factors into a correction step
+ * followed by the forward mix columns transformation, which avoids the
+ * generic GF(2^8) multiplications entirely.
  *
  * @param state State table to be modified.
  *
  */
 static void inv_mix_columns(uint8_t state[ELEMS][ELEMS])
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
+	uint8_t u, v;
 
 	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x0e, orig_state[0][j]) ^
-		    galois_mult(0x0b, orig_state[1][j]) ^
-		    galois_mult(0x0d, orig_state[2][j]) ^
-		    galois_mult(0x09, orig_state[3][j]);
-		state[1][j] =
-		    galois_mult(0x09, orig_state[0][j]) ^
-		    galois_mult(0x0e, orig_state[1][j]) ^
-		    galois_mult(0x0b, orig_state[2][j]) ^
-		    galois_mult(0x0d, orig_state[3][j]);
-		state[2][j] =
-		    galois_mult(0x0d, orig_state[0][j]) ^
-		    galois_mult(0x09, orig_state[1][j]) ^
-		    galois_mult(0x0e, orig_state[2][j]) ^
-		    galois_mult(0x0b, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x0b, orig_state[0][j]) ^
-		    galois_mult(0x0d, orig_state[1][j]) ^
-		    galois_mult(0x09, orig_state[2][j]) ^
-		    galois_mult(0x0e, orig_state[3][j]);
+		u = xtime(xtime(state[0][j] ^ state[2][j]));
+		v = xtime(xtime(state[1][j] ^ state[3][j]));
+
+		state[0][j] ^= u;
+		state[2][j] ^= u;
+		state[1][j] ^= v;
+		state[3][j] ^= v;
 	}
+
+	mix_columns(state);
 }
 
 /** Perform round key transformation on state table.
@@ -372,7 +346,7 @@ static void inv_mix_columns(uint8_t state[ELEMS][ELEMS])
  * @param round_key Round key to be applied on state table.
  *
  */
-static void add_round_key(uint8_t state[ELEMS][ELEMS], uint32_t *round_key)
+static void add_round_key(uint8_t state[ELEMS][ELEMS], const uint32_t *round_key)
 {
 	uint8_t byte_round;
 	uint8_t shift;
@@ -423,7 +397,7 @@ static uint32_t rot_word(uint32_t word)
  * @param key_exp Result key expansion.
  *
  */
-static void key_expansion(uint8_t *key, uint32_t *key_exp)
+static void key_expansion(const uint8_t *key, uint32_t *key_exp)
 {
 	uint32_t temp;
 
@@ -447,28 +421,42 @@ static void key_expansion(uint8_t *key, uint32_t *key_exp)
 	}
 }
 
-/** AES-128 encryption algorithm.
+/** Prepare AES-128 key schedule for repeated use.
  *
- * @param key    Input key.
+ * Expands the key once so that a sequence of blocks can be processed
+ * with aes_encrypt_sched() or aes_decrypt_sched() without repeating the
+ * key expansion for each block.
+ *
+ * @param key   Input key.
+ * @param sched Key schedule to be initialized.
+ *
+ */
+void aes_sched_init(const uint8_t *key, aes_sched_t *sched)
+{
+	key_expansion(key, sched->key_exp);
+}
+
+/** AES-128 encryption with a prepared key schedule.
+ *
+ * @param sched  Expanded key schedule.
  * @param input  Input data sequence to be encrypted.
  * @param output Encrypted data sequence.
  *
- * @return EINVAL when input or key not specified,
+ * @return EINVAL when input or schedule not specified,
  *         ENOMEM when pointer for output is not allocated,
  *         otherwise EOK.
  *
  */
-errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
+errno_t aes_encrypt_sched(const aes_sched_t *sched, uint8_t *input,
+    uint8_t *output)
 {
-	if ((!key) || (!input))
+	if ((!sched) || (!input))
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
+	const uint32_t *key_exp = sched->key_exp;
 
 	/* Copy input into state array. */
 	uint8_t state[ELEMS][ELEMS];
@@ -499,28 +487,27 @@ errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 	return EOK;
 }
 
-/** AES-128 decryption algorithm.
+/** AES-128 decryption with a prepared key schedule.
  *
- * @param key    Input key.
+ * @param sched  Expanded key schedule.
  * @param input  Input data sequence to be decrypted.
  * @param output Decrypted data sequence.
  *
- * @return EINVAL when input or key not specified,
+ * @return EINVAL when input or schedule not specified,
  *         ENOMEM when pointer for output is not allocated,
  *         otherwise EOK.
  *
  */
-errno_t aes_decrypt(uint8_t *key, uint8_t *input, uint8_t *output)
+errno_t aes_decrypt_sched(const aes_sched_t *sched, uint8_t *input,
+    uint8_t *output)
 {
-	if ((!key) || (!input))
+	if ((!sched) || (!input))
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
+	const uint32_t *key_exp = sched->key_exp;
 
 	/* Copy input into state array. */
 	uint8_t state[ELEMS][ELEMS];
@@ -549,3 +536,47 @@ errno_t aes_decrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 
 	return EOK;
 }
+
+/** AES-128 encryption algorithm.
+ *
+ * @param key    Input key.
+ * @param input  Input data sequence to be encrypted.
+ * @param output Encrypted data sequence.
+ *
+ * @return EINVAL when input or key not specified,
+ *         ENOMEM when pointer for output is not allocated,
+ *         otherwise EOK.
+ *
+ */
+errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
+{
+	aes_sched_t sched;
+
+	if (!key)
+		return EINVAL;
+
+	aes_sched_init(key, &sched);
+	return aes_encrypt_sched(&sched, input, output);
+}
+
+/** AES-128 decryption algorithm.
+ *
+ * @param key    Input key.
+ * @param input  Input data sequence to be decrypted.
+ * @param output Decrypted data sequence.
+ *
+ * @return EINVAL when input or key not specified,
+ *         ENOMEM when pointer for output is not allocated,
+ *         otherwise EOK.
+ *
+ */
+errno_t aes_decrypt(uint8_t *key, uint8_t *input, uint8_t *output)
+{
+	aes_sched_t sched;
+
+	if (!key)
+		return EINVAL;
+
+	aes_sched_init(key, &sched);
+	return aes_decrypt_sched(&sched, input, output);
+}
@@ -34,6 +34,7 @@
 #include <stdint.h>
 
 #define AES_CIPHER_LENGTH  16
+#define AES_SCHED_WORDS    44
 #define PBKDF2_KEY_LENGTH  32
 
 /* Left rotation for uint32_t. */
@@ -50,7 +51,15 @@ typedef enum {
 	HASH_SHA1 = 20
 } hash_func_t;
 
+/** Expanded AES-128 key schedule, reusable across cipher blocks. */
+typedef struct {
+	uint32_t key_exp[AES_SCHED_WORDS];
+} aes_sched_t;
+
 extern errno_t rc4(uint8_t *, size_t, uint8_t *, size_t, size_t, uint8_t *);
+extern void aes_sched_init(const uint8_t *, aes_sched_t *);
+extern errno_t aes_encrypt_sched(const aes_sched_t *, uint8_t *, uint8_t *);
+extern errno_t aes_decrypt_sched(const aes_sched_t *, uint8_t *, uint8_t *);
 extern errno_t aes_encrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t aes_decrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t create_hash(uint8_t *, size_t, uint8_t *, hash_func_t);
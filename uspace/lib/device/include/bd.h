@@ -50,6 +50,7 @@ extern errno_t bd_write_blocks(bd_t *, aoff64_t, size_t, const void *, size_t);
 extern errno_t bd_sync_cache(bd_t *, aoff64_t, size_t);
 extern errno_t bd_get_block_size(bd_t *, size_t *);
 extern errno_t bd_get_num_blocks(bd_t *, aoff64_t *);
+extern errno_t bd_get_queue_depth(bd_t *, size_t *);
 
 #endif
 
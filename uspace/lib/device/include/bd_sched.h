@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Block device I/O scheduler
+ */
+
+#ifndef _LIBC_BD_SCHED_H_
+#define _LIBC_BD_SCHED_H_
+
+#include <adt/list.h>
+#include <bd.h>
+#include <fibril_synch.h>
+#include <offset.h>
+
+/** I/O scheduling policy */
+typedef enum {
+	/** Dispatch requests in arrival order */
+	bd_sched_noop,
+	/** Coalesce contiguous requests, dispatch in arrival order */
+	bd_sched_merge,
+	/** Serve requests in block address order bounded by deadlines */
+	bd_sched_deadline
+} bd_sched_policy_t;
+
+/** Block device I/O scheduler.
+ *
+ * Sits between a block device consumer and the bd_srv interface of the
+ * device. Queued requests are coalesced when they address contiguous
+ * block ranges and, under the deadline policy, dispatched in block
+ * address order as long as no request has waited past its deadline.
+ */
+typedef struct {
+	bd_t *bd;			/**< Underlying block device */
+	bd_sched_policy_t policy;	/**< Scheduling policy */
+	size_t block_size;		/**< Device block size in bytes */
+	unsigned max_depth;		/**< Maximum requests in flight */
+	unsigned in_flight;		/**< Requests currently in flight */
+	aoff64_t head_pos;		/**< Block address past the last dispatch */
+	fibril_mutex_t lock;		/**< Protects the queue and counters */
+	fibril_condvar_t queue_cv;	/**< Signalled on dispatch and completion */
+	list_t queue;			/**< Queued requests */
+} bd_sched_t;
+
+extern errno_t bd_sched_create(bd_t *, bd_sched_policy_t, unsigned, size_t,
+    bd_sched_t **);
+extern void bd_sched_destroy(bd_sched_t *);
+extern void bd_sched_set_depth(bd_sched_t *, unsigned);
+extern errno_t bd_sched_read_blocks(bd_sched_t *, aoff64_t, size_t, void *,
+    size_t);
+extern errno_t bd_sched_write_blocks(bd_sched_t *, aoff64_t, size_t,
+    const void *, size_t);
+extern errno_t bd_sched_sync_cache(bd_sched_t *, aoff64_t, size_t);
+
+#endif
+
+/** @}
+ */
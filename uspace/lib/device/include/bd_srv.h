@@ -65,6 +65,15 @@ struct bd_ops {
 	errno_t (*write_blocks)(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 	errno_t (*get_block_size)(bd_srv_t *, size_t *);
 	errno_t (*get_num_blocks)(bd_srv_t *, aoff64_t *);
+	errno_t (*get_queue_depth)(bd_srv_t *, size_t *);
+	/*
+	 * Optional provider of transfer buffers (e.g. from a DMA pool),
+	 * allowing the device to access the data without bouncing it
+	 * through a driver-private buffer. alloc_buf may return NULL,
+	 * in which case an ordinary allocation is used instead.
+	 */
+	void *(*alloc_buf)(bd_srv_t *, size_t);
+	void (*free_buf)(bd_srv_t *, void *, size_t);
 };
 
 extern void bd_srvs_init(bd_srvs_t *);
@@ -75,6 +75,15 @@
 #define NIC_DEFECTIVE_BAD_TCP_CHECKSUM   0x0080
 #define NIC_DEFECTIVE_BAD_UDP_CHECKSUM   0x0100
 
+/**
+ * Offload capability flags as reported by nic_offload_probe() and
+ * configured through nic_offload_set().
+ */
+/** Device computes checksums of transmitted frames */
+#define NIC_OFFLOAD_TX_CHECKSUM  0x0001
+/** Device verifies checksums of received frames */
+#define NIC_OFFLOAD_RX_CHECKSUM  0x0002
+
 /**
  * The bitmap uses single bit for each of the 2^12 = 4096 possible VLAN tags.
  * This means its size is 4096/8 = 512 bytes.
@@ -195,6 +195,26 @@ errno_t bd_get_num_blocks(bd_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Get number of requests the device can have in flight.
+ *
+ * Devices which do not queue requests return ENOTSUP and the caller
+ * should assume a queue depth of one.
+ */
+errno_t bd_get_queue_depth(bd_t *bd, size_t *rqdepth)
+{
+	sysarg_t qdepth;
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	errno_t rc = async_req_0_1(exch, BD_GET_QUEUE_DEPTH, &qdepth);
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*rqdepth = qdepth;
+	return EOK;
+}
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg)
 {
 	bd_t *bd = (bd_t *)arg;
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/**
+ * @file
+ * @brief Block device I/O scheduler
+ *
+ * Requests submitted by concurrent fibrils are queued, coalesced when
+ * they address contiguous block ranges and dispatched to the block
+ * device with a bounded number of requests in flight. There is no
+ * dispatcher fibril; the submitting fibrils cooperate, with each one
+ * dispatching its own request (and any requests merged into it) once
+ * the scheduler selects it as the next to go.
+ */
+
+#include <adt/list.h>
+#include <bd.h>
+#include <bd_sched.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** Time after which a queued request must be served next */
+#define BD_SCHED_DEADLINE_NSEC	(SEC2NSEC(1) / 8)
+
+/** Upper bound on the size of a merged request in bytes */
+#define BD_SCHED_MAX_MERGE	(128 * 1024)
+
+/** Queued I/O request.
+ *
+ * Allocated on the stack of the submitting fibril and linked into the
+ * scheduler queue until it is dispatched or absorbed by a merge.
+ */
+typedef struct {
+	link_t link;		/**< Scheduler queue / dispatch batch link */
+	bool write;		/**< Write request */
+	aoff64_t ba;		/**< First block address */
+	size_t cnt;		/**< Number of blocks */
+	void *buf;		/**< Data buffer */
+	size_t size;		/**< Buffer size in bytes */
+	struct timespec deadline; /**< Time by which to prefer this request */
+	bool done;		/**< Request has completed */
+	errno_t rc;		/**< Completion status */
+} bd_sched_rq_t;
+
+/** Create an I/O scheduler on top of an open block device.
+ *
+ * @param bd		Open block device
+ * @param policy	Scheduling policy
+ * @param max_depth	Maximum number of requests in flight (at least 1)
+ * @param block_size	Device block size in bytes
+ * @param rsched	Place to store pointer to the new scheduler
+ *
+ * @return		EOK on success or an error code
+ */
+errno_t bd_sched_create(bd_t *bd, bd_sched_policy_t policy, unsigned max_depth,
+    size_t block_size, bd_sched_t **rsched)
+{
+	bd_sched_t *sched = calloc(1, sizeof(bd_sched_t));
+	if (sched == NULL)
+		return ENOMEM;
+
+	sched->bd = bd;
+	sched->policy = policy;
+	sched->block_size = block_size;
+	sched->max_depth = (max_depth > 0) ? max_depth : 1;
+	sched->in_flight = 0;
+	sched->head_pos = 0;
+
+	fibril_mutex_initialize(&sched->lock);
+	fibril_condvar_initialize(&sched->queue_cv);
+	list_initialize(&sched->queue);
+
+	*rsched = sched;
+	return EOK;
+}
+
+/** Destroy an I/O scheduler.
+ *
+ * Waits until all queued and in-flight requests have completed. The
+ * underlying block device is not closed.
+ *
+ * @param sched	I/O scheduler
+ */
+void bd_sched_destroy(bd_sched_t *sched)
+{
+	fibril_mutex_lock(&sched->lock);
+	while ((!list_empty(&sched->queue)) || (sched->in_flight > 0))
+		fibril_condvar_wait(&sched->queue_cv, &sched->lock);
+	fibril_mutex_unlock(&sched->lock);
+
+	free(sched);
+}
+
+/** Set the maximum number of requests in flight.
+ *
+ * @param sched		I/O scheduler
+ * @param max_depth	Maximum number of requests in flight (at least 1)
+ */
+void bd_sched_set_depth(bd_sched_t *sched, unsigned max_depth)
+{
+	fibril_mutex_lock(&sched->lock);
+	sched->max_depth = (max_depth > 0) ? max_depth : 1;
+	fibril_condvar_broadcast(&sched->queue_cv);
+	fibril_mutex_unlock(&sched->lock);
+}
+
+/** Pick the request to dispatch next.
+ *
+ * The caller must hold @c sched->lock.
+ *
+ * @param sched	I/O scheduler
+ * @return	Request to dispatch next or NULL if the queue is empty
+ */
+static bd_sched_rq_t *bd_sched_next(bd_sched_t *sched)
+{
+	link_t *first = list_first(&sched->queue);
+	if (first == NULL)
+		return NULL;
+
+	bd_sched_rq_t *frq = list_get_instance(first, bd_sched_rq_t, link);
+
+	if (sched->policy != bd_sched_deadline)
+		return frq;
+
+	/* Serve the oldest request once its deadline has passed */
+	struct timespec now;
+	getuptime(&now);
+	if (ts_gteq(&now, &frq->deadline))
+		return frq;
+
+	/*
+	 * Elevator: prefer the lowest block address at or above the
+	 * current head position, wrapping around to the lowest address
+	 * overall when there is none.
+	 */
+	bd_sched_rq_t *best = NULL;
+	bd_sched_rq_t *lowest = NULL;
+
+	list_foreach(sched->queue, link, bd_sched_rq_t, cur) {
+		if ((lowest == NULL) || (cur->ba < lowest->ba))
+			lowest = cur;
+
+		if ((cur->ba >= sched->head_pos) &&
+		    ((best == NULL) || (cur->ba < best->ba)))
+			best = cur;
+	}
+
+	return (best != NULL) ? best : lowest;
+}
+
+/** Determine whether a request is eligible for merging.
+ *
+ * The caller must hold @c sched->lock.
+ */
+static bool bd_sched_rq_mergeable(bd_sched_t *sched, bd_sched_rq_t *rq)
+{
+	if ((sched->policy == bd_sched_noop) || (sched->block_size == 0))
+		return false;
+
+	/* Only merge requests covering whole blocks */
+	return rq->size == rq->cnt * sched->block_size;
+}
+
+/** Perform a single request as one block device operation. */
+static errno_t bd_sched_issue(bd_sched_t *sched, bd_sched_rq_t *rq)
+{
+	if (rq->write) {
+		return bd_write_blocks(sched->bd, rq->ba, rq->cnt, rq->buf,
+		    rq->size);
+	}
+
+	return bd_read_blocks(sched->bd, rq->ba, rq->cnt, rq->buf, rq->size);
+}
+
+/** Dispatch a request together with any contiguous queued requests.
+ *
+ * Called with @c sched->lock held; the lock is dropped for the duration
+ * of the block device operation and re-acquired before returning. On
+ * return @a rq and all requests merged into it are completed.
+ *
+ * @param sched	I/O scheduler
+ * @param rq	Request to dispatch
+ */
+static void bd_sched_dispatch(bd_sched_t *sched, bd_sched_rq_t *rq)
+{
+	list_t batch;
+	list_initialize(&batch);
+
+	list_remove(&rq->link);
+	list_append(&rq->link, &batch);
+
+	aoff64_t batch_ba = rq->ba;
+	aoff64_t batch_end = rq->ba + rq->cnt;
+	size_t batch_size = rq->size;
+
+	/* Absorb queued requests contiguous with the batch */
+	if (bd_sched_rq_mergeable(sched, rq)) {
+		bool found = true;
+
+		while (found) {
+			found = false;
+
+			list_foreach(sched->queue, link, bd_sched_rq_t, cur) {
+				if ((cur->write != rq->write) ||
+				    (!bd_sched_rq_mergeable(sched, cur)))
+					continue;
+
+				if (batch_size + cur->size >
+				    BD_SCHED_MAX_MERGE)
+					continue;
+
+				if (cur->ba == batch_end) {
+					list_remove(&cur->link);
+					list_append(&cur->link, &batch);
+					batch_end += cur->cnt;
+				} else if (cur->ba + cur->cnt == batch_ba) {
+					list_remove(&cur->link);
+					list_prepend(&cur->link, &batch);
+					batch_ba = cur->ba;
+				} else {
+					continue;
+				}
+
+				batch_size += cur->size;
+				found = true;
+				break;
+			}
+		}
+	}
+
+	sched->in_flight++;
+	sched->head_pos = batch_end;
+	fibril_mutex_unlock(&sched->lock);
+
+	if (list_count(&batch) == 1) {
+		rq->rc = bd_sched_issue(sched, rq);
+	} else {
+		void *mbuf = malloc(batch_size);
+		if (mbuf != NULL) {
+			size_t pos = 0;
+
+			if (rq->write) {
+				list_foreach(batch, link, bd_sched_rq_t, cur) {
+					memcpy(mbuf + pos, cur->buf, cur->size);
+					pos += cur->size;
+				}
+			}
+
+			errno_t rc = rq->write ?
+			    bd_write_blocks(sched->bd, batch_ba,
+			    (size_t)(batch_end - batch_ba), mbuf, batch_size) :
+			    bd_read_blocks(sched->bd, batch_ba,
+			    (size_t)(batch_end - batch_ba), mbuf, batch_size);
+
+			pos = 0;
+			list_foreach(batch, link, bd_sched_rq_t, cur) {
+				if ((!rq->write) && (rc == EOK))
+					memcpy(cur->buf, mbuf + pos, cur->size);
+				pos += cur->size;
+				cur->rc = rc;
+			}
+
+			free(mbuf);
+		} else {
+			/* Cannot merge after all; issue one by one */
+			list_foreach(batch, link, bd_sched_rq_t, cur)
+				cur->rc = bd_sched_issue(sched, cur);
+		}
+	}
+
+	fibril_mutex_lock(&sched->lock);
+	sched->in_flight--;
+
+	link_t *link;
+	while ((link = list_first(&batch)) != NULL) {
+		bd_sched_rq_t *cur = list_get_instance(link, bd_sched_rq_t,
+		    link);
+		list_remove(&cur->link);
+		cur->done = true;
+	}
+
+	fibril_condvar_broadcast(&sched->queue_cv);
+}
+
+/** Submit a request and wait for its completion. */
+static errno_t bd_sched_rq(bd_sched_t *sched, bool write, aoff64_t ba,
+    size_t cnt, void *buf, size_t size)
+{
+	bd_sched_rq_t rq;
+
+	link_initialize(&rq.link);
+	rq.write = write;
+	rq.ba = ba;
+	rq.cnt = cnt;
+	rq.buf = buf;
+	rq.size = size;
+	rq.done = false;
+	rq.rc = EOK;
+
+	getuptime(&rq.deadline);
+	ts_add_diff(&rq.deadline, BD_SCHED_DEADLINE_NSEC);
+
+	fibril_mutex_lock(&sched->lock);
+	list_append(&rq.link, &sched->queue);
+
+	while (!rq.done) {
+		if ((sched->in_flight < sched->max_depth) &&
+		    (bd_sched_next(sched) == &rq)) {
+			bd_sched_dispatch(sched, &rq);
+			break;
+		}
+
+		fibril_condvar_wait(&sched->queue_cv, &sched->lock);
+	}
+
+	fibril_mutex_unlock(&sched->lock);
+	return rq.rc;
+}
+
+/** Read blocks via the scheduler.
+ *
+ * @param sched	I/O scheduler
+ * @param ba	Address of first block
+ * @param cnt	Number of blocks
+ * @param data	Buffer for storing the data
+ * @param size	Size of the buffer in bytes
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t bd_sched_read_blocks(bd_sched_t *sched, aoff64_t ba, size_t cnt,
+    void *data, size_t size)
+{
+	return bd_sched_rq(sched, false, ba, cnt, data, size);
+}
+
+/** Write blocks via the scheduler.
+ *
+ * @param sched	I/O scheduler
+ * @param ba	Address of first block
+ * @param cnt	Number of blocks
+ * @param data	Data to write
+ * @param size	Size of the data in bytes
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t bd_sched_write_blocks(bd_sched_t *sched, aoff64_t ba, size_t cnt,
+    const void *data, size_t size)
+{
+	return bd_sched_rq(sched, true, ba, cnt, (void *) data, size);
+}
+
+/** Flush the device cache via the scheduler.
+ *
+ * Waits until all queued and in-flight requests have completed before
+ * asking the device to flush, so the flush covers them.
+ *
+ * @param sched	I/O scheduler
+ * @param ba	Address of first block
+ * @param cnt	Number of blocks (0 means until the end of device)
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t bd_sched_sync_cache(bd_sched_t *sched, aoff64_t ba, size_t cnt)
+{
+	fibril_mutex_lock(&sched->lock);
+	while ((!list_empty(&sched->queue)) || (sched->in_flight > 0))
+		fibril_condvar_wait(&sched->queue_cv, &sched->lock);
+	fibril_mutex_unlock(&sched->lock);
+
+	return bd_sync_cache(sched->bd, ba, cnt);
+}
+
+/** @}
+ */
@@ -42,12 +42,44 @@
 
 #include <bd_srv.h>
 
+/** Allocate a transfer buffer.
+ *
+ * Preferably use the server's buffer provider (e.g. a DMA pool), fall
+ * back to an ordinary allocation when there is none or it is exhausted.
+ */
+static void *bd_srv_buf_alloc(bd_srv_t *srv, size_t size, bool *pooled)
+{
+	void *buf = NULL;
+
+	*pooled = false;
+	if (srv->srvs->ops->alloc_buf != NULL) {
+		buf = srv->srvs->ops->alloc_buf(srv, size);
+		if (buf != NULL)
+			*pooled = true;
+	}
+
+	if (buf == NULL)
+		buf = malloc(size);
+
+	return buf;
+}
+
+/** Free a transfer buffer allocated by bd_srv_buf_alloc(). */
+static void bd_srv_buf_free(bd_srv_t *srv, void *buf, size_t size, bool pooled)
+{
+	if (pooled)
+		srv->srvs->ops->free_buf(srv, buf, size);
+	else
+		free(buf);
+}
+
 static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	aoff64_t ba;
 	size_t cnt;
 	void *buf;
 	size_t size;
+	bool pooled;
 	errno_t rc;
 
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
@@ -59,7 +91,7 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 		return;
 	}
 
-	buf = malloc(size);
+	buf = bd_srv_buf_alloc(srv, size, &pooled);
 	if (buf == NULL) {
 		async_answer_0(&rcall, ENOMEM);
 		async_answer_0(call, ENOMEM);
@@ -69,7 +101,7 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	if (srv->srvs->ops->read_blocks == NULL) {
 		async_answer_0(&rcall, ENOTSUP);
 		async_answer_0(call, ENOTSUP);
-		free(buf);
+		bd_srv_buf_free(srv, buf, size, pooled);
 		return;
 	}
 
@@ -77,13 +109,13 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	if (rc != EOK) {
 		async_answer_0(&rcall, ENOMEM);
 		async_answer_0(call, ENOMEM);
-		free(buf);
+		bd_srv_buf_free(srv, buf, size, pooled);
 		return;
 	}
 
 	async_data_read_finalize(&rcall, buf, size);
 
-	free(buf);
+	bd_srv_buf_free(srv, buf, size, pooled);
 	async_answer_0(call, EOK);
 }
 
@@ -154,24 +186,40 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	size_t cnt;
 	void *data;
 	size_t size;
+	bool pooled;
 	errno_t rc;
 
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
-	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
+	ipc_call_t wcall;
+	if (!async_data_write_receive(&wcall, &size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	data = bd_srv_buf_alloc(srv, size, &pooled);
+	if (data == NULL) {
+		async_answer_0(&wcall, ENOMEM);
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	rc = async_data_write_finalize(&wcall, data, size);
 	if (rc != EOK) {
+		bd_srv_buf_free(srv, data, size, pooled);
 		async_answer_0(call, rc);
 		return;
 	}
 
 	if (srv->srvs->ops->write_blocks == NULL) {
+		bd_srv_buf_free(srv, data, size, pooled);
 		async_answer_0(call, ENOTSUP);
 		return;
 	}
 
 	rc = srv->srvs->ops->write_blocks(srv, ba, cnt, data, size);
-	free(data);
+	bd_srv_buf_free(srv, data, size, pooled);
 	async_answer_0(call, rc);
 }
 
@@ -203,6 +251,20 @@ static void bd_get_num_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_2(call, rc, LOWER32(num_blocks), UPPER32(num_blocks));
 }
 
+static void bd_get_queue_depth_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	errno_t rc;
+	size_t queue_depth;
+
+	if (srv->srvs->ops->get_queue_depth == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->get_queue_depth(srv, &queue_depth);
+	async_answer_1(call, rc, queue_depth);
+}
+
 static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 {
 	bd_srv_t *srv;
@@ -273,6 +335,9 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 		case BD_GET_NUM_BLOCKS:
 			bd_get_num_blocks_srv(srv, &call);
 			break;
+		case BD_GET_QUEUE_DEPTH:
+			bd_get_queue_depth_srv(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdrv
+ * @{
+ */
+/** @file
+ * @brief Pool of DMA-capable buffers
+ *
+ * Block device drivers traditionally bounce data between the buffer
+ * shared with the client and a driver-private DMA buffer. A DMA pool
+ * lets the server-side stub allocate the shared buffer directly from
+ * device-visible memory, so aligned transfers need no extra copy.
+ */
+
+#include <as.h>
+#include <ddi.h>
+#include <stdlib.h>
+
+#include <dma_pool.h>
+
+/** Create a pool of DMA-capable buffers.
+ *
+ * @param buf_size	Size of a single buffer in bytes.
+ * @param nbufs		Number of buffers in the pool.
+ * @param constraint	Physical address constraint (e.g. DMAMEM_4GiB)
+ *			or zero for no constraint.
+ * @param rpool		Place to store pointer to the new pool.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t dma_pool_create(size_t buf_size, size_t nbufs, uintptr_t constraint,
+    dma_pool_t **rpool)
+{
+	dma_pool_t *pool;
+	errno_t rc;
+	size_t i;
+
+	pool = calloc(1, sizeof(dma_pool_t));
+	if (pool == NULL)
+		return ENOMEM;
+
+	pool->free_idx = calloc(nbufs, sizeof(size_t));
+	if (pool->free_idx == NULL) {
+		free(pool);
+		return ENOMEM;
+	}
+
+	pool->vaddr = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(nbufs * buf_size, constraint,
+	    AS_AREA_READ | AS_AREA_WRITE, 0, &pool->paddr, &pool->vaddr);
+	if (rc != EOK) {
+		free(pool->free_idx);
+		free(pool);
+		return rc;
+	}
+
+	fibril_mutex_initialize(&pool->lock);
+	pool->buf_size = buf_size;
+	pool->nbufs = nbufs;
+
+	for (i = 0; i < nbufs; i++)
+		pool->free_idx[i] = i;
+	pool->free_cnt = nbufs;
+
+	*rpool = pool;
+	return EOK;
+}
+
+/** Destroy a DMA pool.
+ *
+ * All buffers must have been returned to the pool beforehand.
+ *
+ * @param pool		Pool to destroy.
+ */
+void dma_pool_destroy(dma_pool_t *pool)
+{
+	assert(pool->free_cnt == pool->nbufs);
+
+	dmamem_unmap_anonymous(pool->vaddr);
+	free(pool->free_idx);
+	free(pool);
+}
+
+/** Allocate a buffer from a DMA pool.
+ *
+ * @param pool		Pool to allocate from.
+ * @param rphys		Place to store the physical address of the buffer
+ *			or @c NULL if the caller is not interested.
+ *
+ * @return		Pointer to the buffer or @c NULL if the pool
+ *			is exhausted.
+ */
+void *dma_pool_alloc(dma_pool_t *pool, uintptr_t *rphys)
+{
+	size_t idx;
+
+	fibril_mutex_lock(&pool->lock);
+	if (pool->free_cnt == 0) {
+		fibril_mutex_unlock(&pool->lock);
+		return NULL;
+	}
+
+	idx = pool->free_idx[--pool->free_cnt];
+	fibril_mutex_unlock(&pool->lock);
+
+	if (rphys != NULL)
+		*rphys = pool->paddr + idx * pool->buf_size;
+
+	return pool->vaddr + idx * pool->buf_size;
+}
+
+/** Return a buffer to a DMA pool.
+ *
+ * @param pool		Pool the buffer was allocated from.
+ * @param buf		Buffer to return.
+ */
+void dma_pool_free(dma_pool_t *pool, void *buf)
+{
+	size_t idx;
+
+	assert(dma_pool_contains(pool, buf));
+	idx = (buf - pool->vaddr) / pool->buf_size;
+
+	fibril_mutex_lock(&pool->lock);
+	assert(pool->free_cnt < pool->nbufs);
+	pool->free_idx[pool->free_cnt++] = idx;
+	fibril_mutex_unlock(&pool->lock);
+}
+
+/** Determine whether a buffer comes from a DMA pool.
+ *
+ * @param pool		Pool to check against.
+ * @param buf		Buffer to check.
+ *
+ * @return		@c true iff the buffer belongs to the pool.
+ */
+bool dma_pool_contains(dma_pool_t *pool, void *buf)
+{
+	return buf >= pool->vaddr &&
+	    buf < pool->vaddr + pool->nbufs * pool->buf_size;
+}
+
+/** Get the physical address of a location inside a pool buffer.
+ *
+ * @param pool		Pool the buffer was allocated from.
+ * @param buf		Location inside a pool buffer.
+ * @param rphys		Place to store the physical address.
+ *
+ * @return		EOK on success, EINVAL if the location does not
+ *			belong to the pool.
+ */
+errno_t dma_pool_phys(dma_pool_t *pool, void *buf, uintptr_t *rphys)
+{
+	if (!dma_pool_contains(pool, buf))
+		return EINVAL;
+
+	*rphys = pool->paddr + (buf - pool->vaddr);
+	return EOK;
+}
+
+/**
+ * @}
+ */
@@ -1244,7 +1244,7 @@ errno_t nic_offload_set(async_sess_t *dev_sess, uint32_t mask, uint32_t active)
 {
 	async_exch_t *exch = async_exchange_begin(dev_sess);
 	errno_t rc = async_req_3_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
-	    NIC_AUTONEG_RESTART, (sysarg_t) mask, (sysarg_t) active);
+	    NIC_OFFLOAD_SET, (sysarg_t) mask, (sysarg_t) active);
 	async_exchange_end(exch);
 
 	return rc;
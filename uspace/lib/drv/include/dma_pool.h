@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdrv
+ * @{
+ */
+/** @file
+ * @brief Pool of DMA-capable buffers
+ */
+
+#ifndef LIBDRV_DMA_POOL_H_
+#define LIBDRV_DMA_POOL_H_
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Pool of equally sized, physically contiguous, device-visible buffers.
+ *
+ * The pool is backed by a single anonymous DMA memory area, so every
+ * buffer handed out of it can be passed to a device without bouncing
+ * the data through a driver-private buffer.
+ */
+typedef struct {
+	/** Serializes access to the free stack. */
+	fibril_mutex_t lock;
+	/** Size of a single buffer in bytes. */
+	size_t buf_size;
+	/** Total number of buffers in the pool. */
+	size_t nbufs;
+	/** Virtual address of the backing memory area. */
+	void *vaddr;
+	/** Physical address of the backing memory area. */
+	uintptr_t paddr;
+	/** Stack of free buffer indices. */
+	size_t *free_idx;
+	/** Number of free buffers on the stack. */
+	size_t free_cnt;
+} dma_pool_t;
+
+extern errno_t dma_pool_create(size_t, size_t, uintptr_t, dma_pool_t **);
+extern void dma_pool_destroy(dma_pool_t *);
+extern void *dma_pool_alloc(dma_pool_t *, uintptr_t *);
+extern void dma_pool_free(dma_pool_t *, void *);
+extern bool dma_pool_contains(dma_pool_t *, void *);
+extern errno_t dma_pool_phys(dma_pool_t *, void *, uintptr_t *);
+
+#endif
+
+/**
+ * @}
+ */
@@ -42,9 +42,37 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	/**
+	 * Batch of received frames in a single transfer. The data is a
+	 * sequence of frames, each prefixed with its size as a uint32_t.
+	 */
+	NIC_EV_RECEIVED_LIST,
+	/**
+	 * Offer of the shared RX frame pool. Followed by sharing out the
+	 * pool memory area. A client which maps the pool can receive
+	 * frames in place via NIC_EV_RECEIVED_POOL_LIST.
+	 */
+	NIC_EV_FRAME_POOL,
+	/**
+	 * Batch of received frames residing in the shared RX frame pool,
+	 * passed by slot index (an array of nic_pool_frame_t). The slots
+	 * are owned by the client until the event is answered.
+	 */
+	NIC_EV_RECEIVED_POOL_LIST
 } nic_event_t;
 
+/** Size of one slot of the shared RX frame pool in bytes */
+#define NIC_POOL_SLOT_SIZE  2048
+
+/** One entry of a NIC_EV_RECEIVED_POOL_LIST batch */
+typedef struct {
+	/** Pool slot index */
+	uint32_t idx;
+	/** Frame size in bytes */
+	uint32_t size;
+} nic_pool_frame_t;
+
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
@@ -41,6 +41,8 @@ extern void ext4_bitmap_set_bit(uint8_t *, uint32_t);
 extern bool ext4_bitmap_is_free_bit(uint8_t *, uint32_t);
 extern errno_t ext4_bitmap_find_free_byte_and_set_bit(uint8_t *, uint32_t,
     uint32_t *, uint32_t);
+extern errno_t ext4_bitmap_find_free_run_and_set_bit(uint8_t *, uint32_t,
+    uint32_t *, uint32_t, uint32_t);
 extern errno_t ext4_bitmap_find_free_bit_and_set(uint8_t *, uint32_t, uint32_t *,
     uint32_t);
 
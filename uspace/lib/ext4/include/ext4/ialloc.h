@@ -37,7 +37,8 @@
 #include "ext4/types.h"
 
 extern errno_t ext4_ialloc_free_inode(ext4_filesystem_t *, uint32_t, bool);
-extern errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *, uint32_t *, bool);
+extern errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *, uint32_t *, bool,
+    uint32_t);
 extern errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *, uint32_t,
     bool);
 
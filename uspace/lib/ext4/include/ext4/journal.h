@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+
+#ifndef LIBEXT4_JOURNAL_H_
+#define LIBEXT4_JOURNAL_H_
+
+#include <stdint.h>
+#include "ext4/types.h"
+
+/*
+ * On-disk structures of the JBD2 journal. All fields are stored in
+ * big-endian byte order, unlike the rest of the file system.
+ */
+
+#define EXT4_JOURNAL_MAGIC  0xc03b3998
+
+/* Journal block types */
+#define EXT4_JOURNAL_BLOCK_DESCRIPTOR     1
+#define EXT4_JOURNAL_BLOCK_COMMIT         2
+#define EXT4_JOURNAL_BLOCK_SUPERBLOCK_V1  3
+#define EXT4_JOURNAL_BLOCK_SUPERBLOCK_V2  4
+#define EXT4_JOURNAL_BLOCK_REVOKE         5
+
+/* Journal incompatible features */
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE        0x0001
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT         0x0002
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_ASYNC_COMMIT  0x0004
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP \
+	(EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE | \
+	EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT)
+
+/* Descriptor block tag flags */
+#define EXT4_JOURNAL_FLAG_ESCAPE     1
+#define EXT4_JOURNAL_FLAG_SAME_UUID  2
+#define EXT4_JOURNAL_FLAG_DELETED    4
+#define EXT4_JOURNAL_FLAG_LAST_TAG   8
+
+/** Common header of all journal blocks */
+typedef struct ext4_journal_header {
+	uint32_t magic;
+	uint32_t block_type;
+	uint32_t sequence;
+} ext4_journal_header_t;
+
+/** Journal superblock (first block of the journal file) */
+typedef struct ext4_journal_superblock {
+	ext4_journal_header_t header;
+	uint32_t block_size;            /* Journal device block size */
+	uint32_t max_len;               /* Total blocks in the journal file */
+	uint32_t first;                 /* First block of log information */
+	uint32_t sequence;              /* First expected commit ID */
+	uint32_t start;                 /* Block number of the start of log */
+	uint32_t error_number;          /* Error value set by jbd2 */
+	uint32_t features_compatible;
+	uint32_t features_incompatible;
+	uint32_t features_read_only;
+	uint8_t uuid[16];
+	uint32_t users_count;           /* Number of file systems sharing log */
+	uint32_t dyn_superblock;        /* Blocknr of dynamic superblock copy */
+	uint32_t max_transaction;       /* Limit of journal blocks per trans */
+	uint32_t max_transaction_data;  /* Limit of data blocks per trans */
+	uint8_t checksum_type;
+	uint8_t padding2[3];
+	uint32_t padding[42];
+	uint32_t checksum;
+	uint8_t users[16 * 48];         /* IDs of all file systems sharing log */
+} ext4_journal_superblock_t;
+
+/** Tag in a descriptor block, describing one journaled data block */
+typedef struct ext4_journal_block_tag {
+	uint32_t blocknr;               /* Home block number on the device */
+	uint16_t checksum;
+	uint16_t flags;
+	/* Followed by uint32_t blocknr_high iff the 64BIT feature is set */
+} ext4_journal_block_tag_t;
+
+/** Header of a revoke block */
+typedef struct ext4_journal_revoke_header {
+	ext4_journal_header_t header;
+	uint32_t count;                 /* Used bytes incl. this header */
+} ext4_journal_revoke_header_t;
+
+extern errno_t ext4_journal_recover(ext4_filesystem_t *);
+
+#endif
+
+/** @}
+ */
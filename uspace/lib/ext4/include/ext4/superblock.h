@@ -114,6 +114,7 @@ extern void ext4_superblock_set_features_incompatible(ext4_superblock_t *,
 extern uint32_t ext4_superblock_get_features_read_only(ext4_superblock_t *);
 extern void ext4_superblock_set_features_read_only(ext4_superblock_t *,
     uint32_t);
+extern uint32_t ext4_superblock_get_journal_inode_number(ext4_superblock_t *);
 
 extern void ext4_superblock_get_uuid(ext4_superblock_t *, uuid_t *);
 extern void ext4_superblock_set_uuid(ext4_superblock_t *, uuid_t *);
@@ -230,6 +230,7 @@ typedef struct ext4_superblock {
 typedef struct ext4_filesystem {
 	service_id_t device;
 	ext4_superblock_t *superblock;
+	enum cache_mode cmode;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
 } ext4_filesystem_t;
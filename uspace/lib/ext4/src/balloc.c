@@ -46,6 +46,14 @@
 #include "ext4/superblock.h"
 #include "ext4/types.h"
 
+/** Length (in blocks) of the free run preferred when placing a new block.
+ *
+ * Starting an allocation at the head of a longer free run leaves room for
+ * the file to grow contiguously via ext4_balloc_try_alloc_block(), which
+ * keeps streaming writes from scattering extents across the group.
+ */
+#define EXT4_BALLOC_ALLOC_RUN  64
+
 /** Free block.
  *
  * @param inode_ref  Inode, where the block is allocated
@@ -443,6 +451,23 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 		}
 	}
 
+	/* Find the head of a longer free run in bitmap */
+	rc = ext4_bitmap_find_free_run_and_set_bit(bitmap_block->data,
+	    index_in_group, &rel_block_idx, blocks_in_group,
+	    EXT4_BALLOC_ALLOC_RUN);
+	if (rc == EOK) {
+		bitmap_block->dirty = true;
+		rc = block_put(bitmap_block);
+		if (rc != EOK)
+			return rc;
+
+		allocated_block =
+		    ext4_filesystem_index_in_group2blockaddr(sb, rel_block_idx,
+		    block_group);
+
+		goto success;
+	}
+
 	/* Find free BYTE in bitmap */
 	rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 	    index_in_group, &rel_block_idx, blocks_in_group);
@@ -531,6 +556,25 @@ goal_failed:
 		if (index_in_group < first_in_group_index)
 			index_in_group = first_in_group_index;
 
+		/* Try to find the head of a longer free run in bitmap */
+		rc = ext4_bitmap_find_free_run_and_set_bit(bitmap_block->data,
+		    index_in_group, &rel_block_idx, blocks_in_group,
+		    EXT4_BALLOC_ALLOC_RUN);
+		if (rc == EOK) {
+			bitmap_block->dirty = true;
+			rc = block_put(bitmap_block);
+			if (rc != EOK) {
+				ext4_filesystem_put_block_group_ref(bg_ref);
+				return rc;
+			}
+
+			allocated_block =
+			    ext4_filesystem_index_in_group2blockaddr(sb, rel_block_idx,
+			    bgid);
+
+			goto success;
+		}
+
 		/* Try to find free byte in bitmap */
 		rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 		    index_in_group, &rel_block_idx, blocks_in_group);
@@ -34,6 +34,7 @@
  * @brief Ext4 bitmap operations.
  */
 
+#include <assert.h>
 #include <errno.h>
 #include <block.h>
 #include <stdint.h>
@@ -198,6 +199,62 @@ errno_t ext4_bitmap_find_free_byte_and_set_bit(uint8_t *bitmap, uint32_t start,
 	return ENOSPC;
 }
 
+/** Try to find a run of free blocks and set its first bit as used.
+ *
+ * Walk through bitmap and try to find run_len consecutive free bits,
+ * starting at a byte boundary. If such a run is found, only the first
+ * bit is set as used; the rest of the run is left free for subsequent
+ * allocations to grow into.
+ *
+ * @param bitmap  Pointer to bitmap
+ * @param start   Index of bit, where the algorithm will begin
+ * @param index   Output value - index of bit (if run found)
+ * @param max     Maximum index of bit in bitmap
+ * @param run_len Required run length in bits, multiple of 8
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_bitmap_find_free_run_and_set_bit(uint8_t *bitmap, uint32_t start,
+    uint32_t *index, uint32_t max, uint32_t run_len)
+{
+	uint32_t idx;
+
+	assert(run_len % 8 == 0);
+
+	/* Align idx */
+	if (start % 8)
+		idx = start + (8 - (start % 8));
+	else
+		idx = start;
+
+	uint8_t *pos = bitmap + (idx / 8);
+	uint32_t run_bytes = run_len / 8;
+
+	/* Try to find a run of free bytes */
+	while (idx + run_len <= max) {
+		uint32_t i;
+		for (i = 0; i < run_bytes; ++i) {
+			if (pos[i] != 0)
+				break;
+		}
+
+		if (i == run_bytes) {
+			*pos |= 1;
+
+			*index = idx;
+			return EOK;
+		}
+
+		/* Skip past the first occupied byte found */
+		idx += (i + 1) * 8;
+		pos += i + 1;
+	}
+
+	/* Free run not found */
+	return ENOSPC;
+}
+
 /** Try to find free bit and set it as used (1).
  *
  * Walk through bitmap and try to find any free bit.
@@ -441,6 +441,97 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	return rc;
 }
 
+/** Find physical block run starting at the specified logical block.
+ *
+ * Like ext4_extent_find_block(), but also reports how many blocks are
+ * physically contiguous starting at iblock according to the extent the
+ * block belongs to, so that the caller can issue one I/O request for the
+ * whole run.
+ *
+ * @param inode_ref I-node to read extent tree from
+ * @param iblock    Logical block to find the run for
+ * @param fblock    Output value for physical block address
+ * @param count     Output value for number of contiguous blocks (at least 1)
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_find_block_run(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t *fblock, uint32_t *count)
+{
+	errno_t rc = EOK;
+
+	/* Compute bound defined by i-node size */
+	uint64_t inode_size =
+	    ext4_inode_get_size(inode_ref->fs->superblock, inode_ref->inode);
+
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(inode_ref->fs->superblock);
+
+	uint32_t last_idx = (inode_size - 1) / block_size;
+
+	/* Check if requested iblock is not over size of i-node */
+	if (iblock > last_idx) {
+		*fblock = 0;
+		*count = 1;
+		return EOK;
+	}
+
+	block_t *block = NULL;
+
+	/* Walk through extent tree */
+	ext4_extent_header_t *header =
+	    ext4_inode_get_extent_header(inode_ref->inode);
+
+	while (ext4_extent_header_get_depth(header) != 0) {
+		/* Search index in node */
+		ext4_extent_index_t *index;
+		ext4_extent_binsearch_idx(header, &index, iblock);
+
+		/* Load child node and set values for the next iteration */
+		uint64_t child = ext4_extent_index_get_leaf(index);
+
+		if (block != NULL) {
+			rc = block_put(block);
+			if (rc != EOK)
+				return rc;
+		}
+
+		rc = block_get(&block, inode_ref->fs->device, child,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		header = (ext4_extent_header_t *)block->data;
+	}
+
+	/* Search extent in the leaf block */
+	ext4_extent_t *extent = NULL;
+	ext4_extent_binsearch(header, &extent, iblock);
+
+	/* Prevent empty leaf */
+	if (extent == NULL) {
+		*fblock = 0;
+		*count = 1;
+	} else {
+		/* Compute requested physical block address */
+		uint32_t first = ext4_extent_get_first_block(extent);
+		uint32_t blocks = ext4_extent_get_block_count(extent);
+
+		*fblock = ext4_extent_get_start(extent) + iblock - first;
+		if (iblock - first < blocks)
+			*count = blocks - (iblock - first);
+		else
+			*count = 1;
+	}
+
+	/* Cleanup */
+	if (block != NULL)
+		rc = block_put(block);
+
+	return rc;
+}
+
 /** Find extent for specified iblock.
  *
  * This function is used for finding block in the extent tree with
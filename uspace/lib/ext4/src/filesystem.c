@@ -53,6 +53,7 @@
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/superblock.h"
 
@@ -103,6 +104,8 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	if (rc != EOK)
 		goto err_1;
 
+	fs->cmode = cmode;
+
 	/* Compute limits for indirect block levels */
 	uint32_t block_ids_per_block = block_size / sizeof(uint32_t);
 	fs->inode_block_limits[0] = EXT4_INODE_DIRECT_BLOCK_COUNT;
@@ -117,6 +120,44 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	/* Return loaded superblock */
 	fs->superblock = temp_superblock;
 
+	/*
+	 * If the file system was not unmounted cleanly and has a journal,
+	 * replay it to bring the metadata back to the state of the last
+	 * committed transaction.
+	 */
+	if ((ext4_superblock_get_rev_level(fs->superblock) > 0) &&
+	    (ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL)) &&
+	    (ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_RECOVER))) {
+		rc = ext4_journal_recover(fs);
+		if (rc != EOK)
+			goto err_2;
+
+		/*
+		 * The replay may have overwritten the superblock, so re-read
+		 * it from the device before looking at it again.
+		 */
+		rc = ext4_superblock_read_direct(fs->device, &fs->superblock);
+		if (rc != EOK)
+			goto err_2;
+
+		ext4_superblock_release(temp_superblock);
+		temp_superblock = fs->superblock;
+
+		/* The file system is consistent again */
+		ext4_superblock_set_features_incompatible(fs->superblock,
+		    ext4_superblock_get_features_incompatible(fs->superblock) &
+		    ~EXT4_FEATURE_INCOMPAT_RECOVER);
+		ext4_superblock_set_state(fs->superblock,
+		    ext4_superblock_get_state(fs->superblock) |
+		    EXT4_SUPERBLOCK_STATE_VALID_FS);
+
+		rc = ext4_superblock_write_direct(fs->device, fs->superblock);
+		if (rc != EOK)
+			goto err_2;
+	}
+
 	uint16_t state = ext4_superblock_get_state(fs->superblock);
 
 	if (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
@@ -174,7 +215,8 @@ static errno_t ext4_filesystem_create_lost_found(ext4_filesystem_t *fs,
 	errno_t rc;
 	ext4_inode_ref_t *inode_ref;
 
-	rc = ext4_filesystem_alloc_inode(fs, &inode_ref, L_DIRECTORY);
+	rc = ext4_filesystem_alloc_inode(fs, &inode_ref, L_DIRECTORY,
+	    EXT4_INODE_ROOT_INDEX);
 	if (rc != EOK)
 		goto error;
 
@@ -599,11 +641,11 @@ uint32_t ext4_filesystem_blockaddr2group(ext4_superblock_t *sb, uint64_t b)
 static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
 {
 	errno_t rc;
-	block_t *block;
 	aoff64_t b;
 	ext4_block_group_t *bg;
 	ext4_superblock_t *sb = fs->superblock;
 	ext4_block_group_ref_t *bg_ref;
+	uint8_t *dtable;
 
 	uint32_t block_group_count = ext4_superblock_get_block_group_count(sb);
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
@@ -634,71 +676,80 @@ static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
 	uint32_t reserved;
 	uint32_t inode_table_blocks;
 
-	dcnt = block_group_count;
+	/*
+	 * Assemble the whole descriptor table in memory and flush it
+	 * to the device in large contiguous runs rather than going
+	 * through the block cache one block at a time. The blocks are
+	 * not in the cache yet, so later cached accesses will read the
+	 * table back from the device.
+	 */
+	dtable = calloc(dtable_blocks, block_size);
+	if (dtable == NULL)
+		return ENOMEM;
 
-	/* Fill in block descriptors */
-	b = block_id;
-	bg_index = 0;
 	bg_block0 = block_id;
-	while (dcnt > 0) {
-		rc = block_get(&block, fs->device, b, BLOCK_FLAGS_NOREAD);
-		if (rc != EOK)
-			return rc;
-
-		if (dcnt > descriptors_per_block)
-			now = descriptors_per_block;
-		else
-			now = dcnt;
+	for (bg_index = 0; bg_index < block_group_count; bg_index++) {
+		bg = (ext4_block_group_t *) (dtable +
+		    (bg_index / descriptors_per_block) * block_size +
+		    (bg_index % descriptors_per_block) * desc_size);
+
+		block_bitmap = bg_block0 + dtable_blocks;
+		inode_bitmap = block_bitmap + 1;
+		inode_table = inode_bitmap + 1;
+
+		free_blocks = ext4_superblock_get_blocks_in_group(sb,
+		    bg_index);
+
+		free_inodes =
+		    ext4_filesystem_bg_get_itable_size(sb, bg_index) *
+		    ext4_filesystem_inodes_per_block(sb);
+		used_dirs = 0;
+
+		ext4_block_group_set_block_bitmap(bg, sb, block_bitmap);
+		ext4_block_group_set_inode_bitmap(bg, sb, inode_bitmap);
+		ext4_block_group_set_inode_table_first_block(bg, sb,
+		    inode_table);
+		ext4_block_group_set_free_blocks_count(bg, sb,
+		    free_blocks);
+		ext4_block_group_set_free_inodes_count(bg, sb,
+		    free_inodes);
+		ext4_block_group_set_used_dirs_count(bg, sb,
+		    used_dirs);
+
+		/// XX Lazy
+		ext4_block_group_set_flag(bg,
+		    EXT4_BLOCK_GROUP_BLOCK_UNINIT);
+		ext4_block_group_set_flag(bg,
+		    EXT4_BLOCK_GROUP_INODE_UNINIT);
 
-		memset(block->data, 0, block_size);
+		bg_block0 += ext4_superblock_get_blocks_per_group(sb);
+	}
 
-		for (i = 0; i < now; i++) {
-			bg = (ext4_block_group_t *) (block->data + i *
-			    desc_size);
-
-			block_bitmap = bg_block0 + dtable_blocks;
-			inode_bitmap = block_bitmap + 1;
-			inode_table = inode_bitmap + 1;
-
-			free_blocks = ext4_superblock_get_blocks_in_group(sb,
-			    bg_index);
-
-			free_inodes =
-			    ext4_filesystem_bg_get_itable_size(sb, bg_index) *
-			    ext4_filesystem_inodes_per_block(sb);
-			used_dirs = 0;
-
-			ext4_block_group_set_block_bitmap(bg, sb, block_bitmap);
-			ext4_block_group_set_inode_bitmap(bg, sb, inode_bitmap);
-			ext4_block_group_set_inode_table_first_block(bg, sb,
-			    inode_table);
-			ext4_block_group_set_free_blocks_count(bg, sb,
-			    free_blocks);
-			ext4_block_group_set_free_inodes_count(bg, sb,
-			    free_inodes);
-			ext4_block_group_set_used_dirs_count(bg, sb,
-			    used_dirs);
-
-			/// XX Lazy
-			ext4_block_group_set_flag(bg,
-			    EXT4_BLOCK_GROUP_BLOCK_UNINIT);
-			ext4_block_group_set_flag(bg,
-			    EXT4_BLOCK_GROUP_INODE_UNINIT);
-
-			bg_index++;
-			bg_block0 += ext4_superblock_get_blocks_per_group(sb);
-		}
+	/* Write the table in runs of up to 1 MiB */
+	uint32_t batch_blocks = (1024 * 1024) / block_size;
+	if (batch_blocks == 0)
+		batch_blocks = 1;
 
-		block->dirty = true;
+	b = block_id;
+	dcnt = dtable_blocks;
+	i = 0;
+	while (dcnt > 0) {
+		now = dcnt < batch_blocks ? dcnt : batch_blocks;
 
-		rc = block_put(block);
-		if (rc != EOK)
+		rc = block_write_direct(fs->device, b, now,
+		    dtable + (size_t) i * block_size);
+		if (rc != EOK) {
+			free(dtable);
 			return rc;
+		}
 
-		++b;
+		b += now;
+		i += now;
 		dcnt -= now;
 	}
 
+	free(dtable);
+
 	/* This initializes the bitmaps and inode table */
 	for (bg_index = 0; bg_index < block_group_count; bg_index++) {
 		rc = ext4_filesystem_get_block_group_ref(fs, bg_index, &bg_ref);
@@ -1300,12 +1351,14 @@ static errno_t ext4_filesystem_init_inode(ext4_filesystem_t *fs, uint32_t index,
  * @param fs        Filesystem to allocated i-node on
  * @param inode_ref Output pointer to return reference to allocated i-node
  * @param flags     Flags to be set for newly created i-node
+ * @param parent    I-node number of the parent directory or zero if
+ *                  it is not known
  *
  * @return Error code
  *
  */
 errno_t ext4_filesystem_alloc_inode(ext4_filesystem_t *fs,
-    ext4_inode_ref_t **inode_ref, int flags)
+    ext4_inode_ref_t **inode_ref, int flags, uint32_t parent)
 {
 	/* Check if newly allocated i-node will be a directory */
 	bool is_dir = false;
@@ -1314,7 +1367,7 @@ errno_t ext4_filesystem_alloc_inode(ext4_filesystem_t *fs,
 
 	/* Allocate inode by allocation algorithm */
 	uint32_t index;
-	errno_t rc = ext4_ialloc_alloc_inode(fs, &index, is_dir);
+	errno_t rc = ext4_ialloc_alloc_inode(fs, &index, is_dir, parent);
 	if (rc != EOK)
 		return rc;
 
@@ -1689,6 +1742,38 @@ errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Get physical block address and contiguous run length for a logical block.
+ *
+ * For i-nodes using extents the returned count says how many logical blocks
+ * starting at iblock are physically contiguous, allowing the caller to
+ * transfer the whole run with a single I/O request. For i-nodes using
+ * indirect blocks the run is always reported as a single block.
+ *
+ * @param inode_ref I-node to read block addresses from
+ * @param iblock    Logical index of block
+ * @param fblock    Output pointer for return physical block address
+ * @param count     Output pointer for number of contiguous blocks (at least 1)
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_filesystem_get_inode_data_block_run(ext4_inode_ref_t *inode_ref,
+    aoff64_t iblock, uint32_t *fblock, uint32_t *count)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS)) &&
+	    (ext4_inode_get_size(fs->superblock, inode_ref->inode) != 0))
+		return ext4_extent_find_block_run(inode_ref, iblock, fblock,
+		    count);
+
+	*count = 1;
+	return ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
+	    fblock);
+}
+
 /** Set physical block address for the block logical address into the i-node.
  *
  * @param inode_ref I-node to set block address to
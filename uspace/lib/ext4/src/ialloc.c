@@ -161,161 +161,269 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
 	return EOK;
 }
 
-/** I-node allocation algorithm.
- *
- * This is more simple algorithm, than Orlov allocator used
- * in the Linux kernel.
+/** Try to allocate an i-node in one particular block group.
  *
- * @param fs     Filesystem to allocate i-node on
- * @param index  Output value - allocated i-node number
- * @param is_dir Flag if allocated i-node will be file or directory
+ * @param fs           Filesystem to allocate i-node on
+ * @param bgid         Block group to allocate in
+ * @param index        Output value - allocated i-node number
+ * @param is_dir       Flag if allocated i-node will be file or directory
+ * @param need_blocks  When true, skip groups without free data blocks
  *
- * @return Error code
+ * @return EOK on success, ENOSPC if the group is not suitable or full
  *
  */
-errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index, bool is_dir)
+static errno_t ext4_ialloc_try_group(ext4_filesystem_t *fs, uint32_t bgid,
+    uint32_t *index, bool is_dir, bool need_blocks)
 {
-	int pick_first_free = 0;
 	ext4_superblock_t *sb = fs->superblock;
-	uint32_t bgid;
-	uint32_t sb_free_inodes;
-	uint32_t avg_free_inodes;
-	uint32_t const bg_count = ext4_superblock_get_block_group_count(sb);
 
-retry:
+	/* Load block group to check */
+	ext4_block_group_ref_t *bg_ref;
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid, &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	ext4_block_group_t *bg = bg_ref->block_group;
 
-	bgid = 0;
-	sb_free_inodes = ext4_superblock_get_free_inodes_count(sb);
-	avg_free_inodes = sb_free_inodes / bg_count;
+	/* Read necessary values for algorithm */
+	uint32_t free_blocks = ext4_block_group_get_free_blocks_count(bg, sb);
+	uint32_t free_inodes = ext4_block_group_get_free_inodes_count(bg, sb);
+	uint32_t used_dirs = ext4_block_group_get_used_dirs_count(bg, sb);
 
-	/* Try to find free i-node in all block groups */
-	while (bgid < bg_count) {
-		/* Load block group to check */
-		ext4_block_group_ref_t *bg_ref;
-		errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid, &bg_ref);
+	if ((free_inodes == 0) || (need_blocks && (free_blocks == 0))) {
+		rc = ext4_filesystem_put_block_group_ref(bg_ref);
 		if (rc != EOK)
 			return rc;
 
-		ext4_block_group_t *bg = bg_ref->block_group;
+		return ENOSPC;
+	}
 
-		/* Read necessary values for algorithm */
-		uint32_t free_blocks = ext4_block_group_get_free_blocks_count(bg, sb);
-		uint32_t free_inodes = ext4_block_group_get_free_inodes_count(bg, sb);
-		uint32_t used_dirs = ext4_block_group_get_used_dirs_count(bg, sb);
-
-		/*
-		 * Check if this block group is a good candidate
-		 * for allocation.
-		 *
-		 * The criterion is based on the average number
-		 * of free inodes, unless we examine the last block
-		 * group. In that case the last block group might
-		 * have less than the average number of free inodes,
-		 * but it still needs to be taken as a candidate
-		 * because the previous block groups have zero free
-		 * blocks.
-		 */
-		if (((free_inodes >= avg_free_inodes) ||
-		    (bgid == bg_count - 1) || pick_first_free) && (free_blocks > 0)) {
-			/* Load block with bitmap */
-			uint32_t bitmap_block_addr = ext4_block_group_get_inode_bitmap(
-			    bg_ref->block_group, sb);
-
-			block_t *bitmap_block;
-			rc = block_get(&bitmap_block, fs->device, bitmap_block_addr,
-			    BLOCK_FLAGS_NONE);
-			if (rc != EOK) {
-				ext4_filesystem_put_block_group_ref(bg_ref);
-				return rc;
-			}
-
-			/* Try to allocate i-node in the bitmap */
-			uint32_t inodes_in_group = ext4_superblock_get_inodes_in_group(sb, bgid);
-			uint32_t index_in_group;
-			rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
-			    0, &index_in_group, inodes_in_group);
-
-			/* Block group has not any free i-node */
-			if (rc == ENOSPC) {
-				rc = block_put(bitmap_block);
-				if (rc != EOK) {
-					ext4_filesystem_put_block_group_ref(bg_ref);
-					return rc;
-				}
-
-				rc = ext4_filesystem_put_block_group_ref(bg_ref);
-				if (rc != EOK)
-					return rc;
-
-				bgid++;
-				continue;
-			}
-
-			/* Free i-node found, save the bitmap */
-			bitmap_block->dirty = true;
-
-			rc = block_put(bitmap_block);
-			if (rc != EOK) {
-				ext4_filesystem_put_block_group_ref(bg_ref);
-				return rc;
-			}
+	/* Load block with bitmap */
+	uint32_t bitmap_block_addr = ext4_block_group_get_inode_bitmap(
+	    bg_ref->block_group, sb);
 
-			/* Modify filesystem counters */
-			free_inodes--;
-			ext4_block_group_set_free_inodes_count(bg, sb, free_inodes);
+	block_t *bitmap_block;
+	rc = block_get(&bitmap_block, fs->device, bitmap_block_addr,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
 
-			/* Increment used directories counter */
-			if (is_dir) {
-				used_dirs++;
-				ext4_block_group_set_used_dirs_count(bg, sb, used_dirs);
-			}
+	/* Try to allocate i-node in the bitmap */
+	uint32_t inodes_in_group = ext4_superblock_get_inodes_in_group(sb, bgid);
+	uint32_t index_in_group;
+	rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
+	    0, &index_in_group, inodes_in_group);
+
+	/* Block group has not any free i-node */
+	if (rc == ENOSPC) {
+		rc = block_put(bitmap_block);
+		if (rc != EOK) {
+			ext4_filesystem_put_block_group_ref(bg_ref);
+			return rc;
+		}
 
-			/* Decrease unused inodes count */
-			if (ext4_block_group_has_flag(bg,
-			    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
-				uint32_t unused =
-				    ext4_block_group_get_itable_unused(bg, sb);
+		rc = ext4_filesystem_put_block_group_ref(bg_ref);
+		if (rc != EOK)
+			return rc;
 
-				uint32_t inodes_in_group =
-				    ext4_superblock_get_inodes_in_group(sb, bgid);
+		return ENOSPC;
+	}
 
-				uint32_t free = inodes_in_group - unused;
+	/* Free i-node found, save the bitmap */
+	bitmap_block->dirty = true;
 
-				if (index_in_group >= free) {
-					unused = inodes_in_group - (index_in_group + 1);
-					ext4_block_group_set_itable_unused(bg, sb, unused);
-				}
-			}
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
 
-			/* Save modified block group */
-			bg_ref->dirty = true;
+	/* Modify filesystem counters */
+	free_inodes--;
+	ext4_block_group_set_free_inodes_count(bg, sb, free_inodes);
 
-			rc = ext4_filesystem_put_block_group_ref(bg_ref);
-			if (rc != EOK)
-				return rc;
+	/* Increment used directories counter */
+	if (is_dir) {
+		used_dirs++;
+		ext4_block_group_set_used_dirs_count(bg, sb, used_dirs);
+	}
 
-			/* Update superblock */
-			sb_free_inodes--;
-			ext4_superblock_set_free_inodes_count(sb, sb_free_inodes);
+	/* Decrease unused inodes count */
+	if (ext4_block_group_has_flag(bg,
+	    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
+		uint32_t unused =
+		    ext4_block_group_get_itable_unused(bg, sb);
 
-			/* Compute the absolute i-nodex number */
-			*index = ext4_ialloc_index_in_group2inode(sb, index_in_group, bgid);
+		uint32_t free = inodes_in_group - unused;
 
-			return EOK;
+		if (index_in_group >= free) {
+			unused = inodes_in_group - (index_in_group + 1);
+			ext4_block_group_set_itable_unused(bg, sb, unused);
 		}
+	}
+
+	/* Save modified block group */
+	bg_ref->dirty = true;
+
+	rc = ext4_filesystem_put_block_group_ref(bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	/* Update superblock */
+	uint32_t sb_free_inodes = ext4_superblock_get_free_inodes_count(sb);
+	sb_free_inodes--;
+	ext4_superblock_set_free_inodes_count(sb, sb_free_inodes);
+
+	/* Compute the absolute i-nodex number */
+	*index = ext4_ialloc_index_in_group2inode(sb, index_in_group, bgid);
+
+	return EOK;
+}
+
+/** Select a block group for a new directory.
+ *
+ * Orlov-style spreading: among the block groups that have at least the
+ * average number of free i-nodes and free blocks, pick the one with
+ * the fewest directories, so that directory trees (and through the
+ * goal logic in balloc.c also their data) spread over the whole volume
+ * instead of piling up in the first groups. Ties are broken by the
+ * distance from the parent's group.
+ *
+ * @param fs          Filesystem to allocate i-node on
+ * @param parent_bgid Block group of the parent directory
+ * @param rbgid       Output value - selected block group
+ *
+ * @return EOK on success, ENOSPC if no candidate group was found
+ *
+ */
+static errno_t ext4_ialloc_find_dir_group(ext4_filesystem_t *fs,
+    uint32_t parent_bgid, uint32_t *rbgid)
+{
+	ext4_superblock_t *sb = fs->superblock;
+
+	uint32_t bg_count = ext4_superblock_get_block_group_count(sb);
+	uint32_t avg_free_inodes =
+	    ext4_superblock_get_free_inodes_count(sb) / bg_count;
+	uint32_t avg_free_blocks =
+	    ext4_superblock_get_free_blocks_count(sb) / bg_count;
+
+	bool found = false;
+	uint32_t best_bgid = 0;
+	uint32_t best_used_dirs = 0;
+	uint32_t best_distance = 0;
+
+	for (uint32_t bgid = 0; bgid < bg_count; bgid++) {
+		ext4_block_group_ref_t *bg_ref;
+		errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid,
+		    &bg_ref);
+		if (rc != EOK)
+			return rc;
+
+		ext4_block_group_t *bg = bg_ref->block_group;
+
+		uint32_t free_blocks =
+		    ext4_block_group_get_free_blocks_count(bg, sb);
+		uint32_t free_inodes =
+		    ext4_block_group_get_free_inodes_count(bg, sb);
+		uint32_t used_dirs =
+		    ext4_block_group_get_used_dirs_count(bg, sb);
 
-		/* Block group not modified, put it and jump to the next block group */
 		rc = ext4_filesystem_put_block_group_ref(bg_ref);
 		if (rc != EOK)
 			return rc;
 
-		++bgid;
+		if ((free_inodes < avg_free_inodes) ||
+		    (free_blocks < avg_free_blocks) || (free_inodes == 0))
+			continue;
+
+		uint32_t distance = (bgid > parent_bgid) ?
+		    (bgid - parent_bgid) : (parent_bgid - bgid);
+
+		if ((!found) || (used_dirs < best_used_dirs) ||
+		    ((used_dirs == best_used_dirs) &&
+		    (distance < best_distance))) {
+			found = true;
+			best_bgid = bgid;
+			best_used_dirs = used_dirs;
+			best_distance = distance;
+		}
 	}
 
-	/* Try again with less strict conditions */
-	if (pick_first_free == 0) {
-		pick_first_free = 1;
-		goto retry;
+	if (!found)
+		return ENOSPC;
+
+	*rbgid = best_bgid;
+	return EOK;
+}
+
+/** I-node allocation algorithm.
+ *
+ * Orlov-style allocator: new directories are spread over the block
+ * groups with the fewest directories and an above-average amount of
+ * free i-nodes and blocks, while other i-nodes are kept in (or as
+ * close as possible to) the block group of their parent directory.
+ * Since ext4_balloc_find_goal() derives the data block goal from the
+ * i-node's own block group, the data of a file automatically follows
+ * the i-node into the neighborhood of its directory.
+ *
+ * @param fs     Filesystem to allocate i-node on
+ * @param index  Output value - allocated i-node number
+ * @param is_dir Flag if allocated i-node will be file or directory
+ * @param parent I-node number of the parent directory or zero if
+ *               it is not known
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index,
+    bool is_dir, uint32_t parent)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t bg_count = ext4_superblock_get_block_group_count(sb);
+
+	uint32_t parent_bgid = 0;
+	if (parent != 0)
+		parent_bgid = ext4_ialloc_get_bgid_of_inode(sb, parent);
+
+	uint32_t start_bgid = parent_bgid;
+	errno_t rc;
+
+	if (is_dir) {
+		/* Spread directories over the volume */
+		uint32_t dir_bgid;
+		rc = ext4_ialloc_find_dir_group(fs, parent_bgid, &dir_bgid);
+		if ((rc != EOK) && (rc != ENOSPC))
+			return rc;
+
+		if (rc == EOK) {
+			rc = ext4_ialloc_try_group(fs, dir_bgid, index,
+			    is_dir, true);
+			if (rc != ENOSPC)
+				return rc;
+
+			/* The group filled up under us, fall through */
+			start_bgid = dir_bgid;
+		}
+	}
+
+	/*
+	 * Scan the block groups starting at the parent's group (at the
+	 * selected group for directories), so that i-nodes end up as
+	 * close to their directory as possible. The first pass skips
+	 * groups without free data blocks, the second pass takes any
+	 * free i-node.
+	 */
+	for (int need_blocks = 1; need_blocks >= 0; need_blocks--) {
+		for (uint32_t i = 0; i < bg_count; i++) {
+			uint32_t bgid = (start_bgid + i) % bg_count;
+
+			rc = ext4_ialloc_try_group(fs, bgid, index, is_dir,
+			    (bool) need_blocks);
+			if (rc != ENOSPC)
+				return rc;
+		}
 	}
 
 	return ENOSPC;
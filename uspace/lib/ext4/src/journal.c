@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  journal.c
+ * @brief Replay of the JBD2 journal.
+ *
+ * The replay brings the file system metadata back to the state of the
+ * last committed transaction, so that a volume which was not unmounted
+ * cleanly can be mounted without a full consistency check. Following
+ * jbd2, the journal is walked in three passes: first to find the last
+ * fully committed transaction, then to collect revoke records, and
+ * finally to copy the journaled blocks to their home locations.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <block.h>
+#include <byteorder.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "ext4/filesystem.h"
+#include "ext4/inode.h"
+#include "ext4/journal.h"
+#include "ext4/superblock.h"
+
+/** Replay passes, in the order they are executed. */
+typedef enum {
+	/** Find the sequence number of the last committed transaction */
+	JOURNAL_PASS_SCAN,
+	/** Collect revoke records of all committed transactions */
+	JOURNAL_PASS_REVOKE,
+	/** Write journaled blocks of committed transactions back home */
+	JOURNAL_PASS_REPLAY
+} journal_pass_t;
+
+/** State shared by the replay passes */
+typedef struct {
+	ext4_filesystem_t *fs;
+	/** Journal file i-node */
+	ext4_inode_ref_t *inode_ref;
+	/** Block size of both the journal and the file system */
+	uint32_t block_size;
+	/** First log block in the journal file */
+	uint32_t first;
+	/** Total number of blocks in the journal file */
+	uint32_t max_len;
+	/** Log block of the oldest transaction */
+	uint32_t start;
+	/** Sequence number of the oldest transaction */
+	uint32_t sequence;
+	/** Size of one descriptor block tag */
+	size_t tag_size;
+	/** Journal uses 64-bit block numbers */
+	bool feature_64bit;
+	/** Table of revoked home blocks */
+	hash_table_t revoke_table;
+} ext4_journal_recovery_t;
+
+/** Entry of the revoke table */
+typedef struct {
+	ht_link_t link;
+	/** Revoked home block number */
+	uint64_t fblock;
+	/** Highest sequence number revoking the block */
+	uint32_t sequence;
+} revoke_entry_t;
+
+static size_t revoke_key_hash(const void *key)
+{
+	const uint64_t *fblock = key;
+	return hash_mix(*fblock);
+}
+
+static size_t revoke_hash(const ht_link_t *item)
+{
+	revoke_entry_t *entry = hash_table_get_inst(item, revoke_entry_t, link);
+	return hash_mix(entry->fblock);
+}
+
+static bool revoke_key_equal(const void *key, const ht_link_t *item)
+{
+	const uint64_t *fblock = key;
+	revoke_entry_t *entry = hash_table_get_inst(item, revoke_entry_t, link);
+	return entry->fblock == *fblock;
+}
+
+static void revoke_remove_callback(ht_link_t *item)
+{
+	revoke_entry_t *entry = hash_table_get_inst(item, revoke_entry_t, link);
+	free(entry);
+}
+
+static hash_table_ops_t revoke_ops = {
+	.hash = revoke_hash,
+	.key_hash = revoke_key_hash,
+	.key_equal = revoke_key_equal,
+	.equal = NULL,
+	.remove_callback = revoke_remove_callback
+};
+
+/** Compute the log block following jblock, wrapping around the log end. */
+static uint32_t ext4_journal_next_block(ext4_journal_recovery_t *rec,
+    uint32_t jblock)
+{
+	jblock++;
+	if (jblock >= rec->max_len)
+		jblock = rec->first;
+
+	return jblock;
+}
+
+/** Read a block of the journal file.
+ *
+ * @param rec    Recovery state
+ * @param jblock Logical block index within the journal file
+ * @param block  Output pointer for the block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_get_block(ext4_journal_recovery_t *rec,
+    uint32_t jblock, block_t **block)
+{
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(rec->inode_ref,
+	    jblock, &fblock);
+	if (rc != EOK)
+		return rc;
+
+	/* The journal file must not be sparse */
+	if (fblock == 0)
+		return EIO;
+
+	return block_get(block, rec->fs->device, fblock, BLOCK_FLAGS_NONE);
+}
+
+/** Record a revoked home block in the revoke table. */
+static errno_t ext4_journal_record_revoke(ext4_journal_recovery_t *rec,
+    uint64_t fblock, uint32_t sequence)
+{
+	ht_link_t *link = hash_table_find(&rec->revoke_table, &fblock);
+	if (link != NULL) {
+		revoke_entry_t *entry = hash_table_get_inst(link,
+		    revoke_entry_t, link);
+		if (sequence > entry->sequence)
+			entry->sequence = sequence;
+		return EOK;
+	}
+
+	revoke_entry_t *entry = malloc(sizeof(revoke_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	entry->fblock = fblock;
+	entry->sequence = sequence;
+	hash_table_insert(&rec->revoke_table, &entry->link);
+
+	return EOK;
+}
+
+/** Decide whether a block may be replayed from the given transaction. */
+static bool ext4_journal_is_revoked(ext4_journal_recovery_t *rec,
+    uint64_t fblock, uint32_t sequence)
+{
+	ht_link_t *link = hash_table_find(&rec->revoke_table, &fblock);
+	if (link == NULL)
+		return false;
+
+	revoke_entry_t *entry = hash_table_get_inst(link, revoke_entry_t, link);
+	return entry->sequence >= sequence;
+}
+
+/** Copy one journaled block back to its home location. */
+static errno_t ext4_journal_replay_block(ext4_journal_recovery_t *rec,
+    block_t *jdata, uint64_t fblock, uint16_t flags)
+{
+	block_t *home;
+	errno_t rc = block_get(&home, rec->fs->device, fblock,
+	    BLOCK_FLAGS_NOREAD);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(home->data, jdata->data, rec->block_size);
+
+	/*
+	 * An escaped block had its leading magic number zeroed out when it
+	 * was written to the journal so that it cannot be mistaken for a
+	 * journal block. Restore it.
+	 */
+	if (flags & EXT4_JOURNAL_FLAG_ESCAPE)
+		((uint32_t *) home->data)[0] =
+		    host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+
+	home->dirty = true;
+
+	return block_put(home);
+}
+
+/** Process a descriptor block and the data blocks it describes.
+ *
+ * @param rec      Recovery state
+ * @param desc     Descriptor block
+ * @param jblock   Log block of the descriptor; updated to the log block
+ *                 following the last described data block
+ * @param sequence Sequence number of the current transaction
+ * @param replay   True in the replay pass
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_process_descriptor(ext4_journal_recovery_t *rec,
+    block_t *desc, uint32_t *jblock, uint32_t sequence, bool replay)
+{
+	uint8_t *data = desc->data;
+	size_t offset = sizeof(ext4_journal_header_t);
+	uint32_t data_block = ext4_journal_next_block(rec, *jblock);
+	uint64_t fs_blocks =
+	    ext4_superblock_get_blocks_count(rec->fs->superblock);
+	errno_t rc;
+
+	while (offset + rec->tag_size <= rec->block_size) {
+		ext4_journal_block_tag_t *tag =
+		    (ext4_journal_block_tag_t *) (data + offset);
+
+		uint64_t fblock = uint32_t_be2host(tag->blocknr);
+		uint16_t flags = uint16_t_be2host(tag->flags);
+
+		if (rec->feature_64bit) {
+			uint32_t high = uint32_t_be2host(*(uint32_t *) (data +
+			    offset + sizeof(ext4_journal_block_tag_t)));
+			fblock |= ((uint64_t) high) << 32;
+		}
+
+		offset += rec->tag_size;
+		if (!(flags & EXT4_JOURNAL_FLAG_SAME_UUID))
+			offset += sizeof(((ext4_journal_superblock_t *) 0)->uuid);
+
+		if (replay && (fblock < fs_blocks) &&
+		    (!ext4_journal_is_revoked(rec, fblock, sequence))) {
+			block_t *jdata;
+			rc = ext4_journal_get_block(rec, data_block, &jdata);
+			if (rc != EOK)
+				return rc;
+
+			rc = ext4_journal_replay_block(rec, jdata, fblock,
+			    flags);
+
+			errno_t rc2 = block_put(jdata);
+			if (rc == EOK)
+				rc = rc2;
+			if (rc != EOK)
+				return rc;
+		}
+
+		data_block = ext4_journal_next_block(rec, data_block);
+
+		if (flags & EXT4_JOURNAL_FLAG_LAST_TAG)
+			break;
+	}
+
+	*jblock = data_block;
+	return EOK;
+}
+
+/** Collect revoke records from a revoke block. */
+static errno_t ext4_journal_process_revoke(ext4_journal_recovery_t *rec,
+    block_t *block, uint32_t sequence)
+{
+	ext4_journal_revoke_header_t *header = block->data;
+	uint8_t *data = block->data;
+
+	uint32_t count = uint32_t_be2host(header->count);
+	if (count > rec->block_size)
+		count = rec->block_size;
+
+	size_t entry_size = rec->feature_64bit ? sizeof(uint64_t) :
+	    sizeof(uint32_t);
+	size_t offset = sizeof(ext4_journal_revoke_header_t);
+
+	while (offset + entry_size <= count) {
+		uint64_t fblock;
+
+		if (rec->feature_64bit)
+			fblock = uint64_t_be2host(*(uint64_t *) (data + offset));
+		else
+			fblock = uint32_t_be2host(*(uint32_t *) (data + offset));
+
+		errno_t rc = ext4_journal_record_revoke(rec, fblock, sequence);
+		if (rc != EOK)
+			return rc;
+
+		offset += entry_size;
+	}
+
+	return EOK;
+}
+
+/** Walk the log once, performing the work of one replay pass.
+ *
+ * @param rec          Recovery state
+ * @param pass         Pass to perform
+ * @param end_sequence In the scan pass, output value for the sequence
+ *                     number following the last committed transaction.
+ *                     In the other passes, input bound at which the walk
+ *                     stops, so that uncommitted transactions at the log
+ *                     head are ignored.
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_do_pass(ext4_journal_recovery_t *rec,
+    journal_pass_t pass, uint32_t *end_sequence)
+{
+	uint32_t jblock = rec->start;
+	uint32_t sequence = rec->sequence;
+	bool done = false;
+
+	while (!done) {
+		if ((pass != JOURNAL_PASS_SCAN) && (sequence >= *end_sequence))
+			break;
+
+		block_t *block;
+		errno_t rc = ext4_journal_get_block(rec, jblock, &block);
+		if (rc != EOK)
+			return rc;
+
+		ext4_journal_header_t *header = block->data;
+
+		if ((uint32_t_be2host(header->magic) != EXT4_JOURNAL_MAGIC) ||
+		    (uint32_t_be2host(header->sequence) != sequence)) {
+			/* End of the log */
+			(void) block_put(block);
+			break;
+		}
+
+		switch (uint32_t_be2host(header->block_type)) {
+		case EXT4_JOURNAL_BLOCK_DESCRIPTOR:
+			rc = ext4_journal_process_descriptor(rec, block,
+			    &jblock, sequence, pass == JOURNAL_PASS_REPLAY);
+			break;
+		case EXT4_JOURNAL_BLOCK_COMMIT:
+			sequence++;
+			jblock = ext4_journal_next_block(rec, jblock);
+			break;
+		case EXT4_JOURNAL_BLOCK_REVOKE:
+			if (pass == JOURNAL_PASS_REVOKE)
+				rc = ext4_journal_process_revoke(rec, block,
+				    sequence);
+			jblock = ext4_journal_next_block(rec, jblock);
+			break;
+		default:
+			/* Unrecognized journal block - end of the log */
+			done = true;
+			break;
+		}
+
+		errno_t rc2 = block_put(block);
+		if (rc == EOK)
+			rc = rc2;
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (pass == JOURNAL_PASS_SCAN)
+		*end_sequence = sequence;
+
+	return EOK;
+}
+
+/** Replay the journal of a file system that was not unmounted cleanly.
+ *
+ * On success all committed transactions have been written back to their
+ * home locations, the journal has been marked empty and all data has been
+ * synced to the device. The caller is expected to re-read the superblock
+ * afterwards, because the replay may have overwritten it.
+ *
+ * @param fs File system whose journal is to be replayed
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_recover(ext4_filesystem_t *fs)
+{
+	ext4_journal_recovery_t rec;
+	errno_t rc;
+	errno_t rc2;
+
+	uint32_t inum =
+	    ext4_superblock_get_journal_inode_number(fs->superblock);
+	if (inum == 0)
+		return ENOTSUP;
+
+	memset(&rec, 0, sizeof(ext4_journal_recovery_t));
+	rec.fs = fs;
+	rec.block_size = ext4_superblock_get_block_size(fs->superblock);
+
+	rc = ext4_filesystem_get_inode_ref(fs, inum, &rec.inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	/* Load the journal superblock (first block of the journal file) */
+	block_t *sb_block;
+	rc = ext4_journal_get_block(&rec, 0, &sb_block);
+	if (rc != EOK)
+		goto put_inode;
+
+	ext4_journal_superblock_t *jsb = sb_block->data;
+
+	uint32_t block_type = uint32_t_be2host(jsb->header.block_type);
+	if ((uint32_t_be2host(jsb->header.magic) != EXT4_JOURNAL_MAGIC) ||
+	    ((block_type != EXT4_JOURNAL_BLOCK_SUPERBLOCK_V1) &&
+	    (block_type != EXT4_JOURNAL_BLOCK_SUPERBLOCK_V2))) {
+		rc = ENOTSUP;
+		goto put_sb;
+	}
+
+	if (block_type == EXT4_JOURNAL_BLOCK_SUPERBLOCK_V2) {
+		uint32_t incompatible =
+		    uint32_t_be2host(jsb->features_incompatible);
+		if (incompatible & ~EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP) {
+			rc = ENOTSUP;
+			goto put_sb;
+		}
+
+		rec.feature_64bit =
+		    (incompatible & EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT) != 0;
+	}
+
+	if (uint32_t_be2host(jsb->block_size) != rec.block_size) {
+		rc = ENOTSUP;
+		goto put_sb;
+	}
+
+	rec.first = uint32_t_be2host(jsb->first);
+	rec.max_len = uint32_t_be2host(jsb->max_len);
+	rec.start = uint32_t_be2host(jsb->start);
+	rec.sequence = uint32_t_be2host(jsb->sequence);
+	rec.tag_size = sizeof(ext4_journal_block_tag_t) +
+	    (rec.feature_64bit ? sizeof(uint32_t) : 0);
+
+	if ((rec.first == 0) || (rec.first >= rec.max_len) ||
+	    (rec.start >= rec.max_len)) {
+		rc = EIO;
+		goto put_sb;
+	}
+
+	uint32_t end_sequence = rec.sequence;
+
+	if (rec.start != 0) {
+		/* The log is not empty - replay it */
+		if (!hash_table_create(&rec.revoke_table, 0, 0, &revoke_ops)) {
+			rc = ENOMEM;
+			goto put_sb;
+		}
+
+		rc = ext4_journal_do_pass(&rec, JOURNAL_PASS_SCAN,
+		    &end_sequence);
+		if (rc == EOK)
+			rc = ext4_journal_do_pass(&rec, JOURNAL_PASS_REVOKE,
+			    &end_sequence);
+		if (rc == EOK)
+			rc = ext4_journal_do_pass(&rec, JOURNAL_PASS_REPLAY,
+			    &end_sequence);
+
+		hash_table_destroy(&rec.revoke_table);
+
+		if (rc != EOK)
+			goto put_sb;
+	}
+
+	/* Mark the journal empty */
+	jsb->sequence = host2uint32_t_be(end_sequence);
+	jsb->start = 0;
+	sb_block->dirty = true;
+
+put_sb:
+	rc2 = block_put(sb_block);
+	if (rc == EOK)
+		rc = rc2;
+
+	/* Make sure the replayed blocks have hit the device */
+	if (rc == EOK)
+		rc = block_sync_cache(fs->device, 0, 0);
+
+put_inode:
+	rc2 = ext4_filesystem_put_inode_ref(rec.inode_ref);
+	if (rc == EOK)
+		rc = rc2;
+
+	return rc;
+}
+
+/** @}
+ */
@@ -448,9 +448,13 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 		return rc;
 	}
 
-	/* Allocate new i-node in filesystem */
+	/*
+	 * Allocate new i-node in filesystem. The parent directory is
+	 * not known at this point (libfs links the node only after it
+	 * has been created), so the allocator falls back to spreading.
+	 */
 	ext4_inode_ref_t *inode_ref;
-	rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags);
+	rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags, 0);
 	if (rc != EOK) {
 		free(enode);
 		free(fs_node);
@@ -1112,69 +1116,78 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 	}
 
 	/*
-	 * Find next interesting directory entry.
-	 * We want to skip . and .. entries
-	 * as these are not used in HelenOS
+	 * Batch as many directory entries as fit into the client's buffer.
+	 * Entries are returned as a sequence of null-terminated names and the
+	 * position advances over all of them at once, saving one IPC exchange
+	 * per entry when listing large directories. The buffer is allowed to
+	 * overrun the requested size by one entry so that a single entry is
+	 * always delivered, as it used to be; the transfer itself is bounded
+	 * by the client's buffer size.
 	 */
-	bool found = false;
-	while (it.current != NULL) {
-		if (it.current->inode == 0)
-			goto skip;
-
-		uint16_t name_size = ext4_directory_entry_ll_get_name_length(
-		    inst->filesystem->superblock, it.current);
+	uint8_t *buf = malloc(size + EXT4_DIRECTORY_FILENAME_LEN + 1);
+	if (buf == NULL) {
+		ext4_directory_iterator_fini(&it);
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
 
-		/* Skip . and .. */
-		if (ext4_is_dots(it.current->name, name_size))
-			goto skip;
+	size_t used = 0;
+	uint64_t next = pos;
+	bool found = false;
 
+	while (it.current != NULL) {
 		/*
-		 * The on-disk entry does not contain \0 at the end
-		 * end of entry name, so we copy it to new buffer
-		 * and add the \0 at the end
+		 * Consider only interesting directory entries.
+		 * We want to skip empty and . and .. entries
+		 * as the latter are not used in HelenOS.
 		 */
-		uint8_t *buf = malloc(name_size + 1);
-		if (buf == NULL) {
-			ext4_directory_iterator_fini(&it);
-			async_answer_0(call, ENOMEM);
-			return ENOMEM;
-		}
-
-		memcpy(buf, &it.current->name, name_size);
-		*(buf + name_size) = 0;
-		found = true;
+		if (it.current->inode != 0) {
+			uint16_t name_size =
+			    ext4_directory_entry_ll_get_name_length(
+			    inst->filesystem->superblock, it.current);
 
-		(void) async_data_read_finalize(call, buf, name_size + 1);
-		free(buf);
-		break;
+			if (!ext4_is_dots(it.current->name, name_size)) {
+				/* Stop when the buffer is full */
+				if (found && (used + name_size + 1 > size))
+					break;
+
+				/*
+				 * The on-disk entry does not contain \0 at
+				 * the end of entry name, so add it here.
+				 */
+				memcpy(buf + used, &it.current->name,
+				    name_size);
+				buf[used + name_size] = 0;
+				used += name_size + 1;
+				found = true;
+			}
+		}
 
-	skip:
 		rc = ext4_directory_iterator_next(&it);
 		if (rc != EOK) {
 			ext4_directory_iterator_fini(&it);
+			free(buf);
 			async_answer_0(call, rc);
 			return rc;
 		}
-	}
-
-	uint64_t next;
-	if (found) {
-		rc = ext4_directory_iterator_next(&it);
-		if (rc != EOK)
-			return rc;
 
 		next = it.current_offset;
 	}
 
 	rc = ext4_directory_iterator_fini(&it);
-	if (rc != EOK)
+	if (rc != EOK) {
+		free(buf);
 		return rc;
+	}
 
 	/* Prepare return values */
 	if (found) {
+		(void) async_data_read_finalize(call, buf, used);
+		free(buf);
 		*rbytes = next - pos;
 		return EOK;
 	} else {
+		free(buf);
 		async_answer_0(call, ENOENT);
 		return ENOENT;
 	}
@@ -1205,7 +1218,6 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return EOK;
 	}
 
-	/* For now, we only read data from one block at a time */
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	aoff64_t file_block = pos / block_size;
 	uint32_t offset_in_block = pos % block_size;
@@ -1215,6 +1227,66 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 	if (pos + bytes > file_size)
 		bytes = file_size - pos;
 
+	/*
+	 * If the request spans multiple blocks that are physically contiguous
+	 * on the device, transfer the whole run with a single direct request
+	 * instead of pulling the blocks through the cache one by one. This is
+	 * only safe in write-through mode, where no dirty copies of data
+	 * blocks can linger in the block cache.
+	 */
+	size_t left = min(size, file_size - pos);
+	if ((inst->filesystem->cmode == CACHE_MODE_WT) &&
+	    (offset_in_block + left > block_size)) {
+		uint32_t run_start;
+		uint32_t run_len;
+		errno_t rc = ext4_filesystem_get_inode_data_block_run(inode_ref,
+		    file_block, &run_start, &run_len);
+		if (rc != EOK) {
+			async_answer_0(call, rc);
+			return rc;
+		}
+
+		uint32_t blocks_needed =
+		    (offset_in_block + left + block_size - 1) / block_size;
+		uint32_t run_blocks = min(blocks_needed, run_len);
+
+		size_t phys_bsize;
+		if ((run_start != 0) && (run_blocks > 1) &&
+		    (block_get_bsize(inst->service_id, &phys_bsize) == EOK)) {
+			size_t bpp = block_size / phys_bsize;
+			uint8_t *run_buf = malloc((size_t) run_blocks *
+			    block_size);
+
+			/*
+			 * If the buffer cannot be allocated, simply fall
+			 * through to the single-block path below.
+			 */
+			if (run_buf != NULL) {
+				rc = block_read_direct(inst->service_id,
+				    (aoff64_t) run_start * bpp,
+				    (size_t) run_blocks * bpp, run_buf);
+				if (rc != EOK) {
+					free(run_buf);
+					async_answer_0(call, rc);
+					return rc;
+				}
+
+				size_t run_bytes = min(left,
+				    (size_t) run_blocks * block_size -
+				    offset_in_block);
+
+				rc = async_data_read_finalize(call,
+				    run_buf + offset_in_block, run_bytes);
+				free(run_buf);
+				if (rc != EOK)
+					return rc;
+
+				*rbytes = run_bytes;
+				return EOK;
+			}
+		}
+	}
+
 	/* Get the real block number */
 	uint32_t fs_block;
 	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
@@ -853,6 +853,18 @@ void ext4_superblock_set_features_read_only(ext4_superblock_t *sb,
 	sb->features_read_only = host2uint32_t_le(features);
 }
 
+/** Get i-node number of the journal file.
+ *
+ * @param sb Superblock
+ *
+ * @return I-node number of the journal file
+ *
+ */
+uint32_t ext4_superblock_get_journal_inode_number(ext4_superblock_t *sb)
+{
+	return uint32_t_le2host(sb->journal_inode_number);
+}
+
 /** Get UUID of the filesystem.
  *
  * @param sb superblock
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libfs
+ * @{
+ */
+/**
+ * @file
+ * In-memory free-cluster map for FAT-like file systems.
+ *
+ * FAT and exFAT record cluster allocation in on-disk structures whose
+ * linear scanning cost grows with volume size and occupancy. Servers of
+ * these file systems build an fs_cluster_map_t at mount time and keep it
+ * in sync with the on-disk state, so that free clusters can be found in
+ * memory, starting from a rotor hint and preferring contiguous runs.
+ */
+
+#include "clustermap.h"
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdlib.h>
+
+static FIBRIL_MUTEX_INITIALIZE(cluster_maps_mutex);
+static LIST_INITIALIZE(cluster_maps_list);
+
+/** Signalled when a cluster map is published or abandoned. */
+static FIBRIL_CONDVAR_INITIALIZE(cluster_maps_cv);
+
+static bool fs_cluster_map_tst(fs_cluster_map_t *map, uint32_t clst)
+{
+	uint32_t off = clst - map->base;
+
+	return (map->bits[off / 8] & (1 << (off % 8))) != 0;
+}
+
+static void fs_cluster_map_set(fs_cluster_map_t *map, uint32_t clst)
+{
+	uint32_t off = clst - map->base;
+
+	map->bits[off / 8] |= (1 << (off % 8));
+}
+
+static void fs_cluster_map_clr(fs_cluster_map_t *map, uint32_t clst)
+{
+	uint32_t off = clst - map->base;
+
+	map->bits[off / 8] &= ~(1 << (off % 8));
+}
+
+/** Create a cluster map for a volume.
+ *
+ * All clusters are initially marked as used. The caller is expected to
+ * scan the on-disk allocation structures, mark the free clusters via
+ * fs_cluster_map_set_free() and then make the map visible to
+ * fs_cluster_map_get() by calling fs_cluster_map_publish(). The scan may
+ * run on a separate fibril; until the map is published, lookups behave
+ * as if the volume had no cluster map.
+ *
+ * @param service_id	Service ID of the mounted volume.
+ * @param base		Number of the first tracked cluster.
+ * @param nclst		Number of tracked clusters.
+ * @param rmap		Output argument holding the new cluster map.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fs_cluster_map_create(service_id_t service_id, uint32_t base,
+    uint32_t nclst, fs_cluster_map_t **rmap)
+{
+	fs_cluster_map_t *map;
+
+	map = malloc(sizeof(fs_cluster_map_t));
+	if (!map)
+		return ENOMEM;
+
+	map->bits = malloc((nclst + 7) / 8);
+	if (!map->bits) {
+		free(map);
+		return ENOMEM;
+	}
+
+	link_initialize(&map->link);
+	map->service_id = service_id;
+	fibril_mutex_initialize(&map->lock);
+	map->base = base;
+	map->nclst = nclst;
+	map->rotor = 0;
+	map->free_cnt = 0;
+	map->ready = false;
+	memset(map->bits, 0xff, (nclst + 7) / 8);
+
+	fibril_mutex_lock(&cluster_maps_mutex);
+	list_foreach(cluster_maps_list, link, fs_cluster_map_t, cur) {
+		if (cur->service_id == service_id) {
+			fibril_mutex_unlock(&cluster_maps_mutex);
+			free(map->bits);
+			free(map);
+			return EEXIST;
+		}
+	}
+	list_append(&map->link, &cluster_maps_list);
+	fibril_mutex_unlock(&cluster_maps_mutex);
+
+	*rmap = map;
+	return EOK;
+}
+
+/** Publish a fully built cluster map.
+ *
+ * Makes the map visible to fs_cluster_map_get(). Called by the builder
+ * once all free clusters have been marked in the map.
+ *
+ * @param map		Cluster map.
+ */
+void fs_cluster_map_publish(fs_cluster_map_t *map)
+{
+	fibril_mutex_lock(&cluster_maps_mutex);
+	map->ready = true;
+	fibril_condvar_broadcast(&cluster_maps_cv);
+	fibril_mutex_unlock(&cluster_maps_mutex);
+}
+
+/** Throw an unpublished cluster map away.
+ *
+ * Called by the builder when the scan of the on-disk allocation
+ * structures fails. The volume then simply continues without a cluster
+ * map.
+ *
+ * @param map		Cluster map.
+ */
+void fs_cluster_map_abandon(fs_cluster_map_t *map)
+{
+	fibril_mutex_lock(&cluster_maps_mutex);
+	list_remove(&map->link);
+	fibril_condvar_broadcast(&cluster_maps_cv);
+	fibril_mutex_unlock(&cluster_maps_mutex);
+	free(map->bits);
+	free(map);
+}
+
+/** Destroy the cluster map of a volume.
+ *
+ * If the map is still being built, waits for the builder to publish or
+ * abandon it first. It is legal to call this function for a volume which
+ * does not have a cluster map, in which case it is a no-op.
+ *
+ * @param service_id	Service ID of the volume.
+ */
+void fs_cluster_map_destroy(service_id_t service_id)
+{
+	fibril_mutex_lock(&cluster_maps_mutex);
+restart:
+	list_foreach(cluster_maps_list, link, fs_cluster_map_t, cur) {
+		if (cur->service_id == service_id) {
+			if (!cur->ready) {
+				fibril_condvar_wait(&cluster_maps_cv,
+				    &cluster_maps_mutex);
+				goto restart;
+			}
+			list_remove(&cur->link);
+			fibril_mutex_unlock(&cluster_maps_mutex);
+			free(cur->bits);
+			free(cur);
+			return;
+		}
+	}
+	fibril_mutex_unlock(&cluster_maps_mutex);
+}
+
+/** Look the cluster map of a volume up.
+ *
+ * @param service_id	Service ID of the volume.
+ *
+ * @return		Published cluster map or NULL if the volume does
+ *			not have one.
+ */
+fs_cluster_map_t *fs_cluster_map_get(service_id_t service_id)
+{
+	fibril_mutex_lock(&cluster_maps_mutex);
+	list_foreach(cluster_maps_list, link, fs_cluster_map_t, cur) {
+		if (cur->service_id == service_id && cur->ready) {
+			fibril_mutex_unlock(&cluster_maps_mutex);
+			return cur;
+		}
+	}
+	fibril_mutex_unlock(&cluster_maps_mutex);
+	return NULL;
+}
+
+/** Mark a cluster as used. */
+void fs_cluster_map_set_used(fs_cluster_map_t *map, uint32_t clst)
+{
+	fibril_mutex_lock(&map->lock);
+	if (!fs_cluster_map_tst(map, clst)) {
+		fs_cluster_map_set(map, clst);
+		map->free_cnt--;
+	}
+	fibril_mutex_unlock(&map->lock);
+}
+
+/** Mark a cluster as free. */
+void fs_cluster_map_set_free(fs_cluster_map_t *map, uint32_t clst)
+{
+	fibril_mutex_lock(&map->lock);
+	if (fs_cluster_map_tst(map, clst)) {
+		fs_cluster_map_clr(map, clst);
+		map->free_cnt++;
+	}
+	fibril_mutex_unlock(&map->lock);
+}
+
+/** Allocate clusters from the map.
+ *
+ * The search starts at the rotor, i.e. right after the most recently
+ * allocated cluster, which makes consecutive allocations likely to be
+ * physically contiguous. A contiguous run of the requested length is
+ * preferred; if none exists, the clusters are collected one by one.
+ * The allocated cluster numbers are stored in ascending order of
+ * allocation, which for a contiguous run means ascending cluster
+ * numbers.
+ *
+ * @param map		Cluster map.
+ * @param nclsts	Number of clusters to allocate.
+ * @param clsts		Output array for nclsts allocated cluster numbers.
+ *
+ * @return		EOK on success or ENOSPC.
+ */
+errno_t fs_cluster_map_alloc(fs_cluster_map_t *map, unsigned nclsts,
+    uint32_t *clsts)
+{
+	uint32_t off;
+	uint32_t run;
+	uint32_t tried;
+	unsigned found;
+
+	fibril_mutex_lock(&map->lock);
+
+	if (map->free_cnt < nclsts) {
+		fibril_mutex_unlock(&map->lock);
+		return ENOSPC;
+	}
+
+	/*
+	 * Pass 1: look for a contiguous run of nclsts free clusters,
+	 * starting at the rotor and wrapping around once.
+	 */
+	if (nclsts <= map->nclst) {
+		off = map->rotor;
+		run = 0;
+		for (tried = 0; tried < map->nclst + nclsts; tried++) {
+			if (off >= map->nclst) {
+				off = 0;
+				/* Runs do not span the wrap-around. */
+				run = 0;
+			}
+			if (fs_cluster_map_tst(map, map->base + off))
+				run = 0;
+			else
+				run++;
+			off++;
+			if (run == nclsts)
+				break;
+		}
+		if (run == nclsts) {
+			for (found = 0; found < nclsts; found++) {
+				clsts[found] = map->base + off - nclsts +
+				    found;
+				fs_cluster_map_set(map, clsts[found]);
+			}
+			map->free_cnt -= nclsts;
+			map->rotor = off;
+			fibril_mutex_unlock(&map->lock);
+			return EOK;
+		}
+	}
+
+	/*
+	 * Pass 2: no contiguous run exists; collect free clusters one by
+	 * one from the rotor on.
+	 */
+	off = map->rotor;
+	found = 0;
+	for (tried = 0; tried < map->nclst && found < nclsts; tried++) {
+		if (off >= map->nclst)
+			off = 0;
+		if (!fs_cluster_map_tst(map, map->base + off)) {
+			clsts[found] = map->base + off;
+			fs_cluster_map_set(map, clsts[found]);
+			found++;
+		}
+		off++;
+	}
+	assert(found == nclsts);
+	map->free_cnt -= nclsts;
+	map->rotor = off;
+
+	fibril_mutex_unlock(&map->lock);
+	return EOK;
+}
+
+/** @}
+ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libfs
+ * @{
+ */
+/**
+ * @file
+ * In-memory free-cluster map for FAT-like file systems.
+ */
+
+#ifndef LIBFS_CLUSTERMAP_H_
+#define LIBFS_CLUSTERMAP_H_
+
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <loc.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** In-memory map of free and used clusters of one volume.
+ *
+ * The map is built once at mount time by scanning the on-disk allocation
+ * structures and is kept in sync by the file system server afterwards.
+ * It exists to make cluster allocation independent of the size and
+ * occupancy of the on-disk structures.
+ */
+typedef struct {
+	/** Link to the list of all cluster maps. */
+	link_t link;
+	/** Service ID of the mounted volume. */
+	service_id_t service_id;
+	/** Protects all members below. */
+	fibril_mutex_t lock;
+	/** Number of the first tracked cluster. */
+	uint32_t base;
+	/** Number of tracked clusters. */
+	uint32_t nclst;
+	/** Offset at which the next allocation search starts. */
+	uint32_t rotor;
+	/** Number of free clusters. */
+	uint32_t free_cnt;
+	/** One bit per cluster, non-zero means used. */
+	uint8_t *bits;
+	/** True once the map is fully built and published. */
+	bool ready;
+} fs_cluster_map_t;
+
+extern errno_t fs_cluster_map_create(service_id_t, uint32_t, uint32_t,
+    fs_cluster_map_t **);
+extern void fs_cluster_map_publish(fs_cluster_map_t *);
+extern void fs_cluster_map_abandon(fs_cluster_map_t *);
+extern void fs_cluster_map_destroy(service_id_t);
+extern fs_cluster_map_t *fs_cluster_map_get(service_id_t);
+extern void fs_cluster_map_set_used(fs_cluster_map_t *, uint32_t);
+extern void fs_cluster_map_set_free(fs_cluster_map_t *, uint32_t);
+extern errno_t fs_cluster_map_alloc(fs_cluster_map_t *, unsigned, uint32_t *);
+
+#endif
+
+/** @}
+ */
@@ -39,6 +39,7 @@
 
 #include <adt/list.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <types/gfx/bitmap.h>
 #include <types/gfx/context.h>
@@ -46,6 +47,9 @@
 #include <types/gfx/typeface.h>
 #include <riff/chunk.h>
 
+/** Number of entries in glyph lookup cache (indexed by code point) */
+#define GFX_FONT_GCACHE_SIZE 128
+
 /** Font
  *
  * This is private to libgfxfont.
@@ -69,6 +73,15 @@ struct gfx_font {
 	gfx_bitmap_t *bitmap;
 	/** Bitmap rectangle */
 	gfx_rect_t rect;
+	/** Glyph lookup cache.
+	 *
+	 * Glyphs having a single-code-point pattern are entered under
+	 * that code point. A @c NULL entry means the glyph must be
+	 * looked up by searching the glyph list.
+	 */
+	struct gfx_glyph *gcache[GFX_FONT_GCACHE_SIZE];
+	/** @c true iff glyph lookup cache is populated */
+	bool gcache_valid;
 };
 
 /** Font info
@@ -90,6 +103,7 @@ struct gfx_font_info {
 
 extern errno_t gfx_font_splice_at_glyph(gfx_font_t *, gfx_glyph_t *,
     gfx_rect_t *);
+extern void gfx_font_gcache_invalidate(gfx_font_t *);
 extern errno_t gfx_font_info_load(gfx_typeface_t *, riff_rchunk_t *);
 extern errno_t gfx_font_bitmap_pack(gfx_coord_t, gfx_coord_t, uint32_t *,
     void **, size_t *);
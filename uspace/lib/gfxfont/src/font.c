@@ -42,6 +42,7 @@
 #include <gfx/glyph.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <str.h>
 #include "../private/font.h"
 #include "../private/glyph.h"
 #include "../private/tpf_file.h"
@@ -333,6 +334,64 @@ gfx_glyph_t *gfx_font_prev_glyph(gfx_glyph_t *cur)
 	return list_get_instance(link, gfx_glyph_t, lglyphs);
 }
 
+/** Invalidate glyph lookup cache.
+ *
+ * Called whenever the set of glyphs or their patterns change.
+ * The cache will be rebuilt on the next glyph search.
+ *
+ * @param font Font
+ */
+void gfx_font_gcache_invalidate(gfx_font_t *font)
+{
+	font->gcache_valid = false;
+}
+
+/** Populate glyph lookup cache.
+ *
+ * Enter every glyph having a single-code-point pattern into the cache
+ * under that code point. A code point that also begins some longer
+ * pattern is left out, since matching it requires searching the glyph
+ * list (an earlier glyph with the longer pattern must win).
+ *
+ * @param font Font
+ */
+static void gfx_font_gcache_build(gfx_font_t *font)
+{
+	bool shadowed[GFX_FONT_GCACHE_SIZE];
+	gfx_glyph_t *glyph;
+	gfx_glyph_pattern_t *pat;
+	size_t off;
+	char32_t c;
+
+	memset(font->gcache, 0, sizeof(font->gcache));
+	memset(shadowed, 0, sizeof(shadowed));
+
+	glyph = gfx_font_first_glyph(font);
+	while (glyph != NULL) {
+		pat = gfx_glyph_first_pattern(glyph);
+		while (pat != NULL) {
+			off = 0;
+			c = str_decode(pat->text, &off, STR_NO_LIMIT);
+			if (c > 0 && c < GFX_FONT_GCACHE_SIZE) {
+				if (pat->text[off] != '\0') {
+					/* Longer pattern starting with @a c */
+					shadowed[c] = true;
+					font->gcache[c] = NULL;
+				} else if (!shadowed[c] &&
+				    font->gcache[c] == NULL) {
+					font->gcache[c] = glyph;
+				}
+			}
+
+			pat = gfx_glyph_next_pattern(pat);
+		}
+
+		glyph = gfx_font_next_glyph(glyph);
+	}
+
+	font->gcache_valid = true;
+}
+
 /** Search for glyph that should be set for the beginning of a string.
  *
  * @param font Font
@@ -346,6 +405,20 @@ errno_t gfx_font_search_glyph(gfx_font_t *font, const char *str,
 {
 	gfx_glyph_t *glyph;
 	size_t msize;
+	size_t off;
+	char32_t c;
+
+	if (!font->gcache_valid)
+		gfx_font_gcache_build(font);
+
+	/* Try the glyph lookup cache first */
+	off = 0;
+	c = str_decode(str, &off, STR_NO_LIMIT);
+	if (c > 0 && c < GFX_FONT_GCACHE_SIZE && font->gcache[c] != NULL) {
+		*rglyph = font->gcache[c];
+		*rsize = off;
+		return EOK;
+	}
 
 	glyph = gfx_font_first_glyph(font);
 	while (glyph != NULL) {
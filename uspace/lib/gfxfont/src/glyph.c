@@ -117,6 +117,7 @@ errno_t gfx_glyph_create(gfx_font_t *font, gfx_glyph_metrics_t *metrics,
  */
 void gfx_glyph_destroy(gfx_glyph_t *glyph)
 {
+	gfx_font_gcache_invalidate(glyph->font);
 	list_remove(&glyph->lglyphs);
 	free(glyph);
 }
@@ -179,6 +180,7 @@ errno_t gfx_glyph_set_pattern(gfx_glyph_t *glyph, const char *pattern)
 	}
 
 	list_append(&pat->lpatterns, &glyph->patterns);
+	gfx_font_gcache_invalidate(glyph->font);
 	return EOK;
 }
 
@@ -199,6 +201,7 @@ void gfx_glyph_clear_pattern(gfx_glyph_t *glyph, const char *pattern)
 			list_remove(&pat->lpatterns);
 			free(pat->text);
 			free(pat);
+			gfx_font_gcache_invalidate(glyph->font);
 			return;
 		}
 
@@ -450,6 +450,85 @@ PCUT_TEST(search_glyph)
 	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
 }
 
+/** Test gfx_font_search_glyph() returns correct glyphs as patterns change */
+PCUT_TEST(search_glyph_patterns)
+{
+	gfx_font_props_t props;
+	gfx_font_metrics_t metrics;
+	gfx_glyph_metrics_t gmetrics;
+	gfx_typeface_t *tface;
+	gfx_font_t *font;
+	gfx_context_t *gc;
+	gfx_glyph_t *glyph1;
+	gfx_glyph_t *glyph2;
+	gfx_glyph_t *glyph;
+	size_t bytes;
+	test_gc_t tgc;
+	errno_t rc;
+
+	rc = gfx_context_new(&test_ops, (void *)&tgc, &gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_typeface_create(gc, &tface);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gfx_font_props_init(&props);
+	gfx_font_metrics_init(&metrics);
+	rc = gfx_font_create(tface, &props, &metrics, &font);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gfx_glyph_metrics_init(&gmetrics);
+
+	rc = gfx_glyph_create(font, &gmetrics, &glyph1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_create(font, &gmetrics, &glyph2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_set_pattern(glyph1, "AB");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_glyph_set_pattern(glyph2, "A");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Longer pattern of an earlier glyph must win */
+	rc = gfx_font_search_glyph(font, "ABC", &glyph, &bytes);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(glyph1, glyph);
+	PCUT_ASSERT_INT_EQUALS(2, bytes);
+
+	rc = gfx_font_search_glyph(font, "AX", &glyph, &bytes);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(glyph2, glyph);
+	PCUT_ASSERT_INT_EQUALS(1, bytes);
+
+	/* Repeated search must give the same results */
+	rc = gfx_font_search_glyph(font, "AX", &glyph, &bytes);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(glyph2, glyph);
+	PCUT_ASSERT_INT_EQUALS(1, bytes);
+
+	/* Changing patterns must be reflected in further searches */
+	gfx_glyph_clear_pattern(glyph1, "AB");
+	rc = gfx_glyph_set_pattern(glyph1, "B");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_font_search_glyph(font, "ABC", &glyph, &bytes);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(glyph2, glyph);
+	PCUT_ASSERT_INT_EQUALS(1, bytes);
+
+	rc = gfx_font_search_glyph(font, "BC", &glyph, &bytes);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(glyph1, glyph);
+	PCUT_ASSERT_INT_EQUALS(1, bytes);
+
+	gfx_font_close(font);
+	gfx_typeface_destroy(tface);
+	rc = gfx_context_delete(gc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
 /** Test gfx_font_splice_at_glyph() */
 PCUT_TEST(splice_at_glyph)
 {
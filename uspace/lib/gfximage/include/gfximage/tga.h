@@ -45,6 +45,8 @@
 
 extern errno_t decode_tga(gfx_context_t *, void *, size_t,
     gfx_bitmap_t **, gfx_rect_t *);
+extern errno_t decode_tga_scaled(gfx_context_t *, void *, size_t,
+    gfx_coord2_t *, gfx_bitmap_t **, gfx_rect_t *);
 
 #endif
 
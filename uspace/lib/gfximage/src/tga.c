@@ -36,6 +36,7 @@
 
 #include <stdlib.h>
 #include <byteorder.h>
+#include <mem.h>
 #include <align.h>
 #include <stdbool.h>
 #include <pixconv.h>
@@ -163,23 +164,44 @@ static bool decode_tga_header(void *data, size_t size, tga_t *tga)
 	return true;
 }
 
-/** Decode Truevision TGA format
+/** Emit one destination row of box-filtered pixels. */
+static void tga_flush_row(pixelmap_t *pixelmap, uint32_t *acc, uint32_t *cnt,
+    sysarg_t out_w, sysarg_t out_y)
+{
+	for (sysarg_t x = 0; x < out_w; x++) {
+		if (cnt[x] == 0)
+			continue;
+
+		pixel_t pixel = PIXEL(0, acc[3 * x] / cnt[x],
+		    acc[3 * x + 1] / cnt[x], acc[3 * x + 2] / cnt[x]);
+		pixelmap_put_pixel(pixelmap, x, out_y, pixel);
+	}
+}
+
+/** Decode Truevision TGA format with decode-time downscaling
  *
  * Decode Truevision TGA format and create a surface
  * from it. The supported variants of TGA are currently
  * limited to uncompressed 24 bit true-color images without
  * alpha channel.
  *
- * @param gc      Graphic context
- * @param data    Memory representation of gzipped TGA.
- * @param size    Size of the representation (in bytes).
- * @param rbitmap Place to store pointer to new bitmap
- * @param rrect   Place to store bitmap rectangle
+ * If @a max_dims is not NULL, the image is downscaled while the source
+ * rows stream through the decoder so that the resulting bitmap does not
+ * exceed the given dimensions. Pixels are reduced with an integer-factor
+ * box filter (averaging), so a full-size intermediate bitmap is never
+ * allocated.
+ *
+ * @param gc       Graphic context
+ * @param data     Memory representation of TGA.
+ * @param size     Size of the representation (in bytes).
+ * @param max_dims Maximum bitmap dimensions or @c NULL for 1:1 decoding
+ * @param rbitmap  Place to store pointer to new bitmap
+ * @param rrect    Place to store bitmap rectangle
  *
  * @return EOK un success or an error code
  */
-errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
-    gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
+errno_t decode_tga_scaled(gfx_context_t *gc, void *data, size_t size,
+    gfx_coord2_t *max_dims, gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
 {
 	gfx_bitmap_params_t params;
 	gfx_bitmap_alloc_t alloc;
@@ -223,9 +245,20 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 	sysarg_t twidth = tga.startx + tga.width;
 	sysarg_t theight = tga.starty + tga.height;
 
+	/* Integer reduction factor for decode-time box filtering */
+	sysarg_t factor = 1;
+	if (max_dims != NULL && max_dims->x > 0 && max_dims->y > 0) {
+		while (twidth / factor > (sysarg_t) max_dims->x ||
+		    theight / factor > (sysarg_t) max_dims->y)
+			factor++;
+	}
+
+	sysarg_t out_w = (twidth + factor - 1) / factor;
+	sysarg_t out_h = (theight + factor - 1) / factor;
+
 	gfx_bitmap_params_init(&params);
-	params.rect.p1.x = twidth;
-	params.rect.p1.y = theight;
+	params.rect.p1.x = out_w;
+	params.rect.p1.y = out_h;
 
 	rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
 	if (rc != EOK)
@@ -237,8 +270,8 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 		return rc;
 	}
 
-	pixelmap.width = twidth;
-	pixelmap.height = theight;
+	pixelmap.width = out_w;
+	pixelmap.height = out_h;
 	pixelmap.data = alloc.pixels;
 
 	/*
@@ -246,39 +279,122 @@ errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
 	 * variant is in BGR 8:8:8 encoding.
 	 */
 
-	switch (tga.img_type) {
-	case IMG_BGRA:
-		for (sysarg_t y = tga.starty; y < theight; y++) {
-			for (sysarg_t x = tga.startx; x < twidth; x++) {
-				size_t offset =
-				    ((y - tga.starty) * tga.width + (x - tga.startx)) * 3;
-
-				pixel_t pixel =
-				    bgr_888_2pixel(((uint8_t *) tga.img_data) + offset);
-				pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+	if (factor == 1) {
+		switch (tga.img_type) {
+		case IMG_BGRA:
+			for (sysarg_t y = tga.starty; y < theight; y++) {
+				for (sysarg_t x = tga.startx; x < twidth; x++) {
+					size_t offset =
+					    ((y - tga.starty) * tga.width + (x - tga.startx)) * 3;
+
+					pixel_t pixel =
+					    bgr_888_2pixel(((uint8_t *) tga.img_data) + offset);
+					pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+				}
+			}
+			break;
+		case IMG_GRAY:
+			for (sysarg_t y = tga.starty; y < theight; y++) {
+				for (sysarg_t x = tga.startx; x < twidth; x++) {
+					size_t offset =
+					    (y - tga.starty) * tga.width + (x - tga.startx);
+
+					pixel_t pixel =
+					    gray_8_2pixel(((uint8_t *) tga.img_data) + offset);
+					pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+				}
 			}
+			break;
+		default:
+			break;
 		}
-		break;
-	case IMG_GRAY:
-		for (sysarg_t y = tga.starty; y < theight; y++) {
-			for (sysarg_t x = tga.startx; x < twidth; x++) {
-				size_t offset =
-				    (y - tga.starty) * tga.width + (x - tga.startx);
-
-				pixel_t pixel =
-				    gray_8_2pixel(((uint8_t *) tga.img_data) + offset);
-				pixelmap_put_pixel(&pixelmap, x, theight - y - 1, pixel);
+
+		*rbitmap = bitmap;
+		*rrect = params.rect;
+		return EOK;
+	}
+
+	/*
+	 * Downscaled decoding. Source rows stream through per-column
+	 * accumulators; runs of source rows that land on the same
+	 * destination row are averaged and emitted as one row.
+	 */
+	size_t bpp = (tga.img_type == IMG_BGRA) ? 3 : 1;
+
+	uint32_t *acc = calloc(out_w, 3 * sizeof(uint32_t));
+	uint32_t *cnt = calloc(out_w, sizeof(uint32_t));
+	if (acc == NULL || cnt == NULL) {
+		free(acc);
+		free(cnt);
+		gfx_bitmap_destroy(bitmap);
+		return ENOMEM;
+	}
+
+	sysarg_t cur_out_y = (sysarg_t) -1;
+	for (sysarg_t r = 0; r < tga.height; r++) {
+		/* Bitmap row this source row lands on (bottom-up storage) */
+		sysarg_t y = theight - (tga.starty + r) - 1;
+		sysarg_t out_y = y / factor;
+
+		if (out_y != cur_out_y) {
+			if (cur_out_y != (sysarg_t) -1) {
+				tga_flush_row(&pixelmap, acc, cnt, out_w,
+				    cur_out_y);
+				memset(acc, 0, out_w * 3 * sizeof(uint32_t));
+				memset(cnt, 0, out_w * sizeof(uint32_t));
 			}
+
+			cur_out_y = out_y;
+		}
+
+		const uint8_t *row = (uint8_t *) tga.img_data +
+		    (size_t) r * tga.width * bpp;
+
+		for (sysarg_t x = 0; x < tga.width; x++) {
+			sysarg_t out_x = (tga.startx + x) / factor;
+
+			if (bpp == 3) {
+				acc[3 * out_x] += row[x * 3 + 2];
+				acc[3 * out_x + 1] += row[x * 3 + 1];
+				acc[3 * out_x + 2] += row[x * 3];
+			} else {
+				acc[3 * out_x] += row[x];
+				acc[3 * out_x + 1] += row[x];
+				acc[3 * out_x + 2] += row[x];
+			}
+
+			cnt[out_x]++;
 		}
-		break;
-	default:
-		break;
 	}
 
+	if (cur_out_y != (sysarg_t) -1)
+		tga_flush_row(&pixelmap, acc, cnt, out_w, cur_out_y);
+
+	free(acc);
+	free(cnt);
+
 	*rbitmap = bitmap;
 	*rrect = params.rect;
 	return EOK;
 }
 
+/** Decode Truevision TGA format
+ *
+ * Decode the image at its full (1:1) size. See decode_tga_scaled().
+ *
+ * @param gc      Graphic context
+ * @param data    Memory representation of TGA.
+ * @param size    Size of the representation (in bytes).
+ * @param rbitmap Place to store pointer to new bitmap
+ * @param rrect   Place to store bitmap rectangle
+ *
+ * @return EOK un success or an error code
+ */
+errno_t decode_tga(gfx_context_t *gc, void *data, size_t size,
+    gfx_bitmap_t **rbitmap, gfx_rect_t *rrect)
+{
+	return decode_tga_scaled(gc, data, size, NULL, rbitmap, rrect);
+}
+
 /** @}
  */
@@ -38,7 +38,12 @@
 
 #include <async.h>
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
 #include <pcm/format.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 
 extern const char *HOUND_SERVICE;
 
@@ -59,6 +64,81 @@ typedef async_sess_t hound_sess_t;
 typedef struct {
 } *hound_context_id_t;
 
+/** Shared stream ring buffer.
+ *
+ * Single producer, single consumer byte ring placed in a memory area
+ * shared between the client and the server. Head and tail are free
+ * running counters, the data area size must be a power of two.
+ */
+typedef struct {
+	/** Size of the data area in bytes, must be a power of two */
+	size_t size;
+	/** Write position, modified only by the producer */
+	atomic_size_t head;
+	/** Read position, modified only by the consumer */
+	atomic_size_t tail;
+	/** Sample data */
+	uint8_t data[];
+} hound_stream_ring_t;
+
+/**
+ * Count bytes stored in a stream ring buffer.
+ * @param ring The ring buffer.
+ * @return Number of bytes available for reading.
+ */
+static inline size_t hound_stream_ring_bytes(hound_stream_ring_t *ring)
+{
+	return atomic_load(&ring->head) - atomic_load(&ring->tail);
+}
+
+/**
+ * Store data in a stream ring buffer. Producer side only.
+ * @param ring The ring buffer.
+ * @param rsize Size of the ring data area. Passed by the caller so that
+ *              the shared header does not need to be trusted.
+ * @param data Data to store.
+ * @param size Size of the @p data buffer.
+ * @return Number of bytes actually stored.
+ */
+static inline size_t hound_stream_ring_write(hound_stream_ring_t *ring,
+    size_t rsize, const void *data, size_t size)
+{
+	const size_t head = atomic_load(&ring->head);
+	const size_t used = head - atomic_load(&ring->tail);
+	if (used >= rsize)
+		return 0;
+	const size_t copy = min(size, rsize - used);
+	const size_t pos = head & (rsize - 1);
+	const size_t seg = min(copy, rsize - pos);
+	memcpy(ring->data + pos, data, seg);
+	memcpy(ring->data, (const uint8_t *)data + seg, copy - seg);
+	atomic_store(&ring->head, head + copy);
+	return copy;
+}
+
+/**
+ * Retrieve data from a stream ring buffer. Consumer side only.
+ * @param ring The ring buffer.
+ * @param rsize Size of the ring data area. Passed by the caller so that
+ *              the shared header does not need to be trusted.
+ * @param data Destination buffer.
+ * @param size Size of the @p data buffer.
+ * @return Number of bytes actually retrieved.
+ */
+static inline size_t hound_stream_ring_read(hound_stream_ring_t *ring,
+    size_t rsize, void *data, size_t size)
+{
+	const size_t tail = atomic_load(&ring->tail);
+	const size_t used = atomic_load(&ring->head) - tail;
+	const size_t copy = min(size, min(used, rsize));
+	const size_t pos = tail & (rsize - 1);
+	const size_t seg = min(copy, rsize - pos);
+	memcpy(data, ring->data + pos, seg);
+	memcpy((uint8_t *)data + seg, ring->data, copy - seg);
+	atomic_store(&ring->tail, tail + copy);
+	return copy;
+}
+
 hound_sess_t *hound_service_connect(const char *service);
 void hound_service_disconnect(hound_sess_t *sess);
 
@@ -96,6 +176,10 @@ errno_t hound_service_stream_exit(async_exch_t *exch);
 errno_t hound_service_stream_write(async_exch_t *exch, const void *data, size_t size);
 errno_t hound_service_stream_read(async_exch_t *exch, void *data, size_t size);
 
+errno_t hound_service_stream_ring_share(async_exch_t *exch,
+    hound_stream_ring_t *ring);
+errno_t hound_service_stream_ring_wait(async_exch_t *exch);
+
 /* Server */
 
 /** Hound server interace structure */
@@ -123,6 +207,10 @@ typedef struct hound_server_iface {
 	errno_t (*stream_data_write)(void *, void *, size_t);
 	/** Read data from the stream */
 	errno_t (*stream_data_read)(void *, void *, size_t);
+	/** Attach a shared ring buffer to the stream */
+	errno_t (*stream_ring_set)(void *, void *, size_t);
+	/** Block until the stream's ring buffer has free space */
+	errno_t (*stream_ring_wait)(void *);
 	void *server;
 } hound_server_iface_t;
 
@@ -34,9 +34,12 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <align.h>
+#include <as.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <loc.h>
+#include <mem.h>
 #include <str.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -58,6 +61,10 @@ struct hound_stream {
 	hound_context_t *context;
 	/** Stream flags */
 	int flags;
+	/** Shared ring buffer, NULL when using IPC data writes */
+	hound_stream_ring_t *ring;
+	/** Size of the ring buffer data area */
+	size_t ring_size;
 };
 
 /**
@@ -282,6 +289,41 @@ errno_t hound_context_disconnect_target(hound_context_t *hound, const char *targ
 	}
 }
 
+/**
+ * Try to establish a shared ring buffer transport for a stream.
+ * @param stream The target stream.
+ * @param bsize Requested buffering, in bytes.
+ *
+ * Failure is not fatal, the stream simply keeps pushing data through
+ * IPC data writes.
+ */
+static void hound_stream_ring_setup(hound_stream_t *stream, size_t bsize)
+{
+	/* The data area must be a power of two */
+	size_t data_size = PAGE_SIZE;
+	while (data_size < bsize)
+		data_size *= 2;
+
+	const size_t area_size = ALIGN_UP(
+	    offsetof(hound_stream_ring_t, data) + data_size, PAGE_SIZE);
+
+	hound_stream_ring_t *ring = as_area_create(AS_AREA_ANY, area_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring == AS_MAP_FAILED)
+		return;
+
+	memset(ring, 0, sizeof(hound_stream_ring_t));
+	ring->size = data_size;
+
+	const errno_t ret = hound_service_stream_ring_share(stream->exch, ring);
+	if (ret != EOK) {
+		as_area_destroy(ring);
+		return;
+	}
+	stream->ring = ring;
+	stream->ring_size = data_size;
+}
+
 /**
  * Create a new stream associated with the context.
  * @param hound Hound context.
@@ -304,6 +346,8 @@ hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
 		new_stream->format = format;
 		new_stream->context = hound;
 		new_stream->flags = flags;
+		new_stream->ring = NULL;
+		new_stream->ring_size = 0;
 		const errno_t ret = hound_service_stream_enter(new_stream->exch,
 		    hound->id, flags, format, bsize);
 		if (ret != EOK) {
@@ -311,6 +355,9 @@ hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
 			free(new_stream);
 			return NULL;
 		}
+		/* Data writes of record streams are served by the client */
+		if (!hound->record)
+			hound_stream_ring_setup(new_stream, bsize);
 		list_append(&new_stream->link, &hound->stream_list);
 	}
 	return new_stream;
@@ -330,6 +377,8 @@ void hound_stream_destroy(hound_stream_t *stream)
 			hound_service_stream_drain(stream->exch);
 		hound_service_stream_exit(stream->exch);
 		async_exchange_end(stream->exch);
+		if (stream->ring)
+			as_area_destroy(stream->ring);
 		list_remove(&stream->link);
 		free(stream);
 	}
@@ -347,6 +396,24 @@ errno_t hound_stream_write(hound_stream_t *stream, const void *data, size_t size
 	assert(stream);
 	if (!data || size == 0)
 		return EBADMEM;
+	if (stream->ring) {
+		const uint8_t *pos = data;
+		size_t remain = size;
+		while (remain > 0) {
+			const size_t written = hound_stream_ring_write(
+			    stream->ring, stream->ring_size, pos, remain);
+			pos += written;
+			remain -= written;
+			if (remain > 0) {
+				/* Ring full, wait for the mixer to catch up */
+				const errno_t ret =
+				    hound_service_stream_ring_wait(stream->exch);
+				if (ret != EOK)
+					return ret;
+			}
+		}
+		return EOK;
+	}
 	return hound_service_stream_write(stream->exch, data, size);
 }
 
@@ -34,6 +34,7 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <as.h>
 #include <errno.h>
 #include <loc.h>
 #include <macros.h>
@@ -64,6 +65,10 @@ enum ipc_methods {
 	IPC_M_HOUND_STREAM_EXIT,
 	/** Wait until there is no data in the stream */
 	IPC_M_HOUND_STREAM_DRAIN,
+	/** Share a ring buffer with the server */
+	IPC_M_HOUND_STREAM_RING,
+	/** Wait until there is free space in the stream ring buffer */
+	IPC_M_HOUND_STREAM_RING_WAIT,
 };
 
 /** PCM format conversion helper structure */
@@ -362,6 +367,41 @@ errno_t hound_service_stream_read(async_exch_t *exch, void *data, size_t size)
 	return async_data_read_start(exch, data, size);
 }
 
+/**
+ * Share a stream ring buffer with the server.
+ * @param exch IPC exchange in STREAM MODE.
+ * @param ring Initialized ring buffer in a shareable memory area.
+ * @return Error code.
+ *
+ * The server may refuse the ring with ENOTSUP, in which case the stream
+ * keeps using data writes.
+ */
+errno_t hound_service_stream_ring_share(async_exch_t *exch,
+    hound_stream_ring_t *ring)
+{
+	ipc_call_t call;
+	aid_t mid = async_send_0(exch, IPC_M_HOUND_STREAM_RING, &call);
+	if (!mid)
+		return EPARTY;
+	const errno_t rc = async_share_out_start(exch, ring,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	errno_t ret;
+	async_wait_for(mid, &ret);
+	if (rc != EOK)
+		return rc;
+	return ret;
+}
+
+/**
+ * Wait until the stream ring buffer has free space.
+ * @param exch IPC exchange in STREAM MODE.
+ * @return Error code.
+ */
+errno_t hound_service_stream_ring_wait(async_exch_t *exch)
+{
+	return async_req_0_0(exch, IPC_M_HOUND_STREAM_RING_WAIT);
+}
+
 /*
  * SERVER
  */
@@ -610,6 +650,8 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 			break;
 		case IPC_M_HOUND_STREAM_EXIT:
 		case IPC_M_HOUND_STREAM_DRAIN:
+		case IPC_M_HOUND_STREAM_RING:
+		case IPC_M_HOUND_STREAM_RING_WAIT:
 			/* Stream exit/drain is only allowed in stream context */
 			async_answer_0(&call, EINVAL);
 			break;
@@ -627,6 +669,37 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 	}
 }
 
+/**
+ * Accept a shared ring buffer offered by the client.
+ * @param call The IPC_M_HOUND_STREAM_RING call to answer.
+ * @param stream Target stream.
+ */
+static void hound_server_stream_ring(ipc_call_t *call, void *stream)
+{
+	ipc_call_t share;
+	size_t size = 0;
+	unsigned int flags = 0;
+
+	if (!server_iface->stream_ring_set) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+	if (!async_share_out_receive(&share, &size, &flags)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+	void *ring = NULL;
+	errno_t ret = async_share_out_finalize(&share, &ring);
+	if (ret != EOK || ring == AS_MAP_FAILED) {
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+	ret = server_iface->stream_ring_set(stream, ring, size);
+	if (ret != EOK)
+		as_area_destroy(ring);
+	async_answer_0(call, ret);
+}
+
 /**
  * Read data and push it to the stream.
  * @param stream target stream, will push data there.
@@ -637,10 +710,29 @@ static void hound_server_read_data(void *stream)
 	size_t size = 0;
 	errno_t ret_answer = EOK;
 
-	/* accept data write or drain */
-	while (async_data_write_receive(&call, &size) ||
-	    (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_DRAIN)) {
-		/* check drain first */
+	/* accept data write, ring setup or drain */
+	while (true) {
+		if (async_data_write_receive(&call, &size)) {
+			/* there was an error last time */
+			if (ret_answer != EOK) {
+				async_answer_0(&call, ret_answer);
+				continue;
+			}
+
+			char *buffer = malloc(size);
+			if (!buffer) {
+				async_answer_0(&call, ENOMEM);
+				continue;
+			}
+			const errno_t ret =
+			    async_data_write_finalize(&call, buffer, size);
+			if (ret == EOK) {
+				/* push data to stream */
+				ret_answer = server_iface->stream_data_write(
+				    stream, buffer, size);
+			}
+			continue;
+		}
 		if (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_DRAIN) {
 			errno_t ret = ENOTSUP;
 			if (server_iface->drain_stream)
@@ -648,24 +740,18 @@ static void hound_server_read_data(void *stream)
 			async_answer_0(&call, ret);
 			continue;
 		}
-
-		/* there was an error last time */
-		if (ret_answer != EOK) {
-			async_answer_0(&call, ret_answer);
+		if (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_RING) {
+			hound_server_stream_ring(&call, stream);
 			continue;
 		}
-
-		char *buffer = malloc(size);
-		if (!buffer) {
-			async_answer_0(&call, ENOMEM);
+		if (ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_RING_WAIT) {
+			errno_t ret = ENOTSUP;
+			if (server_iface->stream_ring_wait)
+				ret = server_iface->stream_ring_wait(stream);
+			async_answer_0(&call, ret);
 			continue;
 		}
-		const errno_t ret = async_data_write_finalize(&call, buffer, size);
-		if (ret == EOK) {
-			/* push data to stream */
-			ret_answer = server_iface->stream_data_write(
-			    stream, buffer, size);
-		}
+		break;
 	}
 	const errno_t ret = ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_EXIT ?
 	    EOK : EINVAL;
@@ -126,6 +126,7 @@ extern http_request_t *http_request_create(const char *, const char *);
 extern void http_request_destroy(http_request_t *);
 extern errno_t http_request_format(http_request_t *, char **, size_t *);
 extern errno_t http_send_request(http_t *, http_request_t *);
+extern errno_t http_send_requests(http_t *, http_request_t **, size_t);
 extern errno_t http_receive_status(receive_buffer_t *, http_version_t *, uint16_t *,
     char **);
 extern errno_t http_receive_response(receive_buffer_t *, http_response_t **,
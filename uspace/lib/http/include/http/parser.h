@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup http
+ * @{
+ */
+/**
+ * @file Incremental in-place HTTP response parser
+ */
+
+#ifndef HTTP_PARSER_H_
+#define HTTP_PARSER_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "http.h"
+
+/** View into an externally owned buffer (not null-terminated) */
+typedef struct {
+	const char *ptr;
+	size_t len;
+} http_str_t;
+
+/** Parsed header field (views into the parse buffer) */
+typedef struct {
+	http_str_t name;
+	http_str_t value;
+} http_header_view_t;
+
+/** Incremental HTTP response parser
+ *
+ * Parses a response message head in place, without copying the
+ * data or allocating a string per header. All views point into the
+ * buffer passed to http_response_parser_parse() and are only valid
+ * as long as that buffer is.
+ */
+typedef struct {
+	/** Header view pool (allocated once, reused across responses) */
+	http_header_view_t *headers;
+	/** Pool capacity */
+	size_t max_headers;
+	/** Number of parsed headers */
+	size_t nheaders;
+
+	/** Protocol version */
+	http_version_t version;
+	/** Status code */
+	uint16_t status;
+	/** Reason phrase */
+	http_str_t message;
+
+	/** Number of bytes already scanned for the end of the head */
+	size_t scanned;
+	/** Size of the complete message head (zero until found) */
+	size_t head_size;
+} http_response_parser_t;
+
+extern errno_t http_response_parser_init(http_response_parser_t *, size_t);
+extern void http_response_parser_fini(http_response_parser_t *);
+extern void http_response_parser_reset(http_response_parser_t *);
+extern errno_t http_response_parser_parse(http_response_parser_t *,
+    const void *, size_t, bool *);
+extern errno_t http_response_parser_get_header(http_response_parser_t *,
+    const char *, http_str_t *);
+extern bool http_str_cmp(http_str_t *, const char *);
+
+#endif
+
+/** @}
+ */
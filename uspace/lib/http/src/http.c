@@ -56,7 +56,7 @@ static errno_t http_receive(void *client_data, void *buf, size_t buf_size,
 
 http_t *http_create(const char *host, uint16_t port)
 {
-	http_t *http = malloc(sizeof(http_t));
+	http_t *http = calloc(1, sizeof(http_t));
 	if (http == NULL)
 		return NULL;
 
@@ -67,7 +67,11 @@ http_t *http_create(const char *host, uint16_t port)
 	}
 	http->port = port;
 
-	http->buffer_size = 4096;
+	/*
+	 * Large enough to pull a full TCP window's worth of data out of
+	 * the connection in one go when streaming a response body.
+	 */
+	http->buffer_size = 65536;
 	errno_t rc = recv_buffer_init(&http->recv_buffer, http->buffer_size,
 	    http_receive, http);
 	if (rc != EOK) {
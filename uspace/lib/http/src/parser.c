@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup http
+ * @{
+ */
+/**
+ * @file
+ *
+ * Incremental in-place HTTP response parser. Unlike the receive
+ * buffer based routines in response.c and headers.c, the parser
+ * scans a caller-owned buffer for a complete message head and then
+ * parses it in place, returning views into the buffer instead of
+ * allocating a string per header. Scanning is incremental: each
+ * call resumes where the previous one left off, so feeding the
+ * parser as data arrives does not rescan old data.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <http/ctype.h>
+#include <http/parser.h>
+
+/** Initialize response parser
+ *
+ * @param parser      Parser to initialize.
+ * @param max_headers Capacity of the header view pool.
+ *
+ * @return EOK on success, ENOMEM on failure to allocate the pool.
+ *
+ */
+errno_t http_response_parser_init(http_response_parser_t *parser,
+    size_t max_headers)
+{
+	parser->headers = calloc(max_headers, sizeof(http_header_view_t));
+	if (parser->headers == NULL)
+		return ENOMEM;
+
+	parser->max_headers = max_headers;
+	http_response_parser_reset(parser);
+	return EOK;
+}
+
+/** Finalize response parser
+ *
+ */
+void http_response_parser_fini(http_response_parser_t *parser)
+{
+	free(parser->headers);
+	parser->headers = NULL;
+}
+
+/** Reset response parser for parsing the next response
+ *
+ * The header view pool is retained, so parsing responses back to
+ * back (e.g. off a pipelined connection) does not allocate.
+ *
+ */
+void http_response_parser_reset(http_response_parser_t *parser)
+{
+	parser->nheaders = 0;
+	parser->status = 0;
+	parser->message.ptr = NULL;
+	parser->message.len = 0;
+	parser->scanned = 0;
+	parser->head_size = 0;
+}
+
+/** Parse an unsigned decimal number in place
+ *
+ * @return EOK on success, HTTP_EPARSE if no digit is present or
+ *         the value does not fit in uint16_t.
+ *
+ */
+static errno_t parse_uint16(const char *data, size_t size, size_t *pos,
+    uint16_t *out_value)
+{
+	uint32_t value = 0;
+	size_t start = *pos;
+
+	while (*pos < size && data[*pos] >= '0' && data[*pos] <= '9') {
+		value = value * 10 + (data[*pos] - '0');
+		if (value > UINT16_MAX)
+			return HTTP_EPARSE;
+		(*pos)++;
+	}
+
+	if (*pos == start)
+		return HTTP_EPARSE;
+
+	*out_value = (uint16_t) value;
+	return EOK;
+}
+
+/** Consume an end of line (CR, LF, CRLF or LFCR)
+ *
+ */
+static void parse_eol(const char *data, size_t size, size_t *pos)
+{
+	if (*pos < size && data[*pos] == '\r') {
+		(*pos)++;
+		if (*pos < size && data[*pos] == '\n')
+			(*pos)++;
+	} else if (*pos < size && data[*pos] == '\n') {
+		(*pos)++;
+		if (*pos < size && data[*pos] == '\r')
+			(*pos)++;
+	}
+}
+
+/** Parse a complete message head in place
+ *
+ * @param parser Response parser.
+ * @param data   Buffer holding at least parser->head_size bytes.
+ *
+ * @return EOK on success, HTTP_EPARSE on malformed input,
+ *         ELIMIT if the header view pool is exhausted.
+ *
+ */
+static errno_t http_response_parser_head(http_response_parser_t *parser,
+    const char *data)
+{
+	size_t size = parser->head_size;
+	size_t pos = 0;
+	errno_t rc;
+
+	/* Status line */
+
+	static const char prefix[] = "HTTP/";
+	for (size_t i = 0; prefix[i] != 0; i++) {
+		if (pos >= size || data[pos] != prefix[i])
+			return HTTP_EPARSE;
+		pos++;
+	}
+
+	uint16_t num;
+	rc = parse_uint16(data, size, &pos, &num);
+	if (rc != EOK || num > UINT8_MAX)
+		return HTTP_EPARSE;
+	parser->version.major = (uint8_t) num;
+
+	if (pos >= size || data[pos] != '.')
+		return HTTP_EPARSE;
+	pos++;
+
+	rc = parse_uint16(data, size, &pos, &num);
+	if (rc != EOK || num > UINT8_MAX)
+		return HTTP_EPARSE;
+	parser->version.minor = (uint8_t) num;
+
+	if (pos >= size || data[pos] != ' ')
+		return HTTP_EPARSE;
+	pos++;
+
+	rc = parse_uint16(data, size, &pos, &parser->status);
+	if (rc != EOK)
+		return rc;
+
+	while (pos < size && data[pos] == ' ')
+		pos++;
+
+	parser->message.ptr = data + pos;
+	while (pos < size && data[pos] != '\r' && data[pos] != '\n')
+		pos++;
+	parser->message.len = (data + pos) - parser->message.ptr;
+
+	parse_eol(data, size, &pos);
+
+	/* Header fields */
+
+	while (pos < size && data[pos] != '\r' && data[pos] != '\n') {
+		http_str_t name;
+		http_str_t value;
+
+		name.ptr = data + pos;
+		while (pos < size && is_token(data[pos]))
+			pos++;
+		name.len = (data + pos) - name.ptr;
+
+		if (name.len == 0 || pos >= size || data[pos] != ':')
+			return HTTP_EPARSE;
+		pos++;
+
+		while (pos < size && is_lws(data[pos]))
+			pos++;
+
+		value.ptr = data + pos;
+		while (pos < size && data[pos] != '\r' && data[pos] != '\n')
+			pos++;
+		value.len = (data + pos) - value.ptr;
+
+		parse_eol(data, size, &pos);
+
+		/*
+		 * A continuation line extends the value view, including
+		 * the embedded line break and leading whitespace.
+		 */
+		while (pos < size && (data[pos] == ' ' || data[pos] == '\t')) {
+			while (pos < size && data[pos] != '\r' &&
+			    data[pos] != '\n')
+				pos++;
+			value.len = (data + pos) - value.ptr;
+			parse_eol(data, size, &pos);
+		}
+
+		/* Trim trailing whitespace */
+		while (value.len > 0 && is_lws(value.ptr[value.len - 1]))
+			value.len--;
+
+		if (parser->nheaders >= parser->max_headers)
+			return ELIMIT;
+
+		parser->headers[parser->nheaders].name = name;
+		parser->headers[parser->nheaders].value = value;
+		parser->nheaders++;
+	}
+
+	return EOK;
+}
+
+/** Feed data to the response parser
+ *
+ * @a data must always contain the response from its first byte;
+ * between calls the buffer may only grow (the parser remembers how
+ * far it has scanned). Once @a *complete is true, the parsed fields
+ * are valid, parser->head_size gives the size of the message head
+ * (what follows is the message body) and further calls are no-ops
+ * until http_response_parser_reset().
+ *
+ * @param parser   Response parser.
+ * @param data     Buffer holding the response head (or a prefix).
+ * @param size     Number of valid bytes in @a data.
+ * @param complete Place to store whether a complete head was parsed.
+ *
+ * @return EOK on success (including incomplete input).
+ * @return HTTP_EPARSE on malformed input.
+ * @return ELIMIT if the header view pool is exhausted.
+ *
+ */
+errno_t http_response_parser_parse(http_response_parser_t *parser,
+    const void *data, size_t size, bool *complete)
+{
+	const char *d = (const char *) data;
+
+	if (parser->head_size == 0) {
+		/* Look for the empty line ending the head */
+		size_t i = parser->scanned;
+
+		while (i < size) {
+			if (d[i] == '\n' && i >= 1 &&
+			    (d[i - 1] == '\n' ||
+			    (i >= 2 && d[i - 1] == '\r' && d[i - 2] == '\n'))) {
+				parser->head_size = i + 1;
+				break;
+			}
+			i++;
+		}
+
+		if (parser->head_size == 0) {
+			/* Keep enough lookback to match a split CRLFCRLF */
+			parser->scanned = (size > 2) ? size - 2 : 0;
+			*complete = false;
+			return EOK;
+		}
+
+		errno_t rc = http_response_parser_head(parser, d);
+		if (rc != EOK) {
+			parser->head_size = 0;
+			return rc;
+		}
+	}
+
+	*complete = true;
+	return EOK;
+}
+
+/** Compare a string view with a header name
+ *
+ * @return @c true if @a str matches @a name (ASCII case-insensitive).
+ *
+ */
+bool http_str_cmp(http_str_t *str, const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < str->len; i++) {
+		if (name[i] == 0)
+			return false;
+
+		char a = str->ptr[i];
+		char b = name[i];
+
+		if (a >= 'A' && a <= 'Z')
+			a += 'a' - 'A';
+		if (b >= 'A' && b <= 'Z')
+			b += 'a' - 'A';
+
+		if (a != b)
+			return false;
+	}
+
+	return name[i] == 0;
+}
+
+/** Look up a header in a parsed response
+ *
+ * @param parser    Response parser holding a parsed response.
+ * @param name      Header name (ASCII case-insensitive).
+ * @param out_value Place to store the value view.
+ *
+ * @return EOK on success.
+ * @return HTTP_EMISSING_HEADER if there is no such header.
+ * @return HTTP_EMULTIPLE_HEADERS if the header occurs more than once.
+ *
+ */
+errno_t http_response_parser_get_header(http_response_parser_t *parser,
+    const char *name, http_str_t *out_value)
+{
+	http_str_t *found = NULL;
+
+	for (size_t i = 0; i < parser->nheaders; i++) {
+		if (!http_str_cmp(&parser->headers[i].name, name))
+			continue;
+
+		if (found != NULL)
+			return HTTP_EMULTIPLE_HEADERS;
+
+		found = &parser->headers[i].value;
+	}
+
+	if (found == NULL)
+		return HTTP_EMISSING_HEADER;
+
+	*out_value = *found;
+	return EOK;
+}
+
+/** @}
+ */
@@ -172,7 +172,7 @@ errno_t recv_char(receive_buffer_t *rb, char *c, bool consume)
 		if (rc != EOK)
 			return rc;
 
-		rb->in = nrecv;
+		rb->in += nrecv;
 	}
 
 	*c = rb->buffer[rb->out];
@@ -150,5 +150,52 @@ errno_t http_send_request(http_t *http, http_request_t *req)
 	return rc;
 }
 
+/** Send several requests over one connection (HTTP pipelining)
+ *
+ * All requests are formatted into a single buffer and sent with one
+ * TCP send, so the server can process the next request while earlier
+ * responses are still in flight. The caller must read the responses
+ * back to back, in request order, before sending anything else.
+ *
+ * @param http  HTTP connection.
+ * @param reqs  Array of requests.
+ * @param count Number of requests.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t http_send_requests(http_t *http, http_request_t **reqs, size_t count)
+{
+	char *buf = NULL;
+	size_t buf_size = 0;
+	errno_t rc = EOK;
+
+	for (size_t i = 0; i < count; i++) {
+		char *req_buf = NULL;
+		size_t req_size = 0;
+
+		rc = http_request_format(reqs[i], &req_buf, &req_size);
+		if (rc != EOK)
+			goto end;
+
+		char *nbuf = realloc(buf, buf_size + req_size);
+		if (nbuf == NULL) {
+			free(req_buf);
+			rc = ENOMEM;
+			goto end;
+		}
+
+		buf = nbuf;
+		memcpy(buf + buf_size, req_buf, req_size);
+		buf_size += req_size;
+		free(req_buf);
+	}
+
+	rc = tcp_conn_send(http->conn, buf, buf_size);
+end:
+	free(buf);
+	return rc;
+}
+
 /** @}
  */
@@ -62,6 +62,9 @@ typedef struct ieee80211_dev ieee80211_dev_t;
 /** Max authentication password length. */
 #define IEEE80211_MAX_PASSW_LEN  64
 
+/** Max number of data rates remembered for an AP. */
+#define IEEE80211_MAX_RATES_LENGTH  16
+
 /** IEEE 802.11 b/g supported data rates in units of 500 kb/s. */
 static const uint8_t ieee80211bg_data_rates[] = {
 	2, 4, 11, 12, 18, 22, 24, 36, 48, 72, 96, 108
@@ -181,6 +184,7 @@ extern ieee80211_operating_mode_t ieee80211_query_current_op_mode(
     ieee80211_dev_t *);
 extern uint16_t ieee80211_query_current_freq(ieee80211_dev_t *);
 extern void ieee80211_query_bssid(ieee80211_dev_t *, nic_address_t *);
+extern size_t ieee80211_query_ap_rates(ieee80211_dev_t *, uint8_t *);
 extern bool ieee80211_is_connected(ieee80211_dev_t *);
 extern void ieee80211_report_current_op_mode(ieee80211_dev_t *,
     ieee80211_operating_mode_t);
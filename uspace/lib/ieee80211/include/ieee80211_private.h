@@ -204,6 +204,8 @@ typedef struct {
 	ieee80211_scan_result_t scan_result;
 	uint8_t auth_ie[256];
 	size_t auth_ie_len;
+	uint8_t rates[IEEE80211_MAX_RATES_LENGTH];
+	size_t rates_count;
 } ieee80211_scan_result_link_t;
 
 /** List of scan results info. */
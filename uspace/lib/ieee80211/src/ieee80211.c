@@ -336,6 +336,41 @@ void ieee80211_query_bssid(ieee80211_dev_t *ieee80211_dev,
 	fibril_mutex_unlock(&ieee80211_dev->gen_mutex);
 }
 
+/** Query data rates supported by the connected AP.
+ *
+ * Returns the rate set advertised by the AP in its beacons and probe
+ * responses, for seeding hardware/firmware rate control with rates the
+ * peer actually accepts.
+ *
+ * @param ieee80211_dev IEEE 802.11 device.
+ * @param rates         Buffer for at least IEEE80211_MAX_RATES_LENGTH
+ *                      rate values (in units of 500 kb/s).
+ *
+ * @return Number of rates stored, 0 when not known.
+ *
+ */
+size_t ieee80211_query_ap_rates(ieee80211_dev_t *ieee80211_dev,
+    uint8_t *rates)
+{
+	size_t rates_count = 0;
+
+	fibril_mutex_lock(&ieee80211_dev->gen_mutex);
+
+	if (rates) {
+		ieee80211_scan_result_link_t *res_link =
+		    ieee80211_dev->bssid_info.res_link;
+
+		if (res_link) {
+			rates_count = res_link->rates_count;
+			memcpy(rates, res_link->rates, rates_count);
+		}
+	}
+
+	fibril_mutex_unlock(&ieee80211_dev->gen_mutex);
+
+	return rates_count;
+}
+
 /** Get AID of network we are connected to.
  *
  * @param ieee80211_dev IEEE 802.11 device.
@@ -1180,9 +1215,27 @@ static uint8_t *ieee80211_process_ies(ieee80211_dev_t *ieee80211_dev,
 		ieee80211_ie_header_t *ie_header =
 		    (ieee80211_ie_header_t *) it;
 		uint8_t *channel;
+		uint8_t *rates;
 		uint32_t oui;
 
 		switch (ie_header->element_id) {
+		case IEEE80211_RATES_IE:
+		case IEEE80211_EXT_RATES_IE:
+			if (!ap_data)
+				break;
+
+			rates = (uint8_t *)
+			    (it + sizeof(ieee80211_ie_header_t));
+			for (size_t i = 0; i < ie_header->length; i++) {
+				if (ap_data->rates_count ==
+				    IEEE80211_MAX_RATES_LENGTH)
+					break;
+
+				/* Strip the basic rate set flag. */
+				ap_data->rates[ap_data->rates_count++] =
+				    rates[i] & 0x7f;
+			}
+			break;
 		case IEEE80211_CHANNEL_IE:
 			if (!ap_data)
 				break;
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Internet checksum (RFC 1071)
+ */
+
+#include <byteorder.h>
+#include <inet/checksum.h>
+#include <mem.h>
+
+/** Compute Internet checksum.
+ *
+ * One's complement sum of the data interpreted as a sequence of
+ * big-endian 16-bit words, as defined by RFC 1071. The words are
+ * accumulated in host byte order 16 bytes at a time into a 64-bit
+ * sum and the result is byte-swapped at the end, which yields the
+ * same value as the word-by-word big-endian sum (the sum is
+ * byte-order independent) while letting the inner loop process
+ * whole machine words.
+ *
+ * @param ivalue Initial value (INET_CHECKSUM_INIT or a previous
+ *               partial checksum)
+ * @param data   Data to checksum
+ * @param size   Size of data in bytes
+ *
+ * @return Checksum of the data combined with the initial value
+ */
+uint16_t inet_checksum_calc(uint16_t ivalue, const void *data, size_t size)
+{
+	const uint8_t *bdata = data;
+	uint64_t sum;
+	uint64_t w0, w1;
+	uint16_t w;
+
+	/* Convert the initial value to a host byte order partial sum */
+	sum = host2uint16_t_be((uint16_t) ~ivalue);
+
+	while (size >= 16) {
+		memcpy(&w0, bdata, sizeof(w0));
+		memcpy(&w1, bdata + 8, sizeof(w1));
+
+		sum += w0;
+		if (sum < w0)
+			++sum;
+		sum += w1;
+		if (sum < w1)
+			++sum;
+
+		bdata += 16;
+		size -= 16;
+	}
+
+	while (size >= 2) {
+		memcpy(&w, bdata, sizeof(w));
+		sum += w;
+		if (sum < w)
+			++sum;
+		bdata += 2;
+		size -= 2;
+	}
+
+	if (size != 0) {
+		uint8_t tail[2] = { *bdata, 0 };
+		memcpy(&w, tail, sizeof(w));
+		sum += w;
+		if (sum < w)
+			++sum;
+	}
+
+	/* Fold the sum into 16 bits */
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~host2uint16_t_be((uint16_t) sum);
+}
+
+/** @}
+ */
@@ -47,6 +47,7 @@ typedef enum {
 	GC_BITMAP_CREATE_DOUTPUT,
 	GC_BITMAP_DESTROY,
 	GC_BITMAP_RENDER,
+	GC_BITMAP_RENDER_RECT,
 	GC_BITMAP_GET_ALLOC,
 } gc_request_t;
 
@@ -410,6 +410,20 @@ static errno_t ipc_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	/* Destination rectangle */
 	gfx_rect_translate(&offs, &srect, &drect);
 
+	if (offs.x == 0 && offs.y == 0) {
+		/*
+		 * Without an offset all the coordinates fit into the call
+		 * arguments, avoiding the data transfer round trip. This is
+		 * the common case (posting a window damage rectangle).
+		 */
+		exch = async_exchange_begin(ipcbm->ipcgc->sess);
+		rc = async_req_5_0(exch, GC_BITMAP_RENDER_RECT, ipcbm->bmp_id,
+		    srect.p0.x, srect.p0.y, srect.p1.x, srect.p1.y);
+		async_exchange_end(exch);
+
+		return rc;
+	}
+
 	exch = async_exchange_begin(ipcbm->ipcgc->sess);
 	req = async_send_3(exch, GC_BITMAP_RENDER, ipcbm->bmp_id, offs.x,
 	    offs.y, &answer);
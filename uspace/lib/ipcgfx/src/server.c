@@ -356,6 +356,33 @@ static void gc_bitmap_render_srv(ipc_gc_srv_t *srvgc, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+static void gc_bitmap_render_rect_srv(ipc_gc_srv_t *srvgc, ipc_call_t *call)
+{
+	ipc_gc_srv_bitmap_t *bitmap;
+	sysarg_t bmp_id;
+	gfx_rect_t srect;
+	gfx_coord2_t offs;
+	errno_t rc;
+
+	bmp_id = ipc_get_arg1(call);
+	srect.p0.x = ipc_get_arg2(call);
+	srect.p0.y = ipc_get_arg3(call);
+	srect.p1.x = ipc_get_arg4(call);
+	srect.p1.y = ipc_get_arg5(call);
+
+	offs.x = 0;
+	offs.y = 0;
+
+	bitmap = gc_bitmap_lookup(srvgc, bmp_id);
+	if (bitmap == NULL) {
+		async_answer_0(call, ENOENT);
+		return;
+	}
+
+	rc = gfx_bitmap_render(bitmap->bmp, &srect, &offs);
+	async_answer_0(call, rc);
+}
+
 errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 {
 	ipc_gc_srv_t srvgc;
@@ -408,6 +435,9 @@ errno_t gc_conn(ipc_call_t *icall, gfx_context_t *gc)
 		case GC_BITMAP_RENDER:
 			gc_bitmap_render_srv(&srvgc, &call);
 			break;
+		case GC_BITMAP_RENDER_RECT:
+			gc_bitmap_render_rect_srv(&srvgc, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 			break;
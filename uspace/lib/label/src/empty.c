@@ -102,7 +102,6 @@ errno_t label_bd_is_empty(label_bd_t *bd, bool *rempty)
 	void *buf = NULL;
 	aoff64_t nblocks;
 	aoff64_t n;
-	aoff64_t i;
 	size_t block_size;
 	bool empty;
 
@@ -123,8 +122,12 @@ errno_t label_bd_is_empty(label_bd_t *bd, bool *rempty)
 	}
 
 	calc_num_check_blocks(nblocks, block_size, &n);
+	if (n == 0) {
+		*rempty = true;
+		return EOK;
+	}
 
-	buf = calloc(block_size, 1);
+	buf = calloc((size_t)n, block_size);
 	if (buf == NULL) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Error allocating buffer.");
 		rc = ENOMEM;
@@ -133,34 +136,34 @@ errno_t label_bd_is_empty(label_bd_t *bd, bool *rempty)
 
 	empty = true;
 
-	for (i = 0; i < n; i++) {
-		rc = bd->ops->read(bd->arg, i, 1, buf);
-		if (rc != EOK) {
-			log_msg(LOG_DEFAULT, LVL_ERROR, "Error "
-			    "reading blocks.");
-			rc = EIO;
-			goto error;
-		}
+	/*
+	 * Read each checked area with a single request. Issuing one
+	 * request per block costs a device round trip per block.
+	 */
+	rc = bd->ops->read(bd->arg, 0, (size_t)n, buf);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Error "
+		    "reading blocks.");
+		rc = EIO;
+		goto error;
+	}
 
-		if (!mem_is_zero(buf, block_size)) {
-			empty = false;
-			goto done;
-		}
+	if (!mem_is_zero(buf, (size_t)n * block_size)) {
+		empty = false;
+		goto done;
 	}
 
-	for (i = 0; i < n; i++) {
-		rc = bd->ops->read(bd->arg, nblocks - n + i, 1, buf);
-		if (rc != EOK) {
-			log_msg(LOG_DEFAULT, LVL_ERROR, "Error "
-			    "reading blocks.");
-			rc = EIO;
-			goto error;
-		}
+	rc = bd->ops->read(bd->arg, nblocks - n, (size_t)n, buf);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Error "
+		    "reading blocks.");
+		rc = EIO;
+		goto error;
+	}
 
-		if (!mem_is_zero(buf, block_size)) {
-			empty = false;
-			goto done;
-		}
+	if (!mem_is_zero(buf, (size_t)n * block_size)) {
+		empty = false;
+		goto done;
 	}
 
 done:
@@ -43,6 +43,7 @@
 #include <gfx/render.h>
 #include <io/pixel.h>
 #include <io/pixelmap.h>
+#include <mem.h>
 #include <memgfx/memgc.h>
 #include <stdlib.h>
 #include "../private/memgc.h"
@@ -120,10 +121,14 @@ static errno_t mem_gc_fill_rect(void *arg, gfx_rect_t *rect)
 	gfx_rect_t crect;
 	gfx_coord_t x, y;
 	pixelmap_t pixelmap;
+	pixel_t *dp;
 
 	/* Make sure we have a sorted, clipped rectangle */
 	gfx_rect_clip(rect, &mgc->clip_rect, &crect);
 
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
+
 	assert(mgc->rect.p0.x == 0);
 	assert(mgc->rect.p0.y == 0);
 	assert(mgc->alloc.pitch == mgc->rect.p1.x * (int)sizeof(uint32_t));
@@ -131,10 +136,11 @@ static errno_t mem_gc_fill_rect(void *arg, gfx_rect_t *rect)
 	pixelmap.height = mgc->rect.p1.y;
 	pixelmap.data = mgc->alloc.pixels;
 
+	/* Fill a row at a time instead of going through put_pixel */
 	for (y = crect.p0.y; y < crect.p1.y; y++) {
-		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			pixelmap_put_pixel(&pixelmap, x, y, mgc->color);
-		}
+		dp = pixelmap_pixel_at(&pixelmap, crect.p0.x, y);
+		for (x = crect.p0.x; x < crect.p1.x; x++)
+			*dp++ = mgc->color;
 	}
 
 	mem_gc_invalidate_rect(mgc, &crect);
@@ -374,8 +380,11 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_rect_t crect;
 	gfx_coord2_t offs;
 	gfx_coord_t x, y;
+	gfx_coord_t width;
 	pixelmap_t smap;
 	pixelmap_t dmap;
+	pixel_t *sp;
+	pixel_t *dp;
 	pixel_t pixel;
 
 	if (srect0 != NULL)
@@ -396,6 +405,9 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	/* Clip destination rectangle */
 	gfx_rect_clip(&drect, &mbm->mgc->clip_rect, &crect);
 
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
+
 	assert(mbm->alloc.pitch == (mbm->rect.p1.x - mbm->rect.p0.x) *
 	    (int)sizeof(uint32_t));
 	smap.width = mbm->rect.p1.x - mbm->rect.p0.x;
@@ -409,39 +421,42 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	dmap.height = mbm->mgc->rect.p1.y;
 	dmap.data = mbm->mgc->alloc.pixels;
 
+	width = crect.p1.x - crect.p0.x;
+
 	if ((mbm->flags & bmpf_direct_output) != 0) {
 		/* Nothing to do */
 	} else if ((mbm->flags & bmpf_color_key) == 0) {
-		/* Simple copy */
+		/* Simple copy, entire rows at a time */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				pixelmap_put_pixel(&dmap, x, y, pixel);
-			}
+			sp = pixelmap_pixel_at(&smap,
+			    crect.p0.x - mbm->rect.p0.x - offs.x,
+			    y - mbm->rect.p0.y - offs.y);
+			dp = pixelmap_pixel_at(&dmap, crect.p0.x, y);
+			memcpy(dp, sp, width * sizeof(pixel_t));
 		}
 	} else if ((mbm->flags & bmpf_colorize) == 0) {
 		/* Color key */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
+			sp = pixelmap_pixel_at(&smap,
+			    crect.p0.x - mbm->rect.p0.x - offs.x,
+			    y - mbm->rect.p0.y - offs.y);
+			dp = pixelmap_pixel_at(&dmap, crect.p0.x, y);
+			for (x = 0; x < width; x++) {
+				pixel = sp[x];
 				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y, pixel);
+					dp[x] = pixel;
 			}
 		}
 	} else {
 		/* Color key & colorization */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y,
-					    mbm->mgc->color);
+			sp = pixelmap_pixel_at(&smap,
+			    crect.p0.x - mbm->rect.p0.x - offs.x,
+			    y - mbm->rect.p0.y - offs.y);
+			dp = pixelmap_pixel_at(&dmap, crect.p0.x, y);
+			for (x = 0; x < width; x++) {
+				if (sp[x] != mbm->key_color)
+					dp[x] = mbm->mgc->color;
 			}
 		}
 	}
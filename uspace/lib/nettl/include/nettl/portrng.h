@@ -36,13 +36,14 @@
 #ifndef LIBNETTL_PORTRNG_H_
 #define LIBNETTL_PORTRNG_H_
 
+#include <adt/hash_table.h>
 #include <stdbool.h>
 #include <stdint.h>
 
 /** Allocated port */
 typedef struct {
 	/** Link to portrng_t.used */
-	link_t lprng;
+	ht_link_t lprng;
 	/** Port number */
 	uint16_t pn;
 	/** User argument */
@@ -50,7 +51,8 @@ typedef struct {
 } portrng_port_t;
 
 typedef struct {
-	list_t used; /* of portrng_port_t */
+	/** Allocated ports, hashed by port number */
+	hash_table_t used; /* of portrng_port_t */
 } portrng_t;
 
 typedef enum {
@@ -33,10 +33,13 @@
 /**
  * @file Port range allocator
  *
- * Allocates port numbers from IETF port number ranges.
+ * Allocates port numbers from IETF port number ranges. Allocated ports
+ * are kept in a hash table so that the per-datagram port lookup is a
+ * single hash probe regardless of the number of bound ports.
  */
 
-#include <adt/list.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <nettl/portrng.h>
@@ -45,6 +48,49 @@
 
 #include <io/log.h>
 
+static size_t portrng_port_hash(const ht_link_t *item)
+{
+	portrng_port_t *port = hash_table_get_inst(item, portrng_port_t, lprng);
+	return hash_mix(port->pn);
+}
+
+static size_t portrng_key_hash(const void *key)
+{
+	const uint16_t *pn = key;
+	return hash_mix(*pn);
+}
+
+static bool portrng_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	portrng_port_t *port1 = hash_table_get_inst(item1, portrng_port_t,
+	    lprng);
+	portrng_port_t *port2 = hash_table_get_inst(item2, portrng_port_t,
+	    lprng);
+
+	return port1->pn == port2->pn;
+}
+
+static bool portrng_key_equal(const void *key, const ht_link_t *item)
+{
+	const uint16_t *pn = key;
+	portrng_port_t *port = hash_table_get_inst(item, portrng_port_t, lprng);
+
+	return *pn == port->pn;
+}
+
+static void portrng_remove_cb(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, portrng_port_t, lprng));
+}
+
+static hash_table_ops_t portrng_ports_ops = {
+	.hash = portrng_port_hash,
+	.key_hash = portrng_key_hash,
+	.equal = portrng_equal,
+	.key_equal = portrng_key_equal,
+	.remove_callback = portrng_remove_cb
+};
+
 /** Create port range.
  *
  * @param rpr Place to store pointer to new port range
@@ -60,7 +106,11 @@ errno_t portrng_create(portrng_t **rpr)
 	if (pr == NULL)
 		return ENOMEM;
 
-	list_initialize(&pr->used);
+	if (!hash_table_create(&pr->used, 0, 0, &portrng_ports_ops)) {
+		free(pr);
+		return ENOMEM;
+	}
+
 	*rpr = pr;
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_create() - end");
 	return EOK;
@@ -73,7 +123,8 @@ errno_t portrng_create(portrng_t **rpr)
 void portrng_destroy(portrng_t *pr)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_destroy()");
-	assert(list_empty(&pr->used));
+	assert(hash_table_empty(&pr->used));
+	hash_table_destroy(&pr->used);
 	free(pr);
 }
 
@@ -96,8 +147,8 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
     portrng_flags_t flags, uint16_t *apnum)
 {
 	portrng_port_t *p;
+	uint16_t pn;
 	uint32_t i;
-	bool found;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_alloc() - begin");
 
@@ -105,16 +156,9 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 
 		for (i = inet_port_dyn_lo; i <= inet_port_dyn_hi; i++) {
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "trying %" PRIu32, i);
-			found = false;
-			list_foreach(pr->used, lprng, portrng_port_t, port) {
-				if (port->pn == pnum) {
-					found = true;
-					break;
-				}
-			}
-
-			if (!found) {
-				pnum = i;
+			pn = (uint16_t) i;
+			if (hash_table_find(&pr->used, &pn) == NULL) {
+				pnum = pn;
 				break;
 			}
 		}
@@ -133,11 +177,9 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 			return EINVAL;
 		}
 
-		list_foreach(pr->used, lprng, portrng_port_t, port) {
-			if (port->pn == pnum) {
-				log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
-				return EEXIST;
-			}
+		if (hash_table_find(&pr->used, &pnum) != NULL) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
+			return EEXIST;
 		}
 	}
 
@@ -147,7 +189,7 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 
 	p->pn = pnum;
 	p->arg = arg;
-	list_append(&p->lprng, &pr->used);
+	hash_table_insert(&pr->used, &p->lprng);
 	*apnum = pnum;
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_alloc() - end OK pn=%" PRIu16,
 	    pnum);
@@ -164,14 +206,16 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
  */
 errno_t portrng_find_port(portrng_t *pr, uint16_t pnum, void **rarg)
 {
-	list_foreach(pr->used, lprng, portrng_port_t, port) {
-		if (port->pn == pnum) {
-			*rarg = port->arg;
-			return EOK;
-		}
-	}
+	ht_link_t *link;
+	portrng_port_t *port;
 
-	return ENOENT;
+	link = hash_table_find(&pr->used, &pnum);
+	if (link == NULL)
+		return ENOENT;
+
+	port = hash_table_get_inst(link, portrng_port_t, lprng);
+	*rarg = port->arg;
+	return EOK;
 }
 
 /** Free port in port range.
@@ -181,21 +225,17 @@ errno_t portrng_find_port(portrng_t *pr, uint16_t pnum, void **rarg)
  */
 void portrng_free_port(portrng_t *pr, uint16_t pnum)
 {
+	size_t removed;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port(%u)", pnum);
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port() - begin");
-	list_foreach(pr->used, lprng, portrng_port_t, port) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - check port %u", port->pn);
-		if (port->pn == pnum) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - OK");
-			list_remove(&port->lprng);
-			free(port);
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port() - end");
-			return;
-		}
+
+	removed = hash_table_remove(&pr->used, &pnum);
+	if (removed == 0) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - FAIL");
+		assert(false);
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - FAIL");
-	assert(false);
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port() - end");
 }
 
 /** Determine if port range is empty.
@@ -206,7 +246,7 @@ void portrng_free_port(portrng_t *pr, uint16_t pnum)
 bool portrng_empty(portrng_t *pr)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_empty()");
-	return list_empty(&pr->used);
+	return hash_table_empty(&pr->used);
 }
 
 /**
@@ -68,6 +68,8 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/** Index of the backing RX pool slot or -1 if allocated */
+	ssize_t pool_idx;
 } nic_frame_t;
 
 typedef list_t nic_frame_list_t;
@@ -84,6 +86,18 @@ typedef list_t nic_frame_list_t;
  */
 typedef void (*send_frame_handler)(nic_t *, void *, size_t);
 
+/**
+ * Handler for writing a batch of frames to the NIC device.
+ * The driver should post all frames in the list to its TX ring and
+ * trigger the transmission (ring the doorbell) only once for the whole
+ * batch. Unlike send_frame_handler, the frames are released by the
+ * framework after the handler returns.
+ *
+ * @param nic_data
+ * @param frames	List of frames to transmit
+ */
+typedef void (*send_frame_batch_handler)(nic_t *, nic_frame_list_t *);
+
 /**
  * The handler for transitions between driver states.
  * If the handler returns error code, the transition between
@@ -218,6 +232,9 @@ extern void nic_driver_implement(driver_ops_t *, ddf_dev_ops_t *,
 extern errno_t nic_get_resources(nic_t *, hw_res_list_parsed_t *);
 extern void nic_set_specific(nic_t *, void *);
 extern void nic_set_send_frame_handler(nic_t *, send_frame_handler);
+extern void nic_set_send_frame_batch_handler(nic_t *,
+    send_frame_batch_handler);
+extern void nic_set_tx_queue_depth(nic_t *, size_t);
 extern void nic_set_state_change_handlers(nic_t *,
     state_change_handler, state_change_handler, state_change_handler);
 extern void nic_set_filtering_change_handlers(nic_t *,
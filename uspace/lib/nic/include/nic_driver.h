@@ -73,12 +73,36 @@ struct nic {
 	nic_device_state_t state;
 	/** Transmiter is busy - messages are dropped */
 	int tx_busy;
+	/** Queue of frames waiting for transmission */
+	list_t tx_queue;
+	/** Number of frames in the transmit queue */
+	size_t tx_queue_cnt;
+	/** Maximum number of frames the transmit queue may hold */
+	size_t tx_queue_depth;
+	/** Lock protecting the transmit queue */
+	fibril_mutex_t tx_queue_lock;
+	/** Signaled when a frame is queued or tx_busy is cleared */
+	fibril_condvar_t tx_queue_cv;
+	/** Fibril draining the transmit queue (created on first use) */
+	fid_t tx_fibril;
 	/** Device's MAC address */
 	nic_address_t mac;
 	/** Device's default MAC address (assigned the first time, used in STOP) */
 	nic_address_t default_mac;
 	/** Client callback session */
 	async_sess_t *client_session;
+	/** Shared RX frame pool (may be NULL) */
+	void *rx_pool;
+	/** Shared RX frame pool size in bytes */
+	size_t rx_pool_size;
+	/** Stack of free RX pool slot indices */
+	uint32_t *rx_pool_free;
+	/** Number of free RX pool slots */
+	size_t rx_pool_free_cnt;
+	/** Lock protecting the RX pool free stack */
+	fibril_mutex_t rx_pool_lock;
+	/** The client has mapped the RX frame pool */
+	bool rx_pool_shared;
 	/** Current polling mode of the NIC */
 	nic_poll_mode_t poll_mode;
 	/** Polling period (applicable when poll_mode == NIC_POLL_PERIODIC) */
@@ -126,6 +150,14 @@ struct nic {
 	 * Called with the main_lock locked for reading.
 	 */
 	send_frame_handler send_frame;
+	/**
+	 * Optional batched variant of send_frame. When set, the transmit
+	 * queue is drained into the driver several frames at a time through
+	 * this handler so the driver can post all descriptors and ring the
+	 * doorbell only once per batch.
+	 * Called with the main_lock locked for reading.
+	 */
+	send_frame_batch_handler send_frame_batch;
 	/**
 	 * Event handler called when device goes to the ACTIVE state.
 	 * The implementation is optional.
@@ -209,6 +241,8 @@ typedef struct nic_globals {
 	fibril_mutex_t lock;
 } nic_globals_t;
 
+extern errno_t nic_tx_enqueue(nic_t *, void *, size_t);
+
 #endif
 
 /** @}
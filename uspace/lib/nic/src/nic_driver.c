@@ -44,6 +44,7 @@
 #include <sysinfo.h>
 #include <as.h>
 #include <ddf/interrupt.h>
+#include <nic_iface.h>
 #include <ops/nic.h>
 #include <errno.h>
 
@@ -53,6 +54,18 @@
 
 #define NIC_GLOBALS_MAX_CACHE_SIZE 16
 
+/** Maximum size of one serialized batch of received frames */
+#define NIC_RECEIVED_BATCH_SIZE (64 * 1024)
+
+/** Number of slots of the shared RX frame pool */
+#define NIC_POOL_SLOTS 256
+
+/** Default depth of the transmit queue */
+#define NIC_TX_QUEUE_DEPTH 64
+
+/** Maximum number of frames dequeued into the driver in one batch */
+#define NIC_TX_BATCH_SIZE 16
+
 nic_globals_t nic_globals;
 
 /**
@@ -160,6 +173,37 @@ void nic_set_send_frame_handler(nic_t *nic_data, send_frame_handler sffunc)
 	nic_data->send_frame = sffunc;
 }
 
+/**
+ * Setup the batched send frame handler. Optional; when set, the transmit
+ * queue is drained into the driver up to NIC_TX_BATCH_SIZE frames at a time
+ * through this handler, so the driver can post the whole batch to its TX
+ * ring and ring the doorbell only once. The function must be called only
+ * in the add_device handler.
+ *
+ * @param nic_data
+ * @param sfbfunc	Function handling the batched send request
+ */
+void nic_set_send_frame_batch_handler(nic_t *nic_data,
+    send_frame_batch_handler sfbfunc)
+{
+	nic_data->send_frame_batch = sfbfunc;
+}
+
+/**
+ * Set the depth of the transmit queue. When the queue is full, further
+ * send requests are refused with EAGAIN, signaling backpressure to the
+ * client instead of silently dropping frames. The function must be called
+ * only in the add_device handler.
+ *
+ * @param nic_data
+ * @param depth		Maximum number of queued frames, must be nonzero
+ */
+void nic_set_tx_queue_depth(nic_t *nic_data, size_t depth)
+{
+	assert(depth > 0);
+	nic_data->tx_queue_depth = depth;
+}
+
 /**
  * Setup event handlers for transitions between driver states.
  * This function can be called only in the add_device handler.
@@ -280,10 +324,28 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 		link_initialize(&frame->link);
 	}
 
-	frame->data = malloc(size);
+	frame->data = NULL;
+	frame->pool_idx = -1;
+
+	/* Prefer a slot of the shared RX frame pool */
+	if (nic_data->rx_pool != NULL && size <= NIC_POOL_SLOT_SIZE) {
+		fibril_mutex_lock(&nic_data->rx_pool_lock);
+		if (nic_data->rx_pool_free_cnt > 0) {
+			uint32_t idx =
+			    nic_data->rx_pool_free[--nic_data->rx_pool_free_cnt];
+			frame->data = nic_data->rx_pool +
+			    (size_t) idx * NIC_POOL_SLOT_SIZE;
+			frame->pool_idx = idx;
+		}
+		fibril_mutex_unlock(&nic_data->rx_pool_lock);
+	}
+
 	if (frame->data == NULL) {
-		free(frame);
-		return NULL;
+		frame->data = malloc(size);
+		if (frame->data == NULL) {
+			free(frame);
+			return NULL;
+		}
 	}
 
 	frame->size = size;
@@ -300,7 +362,17 @@ void nic_release_frame(nic_t *nic_data, nic_frame_t *frame)
 	if (!frame)
 		return;
 
-	if (frame->data != NULL) {
+	if (frame->pool_idx >= 0) {
+		/* Return the slot to the RX frame pool */
+		fibril_mutex_lock(&nic_data->rx_pool_lock);
+		assert(nic_data->rx_pool_free_cnt < NIC_POOL_SLOTS);
+		nic_data->rx_pool_free[nic_data->rx_pool_free_cnt++] =
+		    (uint32_t) frame->pool_idx;
+		fibril_mutex_unlock(&nic_data->rx_pool_lock);
+		frame->pool_idx = -1;
+		frame->data = NULL;
+		frame->size = 0;
+	} else if (frame->data != NULL) {
 		free(frame->data);
 		frame->data = NULL;
 		frame->size = 0;
@@ -505,22 +577,203 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	 * by other fibril) it cannot crash anything.
 	 */
 	nic_data->tx_busy = busy;
+
+	if (!busy) {
+		/* Wake up the transmit queue drain fibril */
+		fibril_mutex_lock(&nic_data->tx_queue_lock);
+		fibril_condvar_broadcast(&nic_data->tx_queue_cv);
+		fibril_mutex_unlock(&nic_data->tx_queue_lock);
+	}
+}
+
+/** Allocate a frame for the transmit queue
+ *
+ * Unlike nic_alloc_frame() this never takes a slot from the shared RX
+ * frame pool, so queued TX frames cannot starve reception.
+ *
+ * @param size	Frame size in bytes
+ * @return pointer to allocated frame if success, NULL otherwise
+ */
+static nic_frame_t *nic_alloc_tx_frame(size_t size)
+{
+	nic_frame_t *frame;
+	fibril_mutex_lock(&nic_globals.lock);
+	if (nic_globals.frame_cache_size > 0) {
+		link_t *first = list_first(&nic_globals.frame_cache);
+		list_remove(first);
+		nic_globals.frame_cache_size--;
+		frame = list_get_instance(first, nic_frame_t, link);
+		fibril_mutex_unlock(&nic_globals.lock);
+	} else {
+		fibril_mutex_unlock(&nic_globals.lock);
+		frame = malloc(sizeof(nic_frame_t));
+		if (!frame)
+			return NULL;
+
+		link_initialize(&frame->link);
+	}
+
+	frame->pool_idx = -1;
+	frame->data = malloc(size);
+	if (frame->data == NULL) {
+		free(frame);
+		return NULL;
+	}
+
+	frame->size = size;
+	return frame;
+}
+
+/** Main function of the transmit queue drain fibril
+ *
+ * Dequeues frames in batches and passes them to the driver: through the
+ * batch handler - posting the whole batch with a single doorbell - when
+ * the driver provides one, one frame at a time otherwise. When the driver
+ * reports a full TX ring (tx_busy), draining pauses until the flag is
+ * cleared instead of dropping the frames.
+ *
+ * @param data	The NIC structure pointer
+ *
+ * @return EOK, never reached
+ */
+static errno_t nic_tx_fibril_fun(void *data)
+{
+	nic_t *nic_data = data;
+	list_t batch;
+	size_t batch_cnt;
+	nic_frame_t *frame;
+
+	while (true) {
+		list_initialize(&batch);
+		batch_cnt = 0;
+
+		fibril_mutex_lock(&nic_data->tx_queue_lock);
+		while (nic_data->tx_queue_cnt == 0) {
+			fibril_condvar_wait(&nic_data->tx_queue_cv,
+			    &nic_data->tx_queue_lock);
+		}
+
+		while (batch_cnt < NIC_TX_BATCH_SIZE &&
+		    nic_data->tx_queue_cnt > 0) {
+			link_t *first = list_first(&nic_data->tx_queue);
+			list_remove(first);
+			nic_data->tx_queue_cnt--;
+			list_append(first, &batch);
+			batch_cnt++;
+		}
+		fibril_mutex_unlock(&nic_data->tx_queue_lock);
+
+		fibril_rwlock_read_lock(&nic_data->main_lock);
+
+		/* Wait for the driver to free up ring space */
+		while (nic_data->tx_busy &&
+		    nic_data->state == NIC_STATE_ACTIVE) {
+			fibril_rwlock_read_unlock(&nic_data->main_lock);
+			fibril_mutex_lock(&nic_data->tx_queue_lock);
+			if (nic_data->tx_busy) {
+				fibril_condvar_wait_timeout(
+				    &nic_data->tx_queue_cv,
+				    &nic_data->tx_queue_lock, 10000);
+			}
+			fibril_mutex_unlock(&nic_data->tx_queue_lock);
+			fibril_rwlock_read_lock(&nic_data->main_lock);
+		}
+
+		if (nic_data->state != NIC_STATE_ACTIVE) {
+			/* The device went down with frames still queued */
+			fibril_rwlock_read_unlock(&nic_data->main_lock);
+			nic_report_send_error(nic_data, NIC_SEC_OTHER,
+			    batch_cnt);
+			while (!list_empty(&batch)) {
+				frame = list_get_instance(list_first(&batch),
+				    nic_frame_t, link);
+				list_remove(&frame->link);
+				nic_release_frame(nic_data, frame);
+			}
+			continue;
+		}
+
+		if (nic_data->send_frame_batch != NULL) {
+			nic_data->send_frame_batch(nic_data, &batch);
+		} else {
+			list_foreach(batch, link, nic_frame_t, frame) {
+				nic_data->send_frame(nic_data, frame->data,
+				    frame->size);
+			}
+		}
+		fibril_rwlock_read_unlock(&nic_data->main_lock);
+
+		while (!list_empty(&batch)) {
+			frame = list_get_instance(list_first(&batch),
+			    nic_frame_t, link);
+			list_remove(&frame->link);
+			nic_release_frame(nic_data, frame);
+		}
+	}
+
+	return EOK;
+}
+
+/** Append a frame to the transmit queue
+ *
+ * The frame data is copied, the caller keeps ownership of the buffer.
+ * Called with the main_lock locked for reading.
+ *
+ * @param nic_data	The NIC driver data
+ * @param data		Frame data
+ * @param size		Frame size in bytes
+ *
+ * @return EOK		If the frame was queued
+ * @return EAGAIN	If the queue is full - backpressure, retry later
+ * @return ENOMEM	If there is not enough memory
+ */
+errno_t nic_tx_enqueue(nic_t *nic_data, void *data, size_t size)
+{
+	nic_frame_t *frame = nic_alloc_tx_frame(size);
+	if (frame == NULL)
+		return ENOMEM;
+
+	memcpy(frame->data, data, size);
+
+	fibril_mutex_lock(&nic_data->tx_queue_lock);
+
+	if (nic_data->tx_queue_cnt >= nic_data->tx_queue_depth) {
+		fibril_mutex_unlock(&nic_data->tx_queue_lock);
+		nic_release_frame(nic_data, frame);
+		return EAGAIN;
+	}
+
+	/* Create the drain fibril on first use */
+	if (nic_data->tx_fibril == 0) {
+		nic_data->tx_fibril = fibril_create(nic_tx_fibril_fun,
+		    nic_data);
+		if (nic_data->tx_fibril == 0) {
+			fibril_mutex_unlock(&nic_data->tx_queue_lock);
+			nic_release_frame(nic_data, frame);
+			return ENOMEM;
+		}
+		fibril_add_ready(nic_data->tx_fibril);
+	}
+
+	list_append(&frame->link, &nic_data->tx_queue);
+	nic_data->tx_queue_cnt++;
+	fibril_condvar_signal(&nic_data->tx_queue_cv);
+	fibril_mutex_unlock(&nic_data->tx_queue_lock);
+
+	return EOK;
 }
 
 /**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+ * Check a received frame against the receive filters and update the
+ * statistics accordingly.
  *
  * @param nic_data
  * @param frame		The received frame
+ *
+ * @return Whether the frame should be passed to the client
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_frame_accept(nic_t *nic_data, nic_frame_t *frame)
 {
-	/*
-	 * Note: this function must not lock main lock, because loopback driver
-	 * 		 calls it inside send_frame handler (with locked main lock)
-	 */
 	fibril_rwlock_read_lock(&nic_data->rxc_lock);
 	nic_frame_type_t frame_type;
 	bool check = nic_rxc_check(&nic_data->rx_control, frame->data,
@@ -543,45 +796,197 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+		return true;
+	}
+
+	switch (frame_type) {
+	case NIC_FRAME_UNICAST:
+		nic_data->stats.receive_filtered_unicast++;
+		break;
+	case NIC_FRAME_MULTICAST:
+		nic_data->stats.receive_filtered_multicast++;
+		break;
+	case NIC_FRAME_BROADCAST:
+		nic_data->stats.receive_filtered_broadcast++;
+		break;
+	}
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	return false;
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	/*
+	 * Note: this function must not lock main lock, because loopback driver
+	 * 		 calls it inside send_frame handler (with locked main lock)
+	 */
+	if (nic_frame_accept(nic_data, frame)) {
 		nic_ev_received(nic_data->client_session, frame->data,
 		    frame->size);
-	} else {
-		switch (frame_type) {
-		case NIC_FRAME_UNICAST:
-			nic_data->stats.receive_filtered_unicast++;
-			break;
-		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_filtered_multicast++;
-			break;
-		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_filtered_broadcast++;
-			break;
-		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
 	}
+
 	nic_release_frame(nic_data, frame);
 }
 
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
- * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * send them in whole list of frames (actually nic_frame_t structures). The
+ * frames which pass the receive filters are serialized into batches and
+ * each batch is passed to the client in a single transfer, avoiding the
+ * per-frame event overhead. The list is deallocated.
  *
  * @param nic_data
  * @param frames		List of received frames
  */
 void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
+	size_t batch_size = 0;
+
 	if (frames == NULL)
 		return;
-	while (!list_empty(frames)) {
+
+	/* Drop the filtered-out frames, compute the batch size */
+	link_t *link = list_first(frames);
+	while (link != NULL) {
 		nic_frame_t *frame =
-		    list_get_instance(list_first(frames), nic_frame_t, link);
+		    list_get_instance(link, nic_frame_t, link);
+		link_t *next = list_next(link, frames);
+
+		if (nic_frame_accept(nic_data, frame)) {
+			batch_size += sizeof(uint32_t) + frame->size;
+		} else {
+			list_remove(&frame->link);
+			nic_release_frame(nic_data, frame);
+		}
 
-		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
+		link = next;
 	}
+
+	/*
+	 * Frames residing in the shared RX frame pool can be passed to the
+	 * client by slot index, without copying the data at all.
+	 */
+	if (nic_data->rx_pool_shared) {
+		size_t npool = 0;
+
+		list_foreach(*frames, link, nic_frame_t, frame) {
+			if (frame->pool_idx >= 0)
+				npool++;
+		}
+
+		nic_pool_frame_t *precs = (npool > 0) ?
+		    malloc(npool * sizeof(nic_pool_frame_t)) : NULL;
+
+		if (precs != NULL) {
+			size_t i = 0;
+			list_foreach(*frames, link, nic_frame_t, frame) {
+				if (frame->pool_idx >= 0) {
+					precs[i].idx =
+					    (uint32_t) frame->pool_idx;
+					precs[i].size =
+					    (uint32_t) frame->size;
+					i++;
+				}
+			}
+
+			errno_t rc = nic_ev_received_pool_list(
+			    nic_data->client_session, precs,
+			    npool * sizeof(nic_pool_frame_t));
+			free(precs);
+
+			if (rc != ENOTSUP) {
+				/*
+				 * The client returned ownership of the
+				 * slots (whether or not it could process
+				 * the frames); release them.
+				 */
+				link = list_first(frames);
+				while (link != NULL) {
+					nic_frame_t *frame = list_get_instance(
+					    link, nic_frame_t, link);
+					link_t *next = list_next(link, frames);
+
+					if (frame->pool_idx >= 0) {
+						list_remove(&frame->link);
+						nic_release_frame(nic_data,
+						    frame);
+					}
+
+					link = next;
+				}
+			}
+		}
+	}
+
+	if (batch_size > NIC_RECEIVED_BATCH_SIZE)
+		batch_size = NIC_RECEIVED_BATCH_SIZE;
+
+	void *batch = (batch_size != 0 && !list_empty(frames)) ?
+	    malloc(batch_size) : NULL;
+
+	while (!list_empty(frames)) {
+		nic_frame_t *frame;
+		size_t used = 0;
+		size_t nframes = 0;
+
+		/*
+		 * Serialize frames from the head of the list into the
+		 * batch buffer: each frame is prefixed with its size
+		 * as a uint32_t.
+		 */
+		if (batch != NULL) {
+			list_foreach(*frames, link, nic_frame_t, frame) {
+				size_t rec = sizeof(uint32_t) + frame->size;
+				if (used + rec > batch_size)
+					break;
+
+				uint32_t fsize = (uint32_t) frame->size;
+				memcpy(batch + used, &fsize, sizeof(fsize));
+				memcpy(batch + used + sizeof(fsize),
+				    frame->data, frame->size);
+				used += rec;
+				nframes++;
+			}
+		}
+
+		if (nframes == 0) {
+			/* No batch buffer or an oversized frame */
+			frame = list_get_instance(list_first(frames),
+			    nic_frame_t, link);
+			list_remove(&frame->link);
+			nic_ev_received(nic_data->client_session,
+			    frame->data, frame->size);
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		errno_t rc = nic_ev_received_list(nic_data->client_session,
+		    batch, used);
+
+		while (nframes-- > 0) {
+			frame = list_get_instance(list_first(frames),
+			    nic_frame_t, link);
+			list_remove(&frame->link);
+			/* The client may not support batched delivery */
+			if (rc == ENOTSUP) {
+				nic_ev_received(nic_data->client_session,
+				    frame->data, frame->size);
+			}
+			nic_release_frame(nic_data, frame);
+		}
+	}
+
+	if (batch != NULL)
+		free(batch);
+
 	nic_driver_release_frame_list(frames);
 }
 
@@ -609,9 +1014,41 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->fun = NULL;
 	nic_data->state = NIC_STATE_STOPPED;
 	nic_data->client_session = NULL;
+
+	/* Create the shared RX frame pool (best effort) */
+	nic_data->rx_pool = NULL;
+	nic_data->rx_pool_shared = false;
+	fibril_mutex_initialize(&nic_data->rx_pool_lock);
+
+	nic_data->rx_pool_free = calloc(NIC_POOL_SLOTS, sizeof(uint32_t));
+	if (nic_data->rx_pool_free != NULL) {
+		nic_data->rx_pool_size = NIC_POOL_SLOTS * NIC_POOL_SLOT_SIZE;
+		nic_data->rx_pool = as_area_create(AS_AREA_ANY,
+		    nic_data->rx_pool_size,
+		    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+		    AS_AREA_UNPAGED);
+		if (nic_data->rx_pool == AS_MAP_FAILED) {
+			nic_data->rx_pool = NULL;
+			free(nic_data->rx_pool_free);
+			nic_data->rx_pool_free = NULL;
+		} else {
+			for (size_t i = 0; i < NIC_POOL_SLOTS; i++)
+				nic_data->rx_pool_free[i] = i;
+			nic_data->rx_pool_free_cnt = NIC_POOL_SLOTS;
+		}
+	}
+
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
+	nic_data->send_frame_batch = NULL;
+
+	list_initialize(&nic_data->tx_queue);
+	nic_data->tx_queue_cnt = 0;
+	nic_data->tx_queue_depth = NIC_TX_QUEUE_DEPTH;
+	fibril_mutex_initialize(&nic_data->tx_queue_lock);
+	fibril_condvar_initialize(&nic_data->tx_queue_cv);
+	nic_data->tx_fibril = 0;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
 	nic_data->on_stopping = NULL;
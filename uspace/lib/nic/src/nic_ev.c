@@ -35,6 +35,7 @@
  * @brief
  */
 
+#include <as.h>
 #include <async.h>
 #include <nic_iface.h>
 #include <errno.h>
@@ -93,5 +94,78 @@ errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
 	return retval;
 }
 
+/** Batch of frames received.
+ *
+ * The data is a sequence of frames, each prefixed with its size as
+ * a uint32_t, delivered to the client in a single transfer.
+ */
+errno_t nic_ev_received_list(async_sess_t *sess, void *data, size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, NIC_EV_RECEIVED_LIST, &answer);
+	errno_t retval = async_data_write_start(exch, data, size);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Offer the shared RX frame pool to the client.
+ *
+ * The pool memory area is shared out to the client, which maps it
+ * read-only and can then receive frames residing in the pool in place.
+ */
+errno_t nic_ev_frame_pool(async_sess_t *sess, void *pool, size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, NIC_EV_FRAME_POOL, &answer);
+	errno_t retval = async_share_out_start(exch, pool, AS_AREA_READ);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Batch of frames received into the shared RX frame pool.
+ *
+ * The data is an array of nic_pool_frame_t entries referring to pool
+ * slots. The slots remain owned by the client until the event is
+ * answered.
+ */
+errno_t nic_ev_received_pool_list(async_sess_t *sess, void *data, size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, NIC_EV_RECEIVED_POOL_LIST, &answer);
+	errno_t retval = async_data_write_start(exch, data, size);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 /** @}
  */
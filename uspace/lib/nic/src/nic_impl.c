@@ -160,28 +160,33 @@ errno_t nic_set_state_impl(ddf_fun_t *fun, nic_device_state_t state)
 
 /**
  * Default implementation of the send_frame method.
- * Send messages to the network.
+ * Queue a message for transmission. The frame is copied into the
+ * transmit queue and written to the device asynchronously; a full
+ * driver ring (tx_busy) pauses the queue instead of dropping frames.
  *
  * @param	fun
  * @param	data	Frame data
  * @param 	size	Frame size in bytes
  *
- * @return EOK		If the message was sent
+ * @return EOK		If the message was queued
  * @return EBUSY	If the device is not in state when the frame can be sent.
+ * @return EAGAIN	If the transmit queue is full - the caller should
+ * 			back off and retry.
  */
 errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
 {
 	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	errno_t rc;
 
 	fibril_rwlock_read_lock(&nic_data->main_lock);
-	if (nic_data->state != NIC_STATE_ACTIVE || nic_data->tx_busy) {
+	if (nic_data->state != NIC_STATE_ACTIVE) {
 		fibril_rwlock_read_unlock(&nic_data->main_lock);
 		return EBUSY;
 	}
 
-	nic_data->send_frame(nic_data, data, size);
+	rc = nic_tx_enqueue(nic_data, data, size);
 	fibril_rwlock_read_unlock(&nic_data->main_lock);
-	return EOK;
+	return rc;
 }
 
 /**
@@ -203,6 +208,17 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 		return ENOMEM;
 	}
 
+	/*
+	 * Offer the shared RX frame pool to the client. If the client
+	 * does not accept it, frames are delivered by copying as before.
+	 */
+	if (nic->rx_pool != NULL) {
+		errno_t rc = nic_ev_frame_pool(nic->client_session,
+		    nic->rx_pool, nic->rx_pool_size);
+		if (rc == EOK)
+			nic->rx_pool_shared = true;
+	}
+
 	fibril_rwlock_write_unlock(&nic->main_lock);
 	return EOK;
 }
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @brief HelenOS sound server
+ * @{
+ */
+/** @file
+ * Batch sample-rate conversion of interleaved signed 16-bit frames.
+ */
+
+#ifndef PCM_RESAMPLE_H_
+#define PCM_RESAMPLE_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum number of interleaved channels supported by the resampler */
+#define PCM_RESAMPLE_MAX_CHANNELS 8
+
+/** Number of history frames kept between calls */
+#define PCM_RESAMPLE_HIST_FRAMES 3
+
+/** Sample rate converter state.
+ *
+ * The converter processes whole input buffers at a time and carries the
+ * last few input frames over between calls, so a stream can be fed in
+ * arbitrary chunks without seams at the chunk boundaries.
+ */
+typedef struct {
+	/** Number of interleaved channels */
+	unsigned channels;
+	/** Input frames per output frame, 16.16 fixed point */
+	uint32_t step;
+	/** Read position within the virtual input stream, 16.16 fixed point */
+	uint64_t pos;
+	/** Trailing input frames from the previous call */
+	int16_t hist[PCM_RESAMPLE_HIST_FRAMES][PCM_RESAMPLE_MAX_CHANNELS];
+} pcm_resample_t;
+
+extern errno_t pcm_resample_init(pcm_resample_t *, unsigned, unsigned,
+    unsigned);
+extern size_t pcm_resample_out_max(pcm_resample_t *, size_t);
+extern errno_t pcm_resample_linear(pcm_resample_t *, const int16_t *, size_t,
+    int16_t *, size_t, size_t *);
+extern errno_t pcm_resample_cubic(pcm_resample_t *, const int16_t *, size_t,
+    int16_t *, size_t, size_t *);
+
+#endif
+
+/**
+ * @}
+ */
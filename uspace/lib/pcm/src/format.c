@@ -190,6 +190,54 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 	if ((dst_size % dst_frame_size) != 0)
 		return EINVAL;
 
+	/*
+	 * Mixing two buffers of identical format needs no per-sample
+	 * float normalization; saturated integer addition in a tight
+	 * loop is equivalent and leaves the compiler free to vectorize.
+	 * This is the common case, as hound streams default to signed
+	 * 16-bit. Missing source samples are treated as silence, which
+	 * is all zeroes for signed formats, so the destination tail is
+	 * simply left untouched.
+	 */
+#define LOOP_MIX_SAME(type, stype, endian, vmin, vmax) \
+do { \
+	type *dst_buf = dst; \
+	const type *src_buf = src; \
+	const size_t sample_count = min(dst_size, src_size) / sizeof(type); \
+	for (size_t i = 0; i < sample_count; ++i) { \
+		const int64_t sum = \
+		    (int64_t)(stype)(type ## _ ## endian ## 2host(dst_buf[i])) + \
+		    (int64_t)(stype)(type ## _ ## endian ## 2host(src_buf[i])); \
+		const stype sat = (sum < (vmin)) ? (vmin) : \
+		    ((sum > (vmax)) ? (vmax) : (stype)sum); \
+		dst_buf[i] = host2 ## type ## _ ## endian((type)sat); \
+	} \
+} while (0)
+
+	if (pcm_format_same(sf, df)) {
+		switch (df->sample_format) {
+		case PCM_SAMPLE_SINT16_LE:
+			LOOP_MIX_SAME(uint16_t, int16_t, le, INT16_MIN,
+			    INT16_MAX);
+			return EOK;
+		case PCM_SAMPLE_SINT16_BE:
+			LOOP_MIX_SAME(uint16_t, int16_t, be, INT16_MIN,
+			    INT16_MAX);
+			return EOK;
+		case PCM_SAMPLE_SINT32_LE:
+			LOOP_MIX_SAME(uint32_t, int32_t, le, INT32_MIN,
+			    INT32_MAX);
+			return EOK;
+		case PCM_SAMPLE_SINT32_BE:
+			LOOP_MIX_SAME(uint32_t, int32_t, be, INT32_MIN,
+			    INT32_MAX);
+			return EOK;
+		default:
+			break;
+		}
+	}
+#undef LOOP_MIX_SAME
+
 	/*
 	 * This is so ugly it eats kittens, and puppies, and ducklings,
 	 * and all little fluffy things...
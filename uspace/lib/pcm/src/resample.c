@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @brief HelenOS sound server
+ * @{
+ */
+/** @file
+ * Batch sample-rate conversion of interleaved signed 16-bit frames.
+ *
+ * The conversion loops are branch-free fixed-point kernels working on
+ * whole buffers, rather than per-sample callbacks, so the compiler can
+ * keep the state in registers and vectorize the channel lanes.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "resample.h"
+
+/** Conceptually the input is the history followed by the source buffer. */
+static inline const int16_t *resample_frame(pcm_resample_t *rs,
+    const int16_t *src, size_t idx)
+{
+	if (idx < PCM_RESAMPLE_HIST_FRAMES)
+		return rs->hist[idx];
+	return src + (idx - PCM_RESAMPLE_HIST_FRAMES) * rs->channels;
+}
+
+/** Carry the trailing input frames over to the next call. */
+static void resample_save_hist(pcm_resample_t *rs, const int16_t *src,
+    size_t src_frames)
+{
+	int16_t tmp[PCM_RESAMPLE_HIST_FRAMES][PCM_RESAMPLE_MAX_CHANNELS];
+	size_t total = PCM_RESAMPLE_HIST_FRAMES + src_frames;
+	unsigned c;
+	size_t k;
+
+	for (k = 0; k < PCM_RESAMPLE_HIST_FRAMES; k++) {
+		const int16_t *frame = resample_frame(rs, src,
+		    total - PCM_RESAMPLE_HIST_FRAMES + k);
+		for (c = 0; c < rs->channels; c++)
+			tmp[k][c] = frame[c];
+	}
+	for (k = 0; k < PCM_RESAMPLE_HIST_FRAMES; k++) {
+		for (c = 0; c < rs->channels; c++)
+			rs->hist[k][c] = tmp[k][c];
+	}
+
+	rs->pos -= (uint64_t)src_frames << 16;
+}
+
+/** Initialize a sample rate converter.
+ *
+ * @param rs       Converter state to initialize.
+ * @param channels Number of interleaved channels.
+ * @param src_rate Input sampling rate.
+ * @param dst_rate Output sampling rate.
+ * @return EOK on success, EINVAL if the parameters are out of range.
+ */
+errno_t pcm_resample_init(pcm_resample_t *rs, unsigned channels,
+    unsigned src_rate, unsigned dst_rate)
+{
+	unsigned c;
+	size_t k;
+
+	if (channels < 1 || channels > PCM_RESAMPLE_MAX_CHANNELS)
+		return EINVAL;
+	if (src_rate == 0 || dst_rate == 0)
+		return EINVAL;
+
+	rs->step = (uint32_t)(((uint64_t)src_rate << 16) / dst_rate);
+	if (rs->step == 0)
+		return EINVAL;
+
+	rs->channels = channels;
+	rs->pos = (uint64_t)PCM_RESAMPLE_HIST_FRAMES << 16;
+	for (k = 0; k < PCM_RESAMPLE_HIST_FRAMES; k++) {
+		for (c = 0; c < channels; c++)
+			rs->hist[k][c] = 0;
+	}
+	return EOK;
+}
+
+/** Return an upper bound on the output frames produced from an input.
+ *
+ * Size the destination buffer with this before calling the conversion
+ * functions; they refuse to run into a buffer that might be too small.
+ *
+ * @param rs         Converter state.
+ * @param src_frames Number of input frames.
+ * @return           Maximum number of output frames produced.
+ */
+size_t pcm_resample_out_max(pcm_resample_t *rs, size_t src_frames)
+{
+	return (size_t)((((uint64_t)src_frames +
+	    PCM_RESAMPLE_HIST_FRAMES) << 16) / rs->step) + 1;
+}
+
+/** Resample a buffer using linear interpolation.
+ *
+ * Consumes the entire source buffer; input not yet needed for an output
+ * frame is carried over to the next call.
+ *
+ * @param rs         Converter state.
+ * @param src        Input frames (interleaved).
+ * @param src_frames Number of input frames.
+ * @param dst        Output buffer.
+ * @param dst_frames Capacity of @a dst in frames. Must be at least
+ *                   pcm_resample_out_max(rs, src_frames).
+ * @param produced   Set to the number of output frames written.
+ * @return EOK on success, ELIMIT if the output buffer is too small.
+ */
+errno_t pcm_resample_linear(pcm_resample_t *rs, const int16_t *src,
+    size_t src_frames, int16_t *dst, size_t dst_frames, size_t *produced)
+{
+	size_t total = PCM_RESAMPLE_HIST_FRAMES + src_frames;
+	size_t nout = 0;
+	unsigned c;
+
+	if (dst_frames < pcm_resample_out_max(rs, src_frames))
+		return ELIMIT;
+
+	while ((rs->pos >> 16) + 1 < total) {
+		size_t idx = (size_t)(rs->pos >> 16);
+		int64_t frac = (int64_t)(rs->pos & 0xffff);
+		const int16_t *f0 = resample_frame(rs, src, idx);
+		const int16_t *f1 = resample_frame(rs, src, idx + 1);
+
+		for (c = 0; c < rs->channels; c++) {
+			int64_t s0 = f0[c];
+			int64_t s1 = f1[c];
+			dst[nout * rs->channels + c] =
+			    (int16_t)(s0 + (((s1 - s0) * frac) >> 16));
+		}
+
+		nout++;
+		rs->pos += rs->step;
+	}
+
+	resample_save_hist(rs, src, src_frames);
+	*produced = nout;
+	return EOK;
+}
+
+/** Resample a buffer using Catmull-Rom cubic interpolation.
+ *
+ * Same contract as pcm_resample_linear(), with a smoother result at the
+ * cost of a few more multiplications per frame.
+ */
+errno_t pcm_resample_cubic(pcm_resample_t *rs, const int16_t *src,
+    size_t src_frames, int16_t *dst, size_t dst_frames, size_t *produced)
+{
+	size_t total = PCM_RESAMPLE_HIST_FRAMES + src_frames;
+	size_t nout = 0;
+	unsigned c;
+
+	if (dst_frames < pcm_resample_out_max(rs, src_frames))
+		return ELIMIT;
+
+	while ((rs->pos >> 16) + 2 < total && (rs->pos >> 16) >= 1) {
+		size_t idx = (size_t)(rs->pos >> 16);
+		int64_t frac = (int64_t)(rs->pos & 0xffff);
+		const int16_t *fm = resample_frame(rs, src, idx - 1);
+		const int16_t *f0 = resample_frame(rs, src, idx);
+		const int16_t *f1 = resample_frame(rs, src, idx + 1);
+		const int16_t *f2 = resample_frame(rs, src, idx + 2);
+
+		for (c = 0; c < rs->channels; c++) {
+			int64_t sm = fm[c];
+			int64_t s0 = f0[c];
+			int64_t s1 = f1[c];
+			int64_t s2 = f2[c];
+
+			/*
+			 * Catmull-Rom: s0 + f * (c1 + f * (c2 + f * c3)) / 2
+			 * evaluated with a fixed-point Horner scheme.
+			 */
+			int64_t c1 = s1 - sm;
+			int64_t c2 = 2 * sm - 5 * s0 + 4 * s1 - s2;
+			int64_t c3 = 3 * (s0 - s1) + s2 - sm;
+
+			int64_t r = c2 + ((c3 * frac) >> 16);
+			r = c1 + ((r * frac) >> 16);
+			r = s0 + (((r * frac) >> 16) >> 1);
+
+			if (r < INT16_MIN)
+				r = INT16_MIN;
+			if (r > INT16_MAX)
+				r = INT16_MAX;
+			dst[nout * rs->channels + c] = (int16_t)r;
+		}
+
+		nout++;
+		rs->pos += rs->step;
+	}
+
+	resample_save_hist(rs, src, src_frames);
+	*produced = nout;
+	return EOK;
+}
+
+/**
+ * @}
+ */
@@ -59,6 +59,7 @@ enum {
 enum {
 	PCUT_EXTRA_TIMEOUT,
 	PCUT_EXTRA_SKIP,
+	PCUT_EXTRA_SERIAL,
 	PCUT_EXTRA_LAST
 };
 
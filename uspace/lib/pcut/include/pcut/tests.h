@@ -159,6 +159,15 @@
 #define PCUT_TEST_SKIP \
 	{ PCUT_EXTRA_SKIP, 0 }
 
+/** Never run current test concurrently with other tests.
+ *
+ * Only meaningful when tests are run in parallel (the -j option).
+ *
+ * Use as argument to PCUT_TEST().
+ */
+#define PCUT_TEST_SERIAL \
+	{ PCUT_EXTRA_SERIAL, 0 }
+
 
 /** @cond devel */
 
@@ -227,6 +236,27 @@
 		NULL \
 	)
 
+/** Define and start a new test suite that is never run in parallel.
+ *
+ * @see PCUT_TEST_SUITE_SERIAL
+ *
+ * @param suitename Suite name (a valid C identifier).
+ * @param number Item number.
+ */
+#define PCUT_TEST_SUITE_SERIAL_WITH_NUMBER(suitename, number) \
+	PCUT_ITEM_COUNTER_INCREMENT \
+	static pcut_extra_t PCUT_ITEM_EXTRAS_NAME(number)[] = { \
+		PCUT_TEST_SERIAL, \
+		PCUT_TEST_EXTRA_LAST \
+	}; \
+	PCUT_ADD_ITEM(number, PCUT_KIND_TESTSUITE, \
+		#suitename, \
+		NULL, \
+		NULL, NULL, \
+		PCUT_ITEM_EXTRAS_NAME(number), NULL, \
+		NULL \
+	)
+
 /** Define a set-up function for a test suite.
  *
  * @see PCUT_TEST_BEFORE
@@ -274,6 +304,17 @@
 #define PCUT_TEST_SUITE(name) \
 	PCUT_TEST_SUITE_WITH_NUMBER(name, PCUT_ITEM_COUNTER)
 
+/** Define and start a new test suite whose tests need isolation.
+ *
+ * Like PCUT_TEST_SUITE(), but when tests are run in parallel (the -j
+ * option), tests of this suite are run one after another, never
+ * concurrently with each other or with tests of other suites.
+ *
+ * @param name Suite name (a valid C identifier).
+ */
+#define PCUT_TEST_SUITE_SERIAL(name) \
+	PCUT_TEST_SUITE_SERIAL_WITH_NUMBER(name, PCUT_ITEM_COUNTER)
+
 /** Define a set-up function for a test suite.
  *
  * The code of the function immediately follows this macro.
@@ -85,6 +85,9 @@
 
 extern int pcut_run_mode;
 
+/** Number of tests to run concurrently in forking mode. */
+extern int pcut_jobs;
+
 
 pcut_item_t *pcut_fix_list_get_real_head(pcut_item_t *last);
 int pcut_count_tests(pcut_item_t *it);
@@ -98,8 +101,11 @@ int pcut_is_arg_with_number(const char *arg, const char *opt, int *value);
 int pcut_run_test_forking(const char *self_path, pcut_item_t *test);
 int pcut_run_test_forked(pcut_item_t *test);
 int pcut_run_test_single(pcut_item_t *test);
+int pcut_run_suite_parallel(const char *self_path, pcut_item_t *suite,
+		pcut_item_t **last);
 
 int pcut_get_test_timeout(pcut_item_t *test);
+int pcut_is_item_serial(pcut_item_t *item);
 
 void pcut_failed_assertion(const char *message);
 void pcut_print_fail_message(const char *msg);
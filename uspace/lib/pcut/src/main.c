@@ -44,6 +44,9 @@
 /** Current running mode. */
 int pcut_run_mode = PCUT_RUN_MODE_FORKING;
 
+/** Number of tests to run concurrently in forking mode. */
+int pcut_jobs = 1;
+
 /** Empty list to bypass special handling for NULL. */
 static pcut_main_extra_t empty_main_extra[] = {
 	PCUT_MAIN_EXTRA_SET_LAST
@@ -100,8 +103,21 @@ static int run_suite(pcut_item_t *suite, pcut_item_t **last, const char *prog_pa
 	int total_count = 0;
 	int ret_code = PCUT_OUTCOME_PASS;
 	int ret_code_tmp;
+	pcut_item_t *it;
 
-	pcut_item_t *it = pcut_get_real_next(suite);
+#ifdef __helenos__
+	/*
+	 * Run the suite through the parallel runner if the user asked
+	 * for concurrent execution and the suite is not annotated as
+	 * serial-only.
+	 */
+	if ((pcut_run_mode == PCUT_RUN_MODE_FORKING) && (pcut_jobs > 1)
+			&& !pcut_is_item_serial(suite)) {
+		return pcut_run_suite_parallel(prog_path, suite, last);
+	}
+#endif
+
+	it = pcut_get_real_next(suite);
 	if ((it == NULL) || (it->kind == PCUT_KIND_TESTSUITE)) {
 		goto leave_no_print;
 	}
@@ -222,6 +238,7 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 		for (i = 1; i < argc; i++) {
 			pcut_is_arg_with_number(argv[i], "-s", &run_only_suite);
 			pcut_is_arg_with_number(argv[i], "-t", &run_only_test);
+			pcut_is_arg_with_number(argv[i], "-j", &pcut_jobs);
 			if (pcut_str_equals(argv[i], "-l")) {
 				pcut_print_tests(items);
 				return PCUT_OUTCOME_PASS;
@@ -237,6 +254,10 @@ int pcut_main(pcut_item_t *last, int argc, char *argv[]) {
 		}
 	}
 
+	if (pcut_jobs < 1) {
+		pcut_jobs = 1;
+	}
+
 	setvbuf(stdout, NULL, _IONBF, 0);
 	set_setup_teardown_callbacks(items);
 
@@ -90,76 +90,90 @@ void pcut_str_error(int error, char *buffer, int size) {
 /** Maximum size of stdout we are able to capture. */
 #define OUTPUT_BUFFER_SIZE 8192
 
-/** Buffer for assertion and other error messages. */
-static char error_message_buffer[OUTPUT_BUFFER_SIZE];
-
-/** Buffer for stdout from the test. */
-static char extra_output_buffer[OUTPUT_BUFFER_SIZE];
-
-/** Prepare for a new test.
+/** State of a single forked test in flight.
  *
- * @param test Test that is about to be run.
+ * Each concurrently running test owns one slot so that multiple
+ * forked tests can be in progress at the same time.
  */
-static void before_test_start(pcut_item_t *test) {
-	pcut_report_test_start(test);
-
-	memset(error_message_buffer, 0, OUTPUT_BUFFER_SIZE);
-	memset(extra_output_buffer, 0, OUTPUT_BUFFER_SIZE);
-}
-
-/** Mutex guard for forced_termination_cv. */
-static FIBRIL_MUTEX_INITIALIZE(forced_termination_mutex);
-
-/** Condition-variable for checking whether test timed-out. */
-static FIBRIL_CONDVAR_INITIALIZE(forced_termination_cv);
-
-/** Spawned task id. */
-static task_id_t test_task_id;
+typedef struct {
+	/** Mutex guard for timeout_cv. */
+	fibril_mutex_t guard;
+	/** Condition-variable for checking whether test timed-out. */
+	fibril_condvar_t timeout_cv;
+	/** Test that is currently running in this slot. */
+	pcut_item_t *test;
+	/** Spawned task id. */
+	task_id_t task_id;
+	/** Flag whether test is still running.
+	 *
+	 * This flag is used when checking whether test timed-out.
+	 */
+	int running;
+	/** Error message of an internal error (or NULL). */
+	const char *error_message;
+	/** Name of the temporary file capturing stdout of the test. */
+	char tempfile_name[PCUT_TEMP_FILENAME_BUFFER_SIZE];
+	/** Buffer for stdout from the test. */
+	char output[OUTPUT_BUFFER_SIZE];
+} fork_slot_t;
 
-/** Flag whether test is still running.
+/** Initialize a test slot.
  *
- * This flag is used when checking whether test timed-out.
+ * @param slot Slot to initialize.
  */
-static int test_running;
+static void fork_slot_init(fork_slot_t *slot) {
+	fibril_mutex_initialize(&slot->guard);
+	fibril_condvar_initialize(&slot->timeout_cv);
+	slot->test = NULL;
+	slot->running = 0;
+}
 
 /** Main fibril for checking whether test timed-out.
  *
- * @param arg Test that is currently running (pcut_item_t *).
+ * @param arg Slot of the test that is currently running (fork_slot_t *).
  * @return EOK Always.
  */
 static int test_timeout_handler_fibril(void *arg) {
-	pcut_item_t *test = arg;
-	int timeout_sec = pcut_get_test_timeout(test);
+	fork_slot_t *slot = arg;
+	int timeout_sec = pcut_get_test_timeout(slot->test);
 	usec_t timeout_us = SEC2USEC(timeout_sec);
 
-	fibril_mutex_lock(&forced_termination_mutex);
-	if (!test_running) {
+	fibril_mutex_lock(&slot->guard);
+	if (!slot->running) {
 		goto leave_no_kill;
 	}
-	errno_t rc = fibril_condvar_wait_timeout(&forced_termination_cv,
-		&forced_termination_mutex, timeout_us);
+	errno_t rc = fibril_condvar_wait_timeout(&slot->timeout_cv,
+		&slot->guard, timeout_us);
 	if (rc == ETIMEOUT) {
-		task_kill(test_task_id);
+		task_kill(slot->task_id);
 	}
 leave_no_kill:
-	fibril_mutex_unlock(&forced_termination_mutex);
+	fibril_mutex_unlock(&slot->guard);
 	return EOK;
 }
 
-/** Run the test as a new task and report the result.
+/** Run the test as a new task, storing the result in the slot.
+ *
+ * Does not report anything; the caller is responsible for reporting
+ * the outcome together with the captured output in slot->output.
  *
  * @param self_path Path to itself, that is to current binary.
  * @param test Test to be run.
+ * @param slot Slot to run the test in.
+ * @return Test outcome (PCUT_OUTCOME_*).
  */
-int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
-	before_test_start(test);
-
-	char tempfile_name[PCUT_TEMP_FILENAME_BUFFER_SIZE];
-	snprintf(tempfile_name, PCUT_TEMP_FILENAME_BUFFER_SIZE - 1, "pcut_%lld.tmp", (unsigned long long) task_get_id());
+static int run_test_in_task(const char *self_path, pcut_item_t *test,
+		fork_slot_t *slot) {
+	slot->test = test;
+	slot->error_message = NULL;
+	memset(slot->output, 0, OUTPUT_BUFFER_SIZE);
+
+	snprintf(slot->tempfile_name, PCUT_TEMP_FILENAME_BUFFER_SIZE - 1,
+	    "pcut_%lld_%d.tmp", (unsigned long long) task_get_id(), test->id);
 	int tempfile;
-	errno_t rc = vfs_lookup_open(tempfile_name, WALK_REGULAR | WALK_MAY_CREATE, MODE_READ | MODE_WRITE, &tempfile);
+	errno_t rc = vfs_lookup_open(slot->tempfile_name, WALK_REGULAR | WALK_MAY_CREATE, MODE_READ | MODE_WRITE, &tempfile);
 	if (rc != EOK) {
-		pcut_report_test_done(test, PCUT_OUTCOME_INTERNAL_ERROR, "Failed to create temporary file.", NULL, NULL);
+		slot->error_message = "Failed to create temporary file.";
 		return PCUT_OUTCOME_INTERNAL_ERROR;
 	}
 
@@ -175,19 +189,19 @@ int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
 	int status = PCUT_OUTCOME_PASS;
 
 	task_wait_t test_task_wait;
-	rc = task_spawnvf(&test_task_id, &test_task_wait, self_path, arguments,
+	rc = task_spawnvf(&slot->task_id, &test_task_wait, self_path, arguments,
 	    fileno(stdin), tempfile, tempfile);
 	if (rc != EOK) {
 		status = PCUT_OUTCOME_INTERNAL_ERROR;
 		goto leave_close_tempfile;
 	}
 
-	test_running = 1;
+	slot->running = 1;
 
-	fid_t killer_fibril = fibril_create(test_timeout_handler_fibril, test);
+	fid_t killer_fibril = fibril_create(test_timeout_handler_fibril, slot);
 	if (killer_fibril == 0) {
 		/* FIXME: somehow announce this problem. */
-		task_kill(test_task_id);
+		task_kill(slot->task_id);
 	} else {
 		fibril_add_ready(killer_fibril);
 	}
@@ -205,24 +219,323 @@ int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
 		status = task_retval == 0 ? PCUT_OUTCOME_PASS : PCUT_OUTCOME_FAIL;
 	}
 
-	fibril_mutex_lock(&forced_termination_mutex);
-	test_running = 0;
-	fibril_condvar_signal(&forced_termination_cv);
-	fibril_mutex_unlock(&forced_termination_mutex);
+	fibril_mutex_lock(&slot->guard);
+	slot->running = 0;
+	fibril_condvar_signal(&slot->timeout_cv);
+	fibril_mutex_unlock(&slot->guard);
 
 	aoff64_t pos = 0;
 	size_t nread;
-	vfs_read(tempfile, &pos, extra_output_buffer, OUTPUT_BUFFER_SIZE, &nread);
+	vfs_read(tempfile, &pos, slot->output, OUTPUT_BUFFER_SIZE, &nread);
 
 leave_close_tempfile:
 	vfs_put(tempfile);
-	vfs_unlink_path(tempfile_name);
+	vfs_unlink_path(slot->tempfile_name);
 
-	pcut_report_test_done_unparsed(test, status, extra_output_buffer, OUTPUT_BUFFER_SIZE);
+	return status;
+}
+
+/** Report a completed test from a slot.
+ *
+ * @param test Test that was run.
+ * @param status Test outcome (PCUT_OUTCOME_*).
+ * @param slot Slot the test was run in.
+ */
+static void report_test_from_slot(pcut_item_t *test, int status,
+		fork_slot_t *slot) {
+	if (slot->error_message != NULL) {
+		pcut_report_test_done(test, status, slot->error_message,
+		    NULL, NULL);
+	} else {
+		pcut_report_test_done_unparsed(test, status, slot->output,
+		    OUTPUT_BUFFER_SIZE);
+	}
+}
+
+/** Run the test as a new task and report the result.
+ *
+ * @param self_path Path to itself, that is to current binary.
+ * @param test Test to be run.
+ */
+int pcut_run_test_forking(const char *self_path, pcut_item_t *test) {
+	static fork_slot_t slot;
+
+	fork_slot_init(&slot);
+
+	pcut_report_test_start(test);
+
+	int status = run_test_in_task(self_path, test, &slot);
+
+	report_test_from_slot(test, status, &slot);
 
 	return status;
 }
 
+
+/* Parallel execution of forked tests. */
+
+/** Shared state of one parallel suite run. */
+typedef struct {
+	/** Mutex guard for the whole structure. */
+	fibril_mutex_t guard;
+	/** Condition-variable signalled when a test finishes. */
+	fibril_condvar_t done_cv;
+	/** Condition-variable guarding serial-only tests. */
+	fibril_condvar_t serial_cv;
+	/** Path to the current binary. */
+	const char *self_path;
+	/** Tests of the suite, in declaration order. */
+	pcut_item_t **tests;
+	/** Outcome of each test. */
+	int *statuses;
+	/** Captured output of each test (or NULL). */
+	char **outputs;
+	/** Internal error message of each test (or NULL). */
+	const char **error_messages;
+	/** Flag whether given test already finished. */
+	int *finished;
+	/** Number of tests in the suite. */
+	int test_count;
+	/** Index of the next test to hand out to a worker. */
+	int next_test;
+	/** Number of tests currently executing. */
+	int running;
+	/** Flag whether a serial-only test is executing. */
+	int serial_active;
+	/** Number of live worker fibrils. */
+	int workers;
+} parallel_run_t;
+
+/** Worker fibril running tests of a parallel suite run.
+ *
+ * Workers take tests in declaration order, but completion order is
+ * arbitrary; results are stored for the main fibril to report.
+ *
+ * @param arg Shared run state (parallel_run_t *).
+ * @return EOK Always.
+ */
+static int parallel_worker_fibril(void *arg) {
+	parallel_run_t *run = arg;
+	fork_slot_t slot;
+
+	fork_slot_init(&slot);
+
+	fibril_mutex_lock(&run->guard);
+	while (run->next_test < run->test_count) {
+		int index = run->next_test;
+		run->next_test++;
+		pcut_item_t *test = run->tests[index];
+		int serial = pcut_is_item_serial(test);
+
+		/*
+		 * Serial-only tests wait until they are alone; everyone
+		 * waits while a serial-only test is executing.
+		 */
+		while (run->serial_active || (serial && (run->running > 0))) {
+			fibril_condvar_wait(&run->serial_cv, &run->guard);
+		}
+		run->running++;
+		run->serial_active = serial;
+		fibril_mutex_unlock(&run->guard);
+
+		int status = run_test_in_task(run->self_path, test, &slot);
+
+		char *output = NULL;
+		if (slot.error_message == NULL) {
+			output = malloc(OUTPUT_BUFFER_SIZE);
+			if (output != NULL) {
+				memcpy(output, slot.output, OUTPUT_BUFFER_SIZE);
+			} else {
+				status = PCUT_OUTCOME_INTERNAL_ERROR;
+				slot.error_message = "Out of memory when capturing test output.";
+			}
+		}
+
+		fibril_mutex_lock(&run->guard);
+		run->running--;
+		if (serial) {
+			run->serial_active = 0;
+		}
+		fibril_condvar_broadcast(&run->serial_cv);
+
+		run->statuses[index] = status;
+		run->outputs[index] = output;
+		run->error_messages[index] = slot.error_message;
+		run->finished[index] = 1;
+		fibril_condvar_broadcast(&run->done_cv);
+	}
+	run->workers--;
+	fibril_condvar_broadcast(&run->done_cv);
+	fibril_mutex_unlock(&run->guard);
+
+	return EOK;
+}
+
+/** Run all tests of a suite sequentially.
+ *
+ * Fall-back for pcut_run_suite_parallel() when resources for the
+ * parallel machinery cannot be allocated.
+ *
+ * @param self_path Path to the current binary.
+ * @param suite Suite to run.
+ * @return Error code.
+ */
+static int run_suite_sequentially(const char *self_path, pcut_item_t *suite) {
+	int ret_code = PCUT_OUTCOME_PASS;
+	pcut_item_t *it;
+
+	pcut_report_suite_start(suite);
+	for (it = pcut_get_real_next(suite);
+	    (it != NULL) && (it->kind != PCUT_KIND_TESTSUITE);
+	    it = pcut_get_real_next(it)) {
+		if (it->kind != PCUT_KIND_TEST) {
+			continue;
+		}
+		int rc = pcut_run_test_forking(self_path, it);
+		if (rc != PCUT_OUTCOME_PASS) {
+			ret_code = PCUT_OUTCOME_FAIL;
+		}
+	}
+	pcut_report_suite_done(suite);
+
+	return ret_code;
+}
+
+/** Run the whole test suite with multiple tests in flight at once.
+ *
+ * Up to pcut_jobs tests are run concurrently, each as a separate
+ * task. Results are reported in declaration order regardless of
+ * completion order, so the report is deterministic.
+ *
+ * @param self_path Path to the current binary.
+ * @param suite Suite to run.
+ * @param last Pointer to first item after this suite is stored here.
+ * @return Error code.
+ */
+int pcut_run_suite_parallel(const char *self_path, pcut_item_t *suite,
+		pcut_item_t **last) {
+	int ret_code = PCUT_OUTCOME_PASS;
+	int test_count = 0;
+	int i;
+
+	pcut_item_t *it = pcut_get_real_next(suite);
+	while ((it != NULL) && (it->kind != PCUT_KIND_TESTSUITE)) {
+		if (it->kind == PCUT_KIND_TEST) {
+			test_count++;
+		}
+		it = pcut_get_real_next(it);
+	}
+	if (last != NULL) {
+		*last = it;
+	}
+	if (test_count == 0) {
+		return PCUT_OUTCOME_PASS;
+	}
+
+	parallel_run_t run;
+	fibril_mutex_initialize(&run.guard);
+	fibril_condvar_initialize(&run.done_cv);
+	fibril_condvar_initialize(&run.serial_cv);
+	run.self_path = self_path;
+	run.test_count = test_count;
+	run.next_test = 0;
+	run.running = 0;
+	run.serial_active = 0;
+	run.workers = 0;
+
+	run.tests = calloc(test_count, sizeof(pcut_item_t *));
+	run.statuses = calloc(test_count, sizeof(int));
+	run.outputs = calloc(test_count, sizeof(char *));
+	run.error_messages = calloc(test_count, sizeof(const char *));
+	run.finished = calloc(test_count, sizeof(int));
+	if ((run.tests == NULL) || (run.statuses == NULL)
+	    || (run.outputs == NULL) || (run.error_messages == NULL)
+	    || (run.finished == NULL)) {
+		goto leave_fall_back;
+	}
+
+	i = 0;
+	for (it = pcut_get_real_next(suite);
+	    (it != NULL) && (it->kind != PCUT_KIND_TESTSUITE);
+	    it = pcut_get_real_next(it)) {
+		if (it->kind == PCUT_KIND_TEST) {
+			run.tests[i] = it;
+			i++;
+		}
+	}
+
+	int jobs = pcut_jobs;
+	if (jobs > test_count) {
+		jobs = test_count;
+	}
+
+	for (i = 0; i < jobs; i++) {
+		fid_t worker = fibril_create(parallel_worker_fibril, &run);
+		if (worker == 0) {
+			break;
+		}
+		run.workers++;
+		fibril_add_ready(worker);
+	}
+	if (run.workers == 0) {
+		goto leave_fall_back;
+	}
+
+	pcut_report_suite_start(suite);
+
+	/*
+	 * Report finished tests in declaration order, waiting for
+	 * out-of-order stragglers as necessary.
+	 */
+	fibril_mutex_lock(&run.guard);
+	for (i = 0; i < test_count; i++) {
+		while (!run.finished[i]) {
+			fibril_condvar_wait(&run.done_cv, &run.guard);
+		}
+		fibril_mutex_unlock(&run.guard);
+
+		pcut_report_test_start(run.tests[i]);
+		if (run.error_messages[i] != NULL) {
+			pcut_report_test_done(run.tests[i], run.statuses[i],
+			    run.error_messages[i], NULL, NULL);
+		} else {
+			pcut_report_test_done_unparsed(run.tests[i],
+			    run.statuses[i], run.outputs[i], OUTPUT_BUFFER_SIZE);
+		}
+		free(run.outputs[i]);
+		run.outputs[i] = NULL;
+
+		if (run.statuses[i] != PCUT_OUTCOME_PASS) {
+			ret_code = PCUT_OUTCOME_FAIL;
+		}
+
+		fibril_mutex_lock(&run.guard);
+	}
+	while (run.workers > 0) {
+		fibril_condvar_wait(&run.done_cv, &run.guard);
+	}
+	fibril_mutex_unlock(&run.guard);
+
+	pcut_report_suite_done(suite);
+
+	free(run.tests);
+	free(run.statuses);
+	free(run.outputs);
+	free(run.error_messages);
+	free(run.finished);
+
+	return ret_code;
+
+leave_fall_back:
+	free(run.tests);
+	free(run.statuses);
+	free(run.outputs);
+	free(run.error_messages);
+	free(run.finished);
+
+	return run_suite_sequentially(self_path, suite);
+}
+
 void pcut_hook_before_test(pcut_item_t *test) {
 	PCUT_UNUSED(test);
 
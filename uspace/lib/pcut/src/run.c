@@ -301,3 +301,25 @@ int pcut_get_test_timeout(pcut_item_t *test) {
 
 	return timeout;
 }
+
+/** Tell whether given item must not run in parallel with other tests.
+ *
+ * @param item Test or test suite.
+ * @return Whether the item is annotated as serial-only.
+ */
+int pcut_is_item_serial(pcut_item_t *item) {
+	pcut_extra_t *extras = item->extras;
+
+	if (extras == NULL) {
+		return 0;
+	}
+
+	while (extras->type != PCUT_EXTRA_LAST) {
+		if (extras->type == PCUT_EXTRA_SERIAL) {
+			return 1;
+		}
+		extras++;
+	}
+
+	return 0;
+}
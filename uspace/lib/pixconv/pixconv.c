@@ -144,6 +144,84 @@ void pixel2gray_8(void *dst, pixel_t pix)
 	*((uint8_t *) dst) = (red + green + blue) >> 24;
 }
 
+/*
+ * Row variants of the 32-bit converters. Processing a whole span at once
+ * avoids the per-pixel indirect call and yields loops simple enough for
+ * the compiler to vectorize.
+ */
+
+void pixel2argb_8888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2argb_8888(&dp[i], src[i]);
+}
+
+void pixel2abgr_8888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2abgr_8888(&dp[i], src[i]);
+}
+
+void pixel2rgba_8888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2rgba_8888(&dp[i], src[i]);
+}
+
+void pixel2bgra_8888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2bgra_8888(&dp[i], src[i]);
+}
+
+void pixel2rgb_0888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2rgb_0888(&dp[i], src[i]);
+}
+
+void pixel2bgr_0888_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2bgr_0888(&dp[i], src[i]);
+}
+
+void pixel2rgb_8880_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2rgb_8880(&dp[i], src[i]);
+}
+
+void pixel2bgr_8880_row(void *dst, const pixel_t *src, size_t cnt)
+{
+	uint32_t *dp = (uint32_t *) dst;
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		pixel2bgr_8880(&dp[i], src[i]);
+}
+
 void visual_mask_8888(void *dst, bool mask)
 {
 	pixel2abgr_8888(dst, mask ? 0xffffffff : 0);
@@ -38,11 +38,15 @@
 #define SOFTREND_PIXCONV_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <io/pixel.h>
 
 /** Function to render a pixel. */
 typedef void (*pixel2visual_t)(void *, pixel_t);
 
+/** Function to render a row of pixels. */
+typedef void (*pixel2visual_row_t)(void *, const pixel_t *, size_t);
+
 /** Function to render a bit mask. */
 typedef void (*visual_mask_t)(void *, bool);
 
@@ -66,6 +70,15 @@ extern void pixel2rgb_565_le(void *, pixel_t);
 extern void pixel2bgr_323(void *, pixel_t);
 extern void pixel2gray_8(void *, pixel_t);
 
+extern void pixel2argb_8888_row(void *, const pixel_t *, size_t);
+extern void pixel2abgr_8888_row(void *, const pixel_t *, size_t);
+extern void pixel2rgba_8888_row(void *, const pixel_t *, size_t);
+extern void pixel2bgra_8888_row(void *, const pixel_t *, size_t);
+extern void pixel2rgb_0888_row(void *, const pixel_t *, size_t);
+extern void pixel2bgr_0888_row(void *, const pixel_t *, size_t);
+extern void pixel2rgb_8880_row(void *, const pixel_t *, size_t);
+extern void pixel2bgr_8880_row(void *, const pixel_t *, size_t);
+
 extern void visual_mask_8888(void *, bool);
 extern void visual_mask_0888(void *, bool);
 extern void visual_mask_8880(void *, bool);
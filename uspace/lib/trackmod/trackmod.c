@@ -45,7 +45,9 @@
 
 /** Tunables */
 enum {
-	amp_factor = 16
+	amp_factor = 16,
+	/** Frames rendered per channel accumulation pass */
+	render_batch = 128
 };
 
 /** Standard definitions set in stone */
@@ -901,45 +903,67 @@ static void chan_smp_next_frame(trackmod_chan_t *chan)
 	}
 }
 
-/** Render next sample on channel.
+/** Render a batch of samples on one channel into an accumulator.
  *
- * @param modplay Module playback
- * @param cidx    Channel number
- * @return        Sample value
+ * Volume, period and the sample data format cannot change inside a
+ * tick, so they are hoisted out of the per-sample loop. Channels are
+ * independent, so accumulating one channel at a time produces the same
+ * result as rendering sample-major while avoiding the per-sample
+ * dispatch on the sample data format.
+ *
+ * @param modplay  Module playback
+ * @param chan     Channel playback
+ * @param accum    Accumulator the samples are added to
+ * @param nsamples Number of samples to render
  */
-static int trackmod_chan_next_sample(trackmod_modplay_t *modplay,
-    size_t cidx)
+static void trackmod_chan_render(trackmod_modplay_t *modplay,
+    trackmod_chan_t *chan, int32_t *accum, size_t nsamples)
 {
-	int sl, sn;
-	int period, clk;
-	int s;
-
-	trackmod_chan_t *chan = &modplay->chan[cidx];
+	int vol_mul;
+	int clk_inc;
+	int period;
+	int sl, sn, s, clk;
+	bool smp8;
+	size_t i;
 
 	if (chan->sample == NULL || chan->period == 0)
-		return 0;
-
-	/*
-	 * Linear interpolation. Note this is slightly simplified:
-	 * We ignore the half-sample offset and the boundary condition
-	 * at the end of the sample (we should extend with zero).
-	 */
-	sl = (int)chan->lsmp * amp_factor * chan->volume / vol_max;
-	sn = (int)trackmod_sample_get_frame(chan->sample, chan->smp_pos) *
-	    amp_factor * chan->volume / vol_max;
+		return;
 
+	vol_mul = amp_factor * chan->volume;
+	clk_inc = base_clock / modplay->smp_freq;
 	period = (int)chan->period;
-	clk = (int)chan->smp_clk;
+	smp8 = chan->sample->bytes_smp == 1;
+
+	for (i = 0; i < nsamples; i++) {
+		/*
+		 * Linear interpolation. Note this is slightly simplified:
+		 * We ignore the half-sample offset and the boundary condition
+		 * at the end of the sample (we should extend with zero).
+		 */
+		sl = (int)chan->lsmp * vol_mul / vol_max;
+		if (smp8) {
+			sn = ((int8_t *)chan->sample->data)[chan->smp_pos];
+		} else {
+			/* XXX Retain full precision */
+			sn = ((int16_t *)chan->sample->data)[chan->smp_pos] /
+			    256;
+		}
+		sn = sn * vol_mul / vol_max;
 
-	s = (sl * (period - clk) + sn * clk) / period;
+		clk = (int)chan->smp_clk;
+		s = (sl * (period - clk) + sn * clk) / period;
+		accum[i] += s;
 
-	chan->smp_clk += base_clock / modplay->smp_freq;
-	while (chan->sample != NULL && chan->smp_clk >= chan->period) {
-		chan->smp_clk -= chan->period;
-		chan_smp_next_frame(chan);
-	}
+		chan->smp_clk += clk_inc;
+		while (chan->sample != NULL && chan->smp_clk >= chan->period) {
+			chan->smp_clk -= chan->period;
+			chan_smp_next_frame(chan);
+		}
 
-	return s;
+		/* The rest of the batch would only contribute silence. */
+		if (chan->sample == NULL)
+			break;
+	}
 }
 
 /** Render a segment of samples contained entirely within a tick.
@@ -951,20 +975,31 @@ static int trackmod_chan_next_sample(trackmod_modplay_t *modplay,
 static void get_samples_within_tick(trackmod_modplay_t *modplay,
     void *buffer, size_t bufsize)
 {
+	int32_t accum[render_batch];
 	size_t nsamples;
+	size_t done;
+	size_t now;
 	size_t smpidx;
 	size_t chan;
-	int s;
 
 	nsamples = bufsize / modplay->frame_size;
 
-	for (smpidx = 0; smpidx < nsamples; smpidx++) {
-		s = 0;
+	done = 0;
+	while (done < nsamples) {
+		now = min(nsamples - done, render_batch);
+
+		for (smpidx = 0; smpidx < now; smpidx++)
+			accum[smpidx] = 0;
+
 		for (chan = 0; chan < modplay->module->channels; chan++) {
-			s += trackmod_chan_next_sample(modplay, chan);
+			trackmod_chan_render(modplay, &modplay->chan[chan],
+			    accum, now);
 		}
 
-		((int16_t *)buffer)[smpidx] = s;
+		for (smpidx = 0; smpidx < now; smpidx++)
+			((int16_t *)buffer)[done + smpidx] = accum[smpidx];
+
+		done += now;
 	}
 
 	modplay->smp += nsamples;
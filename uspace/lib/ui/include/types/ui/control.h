@@ -37,6 +37,7 @@
 #define _UI_TYPES_CONTROL_H
 
 #include <errno.h>
+#include <gfx/coord.h>
 #include <io/kbd_event.h>
 #include <io/pos_event.h>
 #include <types/ui/event.h>
@@ -50,6 +51,8 @@ typedef struct ui_control_ops {
 	void (*destroy)(void *);
 	/** Paint */
 	errno_t (*paint)(void *);
+	/** Paint only parts intersecting a damage rectangle (optional) */
+	errno_t (*paint_rect)(void *, gfx_rect_t *);
 	/** Keyboard event */
 	ui_evclaim_t (*kbd_event)(void *, kbd_event_t *);
 	/** Position event */
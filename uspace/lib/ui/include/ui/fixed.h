@@ -48,6 +48,7 @@ extern ui_control_t *ui_fixed_ctl(ui_fixed_t *);
 extern errno_t ui_fixed_add(ui_fixed_t *, ui_control_t *);
 extern void ui_fixed_remove(ui_fixed_t *, ui_control_t *);
 extern errno_t ui_fixed_paint(ui_fixed_t *);
+extern errno_t ui_fixed_paint_rect(ui_fixed_t *, gfx_rect_t *);
 extern ui_evclaim_t ui_fixed_kbd_event(ui_fixed_t *, kbd_event_t *);
 extern ui_evclaim_t ui_fixed_pos_event(ui_fixed_t *, pos_event_t *);
 extern void ui_fixed_unfocus(ui_fixed_t *);
@@ -55,12 +55,14 @@ enum {
 
 static void ui_checkbox_ctl_destroy(void *);
 static errno_t ui_checkbox_ctl_paint(void *);
+static errno_t ui_checkbox_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_checkbox_ctl_pos_event(void *, pos_event_t *);
 
 /** Check box control ops */
 ui_control_ops_t ui_checkbox_ops = {
 	.destroy = ui_checkbox_ctl_destroy,
 	.paint = ui_checkbox_ctl_paint,
+	.paint_rect = ui_checkbox_ctl_paint_rect,
 	.pos_event = ui_checkbox_ctl_pos_event
 };
 
@@ -363,6 +365,27 @@ errno_t ui_checkbox_ctl_paint(void *arg)
 	return ui_checkbox_paint(checkbox);
 }
 
+/** Paint check box control parts intersecting a damage rectangle.
+ *
+ * The check box is repainted only if the damage rectangle
+ * intersects its bounds.
+ *
+ * @param arg Argument (ui_checkbox_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_checkbox_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_checkbox_t *checkbox = (ui_checkbox_t *) arg;
+	gfx_rect_t irect;
+
+	gfx_rect_clip(rect, &checkbox->rect, &irect);
+	if (gfx_rect_is_empty(&irect))
+		return EOK;
+
+	return ui_checkbox_paint(checkbox);
+}
+
 /** Handle check box control position event.
  *
  * @param arg Argument (ui_checkbox_t *)
@@ -115,6 +115,23 @@ errno_t ui_control_paint(ui_control_t *control)
 	return control->ops->paint(control->ext);
 }
 
+/** Paint parts of UI control intersecting a damage rectangle.
+ *
+ * Controls that do not implement the @c paint_rect operation are
+ * repainted in full.
+ *
+ * @param control Control
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_control_paint_rect(ui_control_t *control, gfx_rect_t *rect)
+{
+	if (control->ops->paint_rect != NULL)
+		return control->ops->paint_rect(control->ext, rect);
+
+	return control->ops->paint(control->ext);
+}
+
 /** Deliver position event to UI control.
  *
  * @param control Control
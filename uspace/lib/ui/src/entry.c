@@ -52,6 +52,7 @@
 
 static void ui_entry_ctl_destroy(void *);
 static errno_t ui_entry_ctl_paint(void *);
+static errno_t ui_entry_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_entry_ctl_kbd_event(void *, kbd_event_t *);
 static ui_evclaim_t ui_entry_ctl_pos_event(void *, pos_event_t *);
 
@@ -66,6 +67,7 @@ enum {
 ui_control_ops_t ui_entry_ops = {
 	.destroy = ui_entry_ctl_destroy,
 	.paint = ui_entry_ctl_paint,
+	.paint_rect = ui_entry_ctl_paint_rect,
 	.kbd_event = ui_entry_ctl_kbd_event,
 	.pos_event = ui_entry_ctl_pos_event
 };
@@ -303,6 +305,27 @@ errno_t ui_entry_ctl_paint(void *arg)
 	return ui_entry_paint(entry);
 }
 
+/** Paint text entry control parts intersecting a damage rectangle.
+ *
+ * The text entry is repainted only if the damage rectangle
+ * intersects its bounds.
+ *
+ * @param arg Argument (ui_entry_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_entry_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_entry_t *entry = (ui_entry_t *) arg;
+	gfx_rect_t irect;
+
+	gfx_rect_clip(rect, &entry->rect, &irect);
+	if (gfx_rect_is_empty(&irect))
+		return EOK;
+
+	return ui_entry_paint(entry);
+}
+
 /** Insert string at cursor position.
  *
  * @param entry Text entry
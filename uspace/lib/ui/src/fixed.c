@@ -45,6 +45,7 @@
 
 static void ui_fixed_ctl_destroy(void *);
 static errno_t ui_fixed_ctl_paint(void *);
+static errno_t ui_fixed_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_fixed_ctl_kbd_event(void *, kbd_event_t *);
 static ui_evclaim_t ui_fixed_ctl_pos_event(void *, pos_event_t *);
 static void ui_fixed_ctl_unfocus(void *);
@@ -53,6 +54,7 @@ static void ui_fixed_ctl_unfocus(void *);
 ui_control_ops_t ui_fixed_ops = {
 	.destroy = ui_fixed_ctl_destroy,
 	.paint = ui_fixed_ctl_paint,
+	.paint_rect = ui_fixed_ctl_paint_rect,
 	.kbd_event = ui_fixed_ctl_kbd_event,
 	.pos_event = ui_fixed_ctl_pos_event,
 	.unfocus = ui_fixed_ctl_unfocus
@@ -212,6 +214,33 @@ errno_t ui_fixed_paint(ui_fixed_t *fixed)
 	return EOK;
 }
 
+/** Paint parts of fixed layout intersecting a damage rectangle.
+ *
+ * The damage rectangle is propagated to each element; elements that
+ * know their bounds skip painting entirely when they do not intersect
+ * it.
+ *
+ * @param fixed Fixed layout
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_fixed_paint_rect(ui_fixed_t *fixed, gfx_rect_t *rect)
+{
+	ui_fixed_elem_t *elem;
+	errno_t rc;
+
+	elem = ui_fixed_first(fixed);
+	while (elem != NULL) {
+		rc = ui_control_paint_rect(elem->control, rect);
+		if (rc != EOK)
+			return rc;
+
+		elem = ui_fixed_next(elem);
+	}
+
+	return EOK;
+}
+
 /** Handle fixed layout keyboard event.
  *
  * @param fixed Fixed layout
@@ -297,6 +326,19 @@ errno_t ui_fixed_ctl_paint(void *arg)
 	return ui_fixed_paint(fixed);
 }
 
+/** Paint fixed layout control parts intersecting a damage rectangle.
+ *
+ * @param arg Argument (ui_fixed_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_fixed_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_fixed_t *fixed = (ui_fixed_t *) arg;
+
+	return ui_fixed_paint_rect(fixed, rect);
+}
+
 /** Handle fixed layout control keyboard event.
  *
  * @param arg Argument (ui_fixed_t *)
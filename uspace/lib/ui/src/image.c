@@ -49,12 +49,14 @@
 
 static void ui_image_ctl_destroy(void *);
 static errno_t ui_image_ctl_paint(void *);
+static errno_t ui_image_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_image_ctl_pos_event(void *, pos_event_t *);
 
 /** Image control ops */
 ui_control_ops_t ui_image_ops = {
 	.destroy = ui_image_ctl_destroy,
 	.paint = ui_image_ctl_paint,
+	.paint_rect = ui_image_ctl_paint_rect,
 	.pos_event = ui_image_ctl_pos_event
 };
 
@@ -224,6 +226,27 @@ errno_t ui_image_ctl_paint(void *arg)
 	return ui_image_paint(image);
 }
 
+/** Paint image control parts intersecting a damage rectangle.
+ *
+ * The image is repainted only if the damage rectangle
+ * intersects its bounds.
+ *
+ * @param arg Argument (ui_image_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_image_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_image_t *image = (ui_image_t *) arg;
+	gfx_rect_t irect;
+
+	gfx_rect_clip(rect, &image->rect, &irect);
+	if (gfx_rect_is_empty(&irect))
+		return EOK;
+
+	return ui_image_paint(image);
+}
+
 /** Handle image control position event.
  *
  * @param arg Argument (ui_image_t *)
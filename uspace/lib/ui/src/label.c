@@ -47,12 +47,14 @@
 
 static void ui_label_ctl_destroy(void *);
 static errno_t ui_label_ctl_paint(void *);
+static errno_t ui_label_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_label_ctl_pos_event(void *, pos_event_t *);
 
 /** Label control ops */
 ui_control_ops_t ui_label_ops = {
 	.destroy = ui_label_ctl_destroy,
 	.paint = ui_label_ctl_paint,
+	.paint_rect = ui_label_ctl_paint_rect,
 	.pos_event = ui_label_ctl_pos_event
 };
 
@@ -232,6 +234,27 @@ errno_t ui_label_ctl_paint(void *arg)
 	return ui_label_paint(label);
 }
 
+/** Paint label control parts intersecting a damage rectangle.
+ *
+ * The label is repainted only if the damage rectangle
+ * intersects its bounds.
+ *
+ * @param arg Argument (ui_label_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_label_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_label_t *label = (ui_label_t *) arg;
+	gfx_rect_t irect;
+
+	gfx_rect_clip(rect, &label->rect, &irect);
+	if (gfx_rect_is_empty(&irect))
+		return EOK;
+
+	return ui_label_paint(label);
+}
+
 /** Handle label control position event.
  *
  * @param arg Argument (ui_label_t *)
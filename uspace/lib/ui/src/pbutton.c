@@ -55,12 +55,14 @@ enum {
 
 static void ui_pbutton_ctl_destroy(void *);
 static errno_t ui_pbutton_ctl_paint(void *);
+static errno_t ui_pbutton_ctl_paint_rect(void *, gfx_rect_t *);
 static ui_evclaim_t ui_pbutton_ctl_pos_event(void *, pos_event_t *);
 
 /** Push button control ops */
 ui_control_ops_t ui_pbutton_ops = {
 	.destroy = ui_pbutton_ctl_destroy,
 	.paint = ui_pbutton_ctl_paint,
+	.paint_rect = ui_pbutton_ctl_paint_rect,
 	.pos_event = ui_pbutton_ctl_pos_event
 };
 
@@ -548,6 +550,27 @@ errno_t ui_pbutton_ctl_paint(void *arg)
 	return ui_pbutton_paint(pbutton);
 }
 
+/** Paint push button control parts intersecting a damage rectangle.
+ *
+ * The push button is repainted only if the damage rectangle
+ * intersects its bounds.
+ *
+ * @param arg Argument (ui_pbutton_t *)
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_pbutton_ctl_paint_rect(void *arg, gfx_rect_t *rect)
+{
+	ui_pbutton_t *pbutton = (ui_pbutton_t *) arg;
+	gfx_rect_t irect;
+
+	gfx_rect_clip(rect, &pbutton->rect, &irect);
+	if (gfx_rect_is_empty(&irect))
+		return EOK;
+
+	return ui_pbutton_paint(pbutton);
+}
+
 /** Handle push button control position event.
  *
  * @param arg Argument (ui_pbutton_t *)
@@ -670,6 +670,47 @@ errno_t ui_window_paint(ui_window_t *window)
 	return ui_window_send_paint(window);
 }
 
+/** Repaint only the parts of a window intersecting a damage rectangle.
+ *
+ * Fills the damaged part of the application area with the background
+ * and propagates the rectangle to the controls, so controls lying
+ * entirely outside of it are not repainted at all. Useful for
+ * frequently updating applications that know which small part of the
+ * window changed.
+ *
+ * @param window Window
+ * @param rect Damage rectangle
+ * @return EOK on success or an error code
+ */
+errno_t ui_window_paint_rect(ui_window_t *window, gfx_rect_t *rect)
+{
+	gfx_rect_t app_rect;
+	gfx_rect_t drect;
+	errno_t rc;
+
+	ui_window_get_app_rect(window, &app_rect);
+	gfx_rect_clip(rect, &app_rect, &drect);
+	if (gfx_rect_is_empty(&drect))
+		return EOK;
+
+	rc = gfx_set_color(window->gc, window->res->wnd_face_color);
+	if (rc != EOK)
+		return rc;
+
+	rc = gfx_fill_rect(window->gc, &drect);
+	if (rc != EOK)
+		return rc;
+
+	if (window->control != NULL)
+		return ui_control_paint_rect(window->control, &drect);
+
+	rc = gfx_update(window->res->gc);
+	if (rc != EOK)
+		return rc;
+
+	return EOK;
+}
+
 /** Handle window close event. */
 static void dwnd_close_event(void *arg)
 {
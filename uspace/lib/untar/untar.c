@@ -30,16 +30,79 @@
  * @{
  */
 /** @file
+ *
+ * Extraction is pipelined. A read-ahead fibril keeps a small ring of
+ * large buffers filled from the archive so that parsing does not wait
+ * for the source, file payloads are written in large batches rather
+ * than one tar block at a time, and small files are handed off to a
+ * pool of writer fibrils so that creating, filling and closing them
+ * overlaps with reading the next archive entries.
  */
 
+#include <adt/list.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <str.h>
 #include <str_error.h>
 #include <vfs/vfs.h>
 #include "private/tar.h"
 #include "untar.h"
 
+/** Size and number of read-ahead buffers */
+#define RING_BUF_SIZE (64 * 1024)
+#define RING_BUFS 4
+
+/** Number of writer fibrils */
+#define NWRITERS 4
+
+/** Largest file payload handed off to a writer fibril */
+#define ASYNC_FILE_MAX (512 * 1024)
+
+/** Cap on payload bytes queued for the writers */
+#define QUEUE_BYTES_MAX (2 * 1024 * 1024)
+
+/** Read-ahead ring filled from the archive by a producer fibril */
+typedef struct {
+	tar_file_t *tar;	/**< Underlying archive */
+	uint8_t *bufs[RING_BUFS];	/**< Ring of read buffers */
+	size_t len[RING_BUFS];	/**< Valid bytes in each buffer */
+	size_t pos;		/**< Consumer position in head buffer */
+	unsigned head;		/**< Buffer being consumed */
+	unsigned count;		/**< Number of filled buffers */
+	bool eof;		/**< Producer hit end of archive */
+	bool stop;		/**< Consumer is bailing out early */
+	bool running;		/**< Producer fibril is alive */
+	fibril_mutex_t lock;	/**< Protects the ring state */
+	fibril_condvar_t filled_cv;	/**< A buffer was filled */
+	fibril_condvar_t empty_cv;	/**< A buffer was consumed */
+} untar_ring_t;
+
+/** One file extraction handed off to the writer pool */
+typedef struct {
+	link_t link;		/**< Link to untar_pool_t.queue */
+	tar_file_t *tar;	/**< Archive (for error reporting) */
+	char filename[100];	/**< Destination file name */
+	size_t size;		/**< Payload size in bytes */
+	void *data;		/**< Payload, owned by the writer */
+} untar_work_t;
+
+/** Shared state of the writer fibril pool */
+typedef struct {
+	fibril_mutex_t lock;	/**< Protects all pool state */
+	fibril_condvar_t work_cv;	/**< Work queued or shutting down */
+	fibril_condvar_t done_cv;	/**< Work finished or writer exited */
+	list_t queue;		/**< Queued untar_work_t items */
+	size_t queued_bytes;	/**< Payload bytes queued or in flight */
+	unsigned nwriters;	/**< Writer fibrils still running */
+	bool stop;		/**< Writers exit once the queue drains */
+	errno_t rc;		/**< First error hit by a writer */
+} untar_pool_t;
+
 static size_t get_block_count(size_t bytes)
 {
 	return (bytes + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
@@ -70,13 +133,197 @@ static void tar_report(tar_file_t *tar, const char *fmt, ...)
 	va_end(args);
 }
 
-static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
+/** Keep the read-ahead ring filled (fibril entry point). */
+static errno_t untar_ring_fibril(void *arg)
+{
+	untar_ring_t *ring = arg;
+
+	fibril_mutex_lock(&ring->lock);
+	while (!ring->stop) {
+		if (ring->count >= RING_BUFS) {
+			fibril_condvar_wait(&ring->empty_cv, &ring->lock);
+			continue;
+		}
+
+		unsigned slot = (ring->head + ring->count) % RING_BUFS;
+
+		/*
+		 * The slot is not visible to the consumer until count is
+		 * incremented, so it is safe to fill it unlocked.
+		 */
+		fibril_mutex_unlock(&ring->lock);
+		size_t nread = tar_read(ring->tar, ring->bufs[slot],
+		    RING_BUF_SIZE);
+		fibril_mutex_lock(&ring->lock);
+
+		ring->len[slot] = nread;
+		if (nread > 0)
+			ring->count++;
+
+		if (nread < RING_BUF_SIZE) {
+			ring->eof = true;
+			break;
+		}
+
+		fibril_condvar_signal(&ring->filled_cv);
+	}
+
+	ring->running = false;
+	fibril_condvar_broadcast(&ring->filled_cv);
+	fibril_mutex_unlock(&ring->lock);
+	return EOK;
+}
+
+/** Read from the archive through the read-ahead ring.
+ *
+ * @return Number of bytes read; less than @a size only at the end of
+ *         the archive.
+ */
+static size_t untar_ring_read(untar_ring_t *ring, void *data, size_t size)
+{
+	uint8_t *dst = data;
+	size_t copied = 0;
+
+	fibril_mutex_lock(&ring->lock);
+	while (copied < size) {
+		if (ring->count == 0) {
+			if (ring->eof && !ring->running)
+				break;
+			fibril_condvar_wait(&ring->filled_cv, &ring->lock);
+			continue;
+		}
+
+		size_t avail = ring->len[ring->head] - ring->pos;
+		size_t now = min(avail, size - copied);
+
+		memcpy(dst + copied, ring->bufs[ring->head] + ring->pos, now);
+		copied += now;
+		ring->pos += now;
+
+		if (ring->pos >= ring->len[ring->head]) {
+			ring->pos = 0;
+			ring->head = (ring->head + 1) % RING_BUFS;
+			ring->count--;
+			fibril_condvar_signal(&ring->empty_cv);
+		}
+	}
+	fibril_mutex_unlock(&ring->lock);
+
+	return copied;
+}
+
+/** Shut the read-ahead ring down and free its buffers. */
+static void untar_ring_fini(untar_ring_t *ring)
+{
+	fibril_mutex_lock(&ring->lock);
+	ring->stop = true;
+	fibril_condvar_broadcast(&ring->empty_cv);
+	while (ring->running)
+		fibril_condvar_wait(&ring->filled_cv, &ring->lock);
+	fibril_mutex_unlock(&ring->lock);
+
+	for (unsigned i = 0; i < RING_BUFS; i++)
+		free(ring->bufs[i]);
+}
+
+/** Create one file and write its whole payload in a single batch. */
+static errno_t untar_write_file(tar_file_t *tar, const char *filename,
+    const void *data, size_t size)
+{
+	// FIXME: create the directory first
+
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL) {
+		tar_report(tar, "Failed to create %s: %s.\n", filename,
+		    str_error(errno));
+		return errno;
+	}
+
+	errno_t rc = EOK;
+	if (size > 0 && fwrite(data, 1, size, file) != size) {
+		rc = errno;
+		tar_report(tar, "Failed to write to %s: %s.\n", filename,
+		    str_error(rc));
+	}
+
+	fclose(file);
+	return rc;
+}
+
+/** Extract queued files (writer fibril entry point). */
+static errno_t untar_writer_fibril(void *arg)
+{
+	untar_pool_t *pool = arg;
+
+	fibril_mutex_lock(&pool->lock);
+	while (true) {
+		if (list_empty(&pool->queue)) {
+			if (pool->stop)
+				break;
+			fibril_condvar_wait(&pool->work_cv, &pool->lock);
+			continue;
+		}
+
+		untar_work_t *work = list_get_instance(
+		    list_first(&pool->queue), untar_work_t, link);
+		list_remove(&work->link);
+		fibril_mutex_unlock(&pool->lock);
+
+		errno_t rc = untar_write_file(work->tar, work->filename,
+		    work->data, work->size);
+
+		fibril_mutex_lock(&pool->lock);
+		pool->queued_bytes -= work->size;
+		if (rc != EOK && pool->rc == EOK)
+			pool->rc = rc;
+		fibril_condvar_broadcast(&pool->done_cv);
+
+		free(work->data);
+		free(work);
+	}
+
+	pool->nwriters--;
+	fibril_condvar_broadcast(&pool->done_cv);
+	fibril_mutex_unlock(&pool->lock);
+	return EOK;
+}
+
+/** Wait for the writers to finish and collect their result. */
+static errno_t untar_pool_fini(untar_pool_t *pool)
+{
+	fibril_mutex_lock(&pool->lock);
+	pool->stop = true;
+	fibril_condvar_broadcast(&pool->work_cv);
+	while (pool->nwriters > 0)
+		fibril_condvar_wait(&pool->done_cv, &pool->lock);
+	errno_t rc = pool->rc;
+	fibril_mutex_unlock(&pool->lock);
+
+	return rc;
+}
+
+/** Queue a file payload for a writer fibril, with backpressure. */
+static void untar_pool_enqueue(untar_pool_t *pool, untar_work_t *work)
+{
+	fibril_mutex_lock(&pool->lock);
+	while (pool->queued_bytes > 0 &&
+	    pool->queued_bytes + work->size > QUEUE_BYTES_MAX)
+		fibril_condvar_wait(&pool->done_cv, &pool->lock);
+
+	list_append(&work->link, &pool->queue);
+	pool->queued_bytes += work->size;
+	fibril_condvar_signal(&pool->work_cv);
+	fibril_mutex_unlock(&pool->lock);
+}
+
+static errno_t tar_skip_blocks(untar_ring_t *ring, size_t valid_data_size)
 {
 	size_t blocks_to_read = get_block_count(valid_data_size);
 
 	while (blocks_to_read > 0) {
 		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
+		size_t actually_read = untar_ring_read(ring, block,
+		    TAR_BLOCK_SIZE);
 		if (actually_read != TAR_BLOCK_SIZE)
 			return errno;
 
@@ -86,7 +333,11 @@ static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
 	return EOK;
 }
 
-static errno_t tar_handle_normal_file(tar_file_t *tar,
+/** Extract one file, writing its payload in large batches inline.
+ *
+ * Used for payloads too large to buffer for the writer pool.
+ */
+static errno_t tar_handle_large_file(tar_file_t *tar, untar_ring_t *ring,
     const tar_header_t *header)
 {
 	// FIXME: create the directory first
@@ -98,25 +349,29 @@ static errno_t tar_handle_normal_file(tar_file_t *tar,
 		return errno;
 	}
 
+	uint8_t *chunk = malloc(RING_BUF_SIZE);
+	if (chunk == NULL) {
+		fclose(file);
+		return ENOMEM;
+	}
+
 	errno_t rc = EOK;
 	size_t bytes_remaining = header->size;
-	size_t blocks = get_block_count(bytes_remaining);
+	size_t padded_remaining = get_block_count(header->size) *
+	    TAR_BLOCK_SIZE;
 
-	while (blocks > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE) {
+	while (padded_remaining > 0) {
+		size_t now = min(padded_remaining, (size_t) RING_BUF_SIZE);
+		size_t actually_read = untar_ring_read(ring, chunk, now);
+		if (actually_read != now) {
 			rc = errno;
 			tar_report(tar, "Failed to read block for %s: %s.\n",
 			    header->filename, str_error(rc));
 			break;
 		}
 
-		size_t to_write = TAR_BLOCK_SIZE;
-		if (bytes_remaining < TAR_BLOCK_SIZE)
-			to_write = bytes_remaining;
-
-		size_t actually_written = fwrite(block, 1, to_write, file);
+		size_t to_write = min(bytes_remaining, now);
+		size_t actually_written = fwrite(chunk, 1, to_write, file);
 		if (actually_written != to_write) {
 			rc = errno;
 			tar_report(tar, "Failed to write to %s: %s.\n",
@@ -124,15 +379,57 @@ static errno_t tar_handle_normal_file(tar_file_t *tar,
 			break;
 		}
 
-		blocks--;
-		bytes_remaining -= TAR_BLOCK_SIZE;
+		padded_remaining -= now;
+		bytes_remaining -= to_write;
 	}
 
+	free(chunk);
 	fclose(file);
 	return rc;
 }
 
-static errno_t tar_handle_directory(tar_file_t *tar, const tar_header_t *header)
+static errno_t tar_handle_normal_file(tar_file_t *tar, untar_ring_t *ring,
+    untar_pool_t *pool, const tar_header_t *header)
+{
+	size_t padded = get_block_count(header->size) * TAR_BLOCK_SIZE;
+
+	if (header->size > ASYNC_FILE_MAX)
+		return tar_handle_large_file(tar, ring, header);
+
+	/*
+	 * Small file: buffer the whole payload and let a writer fibril
+	 * create and fill it while we move on to the next entry.
+	 */
+	untar_work_t *work = malloc(sizeof(untar_work_t));
+	if (work == NULL)
+		return tar_handle_large_file(tar, ring, header);
+
+	work->data = malloc(padded > 0 ? padded : 1);
+	if (work->data == NULL) {
+		free(work);
+		return tar_handle_large_file(tar, ring, header);
+	}
+
+	size_t actually_read = untar_ring_read(ring, work->data, padded);
+	if (actually_read != padded) {
+		errno_t rc = errno;
+		tar_report(tar, "Failed to read block for %s: %s.\n",
+		    header->filename, str_error(rc));
+		free(work->data);
+		free(work);
+		return rc;
+	}
+
+	work->tar = tar;
+	work->size = header->size;
+	str_cpy(work->filename, sizeof(work->filename), header->filename);
+
+	untar_pool_enqueue(pool, work);
+	return EOK;
+}
+
+static errno_t tar_handle_directory(tar_file_t *tar, untar_ring_t *ring,
+    const tar_header_t *header)
 {
 	errno_t rc = vfs_link_path(header->filename, KIND_DIRECTORY, NULL);
 	if (rc != EOK) {
@@ -143,20 +440,76 @@ static errno_t tar_handle_directory(tar_file_t *tar, const tar_header_t *header)
 		}
 	}
 
-	return tar_skip_blocks(tar, header->size);
+	return tar_skip_blocks(ring, header->size);
 }
 
 int untar(tar_file_t *tar)
 {
+	untar_ring_t ring;
+	untar_pool_t pool;
+	fid_t fid;
+	unsigned i;
+
 	int rc = tar_open(tar);
 	if (rc != EOK) {
 		tar_report(tar, "Failed to open: %s.\n", str_error(rc));
 		return rc;
 	}
 
+	memset(&ring, 0, sizeof(ring));
+	ring.tar = tar;
+	fibril_mutex_initialize(&ring.lock);
+	fibril_condvar_initialize(&ring.filled_cv);
+	fibril_condvar_initialize(&ring.empty_cv);
+
+	for (i = 0; i < RING_BUFS; i++) {
+		ring.bufs[i] = malloc(RING_BUF_SIZE);
+		if (ring.bufs[i] == NULL) {
+			while (i > 0)
+				free(ring.bufs[--i]);
+			tar_close(tar);
+			return ENOMEM;
+		}
+	}
+
+	fid = fibril_create(untar_ring_fibril, &ring);
+	if (fid == 0) {
+		untar_ring_fini(&ring);
+		tar_close(tar);
+		return ENOMEM;
+	}
+
+	ring.running = true;
+	fibril_add_ready(fid);
+
+	fibril_mutex_initialize(&pool.lock);
+	fibril_condvar_initialize(&pool.work_cv);
+	fibril_condvar_initialize(&pool.done_cv);
+	list_initialize(&pool.queue);
+	pool.queued_bytes = 0;
+	pool.nwriters = 0;
+	pool.stop = false;
+	pool.rc = EOK;
+
+	for (i = 0; i < NWRITERS; i++) {
+		fid = fibril_create(untar_writer_fibril, &pool);
+		if (fid == 0)
+			break;
+		pool.nwriters++;
+		fibril_add_ready(fid);
+	}
+
+	if (pool.nwriters == 0) {
+		/* No writers; shut the producer down and give up */
+		untar_ring_fini(&ring);
+		tar_close(tar);
+		return ENOMEM;
+	}
+
 	while (true) {
 		tar_header_raw_t header_raw;
-		size_t header_ok = tar_read(tar, &header_raw, sizeof(header_raw));
+		size_t header_ok = untar_ring_read(&ring, &header_raw,
+		    sizeof(header_raw));
 		if (header_ok != sizeof(header_raw))
 			break;
 
@@ -172,20 +525,31 @@ int untar(tar_file_t *tar)
 
 		switch (header.type) {
 		case TAR_TYPE_DIRECTORY:
-			rc = tar_handle_directory(tar, &header);
+			rc = tar_handle_directory(tar, &ring, &header);
 			break;
 		case TAR_TYPE_NORMAL:
-			rc = tar_handle_normal_file(tar, &header);
+			rc = tar_handle_normal_file(tar, &ring, &pool,
+			    &header);
 			break;
 		default:
-			rc = tar_skip_blocks(tar, header.size);
+			rc = tar_skip_blocks(&ring, header.size);
 			break;
 		}
 
 		if (rc != EOK)
 			break;
+
+		/* Stop early if a writer fibril hit an error */
+		fibril_mutex_lock(&pool.lock);
+		rc = pool.rc;
+		fibril_mutex_unlock(&pool.lock);
+		if (rc != EOK)
+			break;
 	}
 
+	(void) untar_pool_fini(&pool);
+	untar_ring_fini(&ring);
+
 	tar_close(tar);
 	return EOK;
 }
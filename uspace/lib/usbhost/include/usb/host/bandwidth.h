@@ -39,6 +39,7 @@
 
 #include <usb/usb.h>
 
+#include <errno.h>
 #include <stddef.h>
 
 typedef struct endpoint endpoint_t;
@@ -53,6 +54,18 @@ typedef struct {
 extern const bandwidth_accounting_t bandwidth_accounting_usb11;
 extern const bandwidth_accounting_t bandwidth_accounting_usb2;
 
+/**
+ * Number of periodic schedule slots tracked per bus. One slot corresponds to
+ * one service window of the accounting in use - a frame for USB 1.1, a
+ * microframe for USB 2.
+ */
+#define BANDWIDTH_SLOTS 32
+
+extern errno_t bandwidth_reserve_slots(const bandwidth_accounting_t *,
+    size_t *, endpoint_t *);
+extern void bandwidth_release_slots(const bandwidth_accounting_t *,
+    size_t *, endpoint_t *);
+
 #endif
 /**
  * @}
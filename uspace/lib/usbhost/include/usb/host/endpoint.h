@@ -112,6 +112,16 @@ typedef struct endpoint {
 	 */
 	unsigned packets_per_uframe;
 
+	/** Service interval as found in the descriptor (bInterval) */
+	unsigned interval;
+
+	/**
+	 * Phase within the periodic schedule assigned by the bandwidth
+	 * reservation. HC drivers may use it to balance periodic endpoints
+	 * across the frames of their schedule.
+	 */
+	unsigned scheduled_phase;
+
 	/* This structure is meant to be extended by overriding. */
 } endpoint_t;
 
@@ -53,8 +53,8 @@ typedef struct usb2_bus_helper {
 	/** The last reserved address */
 	usb_address_t last_address;
 
-	/** Size of the bandwidth pool */
-	size_t free_bw;
+	/** Bandwidth reserved in each periodic schedule slot */
+	size_t slot_bw[BANDWIDTH_SLOTS];
 
 	/* Configured bandwidth accounting */
 	const bandwidth_accounting_t *bw_accounting;
@@ -35,6 +35,9 @@
  */
 
 #include <assert.h>
+#include <errno.h>
+#include <macros.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "endpoint.h"
@@ -120,7 +123,9 @@ const bandwidth_accounting_t bandwidth_accounting_usb11 = {
  * Calculate bandwidth that needs to be reserved for communication with EP.
  * Calculation follows USB 2.0 specification, chapter 5.11.3.
  *
- * FIXME: Interrupt transfers shall be probably divided by their polling interval.
+ * The returned time is the cost of a single service opportunity. The polling
+ * interval is taken into account by the slot-based reservation, which charges
+ * only the slots in which the endpoint is actually serviced.
  *
  * @param ep An endpoint for which the bandwidth is to be counted
  * @return Number of nanoseconds transaction with @c size bytes payload will
@@ -179,3 +184,124 @@ const bandwidth_accounting_t bandwidth_accounting_usb2 = {
 	.available_bandwidth = BANDWIDTH_AVAILABLE_USB2,
 	.count_bw = &bandwidth_count_usb2,
 };
+
+/**
+ * Determine the service interval of an endpoint in schedule slots.
+ *
+ * The interval is rounded down to a power of two, so that the schedule
+ * repeats regularly within the tracked window, and clamped to the window
+ * size.
+ *
+ * @param ep The endpoint in question
+ * @return Service interval in slots, a power of two in [1, BANDWIDTH_SLOTS].
+ */
+static unsigned bandwidth_slot_interval(endpoint_t *ep)
+{
+	unsigned interval = ep->interval;
+
+	/*
+	 * High-speed and faster devices encode the interval as
+	 * 2^(n-1) (micro)frames.
+	 */
+	if (ep->device->speed >= USB_SPEED_HIGH) {
+		if (interval > 16)
+			interval = 16;
+		interval = interval > 0 ? 1 << (interval - 1) : 1;
+	}
+
+	if (interval == 0)
+		interval = 1;
+
+	/* Round down to a power of two */
+	while ((interval & (interval - 1)) != 0)
+		interval &= interval - 1;
+
+	return min(interval, BANDWIDTH_SLOTS);
+}
+
+/**
+ * Reserve bandwidth for a periodic endpoint in the per-slot schedule.
+ *
+ * The endpoint is assigned the phase within its service interval whose
+ * busiest slot carries the least load, and the budget of every slot it will
+ * occupy is verified against the available bandwidth. The chosen phase is
+ * stored in the endpoint so that HC drivers can use it to place the endpoint
+ * in their periodic schedule.
+ *
+ * @param acc		Bandwidth accounting in use
+ * @param slot_bw	Array of BANDWIDTH_SLOTS reserved amounts
+ * @param ep		Endpoint to reserve bandwidth for
+ * @return		EOK on success, ENOSPC if the budget would be exceeded.
+ */
+errno_t bandwidth_reserve_slots(const bandwidth_accounting_t *acc,
+    size_t *slot_bw, endpoint_t *ep)
+{
+	assert(acc);
+	assert(slot_bw);
+	assert(ep);
+
+	const size_t bw = acc->count_bw(ep);
+
+	/* Only periodic endpoints reserve bandwidth. */
+	if (bw == 0)
+		return EOK;
+
+	const unsigned interval = bandwidth_slot_interval(ep);
+
+	/* Find the phase whose busiest slot carries the least load. */
+	unsigned best_phase = 0;
+	size_t best_load = SIZE_MAX;
+
+	for (unsigned phase = 0; phase < interval; phase++) {
+		size_t load = 0;
+		for (unsigned slot = phase; slot < BANDWIDTH_SLOTS;
+		    slot += interval) {
+			load = max(load, slot_bw[slot]);
+		}
+		if (load < best_load) {
+			best_load = load;
+			best_phase = phase;
+		}
+	}
+
+	/* Verify the budget of every slot the endpoint will occupy. */
+	if (best_load + bw > acc->available_bandwidth)
+		return ENOSPC;
+
+	for (unsigned slot = best_phase; slot < BANDWIDTH_SLOTS;
+	    slot += interval) {
+		slot_bw[slot] += bw;
+	}
+
+	ep->scheduled_phase = best_phase;
+
+	return EOK;
+}
+
+/**
+ * Release bandwidth reserved for a periodic endpoint.
+ *
+ * @param acc		Bandwidth accounting in use
+ * @param slot_bw	Array of BANDWIDTH_SLOTS reserved amounts
+ * @param ep		Endpoint to release bandwidth of
+ */
+void bandwidth_release_slots(const bandwidth_accounting_t *acc,
+    size_t *slot_bw, endpoint_t *ep)
+{
+	assert(acc);
+	assert(slot_bw);
+	assert(ep);
+
+	const size_t bw = acc->count_bw(ep);
+
+	if (bw == 0)
+		return;
+
+	const unsigned interval = bandwidth_slot_interval(ep);
+
+	for (unsigned slot = ep->scheduled_phase; slot < BANDWIDTH_SLOTS;
+	    slot += interval) {
+		assert(slot_bw[slot] >= bw);
+		slot_bw[slot] -= bw;
+	}
+}
@@ -66,6 +66,7 @@ void endpoint_init(endpoint_t *ep, device_t *dev, const usb_endpoint_descriptors
 	ep->transfer_type = USB_ED_GET_TRANSFER_TYPE(desc->endpoint);
 	ep->max_packet_size = USB_ED_GET_MPS(desc->endpoint);
 	ep->packets_per_uframe = USB_ED_GET_ADD_OPPS(desc->endpoint) + 1;
+	ep->interval = desc->endpoint.poll_interval;
 
 	/** Direction both is our construct never present in descriptors */
 	if (ep->transfer_type == USB_TRANSFER_CONTROL)
@@ -38,6 +38,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <str_error.h>
@@ -211,21 +212,17 @@ void usb2_bus_device_gone(usb2_bus_helper_t *helper, device_t *dev)
 
 /**
  * Register an endpoint to the bus. Reserves bandwidth.
+ *
+ * Periodic endpoints are placed in the least-loaded phase of their service
+ * interval and the budget of every occupied schedule slot is verified.
  */
 int usb2_bus_endpoint_register(usb2_bus_helper_t *helper, endpoint_t *ep)
 {
 	assert(ep);
 	assert(fibril_mutex_is_locked(&ep->device->guard));
 
-	size_t bw = helper->bw_accounting->count_bw(ep);
-
-	/* Check for available bandwidth */
-	if (bw > helper->free_bw)
-		return ENOSPC;
-
-	helper->free_bw -= bw;
-
-	return EOK;
+	return bandwidth_reserve_slots(helper->bw_accounting,
+	    helper->slot_bw, ep);
 }
 
 /**
@@ -236,7 +233,7 @@ void usb2_bus_endpoint_unregister(usb2_bus_helper_t *helper, endpoint_t *ep)
 	assert(helper);
 	assert(ep);
 
-	helper->free_bw += helper->bw_accounting->count_bw(ep);
+	bandwidth_release_slots(helper->bw_accounting, helper->slot_bw, ep);
 }
 
 /**
@@ -251,7 +248,7 @@ void usb2_bus_helper_init(usb2_bus_helper_t *helper, const bandwidth_accounting_
 	assert(bw_accounting);
 
 	helper->bw_accounting = bw_accounting;
-	helper->free_bw = bw_accounting->available_bandwidth;
+	memset(helper->slot_bw, 0, sizeof(helper->slot_bw));
 
 	/*
 	 * The first address allocated is for the roothub. This way, its
@@ -61,6 +61,8 @@
 #define VIRTIO_FEATURES_0_31	0
 #define VIRTIO_FEATURES_32_63	1
 
+#define VIRTIO_F_RING_EVENT_IDX	(1U << 29)
+
 #define VIRTIO_F_VERSION_1	1
 
 /** Common configuration structure layout according to VIRTIO version 1.0 */
@@ -151,6 +153,17 @@ typedef struct {
 	virtq_used_t *used;
 	uint16_t used_last_idx;
 
+	/**
+	 * Location of the used_event field (trails the available ring);
+	 * written by the driver to moderate device interrupts
+	 */
+	ioport16_t *used_event;
+	/**
+	 * Location of the avail_event field (trails the used ring);
+	 * written by the device to moderate driver notifications
+	 */
+	ioport16_t *avail_event;
+
 	/** Address of the queue's notification register */
 	ioport16_t *notify;
 } virtq_t;
@@ -179,6 +192,9 @@ typedef struct {
 	/** Device-specific configuration */
 	void *device_cfg;
 
+	/** VIRTIO_F_RING_EVENT_IDX has been negotiated */
+	bool event_idx;
+
 	/** Virtqueues */
 	virtq_t *queues;
 } virtio_dev_t;
@@ -204,7 +220,8 @@ extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
 extern errno_t virtio_virtq_setup(virtio_dev_t *, uint16_t, uint16_t);
 extern void virtio_virtq_teardown(virtio_dev_t *, uint16_t);
 
-extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t);
+extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t, uint32_t,
+    uint32_t *);
 extern void virtio_device_setup_fail(virtio_dev_t *);
 extern void virtio_device_setup_finalize(virtio_dev_t *);
 
@@ -170,6 +170,28 @@ void virtio_free_desc(virtio_dev_t *vdev, uint16_t num, uint16_t *head,
 	fibril_mutex_unlock(&q->lock);
 }
 
+/** Decide whether the device needs to be notified.
+ *
+ * With VIRTIO_F_RING_EVENT_IDX the device publishes in avail_event the
+ * available index for which it wants the next notification, so kicks
+ * for the remaining productions are suppressed and consecutive
+ * productions batch into a single notification. Without it, the device
+ * can only opt out of notifications entirely via the used ring flags.
+ */
+static bool virtio_virtq_need_notify(virtio_dev_t *vdev, virtq_t *q,
+    uint16_t old_idx, uint16_t new_idx)
+{
+	read_barrier();
+
+	if (vdev->event_idx) {
+		uint16_t event = pio_read_le16(q->avail_event);
+		return (uint16_t) (new_idx - event - 1) <
+		    (uint16_t) (new_idx - old_idx);
+	}
+
+	return (pio_read_le16(&q->used->flags) & VIRTQ_USED_F_NO_NOTIFY) == 0;
+}
+
 void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
@@ -181,7 +203,8 @@ void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
 	write_barrier();
 	pio_write_le16(&q->avail->idx, idx + 1);
 	write_barrier();
-	pio_write_le16(q->notify, num);
+	if (virtio_virtq_need_notify(vdev, q, idx, idx + 1))
+		pio_write_le16(q->notify, num);
 	fibril_mutex_unlock(&q->lock);
 }
 
@@ -201,6 +224,11 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	*len = pio_read_le32(&q->used->ring[last_idx].len);
 
 	q->used_last_idx++;
+
+	/* Ask for an interrupt only for entries we have not seen yet */
+	if (vdev->event_idx)
+		pio_write_le16(q->used_event, q->used_last_idx);
+
 	fibril_mutex_unlock(&q->lock);
 
 	return true;
@@ -259,6 +287,10 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	q->used = q->virt + used_offset;
 	q->used_last_idx = 0;
 
+	/* The event fields trail the rings; the memory is allocated above */
+	q->used_event = (ioport16_t *) &q->avail->ring[size];
+	q->avail_event = (ioport16_t *) &q->used->ring[size];
+
 	memset(q->virt, 0, q->size);
 
 	/*
@@ -299,8 +331,14 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
 /**
  * Perform device initialization as described in section 3.1.1 of the
  * specification, steps 1 - 6.
+ *
+ * The mandatory features must all be offered by the device, otherwise
+ * the setup fails with ENOTSUP. Optional features are negotiated on
+ * a best-effort basis and the accepted subset is stored in
+ * @a afeatures (which may be NULL if the caller is not interested).
  */
-errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
+errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features,
+    uint32_t opt_features, uint32_t *afeatures)
 {
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
@@ -329,8 +367,14 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
+	features |= (opt_features & device_features);
 	features &= device_features;
 
+	if (afeatures != NULL)
+		*afeatures = features;
+
+	vdev->event_idx = (features & VIRTIO_F_RING_EVENT_IDX) != 0;
+
 	if (reserved_features != (reserved_features & device_reserved_features))
 		return ENOTSUP;
 	reserved_features &= device_reserved_features;
@@ -37,6 +37,7 @@
 #include <assert.h>
 #include <async.h>
 #include <errno.h>
+#include <fibril.h>
 #include <inttypes.h>
 #include <loc.h>
 #include <stdbool.h>
@@ -54,6 +55,9 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new);
 static errno_t device_source_connection_callback(audio_source_t *source, bool new);
 static void device_event_callback(ipc_call_t *icall, void *arg);
 static errno_t device_check_format(audio_sink_t *sink);
+static errno_t device_mixer_fibril(void *arg);
+static errno_t device_mixer_start(audio_device_t *dev);
+static void device_mixer_stop(audio_device_t *dev);
 static errno_t get_buffer(audio_device_t *dev);
 static errno_t release_buffer(audio_device_t *dev);
 static void advance_buffer(audio_device_t *dev, size_t size);
@@ -94,6 +98,13 @@ errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name
 	dev->buffer.size = 0;
 	dev->buffer.fragment_size = 0;
 
+	/* Init mixer members */
+	fibril_mutex_initialize(&dev->mixer.guard);
+	fibril_condvar_initialize(&dev->mixer.change);
+	dev->mixer.pending = 0;
+	dev->mixer.running = false;
+	dev->mixer.active = false;
+
 	log_verbose("Initialized device (%p) '%s' with id %" PRIun ".",
 	    dev, dev->name, dev->id);
 
@@ -180,6 +191,14 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		audio_sink_mix_inputs(&dev->sink, dev->buffer.position, size);
 		advance_buffer(dev, size);
 
+		ret = device_mixer_start(dev);
+		if (ret != EOK) {
+			log_error("Failed to start mixer fibril: %s",
+			    str_error(ret));
+			release_buffer(dev);
+			return ret;
+		}
+
 		const unsigned frames = dev->buffer.fragment_size /
 		    pcm_format_frame_size(&dev->sink.format);
 		log_verbose("Fragment frame count %u", frames);
@@ -189,6 +208,7 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		if (ret != EOK) {
 			log_error("Failed to start playback: %s",
 			    str_error(ret));
+			device_mixer_stop(dev);
 			release_buffer(dev);
 			return ret;
 		}
@@ -264,7 +284,6 @@ static errno_t device_source_connection_callback(audio_source_t *source, bool ne
  */
 static void device_event_callback(ipc_call_t *icall, void *arg)
 {
-	struct timespec time1;
 	errno_t ret;
 
 	audio_device_t *dev = arg;
@@ -276,16 +295,15 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 
 		switch (ipc_get_imethod(&call)) {
 		case PCM_EVENT_FRAMES_PLAYED:
-			getuptime(&time1);
-			//TODO add underrun detection.
-			/* We never cross the end of the buffer here */
-			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
-			    dev->buffer.fragment_size);
-			advance_buffer(dev, dev->buffer.fragment_size);
-			struct timespec time2;
-			getuptime(&time2);
-			log_verbose("Time to mix sources: %lld\n",
-			    NSEC2USEC(ts_sub_diff(&time2, &time1)));
+			/*
+			 * Mixing is done by the dedicated mixer fibril;
+			 * only account the played fragment here so the
+			 * event handler never blocks on stream locks.
+			 */
+			fibril_mutex_lock(&dev->mixer.guard);
+			dev->mixer.pending++;
+			fibril_condvar_signal(&dev->mixer.change);
+			fibril_mutex_unlock(&dev->mixer.guard);
 			break;
 		case PCM_EVENT_CAPTURE_TERMINATED:
 			log_verbose("Capture terminated");
@@ -299,6 +317,7 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 			break;
 		case PCM_EVENT_PLAYBACK_TERMINATED:
 			log_verbose("Playback Terminated");
+			device_mixer_stop(dev);
 			dev->sink.format = AUDIO_FORMAT_ANY;
 			ret = release_buffer(dev);
 			if (ret != EOK) {
@@ -321,6 +340,94 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 	}
 }
 
+/** Playback mixing fibril.
+ *
+ * Re-mixes one fragment for every fragment the device reports played.
+ * Runs separately from the device event handler, so a mix cycle that
+ * takes long (busy streams, slow conversion) delays only itself; the
+ * accumulated backlog is then mixed back-to-back to catch up with the
+ * hardware instead of dropping out.
+ *
+ * @param arg Audio device (audio_device_t).
+ * @return EOK.
+ */
+static errno_t device_mixer_fibril(void *arg)
+{
+	audio_device_t *dev = arg;
+	assert(dev);
+
+	fibril_mutex_lock(&dev->mixer.guard);
+	while (true) {
+		while (dev->mixer.running && dev->mixer.pending == 0)
+			fibril_condvar_wait(&dev->mixer.change,
+			    &dev->mixer.guard);
+
+		if (!dev->mixer.running)
+			break;
+
+		dev->mixer.pending--;
+		fibril_mutex_unlock(&dev->mixer.guard);
+
+		//TODO add underrun detection.
+		/* We never cross the end of the buffer here */
+		audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
+		    dev->buffer.fragment_size);
+		advance_buffer(dev, dev->buffer.fragment_size);
+
+		fibril_mutex_lock(&dev->mixer.guard);
+	}
+
+	dev->mixer.active = false;
+	fibril_condvar_broadcast(&dev->mixer.change);
+	fibril_mutex_unlock(&dev->mixer.guard);
+	return EOK;
+}
+
+/**
+ * Start the playback mixing fibril.
+ * @param dev Audio device.
+ * @return Error code.
+ */
+static errno_t device_mixer_start(audio_device_t *dev)
+{
+	assert(dev);
+
+	fibril_mutex_lock(&dev->mixer.guard);
+	assert(!dev->mixer.active);
+	dev->mixer.pending = 0;
+	dev->mixer.running = true;
+	dev->mixer.active = true;
+	fibril_mutex_unlock(&dev->mixer.guard);
+
+	fid_t fid = fibril_create(device_mixer_fibril, dev);
+	if (fid == 0) {
+		fibril_mutex_lock(&dev->mixer.guard);
+		dev->mixer.running = false;
+		dev->mixer.active = false;
+		fibril_mutex_unlock(&dev->mixer.guard);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/**
+ * Stop the playback mixing fibril and wait for it to exit.
+ * @param dev Audio device.
+ */
+static void device_mixer_stop(audio_device_t *dev)
+{
+	assert(dev);
+
+	fibril_mutex_lock(&dev->mixer.guard);
+	dev->mixer.running = false;
+	fibril_condvar_broadcast(&dev->mixer.change);
+	while (dev->mixer.active)
+		fibril_condvar_wait(&dev->mixer.change, &dev->mixer.guard);
+	fibril_mutex_unlock(&dev->mixer.guard);
+}
+
 /**
  * Test format against hardware limits.
  * @param sink audio playback device.
@@ -63,6 +63,19 @@ typedef struct {
 		void *position;
 		size_t fragment_size;
 	} buffer;
+	/** Playback mixing fibril state */
+	struct {
+		/** Synchronize access to the fields below */
+		fibril_mutex_t guard;
+		/** Signalled on played fragments and state changes */
+		fibril_condvar_t change;
+		/** Number of played fragments not yet re-mixed */
+		unsigned pending;
+		/** Set while the mixing fibril should keep running */
+		bool running;
+		/** Set while the mixing fibril exists */
+		bool active;
+	} mixer;
 	/** Capture device abstraction. */
 	audio_source_t source;
 	/** Playback device abstraction. */
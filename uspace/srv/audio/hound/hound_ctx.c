@@ -34,6 +34,7 @@
 /** @file
  */
 
+#include <as.h>
 #include <macros.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -167,6 +168,10 @@ typedef struct hound_ctx_stream {
 	int flags;
 	/** Maximum allowed buffer size */
 	size_t allowed_size;
+	/** Shared client ring buffer, NULL when data come via IPC writes */
+	hound_stream_ring_t *ring;
+	/** Size of the shared ring buffer data area */
+	size_t ring_size;
 	/** Fifo access synchronization */
 	fibril_mutex_t guard;
 	/** buffer status change condition */
@@ -257,6 +262,8 @@ hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
 		stream->flags = flags;
 		stream->format = format;
 		stream->allowed_size = buffer_size;
+		stream->ring = NULL;
+		stream->ring_size = 0;
 		stream_append(ctx, stream);
 		log_verbose("CTX: %p added stream; flags:%#x ch: %u r:%u f:%s",
 		    ctx, flags, format.channels, format.sampling_rate,
@@ -284,6 +291,8 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 		    stream->format.channels, stream->format.sampling_rate,
 		    pcm_sample_format_str(stream->format.sample_format));
 		audio_pipe_fini(&stream->fifo);
+		if (stream->ring)
+			as_area_destroy(stream->ring);
 		free(stream);
 	}
 }
@@ -348,6 +357,102 @@ errno_t hound_ctx_stream_read(hound_ctx_stream_t *stream, void *data, size_t siz
 	return EEMPTY;
 }
 
+/**
+ * Move data from the shared ring buffer to the stream fifo.
+ * @param stream The target stream, its guard must be held.
+ *
+ * Does nothing if the stream has no ring buffer attached.
+ */
+static void stream_pump_ring(hound_ctx_stream_t *stream)
+{
+	assert(stream);
+	assert(fibril_mutex_is_locked(&stream->guard));
+
+	if (!stream->ring)
+		return;
+
+	size_t avail = hound_stream_ring_bytes(stream->ring);
+	if (stream->allowed_size) {
+		const size_t pending = audio_pipe_bytes(&stream->fifo);
+		if (pending >= stream->allowed_size)
+			return;
+		avail = min(avail, stream->allowed_size - pending);
+	}
+	if (avail == 0)
+		return;
+
+	void *buffer = malloc(avail);
+	if (!buffer)
+		return;
+	const size_t got = hound_stream_ring_read(stream->ring,
+	    stream->ring_size, buffer, avail);
+	if (got == 0) {
+		free(buffer);
+		return;
+	}
+	const errno_t ret =
+	    audio_pipe_push_data(&stream->fifo, buffer, got, stream->format);
+	if (ret != EOK)
+		free(buffer);
+}
+
+/**
+ * Attach a shared ring buffer to a stream.
+ * @param stream The target stream.
+ * @param base Shared memory area holding the ring buffer.
+ * @param area_size Size of the shared area.
+ * @return Error code.
+ *
+ * The advertised data area size is validated against the real area size,
+ * the client cannot trick the server into reading outside of it.
+ */
+errno_t hound_ctx_stream_set_ring(hound_ctx_stream_t *stream, void *base,
+    size_t area_size)
+{
+	assert(stream);
+	hound_stream_ring_t *ring = base;
+
+	if (area_size < offsetof(hound_stream_ring_t, data))
+		return EINVAL;
+
+	const size_t data_size = ring->size;
+	if (data_size == 0 || (data_size & (data_size - 1)) != 0)
+		return EINVAL;
+	if (data_size > area_size - offsetof(hound_stream_ring_t, data))
+		return EINVAL;
+
+	fibril_mutex_lock(&stream->guard);
+	if (stream->ring) {
+		fibril_mutex_unlock(&stream->guard);
+		return EBUSY;
+	}
+	stream->ring = ring;
+	stream->ring_size = data_size;
+	fibril_mutex_unlock(&stream->guard);
+	log_verbose("CTX: %p stream %p uses a %zuB shared ring buffer",
+	    stream->ctx, stream, data_size);
+	return EOK;
+}
+
+/**
+ * Block until the stream's ring buffer has free space.
+ * @param stream The target stream.
+ * @return Error code.
+ */
+errno_t hound_ctx_stream_wait_ring(hound_ctx_stream_t *stream)
+{
+	assert(stream);
+	fibril_mutex_lock(&stream->guard);
+	if (!stream->ring) {
+		fibril_mutex_unlock(&stream->guard);
+		return EINVAL;
+	}
+	while (hound_stream_ring_bytes(stream->ring) >= stream->ring_size)
+		fibril_condvar_wait(&stream->change, &stream->guard);
+	fibril_mutex_unlock(&stream->guard);
+	return EOK;
+}
+
 /**
  * Add (mix) stream data to the destination buffer.
  * @param stream The source stream.
@@ -361,6 +466,7 @@ size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
 {
 	assert(stream);
 	fibril_mutex_lock(&stream->guard);
+	stream_pump_ring(stream);
 	const size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
 	fibril_condvar_signal(&stream->change);
 	fibril_mutex_unlock(&stream->guard);
@@ -376,7 +482,8 @@ void hound_ctx_stream_drain(hound_ctx_stream_t *stream)
 	assert(stream);
 	log_debug("Draining stream");
 	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo))
+	while (audio_pipe_bytes(&stream->fifo) ||
+	    (stream->ring && hound_stream_ring_bytes(stream->ring)))
 		fibril_condvar_wait(&stream->change, &stream->guard);
 	fibril_mutex_unlock(&stream->guard);
 }
@@ -73,6 +73,9 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream);
 errno_t hound_ctx_stream_write(hound_ctx_stream_t *stream, void *buffer,
     size_t size);
 errno_t hound_ctx_stream_read(hound_ctx_stream_t *stream, void *buffer, size_t size);
+errno_t hound_ctx_stream_set_ring(hound_ctx_stream_t *stream, void *base,
+    size_t area_size);
+errno_t hound_ctx_stream_wait_ring(hound_ctx_stream_t *stream);
 size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
     size_t size, const pcm_format_t *f);
 void hound_ctx_stream_drain(hound_ctx_stream_t *stream);
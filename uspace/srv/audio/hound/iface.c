@@ -151,6 +151,16 @@ static errno_t iface_stream_data_write(void *stream, void *buffer, size_t size)
 	return hound_ctx_stream_write(stream, buffer, size);
 }
 
+static errno_t iface_stream_ring_set(void *stream, void *base, size_t size)
+{
+	return hound_ctx_stream_set_ring(stream, base, size);
+}
+
+static errno_t iface_stream_ring_wait(void *stream)
+{
+	return hound_ctx_stream_wait_ring(stream);
+}
+
 hound_server_iface_t hound_iface = {
 	.add_context = iface_add_context,
 	.rem_context = iface_rem_context,
@@ -163,5 +173,7 @@ hound_server_iface_t hound_iface = {
 	.drain_stream = iface_drain_stream,
 	.stream_data_write = iface_stream_data_write,
 	.stream_data_read = iface_stream_data_read,
+	.stream_ring_set = iface_stream_ring_set,
+	.stream_ring_wait = iface_stream_ring_wait,
 	.server = NULL,
 };
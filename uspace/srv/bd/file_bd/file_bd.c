@@ -36,14 +36,29 @@
  *
  * Allows accessing a file as a block device. Useful for, e.g., mounting
  * a disk image.
+ *
+ * When possible, the image is also mapped read-only into our address
+ * space via the VFS pager and reads are served by a direct copy from
+ * the mapping, avoiding a round trip to the file system server per
+ * request. Pages overwritten through the block device are remembered
+ * in a dirty page map and read back through the file from then on,
+ * since the already faulted-in pages of the mapping would be stale.
+ *
+ * Writes are buffered and flushed to the file asynchronously by a
+ * dedicated fibril; clients needing durability use BD_SYNC_CACHE.
  */
 
+#include <align.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
+#include <fibril.h>
 #include <fibril_synch.h>
+#include <ipc/services.h>
 #include <loc.h>
+#include <ns.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <errno.h>
@@ -57,21 +72,40 @@
 
 #define DEFAULT_BLOCK_SIZE 512
 
+/** How long a write may linger unflushed, giving writes time to batch up */
+#define FLUSH_BATCH_DELAY_USEC 100000
+
 static size_t block_size;
 static aoff64_t num_blocks;
 static FILE *img;
 
+/** Read-only mapping of the image backed by the VFS pager (or NULL) */
+static uint8_t *img_map = NULL;
+
+/** One bit per page of the mapping, set once the page has been written to */
+static uint8_t *dirty_map;
+
+/** Buffered writes are waiting to be flushed to the image file */
+static bool flush_pending;
+
+/** Deferred flush of the image file failed */
+static bool flush_failed;
+
 static service_id_t service_id;
 static bd_srvs_t bd_srvs;
 static fibril_mutex_t dev_lock;
+static fibril_condvar_t flush_cv;
 
 static void print_usage(void);
 static errno_t file_bd_init(const char *fname);
+static void file_bd_map_init(size_t img_size);
+static errno_t file_bd_flush_fibril(void *arg);
 static void file_bd_connection(ipc_call_t *icall, void *);
 
 static errno_t file_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t file_bd_close(bd_srv_t *);
 static errno_t file_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
+static errno_t file_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 static errno_t file_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t file_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t file_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
@@ -80,6 +114,7 @@ static bd_ops_t file_bd_ops = {
 	.open = file_bd_open,
 	.close = file_bd_close,
 	.read_blocks = file_bd_read_blocks,
+	.sync_cache = file_bd_sync_cache,
 	.write_blocks = file_bd_write_blocks,
 	.get_block_size = file_bd_get_block_size,
 	.get_num_blocks = file_bd_get_num_blocks
@@ -199,6 +234,121 @@ static errno_t file_bd_init(const char *fname)
 	num_blocks = img_size / block_size;
 
 	fibril_mutex_initialize(&dev_lock);
+	fibril_condvar_initialize(&flush_cv);
+
+	if (img_size > 0)
+		file_bd_map_init((size_t) img_size);
+
+	fid_t fid = fibril_create(file_bd_flush_fibril, NULL);
+	if (fid == 0) {
+		printf("%s: Failed creating flush fibril.\n", NAME);
+		fclose(img);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+
+	return EOK;
+}
+
+/** Map the image file read-only via the VFS pager.
+ *
+ * On success reads are served by a direct copy from the mapping and
+ * the pages are shared with all other mappings of the file through the
+ * pager's page cache. Failure is not fatal; reads simply keep going
+ * through the file.
+ *
+ * @param img_size Size of the image file in bytes.
+ *
+ */
+static void file_bd_map_init(size_t img_size)
+{
+	async_sess_t *pager = service_connect(SERVICE_VFS, INTERFACE_PAGER,
+	    0, NULL);
+	if (pager == NULL)
+		return;
+
+	size_t map_size = ALIGN_UP(img_size, PAGE_SIZE);
+
+	dirty_map = calloc((map_size / PAGE_SIZE + 7) / 8, 1);
+	if (dirty_map == NULL)
+		return;
+
+	void *map = async_as_area_create(AS_AREA_ANY, map_size,
+	    AS_AREA_READ | AS_AREA_CACHEABLE, pager, (sysarg_t) fileno(img),
+	    0, 0);
+	if (map == AS_MAP_FAILED) {
+		free(dirty_map);
+		dirty_map = NULL;
+		return;
+	}
+
+	img_map = map;
+}
+
+/** Return true if no block in the range has been written to.
+ *
+ * Must be called with dev_lock held.
+ *
+ * @param ba  Address of first block.
+ * @param cnt Number of blocks.
+ *
+ */
+static bool file_bd_range_clean(aoff64_t ba, size_t cnt)
+{
+	size_t pfirst = (ba * block_size) / PAGE_SIZE;
+	size_t plast = (ba * block_size + cnt * block_size - 1) / PAGE_SIZE;
+
+	for (size_t page = pfirst; page <= plast; page++) {
+		if (dirty_map[page / 8] & (1 << (page % 8)))
+			return false;
+	}
+
+	return true;
+}
+
+/** Mark all pages overlapping the block range as written to.
+ *
+ * Must be called with dev_lock held.
+ *
+ * @param ba  Address of first block.
+ * @param cnt Number of blocks.
+ *
+ */
+static void file_bd_range_dirty(aoff64_t ba, size_t cnt)
+{
+	size_t pfirst = (ba * block_size) / PAGE_SIZE;
+	size_t plast = (ba * block_size + cnt * block_size - 1) / PAGE_SIZE;
+
+	for (size_t page = pfirst; page <= plast; page++)
+		dirty_map[page / 8] |= 1 << (page % 8);
+}
+
+/** Write buffered data back to the image file.
+ *
+ * Runs for the lifetime of the server. Woken up by the first write
+ * after a flush, then waits a short while so that a burst of writes is
+ * flushed in one go.
+ *
+ */
+static errno_t file_bd_flush_fibril(void *arg)
+{
+	while (true) {
+		fibril_mutex_lock(&dev_lock);
+		while (!flush_pending)
+			fibril_condvar_wait(&flush_cv, &dev_lock);
+		fibril_mutex_unlock(&dev_lock);
+
+		fibril_usleep(FLUSH_BATCH_DELAY_USEC);
+
+		fibril_mutex_lock(&dev_lock);
+		flush_pending = false;
+		if (fflush(img) != 0) {
+			printf("%s: Error flushing image file.\n", NAME);
+			flush_failed = true;
+		}
+		fibril_mutex_unlock(&dev_lock);
+	}
 
 	return EOK;
 }
@@ -239,6 +389,17 @@ static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *
 
 	fibril_mutex_lock(&dev_lock);
 
+	/*
+	 * Serve the request from the mapping unless some of the blocks
+	 * have been overwritten, in which case the faulted-in pages may
+	 * no longer match the file.
+	 */
+	if (img_map != NULL && file_bd_range_clean(ba, cnt)) {
+		memcpy(buf, img_map + ba * block_size, cnt * block_size);
+		fibril_mutex_unlock(&dev_lock);
+		return EOK;
+	}
+
 	clearerr(img);
 	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
 		fibril_mutex_unlock(&dev_lock);
@@ -279,6 +440,13 @@ static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 
 	fibril_mutex_lock(&dev_lock);
 
+	if (flush_failed) {
+		/* Report a write lost by an earlier deferred flush. */
+		flush_failed = false;
+		fibril_mutex_unlock(&dev_lock);
+		return EIO;
+	}
+
 	clearerr(img);
 	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
 		fibril_mutex_unlock(&dev_lock);
@@ -292,9 +460,12 @@ static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		return EIO;	/* Write error */
 	}
 
-	if (fflush(img) != 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
+	if (dirty_map != NULL)
+		file_bd_range_dirty(ba, cnt);
+
+	if (!flush_pending) {
+		flush_pending = true;
+		fibril_condvar_signal(&flush_cv);
 	}
 
 	fibril_mutex_unlock(&dev_lock);
@@ -302,6 +473,24 @@ static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 	return EOK;
 }
 
+/** Flush buffered writes to the image file. */
+static errno_t file_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&dev_lock);
+
+	flush_pending = false;
+	if (fflush(img) != 0 || flush_failed)
+		rc = EIO;
+
+	flush_failed = false;
+
+	fibril_mutex_unlock(&dev_lock);
+
+	return rc;
+}
+
 /** Get device block size. */
 static errno_t file_bd_get_block_size(bd_srv_t *bd, size_t *rsize)
 {
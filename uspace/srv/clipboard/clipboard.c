@@ -26,6 +26,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
@@ -42,10 +43,28 @@
 
 static char *clip_data = NULL;
 static size_t clip_size = 0;
+/** Size of shared area holding the data (0 if not in a shared area) */
+static size_t clip_asize = 0;
 static clipboard_tag_t clip_tag = CLIPBOARD_TAG_NONE;
 static FIBRIL_MUTEX_INITIALIZE(clip_mtx);
 static service_id_t svc_id;
 
+/** Release clipboard contents (with clip_mtx held). */
+static void clip_release_data(void)
+{
+	if (clip_data != NULL) {
+		if (clip_asize != 0)
+			as_area_destroy(clip_data);
+		else
+			free(clip_data);
+	}
+
+	clip_data = NULL;
+	clip_size = 0;
+	clip_asize = 0;
+	clip_tag = CLIPBOARD_TAG_NONE;
+}
+
 static void clip_put_data(ipc_call_t *req)
 {
 	char *data;
@@ -56,12 +75,7 @@ static void clip_put_data(ipc_call_t *req)
 	case CLIPBOARD_TAG_NONE:
 		fibril_mutex_lock(&clip_mtx);
 
-		if (clip_data)
-			free(clip_data);
-
-		clip_data = NULL;
-		clip_size = 0;
-		clip_tag = CLIPBOARD_TAG_NONE;
+		clip_release_data();
 
 		fibril_mutex_unlock(&clip_mtx);
 		async_answer_0(req, EOK);
@@ -75,11 +89,58 @@ static void clip_put_data(ipc_call_t *req)
 
 		fibril_mutex_lock(&clip_mtx);
 
-		if (clip_data)
-			free(clip_data);
+		clip_release_data();
+
+		clip_data = data;
+		clip_size = size;
+		clip_tag = CLIPBOARD_TAG_DATA;
+
+		fibril_mutex_unlock(&clip_mtx);
+		async_answer_0(req, EOK);
+		break;
+	default:
+		async_answer_0(req, EINVAL);
+	}
+}
+
+/** Accept clipboard contents in a memory area shared by the setter. */
+static void clip_put_area(ipc_call_t *req)
+{
+	ipc_call_t call;
+	void *data;
+	size_t size;
+	size_t asize;
+	unsigned int flags;
+	errno_t rc;
+
+	switch (ipc_get_arg1(req)) {
+	case CLIPBOARD_TAG_DATA:
+		size = ipc_get_arg2(req);
+
+		if (!async_share_out_receive(&call, &asize, &flags)) {
+			async_answer_0(req, EINVAL);
+			break;
+		}
+
+		if (size == 0 || size > asize) {
+			async_answer_0(&call, EINVAL);
+			async_answer_0(req, EINVAL);
+			break;
+		}
+
+		rc = async_share_out_finalize(&call, &data);
+		if (rc != EOK || data == AS_MAP_FAILED) {
+			async_answer_0(req, ENOMEM);
+			break;
+		}
+
+		fibril_mutex_lock(&clip_mtx);
+
+		clip_release_data();
 
 		clip_data = data;
 		clip_size = size;
+		clip_asize = asize;
 		clip_tag = CLIPBOARD_TAG_DATA;
 
 		fibril_mutex_unlock(&clip_mtx);
@@ -140,6 +201,64 @@ static void clip_get_data(ipc_call_t *req)
 	fibril_mutex_unlock(&clip_mtx);
 }
 
+/** Share clipboard contents directly to a getter.
+ *
+ * Only possible when the contents live in a shared area (i.e. they were
+ * put there via CLIPBOARD_PUT_AREA). Otherwise the client is told to
+ * fall back to CLIPBOARD_GET_DATA.
+ */
+static void clip_get_area(ipc_call_t *req)
+{
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	fibril_mutex_lock(&clip_mtx);
+
+	switch (ipc_get_arg1(req)) {
+	case CLIPBOARD_TAG_DATA:
+		if (!async_share_in_receive(&call, &size)) {
+			async_answer_0(req, EINVAL);
+			break;
+		}
+
+		if (clip_tag != CLIPBOARD_TAG_DATA || clip_asize == 0) {
+			/* Not in a shared area, client must copy */
+			async_answer_0(&call, ENOTSUP);
+			async_answer_0(req, ENOTSUP);
+			break;
+		}
+
+		if (size != clip_asize) {
+			/*
+			 * The data in the clipboard has changed since the
+			 * last call of CLIPBOARD_CONTENT
+			 */
+			async_answer_0(&call, EOVERFLOW);
+			async_answer_0(req, EOVERFLOW);
+			break;
+		}
+
+		rc = async_share_in_finalize(&call, clip_data, AS_AREA_READ);
+		if (rc != EOK) {
+			async_answer_0(req, EIO);
+			break;
+		}
+
+		async_answer_0(req, EOK);
+		break;
+	default:
+		/*
+		 * Sorry, we don't know how to get unknown or NONE
+		 * data from the clipbard
+		 */
+		async_answer_0(req, EINVAL);
+		break;
+	}
+
+	fibril_mutex_unlock(&clip_mtx);
+}
+
 static void clip_content(ipc_call_t *req)
 {
 	fibril_mutex_lock(&clip_mtx);
@@ -175,6 +294,12 @@ static void clip_connection(ipc_call_t *icall, void *arg)
 		case CLIPBOARD_CONTENT:
 			clip_content(&call);
 			break;
+		case CLIPBOARD_PUT_AREA:
+			clip_put_area(&call);
+			break;
+		case CLIPBOARD_GET_AREA:
+			clip_get_area(&call);
+			break;
 		default:
 			async_answer_0(&call, ENOENT);
 		}
@@ -48,6 +48,29 @@
 #include "main.h"
 
 static errno_t driver_reassign_fibril(void *);
+static errno_t pass_device_fibril(void *);
+
+/** Tracks one parallel pass_devices_to_driver() operation */
+typedef struct {
+	/** Synchronize access to nbusy */
+	fibril_mutex_t lock;
+	/** Signalled when nbusy drops */
+	fibril_condvar_t done_cv;
+	/** Number of devices still being passed */
+	size_t nbusy;
+	/** Driver the devices are passed to */
+	driver_t *driver;
+	/** Device tree */
+	dev_tree_t *tree;
+} pass_devices_t;
+
+/** Device being passed to a driver by pass_device_fibril() */
+typedef struct {
+	/** The pass operation this device belongs to */
+	pass_devices_t *pass;
+	/** Device to pass */
+	dev_node_t *dev;
+} pass_dev_t;
 
 /**
  * Initialize the list of device driver's.
@@ -416,7 +439,63 @@ driver_t *driver_find_by_name(driver_list_t *drv_list, const char *drv_name)
 	return res;
 }
 
+/** Pass one device to its driver and handle a failed probe.
+ *
+ * @param driver	The driver the device was matched to.
+ * @param dev		The device node (one reference is consumed).
+ * @param tree		Device tree.
+ */
+static void pass_one_device(driver_t *driver, dev_node_t *dev, dev_tree_t *tree)
+{
+	add_device(driver, dev, tree);
+
+	/* Device probe failed, need to try next best driver */
+	if (dev->state == DEVICE_NOT_PRESENT) {
+		fibril_mutex_lock(&driver->driver_mutex);
+		list_remove(&dev->driver_devices);
+		fibril_mutex_unlock(&driver->driver_mutex);
+		/* Give an extra reference to driver_reassign_fibril */
+		dev_add_ref(dev);
+		fid_t fid = fibril_create(driver_reassign_fibril, dev);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Error creating fibril to assign driver.");
+			dev_del_ref(dev);
+		} else {
+			fibril_add_ready(fid);
+		}
+	}
+
+	dev_del_ref(dev);
+}
+
+/** Pass a device to its driver in a separate fibril.
+ *
+ * @param arg Pass descriptor (pass_dev_t)
+ */
+static errno_t pass_device_fibril(void *arg)
+{
+	pass_dev_t *pd = (pass_dev_t *) arg;
+	pass_devices_t *pass = pd->pass;
+
+	pass_one_device(pass->driver, pd->dev, pass->tree);
+	free(pd);
+
+	fibril_mutex_lock(&pass->lock);
+	assert(pass->nbusy > 0);
+	pass->nbusy--;
+	fibril_condvar_broadcast(&pass->done_cv);
+	fibril_mutex_unlock(&pass->lock);
+
+	return EOK;
+}
+
 /** Notify driver about the devices to which it was assigned.
+ *
+ * The devices are passed concurrently, each in its own fibril. For a
+ * bus driver this means its child devices are probed in parallel and
+ * independent subtrees of the device tree are brought up concurrently
+ * instead of one after another.
  *
  * @param driver	The driver to which the devices are passed.
  */
@@ -424,66 +503,96 @@ static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 {
 	dev_node_t *dev;
 	link_t *link;
+	pass_devices_t pass;
+	size_t ndisp;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "pass_devices_to_driver(driver=\"%s\")",
 	    driver->name);
 
+	fibril_mutex_initialize(&pass.lock);
+	fibril_condvar_initialize(&pass.done_cv);
+	pass.nbusy = 0;
+	pass.driver = driver;
+	pass.tree = tree;
+
 	fibril_mutex_lock(&driver->driver_mutex);
 
 	/*
 	 * Go through devices list as long as there is some device
 	 * that has not been passed to the driver.
 	 */
-	link = driver->devices.head.next;
-	while (link != &driver->devices.head) {
-		dev = list_get_instance(link, dev_node_t, driver_devices);
-		fibril_rwlock_write_lock(&tree->rwlock);
+	while (true) {
+		ndisp = 0;
+		link = driver->devices.head.next;
+		while (link != &driver->devices.head) {
+			dev = list_get_instance(link, dev_node_t,
+			    driver_devices);
+			link = link->next;
+
+			fibril_rwlock_write_lock(&tree->rwlock);
+
+			if (dev->passed_to_driver) {
+				fibril_rwlock_write_unlock(&tree->rwlock);
+				continue;
+			}
+
+			dev_add_ref(dev);
+
+			/* Prevent a second dispatch of the same device */
+			dev->passed_to_driver = true;
 
-		if (dev->passed_to_driver) {
 			fibril_rwlock_write_unlock(&tree->rwlock);
-			link = link->next;
-			continue;
-		}
 
-		dev_add_ref(dev);
+			pass_dev_t *pd = malloc(sizeof(pass_dev_t));
+			fid_t fid = 0;
+			if (pd != NULL) {
+				pd->pass = &pass;
+				pd->dev = dev;
+				fid = fibril_create(pass_device_fibril, pd);
+			}
 
-		/*
-		 * Unlock to avoid deadlock when adding device
-		 * handled by itself.
-		 */
-		fibril_mutex_unlock(&driver->driver_mutex);
-		fibril_rwlock_write_unlock(&tree->rwlock);
+			if (fid != 0) {
+				fibril_mutex_lock(&pass.lock);
+				pass.nbusy++;
+				fibril_mutex_unlock(&pass.lock);
+				fibril_add_ready(fid);
+				ndisp++;
+				continue;
+			}
 
-		add_device(driver, dev, tree);
+			free(pd);
 
-		/* Device probe failed, need to try next best driver */
-		if (dev->state == DEVICE_NOT_PRESENT) {
-			fibril_mutex_lock(&driver->driver_mutex);
-			list_remove(&dev->driver_devices);
+			/*
+			 * Out of memory. Pass the device synchronously,
+			 * unlocking to avoid deadlock when adding device
+			 * handled by itself.
+			 */
 			fibril_mutex_unlock(&driver->driver_mutex);
-			/* Give an extra reference to driver_reassign_fibril */
-			dev_add_ref(dev);
-			fid_t fid = fibril_create(driver_reassign_fibril, dev);
-			if (fid == 0) {
-				log_msg(LOG_DEFAULT, LVL_ERROR,
-				    "Error creating fibril to assign driver.");
-				dev_del_ref(dev);
-			}
-			fibril_add_ready(fid);
+			pass_one_device(driver, dev, tree);
+			fibril_mutex_lock(&driver->driver_mutex);
+			ndisp++;
+
+			/* The list could have changed, restart the cycle. */
+			link = driver->devices.head.next;
 		}
 
-		dev_del_ref(dev);
+		if (ndisp == 0)
+			break;
 
-		/*
-		 * Lock again as we will work with driver's
-		 * structure.
-		 */
-		fibril_mutex_lock(&driver->driver_mutex);
+		fibril_mutex_unlock(&driver->driver_mutex);
+
+		/* Wait for all the dispatched passes to finish. */
+		fibril_mutex_lock(&pass.lock);
+		while (pass.nbusy > 0)
+			fibril_condvar_wait(&pass.done_cv, &pass.lock);
+		fibril_mutex_unlock(&pass.lock);
 
 		/*
-		 * Restart the cycle to go through all devices again.
+		 * While the devices were being passed, the driver could
+		 * have been attached to more of them. Go through the list
+		 * again before declaring the driver running.
 		 */
-		link = driver->devices.head.next;
+		fibril_mutex_lock(&driver->driver_mutex);
 	}
 
 	/*
@@ -224,11 +224,30 @@ typedef struct {
 
 typedef uint32_t cdfs_lba_t;
 
+/** One record of the persistent directory index.
+ *
+ * The index describes every dentry of the (read-only) medium in a compact
+ * array built once at mount time, so name lookups and directory listings
+ * can be answered from memory even after the corresponding nodes were
+ * evicted from the node cache.
+ */
+typedef struct {
+	fs_index_t parent;	  /**< Node index of the parent directory */
+	fs_index_t index;	  /**< Node index (dentry offset on disc) */
+	char *name;		  /**< Decoded dentry name */
+	cdfs_lba_t lba;		  /**< LBA of the data extent */
+	uint32_t size;		  /**< Size of the data extent */
+	cdfs_dentry_type_t type;  /**< Dentry type */
+} cdfs_idx_rec_t;
+
 typedef struct {
 	link_t link;		  /**< Link to list of all instances */
 	service_id_t service_id;  /**< Service ID of block device */
 	cdfs_enc_t enc;		  /**< Filesystem string encoding */
 	char *vol_ident;	  /**< Volume identifier */
+	cdfs_idx_rec_t *idx;	  /**< Directory index sorted by (parent, name) */
+	cdfs_idx_rec_t **idx_by_index; /**< Index records sorted by node index */
+	size_t idx_cnt;		  /**< Number of directory index records */
 } cdfs_t;
 
 typedef struct {
@@ -565,6 +584,132 @@ static char *cdfs_decode_vol_ident(void *data, size_t dsize, cdfs_enc_t enc)
 	return ident;
 }
 
+/** Find a directory index record by node index.
+ *
+ * @param fs	File system instance
+ * @param index	Node index to look for
+ * @return	Matching record or NULL if not indexed
+ */
+static cdfs_idx_rec_t *cdfs_index_find(cdfs_t *fs, fs_index_t index)
+{
+	size_t lo = 0;
+	size_t hi = fs->idx_cnt;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		cdfs_idx_rec_t *rec = fs->idx_by_index[mid];
+
+		if (rec->index == index)
+			return rec;
+
+		if (rec->index < index)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+/** Find the first directory index record belonging to a directory.
+ *
+ * The records of one directory form a contiguous run in the index.
+ *
+ * @param fs		File system instance
+ * @param parent	Node index of the directory
+ * @return		Position of the first record of @a parent
+ */
+static size_t cdfs_index_dir_first(cdfs_t *fs, fs_index_t parent)
+{
+	size_t lo = 0;
+	size_t hi = fs->idx_cnt;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (fs->idx[mid].parent < parent)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/** Find a directory index record by parent directory and dentry name.
+ *
+ * @param fs		File system instance
+ * @param parent	Node index of the parent directory
+ * @param name		Dentry name
+ * @return		Matching record or NULL if there is no such dentry
+ */
+static cdfs_idx_rec_t *cdfs_index_match(cdfs_t *fs, fs_index_t parent,
+    const char *name)
+{
+	size_t lo = 0;
+	size_t hi = fs->idx_cnt;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		cdfs_idx_rec_t *rec = fs->idx + mid;
+
+		int cmp;
+		if (rec->parent < parent)
+			cmp = -1;
+		else if (rec->parent > parent)
+			cmp = 1;
+		else
+			cmp = str_cmp(rec->name, name);
+
+		if (cmp == 0)
+			return rec;
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+/** Populate a directory node from the directory index.
+ *
+ * Equivalent to reading and parsing the directory extent, but served
+ * entirely from the in-memory index.
+ */
+static errno_t cdfs_readdir_index(cdfs_t *fs, fs_node_t *fs_node)
+{
+	cdfs_node_t *node = CDFS_NODE(fs_node);
+
+	for (size_t i = cdfs_index_dir_first(fs, node->index);
+	    (i < fs->idx_cnt) && (fs->idx[i].parent == node->index); i++) {
+		cdfs_idx_rec_t *rec = fs->idx + i;
+
+		fs_node_t *fn;
+		errno_t rc = create_node(&fn, fs, (rec->type == CDFS_DIRECTORY) ?
+		    L_DIRECTORY : L_FILE, rec->index);
+		if (rc != EOK)
+			return rc;
+
+		assert(fn != NULL);
+
+		cdfs_node_t *cur = CDFS_NODE(fn);
+		cur->lba = rec->lba;
+		cur->size = rec->size;
+
+		// FIXME: check return value
+
+		link_node(fs_node, fn, rec->name);
+
+		if (rec->type == CDFS_FILE)
+			cur->processed = true;
+	}
+
+	node->processed = true;
+	return EOK;
+}
+
 static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 {
 	cdfs_node_t *node = CDFS_NODE(fs_node);
@@ -573,6 +718,10 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 	if (node->processed)
 		return EOK;
 
+	/* Once the directory index is built, no block reads are needed. */
+	if (fs->idx != NULL)
+		return cdfs_readdir_index(fs, fs_node);
+
 	uint32_t blocks = node->size / BLOCK_SIZE;
 	if ((node->size % BLOCK_SIZE) != 0)
 		blocks++;
@@ -647,36 +796,52 @@ static errno_t cdfs_readdir(cdfs_t *fs, fs_node_t *fs_node)
 
 static fs_node_t *get_uncached_node(cdfs_t *fs, fs_index_t index)
 {
-	cdfs_lba_t lba = index / BLOCK_SIZE;
-	size_t offset = index % BLOCK_SIZE;
+	cdfs_dentry_type_t dentry_type;
+	cdfs_lba_t data_lba;
+	uint32_t size;
+
+	cdfs_idx_rec_t *rec = cdfs_index_find(fs, index);
+	if (rec != NULL) {
+		/* Resurrect the evicted node from the directory index. */
+		dentry_type = rec->type;
+		data_lba = rec->lba;
+		size = rec->size;
+	} else {
+		cdfs_lba_t lba = index / BLOCK_SIZE;
+		size_t offset = index % BLOCK_SIZE;
 
-	block_t *block;
-	errno_t rc = block_get(&block, fs->service_id, lba, BLOCK_FLAGS_NONE);
-	if (rc != EOK)
-		return NULL;
+		block_t *block;
+		errno_t rc = block_get(&block, fs->service_id, lba,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return NULL;
 
-	cdfs_dir_t *dir = (cdfs_dir_t *) (block->data + offset);
+		cdfs_dir_t *dir = (cdfs_dir_t *) (block->data + offset);
 
-	cdfs_dentry_type_t dentry_type;
-	if (dir->flags & DIR_FLAG_DIRECTORY)
-		dentry_type = CDFS_DIRECTORY;
-	else
-		dentry_type = CDFS_FILE;
+		if (dir->flags & DIR_FLAG_DIRECTORY)
+			dentry_type = CDFS_DIRECTORY;
+		else
+			dentry_type = CDFS_FILE;
+
+		data_lba = uint32_lb(dir->lba);
+		size = uint32_lb(dir->size);
+
+		block_put(block);
+	}
 
 	fs_node_t *fn;
-	rc = create_node(&fn, fs, dentry_type, index);
+	errno_t rc = create_node(&fn, fs, dentry_type, index);
 	if ((rc != EOK) || (fn == NULL))
 		return NULL;
 
 	cdfs_node_t *node = CDFS_NODE(fn);
-	node->lba = uint32_lb(dir->lba);
-	node->size = uint32_lb(dir->size);
+	node->lba = data_lba;
+	node->size = size;
 	node->lnkcnt = 1;
 
 	if (dentry_type == CDFS_FILE)
 		node->processed = true;
 
-	block_put(block);
 	return fn;
 }
 
@@ -701,6 +866,21 @@ static errno_t cdfs_match(fs_node_t **fn, fs_node_t *pfn, const char *component)
 {
 	cdfs_node_t *parent = CDFS_NODE(pfn);
 
+	if (parent->fs->idx != NULL) {
+		/*
+		 * Answer the lookup by binary search in the directory index
+		 * without populating the parent's dentry list.
+		 */
+		cdfs_idx_rec_t *rec = cdfs_index_match(parent->fs,
+		    parent->index, component);
+		if (rec != NULL)
+			*fn = get_cached_node(parent->fs, rec->index);
+		else
+			*fn = NULL;
+
+		return EOK;
+	}
+
 	if (!parent->processed) {
 		errno_t rc = cdfs_readdir(parent->fs, pfn);
 		if (rc != EOK)
@@ -1049,6 +1229,148 @@ static errno_t iso_readfs(cdfs_t *fs, fs_node_t *rfn,
 	return cdfs_readdir(fs, rfn);
 }
 
+static int cdfs_idx_rec_cmp(const void *a, const void *b)
+{
+	const cdfs_idx_rec_t *ra = a;
+	const cdfs_idx_rec_t *rb = b;
+
+	if (ra->parent < rb->parent)
+		return -1;
+
+	if (ra->parent > rb->parent)
+		return 1;
+
+	return str_cmp(ra->name, rb->name);
+}
+
+static int cdfs_idx_ptr_cmp(const void *a, const void *b)
+{
+	const cdfs_idx_rec_t *ra = *(cdfs_idx_rec_t *const *) a;
+	const cdfs_idx_rec_t *rb = *(cdfs_idx_rec_t *const *) b;
+
+	if (ra->index < rb->index)
+		return -1;
+
+	if (ra->index > rb->index)
+		return 1;
+
+	return 0;
+}
+
+/** Free the directory index of a file system instance. */
+static void cdfs_index_destroy(cdfs_t *fs)
+{
+	for (size_t i = 0; i < fs->idx_cnt; i++)
+		free(fs->idx[i].name);
+
+	free(fs->idx);
+	free(fs->idx_by_index);
+
+	fs->idx = NULL;
+	fs->idx_by_index = NULL;
+	fs->idx_cnt = 0;
+}
+
+/** Recursively record the dentries of a directory subtree.
+ *
+ * @param fs	File system instance
+ * @param dfn	Directory node to scan
+ * @param recs	Pointer to the record array being built
+ * @param cnt	Pointer to the number of valid records
+ * @param cap	Pointer to the capacity of the record array
+ * @return	EOK on success or an error code
+ */
+static errno_t cdfs_index_scan_dir(cdfs_t *fs, fs_node_t *dfn,
+    cdfs_idx_rec_t **recs, size_t *cnt, size_t *cap)
+{
+	cdfs_node_t *dnode = CDFS_NODE(dfn);
+
+	errno_t rc = cdfs_readdir(fs, dfn);
+	if (rc != EOK)
+		return rc;
+
+	list_foreach(dnode->cs_list, link, cdfs_dentry_t, dentry) {
+		fs_node_t *fn = get_cached_node(fs, dentry->index);
+		if (fn == NULL)
+			return EIO;
+
+		cdfs_node_t *child = CDFS_NODE(fn);
+
+		if (*cnt == *cap) {
+			size_t ncap = (*cap > 0) ? (2 * *cap) : 64;
+			cdfs_idx_rec_t *nrecs = realloc(*recs,
+			    ncap * sizeof(cdfs_idx_rec_t));
+			if (nrecs == NULL)
+				return ENOMEM;
+
+			*recs = nrecs;
+			*cap = ncap;
+		}
+
+		cdfs_idx_rec_t *rec = *recs + *cnt;
+		rec->name = str_dup(dentry->name);
+		if (rec->name == NULL)
+			return ENOMEM;
+
+		rec->parent = dnode->index;
+		rec->index = dentry->index;
+		rec->lba = child->lba;
+		rec->size = child->size;
+		rec->type = child->type;
+		(*cnt)++;
+
+		if (child->type == CDFS_DIRECTORY) {
+			rc = cdfs_index_scan_dir(fs, fn, recs, cnt, cap);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	return EOK;
+}
+
+/** Build the persistent directory index of a file system instance.
+ *
+ * Walks the whole directory hierarchy once at mount time and records every
+ * dentry in a compact array with two sorted views: by (parent, name) for
+ * lookups and listings and by node index for resurrecting evicted nodes.
+ * The walk also warms the block cache. Failure is not fatal; the partial
+ * index is freed and cdfs falls back to parsing directory extents from the
+ * block layer on demand.
+ */
+static void cdfs_index_build(cdfs_t *fs, fs_node_t *rfn)
+{
+	cdfs_idx_rec_t *recs = NULL;
+	size_t cnt = 0;
+	size_t cap = 0;
+
+	errno_t rc = cdfs_index_scan_dir(fs, rfn, &recs, &cnt, &cap);
+	if (rc != EOK)
+		goto error;
+
+	cdfs_idx_rec_t **by_index = malloc(cnt * sizeof(cdfs_idx_rec_t *));
+	if ((by_index == NULL) && (cnt > 0))
+		goto error;
+
+	qsort(recs, cnt, sizeof(cdfs_idx_rec_t), cdfs_idx_rec_cmp);
+
+	for (size_t i = 0; i < cnt; i++)
+		by_index[i] = recs + i;
+
+	qsort(by_index, cnt, sizeof(cdfs_idx_rec_t *), cdfs_idx_ptr_cmp);
+
+	fs->idx = recs;
+	fs->idx_by_index = by_index;
+	fs->idx_cnt = cnt;
+	return;
+
+error:
+	for (size_t i = 0; i < cnt; i++)
+		free(recs[i].name);
+
+	free(recs);
+}
+
 /*
  * Mount a session with session start offset
  *
@@ -1079,6 +1401,9 @@ static cdfs_t *cdfs_fs_create(service_id_t sid, cdfs_lba_t altroot)
 	if (iso_readfs(fs, rfn, altroot) != EOK)
 		goto error;
 
+	/* Index the directory hierarchy (best effort) */
+	cdfs_index_build(fs, rfn);
+
 	list_append(&fs->link, &cdfs_instances);
 	return fs;
 error:
@@ -1223,6 +1548,7 @@ static void cdfs_fs_destroy(cdfs_t *fs)
 {
 	list_remove(&fs->link);
 	hash_table_apply(&nodes, rm_service_id_nodes, &fs->service_id);
+	cdfs_index_destroy(fs);
 	block_cache_fini(fs->service_id);
 	block_fini(fs->service_id);
 	free(fs->vol_ident);
@@ -41,6 +41,7 @@
 #include "exfat.h"
 #include "../../vfs/vfs.h"
 #include <libfs.h>
+#include <clustermap.h>
 #include <block.h>
 #include <errno.h>
 #include <byteorder.h>
@@ -301,6 +302,8 @@ exfat_alloc_clusters(exfat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	exfat_cluster_t *lifo;    /* stack for storing free cluster numbers */
 	unsigned found = 0;     /* top of the free cluster number stack */
 	exfat_cluster_t clst;
+	fs_cluster_map_t *cmap;
+	unsigned c;
 	errno_t rc = EOK;
 
 	lifo = (exfat_cluster_t *) malloc(nclsts * sizeof(exfat_cluster_t));
@@ -308,24 +311,69 @@ exfat_alloc_clusters(exfat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 		return ENOMEM;
 
 	fibril_mutex_lock(&exfat_alloc_lock);
-	for (clst = EXFAT_CLST_FIRST; clst < DATA_CNT(bs) + 2 && found < nclsts;
-	    clst++) {
-		/* Need to rewrite because of multiple exfat_bitmap_get calls */
-		if (exfat_bitmap_is_free(bs, service_id, clst) == EOK) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = exfat_set_cluster(bs, service_id, clst,
-			    (found == 0) ?  EXFAT_CLST_EOF : lifo[found - 1]);
+	cmap = fs_cluster_map_get(service_id);
+	if (cmap) {
+		/*
+		 * Pick the clusters from the in-memory free-cluster map.
+		 * The map returns them in order of allocation, while the
+		 * lifo convention used below stores the end of the chain
+		 * first, so reverse the order.
+		 */
+		rc = fs_cluster_map_alloc(cmap, nclsts, lifo);
+		if (rc != EOK) {
+			free(lifo);
+			fibril_mutex_unlock(&exfat_alloc_lock);
+			return rc;
+		}
+		for (c = 0; c < nclsts / 2; c++) {
+			clst = lifo[c];
+			lifo[c] = lifo[nclsts - 1 - c];
+			lifo[nclsts - 1 - c] = clst;
+		}
+
+		/*
+		 * Link the clusters into an independent chain in FAT and
+		 * mark them in the on-disk allocation bitmap.
+		 */
+		for (found = 0; found < nclsts; found++) {
+			rc = exfat_set_cluster(bs, service_id, lifo[found],
+			    (found == 0) ? EXFAT_CLST_EOF : lifo[found - 1]);
 			if (rc != EOK)
 				goto exit_error;
-			found++;
-			rc = exfat_bitmap_set_cluster(bs, service_id, clst);
-			if (rc != EOK)
+			rc = exfat_bitmap_set_cluster(bs, service_id,
+			    lifo[found]);
+			if (rc != EOK) {
+				found++;
 				goto exit_error;
-
+			}
+		}
+	} else {
+		/* No cluster map; scan the on-disk allocation bitmap. */
+		for (clst = EXFAT_CLST_FIRST;
+		    clst < DATA_CNT(bs) + 2 && found < nclsts; clst++) {
+			/*
+			 * Need to rewrite because of multiple
+			 * exfat_bitmap_get calls
+			 */
+			if (exfat_bitmap_is_free(bs, service_id, clst) ==
+			    EOK) {
+				/*
+				 * The cluster is free. Put it into our stack
+				 * of found clusters and mark it as non-free.
+				 */
+				lifo[found] = clst;
+				rc = exfat_set_cluster(bs, service_id, clst,
+				    (found == 0) ?  EXFAT_CLST_EOF :
+				    lifo[found - 1]);
+				if (rc != EOK)
+					goto exit_error;
+				found++;
+				rc = exfat_bitmap_set_cluster(bs, service_id,
+				    clst);
+				if (rc != EOK)
+					goto exit_error;
+
+			}
 		}
 	}
 
@@ -342,6 +390,11 @@ exfat_alloc_clusters(exfat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 exit_error:
 
 	/* If something wrong - free the clusters */
+	if (cmap) {
+		/* All nclsts clusters were taken from the map. */
+		for (c = 0; c < nclsts; c++)
+			fs_cluster_map_set_free(cmap, lifo[c]);
+	}
 	while (found--) {
 		(void) exfat_bitmap_clear_cluster(bs, service_id, lifo[found]);
 		(void) exfat_set_cluster(bs, service_id, lifo[found], 0);
@@ -352,6 +405,66 @@ exit_error:
 	return rc;
 }
 
+/** Scan the on-disk allocation bitmap into a cluster map.
+ *
+ * Runs on a separate fibril spawned by exfat_cluster_map_build() so that
+ * the scan overlaps with the rest of the mount. The map is published
+ * only after the scan finishes; until then, allocations fall back to
+ * scanning the on-disk bitmap.
+ *
+ * @param arg		Unpublished cluster map (fs_cluster_map_t *).
+ *
+ * @return		EOK.
+ */
+static errno_t exfat_cluster_map_scan(void *arg)
+{
+	fs_cluster_map_t *cmap = (fs_cluster_map_t *) arg;
+	service_id_t service_id = cmap->service_id;
+	exfat_bs_t *bs = block_bb_get(service_id);
+	exfat_cluster_t clst;
+
+	for (clst = EXFAT_CLST_FIRST; clst < DATA_CNT(bs) + 2; clst++) {
+		if (exfat_bitmap_is_free(bs, service_id, clst) == EOK)
+			fs_cluster_map_set_free(cmap, clst);
+	}
+
+	fs_cluster_map_publish(cmap);
+	return EOK;
+}
+
+/** Build the in-memory free-cluster map for a volume.
+ *
+ * The actual scan of the on-disk allocation bitmap runs on a separate
+ * fibril and overlaps with the rest of the mount, so that subsequent
+ * allocations do not have to scan the bitmap at all. Failure to build
+ * the map is not fatal; allocation falls back to scanning the on-disk
+ * bitmap.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t exfat_cluster_map_build(exfat_bs_t *bs, service_id_t service_id)
+{
+	fs_cluster_map_t *cmap;
+	errno_t rc;
+	fid_t fid;
+
+	rc = fs_cluster_map_create(service_id, EXFAT_CLST_FIRST, DATA_CNT(bs),
+	    &cmap);
+	if (rc != EOK)
+		return rc;
+
+	fid = fibril_create(exfat_cluster_map_scan, cmap);
+	if (fid == 0) {
+		/* Cannot spawn the scanner; scan synchronously. */
+		return exfat_cluster_map_scan(cmap);
+	}
+	fibril_add_ready(fid);
+	return EOK;
+}
+
 /** Free clusters forming a cluster chain in FAT.
  *
  * @param bs		Buffer hodling the boot sector of the file system.
@@ -364,6 +477,7 @@ errno_t
 exfat_free_clusters(exfat_bs_t *bs, service_id_t service_id, exfat_cluster_t firstc)
 {
 	exfat_cluster_t nextc;
+	fs_cluster_map_t *cmap = fs_cluster_map_get(service_id);
 	errno_t rc;
 
 	/* Mark all clusters in the chain as free */
@@ -378,6 +492,8 @@ exfat_free_clusters(exfat_bs_t *bs, service_id_t service_id, exfat_cluster_t fir
 		rc = exfat_bitmap_clear_cluster(bs, service_id, firstc);
 		if (rc != EOK)
 			return rc;
+		if (cmap)
+			fs_cluster_map_set_free(cmap, firstc);
 		firstc = nextc;
 	}
 
@@ -80,6 +80,7 @@ extern errno_t exfat_chop_clusters(struct exfat_bs *, struct exfat_node *,
 extern errno_t exfat_alloc_clusters(struct exfat_bs *, service_id_t, unsigned,
     exfat_cluster_t *, exfat_cluster_t *);
 extern errno_t exfat_free_clusters(struct exfat_bs *, service_id_t, exfat_cluster_t);
+extern errno_t exfat_cluster_map_build(struct exfat_bs *, service_id_t);
 extern errno_t exfat_zero_cluster(struct exfat_bs *, service_id_t, exfat_cluster_t);
 
 extern errno_t exfat_read_uctable(struct exfat_bs *, struct exfat_node *,
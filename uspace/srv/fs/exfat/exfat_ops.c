@@ -44,6 +44,7 @@
 #include "exfat_bitmap.h"
 #include "../../vfs/vfs.h"
 #include <libfs.h>
+#include <clustermap.h>
 #include <block.h>
 #include <ipc/services.h>
 #include <ipc/loc.h>
@@ -1298,6 +1299,12 @@ exfat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	if (rc != EOK)
 		return rc;
 
+	/*
+	 * Build the in-memory free-cluster map. If this fails, cluster
+	 * allocation will fall back to scanning the allocation bitmap.
+	 */
+	(void) exfat_cluster_map_build(block_bb_get(service_id), service_id);
+
 	*index = ridxp->index;
 	*size = EXFAT_NODE(rfn)->size;
 
@@ -1313,6 +1320,7 @@ static errno_t exfat_unmounted(service_id_t service_id)
 	if (rc != EOK)
 		return rc;
 
+	fs_cluster_map_destroy(service_id);
 	exfat_fs_close(service_id, rfn);
 	return EOK;
 }
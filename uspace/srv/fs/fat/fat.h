@@ -253,6 +253,17 @@ typedef struct fat_node {
 	bool		currc_cached_valid;
 	aoff64_t	currc_cached_bn;
 	fat_cluster_t	currc_cached_value;
+
+	/*
+	 * Map of the node's cluster chain as runs of contiguous clusters.
+	 * The runs are resolved lazily from the FAT and memoized here, so
+	 * that repeated I/O does not re-walk the chain cluster by cluster.
+	 * The map covers the first extents_clusters clusters of the chain.
+	 */
+	fat_extent_t	*extents;
+	unsigned	extents_cnt;
+	unsigned	extents_max;
+	uint32_t	extents_clusters;
 } fat_node_t;
 
 typedef struct {
@@ -41,6 +41,7 @@
 #include "fat.h"
 #include "../../vfs/vfs.h"
 #include <libfs.h>
+#include <clustermap.h>
 #include <block.h>
 #include <errno.h>
 #include <byteorder.h>
@@ -112,6 +113,133 @@ fat_cluster_walk(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc,
 	return EOK;
 }
 
+/** Throw away the memoized extent map of a node.
+ *
+ * Must be called whenever clusters are chopped off the node's cluster
+ * chain and when the in-core node is recycled or freed. Appending
+ * clusters to the chain does not disturb the map as the already
+ * memoized prefix of the chain stays intact.
+ *
+ * @param nodep		FAT node whose extent map is to be invalidated.
+ */
+void fat_extents_invalidate(fat_node_t *nodep)
+{
+	if (nodep->extents)
+		free(nodep->extents);
+	nodep->extents = NULL;
+	nodep->extents_cnt = 0;
+	nodep->extents_max = 0;
+	nodep->extents_clusters = 0;
+}
+
+/** Record one more cluster in the node's extent map.
+ *
+ * @param nodep		FAT node.
+ * @param clst		Cluster number to record.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+static errno_t fat_extent_append(fat_node_t *nodep, fat_cluster_t clst)
+{
+	fat_extent_t *ext;
+
+	if (nodep->extents_cnt > 0) {
+		ext = &nodep->extents[nodep->extents_cnt - 1];
+		if (ext->start + ext->len == clst) {
+			/* The cluster extends the last contiguous run. */
+			ext->len++;
+			nodep->extents_clusters++;
+			return EOK;
+		}
+	}
+
+	if (nodep->extents_cnt == nodep->extents_max) {
+		unsigned nmax = nodep->extents_max ?
+		    2 * nodep->extents_max : 4;
+		ext = (fat_extent_t *) realloc(nodep->extents,
+		    nmax * sizeof(fat_extent_t));
+		if (!ext)
+			return ENOMEM;
+		nodep->extents = ext;
+		nodep->extents_max = nmax;
+	}
+
+	ext = &nodep->extents[nodep->extents_cnt++];
+	ext->start = clst;
+	ext->len = 1;
+	nodep->extents_clusters++;
+
+	return EOK;
+}
+
+/** Resolve the n-th cluster of a node via its extent map.
+ *
+ * Clusters already covered by the extent map are resolved without
+ * touching the FAT. Otherwise the cluster chain is walked from the end
+ * of the memoized part only, and the newly seen clusters are merged
+ * into the map, so each cluster of the chain is read from the FAT at
+ * most once over the node's lifetime.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node.
+ * @param clst_idx	Index of the cluster within the node's chain.
+ * @param clst		Output argument holding the cluster number.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fat_extent_get_cluster(fat_bs_t *bs, fat_node_t *nodep,
+    uint32_t clst_idx, fat_cluster_t *clst)
+{
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_cluster_t cur;
+	uint32_t base;
+	unsigned e;
+	errno_t rc;
+
+	if (nodep->firstc == FAT_CLST_RES0)
+		return ELIMIT;
+
+	if (nodep->extents_clusters == 0) {
+		rc = fat_extent_append(nodep, nodep->firstc);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/* Walk the not-yet-memoized tail of the chain. */
+	while (clst_idx >= nodep->extents_clusters) {
+		cur = nodep->extents[nodep->extents_cnt - 1].start +
+		    nodep->extents[nodep->extents_cnt - 1].len - 1;
+
+		rc = fat_get_cluster(bs, nodep->idx->service_id, FAT1, cur,
+		    &cur);
+		if (rc != EOK)
+			return rc;
+
+		if (cur >= clst_last1) {
+			/* The chain is shorter than clst_idx. */
+			return ELIMIT;
+		}
+		assert(cur != FAT_CLST_BAD(bs));
+
+		rc = fat_extent_append(nodep, cur);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/* Look the cluster up in the extent map. */
+	base = 0;
+	for (e = 0; e < nodep->extents_cnt; e++) {
+		if (clst_idx < base + nodep->extents[e].len) {
+			*clst = nodep->extents[e].start + (clst_idx - base);
+			return EOK;
+		}
+		base += nodep->extents[e].len;
+	}
+
+	assert(false);
+	return EIO;
+}
+
 /** Read block from file located on a FAT file system.
  *
  * @param block		Pointer to a block pointer for storing result.
@@ -147,6 +275,23 @@ fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
 		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
 	}
 
+	/*
+	 * Try to resolve the cluster through the node's extent map first.
+	 * This succeeds in O(1) FAT accesses per cluster even for random
+	 * access patterns. Fall back to the chain walk only if the map
+	 * cannot be grown due to lack of memory.
+	 */
+	rc = fat_extent_get_cluster(bs, nodep, bn / SPC(bs), &currc);
+	if (rc == EOK) {
+		nodep->currc_cached_valid = true;
+		nodep->currc_cached_bn = bn;
+		nodep->currc_cached_value = currc;
+		return block_get(block, nodep->idx->service_id,
+		    CLBN2PBN(bs, currc, bn), flags);
+	}
+	if (rc != ENOMEM)
+		return rc;
+
 	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
 		/*
 		 * We can start with the cluster cached by the previous call to
@@ -680,34 +825,68 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	fat_cluster_t clst;
 	fat_cluster_t value = 0;
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fs_cluster_map_t *cmap;
+	unsigned c;
 	errno_t rc = EOK;
 
 	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
 	if (!lifo)
 		return ENOMEM;
 
-	/*
-	 * Search FAT1 for unused clusters.
-	 */
 	fibril_mutex_lock(&fat_alloc_lock);
-	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 && found < nclsts;
-	    clst++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
-		if (rc != EOK)
-			break;
+	cmap = fs_cluster_map_get(service_id);
+	if (cmap) {
+		/*
+		 * Pick the clusters from the in-memory free-cluster map.
+		 * The map returns them in order of allocation, while the
+		 * lifo convention used below stores the end of the chain
+		 * first, so reverse the order.
+		 */
+		rc = fs_cluster_map_alloc(cmap, nclsts, lifo);
+		if (rc != EOK) {
+			free(lifo);
+			fibril_mutex_unlock(&fat_alloc_lock);
+			return rc;
+		}
+		for (c = 0; c < nclsts / 2; c++) {
+			clst = lifo[c];
+			lifo[c] = lifo[nclsts - 1 - c];
+			lifo[nclsts - 1 - c] = clst;
+		}
 
-		if (value == FAT_CLST_RES0) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = fat_set_cluster(bs, service_id, FAT1, clst,
-			    (found == 0) ?  clst_last1 : lifo[found - 1]);
+		/* Link the clusters into an independent chain in FAT1. */
+		for (found = 0; found < nclsts; found++) {
+			rc = fat_set_cluster(bs, service_id, FAT1, lifo[found],
+			    (found == 0) ? clst_last1 : lifo[found - 1]);
+			if (rc != EOK)
+				break;
+		}
+	} else {
+		/*
+		 * No cluster map; search FAT1 for unused clusters.
+		 */
+		for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 &&
+		    found < nclsts; clst++) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst,
+			    &value);
 			if (rc != EOK)
 				break;
 
-			found++;
+			if (value == FAT_CLST_RES0) {
+				/*
+				 * The cluster is free. Put it into our stack
+				 * of found clusters and mark it as non-free.
+				 */
+				lifo[found] = clst;
+				rc = fat_set_cluster(bs, service_id, FAT1,
+				    clst,
+				    (found == 0) ?  clst_last1 :
+				    lifo[found - 1]);
+				if (rc != EOK)
+					break;
+
+				found++;
+			}
 		}
 	}
 
@@ -723,6 +902,11 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	}
 
 	/* If something wrong - free the clusters */
+	if (cmap) {
+		/* All nclsts clusters were taken from the map. */
+		for (c = 0; c < nclsts; c++)
+			fs_cluster_map_set_free(cmap, lifo[c]);
+	}
 	while (found--) {
 		(void) fat_set_cluster(bs, service_id, FAT1, lifo[found],
 		    FAT_CLST_RES0);
@@ -734,6 +918,44 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	return ENOSPC;
 }
 
+/** Build the in-memory free-cluster map for a volume.
+ *
+ * Scans FAT1 once and records which clusters are free, so that
+ * subsequent allocations do not have to scan the FAT at all. Failure
+ * to build the map is not fatal; allocation falls back to scanning
+ * the FAT.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fat_cluster_map_build(fat_bs_t *bs, service_id_t service_id)
+{
+	fs_cluster_map_t *cmap;
+	fat_cluster_t clst;
+	fat_cluster_t value;
+	errno_t rc;
+
+	rc = fs_cluster_map_create(service_id, FAT_CLST_FIRST, CC(bs), &cmap);
+	if (rc != EOK)
+		return rc;
+
+	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2; clst++) {
+		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
+		if (rc != EOK) {
+			fs_cluster_map_abandon(cmap);
+			return rc;
+		}
+
+		if (value == FAT_CLST_RES0)
+			fs_cluster_map_set_free(cmap, clst);
+	}
+
+	fs_cluster_map_publish(cmap);
+	return EOK;
+}
+
 /** Free clusters forming a cluster chain in all copies of FAT.
  *
  * @param bs		Buffer hodling the boot sector of the file system.
@@ -748,6 +970,7 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 	unsigned fatno;
 	fat_cluster_t nextc = 0;
 	fat_cluster_t clst_bad = FAT_CLST_BAD(bs);
+	fs_cluster_map_t *cmap = fs_cluster_map_get(service_id);
 	errno_t rc;
 
 	/* Mark all clusters in the chain as free in all copies of FAT. */
@@ -765,6 +988,8 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 				return rc;
 		}
 
+		if (cmap)
+			fs_cluster_map_set_free(cmap, firstc);
 		firstc = nextc;
 	}
 
@@ -834,11 +1059,12 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	service_id_t service_id = nodep->idx->service_id;
 
 	/*
-	 * Invalidate cached cluster numbers.
+	 * Invalidate cached cluster numbers and the extent map.
 	 */
 	nodep->lastc_cached_valid = false;
 	if (nodep->currc_cached_value != lcl)
 		nodep->currc_cached_valid = false;
+	fat_extents_invalidate(nodep);
 
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
@@ -105,6 +105,14 @@ struct fat_bs;
 
 typedef uint32_t fat_cluster_t;
 
+/** Run of contiguous clusters in a node's cluster chain. */
+typedef struct {
+	/** First cluster of the run. */
+	fat_cluster_t	start;
+	/** Number of contiguous clusters in the run. */
+	uint32_t	len;
+} fat_extent_t;
+
 #define fat_clusters_get(numc, bs, sid, fc) \
     fat_cluster_walk((bs), (sid), (fc), NULL, (numc), (uint32_t) -1)
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
@@ -112,6 +120,9 @@ extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
 
 extern errno_t fat_block_get(block_t **, struct fat_bs *, struct fat_node *,
     aoff64_t, int);
+extern errno_t fat_extent_get_cluster(struct fat_bs *, struct fat_node *,
+    uint32_t, fat_cluster_t *);
+extern void fat_extents_invalidate(struct fat_node *);
 extern errno_t _fat_block_get(block_t **, struct fat_bs *, service_id_t,
     fat_cluster_t, fat_cluster_t *, aoff64_t, int);
 
@@ -121,6 +132,7 @@ extern errno_t fat_chop_clusters(struct fat_bs *, struct fat_node *,
     fat_cluster_t);
 extern errno_t fat_alloc_clusters(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t *, fat_cluster_t *);
+extern errno_t fat_cluster_map_build(struct fat_bs *, service_id_t);
 extern errno_t fat_free_clusters(struct fat_bs *, service_id_t, fat_cluster_t);
 extern errno_t fat_alloc_shadow_clusters(struct fat_bs *, service_id_t,
     fat_cluster_t *, unsigned);
@@ -42,6 +42,7 @@
 #include "fat_directory.h"
 #include "../../vfs/vfs.h"
 #include <libfs.h>
+#include <clustermap.h>
 #include <block.h>
 #include <ipc/services.h>
 #include <ipc/loc.h>
@@ -111,6 +112,10 @@ static void fat_node_initialize(fat_node_t *node)
 	node->currc_cached_valid = false;
 	node->currc_cached_bn = 0;
 	node->currc_cached_value = 0;
+	node->extents = NULL;
+	node->extents_cnt = 0;
+	node->extents_max = 0;
+	node->extents_clusters = 0;
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -192,6 +197,7 @@ restart:
 				return rc;
 		}
 		nodep->idx->nodep = NULL;
+		fat_extents_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 
@@ -230,6 +236,7 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 				idxp_tmp->nodep = NULL;
 				fibril_mutex_unlock(&nodep->lock);
 				fibril_mutex_unlock(&idxp_tmp->lock);
+				fat_extents_invalidate(nodep);
 				free(nodep->bp);
 				free(nodep);
 				return rc;
@@ -238,6 +245,7 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 		idxp_tmp->nodep = NULL;
 		fibril_mutex_unlock(&nodep->lock);
 		fibril_mutex_unlock(&idxp_tmp->lock);
+		fat_extents_invalidate(nodep);
 		fn = FS_NODE(nodep);
 	} else {
 	skip_cache:
@@ -476,6 +484,7 @@ errno_t fat_node_put(fs_node_t *fn)
 	}
 	fibril_mutex_unlock(&nodep->lock);
 	if (destroy) {
+		fat_extents_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 	}
@@ -569,6 +578,7 @@ errno_t fat_destroy_node(fs_node_t *fn)
 	}
 
 	fat_idx_destroy(nodep->idx);
+	fat_extents_invalidate(nodep);
 	free(nodep->bp);
 	free(nodep);
 	return rc;
@@ -1117,6 +1127,12 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 
 	fibril_mutex_unlock(&ridxp->lock);
 
+	/*
+	 * Build the in-memory free-cluster map. If this fails, cluster
+	 * allocation will fall back to scanning the FAT.
+	 */
+	(void) fat_cluster_map_build(block_bb_get(service_id), service_id);
+
 	*index = ridxp->index;
 	*size = FAT_NODE(rfn)->size;
 
@@ -1195,6 +1211,7 @@ static errno_t fat_unmounted(service_id_t service_id)
 	 * stop using libblock for this instance.
 	 */
 	(void) fat_node_fini_by_service_id(service_id);
+	fs_cluster_map_destroy(service_id);
 	fat_fs_close(service_id, fn);
 
 	void *data;
@@ -155,6 +155,8 @@ struct mfs_instance {
 	service_id_t service_id;
 	struct mfs_sb_info *sbi;
 	unsigned open_nodes_cnt;
+	/* True while the mount-time bitmap warmup fibril is running */
+	bool warmup_active;
 };
 
 /* MinixFS node in core */
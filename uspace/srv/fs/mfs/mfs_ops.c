@@ -70,6 +70,10 @@ static errno_t mfs_free_block_count(service_id_t service_id, uint64_t *count);
 static hash_table_t open_nodes;
 static FIBRIL_MUTEX_INITIALIZE(open_nodes_lock);
 
+/* Protects mfs_instance.warmup_active of all instances */
+static FIBRIL_MUTEX_INITIALIZE(warmup_lock);
+static FIBRIL_CONDVAR_INITIALIZE(warmup_cv);
+
 libfs_ops_t mfs_libfs_ops = {
 	.size_get = mfs_size_get,
 	.root_get = mfs_root_get,
@@ -293,6 +297,44 @@ static errno_t mfs_fsprobe(service_id_t service_id, vfs_fs_probe_info_t *info)
 	return rc;
 }
 
+/** Read the inode and zone bitmaps into the block cache.
+ *
+ * Runs on a separate fibril spawned by mfs_mounted(), so that the
+ * bitmap reads overlap with the rest of the mount and the first
+ * allocations find the bitmap blocks already cached. Read errors are
+ * ignored; the blocks are then simply read on first use.
+ *
+ * @param arg		Pointer to the filesystem instance.
+ *
+ * @return		EOK.
+ */
+static errno_t
+mfs_warmup_fibril(void *arg)
+{
+	struct mfs_instance *inst = arg;
+	struct mfs_sb_info *sbi = inst->sbi;
+	unsigned long nblocks;
+	unsigned long block;
+	block_t *b;
+
+	nblocks = MFS_BMAP_SIZE_BLOCKS(sbi, BMAP_INODE) +
+	    MFS_BMAP_SIZE_BLOCKS(sbi, BMAP_ZONE);
+
+	for (block = 0; block < nblocks; ++block) {
+		if (block_get(&b, inst->service_id,
+		    MFS_BMAP_START_BLOCK(sbi, BMAP_INODE) + block,
+		    BLOCK_FLAGS_NONE) != EOK)
+			break;
+		block_put(b);
+	}
+
+	fibril_mutex_lock(&warmup_lock);
+	inst->warmup_active = false;
+	fibril_condvar_broadcast(&warmup_cv);
+	fibril_mutex_unlock(&warmup_lock);
+	return EOK;
+}
+
 static errno_t
 mfs_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
     aoff64_t *size)
@@ -336,6 +378,7 @@ mfs_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	instance->service_id = service_id;
 	instance->sbi = sbi;
 	instance->open_nodes_cnt = 0;
+	instance->warmup_active = false;
 	rc = fs_instance_create(service_id, instance);
 	if (rc != EOK) {
 		block_cache_fini(service_id);
@@ -343,6 +386,15 @@ mfs_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 		goto out_error;
 	}
 
+	/* Prefetch the bitmaps concurrently with the rest of the mount */
+	fid_t fid = fibril_create(mfs_warmup_fibril, instance);
+	if (fid != 0) {
+		fibril_mutex_lock(&warmup_lock);
+		instance->warmup_active = true;
+		fibril_mutex_unlock(&warmup_lock);
+		fibril_add_ready(fid);
+	}
+
 	mfsdebug("mount successful\n");
 
 	fs_node_t *fn;
@@ -378,6 +430,12 @@ mfs_unmounted(service_id_t service_id)
 	if (inst->open_nodes_cnt != 0)
 		return EBUSY;
 
+	/* Wait for the mount-time bitmap warmup to finish */
+	fibril_mutex_lock(&warmup_lock);
+	while (inst->warmup_active)
+		fibril_condvar_wait(&warmup_cv, &warmup_lock);
+	fibril_mutex_unlock(&warmup_lock);
+
 	(void) block_cache_fini(service_id);
 	block_fini(service_id);
 
@@ -56,6 +56,21 @@ typedef struct tmpfs_dentry {
 	char *name;		/**< Name of dentry. */
 } tmpfs_dentry_t;
 
+/** Size of a single chunk of file content. */
+#define TMPFS_PAGE_SIZE		4096
+
+/** One page-sized chunk of file content.
+ *
+ * File content is kept in page-sized chunks indexed by a per-node hash
+ * table. Pages which were never written are not backed at all and read
+ * back as zeros, so sparse files only consume memory for their data.
+ */
+typedef struct {
+	ht_link_t link;		/**< Pages hash table link. */
+	aoff64_t page;		/**< Page index within the file. */
+	void *data;		/**< TMPFS_PAGE_SIZE bytes of content. */
+} tmpfs_page_t;
+
 typedef struct tmpfs_node {
 	fs_node_t *bp;		/**< Back pointer to the FS node. */
 	fs_index_t index;	/**< TMPFS node index. */
@@ -64,7 +79,7 @@ typedef struct tmpfs_node {
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
 	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
+	hash_table_t pages;	/**< File content if type is TMPFS_FILE. */
 	list_t cs_list;		/**< Child's siblings list. */
 } tmpfs_node_t;
 
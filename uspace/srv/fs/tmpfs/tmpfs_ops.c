@@ -179,10 +179,7 @@ static void nodes_remove_callback(ht_link_t *item)
 		free(dentryp);
 	}
 
-	if (nodep->data) {
-		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
-	}
+	hash_table_destroy(&nodep->pages);
 	free(nodep->bp);
 	free(nodep);
 }
@@ -196,7 +193,92 @@ hash_table_ops_t nodes_ops = {
 	.remove_callback = nodes_remove_callback
 };
 
-static void tmpfs_node_initialize(tmpfs_node_t *nodep)
+/*
+ * Implementation of hash table interface for the per-node pages hash table.
+ */
+
+static size_t pages_key_hash(const void *key)
+{
+	const aoff64_t *page = key;
+	return hash_mix64(*page);
+}
+
+static size_t pages_hash(const ht_link_t *item)
+{
+	tmpfs_page_t *pagep = hash_table_get_inst(item, tmpfs_page_t, link);
+	return hash_mix64(pagep->page);
+}
+
+static bool pages_key_equal(const void *key_arg, const ht_link_t *item)
+{
+	tmpfs_page_t *pagep = hash_table_get_inst(item, tmpfs_page_t, link);
+	const aoff64_t *page = key_arg;
+
+	return pagep->page == *page;
+}
+
+static void pages_remove_callback(ht_link_t *item)
+{
+	tmpfs_page_t *pagep = hash_table_get_inst(item, tmpfs_page_t, link);
+
+	free(pagep->data);
+	free(pagep);
+}
+
+/** TMPFS pages hash table operations. */
+static hash_table_ops_t pages_ops = {
+	.hash = pages_hash,
+	.key_hash = pages_key_hash,
+	.key_equal = pages_key_equal,
+	.equal = NULL,
+	.remove_callback = pages_remove_callback
+};
+
+/** Find the chunk backing the given page of a file.
+ *
+ * @return Chunk or NULL if the page is a hole.
+ */
+static tmpfs_page_t *tmpfs_page_find(tmpfs_node_t *nodep, aoff64_t page)
+{
+	ht_link_t *hlp = hash_table_find(&nodep->pages, &page);
+
+	if (!hlp)
+		return NULL;
+	return hash_table_get_inst(hlp, tmpfs_page_t, link);
+}
+
+/** Find or allocate the chunk backing the given page of a file.
+ *
+ * Newly allocated chunks are zero-filled.
+ *
+ * @return EOK on success or ENOMEM.
+ */
+static errno_t tmpfs_page_get(tmpfs_node_t *nodep, aoff64_t page,
+    tmpfs_page_t **rpage)
+{
+	tmpfs_page_t *pagep = tmpfs_page_find(nodep, page);
+
+	if (pagep) {
+		*rpage = pagep;
+		return EOK;
+	}
+
+	pagep = malloc(sizeof(tmpfs_page_t));
+	if (!pagep)
+		return ENOMEM;
+	pagep->data = calloc(1, TMPFS_PAGE_SIZE);
+	if (!pagep->data) {
+		free(pagep);
+		return ENOMEM;
+	}
+	pagep->page = page;
+	hash_table_insert(&nodep->pages, &pagep->link);
+
+	*rpage = pagep;
+	return EOK;
+}
+
+static bool tmpfs_node_initialize(tmpfs_node_t *nodep)
 {
 	nodep->bp = NULL;
 	nodep->index = 0;
@@ -204,8 +286,8 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
 	list_initialize(&nodep->cs_list);
+	return hash_table_create(&nodep->pages, 0, 0, &pages_ops);
 }
 
 static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
@@ -308,9 +390,13 @@ errno_t tmpfs_create_node(fs_node_t **rfn, service_id_t service_id, int lflag)
 	if (!nodep)
 		return ENOMEM;
 
-	tmpfs_node_initialize(nodep);
+	if (!tmpfs_node_initialize(nodep)) {
+		free(nodep);
+		return ENOMEM;
+	}
 	nodep->bp = malloc(sizeof(fs_node_t));
 	if (!nodep->bp) {
+		hash_table_destroy(&nodep->pages);
 		free(nodep);
 		return ENOMEM;
 	}
@@ -491,9 +577,23 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
+		/*
+		 * Read at most one chunk; the client will come back for the
+		 * rest. Holes are not backed by any chunk and read as zeros.
+		 */
+		static const uint8_t zero_page[TMPFS_PAGE_SIZE];
+		tmpfs_page_t *pagep;
+
 		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		bytes = min(bytes, TMPFS_PAGE_SIZE - pos % TMPFS_PAGE_SIZE);
+		pagep = tmpfs_page_find(nodep, pos / TMPFS_PAGE_SIZE);
+		if (pagep) {
+			(void) async_data_read_finalize(&call,
+			    pagep->data + pos % TMPFS_PAGE_SIZE, bytes);
+		} else {
+			(void) async_data_read_finalize(&call, zero_page,
+			    bytes);
+		}
 	} else {
 		tmpfs_dentry_t *dentryp;
 		link_t *lnk;
@@ -553,33 +653,25 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 
 	/*
-	 * Check whether the file needs to grow.
+	 * Write at most one chunk; the client will come back for the rest.
+	 * The chunk is allocated on demand, so appending never copies the
+	 * already written content and writing beyond the end of file leaves
+	 * the skipped pages unbacked.
 	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
-		goto out;
-	}
-	size_t delta = (pos + size) - nodep->size;
-	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
-	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
-		async_answer_0(&call, ENOMEM);
+	tmpfs_page_t *pagep;
+	errno_t rc;
+
+	size = min(size, TMPFS_PAGE_SIZE - pos % TMPFS_PAGE_SIZE);
+	rc = tmpfs_page_get(nodep, pos / TMPFS_PAGE_SIZE, &pagep);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
 		size = 0;
 		goto out;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
+	(void) async_data_write_finalize(&call,
+	    pagep->data + pos % TMPFS_PAGE_SIZE, size);
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
 
 out:
 	*wbytes = size;
@@ -587,6 +679,21 @@ out:
 	return EOK;
 }
 
+typedef struct {
+	tmpfs_node_t *nodep;
+	aoff64_t first_page;
+} tmpfs_shrink_arg_t;
+
+static bool tmpfs_shrink_page(ht_link_t *item, void *arg)
+{
+	tmpfs_shrink_arg_t *sa = (tmpfs_shrink_arg_t *) arg;
+	tmpfs_page_t *pagep = hash_table_get_inst(item, tmpfs_page_t, link);
+
+	if (pagep->page >= sa->first_page)
+		hash_table_remove_item(&sa->nodep->pages, &pagep->link);
+	return true;
+}
+
 static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
     aoff64_t size)
 {
@@ -609,17 +716,35 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 	if (size > SIZE_MAX)
 		return ENOMEM;
 
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
-
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
+	if (size < nodep->size) {
+		/*
+		 * Free the chunks which lie entirely beyond the new size and
+		 * zero out the tail of the last remaining chunk, so that a
+		 * later extension of the file reads back zeros.
+		 */
+		tmpfs_shrink_arg_t arg = {
+			.nodep = nodep,
+			.first_page = (size + TMPFS_PAGE_SIZE - 1) /
+			    TMPFS_PAGE_SIZE
+		};
+		hash_table_apply(&nodep->pages, tmpfs_shrink_page, &arg);
+
+		if (size % TMPFS_PAGE_SIZE != 0) {
+			tmpfs_page_t *pagep = tmpfs_page_find(nodep,
+			    size / TMPFS_PAGE_SIZE);
+			if (pagep) {
+				memset(pagep->data + size % TMPFS_PAGE_SIZE,
+				    0, TMPFS_PAGE_SIZE -
+				    size % TMPFS_PAGE_SIZE);
+			}
+		}
 	}
 
+	/*
+	 * Growing the file allocates nothing; the new pages are holes until
+	 * they are written to.
+	 */
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
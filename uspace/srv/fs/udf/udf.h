@@ -99,6 +99,17 @@ typedef struct udf_allocator {
 	uint32_t position;
 } udf_allocator_t;
 
+/** One decoded directory entry.
+ *
+ * Compact record of the directory index built on the first scan of a
+ * directory, so that later lookups and listings are answered from
+ * memory instead of re-parsing FIDs from the block layer.
+ */
+typedef struct udf_dentry {
+	char *name;        /* Name decoded to UNIX representation */
+	fs_index_t index;  /* Absolute position of the ICB (sector) */
+} udf_dentry_t;
+
 typedef struct udf_node {
 	udf_instance_t *instance;
 	fs_node_t *fs_node;
@@ -106,6 +117,7 @@ typedef struct udf_node {
 
 	fs_index_t index;  /* FID logical block */
 	ht_link_t link;
+	link_t ffn_link;   /* Link to the list of cached free nodes */
 	size_t ref_cnt;
 	size_t link_cnt;
 
@@ -114,6 +126,11 @@ typedef struct udf_node {
 	uint8_t *data;
 	udf_allocator_t *allocators;
 	size_t alloc_size;
+
+	/* Directory index (only for directories, built on demand) */
+	udf_dentry_t *dentries;
+	size_t dentry_cnt;
+	bool dir_indexed;
 } udf_node_t;
 
 extern vfs_out_ops_t udf_ops;
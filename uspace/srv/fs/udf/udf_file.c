@@ -38,12 +38,14 @@
 #include <libfs.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <str.h>
 #include <inttypes.h>
 #include <io/log.h>
 #include <mem.h>
 #include "udf.h"
 #include "udf_file.h"
 #include "udf_cksum.h"
+#include "udf_osta.h"
 #include "udf_volume.h"
 
 /** Read extended allocator in allocation sequence
@@ -564,6 +566,96 @@ errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **fid,
 	return ENOENT;
 }
 
+/** Build the in-memory index of a directory
+ *
+ * Scan all FIDs of the directory once and store the decoded names
+ * together with the positions of the respective ICBs in a compact
+ * array attached to the node. Later lookups and listings are then
+ * answered from this index without re-parsing the FIDs from the
+ * block layer. The medium is read-only, so the index can never go
+ * stale; it lives as long as the node stays in the node cache.
+ *
+ * @param node UDF directory node
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t udf_dir_index_build(udf_node_t *node)
+{
+	fibril_mutex_lock(&node->lock);
+
+	if (node->dir_indexed) {
+		fibril_mutex_unlock(&node->lock);
+		return EOK;
+	}
+
+	char *name = malloc(MAX_FILE_NAME_LEN + 1);
+	if (name == NULL) {
+		fibril_mutex_unlock(&node->lock);
+		return ENOMEM;
+	}
+
+	udf_dentry_t *dentries = NULL;
+	size_t cnt = 0;
+	size_t cap = 0;
+
+	block_t *block = NULL;
+	udf_file_identifier_descriptor_t *fid = NULL;
+	aoff64_t pos = 0;
+
+	while (udf_get_fid(&fid, &block, node, pos) == EOK) {
+		udf_to_unix_name(name, MAX_FILE_NAME_LEN,
+		    (char *) fid->implementation_use + FLE16(fid->length_iu),
+		    fid->length_file_id, &node->instance->charset);
+
+		udf_long_ad_t long_ad = fid->icb;
+
+		if (block != NULL) {
+			block_put(block);
+			block = NULL;
+		}
+
+		if (cnt == cap) {
+			size_t new_cap = (cap == 0) ? 8 : 2 * cap;
+			udf_dentry_t *tmp = realloc(dentries,
+			    new_cap * sizeof(udf_dentry_t));
+			if (tmp == NULL)
+				goto error;
+
+			dentries = tmp;
+			cap = new_cap;
+		}
+
+		dentries[cnt].name = str_dup(name);
+		if (dentries[cnt].name == NULL)
+			goto error;
+
+		dentries[cnt].index = udf_long_ad_to_pos(node->instance,
+		    &long_ad);
+		cnt++;
+		pos++;
+	}
+
+	free(name);
+
+	node->dentries = dentries;
+	node->dentry_cnt = cnt;
+	node->dir_indexed = true;
+
+	fibril_mutex_unlock(&node->lock);
+	return EOK;
+
+error:
+	for (size_t i = 0; i < cnt; i++)
+		free(dentries[i].name);
+
+	free(dentries);
+	free(name);
+
+	fibril_mutex_unlock(&node->lock);
+	return ENOMEM;
+}
+
 /** Read file if it is saved in allocators.
  *
  * @param read_len Returned value. Length file or part file which we could read.
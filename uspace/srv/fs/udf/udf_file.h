@@ -205,6 +205,7 @@ extern errno_t udf_get_fid_in_allocator(udf_file_identifier_descriptor_t **,
     block_t **, udf_node_t *, aoff64_t);
 extern errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **,
     block_t **, udf_node_t *, aoff64_t, size_t *, void **, size_t *);
+extern errno_t udf_dir_index_build(udf_node_t *);
 
 #endif /* UDF_FILE_H_ */
 
@@ -51,6 +51,13 @@ static FIBRIL_MUTEX_INITIALIZE(udf_idx_lock);
 
 static hash_table_t udf_idx;
 
+/** Maximum number of unreferenced nodes kept in the free node cache */
+#define UDF_FFN_CACHE_SIZE  256
+
+/** List of cached free nodes (least recently used first) */
+static LIST_INITIALIZE(udf_ffn_list);
+static size_t udf_ffn_count = 0;
+
 typedef struct {
 	service_id_t service_id;
 	fs_index_t index;
@@ -85,6 +92,33 @@ static hash_table_ops_t udf_idx_ops = {
 	.remove_callback = NULL
 };
 
+/** Remove node from hash table and release all its memory
+ *
+ * Must be called with udf_idx_lock held.
+ *
+ * @param node UDF node
+ *
+ */
+static void udf_node_destroy(udf_node_t *node)
+{
+	hash_table_remove_item(&udf_idx, &node->link);
+
+	assert(node->instance->open_nodes_count > 0);
+	node->instance->open_nodes_count--;
+
+	if (node->dentries != NULL) {
+		for (size_t i = 0; i < node->dentry_cnt; i++)
+			free(node->dentries[i].name);
+
+		free(node->dentries);
+	}
+
+	free(node->allocators);
+	free(node->data);
+	free(node->fs_node);
+	free(node);
+}
+
 /** Initialization of hash table
  *
  * @return EOK on success or an error code.
@@ -131,6 +165,13 @@ errno_t udf_idx_get(udf_node_t **udfn, udf_instance_t *instance, fs_index_t inde
 	if (already_open) {
 		udf_node_t *node = hash_table_get_inst(already_open,
 		    udf_node_t, link);
+
+		/* Reclaim the node from the free node cache */
+		if (node->ref_cnt == 0) {
+			list_remove(&node->ffn_link);
+			udf_ffn_count--;
+		}
+
 		node->ref_cnt++;
 
 		*udfn = node;
@@ -178,6 +219,10 @@ errno_t udf_idx_add(udf_node_t **udfn, udf_instance_t *instance, fs_index_t inde
 	udf_node->fs_node = fs_node;
 	udf_node->data = NULL;
 	udf_node->allocators = NULL;
+	udf_node->dentries = NULL;
+	udf_node->dentry_cnt = 0;
+	udf_node->dir_indexed = false;
+	link_initialize(&udf_node->ffn_link);
 
 	fibril_mutex_initialize(&udf_node->lock);
 	fs_node->data = udf_node;
@@ -191,27 +236,85 @@ errno_t udf_idx_add(udf_node_t **udfn, udf_instance_t *instance, fs_index_t inde
 	return EOK;
 }
 
-/** Delete node from hash table
+/** Drop one reference to a node
+ *
+ * When the last reference is dropped, the node is not destroyed but
+ * kept in the free node cache with its decoded file entry and extent
+ * map. The medium is read-only, so the cached metadata can never go
+ * stale; the least recently used node is evicted when the cache
+ * overflows.
  *
  * @param node UDF node
  *
  * @return EOK on success or an error code.
  *
  */
-errno_t udf_idx_del(udf_node_t *node)
+errno_t udf_idx_put(udf_node_t *node)
 {
-	assert(node->ref_cnt == 0);
+	fibril_mutex_lock(&udf_idx_lock);
+
+	assert(node->ref_cnt > 0);
+	node->ref_cnt--;
+
+	if (node->ref_cnt == 0) {
+		list_append(&node->ffn_link, &udf_ffn_list);
+		udf_ffn_count++;
 
+		if (udf_ffn_count > UDF_FFN_CACHE_SIZE) {
+			udf_node_t *evicted = list_get_instance(
+			    list_first(&udf_ffn_list), udf_node_t, ffn_link);
+
+			list_remove(&evicted->ffn_link);
+			udf_ffn_count--;
+			udf_node_destroy(evicted);
+		}
+	}
+
+	fibril_mutex_unlock(&udf_idx_lock);
+	return EOK;
+}
+
+/** Destroy all cached free nodes of one instance
+ *
+ * Called on unmount, when the instance is about to be freed.
+ *
+ * @param instance UDF instance
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t udf_idx_purge(udf_instance_t *instance)
+{
 	fibril_mutex_lock(&udf_idx_lock);
 
-	hash_table_remove_item(&udf_idx, &node->link);
+	list_foreach_safe(udf_ffn_list, cur, next) {
+		udf_node_t *node = list_get_instance(cur, udf_node_t,
+		    ffn_link);
 
-	assert(node->instance->open_nodes_count > 0);
-	node->instance->open_nodes_count--;
+		if (node->instance == instance) {
+			list_remove(&node->ffn_link);
+			udf_ffn_count--;
+			udf_node_destroy(node);
+		}
+	}
 
-	free(node->fs_node);
-	free(node);
+	fibril_mutex_unlock(&udf_idx_lock);
+	return EOK;
+}
+
+/** Delete node from hash table
+ *
+ * @param node UDF node
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t udf_idx_del(udf_node_t *node)
+{
+	assert(node->ref_cnt == 0);
 
+	fibril_mutex_lock(&udf_idx_lock);
+	udf_node_destroy(node);
 	fibril_mutex_unlock(&udf_idx_lock);
 	return EOK;
 }
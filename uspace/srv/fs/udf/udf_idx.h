@@ -39,6 +39,8 @@ extern errno_t udf_idx_init(void);
 extern errno_t udf_idx_fini(void);
 extern errno_t udf_idx_get(udf_node_t **, udf_instance_t *, fs_index_t);
 extern errno_t udf_idx_add(udf_node_t **, udf_instance_t *, fs_index_t);
+extern errno_t udf_idx_put(udf_node_t *);
+extern errno_t udf_idx_purge(udf_instance_t *);
 extern errno_t udf_idx_del(udf_node_t *);
 
 #endif /* UDF_IDX_H_ */
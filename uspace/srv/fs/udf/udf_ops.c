@@ -61,9 +61,6 @@
 #include "udf_file.h"
 #include "udf_osta.h"
 
-/** List of cached free nodes. */
-static LIST_INITIALIZE(ffn_list);
-
 static errno_t udf_node_get(fs_node_t **rfn, service_id_t service_id,
     fs_index_t index)
 {
@@ -112,6 +109,21 @@ static service_id_t udf_service_get(fs_node_t *node)
 
 static errno_t udf_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
+	udf_node_t *parent = UDF_NODE(pfn);
+
+	/* Serve the lookup from the directory index when possible */
+	if (udf_dir_index_build(parent) == EOK) {
+		for (size_t i = 0; i < parent->dentry_cnt; i++) {
+			if (str_casecmp(parent->dentries[i].name,
+			    component) == 0)
+				return udf_node_get(rfn, udf_service_get(pfn),
+				    parent->dentries[i].index);
+		}
+
+		return ENOENT;
+	}
+
+	/* Fall back to scanning the FIDs on the medium */
 	char *name = malloc(MAX_FILE_NAME_LEN + 1);
 	if (name == NULL)
 		return ENOMEM;
@@ -162,15 +174,12 @@ static errno_t udf_node_put(fs_node_t *fn)
 	if (!node)
 		return EINVAL;
 
-	fibril_mutex_lock(&node->lock);
-	node->ref_cnt--;
-	fibril_mutex_unlock(&node->lock);
-
-	/* Delete node from hash table and memory */
-	if (!node->ref_cnt)
-		udf_idx_del(node);
-
-	return EOK;
+	/*
+	 * The node is not destroyed when the last reference is dropped;
+	 * it stays in the free node cache with its decoded file entry,
+	 * extent map and directory index for the lifetime of the mount.
+	 */
+	return udf_idx_put(node);
 }
 
 static errno_t udf_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
@@ -439,6 +448,9 @@ static errno_t udf_unmounted(service_id_t service_id)
 	udf_node_put(fn);
 	udf_node_put(fn);
 
+	/* Destroy nodes kept in the free node cache */
+	udf_idx_purge(instance);
+
 	fs_instance_destroy(service_id);
 	free(instance);
 	block_cache_fini(service_id);
@@ -492,6 +504,23 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		(void) udf_node_put(rfn);
 		return rc;
 	} else {
+		/* Serve the listing from the directory index when possible */
+		if (udf_dir_index_build(node) == EOK) {
+			if (pos < node->dentry_cnt) {
+				async_data_read_finalize(&call,
+				    node->dentries[pos].name,
+				    str_size(node->dentries[pos].name) + 1);
+				*rbytes = 1;
+				udf_node_put(rfn);
+				return EOK;
+			}
+
+			*rbytes = 0;
+			udf_node_put(rfn);
+			async_answer_0(&call, ENOENT);
+			return ENOENT;
+		}
+
 		block_t *block = NULL;
 		udf_file_identifier_descriptor_t *fid = NULL;
 		if (udf_get_fid(&fid, &block, node, pos) == EOK) {
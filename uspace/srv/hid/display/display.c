@@ -89,6 +89,7 @@ errno_t ds_display_create(gfx_context_t *gc, ds_display_flags_t flags,
 	}
 
 	fibril_mutex_initialize(&disp->lock);
+	fibril_condvar_initialize(&disp->repaint_cv);
 	list_initialize(&disp->clients);
 	disp->next_wnd_id = 1;
 	list_initialize(&disp->ddevs);
@@ -656,6 +657,47 @@ errno_t ds_display_paint_bg(ds_display_t *disp, gfx_rect_t *rect)
 	return gfx_fill_rect(gc, &crect);
 }
 
+/** Determine if window is completely occluded.
+ *
+ * Determine whether the part of window @a wnd lying within rectangle
+ * @a rect (or within the entire display if @a rect is @c NULL) is
+ * completely covered by a window above it. Since windows are opaque,
+ * painting such a window would have no visible effect.
+ *
+ * @param wnd Window
+ * @param rect Bounding rectangle or @c NULL for entire display
+ * @return @c true iff the window need not be painted
+ */
+bool ds_display_window_occluded(ds_window_t *wnd, gfx_rect_t *rect)
+{
+	ds_window_t *above;
+	gfx_rect_t drect;
+	gfx_rect_t crect;
+	gfx_rect_t adrect;
+
+	/* Window bounding rectangle on display, clipped to @a rect */
+	gfx_rect_translate(&wnd->dpos, &wnd->rect, &drect);
+	if (rect != NULL)
+		gfx_rect_clip(&drect, rect, &crect);
+	else
+		crect = drect;
+
+	if (gfx_rect_is_empty(&crect))
+		return true;
+
+	/* Walk windows above @a wnd (towards the start of the list) */
+	above = ds_display_prev_window(wnd);
+	while (above != NULL) {
+		gfx_rect_translate(&above->dpos, &above->rect, &adrect);
+		if (gfx_rect_is_inside(&crect, &adrect))
+			return true;
+
+		above = ds_display_prev_window(above);
+	}
+
+	return false;
+}
+
 /** Update front buffer from back buffer.
  *
  * If the display is not double-buffered, no action is taken.
@@ -663,7 +705,7 @@ errno_t ds_display_paint_bg(ds_display_t *disp, gfx_rect_t *rect)
  * @param disp Display
  * @return EOK on success, or an error code
  */
-static errno_t ds_display_update(ds_display_t *disp)
+errno_t ds_display_update(ds_display_t *disp)
 {
 	errno_t rc;
 
@@ -703,9 +745,12 @@ errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
 	/* Paint windows bottom to top */
 	wnd = ds_display_last_window(disp);
 	while (wnd != NULL) {
-		rc = ds_window_paint(wnd, rect);
-		if (rc != EOK)
-			return rc;
+		/* Skip windows that would be completely painted over */
+		if (!ds_display_window_occluded(wnd, rect)) {
+			rc = ds_window_paint(wnd, rect);
+			if (rc != EOK)
+				return rc;
+		}
 
 		wnd = ds_display_prev_window(wnd);
 	}
@@ -720,6 +765,16 @@ errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
 		wnd = ds_display_prev_window(wnd);
 	}
 
+	/* Re-save scene under pointers now that it has been repainted */
+	seat = ds_display_first_seat(disp);
+	while (seat != NULL) {
+		rc = ds_seat_save_under(seat, rect);
+		if (rc != EOK)
+			return rc;
+
+		seat = ds_display_next_seat(seat);
+	}
+
 	/* Paint pointers */
 	seat = ds_display_first_seat(disp);
 	while (seat != NULL) {
@@ -733,6 +788,27 @@ errno_t ds_display_paint(ds_display_t *disp, gfx_rect_t *rect)
 	return ds_display_update(disp);
 }
 
+/** Defer painting of a display rectangle.
+ *
+ * Add a rectangle to the pending repaint rectangle and wake up the
+ * compositor fibril, which will perform the actual painting. This is
+ * used for client-initiated damage so that a slow paint operation
+ * does not stall the fibril posting the damage. The caller must hold
+ * the display lock.
+ *
+ * @param disp Display
+ * @param rect Rectangle to repaint
+ */
+void ds_display_defer_paint(ds_display_t *disp, gfx_rect_t *rect)
+{
+	gfx_rect_t env;
+
+	gfx_rect_envelope(&disp->repaint_rect, rect, &env);
+	disp->repaint_rect = env;
+
+	fibril_condvar_signal(&disp->repaint_cv);
+}
+
 /** Display invalidate callback.
  *
  * Called by backbuffer memory GC when something is rendered into it.
@@ -66,6 +66,7 @@ extern ds_window_t *ds_display_first_window(ds_display_t *);
 extern ds_window_t *ds_display_last_window(ds_display_t *);
 extern ds_window_t *ds_display_next_window(ds_window_t *);
 extern ds_window_t *ds_display_prev_window(ds_window_t *);
+extern bool ds_display_window_occluded(ds_window_t *, gfx_rect_t *);
 extern errno_t ds_display_post_kbd_event(ds_display_t *, kbd_event_t *);
 extern errno_t ds_display_post_ptd_event(ds_display_t *, ptd_event_t *);
 extern void ds_display_add_seat(ds_display_t *, ds_seat_t *);
@@ -80,7 +81,9 @@ extern void ds_display_add_cursor(ds_display_t *, ds_cursor_t *);
 extern void ds_display_remove_cursor(ds_cursor_t *);
 extern gfx_context_t *ds_display_get_gc(ds_display_t *);
 extern errno_t ds_display_paint_bg(ds_display_t *, gfx_rect_t *);
+extern errno_t ds_display_update(ds_display_t *);
 extern errno_t ds_display_paint(ds_display_t *, gfx_rect_t *);
+extern void ds_display_defer_paint(ds_display_t *, gfx_rect_t *);
 
 #endif
 
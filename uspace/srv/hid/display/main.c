@@ -36,7 +36,9 @@
 #include <async.h>
 #include <disp_srv.h>
 #include <errno.h>
+#include <fibril.h>
 #include <gfx/context.h>
+#include <gfx/coord.h>
 #include <str_error.h>
 #include <io/log.h>
 #include <io/kbd_event.h>
@@ -57,6 +59,17 @@
 
 static void display_client_conn(ipc_call_t *, void *);
 static void display_client_ev_pending(void *);
+static errno_t display_compositor_fibril(void *);
+
+/** Minimum interval between two composited frames (microseconds).
+ *
+ * Client damage arriving faster than this is coalesced into a single
+ * repaint. We have no way of synchronizing to the actual display
+ * refresh, so a rate in the ballpark of common displays is used.
+ */
+enum {
+	frame_interval_usec = 16667
+};
 
 #ifdef CONFIG_DISP_DOUBLE_BUF
 /*
@@ -82,6 +95,43 @@ static void display_client_ev_pending(void *arg)
 	display_srv_ev_pending(srv);
 }
 
+/** Compositor fibril.
+ *
+ * Performs deferred repaints posted by ds_display_defer_paint().
+ * Damage posted by clients is coalesced and painted here, one frame
+ * at a time, so that a slow paint operation cannot stall the fibrils
+ * processing client requests and input events. After each frame the
+ * fibril rests until the next frame tick, coalescing any damage that
+ * arrives in the meantime.
+ *
+ * @param arg Display (cast to void *)
+ * @return Does not return
+ */
+static errno_t display_compositor_fibril(void *arg)
+{
+	ds_display_t *disp = (ds_display_t *) arg;
+	gfx_rect_t rect;
+
+	while (true) {
+		ds_display_lock(disp);
+		while (gfx_rect_is_empty(&disp->repaint_rect))
+			fibril_condvar_wait(&disp->repaint_cv, &disp->lock);
+
+		rect = disp->repaint_rect;
+		disp->repaint_rect.p0.x = 0;
+		disp->repaint_rect.p0.y = 0;
+		disp->repaint_rect.p1.x = 0;
+		disp->repaint_rect.p1.y = 0;
+
+		(void) ds_display_paint(disp, &rect);
+		ds_display_unlock(disp);
+
+		fibril_usleep(frame_interval_usec);
+	}
+
+	return EOK;
+}
+
 /** Initialize display server */
 static errno_t display_srv_init(ds_output_t **routput)
 {
@@ -114,6 +164,14 @@ static errno_t display_srv_init(ds_output_t **routput)
 	if (rc != EOK)
 		goto error;
 
+	fid_t fid = fibril_create(display_compositor_fibril, (void *) disp);
+	if (fid == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	fibril_add_ready(fid);
+
 	async_set_fallback_port_handler(display_client_conn, disp);
 
 	rc = loc_server_register(NAME);
@@ -35,8 +35,11 @@
 
 #include <adt/list.h>
 #include <errno.h>
+#include <gfx/bitmap.h>
 #include <gfx/color.h>
 #include <gfx/render.h>
+#include <io/pixel.h>
+#include <mem.h>
 #include <stdlib.h>
 #include "client.h"
 #include "cursor.h"
@@ -46,6 +49,8 @@
 
 static void ds_seat_get_pointer_rect(ds_seat_t *, gfx_rect_t *);
 static errno_t ds_seat_repaint_pointer(ds_seat_t *, gfx_rect_t *);
+static bool ds_seat_can_restore_under(ds_seat_t *, gfx_rect_t *);
+static errno_t ds_seat_restore_under(ds_seat_t *);
 
 /** Create seat.
  *
@@ -79,6 +84,10 @@ errno_t ds_seat_create(ds_display_t *display, ds_seat_t **rseat)
 void ds_seat_destroy(ds_seat_t *seat)
 {
 	ds_display_remove_seat(seat);
+
+	if (seat->under_bmp != NULL)
+		gfx_bitmap_destroy(seat->under_bmp);
+
 	free(seat);
 }
 
@@ -291,11 +300,172 @@ void ds_seat_get_pointer_rect(ds_seat_t *seat, gfx_rect_t *rect)
 	ds_cursor_get_rect(cursor, &seat->pntpos, rect);
 }
 
+/** Save scene under pointer.
+ *
+ * Save the contents of the back buffer in the area covered by the
+ * pointer so that the scene can later be restored by a simple blit
+ * when the pointer moves away. Called after the scene (without
+ * pointers) has been painted. If the display is not double-buffered,
+ * no action is taken.
+ *
+ * @param seat Seat
+ * @param clip Only re-save the area within this rectangle
+ *             or @c NULL to save the entire area under the pointer
+ *
+ * @return EOK on success or an error code
+ */
+errno_t ds_seat_save_under(ds_seat_t *seat, gfx_rect_t *clip)
+{
+	ds_display_t *disp = seat->display;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t salloc;
+	gfx_bitmap_alloc_t dalloc;
+	gfx_rect_t nrect;
+	gfx_rect_t brect;
+	gfx_rect_t crect;
+	pixel_t *sp;
+	pixel_t *dp;
+	gfx_coord_t y;
+	gfx_coord_t width;
+	errno_t rc;
+
+	if (disp->backbuf == NULL) {
+		/* Cannot read back the scene without a back buffer */
+		return EOK;
+	}
+
+	ds_seat_get_pointer_rect(seat, &nrect);
+	gfx_rect_rtranslate(&seat->pntpos, &nrect, &brect);
+
+	/* Discard saved bitmap if the cursor dimensions have changed */
+	if (seat->under_bmp != NULL &&
+	    (seat->under_brect.p0.x != brect.p0.x ||
+	    seat->under_brect.p0.y != brect.p0.y ||
+	    seat->under_brect.p1.x != brect.p1.x ||
+	    seat->under_brect.p1.y != brect.p1.y)) {
+		gfx_bitmap_destroy(seat->under_bmp);
+		seat->under_bmp = NULL;
+	}
+
+	if (seat->under_bmp == NULL) {
+		gfx_bitmap_params_init(&params);
+		params.rect = brect;
+
+		rc = gfx_bitmap_create(ds_display_get_gc(disp), &params, NULL,
+		    &seat->under_bmp);
+		if (rc != EOK)
+			return rc;
+
+		seat->under_brect = brect;
+	}
+
+	/*
+	 * Unless there is a complete valid save to update partially,
+	 * the entire area under the pointer must be saved.
+	 */
+	if (gfx_rect_is_empty(&seat->under_rect))
+		clip = NULL;
+
+	/* Determine which part of the back buffer to copy */
+	gfx_rect_clip(&nrect, &disp->rect, &crect);
+	if (clip != NULL)
+		gfx_rect_clip(&crect, clip, &crect);
+
+	seat->under_pos = seat->pntpos;
+	seat->under_rect = nrect;
+
+	if (gfx_rect_is_empty(&crect))
+		return EOK;
+
+	rc = gfx_bitmap_get_alloc(disp->backbuf, &salloc);
+	if (rc != EOK)
+		return rc;
+
+	rc = gfx_bitmap_get_alloc(seat->under_bmp, &dalloc);
+	if (rc != EOK)
+		return rc;
+
+	width = crect.p1.x - crect.p0.x;
+
+	for (y = crect.p0.y; y < crect.p1.y; y++) {
+		sp = (pixel_t *) ((uint8_t *) salloc.pixels + salloc.off0 +
+		    (y - disp->rect.p0.y) * salloc.pitch) +
+		    (crect.p0.x - disp->rect.p0.x);
+		dp = (pixel_t *) ((uint8_t *) dalloc.pixels + dalloc.off0 +
+		    (y - seat->pntpos.y - brect.p0.y) * dalloc.pitch) +
+		    (crect.p0.x - seat->pntpos.x - brect.p0.x);
+		memcpy(dp, sp, width * sizeof(pixel_t));
+	}
+
+	return EOK;
+}
+
+/** Determine if pointer can be repainted by restoring saved scene.
+ *
+ * @param seat Seat
+ * @param old_rect Rectangle previously covered by pointer
+ * @return @c true iff the saved scene can be used
+ */
+static bool ds_seat_can_restore_under(ds_seat_t *seat, gfx_rect_t *old_rect)
+{
+	ds_display_t *disp = seat->display;
+	ds_seat_t *other;
+	gfx_rect_t prect;
+
+	if (disp->backbuf == NULL || seat->under_bmp == NULL)
+		return false;
+
+	/* Saved area must exactly cover the area to restore */
+	if (gfx_rect_is_empty(&seat->under_rect) ||
+	    seat->under_rect.p0.x != old_rect->p0.x ||
+	    seat->under_rect.p0.y != old_rect->p0.y ||
+	    seat->under_rect.p1.x != old_rect->p1.x ||
+	    seat->under_rect.p1.y != old_rect->p1.y)
+		return false;
+
+	/* The saved scene must not contain another seat's pointer */
+	other = ds_display_first_seat(disp);
+	while (other != NULL) {
+		if (other != seat) {
+			ds_seat_get_pointer_rect(other, &prect);
+			if (gfx_rect_is_incident(&prect, old_rect))
+				return false;
+		}
+
+		other = ds_display_next_seat(other);
+	}
+
+	return true;
+}
+
+/** Restore saved scene under pointer.
+ *
+ * Blit the scene saved by @c ds_seat_save_under() back to the display,
+ * erasing the painted pointer.
+ *
+ * @param seat Seat
+ * @return EOK on success or an error code
+ */
+static errno_t ds_seat_restore_under(ds_seat_t *seat)
+{
+	errno_t rc;
+
+	rc = gfx_bitmap_render(seat->under_bmp, NULL, &seat->under_pos);
+	if (rc != EOK)
+		return rc;
+
+	seat->under_rect.p0 = seat->under_rect.p1;
+	return EOK;
+}
+
 /** Repaint seat pointer
  *
- * Repaint the pointer after it has moved or changed. This is done by
- * repainting the area of the display previously (@a old_rect) and currently
- * covered by the pointer.
+ * Repaint the pointer after it has moved or changed. If the scene under
+ * the pointer was previously saved, it is simply blitted back and the
+ * scene under the new position is saved before painting the pointer
+ * there, avoiding any recompositing of windows. Otherwise this is done
+ * by repainting the area of the display previously (@a old_rect) and
+ * currently covered by the pointer.
  *
  * @param seat Seat
  * @param old_rect Rectangle previously covered by pointer
@@ -310,6 +480,22 @@ static errno_t ds_seat_repaint_pointer(ds_seat_t *seat, gfx_rect_t *old_rect)
 
 	ds_seat_get_pointer_rect(seat, &new_rect);
 
+	if (ds_seat_can_restore_under(seat, old_rect)) {
+		rc = ds_seat_restore_under(seat);
+		if (rc != EOK)
+			return rc;
+
+		rc = ds_seat_save_under(seat, NULL);
+		if (rc != EOK)
+			return rc;
+
+		rc = ds_seat_paint_pointer(seat, &new_rect);
+		if (rc != EOK)
+			return rc;
+
+		return ds_display_update(seat->display);
+	}
+
 	if (gfx_rect_is_incident(old_rect, &new_rect)) {
 		/* Rectangles do not intersect. Repaint them separately. */
 		rc = ds_display_paint(seat->display, &new_rect);
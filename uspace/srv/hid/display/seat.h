@@ -56,6 +56,7 @@ extern errno_t ds_seat_post_ptd_event(ds_seat_t *, ptd_event_t *);
 extern errno_t ds_seat_post_pos_event(ds_seat_t *, pos_event_t *);
 extern void ds_seat_set_wm_cursor(ds_seat_t *, ds_cursor_t *);
 extern errno_t ds_seat_paint_pointer(ds_seat_t *, gfx_rect_t *);
+extern errno_t ds_seat_save_under(ds_seat_t *, gfx_rect_t *);
 
 #endif
 
@@ -213,6 +213,74 @@ PCUT_TEST(display_window_by_pos)
 	ds_display_destroy(disp);
 }
 
+/** Test ds_display_window_occluded(). */
+PCUT_TEST(display_window_occluded)
+{
+	ds_display_t *disp;
+	ds_client_t *client;
+	ds_seat_t *seat;
+	ds_window_t *w0;
+	ds_window_t *w1;
+	display_wnd_params_t params;
+	gfx_rect_t rect;
+	bool called_cb = false;
+	errno_t rc;
+
+	rc = ds_display_create(NULL, df_none, &disp);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_client_create(disp, &test_ds_client_cb, &called_cb, &client);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_seat_create(disp, &seat);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	display_wnd_params_init(&params);
+	params.rect.p0.x = params.rect.p0.y = 0;
+	params.rect.p1.x = params.rect.p1.y = 100;
+
+	/* w1 is created first, so w0 lies above it */
+	rc = ds_window_create(client, &params, &w1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = ds_window_create(client, &params, &w0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	w0->dpos.x = 10;
+	w0->dpos.y = 10;
+
+	w1->dpos.x = 10;
+	w1->dpos.y = 10;
+
+	/* w1 is completely covered by w0 */
+	PCUT_ASSERT_TRUE(ds_display_window_occluded(w1, NULL));
+
+	/* The topmost window is never occluded */
+	PCUT_ASSERT_FALSE(ds_display_window_occluded(w0, NULL));
+
+	/* Move w1 so that it sticks out */
+	w1->dpos.x = 50;
+	w1->dpos.y = 50;
+
+	PCUT_ASSERT_FALSE(ds_display_window_occluded(w1, NULL));
+
+	/* Part of w1 within this rectangle is still covered by w0 */
+	rect.p0.x = rect.p0.y = 50;
+	rect.p1.x = rect.p1.y = 100;
+	PCUT_ASSERT_TRUE(ds_display_window_occluded(w1, &rect));
+
+	/* Rectangle not intersecting w1 at all */
+	rect.p0.x = rect.p0.y = 200;
+	rect.p1.x = rect.p1.y = 300;
+	PCUT_ASSERT_TRUE(ds_display_window_occluded(w1, &rect));
+
+	ds_window_destroy(w0);
+	ds_window_destroy(w1);
+	ds_seat_destroy(seat);
+	ds_client_destroy(client);
+	ds_display_destroy(disp);
+}
+
 /** Basic seat operation. */
 PCUT_TEST(display_seat)
 {
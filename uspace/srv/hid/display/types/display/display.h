@@ -106,6 +106,12 @@ typedef struct ds_display {
 	/** Backbuffer dirty rectangle */
 	gfx_rect_t dirty_rect;
 
+	/** Pending deferred repaint rectangle */
+	gfx_rect_t repaint_rect;
+
+	/** Signalled when @c repaint_rect becomes non-empty */
+	fibril_condvar_t repaint_cv;
+
 	/** Display flags */
 	ds_display_flags_t flags;
 } ds_display_t;
@@ -38,6 +38,7 @@
 
 #include <adt/list.h>
 #include <gfx/coord.h>
+#include <types/gfx/bitmap.h>
 
 /** Display server seat */
 typedef struct ds_seat {
@@ -55,6 +56,14 @@ typedef struct ds_seat {
 	struct ds_cursor *wm_cursor;
 	/** Pointer position */
 	gfx_coord2_t pntpos;
+	/** Saved scene under pointer or @c NULL */
+	gfx_bitmap_t *under_bmp;
+	/** Bitmap-relative rectangle of @c under_bmp */
+	gfx_rect_t under_brect;
+	/** Position at which scene under pointer was saved */
+	gfx_coord2_t under_pos;
+	/** Display rectangle covered by saved scene (empty if none) */
+	gfx_rect_t under_rect;
 } ds_seat_t;
 
 #endif
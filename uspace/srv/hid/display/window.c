@@ -828,11 +828,11 @@ static void ds_window_invalidate_cb(void *arg, gfx_rect_t *rect)
 	ds_window_t *wnd = (ds_window_t *)arg;
 	gfx_rect_t drect;
 
-	/* Repaint the corresponding part of the display */
+	/* Have the compositor repaint the corresponding display area */
 
 	gfx_rect_translate(&wnd->dpos, rect, &drect);
 	ds_display_lock(wnd->display);
-	(void) ds_display_paint(wnd->display, &drect);
+	ds_display_defer_paint(wnd->display, &drect);
 	ds_display_unlock(wnd->display);
 }
 
@@ -31,6 +31,7 @@
  */
 
 #include <errno.h>
+#include <mem.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <macros.h>
@@ -78,6 +79,8 @@ outdev_t *outdev_register(outdev_ops_t *ops, void *data)
 		return NULL;
 	}
 
+	dev->top_row = 0;
+
 	list_append(&dev->link, &outdevs);
 	return dev;
 }
@@ -272,12 +275,30 @@ static bool srv_update_scroll(outdev_t *dev, chargrid_t *buf)
 	assert(dev->ops.char_update);
 
 	sysarg_t top_row = chargrid_get_top_row(buf);
+	bool scrolled = false;
 
 	if (dev->top_row == top_row)
 		return false;
 
+	sysarg_t delta = (dev->rows + top_row - dev->top_row) % dev->rows;
 	dev->top_row = top_row;
 
+	if ((dev->ops.scroll) && (delta > 0) && (delta < dev->rows)) {
+		/*
+		 * Scroll the device and move the backbuffer rows up in
+		 * tandem. The backbuffer is never rotated, thus its rows
+		 * are stored linearly and can be moved with a single
+		 * memmove(). Afterwards only the newly exposed bottom
+		 * rows need to be redrawn unconditionally; the rest is
+		 * covered by the regular difference update below.
+		 */
+		memmove(chargrid_charfield_at(dev->backbuf, 0, 0),
+		    chargrid_charfield_at(dev->backbuf, 0, delta),
+		    (dev->rows - delta) * dev->cols * sizeof(charfield_t));
+		dev->ops.scroll(dev, delta);
+		scrolled = true;
+	}
+
 	for (sysarg_t y = 0; y < dev->rows; y++) {
 		for (sysarg_t x = 0; x < dev->cols; x++) {
 			charfield_t *front_field =
@@ -286,14 +307,22 @@ static bool srv_update_scroll(outdev_t *dev, chargrid_t *buf)
 			    chargrid_charfield_at(dev->backbuf, x, y);
 			bool update = false;
 
-			if (front_field->ch != back_field->ch) {
+			if ((scrolled) && (y >= dev->rows - delta)) {
+				/* Newly exposed row, contents undefined */
 				back_field->ch = front_field->ch;
-				update = true;
-			}
-
-			if (!attrs_same(front_field->attrs, back_field->attrs)) {
 				back_field->attrs = front_field->attrs;
 				update = true;
+			} else {
+				if (front_field->ch != back_field->ch) {
+					back_field->ch = front_field->ch;
+					update = true;
+				}
+
+				if (!attrs_same(front_field->attrs,
+				    back_field->attrs)) {
+					back_field->attrs = front_field->attrs;
+					update = true;
+				}
 			}
 
 			front_field->flags &= ~CHAR_FLAG_DIRTY;
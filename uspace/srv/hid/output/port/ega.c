@@ -35,6 +35,7 @@
 #include <align.h>
 #include <as.h>
 #include <ddi.h>
+#include <mem.h>
 #include <io/chargrid.h>
 #include "../output.h"
 #include "ega.h"
@@ -169,6 +170,12 @@ static void ega_char_update(outdev_t *dev, sysarg_t col, sysarg_t row)
 	draw_char(field, col, row);
 }
 
+static void ega_scroll(outdev_t *dev, sysarg_t rows)
+{
+	memmove(ega.addr, ega.addr + FB_POS(0, rows),
+	    FB_POS(0, ega.rows - rows));
+}
+
 static void ega_flush(outdev_t *dev)
 {
 }
@@ -180,6 +187,7 @@ static outdev_ops_t ega_ops = {
 	.get_caps = ega_get_caps,
 	.cursor_update = ega_cursor_update,
 	.char_update = ega_char_update,
+	.scroll = ega_scroll,
 	.flush = ega_flush
 };
 
@@ -219,6 +219,22 @@ void vt100_cursor_visibility(vt100_state_t *state, bool visible)
 		state->control_puts("\033[?25l");
 }
 
+/** Scroll the whole screen up by @a rows rows (ECMA-48 SU).
+ *
+ * The newly exposed bottom rows are blanked by the terminal and have
+ * to be redrawn by the caller. The cursor position is not affected.
+ */
+void vt100_scroll(vt100_state_t *state, sysarg_t rows)
+{
+	char control[MAX_CONTROL];
+
+	if ((rows == 0) || (rows >= state->rows))
+		return;
+
+	snprintf(control, MAX_CONTROL, "\033[%" PRIun "S", rows);
+	state->control_puts(control);
+}
+
 void vt100_putuchar(vt100_state_t *state, char32_t ch)
 {
 	state->putuchar(ch == 0 ? ' ' : ch);
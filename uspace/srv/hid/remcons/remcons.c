@@ -152,7 +152,9 @@ static errno_t remcons_write(con_srv_t *srv, void *data, size_t size, size_t *nw
 
 static void remcons_sync(con_srv_t *srv)
 {
-	(void) srv;
+	telnet_user_t *user = srv_to_user(srv);
+
+	telnet_user_flush(user);
 }
 
 static void remcons_clear(con_srv_t *srv)
@@ -47,12 +47,19 @@
 #include <io/console.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <mem.h>
+#include <str.h>
 #include "user.h"
 #include "telnet.h"
 
 static FIBRIL_MUTEX_INITIALIZE(users_guard);
 static LIST_INITIALIZE(users);
 
+/** How long output may sit in the buffer before it is flushed (usec). */
+#define FLUSH_TIMEOUT  10000
+
+static void telnet_user_flush_timer(void *);
+
 /** Create new telnet user.
  *
  * @param conn Incoming connection.
@@ -90,6 +97,16 @@ telnet_user_t *telnet_user_create(tcp_conn_t *conn)
 
 	user->cursor_x = 0;
 
+	fibril_mutex_initialize(&user->obuf_guard);
+	user->out_buffer_len = 0;
+	user->flush_scheduled = false;
+	user->flush_timer = fibril_timer_create(&user->obuf_guard);
+	if (user->flush_timer == NULL) {
+		free(user->service_name);
+		free(user);
+		return NULL;
+	}
+
 	return user;
 }
 
@@ -112,6 +129,8 @@ void telnet_user_destroy(telnet_user_t *user)
 	list_remove(&user->link);
 	fibril_mutex_unlock(&users_guard);
 
+	fibril_timer_destroy(user->flush_timer);
+	free(user->service_name);
 	free(user);
 }
 
@@ -275,15 +294,28 @@ errno_t telnet_user_get_next_keyboard_event(telnet_user_t *user, kbd_event_t *ev
 {
 	fibril_mutex_lock(&user->guard);
 	if (list_empty(&user->in_events.list)) {
-		char next_byte = 0;
 		bool inside_telnet_command = false;
+		bool have_event = false;
 
 		telnet_cmd_t telnet_option_code = 0;
 
-		/* Skip zeros, bail-out on error. */
-		while (next_byte == 0) {
+		/* The client is about to wait for input; send any echo now. */
+		telnet_user_flush(user);
+
+		/*
+		 * Block until at least one event is available, then keep
+		 * converting whatever else is already buffered. This way
+		 * a bulk paste is turned into events in a single pass
+		 * instead of one buffer traversal per byte.
+		 */
+		while (!have_event ||
+		    user->socket_buffer_pos < user->socket_buffer_len) {
+			char next_byte = 0;
+
 			errno_t rc = telnet_user_recv_next_byte_no_lock(user, &next_byte);
 			if (rc != EOK) {
+				if (have_event)
+					break;
 				fibril_mutex_unlock(&user->guard);
 				return rc;
 			}
@@ -292,7 +324,6 @@ errno_t telnet_user_get_next_keyboard_event(telnet_user_t *user, kbd_event_t *ev
 			/* Skip telnet commands. */
 			if (inside_telnet_command) {
 				inside_telnet_command = false;
-				next_byte = 0;
 				if (TELNET_IS_OPTION_CODE(byte)) {
 					telnet_option_code = byte;
 					inside_telnet_command = true;
@@ -300,24 +331,30 @@ errno_t telnet_user_get_next_keyboard_event(telnet_user_t *user, kbd_event_t *ev
 					process_telnet_command(user,
 					    telnet_option_code, byte);
 				}
+				continue;
 			}
 			if (byte == TELNET_IAC) {
 				inside_telnet_command = true;
-				next_byte = 0;
+				continue;
 			}
-		}
 
-		/* CR-LF conversions. */
-		if (next_byte == 13) {
-			next_byte = 10;
-		}
+			/* Skip zeros. */
+			if (next_byte == 0)
+				continue;
+
+			/* CR-LF conversions. */
+			if (next_byte == 13) {
+				next_byte = 10;
+			}
 
-		kbd_event_t *down = new_kbd_event(KEY_PRESS, next_byte);
-		kbd_event_t *up = new_kbd_event(KEY_RELEASE, next_byte);
-		assert(down);
-		assert(up);
-		prodcons_produce(&user->in_events, &down->link);
-		prodcons_produce(&user->in_events, &up->link);
+			kbd_event_t *down = new_kbd_event(KEY_PRESS, next_byte);
+			kbd_event_t *up = new_kbd_event(KEY_RELEASE, next_byte);
+			assert(down);
+			assert(up);
+			prodcons_produce(&user->in_events, &down->link);
+			prodcons_produce(&user->in_events, &up->link);
+			have_event = true;
+		}
 	}
 
 	link_t *link = prodcons_consume(&user->in_events);
@@ -332,6 +369,85 @@ errno_t telnet_user_get_next_keyboard_event(telnet_user_t *user, kbd_event_t *ev
 	return EOK;
 }
 
+/** Send buffered output to the socket.
+ *
+ * Must be called with @c obuf_guard held.
+ */
+static errno_t telnet_user_flush_no_lock(telnet_user_t *user)
+{
+	errno_t rc;
+
+	if (user->out_buffer_len == 0)
+		return EOK;
+
+	if (user->conn == NULL || user->socket_closed) {
+		user->out_buffer_len = 0;
+		return ENOENT;
+	}
+
+	rc = tcp_conn_send(user->conn, user->out_buffer,
+	    user->out_buffer_len);
+	user->out_buffer_len = 0;
+
+	return rc;
+}
+
+/** Flush timer handler.
+ *
+ * Sends output that has been sitting in the buffer for FLUSH_TIMEOUT.
+ */
+static void telnet_user_flush_timer(void *arg)
+{
+	telnet_user_t *user = arg;
+
+	fibril_mutex_lock(&user->obuf_guard);
+	user->flush_scheduled = false;
+	(void) telnet_user_flush_no_lock(user);
+	fibril_mutex_unlock(&user->obuf_guard);
+}
+
+/** Queue raw bytes for transmission to the socket.
+ *
+ * The data is aggregated into the output buffer; the buffer is sent
+ * when it fills up or when the flush timer expires, so a burst of
+ * small writes becomes a handful of TCP segments instead of one
+ * segment per character. Must be called with @c obuf_guard held.
+ */
+static errno_t telnet_user_queue_raw_no_lock(telnet_user_t *user,
+    const uint8_t *data, size_t size)
+{
+	errno_t rc;
+
+	while (size > 0) {
+		size_t space = OUT_BUFFER_SIZE - user->out_buffer_len;
+		size_t now = (size < space) ? size : space;
+
+		memcpy(user->out_buffer + user->out_buffer_len, data, now);
+		user->out_buffer_len += now;
+		data += now;
+		size -= now;
+
+		if (user->out_buffer_len == OUT_BUFFER_SIZE) {
+			rc = telnet_user_flush_no_lock(user);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	/*
+	 * Make sure a partially filled buffer goes out eventually. If
+	 * the timer is already pending, the data just queued will be
+	 * picked up by its handler.
+	 */
+	if (user->out_buffer_len > 0 && !user->flush_scheduled) {
+		user->flush_scheduled = true;
+		fibril_timer_set_locked(user->flush_timer, FLUSH_TIMEOUT,
+		    telnet_user_flush_timer, user);
+	}
+
+	return EOK;
+}
+
 /** Send data (convert them first) to the socket, no locking.
  *
  * @param user Telnet user.
@@ -340,9 +456,11 @@ errno_t telnet_user_get_next_keyboard_event(telnet_user_t *user, kbd_event_t *ev
  */
 static errno_t telnet_user_send_data_no_lock(telnet_user_t *user, uint8_t *data, size_t size)
 {
-	uint8_t *converted = malloc(3 * size + 1);
+	uint8_t *converted = malloc(2 * size + 1);
+	errno_t rc;
+
 	assert(converted);
-	int converted_size = 0;
+	size_t converted_size = 0;
 
 	/* Convert new-lines. */
 	for (size_t i = 0; i < size; i++) {
@@ -360,7 +478,10 @@ static errno_t telnet_user_send_data_no_lock(telnet_user_t *user, uint8_t *data,
 		}
 	}
 
-	errno_t rc = tcp_conn_send(user->conn, converted, converted_size);
+	fibril_mutex_lock(&user->obuf_guard);
+	rc = telnet_user_queue_raw_no_lock(user, converted, converted_size);
+	fibril_mutex_unlock(&user->obuf_guard);
+
 	free(converted);
 
 	return rc;
@@ -383,6 +504,14 @@ errno_t telnet_user_send_data(telnet_user_t *user, uint8_t *data, size_t size)
 	return rc;
 }
 
+/** Flush any buffered output to the socket immediately. */
+void telnet_user_flush(telnet_user_t *user)
+{
+	fibril_mutex_lock(&user->obuf_guard);
+	(void) telnet_user_flush_no_lock(user);
+	fibril_mutex_unlock(&user->obuf_guard);
+}
+
 /** Update cursor X position.
  *
  * This call may result in sending control commands over socket.
@@ -392,15 +521,39 @@ errno_t telnet_user_send_data(telnet_user_t *user, uint8_t *data, size_t size)
  */
 void telnet_user_update_cursor_x(telnet_user_t *user, int new_x)
 {
+	char seq[16];
+	int delta;
+	size_t len;
+
 	fibril_mutex_lock(&user->guard);
-	if (user->cursor_x - 1 == new_x) {
-		uint8_t data = '\b';
+
+	/*
+	 * Emit a relative movement sequence rather than forcing the
+	 * client to redraw: a single backspace for the common one-left
+	 * case, an ANSI cursor movement sequence otherwise.
+	 */
+	delta = new_x - user->cursor_x;
+	if (delta == -1) {
+		str_cpy(seq, sizeof(seq), "\b");
+	} else if (delta < 0) {
+		snprintf(seq, sizeof(seq), "\033[%dD", -delta);
+	} else if (delta > 0) {
+		snprintf(seq, sizeof(seq), "\033[%dC", delta);
+	} else {
+		seq[0] = '\0';
+	}
+
+	len = str_size(seq);
+	if (len > 0) {
+		fibril_mutex_lock(&user->obuf_guard);
 		/* Ignore errors. */
-		telnet_user_send_data_no_lock(user, &data, 1);
+		(void) telnet_user_queue_raw_no_lock(user,
+		    (uint8_t *) seq, len);
+		fibril_mutex_unlock(&user->obuf_guard);
 	}
+
 	user->cursor_x = new_x;
 	fibril_mutex_unlock(&user->guard);
-
 }
 
 /**
@@ -44,6 +44,9 @@
 
 #define BUFFER_SIZE 32
 
+/** Size of the output aggregation buffer */
+#define OUT_BUFFER_SIZE 2048
+
 /** Representation of a connected (human) user. */
 typedef struct {
 	/** Mutex guarding the whole structure. */
@@ -78,6 +81,16 @@ typedef struct {
 
 	/** X position of the cursor. */
 	int cursor_x;
+
+	/** Mutex guarding the output buffer (nests inside @c guard). */
+	fibril_mutex_t obuf_guard;
+	/** Output waiting to be sent to the socket. */
+	uint8_t out_buffer[OUT_BUFFER_SIZE];
+	size_t out_buffer_len;
+	/** Fires to flush output that sat in the buffer too long. */
+	fibril_timer_t *flush_timer;
+	/** The flush timer is armed or its handler has yet to run. */
+	bool flush_scheduled;
 } telnet_user_t;
 
 extern telnet_user_t *telnet_user_create(tcp_conn_t *);
@@ -88,6 +101,7 @@ extern bool telnet_user_is_zombie(telnet_user_t *);
 extern void telnet_user_notify_client_disconnected(telnet_user_t *);
 extern errno_t telnet_user_get_next_keyboard_event(telnet_user_t *, kbd_event_t *);
 extern errno_t telnet_user_send_data(telnet_user_t *, uint8_t *, size_t);
+extern void telnet_user_flush(telnet_user_t *);
 extern void telnet_user_update_cursor_x(telnet_user_t *, int);
 
 /** Print informational message about connected user. */
@@ -55,6 +55,9 @@ static tcp_cb_t conn_cb = {
 /** Buffer for receiving the request. */
 #define BUFFER_SIZE  1024
 
+/** How long to wait for damage before sending an empty update (usec). */
+#define DAMAGE_WAIT_TIMEOUT  500000
+
 static char rbuf[BUFFER_SIZE];
 static size_t rbuf_out;
 static size_t rbuf_in;
@@ -135,7 +138,7 @@ static void rfb_framebuffer_update_request_to_host(rfb_framebuffer_update_reques
     rfb_framebuffer_update_request_t *dst)
 {
 	dst->x = uint16_t_be2host(src->x);
-	dst->y = uint16_t_be2host(src->x);
+	dst->y = uint16_t_be2host(src->y);
 	dst->width = uint16_t_be2host(src->width);
 	dst->height = uint16_t_be2host(src->height);
 }
@@ -176,6 +179,7 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 {
 	memset(rfb, 0, sizeof(rfb_t));
 	fibril_mutex_initialize(&rfb->lock);
+	fibril_condvar_initialize(&rfb->damage_cv);
 
 	rfb_pixel_format_t *pf = &rfb->pixel_format;
 	pf->bpp = 32;
@@ -212,9 +216,102 @@ errno_t rfb_set_size(rfb_t *rfb, uint16_t width, uint16_t height)
 	/* Fill with white */
 	memset(rfb->framebuffer.data, 255, new_size);
 
+	/* Stale damage is meaningless for the new size */
+	rfb->damage_count = 0;
+
 	return EOK;
 }
 
+/** Compute envelope of two rectangles. */
+static void rfb_rect_envelope(rfb_rectangle_t *a, rfb_rectangle_t *b,
+    rfb_rectangle_t *dest)
+{
+	uint16_t x0 = min(a->x, b->x);
+	uint16_t y0 = min(a->y, b->y);
+	uint16_t x1 = max(a->x + a->width, b->x + b->width);
+	uint16_t y1 = max(a->y + a->height, b->y + b->height);
+
+	dest->x = x0;
+	dest->y = y0;
+	dest->width = x1 - x0;
+	dest->height = y1 - y0;
+}
+
+/** Determine whether two rectangles overlap or touch. */
+static bool rfb_rect_touches(rfb_rectangle_t *a, rfb_rectangle_t *b)
+{
+	return a->x <= b->x + b->width && b->x <= a->x + a->width &&
+	    a->y <= b->y + b->height && b->y <= a->y + a->height;
+}
+
+/** Add a damaged area to be sent with the next framebuffer update.
+ *
+ * The rectangle is merged with an already accumulated rectangle when
+ * they overlap or touch; otherwise it occupies a free slot. When all
+ * slots are taken, it is merged with the rectangle whose envelope
+ * grows the least, so damage never gets lost.
+ *
+ * @param rfb    RFB server
+ * @param x      Damage X coordinate
+ * @param y      Damage Y coordinate
+ * @param width  Damage width
+ * @param height Damage height
+ */
+void rfb_damage_add(rfb_t *rfb, uint16_t x, uint16_t y, uint16_t width,
+    uint16_t height)
+{
+	rfb_rectangle_t nrect = {
+		.x = x,
+		.y = y,
+		.width = width,
+		.height = height,
+		.enctype = 0
+	};
+
+	if (width == 0 || height == 0)
+		return;
+
+	fibril_mutex_lock(&rfb->lock);
+
+	bool merged = false;
+	for (unsigned i = 0; i < rfb->damage_count; i++) {
+		if (rfb_rect_touches(&rfb->damage_rects[i], &nrect)) {
+			rfb_rect_envelope(&rfb->damage_rects[i], &nrect,
+			    &rfb->damage_rects[i]);
+			merged = true;
+			break;
+		}
+	}
+
+	if (!merged) {
+		if (rfb->damage_count < RFB_DAMAGE_MAX_RECTS) {
+			rfb->damage_rects[rfb->damage_count++] = nrect;
+		} else {
+			/* Merge where the envelope grows the least */
+			rfb_rectangle_t env;
+			uint32_t best_area = 0;
+			unsigned best = 0;
+
+			for (unsigned i = 0; i < RFB_DAMAGE_MAX_RECTS; i++) {
+				rfb_rect_envelope(&rfb->damage_rects[i],
+				    &nrect, &env);
+				uint32_t area = (uint32_t) env.width *
+				    env.height;
+				if (i == 0 || area < best_area) {
+					best_area = area;
+					best = i;
+				}
+			}
+
+			rfb_rect_envelope(&rfb->damage_rects[best], &nrect,
+			    &rfb->damage_rects[best]);
+		}
+	}
+
+	fibril_condvar_broadcast(&rfb->damage_cv);
+	fibril_mutex_unlock(&rfb->lock);
+}
+
 static errno_t __attribute__((warn_unused_result))
 recv_message(tcp_conn_t *conn, char type, void *buf, size_t size)
 {
@@ -457,8 +554,8 @@ static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 	for (uint16_t y = 0; y < rect->height; y += 16) {
 		for (uint16_t x = 0; x < rect->width; x += 16) {
 			rfb_rectangle_t tile = {
-				.x = x,
-				.y = y,
+				.x = rect->x + x,
+				.y = rect->y + y,
 				.width = (x + 16 <= rect->width ? 16 : rect->width - x),
 				.height = (y + 16 <= rect->height ? 16 : rect->height - y)
 			};
@@ -489,18 +586,53 @@ static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
     bool incremental)
 {
+	rfb_rectangle_t rects[RFB_DAMAGE_MAX_RECTS];
+	unsigned rect_count = 0;
+
 	fibril_mutex_lock(&rfb->lock);
-	if (!incremental || !rfb->damage_valid) {
-		rfb->damage_rect.x = 0;
-		rfb->damage_rect.y = 0;
-		rfb->damage_rect.width = rfb->width;
-		rfb->damage_rect.height = rfb->height;
+
+	if (incremental && rfb->damage_count == 0) {
+		/*
+		 * Nothing changed. Wait a while for damage to arrive
+		 * instead of retransmitting unchanged content; on timeout
+		 * an empty update lets the client ask again.
+		 */
+		(void) fibril_condvar_wait_timeout(&rfb->damage_cv,
+		    &rfb->lock, DAMAGE_WAIT_TIMEOUT);
+	}
+
+	if (!incremental) {
+		rects[0].x = 0;
+		rects[0].y = 0;
+		rects[0].width = rfb->width;
+		rects[0].height = rfb->height;
+		rects[0].enctype = 0;
+		rect_count = 1;
+	} else {
+		/* Snapshot accumulated damage clipped to the framebuffer */
+		for (unsigned i = 0; i < rfb->damage_count; i++) {
+			rfb_rectangle_t drect = rfb->damage_rects[i];
+
+			if (drect.x >= rfb->width || drect.y >= rfb->height)
+				continue;
+
+			drect.width = min(drect.width, rfb->width - drect.x);
+			drect.height = min(drect.height, rfb->height - drect.y);
+			rects[rect_count++] = drect;
+		}
 	}
 
-	/* We send only single raw rectangle right now */
+	rfb->damage_count = 0;
+
 	size_t buf_size = sizeof(rfb_framebuffer_update_t) +
-	    sizeof(rfb_rectangle_t) * 1 +
-	    rfb_rect_encode_raw(rfb, &rfb->damage_rect, NULL);
+	    sizeof(rfb_rectangle_t) * rect_count;
+
+	for (unsigned i = 0; i < rect_count; i++) {
+		if (rfb->supports_trle)
+			buf_size += rfb_rect_encode_trle(rfb, &rects[i], NULL);
+		else
+			buf_size += rfb_rect_encode_raw(rfb, &rects[i], NULL);
+	}
 
 	void *buf = malloc(buf_size);
 	if (buf == NULL) {
@@ -512,25 +644,25 @@ static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
 	void *pos = buf;
 	rfb_framebuffer_update_t *fbu = buf;
 	fbu->message_type = RFB_SMSG_FRAMEBUFFER_UPDATE;
-	fbu->rect_count = 1;
+	fbu->rect_count = rect_count;
 	rfb_framebuffer_update_to_be(fbu, fbu);
 	pos += sizeof(rfb_framebuffer_update_t);
 
-	rfb_rectangle_t *rect = pos;
-	pos += sizeof(rfb_rectangle_t);
+	for (unsigned i = 0; i < rect_count; i++) {
+		rfb_rectangle_t *rect = pos;
+		pos += sizeof(rfb_rectangle_t);
 
-	*rect = rfb->damage_rect;
+		*rect = rects[i];
 
-	if (rfb->supports_trle) {
-		rect->enctype = RFB_ENCODING_TRLE;
-		pos += rfb_rect_encode_trle(rfb, rect, pos);
-	} else {
-		rect->enctype = RFB_ENCODING_RAW;
-		pos += rfb_rect_encode_raw(rfb, rect, pos);
+		if (rfb->supports_trle) {
+			rect->enctype = RFB_ENCODING_TRLE;
+			pos += rfb_rect_encode_trle(rfb, rect, pos);
+		} else {
+			rect->enctype = RFB_ENCODING_RAW;
+			pos += rfb_rect_encode_raw(rfb, rect, pos);
+		}
+		rfb_rectangle_to_be(rect, rect);
 	}
-	rfb_rectangle_to_be(rect, rect);
-
-	rfb->damage_valid = false;
 
 	size_t send_palette_size = 0;
 	void *send_palette = NULL;
@@ -54,6 +54,9 @@
 #define RFB_TILE_ENCODING_RAW 0
 #define RFB_TILE_ENCODING_SOLID 1
 
+/** Max damage rectangles accumulated between client update requests. */
+#define RFB_DAMAGE_MAX_RECTS 8
+
 typedef struct {
 	uint8_t bpp;
 	uint8_t depth;
@@ -154,8 +157,9 @@ typedef struct {
 	tcp_t *tcp;
 	tcp_listener_t *lst;
 	pixelmap_t framebuffer;
-	rfb_rectangle_t damage_rect;
-	bool damage_valid;
+	rfb_rectangle_t damage_rects[RFB_DAMAGE_MAX_RECTS];
+	unsigned damage_count;
+	fibril_condvar_t damage_cv;
 	fibril_mutex_t lock;
 	pixel_t *palette;
 	size_t palette_used;
@@ -165,5 +169,6 @@ typedef struct {
 extern errno_t rfb_init(rfb_t *, uint16_t, uint16_t, const char *);
 extern errno_t rfb_set_size(rfb_t *, uint16_t, uint16_t);
 extern errno_t rfb_listen(rfb_t *, uint16_t);
+extern void rfb_damage_add(rfb_t *, uint16_t, uint16_t, uint16_t, uint16_t);
 
 #endif
@@ -87,6 +87,8 @@ static void category_init(category_t *cat, const char *name)
 	fibril_mutex_initialize(&cat->mutex);
 	cat->name = str_dup(name);
 	cat->id = loc_create_id();
+	cat->gen = 0;
+	cat->rm_gen = 0;
 	link_initialize(&cat->cat_list);
 	list_initialize(&cat->svc_memb);
 }
@@ -124,6 +126,9 @@ errno_t category_add_service(category_t *cat, loc_service_t *svc)
 	nmemb->svc = svc;
 	nmemb->cat = cat;
 
+	cat->gen++;
+	nmemb->add_gen = cat->gen;
+
 	list_append(&nmemb->cat_link, &cat->svc_memb);
 	list_append(&nmemb->svc_link, &svc->cat_memb);
 
@@ -136,6 +141,9 @@ void category_remove_service(svc_categ_t *memb)
 	assert(fibril_mutex_is_locked(&memb->cat->mutex));
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
+	memb->cat->gen++;
+	memb->cat->rm_gen = memb->cat->gen;
+
 	list_remove(&memb->cat_link);
 	list_remove(&memb->svc_link);
 
@@ -195,6 +203,55 @@ errno_t category_get_services(category_t *cat, service_id_t *id_buf,
 	return EOK;
 }
 
+/** Get changes in category since a client-known generation.
+ *
+ * If @a since_gen is zero or a service has been removed from the
+ * category after that generation, the full membership is returned
+ * (and @a *full is set). Otherwise only the services added after
+ * @a since_gen are returned. @a *rgen receives the current generation,
+ * to be passed as @a since_gen in the next call.
+ */
+errno_t category_get_services_since(category_t *cat, sysarg_t since_gen,
+    service_id_t *id_buf, size_t buf_size, size_t *act_size, sysarg_t *rgen,
+    bool *full)
+{
+	size_t act_cnt;
+	size_t buf_cnt;
+
+	assert(fibril_mutex_is_locked(&cat->mutex));
+
+	*rgen = cat->gen;
+
+	if (since_gen == 0 || cat->rm_gen > since_gen) {
+		*full = true;
+		return category_get_services(cat, id_buf, buf_size, act_size);
+	}
+
+	*full = false;
+	buf_cnt = buf_size / sizeof(service_id_t);
+
+	act_cnt = 0;
+	list_foreach(cat->svc_memb, cat_link, svc_categ_t, memb) {
+		if (memb->add_gen > since_gen)
+			act_cnt++;
+	}
+	*act_size = act_cnt * sizeof(service_id_t);
+
+	if (buf_size % sizeof(service_id_t) != 0)
+		return EINVAL;
+
+	size_t pos = 0;
+	list_foreach(cat->svc_memb, cat_link, svc_categ_t, memb) {
+		if (memb->add_gen <= since_gen)
+			continue;
+		if (pos < buf_cnt)
+			id_buf[pos] = memb->svc->id;
+		pos++;
+	}
+
+	return EOK;
+}
+
 /**
  * @}
  */
@@ -51,6 +51,12 @@ typedef struct {
 	/** Category name */
 	const char *name;
 
+	/** Change generation, incremented on every membership change */
+	sysarg_t gen;
+
+	/** Generation of the most recent service removal */
+	sysarg_t rm_gen;
+
 	/** Link to list of categories (categ_dir_t.categories) */
 	link_t cat_list;
 
@@ -77,6 +83,9 @@ typedef struct {
 	category_t *cat;
 	/** Service */
 	loc_service_t *svc;
+
+	/** Category generation in which the service was added */
+	sysarg_t add_gen;
 } svc_categ_t;
 
 extern void categ_dir_init(categ_dir_t *);
@@ -90,6 +99,8 @@ extern category_t *category_get(categ_dir_t *, catid_t);
 extern category_t *category_find_by_name(categ_dir_t *, const char *);
 extern errno_t category_get_services(category_t *, service_id_t *, size_t,
     size_t *);
+extern errno_t category_get_services_since(category_t *, sysarg_t,
+    service_id_t *, size_t, size_t *, sysarg_t *, bool *);
 
 #endif
 
@@ -37,6 +37,8 @@
 
 #include <ipc/services.h>
 #include <ns.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <async.h>
 #include <stdio.h>
 #include <errno.h>
@@ -65,6 +67,22 @@ LIST_INITIALIZE(services_list);
 LIST_INITIALIZE(namespaces_list);
 LIST_INITIALIZE(servers_list);
 
+/*
+ * Hash tables for fast lookup of services and namespaces by ID and
+ * by name. They mirror services_list and namespaces_list and are
+ * protected by the same mutex (services_list_mutex).
+ */
+static hash_table_t services_by_id;
+static hash_table_t services_by_name;
+static hash_table_t namespaces_by_id;
+static hash_table_t namespaces_by_name;
+
+/** Key of services_by_name hash table */
+typedef struct {
+	const char *ns_name;
+	const char *name;
+} svc_name_key_t;
+
 /*
  * Locking order:
  *  servers_list_mutex
@@ -94,6 +112,123 @@ static categ_dir_t cdir;
 static FIBRIL_MUTEX_INITIALIZE(callback_sess_mutex);
 static LIST_INITIALIZE(callback_sess_list);
 
+static size_t str_key_hash(const char *str)
+{
+	size_t hash = 0;
+
+	while (*str != 0)
+		hash = hash_combine(hash, *str++);
+
+	return hash;
+}
+
+static size_t id_key_hash(const void *key)
+{
+	const service_id_t *id = key;
+	return *id;
+}
+
+static size_t svc_id_hash(const ht_link_t *item)
+{
+	loc_service_t *svc = hash_table_get_inst(item, loc_service_t, by_id);
+	return svc->id;
+}
+
+static bool svc_id_key_equal(const void *key, const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_service_t *svc = hash_table_get_inst(item, loc_service_t, by_id);
+	return svc->id == *id;
+}
+
+static size_t svc_name_key_hash(const void *key)
+{
+	const svc_name_key_t *nkey = key;
+	return hash_combine(str_key_hash(nkey->ns_name),
+	    str_key_hash(nkey->name));
+}
+
+static size_t svc_name_hash(const ht_link_t *item)
+{
+	loc_service_t *svc = hash_table_get_inst(item, loc_service_t, by_name);
+	return hash_combine(str_key_hash(svc->namespace->name),
+	    str_key_hash(svc->name));
+}
+
+static bool svc_name_key_equal(const void *key, const ht_link_t *item)
+{
+	const svc_name_key_t *nkey = key;
+	loc_service_t *svc = hash_table_get_inst(item, loc_service_t, by_name);
+	return (str_cmp(svc->namespace->name, nkey->ns_name) == 0) &&
+	    (str_cmp(svc->name, nkey->name) == 0);
+}
+
+static size_t ns_id_hash(const ht_link_t *item)
+{
+	loc_namespace_t *namespace =
+	    hash_table_get_inst(item, loc_namespace_t, by_id);
+	return namespace->id;
+}
+
+static bool ns_id_key_equal(const void *key, const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_namespace_t *namespace =
+	    hash_table_get_inst(item, loc_namespace_t, by_id);
+	return namespace->id == *id;
+}
+
+static size_t ns_name_key_hash(const void *key)
+{
+	return str_key_hash(key);
+}
+
+static size_t ns_name_hash(const ht_link_t *item)
+{
+	loc_namespace_t *namespace =
+	    hash_table_get_inst(item, loc_namespace_t, by_name);
+	return str_key_hash(namespace->name);
+}
+
+static bool ns_name_key_equal(const void *key, const ht_link_t *item)
+{
+	loc_namespace_t *namespace =
+	    hash_table_get_inst(item, loc_namespace_t, by_name);
+	return str_cmp(namespace->name, key) == 0;
+}
+
+static hash_table_ops_t svc_id_ops = {
+	.hash = svc_id_hash,
+	.key_hash = id_key_hash,
+	.key_equal = svc_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t svc_name_ops = {
+	.hash = svc_name_hash,
+	.key_hash = svc_name_key_hash,
+	.key_equal = svc_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t ns_id_ops = {
+	.hash = ns_id_hash,
+	.key_hash = id_key_hash,
+	.key_equal = ns_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t ns_name_ops = {
+	.hash = ns_name_hash,
+	.key_hash = ns_name_key_hash,
+	.key_equal = ns_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 service_id_t loc_create_id(void)
 {
 	/*
@@ -185,29 +320,23 @@ static loc_namespace_t *loc_namespace_find_name(const char *name)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(namespaces_list, namespaces, loc_namespace_t, namespace) {
-		if (str_cmp(namespace->name, name) == 0)
-			return namespace;
-	}
+	ht_link_t *link = hash_table_find(&namespaces_by_name, name);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_namespace_t, by_name);
 }
 
-/** Find namespace with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find namespace with given ID. */
 static loc_namespace_t *loc_namespace_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(namespaces_list, namespaces, loc_namespace_t, namespace) {
-		if (namespace->id == id)
-			return namespace;
-	}
+	ht_link_t *link = hash_table_find(&namespaces_by_id, &id);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_namespace_t, by_id);
 }
 
 /** Find service with given name. */
@@ -216,30 +345,28 @@ static loc_service_t *loc_service_find_name(const char *ns_name,
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if ((str_cmp(service->namespace->name, ns_name) == 0) &&
-		    (str_cmp(service->name, name) == 0))
-			return service;
-	}
+	svc_name_key_t key = {
+		.ns_name = ns_name,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&services_by_name, &key);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_service_t, by_name);
 }
 
-/** Find service with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find service with given ID. */
 static loc_service_t *loc_service_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if (service->id == id)
-			return service;
-	}
+	ht_link_t *link = hash_table_find(&services_by_id, &id);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_service_t, by_id);
 }
 
 /** Create a namespace (if not already present). */
@@ -268,8 +395,11 @@ static loc_namespace_t *loc_namespace_create(const char *ns_name)
 
 	/*
 	 * Insert new namespace into list of registered namespaces
+	 * and the lookup tables
 	 */
 	list_append(&(namespace->namespaces), &namespaces_list);
+	hash_table_insert(&namespaces_by_id, &namespace->by_id);
+	hash_table_insert(&namespaces_by_name, &namespace->by_name);
 
 	return namespace;
 }
@@ -281,6 +411,8 @@ static void loc_namespace_destroy(loc_namespace_t *namespace)
 
 	if (namespace->refcnt == 0) {
 		list_remove(&(namespace->namespaces));
+		hash_table_remove_item(&namespaces_by_id, &namespace->by_id);
+		hash_table_remove_item(&namespaces_by_name, &namespace->by_name);
 
 		free(namespace->name);
 		free(namespace);
@@ -312,6 +444,10 @@ static void loc_service_unregister_core(loc_service_t *service)
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 	assert(fibril_mutex_is_locked(&cdir.mutex));
 
+	/* Remove from the lookup tables before the namespace can go away */
+	hash_table_remove_item(&services_by_id, &service->by_id);
+	hash_table_remove_item(&services_by_name, &service->by_name);
+
 	loc_namespace_delref(service->namespace);
 	list_remove(&(service->services));
 	list_remove(&(service->server_services));
@@ -447,7 +583,7 @@ static errno_t loc_server_unregister(loc_server_t *server)
 
 	free(server);
 
-	loc_category_change_event();
+	loc_category_change_event(0, 0);
 	return EOK;
 }
 
@@ -523,8 +659,10 @@ static void loc_service_register(ipc_call_t *icall, loc_server_t *server)
 	loc_namespace_addref(namespace, service);
 	service->server = server;
 
-	/* Insert service into list of all services  */
+	/* Insert service into list of all services and the lookup tables */
 	list_append(&service->services, &services_list);
+	hash_table_insert(&services_by_id, &service->by_id);
+	hash_table_insert(&services_by_name, &service->by_name);
 
 	/* Insert service into list of services supplied by one server */
 	fibril_mutex_lock(&service->server->services_mutex);
@@ -563,7 +701,7 @@ static void loc_service_unregister(ipc_call_t *icall, loc_server_t *server)
 	 * Otherwise the current fibril might block and transitively wait for
 	 * the completion of requests that are routed to it via an IPC loop.
 	 */
-	loc_category_change_event();
+	loc_category_change_event(0, 0);
 	async_answer_0(icall, EOK);
 }
 
@@ -879,13 +1017,24 @@ static void loc_callback_create(ipc_call_t *icall)
 	async_answer_0(icall, EOK);
 }
 
-void loc_category_change_event(void)
+/** Send category change event to all registered callback sessions.
+ *
+ * The event carries the ID of the changed category and its new
+ * generation so that clients can fetch just the changes via
+ * LOC_CATEGORY_GET_SVCS_SINCE. Zero arguments mean the set of
+ * affected categories is not known (e.g. a server unregistered).
+ *
+ * @param cat_id ID of the changed category (zero if unspecified)
+ * @param gen    Category generation after the change (zero if unspecified)
+ *
+ */
+void loc_category_change_event(category_id_t cat_id, sysarg_t gen)
 {
 	fibril_mutex_lock(&callback_sess_mutex);
 
 	list_foreach(callback_sess_list, cb_sess_list, cb_sess_t, cb_sess) {
 		async_exch_t *exch = async_exchange_begin(cb_sess->sess);
-		async_msg_0(exch, LOC_EVENT_CAT_CHANGE);
+		async_msg_2(exch, LOC_EVENT_CAT_CHANGE, cat_id, gen);
 		async_exchange_end(exch);
 	}
 
@@ -1170,6 +1319,69 @@ static void loc_category_get_svcs(ipc_call_t *icall)
 	async_answer_1(icall, retval, act_size);
 }
 
+/** Get services in category added since a client-known generation.
+ *
+ * Like loc_category_get_svcs(), but the client passes the category
+ * generation from a previous call (or zero) in arg2 and, if no service
+ * has been removed from the category since then, receives only the
+ * services added after it. The answer carries the actual size in arg1,
+ * the current generation in arg2 and a flag in arg3 telling whether
+ * a full list (as opposed to a delta) was returned.
+ */
+static void loc_category_get_svcs_since(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	size_t act_size;
+	sysarg_t gen;
+	bool full;
+	errno_t rc;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	fibril_mutex_lock(&cdir.mutex);
+
+	category_t *cat = category_get(&cdir, ipc_get_arg1(icall));
+	if (cat == NULL) {
+		fibril_mutex_unlock(&cdir.mutex);
+		async_answer_0(&call, ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	service_id_t *id_buf = (service_id_t *) malloc(size);
+	if (id_buf == NULL) {
+		fibril_mutex_unlock(&cdir.mutex);
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	fibril_mutex_lock(&cat->mutex);
+
+	rc = category_get_services_since(cat, ipc_get_arg2(icall), id_buf,
+	    size, &act_size, &gen, &full);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&cat->mutex);
+		fibril_mutex_unlock(&cdir.mutex);
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	fibril_mutex_unlock(&cat->mutex);
+	fibril_mutex_unlock(&cdir.mutex);
+
+	errno_t retval = async_data_read_finalize(&call, id_buf, size);
+	free(id_buf);
+
+	async_answer_3(icall, retval, act_size, gen, full);
+}
+
 static void loc_null_create(ipc_call_t *icall)
 {
 	fibril_mutex_lock(&null_services_mutex);
@@ -1236,6 +1448,8 @@ static void loc_null_create(ipc_call_t *icall)
 	 */
 	list_append(&service->services, &services_list);
 	list_append(&service->server_services, &dummy_null_services);
+	hash_table_insert(&services_by_id, &service->by_id);
+	hash_table_insert(&services_by_name, &service->by_name);
 	null_services[i] = service;
 
 	fibril_mutex_unlock(&services_list_mutex);
@@ -1298,6 +1512,7 @@ static void loc_service_add_to_cat(ipc_call_t *icall)
 
 	fibril_mutex_lock(&cat->mutex);
 	retval = category_add_service(cat, svc);
+	sysarg_t gen = cat->gen;
 
 	fibril_mutex_unlock(&cat->mutex);
 	fibril_mutex_unlock(&cdir.mutex);
@@ -1308,7 +1523,7 @@ static void loc_service_add_to_cat(ipc_call_t *icall)
 	 * Otherwise the current fibril might block and transitively wait for
 	 * the completion of requests that are routed to it via an IPC loop.
 	 */
-	loc_category_change_event();
+	loc_category_change_event(cat_id, gen);
 	async_answer_0(icall, retval);
 }
 
@@ -1324,6 +1539,18 @@ static bool loc_init(void)
 	for (i = 0; i < NULL_SERVICES; i++)
 		null_services[i] = NULL;
 
+	if (!hash_table_create(&services_by_id, 0, 0, &svc_id_ops))
+		return false;
+
+	if (!hash_table_create(&services_by_name, 0, 0, &svc_name_ops))
+		return false;
+
+	if (!hash_table_create(&namespaces_by_id, 0, 0, &ns_id_ops))
+		return false;
+
+	if (!hash_table_create(&namespaces_by_name, 0, 0, &ns_name_ops))
+		return false;
+
 	categ_dir_init(&cdir);
 
 	cat = category_new("disk");
@@ -1504,6 +1731,9 @@ static void loc_connection_consumer(ipc_call_t *icall, void *arg)
 		case LOC_CATEGORY_GET_SVCS:
 			loc_category_get_svcs(&call);
 			break;
+		case LOC_CATEGORY_GET_SVCS_SINCE:
+			loc_category_get_svcs_since(&call);
+			break;
 		case LOC_ID_PROBE:
 			loc_id_probe(&call);
 			break;
@@ -36,6 +36,7 @@
 #define LOCSRV_H_
 
 #include <ipc/loc.h>
+#include <adt/hash_table.h>
 #include <async.h>
 #include <fibril_synch.h>
 #include <stddef.h>
@@ -69,6 +70,12 @@ typedef struct {
 	/** Link to namespaces_list */
 	link_t namespaces;
 
+	/** Link to namespaces_by_id hash table */
+	ht_link_t by_id;
+
+	/** Link to namespaces_by_name hash table */
+	ht_link_t by_name;
+
 	/** Unique namespace identifier */
 	service_id_t id;
 
@@ -92,6 +99,12 @@ typedef struct {
 	/** Link to list of services in category (category_t.services) */
 	link_t cat_services;
 
+	/** Link to services_by_id hash table */
+	ht_link_t by_id;
+
+	/** Link to services_by_name hash table */
+	ht_link_t by_name;
+
 	/** List of category memberships (svc_categ_t) */
 	list_t cat_memb;
 
@@ -111,7 +124,7 @@ typedef struct {
 extern fibril_mutex_t services_list_mutex;
 
 extern service_id_t loc_create_id(void);
-extern void loc_category_change_event(void);
+extern void loc_category_change_event(category_id_t, sysarg_t);
 
 #endif
 
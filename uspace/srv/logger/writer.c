@@ -39,14 +39,21 @@
 #include <io/log.h>
 #include <io/logctl.h>
 #include <io/klog.h>
+#include <as.h>
+#include <mem.h>
 #include <ns.h>
 #include <async.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include <str_error.h>
 #include "logger.h"
 
+/** Size of the buffer for lazily rendered binary records. */
+#define RENDER_BUFFER_SIZE 1024
+
 static logger_log_t *handle_create_log(sysarg_t parent)
 {
 	void *name;
@@ -91,6 +98,122 @@ leave:
 	return rc;
 }
 
+static errno_t handle_receive_ring(logger_ring_t **ring)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+
+	if (!async_share_out_receive(&call, &size, &flags))
+		return EINVAL;
+
+	if ((size < sizeof(logger_ring_t)) ||
+	    ((flags & AS_AREA_WRITE) == 0)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	void *ptr;
+	errno_t rc = async_share_out_finalize(&call, &ptr);
+	if ((rc != EOK) || (ptr == AS_MAP_FAILED))
+		return ENOMEM;
+
+	*ring = ptr;
+
+	return EOK;
+}
+
+static void handle_flush(logger_ring_t *ring, size_t *dropped)
+{
+	if (ring == NULL)
+		return;
+
+	while (true) {
+		size_t tail = atomic_load(&ring->tail);
+
+		if (tail == atomic_load(&ring->head)) {
+			/*
+			 * Clear the flush request and re-check: a writer
+			 * appending after the clear sends a new request,
+			 * one that appended before is caught by the
+			 * re-check.
+			 */
+			atomic_store(&ring->flush_pending, 0);
+			if (tail == atomic_load(&ring->head))
+				break;
+
+			continue;
+		}
+
+		logger_ring_slot_t *slot =
+		    &ring->slot[tail & (LOGGER_RING_SLOTS - 1)];
+
+		/* Copy the record out of the shared area. */
+		sysarg_t log_id = slot->log_id;
+		uint32_t level = slot->level;
+		uint32_t kind = slot->kind;
+		size_t size = slot->size;
+		if (size > LOGGER_RING_MSG_SIZE)
+			size = LOGGER_RING_MSG_SIZE;
+
+		char text[LOGGER_RING_MSG_SIZE + 1];
+		memcpy(text, slot->text, size);
+		text[size] = 0;
+
+		/*
+		 * Claim the record. Failure of either check means the
+		 * writer dropped it as the oldest record while we were
+		 * copying it.
+		 */
+		if (atomic_load(&slot->seq) != tail)
+			continue;
+
+		if (!atomic_compare_exchange_strong(&ring->tail, &tail,
+		    tail + 1))
+			continue;
+
+		if (level >= LVL_LIMIT)
+			continue;
+
+		logger_log_t *log = find_log_by_id_and_lock(log_id);
+		if (log == NULL)
+			continue;
+
+		if (shall_log_message(log, level)) {
+			const char *message = text;
+			char rendered[RENDER_BUFFER_SIZE];
+
+			/*
+			 * Binary records are rendered only here, once the
+			 * message is known to pass the level filter.
+			 */
+			if (kind == LOGGER_REC_BINARY) {
+				if (log_fmt_render(text, size, rendered,
+				    sizeof(rendered)) != EOK) {
+					log_unlock(log);
+					continue;
+				}
+
+				str_rtrim(rendered, '\n');
+				message = rendered;
+			}
+
+			KLOG_PRINTF(level, "[%s] %s: %s", log->full_name,
+			    log_level_str(level), message);
+			write_to_log(log, level, message);
+		}
+
+		log_unlock(log);
+	}
+
+	size_t total = atomic_load(&ring->dropped);
+	if (total != *dropped) {
+		logger_log("writer: %zu messages dropped on ring overflow.\n",
+		    total - *dropped);
+		*dropped = total;
+	}
+}
+
 void logger_connection_handler_writer(ipc_call_t *icall)
 {
 	logger_log_t *log;
@@ -104,6 +227,9 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 	logger_registered_logs_t registered_logs;
 	registered_logs_init(&registered_logs);
 
+	logger_ring_t *ring = NULL;
+	size_t ring_dropped = 0;
+
 	while (true) {
 		ipc_call_t call;
 		async_get_call(&call);
@@ -133,12 +259,26 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 			    ipc_get_arg2(&call));
 			async_answer_0(&call, rc);
 			break;
+		case LOGGER_WRITER_RING:
+			rc = handle_receive_ring(&ring);
+			async_answer_0(&call, rc);
+			break;
+		case LOGGER_WRITER_FLUSH:
+			handle_flush(ring, &ring_dropped);
+			async_answer_0(&call, EOK);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 			break;
 		}
 	}
 
+	if (ring != NULL) {
+		/* Drain whatever the client left behind. */
+		handle_flush(ring, &ring_dropped);
+		as_area_destroy(ring);
+	}
+
 	unregister_logs(&registered_logs);
 	logger_log("writer: client terminated.\n");
 }
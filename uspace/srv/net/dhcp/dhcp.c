@@ -51,6 +51,7 @@
 
 #include "dhcp.h"
 #include "dhcp_std.h"
+#include "lease.h"
 #include "transport.h"
 
 enum {
@@ -82,19 +83,6 @@ typedef enum {
 	ds_selecting
 } dhcp_state_t;
 
-typedef struct {
-	/** Message type */
-	enum dhcp_msg_type msg_type;
-	/** Offered address */
-	inet_naddr_t oaddr;
-	/** Server address */
-	inet_addr_t srv_addr;
-	/** Router address */
-	inet_addr_t router;
-	/** DNS server */
-	inet_addr_t dns_server;
-} dhcp_offer_t;
-
 typedef struct {
 	/** Link to dhcp_links list */
 	link_t links;
@@ -112,6 +100,10 @@ typedef struct {
 	dhcp_state_t state;
 	/** Last received offer */
 	dhcp_offer_t offer;
+	/** ID of configured address or 0 if none */
+	service_id_t addr_id;
+	/** ID of configured default route or 0 if none */
+	service_id_t sroute_id;
 } dhcp_link_t;
 
 static void dhcpsrv_recv(void *, void *, size_t);
@@ -183,7 +175,8 @@ static errno_t dhcp_send_request(dhcp_link_t *dlink, dhcp_offer_t *offer)
 	hdr->hlen = 6;
 	hdr->xid = host2uint32_t_be(42);
 	hdr->flags = flag_broadcast;
-	hdr->ciaddr = host2uint32_t_be(offer->oaddr.addr);
+	if (dlink->state != ds_init_reboot)
+		hdr->ciaddr = host2uint32_t_be(offer->oaddr.addr);
 	addr48(dlink->link_info.mac_addr, hdr->chaddr);
 	hdr->opt_magic = host2uint32_t_be(dhcp_opt_magic);
 
@@ -200,12 +193,19 @@ static errno_t dhcp_send_request(dhcp_link_t *dlink, dhcp_offer_t *offer)
 	opt[i++] = (offer->oaddr.addr >> 8) & 0xff;
 	opt[i++] = offer->oaddr.addr & 0xff;
 
-	opt[i++] = opt_server_id;
-	opt[i++] = 4;
-	opt[i++] = offer->srv_addr.addr >> 24;
-	opt[i++] = (offer->srv_addr.addr >> 16) & 0xff;
-	opt[i++] = (offer->srv_addr.addr >> 8) & 0xff;
-	opt[i++] = offer->srv_addr.addr & 0xff;
+	/*
+	 * In INIT-REBOOT state the request verifies a previously leased
+	 * address and must not contain the server identifier option
+	 * (RFC 2131 section 4.3.2).
+	 */
+	if (dlink->state != ds_init_reboot) {
+		opt[i++] = opt_server_id;
+		opt[i++] = 4;
+		opt[i++] = offer->srv_addr.addr >> 24;
+		opt[i++] = (offer->srv_addr.addr >> 16) & 0xff;
+		opt[i++] = (offer->srv_addr.addr >> 8) & 0xff;
+		opt[i++] = offer->srv_addr.addr & 0xff;
+	}
 
 	opt[i++] = opt_end;
 
@@ -360,28 +360,29 @@ static errno_t dhcp_parse_reply(void *msg, size_t size, dhcp_offer_t *offer)
 	return EOK;
 }
 
-static errno_t dhcp_cfg_create(service_id_t iplink, dhcp_offer_t *offer)
+static errno_t dhcp_cfg_create(dhcp_link_t *dlink, dhcp_offer_t *offer)
 {
 	errno_t rc;
-	service_id_t addr_id;
-	service_id_t sroute_id;
 	inet_naddr_t defr;
 
-	rc = inetcfg_addr_create_static("dhcp4a", &offer->oaddr, iplink,
-	    &addr_id);
+	rc = inetcfg_addr_create_static("dhcp4a", &offer->oaddr,
+	    dlink->link_id, &dlink->addr_id);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR,
 		    "Error creating IP address %s: %s", "dhcp4a", str_error(rc));
+		dlink->addr_id = 0;
 		return rc;
 	}
 
 	if (offer->router.addr != 0) {
 		inet_naddr_set(0, 0, &defr);
 
-		rc = inetcfg_sroute_create("dhcpdef", &defr, &offer->router, &sroute_id);
+		rc = inetcfg_sroute_create("dhcpdef", &defr, &offer->router,
+		    &dlink->sroute_id);
 		if (rc != EOK) {
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Error creating "
 			    "default route %s: %s.", "dhcpdef", str_error(rc));
+			dlink->sroute_id = 0;
 			return rc;
 		}
 	}
@@ -398,6 +399,32 @@ static errno_t dhcp_cfg_create(service_id_t iplink, dhcp_offer_t *offer)
 	return EOK;
 }
 
+/** Remove address and route previously created by dhcp_cfg_create(). */
+static void dhcp_cfg_remove(dhcp_link_t *dlink)
+{
+	errno_t rc;
+
+	if (dlink->sroute_id != 0) {
+		rc = inetcfg_sroute_delete(dlink->sroute_id);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Error deleting "
+			    "default route: %s.", str_error(rc));
+		}
+
+		dlink->sroute_id = 0;
+	}
+
+	if (dlink->addr_id != 0) {
+		rc = inetcfg_addr_delete(dlink->addr_id);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Error deleting "
+			    "IP address: %s.", str_error(rc));
+		}
+
+		dlink->addr_id = 0;
+	}
+}
+
 void dhcpsrv_links_init(void)
 {
 	list_initialize(&dhcp_links);
@@ -438,6 +465,41 @@ static errno_t dhcp_discover_proc(dhcp_link_t *dlink)
 	return rc;
 }
 
+/** Start INIT-REBOOT using a cached lease (stored in dlink->offer).
+ *
+ * Configure the cached address immediately so that the link is usable
+ * right away and verify the lease with the server in the background.
+ * The configuration is torn down again if the server NAKs the request.
+ */
+static errno_t dhcp_init_reboot_proc(dhcp_link_t *dlink)
+{
+	errno_t rc;
+
+	dlink->state = ds_init_reboot;
+
+	rc = dhcp_cfg_create(dlink, &dlink->offer);
+	if (rc != EOK)
+		return rc;
+
+	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Configured from cached lease, "
+	    "verifying with server.", dlink->link_info.name);
+
+	rc = dhcp_send_request(dlink, &dlink->offer);
+	if (rc != EOK) {
+		dhcp_cfg_remove(dlink);
+		return EIO;
+	}
+
+	dlink->retries_left = dhcp_request_retries;
+
+	if ((dlink->timeout->state == fts_not_set) ||
+	    (dlink->timeout->state == fts_fired))
+		fibril_timer_set(dlink->timeout, dhcp_request_timeout_val,
+		    dhcpsrv_request_timeout, dlink);
+
+	return EOK;
+}
+
 errno_t dhcpsrv_link_add(service_id_t link_id)
 {
 	dhcp_link_t *dlink;
@@ -479,13 +541,25 @@ errno_t dhcpsrv_link_add(service_id_t link_id)
 		goto error;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPDISCOVER");
-	rc = dhcp_discover_proc(dlink);
+	/*
+	 * If we have a cached lease for this link, request the cached
+	 * address via INIT-REBOOT instead of performing full discovery.
+	 */
+	rc = dhcp_lease_load(dlink->link_info.name, &dlink->offer);
+	if (rc == EOK)
+		rc = dhcp_init_reboot_proc(dlink);
+	else
+		rc = ENOENT;
+
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER.");
-		dhcp_link_set_failed(dlink);
-		rc = EIO;
-		goto error;
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Send DHCPDISCOVER");
+		rc = dhcp_discover_proc(dlink);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER.");
+			dhcp_link_set_failed(dlink);
+			rc = EIO;
+			goto error;
+		}
 	}
 
 	list_append(&dlink->links, &dhcp_links);
@@ -548,26 +622,75 @@ static void dhcpsrv_recv_ack(dhcp_link_t *dlink, dhcp_offer_t *offer)
 {
 	errno_t rc;
 
-	if (dlink->state != ds_requesting) {
+	if (dlink->state != ds_requesting &&
+	    dlink->state != ds_init_reboot) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received ack in state "
 		    " %d, ignoring.", (int)dlink->state);
 		return;
 	}
 
 	fibril_timer_clear(dlink->timeout);
+
+	/*
+	 * If a different address was provisionally configured from a
+	 * cached lease, remove it before applying the acknowledged one.
+	 */
+	if (dlink->addr_id != 0 &&
+	    (dlink->offer.oaddr.addr != offer->oaddr.addr ||
+	    dlink->offer.oaddr.prefix != offer->oaddr.prefix ||
+	    dlink->offer.router.addr != offer->router.addr))
+		dhcp_cfg_remove(dlink);
+
 	dlink->offer = *offer;
 	dlink->state = ds_bound;
 
-	rc = dhcp_cfg_create(dlink->link_id, offer);
+	if (dlink->addr_id == 0) {
+		rc = dhcp_cfg_create(dlink, offer);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Error creating configuration.");
+			return;
+		}
+	}
+
+	rc = dhcp_lease_save(dlink->link_info.name, &dlink->offer);
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Error creating configuration.");
-		return;
+		log_msg(LOG_DEFAULT, LVL_WARN, "%s: Failed caching lease: "
+		    "%s.", dlink->link_info.name, str_error(rc));
 	}
 
 	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Successfully configured.",
 	    dlink->link_info.name);
 }
 
+static void dhcpsrv_recv_nak(dhcp_link_t *dlink)
+{
+	errno_t rc;
+
+	if (dlink->state != ds_requesting &&
+	    dlink->state != ds_init_reboot) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received nak in state "
+		    " %d, ignoring.", (int)dlink->state);
+		return;
+	}
+
+	fibril_timer_clear(dlink->timeout);
+
+	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: Server declined request, "
+	    "restarting discovery.", dlink->link_info.name);
+
+	if (dlink->state == ds_init_reboot) {
+		/* The cached lease is no longer valid */
+		dhcp_cfg_remove(dlink);
+		(void) dhcp_lease_remove(dlink->link_info.name);
+	}
+
+	rc = dhcp_discover_proc(dlink);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Error sending DHCPDISCOVER.");
+		dhcp_link_set_failed(dlink);
+	}
+}
+
 static void dhcpsrv_recv(void *arg, void *msg, size_t size)
 {
 	dhcp_link_t *dlink = (dhcp_link_t *)arg;
@@ -590,6 +713,9 @@ static void dhcpsrv_recv(void *arg, void *msg, size_t size)
 	case msg_dhcpack:
 		dhcpsrv_recv_ack(dlink, &offer);
 		break;
+	case msg_dhcpnak:
+		dhcpsrv_recv_nak(dlink);
+		break;
 	default:
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Received unexpected "
 		    "message type. %d", (int)offer.msg_type);
@@ -630,12 +756,27 @@ static void dhcpsrv_request_timeout(void *arg)
 	dhcp_link_t *dlink = (dhcp_link_t *)arg;
 	errno_t rc;
 
-	assert(dlink->state == ds_requesting);
+	assert(dlink->state == ds_requesting ||
+	    dlink->state == ds_init_reboot);
 	log_msg(LOG_DEFAULT, LVL_NOTE, "%s: dhcpsrv_request_timeout",
 	    dlink->link_info.name);
 
 	if (dlink->retries_left == 0) {
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Retries exhausted");
+
+		if (dlink->state == ds_init_reboot) {
+			/*
+			 * No response to lease verification. Keep the
+			 * provisional configuration (the server may be
+			 * temporarily unreachable) and fall back to
+			 * discovery. A NAK or a new lease will replace it.
+			 */
+			rc = dhcp_discover_proc(dlink);
+			if (rc != EOK)
+				dhcp_link_set_failed(dlink);
+			return;
+		}
+
 		dhcp_link_set_failed(dlink);
 		return;
 	}
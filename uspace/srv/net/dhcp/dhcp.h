@@ -37,8 +37,24 @@
 #ifndef DHCP_H
 #define DHCP_H
 
+#include <inet/addr.h>
 #include <ipc/loc.h>
 
+#include "dhcp_std.h"
+
+typedef struct {
+	/** Message type */
+	enum dhcp_msg_type msg_type;
+	/** Offered address */
+	inet_naddr_t oaddr;
+	/** Server address */
+	inet_addr_t srv_addr;
+	/** Router address */
+	inet_addr_t router;
+	/** DNS server */
+	inet_addr_t dns_server;
+} dhcp_offer_t;
+
 extern void dhcpsrv_links_init(void);
 extern errno_t dhcpsrv_link_add(service_id_t);
 extern errno_t dhcpsrv_link_remove(service_id_t);
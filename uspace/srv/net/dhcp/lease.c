@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2013 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup dhcp
+ * @{
+ */
+/**
+ * @file
+ * @brief DHCP lease cache
+ *
+ * Persist the last lease obtained for each link in a SIF repository so
+ * that after a reboot the link can be configured immediately from the
+ * cached lease (and verified with the server using INIT-REBOOT) instead
+ * of going through a full DISCOVER/OFFER/REQUEST/ACK exchange.
+ *
+ * Leases are keyed by link name, since service IDs are not stable
+ * across reboots.
+ */
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <io/log.h>
+#include <mem.h>
+#include <sif.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "dhcp.h"
+#include "lease.h"
+
+/** File where cached leases are stored */
+static const char *dhcp_lease_file = "/cfg/dhcp.sif";
+
+/** Open (or create) the lease repository.
+ *
+ * @param rrepo Place to store pointer to SIF session
+ * @param rleases Place to store pointer to 'leases' node
+ * @return EOK on success or an error code
+ */
+static errno_t dhcp_lease_repo_open(sif_sess_t **rrepo, sif_node_t **rleases)
+{
+	sif_sess_t *repo = NULL;
+	sif_trans_t *trans = NULL;
+	sif_node_t *node;
+	const char *ntype;
+	errno_t rc;
+
+	/* Try opening existing repository */
+	rc = sif_open(dhcp_lease_file, &repo);
+	if (rc != EOK) {
+		/* Failed to open existing, create new repository */
+		rc = sif_create(dhcp_lease_file, &repo);
+		if (rc != EOK)
+			return rc;
+
+		rc = sif_trans_begin(repo, &trans);
+		if (rc != EOK)
+			goto error;
+
+		/* Create 'leases' node. */
+		rc = sif_node_append_child(trans, sif_get_root(repo),
+		    "leases", &node);
+		if (rc != EOK)
+			goto error;
+
+		rc = sif_trans_end(trans);
+		if (rc != EOK)
+			goto error;
+	} else {
+		/*
+		 * Opened existing repo. Find 'leases' node, should be
+		 * the first child of the root node.
+		 */
+		node = sif_node_first_child(sif_get_root(repo));
+		if (node == NULL) {
+			rc = EIO;
+			goto error;
+		}
+
+		/* Verify it's the correct node type */
+		ntype = sif_node_get_type(node);
+		if (str_cmp(ntype, "leases") != 0) {
+			rc = EIO;
+			goto error;
+		}
+	}
+
+	*rrepo = repo;
+	*rleases = node;
+	return EOK;
+error:
+	if (trans != NULL)
+		sif_trans_abort(trans);
+	(void) sif_close(repo);
+	return rc;
+}
+
+/** Find lease node for a link.
+ *
+ * @param leases Leases node
+ * @param link_name Link name
+ * @return Lease node or @c NULL if not found
+ */
+static sif_node_t *dhcp_lease_find(sif_node_t *leases, const char *link_name)
+{
+	sif_node_t *nlease;
+	const char *lname;
+
+	nlease = sif_node_first_child(leases);
+	while (nlease != NULL) {
+		if (str_cmp(sif_node_get_type(nlease), "lease") == 0) {
+			lname = sif_node_get_attr(nlease, "link");
+			if (lname != NULL && str_cmp(lname, link_name) == 0)
+				return nlease;
+		}
+
+		nlease = sif_node_next_child(nlease);
+	}
+
+	return NULL;
+}
+
+/** Load cached lease for a link.
+ *
+ * @param link_name Link name
+ * @param offer Place to store the cached lease
+ * @return EOK on success, ENOENT if no lease is cached for the link
+ *         or an error code
+ */
+errno_t dhcp_lease_load(const char *link_name, dhcp_offer_t *offer)
+{
+	sif_sess_t *repo = NULL;
+	sif_node_t *leases;
+	sif_node_t *nlease;
+	const char *saddr;
+	const char *ssrv;
+	const char *srouter;
+	const char *sdns;
+	errno_t rc;
+
+	rc = dhcp_lease_repo_open(&repo, &leases);
+	if (rc != EOK)
+		return rc;
+
+	nlease = dhcp_lease_find(leases, link_name);
+	if (nlease == NULL) {
+		rc = ENOENT;
+		goto error;
+	}
+
+	memset(offer, 0, sizeof(*offer));
+
+	saddr = sif_node_get_attr(nlease, "addr");
+	ssrv = sif_node_get_attr(nlease, "srvaddr");
+	if (saddr == NULL || ssrv == NULL) {
+		rc = EIO;
+		goto error;
+	}
+
+	rc = inet_naddr_parse(saddr, &offer->oaddr, NULL);
+	if (rc != EOK)
+		goto error;
+
+	rc = inet_addr_parse(ssrv, &offer->srv_addr, NULL);
+	if (rc != EOK)
+		goto error;
+
+	srouter = sif_node_get_attr(nlease, "router");
+	if (srouter != NULL) {
+		rc = inet_addr_parse(srouter, &offer->router, NULL);
+		if (rc != EOK)
+			goto error;
+	}
+
+	sdns = sif_node_get_attr(nlease, "dns");
+	if (sdns != NULL) {
+		rc = inet_addr_parse(sdns, &offer->dns_server, NULL);
+		if (rc != EOK)
+			goto error;
+	}
+
+	(void) sif_close(repo);
+	return EOK;
+error:
+	(void) sif_close(repo);
+	return rc;
+}
+
+/** Save lease for a link, replacing any previously cached lease.
+ *
+ * @param link_name Link name
+ * @param offer Lease to save
+ * @return EOK on success or an error code
+ */
+errno_t dhcp_lease_save(const char *link_name, dhcp_offer_t *offer)
+{
+	sif_sess_t *repo = NULL;
+	sif_trans_t *trans = NULL;
+	sif_node_t *leases;
+	sif_node_t *nlease;
+	char *saddr = NULL;
+	char *ssrv = NULL;
+	char *srouter = NULL;
+	char *sdns = NULL;
+	errno_t rc;
+
+	rc = dhcp_lease_repo_open(&repo, &leases);
+	if (rc != EOK)
+		return rc;
+
+	rc = inet_naddr_format(&offer->oaddr, &saddr);
+	if (rc != EOK)
+		goto error;
+
+	rc = inet_addr_format(&offer->srv_addr, &ssrv);
+	if (rc != EOK)
+		goto error;
+
+	if (offer->router.addr != 0) {
+		rc = inet_addr_format(&offer->router, &srouter);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if (offer->dns_server.addr != 0) {
+		rc = inet_addr_format(&offer->dns_server, &sdns);
+		if (rc != EOK)
+			goto error;
+	}
+
+	rc = sif_trans_begin(repo, &trans);
+	if (rc != EOK)
+		goto error;
+
+	nlease = dhcp_lease_find(leases, link_name);
+	if (nlease == NULL) {
+		rc = sif_node_append_child(trans, leases, "lease", &nlease);
+		if (rc != EOK)
+			goto error;
+
+		rc = sif_node_set_attr(trans, nlease, "link", link_name);
+		if (rc != EOK)
+			goto error;
+	}
+
+	rc = sif_node_set_attr(trans, nlease, "addr", saddr);
+	if (rc != EOK)
+		goto error;
+
+	rc = sif_node_set_attr(trans, nlease, "srvaddr", ssrv);
+	if (rc != EOK)
+		goto error;
+
+	if (srouter != NULL) {
+		rc = sif_node_set_attr(trans, nlease, "router", srouter);
+		if (rc != EOK)
+			goto error;
+	} else {
+		sif_node_unset_attr(trans, nlease, "router");
+	}
+
+	if (sdns != NULL) {
+		rc = sif_node_set_attr(trans, nlease, "dns", sdns);
+		if (rc != EOK)
+			goto error;
+	} else {
+		sif_node_unset_attr(trans, nlease, "dns");
+	}
+
+	rc = sif_trans_end(trans);
+	if (rc != EOK)
+		goto error;
+
+	trans = NULL;
+
+	free(saddr);
+	free(ssrv);
+	free(srouter);
+	free(sdns);
+	(void) sif_close(repo);
+	return EOK;
+error:
+	if (trans != NULL)
+		sif_trans_abort(trans);
+	free(saddr);
+	free(ssrv);
+	free(srouter);
+	free(sdns);
+	(void) sif_close(repo);
+	return rc;
+}
+
+/** Remove cached lease for a link (e.g. after receiving DHCPNAK).
+ *
+ * @param link_name Link name
+ * @return EOK on success (including no lease being cached) or an
+ *         error code
+ */
+errno_t dhcp_lease_remove(const char *link_name)
+{
+	sif_sess_t *repo = NULL;
+	sif_trans_t *trans = NULL;
+	sif_node_t *leases;
+	sif_node_t *nlease;
+	errno_t rc;
+
+	rc = dhcp_lease_repo_open(&repo, &leases);
+	if (rc != EOK)
+		return rc;
+
+	nlease = dhcp_lease_find(leases, link_name);
+	if (nlease == NULL) {
+		(void) sif_close(repo);
+		return EOK;
+	}
+
+	rc = sif_trans_begin(repo, &trans);
+	if (rc != EOK)
+		goto error;
+
+	sif_node_destroy(trans, nlease);
+
+	rc = sif_trans_end(trans);
+	if (rc != EOK)
+		goto error;
+
+	(void) sif_close(repo);
+	return EOK;
+error:
+	if (trans != NULL)
+		sif_trans_abort(trans);
+	(void) sif_close(repo);
+	return rc;
+}
+
+/** @}
+ */
@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file Record cache
+ *
+ * Caches query results keyed by (name, query type), honoring the TTL
+ * from the answer. Names that fail to resolve are cached negatively for
+ * a short while. A query that is already on the wire is represented by
+ * a pending entry; concurrent identical lookups wait for it to complete
+ * instead of each sending their own request.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <io/log.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+#include "cache.h"
+#include "dns_std.h"
+#include "dns_type.h"
+
+/** Maximum number of cached results */
+#define DNS_CACHE_MAX_ENTRIES 100
+/** Lower bound on positive TTL in seconds (so zero TTLs do not churn) */
+#define DNS_CACHE_MIN_TTL 1
+/** Upper bound on positive TTL in seconds */
+#define DNS_CACHE_MAX_TTL 3600
+/** How long a failed resolution is cached, in seconds */
+#define DNS_CACHE_NEG_TTL 30
+
+/** Cache entry state */
+typedef enum {
+	/** Query is on the wire */
+	dce_pending,
+	/** Name resolved successfully */
+	dce_positive,
+	/** Name failed to resolve */
+	dce_negative
+} dns_cache_state_t;
+
+/** Record cache entry */
+struct dns_cache_entry {
+	/** Link to cache hash table */
+	ht_link_t lcache;
+	/** Queried name */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Entry state */
+	dns_cache_state_t state;
+	/** Query result (for negative entries, always EIO) */
+	errno_t rc;
+	/** Canonical name (for positive entries) */
+	char *cname;
+	/** Host address (for positive entries) */
+	inet_addr_t addr;
+	/** Uptime at which the entry expires (not valid when pending) */
+	struct timespec expires;
+};
+
+/** Record cache lookup key */
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+static FIBRIL_CONDVAR_INITIALIZE(cache_cv);
+static hash_table_t cache_table;
+
+static size_t cache_name_hash(const char *name, dns_qtype_t qtype)
+{
+	size_t hash = 0;
+	const char *cp;
+
+	hash = hash_combine(hash, qtype);
+	for (cp = name; *cp != '\0'; cp++)
+		hash = hash_combine(hash, (uint8_t)*cp);
+
+	return hash_mix(hash);
+}
+
+static size_t cache_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, lcache);
+	return cache_name_hash(entry->name, entry->qtype);
+}
+
+static size_t cache_key_hash(const void *key)
+{
+	const dns_cache_key_t *ckey = key;
+	return cache_name_hash(ckey->name, ckey->qtype);
+}
+
+static bool cache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	dns_cache_entry_t *e1 = hash_table_get_inst(item1, dns_cache_entry_t,
+	    lcache);
+	dns_cache_entry_t *e2 = hash_table_get_inst(item2, dns_cache_entry_t,
+	    lcache);
+
+	return e1->qtype == e2->qtype && str_cmp(e1->name, e2->name) == 0;
+}
+
+static bool cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const dns_cache_key_t *ckey = key;
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, lcache);
+
+	return ckey->qtype == entry->qtype &&
+	    str_cmp(ckey->name, entry->name) == 0;
+}
+
+static void cache_remove_cb(ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, lcache);
+
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+static hash_table_ops_t cache_ops = {
+	.hash = cache_hash,
+	.key_hash = cache_key_hash,
+	.equal = cache_equal,
+	.key_equal = cache_key_equal,
+	.remove_callback = cache_remove_cb
+};
+
+/** Initialize the record cache.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_init(void)
+{
+	if (!hash_table_create(&cache_table, 0, 0, &cache_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Find cache entry, removing it if it has expired.
+ *
+ * Must be called with @c cache_lock held.
+ *
+ * @param name  Queried name
+ * @param qtype Query type
+ * @return Fresh cache entry or @c NULL if there is none
+ */
+static dns_cache_entry_t *cache_find(const char *name, dns_qtype_t qtype)
+{
+	dns_cache_key_t key;
+	dns_cache_entry_t *entry;
+	ht_link_t *link;
+	struct timespec now;
+
+	key.name = name;
+	key.qtype = qtype;
+
+	link = hash_table_find(&cache_table, &key);
+	if (link == NULL)
+		return NULL;
+
+	entry = hash_table_get_inst(link, dns_cache_entry_t, lcache);
+	if (entry->state == dce_pending)
+		return entry;
+
+	getuptime(&now);
+	if (ts_gteq(&now, &entry->expires)) {
+		hash_table_remove_item(&cache_table, &entry->lcache);
+		return NULL;
+	}
+
+	return entry;
+}
+
+static bool cache_evict_one(ht_link_t *item, void *arg)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, lcache);
+
+	/* Pending entries are owned by a querying fibril */
+	if (entry->state != dce_pending)
+		hash_table_remove_item(&cache_table, &entry->lcache);
+
+	return true;
+}
+
+/** Look up a query result in the cache.
+ *
+ * On a positive hit @a info is filled in and EOK is returned. On a
+ * negative hit the cached error is returned. ENOENT means the caller
+ * should perform the query on the wire: if @a *pend is not @c NULL,
+ * a pending entry was created on the caller's behalf and the caller
+ * must report the result via dns_cache_complete(); if it is @c NULL,
+ * the result cannot be cached and the caller just queries directly.
+ * If an identical query is already on the wire, the function waits for
+ * it and returns its result.
+ *
+ * @param name  Queried name
+ * @param qtype Query type
+ * @param info  Place to store host information (on EOK)
+ * @param pend  Place to store pending entry pointer (on ENOENT)
+ * @return EOK, ENOENT, ENOMEM or a cached query error
+ */
+errno_t dns_cache_lookup(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info, dns_cache_entry_t **pend)
+{
+	dns_cache_entry_t *entry;
+	errno_t rc;
+
+	*pend = NULL;
+
+	fibril_mutex_lock(&cache_lock);
+
+	for (;;) {
+		entry = cache_find(name, qtype);
+		if (entry == NULL)
+			break;
+
+		if (entry->state == dce_positive) {
+			info->cname = str_dup(entry->cname);
+			if (info->cname == NULL) {
+				fibril_mutex_unlock(&cache_lock);
+				return ENOMEM;
+			}
+
+			info->addr = entry->addr;
+			fibril_mutex_unlock(&cache_lock);
+
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_lookup: "
+			    "'%s' hit", name);
+			return EOK;
+		}
+
+		if (entry->state == dce_negative) {
+			rc = entry->rc;
+			fibril_mutex_unlock(&cache_lock);
+
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_lookup: "
+			    "'%s' negative hit", name);
+			return rc;
+		}
+
+		/* Identical query in flight - wait for its result */
+		fibril_condvar_wait(&cache_cv, &cache_lock);
+	}
+
+	if (hash_table_size(&cache_table) >= DNS_CACHE_MAX_ENTRIES)
+		hash_table_apply(&cache_table, cache_evict_one, NULL);
+
+	entry = calloc(1, sizeof(dns_cache_entry_t));
+	if (entry != NULL) {
+		entry->name = str_dup(name);
+		if (entry->name == NULL) {
+			free(entry);
+			entry = NULL;
+		}
+	}
+
+	if (entry != NULL) {
+		entry->qtype = qtype;
+		entry->state = dce_pending;
+		hash_table_insert(&cache_table, &entry->lcache);
+		*pend = entry;
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+	return ENOENT;
+}
+
+/** Report the result of a query to the cache.
+ *
+ * Completes the pending entry created by dns_cache_lookup() and wakes
+ * up any fibrils waiting for the result. Successful results are cached
+ * for min(@a ttl, one hour), EIO (name does not resolve) negatively for
+ * a short while; other errors are considered transient and not cached.
+ *
+ * @param entry Pending entry
+ * @param rc    Query result
+ * @param info  Host information (valid if @a rc is EOK)
+ * @param ttl   Record TTL in seconds (valid if @a rc is EOK)
+ */
+void dns_cache_complete(dns_cache_entry_t *entry, errno_t rc,
+    dns_host_info_t *info, uint32_t ttl)
+{
+	nsec_t life;
+
+	fibril_mutex_lock(&cache_lock);
+
+	if (rc == EOK) {
+		entry->cname = str_dup(info->cname);
+		if (entry->cname == NULL)
+			rc = ENOMEM;
+	}
+
+	if (rc == EOK) {
+		if (ttl < DNS_CACHE_MIN_TTL)
+			ttl = DNS_CACHE_MIN_TTL;
+		if (ttl > DNS_CACHE_MAX_TTL)
+			ttl = DNS_CACHE_MAX_TTL;
+
+		entry->state = dce_positive;
+		entry->addr = info->addr;
+		life = SEC2NSEC((nsec_t)ttl);
+	} else if (rc == EIO) {
+		entry->state = dce_negative;
+		entry->rc = rc;
+		life = SEC2NSEC(DNS_CACHE_NEG_TTL);
+	} else {
+		/* Transient failure - do not cache */
+		hash_table_remove_item(&cache_table, &entry->lcache);
+		entry = NULL;
+	}
+
+	if (entry != NULL) {
+		getuptime(&entry->expires);
+		ts_add_diff(&entry->expires, life);
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+	fibril_condvar_broadcast(&cache_cv);
+}
+
+/** @}
+ */
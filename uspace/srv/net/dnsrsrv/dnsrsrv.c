@@ -45,6 +45,7 @@
 #include <str.h>
 #include <task.h>
 
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "query.h"
@@ -59,6 +60,12 @@ static errno_t dnsr_init(void)
 	errno_t rc;
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_init()");
 
+	rc = dns_cache_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing cache.");
+		return EIO;
+	}
+
 	rc = transport_init();
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing transport.");
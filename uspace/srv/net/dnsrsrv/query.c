@@ -38,6 +38,7 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
@@ -47,7 +48,7 @@
 static uint16_t msg_id;
 
 static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+    dns_host_info_t *info, uint32_t *rttl)
 {
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
@@ -146,6 +147,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = rr->ttl;
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +173,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = rr->ttl;
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -189,6 +192,31 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 	return EIO;
 }
 
+/** Query name, going through the record cache.
+ *
+ * On a cache miss the query is sent on the wire and its result is
+ * reported back to the cache. Concurrent identical queries coalesce
+ * into a single wire query.
+ */
+static errno_t dns_name_query_cached(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info)
+{
+	dns_cache_entry_t *pend;
+	uint32_t ttl;
+	errno_t rc;
+
+	rc = dns_cache_lookup(name, qtype, info, &pend);
+	if (rc != ENOENT)
+		return rc;
+
+	ttl = 0;
+	rc = dns_name_query(name, qtype, info, &ttl);
+	if (pend != NULL)
+		dns_cache_complete(pend, rc, info, ttl);
+
+	return rc;
+}
+
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 {
 	dns_host_info_t *info = calloc(1, sizeof(dns_host_info_t));
@@ -199,17 +227,17 @@ errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 
 	switch (ver) {
 	case ip_any:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_name_query_cached(name, DTYPE_AAAA, info);
 
 		if (rc != EOK)
-			rc = dns_name_query(name, DTYPE_A, info);
+			rc = dns_name_query_cached(name, DTYPE_A, info);
 
 		break;
 	case ip_v4:
-		rc = dns_name_query(name, DTYPE_A, info);
+		rc = dns_name_query_cached(name, DTYPE_A, info);
 		break;
 	case ip_v6:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_name_query_cached(name, DTYPE_AAAA, info);
 		break;
 	default:
 		rc = EINVAL;
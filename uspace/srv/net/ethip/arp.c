@@ -34,6 +34,7 @@
  * @brief
  */
 
+#include <adt/list.h>
 #include <errno.h>
 #include <io/log.h>
 #include <inet/iplink_srv.h>
@@ -46,11 +47,38 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
+/** Transmit a frame that waited for address resolution.
+ *
+ * @param nic      NIC to send the frame on
+ * @param mac_addr Resolved destination MAC address
+ * @param frame    Pending frame (consumed)
+ */
+static void arp_send_pending(ethip_nic_t *nic, addr48_t mac_addr,
+    ethip_pending_frame_t *frame)
+{
+	eth_frame_t eframe;
+	void *fdata;
+	size_t fsize;
+	errno_t rc;
+
+	addr48(mac_addr, eframe.dest);
+	addr48(nic->mac_addr, eframe.src);
+	eframe.etype_len = ETYPE_IP;
+	eframe.data = frame->data;
+	eframe.size = frame->size;
+
+	rc = eth_pdu_encode(&eframe, &fdata, &fsize);
+	if (rc == EOK) {
+		(void) ethip_nic_send(nic, fdata, fsize);
+		free(fdata);
+	}
+
+	free(frame->data);
+	free(frame);
+}
+
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "arp_received()");
@@ -77,8 +105,20 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Request/reply to my address");
 
-	(void) atrans_add(packet.sender_proto_addr,
-	    packet.sender_hw_addr);
+	list_t rqueue;
+	list_initialize(&rqueue);
+
+	if (atrans_add(packet.sender_proto_addr, packet.sender_hw_addr,
+	    &rqueue) == EOK) {
+		/* Transmit frames that waited for this translation */
+		while (!list_empty(&rqueue)) {
+			link_t *link = list_first(&rqueue);
+			ethip_pending_frame_t *pframe = list_get_instance(link,
+			    ethip_pending_frame_t, link);
+			list_remove(&pframe->link);
+			arp_send_pending(nic, packet.sender_hw_addr, pframe);
+		}
+	}
 
 	if (packet.opcode == aop_request) {
 		arp_eth_packet_t reply;
@@ -93,18 +133,37 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
+/** Translate IPv4 address to MAC address, resolving asynchronously.
+ *
+ * On a cache hit EOK is returned and @a mac_addr is valid; the caller
+ * should transmit the frame itself. On a cache miss the frame payload is
+ * queued for transmission once the address resolves, an ARP request is
+ * sent if none is outstanding and EINPROGRESS is returned. The sending
+ * fibril never blocks waiting for a reply.
+ *
+ * @param nic      NIC to resolve on
+ * @param src_addr Source IPv4 address
+ * @param ip_addr  Destination IPv4 address
+ * @param mac_addr Place to store MAC address (on EOK)
+ * @param data     Frame payload
+ * @param size     Frame payload size
+ * @return EOK, EINPROGRESS, EHOSTUNREACH or ENOMEM
+ */
 errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
-    addr48_t mac_addr)
+    addr48_t mac_addr, void *data, size_t size)
 {
+	bool req;
+	errno_t rc;
+
 	/* Broadcast address */
 	if (ip_addr == addr32_broadcast_all_hosts) {
 		addr48(addr48_broadcast, mac_addr);
 		return EOK;
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	rc = atrans_lookup_queue(ip_addr, mac_addr, data, size, &req);
+	if (rc != EINPROGRESS || !req)
+		return rc;
 
 	arp_eth_packet_t packet;
 
@@ -114,11 +173,13 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 	addr48(addr48_broadcast, packet.target_hw_addr);
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
+	/*
+	 * If the request cannot be sent, the queued frame is dropped
+	 * when the incomplete entry expires.
+	 */
+	(void) arp_send_packet(nic, &packet);
 
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	return EINPROGRESS;
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
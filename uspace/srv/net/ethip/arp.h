@@ -39,10 +39,12 @@
 
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <stddef.h>
 #include "ethip.h"
 
 extern void arp_received(ethip_nic_t *, eth_frame_t *);
-extern errno_t arp_translate(ethip_nic_t *, addr32_t, addr32_t, addr48_t);
+extern errno_t arp_translate(ethip_nic_t *, addr32_t, addr32_t, addr48_t,
+    void *, size_t);
 
 #endif
 
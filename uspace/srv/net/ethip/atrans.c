@@ -31,134 +31,334 @@
  */
 /**
  * @file
- * @brief
+ * @brief Neighbor (address translation) cache
+ *
+ * Translations are kept in a hash table keyed by IP address. Each entry
+ * carries an expiration time; completed translations, outstanding
+ * resolutions and failed resolutions all age out. While a resolution is
+ * outstanding, frames for that neighbor are queued on the entry instead
+ * of blocking the sending fibril; they are released (or dropped) when
+ * the resolution completes (or fails).
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "atrans.h"
 #include "ethip.h"
 
-/** Address translation list (of ethip_atrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+/** How long a completed translation remains valid */
+#define ATRANS_VALID_TTL SEC2NSEC(600)
+/** How long a failed resolution is remembered */
+#define ATRANS_NEGATIVE_TTL SEC2NSEC(10)
+/** How long to wait for an outstanding resolution to complete */
+#define ATRANS_REQUEST_TTL SEC2NSEC(3)
 
-static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+/** Address translation table (of ethip_atrans_t), keyed by IP address */
+static FIBRIL_MUTEX_INITIALIZE(atrans_lock);
+static hash_table_t atrans_table;
+
+static size_t atrans_ht_hash(const ht_link_t *item)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
-	}
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    latrans);
+	return hash_mix(atrans->ip_addr);
+}
 
-	return NULL;
+static size_t atrans_ht_key_hash(const void *key)
+{
+	const addr32_t *ip_addr = key;
+	return hash_mix(*ip_addr);
 }
 
-errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+static bool atrans_ht_equal(const ht_link_t *item1, const ht_link_t *item2)
 {
-	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
+	ethip_atrans_t *a1 = hash_table_get_inst(item1, ethip_atrans_t,
+	    latrans);
+	ethip_atrans_t *a2 = hash_table_get_inst(item2, ethip_atrans_t,
+	    latrans);
+
+	return a1->ip_addr == a2->ip_addr;
+}
+
+static bool atrans_ht_key_equal(const void *key, const ht_link_t *item)
+{
+	const addr32_t *ip_addr = key;
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    latrans);
 
-	atrans = calloc(1, sizeof(ethip_atrans_t));
-	if (atrans == NULL)
+	return *ip_addr == atrans->ip_addr;
+}
+
+static hash_table_ops_t atrans_ht_ops = {
+	.hash = atrans_ht_hash,
+	.key_hash = atrans_ht_key_hash,
+	.equal = atrans_ht_equal,
+	.key_equal = atrans_ht_key_equal,
+	.remove_callback = NULL
+};
+
+/** Initialize the address translation table.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_init(void)
+{
+	if (!hash_table_create(&atrans_table, 0, 0, &atrans_ht_ops))
 		return ENOMEM;
 
-	atrans->ip_addr = ip_addr;
-	addr48(mac_addr, atrans->mac_addr);
+	return EOK;
+}
+
+/** Drop all frames queued on a translation entry.
+ *
+ * @param atrans Translation entry
+ */
+static void atrans_drop_frames(ethip_atrans_t *atrans)
+{
+	ethip_pending_frame_t *frame;
+	link_t *link;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+	while (!list_empty(&atrans->frame_queue)) {
+		link = list_first(&atrans->frame_queue);
+		frame = list_get_instance(link, ethip_pending_frame_t, link);
+		list_remove(&frame->link);
+		free(frame->data);
+		free(frame);
 	}
+}
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+/** Destroy a translation entry, dropping any queued frames.
+ *
+ * @param atrans Translation entry
+ */
+static void atrans_destroy(ethip_atrans_t *atrans)
+{
+	atrans_drop_frames(atrans);
+	free(atrans);
+}
 
-	return EOK;
+/** Set the expiration time of a translation entry.
+ *
+ * @param atrans Translation entry
+ * @param ttl    Entry lifetime in nanoseconds
+ */
+static void atrans_set_expiry(ethip_atrans_t *atrans, nsec_t ttl)
+{
+	getuptime(&atrans->expires);
+	ts_add_diff(&atrans->expires, ttl);
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Find translation entry, aging it as needed.
+ *
+ * An expired outstanding resolution turns into a negative entry (and its
+ * queued frames are dropped). Other expired entries are removed. Must be
+ * called with @c atrans_lock held.
+ *
+ * @param ip_addr IP address
+ * @return Fresh translation entry or @c NULL if there is none
+ */
+static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+{
+	ethip_atrans_t *atrans;
+	ht_link_t *link;
+	struct timespec now;
+
+	link = hash_table_find(&atrans_table, &ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	atrans = hash_table_get_inst(link, ethip_atrans_t, latrans);
+
+	getuptime(&now);
+	if (!ts_gteq(&now, &atrans->expires))
+		return atrans;
+
+	if (atrans->state == at_incomplete) {
+		/* Resolution timed out - remember the failure */
+		atrans->state = at_negative;
+		atrans_set_expiry(atrans, ATRANS_NEGATIVE_TTL);
+		atrans_drop_frames(atrans);
+		return atrans;
+	}
+
+	hash_table_remove_item(&atrans_table, &atrans->latrans);
+	atrans_destroy(atrans);
+	return NULL;
+}
+
+/** Add a completed translation.
+ *
+ * Any frames queued for the address are moved to @a rqueue for the caller
+ * to transmit (outside of the translation table lock).
+ *
+ * @param ip_addr  IP address
+ * @param mac_addr MAC address
+ * @param rqueue   List to receive queued frames (of ethip_pending_frame_t)
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr, list_t *rqueue)
 {
 	ethip_atrans_t *atrans;
 
-	fibril_mutex_lock(&atrans_list_lock);
+	fibril_mutex_lock(&atrans_lock);
+
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
+		atrans = calloc(1, sizeof(ethip_atrans_t));
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			return ENOMEM;
+		}
+
+		atrans->ip_addr = ip_addr;
+		list_initialize(&atrans->frame_queue);
+		hash_table_insert(&atrans_table, &atrans->latrans);
 	}
 
-	list_remove(&atrans->atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = at_complete;
+	atrans_set_expiry(atrans, ATRANS_VALID_TTL);
+
+	/* Hand over frames that waited for this resolution */
+	list_concat(rqueue, &atrans->frame_queue);
+
+	fibril_mutex_unlock(&atrans_lock);
 
 	return EOK;
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, addr48_t mac_addr)
+/** Remove translation entry.
+ *
+ * @param ip_addr IP address
+ * @return EOK on success, ENOENT if there is no translation
+ */
+errno_t atrans_remove(addr32_t ip_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+	ht_link_t *link;
+
+	fibril_mutex_lock(&atrans_lock);
+	link = hash_table_find(&atrans_table, &ip_addr);
+	if (link == NULL) {
+		fibril_mutex_unlock(&atrans_lock);
 		return ENOENT;
+	}
+
+	atrans = hash_table_get_inst(link, ethip_atrans_t, latrans);
+	hash_table_remove_item(&atrans_table, &atrans->latrans);
+	fibril_mutex_unlock(&atrans_lock);
+	atrans_destroy(atrans);
 
-	addr48(atrans->mac_addr, mac_addr);
 	return EOK;
 }
 
+/** Look up address translation.
+ *
+ * @param ip_addr  IP address
+ * @param mac_addr Place to store MAC address
+ * @return EOK on success, ENOENT if there is no valid translation
+ */
 errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
 {
-	errno_t rc;
+	ethip_atrans_t *atrans;
+
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL || atrans->state != at_complete) {
+		fibril_mutex_unlock(&atrans_lock);
+		return ENOENT;
+	}
 
-	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
+	addr48(atrans->mac_addr, mac_addr);
+	fibril_mutex_unlock(&atrans_lock);
 
-	return rc;
+	return EOK;
 }
 
-static void atrans_lookup_timeout_handler(void *arg)
+/** Look up address translation, queueing the frame on a miss.
+ *
+ * If a valid translation exists, it is returned just like from
+ * atrans_lookup(). Otherwise a copy of the frame payload is queued on the
+ * (possibly newly created) incomplete entry and EINPROGRESS is returned;
+ * @a *req tells the caller whether it should send a resolution request
+ * (@c false means one is already outstanding). If the address recently
+ * failed to resolve, EHOSTUNREACH is returned and nothing is queued.
+ *
+ * @param ip_addr  IP address
+ * @param mac_addr Place to store MAC address (on EOK)
+ * @param data     Frame payload
+ * @param size     Frame payload size
+ * @param req      Place to store request flag (on EINPROGRESS)
+ * @return EOK, EINPROGRESS, EHOSTUNREACH or ENOMEM
+ */
+errno_t atrans_lookup_queue(addr32_t ip_addr, addr48_t mac_addr, void *data,
+    size_t size, bool *req)
 {
-	bool *timedout = (bool *)arg;
+	ethip_atrans_t *atrans;
+	ethip_pending_frame_t *frame;
+	bool created = false;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
-}
+	fibril_mutex_lock(&atrans_lock);
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    addr48_t mac_addr)
-{
-	fibril_timer_t *t;
-	bool timedout;
-	errno_t rc;
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans->state == at_complete) {
+		addr48(atrans->mac_addr, mac_addr);
+		fibril_mutex_unlock(&atrans_lock);
+		return EOK;
+	}
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
-		return ENOMEM;
+	if (atrans != NULL && atrans->state == at_negative) {
+		fibril_mutex_unlock(&atrans_lock);
+		return EHOSTUNREACH;
+	}
 
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+	if (atrans == NULL) {
+		atrans = calloc(1, sizeof(ethip_atrans_t));
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			return ENOMEM;
+		}
 
-	fibril_mutex_lock(&atrans_list_lock);
+		atrans->ip_addr = ip_addr;
+		atrans->state = at_incomplete;
+		list_initialize(&atrans->frame_queue);
+		atrans_set_expiry(atrans, ATRANS_REQUEST_TTL);
+		hash_table_insert(&atrans_table, &atrans->latrans);
+		created = true;
+	}
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+	frame = calloc(1, sizeof(ethip_pending_frame_t));
+	if (frame == NULL)
+		goto error;
+
+	frame->data = malloc(size);
+	if (frame->data == NULL) {
+		free(frame);
+		goto error;
 	}
 
-	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	memcpy(frame->data, data, size);
+	frame->size = size;
+	list_append(&frame->link, &atrans->frame_queue);
 
-	return rc;
+	fibril_mutex_unlock(&atrans_lock);
+	*req = created;
+	return EINPROGRESS;
+error:
+	if (created) {
+		hash_table_remove_item(&atrans_table, &atrans->latrans);
+		free(atrans);
+	}
+	fibril_mutex_unlock(&atrans_lock);
+	return ENOMEM;
 }
 
 /** @}
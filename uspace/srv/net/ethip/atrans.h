@@ -37,14 +37,18 @@
 #ifndef ATRANS_H_
 #define ATRANS_H_
 
+#include <adt/list.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <stdbool.h>
 #include "ethip.h"
 
-extern errno_t atrans_add(addr32_t, addr48_t);
+extern errno_t atrans_init(void);
+extern errno_t atrans_add(addr32_t, addr48_t, list_t *);
 extern errno_t atrans_remove(addr32_t);
 extern errno_t atrans_lookup(addr32_t, addr48_t);
-extern errno_t atrans_lookup_timeout(addr32_t, usec_t, addr48_t);
+extern errno_t atrans_lookup_queue(addr32_t, addr48_t, void *, size_t,
+    bool *);
 
 #endif
 
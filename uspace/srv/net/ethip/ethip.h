@@ -37,6 +37,7 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
 #include <inet/iplink_srv.h>
@@ -44,6 +45,7 @@
 #include <loc.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct {
 	link_t link;
@@ -62,6 +64,11 @@ typedef struct ethip_nic {
 	/** MAC address */
 	addr48_t mac_addr;
 
+	/** Shared RX frame pool mapped from the driver (may be NULL) */
+	void *frame_pool;
+	/** Size of the shared RX frame pool in bytes */
+	size_t frame_pool_size;
+
 	/**
 	 * List of IP addresses configured on this link
 	 * (of the type ethip_link_addr_t)
@@ -108,11 +115,37 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
-/** Address translation table element */
+/** Address translation entry state */
+typedef enum {
+	/** Resolution in progress */
+	at_incomplete,
+	/** Valid translation */
+	at_complete,
+	/** Resolution failed */
+	at_negative
+} ethip_atrans_state_t;
+
+/** Frame waiting for address resolution */
+typedef struct {
+	link_t link;
+	/** Frame payload */
+	void *data;
+	/** Payload size */
+	size_t size;
+} ethip_pending_frame_t;
+
+/** Address translation table entry */
 typedef struct {
-	link_t atrans_list;
+	/** Link to the translation hash table */
+	ht_link_t latrans;
 	addr32_t ip_addr;
 	addr48_t mac_addr;
+	/** Entry state */
+	ethip_atrans_state_t state;
+	/** Uptime at which the entry expires */
+	struct timespec expires;
+	/** Frames waiting for resolution (of ethip_pending_frame_t) */
+	list_t frame_queue;
 } ethip_atrans_t;
 
 extern errno_t ethip_iplink_init(ethip_nic_t *);
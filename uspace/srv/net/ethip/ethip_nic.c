@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <as.h>
 #include <async.h>
 #include <stdbool.h>
 #include <errno.h>
@@ -282,6 +283,128 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_received_list(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	void *data;
+	size_t size;
+	size_t offs;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_list() nic=%p",
+	    nic);
+
+	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		return;
+	}
+
+	/*
+	 * The batch is a sequence of frames, each prefixed with its size
+	 * as a uint32_t.
+	 */
+	offs = 0;
+	while (offs + sizeof(uint32_t) <= size) {
+		uint32_t fsize;
+
+		memcpy(&fsize, data + offs, sizeof(fsize));
+		offs += sizeof(fsize);
+
+		if (fsize > size - offs) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "Malformed frame batch");
+			rc = EINVAL;
+			break;
+		}
+
+		rc = ethip_received(&nic->iplink, data + offs, fsize);
+		offs += fsize;
+	}
+
+	free(data);
+	async_answer_0(call, rc);
+}
+
+static void ethip_nic_frame_pool(ethip_nic_t *nic, ipc_call_t *call)
+{
+	ipc_call_t scall;
+	size_t size;
+	unsigned int flags;
+	void *pool;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_frame_pool() nic=%p", nic);
+
+	if (!async_share_out_receive(&scall, &size, &flags)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if ((flags & AS_AREA_READ) == 0) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&scall, &pool);
+	if (rc != EOK || pool == AS_MAP_FAILED) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed mapping frame pool");
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	nic->frame_pool = pool;
+	nic->frame_pool_size = size;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Mapped frame pool (%zu bytes)", size);
+	async_answer_0(call, EOK);
+}
+
+static void ethip_nic_received_pool_list(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	nic_pool_frame_t *pframes;
+	size_t size;
+	size_t cnt;
+	size_t i;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_pool_list() "
+	    "nic=%p", nic);
+
+	if (nic->frame_pool == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = async_data_write_accept((void **) &pframes, false, 0, 0, 0,
+	    &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		return;
+	}
+
+	cnt = size / sizeof(nic_pool_frame_t);
+	for (i = 0; i < cnt; i++) {
+		size_t offs = (size_t) pframes[i].idx * NIC_POOL_SLOT_SIZE;
+
+		if (pframes[i].size > NIC_POOL_SLOT_SIZE ||
+		    offs + pframes[i].size > nic->frame_pool_size) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "Invalid pool frame reference");
+			rc = EINVAL;
+			break;
+		}
+
+		rc = ethip_received(&nic->iplink, nic->frame_pool + offs,
+		    pframes[i].size);
+	}
+
+	free(pframes);
+
+	/* Answering returns the pool slots to the driver */
+	async_answer_0(call, rc);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -310,6 +433,15 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_RECEIVED:
 			ethip_nic_received(nic, &call);
 			break;
+		case NIC_EV_RECEIVED_LIST:
+			ethip_nic_received_list(nic, &call);
+			break;
+		case NIC_EV_FRAME_POOL:
+			ethip_nic_frame_pool(nic, &call);
+			break;
+		case NIC_EV_RECEIVED_POOL_LIST:
+			ethip_nic_received_pool_list(nic, &call);
+			break;
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup inet
+ * @{
+ */
+/**
+ * @file
+ * @brief Direction (next hop) cache
+ *
+ * Caches the result of route resolution keyed by (destination, TOS)
+ * so that steady-state forwarding of a flow does not repeat the
+ * address object and static route lookups for every datagram. The
+ * cache is flushed whenever the configuration it was derived from
+ * (address objects or static routes) changes.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <fibril_synch.h>
+#include <io/log.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "dircache.h"
+#include "inetsrv.h"
+
+/** Maximum number of cached directions */
+#define DIRCACHE_MAX_ENTRIES 64
+
+/** Direction cache entry */
+typedef struct {
+	/** Link to dircache hash table */
+	ht_link_t link;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Type of service */
+	uint8_t tos;
+	/** Cached direction */
+	inet_dir_t dir;
+} inet_dircache_entry_t;
+
+/** Direction cache lookup key */
+typedef struct {
+	inet_addr_t *dest;
+	uint8_t tos;
+} inet_dircache_key_t;
+
+static FIBRIL_MUTEX_INITIALIZE(dircache_lock);
+static hash_table_t dircache;
+static bool dircache_valid = false;
+
+static size_t dircache_addr_hash(inet_addr_t *dest, uint8_t tos)
+{
+	size_t hash = 0;
+	size_t i;
+
+	hash = hash_combine(hash, tos);
+	hash = hash_combine(hash, dest->version);
+
+	if (dest->version == ip_v6) {
+		for (i = 0; i < sizeof(dest->addr6); i++)
+			hash = hash_combine(hash, dest->addr6[i]);
+	} else {
+		hash = hash_combine(hash, dest->addr);
+	}
+
+	return hash_mix(hash);
+}
+
+static size_t dircache_hash(const ht_link_t *item)
+{
+	inet_dircache_entry_t *entry = hash_table_get_inst(item,
+	    inet_dircache_entry_t, link);
+	return dircache_addr_hash(&entry->dest, entry->tos);
+}
+
+static size_t dircache_key_hash(const void *key)
+{
+	const inet_dircache_key_t *dkey = key;
+	return dircache_addr_hash(dkey->dest, dkey->tos);
+}
+
+static bool dircache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	inet_dircache_entry_t *e1 = hash_table_get_inst(item1,
+	    inet_dircache_entry_t, link);
+	inet_dircache_entry_t *e2 = hash_table_get_inst(item2,
+	    inet_dircache_entry_t, link);
+
+	return e1->tos == e2->tos && inet_addr_compare(&e1->dest, &e2->dest);
+}
+
+static bool dircache_key_equal(const void *key, const ht_link_t *item)
+{
+	const inet_dircache_key_t *dkey = key;
+	inet_dircache_entry_t *entry = hash_table_get_inst(item,
+	    inet_dircache_entry_t, link);
+
+	return dkey->tos == entry->tos &&
+	    inet_addr_compare(dkey->dest, &entry->dest);
+}
+
+static void dircache_remove_cb(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, inet_dircache_entry_t, link));
+}
+
+static hash_table_ops_t dircache_ops = {
+	.hash = dircache_hash,
+	.key_hash = dircache_key_hash,
+	.equal = dircache_equal,
+	.key_equal = dircache_key_equal,
+	.remove_callback = dircache_remove_cb
+};
+
+/** Make sure the cache hash table exists.
+ *
+ * Must be called with @c dircache_lock held.
+ */
+static bool dircache_ensure(void)
+{
+	if (dircache_valid)
+		return true;
+
+	if (!hash_table_create(&dircache, 0, 0, &dircache_ops))
+		return false;
+
+	dircache_valid = true;
+	return true;
+}
+
+/** Look up cached direction for a destination.
+ *
+ * @param dest	Destination address
+ * @param tos	Type of service
+ * @param dir	Place to store direction
+ * @return	EOK on cache hit, ENOENT on cache miss
+ */
+errno_t inet_dircache_find(inet_addr_t *dest, uint8_t tos, inet_dir_t *dir)
+{
+	inet_dircache_key_t key;
+	inet_dircache_entry_t *entry;
+	ht_link_t *link;
+
+	key.dest = dest;
+	key.tos = tos;
+
+	fibril_mutex_lock(&dircache_lock);
+
+	if (!dircache_valid) {
+		fibril_mutex_unlock(&dircache_lock);
+		return ENOENT;
+	}
+
+	link = hash_table_find(&dircache, &key);
+	if (link == NULL) {
+		fibril_mutex_unlock(&dircache_lock);
+		return ENOENT;
+	}
+
+	entry = hash_table_get_inst(link, inet_dircache_entry_t, link);
+	*dir = entry->dir;
+
+	fibril_mutex_unlock(&dircache_lock);
+	return EOK;
+}
+
+/** Insert resolved direction into the cache.
+ *
+ * Failure to insert merely means the next lookup will miss.
+ *
+ * @param dest	Destination address
+ * @param tos	Type of service
+ * @param dir	Resolved direction
+ */
+void inet_dircache_insert(inet_addr_t *dest, uint8_t tos, inet_dir_t *dir)
+{
+	inet_dircache_entry_t *entry;
+
+	entry = calloc(1, sizeof(inet_dircache_entry_t));
+	if (entry == NULL)
+		return;
+
+	entry->dest = *dest;
+	entry->tos = tos;
+	entry->dir = *dir;
+
+	fibril_mutex_lock(&dircache_lock);
+
+	if (!dircache_ensure()) {
+		fibril_mutex_unlock(&dircache_lock);
+		free(entry);
+		return;
+	}
+
+	/* Keep the cache small; flows beyond the limit flush it */
+	if (hash_table_size(&dircache) >= DIRCACHE_MAX_ENTRIES)
+		hash_table_clear(&dircache);
+
+	if (!hash_table_insert_unique(&dircache, &entry->link))
+		free(entry);
+
+	fibril_mutex_unlock(&dircache_lock);
+}
+
+/** Flush the direction cache.
+ *
+ * Needs to be called whenever address objects or static routes change.
+ */
+void inet_dircache_invalidate(void)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_dircache_invalidate()");
+
+	fibril_mutex_lock(&dircache_lock);
+	if (dircache_valid)
+		hash_table_clear(&dircache);
+	fibril_mutex_unlock(&dircache_lock);
+}
+
+/** @}
+ */
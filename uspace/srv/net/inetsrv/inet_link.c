@@ -54,6 +54,13 @@ static bool first_link6 = true;
 static FIBRIL_MUTEX_INITIALIZE(ip_ident_lock);
 static uint16_t ip_ident = 0;
 
+enum {
+	/** Number of times to retry sending when the link pushes back */
+	link_send_retries = 3,
+	/** Delay between send retries in microseconds */
+	link_send_retry_delay = 1000
+};
+
 static errno_t inet_iplink_recv(iplink_t *, iplink_recv_sdu_t *, ip_ver_t);
 static errno_t inet_iplink_change_addr(iplink_t *, addr48_t);
 static inet_link_t *inet_link_get_by_id_locked(sysarg_t);
@@ -363,8 +370,17 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 		if (rc != EOK)
 			return rc;
 
-		/* Send the PDU */
-		rc = iplink_send(ilink->iplink, &sdu);
+		/*
+		 * Send the PDU. EAGAIN means the link's transmit queue is
+		 * full; back off briefly instead of dropping the fragment.
+		 */
+		int retries = link_send_retries;
+		do {
+			rc = iplink_send(ilink->iplink, &sdu);
+			if (rc != EAGAIN)
+				break;
+			fibril_usleep(link_send_retry_delay);
+		} while (retries-- > 0);
 
 		free(sdu.data);
 		offs = roffs;
@@ -436,8 +452,17 @@ errno_t inet_link_send_dgram6(inet_link_t *ilink, addr48_t ldest,
 		if (rc != EOK)
 			return rc;
 
-		/* Send the PDU */
-		rc = iplink_send6(ilink->iplink, &sdu6);
+		/*
+		 * Send the PDU. EAGAIN means the link's transmit queue is
+		 * full; back off briefly instead of dropping the fragment.
+		 */
+		int retries = link_send_retries;
+		do {
+			rc = iplink_send6(ilink->iplink, &sdu6);
+			if (rc != EAGAIN)
+				break;
+			fibril_usleep(link_send_retry_delay);
+		} while (retries-- > 0);
 
 		free(sdu6.data);
 		offs = roffs;
@@ -49,6 +49,7 @@
 #include <stdint.h>
 #include <task.h>
 #include "addrobj.h"
+#include "dircache.h"
 #include "icmp.h"
 #include "icmp_std.h"
 #include "icmpv6.h"
@@ -87,8 +88,12 @@ static errno_t inet_init(void)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_init()");
 
+	errno_t rc = inet_reass_init();
+	if (rc != EOK)
+		return rc;
+
 	port_id_t port;
-	errno_t rc = async_create_port(INTERFACE_INET,
+	rc = async_create_port(INTERFACE_INET,
 	    inet_default_conn, NULL, &port);
 	if (rc != EOK)
 		return rc;
@@ -141,6 +146,10 @@ static errno_t inet_find_dir(inet_addr_t *src, inet_addr_t *dest, uint8_t tos,
 	/* XXX Handle case where source address is specified */
 	(void) src;
 
+	/* Fast path - direction cached from an earlier datagram of the flow */
+	if (inet_dircache_find(dest, tos, dir) == EOK)
+		return EOK;
+
 	dir->aobj = inet_addrobj_find(dest, iaf_net);
 	if (dir->aobj != NULL) {
 		dir->ldest = *dest;
@@ -160,6 +169,7 @@ static errno_t inet_find_dir(inet_addr_t *src, inet_addr_t *dest, uint8_t tos,
 		return ENOENT;
 	}
 
+	inet_dircache_insert(dest, tos, dir);
 	return EOK;
 }
 
@@ -189,6 +199,17 @@ errno_t inet_route_packet(inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "dgram to be routed");
 
+	/*
+	 * Loopback shortcut. A datagram destined for one of our own
+	 * addresses would go out through loopip only to come right back,
+	 * costing two IPC round trips and a pass through loopip's queues.
+	 * Hand it to the inbound processing path directly instead.
+	 */
+	if (inet_addrobj_find(&dgram->dest, iaf_addr) != NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "dgram delivered locally");
+		return inet_recv_dgram_local(dgram, proto);
+	}
+
 	/* Route packet using source/destination addresses */
 
 	rc = inet_find_dir(&dgram->src, &dgram->dest, dgram->tos, &dir);
@@ -47,42 +47,6 @@
 #include "inet_std.h"
 #include "pdu.h"
 
-/** One's complement addition.
- *
- * Result is a + b + carry.
- */
-static uint16_t inet_ocadd16(uint16_t a, uint16_t b)
-{
-	uint32_t s;
-
-	s = (uint32_t)a + (uint32_t)b;
-	return (s & 0xffff) + (s >> 16);
-}
-
-uint16_t inet_checksum_calc(uint16_t ivalue, void *data, size_t size)
-{
-	uint16_t sum;
-	uint16_t w;
-	size_t words, i;
-	uint8_t *bdata;
-
-	sum = ~ivalue;
-	words = size / 2;
-	bdata = (uint8_t *)data;
-
-	for (i = 0; i < words; i++) {
-		w = ((uint16_t)bdata[2 * i] << 8) | bdata[2 * i + 1];
-		sum = inet_ocadd16(sum, w);
-	}
-
-	if (size % 2 != 0) {
-		w = ((uint16_t)bdata[2 * words] << 8);
-		sum = inet_ocadd16(sum, w);
-	}
-
-	return ~sum;
-}
-
 /** Encode IPv4 PDU.
  *
  * Encode internet packet into PDU (serialized form). Will encode a
@@ -141,7 +105,8 @@ errno_t inet_pdu_encode(inet_packet_t *packet, addr32_t src, addr32_t dest,
 	    (rem_offs < packet->size ? BIT_V(uint16_t, FF_FLAG_MF) : 0) +
 	    (foff << FF_FRAGOFF_l);
 
-	void *data = calloc(size, 1);
+	/* All header fields are filled in below, payload is copied over */
+	void *data = malloc(size);
 	if (data == NULL)
 		return ENOMEM;
 
@@ -249,7 +214,8 @@ errno_t inet_pdu_encode6(inet_packet_t *packet, addr128_t src, addr128_t dest,
 	    (rem_offs < packet->size ? BIT_V(uint16_t, OF_FLAG_M) : 0) +
 	    (foff << OF_FRAGOFF_l);
 
-	void *data = calloc(size, 1);
+	/* All header fields are filled in below, payload is copied over */
+	void *data = malloc(size);
 	if (data == NULL)
 		return ENOMEM;
 
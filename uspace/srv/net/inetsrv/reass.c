@@ -32,26 +32,56 @@
 /**
  * @file
  * @brief Datagram reassembly.
+ *
+ * Partial datagrams are kept in a hash table keyed by (source,
+ * destination, protocol, identification), so finding the datagram a
+ * fragment belongs to is a single probe. The amount of fragment data
+ * buffered per source address is bounded, and datagrams that do not
+ * complete in time are expired by a timer following a list ordered by
+ * expiration time, without scanning the table.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
+/** Reassembly timeout in seconds */
+#define REASS_TIMEOUT 30
+/** Maximum bytes of fragment data buffered per source address */
+#define REASS_SRC_MAX_BYTES 131072
+
 /** Datagram being reassembled.
  *
  * Uniquely identified by (source address, destination address, protocol,
  * identification) per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
+	/** Link to reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to reass_dgram_exp (ordered by @c expires ascending) */
+	link_t exp_link;
+	/** Source address */
+	inet_addr_t src;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Protocol */
+	uint8_t proto;
+	/** Identification */
+	uint32_t ident;
+	/** Fragment data buffered for this datagram */
+	size_t bytes;
+	/** Uptime at which reassembly is abandoned */
+	struct timespec expires;
 	/** List of fragments, @c reass_frag_t */
 	list_t frags;
 } reass_dgram_t;
@@ -62,18 +92,282 @@ typedef struct {
 	inet_packet_t packet;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
-/** Protects access to @c reass_dgram_map */
-static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
-
-static reass_dgram_t *reass_dgram_new(void);
+/** Fragment data accounting for one source address */
+typedef struct {
+	/** Link to reass_src_map */
+	ht_link_t map_link;
+	/** Source address */
+	inet_addr_t src;
+	/** Fragment data buffered from this source */
+	size_t bytes;
+} reass_src_t;
+
+/** Datagram map key */
+typedef struct {
+	inet_addr_t *src;
+	inet_addr_t *dest;
+	uint8_t proto;
+	uint32_t ident;
+} reass_dgram_key_t;
+
+/** Datagram map (of reass_dgram_t) */
+static hash_table_t reass_dgram_map;
+/** Per-source accounting (of reass_src_t) */
+static hash_table_t reass_src_map;
+/** Partial datagrams ordered by expiration time */
+static LIST_INITIALIZE(reass_dgram_exp);
+/** Expires partial datagrams */
+static fibril_timer_t *reass_timer;
+/** Protects reassembly state */
+static FIBRIL_MUTEX_INITIALIZE(reass_lock);
+
+static reass_dgram_t *reass_dgram_new(inet_packet_t *);
 static reass_dgram_t *reass_dgram_get(inet_packet_t *);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
 static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
+static void reass_timeout(void *);
+
+static size_t reass_addr_hash(size_t hash, inet_addr_t *addr)
+{
+	size_t i;
+
+	hash = hash_combine(hash, addr->version);
+
+	if (addr->version == ip_v6) {
+		for (i = 0; i < sizeof(addr->addr6); i++)
+			hash = hash_combine(hash, addr->addr6[i]);
+	} else {
+		hash = hash_combine(hash, addr->addr);
+	}
+
+	return hash;
+}
+
+static size_t reass_dgram_ht_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+	size_t hash = 0;
+
+	hash = reass_addr_hash(hash, &rdg->src);
+	hash = reass_addr_hash(hash, &rdg->dest);
+	hash = hash_combine(hash, rdg->proto);
+	hash = hash_combine(hash, rdg->ident);
+	return hash_mix(hash);
+}
+
+static size_t reass_dgram_ht_key_hash(const void *key)
+{
+	const reass_dgram_key_t *dkey = key;
+	size_t hash = 0;
+
+	hash = reass_addr_hash(hash, dkey->src);
+	hash = reass_addr_hash(hash, dkey->dest);
+	hash = hash_combine(hash, dkey->proto);
+	hash = hash_combine(hash, dkey->ident);
+	return hash_mix(hash);
+}
+
+static bool reass_dgram_ht_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	reass_dgram_t *r1 = hash_table_get_inst(item1, reass_dgram_t,
+	    map_link);
+	reass_dgram_t *r2 = hash_table_get_inst(item2, reass_dgram_t,
+	    map_link);
+
+	return r1->proto == r2->proto && r1->ident == r2->ident &&
+	    inet_addr_compare(&r1->src, &r2->src) &&
+	    inet_addr_compare(&r1->dest, &r2->dest);
+}
+
+static bool reass_dgram_ht_key_equal(const void *key, const ht_link_t *item)
+{
+	const reass_dgram_key_t *dkey = key;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return dkey->proto == rdg->proto && dkey->ident == rdg->ident &&
+	    inet_addr_compare(dkey->src, &rdg->src) &&
+	    inet_addr_compare(dkey->dest, &rdg->dest);
+}
+
+static hash_table_ops_t reass_dgram_ht_ops = {
+	.hash = reass_dgram_ht_hash,
+	.key_hash = reass_dgram_ht_key_hash,
+	.equal = reass_dgram_ht_equal,
+	.key_equal = reass_dgram_ht_key_equal,
+	.remove_callback = NULL
+};
+
+static size_t reass_src_ht_hash(const ht_link_t *item)
+{
+	reass_src_t *rsrc = hash_table_get_inst(item, reass_src_t, map_link);
+	return hash_mix(reass_addr_hash(0, &rsrc->src));
+}
+
+static size_t reass_src_ht_key_hash(const void *key)
+{
+	return hash_mix(reass_addr_hash(0, (inet_addr_t *)key));
+}
+
+static bool reass_src_ht_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	reass_src_t *s1 = hash_table_get_inst(item1, reass_src_t, map_link);
+	reass_src_t *s2 = hash_table_get_inst(item2, reass_src_t, map_link);
+
+	return inet_addr_compare(&s1->src, &s2->src);
+}
+
+static bool reass_src_ht_key_equal(const void *key, const ht_link_t *item)
+{
+	reass_src_t *rsrc = hash_table_get_inst(item, reass_src_t, map_link);
+
+	return inet_addr_compare((inet_addr_t *)key, &rsrc->src);
+}
+
+static hash_table_ops_t reass_src_ht_ops = {
+	.hash = reass_src_ht_hash,
+	.key_hash = reass_src_ht_key_hash,
+	.equal = reass_src_ht_equal,
+	.key_equal = reass_src_ht_key_equal,
+	.remove_callback = NULL
+};
+
+/** Initialize datagram reassembly.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_reass_init(void)
+{
+	if (!hash_table_create(&reass_dgram_map, 0, 0, &reass_dgram_ht_ops))
+		return ENOMEM;
+
+	if (!hash_table_create(&reass_src_map, 0, 0, &reass_src_ht_ops)) {
+		hash_table_destroy(&reass_dgram_map);
+		return ENOMEM;
+	}
+
+	reass_timer = fibril_timer_create(NULL);
+	if (reass_timer == NULL) {
+		hash_table_destroy(&reass_src_map);
+		hash_table_destroy(&reass_dgram_map);
+		return ENOMEM;
+	}
+
+	return EOK;
+}
+
+/** Find per-source accounting record.
+ *
+ * Must be called with @c reass_lock held.
+ *
+ * @param src    Source address
+ * @param create @c true to create the record if it does not exist
+ * @return Accounting record or @c NULL
+ */
+static reass_src_t *reass_src_get(inet_addr_t *src, bool create)
+{
+	reass_src_t *rsrc;
+	ht_link_t *link;
+
+	link = hash_table_find(&reass_src_map, src);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_src_t, map_link);
+
+	if (!create)
+		return NULL;
+
+	rsrc = calloc(1, sizeof(reass_src_t));
+	if (rsrc == NULL)
+		return NULL;
+
+	rsrc->src = *src;
+	hash_table_insert(&reass_src_map, &rsrc->map_link);
+	return rsrc;
+}
+
+/** Return buffered fragment data to the per-source budget.
+ *
+ * Must be called with @c reass_lock held.
+ *
+ * @param src   Source address
+ * @param bytes Number of bytes to return
+ */
+static void reass_src_debit(inet_addr_t *src, size_t bytes)
+{
+	reass_src_t *rsrc;
+
+	rsrc = reass_src_get(src, false);
+	assert(rsrc != NULL);
+	assert(rsrc->bytes >= bytes);
+
+	rsrc->bytes -= bytes;
+	if (rsrc->bytes == 0) {
+		hash_table_remove_item(&reass_src_map, &rsrc->map_link);
+		free(rsrc);
+	}
+}
+
+/** Plan the next expiration pass.
+ *
+ * Arms the timer for the expiration of the first datagram in the
+ * expiration list (if any). Must be called with @c reass_lock held.
+ */
+static void reass_timer_arm(void)
+{
+	reass_dgram_t *rdg;
+	struct timespec now;
+	link_t *link;
+	nsec_t delay;
+
+	link = list_first(&reass_dgram_exp);
+	if (link == NULL)
+		return;
+
+	rdg = list_get_instance(link, reass_dgram_t, exp_link);
+
+	getuptime(&now);
+	delay = ts_sub_diff(&rdg->expires, &now);
+	if (delay < 0)
+		delay = 0;
+
+	fibril_timer_set(reass_timer, NSEC2USEC(delay), reass_timeout, NULL);
+}
+
+/** Expire partial datagrams whose reassembly timed out.
+ *
+ * @param arg Not used
+ */
+static void reass_timeout(void *arg)
+{
+	reass_dgram_t *rdg;
+	struct timespec now;
+	link_t *link;
+
+	(void)arg;
+
+	fibril_mutex_lock(&reass_lock);
+
+	getuptime(&now);
+
+	while ((link = list_first(&reass_dgram_exp)) != NULL) {
+		rdg = list_get_instance(link, reass_dgram_t, exp_link);
+		if (!ts_gteq(&now, &rdg->expires))
+			break;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out "
+		    "(proto=%u, ident=%u).", rdg->proto, rdg->ident);
+
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+	}
+
+	reass_timer_arm();
+	fibril_mutex_unlock(&reass_lock);
+}
 
 /** Queue packet for datagram reassembly.
  *
@@ -87,27 +381,29 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_reass_queue_packet()");
 
-	fibril_mutex_lock(&reass_dgram_map_lock);
+	fibril_mutex_lock(&reass_lock);
 
 	/* Get existing or new datagram */
 	rdg = reass_dgram_get(packet);
 	if (rdg == NULL) {
 		/* Only happens when we are out of memory */
-		fibril_mutex_unlock(&reass_dgram_map_lock);
+		fibril_mutex_unlock(&reass_lock);
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Allocation failed, packet dropped.");
 		return ENOMEM;
 	}
 
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
-		return ENOMEM;
+	if (rc != EOK) {
+		fibril_mutex_unlock(&reass_lock);
+		return rc;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
 		/* Remove it from the map */
 		reass_dgram_remove(rdg);
-		fibril_mutex_unlock(&reass_dgram_map_lock);
+		fibril_mutex_unlock(&reass_lock);
 
 		/* Deliver complete datagram */
 		rc = reass_dgram_deliver(rdg);
@@ -115,7 +411,7 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 		return rc;
 	}
 
-	fibril_mutex_unlock(&reass_dgram_map_lock);
+	fibril_mutex_unlock(&reass_lock);
 	return EOK;
 }
 
@@ -126,43 +422,55 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
  */
 static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	reass_dgram_key_t key;
+	ht_link_t *link;
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	assert(fibril_mutex_is_locked(&reass_lock));
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
+	key.src = &packet->src;
+	key.dest = &packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
-	}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(packet);
 }
 
 /** Create new datagram reassembly structure.
  *
+ * @param packet	Packet the datagram is keyed after
  * @return New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(inet_packet_t *packet)
 {
 	reass_dgram_t *rdg;
+	bool was_empty;
 
 	rdg = calloc(1, sizeof(reass_dgram_t));
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
+	rdg->src = packet->src;
+	rdg->dest = packet->dest;
+	rdg->proto = packet->proto;
+	rdg->ident = packet->ident;
 	list_initialize(&rdg->frags);
 
+	getuptime(&rdg->expires);
+	ts_add_diff(&rdg->expires, SEC2NSEC(REASS_TIMEOUT));
+
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+
+	/* All datagrams have the same lifetime, so the list stays sorted */
+	was_empty = list_empty(&reass_dgram_exp);
+	list_append(&rdg->exp_link, &reass_dgram_exp);
+	if (was_empty)
+		reass_timer_arm();
+
 	return rdg;
 }
 
@@ -182,12 +490,30 @@ static reass_frag_t *reass_frag_new(void)
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
 	reass_frag_t *frag;
+	reass_src_t *rsrc;
 	void *data_copy;
 	link_t *link;
 
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	assert(fibril_mutex_is_locked(&reass_lock));
+
+	/*
+	 * Bound the amount of fragment data buffered for each source
+	 * address so a fragment flood from one peer cannot exhaust our
+	 * memory.
+	 */
+	rsrc = reass_src_get(&packet->src, true);
+	if (rsrc == NULL)
+		return ENOMEM;
+
+	if (rsrc->bytes + packet->size > REASS_SRC_MAX_BYTES) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Per-source reassembly "
+		    "limit exceeded, fragment dropped.");
+		return ELIMIT;
+	}
 
 	frag = reass_frag_new();
+	if (frag == NULL)
+		return ENOMEM;
 
 	/* Clone the packet */
 
@@ -202,6 +528,9 @@ static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet
 	frag->packet = *packet;
 	frag->packet.data = data_copy;
 
+	rsrc->bytes += packet->size;
+	rdg->bytes += packet->size;
+
 	/*
 	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
 	 * data immediately. Possibly eliminate redundant packet headers.
@@ -240,7 +569,7 @@ static bool reass_dgram_complete(reass_dgram_t *rdg)
 	reass_frag_t *frag, *prev;
 	link_t *link;
 
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	assert(fibril_mutex_is_locked(&reass_lock));
 	assert(!list_empty(&rdg->frags));
 
 	link = list_first(&rdg->frags);
@@ -281,8 +610,11 @@ static bool reass_dgram_complete(reass_dgram_t *rdg)
  */
 static void reass_dgram_remove(reass_dgram_t *rdg)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+	assert(fibril_mutex_is_locked(&reass_lock));
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->exp_link);
+	if (rdg->bytes > 0)
+		reass_src_debit(&rdg->src, rdg->bytes);
 }
 
 /** Deliver complete datagram.
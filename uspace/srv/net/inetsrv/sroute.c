@@ -39,16 +39,178 @@
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <ipc/loc.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "dircache.h"
 #include "sroute.h"
 #include "inetsrv.h"
 #include "inet_link.h"
 
-static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
+/** Multibit trie node with 8-bit stride.
+ *
+ * Prefixes whose length is not a multiple of eight are expanded into
+ * the slots of the node where they terminate, so a lookup is a plain
+ * walk remembering the most specific route seen so far.
+ */
+typedef struct inet_sroute_node {
+	/** Most specific route terminating in this stride, per slot */
+	inet_sroute_t *route[256];
+	/** Prefix length of route[i], valid if route[i] is not NULL */
+	uint8_t rbits[256];
+	/** Child nodes */
+	struct inet_sroute_node *child[256];
+} inet_sroute_node_t;
+
+/**
+ * Protects the route list and lookup tries. The per-datagram lookup
+ * only takes the read lock, route configuration changes take the
+ * write lock.
+ */
+static FIBRIL_RWLOCK_INITIALIZE(sroute_list_lock);
 static LIST_INITIALIZE(sroute_list);
 static sysarg_t sroute_id = 0;
 
+/** Route lookup tries, one per address family */
+static inet_sroute_node_t *sroute_trie_v4;
+static inet_sroute_node_t *sroute_trie_v6;
+
+/** Extract address bytes in lookup order.
+ *
+ * @param addr	Address
+ * @param b	Buffer for up to 16 address bytes
+ * @return	Number of address bytes
+ */
+static size_t inet_sroute_addr_bytes(inet_addr_t *addr, uint8_t *b)
+{
+	addr32_t v4;
+	addr128_t v6;
+	size_t i;
+
+	switch (inet_addr_get(addr, &v4, &v6)) {
+	case ip_v4:
+		for (i = 0; i < 4; i++)
+			b[i] = (v4 >> (24 - 8 * i)) & 0xff;
+		return 4;
+	case ip_v6:
+		memcpy(b, v6, 16);
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/** Destroy trie node and all its descendants.
+ *
+ * @param node	Trie node or NULL
+ */
+static void inet_sroute_node_destroy(inet_sroute_node_t *node)
+{
+	unsigned i;
+
+	if (node == NULL)
+		return;
+
+	for (i = 0; i < 256; i++)
+		inet_sroute_node_destroy(node->child[i]);
+
+	free(node);
+}
+
+/** Insert route into lookup trie.
+ *
+ * @param rroot	Pointer to trie root pointer (created on demand)
+ * @param sroute Route to insert
+ * @return	EOK on success, ENOMEM if out of memory
+ */
+static errno_t inet_sroute_trie_insert(inet_sroute_node_t **rroot,
+    inet_sroute_t *sroute)
+{
+	inet_sroute_node_t *node;
+	uint8_t b[16];
+	uint8_t bits;
+	unsigned nslots;
+	unsigned base;
+	unsigned i;
+	size_t nbytes;
+	size_t level;
+
+	nbytes = inet_sroute_addr_bytes((inet_addr_t *)&sroute->dest, b);
+	(void) inet_naddr_get(&sroute->dest, NULL, NULL, &bits);
+
+	if (nbytes == 0 || bits > 8 * nbytes)
+		return EINVAL;
+
+	if (*rroot == NULL) {
+		*rroot = calloc(1, sizeof(inet_sroute_node_t));
+		if (*rroot == NULL)
+			return ENOMEM;
+	}
+
+	/* Descend through whole-byte prefix levels */
+	node = *rroot;
+	for (level = 0; level + 1 < (bits + 7) / 8; level++) {
+		if (node->child[b[level]] == NULL) {
+			node->child[b[level]] = calloc(1,
+			    sizeof(inet_sroute_node_t));
+			if (node->child[b[level]] == NULL)
+				return ENOMEM;
+		}
+
+		node = node->child[b[level]];
+	}
+
+	/*
+	 * Expand the remaining partial byte (or the whole node for a
+	 * prefix length of zero) into slots, keeping the most specific
+	 * route in each slot.
+	 */
+	if (bits == 0) {
+		base = 0;
+		nslots = 256;
+	} else {
+		nslots = 1 << (8 - (bits - 8 * level));
+		base = b[level] & ~(nslots - 1);
+	}
+
+	for (i = base; i < base + nslots; i++) {
+		if (node->route[i] == NULL || node->rbits[i] < bits) {
+			node->route[i] = sroute;
+			node->rbits[i] = bits;
+		}
+	}
+
+	return EOK;
+}
+
+/** Rebuild lookup tries from the route list.
+ *
+ * Needs to be called with the write lock held whenever a route is
+ * removed (insertion updates the tries in place).
+ */
+static void inet_sroute_trie_rebuild(void)
+{
+	inet_sroute_node_t *ov4 = sroute_trie_v4;
+	inet_sroute_node_t *ov6 = sroute_trie_v6;
+	errno_t rc;
+
+	sroute_trie_v4 = NULL;
+	sroute_trie_v6 = NULL;
+
+	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
+		rc = inet_sroute_trie_insert(
+		    sroute->dest.version == ip_v6 ? &sroute_trie_v6 :
+		    &sroute_trie_v4, sroute);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed inserting "
+			    "route into lookup trie.");
+		}
+	}
+
+	inet_sroute_node_destroy(ov4);
+	inet_sroute_node_destroy(ov6);
+}
+
 inet_sroute_t *inet_sroute_new(void)
 {
 	inet_sroute_t *sroute = calloc(1, sizeof(inet_sroute_t));
@@ -60,9 +222,9 @@ inet_sroute_t *inet_sroute_new(void)
 	}
 
 	link_initialize(&sroute->sroute_list);
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_write_lock(&sroute_list_lock);
 	sroute->id = ++sroute_id;
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_write_unlock(&sroute_list_lock);
 
 	return sroute;
 }
@@ -76,16 +238,34 @@ void inet_sroute_delete(inet_sroute_t *sroute)
 
 void inet_sroute_add(inet_sroute_t *sroute)
 {
-	fibril_mutex_lock(&sroute_list_lock);
+	errno_t rc;
+
+	fibril_rwlock_write_lock(&sroute_list_lock);
 	list_append(&sroute->sroute_list, &sroute_list);
-	fibril_mutex_unlock(&sroute_list_lock);
+
+	rc = inet_sroute_trie_insert(sroute->dest.version == ip_v6 ?
+	    &sroute_trie_v6 : &sroute_trie_v4, sroute);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed inserting route "
+		    "into lookup trie.");
+	}
+
+	fibril_rwlock_write_unlock(&sroute_list_lock);
+
+	inet_dircache_invalidate();
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_write_lock(&sroute_list_lock);
 	list_remove(&sroute->sroute_list);
-	fibril_mutex_unlock(&sroute_list_lock);
+
+	/* The trie may reference @a sroute in many slots. Rebuild it. */
+	inet_sroute_trie_rebuild();
+
+	fibril_rwlock_write_unlock(&sroute_list_lock);
+
+	inet_dircache_invalidate();
 }
 
 /** Find static route object matching address @a addr.
@@ -94,39 +274,30 @@ void inet_sroute_remove(inet_sroute_t *sroute)
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
+	inet_sroute_node_t *node;
 	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
+	uint8_t b[16];
+	size_t nbytes;
+	size_t i;
 
-	fibril_mutex_lock(&sroute_list_lock);
+	nbytes = inet_sroute_addr_bytes(addr, b);
 
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
+	fibril_rwlock_read_lock(&sroute_list_lock);
 
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
+	node = (addr->version == ip_v6) ? sroute_trie_v6 : sroute_trie_v4;
 
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
+	/* Walk the trie, remembering the most specific route seen */
+	for (i = 0; i < nbytes && node != NULL; i++) {
+		if (node->route[b[i]] != NULL)
+			best = node->route[b[i]];
 
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
-
-			best = sroute;
-			best_bits = dest_bits;
-		}
+		node = node->child[b[i]];
 	}
 
 	if (best == NULL)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_list_lock);
 
 	return best;
 }
@@ -141,11 +312,11 @@ inet_sroute_t *inet_sroute_find_by_name(const char *name)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name('%s')",
 	    name);
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_list_lock);
 
 	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
 		if (str_cmp(sroute->name, name) == 0) {
-			fibril_mutex_unlock(&sroute_list_lock);
+			fibril_rwlock_read_unlock(&sroute_list_lock);
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name: found %p",
 			    sroute);
 			return sroute;
@@ -153,7 +324,7 @@ inet_sroute_t *inet_sroute_find_by_name(const char *name)
 	}
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name: Not found");
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_list_lock);
 
 	return NULL;
 }
@@ -167,16 +338,16 @@ inet_sroute_t *inet_sroute_get_by_id(sysarg_t id)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_get_by_id(%zu)", (size_t)id);
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_list_lock);
 
 	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
 		if (sroute->id == id) {
-			fibril_mutex_unlock(&sroute_list_lock);
+			fibril_rwlock_read_unlock(&sroute_list_lock);
 			return sroute;
 		}
 	}
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_list_lock);
 
 	return NULL;
 }
@@ -187,12 +358,12 @@ errno_t inet_sroute_get_id_list(sysarg_t **rid_list, size_t *rcount)
 	sysarg_t *id_list;
 	size_t count, i;
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_list_lock);
 	count = list_count(&sroute_list);
 
 	id_list = calloc(count, sizeof(sysarg_t));
 	if (id_list == NULL) {
-		fibril_mutex_unlock(&sroute_list_lock);
+		fibril_rwlock_read_unlock(&sroute_list_lock);
 		return ENOMEM;
 	}
 
@@ -201,7 +372,7 @@ errno_t inet_sroute_get_id_list(sysarg_t **rid_list, size_t *rcount)
 		id_list[i++] = sroute->id;
 	}
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_list_lock);
 
 	*rid_list = id_list;
 	*rcount = count;
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file TCP congestion control (RFC 5681, RFC 6582)
+ *
+ * The congestion control algorithm is pluggable via tcp_cc_ops_t so
+ * that other algorithms (e.g. CUBIC) can be added alongside NewReno.
+ * The congestion state (cwnd, ssthresh, dupacks) lives in the
+ * connection structure and all operations are called with the
+ * connection locked.
+ */
+
+#include <io/log.h>
+#include <macros.h>
+#include "cc.h"
+#include "tcp_type.h"
+#include "tqueue.h"
+
+/** Initialize congestion state of a new connection.
+ *
+ * The initial window is set per RFC 3390.
+ */
+static void newreno_open(tcp_conn_t *conn)
+{
+	conn->cwnd = 4 * TCP_CC_MSS;
+	conn->ssthresh = UINT32_MAX;
+	conn->dupacks = 0;
+}
+
+/** New data was acknowledged.
+ *
+ * Grow the congestion window: exponentially in slow start, by roughly
+ * one segment per round-trip in congestion avoidance. If the ACK ends
+ * fast recovery, deflate the window back to the slow start threshold.
+ *
+ * @param conn  Connection
+ * @param acked Number of newly acknowledged bytes
+ */
+static void newreno_ack_recv(tcp_conn_t *conn, uint32_t acked)
+{
+	if (conn->dupacks >= TCP_CC_DUPACK_THRESHOLD) {
+		/* Leaving fast recovery */
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: leaving fast recovery, "
+		    "cwnd=%" PRIu32, conn->name, conn->ssthresh);
+		conn->cwnd = conn->ssthresh;
+	}
+
+	conn->dupacks = 0;
+
+	if (conn->cwnd < conn->ssthresh) {
+		/* Slow start */
+		conn->cwnd += min(acked, TCP_CC_MSS);
+	} else {
+		/* Congestion avoidance */
+		conn->cwnd += max(1, TCP_CC_MSS * TCP_CC_MSS / conn->cwnd);
+	}
+}
+
+/** Duplicate acknowledgement received.
+ *
+ * On the third duplicate ACK enter fast recovery: halve the window
+ * and retransmit the first unacknowledged segment without waiting
+ * for the retransmission timer. Further duplicate ACKs inflate the
+ * window by one segment each, as each signals that a segment has
+ * left the network.
+ */
+static void newreno_dup_ack(tcp_conn_t *conn)
+{
+	uint32_t flight;
+
+	++conn->dupacks;
+
+	if (conn->dupacks == TCP_CC_DUPACK_THRESHOLD) {
+		flight = conn->snd_nxt - conn->snd_una;
+		conn->ssthresh = max(flight / 2, 2 * TCP_CC_MSS);
+		conn->cwnd = conn->ssthresh +
+		    TCP_CC_DUPACK_THRESHOLD * TCP_CC_MSS;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: fast retransmit, "
+		    "ssthresh=%" PRIu32, conn->name, conn->ssthresh);
+
+		tcp_tqueue_retransmit(conn);
+	} else if (conn->dupacks > TCP_CC_DUPACK_THRESHOLD) {
+		conn->cwnd += TCP_CC_MSS;
+	}
+}
+
+/** Retransmission timeout fired.
+ *
+ * Collapse the congestion window and restart in slow start.
+ */
+static void newreno_rtx_timeout(tcp_conn_t *conn)
+{
+	uint32_t flight;
+
+	flight = conn->snd_nxt - conn->snd_una;
+	conn->ssthresh = max(flight / 2, 2 * TCP_CC_MSS);
+	conn->cwnd = TCP_CC_MSS;
+	conn->dupacks = 0;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: retransmission timeout, "
+	    "ssthresh=%" PRIu32, conn->name, conn->ssthresh);
+}
+
+const tcp_cc_ops_t tcp_cc_newreno = {
+	.name = "newreno",
+	.open = newreno_open,
+	.ack_recv = newreno_ack_recv,
+	.dup_ack = newreno_dup_ack,
+	.rtx_timeout = newreno_rtx_timeout
+};
+
+/**
+ * @}
+ */
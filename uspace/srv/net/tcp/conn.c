@@ -42,6 +42,7 @@
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
@@ -53,8 +54,8 @@
 #include "tqueue.h"
 #include "ucall.h"
 
-#define RCV_BUF_SIZE 4096/*2*/
-#define SND_BUF_SIZE 4096
+#define RCV_BUF_SIZE 65536
+#define SND_BUF_SIZE 65536
 
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
@@ -65,8 +66,12 @@ static LIST_INITIALIZE(conn_list);
 static FIBRIL_MUTEX_INITIALIZE(conn_list_lock);
 /** Connection association map */
 static amap_t *amap;
-/** Taken after tcp_conn_t lock */
-static FIBRIL_MUTEX_INITIALIZE(amap_lock);
+/**
+ * Protects @c amap. Lookup is read-mostly, updates only happen when
+ * connections are created, destroyed or change identity. Taken after
+ * tcp_conn_t lock.
+ */
+static FIBRIL_RWLOCK_INITIALIZE(amap_lock);
 
 /** Internal loopback configuration */
 tcp_lb_t tcp_conn_lb = tcp_lb_none;
@@ -152,6 +157,18 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
 
+	/*
+	 * Choose the receive window scale factor we will propose so that
+	 * the entire receive buffer can be advertised (RFC 7323).
+	 */
+	while ((conn->rcv_buf_size >> conn->rcv_wscale) > UINT16_MAX &&
+	    conn->rcv_wscale < TCP_MAX_WSCALE)
+		++conn->rcv_wscale;
+
+	/* Initialize congestion control */
+	conn->cc = &tcp_cc_newreno;
+	conn->cc->open(conn);
+
 	/* Initialize incoming segment queue */
 	tcp_iqueue_init(&conn->incoming, conn);
 
@@ -310,20 +327,20 @@ errno_t tcp_conn_add(tcp_conn_t *conn)
 	errno_t rc;
 
 	tcp_conn_addref(conn);
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_add: conn=%p", conn);
 
 	rc = amap_insert(amap, &conn->ident, conn, af_allow_system, &aepp);
 	if (rc != EOK) {
 		tcp_conn_delref(conn);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 		return rc;
 	}
 
 	conn->ident = aepp;
 	conn->mapped = true;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 
 	return EOK;
 }
@@ -337,10 +354,10 @@ static void tcp_conn_remove(tcp_conn_t *conn)
 	if (!conn->mapped)
 		return;
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 	amap_remove(amap, &conn->ident);
 	conn->mapped = false;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 	tcp_conn_delref(conn);
 }
 
@@ -432,19 +449,19 @@ tcp_conn_t *tcp_conn_find_ref(inet_ep2_t *epp)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref(%p)", epp);
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_read_lock(&amap_lock);
 
 	rc = amap_find_match(amap, epp, &arg);
 	if (rc != EOK) {
 		assert(rc == ENOENT);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_read_unlock(&amap_lock);
 		return NULL;
 	}
 
 	conn = (tcp_conn_t *)arg;
 	tcp_conn_addref(conn);
 
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_read_unlock(&amap_lock);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref: got conn=%p",
 	    conn);
 	return conn;
@@ -511,6 +528,33 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Process options received on a SYN segment.
+ *
+ * Window scaling is only in effect if both sides sent the Window Scale
+ * option in their SYN (RFC 7323). If the peer did not send it, revert
+ * our receive scale factor to zero as well.
+ *
+ * @param conn		Connection
+ * @param seg		SYN segment
+ */
+static void tcp_conn_syn_options(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (seg->has_wscale) {
+		conn->wscale_rcvd = true;
+		conn->snd_wscale = seg->wscale;
+	} else {
+		conn->wscale_rcvd = false;
+		conn->snd_wscale = 0;
+		conn->rcv_wscale = 0;
+	}
+
+	conn->sack_perm = seg->sack_perm;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_wscale=%u, rcv_wscale=%u, "
+	    "sack_perm=%d", conn->name, conn->snd_wscale, conn->rcv_wscale,
+	    (int) conn->sack_perm);
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -540,6 +584,7 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
+	tcp_conn_syn_options(conn, seg);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "rcv_nxt=%u", conn->rcv_nxt);
 
@@ -614,6 +659,7 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
+	tcp_conn_syn_options(conn, seg);
 
 	if ((seg->ctrl & CTL_ACK) != 0) {
 		conn->snd_una = seg->ack;
@@ -665,6 +711,10 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
+	/* The window field of a SYN segment is never scaled (RFC 7323) */
+	if ((seg->ctrl & CTL_SYN) == 0)
+		seg->wnd <<= conn->snd_wscale;
+
 	/* Discard unacceptable segments ("old duplicates") */
 	if (!seq_no_segment_acceptable(conn, seg)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Replying ACK to unacceptable segment.");
@@ -811,6 +861,8 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
  */
 static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	uint32_t acked;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_seg_proc_ack_est(%p, %p)", conn, seg);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "SEG.ACK=%u, SND.UNA=%u, SND.NXT=%u",
@@ -828,10 +880,18 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			return cp_done;
 		} else {
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
+
+			/* Duplicate ACKs signal possible segment loss */
+			if (seg->len == 0 && conn->snd_nxt != conn->snd_una)
+				conn->cc->dup_ack(conn);
 		}
 	} else {
 		/* Update SND.UNA */
+		acked = seg->ack - conn->snd_una;
 		conn->snd_una = seg->ack;
+
+		if (acked > 0)
+			conn->cc->ack_recv(conn, acked);
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
@@ -1254,7 +1314,7 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		oldepp = conn->ident;
 
 		/* Need to remove and re-insert connection with new identity */
-		fibril_mutex_lock(&amap_lock);
+		fibril_rwlock_write_lock(&amap_lock);
 
 		if (inet_addr_is_any(&conn->ident.remote.addr))
 			conn->ident.remote.addr = epp->remote.addr;
@@ -1270,13 +1330,13 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 			assert(rc != EEXIST);
 			assert(rc == ENOMEM);
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory.");
-			fibril_mutex_unlock(&amap_lock);
+			fibril_rwlock_write_unlock(&amap_lock);
 			tcp_conn_unlock(conn);
 			return;
 		}
 
 		amap_remove(amap, &oldepp);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 
 		conn->name = (char *) "a";
 	}
@@ -37,6 +37,7 @@
 #include <bitops.h>
 #include <byteorder.h>
 #include <errno.h>
+#include <inet/checksum.h>
 #include <inet/endpoint.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -46,44 +47,6 @@
 #include "std.h"
 #include "tcp_type.h"
 
-#define TCP_CHECKSUM_INIT 0xffff
-
-/** One's complement addition.
- *
- * Result is a + b + carry.
- */
-static uint16_t tcp_ocadd16(uint16_t a, uint16_t b)
-{
-	uint32_t s;
-
-	s = (uint32_t)a + (uint32_t)b;
-	return (s & 0xffff) + (s >> 16);
-}
-
-static uint16_t tcp_checksum_calc(uint16_t ivalue, void *data, size_t size)
-{
-	uint16_t sum;
-	uint16_t w;
-	size_t words, i;
-	uint8_t *bdata;
-
-	sum = ~ivalue;
-	words = size / 2;
-	bdata = (uint8_t *)data;
-
-	for (i = 0; i < words; i++) {
-		w = ((uint16_t)bdata[2 * i] << 8) | bdata[2 * i + 1];
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	if (size % 2 != 0) {
-		w = ((uint16_t)bdata[2 * words] << 8);
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	return ~sum;
-}
-
 static void tcp_header_decode_flags(uint16_t doff_flags, tcp_control_t *rctl)
 {
 	tcp_control_t ctl;
@@ -125,7 +88,8 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t opts_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +99,8 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = ((sizeof(tcp_header_t) + opts_size) / sizeof(uint32_t)) <<
+	    DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -144,6 +109,91 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->urg_ptr = host2uint16_t_be(seg->up);
 }
 
+/** Encode TCP options following the fixed header.
+ *
+ * The option area must have been sized by tcp_options_size() and is
+ * padded to a multiple of four bytes with no-operation options.
+ */
+static void tcp_options_encode(tcp_segment_t *seg, uint8_t *opts)
+{
+	if (seg->has_wscale) {
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_WINDOW_SCALE;
+		*opts++ = 3;
+		*opts++ = seg->wscale;
+	}
+
+	if (seg->sack_perm) {
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_SACK_PERMITTED;
+		*opts++ = 2;
+	}
+}
+
+/** Compute size of the encoded option area of a segment. */
+static size_t tcp_options_size(tcp_segment_t *seg)
+{
+	size_t size = 0;
+
+	if (seg->has_wscale)
+		size += 4;
+	if (seg->sack_perm)
+		size += 4;
+
+	return size;
+}
+
+/** Decode TCP options from the variable part of the header.
+ *
+ * Unknown options are skipped. Malformed options terminate the
+ * decoding, ignoring the rest of the option area.
+ */
+static void tcp_options_decode(tcp_pdu_t *pdu, tcp_segment_t *seg)
+{
+	uint8_t *opts = (uint8_t *) pdu->header + sizeof(tcp_header_t);
+	size_t rem = pdu->header_size - sizeof(tcp_header_t);
+	uint8_t olen;
+
+	while (rem > 0) {
+		if (opts[0] == OPT_END_LIST)
+			break;
+
+		if (opts[0] == OPT_NOP) {
+			++opts;
+			--rem;
+			continue;
+		}
+
+		if (rem < 2)
+			break;
+
+		olen = opts[1];
+		if (olen < 2 || olen > rem)
+			break;
+
+		switch (opts[0]) {
+		case OPT_WINDOW_SCALE:
+			if (olen == 3) {
+				seg->has_wscale = true;
+				seg->wscale = opts[2];
+				if (seg->wscale > TCP_MAX_WSCALE)
+					seg->wscale = TCP_MAX_WSCALE;
+			}
+			break;
+		case OPT_SACK_PERMITTED:
+			if (olen == 2)
+				seg->sack_perm = true;
+			break;
+		default:
+			break;
+		}
+
+		opts += olen;
+		rem -= olen;
+	}
+}
+
 static ip_ver_t tcp_phdr_setup(tcp_pdu_t *pdu, tcp_phdr_t *phdr,
     tcp_phdr6_t *phdr6)
 {
@@ -194,14 +244,18 @@ static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	size_t opts_size;
+
+	opts_size = tcp_options_size(seg);
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	hdr = calloc(1, sizeof(tcp_header_t) + opts_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, opts_size);
+	tcp_options_encode(seg, (uint8_t *) hdr + sizeof(tcp_header_t));
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = sizeof(tcp_header_t) + opts_size;
 
 	return EOK;
 }
@@ -270,19 +324,19 @@ static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
 	ip_ver_t ver = tcp_phdr_setup(pdu, &phdr, &phdr6);
 	switch (ver) {
 	case ip_v4:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, (void *) &phdr,
 		    sizeof(tcp_phdr_t));
 		break;
 	case ip_v6:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr6,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, (void *) &phdr6,
 		    sizeof(tcp_phdr6_t));
 		break;
 	default:
 		assert(false);
 	}
 
-	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
-	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
+	cs_headers = inet_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
+	return inet_checksum_calc(cs_headers, pdu->text, pdu->text_size);
 }
 
 static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
@@ -305,6 +359,7 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 
 	tcp_header_decode(pdu->header, nseg);
 	nseg->len += seq_no_control_len(nseg->ctrl);
+	tcp_options_decode(pdu, nseg);
 
 	hdr = (tcp_header_t *)pdu->header;
 
@@ -32,8 +32,15 @@
 
 /**
  * @file Global segment receive queue
+ *
+ * Inbound segments are sharded across several worker fibrils by a hash
+ * of the endpoint pair. All segments of one connection carry the same
+ * endpoint pair and thus always map to the same worker, so processing
+ * order within a connection is preserved while different connections
+ * can be processed concurrently.
  */
 
+#include <adt/hash.h>
 #include <adt/prodcons.h>
 #include <errno.h>
 #include <io/log.h>
@@ -47,8 +54,11 @@
 #include "tcp_type.h"
 #include "ucall.h"
 
-static prodcons_t rqueue;
-static bool fibril_active;
+/** Number of receive queue worker fibrils */
+#define RQUEUE_NWORKERS 4
+
+static prodcons_t rqueue[RQUEUE_NWORKERS];
+static unsigned fibrils_active;
 static fibril_mutex_t lock;
 static fibril_condvar_t cv;
 static tcp_rqueue_cb_t *rqueue_cb;
@@ -56,27 +66,64 @@ static tcp_rqueue_cb_t *rqueue_cb;
 /** Initialize segment receive queue. */
 void tcp_rqueue_init(tcp_rqueue_cb_t *rcb)
 {
-	prodcons_initialize(&rqueue);
+	unsigned i;
+
+	for (i = 0; i < RQUEUE_NWORKERS; i++)
+		prodcons_initialize(&rqueue[i]);
 	fibril_mutex_initialize(&lock);
 	fibril_condvar_initialize(&cv);
-	fibril_active = false;
+	fibrils_active = 0;
 	rqueue_cb = rcb;
 }
 
 /** Finalize segment receive queue. */
 void tcp_rqueue_fini(void)
 {
-	inet_ep2_t epp;
+	tcp_rqueue_entry_t *rqe;
+	unsigned i;
+
+	/* Send each worker a termination sentinel */
+	for (i = 0; i < RQUEUE_NWORKERS; i++) {
+		rqe = calloc(1, sizeof(tcp_rqueue_entry_t));
+		if (rqe == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating RQE.");
+			return;
+		}
 
-	inet_ep2_init(&epp);
-	tcp_rqueue_insert_seg(&epp, NULL);
+		inet_ep2_init(&rqe->epp);
+		rqe->seg = NULL;
+		prodcons_produce(&rqueue[i], &rqe->link);
+	}
 
 	fibril_mutex_lock(&lock);
-	while (fibril_active)
+	while (fibrils_active > 0)
 		fibril_condvar_wait(&cv, &lock);
 	fibril_mutex_unlock(&lock);
 }
 
+/** Select receive queue shard for an endpoint pair.
+ *
+ * @param epp	Endpoint pair, oriented for reception
+ * @return	Shard index
+ */
+static size_t tcp_rqueue_shard(inet_ep2_t *epp)
+{
+	size_t hash = 0;
+	unsigned i;
+
+	hash = hash_combine(hash, epp->remote.port);
+	hash = hash_combine(hash, epp->local.port);
+
+	if (epp->remote.addr.version == ip_v6) {
+		for (i = 0; i < sizeof(epp->remote.addr.addr6); i++)
+			hash = hash_combine(hash, epp->remote.addr.addr6[i]);
+	} else {
+		hash = hash_combine(hash, epp->remote.addr.addr);
+	}
+
+	return hash_mix(hash) % RQUEUE_NWORKERS;
+}
+
 /** Insert segment into receive queue.
  *
  * @param epp	Endpoint pair, oriented for reception
@@ -100,19 +147,20 @@ void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	rqe->epp = *epp;
 	rqe->seg = seg;
 
-	prodcons_produce(&rqueue, &rqe->link);
+	prodcons_produce(&rqueue[tcp_rqueue_shard(epp)], &rqe->link);
 }
 
 /** Receive queue handler fibril. */
 static errno_t tcp_rqueue_fibril(void *arg)
 {
+	prodcons_t *queue = (prodcons_t *) arg;
 	link_t *link;
 	tcp_rqueue_entry_t *rqe;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril()");
 
 	while (true) {
-		link = prodcons_consume(&rqueue);
+		link = prodcons_consume(queue);
 		rqe = list_get_instance(link, tcp_rqueue_entry_t, link);
 
 		if (rqe->seg == NULL) {
@@ -128,28 +176,32 @@ static errno_t tcp_rqueue_fibril(void *arg)
 
 	/* Finished */
 	fibril_mutex_lock(&lock);
-	fibril_active = false;
+	--fibrils_active;
 	fibril_mutex_unlock(&lock);
 	fibril_condvar_broadcast(&cv);
 
 	return 0;
 }
 
-/** Start receive queue handler fibril. */
+/** Start receive queue handler fibrils. */
 void tcp_rqueue_fibril_start(void)
 {
 	fid_t fid;
+	unsigned i;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril_start()");
 
-	fid = fibril_create(tcp_rqueue_fibril, NULL);
-	if (fid == 0) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating rqueue fibril.");
-		return;
-	}
+	for (i = 0; i < RQUEUE_NWORKERS; i++) {
+		fid = fibril_create(tcp_rqueue_fibril, &rqueue[i]);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Failed creating rqueue fibril.");
+			return;
+		}
 
-	fibril_add_ready(fid);
-	fibril_active = true;
+		fibril_add_ready(fid);
+		++fibrils_active;
+	}
 }
 
 /**
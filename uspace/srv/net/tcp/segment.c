@@ -74,6 +74,9 @@ tcp_segment_t *tcp_segment_dup(tcp_segment_t *seg)
 	scopy->len = seg->len;
 	scopy->wnd = seg->wnd;
 	scopy->up = seg->up;
+	scopy->has_wscale = seg->has_wscale;
+	scopy->wscale = seg->wscale;
+	scopy->sack_perm = seg->sack_perm;
 
 	tsize = tcp_segment_text_size(seg);
 	scopy->data = calloc(tsize, 1);
@@ -109,9 +109,18 @@ enum opt_kind {
 	/** No-operation */
 	OPT_NOP			= 1,
 	/** Maximum segment size */
-	OPT_MAX_SEG_SIZE	= 2
+	OPT_MAX_SEG_SIZE	= 2,
+	/** Window scale (RFC 7323) */
+	OPT_WINDOW_SCALE	= 3,
+	/** SACK permitted (RFC 2018) */
+	OPT_SACK_PERMITTED	= 4,
+	/** SACK blocks (RFC 2018) */
+	OPT_SACK		= 5
 };
 
+/** Maximum valid window scale shift count (RFC 7323) */
+#define TCP_MAX_WSCALE 14
+
 #endif
 
 /** @}
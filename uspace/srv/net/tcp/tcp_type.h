@@ -173,6 +173,13 @@ typedef struct {
 	void *data;
 	/** Segment data, original pointer used to free data */
 	void *dfptr;
+
+	/** Window scale option is present (SYN segments only) */
+	bool has_wscale;
+	/** Window scale shift count from the window scale option */
+	uint8_t wscale;
+	/** SACK permitted option is present (SYN segments only) */
+	bool sack_perm;
 } tcp_segment_t;
 
 /** Receive queue entry */
@@ -207,6 +214,10 @@ typedef struct {
 	link_t link;
 	tcp_conn_t *conn;
 	tcp_segment_t *seg;
+	/** Uptime (usec) when the segment was last sent */
+	usec_t t_sent;
+	/** Number of times the segment was retransmitted */
+	unsigned rtx_cnt;
 } tcp_tqueue_entry_t;
 
 /** Retransmission queue callbacks */
@@ -223,10 +234,30 @@ typedef struct {
 	/** Retransmission timer */
 	fibril_timer_t *timer;
 
+	/** Transmit pacing timer */
+	fibril_timer_t *pace_timer;
+
 	/** Callbacks */
 	tcp_tqueue_cb_t *cb;
 } tcp_tqueue_t;
 
+/** Congestion control operations.
+ *
+ * All operations are called with the connection locked.
+ */
+typedef struct tcp_cc_ops {
+	/** Name of the congestion control algorithm */
+	const char *name;
+	/** Initialize congestion state of a new connection */
+	void (*open)(tcp_conn_t *);
+	/** New data was acknowledged (@c acked bytes) */
+	void (*ack_recv)(tcp_conn_t *, uint32_t);
+	/** Duplicate acknowledgement received */
+	void (*dup_ack)(tcp_conn_t *);
+	/** Retransmission timeout fired */
+	void (*rtx_timeout)(tcp_conn_t *);
+} tcp_cc_ops_t;
+
 /** Connection */
 struct tcp_conn {
 	char *name;
@@ -316,6 +347,35 @@ struct tcp_conn {
 	uint32_t rcv_up;
 	/** Initial receive sequence number */
 	uint32_t irs;
+
+	/** Peer sent the window scale option in its SYN */
+	bool wscale_rcvd;
+	/** Shift count applied to incoming window advertisements */
+	uint8_t snd_wscale;
+	/** Shift count applied to outgoing window advertisements */
+	uint8_t rcv_wscale;
+	/** Peer sent the SACK permitted option in its SYN */
+	bool sack_perm;
+
+	/** Congestion control operations */
+	const tcp_cc_ops_t *cc;
+	/** Congestion window */
+	uint32_t cwnd;
+	/** Slow start threshold */
+	uint32_t ssthresh;
+	/** Number of consecutive duplicate acknowledgements */
+	uint32_t dupacks;
+
+	/** Smoothed round-trip time (usec), valid if @c rtt_valid */
+	usec_t srtt;
+	/** Round-trip time variation (usec) */
+	usec_t rttvar;
+	/** Current retransmission timeout (usec) */
+	usec_t rto;
+	/** At least one RTT sample has been taken */
+	bool rtt_valid;
+	/** Uptime (usec) when the pacing gate next opens */
+	usec_t pace_next;
 };
 
 /** Continuation of processing.
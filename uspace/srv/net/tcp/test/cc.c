@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <pcut/pcut.h>
+
+#include "../cc.h"
+#include "../conn.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cc);
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+PCUT_TEST_AFTER
+{
+	tcp_conns_fini();
+}
+
+/** New connection starts in slow start with RFC 3390 initial window */
+PCUT_TEST(initial_window)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	PCUT_ASSERT_EQUALS(&tcp_cc_newreno, conn->cc);
+	PCUT_ASSERT_INT_EQUALS(4 * TCP_CC_MSS, conn->cwnd);
+	PCUT_ASSERT_INT_EQUALS(0, conn->dupacks);
+
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Congestion window grows by acked bytes in slow start */
+PCUT_TEST(slow_start)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	uint32_t ocwnd;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	ocwnd = conn->cwnd;
+	conn->cc->ack_recv(conn, TCP_CC_MSS);
+	PCUT_ASSERT_INT_EQUALS(ocwnd + TCP_CC_MSS, conn->cwnd);
+
+	/* Growth per ACK is capped at one MSS */
+	ocwnd = conn->cwnd;
+	conn->cc->ack_recv(conn, 4 * TCP_CC_MSS);
+	PCUT_ASSERT_INT_EQUALS(ocwnd + TCP_CC_MSS, conn->cwnd);
+
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Congestion window grows slowly in congestion avoidance */
+PCUT_TEST(congestion_avoidance)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	uint32_t ocwnd;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Force congestion avoidance */
+	conn->ssthresh = conn->cwnd;
+
+	ocwnd = conn->cwnd;
+	conn->cc->ack_recv(conn, TCP_CC_MSS);
+	PCUT_ASSERT_TRUE(conn->cwnd > ocwnd);
+	PCUT_ASSERT_TRUE(conn->cwnd <= ocwnd + TCP_CC_MSS);
+
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Three duplicate ACKs trigger fast retransmit and window reduction */
+PCUT_TEST(fast_retransmit)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	uint32_t flight;
+	int i;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Pretend we have data in flight */
+	flight = 10 * TCP_CC_MSS;
+	conn->snd_una = 100;
+	conn->snd_nxt = 100 + flight;
+	conn->cwnd = flight;
+	conn->ssthresh = UINT32_MAX;
+
+	tcp_conn_lock(conn);
+	for (i = 0; i < TCP_CC_DUPACK_THRESHOLD; i++)
+		conn->cc->dup_ack(conn);
+	tcp_conn_unlock(conn);
+
+	PCUT_ASSERT_INT_EQUALS(flight / 2, conn->ssthresh);
+	PCUT_ASSERT_INT_EQUALS(flight / 2 +
+	    TCP_CC_DUPACK_THRESHOLD * TCP_CC_MSS, conn->cwnd);
+
+	/* A new ACK deflates the window back to ssthresh */
+	conn->cc->ack_recv(conn, TCP_CC_MSS);
+	PCUT_ASSERT_INT_EQUALS(0, conn->dupacks);
+
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Retransmission timeout collapses the window to one segment */
+PCUT_TEST(rtx_timeout)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	uint32_t flight;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	flight = 10 * TCP_CC_MSS;
+	conn->snd_una = 100;
+	conn->snd_nxt = 100 + flight;
+
+	conn->cc->rtx_timeout(conn);
+
+	PCUT_ASSERT_INT_EQUALS(flight / 2, conn->ssthresh);
+	PCUT_ASSERT_INT_EQUALS(TCP_CC_MSS, conn->cwnd);
+	PCUT_ASSERT_INT_EQUALS(0, conn->dupacks);
+
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+PCUT_EXPORT(cc);
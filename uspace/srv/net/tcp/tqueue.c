@@ -42,7 +42,9 @@
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "ncsim.h"
@@ -52,16 +54,38 @@
 #include "tqueue.h"
 #include "tcp_type.h"
 
+/** Initial retransmission timeout before any RTT sample is taken */
 #define RETRANSMIT_TIMEOUT	(2*1000*1000)
 
+/** Bounds for the adaptive retransmission timeout */
+#define TCP_RTO_MIN	(200*1000)
+#define TCP_RTO_MAX	(60*1000*1000)
+
+/** Pace data segments at the estimated bottleneck rate (cwnd / srtt) */
+#define TCP_PACING	true
+
 static void retransmit_timeout_func(void *);
+static void pace_timeout_func(void *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
+static void tcp_tqueue_timer_ensure(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
+static void tcp_tqueue_pace_timer_set(tcp_conn_t *, usec_t);
+static void tcp_tqueue_pace_timer_clear(tcp_conn_t *);
+static void tcp_tqueue_update_rtt(tcp_conn_t *, usec_t);
 static void tcp_tqueue_seg(tcp_conn_t *, tcp_segment_t *);
 static void tcp_conn_transmit_segment(tcp_conn_t *, tcp_segment_t *);
 static void tcp_prepare_transmit_segment(tcp_conn_t *, tcp_segment_t *);
 static void tcp_tqueue_send_immed(tcp_conn_t *, tcp_segment_t *);
 
+/** Get system uptime in microseconds. */
+static usec_t tcp_uptime_usec(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return (usec_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
     tcp_tqueue_cb_t *cb)
 {
@@ -71,6 +95,20 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 	if (tqueue->timer == NULL)
 		return ENOMEM;
 
+	tqueue->pace_timer = fibril_timer_create(&conn->lock);
+	if (tqueue->pace_timer == NULL) {
+		fibril_timer_destroy(tqueue->timer);
+		tqueue->timer = NULL;
+		return ENOMEM;
+	}
+
+	/* No RTT estimate yet */
+	conn->srtt = 0;
+	conn->rttvar = 0;
+	conn->rto = RETRANSMIT_TIMEOUT;
+	conn->rtt_valid = false;
+	conn->pace_next = 0;
+
 	list_initialize(&tqueue->list);
 
 	return EOK;
@@ -79,6 +117,7 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 void tcp_tqueue_clear(tcp_tqueue_t *tqueue)
 {
 	tcp_tqueue_timer_clear(tqueue->conn);
+	tcp_tqueue_pace_timer_clear(tqueue->conn);
 }
 
 void tcp_tqueue_fini(tcp_tqueue_t *tqueue)
@@ -91,6 +130,11 @@ void tcp_tqueue_fini(tcp_tqueue_t *tqueue)
 		tqueue->timer = NULL;
 	}
 
+	if (tqueue->pace_timer != NULL) {
+		fibril_timer_destroy(tqueue->pace_timer);
+		tqueue->pace_timer = NULL;
+	}
+
 	while (!list_empty(&tqueue->list)) {
 		link = list_first(&tqueue->list);
 		tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
@@ -110,6 +154,20 @@ void tcp_tqueue_ctrl_seg(tcp_conn_t *conn, tcp_control_t ctrl)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_tqueue_ctrl_seg(%p, %u)", conn, ctrl);
 
 	seg = tcp_segment_make_ctrl(ctrl);
+
+	if ((ctrl & CTL_SYN) != 0) {
+		/*
+		 * Attach options to the SYN segment. On a SYN,ACK we only
+		 * offer what the peer has offered in its SYN.
+		 */
+		if (!tcp_conn_got_syn(conn) || conn->wscale_rcvd) {
+			seg->has_wscale = true;
+			seg->wscale = conn->rcv_wscale;
+		}
+
+		seg->sack_perm = !tcp_conn_got_syn(conn) || conn->sack_perm;
+	}
+
 	tcp_tqueue_seg(conn, seg);
 	tcp_segment_delete(seg);
 }
@@ -145,12 +203,14 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 
 		tqe->conn = conn;
 		tqe->seg = rt_seg;
+		tqe->t_sent = tcp_uptime_usec();
+		tqe->rtx_cnt = 0;
 		rt_seg->seq = conn->snd_nxt;
 
 		list_append(&tqe->link, &conn->retransmit.list);
 
-		/* Set retransmission timer */
-		tcp_tqueue_timer_set(conn);
+		/* Start retransmission timer unless it is already running */
+		tcp_tqueue_timer_ensure(conn);
 	}
 
 	tcp_prepare_transmit_segment(conn, seg);
@@ -173,68 +233,109 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 }
 
 /** Transmit data from the send buffer.
+ *
+ * Data is sent in segments of at most one MSS. When an RTT estimate
+ * is available, successive segments are paced at the estimated
+ * bottleneck rate (one congestion window per round-trip) instead of
+ * going to the wire back-to-back; transmission is then resumed by the
+ * pacing timer.
  *
  * @param conn	Connection
  */
 void tcp_tqueue_new_data(tcp_conn_t *conn)
 {
+	uint32_t swnd;
+	uint32_t in_flight;
 	size_t avail_wnd;
 	size_t xfer_seqlen;
 	size_t snd_buf_seqlen;
 	size_t data_size;
 	tcp_control_t ctrl;
 	bool send_fin;
+	usec_t now;
+	usec_t interval;
 
 	tcp_segment_t *seg;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
 
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
-	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
-
-	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+	while (true) {
+		/*
+		 * Number of free sequence numbers in the send window, further
+		 * limited by the congestion window.
+		 */
+		swnd = min(conn->snd_wnd, conn->cwnd);
+		in_flight = conn->snd_nxt - conn->snd_una;
+		avail_wnd = (swnd > in_flight) ? swnd - in_flight : 0;
+		snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
+
+		xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
+		    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
+		    xfer_seqlen);
+
+		if (xfer_seqlen == 0)
+			return;
 
-	if (xfer_seqlen == 0)
-		return;
+		/* Send at most one MSS worth of data per segment. */
+		if (xfer_seqlen > TCP_CC_MSS)
+			xfer_seqlen = TCP_CC_MSS;
+
+		if (TCP_PACING && conn->rtt_valid) {
+			now = tcp_uptime_usec();
+			if (now < conn->pace_next) {
+				/* Too early. Resume when the gate opens. */
+				tcp_tqueue_pace_timer_set(conn,
+				    conn->pace_next - now);
+				return;
+			}
+		}
 
-	/* XXX Do not always send immediately */
+		send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
+		data_size = xfer_seqlen - (send_fin ? 1 : 0);
 
-	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
-	data_size = xfer_seqlen - (send_fin ? 1 : 0);
+		if (send_fin) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
+			/* We are sending out FIN */
+			ctrl = CTL_FIN;
+		} else {
+			ctrl = 0;
+		}
 
-	if (send_fin) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
-		/* We are sending out FIN */
-		ctrl = CTL_FIN;
-	} else {
-		ctrl = 0;
-	}
+		seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
+		if (seg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+			return;
+		}
 
-	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
-	if (seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
-		return;
-	}
+		/* Remove data from send buffer */
+		memmove(conn->snd_buf, conn->snd_buf + data_size,
+		    conn->snd_buf_used - data_size);
+		conn->snd_buf_used -= data_size;
 
-	/* Remove data from send buffer */
-	memmove(conn->snd_buf, conn->snd_buf + data_size,
-	    conn->snd_buf_used - data_size);
-	conn->snd_buf_used -= data_size;
+		if (send_fin)
+			conn->snd_buf_fin = false;
 
-	if (send_fin)
-		conn->snd_buf_fin = false;
+		fibril_condvar_broadcast(&conn->snd_buf_cv);
 
-	fibril_condvar_broadcast(&conn->snd_buf_cv);
+		if (send_fin)
+			tcp_conn_fin_sent(conn);
 
-	if (send_fin)
-		tcp_conn_fin_sent(conn);
+		tcp_tqueue_seg(conn, seg);
+		tcp_segment_delete(seg);
 
-	tcp_tqueue_seg(conn, seg);
-	tcp_segment_delete(seg);
+		/*
+		 * Advance the pacing gate by the serialization time of
+		 * the segment at the estimated bottleneck rate of
+		 * cwnd / srtt bytes per microsecond.
+		 */
+		if (TCP_PACING && conn->rtt_valid && conn->cwnd > 0) {
+			interval = (usec_t) xfer_seqlen * conn->srtt /
+			    conn->cwnd;
+			now = tcp_uptime_usec();
+			conn->pace_next = max(conn->pace_next, now) + interval;
+		}
+	}
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
@@ -245,10 +346,15 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 void tcp_tqueue_ack_received(tcp_conn_t *conn)
 {
 	link_t *cur, *next;
+	bool removed = false;
+	bool have_sample = false;
+	usec_t rtt_sample = 0;
+	usec_t now;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_ack_received(%p)", conn->name,
 	    conn);
 
+	now = tcp_uptime_usec();
 	cur = conn->retransmit.list.head.next;
 
 	while (cur != &conn->retransmit.list.head) {
@@ -257,32 +363,53 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 		tcp_tqueue_entry_t *tqe = list_get_instance(cur,
 		    tcp_tqueue_entry_t, link);
 
-		if (seq_no_segment_acked(conn, tqe->seg, conn->snd_una)) {
-			/* Remove acknowledged segment */
-			list_remove(cur);
-
-			if ((tqe->seg->ctrl & CTL_FIN) != 0) {
-				log_msg(LOG_DEFAULT, LVL_DEBUG, "Fin has been acked");
-				log_msg(LOG_DEFAULT, LVL_DEBUG, "SND.UNA=%" PRIu32
-				    " SEG.SEQ=%" PRIu32 " SEG.LEN=%" PRIu32,
-				    conn->snd_una, tqe->seg->seq, tqe->seg->len);
-				/* Our FIN has been acked */
-				conn->fin_is_acked = true;
-			}
+		if (!seq_no_segment_acked(conn, tqe->seg, conn->snd_una)) {
+			/*
+			 * Queue entries are in sequence order, so nothing
+			 * further down the list can be acknowledged either.
+			 */
+			break;
+		}
 
-			tcp_segment_delete(tqe->seg);
-			free(tqe);
+		/* Remove acknowledged segment */
+		list_remove(cur);
+		removed = true;
+
+		/*
+		 * Segments that were retransmitted must not be sampled
+		 * (Karn's algorithm); the measured time could belong to
+		 * either transmission.
+		 */
+		if (tqe->rtx_cnt == 0 && now >= tqe->t_sent) {
+			rtt_sample = now - tqe->t_sent;
+			have_sample = true;
+		}
 
-			/* Reset retransmission timer */
-			tcp_tqueue_timer_set(conn);
+		if ((tqe->seg->ctrl & CTL_FIN) != 0) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Fin has been acked");
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "SND.UNA=%" PRIu32
+			    " SEG.SEQ=%" PRIu32 " SEG.LEN=%" PRIu32,
+			    conn->snd_una, tqe->seg->seq, tqe->seg->len);
+			/* Our FIN has been acked */
+			conn->fin_is_acked = true;
 		}
 
+		tcp_segment_delete(tqe->seg);
+		free(tqe);
+
 		cur = next;
 	}
 
-	/* Clear retransmission timer if the queue is empty. */
-	if (list_empty(&conn->retransmit.list))
+	if (have_sample)
+		tcp_tqueue_update_rtt(conn, rtt_sample);
+
+	if (list_empty(&conn->retransmit.list)) {
+		/* Clear retransmission timer if the queue is empty. */
 		tcp_tqueue_timer_clear(conn);
+	} else if (removed) {
+		/* Restart retransmission timer for the remaining data. */
+		tcp_tqueue_timer_set(conn);
+	}
 
 	/* Possibly transmit more data */
 	tcp_tqueue_new_data(conn);
@@ -293,7 +420,14 @@ static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	/*
+	 * Scale the advertised window. The window field of a SYN segment
+	 * is never scaled (RFC 7323).
+	 */
+	if ((seg->ctrl & CTL_SYN) != 0)
+		seg->wnd = min(conn->rcv_wnd, UINT16_MAX);
+	else
+		seg->wnd = min(conn->rcv_wnd >> conn->rcv_wscale, UINT16_MAX);
 
 	if ((seg->ctrl & CTL_ACK) != 0)
 		seg->ack = conn->rcv_nxt;
@@ -317,13 +451,49 @@ void tcp_tqueue_send_immed(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->retransmit.cb->transmit_seg(&conn->ident, seg);
 }
 
-static void retransmit_timeout_func(void *arg)
+/** Retransmit the first segment in the retransmission queue.
+ *
+ * Called upon retransmission timeout and by congestion control when
+ * entering fast retransmit.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_retransmit(tcp_conn_t *conn)
 {
-	tcp_conn_t *conn = (tcp_conn_t *) arg;
 	tcp_tqueue_entry_t *tqe;
 	tcp_segment_t *rt_seg;
 	link_t *link;
 
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	link = list_first(&conn->retransmit.list);
+	if (link == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
+		return;
+	}
+
+	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		/* XXX Handle properly */
+		return;
+	}
+
+	/* Mark the entry so that it is not used for RTT sampling. */
+	++tqe->rtx_cnt;
+	tqe->t_sent = tcp_uptime_usec();
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
+	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_segment_delete(rt_seg);
+}
+
+static void retransmit_timeout_func(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
 
 	tcp_conn_lock(conn);
@@ -335,30 +505,23 @@ static void retransmit_timeout_func(void *arg)
 		return;
 	}
 
-	link = list_first(&conn->retransmit.list);
-	if (link == NULL) {
+	if (list_empty(&conn->retransmit.list)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
 		tcp_conn_unlock(conn);
 		tcp_conn_delref(conn);
 		return;
 	}
 
-	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+	/* Let congestion control collapse the congestion window */
+	conn->cc->rtx_timeout(conn);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
-	}
+	tcp_tqueue_retransmit(conn);
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	/* Back off the retransmission timeout (RFC 6298) */
+	conn->rto = min(2 * conn->rto, TCP_RTO_MAX);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -366,6 +529,64 @@ static void retransmit_timeout_func(void *arg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p) end", conn->name, conn);
 }
 
+/** Process the pacing timer firing.
+ *
+ * Resume transmission of buffered data once the pacing gate opens.
+ */
+static void pace_timeout_func(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: pace_timeout_func(%p)", conn->name, conn);
+
+	tcp_conn_lock(conn);
+
+	if (conn->cstate == st_closed) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Connection already closed.");
+		tcp_conn_unlock(conn);
+		tcp_conn_delref(conn);
+		return;
+	}
+
+	tcp_tqueue_new_data(conn);
+
+	tcp_conn_unlock(conn);
+	tcp_conn_delref(conn);
+}
+
+/** Update the RTT estimate and retransmission timeout (RFC 6298).
+ *
+ * @param conn	Connection
+ * @param rtt	Round-trip time sample in microseconds
+ */
+static void tcp_tqueue_update_rtt(tcp_conn_t *conn, usec_t rtt)
+{
+	usec_t delta;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (!conn->rtt_valid) {
+		conn->srtt = rtt;
+		conn->rttvar = rtt / 2;
+		conn->rtt_valid = true;
+	} else {
+		delta = (conn->srtt > rtt) ? conn->srtt - rtt :
+		    rtt - conn->srtt;
+		conn->rttvar = (3 * conn->rttvar + delta) / 4;
+		conn->srtt = (7 * conn->srtt + rtt) / 8;
+	}
+
+	conn->rto = conn->srtt + 4 * conn->rttvar;
+	if (conn->rto < TCP_RTO_MIN)
+		conn->rto = TCP_RTO_MIN;
+	if (conn->rto > TCP_RTO_MAX)
+		conn->rto = TCP_RTO_MAX;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: rtt=%lld srtt=%lld rttvar=%lld "
+	    "rto=%lld", conn->name, (long long) rtt, (long long) conn->srtt,
+	    (long long) conn->rttvar, (long long) conn->rto);
+}
+
 /** Set or re-set retransmission timer */
 static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 {
@@ -377,12 +598,28 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
 }
 
+/** Start retransmission timer if it is not already running.
+ *
+ * Per RFC 6298 the timer is started when a segment with data is
+ * queued and left alone while earlier data is still outstanding, so
+ * queueing a batch of segments does not re-arm it once per segment.
+ */
+static void tcp_tqueue_timer_ensure(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->retransmit.timer->state == fts_active)
+		return;
+
+	tcp_tqueue_timer_set(conn);
+}
+
 /** Clear retransmission timer */
 static void tcp_tqueue_timer_clear(tcp_conn_t *conn)
 {
@@ -396,6 +633,28 @@ static void tcp_tqueue_timer_clear(tcp_conn_t *conn)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_clear() end", conn->name);
 }
 
+/** Start pacing timer unless it is already running */
+static void tcp_tqueue_pace_timer_set(tcp_conn_t *conn, usec_t delay)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->retransmit.pace_timer->state == fts_active)
+		return;
+
+	tcp_conn_addref(conn);
+	fibril_timer_set_locked(conn->retransmit.pace_timer, delay,
+	    pace_timeout_func, (void *) conn);
+}
+
+/** Clear pacing timer */
+static void tcp_tqueue_pace_timer_clear(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (fibril_timer_clear_locked(conn->retransmit.pace_timer) == fts_active)
+		tcp_conn_delref(conn);
+}
+
 /**
  * @}
  */
@@ -49,7 +49,11 @@
 #include "udp_type.h"
 
 static LIST_INITIALIZE(assoc_list);
-static FIBRIL_MUTEX_INITIALIZE(assoc_list_lock);
+/**
+ * Protects the association list and map. Lookup on the receive path is
+ * read-mostly, updates only happen when associations come and go.
+ */
+static FIBRIL_RWLOCK_INITIALIZE(assoc_list_lock);
 static amap_t *amap;
 
 static udp_assoc_t *udp_assoc_find_ref(inet_ep2_t *);
@@ -196,18 +200,18 @@ errno_t udp_assoc_add(udp_assoc_t *assoc)
 	errno_t rc;
 
 	udp_assoc_addref(assoc);
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_write_lock(&assoc_list_lock);
 
 	rc = amap_insert(amap, &assoc->ident, assoc, af_allow_system, &aepp);
 	if (rc != EOK) {
 		udp_assoc_delref(assoc);
-		fibril_mutex_unlock(&assoc_list_lock);
+		fibril_rwlock_write_unlock(&assoc_list_lock);
 		return rc;
 	}
 
 	assoc->ident = aepp;
 	list_append(&assoc->link, &assoc_list);
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_write_unlock(&assoc_list_lock);
 
 	return EOK;
 }
@@ -218,10 +222,10 @@ errno_t udp_assoc_add(udp_assoc_t *assoc)
  */
 void udp_assoc_remove(udp_assoc_t *assoc)
 {
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_write_lock(&assoc_list_lock);
 	amap_remove(amap, &assoc->ident);
 	list_remove(&assoc->link);
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_write_unlock(&assoc_list_lock);
 	udp_assoc_delref(assoc);
 }
 
@@ -421,19 +425,19 @@ static udp_assoc_t *udp_assoc_find_ref(inet_ep2_t *epp)
 	udp_assoc_t *assoc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_find_ref(%p)", epp);
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_read_lock(&assoc_list_lock);
 
 	rc = amap_find_match(amap, epp, &arg);
 	if (rc != EOK) {
 		assert(rc == ENOENT);
-		fibril_mutex_unlock(&assoc_list_lock);
+		fibril_rwlock_read_unlock(&assoc_list_lock);
 		return NULL;
 	}
 
 	assoc = (udp_assoc_t *)arg;
 	udp_assoc_addref(assoc);
 
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_read_unlock(&assoc_list_lock);
 	return assoc;
 }
 
@@ -35,7 +35,9 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <async.h>
+#include <fibril.h>
 #include <ipc/services.h>
 #include <task.h>
 #include <ipc/corecfg.h>
@@ -46,42 +48,53 @@
 
 #define NAME  "taskmon"
 
+/** Default limit on dumped task memory (KiB). */
+#define DUMP_MEM_LIMIT_KB  65536
+
 static bool write_core_files;
 
 static void corecfg_client_conn(ipc_call_t *, void *);
 
-static void fault_event(ipc_call_t *call, void *arg)
+/** Collect the dump of one faulted task. */
+static errno_t dump_fibril(void *arg)
 {
+	task_id_t taskid = *(task_id_t *) arg;
 	const char *fname;
 	char *s_taskid;
+	char *s_limit;
 	char *dump_fname;
 	errno_t rc;
 
-	task_id_t taskid;
-	uintptr_t thread;
-
-	taskid = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
-	thread = ipc_get_arg3(call);
+	free(arg);
 
 	if (asprintf(&s_taskid, "%" PRIu64, taskid) < 0) {
 		printf("Memory allocation failed.\n");
-		return;
+		return ENOMEM;
 	}
 
-	printf(NAME ": Task %" PRIu64 " fault in thread %p.\n", taskid,
-	    (void *) thread);
-
 	fname = "/app/taskdump";
 
 	if (write_core_files) {
-		if (asprintf(&dump_fname, "/data/core%" PRIu64, taskid) < 0) {
+		if (asprintf(&dump_fname, "/data/core%" PRIu64 ".gz",
+		    taskid) < 0) {
 			printf("Memory allocation failed.\n");
-			return;
+			free(s_taskid);
+			return ENOMEM;
+		}
+
+		if (asprintf(&s_limit, "%d", DUMP_MEM_LIMIT_KB) < 0) {
+			printf("Memory allocation failed.\n");
+			free(dump_fname);
+			free(s_taskid);
+			return ENOMEM;
 		}
 
-		printf(NAME ": Executing %s -c %s -t %s\n", fname, dump_fname, s_taskid);
-		rc = task_spawnl(NULL, NULL, fname, fname, "-c", dump_fname, "-t", s_taskid,
-		    NULL);
+		printf(NAME ": Executing %s -c %s -z -l %s -t %s\n", fname,
+		    dump_fname, s_limit, s_taskid);
+		rc = task_spawnl(NULL, NULL, fname, fname, "-c", dump_fname,
+		    "-z", "-l", s_limit, "-t", s_taskid, NULL);
+		free(s_limit);
+		free(dump_fname);
 	} else {
 		printf(NAME ": Executing %s -t %s\n", fname, s_taskid);
 		rc = task_spawnl(NULL, NULL, fname, fname, "-t", s_taskid, NULL);
@@ -91,6 +104,46 @@ static void fault_event(ipc_call_t *call, void *arg)
 		printf("%s: Error spawning %s (%s).\n", NAME, fname,
 		    str_error(rc));
 	}
+
+	free(s_taskid);
+
+	return rc;
+}
+
+static void fault_event(ipc_call_t *call, void *arg)
+{
+	task_id_t taskid;
+	task_id_t *dump_arg;
+	uintptr_t thread;
+	fid_t fid;
+
+	taskid = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	thread = ipc_get_arg3(call);
+
+	printf(NAME ": Task %" PRIu64 " fault in thread %p.\n", taskid,
+	    (void *) thread);
+
+	/*
+	 * Collect the dump in a separate fibril so that this handler
+	 * returns immediately and concurrent faults are not serialized
+	 * behind each other's dumps.
+	 */
+	dump_arg = malloc(sizeof(task_id_t));
+	if (dump_arg == NULL) {
+		printf("Memory allocation failed.\n");
+		return;
+	}
+
+	*dump_arg = taskid;
+
+	fid = fibril_create(dump_fibril, dump_arg);
+	if (fid == 0) {
+		printf("Failed creating dump fibril.\n");
+		free(dump_arg);
+		return;
+	}
+
+	fibril_add_ready(fid);
 }
 
 static void corecfg_get_enable_srv(ipc_call_t *icall)
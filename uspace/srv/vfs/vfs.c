@@ -99,6 +99,15 @@ int main(int argc, char **argv)
 		return ENOMEM;
 	}
 
+	/*
+	 * Initialize the name cache.
+	 */
+	if (!vfs_ncache_init()) {
+		printf("%s: Failed to initialize VFS name cache\n",
+		    NAME);
+		return ENOMEM;
+	}
+
 	/*
 	 * Allocate and initialize the Path Lookup Buffer.
 	 */
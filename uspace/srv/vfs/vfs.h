@@ -37,6 +37,7 @@
 #include <adt/list.h>
 #include <adt/hash_table.h>
 #include <fibril_synch.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <loc.h>
@@ -87,6 +88,18 @@ typedef enum vfs_node_type {
 	VFS_NODE_DIRECTORY,
 } vfs_node_type_t;
 
+/** Byte range lock on a node's contents.
+ *
+ * Allocated on the stack of the fibril performing the I/O and linked into
+ * the node's list of locked ranges for the duration of the operation.
+ */
+typedef struct {
+	link_t link;		/**< Link to vfs_node_t.range_locks. */
+	aoff64_t pos;		/**< First byte of the range. */
+	aoff64_t len;		/**< Length of the range; 0 means unbounded. */
+	bool exclusive;		/**< Excludes all overlapping range locks. */
+} vfs_range_lock_t;
+
 typedef struct {
 	vfs_triplet_t triplet;
 	vfs_node_type_t type;
@@ -110,7 +123,7 @@ typedef struct _vfs_node {
 	 * Usage counter.  This includes, but is not limited to, all vfs_file_t
 	 * structures that reference this node.
 	 */
-	unsigned refcnt;
+	atomic_uint refcnt;
 
 	ht_link_t nh_link;		/**< Node hash-table link. */
 
@@ -118,10 +131,30 @@ typedef struct _vfs_node {
 
 	aoff64_t size;		/**< Cached size if the node is a file. */
 
-	/**
-	 * Holding this rwlock prevents modifications of the node's contents.
+	/** Protects the list of locked content ranges and the size. */
+	fibril_mutex_t range_lock_mutex;
+
+	/** Signalled whenever a locked content range is released. */
+	fibril_condvar_t range_lock_cv;
+
+	/** List of currently locked content ranges (vfs_range_lock_t). */
+	list_t range_locks;
+
+	/*
+	 * Write-combining staging buffer. Small writes through file
+	 * handles opened with MODE_WRITE_COMBINE are coalesced here and
+	 * flushed to the FS server in one batch. All three members are
+	 * only accessed while holding an exclusive whole-file range lock.
 	 */
-	fibril_rwlock_t contents_rwlock;
+
+	/** Staged data or NULL if the node has no staging buffer. */
+	void *wc_buf;
+
+	/** Offset of the staged data within the file. */
+	aoff64_t wc_pos;
+
+	/** Number of staged bytes. */
+	size_t wc_len;
 
 	struct _vfs_node *mount;
 } vfs_node_t;
@@ -137,7 +170,7 @@ typedef struct {
 	vfs_node_t *node;
 
 	/** Number of file handles referencing this file. */
-	unsigned refcnt;
+	atomic_uint refcnt;
 
 	int permissions;
 	bool open_read;
@@ -145,9 +178,10 @@ typedef struct {
 
 	/** Append on write. */
 	bool append;
-} vfs_file_t;
 
-extern fibril_mutex_t nodes_mutex;
+	/** Coalesce small writes in the node's staging buffer. */
+	bool write_combine;
+} vfs_file_t;
 
 extern fibril_condvar_t fs_list_cv;
 extern fibril_mutex_t fs_list_lock;
@@ -182,6 +216,10 @@ extern errno_t vfs_get_fstypes(vfs_fstypes_t *);
 extern errno_t vfs_lookup_internal(vfs_node_t *, char *, int, vfs_lookup_res_t *);
 extern errno_t vfs_link_internal(vfs_node_t *, char *, vfs_triplet_t *);
 
+extern bool vfs_ncache_init(void);
+extern void vfs_ncache_invalidate(vfs_triplet_t *);
+extern void vfs_ncache_purge(void);
+
 extern bool vfs_nodes_init(void);
 extern vfs_node_t *vfs_node_get(vfs_lookup_res_t *);
 extern vfs_node_t *vfs_node_peek(vfs_lookup_res_t *result);
@@ -191,6 +229,10 @@ extern unsigned vfs_nodes_refcount_sum_get(fs_handle_t, service_id_t);
 
 extern bool vfs_node_has_children(vfs_node_t *node);
 
+extern void vfs_node_lock_range(vfs_node_t *, vfs_range_lock_t *, aoff64_t,
+    aoff64_t, bool);
+extern void vfs_node_unlock_range(vfs_node_t *, vfs_range_lock_t *);
+
 extern void *vfs_client_data_create(void);
 extern void vfs_client_data_destroy(void *);
 
@@ -210,10 +252,11 @@ extern errno_t vfs_open_node_remote(vfs_node_t *);
 extern errno_t vfs_op_clone(int oldfd, int newfd, bool desc, int *);
 extern errno_t vfs_op_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *);
 extern errno_t vfs_op_mount(int mpfd, unsigned servid, unsigned flags, unsigned instance, const char *opts, const char *fsname, int *outfd);
+extern errno_t vfs_op_msync(int fd, aoff64_t, aoff64_t);
 extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(int fd, int flags);
 extern errno_t vfs_op_put(int fd);
-extern errno_t vfs_op_read(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_read(int fd, aoff64_t, size_t, size_t *out_bytes);
 extern errno_t vfs_op_rename(int basefd, char *old, char *new);
 extern errno_t vfs_op_resize(int fd, int64_t size);
 extern errno_t vfs_op_stat(int fd);
@@ -223,11 +266,13 @@ extern errno_t vfs_op_unlink(int parentfd, int expectfd, char *path);
 extern errno_t vfs_op_unmount(int mpfd);
 extern errno_t vfs_op_wait_handle(bool high_fd, int *out_fd);
 extern errno_t vfs_op_walk(int parentfd, int flags, char *path, int *out_fd);
-extern errno_t vfs_op_write(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_write(int fd, aoff64_t, size_t, size_t *out_bytes);
 
 extern void vfs_register(ipc_call_t *);
 
 extern void vfs_page_in(ipc_call_t *);
+extern void vfs_pcache_invalidate(vfs_triplet_t *, aoff64_t, aoff64_t);
+extern errno_t vfs_pcache_sync(vfs_triplet_t *, aoff64_t, aoff64_t);
 
 typedef struct {
 	void *buffer;
@@ -36,6 +36,7 @@
  */
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <str.h>
 #include <assert.h>
@@ -43,18 +44,43 @@
 #include <fibril.h>
 #include <fibril_synch.h>
 #include <adt/list.h>
+#include <macros.h>
 #include <task.h>
 #include <vfs/vfs.h>
 #include "vfs.h"
 
 #define VFS_DATA	((vfs_client_data_t *) async_get_client_data())
-#define FILES		(VFS_DATA->files)
+
+/** Initial capacity of a client's file descriptor table. */
+#define FD_TABLE_INITIAL	16
+
+/** Snapshot of a client's file descriptor table.
+ *
+ * Readers resolve file descriptors against the currently published
+ * snapshot without taking the client lock. A snapshot is immutable in
+ * size; the table grows by copy-and-publish under the client lock.
+ * Superseded snapshots are kept on the retired chain and freed only
+ * when the client goes away, so a concurrent reader can never see the
+ * table memory disappear under it.
+ */
+typedef struct vfs_fd_table {
+	/** Chain of superseded tables (valid once retired). */
+	struct vfs_fd_table *next;
+	/** Number of entries. */
+	int capacity;
+	/** File structures; the entries are accessed atomically. */
+	_Atomic(vfs_file_t *) entries[];
+} vfs_fd_table_t;
 
 typedef struct {
+	/** Guards fd allocation, freeing and fd table growth. */
 	fibril_mutex_t lock;
 	fibril_condvar_t cv;
 	list_t passed_handles;
-	vfs_file_t **files;
+	/** Currently published fd table. */
+	_Atomic(vfs_fd_table_t *) table;
+	/** Superseded fd tables, freed on client destroy. */
+	vfs_fd_table_t *retired;
 } vfs_client_data_t;
 
 typedef struct {
@@ -65,36 +91,100 @@ typedef struct {
 
 static errno_t _vfs_fd_free(vfs_client_data_t *, int);
 
+/** Allocate an empty fd table snapshot.
+ *
+ * @param capacity	Number of entries.
+ *
+ * @return		New table or NULL on failure.
+ */
+static vfs_fd_table_t *fd_table_new(int capacity)
+{
+	vfs_fd_table_t *table;
+	int i;
+
+	table = malloc(sizeof(vfs_fd_table_t) +
+	    capacity * sizeof(table->entries[0]));
+	if (!table)
+		return NULL;
+
+	table->next = NULL;
+	table->capacity = capacity;
+	for (i = 0; i < capacity; i++)
+		atomic_init(&table->entries[i], NULL);
+
+	return table;
+}
+
+/** Grow the client's fd table to at least @a capacity entries.
+ *
+ * A larger copy of the current table is published and the old snapshot
+ * is retired. Must be called with the client lock held.
+ *
+ * @return		The published table or NULL on failure.
+ */
+static vfs_fd_table_t *fd_table_grow(vfs_client_data_t *vfs_data, int capacity)
+{
+	vfs_fd_table_t *table = atomic_load(&vfs_data->table);
+	vfs_fd_table_t *ntable;
+	int ncapacity;
+	int i;
+
+	assert(fibril_mutex_is_locked(&vfs_data->lock));
+
+	ncapacity = table ? table->capacity : FD_TABLE_INITIAL;
+	while (ncapacity < capacity)
+		ncapacity = min(2 * ncapacity, VFS_MAX_OPEN_FILES);
+
+	ntable = fd_table_new(ncapacity);
+	if (!ntable)
+		return NULL;
+
+	if (table) {
+		for (i = 0; i < table->capacity; i++) {
+			atomic_init(&ntable->entries[i],
+			    atomic_load(&table->entries[i]));
+		}
+		table->next = vfs_data->retired;
+		vfs_data->retired = table;
+	}
+
+	atomic_store(&vfs_data->table, ntable);
+	return ntable;
+}
+
 /** Initialize the table of open files. */
 static bool vfs_files_init(vfs_client_data_t *vfs_data)
 {
+	bool ok = true;
+
 	fibril_mutex_lock(&vfs_data->lock);
-	if (!vfs_data->files) {
-		vfs_data->files = malloc(VFS_MAX_OPEN_FILES * sizeof(vfs_file_t *));
-		if (!vfs_data->files) {
-			fibril_mutex_unlock(&vfs_data->lock);
-			return false;
-		}
-		memset(vfs_data->files, 0, VFS_MAX_OPEN_FILES * sizeof(vfs_file_t *));
-	}
+	if (!atomic_load(&vfs_data->table))
+		ok = (fd_table_grow(vfs_data, FD_TABLE_INITIAL) != NULL);
 	fibril_mutex_unlock(&vfs_data->lock);
-	return true;
+	return ok;
 }
 
 /** Cleanup the table of open files. */
 static void vfs_files_done(vfs_client_data_t *vfs_data)
 {
+	vfs_fd_table_t *table = atomic_load(&vfs_data->table);
 	int i;
 
-	if (!vfs_data->files)
+	if (!table)
 		return;
 
-	for (i = 0; i < VFS_MAX_OPEN_FILES; i++) {
-		if (vfs_data->files[i])
+	for (i = 0; i < table->capacity; i++) {
+		if (atomic_load(&table->entries[i]))
 			(void) _vfs_fd_free(vfs_data, i);
 	}
 
-	free(vfs_data->files);
+	free(table);
+
+	while (vfs_data->retired) {
+		table = vfs_data->retired;
+		vfs_data->retired = table->next;
+		free(table);
+	}
 
 	while (!list_empty(&vfs_data->passed_handles)) {
 		link_t *lnk;
@@ -117,7 +207,8 @@ void *vfs_client_data_create(void)
 		fibril_mutex_initialize(&vfs_data->lock);
 		fibril_condvar_initialize(&vfs_data->cv);
 		list_initialize(&vfs_data->passed_handles);
-		vfs_data->files = NULL;
+		atomic_init(&vfs_data->table, NULL);
+		vfs_data->retired = NULL;
 	}
 
 	return vfs_data;
@@ -134,7 +225,7 @@ void vfs_client_data_destroy(void *data)
 /** Close the file in the endpoint FS server. */
 static errno_t vfs_file_close_remote(vfs_file_t *file)
 {
-	assert(!file->refcnt);
+	assert(atomic_load(&file->refcnt) == 0);
 
 	async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
 
@@ -157,9 +248,7 @@ static errno_t vfs_file_close_remote(vfs_file_t *file)
  */
 static void vfs_file_addref(vfs_client_data_t *vfs_data, vfs_file_t *file)
 {
-	assert(fibril_mutex_is_locked(&vfs_data->lock));
-
-	file->refcnt++;
+	atomic_fetch_add(&file->refcnt, 1);
 }
 
 /** Decrement reference count of VFS file structure.
@@ -171,9 +260,7 @@ static errno_t vfs_file_delref(vfs_client_data_t *vfs_data, vfs_file_t *file)
 {
 	errno_t rc = EOK;
 
-	assert(fibril_mutex_is_locked(&vfs_data->lock));
-
-	if (file->refcnt-- == 1) {
+	if (atomic_fetch_sub(&file->refcnt, 1) == 1) {
 		/*
 		 * Lost the last reference to a file, need to close it in the
 		 * endpoint FS and drop our reference to the underlying VFS node.
@@ -191,55 +278,87 @@ static errno_t vfs_file_delref(vfs_client_data_t *vfs_data, vfs_file_t *file)
 	return rc;
 }
 
+/** Install a new file structure into a free fd table slot.
+ *
+ * Must be called with the client lock held.
+ */
+static errno_t _vfs_fd_install(vfs_client_data_t *vfs_data,
+    vfs_fd_table_t *table, int fd, vfs_file_t **file)
+{
+	vfs_file_t *nfile;
+
+	nfile = (vfs_file_t *) malloc(sizeof(vfs_file_t));
+	if (!nfile)
+		return ENOMEM;
+
+	memset(nfile, 0, sizeof(vfs_file_t));
+
+	fibril_mutex_initialize(&nfile->_lock);
+	fibril_mutex_lock(&nfile->_lock);
+	atomic_init(&nfile->refcnt, 0);
+	vfs_file_addref(vfs_data, nfile);
+	vfs_file_addref(vfs_data, nfile);
+
+	atomic_store(&table->entries[fd], nfile);
+	*file = nfile;
+	return EOK;
+}
+
 static errno_t _vfs_fd_alloc(vfs_client_data_t *vfs_data, vfs_file_t **file, bool desc, int *out_fd)
 {
+	vfs_fd_table_t *table;
+	errno_t rc;
+	int i;
+
 	if (!vfs_files_init(vfs_data))
 		return ENOMEM;
 
-	unsigned int i;
-	if (desc)
-		i = VFS_MAX_OPEN_FILES - 1;
-	else
-		i = 0;
-
 	fibril_mutex_lock(&vfs_data->lock);
-	while (true) {
-		if (!vfs_data->files[i]) {
-			vfs_data->files[i] = (vfs_file_t *) malloc(sizeof(vfs_file_t));
-			if (!vfs_data->files[i]) {
+	table = atomic_load(&vfs_data->table);
+
+	if (desc) {
+		/*
+		 * Descending allocation hands out the highest free fd,
+		 * so the table must span the entire fd range.
+		 */
+		if (table->capacity < VFS_MAX_OPEN_FILES) {
+			table = fd_table_grow(vfs_data, VFS_MAX_OPEN_FILES);
+			if (!table) {
 				fibril_mutex_unlock(&vfs_data->lock);
 				return ENOMEM;
 			}
-
-			memset(vfs_data->files[i], 0, sizeof(vfs_file_t));
-
-			fibril_mutex_initialize(&vfs_data->files[i]->_lock);
-			fibril_mutex_lock(&vfs_data->files[i]->_lock);
-			vfs_file_addref(vfs_data, vfs_data->files[i]);
-
-			*file = vfs_data->files[i];
-			vfs_file_addref(vfs_data, *file);
-
-			fibril_mutex_unlock(&vfs_data->lock);
-			*out_fd = (int) i;
-			return EOK;
 		}
 
-		if (desc) {
-			if (i == 0)
-				break;
-
-			i--;
-		} else {
-			if (i == VFS_MAX_OPEN_FILES - 1)
-				break;
+		for (i = table->capacity - 1; i >= 0; i--) {
+			if (!atomic_load(&table->entries[i]))
+				goto found;
+		}
+	} else {
+		for (i = 0; i < table->capacity; i++) {
+			if (!atomic_load(&table->entries[i]))
+				goto found;
+		}
 
-			i++;
+		if (table->capacity < VFS_MAX_OPEN_FILES) {
+			i = table->capacity;
+			table = fd_table_grow(vfs_data, table->capacity + 1);
+			if (!table) {
+				fibril_mutex_unlock(&vfs_data->lock);
+				return ENOMEM;
+			}
+			goto found;
 		}
 	}
-	fibril_mutex_unlock(&vfs_data->lock);
 
+	fibril_mutex_unlock(&vfs_data->lock);
 	return EMFILE;
+
+found:
+	rc = _vfs_fd_install(vfs_data, table, i, file);
+	fibril_mutex_unlock(&vfs_data->lock);
+	if (rc == EOK)
+		*out_fd = i;
+	return rc;
 }
 
 /** Allocate a file descriptor.
@@ -259,13 +378,18 @@ errno_t vfs_fd_alloc(vfs_file_t **file, bool desc, int *out_fd)
 
 static errno_t _vfs_fd_free_locked(vfs_client_data_t *vfs_data, int fd)
 {
-	if ((fd < 0) || (fd >= VFS_MAX_OPEN_FILES) || !vfs_data->files[fd]) {
+	vfs_fd_table_t *table = atomic_load(&vfs_data->table);
+	vfs_file_t *file;
+
+	if ((fd < 0) || (fd >= table->capacity))
 		return EBADF;
-	}
 
-	errno_t rc = vfs_file_delref(vfs_data, vfs_data->files[fd]);
-	vfs_data->files[fd] = NULL;
-	return rc;
+	file = atomic_load(&table->entries[fd]);
+	if (!file)
+		return EBADF;
+
+	atomic_store(&table->entries[fd], NULL);
+	return vfs_file_delref(vfs_data, file);
 }
 
 static errno_t _vfs_fd_free(vfs_client_data_t *vfs_data, int fd)
@@ -305,6 +429,8 @@ errno_t vfs_fd_free(int fd)
  */
 errno_t vfs_fd_assign(vfs_file_t *file, int fd)
 {
+	vfs_fd_table_t *table;
+
 	if (!vfs_files_init(VFS_DATA))
 		return ENOMEM;
 
@@ -314,12 +440,21 @@ errno_t vfs_fd_assign(vfs_file_t *file, int fd)
 		return EBADF;
 	}
 
+	table = atomic_load(&VFS_DATA->table);
+	if (fd >= table->capacity) {
+		table = fd_table_grow(VFS_DATA, fd + 1);
+		if (!table) {
+			fibril_mutex_unlock(&VFS_DATA->lock);
+			return ENOMEM;
+		}
+	}
+
 	/* Make sure fd is closed. */
 	(void) _vfs_fd_free_locked(VFS_DATA, fd);
-	assert(FILES[fd] == NULL);
+	assert(atomic_load(&table->entries[fd]) == NULL);
 
-	FILES[fd] = file;
-	vfs_file_addref(VFS_DATA, FILES[fd]);
+	vfs_file_addref(VFS_DATA, file);
+	atomic_store(&table->entries[fd], file);
 	fibril_mutex_unlock(&VFS_DATA->lock);
 
 	return EOK;
@@ -328,37 +463,49 @@ errno_t vfs_fd_assign(vfs_file_t *file, int fd)
 static void _vfs_file_put(vfs_client_data_t *vfs_data, vfs_file_t *file)
 {
 	fibril_mutex_unlock(&file->_lock);
-
-	fibril_mutex_lock(&vfs_data->lock);
 	vfs_file_delref(vfs_data, file);
-	fibril_mutex_unlock(&vfs_data->lock);
 }
 
 static vfs_file_t *_vfs_file_get(vfs_client_data_t *vfs_data, int fd)
 {
-	if (!vfs_files_init(vfs_data))
+	vfs_fd_table_t *table;
+	vfs_file_t *file;
+	unsigned cnt;
+
+	/*
+	 * Lock-free lookup against the published fd table snapshot. Note
+	 * that there must be no blocking point between loading the entry
+	 * and pinning the file below; superseded table snapshots are only
+	 * freed when the client goes away.
+	 */
+	table = atomic_load(&vfs_data->table);
+	if (table == NULL)
 		return NULL;
 
-	fibril_mutex_lock(&vfs_data->lock);
-	if ((fd >= 0) && (fd < VFS_MAX_OPEN_FILES)) {
-		vfs_file_t *file = vfs_data->files[fd];
-		if (file != NULL) {
-			vfs_file_addref(vfs_data, file);
-			fibril_mutex_unlock(&vfs_data->lock);
-
-			fibril_mutex_lock(&file->_lock);
-			if (file->node == NULL) {
-				_vfs_file_put(vfs_data, file);
-				return NULL;
-			}
-			assert(file != NULL);
-			assert(file->node != NULL);
-			return file;
-		}
-	}
-	fibril_mutex_unlock(&vfs_data->lock);
+	if ((fd < 0) || (fd >= table->capacity))
+		return NULL;
 
-	return NULL;
+	file = atomic_load(&table->entries[fd]);
+	if (file == NULL)
+		return NULL;
+
+	/*
+	 * Pin the file. A count of zero means the file is being torn down
+	 * by a concurrent close and must not be revived.
+	 */
+	cnt = atomic_load(&file->refcnt);
+	do {
+		if (cnt == 0)
+			return NULL;
+	} while (!atomic_compare_exchange_weak(&file->refcnt, &cnt, cnt + 1));
+
+	fibril_mutex_lock(&file->_lock);
+	if (file->node == NULL) {
+		_vfs_file_put(vfs_data, file);
+		return NULL;
+	}
+	assert(file->node != NULL);
+	return file;
 }
 
 /** Find VFS file structure for a given file descriptor.
@@ -156,6 +156,16 @@ static void vfs_in_mount(ipc_call_t *req)
 	free(fs_name);
 }
 
+static void vfs_in_msync(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t offset = MERGE_LOUP32(ipc_get_arg2(req), ipc_get_arg3(req));
+	aoff64_t size = ipc_get_arg4(req);
+
+	errno_t rc = vfs_op_msync(fd, offset, size);
+	async_answer_0(req, rc);
+}
+
 static void vfs_in_open(ipc_call_t *req)
 {
 	int fd = ipc_get_arg1(req);
@@ -177,9 +187,10 @@ static void vfs_in_read(ipc_call_t *req)
 	int fd = ipc_get_arg1(req);
 	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
 	    ipc_get_arg3(req));
+	size_t len = ipc_get_arg4(req);
 
 	size_t bytes = 0;
-	errno_t rc = vfs_op_read(fd, pos, &bytes);
+	errno_t rc = vfs_op_read(fd, pos, len, &bytes);
 	async_answer_1(req, rc, bytes);
 }
 
@@ -309,9 +320,10 @@ static void vfs_in_write(ipc_call_t *req)
 	int fd = ipc_get_arg1(req);
 	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
 	    ipc_get_arg3(req));
+	size_t len = ipc_get_arg4(req);
 
 	size_t bytes = 0;
-	errno_t rc = vfs_op_write(fd, pos, &bytes);
+	errno_t rc = vfs_op_write(fd, pos, len, &bytes);
 	async_answer_1(req, rc, bytes);
 }
 
@@ -347,6 +359,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_MOUNT:
 			vfs_in_mount(&call);
 			break;
+		case VFS_IN_MSYNC:
+			vfs_in_msync(&call);
+			break;
 		case VFS_IN_OPEN:
 			vfs_in_open(&call);
 			break;
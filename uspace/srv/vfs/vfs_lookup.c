@@ -42,7 +42,10 @@
 #include <str.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <fibril_synch.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <vfs/canonify.h>
 #include <dirent.h>
@@ -52,6 +55,264 @@ FIBRIL_MUTEX_INITIALIZE(plb_mutex);
 LIST_INITIALIZE(plb_entries);	/**< PLB entry ring buffer. */
 uint8_t *plb = NULL;
 
+/** Maximum number of name cache entries. */
+#define NCACHE_ENTRIES_MAX	1024
+
+/** Name cache entry.
+ *
+ * Maps a (parent directory triplet, component name) pair to the result of
+ * its lookup. Negative entries record that the name does not exist in the
+ * parent directory so that repeated lookups of missing files do not leave
+ * the VFS task either.
+ */
+typedef struct {
+	ht_link_t nc_link;	/**< Name cache hash table link. */
+	link_t lru_link;	/**< LRU list link. */
+	vfs_triplet_t parent;	/**< Triplet of the parent directory. */
+	char *name;		/**< Component name. */
+	bool positive;		/**< False if the name does not exist. */
+	vfs_lookup_res_t res;	/**< Lookup result (positive entries only). */
+} ncache_entry_t;
+
+/** Name cache lookup key. */
+typedef struct {
+	vfs_triplet_t *parent;
+	const char *name;
+} ncache_key_t;
+
+/** Mutex protecting the name cache. */
+static FIBRIL_MUTEX_INITIALIZE(ncache_mutex);
+
+/** Name cache hash table. */
+static hash_table_t ncache;
+
+/** Name cache entries in least-recently-used order. */
+static LIST_INITIALIZE(ncache_lru);
+
+/** Current number of name cache entries. */
+static size_t ncache_entries = 0;
+
+static bool triplet_equal(vfs_triplet_t *a, vfs_triplet_t *b)
+{
+	return (a->fs_handle == b->fs_handle) &&
+	    (a->service_id == b->service_id) && (a->index == b->index);
+}
+
+static size_t ncache_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != 0)
+		hash = hash_combine(hash, (unsigned char) *name++);
+
+	return hash;
+}
+
+static size_t ncache_key_hash(const void *key)
+{
+	const ncache_key_t *nk = key;
+	size_t hash = hash_combine(nk->parent->fs_handle, nk->parent->index);
+	hash = hash_combine(hash, nk->parent->service_id);
+	return hash_combine(hash, ncache_name_hash(nk->name));
+}
+
+static size_t ncache_hash(const ht_link_t *item)
+{
+	ncache_entry_t *ent = hash_table_get_inst(item, ncache_entry_t,
+	    nc_link);
+	ncache_key_t key = {
+		.parent = &ent->parent,
+		.name = ent->name
+	};
+	return ncache_key_hash(&key);
+}
+
+static bool ncache_key_equal(const void *key, const ht_link_t *item)
+{
+	const ncache_key_t *nk = key;
+	ncache_entry_t *ent = hash_table_get_inst(item, ncache_entry_t,
+	    nc_link);
+	return triplet_equal(nk->parent, &ent->parent) &&
+	    (str_cmp(nk->name, ent->name) == 0);
+}
+
+/** Name cache hash table operations. */
+static hash_table_ops_t ncache_ops = {
+	.hash = ncache_hash,
+	.key_hash = ncache_key_hash,
+	.key_equal = ncache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Initialize the name cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_ncache_init(void)
+{
+	return hash_table_create(&ncache, 0, 0, &ncache_ops);
+}
+
+/** Remove a name cache entry. The name cache mutex must be held. */
+static void ncache_evict(ncache_entry_t *ent)
+{
+	hash_table_remove_item(&ncache, &ent->nc_link);
+	list_remove(&ent->lru_link);
+	assert(ncache_entries > 0);
+	ncache_entries--;
+	free(ent->name);
+	free(ent);
+}
+
+/** Look a component up in the name cache.
+ *
+ * @param parent	Triplet of the parent directory
+ * @param name		Component name
+ * @param positive	Place to store whether the name exists
+ * @param res		Place to store the cached lookup result; valid only
+ *			for positive entries
+ *
+ * @return		True if the cache knows the name, false otherwise.
+ */
+static bool vfs_ncache_get(vfs_triplet_t *parent, const char *name,
+    bool *positive, vfs_lookup_res_t *res)
+{
+	ncache_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&ncache_mutex);
+	ht_link_t *link = hash_table_find(&ncache, &key);
+	if (!link) {
+		fibril_mutex_unlock(&ncache_mutex);
+		return false;
+	}
+
+	ncache_entry_t *ent = hash_table_get_inst(link, ncache_entry_t,
+	    nc_link);
+
+	*positive = ent->positive;
+	if (ent->positive)
+		*res = ent->res;
+
+	/* Freshly used entries go to the back of the LRU list. */
+	list_remove(&ent->lru_link);
+	list_append(&ent->lru_link, &ncache_lru);
+
+	fibril_mutex_unlock(&ncache_mutex);
+	return true;
+}
+
+/** Insert a component lookup result into the name cache.
+ *
+ * @param parent	Triplet of the parent directory
+ * @param name		Component name
+ * @param res		Lookup result or NULL to cache a negative entry
+ */
+static void vfs_ncache_insert(vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *res)
+{
+	ncache_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&ncache_mutex);
+
+	ncache_entry_t *ent;
+	ht_link_t *link = hash_table_find(&ncache, &key);
+	if (link) {
+		ent = hash_table_get_inst(link, ncache_entry_t, nc_link);
+		list_remove(&ent->lru_link);
+	} else {
+		ent = malloc(sizeof(ncache_entry_t));
+		if (!ent) {
+			fibril_mutex_unlock(&ncache_mutex);
+			return;
+		}
+		ent->name = str_dup(name);
+		if (!ent->name) {
+			free(ent);
+			fibril_mutex_unlock(&ncache_mutex);
+			return;
+		}
+		ent->parent = *parent;
+		hash_table_insert(&ncache, &ent->nc_link);
+		ncache_entries++;
+	}
+
+	ent->positive = (res != NULL);
+	if (res)
+		ent->res = *res;
+
+	list_append(&ent->lru_link, &ncache_lru);
+
+	if (ncache_entries > NCACHE_ENTRIES_MAX) {
+		ncache_entry_t *oldest = list_get_instance(
+		    list_first(&ncache_lru), ncache_entry_t, lru_link);
+		ncache_evict(oldest);
+	}
+
+	fibril_mutex_unlock(&ncache_mutex);
+}
+
+/** Remove a single name from the name cache.
+ *
+ * @param parent	Triplet of the parent directory
+ * @param name		Component name
+ */
+static void vfs_ncache_remove(vfs_triplet_t *parent, const char *name)
+{
+	ncache_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&ncache_mutex);
+	ht_link_t *link = hash_table_find(&ncache, &key);
+	if (link) {
+		ncache_evict(hash_table_get_inst(link, ncache_entry_t,
+		    nc_link));
+	}
+	fibril_mutex_unlock(&ncache_mutex);
+}
+
+/** Remove all name cache entries referring to a triplet.
+ *
+ * Called when a file system node ceases to exist or when its VFS-cached
+ * metadata (e.g. size) can no longer be kept in sync.
+ *
+ * @param triplet	Triplet of the node
+ */
+void vfs_ncache_invalidate(vfs_triplet_t *triplet)
+{
+	fibril_mutex_lock(&ncache_mutex);
+	list_foreach_safe(ncache_lru, cur, next) {
+		ncache_entry_t *ent = list_get_instance(cur, ncache_entry_t,
+		    lru_link);
+		if (triplet_equal(&ent->parent, triplet) ||
+		    (ent->positive && triplet_equal(&ent->res.triplet,
+		    triplet))) {
+			ncache_evict(ent);
+		}
+	}
+	fibril_mutex_unlock(&ncache_mutex);
+}
+
+/** Remove all name cache entries. */
+void vfs_ncache_purge(void)
+{
+	fibril_mutex_lock(&ncache_mutex);
+	while (!list_empty(&ncache_lru)) {
+		ncache_entry_t *ent = list_get_instance(
+		    list_first(&ncache_lru), ncache_entry_t, lru_link);
+		ncache_evict(ent);
+	}
+	fibril_mutex_unlock(&ncache_mutex);
+}
+
 static errno_t plb_insert_entry(plb_entry_t *entry, char *path, size_t *start,
     size_t len)
 {
@@ -191,6 +452,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 		goto out;
 	}
 
+	/* The name is about to come into existence. */
+	vfs_ncache_remove(triplet, component);
+
 	async_exch_t *exch = vfs_exchange_grab(triplet->fs_handle);
 	aid_t req = async_send_3(exch, VFS_OUT_LINK, triplet->service_id,
 	    triplet->index, child->index, NULL);
@@ -237,6 +501,39 @@ static errno_t out_lookup(vfs_triplet_t *base, size_t *pfirst, size_t *plen,
 	return EOK;
 }
 
+/** Extract the next component of a path.
+ *
+ * @param path Remaining path, starting with a slash
+ * @param len  Number of characters remaining in the path
+ * @param name Buffer for the component name, at least NAME_MAX + 1 bytes
+ * @param clen Place to store the number of characters consumed, including
+ *             the leading slash
+ *
+ * @return True if the component fits in NAME_MAX characters.
+ */
+static bool path_component(const char *path, size_t len, char *name,
+    size_t *clen)
+{
+	size_t pos = 0;
+	size_t nlen = 0;
+	bool fits = true;
+
+	while ((pos < len) && (path[pos] == '/'))
+		pos++;
+
+	while ((pos < len) && (path[pos] != '/')) {
+		if (nlen < NAME_MAX)
+			name[nlen++] = path[pos];
+		else
+			fits = false;
+		pos++;
+	}
+
+	name[nlen] = 0;
+	*clen = pos;
+	return fits;
+}
+
 static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
     vfs_lookup_res_t *result, size_t len)
 {
@@ -253,38 +550,119 @@ static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 	vfs_lookup_res_t res;
 
-	/* Resolve path as long as there are mount points to cross. */
+	/* Cross mount points in the base node. */
+	while (base->mount) {
+		if (lflag & L_DISABLE_MOUNTS) {
+			rc = EXDEV;
+			goto out;
+		}
+
+		base = base->mount;
+	}
+
+	vfs_triplet_t cur = *((vfs_triplet_t *) base);
+
+	/*
+	 * Resolve the path one component at a time so that each step can be
+	 * satisfied from (and recorded in) the name cache. Only cache misses
+	 * are sent to the file system server.
+	 */
 	while (nlen > 0) {
-		while (base->mount) {
-			if (lflag & L_DISABLE_MOUNTS) {
-				rc = EXDEV;
-				goto out;
-			}
+		char component[NAME_MAX + 1];
+		size_t clen;
+		bool wellformed = path_component(path + (len - nlen), nlen,
+		    component, &clen);
+		bool last = (clen == nlen);
 
-			base = base->mount;
-		}
+		int tflag = last ? lflag :
+		    ((lflag & L_DISABLE_MOUNTS) | L_DIRECTORY);
 
-		rc = out_lookup((vfs_triplet_t *) base, &next, &nlen, lflag,
-		    &res);
-		if (rc != EOK)
-			goto out;
+		/*
+		 * Lookups with side effects or special mount point semantics
+		 * bypass the name cache. Creation and removal also invalidate
+		 * whatever the cache knows about the name.
+		 */
+		bool cacheable = wellformed && (component[0] != 0) &&
+		    ((tflag & ~(L_FILE | L_DIRECTORY | L_DISABLE_MOUNTS)) == 0);
 
-		if (nlen > 0) {
-			base = vfs_node_peek(&res);
-			if (!base) {
+		if (last && (lflag & (L_CREATE | L_UNLINK)))
+			vfs_ncache_remove(&cur, component);
+
+		bool positive;
+		if (cacheable &&
+		    vfs_ncache_get(&cur, component, &positive, &res)) {
+			if (!positive) {
 				rc = ENOENT;
 				goto out;
 			}
-			if (!base->mount) {
-				vfs_node_put(base);
-				rc = ENOENT;
+
+			/* The same type checks the server would have done. */
+			if ((tflag & L_FILE) &&
+			    (res.type == VFS_NODE_DIRECTORY)) {
+				rc = EISDIR;
 				goto out;
 			}
-			vfs_node_put(base);
-			if (lflag & L_DISABLE_MOUNTS) {
-				rc = EXDEV;
+			if ((tflag & L_DIRECTORY) &&
+			    (res.type == VFS_NODE_FILE)) {
+				rc = ENOTDIR;
+				goto out;
+			}
+
+			next = (next + clen) % PLB_SIZE;
+			nlen -= clen;
+		} else {
+			size_t cnext = next;
+			size_t cnlen = clen;
+
+			rc = out_lookup(&cur, &cnext, &cnlen, tflag, &res);
+			if (rc != EOK)
+				goto out;
+
+			if (cnlen != 0) {
+				/*
+				 * The file system server could not resolve
+				 * the component, i.e. the name does not exist
+				 * in the current directory.
+				 */
+				if (cacheable)
+					vfs_ncache_insert(&cur, component,
+					    NULL);
+				rc = ENOENT;
 				goto out;
 			}
+
+			if (cacheable)
+				vfs_ncache_insert(&cur, component, &res);
+
+			next = cnext;
+			nlen -= clen;
+		}
+
+		/* If this was not the final component, cross mount points. */
+		if (nlen > 0) {
+			vfs_node_t *tnode = vfs_node_peek(&res);
+			if (tnode) {
+				if (tnode->mount &&
+				    (lflag & L_DISABLE_MOUNTS)) {
+					vfs_node_put(tnode);
+					rc = EXDEV;
+					goto out;
+				}
+
+				while (tnode->mount) {
+					vfs_node_addref(tnode->mount);
+					vfs_node_t *nbase = tnode->mount;
+					vfs_node_put(tnode);
+					tnode = nbase;
+				}
+
+				res.triplet = *((vfs_triplet_t *) tnode);
+				res.type = tnode->type;
+				res.size = tnode->size;
+				vfs_node_put(tnode);
+			}
+
+			cur = res.triplet;
 		}
 	}
 
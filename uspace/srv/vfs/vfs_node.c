@@ -36,6 +36,7 @@
  */
 
 #include "vfs.h"
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <str.h>
 #include <fibril_synch.h>
@@ -46,14 +47,22 @@
 #include <errno.h>
 #include <macros.h>
 
-/** Mutex protecting the VFS node hash table. */
-FIBRIL_MUTEX_INITIALIZE(nodes_mutex);
+#define NODES_SHARDS_LOG	4
+#define NODES_SHARDS		(1 << NODES_SHARDS_LOG)
 
-#define NODES_BUCKETS_LOG	8
-#define NODES_BUCKETS		(1 << NODES_BUCKETS_LOG)
+/** One shard of the VFS node registry. */
+typedef struct {
+	/** Mutex protecting the shard's hash table. */
+	fibril_mutex_t lock;
+	/** Active, in-memory VFS nodes hashing into this shard. */
+	hash_table_t nodes;
+} nodes_shard_t;
 
-/** VFS node hash table containing all active, in-memory VFS nodes. */
-hash_table_t nodes;
+/**
+ * The VFS node registry, sharded by triplet hash so that lookups for
+ * unrelated nodes do not contend on a single mutex.
+ */
+static nodes_shard_t nodes_shards[NODES_SHARDS];
 
 #define KEY_FS_HANDLE	0
 #define KEY_DEV_HANDLE	1
@@ -73,18 +82,43 @@ hash_table_ops_t nodes_ops = {
 	.remove_callback = NULL,
 };
 
-/** Initialize the VFS node hash table.
+/** Return the shard a triplet hashes into. */
+static inline nodes_shard_t *triplet_shard(const vfs_triplet_t *tri)
+{
+	return &nodes_shards[nodes_key_hash(tri) & (NODES_SHARDS - 1)];
+}
+
+/** Return the shard a node belongs to. */
+static inline nodes_shard_t *node_shard(vfs_node_t *node)
+{
+	vfs_triplet_t tri = node_triplet(node);
+	return triplet_shard(&tri);
+}
+
+/** Initialize the VFS node registry.
  *
  * @return		Return true on success, false on failure.
  */
 bool vfs_nodes_init(void)
 {
-	return hash_table_create(&nodes, 0, 0, &nodes_ops);
+	int i;
+
+	for (i = 0; i < NODES_SHARDS; i++) {
+		fibril_mutex_initialize(&nodes_shards[i].lock);
+		if (!hash_table_create(&nodes_shards[i].nodes, 0, 0,
+		    &nodes_ops)) {
+			while (i > 0)
+				hash_table_destroy(&nodes_shards[--i].nodes);
+			return false;
+		}
+	}
+
+	return true;
 }
 
 static inline void _vfs_node_addref(vfs_node_t *node)
 {
-	node->refcnt++;
+	atomic_fetch_add(&node->refcnt, 1);
 }
 
 /** Increment reference count of a VFS node.
@@ -93,9 +127,7 @@ static inline void _vfs_node_addref(vfs_node_t *node)
  */
 void vfs_node_addref(vfs_node_t *node)
 {
-	fibril_mutex_lock(&nodes_mutex);
 	_vfs_node_addref(node);
-	fibril_mutex_unlock(&nodes_mutex);
 }
 
 /** Decrement reference count of a VFS node.
@@ -106,24 +138,48 @@ void vfs_node_addref(vfs_node_t *node)
  */
 void vfs_node_delref(vfs_node_t *node)
 {
+	nodes_shard_t *shard = node_shard(node);
 	bool free_node = false;
+	unsigned cnt;
+
+	/*
+	 * Fast path: as long as this is provably not the last reference,
+	 * drop it without taking the shard lock.
+	 */
+	cnt = atomic_load(&node->refcnt);
+	while (cnt > 1) {
+		if (atomic_compare_exchange_weak(&node->refcnt, &cnt, cnt - 1))
+			return;
+	}
 
-	fibril_mutex_lock(&nodes_mutex);
+	/*
+	 * This may be the last reference. Drop it under the shard lock so
+	 * that a concurrent vfs_node_get() cannot find the node after it
+	 * has been decided to free it.
+	 */
+	fibril_mutex_lock(&shard->lock);
 
-	node->refcnt--;
-	if (node->refcnt == 0) {
+	if (atomic_fetch_sub(&node->refcnt, 1) == 1) {
 		/*
 		 * We are dropping the last reference to this node.
 		 * Remove it from the VFS node hash table.
 		 */
 
-		hash_table_remove_item(&nodes, &node->nh_link);
+		hash_table_remove_item(&shard->nodes, &node->nh_link);
 		free_node = true;
 	}
 
-	fibril_mutex_unlock(&nodes_mutex);
+	fibril_mutex_unlock(&shard->lock);
 
 	if (free_node) {
+		/*
+		 * The name cache may hold a stale copy of the node's
+		 * metadata once the node itself is gone, and the page
+		 * cache may hold its content.
+		 */
+		vfs_ncache_invalidate((vfs_triplet_t *) node);
+		vfs_pcache_invalidate((vfs_triplet_t *) node, 0, 0);
+
 		/*
 		 * VFS_OUT_DESTROY will free up the file's resources if there
 		 * are no more hard links.
@@ -134,6 +190,7 @@ void vfs_node_delref(vfs_node_t *node)
 		    (sysarg_t)node->index);
 		vfs_exchange_release(exch);
 
+		free(node->wc_buf);
 		free(node);
 	}
 }
@@ -147,9 +204,14 @@ void vfs_node_delref(vfs_node_t *node)
  */
 void vfs_node_forget(vfs_node_t *node)
 {
-	fibril_mutex_lock(&nodes_mutex);
-	hash_table_remove_item(&nodes, &node->nh_link);
-	fibril_mutex_unlock(&nodes_mutex);
+	nodes_shard_t *shard = node_shard(node);
+
+	fibril_mutex_lock(&shard->lock);
+	hash_table_remove_item(&shard->nodes, &node->nh_link);
+	fibril_mutex_unlock(&shard->lock);
+	vfs_ncache_invalidate((vfs_triplet_t *) node);
+	vfs_pcache_invalidate((vfs_triplet_t *) node, 0, 0);
+	free(node->wc_buf);
 	free(node);
 }
 
@@ -167,14 +229,15 @@ void vfs_node_forget(vfs_node_t *node)
  */
 vfs_node_t *vfs_node_get(vfs_lookup_res_t *result)
 {
+	nodes_shard_t *shard = triplet_shard(&result->triplet);
 	vfs_node_t *node;
 
-	fibril_mutex_lock(&nodes_mutex);
-	ht_link_t *tmp = hash_table_find(&nodes, &result->triplet);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *tmp = hash_table_find(&shard->nodes, &result->triplet);
 	if (!tmp) {
 		node = (vfs_node_t *) malloc(sizeof(vfs_node_t));
 		if (!node) {
-			fibril_mutex_unlock(&nodes_mutex);
+			fibril_mutex_unlock(&shard->lock);
 			return NULL;
 		}
 		memset(node, 0, sizeof(vfs_node_t));
@@ -183,29 +246,33 @@ vfs_node_t *vfs_node_get(vfs_lookup_res_t *result)
 		node->index = result->triplet.index;
 		node->size = result->size;
 		node->type = result->type;
-		fibril_rwlock_initialize(&node->contents_rwlock);
-		hash_table_insert(&nodes, &node->nh_link);
+		atomic_init(&node->refcnt, 0);
+		fibril_mutex_initialize(&node->range_lock_mutex);
+		fibril_condvar_initialize(&node->range_lock_cv);
+		list_initialize(&node->range_locks);
+		hash_table_insert(&shard->nodes, &node->nh_link);
 	} else {
 		node = hash_table_get_inst(tmp, vfs_node_t, nh_link);
 	}
 
 	_vfs_node_addref(node);
-	fibril_mutex_unlock(&nodes_mutex);
+	fibril_mutex_unlock(&shard->lock);
 
 	return node;
 }
 
 vfs_node_t *vfs_node_peek(vfs_lookup_res_t *result)
 {
+	nodes_shard_t *shard = triplet_shard(&result->triplet);
 	vfs_node_t *node = NULL;
 
-	fibril_mutex_lock(&nodes_mutex);
-	ht_link_t *tmp = hash_table_find(&nodes, &result->triplet);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *tmp = hash_table_find(&shard->nodes, &result->triplet);
 	if (tmp) {
 		node = hash_table_get_inst(tmp, vfs_node_t, nh_link);
 		_vfs_node_addref(node);
 	}
-	fibril_mutex_unlock(&nodes_mutex);
+	fibril_mutex_unlock(&shard->lock);
 
 	return node;
 }
@@ -237,7 +304,7 @@ static bool refcnt_visitor(ht_link_t *item, void *arg)
 
 	if ((node->fs_handle == rd->fs_handle) &&
 	    (node->service_id == rd->service_id))
-		rd->refcnt += node->refcnt;
+		rd->refcnt += atomic_load(&node->refcnt);
 
 	return true;
 }
@@ -250,10 +317,13 @@ vfs_nodes_refcount_sum_get(fs_handle_t fs_handle, service_id_t service_id)
 		.fs_handle = fs_handle,
 		.service_id = service_id
 	};
+	int i;
 
-	fibril_mutex_lock(&nodes_mutex);
-	hash_table_apply(&nodes, refcnt_visitor, &rd);
-	fibril_mutex_unlock(&nodes_mutex);
+	for (i = 0; i < NODES_SHARDS; i++) {
+		fibril_mutex_lock(&nodes_shards[i].lock);
+		hash_table_apply(&nodes_shards[i].nodes, refcnt_visitor, &rd);
+		fibril_mutex_unlock(&nodes_shards[i].lock);
+	}
 
 	return rd.refcnt;
 }
@@ -312,6 +382,72 @@ static inline vfs_triplet_t node_triplet(vfs_node_t *node)
 	return tri;
 }
 
+/** Determine whether two content range locks conflict.
+ *
+ * Two locks conflict if their byte ranges overlap and at least one of them
+ * is exclusive. A range with zero length extends to infinity.
+ */
+static bool range_locks_conflict(vfs_range_lock_t *a, vfs_range_lock_t *b)
+{
+	if (!a->exclusive && !b->exclusive)
+		return false;
+
+	if ((a->len != 0) && (a->pos + a->len <= b->pos))
+		return false;
+
+	if ((b->len != 0) && (b->pos + b->len <= a->pos))
+		return false;
+
+	return true;
+}
+
+/** Lock a byte range of the node's contents.
+ *
+ * Blocks until no conflicting range is held. The lock structure is provided
+ * by the caller and must stay valid until vfs_node_unlock_range().
+ *
+ * @param node		VFS node
+ * @param rl		Caller-provided range lock structure
+ * @param pos		First byte of the range
+ * @param len		Length of the range; 0 means up to infinity
+ * @param exclusive	True to exclude all overlapping ranges
+ */
+void vfs_node_lock_range(vfs_node_t *node, vfs_range_lock_t *rl, aoff64_t pos,
+    aoff64_t len, bool exclusive)
+{
+	link_initialize(&rl->link);
+	rl->pos = pos;
+	rl->len = len;
+	rl->exclusive = exclusive;
+
+	fibril_mutex_lock(&node->range_lock_mutex);
+
+restart:
+	list_foreach(node->range_locks, link, vfs_range_lock_t, cur) {
+		if (range_locks_conflict(rl, cur)) {
+			fibril_condvar_wait(&node->range_lock_cv,
+			    &node->range_lock_mutex);
+			goto restart;
+		}
+	}
+
+	list_append(&rl->link, &node->range_locks);
+	fibril_mutex_unlock(&node->range_lock_mutex);
+}
+
+/** Unlock a byte range of the node's contents.
+ *
+ * @param node	VFS node
+ * @param rl	Range lock structure passed to vfs_node_lock_range()
+ */
+void vfs_node_unlock_range(vfs_node_t *node, vfs_range_lock_t *rl)
+{
+	fibril_mutex_lock(&node->range_lock_mutex);
+	list_remove(&rl->link);
+	fibril_condvar_broadcast(&node->range_lock_cv);
+	fibril_mutex_unlock(&node->range_lock_mutex);
+}
+
 bool vfs_node_has_children(vfs_node_t *node)
 {
 	async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
@@ -53,6 +53,7 @@
 /* Forward declarations of static functions. */
 static errno_t vfs_truncate_internal(fs_handle_t, service_id_t, fs_index_t,
     aoff64_t);
+static errno_t vfs_wc_flush(vfs_node_t *);
 
 /**
  * This rwlock prevents the race between a triplet-to-VFS-node resolution and a
@@ -124,6 +125,18 @@ errno_t vfs_op_clone(int oldfd, int newfd, bool desc, int *out_fd)
 
 errno_t vfs_op_put(int fd)
 {
+	/*
+	 * Flush writes staged for the node by write combining. Data
+	 * staged by a client which dies without closing its files is
+	 * dropped, just like data in its unflushed stdio buffers.
+	 */
+	vfs_file_t *file = vfs_file_get(fd);
+	if (file) {
+		if (file->write_combine && file->node)
+			(void) vfs_wc_flush(file->node);
+		vfs_file_put(file);
+	}
+
 	return vfs_fd_free(fd);
 }
 
@@ -271,6 +284,7 @@ errno_t vfs_op_mount(int mpfd, unsigned service_id, unsigned flags,
 		vfs_node_addref(mp->node);
 		vfs_node_addref(root);
 		mp->node->mount = root;
+		vfs_ncache_purge();
 	}
 
 	fibril_rwlock_write_unlock(&namespace_rwlock);
@@ -312,7 +326,8 @@ errno_t vfs_op_open(int fd, int mode)
 	if (!file)
 		return EBADF;
 
-	if ((mode & ~file->permissions) != 0) {
+	/* MODE_WRITE_COMBINE is a modifier, not a permission. */
+	if ((mode & ~(file->permissions | MODE_WRITE_COMBINE)) != 0) {
 		vfs_file_put(file);
 		return EPERM;
 	}
@@ -325,6 +340,8 @@ errno_t vfs_op_open(int fd, int mode)
 	file->open_read = (mode & MODE_READ) != 0;
 	file->open_write = (mode & (MODE_WRITE | MODE_APPEND)) != 0;
 	file->append = (mode & MODE_APPEND) != 0;
+	file->write_combine = ((mode & MODE_WRITE_COMBINE) != 0) &&
+	    file->open_write;
 
 	if (!file->open_read && !file->open_write) {
 		vfs_file_put(file);
@@ -407,8 +424,190 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
-static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
-    void *ipc_cb_data)
+/** Size of a node's write-combining staging buffer. */
+#define WC_BUF_SIZE	16384
+
+/** Largest write considered for write combining. */
+#define WC_MAX_WRITE	4096
+
+/** Flush a node's write-combining staging buffer to the FS server.
+ *
+ * The caller must hold an exclusive whole-file range lock on the node.
+ * The staged data is dropped even if the flush fails, so the failure is
+ * reported exactly once, to the operation which triggered the flush.
+ *
+ * @param node		Node with a non-empty staging buffer.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t vfs_wc_flush_locked(vfs_node_t *node)
+{
+	vfs_info_t *fs_info = fs_handle_to_info(node->fs_handle);
+	size_t off = 0;
+	errno_t rc = EOK;
+
+	assert(fs_info);
+
+	while (off < node->wc_len) {
+		ipc_call_t answer;
+		async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+		aid_t msg = async_send_4(exch, VFS_OUT_WRITE,
+		    node->service_id, node->index,
+		    LOWER32(node->wc_pos + off), UPPER32(node->wc_pos + off),
+		    &answer);
+		rc = async_data_write_start(exch, node->wc_buf + off,
+		    node->wc_len - off);
+		vfs_exchange_release(exch);
+
+		if (rc == EOK)
+			async_wait_for(msg, &rc);
+		else
+			async_forget(msg);
+
+		if (rc != EOK)
+			break;
+
+		size_t bytes = ipc_get_arg1(&answer);
+		if (bytes == 0) {
+			rc = EIO;
+			break;
+		}
+
+		/* Update the cached version of node's size. */
+		if (!fs_info->write_retains_size) {
+			aoff64_t nsize = MERGE_LOUP32(ipc_get_arg2(&answer),
+			    ipc_get_arg3(&answer));
+
+			fibril_mutex_lock(&node->range_lock_mutex);
+			if (nsize > node->size)
+				node->size = nsize;
+			fibril_mutex_unlock(&node->range_lock_mutex);
+		}
+
+		off += bytes;
+	}
+
+	node->wc_len = 0;
+	return rc;
+}
+
+/** Flush any data staged for a node by write combining.
+ *
+ * Grabs an exclusive whole-file range lock, so the caller must not hold
+ * a range lock on the node.
+ *
+ * @param node		Node to flush.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t vfs_wc_flush(vfs_node_t *node)
+{
+	vfs_range_lock_t range;
+	errno_t rc = EOK;
+
+	/* Unsynchronized peek; the common case has nothing staged. */
+	if (node->wc_len == 0)
+		return EOK;
+
+	vfs_node_lock_range(node, &range, 0, 0, true);
+	if (node->wc_len != 0)
+		rc = vfs_wc_flush_locked(node);
+	vfs_node_unlock_range(node, &range);
+
+	return rc;
+}
+
+/** Serve a small write from the node's write-combining staging buffer.
+ *
+ * The data is accepted from the client into the staging buffer and only
+ * sent to the FS server when the buffer fills up, when a write not
+ * adjacent to the staged run, a read or a resize arrives, or on
+ * vfs_op_sync() and vfs_op_put() of the file.
+ *
+ * @param file		Open file with write_combine set.
+ * @param pos		Position to write to.
+ * @param len		Number of bytes to write.
+ * @param[out] out_bytes Number of bytes actually accepted.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t vfs_wc_write(vfs_file_t *file, aoff64_t pos, size_t len,
+    size_t *out_bytes)
+{
+	vfs_node_t *node = file->node;
+	vfs_range_lock_t range;
+	ipc_call_t call;
+	size_t size;
+	errno_t rc = EOK;
+
+	vfs_node_lock_range(node, &range, 0, 0, true);
+
+	if (file->append)
+		pos = node->size;
+
+	if (node->wc_buf == NULL) {
+		node->wc_buf = malloc(WC_BUF_SIZE);
+		if (node->wc_buf == NULL) {
+			vfs_node_unlock_range(node, &range);
+			return ENOMEM;
+		}
+	}
+
+	/* Only writes extending the staged run are combined. */
+	if ((node->wc_len > 0) && (pos != node->wc_pos + node->wc_len)) {
+		rc = vfs_wc_flush_locked(node);
+		if (rc != EOK) {
+			vfs_node_unlock_range(node, &range);
+			return rc;
+		}
+	}
+
+	if (node->wc_len == 0)
+		node->wc_pos = pos;
+
+	if (!async_data_write_receive(&call, &size)) {
+		vfs_node_unlock_range(node, &range);
+		return EINVAL;
+	}
+
+	if (size > len)
+		size = len;
+	if (size > WC_BUF_SIZE - node->wc_len)
+		size = WC_BUF_SIZE - node->wc_len;
+
+	rc = async_data_write_finalize(&call, node->wc_buf + node->wc_len,
+	    size);
+	if (rc != EOK) {
+		vfs_node_unlock_range(node, &range);
+		return rc;
+	}
+
+	node->wc_len += size;
+
+	/*
+	 * Any pages of the written range cached for memory-mapped access
+	 * are now stale.
+	 */
+	vfs_pcache_invalidate((vfs_triplet_t *) node, pos, size);
+
+	/* The cached version of node's size must reflect the staged data. */
+	fibril_mutex_lock(&node->range_lock_mutex);
+	if (node->wc_pos + node->wc_len > node->size)
+		node->size = node->wc_pos + node->wc_len;
+	fibril_mutex_unlock(&node->range_lock_mutex);
+
+	if (node->wc_len == WC_BUF_SIZE)
+		rc = vfs_wc_flush_locked(node);
+
+	vfs_node_unlock_range(node, &range);
+
+	if (rc == EOK)
+		*out_bytes = size;
+	return rc;
+}
+
+static errno_t vfs_rdwr(int fd, aoff64_t pos, size_t len, bool read,
+    rdwr_ipc_cb_t ipc_cb, void *ipc_cb_data)
 {
 	/*
 	 * The following code strongly depends on the fact that the files data
@@ -433,18 +632,7 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 	vfs_info_t *fs_info = fs_handle_to_info(file->node->fs_handle);
 	assert(fs_info);
 
-	bool rlock = read ||
-	    (fs_info->concurrent_read_write && fs_info->write_retains_size);
-
-	/*
-	 * Lock the file's node so that no other client can read/write to it at
-	 * the same time unless the FS supports concurrent reads/writes and its
-	 * write implementation does not modify the file size.
-	 */
-	if (rlock)
-		fibril_rwlock_read_lock(&file->node->contents_rwlock);
-	else
-		fibril_rwlock_write_lock(&file->node->contents_rwlock);
+	vfs_range_lock_t range;
 
 	if (file->node->type == VFS_NODE_DIRECTORY) {
 		/*
@@ -453,25 +641,56 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 		 */
 
 		if (!read) {
-			if (rlock) {
-				fibril_rwlock_read_unlock(
-				    &file->node->contents_rwlock);
-			} else {
-				fibril_rwlock_write_unlock(
-				    &file->node->contents_rwlock);
-			}
 			vfs_file_put(file);
 			return EINVAL;
 		}
 
 		fibril_rwlock_read_lock(&namespace_rwlock);
+	} else {
+		/*
+		 * Data staged for the node by write combining must reach
+		 * the FS server before any other I/O on the node, lest the
+		 * operations be reordered.
+		 */
+		if (file->node->wc_len != 0) {
+			errno_t frc = vfs_wc_flush(file->node);
+			if (frc != EOK) {
+				vfs_file_put(file);
+				return frc;
+			}
+		}
+
+		/*
+		 * Lock the accessed byte range of the node so that writes are
+		 * ordered with respect to overlapping reads and writes, but
+		 * I/O to disjoint regions of the file proceeds in parallel.
+		 * Writes also need to be exclusive to keep the cached file
+		 * size consistent, unless the FS supports concurrent
+		 * reads/writes and its write implementation does not modify
+		 * the file size.
+		 */
+		bool exclusive = !read &&
+		    !(fs_info->concurrent_read_write &&
+		    fs_info->write_retains_size);
+
+		if (!read && file->append) {
+			/*
+			 * The end of file must not move between the position
+			 * lookup and the write itself; lock everything from
+			 * the current end of file onwards and re-read the
+			 * position once the lock is held.
+			 */
+			vfs_node_lock_range(file->node, &range,
+			    file->node->size, 0, true);
+			pos = file->node->size;
+		} else {
+			vfs_node_lock_range(file->node, &range, pos,
+			    (aoff64_t) len, exclusive);
+		}
 	}
 
 	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
 
-	if (!read && file->append)
-		pos = file->node->size;
-
 	/*
 	 * Handle communication with the endpoint FS.
 	 */
@@ -480,19 +699,34 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 
 	vfs_exchange_release(fs_exch);
 
-	if (file->node->type == VFS_NODE_DIRECTORY)
+	if (file->node->type == VFS_NODE_DIRECTORY) {
 		fibril_rwlock_read_unlock(&namespace_rwlock);
-
-	/* Unlock the VFS node. */
-	if (rlock) {
-		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
 	} else {
+		/*
+		 * Any pages of the written range cached for memory-mapped
+		 * access are now stale.
+		 */
+		if (!read && (rc == EOK)) {
+			vfs_pcache_invalidate((vfs_triplet_t *) file->node,
+			    pos, ipc_get_arg1(&answer));
+		}
+
 		/* Update the cached version of node's size. */
-		if (rc == EOK) {
-			file->node->size = MERGE_LOUP32(ipc_get_arg2(&answer),
+		if (!read && (rc == EOK) && !fs_info->write_retains_size) {
+			aoff64_t nsize = MERGE_LOUP32(ipc_get_arg2(&answer),
 			    ipc_get_arg3(&answer));
+
+			/*
+			 * Concurrent writes to disjoint ranges may complete
+			 * out of order; the file can only have grown.
+			 */
+			fibril_mutex_lock(&file->node->range_lock_mutex);
+			if (nsize > file->node->size)
+				file->node->size = nsize;
+			fibril_mutex_unlock(&file->node->range_lock_mutex);
 		}
-		fibril_rwlock_write_unlock(&file->node->contents_rwlock);
+
+		vfs_node_unlock_range(file->node, &range);
 	}
 
 	vfs_file_put(file);
@@ -502,12 +736,12 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 
 errno_t vfs_rdwr_internal(int fd, aoff64_t pos, bool read, rdwr_io_chunk_t *chunk)
 {
-	return vfs_rdwr(fd, pos, read, rdwr_ipc_internal, chunk);
+	return vfs_rdwr(fd, pos, chunk->size, read, rdwr_ipc_internal, chunk);
 }
 
-errno_t vfs_op_read(int fd, aoff64_t pos, size_t *out_bytes)
+errno_t vfs_op_read(int fd, aoff64_t pos, size_t len, size_t *out_bytes)
 {
-	return vfs_rdwr(fd, pos, true, rdwr_ipc_client, out_bytes);
+	return vfs_rdwr(fd, pos, len, true, rdwr_ipc_client, out_bytes);
 }
 
 errno_t vfs_op_rename(int basefd, char *old, char *new)
@@ -622,14 +856,25 @@ errno_t vfs_op_resize(int fd, int64_t size)
 		return EINVAL;
 	}
 
-	fibril_rwlock_write_lock(&file->node->contents_rwlock);
+	/* Resizing affects the whole file; lock all of it exclusively. */
+	vfs_range_lock_t range;
+	vfs_node_lock_range(file->node, &range, 0, 0, true);
+
+	/* Staged writes must be applied before the truncation. */
+	errno_t rc = EOK;
+	if (file->node->wc_len != 0)
+		rc = vfs_wc_flush_locked(file->node);
 
-	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
-	    file->node->service_id, file->node->index, size);
 	if (rc == EOK)
+		rc = vfs_truncate_internal(file->node->fs_handle,
+		    file->node->service_id, file->node->index, size);
+	if (rc == EOK) {
 		file->node->size = size;
+		vfs_pcache_invalidate((vfs_triplet_t *) file->node,
+		    (aoff64_t) size, 0);
+	}
 
-	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
+	vfs_node_unlock_range(file->node, &range);
 	vfs_file_put(file);
 	return rc;
 }
@@ -668,12 +913,41 @@ errno_t vfs_op_statfs(int fd)
 	return rc;
 }
 
+errno_t vfs_op_msync(int fd, aoff64_t offset, aoff64_t size)
+{
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file)
+		return EBADF;
+
+	/*
+	 * Push modifications made through memory mappings of the file
+	 * from the page cache to the FS server.
+	 */
+	errno_t rc = vfs_pcache_sync((vfs_triplet_t *) file->node, offset,
+	    size);
+
+	vfs_file_put(file);
+
+	if (rc != EOK)
+		return rc;
+
+	/* Let the FS server write the data to stable storage. */
+	return vfs_op_sync(fd);
+}
+
 errno_t vfs_op_sync(int fd)
 {
 	vfs_file_t *file = vfs_file_get(fd);
 	if (!file)
 		return EBADF;
 
+	/* Push writes staged by write combining to the FS server first. */
+	errno_t frc = vfs_wc_flush(file->node);
+	if (frc != EOK) {
+		vfs_file_put(file);
+		return frc;
+	}
+
 	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
 
 	aid_t msg;
@@ -768,9 +1042,10 @@ errno_t vfs_op_unlink(int parentfd, int expectfd, char *path)
 
 	/* If the node is not held by anyone, try to destroy it. */
 	vfs_node_t *node = vfs_node_peek(&lr);
-	if (!node)
+	if (!node) {
 		out_destroy(&lr.triplet);
-	else
+		vfs_ncache_invalidate(&lr.triplet);
+	} else
 		vfs_node_put(node);
 
 exit:
@@ -825,6 +1100,7 @@ errno_t vfs_op_unmount(int mpfd)
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
+	vfs_ncache_purge();
 
 	fibril_rwlock_write_unlock(&namespace_rwlock);
 
@@ -918,9 +1194,26 @@ errno_t vfs_op_walk(int parentfd, int flags, char *path, int *out_fd)
 	return EOK;
 }
 
-errno_t vfs_op_write(int fd, aoff64_t pos, size_t *out_bytes)
+errno_t vfs_op_write(int fd, aoff64_t pos, size_t len, size_t *out_bytes)
 {
-	return vfs_rdwr(fd, pos, false, rdwr_ipc_client, out_bytes);
+	/*
+	 * Small writes through handles opened with MODE_WRITE_COMBINE
+	 * are coalesced in the node's staging buffer; larger ones take
+	 * the ordinary path, which flushes the staged data first.
+	 */
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file)
+		return EBADF;
+
+	if (file->write_combine && file->open_write &&
+	    (file->node->type == VFS_NODE_FILE) && (len <= WC_MAX_WRITE)) {
+		errno_t rc = vfs_wc_write(file, pos, len, out_bytes);
+		vfs_file_put(file);
+		return rc;
+	}
+	vfs_file_put(file);
+
+	return vfs_rdwr(fd, pos, len, false, rdwr_ipc_client, out_bytes);
 }
 
 /**
@@ -32,34 +32,362 @@
 
 /**
  * @file vfs_pager.c
- * @brief VFS pager operations.
+ * @brief VFS pager operations and the page cache backing them.
+ *
+ * Pages read in on behalf of memory-mapped files are kept in a small
+ * cache keyed by file identity and offset. Repeated faults on the same
+ * file page, possibly from different clients, are then served from the
+ * already populated page, which both avoids re-reading the data from
+ * the file system server and makes all mappings of a file page share
+ * one frame, i.e. keeps them coherent.
+ *
+ * The kernel maps file pages read-only at first and repeats the
+ * page-in request with AS_PAGE_IN_WRITE on the first store, so the
+ * cache knows which of its pages are writably mapped. Such pages are
+ * considered dirty for as long as they are cached: the pager is not
+ * notified of subsequent stores through the established writable
+ * mapping, so it conservatively rewrites them on every write-back
+ * pass. Dirty pages are written back by a background fibril, on
+ * explicit request (see vfs_pcache_sync()) and are never evicted,
+ * since evicting a writably mapped page would detach it from future
+ * mappings of the same file page and lose coherence.
  */
 
 #include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <abi/mm/as.h>
 #include <async.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <as.h>
+#include <smc.h>
+#include <macros.h>
+
+/** Maximum number of pages kept in the page cache. */
+#define PCACHE_PAGES_MAX	1024
+
+/** Microseconds between write-back passes of the background fibril. */
+#define PCACHE_WB_PERIOD	1000000
+
+/** Number of dirty pages that wakes the write-back fibril early. */
+#define PCACHE_DIRTY_HIWAT	(PCACHE_PAGES_MAX / 8)
+
+/** One cached file page. */
+typedef struct {
+	ht_link_t link;		/**< Page cache hash table link. */
+	link_t lru_link;	/**< Page cache LRU list link. */
+	vfs_triplet_t triplet;	/**< Identity of the file. */
+	aoff64_t offset;	/**< Offset of the page within the file. */
+	size_t size;		/**< Size of the page. */
+	size_t valid;		/**< Bytes actually read from the file. */
+	bool dirty;		/**< Page is writably mapped somewhere. */
+	void *data;		/**< Address of the page in our space. */
+} vfs_page_t;
+
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+} pcache_key_t;
+
+static FIBRIL_MUTEX_INITIALIZE(pcache_mutex);
+static FIBRIL_CONDVAR_INITIALIZE(pcache_dirty_cv);
+static hash_table_t pcache;
+static LIST_INITIALIZE(pcache_lru);
+static bool pcache_ready = false;
+static size_t pcache_dirty_cnt = 0;
+static fid_t pcache_wb_fid = 0;
+
+/*
+ * Incremented on every invalidation. A page read in while an
+ * invalidation took place may be stale and must not enter the cache.
+ */
+static unsigned long pcache_gen = 0;
+
+static size_t pcache_key_hash(const void *k)
+{
+	const pcache_key_t *key = k;
+	size_t hash;
+
+	hash = hash_combine(key->triplet.fs_handle, key->triplet.service_id);
+	hash = hash_combine(hash, key->triplet.index);
+	return hash_combine(hash, key->offset);
+}
+
+static size_t pcache_hash(const ht_link_t *item)
+{
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+	size_t hash;
+
+	hash = hash_combine(page->triplet.fs_handle,
+	    page->triplet.service_id);
+	hash = hash_combine(hash, page->triplet.index);
+	return hash_combine(hash, page->offset);
+}
+
+static bool pcache_key_equal(const void *k, const ht_link_t *item)
+{
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+	const pcache_key_t *key = k;
+
+	return (key->triplet.fs_handle == page->triplet.fs_handle) &&
+	    (key->triplet.service_id == page->triplet.service_id) &&
+	    (key->triplet.index == page->triplet.index) &&
+	    (key->offset == page->offset);
+}
+
+static hash_table_ops_t pcache_ops = {
+	.hash = pcache_hash,
+	.key_hash = pcache_key_hash,
+	.key_equal = pcache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Drop a page from the page cache.
+ *
+ * The page cache mutex must be held.
+ */
+static void pcache_page_evict(vfs_page_t *page)
+{
+	if (page->dirty)
+		pcache_dirty_cnt--;
+	hash_table_remove_item(&pcache, &page->link);
+	list_remove(&page->lru_link);
+	as_area_destroy(page->data);
+	free(page);
+}
+
+/** Mark a cached page as dirty.
+ *
+ * The page cache mutex must be held. When the number of dirty pages
+ * crosses the high watermark, the write-back fibril is woken up early.
+ */
+static void pcache_page_mark_dirty(vfs_page_t *page)
+{
+	if (page->dirty)
+		return;
+
+	page->dirty = true;
+	pcache_dirty_cnt++;
+
+	if (pcache_dirty_cnt >= PCACHE_DIRTY_HIWAT)
+		fibril_condvar_signal(&pcache_dirty_cv);
+}
+
+/** Write the contents of a cached page back to the file system server.
+ *
+ * The page cache mutex must be held; holding it across the IPC keeps
+ * the page from being invalidated under our hands. Only the bytes
+ * actually read from the file are written back, so a partial tail page
+ * does not grow the file.
+ *
+ * @param page	Dirty page to write back.
+ *
+ * @return	EOK on success or an error code.
+ */
+static errno_t pcache_page_write_back(vfs_page_t *page)
+{
+	size_t off = 0;
+	errno_t rc = EOK;
+
+	while (off < page->valid) {
+		ipc_call_t answer;
+		async_exch_t *exch =
+		    vfs_exchange_grab(page->triplet.fs_handle);
+		aid_t msg = async_send_4(exch, VFS_OUT_WRITE,
+		    page->triplet.service_id, page->triplet.index,
+		    LOWER32(page->offset + off), UPPER32(page->offset + off),
+		    &answer);
+		rc = async_data_write_start(exch, page->data + off,
+		    page->valid - off);
+		vfs_exchange_release(exch);
+
+		if (rc == EOK)
+			async_wait_for(msg, &rc);
+		else
+			async_forget(msg);
+
+		if (rc != EOK)
+			break;
+
+		size_t bytes = ipc_get_arg1(&answer);
+		if (bytes == 0) {
+			rc = EIO;
+			break;
+		}
+
+		off += bytes;
+	}
+
+	return rc;
+}
+
+/** Background fibril periodically writing dirty pages back.
+ *
+ * Dirty pages stay writably mapped in their clients, so they cannot be
+ * considered clean after a pass; every pass rewrites all of them. This
+ * bounds the amount of modified data lost in a crash roughly to the
+ * write-back period.
+ */
+static errno_t pcache_wb_fibril(void *arg)
+{
+	fibril_mutex_lock(&pcache_mutex);
+
+	while (true) {
+		(void) fibril_condvar_wait_timeout(&pcache_dirty_cv,
+		    &pcache_mutex, PCACHE_WB_PERIOD);
+
+		if (pcache_dirty_cnt == 0)
+			continue;
+
+		list_foreach(pcache_lru, lru_link, vfs_page_t, page) {
+			if (page->dirty)
+				(void) pcache_page_write_back(page);
+		}
+	}
+
+	fibril_mutex_unlock(&pcache_mutex);
+	return EOK;
+}
+
+/** Make sure the page cache hash table exists.
+ *
+ * The page cache mutex must be held.
+ *
+ * @return True on success.
+ */
+static bool pcache_init(void)
+{
+	if (!pcache_ready)
+		pcache_ready = hash_table_create(&pcache, 0, 0, &pcache_ops);
+
+	if (pcache_ready && pcache_wb_fid == 0) {
+		pcache_wb_fid = fibril_create(pcache_wb_fibril, NULL);
+		if (pcache_wb_fid != 0)
+			fibril_add_ready(pcache_wb_fid);
+	}
+
+	return pcache_ready;
+}
+
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+	aoff64_t size;
+} pcache_inval_arg_t;
+
+static bool pcache_inval_page(ht_link_t *item, void *arg)
+{
+	pcache_inval_arg_t *ia = (pcache_inval_arg_t *) arg;
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+
+	if ((ia->triplet.fs_handle != page->triplet.fs_handle) ||
+	    (ia->triplet.service_id != page->triplet.service_id) ||
+	    (ia->triplet.index != page->triplet.index))
+		return true;
+
+	if (page->offset + page->size <= ia->offset)
+		return true;
+	if ((ia->size != 0) && (ia->offset + ia->size <= page->offset))
+		return true;
+
+	pcache_page_evict(page);
+	return true;
+}
+
+/** Invalidate cached pages overlapping a byte range of a file.
+ *
+ * Called whenever the file's content changes behind the page cache's
+ * back, i.e. on writes, truncation and node destruction.
+ *
+ * @param triplet	Identity of the file.
+ * @param offset	First byte of the range.
+ * @param size		Length of the range; zero means up to the end of
+ *			the file.
+ */
+void vfs_pcache_invalidate(vfs_triplet_t *triplet, aoff64_t offset,
+    aoff64_t size)
+{
+	pcache_inval_arg_t arg = {
+		.triplet = *triplet,
+		.offset = offset,
+		.size = size
+	};
+
+	fibril_mutex_lock(&pcache_mutex);
+	pcache_gen++;
+	if (pcache_ready)
+		hash_table_apply(&pcache, pcache_inval_page, &arg);
+	fibril_mutex_unlock(&pcache_mutex);
+}
 
 void vfs_page_in(ipc_call_t *req)
 {
-	aoff64_t offset = ipc_get_arg1(req);
+	/*
+	 * The offset of the faulting page within the file is the offset
+	 * of the page within the area plus the offset of the area within
+	 * the file (id2), so that an area can map a file from a non-zero
+	 * offset (e.g. an ELF segment).
+	 */
+	aoff64_t offset = ipc_get_arg1(req) + ipc_get_arg4(req);
 	size_t page_size = ipc_get_arg2(req);
 	int fd = ipc_get_arg3(req);
-	void *page;
+	bool write = (page_size & AS_PAGE_IN_WRITE) != 0;
+	page_size &= ~((size_t) AS_PAGE_IN_WRITE);
+	vfs_page_t *page;
+	unsigned long gen;
+	void *data;
 	errno_t rc;
 
-	page = as_area_create(AS_AREA_ANY, page_size,
+	/*
+	 * Look the page up in the page cache first.
+	 */
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		async_answer_0(req, EBADF);
+		return;
+	}
+	pcache_key_t key = {
+		.triplet = *((vfs_triplet_t *) file->node),
+		.offset = offset
+	};
+	vfs_file_put(file);
+
+	fibril_mutex_lock(&pcache_mutex);
+	gen = pcache_gen;
+	if (pcache_init()) {
+		ht_link_t *hlp = hash_table_find(&pcache, &key);
+		if (hlp) {
+			page = hash_table_get_inst(hlp, vfs_page_t, link);
+			list_remove(&page->lru_link);
+			list_append(&page->lru_link, &pcache_lru);
+			if (write)
+				pcache_page_mark_dirty(page);
+			async_answer_1(req, EOK, (sysarg_t) page->data);
+			fibril_mutex_unlock(&pcache_mutex);
+			return;
+		}
+	}
+	fibril_mutex_unlock(&pcache_mutex);
+
+	/*
+	 * Cache miss; read the page in from the file system server.
+	 */
+	data = as_area_create(AS_AREA_ANY, page_size,
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 
-	if (page == AS_MAP_FAILED) {
+	if (data == AS_MAP_FAILED) {
 		async_answer_0(req, ENOMEM);
 		return;
 	}
 
 	rdwr_io_chunk_t chunk = {
-		.buffer = page,
+		.buffer = data,
 		.size = page_size
 	};
 
@@ -77,15 +405,112 @@ void vfs_page_in(ipc_call_t *req)
 		chunk.size = page_size - total;
 	} while (total < page_size);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		as_area_destroy(data);
+		return;
+	}
+
+	/*
+	 * The page may back an executable mapping in the client. Make
+	 * sure the data has reached memory so that instruction fetches
+	 * see it even where the instruction cache does not snoop.
+	 */
+	smc_coherence(data, page_size);
+
+	async_answer_1(req, rc, (sysarg_t) data);
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * Insert the page into the page cache, unless some other fibril
+	 * beat us to it while we were reading.
 	 */
-	as_area_destroy(page);
+	page = malloc(sizeof(vfs_page_t));
+	if (!page) {
+		as_area_destroy(data);
+		return;
+	}
+	page->triplet = key.triplet;
+	page->offset = offset;
+	page->size = page_size;
+	page->valid = total;
+	page->dirty = false;
+	page->data = data;
+
+	fibril_mutex_lock(&pcache_mutex);
+	if (!pcache_ready || pcache_gen != gen ||
+	    hash_table_find(&pcache, &key) != NULL) {
+		fibril_mutex_unlock(&pcache_mutex);
+		as_area_destroy(data);
+		free(page);
+		return;
+	}
+	hash_table_insert(&pcache, &page->link);
+	list_append(&page->lru_link, &pcache_lru);
+	if (write)
+		pcache_page_mark_dirty(page);
+	if (list_count(&pcache_lru) > PCACHE_PAGES_MAX) {
+		/*
+		 * Evict the least recently used clean page. Dirty pages
+		 * are skipped: they are writably mapped and dropping
+		 * them would detach future mappings from the ongoing
+		 * modifications. If everything is dirty, the cache
+		 * temporarily exceeds its limit.
+		 */
+		list_foreach(pcache_lru, lru_link, vfs_page_t, victim) {
+			if (!victim->dirty) {
+				pcache_page_evict(victim);
+				break;
+			}
+		}
+	}
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Write dirty cached pages overlapping a byte range of a file back.
+ *
+ * Provides the barrier for msync-style calls: when this function
+ * returns, all modifications which clients made through their
+ * memory mappings before the call have reached the file system
+ * server. The pages remain cached and dirty, since the writable
+ * mappings remain in place.
+ *
+ * @param triplet	Identity of the file.
+ * @param offset	First byte of the range.
+ * @param size		Length of the range; zero means up to the end of
+ *			the file.
+ *
+ * @return		EOK on success or the first error encountered.
+ */
+errno_t vfs_pcache_sync(vfs_triplet_t *triplet, aoff64_t offset, aoff64_t size)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&pcache_mutex);
+	if (!pcache_ready) {
+		fibril_mutex_unlock(&pcache_mutex);
+		return EOK;
+	}
+
+	list_foreach(pcache_lru, lru_link, vfs_page_t, page) {
+		if ((triplet->fs_handle != page->triplet.fs_handle) ||
+		    (triplet->service_id != page->triplet.service_id) ||
+		    (triplet->index != page->triplet.index))
+			continue;
+
+		if (page->offset + page->size <= offset)
+			continue;
+		if ((size != 0) && (offset + size <= page->offset))
+			continue;
+
+		if (page->dirty) {
+			errno_t prc = pcache_page_write_back(page);
+			if ((rc == EOK) && (prc != EOK))
+				rc = prc;
+		}
+	}
+	fibril_mutex_unlock(&pcache_mutex);
+
+	return rc;
 }
 
 /**
@@ -36,6 +36,7 @@
 
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <loc.h>
@@ -52,10 +53,31 @@
 #include "types/part.h"
 #include "volume.h"
 
-static errno_t vol_part_add_locked(vol_parts_t *, service_id_t);
+static errno_t vol_part_add_unlocked(vol_parts_t *, service_id_t);
 static void vol_part_remove_locked(vol_part_t *);
 static errno_t vol_part_find_by_id_ref_locked(vol_parts_t *, service_id_t,
     vol_part_t **);
+static void vol_part_ncache_remove(vol_parts_t *, service_id_t);
+
+/** Completion of a batch of discovery fibrils */
+typedef struct {
+	/** Synchronize access to @c pending */
+	fibril_mutex_t lock;
+	/** Signaled when @c pending drops to zero */
+	fibril_condvar_t cv;
+	/** Number of discovery fibrils still running */
+	size_t pending;
+} vol_part_disc_t;
+
+/** Argument to a discovery fibril */
+typedef struct {
+	/** Partition list */
+	vol_parts_t *parts;
+	/** Service ID of the partition to add */
+	service_id_t svc_id;
+	/** Discovery batch this fibril belongs to */
+	vol_part_disc_t *disc;
+} vol_part_disc_work_t;
 
 struct fsname_type {
 	const char *name;
@@ -86,6 +108,28 @@ static const char *fstype_str(vol_fstype_t fstype)
 	return NULL;
 }
 
+/** Add partition and signal discovery batch completion. */
+static errno_t vol_part_disc_fibril(void *arg)
+{
+	vol_part_disc_work_t *work = (vol_part_disc_work_t *)arg;
+	errno_t rc;
+
+	rc = vol_part_add_unlocked(work->parts, work->svc_id);
+	if (rc != EOK && rc != EEXIST) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Could not add "
+		    "partition %zu.", work->svc_id);
+	}
+
+	fibril_mutex_lock(&work->disc->lock);
+	assert(work->disc->pending > 0);
+	--work->disc->pending;
+	fibril_condvar_broadcast(&work->disc->cv);
+	fibril_mutex_unlock(&work->disc->lock);
+
+	free(work);
+	return EOK;
+}
+
 /** Check for new and removed partitions */
 static errno_t vol_part_check_new(vol_parts_t *parts)
 {
@@ -96,6 +140,9 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 	size_t count, i;
 	link_t *cur, *next;
 	vol_part_t *part;
+	vol_part_disc_t disc;
+	vol_part_disc_work_t *work;
+	fid_t fid;
 	errno_t rc;
 
 	fibril_mutex_lock(&parts->lock);
@@ -115,29 +162,6 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 		return EIO;
 	}
 
-	/* Check for new partitions */
-	for (i = 0; i < count; i++) {
-		already_known = false;
-
-		// XXX Make this faster
-		list_foreach(parts->parts, lparts, vol_part_t, part) {
-			if (part->svc_id == svcs[i]) {
-				already_known = true;
-				break;
-			}
-		}
-
-		if (!already_known) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Found partition '%lu'",
-			    (unsigned long) svcs[i]);
-			rc = vol_part_add_locked(parts, svcs[i]);
-			if (rc != EOK) {
-				log_msg(LOG_DEFAULT, LVL_ERROR, "Could not add "
-				    "partition.");
-			}
-		}
-	}
-
 	/* Check for removed partitions */
 	cur = list_first(&parts->parts);
 	while (cur != NULL) {
@@ -162,9 +186,74 @@ static errno_t vol_part_check_new(vol_parts_t *parts)
 		cur = next;
 	}
 
-	free(svcs);
+	/* Mark partitions that are already known */
+	for (i = 0; i < count; i++) {
+		already_known = false;
+
+		// XXX Make this faster
+		list_foreach(parts->parts, lparts, vol_part_t, part) {
+			if (part->svc_id == svcs[i]) {
+				already_known = true;
+				break;
+			}
+		}
+
+		if (already_known)
+			svcs[i] = 0;
+	}
 
 	fibril_mutex_unlock(&parts->lock);
+
+	/*
+	 * Probe new partitions on separate fibrils so that slow devices
+	 * do not serialize the discovery of the others. Wait until the
+	 * whole batch is done before returning.
+	 */
+	fibril_mutex_initialize(&disc.lock);
+	fibril_condvar_initialize(&disc.cv);
+	disc.pending = 0;
+
+	for (i = 0; i < count; i++) {
+		if (svcs[i] == 0)
+			continue;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Found partition '%lu'",
+		    (unsigned long) svcs[i]);
+
+		work = calloc(1, sizeof(vol_part_disc_work_t));
+		if (work != NULL) {
+			work->parts = parts;
+			work->svc_id = svcs[i];
+			work->disc = &disc;
+
+			fid = fibril_create(vol_part_disc_fibril, (void *)work);
+		} else {
+			fid = 0;
+		}
+
+		if (fid != 0) {
+			fibril_mutex_lock(&disc.lock);
+			++disc.pending;
+			fibril_mutex_unlock(&disc.lock);
+
+			fibril_add_ready(fid);
+		} else {
+			/* Fall back to adding the partition directly */
+			free(work);
+			rc = vol_part_add_unlocked(parts, svcs[i]);
+			if (rc != EOK && rc != EEXIST) {
+				log_msg(LOG_DEFAULT, LVL_ERROR, "Could not "
+				    "add partition.");
+			}
+		}
+	}
+
+	fibril_mutex_lock(&disc.lock);
+	while (disc.pending > 0)
+		fibril_condvar_wait(&disc.cv, &disc.lock);
+	fibril_mutex_unlock(&disc.lock);
+
+	free(svcs);
 	return EOK;
 }
 
@@ -200,6 +289,80 @@ static void vol_part_delete(vol_part_t *part)
 	free(part);
 }
 
+/** Find cached negative probe result.
+ *
+ * @param parts Partition list
+ * @param sid Service ID
+ * @param rpcnt Place to store cached partition contents
+ * @return EOK if found, ENOENT if not cached
+ */
+static errno_t vol_part_ncache_find(vol_parts_t *parts, service_id_t sid,
+    vol_part_cnt_t *rpcnt)
+{
+	fibril_mutex_lock(&parts->ncache_lock);
+
+	list_foreach(parts->ncache, lncache, vol_part_ncache_entry_t, ent) {
+		if (ent->svc_id == sid) {
+			*rpcnt = ent->pcnt;
+			fibril_mutex_unlock(&parts->ncache_lock);
+			return EOK;
+		}
+	}
+
+	fibril_mutex_unlock(&parts->ncache_lock);
+	return ENOENT;
+}
+
+/** Cache a negative probe result.
+ *
+ * Failure to allocate the cache entry is not an error, the device
+ * will simply be probed again next time.
+ *
+ * @param parts Partition list
+ * @param sid Service ID
+ * @param pcnt Partition contents determined by the probe
+ */
+static void vol_part_ncache_insert(vol_parts_t *parts, service_id_t sid,
+    vol_part_cnt_t pcnt)
+{
+	vol_part_ncache_entry_t *ent;
+
+	fibril_mutex_lock(&parts->ncache_lock);
+
+	list_foreach(parts->ncache, lncache, vol_part_ncache_entry_t, oent) {
+		if (oent->svc_id == sid) {
+			oent->pcnt = pcnt;
+			fibril_mutex_unlock(&parts->ncache_lock);
+			return;
+		}
+	}
+
+	ent = calloc(1, sizeof(vol_part_ncache_entry_t));
+	if (ent != NULL) {
+		ent->svc_id = sid;
+		ent->pcnt = pcnt;
+		list_append(&ent->lncache, &parts->ncache);
+	}
+
+	fibril_mutex_unlock(&parts->ncache_lock);
+}
+
+/** Remove cached probe result (e.g. because the contents changed). */
+static void vol_part_ncache_remove(vol_parts_t *parts, service_id_t sid)
+{
+	fibril_mutex_lock(&parts->ncache_lock);
+
+	list_foreach(parts->ncache, lncache, vol_part_ncache_entry_t, ent) {
+		if (ent->svc_id == sid) {
+			list_remove(&ent->lncache);
+			free(ent);
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&parts->ncache_lock);
+}
+
 static errno_t vol_part_probe(vol_part_t *part)
 {
 	bool empty;
@@ -207,11 +370,27 @@ static errno_t vol_part_probe(vol_part_t *part)
 	struct fsname_type *fst;
 	char *label;
 	vol_volume_t *volume;
+	vol_part_cnt_t pcnt;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Probe partition %s", part->svc_name);
 
-	assert(fibril_mutex_is_locked(&part->parts->lock));
+	/* Check for a cached negative result first */
+	rc = vol_part_ncache_find(part->parts, part->svc_id, &pcnt);
+	if (rc == EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Negative probe result for "
+		    "%s found in cache.", part->svc_name);
+
+		label = str_dup("");
+		if (label == NULL) {
+			rc = ENOMEM;
+			goto error;
+		}
+
+		part->pcnt = pcnt;
+		part->label = label;
+		goto have_cnt;
+	}
 
 	fst = &fstab[0];
 	while (fst->name != NULL) {
@@ -253,8 +432,13 @@ static errno_t vol_part_probe(vol_part_t *part)
 
 		part->pcnt = empty ? vpc_empty : vpc_unknown;
 		part->label = label;
+
+		/* Remember so that we need not probe this device again */
+		vol_part_ncache_insert(part->parts, part->svc_id, part->pcnt);
 	}
 
+have_cnt:
+
 	/* Look up new or existing volume. */
 	rc = vol_volume_lookup_ref(part->parts->volumes, part->label, &volume);
 	if (rc != EOK)
@@ -405,16 +589,16 @@ static errno_t vol_part_mount(vol_part_t *part)
 	return rc;
 }
 
-static errno_t vol_part_add_locked(vol_parts_t *parts, service_id_t sid)
+static errno_t vol_part_add_unlocked(vol_parts_t *parts, service_id_t sid)
 {
 	vol_part_t *part;
+	vol_part_t *dup;
 	errno_t rc;
 
-	assert(fibril_mutex_is_locked(&parts->lock));
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "vol_part_add_locked(%zu)", sid);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "vol_part_add_unlocked(%zu)", sid);
 
 	/* Check for duplicates */
-	rc = vol_part_find_by_id_ref_locked(parts, sid, &part);
+	rc = vol_part_find_by_id_ref(parts, sid, &part);
 	if (rc == EOK) {
 		vol_part_del_ref(part);
 		return EEXIST;
@@ -435,16 +619,35 @@ static errno_t vol_part_add_locked(vol_parts_t *parts, service_id_t sid)
 		goto error;
 	}
 
+	/*
+	 * Probe without holding the partition list lock so that other
+	 * partitions can be probed at the same time.
+	 */
 	rc = vol_part_probe(part);
 	if (rc != EOK)
 		goto error;
 
+	fibril_mutex_lock(&parts->lock);
+
+	/* Check that the partition was not added in the meantime */
+	rc = vol_part_find_by_id_ref_locked(parts, sid, &dup);
+	if (rc == EOK) {
+		fibril_mutex_unlock(&parts->lock);
+		vol_part_del_ref(dup);
+		rc = EEXIST;
+		goto error;
+	}
+
 	rc = vol_part_mount(part);
-	if (rc != EOK)
+	if (rc != EOK) {
+		fibril_mutex_unlock(&parts->lock);
 		goto error;
+	}
 
 	list_append(&part->lparts, &parts->parts);
 
+	fibril_mutex_unlock(&parts->lock);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Added partition %zu", part->svc_id);
 
 	return EOK;
@@ -468,13 +671,7 @@ static void vol_part_remove_locked(vol_part_t *part)
 
 errno_t vol_part_add_part(vol_parts_t *parts, service_id_t sid)
 {
-	errno_t rc;
-
-	fibril_mutex_lock(&parts->lock);
-	rc = vol_part_add_locked(parts, sid);
-	fibril_mutex_unlock(&parts->lock);
-
-	return rc;
+	return vol_part_add_unlocked(parts, sid);
 }
 
 static void vol_part_cat_change_cb(void *arg)
@@ -494,6 +691,8 @@ errno_t vol_parts_create(vol_volumes_t *volumes, vol_parts_t **rparts)
 
 	fibril_mutex_initialize(&parts->lock);
 	list_initialize(&parts->parts);
+	fibril_mutex_initialize(&parts->ncache_lock);
+	list_initialize(&parts->ncache);
 	parts->volumes = volumes;
 
 	*rparts = parts;
@@ -502,10 +701,24 @@ errno_t vol_parts_create(vol_volumes_t *volumes, vol_parts_t **rparts)
 
 void vol_parts_destroy(vol_parts_t *parts)
 {
+	link_t *link;
+	vol_part_ncache_entry_t *ent;
+
 	if (parts == NULL)
 		return;
 
 	assert(list_empty(&parts->parts));
+
+	link = list_first(&parts->ncache);
+	while (link != NULL) {
+		ent = list_get_instance(link, vol_part_ncache_entry_t,
+		    lncache);
+		list_remove(&ent->lncache);
+		free(ent);
+
+		link = list_first(&parts->ncache);
+	}
+
 	free(parts);
 }
 
@@ -675,6 +888,8 @@ errno_t vol_part_empty_part(vol_part_t *part)
 		return rc;
 	}
 
+	vol_part_ncache_insert(part->parts, part->svc_id, vpc_empty);
+
 	part->pcnt = vpc_empty;
 	return EOK;
 }
@@ -698,6 +913,9 @@ errno_t vol_part_insert_part(vol_part_t *part)
 		return EOK;
 	}
 
+	/* The medium might have been changed */
+	vol_part_ncache_remove(part->parts, part->svc_id);
+
 	rc = vol_part_probe(part);
 	if (rc != EOK)
 		goto error;
@@ -763,6 +981,9 @@ errno_t vol_part_mkfs_part(vol_part_t *part, vol_fstype_t fstype,
 		return rc;
 	}
 
+	/* The partition now contains a file system */
+	vol_part_ncache_remove(part->parts, part->svc_id);
+
 	/*
 	 * Re-probe the partition to update information. This is needed since
 	 * the FS can make conversions of the volume label (e.g. make it
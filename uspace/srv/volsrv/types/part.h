@@ -69,12 +69,26 @@ typedef struct {
 	struct vol_volume *volume;
 } vol_part_t;
 
+/** Cached negative probe result */
+typedef struct {
+	/** Link to vol_parts.ncache */
+	link_t lncache;
+	/** Service ID */
+	service_id_t svc_id;
+	/** Partition contents determined by the probe */
+	vol_part_cnt_t pcnt;
+} vol_part_ncache_entry_t;
+
 /** Partitions */
 typedef struct vol_parts {
 	/** Synchronize access to list of partitions */
 	fibril_mutex_t lock;
 	/** Partitions (list of vol_part_t) */
 	list_t parts;
+	/** Synchronize access to negative probe cache */
+	fibril_mutex_t ncache_lock;
+	/** Cached negative probe results (list of vol_part_ncache_entry_t) */
+	list_t ncache;
 	/** Underlying volumes */
 	struct vol_volumes *volumes;
 } vol_parts_t;